@@ -23,8 +23,8 @@
 
 __BEGIN_DECLS
 
-// Typically, apps seem to have ~300 binary images loaded
-#define CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT (512)
+// Typically, apps seem to have ~300 binary images loaded, but some load many more
+#define CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT (1024)
 #define CLS_BINARY_IMAGE_RUNTIME_NODE_NAME_SIZE (32)
 #define CLS_BINARY_IMAGE_RUNTIME_NODE_RECORD_NAME 0
 
@@ -57,11 +57,36 @@ typedef struct {
 
 typedef struct {
   const char* path;
+  // Directory of the manifests that list the images loaded at launch, which can be NULL
+  const char* manifestDirectoryPath;
 } FIRCLSBinaryImageReadOnlyContext;
 
+typedef struct {
+  uintptr_t start;
+  uintptr_t end;
+  uint32_t nodeIndex;
+} FIRCLSBinaryImageIndexEntry;
+
+// The address ranges of the loaded images, sorted by start address, so that images can be found
+// with a binary search at crash time.
+typedef struct {
+  // The value of nodesGeneration that the entries were built from
+  uint32_t generation;
+  uint32_t count;
+  FIRCLSBinaryImageIndexEntry entries[CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT];
+} FIRCLSBinaryImageIndex;
+
 typedef struct {
   FIRCLSFile file;
   FIRCLSBinaryImageRuntimeNode nodes[CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT];
+
+  // Incremented every time a node is stored
+  _Atomic(uint32_t) volatile nodesGeneration;
+
+  // The index is double-buffered: the binary image queue rebuilds the inactive one and then makes
+  // it active, so a crash handler always reads a complete index.
+  FIRCLSBinaryImageIndex indexes[2];
+  _Atomic(uint32_t) volatile activeIndex;
 } FIRCLSBinaryImageReadWriteContext;
 
 void FIRCLSBinaryImageInit(FIRCLSBinaryImageReadOnlyContext* roContext,
@@ -78,4 +103,9 @@ bool FIRCLSBinaryImageFindImageForUUID(const char* uuidString,
 
 bool FIRCLSBinaryImageRecordMainExecutable(FIRCLSFile* file);
 
+// Replaces the manifest reference in the binary image file at path with the full entries of the
+// images it lists, so that the file can be processed and uploaded on its own. Returns false if the
+// referenced manifest could not be read.
+bool FIRCLSBinaryImageExpandManifestReference(const char* path, const char* manifestDirectoryPath);
+
 __END_DECLS
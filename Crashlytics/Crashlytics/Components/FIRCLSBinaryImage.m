@@ -20,6 +20,7 @@
 #include <mach-o/getsect.h>
 
 #include <stdatomic.h>
+#include <stdlib.h>
 
 #include "FIRCLSByteUtility.h"
 #include "FIRCLSFeatures.h"
@@ -49,6 +50,23 @@ static bool FIRCLSBinaryImageFillInImageDetails(FIRCLSBinaryImageDetails* detail
 
 static void FIRCLSBinaryImageStoreNode(bool added, FIRCLSBinaryImageDetails imageDetails);
 static void FIRCLSBinaryImageRecordSlice(bool added, const FIRCLSBinaryImageDetails imageDetails);
+static void FIRCLSBinaryImageRebuildIndex(void);
+static void FIRCLSBinaryImageFinishLaunchManifest(void);
+
+// Maximum number of launch manifests kept on disk. Reports are expanded on the launch after they
+// are written, so only the most recent manifests can still be referenced.
+static const NSUInteger FIRCLSBinaryImageMaxLaunchManifests = 8;
+
+// The images loaded by the time FIRCLSBinaryImageInit registers for dyld callbacks are listed once
+// in a manifest named after a hash of their contents, which every launch with the same images
+// shares. Reports then record only where each of those images was loaded. This is only accessed on
+// the binary image queue.
+static struct {
+  bool recording;
+  FIRCLSBinaryImageDetails* images;
+  uint32_t count;
+  uint32_t capacity;
+} FIRCLSBinaryImageLaunchManifest;
 
 #pragma mark - Core API
 void FIRCLSBinaryImageInit(FIRCLSBinaryImageReadOnlyContext* roContext,
@@ -66,12 +84,17 @@ void FIRCLSBinaryImageInit(FIRCLSBinaryImageReadOnlyContext* roContext,
     if (!FIRCLSBinaryImageOpenIfNeeded(&needsClosing)) {
       FIRCLSSDKLog("Error: Unable to open the binary image log file during init\n");
     }
+
+    FIRCLSBinaryImageLaunchManifest.recording =
+        FIRCLSIsValidPointer(_firclsContext.readonly->binaryimage.manifestDirectoryPath);
   });
 
+  // dyld calls the add callback for every image that is already loaded before this returns
   _dyld_register_func_for_add_image(FIRCLSBinaryImageAddedCallback);
   _dyld_register_func_for_remove_image(FIRCLSBinaryImageRemovedCallback);
 
   dispatch_async(FIRCLSGetBinaryImageQueue(), ^{
+    FIRCLSBinaryImageFinishLaunchManifest();
     FIRCLSFileClose(&_firclsContext.writable->binaryImage.file);
   });
 }
@@ -121,12 +144,43 @@ bool FIRCLSBinaryImageSafeFindImageForAddress(uintptr_t address,
     return false;
   }
 
-  FIRCLSBinaryImageRuntimeNode* nodes = _firclsContext.writable->binaryImage.nodes;
+  FIRCLSBinaryImageReadWriteContext* context = &_firclsContext.writable->binaryImage;
+  FIRCLSBinaryImageRuntimeNode* nodes = context->nodes;
   if (!nodes) {
     FIRCLSSDKLogError("The node structure is NULL\n");
     return false;
   }
 
+  // The index can only be trusted if no node was stored since it was built. Otherwise, fall back to
+  // scanning all of the nodes.
+  const uint32_t generation = atomic_load(&context->nodesGeneration);
+  const FIRCLSBinaryImageIndex* index = &context->indexes[atomic_load(&context->activeIndex) & 1];
+  if (index->generation == generation && index->count <= CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT) {
+    // find the last entry that starts at or before the address
+    uint32_t low = 0;
+    uint32_t high = index->count;
+    while (low < high) {
+      const uint32_t middle = low + (high - low) / 2;
+      if (index->entries[middle].start <= address) {
+        low = middle + 1;
+      } else {
+        high = middle;
+      }
+    }
+
+    if (low == 0) {
+      return false;
+    }
+
+    const FIRCLSBinaryImageIndexEntry* entry = &index->entries[low - 1];
+    if (address >= entry->end || entry->nodeIndex >= CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT) {
+      return false;
+    }
+
+    *image = nodes[entry->nodeIndex];  // copy the image
+    return true;
+  }
+
   for (uint32_t i = 0; i < CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT; ++i) {
     FIRCLSBinaryImageRuntimeNode* node = &nodes[i];
     if (!FIRCLSIsValidPointer(node)) {
@@ -378,6 +432,7 @@ static void FIRCLSBinaryImageChanged(bool added,
   // this isn't, so do it on a serial queue
   dispatch_async(FIRCLSGetBinaryImageQueue(), ^{
     FIRCLSBinaryImageRecordSlice(added, imageDetails);
+    FIRCLSBinaryImageRebuildIndex();
   });
 }
 
@@ -429,6 +484,7 @@ static void FIRCLSBinaryImageStoreNode(bool added, FIRCLSBinaryImageDetails imag
     if (atomic_compare_exchange_strong(&node->baseAddress, &searchAddress,
                                        imageDetails.node.baseAddress)) {
       *node = imageDetails.node;
+      atomic_fetch_add(&_firclsContext.writable->binaryImage.nodesGeneration, 1);
       success = true;
 
       break;
@@ -449,6 +505,51 @@ static void FIRCLSBinaryImageStoreNode(bool added, FIRCLSBinaryImageDetails imag
   }
 }
 
+static int FIRCLSBinaryImageCompareIndexEntries(const void* a, const void* b) {
+  const uintptr_t aStart = ((const FIRCLSBinaryImageIndexEntry*)a)->start;
+  const uintptr_t bStart = ((const FIRCLSBinaryImageIndexEntry*)b)->start;
+
+  return (aStart > bStart) - (aStart < bStart);
+}
+
+// Must be called on the binary image queue, which is the only writer of the index.
+static void FIRCLSBinaryImageRebuildIndex(void) {
+  if (!_firclsContext.writable) {
+    FIRCLSSDKLog("Error: Writable context is NULL\n");
+    return;
+  }
+
+  FIRCLSBinaryImageReadWriteContext* context = &_firclsContext.writable->binaryImage;
+
+  // Read the generation before the nodes, so that a node stored while they are being read makes
+  // the index stale rather than wrong.
+  const uint32_t generation = atomic_load(&context->nodesGeneration);
+  const uint32_t active = atomic_load(&context->activeIndex) & 1;
+  FIRCLSBinaryImageIndex* index = &context->indexes[active ^ 1];
+
+  uint32_t count = 0;
+  for (uint32_t i = 0; i < CLS_BINARY_IMAGE_RUNTIME_NODE_COUNT; ++i) {
+    const FIRCLSBinaryImageRuntimeNode* node = &context->nodes[i];
+    const uintptr_t start = (uintptr_t)node->baseAddress;
+    if (start == 0 || node->size == 0) {
+      continue;
+    }
+
+    index->entries[count].start = start;
+    index->entries[count].end = start + node->size;
+    index->entries[count].nodeIndex = i;
+    ++count;
+  }
+
+  qsort(index->entries, count, sizeof(FIRCLSBinaryImageIndexEntry),
+        FIRCLSBinaryImageCompareIndexEntries);
+
+  index->count = count;
+  index->generation = generation;
+
+  atomic_store(&context->activeIndex, active ^ 1);
+}
+
 #pragma mark - On-Disk Storage
 static void FIRCLSBinaryImageRecordDetails(FIRCLSFile* file,
                                            const FIRCLSBinaryImageDetails imageDetails) {
@@ -510,6 +611,30 @@ static void FIRCLSBinaryImageRecordLibraryFrameworkInfo(FIRCLSFile* file, const
       file, "display_version", [bundle objectForInfoDictionaryKey:@"CFBundleShortVersionString"]);
 }
 
+static bool FIRCLSBinaryImageAddToLaunchManifest(const FIRCLSBinaryImageDetails imageDetails) {
+  if (!FIRCLSBinaryImageLaunchManifest.recording) {
+    return false;
+  }
+
+  if (FIRCLSBinaryImageLaunchManifest.count == FIRCLSBinaryImageLaunchManifest.capacity) {
+    const uint32_t capacity = FIRCLSBinaryImageLaunchManifest.capacity > 0
+                                  ? FIRCLSBinaryImageLaunchManifest.capacity * 2
+                                  : 256;
+    FIRCLSBinaryImageDetails* images = realloc(FIRCLSBinaryImageLaunchManifest.images,
+                                               capacity * sizeof(FIRCLSBinaryImageDetails));
+    if (!images) {
+      return false;
+    }
+
+    FIRCLSBinaryImageLaunchManifest.images = images;
+    FIRCLSBinaryImageLaunchManifest.capacity = capacity;
+  }
+
+  FIRCLSBinaryImageLaunchManifest.images[FIRCLSBinaryImageLaunchManifest.count++] = imageDetails;
+
+  return true;
+}
+
 static void FIRCLSBinaryImageRecordSlice(bool added, const FIRCLSBinaryImageDetails imageDetails) {
   bool needsClosing = false;
   if (!FIRCLSBinaryImageOpenIfNeeded(&needsClosing)) {
@@ -523,16 +648,23 @@ static void FIRCLSBinaryImageRecordSlice(bool added, const FIRCLSBinaryImageDeta
 
   FIRCLSFileWriteHashStart(file);
 
-  const char* path = FIRCLSMachOSliceGetExecutablePath((FIRCLSMachOSliceRef)&imageDetails.slice);
+  if (added && FIRCLSBinaryImageAddToLaunchManifest(imageDetails)) {
+    // the rest of the details are in the launch manifest
+    FIRCLSFileWriteHashEntryString(file, "uuid", imageDetails.uuidString);
+    FIRCLSFileWriteHashEntryUint64(file, "base", (uintptr_t)imageDetails.slice.startAddress);
+  } else {
+    const char* path =
+        FIRCLSMachOSliceGetExecutablePath((FIRCLSMachOSliceRef)&imageDetails.slice);
 
-  FIRCLSFileWriteHashEntryString(file, "path", path);
+    FIRCLSFileWriteHashEntryString(file, "path", path);
 
-  if (added) {
-    // this won't work if the binary has been unloaded
-    FIRCLSBinaryImageRecordLibraryFrameworkInfo(file, path);
-  }
+    if (added) {
+      // this won't work if the binary has been unloaded
+      FIRCLSBinaryImageRecordLibraryFrameworkInfo(file, path);
+    }
 
-  FIRCLSBinaryImageRecordDetails(file, imageDetails);
+    FIRCLSBinaryImageRecordDetails(file, imageDetails);
+  }
 
   FIRCLSFileWriteHashEnd(file);
 
@@ -543,6 +675,233 @@ static void FIRCLSBinaryImageRecordSlice(bool added, const FIRCLSBinaryImageDeta
   }
 }
 
+#pragma mark - Launch Manifest
+static int FIRCLSBinaryImageCompareUUIDs(const void* a, const void* b) {
+  return strcmp(((const FIRCLSBinaryImageDetails*)a)->uuidString,
+                ((const FIRCLSBinaryImageDetails*)b)->uuidString);
+}
+
+// 64-bit FNV-1a
+static uint64_t FIRCLSBinaryImageHashBytes(uint64_t hash, const void* bytes, size_t length) {
+  const uint8_t* data = bytes;
+
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return hash;
+}
+
+static void FIRCLSBinaryImageTrimLaunchManifests(NSString* directory) {
+  NSFileManager* fileManager = [NSFileManager defaultManager];
+  NSArray<NSString*>* names = [fileManager contentsOfDirectoryAtPath:directory error:nil];
+  if ([names count] <= FIRCLSBinaryImageMaxLaunchManifests) {
+    return;
+  }
+
+  NSMutableDictionary<NSString*, NSDate*>* dates = [NSMutableDictionary dictionary];
+  for (NSString* name in names) {
+    NSString* path = [directory stringByAppendingPathComponent:name];
+    NSDate* date = [[fileManager attributesOfItemAtPath:path error:nil] fileModificationDate];
+    dates[path] = date ?: [NSDate distantPast];
+  }
+
+  NSArray<NSString*>* newestFirst =
+      [dates keysSortedByValueUsingComparator:^NSComparisonResult(NSDate* a, NSDate* b) {
+        return [b compare:a];
+      }];
+
+  for (NSUInteger i = FIRCLSBinaryImageMaxLaunchManifests; i < [newestFirst count]; ++i) {
+    [fileManager removeItemAtPath:newestFirst[i] error:nil];
+  }
+}
+
+static bool FIRCLSBinaryImageWriteLaunchManifest(NSString* path) {
+  NSFileManager* fileManager = [NSFileManager defaultManager];
+
+  if ([fileManager fileExistsAtPath:path]) {
+    // keep the manifest in use from being trimmed
+    [fileManager setAttributes:@{NSFileModificationDate : [NSDate date]}
+                  ofItemAtPath:path
+                         error:nil];
+    return true;
+  }
+
+  // Write to a temporary file first, so that a manifest is never seen partially written
+  NSString* temporaryPath = [path stringByAppendingPathExtension:@"tmp"];
+
+  FIRCLSFile file;
+  if (!FIRCLSFileInitWithPathMode(&file, [temporaryPath fileSystemRepresentation], false, true)) {
+    FIRCLSSDKLog("Error: unable to open the binary image manifest\n");
+    return false;
+  }
+
+  for (uint32_t i = 0; i < FIRCLSBinaryImageLaunchManifest.count; ++i) {
+    const FIRCLSBinaryImageDetails* imageDetails = &FIRCLSBinaryImageLaunchManifest.images[i];
+    const char* imagePath =
+        FIRCLSMachOSliceGetExecutablePath((FIRCLSMachOSliceRef)&imageDetails->slice);
+
+    FIRCLSFileWriteSectionStart(&file, "load");
+    FIRCLSFileWriteHashStart(&file);
+
+    // The load address is different every launch, so it's recorded in each report instead
+    FIRCLSFileWriteHashEntryString(&file, "path", imagePath);
+    FIRCLSBinaryImageRecordLibraryFrameworkInfo(&file, imagePath);
+    FIRCLSFileWriteHashEntryString(&file, "uuid", imageDetails->uuidString);
+    FIRCLSFileWriteHashEntryUint64(&file, "size", imageDetails->node.size);
+
+    FIRCLSFileWriteHashEnd(&file);
+    FIRCLSFileWriteSectionEnd(&file);
+  }
+
+  FIRCLSFileClose(&file);
+
+  if (rename([temporaryPath fileSystemRepresentation], [path fileSystemRepresentation]) != 0) {
+    FIRCLSSDKLog("Error: unable to move the binary image manifest %s\n", strerror(errno));
+    unlink([temporaryPath fileSystemRepresentation]);
+    return false;
+  }
+
+  FIRCLSBinaryImageTrimLaunchManifests([path stringByDeletingLastPathComponent]);
+
+  return true;
+}
+
+static void FIRCLSBinaryImageFinishLaunchManifest(void) {
+  if (!FIRCLSBinaryImageLaunchManifest.recording) {
+    return;
+  }
+
+  FIRCLSBinaryImageLaunchManifest.recording = false;
+
+  FIRCLSBinaryImageDetails* images = FIRCLSBinaryImageLaunchManifest.images;
+  const uint32_t count = FIRCLSBinaryImageLaunchManifest.count;
+
+  // Sort the images so that the hash doesn't depend on the order they were loaded in
+  qsort(images, count, sizeof(FIRCLSBinaryImageDetails), FIRCLSBinaryImageCompareUUIDs);
+
+  uint64_t hash = 14695981039346656037ULL;
+  for (uint32_t i = 0; i < count; ++i) {
+    const char* imagePath = FIRCLSMachOSliceGetExecutablePath(&images[i].slice);
+    const uint64_t size = images[i].node.size;
+
+    hash = FIRCLSBinaryImageHashBytes(hash, images[i].uuidString, strlen(images[i].uuidString));
+    if (imagePath) {
+      hash = FIRCLSBinaryImageHashBytes(hash, imagePath, strlen(imagePath) + 1);
+    }
+    hash = FIRCLSBinaryImageHashBytes(hash, &size, sizeof(size));
+  }
+
+  char hashString[17];
+  snprintf(hashString, sizeof(hashString), "%016llx", hash);
+
+  NSString* directory = [NSString
+      stringWithUTF8String:_firclsContext.readonly->binaryimage.manifestDirectoryPath];
+  NSString* manifestPath =
+      [[directory stringByAppendingPathComponent:[NSString stringWithUTF8String:hashString]]
+          stringByAppendingPathExtension:@"clsrecord"];
+
+  FIRCLSFile* file = &_firclsContext.writable->binaryImage.file;
+
+  if (FIRCLSBinaryImageWriteLaunchManifest(manifestPath)) {
+    FIRCLSFileWriteSectionStart(file, "manifest");
+    FIRCLSFileWriteHashStart(file);
+    FIRCLSFileWriteHashEntryString(file, "hash", hashString);
+    FIRCLSFileWriteHashEnd(file);
+    FIRCLSFileWriteSectionEnd(file);
+  } else {
+    // Without a manifest, the report has to hold the full entries itself. Entries with only an
+    // address are dropped when the report is expanded.
+    for (uint32_t i = 0; i < count; ++i) {
+      FIRCLSBinaryImageRecordSlice(true, images[i]);
+    }
+  }
+
+  free(images);
+  memset(&FIRCLSBinaryImageLaunchManifest, 0, sizeof(FIRCLSBinaryImageLaunchManifest));
+}
+
+bool FIRCLSBinaryImageExpandManifestReference(const char* path, const char* manifestDirectoryPath) {
+  NSArray* sections = FIRCLSFileReadSections(path, false, nil);
+  if ([sections count] == 0) {
+    return true;
+  }
+
+  NSString* hash = nil;
+  BOOL hasAddressOnlyEntries = NO;
+  for (NSDictionary* section in sections) {
+    hash = [section[@"manifest"] objectForKey:@"hash"] ?: hash;
+
+    NSDictionary* load = section[@"load"];
+    if (load && !load[@"path"]) {
+      hasAddressOnlyEntries = YES;
+    }
+  }
+
+  if (!hash && !hasAddressOnlyEntries) {
+    // nothing references a manifest
+    return true;
+  }
+
+  NSMutableDictionary<NSString*, NSDictionary*>* imagesByUUID = [NSMutableDictionary dictionary];
+  bool foundManifest = false;
+  if (hash && FIRCLSIsValidPointer(manifestDirectoryPath)) {
+    NSString* manifestPath = [[[NSString stringWithUTF8String:manifestDirectoryPath]
+        stringByAppendingPathComponent:hash] stringByAppendingPathExtension:@"clsrecord"];
+
+    for (NSDictionary* section in FIRCLSFileReadSections([manifestPath fileSystemRepresentation],
+                                                         false, nil)) {
+      NSDictionary* load = section[@"load"];
+      NSString* uuid = load[@"uuid"];
+      if (uuid) {
+        imagesByUUID[uuid] = load;
+      }
+    }
+
+    foundManifest = [imagesByUUID count] > 0;
+  }
+
+  if (hash && !foundManifest) {
+    FIRCLSSDKLog("Unable to read the binary image manifest %s\n", [hash UTF8String]);
+  }
+
+  NSMutableData* output = [NSMutableData data];
+  for (NSDictionary* section in sections) {
+    if (section[@"manifest"]) {
+      continue;
+    }
+
+    NSDictionary* entry = section;
+    NSDictionary* load = section[@"load"];
+    if (load && !load[@"path"]) {
+      NSDictionary* image = imagesByUUID[load[@"uuid"] ?: @""];
+      if (!image || !load[@"base"]) {
+        continue;
+      }
+
+      NSMutableDictionary* details = [image mutableCopy];
+      details[@"base"] = load[@"base"];
+      entry = @{@"load" : details};
+    }
+
+    NSData* line = [NSJSONSerialization dataWithJSONObject:entry options:0 error:nil];
+    if (!line) {
+      continue;
+    }
+
+    [output appendData:line];
+    [output appendBytes:"\n" length:1];
+  }
+
+  if (![output writeToFile:[NSString stringWithUTF8String:path] atomically:YES]) {
+    FIRCLSSDKLog("Unable to expand binary image file %s\n", path);
+    return false;
+  }
+
+  return !hash || foundManifest;
+}
+
 bool FIRCLSBinaryImageRecordMainExecutable(FIRCLSFile* file) {
   FIRCLSBinaryImageDetails imageDetails;
 
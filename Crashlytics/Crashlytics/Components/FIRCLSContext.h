@@ -83,6 +83,7 @@ typedef struct {
   const char* customBundleId;
   const char* rootPath;
   const char* previouslyCrashedFileRootPath;
+  const char* binaryImageManifestPath;
   const char* sessionId;
   const char* installId;
   const char* betaToken;
@@ -66,6 +66,7 @@ FIRCLSContextInitData FIRCLSContextBuildInitData(FIRCLSInternalReport* report,
   initData.sessionId = [[report identifier] UTF8String];
   initData.rootPath = [[report path] UTF8String];
   initData.previouslyCrashedFileRootPath = [[fileManager rootPath] UTF8String];
+  initData.binaryImageManifestPath = [[fileManager binaryImageManifestPath] UTF8String];
   initData.errorsEnabled = [settings errorReportingEnabled];
   initData.customExceptionsEnabled = [settings customExceptionsEnabled];
   initData.maxCustomExceptions = [settings maxCustomExceptions];
@@ -153,6 +154,13 @@ bool FIRCLSContextInitialize(FIRCLSInternalReport* report,
         FIRCLSContextAppendToRoot(rootPath, FIRCLSReportLogAFile);
     _firclsContext.readonly->logging.logStorage.bPath =
         FIRCLSContextAppendToRoot(rootPath, FIRCLSReportLogBFile);
+    if (initData->maxLogSize > 0 &&
+        FIRCLSMappedRingBufferOpen(&_firclsContext.writable->logging.logRingBuffer,
+                                   _firclsContext.readonly->logging.logStorage.aPath,
+                                   FIRCLSUserLoggingRingBufferCapacity(initData->maxLogSize))) {
+      _firclsContext.readonly->logging.logStorage.ringBuffer =
+          &_firclsContext.writable->logging.logRingBuffer;
+    }
     _firclsContext.readonly->logging.customExceptionStorage.aPath =
         FIRCLSContextAppendToRoot(rootPath, FIRCLSReportCustomExceptionAFile);
     _firclsContext.readonly->logging.customExceptionStorage.bPath =
@@ -182,6 +190,10 @@ bool FIRCLSContextInitialize(FIRCLSInternalReport* report,
   dispatch_group_async(group, queue, ^{
     _firclsContext.readonly->binaryimage.path =
         FIRCLSContextAppendToRoot(rootPath, FIRCLSReportBinaryImageFile);
+    if (FIRCLSIsValidPointer(initData->binaryImageManifestPath)) {
+      _firclsContext.readonly->binaryimage.manifestDirectoryPath =
+          FIRCLSDupString(initData->binaryImageManifestPath);
+    }
 
     FIRCLSBinaryImageInit(&_firclsContext.readonly->binaryimage,
                           &_firclsContext.writable->binaryImage);
@@ -342,6 +354,9 @@ static void FIRCLSContextAllocate(FIRCLSContext* context) {
 void FIRCLSContextBaseDeinit(void) {
   _firclsContext.readonly->initialized = false;
 
+  if (FIRCLSIsValidPointer(_firclsContext.writable)) {
+    FIRCLSMappedRingBufferClose(&_firclsContext.writable->logging.logRingBuffer);
+  }
   FIRCLSAllocatorDestroy(_firclsContext.allocator);
 }
 
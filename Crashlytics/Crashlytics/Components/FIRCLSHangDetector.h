@@ -0,0 +1,36 @@
+// Copyright 2020 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#pragma once
+
+#include <stdint.h>
+#include <sys/cdefs.h>
+
+// The hang detector reports stalls of the main run loop as non-fatal events. A watchdog thread
+// polls the time the main run loop has spent on its current pass. Once that exceeds the
+// threshold, the watchdog samples the main thread's stack with the crash-time unwinder until the
+// run loop moves on, and then records the stack seen in the most samples, with addresses that are
+// symbolicated the same way as crash reports.
+//
+// It is off by default, and ignores stalls while a debugger is attached.
+
+__BEGIN_DECLS
+
+// Starts reporting main run loop passes longer than the threshold, or changes the threshold if
+// the detector is running already.
+void FIRCLSHangDetectorStart(uint32_t thresholdMilliseconds);
+void FIRCLSHangDetectorStop(void);
+
+__END_DECLS
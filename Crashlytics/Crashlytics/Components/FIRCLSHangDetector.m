@@ -0,0 +1,206 @@
+// Copyright 2020 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "FIRCLSHangDetector.h"
+
+#include "FIRCLSContext.h"
+#include "FIRCLSException.h"
+#include "FIRCLSInternalLogging.h"
+#include "FIRCLSProcess.h"
+#include "FIRCLSProfiling.h"
+#import "FIRStackFrame_Private.h"
+
+#import <CoreFoundation/CoreFoundation.h>
+#import <Foundation/Foundation.h>
+
+#include <dispatch/dispatch.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#define CLS_HANG_SAMPLE_INTERVAL_MICROSECONDS (50 * 1000)
+#define CLS_HANG_IDLE_INTERVAL_MICROSECONDS (1000 * 1000)
+#define CLS_HANG_MAX_FRAMES (128)
+// Samples that match none of the distinct stacks kept so far, once there are this many, only
+// count towards the total.
+#define CLS_HANG_MAX_STACKS (16)
+
+typedef struct {
+  uint32_t sampleCount;
+  uint32_t frameCount;
+  uintptr_t frames[CLS_HANG_MAX_FRAMES];
+} FIRCLSHangStack;
+
+static struct {
+  // 0 while the detector is stopped
+  _Atomic(uint32_t) thresholdMicroseconds;
+  // when the main run loop started its current pass, or 0 while it waits for events
+  _Atomic(FIRCLSProfileMark) busySince;
+
+  thread_t mainThread;
+
+  // Only used on the watchdog thread. The hang in progress is identified by the pass it started
+  // in.
+  FIRCLSProfileMark hangBusySince;
+  uint32_t sampleCount;
+  uint32_t stackCount;
+  FIRCLSHangStack sample;
+  FIRCLSHangStack stacks[CLS_HANG_MAX_STACKS];
+} _firclsHangDetector;
+
+static void FIRCLSHangDetectorObserveRunLoop(CFRunLoopObserverRef observer,
+                                             CFRunLoopActivity activity,
+                                             void *info) {
+  if (activity == kCFRunLoopBeforeWaiting || activity == kCFRunLoopExit) {
+    atomic_store(&_firclsHangDetector.busySince, 0);
+  } else {
+    atomic_store(&_firclsHangDetector.busySince, FIRCLSProfilingStart());
+  }
+}
+
+static void FIRCLSHangDetectorAddSample(void) {
+  FIRCLSHangStack *sample = &_firclsHangDetector.sample;
+
+  _firclsHangDetector.sampleCount += 1;
+
+  for (uint32_t i = 0; i < _firclsHangDetector.stackCount; ++i) {
+    FIRCLSHangStack *stack = &_firclsHangDetector.stacks[i];
+    if (stack->frameCount == sample->frameCount &&
+        memcmp(stack->frames, sample->frames, sample->frameCount * sizeof(uintptr_t)) == 0) {
+      stack->sampleCount += 1;
+      return;
+    }
+  }
+
+  if (_firclsHangDetector.stackCount < CLS_HANG_MAX_STACKS) {
+    FIRCLSHangStack *stack = &_firclsHangDetector.stacks[_firclsHangDetector.stackCount];
+    memcpy(stack, sample, sizeof(FIRCLSHangStack));
+    stack->sampleCount = 1;
+    _firclsHangDetector.stackCount += 1;
+  }
+}
+
+static void FIRCLSHangDetectorRecordHang(void) {
+  const FIRCLSHangStack *heaviest = NULL;
+  for (uint32_t i = 0; i < _firclsHangDetector.stackCount; ++i) {
+    const FIRCLSHangStack *stack = &_firclsHangDetector.stacks[i];
+    if (!heaviest || stack->sampleCount > heaviest->sampleCount) {
+      heaviest = stack;
+    }
+  }
+  if (!heaviest) {
+    return;
+  }
+
+  const uint64_t hangMilliseconds =
+      FIRCLSProfileEndMicroseconds(_firclsHangDetector.hangBusySince) / 1000;
+
+  @autoreleasepool {
+    NSMutableArray<FIRStackFrame *> *frames =
+        [NSMutableArray arrayWithCapacity:heaviest->frameCount];
+    for (uint32_t i = 0; i < heaviest->frameCount; ++i) {
+      [frames addObject:[FIRStackFrame stackFrameWithAddress:heaviest->frames[i]]];
+    }
+
+    NSString *reason = [NSString
+        stringWithFormat:@"The main thread was unresponsive for %llu ms. This stack was seen in "
+                         @"%u of %u samples, out of %u distinct stacks.",
+                         hangMilliseconds, heaviest->sampleCount, _firclsHangDetector.sampleCount,
+                         _firclsHangDetector.stackCount];
+
+    FIRCLSSDKLogInfo("Recording a main thread hang of %llu ms\n", hangMilliseconds);
+    FIRCLSExceptionRecord(FIRCLSExceptionTypeCustom, "Main Thread Hang", [reason UTF8String],
+                          frames, NO);
+  }
+}
+
+static void FIRCLSHangDetectorEndHang(void) {
+  if (_firclsHangDetector.hangBusySince != 0) {
+    FIRCLSHangDetectorRecordHang();
+  }
+
+  _firclsHangDetector.hangBusySince = 0;
+  _firclsHangDetector.sampleCount = 0;
+  _firclsHangDetector.stackCount = 0;
+}
+
+static void *FIRCLSHangDetectorWatchdog(void *argument) {
+  pthread_setname_np("com.google.firebase.crashlytics.hang-watchdog");
+
+  while (true) {
+    const uint32_t threshold = atomic_load(&_firclsHangDetector.thresholdMicroseconds);
+    if (threshold == 0) {
+      // Stopped, so any hang in progress is dropped.
+      _firclsHangDetector.hangBusySince = 0;
+      _firclsHangDetector.sampleCount = 0;
+      _firclsHangDetector.stackCount = 0;
+      usleep(CLS_HANG_IDLE_INTERVAL_MICROSECONDS);
+      continue;
+    }
+
+    usleep(CLS_HANG_SAMPLE_INTERVAL_MICROSECONDS);
+
+    const FIRCLSProfileMark busySince = atomic_load(&_firclsHangDetector.busySince);
+    const bool stalled = busySince != 0 && FIRCLSProfileEndMicroseconds(busySince) >= threshold;
+
+    // The run loop moved on since the hang in progress was sampled, so it's over.
+    if (busySince != _firclsHangDetector.hangBusySince) {
+      FIRCLSHangDetectorEndHang();
+    }
+
+    // Time stops at breakpoints, but not for the watchdog. The unwinder needs the binary images
+    // that are only tracked once Crashlytics is initialized.
+    if (!stalled || FIRCLSProcessDebuggerAttached() || !FIRCLSContextIsInitialized()) {
+      continue;
+    }
+
+    _firclsHangDetector.hangBusySince = busySince;
+
+    FIRCLSHangStack *sample = &_firclsHangDetector.sample;
+    if (FIRCLSProcessSampleThread(_firclsHangDetector.mainThread, sample->frames,
+                                  CLS_HANG_MAX_FRAMES, &sample->frameCount)) {
+      FIRCLSHangDetectorAddSample();
+    }
+  }
+
+  return NULL;
+}
+
+void FIRCLSHangDetectorStart(uint32_t thresholdMilliseconds) {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    _firclsHangDetector.mainThread = pthread_mach_thread_np(pthread_main_thread_np());
+
+    CFRunLoopObserverRef observer =
+        CFRunLoopObserverCreate(kCFAllocatorDefault, kCFRunLoopAllActivities, true, 0,
+                                FIRCLSHangDetectorObserveRunLoop, NULL);
+    CFRunLoopAddObserver(CFRunLoopGetMain(), observer, kCFRunLoopCommonModes);
+    CFRelease(observer);
+
+    pthread_t watchdog;
+    if (pthread_create(&watchdog, NULL, FIRCLSHangDetectorWatchdog, NULL) != 0) {
+      FIRCLSSDKLogError("Unable to start the hang watchdog thread\n");
+      return;
+    }
+    pthread_detach(watchdog);
+  });
+
+  atomic_store(&_firclsHangDetector.thresholdMicroseconds, thresholdMilliseconds * 1000);
+}
+
+void FIRCLSHangDetectorStop(void) {
+  atomic_store(&_firclsHangDetector.thresholdMicroseconds, 0);
+}
@@ -22,18 +22,58 @@
 #include "FIRCLSUtility.h"
 
 #include <dispatch/dispatch.h>
+#include <mach/semaphore.h>
 #include <objc/message.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <sys/sysctl.h>
 
 #define THREAD_NAME_BUFFER_SIZE (64)
 
+// Parallel unwinding. Threads beyond the maximum, and stacks deeper than the buffer, are recorded
+// serially instead.
+#define CLS_PROCESS_UNWIND_WORKER_COUNT (3)
+#define CLS_PROCESS_UNWIND_MAX_THREADS (128)
+#define CLS_PROCESS_UNWIND_MAX_FRAMES (128)
+#define CLS_PROCESS_UNWIND_TIMEOUT_SECONDS (2)
+
+typedef enum {
+  FIRCLSProcessUnwindPending = 0,
+  FIRCLSProcessUnwindClaimed,
+  FIRCLSProcessUnwindDone,
+} FIRCLSProcessUnwindState;
+
+typedef struct {
+  _Atomic(uint32_t) state;
+  bool succeeded;
+  FIRCLSThreadContext registers;
+  uint32_t frameCount;
+  uintptr_t frames[CLS_PROCESS_UNWIND_MAX_FRAMES];
+  uint64_t microseconds;
+} FIRCLSProcessUnwoundThread;
+
+// This is written at crash time, so it can't live in the read-only context. It is pre-allocated,
+// because nothing can be allocated once the other threads are suspended.
+static struct {
+  bool initialized;
+  semaphore_t workAvailable;
+  semaphore_t workerFinished;
+  thread_t workers[CLS_PROCESS_UNWIND_WORKER_COUNT];
+  uint32_t workerCount;
+
+  FIRCLSProcess *process;
+  uint32_t threadCount;
+  _Atomic(uint32_t) nextThread;
+  FIRCLSProcessUnwoundThread threads[CLS_PROCESS_UNWIND_MAX_THREADS];
+} _firclsProcessUnwind;
+
 #pragma mark Prototypes
 static bool FIRCLSProcessGetThreadName(FIRCLSProcess *process,
                                        thread_t thread,
                                        char *buffer,
                                        size_t length);
 static const char *FIRCLSProcessGetThreadDispatchQueueName(FIRCLSProcess *process, thread_t thread);
+static bool FIRCLSProcessIsUnwindWorkerThread(thread_t thread);
 
 #pragma mark - API
 bool FIRCLSProcessInit(FIRCLSProcess *process, thread_t crashedThread, void *uapVoid) {
@@ -45,6 +85,8 @@ bool FIRCLSProcessInit(FIRCLSProcess *process, thread_t crashedThread, void *uap
   process->thisThread = mach_thread_self();
   process->crashedThread = crashedThread;
   process->uapVoid = uapVoid;
+  process->slowestThreadIndex = 0;
+  process->slowestThreadMicroseconds = 0;
 
   if (task_threads(process->task, &process->threads, &process->threadCount) != KERN_SUCCESS) {
     // failed to get all threads
@@ -122,7 +164,9 @@ bool FIRCLSProcessSuspendAllOtherThreads(FIRCLSProcess *process) {
 
     thread = FIRCLSProcessGetThread(process, i);
 
-    if (FIRCLSProcessIsCurrentThread(process, thread)) {
+    // the unwind workers are blocked until they are needed to record the threads
+    if (FIRCLSProcessIsCurrentThread(process, thread) ||
+        FIRCLSProcessIsUnwindWorkerThread(thread)) {
       continue;
     }
 
@@ -145,7 +189,8 @@ bool FIRCLSProcessResumeAllOtherThreads(FIRCLSProcess *process) {
 
     thread = FIRCLSProcessGetThread(process, i);
 
-    if (FIRCLSProcessIsCurrentThread(process, thread)) {
+    if (FIRCLSProcessIsCurrentThread(process, thread) ||
+        FIRCLSProcessIsUnwindWorkerThread(thread)) {
       continue;
     }
 
@@ -468,6 +513,28 @@ static bool FIRCLSProcessRecordThread(FIRCLSProcess *process, thread_t thread, F
   return true;
 }
 
+static void FIRCLSProcessNoteThreadTime(FIRCLSProcess *process,
+                                        uint32_t index,
+                                        uint64_t microseconds) {
+  if (microseconds >= process->slowestThreadMicroseconds) {
+    process->slowestThreadIndex = index;
+    process->slowestThreadMicroseconds = microseconds;
+  }
+}
+
+static bool FIRCLSProcessRecordTimedThread(FIRCLSProcess *process,
+                                           uint32_t index,
+                                           thread_t thread,
+                                           FIRCLSFile *file) {
+  const FIRCLSProfileMark mark = FIRCLSProfilingStart();
+
+  const bool recorded = FIRCLSProcessRecordThread(process, thread, file);
+
+  FIRCLSProcessNoteThreadTime(process, index, FIRCLSProfileEndMicroseconds(mark));
+
+  return recorded;
+}
+
 bool FIRCLSProcessRecordAllThreads(FIRCLSProcess *process, FIRCLSFile *file) {
   uint32_t threadCount;
   uint32_t i;
@@ -484,7 +551,236 @@ bool FIRCLSProcessRecordAllThreads(FIRCLSProcess *process, FIRCLSFile *file) {
     thread = FIRCLSProcessGetThread(process, i);
 
     FIRCLSSDKLogInfo("recording thread %d data\n", i);
-    if (!FIRCLSProcessRecordThread(process, thread, file)) {
+    if (!FIRCLSProcessRecordTimedThread(process, i, thread, file)) {
+      return false;
+    }
+  }
+
+  FIRCLSFileWriteArrayEnd(file);
+
+  FIRCLSFileWriteSectionEnd(file);
+
+  FIRCLSSDKLogInfo("completed recording all thread data\n");
+
+  return true;
+}
+
+#pragma mark - Parallel Unwinding
+static bool FIRCLSProcessIsUnwindWorkerThread(thread_t thread) {
+  for (uint32_t i = 0; i < _firclsProcessUnwind.workerCount; ++i) {
+    if (MACH_PORT_INDEX(_firclsProcessUnwind.workers[i]) == MACH_PORT_INDEX(thread)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Unwinds a thread into its buffer. Unlike FIRCLSProcessRecordThread, this doesn't touch the
+// logging level, which is shared by all threads. Stacks that don't fit in the buffer, or that
+// recurse, are left for FIRCLSProcessRecordThread.
+static void FIRCLSProcessUnwindThread(FIRCLSProcess *process,
+                                      thread_t thread,
+                                      FIRCLSProcessUnwoundThread *unwound) {
+  FIRCLSUnwindContext unwindContext;
+
+  unwound->succeeded = false;
+  unwound->frameCount = 0;
+
+  if (!FIRCLSProcessGetThreadState(process, thread, &unwound->registers)) {
+    return;
+  }
+
+  if (!FIRCLSUnwindInit(&unwindContext, unwound->registers)) {
+    return;
+  }
+
+  while (FIRCLSUnwindNextFrame(&unwindContext)) {
+    if (FIRCLSUnwindGetFrameRepeatCount(&unwindContext) >=
+            FIRCLSUnwindInfiniteRecursionCountThreshold ||
+        unwound->frameCount == CLS_PROCESS_UNWIND_MAX_FRAMES) {
+      return;
+    }
+
+    unwound->frames[unwound->frameCount] = FIRCLSUnwindGetPC(&unwindContext);
+    unwound->frameCount += 1;
+  }
+
+  unwound->succeeded = true;
+}
+
+static void FIRCLSProcessUnwindPendingThreads(void) {
+  while (true) {
+    const uint32_t index = atomic_fetch_add(&_firclsProcessUnwind.nextThread, 1);
+    if (index >= _firclsProcessUnwind.threadCount) {
+      return;
+    }
+
+    FIRCLSProcessUnwoundThread *unwound = &_firclsProcessUnwind.threads[index];
+
+    uint32_t expected = FIRCLSProcessUnwindPending;
+    if (!atomic_compare_exchange_strong(&unwound->state, &expected, FIRCLSProcessUnwindClaimed)) {
+      continue;
+    }
+
+    const FIRCLSProfileMark mark = FIRCLSProfilingStart();
+
+    FIRCLSProcessUnwindThread(_firclsProcessUnwind.process,
+                              FIRCLSProcessGetThread(_firclsProcessUnwind.process, index), unwound);
+
+    unwound->microseconds = FIRCLSProfileEndMicroseconds(mark);
+
+    atomic_store(&unwound->state, FIRCLSProcessUnwindDone);
+  }
+}
+
+static void *FIRCLSProcessUnwindWorker(void *argument) {
+  pthread_setname_np("com.google.firebase.crashlytics.UnwindWorker");
+
+  while (semaphore_wait(_firclsProcessUnwind.workAvailable) == KERN_SUCCESS) {
+    FIRCLSProcessUnwindPendingThreads();
+    semaphore_signal(_firclsProcessUnwind.workerFinished);
+  }
+
+  return NULL;
+}
+
+void FIRCLSProcessParallelUnwindInit(void) {
+  if (_firclsProcessUnwind.initialized) {
+    return;
+  }
+
+  if (semaphore_create(mach_task_self(), &_firclsProcessUnwind.workAvailable, SYNC_POLICY_FIFO,
+                       0) != KERN_SUCCESS) {
+    FIRCLSSDKLog("Unable to create the unwind work semaphore\n");
+    return;
+  }
+
+  if (semaphore_create(mach_task_self(), &_firclsProcessUnwind.workerFinished, SYNC_POLICY_FIFO,
+                       0) != KERN_SUCCESS) {
+    FIRCLSSDKLog("Unable to create the unwind worker semaphore\n");
+    semaphore_destroy(mach_task_self(), _firclsProcessUnwind.workAvailable);
+    return;
+  }
+
+  pthread_attr_t attr;
+
+  if (pthread_attr_init(&attr) != 0) {
+    FIRCLSSDKLog("Unable to init the unwind worker attributes\n");
+    return;
+  }
+
+  pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+
+  for (uint32_t i = 0; i < CLS_PROCESS_UNWIND_WORKER_COUNT; ++i) {
+    pthread_t worker;
+
+    if (pthread_create(&worker, &attr, FIRCLSProcessUnwindWorker, NULL) != 0) {
+      FIRCLSSDKLog("Unable to start an unwind worker\n");
+      break;
+    }
+
+    _firclsProcessUnwind.workers[_firclsProcessUnwind.workerCount] =
+        pthread_mach_thread_np(worker);
+    _firclsProcessUnwind.workerCount += 1;
+  }
+
+  pthread_attr_destroy(&attr);
+
+  _firclsProcessUnwind.initialized = _firclsProcessUnwind.workerCount > 0;
+}
+
+static void FIRCLSProcessWriteUnwoundThread(FIRCLSProcess *process,
+                                            thread_t thread,
+                                            const FIRCLSProcessUnwoundThread *unwound,
+                                            FIRCLSFile *file) {
+  FIRCLSFileWriteHashStart(file);
+
+  // registers
+  FIRCLSFileWriteHashKey(file, "registers");
+  FIRCLSFileWriteHashStart(file);
+
+  FIRCLSProcessRecordThreadRegisters(unwound->registers, file);
+
+  FIRCLSFileWriteHashEnd(file);
+
+  // stacktrace
+  FIRCLSFileWriteHashKey(file, "stacktrace");
+
+  FIRCLSFileWriteArrayStart(file);
+
+  for (uint32_t i = 0; i < unwound->frameCount; ++i) {
+    FIRCLSFileWriteArrayEntryUint64(file, unwound->frames[i]);
+  }
+
+  FIRCLSFileWriteArrayEnd(file);
+
+  // crashed?
+  if (FIRCLSProcessIsCrashedThread(process, thread)) {
+    FIRCLSFileWriteHashEntryBoolean(file, "crashed", true);
+  }
+
+  // end thread info
+  FIRCLSFileWriteHashEnd(file);
+}
+
+bool FIRCLSProcessRecordAllThreadsInParallel(FIRCLSProcess *process, FIRCLSFile *file) {
+  if (!_firclsProcessUnwind.initialized) {
+    return FIRCLSProcessRecordAllThreads(process, file);
+  }
+
+  const uint32_t threadCount = FIRCLSProcessGetThreadCount(process);
+  const uint32_t unwoundCount =
+      threadCount < CLS_PROCESS_UNWIND_MAX_THREADS ? threadCount : CLS_PROCESS_UNWIND_MAX_THREADS;
+
+  for (uint32_t i = 0; i < unwoundCount; ++i) {
+    // The current thread can only be unwound from itself, so it is recorded serially.
+    thread_t thread = FIRCLSProcessGetThread(process, i);
+    atomic_store(&_firclsProcessUnwind.threads[i].state,
+                 FIRCLSProcessIsCurrentThread(process, thread) ? FIRCLSProcessUnwindClaimed
+                                                               : FIRCLSProcessUnwindPending);
+  }
+
+  _firclsProcessUnwind.process = process;
+  _firclsProcessUnwind.threadCount = unwoundCount;
+  atomic_store(&_firclsProcessUnwind.nextThread, 0);
+
+  FIRCLSSDKLogInfo("unwinding %d threads in parallel\n", unwoundCount);
+
+  for (uint32_t i = 0; i < _firclsProcessUnwind.workerCount; ++i) {
+    semaphore_signal(_firclsProcessUnwind.workAvailable);
+  }
+
+  // this thread helps, rather than just waiting
+  FIRCLSProcessUnwindPendingThreads();
+
+  // A worker that doesn't finish in time has its thread recorded serially below.
+  const mach_timespec_t timeout = {CLS_PROCESS_UNWIND_TIMEOUT_SECONDS, 0};
+  for (uint32_t i = 0; i < _firclsProcessUnwind.workerCount; ++i) {
+    if (semaphore_timedwait(_firclsProcessUnwind.workerFinished, timeout) != KERN_SUCCESS) {
+      FIRCLSSDKLogWarn("Unwind worker did not finish in time\n");
+      break;
+    }
+  }
+
+  FIRCLSFileWriteSectionStart(file, "threads");
+
+  FIRCLSFileWriteArrayStart(file);
+
+  for (uint32_t i = 0; i < threadCount; ++i) {
+    thread_t thread = FIRCLSProcessGetThread(process, i);
+
+    if (i < unwoundCount) {
+      const FIRCLSProcessUnwoundThread *unwound = &_firclsProcessUnwind.threads[i];
+      if (atomic_load(&unwound->state) == FIRCLSProcessUnwindDone && unwound->succeeded) {
+        FIRCLSProcessNoteThreadTime(process, i, unwound->microseconds);
+        FIRCLSProcessWriteUnwoundThread(process, thread, unwound, file);
+        continue;
+      }
+    }
+
+    FIRCLSSDKLogInfo("recording thread %d data\n", i);
+    if (!FIRCLSProcessRecordTimedThread(process, i, thread, file)) {
       return false;
     }
   }
@@ -498,6 +794,42 @@ bool FIRCLSProcessRecordAllThreads(FIRCLSProcess *process, FIRCLSFile *file) {
   return true;
 }
 
+#pragma mark - Sampling
+bool FIRCLSProcessSampleThread(thread_t thread,
+                               uintptr_t *frames,
+                               uint32_t maxFrames,
+                               uint32_t *frameCount) {
+  // Neither the calling thread nor a crashed thread is involved, so the state always comes from
+  // thread_get_state.
+  FIRCLSProcess process = {0};
+  FIRCLSUnwindContext unwindContext;
+  FIRCLSThreadContext context;
+
+  *frameCount = 0;
+
+  if (thread_suspend(thread) != KERN_SUCCESS) {
+    return false;
+  }
+
+  // Nothing can be allocated until the thread resumes, since it may hold the malloc lock.
+  bool succeeded = FIRCLSProcessGetThreadState(&process, thread, &context) &&
+                   FIRCLSUnwindInit(&unwindContext, context);
+
+  while (succeeded && *frameCount < maxFrames && FIRCLSUnwindNextFrame(&unwindContext)) {
+    if (FIRCLSUnwindGetFrameRepeatCount(&unwindContext) >=
+        FIRCLSUnwindInfiniteRecursionCountThreshold) {
+      break;
+    }
+
+    frames[*frameCount] = FIRCLSUnwindGetPC(&unwindContext);
+    *frameCount += 1;
+  }
+
+  thread_resume(thread);
+
+  return succeeded;
+}
+
 void FIRCLSProcessRecordThreadNames(FIRCLSProcess *process, FIRCLSFile *file) {
   uint32_t threadCount;
   uint32_t i;
@@ -29,6 +29,10 @@ typedef struct {
   thread_act_array_t threads;
   mach_msg_type_number_t threadCount;
   void *uapVoid;  // current thread state
+
+  // the thread that took longest to record, for the handler timings
+  uint32_t slowestThreadIndex;
+  uint64_t slowestThreadMicroseconds;
 } FIRCLSProcess;
 
 bool FIRCLSProcessInit(FIRCLSProcess *process, thread_t crashedThread, void *uapVoid);
@@ -41,5 +45,19 @@ bool FIRCLSProcessResumeAllOtherThreads(FIRCLSProcess *process);
 void FIRCLSProcessRecordThreadNames(FIRCLSProcess *process, FIRCLSFile *file);
 void FIRCLSProcessRecordDispatchQueueNames(FIRCLSProcess *process, FIRCLSFile *file);
 bool FIRCLSProcessRecordAllThreads(FIRCLSProcess *process, FIRCLSFile *file);
+
+// Unwinding threads in parallel needs a handler thread that can wait on other threads, so it is
+// only possible outside of signal context. The worker threads are started ahead of time, and
+// without them, this records the threads one after another.
+void FIRCLSProcessParallelUnwindInit(void);
+bool FIRCLSProcessRecordAllThreadsInParallel(FIRCLSProcess *process, FIRCLSFile *file);
 void FIRCLSProcessRecordStats(FIRCLSProcess *process, FIRCLSFile *file);
+
+// Suspends a thread of this process just long enough to unwind up to maxFrames of its stack, for
+// sampling a running thread outside of crash handling. Returns false if the thread couldn't be
+// unwound.
+bool FIRCLSProcessSampleThread(thread_t thread,
+                               uintptr_t *frames,
+                               uint32_t maxFrames,
+                               uint32_t *frameCount);
 void FIRCLSProcessRecordRuntimeInfo(FIRCLSProcess *process, FIRCLSFile *file);
@@ -21,6 +21,7 @@ __BEGIN_DECLS
 #ifdef __OBJC__
 extern NSString* const FIRCLSStartTimeKey;
 extern NSString* const FIRCLSFirstRunloopTurnTimeKey;
+extern NSString* const FIRCLSPreviousCrashHandlerTimingsKey;
 extern NSString* const FIRCLSInBackgroundKey;
 #if TARGET_OS_IPHONE
 extern NSString* const FIRCLSDeviceOrientationKey;
@@ -50,6 +51,10 @@ typedef struct {
   uint32_t maxEntries;
   bool restrictBySize;
   uint32_t* entryCount;
+
+  // When open, entries are appended to this ring buffer, which is backed by aPath, instead of
+  // switching between the A and B files.
+  FIRCLSMappedRingBuffer* ringBuffer;
 } FIRCLSUserLoggingABStorage;
 
 typedef struct {
@@ -68,13 +73,17 @@ typedef struct {
   uint32_t userKVCount;
   uint32_t internalKVCount;
   uint32_t errorsCount;
+  FIRCLSMappedRingBuffer logRingBuffer;
 } FIRCLSUserLoggingWritableContext;
 
 void FIRCLSUserLoggingInit(FIRCLSUserLoggingReadOnlyContext* roContext,
                            FIRCLSUserLoggingWritableContext* rwContext);
 
+uint32_t FIRCLSUserLoggingRingBufferCapacity(uint32_t maxSize);
+
 #ifdef __OBJC__
 void FIRCLSUserLoggingRecordUserKeyValue(NSString* key, id value);
+void FIRCLSUserLoggingRecordUserKeysAndValues(NSDictionary* keysAndValues);
 void FIRCLSUserLoggingRecordInternalKeyValue(NSString* key, id value);
 void FIRCLSUserLoggingWriteInternalKeyValue(NSString* key, NSString* value);
 
@@ -88,6 +97,9 @@ void FIRCLSUserLoggingRecordKeyValue(NSString* key,
                                      id value,
                                      FIRCLSUserLoggingKVStorage* storage,
                                      uint32_t* counter);
+void FIRCLSUserLoggingRecordKeysAndValues(NSDictionary* keysAndValues,
+                                          FIRCLSUserLoggingKVStorage* storage,
+                                          uint32_t* counter);
 
 void FIRCLSUserLoggingWriteAndCheckABFiles(FIRCLSUserLoggingABStorage* storage,
                                            const char** activePath,
@@ -23,6 +23,8 @@
 
 NSString *const FIRCLSStartTimeKey = @"com.crashlytics.kit-start-time";
 NSString *const FIRCLSFirstRunloopTurnTimeKey = @"com.crashlytics.first-run-loop-time";
+NSString *const FIRCLSPreviousCrashHandlerTimingsKey =
+    @"com.crashlytics.previous-crash-handler-timings";
 NSString *const FIRCLSInBackgroundKey = @"com.crashlytics.in-background";
 #if TARGET_OS_IPHONE
 NSString *const FIRCLSDeviceOrientationKey = @"com.crashlytics.device-orientation";
@@ -40,6 +42,12 @@ static void FIRCLSUserLoggingWriteKeyValue(NSString *key,
                                            NSString *value,
                                            FIRCLSUserLoggingKVStorage *storage,
                                            uint32_t *counter);
+static void FIRCLSUserLoggingWriteKeysAndValues(NSDictionary *keysAndValues,
+                                                FIRCLSUserLoggingKVStorage *storage,
+                                                uint32_t *counter);
+static void FIRCLSUserLoggingCountKeyValues(FIRCLSUserLoggingKVStorage *storage,
+                                            uint32_t *counter,
+                                            uint32_t count);
 static void FIRCLSUserLoggingCheckAndSwapABFiles(FIRCLSUserLoggingABStorage *storage,
                                                  const char **activePath,
                                                  off_t fileSize);
@@ -77,6 +85,12 @@ void FIRCLSUserLoggingRecordUserKeyValue(NSString *key, id value) {
                                   &_firclsContext.writable->logging.userKVCount);
 }
 
+void FIRCLSUserLoggingRecordUserKeysAndValues(NSDictionary *keysAndValues) {
+  FIRCLSUserLoggingRecordKeysAndValues(keysAndValues,
+                                       &_firclsContext.readonly->logging.userKVStorage,
+                                       &_firclsContext.writable->logging.userKVCount);
+}
+
 static id FIRCLSUserLoggingGetComponent(NSDictionary *entry,
                                         NSString *componentName,
                                         bool decodeHex) {
@@ -193,6 +207,16 @@ void FIRCLSUserLoggingCompactKVEntries(FIRCLSUserLoggingKVStorage *storage) {
   }
 }
 
+static NSString *FIRCLSUserLoggingKeyValueDescription(id value) {
+  if ([value respondsToSelector:@selector(description)]) {
+    return [value description];
+  }
+
+  // passing nil will result in a JSON null being written, which is deserialized as [NSNull null],
+  // signaling to remove the key during compaction
+  return nil;
+}
+
 void FIRCLSUserLoggingRecordKeyValue(NSString *key,
                                      id value,
                                      FIRCLSUserLoggingKVStorage *storage,
@@ -212,19 +236,55 @@ void FIRCLSUserLoggingRecordKeyValue(NSString *key,
     return;
   }
 
-  if ([value respondsToSelector:@selector(description)]) {
-    value = [value description];
-  } else {
-    // passing nil will result in a JSON null being written, which is deserialized as [NSNull null],
-    // signaling to remove the key during compaction
-    value = nil;
-  }
+  value = FIRCLSUserLoggingKeyValueDescription(value);
 
   dispatch_sync(FIRCLSGetLoggingQueue(), ^{
     FIRCLSUserLoggingWriteKeyValue(key, value, storage, counter);
   });
 }
 
+void FIRCLSUserLoggingRecordKeysAndValues(NSDictionary *keysAndValues,
+                                          FIRCLSUserLoggingKVStorage *storage,
+                                          uint32_t *counter) {
+  if (![keysAndValues isKindOfClass:[NSDictionary class]] || [keysAndValues count] == 0) {
+    return;
+  }
+
+  if (!FIRCLSContextIsInitialized()) {
+    return;
+  }
+
+  // Convert everything up front, so the logging queue is only entered once. A dictionary already
+  // holds one value per key, so superseded values never reach the file.
+  NSMutableDictionary *descriptions = [NSMutableDictionary dictionary];
+  for (id key in keysAndValues) {
+    if (![key isKindOfClass:[NSString class]]) {
+      FIRCLSSDKLogWarn("User provided bad key\n");
+      continue;
+    }
+
+    id value = [keysAndValues objectForKey:key];
+    if (value == [NSNull null]) {
+      value = nil;
+    }
+
+    descriptions[key] = FIRCLSUserLoggingKeyValueDescription(value) ?: [NSNull null];
+  }
+
+  dispatch_sync(FIRCLSGetLoggingQueue(), ^{
+    FIRCLSUserLoggingWriteKeysAndValues(descriptions, storage, counter);
+  });
+}
+
+static void FIRCLSUserLoggingWriteKeyValueEntry(FIRCLSFile *file, NSString *key, NSString *value) {
+  FIRCLSFileWriteSectionStart(file, "kv");
+  FIRCLSFileWriteHashStart(file);
+  FIRCLSFileWriteHashEntryHexEncodedString(file, "key", [key UTF8String]);
+  FIRCLSFileWriteHashEntryHexEncodedString(file, "value", [value UTF8String]);
+  FIRCLSFileWriteHashEnd(file);
+  FIRCLSFileWriteSectionEnd(file);
+}
+
 static void FIRCLSUserLoggingWriteKeyValue(NSString *key,
                                            NSString *value,
                                            FIRCLSUserLoggingKVStorage *storage,
@@ -241,16 +301,44 @@ static void FIRCLSUserLoggingWriteKeyValue(NSString *key,
     return;
   }
 
-  FIRCLSFileWriteSectionStart(&file, "kv");
-  FIRCLSFileWriteHashStart(&file);
-  FIRCLSFileWriteHashEntryHexEncodedString(&file, "key", [key UTF8String]);
-  FIRCLSFileWriteHashEntryHexEncodedString(&file, "value", [value UTF8String]);
-  FIRCLSFileWriteHashEnd(&file);
-  FIRCLSFileWriteSectionEnd(&file);
+  FIRCLSUserLoggingWriteKeyValueEntry(&file, key, value);
+
+  FIRCLSFileClose(&file);
+
+  FIRCLSUserLoggingCountKeyValues(storage, counter, 1);
+}
+
+static void FIRCLSUserLoggingWriteKeysAndValues(NSDictionary *keysAndValues,
+                                                FIRCLSUserLoggingKVStorage *storage,
+                                                uint32_t *counter) {
+  FIRCLSFile file;
+
+  if (!FIRCLSIsValidPointer(storage) || !FIRCLSIsValidPointer(counter)) {
+    FIRCLSSDKLogError("Bad parameters\n");
+    return;
+  }
+
+  // one open and close for the whole batch
+  if (!FIRCLSFileInitWithPath(&file, storage->incrementalPath, true)) {
+    FIRCLSSDKLogError("Unable to open k-v file\n");
+    return;
+  }
+
+  for (NSString *key in keysAndValues) {
+    id value = [keysAndValues objectForKey:key];
+
+    FIRCLSUserLoggingWriteKeyValueEntry(&file, key, value == [NSNull null] ? nil : value);
+  }
 
   FIRCLSFileClose(&file);
 
-  *counter += 1;
+  FIRCLSUserLoggingCountKeyValues(storage, counter, (uint32_t)[keysAndValues count]);
+}
+
+static void FIRCLSUserLoggingCountKeyValues(FIRCLSUserLoggingKVStorage *storage,
+                                            uint32_t *counter,
+                                            uint32_t count) {
+  *counter += count;
   if (*counter >= storage->maxIncrementalCount) {
     dispatch_async(FIRCLSGetLoggingQueue(), ^{
       FIRCLSUserLoggingCompactKVEntries(storage);
@@ -360,6 +448,12 @@ void FIRCLSLog(NSString *format, ...) {
 }
 
 #pragma mark - Properties
+uint32_t FIRCLSUserLoggingRingBufferCapacity(uint32_t maxSize) {
+  // Messages are hex-encoded, so a message of maxSize takes twice that. Keep room for two of
+  // them, like the A and B files together.
+  return maxSize * 4;
+}
+
 uint32_t FIRCLSUserLoggingMaxLogSize(void) {
   // don't forget that the message encoding overhead is 2x, and we
   // wrap everything in a json structure with time. So, there is
@@ -453,6 +547,14 @@ void FIRCLSUserLoggingWriteAndCheckABFiles(FIRCLSUserLoggingABStorage *storage,
   dispatch_sync(FIRCLSGetLoggingQueue(), ^{
     FIRCLSFile file;
 
+    // The ring drops its oldest entries by itself, so there are no files to switch between.
+    if (FIRCLSMappedRingBufferIsOpen(storage->ringBuffer) &&
+        FIRCLSFileInitWithMappedRingBuffer(&file, storage->ringBuffer)) {
+      openedFileBlock(&file);
+      FIRCLSFileClose(&file);
+      return;
+    }
+
     if (!FIRCLSFileInitWithPath(&file, *activePath, true)) {
       FIRCLSSDKLog("Unable to open log file\n");
       return;
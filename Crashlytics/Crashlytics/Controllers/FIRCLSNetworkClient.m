@@ -29,6 +29,10 @@ NSString *const FIRCLSNetworkClientErrorDomain = @"FIRCLSNetworkError";
 
 NSString *const FIRCLSNetworkClientBackgroundIdentifierSuffix = @".crash.background-session";
 
+// Uploads beyond this are queued by the session, rather than all competing for bandwidth at once
+// when a backlog of reports is submitted.
+static const NSInteger FIRCLSNetworkClientMaximumConcurrentUploads = 2;
+
 @interface FIRCLSNetworkClient () <NSURLSessionDelegate> {
   NSURLSession *_session;
 }
@@ -101,6 +105,11 @@ NSString *const FIRCLSNetworkClientBackgroundIdentifierSuffix = @".crash.backgro
     config = [urlSessionConfigurationClass defaultSessionConfiguration];
   }
 
+  // the FIRCLSURLSession wrapper doesn't support this
+  if ([config respondsToSelector:@selector(setHTTPMaximumConnectionsPerHost:)]) {
+    config.HTTPMaximumConnectionsPerHost = FIRCLSNetworkClientMaximumConcurrentUploads;
+  }
+
   _session = [urlSessionClass sessionWithConfiguration:config
                                               delegate:self
                                          delegateQueue:self.operationQueue];
@@ -138,10 +147,21 @@ NSString *const FIRCLSNetworkClientBackgroundIdentifierSuffix = @".crash.backgro
     return;
   }
 
-  // This is the absolute minimum necessary. Perhaps we can do better?
-  if (completionBlock) {
-    [[NSOperationQueue mainQueue] addOperationWithBlock:completionBlock];
-  }
+  // Recreating the background session reattaches the uploads a previous launch left in flight.
+  // Wait until they are known, so that prepared files they cover are not submitted again.
+  [self.operationQueue addOperationWithBlock:^{
+    [self.session getTasksWithCompletionHandler:^(NSArray *dataTasks, NSArray *uploadTasks,
+                                                  NSArray *downloadTasks) {
+      if (uploadTasks.count > 0) {
+        FIRCLSDeveloperLog("Crashlytics:Crash:Client", @"Reconnected to %lu in-flight uploads",
+                           (unsigned long)uploadTasks.count);
+      }
+
+      if (completionBlock) {
+        [[NSOperationQueue mainQueue] addOperationWithBlock:completionBlock];
+      }
+    }];
+  }];
 }
 
 #pragma mark - API
@@ -567,10 +567,43 @@ static void (^reportSentCallback)(void);
   return count;
 }
 
+// After a crash loop there can be many reports waiting, and they may take more than one launch
+// to get through. Crashes go first, and newer reports before older ones within each group, so the
+// most relevant crash is the one most likely to make it.
+- (NSArray *)prioritizedReportPaths:(NSArray *)reportPaths {
+  NSMutableDictionary *crashes = [NSMutableDictionary dictionaryWithCapacity:reportPaths.count];
+  NSMutableDictionary *dates = [NSMutableDictionary dictionaryWithCapacity:reportPaths.count];
+
+  for (NSString *path in reportPaths) {
+    crashes[path] = @([[FIRCLSInternalReport reportWithPath:path] isCrash]);
+    dates[path] = [_fileManager modificationDateAtPath:path] ?: [NSDate distantPast];
+  }
+
+  return [reportPaths sortedArrayUsingComparator:^NSComparisonResult(NSString *a, NSString *b) {
+    if (![crashes[a] isEqualToNumber:crashes[b]]) {
+      return [crashes[a] boolValue] ? NSOrderedAscending : NSOrderedDescending;
+    }
+
+    return [dates[b] compare:dates[a]];
+  }];
+}
+
+- (NSArray *)newestFirstPaths:(NSArray *)paths {
+  NSMutableDictionary *dates = [NSMutableDictionary dictionaryWithCapacity:paths.count];
+
+  for (NSString *path in paths) {
+    dates[path] = [_fileManager modificationDateAtPath:path] ?: [NSDate distantPast];
+  }
+
+  return [paths sortedArrayUsingComparator:^NSComparisonResult(NSString *a, NSString *b) {
+    return [dates[b] compare:dates[a]];
+  }];
+}
+
 - (void)processExistingReportPaths:(NSArray *)reportPaths
                dataCollectionToken:(FIRCLSDataCollectionToken *)dataCollectionToken
                           asUrgent:(BOOL)urgent {
-  for (NSString *path in reportPaths) {
+  for (NSString *path in [self prioritizedReportPaths:reportPaths]) {
     [self processExistingActiveReportPath:path
                       dataCollectionToken:dataCollectionToken
                                  asUrgent:urgent];
@@ -591,6 +624,8 @@ static void (^reportSentCallback)(void);
     return;
   }
 
+  [self recordCrashHandlerTimingsForReport:report];
+
   if (urgent && [dataCollectionToken isValid]) {
     // We can proceed without the delegate.
     [[self uploader] prepareAndSubmitReport:report
@@ -603,6 +638,28 @@ static void (^reportSentCallback)(void);
   [self submitReport:report dataCollectionToken:dataCollectionToken];
 }
 
+// The handler's phase timings end up in the crash file, which isn't surfaced on its own. Copy
+// them into an internal key of the current session, so slow handlers show up in the field.
+- (void)recordCrashHandlerTimingsForReport:(FIRCLSInternalReport *)report {
+  NSDictionary *timings = [report crashHandlerTimings];
+  if (timings.count == 0) {
+    return;
+  }
+
+  NSMutableArray *entries = [NSMutableArray arrayWithCapacity:timings.count];
+  for (NSString *key in [[timings allKeys] sortedArrayUsingSelector:@selector(compare:)]) {
+    [entries addObject:[NSString stringWithFormat:@"%@=%@", key, timings[key]]];
+  }
+
+  NSString *value = [entries componentsJoinedByString:@","];
+
+  FIRCLSDebugLog(@"Crash handler timings for report %@: %@", report.identifier, value);
+
+  dispatch_async(FIRCLSGetLoggingQueue(), ^{
+    FIRCLSUserLoggingWriteInternalKeyValue(FIRCLSPreviousCrashHandlerTimingsKey, value);
+  });
+}
+
 - (void)submitReport:(FIRCLSInternalReport *)report
     dataCollectionToken:(FIRCLSDataCollectionToken *)dataCollectionToken {
   [self.operationQueue addOperationWithBlock:^{
@@ -638,7 +695,7 @@ static void (^reportSentCallback)(void);
 
   // deal with stuff in processing more carefully - do not process again
   [self.operationQueue addOperationWithBlock:^{
-    for (NSString *path in processingPaths) {
+    for (NSString *path in [self prioritizedReportPaths:processingPaths]) {
       FIRCLSInternalReport *report = [FIRCLSInternalReport reportWithPath:path];
       [[self uploader] prepareAndSubmitReport:report
                           dataCollectionToken:token
@@ -667,7 +724,7 @@ static void (^reportSentCallback)(void);
   // captured, some could be completed (deleted). So, just double-check to make sure
   // the file still exists.
 
-  for (NSString *path in files) {
+  for (NSString *path in [self newestFirstPaths:files]) {
     if (![[_fileManager underlyingFileManager] fileExistsAtPath:path]) {
       continue;
     }
@@ -15,10 +15,12 @@
 #import <FirebaseAnalyticsInterop/FIRAnalyticsInterop.h>
 
 #import "FIRCLSApplication.h"
+#import "FIRCLSBinaryImage.h"
 #import "FIRCLSDataCollectionArbiter.h"
 #import "FIRCLSDataCollectionToken.h"
 #import "FIRCLSDefines.h"
 #import "FIRCLSFCRAnalytics.h"
+#import "FIRCLSFile.h"
 #import "FIRCLSFileManager.h"
 #import "FIRCLSInstallIdentifierModel.h"
 #import "FIRCLSInternalReport.h"
@@ -88,6 +90,20 @@
 
   FIRCLSApplicationActivity(
       FIRCLSApplicationActivityDefault, @"Crashlytics Crash Report Processing", ^{
+        // Crash handlers write their files in the binary encoding, and the log is a ring
+        // buffer. Convert them back to JSON before they are processed and uploaded.
+        [report enumerateSymbolicatableFilesInContent:^(NSString *path) {
+          FIRCLSFileConvertBinaryToJSON([path fileSystemRepresentation]);
+        }];
+        FIRCLSFileConvertBinaryToJSON(
+            [[report pathForContentFile:FIRCLSReportLogAFile] fileSystemRepresentation]);
+
+        // The binary image file only references the images loaded at launch. Put their full
+        // entries back, since the report is processed and uploaded on its own.
+        FIRCLSBinaryImageExpandManifestReference(
+            [report.binaryImagePath fileSystemRepresentation],
+            [self.fileManager.binaryImageManifestPath fileSystemRepresentation]);
+
         if (shouldProcess) {
           if (![self.fileManager moveItemAtPath:report.path
                                     toDirectory:self.fileManager.processingPath]) {
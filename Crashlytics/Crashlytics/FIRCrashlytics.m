@@ -27,6 +27,7 @@
 #include "FIRCLSException.h"
 #import "FIRCLSFileManager.h"
 #include "FIRCLSGlobals.h"
+#include "FIRCLSHangDetector.h"
 #import "FIRCLSHost.h"
 #include "FIRCLSProfiling.h"
 #import "FIRCLSReport_Private.h"
@@ -277,6 +278,10 @@ NSString *const FIRCLSGoogleTransportMappingID = @"1206";
   FIRCLSUserLoggingRecordUserKeyValue(key, value);
 }
 
+- (void)setCustomKeysAndValues:(NSDictionary *)keysAndValues {
+  FIRCLSUserLoggingRecordUserKeysAndValues(keysAndValues);
+}
+
 #pragma mark - API: Development Platform
 // These two methods are depercated by our own API, so
 // its ok to implement them
@@ -320,4 +325,13 @@ NSString *const FIRCLSGoogleTransportMappingID = @"1206";
   FIRCLSExceptionRecordModel(exceptionModel);
 }
 
+#pragma mark - API: Hang Detection
+- (void)setHangDetectionThreshold:(NSTimeInterval)threshold {
+  if (threshold > 0) {
+    FIRCLSHangDetectorStart((uint32_t)(threshold * 1000));
+  } else {
+    FIRCLSHangDetectorStop();
+  }
+}
+
 @end
@@ -205,7 +205,7 @@ void FIRCLSExceptionRecord(FIRCLSExceptionType type,
       const char *path = _firclsContext.readonly->exception.path;
       FIRCLSFile file;
 
-      if (!FIRCLSFileInitWithPath(&file, path, false)) {
+      if (!FIRCLSFileInitBinaryWithPath(&file, path, false)) {
         FIRCLSSDKLog("Unable to open exception file\n");
         return;
       }
@@ -213,7 +213,7 @@ void FIRCLSExceptionRecord(FIRCLSExceptionType type,
       FIRCLSExceptionWrite(&file, type, name, reason, frames);
 
       // We only want to do this work if we have the expectation that we'll actually crash
-      FIRCLSHandler(&file, mach_thread_self(), NULL);
+      FIRCLSHandler(&file, mach_thread_self(), NULL, false);
 
       FIRCLSFileClose(&file);
 
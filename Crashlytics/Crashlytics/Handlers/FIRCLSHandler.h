@@ -17,10 +17,12 @@
 #include "FIRCLSFile.h"
 
 #include <mach/mach.h>
+#include <stdbool.h>
 
 __BEGIN_DECLS
 
-void FIRCLSHandler(FIRCLSFile* file, thread_t crashedThread, void* uapVoid);
+// parallelUnwind may only be true outside of signal context
+void FIRCLSHandler(FIRCLSFile* file, thread_t crashedThread, void* uapVoid, bool parallelUnwind);
 void FIRCLSHandlerAttemptImmediateDelivery(void);
 
 __END_DECLS
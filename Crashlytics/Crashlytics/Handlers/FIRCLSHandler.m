@@ -18,32 +18,83 @@
 #include "FIRCLSGlobals.h"
 #include "FIRCLSHost.h"
 #include "FIRCLSProcess.h"
+#include "FIRCLSProfiling.h"
 #include "FIRCLSUtility.h"
 
 #import "FIRCLSReportManager_Private.h"
 
-void FIRCLSHandler(FIRCLSFile* file, thread_t crashedThread, void* uapVoid) {
+// Microseconds spent in each phase of the handler, written to the crash file so slow handlers can
+// be found in the field. This is read back when the report is processed on the next launch.
+typedef struct {
+  uint64_t suspend;
+  uint64_t threads;
+  uint64_t threadMetadata;
+  uint64_t stats;
+  uint64_t crashedMarker;
+} FIRCLSHandlerTimings;
+
+static void FIRCLSHandlerRecordTimings(FIRCLSProcess* process,
+                                       const FIRCLSHandlerTimings* timings,
+                                       FIRCLSProfileMark start,
+                                       FIRCLSFile* file) {
+  FIRCLSFileWriteSectionStart(file, "handler_timings");
+  FIRCLSFileWriteHashStart(file);
+
+  FIRCLSFileWriteHashEntryUint64(file, "suspend_us", timings->suspend);
+  FIRCLSFileWriteHashEntryUint64(file, "threads_us", timings->threads);
+  FIRCLSFileWriteHashEntryUint64(file, "thread_count", process->threadCount);
+  FIRCLSFileWriteHashEntryUint64(file, "slowest_thread_us", process->slowestThreadMicroseconds);
+  FIRCLSFileWriteHashEntryUint64(file, "slowest_thread_index", process->slowestThreadIndex);
+  FIRCLSFileWriteHashEntryUint64(file, "thread_metadata_us", timings->threadMetadata);
+  FIRCLSFileWriteHashEntryUint64(file, "stats_us", timings->stats);
+  FIRCLSFileWriteHashEntryUint64(file, "crashed_marker_us", timings->crashedMarker);
+  FIRCLSFileWriteHashEntryUint64(file, "total_us", FIRCLSProfileEndMicroseconds(start));
+
+  FIRCLSFileWriteHashEnd(file);
+  FIRCLSFileWriteSectionEnd(file);
+}
+
+void FIRCLSHandler(FIRCLSFile* file, thread_t crashedThread, void* uapVoid, bool parallelUnwind) {
   FIRCLSProcess process;
+  FIRCLSHandlerTimings timings = {0};
+  const FIRCLSProfileMark start = FIRCLSProfilingStart();
+  FIRCLSProfileMark mark;
 
   FIRCLSProcessInit(&process, crashedThread, uapVoid);
 
+  mark = FIRCLSProfilingStart();
   FIRCLSProcessSuspendAllOtherThreads(&process);
+  timings.suspend = FIRCLSProfileEndMicroseconds(mark);
 
-  FIRCLSProcessRecordAllThreads(&process, file);
+  mark = FIRCLSProfilingStart();
+  if (parallelUnwind) {
+    FIRCLSProcessRecordAllThreadsInParallel(&process, file);
+  } else {
+    FIRCLSProcessRecordAllThreads(&process, file);
+  }
+  timings.threads = FIRCLSProfileEndMicroseconds(mark);
 
+  mark = FIRCLSProfilingStart();
   FIRCLSProcessRecordRuntimeInfo(&process, file);
   // Get dispatch queue and thread names. Note that getting the thread names
   // can hang, so let's do that last
   FIRCLSProcessRecordDispatchQueueNames(&process, file);
   FIRCLSProcessRecordThreadNames(&process, file);
+  timings.threadMetadata = FIRCLSProfileEndMicroseconds(mark);
 
   // this stuff isn't super important, but we can try
+  mark = FIRCLSProfilingStart();
   FIRCLSProcessRecordStats(&process, file);
   FIRCLSHostWriteDiskUsage(file);
+  timings.stats = FIRCLSProfileEndMicroseconds(mark);
 
   // This is the first common point where various crash handlers call into
   // Store a crash file marker to indicate that a crash has occured
+  mark = FIRCLSProfilingStart();
   FIRCLSCreateCrashedMarkerFile();
+  timings.crashedMarker = FIRCLSProfileEndMicroseconds(mark);
+
+  FIRCLSHandlerRecordTimings(&process, &timings, start, file);
 
   FIRCLSProcessResumeAllOtherThreads(&process);
 
@@ -61,7 +61,10 @@ void FIRCLSMachExceptionInit(FIRCLSMachExceptionReadContext* context, exception_
   if (!FIRCLSMachExceptionThreadStart(context)) {
     FIRCLSSDKLog("Unable to start thread\n");
     FIRCLSMachExceptionUnregister(&context->originalPorts, context->mask);
+    return;
   }
+
+  FIRCLSProcessParallelUnwindInit();
 }
 
 void FIRCLSMachExceptionCheckHandlers(void) {
@@ -484,7 +487,7 @@ static bool FIRCLSMachExceptionRecord(FIRCLSMachExceptionReadContext* context,
 
   FIRCLSFile file;
 
-  if (!FIRCLSFileInitWithPath(&file, context->path, false)) {
+  if (!FIRCLSFileInitBinaryWithPath(&file, context->path, false)) {
     FIRCLSSDKLog("Unable to open mach exception file\n");
     return false;
   }
@@ -519,7 +522,9 @@ static bool FIRCLSMachExceptionRecord(FIRCLSMachExceptionReadContext* context,
 
   FIRCLSFileWriteSectionEnd(&file);
 
-  FIRCLSHandler(&file, message->thread.name, NULL);
+  // The exception server thread runs outside of signal context, so it can wait on the unwind
+  // workers.
+  FIRCLSHandler(&file, message->thread.name, NULL, true);
 
   FIRCLSFileClose(&file);
 
@@ -242,7 +242,7 @@ static void FIRCLSSignalRecordSignal(int savedErrno, siginfo_t *info, void *uapV
 
   FIRCLSFile file;
 
-  if (!FIRCLSFileInitWithPath(&file, _firclsContext.readonly->signal.path, false)) {
+  if (!FIRCLSFileInitBinaryWithPath(&file, _firclsContext.readonly->signal.path, false)) {
     FIRCLSSDKLog("Unable to open signal file\n");
     return;
   }
@@ -272,7 +272,7 @@ static void FIRCLSSignalRecordSignal(int savedErrno, siginfo_t *info, void *uapV
 
   FIRCLSFileWriteSectionEnd(&file);
 
-  FIRCLSHandler(&file, mach_thread_self(), uapVoid);
+  FIRCLSHandler(&file, mach_thread_self(), uapVoid, false);
 
   FIRCLSFileClose(&file);
 }
@@ -18,6 +18,8 @@
 #include <stdint.h>
 #include <sys/cdefs.h>
 
+#include "FIRCLSMappedRingBuffer.h"
+
 #if defined(__OBJC__)
 #import <Foundation/Foundation.h>
 #endif
@@ -34,6 +36,14 @@ typedef struct {
   size_t writeBufferLength;
 
   off_t writtenLength;
+
+  // When set, values are written in a compact tagged binary encoding instead of JSON. See
+  // FIRCLSFileInitBinaryWithPath.
+  bool binaryEncoding;
+
+  // When set, each section is written as one record of the ring buffer instead of to fd. See
+  // FIRCLSFileInitWithMappedRingBuffer.
+  FIRCLSMappedRingBuffer* ringBuffer;
 } FIRCLSFile;
 typedef FIRCLSFile* FIRCLSFileRef;
 
@@ -52,6 +62,18 @@ bool FIRCLSFileInitWithPathMode(FIRCLSFile* file,
                                 bool appendMode,
                                 bool bufferWrites);
 
+// Opens the file in append mode like FIRCLSFileInitWithPath, but writes values in a binary
+// encoding that needs no formatting or escaping, which keeps the work done in crash handlers to a
+// minimum. FIRCLSFileReadSections reads both encodings, and FIRCLSFileConvertBinaryToJSON rewrites
+// a binary file as JSON sections before it is uploaded.
+bool FIRCLSFileInitBinaryWithPath(FIRCLSFile* file, const char* path, bool bufferWrites);
+
+// Writes JSON sections into an open ring buffer, one record per section, so that each section is
+// appended with a memcpy and replaces the oldest sections once the ring is full. A section only
+// becomes visible when it ends. FIRCLSFileReadSections reads ring files like regular ones, and
+// FIRCLSFileConvertBinaryToJSON turns them into regular files.
+bool FIRCLSFileInitWithMappedRingBuffer(FIRCLSFile* file, FIRCLSMappedRingBuffer* ringBuffer);
+
 void FIRCLSFileFlushWriteBuffer(FIRCLSFile* file);
 bool FIRCLSFileClose(FIRCLSFile* file);
 bool FIRCLSFileCloseWithOffset(FIRCLSFile* file, off_t* finalSize);
@@ -97,6 +119,7 @@ void FIRCLSFileWriteInt64(FIRCLSFile* file, int64_t number);
 NSArray* FIRCLSFileReadSections(const char* path,
                                 bool deleteOnFailure,
                                 NSObject* (^transformer)(id obj));
+bool FIRCLSFileConvertBinaryToJSON(const char* path);
 NSString* FIRCLSFileHexEncodeString(const char* string);
 NSString* FIRCLSFileHexDecodeString(const char* string);
 #endif
@@ -33,6 +33,30 @@ static const size_t FIRCLSUInt64StringBufferLength = 21;
 static const size_t FIRCLSStringBufferLength = 16;
 const size_t FIRCLSWriteBufferLength = 1000;
 
+// A binary-encoded file starts with this byte, which can never start a JSON section. It is
+// followed by the top-level values, one after another. Each value starts with one of the tags
+// below. Lengths and integers are stored as base-128 varints, and signed integers are
+// zigzag-encoded first.
+static const uint8_t FIRCLSFileBinaryMagic = 0xB1;
+enum {
+  FIRCLSFileBinaryTagHashStart = 'H',
+  FIRCLSFileBinaryTagHashEnd = 'h',
+  FIRCLSFileBinaryTagArrayStart = 'A',
+  FIRCLSFileBinaryTagArrayEnd = 'a',
+  FIRCLSFileBinaryTagKey = 'K',        // length, bytes
+  FIRCLSFileBinaryTagUInt64 = 'U',     // varint
+  FIRCLSFileBinaryTagInt64 = 'I',      // zigzag varint
+  FIRCLSFileBinaryTagString = 'S',     // length, bytes
+  FIRCLSFileBinaryTagHexString = 'X',  // length, raw bytes, hex-encoded when read back
+  FIRCLSFileBinaryTagNull = 'N',
+  FIRCLSFileBinaryTagTrue = 'T',
+  FIRCLSFileBinaryTagFalse = 'F',
+};
+// Enough for a tag, a varint and a short string, so that most values take a single write.
+static const size_t FIRCLSBinaryValueBufferLength = 64;
+// Deeper nesting than this is treated as a corrupt file when reading.
+static const NSUInteger FIRCLSBinaryMaxDepth = 64;
+
 static bool FIRCLSFileInit(FIRCLSFile* file, int fdm, bool appendMode, bool bufferWrites);
 
 static void FIRCLSFileWriteToFileDescriptorOrBuffer(FIRCLSFile* file,
@@ -136,6 +160,38 @@ bool FIRCLSFileInitWithPathMode(FIRCLSFile* file,
   return FIRCLSFileInit(file, fd, appendMode, bufferWrites);
 }
 
+bool FIRCLSFileInitBinaryWithPath(FIRCLSFile* file, const char* path, bool bufferWrites) {
+  if (!FIRCLSFileInitWithPathMode(file, path, true, bufferWrites)) {
+    return false;
+  }
+
+  file->binaryEncoding = true;
+
+  if (file->writtenLength == 0) {
+    FIRCLSFileWriteToFileDescriptorOrBuffer(file, (const char*)&FIRCLSFileBinaryMagic, 1);
+  }
+
+  return true;
+}
+
+bool FIRCLSFileInitWithMappedRingBuffer(FIRCLSFile* file, FIRCLSMappedRingBuffer* ringBuffer) {
+  if (!file) {
+    FIRCLSSDKLog("Error: file is null\n");
+    return false;
+  }
+
+  if (!FIRCLSMappedRingBufferIsOpen(ringBuffer)) {
+    FIRCLSSDKLog("Error: ring buffer is not open\n");
+    return false;
+  }
+
+  memset(file, 0, sizeof(FIRCLSFile));
+  file->fd = -1;
+  file->ringBuffer = ringBuffer;
+
+  return true;
+}
+
 bool FIRCLSFileClose(FIRCLSFile* file) {
   return FIRCLSFileCloseWithOffset(file, NULL);
 }
@@ -156,6 +212,13 @@ bool FIRCLSFileCloseWithOffset(FIRCLSFile* file, off_t* finalSize) {
     *finalSize = file->writtenLength;
   }
 
+  // the ring buffer owns its file, and stays open
+  if (file->ringBuffer) {
+    memset(file, 0, sizeof(FIRCLSFile));
+    file->fd = -1;
+    return true;
+  }
+
   if (close(file->fd) != 0) {
     FIRCLSSDKLog("Error: Unable to close file %s\n", strerror(errno));
     return false;
@@ -172,7 +235,7 @@ bool FIRCLSFileIsOpen(FIRCLSFile* file) {
     return false;
   }
 
-  return file->fd > -1;
+  return file->fd > -1 || file->ringBuffer;
 }
 
 #pragma mark - Core Writing API
@@ -211,6 +274,12 @@ static void FIRCLSFileWriteToFileDescriptorOrBuffer(FIRCLSFile* file,
 }
 
 static void FIRCLSFileWriteToFileDescriptor(FIRCLSFile* file, const char* string, size_t length) {
+  if (file->ringBuffer) {
+    FIRCLSMappedRingBufferAppend(file->ringBuffer, string, length);
+    file->writtenLength += length;
+    return;
+  }
+
   if (!FIRCLSFileWriteWithRetries(file->fd, string, length)) {
     return;
   }
@@ -226,7 +295,8 @@ static void FIRCLSFileWriteToBuffer(FIRCLSFile* file, const char* string, size_t
   if (file->writeBufferLength + writeLength > FIRCLSWriteBufferLength - 1) {
     writeLength = FIRCLSWriteBufferLength - file->writeBufferLength - 1;
   }
-  strncpy(file->writeBuffer + file->writeBufferLength, string, writeLength);
+  // memcpy rather than strncpy, because binary-encoded values can contain zero bytes
+  memcpy(file->writeBuffer + file->writeBufferLength, string, writeLength);
   file->writeBufferLength += writeLength;
   file->writeBuffer[file->writeBufferLength] = '\0';
 }
@@ -272,6 +342,60 @@ bool FIRCLSFileWriteWithRetries(int fd, const void* buffer, size_t length) {
                                       });
 }
 
+#pragma mark - Binary Encoding
+
+static size_t FIRCLSFileEncodeVarint(uint8_t* buffer, uint64_t number) {
+  size_t length = 0;
+
+  while (number >= 0x80) {
+    buffer[length++] = (uint8_t)(number | 0x80);
+    number >>= 7;
+  }
+
+  buffer[length++] = (uint8_t)number;
+
+  return length;
+}
+
+// Writes a tag, an optional varint and optional bytes, collapsing them into one write call when
+// they fit in the stack buffer.
+static void FIRCLSFileWriteBinaryValue(FIRCLSFile* file,
+                                       char tag,
+                                       bool hasNumber,
+                                       uint64_t number,
+                                       const char* bytes,
+                                       size_t length) {
+  uint8_t buffer[FIRCLSBinaryValueBufferLength];
+  size_t used = 0;
+
+  buffer[used++] = (uint8_t)tag;
+  if (hasNumber) {
+    used += FIRCLSFileEncodeVarint(buffer + used, number);
+  }
+
+  if (length > 0 && used + length <= sizeof(buffer)) {
+    memcpy(buffer + used, bytes, length);
+    used += length;
+    length = 0;
+  }
+
+  FIRCLSFileWriteToFileDescriptorOrBuffer(file, (const char*)buffer, used);
+
+  if (length > 0) {
+    FIRCLSFileWriteToFileDescriptorOrBuffer(file, bytes, length);
+  }
+}
+
+static void FIRCLSFileWriteBinaryBytes(FIRCLSFile* file, char tag, const char* bytes) {
+  if (!bytes) {
+    FIRCLSFileWriteBinaryValue(file, FIRCLSFileBinaryTagNull, false, 0, NULL, 0);
+    return;
+  }
+
+  size_t length = strlen(bytes);
+  FIRCLSFileWriteBinaryValue(file, tag, true, length, bytes, length);
+}
+
 #pragma mark - Strings
 
 static void FIRCLSFileWriteUnbufferedStringWithSuffix(FIRCLSFile* file,
@@ -326,6 +450,11 @@ static void FIRCLSFileWriteStringWithSuffix(FIRCLSFile* file,
 }
 
 void FIRCLSFileWriteString(FIRCLSFile* file, const char* string) {
+  if (file->binaryEncoding) {
+    FIRCLSFileWriteBinaryBytes(file, FIRCLSFileBinaryTagString, string);
+    return;
+  }
+
   if (!string) {
     FIRCLSFileWriteToFileDescriptorOrBuffer(file, "null", 4);
     return;
@@ -339,6 +468,12 @@ void FIRCLSFileWriteHexEncodedString(FIRCLSFile* file, const char* string) {
     return;
   }
 
+  if (file->binaryEncoding) {
+    // the raw bytes are smaller, and are hex-encoded when the file is read back
+    FIRCLSFileWriteBinaryBytes(file, FIRCLSFileBinaryTagHexString, string);
+    return;
+  }
+
   if (!string) {
     FIRCLSFileWriteToFileDescriptorOrBuffer(file, "null", 4);
     return;
@@ -380,6 +515,11 @@ void FIRCLSFileWriteHexEncodedString(FIRCLSFile* file, const char* string) {
 
 #pragma mark - Integers
 void FIRCLSFileWriteUInt64(FIRCLSFile* file, uint64_t number, bool hex) {
+  if (file->binaryEncoding) {
+    FIRCLSFileWriteBinaryValue(file, FIRCLSFileBinaryTagUInt64, true, number, NULL, 0);
+    return;
+  }
+
   char buffer[FIRCLSUInt64StringBufferLength];
   short i = FIRCLSFilePrepareUInt64(buffer, number, hex);
   char* beginning = &buffer[i];  // Write from a pointer to the begining of the string.
@@ -394,6 +534,12 @@ void FIRCLSFileFDWriteUInt64(int fd, uint64_t number, bool hex) {
 }
 
 void FIRCLSFileWriteInt64(FIRCLSFile* file, int64_t number) {
+  if (file->binaryEncoding) {
+    uint64_t zigzag = ((uint64_t)number << 1) ^ (uint64_t)(number >> 63);
+    FIRCLSFileWriteBinaryValue(file, FIRCLSFileBinaryTagInt64, true, zigzag, NULL, 0);
+    return;
+  }
+
   if (number < 0) {
     FIRCLSFileWriteToFileDescriptorOrBuffer(file, "-", 1);
     number *= -1;  // make it positive
@@ -440,6 +586,12 @@ short FIRCLSFilePrepareUInt64(char* buffer, uint64_t number, bool hex) {
 }
 
 void FIRCLSFileWriteBool(FIRCLSFile* file, bool value) {
+  if (file->binaryEncoding) {
+    FIRCLSFileWriteBinaryValue(file, value ? FIRCLSFileBinaryTagTrue : FIRCLSFileBinaryTagFalse,
+                               false, 0, NULL, 0);
+    return;
+  }
+
   if (value) {
     FIRCLSFileWriteToFileDescriptorOrBuffer(file, "true", 4);
   } else {
@@ -448,16 +600,36 @@ void FIRCLSFileWriteBool(FIRCLSFile* file, bool value) {
 }
 
 void FIRCLSFileWriteSectionStart(FIRCLSFile* file, const char* name) {
+  if (file->ringBuffer) {
+    FIRCLSMappedRingBufferBeginRecord(file->ringBuffer);
+  }
+
   FIRCLSFileWriteHashStart(file);
   FIRCLSFileWriteHashKey(file, name);
 }
 
 void FIRCLSFileWriteSectionEnd(FIRCLSFile* file) {
   FIRCLSFileWriteHashEnd(file);
-  FIRCLSFileWriteToFileDescriptorOrBuffer(file, "\n", 1);
+
+  // binary values are self-delimiting, so they need no separator
+  if (!file->binaryEncoding) {
+    FIRCLSFileWriteToFileDescriptorOrBuffer(file, "\n", 1);
+  }
+
+  if (file->ringBuffer) {
+    FIRCLSMappedRingBufferCommitRecord(file->ringBuffer);
+  }
 }
 
 void FIRCLSFileWriteCollectionStart(FIRCLSFile* file, const char openingChar) {
+  if (file->binaryEncoding) {
+    char tag =
+        openingChar == '{' ? FIRCLSFileBinaryTagHashStart : FIRCLSFileBinaryTagArrayStart;
+    FIRCLSFileWriteBinaryValue(file, tag, false, 0, NULL, 0);
+    file->collectionDepth++;
+    return;
+  }
+
   char string[2];
 
   string[0] = ',';
@@ -475,7 +647,12 @@ void FIRCLSFileWriteCollectionStart(FIRCLSFile* file, const char openingChar) {
 }
 
 void FIRCLSFileWriteCollectionEnd(FIRCLSFile* file, const char closingChar) {
-  FIRCLSFileWriteToFileDescriptorOrBuffer(file, &closingChar, 1);
+  if (file->binaryEncoding) {
+    char tag = closingChar == '}' ? FIRCLSFileBinaryTagHashEnd : FIRCLSFileBinaryTagArrayEnd;
+    FIRCLSFileWriteBinaryValue(file, tag, false, 0, NULL, 0);
+  } else {
+    FIRCLSFileWriteToFileDescriptorOrBuffer(file, &closingChar, 1);
+  }
 
   if (file->collectionDepth <= 0) {
     //        FIRCLSSafeLog("Collection depth invariant violated\n");
@@ -488,7 +665,7 @@ void FIRCLSFileWriteCollectionEnd(FIRCLSFile* file, const char closingChar) {
 }
 
 void FIRCLSFileWriteColletionEntryProlog(FIRCLSFile* file) {
-  if (file->needComma) {
+  if (file->needComma && !file->binaryEncoding) {
     FIRCLSFileWriteToFileDescriptorOrBuffer(file, ",", 1);
   }
 }
@@ -508,7 +685,12 @@ void FIRCLSFileWriteHashEnd(FIRCLSFile* file) {
 void FIRCLSFileWriteHashKey(FIRCLSFile* file, const char* key) {
   FIRCLSFileWriteColletionEntryProlog(file);
 
-  FIRCLSFileWriteStringWithSuffix(file, key, strlen(key), ':');
+  if (file->binaryEncoding) {
+    size_t length = strlen(key);
+    FIRCLSFileWriteBinaryValue(file, FIRCLSFileBinaryTagKey, true, length, key, length);
+  } else {
+    FIRCLSFileWriteStringWithSuffix(file, key, strlen(key), ':');
+  }
 
   file->needComma = false;
 }
@@ -597,6 +779,195 @@ void FIRCLSFileWriteArrayEntryHexEncodedString(FIRCLSFile* file, const char* val
   FIRCLSFileWriteColletionEntryEpilog(file);
 }
 
+#pragma mark - Reading
+
+static BOOL FIRCLSFileDataIsBinaryEncoded(NSData* data) {
+  return [data length] > 0 && ((const uint8_t*)[data bytes])[0] == FIRCLSFileBinaryMagic;
+}
+
+static BOOL FIRCLSFileDataIsRingBuffer(NSData* data) {
+  return FIRCLSMappedRingBufferIsRingData([data bytes], [data length]);
+}
+
+// The records of a ring buffer are whole JSON sections, so together they read like a regular file.
+static NSData* FIRCLSFileJSONDataFromRingBufferData(NSData* data) {
+  size_t capacity = FIRCLSMappedRingBufferCapacity([data bytes], [data length]);
+  NSMutableData* records = [NSMutableData dataWithLength:capacity];
+
+  size_t length = FIRCLSMappedRingBufferCopyRecords([data bytes], [data length],
+                                                    [records mutableBytes], capacity);
+  [records setLength:length];
+
+  return records;
+}
+
+static BOOL FIRCLSFileReadBinaryVarint(NSData* data, NSUInteger* offset, uint64_t* value) {
+  const uint8_t* bytes = [data bytes];
+  uint64_t result = 0;
+
+  for (unsigned int shift = 0; shift < 64 && *offset < [data length]; shift += 7) {
+    uint8_t byte = bytes[(*offset)++];
+
+    result |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      return YES;
+    }
+  }
+
+  return NO;
+}
+
+static NSString* FIRCLSFileReadBinaryString(NSData* data, NSUInteger* offset, BOOL hexEncode) {
+  uint64_t length = 0;
+  if (!FIRCLSFileReadBinaryVarint(data, offset, &length)) {
+    return nil;
+  }
+
+  if (length > [data length] - *offset) {
+    return nil;
+  }
+
+  const uint8_t* bytes = (const uint8_t*)[data bytes] + *offset;
+  *offset += (NSUInteger)length;
+
+  if (!hexEncode) {
+    return [[NSString alloc] initWithBytes:bytes
+                                    length:(NSUInteger)length
+                                  encoding:NSUTF8StringEncoding];
+  }
+
+  NSMutableData* encoded = [NSMutableData dataWithLength:(NSUInteger)length * 2];
+  char* encodedBytes = [encoded mutableBytes];
+  for (NSUInteger i = 0; i < length; ++i) {
+    FIRCLSHexFromByte(bytes[i], &encodedBytes[i * 2]);
+  }
+
+  return [[NSString alloc] initWithData:encoded encoding:NSASCIIStringEncoding];
+}
+
+// Decodes one value into the same Foundation objects NSJSONSerialization would produce for its
+// JSON counterpart. Returns nil if the data is truncated or corrupt.
+static id FIRCLSFileReadBinaryValue(NSData* data, NSUInteger* offset, NSUInteger depth) {
+  if (*offset >= [data length] || depth > FIRCLSBinaryMaxDepth) {
+    return nil;
+  }
+
+  uint8_t tag = ((const uint8_t*)[data bytes])[(*offset)++];
+  uint64_t number = 0;
+
+  switch (tag) {
+    case FIRCLSFileBinaryTagHashStart: {
+      NSMutableDictionary* hash = [NSMutableDictionary dictionary];
+      while (*offset < [data length]) {
+        uint8_t keyTag = ((const uint8_t*)[data bytes])[(*offset)++];
+        if (keyTag == FIRCLSFileBinaryTagHashEnd) {
+          return hash;
+        }
+
+        NSString* key = nil;
+        if (keyTag == FIRCLSFileBinaryTagKey) {
+          key = FIRCLSFileReadBinaryString(data, offset, NO);
+        }
+
+        id value = key ? FIRCLSFileReadBinaryValue(data, offset, depth + 1) : nil;
+        if (!value) {
+          return nil;
+        }
+
+        hash[key] = value;
+      }
+      return nil;
+    }
+    case FIRCLSFileBinaryTagArrayStart: {
+      NSMutableArray* array = [NSMutableArray array];
+      while (*offset < [data length]) {
+        if (((const uint8_t*)[data bytes])[*offset] == FIRCLSFileBinaryTagArrayEnd) {
+          (*offset)++;
+          return array;
+        }
+
+        id value = FIRCLSFileReadBinaryValue(data, offset, depth + 1);
+        if (!value) {
+          return nil;
+        }
+
+        [array addObject:value];
+      }
+      return nil;
+    }
+    case FIRCLSFileBinaryTagUInt64:
+      if (!FIRCLSFileReadBinaryVarint(data, offset, &number)) {
+        return nil;
+      }
+      return @(number);
+    case FIRCLSFileBinaryTagInt64:
+      if (!FIRCLSFileReadBinaryVarint(data, offset, &number)) {
+        return nil;
+      }
+      return @((int64_t)(number >> 1) ^ -(int64_t)(number & 1));
+    case FIRCLSFileBinaryTagString:
+      return FIRCLSFileReadBinaryString(data, offset, NO);
+    case FIRCLSFileBinaryTagHexString:
+      return FIRCLSFileReadBinaryString(data, offset, YES);
+    case FIRCLSFileBinaryTagNull:
+      return [NSNull null];
+    case FIRCLSFileBinaryTagTrue:
+      return @YES;
+    case FIRCLSFileBinaryTagFalse:
+      return @NO;
+    default:
+      return nil;
+  }
+}
+
+static NSArray* FIRCLSFileReadBinarySectionsFromData(NSData* data) {
+  NSMutableArray* sections = [NSMutableArray array];
+
+  // A crash can interrupt the last value, and there is no way to resynchronize after a corrupt
+  // one, so keep everything decoded up to that point.
+  NSUInteger offset = 1;
+  while (offset < [data length]) {
+    id section = FIRCLSFileReadBinaryValue(data, &offset, 0);
+    if (!section) {
+      FIRCLSSDKLog("Unable to decode binary section at offset %lu\n", (unsigned long)offset);
+      break;
+    }
+
+    [sections addObject:section];
+  }
+
+  return sections;
+}
+
+static NSArray* FIRCLSFileReadJSONSectionsFromData(NSData* data) {
+  if (!data) {
+    return nil;
+  }
+
+  NSString* contents = [[NSString alloc] initWithData:data encoding:NSUTF8StringEncoding];
+  NSArray* components = [contents componentsSeparatedByString:@"\n"];
+
+  if (!components) {
+    return nil;
+  }
+
+  NSMutableArray* sections = [NSMutableArray array];
+
+  for (NSString* component in components) {
+    NSData* componentData = [component dataUsingEncoding:NSUTF8StringEncoding];
+
+    id obj = [NSJSONSerialization JSONObjectWithData:componentData options:0 error:nil];
+    if (!obj) {
+      continue;
+    }
+
+    [sections addObject:obj];
+  }
+
+  return sections;
+}
+
 NSArray* FIRCLSFileReadSections(const char* path,
                                 bool deleteOnFailure,
                                 NSObject* (^transformer)(id obj)) {
@@ -606,12 +977,16 @@ NSArray* FIRCLSFileReadSections(const char* path,
   }
 
   NSString* pathString = [NSString stringWithUTF8String:path];
-  NSString* contents = [NSString stringWithContentsOfFile:pathString
-                                                 encoding:NSUTF8StringEncoding
-                                                    error:nil];
-  NSArray* components = [contents componentsSeparatedByString:@"\n"];
+  NSData* data = [NSData dataWithContentsOfFile:pathString];
+  if (FIRCLSFileDataIsRingBuffer(data)) {
+    data = FIRCLSFileJSONDataFromRingBufferData(data);
+  }
 
-  if (!components) {
+  NSArray* sections = FIRCLSFileDataIsBinaryEncoded(data)
+                          ? FIRCLSFileReadBinarySectionsFromData(data)
+                          : FIRCLSFileReadJSONSectionsFromData(data);
+
+  if (!sections) {
     if (deleteOnFailure) {
       unlink(path);
     }
@@ -623,13 +998,8 @@ NSArray* FIRCLSFileReadSections(const char* path,
   NSMutableArray* array = [NSMutableArray array];
 
   // loop through all the entires, and
-  for (NSString* component in components) {
-    NSData* data = [component dataUsingEncoding:NSUTF8StringEncoding];
-
-    id obj = [NSJSONSerialization JSONObjectWithData:data options:0 error:nil];
-    if (!obj) {
-      continue;
-    }
+  for (id section in sections) {
+    id obj = section;
 
     if (transformer) {
       obj = transformer(obj);
@@ -645,6 +1015,47 @@ NSArray* FIRCLSFileReadSections(const char* path,
   return array;
 }
 
+bool FIRCLSFileConvertBinaryToJSON(const char* path) {
+  if (!FIRCLSIsValidPointer(path)) {
+    FIRCLSSDKLogError("Error: input path is invalid\n");
+    return false;
+  }
+
+  NSString* pathString = [NSString stringWithUTF8String:path];
+  NSData* data = [NSData dataWithContentsOfFile:pathString];
+  if (FIRCLSFileDataIsRingBuffer(data)) {
+    if (![FIRCLSFileJSONDataFromRingBufferData(data) writeToFile:pathString atomically:YES]) {
+      FIRCLSSDKLog("Unable to convert ring buffer file %s\n", path);
+      return false;
+    }
+
+    return true;
+  }
+
+  if (!FIRCLSFileDataIsBinaryEncoded(data)) {
+    // missing, or already JSON
+    return true;
+  }
+
+  NSMutableData* output = [NSMutableData data];
+  for (id section in FIRCLSFileReadBinarySectionsFromData(data)) {
+    NSData* line = [NSJSONSerialization dataWithJSONObject:section options:0 error:nil];
+    if (!line) {
+      continue;
+    }
+
+    [output appendData:line];
+    [output appendBytes:"\n" length:1];
+  }
+
+  if (![output writeToFile:pathString atomically:YES]) {
+    FIRCLSSDKLog("Unable to convert binary file %s\n", path);
+    return false;
+  }
+
+  return true;
+}
+
 NSString* FIRCLSFileHexEncodeString(const char* string) {
   size_t length = strlen(string);
   char* encodedBuffer = malloc(length * 2 + 1);
@@ -0,0 +1,287 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdatomic.h>
+
+#include "FIRCLSMappedRingBuffer.h"
+#include "FIRCLSUtility.h"
+
+#include <TargetConditionals.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// "CLSR"
+#define CLS_RING_BUFFER_MAGIC (0x52534c43)
+
+// Offsets are logical: they only ever grow, and wrap around the data region modulo the capacity.
+// Records between tail and head are committed and whole. Each is a 4-byte length followed by the
+// record's bytes, and may wrap.
+struct FIRCLSMappedRingBufferHeader {
+  uint32_t magic;
+  uint32_t capacity;
+  _Atomic(uint64_t) tail;
+  _Atomic(uint64_t) head;
+};
+
+static const size_t FIRCLSMappedRingBufferDataOffset = sizeof(FIRCLSMappedRingBufferHeader);
+
+#pragma mark - Wrapped Copies
+static void FIRCLSMappedRingBufferCopyIn(uint8_t* data,
+                                         uint64_t capacity,
+                                         uint64_t offset,
+                                         const void* bytes,
+                                         size_t length) {
+  size_t start = (size_t)(offset % capacity);
+  size_t firstLength = length;
+
+  if (start + length > capacity) {
+    firstLength = (size_t)capacity - start;
+  }
+
+  memcpy(data + start, bytes, firstLength);
+  memcpy(data, (const uint8_t*)bytes + firstLength, length - firstLength);
+}
+
+static void FIRCLSMappedRingBufferCopyOut(const uint8_t* data,
+                                          uint64_t capacity,
+                                          uint64_t offset,
+                                          void* bytes,
+                                          size_t length) {
+  size_t start = (size_t)(offset % capacity);
+  size_t firstLength = length;
+
+  if (start + length > capacity) {
+    firstLength = (size_t)capacity - start;
+  }
+
+  memcpy(bytes, data + start, firstLength);
+  memcpy((uint8_t*)bytes + firstLength, data, length - firstLength);
+}
+
+#pragma mark - Lifecycle
+bool FIRCLSMappedRingBufferOpen(FIRCLSMappedRingBuffer* ring, const char* path, uint32_t capacity) {
+  if (!ring || !path || capacity == 0) {
+    return false;
+  }
+
+  memset(ring, 0, sizeof(FIRCLSMappedRingBuffer));
+  ring->fd = -1;
+
+  int mask = O_RDWR | O_CREAT | O_TRUNC;
+#if TARGET_OS_IPHONE
+  // same data protection class as FIRCLSFile, so the ring stays writable while locked
+  int fd = open_dprotected_np(path, mask, 4, 0, 0644);
+#else
+  int fd = open(path, mask, 0644);
+#endif
+  if (fd < 0) {
+    FIRCLSSDKLog("Error: Unable to open ring buffer file %s\n", strerror(errno));
+    return false;
+  }
+
+  size_t mappedLength = FIRCLSMappedRingBufferDataOffset + capacity;
+  if (ftruncate(fd, (off_t)mappedLength) != 0) {
+    FIRCLSSDKLog("Error: Unable to size ring buffer file %s\n", strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  void* mapping = mmap(NULL, mappedLength, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    FIRCLSSDKLog("Error: Unable to map ring buffer file %s\n", strerror(errno));
+    close(fd);
+    return false;
+  }
+
+  ring->fd = fd;
+  ring->header = mapping;
+  ring->data = (uint8_t*)mapping + FIRCLSMappedRingBufferDataOffset;
+  ring->mappedLength = mappedLength;
+  ring->capacity = capacity;
+
+  ring->header->capacity = capacity;
+  atomic_store(&ring->header->tail, 0);
+  atomic_store(&ring->header->head, 0);
+  ring->header->magic = CLS_RING_BUFFER_MAGIC;
+
+  return true;
+}
+
+void FIRCLSMappedRingBufferClose(FIRCLSMappedRingBuffer* ring) {
+  if (!FIRCLSMappedRingBufferIsOpen(ring)) {
+    return;
+  }
+
+  munmap(ring->header, ring->mappedLength);
+  close(ring->fd);
+
+  memset(ring, 0, sizeof(FIRCLSMappedRingBuffer));
+  ring->fd = -1;
+}
+
+bool FIRCLSMappedRingBufferIsOpen(const FIRCLSMappedRingBuffer* ring) {
+  return ring && ring->header;
+}
+
+#pragma mark - Writing
+// Drops the oldest records until the current record can grow to end. Fails, without dropping
+// anything, if the record can never fit.
+static bool FIRCLSMappedRingBufferMakeRoom(FIRCLSMappedRingBuffer* ring, uint64_t end) {
+  if (end - ring->recordStart > ring->capacity) {
+    FIRCLSSDKLog("Dropping a record larger than the ring buffer\n");
+    ring->recordFailed = true;
+    return false;
+  }
+
+  uint64_t tail = atomic_load_explicit(&ring->header->tail, memory_order_relaxed);
+  if (end - tail <= ring->capacity) {
+    return true;
+  }
+
+  while (end - tail > ring->capacity) {
+    uint32_t length = 0;
+    FIRCLSMappedRingBufferCopyOut(ring->data, ring->capacity, tail, &length, sizeof(length));
+    tail += sizeof(length) + length;
+  }
+
+  // Publish the new tail before overwriting the dropped records, so a reader never sees a tail
+  // pointing at bytes that belong to the record being written.
+  atomic_store_explicit(&ring->header->tail, tail, memory_order_release);
+
+  return true;
+}
+
+void FIRCLSMappedRingBufferBeginRecord(FIRCLSMappedRingBuffer* ring) {
+  if (!FIRCLSMappedRingBufferIsOpen(ring)) {
+    return;
+  }
+
+  ring->recordStart = atomic_load_explicit(&ring->header->head, memory_order_relaxed);
+  ring->recordFailed = false;
+
+  // reserve the length, which is only known on commit
+  ring->recordEnd = ring->recordStart + sizeof(uint32_t);
+  FIRCLSMappedRingBufferMakeRoom(ring, ring->recordEnd);
+}
+
+void FIRCLSMappedRingBufferAppend(FIRCLSMappedRingBuffer* ring, const void* bytes, size_t length) {
+  if (!FIRCLSMappedRingBufferIsOpen(ring) || ring->recordFailed || length == 0) {
+    return;
+  }
+
+  if (!FIRCLSMappedRingBufferMakeRoom(ring, ring->recordEnd + length)) {
+    return;
+  }
+
+  FIRCLSMappedRingBufferCopyIn(ring->data, ring->capacity, ring->recordEnd, bytes, length);
+  ring->recordEnd += length;
+}
+
+bool FIRCLSMappedRingBufferCommitRecord(FIRCLSMappedRingBuffer* ring) {
+  if (!FIRCLSMappedRingBufferIsOpen(ring) || ring->recordFailed) {
+    return false;
+  }
+
+  uint32_t length = (uint32_t)(ring->recordEnd - ring->recordStart - sizeof(length));
+  FIRCLSMappedRingBufferCopyIn(ring->data, ring->capacity, ring->recordStart, &length,
+                               sizeof(length));
+
+  atomic_store_explicit(&ring->header->head, ring->recordEnd, memory_order_release);
+
+  return true;
+}
+
+#pragma mark - Reading
+static bool FIRCLSMappedRingBufferReadHeader(const void* contents,
+                                             size_t length,
+                                             uint64_t* capacity,
+                                             uint64_t* tail,
+                                             uint64_t* head) {
+  if (!contents || length < FIRCLSMappedRingBufferDataOffset) {
+    return false;
+  }
+
+  const uint8_t* bytes = contents;
+  uint32_t magic = 0;
+  uint32_t ringCapacity = 0;
+
+  memcpy(&magic, bytes + offsetof(FIRCLSMappedRingBufferHeader, magic), sizeof(magic));
+  memcpy(&ringCapacity, bytes + offsetof(FIRCLSMappedRingBufferHeader, capacity),
+         sizeof(ringCapacity));
+  memcpy(tail, bytes + offsetof(FIRCLSMappedRingBufferHeader, tail), sizeof(*tail));
+  memcpy(head, bytes + offsetof(FIRCLSMappedRingBufferHeader, head), sizeof(*head));
+
+  if (magic != CLS_RING_BUFFER_MAGIC || ringCapacity == 0 ||
+      length < FIRCLSMappedRingBufferDataOffset + ringCapacity) {
+    return false;
+  }
+
+  if (*head < *tail || *head - *tail > ringCapacity) {
+    return false;
+  }
+
+  *capacity = ringCapacity;
+
+  return true;
+}
+
+bool FIRCLSMappedRingBufferIsRingData(const void* contents, size_t length) {
+  uint64_t capacity, tail, head;
+
+  return FIRCLSMappedRingBufferReadHeader(contents, length, &capacity, &tail, &head);
+}
+
+size_t FIRCLSMappedRingBufferCapacity(const void* contents, size_t length) {
+  uint64_t capacity, tail, head;
+
+  if (!FIRCLSMappedRingBufferReadHeader(contents, length, &capacity, &tail, &head)) {
+    return 0;
+  }
+
+  return (size_t)capacity;
+}
+
+size_t FIRCLSMappedRingBufferCopyRecords(const void* contents,
+                                         size_t length,
+                                         void* output,
+                                         size_t outputLength) {
+  uint64_t capacity, tail, head;
+
+  if (!FIRCLSMappedRingBufferReadHeader(contents, length, &capacity, &tail, &head)) {
+    return 0;
+  }
+
+  const uint8_t* data = (const uint8_t*)contents + FIRCLSMappedRingBufferDataOffset;
+  size_t copied = 0;
+
+  while (head - tail >= sizeof(uint32_t)) {
+    uint32_t recordLength = 0;
+    FIRCLSMappedRingBufferCopyOut(data, capacity, tail, &recordLength, sizeof(recordLength));
+    tail += sizeof(recordLength);
+
+    if (recordLength > head - tail || recordLength > outputLength - copied) {
+      break;
+    }
+
+    FIRCLSMappedRingBufferCopyOut(data, capacity, tail, (uint8_t*)output + copied, recordLength);
+    tail += recordLength;
+    copied += recordLength;
+  }
+
+  return copied;
+}
@@ -0,0 +1,70 @@
+// Copyright 2019 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/cdefs.h>
+#include <sys/types.h>
+
+__BEGIN_DECLS
+
+// A fixed-size ring of records, backed by a shared mapping of a file. Appending a record is a
+// memcpy into the mapping, with no system calls, and the oldest whole records are dropped to make
+// room. Because the mapping is shared, committed records are in the file even if the process
+// crashes right after writing them.
+//
+// Records are published atomically: a record becomes visible to readers only once it is
+// committed, so a crash in the middle of a write loses that record and nothing else. There must
+// be only one writer at a time.
+typedef struct FIRCLSMappedRingBufferHeader FIRCLSMappedRingBufferHeader;
+
+typedef struct {
+  int fd;
+  FIRCLSMappedRingBufferHeader* header;
+  uint8_t* data;
+  size_t mappedLength;
+  uint64_t capacity;
+
+  // the record being written, which is not visible until committed
+  uint64_t recordStart;
+  uint64_t recordEnd;
+  bool recordFailed;
+} FIRCLSMappedRingBuffer;
+
+// Creates the file at path, replacing any existing one, and maps it with room for capacity bytes
+// of records, including a 4-byte length per record.
+bool FIRCLSMappedRingBufferOpen(FIRCLSMappedRingBuffer* ring, const char* path, uint32_t capacity);
+void FIRCLSMappedRingBufferClose(FIRCLSMappedRingBuffer* ring);
+bool FIRCLSMappedRingBufferIsOpen(const FIRCLSMappedRingBuffer* ring);
+
+// Writing. Appends between Begin and Commit make up one record. A record that does not fit in the
+// whole ring is dropped.
+void FIRCLSMappedRingBufferBeginRecord(FIRCLSMappedRingBuffer* ring);
+void FIRCLSMappedRingBufferAppend(FIRCLSMappedRingBuffer* ring, const void* bytes, size_t length);
+bool FIRCLSMappedRingBufferCommitRecord(FIRCLSMappedRingBuffer* ring);
+
+// Reading, from the contents of a ring file.
+bool FIRCLSMappedRingBufferIsRingData(const void* contents, size_t length);
+// Copies the committed records, oldest first and without their lengths, into output. Returns the
+// number of bytes copied, which is never more than the capacity of the ring.
+size_t FIRCLSMappedRingBufferCopyRecords(const void* contents,
+                                         size_t length,
+                                         void* output,
+                                         size_t outputLength);
+// The capacity of the ring stored in contents, or 0 if it is not a ring file.
+size_t FIRCLSMappedRingBufferCapacity(const void* contents, size_t length);
+
+__END_DECLS
@@ -21,21 +21,30 @@ FIRCLSProfileMark FIRCLSProfilingStart(void) {
   return mach_absolute_time();
 }
 
-double FIRCLSProfileEnd(FIRCLSProfileMark mark) {
+static uint64_t FIRCLSProfileEndNanoseconds(FIRCLSProfileMark mark) {
   uint64_t duration = mach_absolute_time() - mark;
 
   mach_timebase_info_data_t info;
   mach_timebase_info(&info);
 
   if (info.denom == 0) {
-    return 0.0;
+    return 0;
   }
 
   // Convert to nanoseconds
   duration *= info.numer;
   duration /= info.denom;
 
-  return (double)duration / (double)NSEC_PER_MSEC;  // return time in milliseconds
+  return duration;
+}
+
+double FIRCLSProfileEnd(FIRCLSProfileMark mark) {
+  // return time in milliseconds
+  return (double)FIRCLSProfileEndNanoseconds(mark) / (double)NSEC_PER_MSEC;
+}
+
+uint64_t FIRCLSProfileEndMicroseconds(FIRCLSProfileMark mark) {
+  return FIRCLSProfileEndNanoseconds(mark) / NSEC_PER_USEC;
 }
 
 void FIRCLSProfileBlock(const char* label, void (^block)(void)) {
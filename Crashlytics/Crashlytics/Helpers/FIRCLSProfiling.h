@@ -23,6 +23,8 @@ __BEGIN_DECLS
 // high-resolution timing, returning the results in seconds
 FIRCLSProfileMark FIRCLSProfilingStart(void);
 double FIRCLSProfileEnd(FIRCLSProfileMark mark);
+// whole microseconds, which needs no floating point and so is usable at crash time
+uint64_t FIRCLSProfileEndMicroseconds(FIRCLSProfileMark mark);
 
 void FIRCLSProfileBlock(const char* label, void (^block)(void));
 
@@ -44,6 +44,10 @@
 @property(nonatomic, readonly) NSString *pendingPath;
 @property(nonatomic, readonly) NSString *preparedPath;
 @property(nonatomic, readonly) NSString *legacyPreparedPath;
+/**
+ * Path to the directory of binary image manifests shared between reports
+ */
+@property(nonatomic, readonly) NSString *binaryImageManifestPath;
 @property(nonatomic, readonly) NSArray *activePathContents;
 @property(nonatomic, readonly) NSArray *legacyPreparedPathContents;
 @property(nonatomic, readonly) NSArray *preparedPathContents;
@@ -61,6 +65,7 @@
                        usingBlock:(void (^)(NSString *filePath, NSString *extension))block;
 - (BOOL)moveItemsFromDirectory:(NSString *)srcDir toDirectory:(NSString *)destDir;
 - (NSNumber *)fileSizeAtPath:(NSString *)path;
+- (NSDate *)modificationDateAtPath:(NSString *)path;
 - (NSArray *)contentsOfDirectory:(NSString *)path;
 
 // logic of managing files/directories
@@ -169,6 +169,18 @@ NSString *const FIRCLSCacheVersion = @"v5";
   return [attrs objectForKey:NSFileSize];
 }
 
+- (NSDate *)modificationDateAtPath:(NSString *)path {
+  NSError *error = nil;
+  NSDictionary *attrs = [[self underlyingFileManager] attributesOfItemAtPath:path error:&error];
+
+  if (!attrs) {
+    FIRCLSErrorLog(@"Unable to read modification date: %@", error);
+    return nil;
+  }
+
+  return [attrs objectForKey:NSFileModificationDate];
+}
+
 - (NSArray *)contentsOfDirectory:(NSString *)path {
   NSMutableArray *array = [NSMutableArray array];
 
@@ -231,6 +243,10 @@ NSString *const FIRCLSCacheVersion = @"v5";
   return [[self structurePath] stringByAppendingPathComponent:@"prepared"];
 }
 
+- (NSString *)binaryImageManifestPath {
+  return [[self structurePath] stringByAppendingPathComponent:@"binary-images"];
+}
+
 - (NSArray *)activePathContents {
   return [self contentsOfDirectory:[self activePath]];
 }
@@ -265,6 +281,10 @@ NSString *const FIRCLSCacheVersion = @"v5";
     return NO;
   }
 
+  if (![self createDirectoryAtPath:[self binaryImageManifestPath]]) {
+    return NO;
+  }
+
   return YES;
 }
 
@@ -104,6 +104,12 @@ extern NSString *const FIRCLSReportUserCompactedKVFile;
 
 @property(nonatomic, copy, readonly) NSDate *crashedOnDate;
 
+/**
+ * Returns the time, in microseconds, that the crash handler spent in each phase, or nil if the
+ * report has no crash or the handler didn't get as far as recording it.
+ **/
+@property(nonatomic, copy, readonly) NSDictionary *crashHandlerTimings;
+
 /**
  * Returns the os version that the application crashed on.
  **/
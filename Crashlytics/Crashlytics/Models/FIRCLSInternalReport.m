@@ -240,6 +240,25 @@ NSString *const FIRCLSReportUserCompactedKVFile = @"user_compacted_kv.clsrecord"
   return [NSDate dateWithTimeIntervalSince1970:[timeValue unsignedIntegerValue]];
 }
 
+- (NSDictionary *)crashHandlerTimings {
+  if (!self.isCrash) {
+    return nil;
+  }
+
+  for (NSString *fileName in [FIRCLSInternalReport crashFileNames]) {
+    NSString *path = [self pathForContentFile:fileName];
+
+    for (NSDictionary *section in [self.class readFIRCLSFileAtPath:path]) {
+      NSDictionary *timings = [section objectForKey:@"handler_timings"];
+      if ([timings isKindOfClass:[NSDictionary class]]) {
+        return timings;
+      }
+    }
+  }
+
+  return nil;
+}
+
 - (NSString *)OSVersion {
   return [[[self.metadataSections objectAtIndex:1] objectForKey:@"host"]
       objectForKey:@"os_display_version"];
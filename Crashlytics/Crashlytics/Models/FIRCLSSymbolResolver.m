@@ -21,8 +21,22 @@
 #import "FIRCLSLogger.h"
 #import "FIRStackFrame_Private.h"
 
+// Threads of the same process share most of their outer frames, so the same addresses come up
+// again and again. This bounds the cache of their resolved symbols.
+static const NSUInteger FIRCLSSymbolResolverCacheCountLimit = 1024;
+
 @interface FIRCLSSymbolResolver () {
   NSMutableArray* _binaryImages;
+
+  // Consecutive frames usually fall in the same image, so check the last one found first.
+  NSDictionary* _lastBinaryImage;
+
+  // FIRCLSBinaryImageDetails, boxed in NSValue, by image UUID. Finding an image by UUID walks the
+  // whole list of loaded images, so it's only done once per image.
+  NSMutableDictionary<NSString*, NSValue*>* _imageDetails;
+
+  // The fields of a resolved frame, by address
+  NSCache<NSNumber*, NSDictionary*>* _resolvedFrames;
 }
 
 @end
@@ -36,6 +50,9 @@
   }
 
   _binaryImages = [NSMutableArray array];
+  _imageDetails = [NSMutableDictionary dictionary];
+  _resolvedFrames = [[NSCache alloc] init];
+  _resolvedFrames.countLimit = FIRCLSSymbolResolverCacheCountLimit;
 
   return self;
 }
@@ -83,20 +100,46 @@
   return YES;
 }
 
+static BOOL FIRCLSSymbolResolverImageContainsPC(NSDictionary* image, uintptr_t pc) {
+  uintptr_t base = [[image objectForKey:@"base"] unsignedIntegerValue];
+  uintptr_t size = [[image objectForKey:@"size"] unsignedIntegerValue];
+
+  return pc >= base && pc < (base + size);
+}
+
 - (NSDictionary*)loadedBinaryImageForPC:(uintptr_t)pc {
-  NSUInteger index =
-      [_binaryImages indexOfObjectPassingTest:^BOOL(id obj, NSUInteger idx, BOOL* stop) {
-        uintptr_t base = [[obj objectForKey:@"base"] unsignedIntegerValue];
-        uintptr_t size = [[obj objectForKey:@"size"] unsignedIntegerValue];
+  if (_lastBinaryImage && FIRCLSSymbolResolverImageContainsPC(_lastBinaryImage, pc)) {
+    return _lastBinaryImage;
+  }
+
+  // The images are sorted by base address, so find the last one starting at or before pc.
+  NSUInteger low = 0;
+  NSUInteger high = [_binaryImages count];
+
+  while (low < high) {
+    NSUInteger mid = low + (high - low) / 2;
+    NSDictionary* image = [_binaryImages objectAtIndex:mid];
+    uintptr_t base = [[image objectForKey:@"base"] unsignedIntegerValue];
 
-        return pc >= base && pc < (base + size);
-      }];
+    if (base <= pc) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
 
-  if (index == NSNotFound) {
+  if (low == 0) {
     return nil;
   }
 
-  return [_binaryImages objectAtIndex:index];
+  NSDictionary* image = [_binaryImages objectAtIndex:low - 1];
+  if (!FIRCLSSymbolResolverImageContainsPC(image, pc)) {
+    return nil;
+  }
+
+  _lastBinaryImage = image;
+
+  return image;
 }
 
 - (BOOL)fillInImageDetails:(FIRCLSBinaryImageDetails*)details forUUID:(NSString*)uuid {
@@ -104,7 +147,20 @@
     return NO;
   }
 
-  return FIRCLSBinaryImageFindImageForUUID([uuid UTF8String], details);
+  NSValue* cached = [_imageDetails objectForKey:uuid];
+  if (cached) {
+    [cached getValue:details];
+    return YES;
+  }
+
+  if (!FIRCLSBinaryImageFindImageForUUID([uuid UTF8String], details)) {
+    return NO;
+  }
+
+  NSValue* value = [NSValue valueWithBytes:details objCType:@encode(FIRCLSBinaryImageDetails)];
+  [_imageDetails setObject:value forKey:uuid];
+
+  return YES;
 }
 
 - (FIRStackFrame*)frameForAddress:(uint64_t)address {
@@ -123,6 +179,35 @@
     return NO;
   }
 
+  NSDictionary* resolved = [_resolvedFrames objectForKey:@(address)];
+  if (!resolved) {
+    resolved = [self resolveAddress:address];
+    if (!resolved) {
+      return NO;
+    }
+
+    [_resolvedFrames setObject:resolved forKey:@(address)];
+  }
+
+  NSString* symbol = [resolved objectForKey:@"symbol"];
+  if (symbol) {
+    frame.symbol = symbol;
+    frame.rawSymbol = symbol;
+  }
+
+  NSNumber* offset = [resolved objectForKey:@"offset"];
+  if (offset) {
+    [frame setOffset:[offset unsignedIntegerValue]];
+  }
+
+  [frame setLibrary:[resolved objectForKey:@"library"]];
+
+  return YES;
+}
+
+// Looks up the symbol for an address, returning the frame's symbol, offset and library, or nil if
+// it can't be found.
+- (NSDictionary*)resolveAddress:(uint64_t)address {
   NSDictionary* binaryImage = [self loadedBinaryImageForPC:(uintptr_t)address];
 
   FIRCLSBinaryImageDetails imageDetails;
@@ -131,7 +216,7 @@
 #if DEBUG
     FIRCLSDebugLog(@"Image not found");
 #endif
-    return NO;
+    return nil;
   }
 
   uintptr_t addr = (uintptr_t)address -
@@ -143,7 +228,7 @@
 #if DEBUG
     FIRCLSDebugLog(@"Could not look up address");
 #endif
-    return NO;
+    return nil;
   }
 
   if (addr - (uintptr_t)dlInfo.dli_saddr == 0) {
@@ -152,24 +237,26 @@
 #if DEBUG
       FIRCLSDebugLog(@"Could not look up address");
 #endif
-      return NO;
+      return nil;
     }
   }
 
-  if (dlInfo.dli_sname) {
-    NSString* symbol = [NSString stringWithUTF8String:dlInfo.dli_sname];
+  NSMutableDictionary* resolved = [NSMutableDictionary dictionaryWithCapacity:3];
 
-    frame.symbol = symbol;
-    frame.rawSymbol = symbol;
+  if (dlInfo.dli_sname) {
+    [resolved setObject:[NSString stringWithUTF8String:dlInfo.dli_sname] forKey:@"symbol"];
   }
 
   if (addr > (uintptr_t)dlInfo.dli_saddr) {
-    [frame setOffset:addr - (uintptr_t)dlInfo.dli_saddr];
+    [resolved setObject:@(addr - (uintptr_t)dlInfo.dli_saddr) forKey:@"offset"];
   }
 
-  [frame setLibrary:[[binaryImage objectForKey:@"path"] lastPathComponent]];
+  NSString* library = [[binaryImage objectForKey:@"path"] lastPathComponent];
+  if (library) {
+    [resolved setObject:library forKey:@"library"];
+  }
 
-  return YES;
+  return resolved;
 }
 
 @end
@@ -83,6 +83,15 @@ NS_SWIFT_NAME(Crashlytics)
  */
 - (void)setCustomValue:(id)value forKey:(NSString *)key;
 
+/**
+ * Sets multiple custom keys and values at once. This is equivalent to calling
+ * setCustomValue:forKey: for each entry, but records them together, which is much cheaper when
+ * setting many keys, for example at startup. An NSNull value removes its key.
+ *
+ * @param keysAndValues The values to be associated with their keys
+ */
+- (void)setCustomKeysAndValues:(NSDictionary *)keysAndValues;
+
 /**
  * Records a user ID (identifier) that's associated with subsequent fatal and non-fatal reports.
  *
@@ -119,6 +128,20 @@ NS_SWIFT_NAME(Crashlytics)
 - (void)recordExceptionModel:(FIRExceptionModel *)exceptionModel
     NS_SWIFT_NAME(record(exceptionModel:));
 
+/**
+ * Reports hangs of the main thread as non-fatal events. When the main run loop is busy with a
+ * single pass for longer than the threshold, Crashlytics samples the main thread's stack until
+ * the run loop moves on, and records the stack it saw most often. The stack is symbolicated the
+ * same way as crash reports.
+ *
+ * Hang detection is off by default, and ignores hangs while a debugger is attached.
+ *
+ * @param threshold How long the main thread must be unresponsive for a hang to be recorded, in
+ * seconds. A threshold of 0 turns hang detection off.
+ */
+- (void)setHangDetectionThreshold:(NSTimeInterval)threshold
+    NS_SWIFT_NAME(setHangDetectionThreshold(_:));
+
 /**
  * Returns whether the app crashed during the previous execution.
  */
@@ -124,6 +124,11 @@ bool FIRCLSCompactUnwindLookupFirstLevel(FIRCLSCompactUnwindContext* context, ui
 
   address -= context->loadAddress;  // search relative to zero
 
+  if (context->hasFirstLevelEntry && address >= context->indexHeader.functionOffset &&
+      address < context->firstLevelNextFunctionOffset) {
+    return true;
+  }
+
   // minus one because of the extra entry - see comment above
   for (uint32_t index = 0; index < indexCount - 1; ++index) {
     uint32_t value = indexEntries[index].functionOffset;
@@ -132,10 +137,12 @@ bool FIRCLSCompactUnwindLookupFirstLevel(FIRCLSCompactUnwindContext* context, ui
     if (address >= value && address < nextValue) {
       context->firstLevelNextFunctionOffset = nextValue;
       context->indexHeader = indexEntries[index];
+      context->hasFirstLevelEntry = true;
       return true;
     }
   }
 
+  context->hasFirstLevelEntry = false;
   return false;
 }
 
@@ -320,6 +327,13 @@ bool FIRCLSCompactUnwindLookup(FIRCLSCompactUnwindContext* context,
     return false;
   }
 
+  // same function as the last lookup, which is typical of recursion
+  if (context->hasLastResult && pc >= context->lastResult.functionStart &&
+      pc < context->lastResult.functionEnd) {
+    *result = context->lastResult;
+    return true;
+  }
+
   // step 1 - find the pc in the first-level index
   if (!FIRCLSCompactUnwindLookupFirstLevel(context, pc)) {
     FIRCLSSDKLogWarn("Unable to find pc in first level\n");
@@ -336,6 +350,9 @@ bool FIRCLSCompactUnwindLookup(FIRCLSCompactUnwindContext* context,
     return false;
   }
 
+  context->lastResult = *result;
+  context->hasLastResult = true;
+
   return true;
 }
 
@@ -383,14 +400,21 @@ bool FIRCLSCompactUnwindDwarfFrame(FIRCLSCompactUnwindContext* context,
   // Everyone's favorite! Dwarf unwinding!
   FIRCLSSDKLogInfo("Trying to read dwarf data with offset %lx\n", dwarfOffset);
 
-  FIRCLSDwarfCFIRecord record;
+  // The compact encoding gives the offset of the FDE directly, so the only work to save is parsing
+  // it and its CIE again when a function shows up in consecutive frames.
+  if (context->lastDwarfOffset == 0 || context->lastDwarfOffset != dwarfOffset) {
+    context->lastDwarfOffset = 0;
 
-  if (!FIRCLSDwarfParseCFIFromFDERecordOffset(&record, context->ehFrame, dwarfOffset)) {
-    FIRCLSSDKLogError("Unable to init FDE\n");
-    return false;
+    if (!FIRCLSDwarfParseCFIFromFDERecordOffset(&context->lastDwarfRecord, context->ehFrame,
+                                                dwarfOffset)) {
+      FIRCLSSDKLogError("Unable to init FDE\n");
+      return false;
+    }
+
+    context->lastDwarfOffset = dwarfOffset;
   }
 
-  if (!FIRCLSDwarfUnwindComputeRegisters(&record, registers)) {
+  if (!FIRCLSDwarfUnwindComputeRegisters(&context->lastDwarfRecord, registers)) {
     FIRCLSSDKLogError("Failed to compute DWARF registers\n");
     return false;
   }
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include "FIRCLSDwarfUnwind.h"
 #include "FIRCLSFeatures.h"
 #include "FIRCLSThreadState.h"
 
@@ -32,6 +33,15 @@
 // Its output is undefined if the input is zero.
 #define GET_BITS_WITH_MASK(value, mask) ((value & mask) >> (mask == 0 ? 0 : __builtin_ctz(mask)))
 
+typedef struct {
+  compact_unwind_encoding_t encoding;
+  uintptr_t functionStart;
+  uintptr_t functionEnd;
+  uintptr_t lsda;
+  uintptr_t personality;
+
+} FIRCLSCompactUnwindResult;
+
 typedef struct {
   const void* unwindInfo;
   const void* ehFrame;
@@ -40,16 +50,19 @@ typedef struct {
   struct unwind_info_section_header unwindHeader;
   struct unwind_info_section_header_index_entry indexHeader;
   uint32_t firstLevelNextFunctionOffset;
-} FIRCLSCompactUnwindContext;
 
-typedef struct {
-  compact_unwind_encoding_t encoding;
-  uintptr_t functionStart;
-  uintptr_t functionEnd;
-  uintptr_t lsda;
-  uintptr_t personality;
+  // Consecutive frames usually fall in the same second-level page, and often in the same function,
+  // so the last lookup results are kept and reused while the pc stays within their ranges.
+  bool hasFirstLevelEntry;
+  bool hasLastResult;
+  FIRCLSCompactUnwindResult lastResult;
 
-} FIRCLSCompactUnwindResult;
+#if CLS_DWARF_UNWINDING_SUPPORTED
+  // The FDE offset and parsed CFI record of the last DWARF frame
+  uintptr_t lastDwarfOffset;
+  FIRCLSDwarfCFIRecord lastDwarfRecord;
+#endif
+} FIRCLSCompactUnwindContext;
 
 bool FIRCLSCompactUnwindInit(FIRCLSCompactUnwindContext* context,
                              const void* unwindInfo,
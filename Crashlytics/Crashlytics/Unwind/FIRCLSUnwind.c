@@ -223,31 +223,42 @@ static bool FIRCLSUnwindWithCompactUnwindInfo(FIRCLSUnwindContext* context) {
     return false;
   }
 
-  // step one - find the image the current pc is within
-  FIRCLSBinaryImageRuntimeNode image;
-
   uintptr_t pc = FIRCLSUnwindGetPC(context);
 
-  if (!FIRCLSBinaryImageSafeFindImageForAddress(pc, &image)) {
-    FIRCLSSDKLogWarn("Unable to find binary for %p\n", (void*)pc);
-    return false;
-  }
+  // Consecutive frames are often in the same image. In that case, the unwind info is already
+  // loaded, along with the results of the previous lookups.
+  if (pc < context->compactUnwindImageStart || pc >= context->compactUnwindImageEnd) {
+    context->compactUnwindImageStart = 0;
+    context->compactUnwindImageEnd = 0;
+
+    // step one - find the image the current pc is within
+    FIRCLSBinaryImageRuntimeNode image;
+
+    if (!FIRCLSBinaryImageSafeFindImageForAddress(pc, &image)) {
+      FIRCLSSDKLogWarn("Unable to find binary for %p\n", (void*)pc);
+      return false;
+    }
 
 #if CLS_BINARY_IMAGE_RUNTIME_NODE_RECORD_NAME
-  FIRCLSSDKLogDebug("Binary image for %p at %p => %s\n", (void*)pc, image.baseAddress, image.name);
+    FIRCLSSDKLogDebug("Binary image for %p at %p => %s\n", (void*)pc, image.baseAddress,
+                      image.name);
 #else
-  FIRCLSSDKLogDebug("Binary image for %p at %p\n", (void*)pc, image.baseAddress);
+    FIRCLSSDKLogDebug("Binary image for %p at %p\n", (void*)pc, image.baseAddress);
 #endif
 
-  if (!FIRCLSBinaryImageSafeHasUnwindInfo(&image)) {
-    FIRCLSSDKLogInfo("Binary image at %p has no unwind info\n", image.baseAddress);
-    return false;
-  }
+    if (!FIRCLSBinaryImageSafeHasUnwindInfo(&image)) {
+      FIRCLSSDKLogInfo("Binary image at %p has no unwind info\n", image.baseAddress);
+      return false;
+    }
 
-  if (!FIRCLSCompactUnwindInit(&context->compactUnwindState, image.unwindInfo, image.ehFrame,
-                               (uintptr_t)image.baseAddress)) {
-    FIRCLSSDKLogError("Unable to read unwind info\n");
-    return false;
+    if (!FIRCLSCompactUnwindInit(&context->compactUnwindState, image.unwindInfo, image.ehFrame,
+                                 (uintptr_t)image.baseAddress)) {
+      FIRCLSSDKLogError("Unable to read unwind info\n");
+      return false;
+    }
+
+    context->compactUnwindImageStart = (uintptr_t)image.baseAddress;
+    context->compactUnwindImageEnd = (uintptr_t)image.baseAddress + image.size;
   }
 
   // this function will actually attempt to find compact unwind info for the current PC,
@@ -33,6 +33,9 @@ typedef struct {
   uint32_t frameCount;
 #if CLS_COMPACT_UNWINDING_SUPPORTED
   FIRCLSCompactUnwindContext compactUnwindState;
+  // The address range of the image that compactUnwindState was initialized for
+  uintptr_t compactUnwindImageStart;
+  uintptr_t compactUnwindImageEnd;
 #endif
   uintptr_t lastFramePC;
   uint32_t repeatCount;
@@ -0,0 +1,109 @@
+// Copyright 2020 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "FIRCLSBinaryImage.h"
+#include "FIRCLSFile.h"
+
+#import <XCTest/XCTest.h>
+
+@interface FIRCLSBinaryImageTests : XCTestCase
+
+@property(nonatomic, strong) NSString *manifestDirectory;
+@property(nonatomic, strong) NSString *binaryImagePath;
+
+@end
+
+@implementation FIRCLSBinaryImageTests
+
+- (void)setUp {
+  [super setUp];
+
+  self.manifestDirectory =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:@"binary_image_manifests"];
+  self.binaryImagePath =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:@"binary_images.clsrecord"];
+
+  [[NSFileManager defaultManager] removeItemAtPath:self.manifestDirectory error:nil];
+  [[NSFileManager defaultManager] createDirectoryAtPath:self.manifestDirectory
+                            withIntermediateDirectories:YES
+                                             attributes:nil
+                                                  error:nil];
+}
+
+- (void)tearDown {
+  [[NSFileManager defaultManager] removeItemAtPath:self.manifestDirectory error:nil];
+  [[NSFileManager defaultManager] removeItemAtPath:self.binaryImagePath error:nil];
+
+  [super tearDown];
+}
+
+- (void)writeLines:(NSArray<NSString *> *)lines toPath:(NSString *)path {
+  NSString *contents = [[lines componentsJoinedByString:@"\n"] stringByAppendingString:@"\n"];
+  XCTAssert([contents writeToFile:path atomically:YES encoding:NSUTF8StringEncoding error:nil]);
+}
+
+- (NSArray *)expandedSections {
+  return FIRCLSFileReadSections([self.binaryImagePath fileSystemRepresentation], false, nil);
+}
+
+- (void)testExpandingFillsInManifestEntries {
+  [self writeLines:@[
+    @"{\"load\":{\"path\":\"/usr/lib/libA.dylib\",\"uuid\":\"aaaa\",\"size\":4096}}",
+    @"{\"load\":{\"path\":\"/usr/lib/libB.dylib\",\"uuid\":\"bbbb\",\"size\":8192}}"
+  ]
+            toPath:[self.manifestDirectory stringByAppendingPathComponent:@"0123.clsrecord"]];
+  [self writeLines:@[
+    @"{\"load\":{\"uuid\":\"aaaa\",\"base\":65536}}",
+    @"{\"load\":{\"uuid\":\"bbbb\",\"base\":131072}}",
+    @"{\"manifest\":{\"hash\":\"0123\"}}",
+    @"{\"load\":{\"path\":\"/usr/lib/libC.dylib\",\"uuid\":\"cccc\",\"base\":262144,\"size\":16}}"
+  ]
+            toPath:self.binaryImagePath];
+
+  XCTAssert(FIRCLSBinaryImageExpandManifestReference(
+      [self.binaryImagePath fileSystemRepresentation],
+      [self.manifestDirectory fileSystemRepresentation]));
+
+  NSArray *sections = [self expandedSections];
+  XCTAssertEqual([sections count], 3u);
+
+  NSDictionary *first = sections[0][@"load"];
+  XCTAssertEqualObjects(first[@"path"], @"/usr/lib/libA.dylib");
+  XCTAssertEqualObjects(first[@"size"], @4096);
+  XCTAssertEqualObjects(first[@"base"], @65536);
+
+  NSDictionary *second = sections[1][@"load"];
+  XCTAssertEqualObjects(second[@"path"], @"/usr/lib/libB.dylib");
+  XCTAssertEqualObjects(second[@"base"], @131072);
+
+  XCTAssertEqualObjects(sections[2][@"load"][@"path"], @"/usr/lib/libC.dylib");
+}
+
+- (void)testExpandingWithoutTheManifestDropsAddressOnlyEntries {
+  [self writeLines:@[
+    @"{\"load\":{\"uuid\":\"aaaa\",\"base\":65536}}", @"{\"manifest\":{\"hash\":\"missing\"}}",
+    @"{\"load\":{\"path\":\"/usr/lib/libC.dylib\",\"uuid\":\"cccc\",\"base\":262144,\"size\":16}}"
+  ]
+            toPath:self.binaryImagePath];
+
+  XCTAssertFalse(FIRCLSBinaryImageExpandManifestReference(
+      [self.binaryImagePath fileSystemRepresentation],
+      [self.manifestDirectory fileSystemRepresentation]));
+
+  NSArray *sections = [self expandedSections];
+  XCTAssertEqual([sections count], 1u);
+  XCTAssertEqualObjects(sections[0][@"load"][@"uuid"], @"cccc");
+}
+
+@end
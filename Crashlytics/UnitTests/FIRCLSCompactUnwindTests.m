@@ -153,6 +153,45 @@
   XCTAssertEqual(result.encoding & UNWIND_X86_64_MODE_MASK, UNWIND_X86_64_MODE_DWARF, @"");
   XCTAssertEqual(result.functionStart, loadAddress + 0x00001558, @"");
 }
+
+- (void)testRepeatedLookupsReuseOnlyMatchingResults {
+  NSString* dylibPath = [self pathForResource:@"10.9.4_libsystem_kernel.dylib"];
+
+  struct FIRCLSMachOFile file;
+
+  XCTAssertTrue(FIRCLSMachOFileInitWithPath(&file, [dylibPath fileSystemRepresentation]), @"");
+
+  struct FIRCLSMachOSlice slice = FIRCLSMachOFileSliceWithArchitectureName(&file, "x86_64");
+
+  const void* compactUnwind = NULL;
+  const void* ehFrame = NULL;
+
+  XCTAssert(FIRCLSMachOSliceGetSectionByName(&slice, SEG_TEXT, "__eh_frame", &ehFrame));
+  XCTAssert(FIRCLSMachOSliceGetSectionByName(&slice, SEG_TEXT, "__unwind_info", &compactUnwind));
+
+  FIRCLSCompactUnwindContext context;
+
+  // hard-code a load address seen during testing
+  uintptr_t loadAddress = 0x7fff94044000;
+  XCTAssertTrue(FIRCLSCompactUnwindInit(&context, compactUnwind, ehFrame, loadAddress), @"");
+
+  FIRCLSCompactUnwindResult result;
+
+  // the same function twice, as in a recursive stack
+  XCTAssertTrue(FIRCLSCompactUnwindLookup(&context, loadAddress + 0x00001520, &result), @"");
+  XCTAssertTrue(FIRCLSCompactUnwindLookup(&context, loadAddress + 0x00001557, &result), @"");
+  XCTAssertEqual(result.functionStart, loadAddress + 0x0000151A, @"");
+  XCTAssertEqual(result.functionEnd, loadAddress + 0x00001558, @"");
+
+  // a function in another second-level page
+  XCTAssertTrue(FIRCLSCompactUnwindLookup(&context, 0x7fff94051e6c, &result), @"");
+  XCTAssertEqual(result.functionStart, loadAddress + 0x0000DCC1, @"");
+
+  // and back, to the function right after the first one
+  XCTAssertTrue(FIRCLSCompactUnwindLookup(&context, loadAddress + 0x00001558, &result), @"");
+  XCTAssertEqual(result.encoding & UNWIND_X86_64_MODE_MASK, UNWIND_X86_64_MODE_DWARF, @"");
+  XCTAssertEqual(result.functionStart, loadAddress + 0x00001558, @"");
+}
 #endif
 
 #if CLS_CPU_X86_64
@@ -67,7 +67,7 @@
   path = [path stringByAppendingPathComponent:@"v5/reports"];
   XCTAssertTrue([self doesFileExist:path], @"");
 
-  for (NSString* subpath in @[ @"active", @"prepared", @"processing" ]) {
+  for (NSString* subpath in @[ @"active", @"prepared", @"processing", @"binary-images" ]) {
     XCTAssertTrue([self doesFileExist:[path stringByAppendingPathComponent:subpath]], @"");
   }
 }
@@ -427,4 +427,61 @@
   free(input);
 }
 
+#pragma mark -
+
+- (void)testBinaryEncodingReadsBackAsSections {
+  NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"binary_file_test"];
+  [[NSFileManager defaultManager] removeItemAtPath:path error:nil];
+
+  FIRCLSFile file;
+  XCTAssert(FIRCLSFileInitBinaryWithPath(&file, [path fileSystemRepresentation], false));
+
+  FIRCLSFileWriteSectionStart(&file, "signal");
+  FIRCLSFileWriteHashStart(&file);
+  FIRCLSFileWriteHashEntryUint64(&file, "address", 0x100001234);
+  FIRCLSFileWriteHashEntryInt64(&file, "offset", -42);
+  FIRCLSFileWriteHashEntryString(&file, "name", "SIGSEGV");
+  FIRCLSFileWriteHashEntryString(&file, "missing", NULL);
+  FIRCLSFileWriteHashEntryHexEncodedString(&file, "reason", "bad access");
+  FIRCLSFileWriteHashEntryBoolean(&file, "fatal", true);
+  FIRCLSFileWriteHashKey(&file, "stacktrace");
+  FIRCLSFileWriteArrayStart(&file);
+  FIRCLSFileWriteArrayEntryUint64(&file, 1);
+  FIRCLSFileWriteArrayEntryUint64(&file, 300);
+  FIRCLSFileWriteArrayEnd(&file);
+  FIRCLSFileWriteHashEnd(&file);
+  FIRCLSFileWriteSectionEnd(&file);
+
+  FIRCLSFileWriteSectionStart(&file, "empty");
+  FIRCLSFileWriteHashStart(&file);
+  FIRCLSFileWriteHashEnd(&file);
+  FIRCLSFileWriteSectionEnd(&file);
+
+  // an interrupted value at the end must not hide the sections before it
+  FIRCLSFileWriteSectionStart(&file, "truncated");
+  FIRCLSFileWriteHashStart(&file);
+  FIRCLSFileClose(&file);
+
+  NSDictionary *expectedSignal = @{
+    @"address" : @(0x100001234),
+    @"offset" : @(-42),
+    @"name" : @"SIGSEGV",
+    @"missing" : [NSNull null],
+    @"reason" : FIRCLSFileHexEncodeString("bad access"),
+    @"fatal" : @YES,
+    @"stacktrace" : @[ @1, @300 ]
+  };
+  NSArray *expected = @[ @{@"signal" : expectedSignal}, @{@"empty" : @{}} ];
+
+  NSArray *sections = FIRCLSFileReadSections([path fileSystemRepresentation], false, nil);
+  XCTAssertEqualObjects(sections, expected);
+
+  XCTAssert(FIRCLSFileConvertBinaryToJSON([path fileSystemRepresentation]));
+  NSString *contents = [self contentsOfFileAtPath:path];
+  XCTAssert([contents hasPrefix:@"{\"signal\":"], @"Converted file should be JSON: %@", contents);
+
+  sections = FIRCLSFileReadSections([path fileSystemRepresentation], false, nil);
+  XCTAssertEqualObjects(sections, expected);
+}
+
 @end
@@ -67,4 +67,32 @@
   XCTAssert(report.needsToBeSubmitted, @"with the B file present, needs to be submitted");
 }
 
+- (void)testCrashHandlerTimings {
+  NSString *name = @"metadata_only_report";
+
+  NSString *tempPath = [NSTemporaryDirectory() stringByAppendingPathComponent:name];
+
+  [[NSFileManager defaultManager] removeItemAtPath:tempPath error:nil];
+  [[NSFileManager defaultManager] copyItemAtPath:[self pathForResource:name]
+                                          toPath:tempPath
+                                           error:nil];
+
+  FIRCLSInternalReport *report = [[FIRCLSInternalReport alloc] initWithPath:tempPath];
+
+  XCTAssertNil(report.crashHandlerTimings, @"a report without a crash has no handler timings");
+
+  NSString *signalPath = [report pathForContentFile:FIRCLSReportSignalFile];
+  NSString *contents = @"{\"signal\":{\"number\":11,\"time\":1}}\n"
+                       @"{\"handler_timings\":{\"threads_us\":250,\"total_us\":400}}\n";
+
+  [[NSFileManager defaultManager] createFileAtPath:signalPath
+                                          contents:[contents dataUsingEncoding:NSUTF8StringEncoding]
+                                        attributes:nil];
+
+  NSDictionary *timings = report.crashHandlerTimings;
+
+  XCTAssertEqualObjects(timings[@"threads_us"], @250);
+  XCTAssertEqualObjects(timings[@"total_us"], @400);
+}
+
 @end
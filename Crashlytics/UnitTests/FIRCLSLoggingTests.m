@@ -165,6 +165,20 @@
   XCTAssertEqualObjects(keyValues[0][@"value"], @"736f6d6520737472696e672076616c7565", @"");
 }
 
+- (void)testKeyValueBatch {
+  FIRCLSUserLoggingRecordUserKeyValue(@"removed", @"value");
+  FIRCLSUserLoggingRecordUserKeysAndValues(
+      @{@"mykey" : @"some string value", @"number" : @42, @"removed" : [NSNull null]});
+
+  XCTAssertEqual([[self incrementalKeyValues] count], 4, @"");
+  XCTAssertEqual(_firclsContext.writable->logging.userKVCount, 4, @"");
+
+  NSDictionary* keyValues =
+      FIRCLSUserLoggingGetCompactedKVEntries(&_firclsContext.readonly->logging.userKVStorage, true);
+  NSDictionary* expected = @{@"mykey" : @"some string value", @"number" : @"42"};
+  XCTAssertEqualObjects(keyValues, expected, @"");
+}
+
 - (void)testKeyValueLogSingleKeyCompaction {
   for (NSUInteger i = 0; i < FIRCLSUserLoggingMaxKVEntries; ++i) {
     FIRCLSUserLoggingRecordUserKeyValue(
@@ -280,6 +294,31 @@
                         @"");  // "some value 1905"
 }
 
+- (void)testUserLogRingBuffer {
+  FIRCLSMappedRingBuffer* ringBuffer = &_firclsContext.writable->logging.logRingBuffer;
+  XCTAssert(FIRCLSMappedRingBufferOpen(ringBuffer, [self.logAPath fileSystemRepresentation],
+                                       4 * 1024));
+  _firclsContext.readonly->logging.logStorage.ringBuffer = ringBuffer;
+
+  for (int i = 0; i < 1000; ++i) {
+    FIRCLSLog(@"some value %d", i);
+  }
+
+  NSArray* logA = [self logAContents];
+
+  // the oldest entries have been dropped, and the rest are whole and in order
+  XCTAssert([logA count] > 10 && [logA count] < 1000, @"%lu entries", (unsigned long)logA.count);
+  XCTAssertEqualObjects([logA lastObject][@"log"][@"msg"], @"736f6d652076616c756520393939",
+                        @"");  // "some value 999"
+  XCTAssertEqual([[self logBContents] count], 0, @"");
+
+  XCTAssert(FIRCLSFileConvertBinaryToJSON([self.logAPath fileSystemRepresentation]));
+  FIRCLSMappedRingBufferClose(ringBuffer);
+  _firclsContext.readonly->logging.logStorage.ringBuffer = NULL;
+
+  XCTAssertEqualObjects([self logAContents], logA, @"");
+}
+
 - (void)testLoggedError {
   NSError* error = [NSError errorWithDomain:@"My Custom Domain"
                                        code:-1
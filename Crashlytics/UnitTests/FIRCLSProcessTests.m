@@ -0,0 +1,78 @@
+// Copyright 2020 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "FIRCLSProcess.h"
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+
+#include <pthread.h>
+
+@interface FIRCLSProcessTests : XCTestCase
+@end
+
+@implementation FIRCLSProcessTests {
+  dispatch_semaphore_t _finish;
+}
+
+- (void)setUp {
+  [super setUp];
+  _finish = dispatch_semaphore_create(0);
+}
+
+- (void)tearDown {
+  // let the blocked thread finish
+  dispatch_semaphore_signal(_finish);
+  [super tearDown];
+}
+
+// Returns a thread that stays blocked until the test ends.
+- (thread_t)startBlockedThread {
+  dispatch_semaphore_t started = dispatch_semaphore_create(0);
+  dispatch_semaphore_t finish = _finish;
+  __block thread_t thread = MACH_PORT_NULL;
+
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    thread = pthread_mach_thread_np(pthread_self());
+    dispatch_semaphore_signal(started);
+    dispatch_semaphore_wait(finish, DISPATCH_TIME_FOREVER);
+  });
+  dispatch_semaphore_wait(started, DISPATCH_TIME_FOREVER);
+
+  return thread;
+}
+
+- (void)testSampleBlockedThread {
+  thread_t thread = [self startBlockedThread];
+
+  uintptr_t frames[64];
+  uint32_t frameCount = 0;
+  XCTAssertTrue(FIRCLSProcessSampleThread(thread, frames, 64, &frameCount));
+  XCTAssertGreaterThan(frameCount, 0u);
+
+  // the thread is resumed, so it can be sampled again
+  XCTAssertTrue(FIRCLSProcessSampleThread(thread, frames, 64, &frameCount));
+}
+
+- (void)testSampleStopsAtMaxFrames {
+  thread_t thread = [self startBlockedThread];
+
+  uintptr_t frames[2];
+  uint32_t frameCount = 0;
+  XCTAssertTrue(FIRCLSProcessSampleThread(thread, frames, 2, &frameCount));
+  XCTAssertEqual(frameCount, 2u);
+}
+
+@end
@@ -130,18 +130,22 @@
 
 #pragma mark - Report Helpers
 - (FIRCLSInternalReport *)createActiveReport {
-  NSString *reportPath =
-      [self.fileManager.activePath stringByAppendingPathComponent:@"my_session_id"];
+  return [self createActiveReportWithIdentifier:@"my_session_id"];
+}
+
+- (FIRCLSInternalReport *)createActiveReportWithIdentifier:(NSString *)identifier {
+  NSString *reportPath = [self.fileManager.activePath stringByAppendingPathComponent:identifier];
   FIRCLSInternalReport *report = [[FIRCLSInternalReport alloc] initWithPath:reportPath
-                                                        executionIdentifier:@"my_session_id"];
+                                                        executionIdentifier:identifier];
 
   if (![self.fileManager createDirectoryAtPath:report.path]) {
     return nil;
   }
 
-  if (![self createMetadata:
-                 @"{\"identity\":{\"api_key\":\"my_key\",\"session_id\":\"my_session_id\"}}\n"
-                  forReport:report]) {
+  NSString *metadata = [NSString
+      stringWithFormat:@"{\"identity\":{\"api_key\":\"my_key\",\"session_id\":\"%@\"}}\n",
+                       identifier];
+  if (![self createMetadata:metadata forReport:report]) {
     return nil;
   }
 
@@ -307,6 +311,36 @@
   XCTAssertEqualObjects(self.prepareAndSubmitReportArray[0][@"urgent"], @(NO));
 }
 
+- (void)testExistingReportsAreSubmittedNewestCrashFirst {
+  NSArray *reports = @[
+    @[ @"older_crash", FIRCLSReportSignalFile, @(-100) ],
+    @[ @"newer_error", FIRCLSReportErrorAFile, @(-1) ],
+    @[ @"newest_crash", FIRCLSReportSignalFile, @(-10) ],
+  ];
+
+  for (NSArray *entry in reports) {
+    FIRCLSInternalReport *report = [self createActiveReportWithIdentifier:entry[0]];
+    XCTAssertTrue([self createFileWithContents:@"contents"
+                                        atPath:[report pathForContentFile:entry[1]]]);
+
+    NSDate *date = [NSDate dateWithTimeIntervalSinceNow:[entry[2] doubleValue]];
+    XCTAssertTrue([self.fileManager.underlyingFileManager
+        setAttributes:@{NSFileModificationDate : date}
+         ofItemAtPath:report.path
+                error:nil]);
+  }
+
+  [self startReportManager];
+
+  XCTAssertEqual([self.prepareAndSubmitReportArray count], 3);
+
+  NSArray *order = @[ @"newest_crash", @"older_crash", @"newer_error" ];
+  for (NSUInteger i = 0; i < order.count; ++i) {
+    FIRCLSInternalReport *report = self.prepareAndSubmitReportArray[i][@"report"];
+    XCTAssertEqualObjects(report.path.lastPathComponent, order[i]);
+  }
+}
+
 - (void)testExistingReportOnStartWithDataCollectionDisabledThenEnabled {
   // create a report and put it in place
   FIRCLSInternalReport *report = [self createActiveReport];
@@ -62,4 +62,17 @@
   XCTAssert([resolver loadBinaryImagesFromFile:binaryImagePath]);
 }
 
+- (void)testAddressOutsideLoadedImages {
+  FIRCLSSymbolResolver* resolver = [[FIRCLSSymbolResolver alloc] init];
+
+  NSString* binaryImagePath = [self pathForResource:@"binary_images_missing_base_entry.clsrecord"];
+
+  XCTAssert([resolver loadBinaryImagesFromFile:binaryImagePath]);
+
+  // below every image, and repeated, to go through the cached paths too
+  XCTAssertNil([resolver frameForAddress:1]);
+  XCTAssertNil([resolver frameForAddress:1]);
+  XCTAssertNil([resolver frameForAddress:UINT64_MAX]);
+}
+
 @end
@@ -156,6 +156,12 @@
   self.trackedQueries[@(query.queryId)] = query;
 }
 
+- (void)saveTrackedQueries:(NSArray *)queries {
+  for (FTrackedQuery *query in queries) {
+    [self saveTrackedQuery:query];
+  }
+}
+
 - (void)setTrackedQueryKeys:(NSSet *)keys forQueryId:(NSUInteger)queryId {
   self.trackedQueryKeys[@(queryId)] = keys;
 }
@@ -481,4 +481,40 @@
   }];
 }
 
+- (void)testFromSortedKeysBuildsArrayAndTreeDictionaries {
+  for (NSUInteger n = 0; n < SORTED_DICTIONARY_ARRAY_TO_RB_TREE_SIZE_THRESHOLD * 4; n++) {
+    NSMutableArray *keys = [NSMutableArray arrayWithCapacity:n];
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:n];
+    for (NSUInteger i = 0; i < n; i++) {
+      [keys addObject:@(i)];
+      [values addObject:@(i * 2)];
+    }
+
+    FImmutableSortedDictionary *dict =
+        [FImmutableSortedDictionary fromSortedKeys:keys
+                                            values:values
+                                    withComparator:[self defaultComparator]];
+    if (n <= SORTED_DICTIONARY_ARRAY_TO_RB_TREE_SIZE_THRESHOLD) {
+      XCTAssertTrue([dict isKindOfClass:[FArraySortedDictionary class]]);
+    } else {
+      XCTAssertTrue([dict isKindOfClass:[FTreeSortedDictionary class]]);
+    }
+    XCTAssertEqual(dict.count, (int)n);
+
+    __block NSUInteger next = 0;
+    [dict enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
+      XCTAssertEqualObjects(key, @(next));
+      XCTAssertEqualObjects(value, @(next * 2));
+      next = next + 1;
+    }];
+    XCTAssertEqual(next, n);
+  }
+}
+
+- (void)testFromSortedKeysRejectsUnsortedKeys {
+  XCTAssertThrows([FImmutableSortedDictionary fromSortedKeys:@[ @2, @1 ]
+                                                      values:@[ @2, @1 ]
+                                              withComparator:[self defaultComparator]]);
+}
+
 @end
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+#import <XCTest/XCTest.h>
+
+#import "FChildEventRegistration.h"
+#import "FDataEvent.h"
+#import "FEventRaiser.h"
+#import "FValueEventRegistration.h"
+
+@interface FEventRaiserTest : XCTestCase
+
+@end
+
+@implementation FEventRaiserTest
+
+- (FDataEvent *)valueEventFor:(id<FEventRegistration>)registration {
+  return [[FDataEvent alloc] initWithEventType:FIRDataEventTypeValue
+                             eventRegistration:registration
+                                  dataSnapshot:nil];
+}
+
+- (FDataEvent *)childAddedEventFor:(id<FEventRegistration>)registration {
+  return [[FDataEvent alloc] initWithEventType:FIRDataEventTypeChildAdded
+                             eventRegistration:registration
+                                  dataSnapshot:nil];
+}
+
+- (void)testEventsAreRaisedInOrder {
+  dispatch_queue_t queue = dispatch_queue_create("FEventRaiserTest", DISPATCH_QUEUE_SERIAL);
+  FEventRaiser *raiser = [[FEventRaiser alloc] initWithQueue:queue];
+  NSMutableArray *raised = [NSMutableArray array];
+
+  FValueEventRegistration *value =
+      [[FValueEventRegistration alloc] initWithRepo:nil
+                                             handle:1
+                                           callback:^(FIRDataSnapshot *snapshot) {
+                                             [raised addObject:@"value"];
+                                           }
+                                     cancelCallback:nil];
+  NSDictionary *callbacks = @{
+    @(FIRDataEventTypeChildAdded) : ^(FIRDataSnapshot *snapshot, NSString *prevName) {
+      [raised addObject:@"child"];
+    }
+  };
+  FChildEventRegistration *child = [[FChildEventRegistration alloc] initWithRepo:nil
+                                                                          handle:2
+                                                                       callbacks:callbacks
+                                                                  cancelCallback:nil];
+
+  [raiser raiseEvents:@[
+    [self childAddedEventFor:child], [self childAddedEventFor:child], [self valueEventFor:value]
+  ]];
+  [raiser raiseEvents:@[ [self valueEventFor:value] ]];
+  dispatch_sync(queue, ^{
+  });
+
+  XCTAssertEqualObjects(raised, (@[ @"child", @"child", @"value", @"value" ]));
+}
+
+- (void)testCoalescedValueEventsOnlyRaiseTheLatest {
+  dispatch_queue_t queue = dispatch_queue_create("FEventRaiserTest", DISPATCH_QUEUE_SERIAL);
+  FEventRaiser *raiser = [[FEventRaiser alloc] initWithQueue:queue];
+  raiser.coalescesValueEvents = YES;
+  __block NSUInteger raised = 0;
+  FValueEventRegistration *value =
+      [[FValueEventRegistration alloc] initWithRepo:nil
+                                             handle:1
+                                           callback:^(FIRDataSnapshot *snapshot) {
+                                             raised++;
+                                           }
+                                     cancelCallback:nil];
+
+  dispatch_suspend(queue);
+  [raiser raiseEvents:@[ [self valueEventFor:value] ]];
+  [raiser raiseEvents:@[ [self valueEventFor:value] ]];
+  [raiser raiseEvents:@[ [self valueEventFor:value] ]];
+  dispatch_resume(queue);
+  dispatch_sync(queue, ^{
+  });
+  XCTAssertEqual(raised, 1);
+
+  [raiser raiseEvents:@[ [self valueEventFor:value] ]];
+  dispatch_sync(queue, ^{
+  });
+  XCTAssertEqual(raised, 2);
+}
+
+@end
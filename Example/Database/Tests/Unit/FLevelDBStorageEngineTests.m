@@ -16,9 +16,11 @@
 
 #import <XCTest/XCTest.h>
 
+#import "APLevelDB.h"
 #import "FEmptyNode.h"
 #import "FLevelDBStorageEngine.h"
 #import "FPathIndex.h"
+#import "FPruneForest.h"
 #import "FQueryParams.h"
 #import "FSnapshotUtilities.h"
 #import "FTestHelpers.h"
@@ -472,24 +474,73 @@
 // Well this is awkward, but NSJSONSerialization fails to deserialize JSON with tiny/huge doubles
 // It is kind of bad we raise "invalid" data, but at least we don't crash *trollface*
 - (void)testExtremeDoublesAsServerCache {
-#ifdef TARGET_OS_IOS
-  if ([[NSProcessInfo processInfo] operatingSystemVersion].majorVersion >= 11) {
-    // NSJSONSerialization on iOS 11 correctly serializes small and large doubles.
-    return;
-  }
-#endif
-#if TARGET_OS_MACCATALYST
-  return;
-#endif
+  FLevelDBStorageEngine *engine = [self cleanStorageEngine];
+  id<FNode> expectedData = NODE((@{@"works" : @"value", @"tiny" : @(2.225073858507201e-308)}));
+  [engine updateServerCache:expectedData atPath:PATH(@"foo") merge:NO];
+
+  // Leaves are stored as binary, so doubles that JSON can't parse back are kept
+  XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], expectedData);
+}
+
+- (void)testServerCacheWrittenAsJSONIsMigrated {
+  NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db-migration"];
+  NSString *basePath = [[FLevelDBStorageEngine firebaseDir] stringByAppendingPathComponent:path];
+  NSString *versionPath = [basePath stringByAppendingPathComponent:@"version"];
+
+  FLevelDBStorageEngine *engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+  [engine purgeEverything];
+  [engine close];
+
+  // Write leaves the way version 1 of the database did
+  APLevelDB *db = [APLevelDB levelDBWithPath:[basePath stringByAppendingPathComponent:@"server_data"]
+                                       error:nil];
+  NSDictionary *leaves = @{
+    @"/server_cache/foo/string/" : @"\"value\"",
+    @"/server_cache/foo/double/" : @"2.47",
+    @"/server_cache/foo/long/" : @"1542405709418655810",
+    @"/server_cache/foo/bool/" : @"true",
+  };
+  [leaves enumerateKeysAndObjectsUsingBlock:^(NSString *key, NSString *value, BOOL *stop) {
+    [db setData:[value dataUsingEncoding:NSUTF8StringEncoding] forKey:key];
+  }];
+  [db close];
+  XCTAssertTrue([@"1" writeToFile:versionPath
+                       atomically:NO
+                         encoding:NSUTF8StringEncoding
+                            error:nil]);
 
+  engine = [[FLevelDBStorageEngine alloc] initWithPath:path];
+  id<FNode> expectedData = NODE((
+      @{@"string" : @"value", @"double" : @2.47, @"long" : @1542405709418655810, @"bool" : @YES}));
+  XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], expectedData);
+  XCTAssertEqualObjects([NSString stringWithContentsOfFile:versionPath
+                                                  encoding:NSUTF8StringEncoding
+                                                     error:nil],
+                        @"2");
+  [engine close];
+}
+
+- (void)testServerCacheSizeIsKeptUpToDate {
   FLevelDBStorageEngine *engine = [self cleanStorageEngine];
-  [engine updateServerCache:NODE((@{@"works" : @"value", @"fails" : @(2.225073858507201e-308)}))
-                     atPath:PATH(@"foo")
-                      merge:NO];
+  [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"foo") merge:NO];
+  // Measures the size, which is then kept up to date by later writes
+  XCTAssertGreaterThan([engine serverCacheEstimatedSizeInBytes], 0);
+
+  [engine updateServerCache:SAMPLE_NODE atPath:PATH(@"bar") merge:NO];
+  [engine updateServerCache:NODE(@"later-bar") atPath:PATH(@"foo/foo/bar") merge:NO];
+  [engine updateServerCache:NODE(@"deeper") atPath:PATH(@"foo/qux/deeper") merge:NO];
+  NSDictionary *mergeData = @{@"baz" : @"baz-value", @"quu" : @{@"a" : @1}};
+  [engine updateServerCacheWithMerge:[FCompoundWrite compoundWriteWithValueDictionary:mergeData]
+                              atPath:PATH(@"bar")];
+  FPruneForest *prune = [[FPruneForest empty] prunePath:PATH(@"foo")];
+  [engine pruneCache:[prune keepPath:PATH(@"foo/qux")] atPath:PATH(@"")];
+  NSUInteger trackedSize = [engine serverCacheEstimatedSizeInBytes];
+  [engine close];
 
-  // Will drop the tiny double
-  XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo")], NODE(@{@"works" : @"value"}));
-  XCTAssertEqualObjects([engine serverCacheAtPath:PATH(@"foo/fails")], [FEmptyNode emptyNode]);
+  NSString *path = [NSTemporaryDirectory() stringByAppendingPathComponent:@"test-db"];
+  FLevelDBStorageEngine *reopened = [[FLevelDBStorageEngine alloc] initWithPath:path];
+  XCTAssertEqual(trackedSize, [reopened serverCacheEstimatedSizeInBytes]);
+  [reopened close];
 }
 
 - (void)testLongValuesDontLosePrecision {
@@ -351,6 +351,32 @@
   XCTAssertTrue([manager hasActiveDefaultQueryAtPath:PATH(@"bar/baz")]);
 }
 
+- (void)testChangesToExistingQueriesAreSavedTogether {
+  FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
+  FTestClock *clock = [[FTestClock alloc] init];
+  FTrackedQueryManager *manager =
+      [[FTrackedQueryManager alloc] initWithStorageEngine:engine clock:clock];
+
+  // New queries are saved right away
+  [manager setQueryActive:SAMPLE_QUERY];
+  FTrackedQuery *saved = [engine loadTrackedQueries].firstObject;
+  XCTAssertTrue(saved.isActive);
+
+  [clock tick];
+  [manager setQueryInactive:SAMPLE_QUERY];
+  [manager setQueryComplete:SAMPLE_QUERY];
+  saved = [engine loadTrackedQueries].firstObject;
+  XCTAssertTrue(saved.isActive);
+  XCTAssertFalse(saved.isComplete);
+
+  [manager flush];
+  saved = [engine loadTrackedQueries].firstObject;
+  XCTAssertFalse(saved.isActive);
+  XCTAssertTrue(saved.isComplete);
+  XCTAssertEqual(saved.lastUse, clock.currentTime);
+  [manager verifyCache];
+}
+
 - (void)testCacheSanity {
   FMockStorageEngine *engine = [[FMockStorageEngine alloc] init];
   FTrackedQueryManager *manager = [self newManagerWithStorageEngine:engine];
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "FEmptyNode.h"
+#import "FNode.h"
+#import "FPath.h"
+#import "FSnapshotUtilities.h"
+#import "FWriteTree.h"
+
+@interface FWriteTreeTest : XCTestCase
+
+@end
+
+@implementation FWriteTreeTest
+
+- (id<FNode>)hiddenCacheOf:(FWriteTree *)writeTree atPath:(NSString *)path {
+  return [writeTree calculateCompleteEventCacheAtPath:[FPath pathWithString:path]
+                                  completeServerCache:[FEmptyNode emptyNode]
+                                      excludeWriteIds:nil
+                                  includeHiddenWrites:YES];
+}
+
+- (void)testHiddenEventCacheFollowsWrites {
+  FWriteTree *writeTree = [[FWriteTree alloc] init];
+  [writeTree addOverwriteAtPath:[FPath pathWithString:@"a/b"]
+                        newData:[FSnapshotUtilities nodeFrom:@"first"]
+                        writeId:1
+                      isVisible:NO];
+  XCTAssertEqualObjects([[self hiddenCacheOf:writeTree atPath:@"a"] val], @{@"b" : @"first"});
+
+  [writeTree addOverwriteAtPath:[FPath pathWithString:@"a/c"]
+                        newData:[FSnapshotUtilities nodeFrom:@"second"]
+                        writeId:2
+                      isVisible:NO];
+  XCTAssertEqualObjects([[self hiddenCacheOf:writeTree atPath:@"a"] val],
+                        (@{@"b" : @"first", @"c" : @"second"}));
+
+  [writeTree removeWriteId:1];
+  XCTAssertEqualObjects([[self hiddenCacheOf:writeTree atPath:@"a"] val], @{@"c" : @"second"});
+
+  [writeTree removeAllWrites];
+  XCTAssertTrue([[self hiddenCacheOf:writeTree atPath:@"a"] isEmpty]);
+}
+
+- (void)testExcludedWritesAreCachedSeparately {
+  FWriteTree *writeTree = [[FWriteTree alloc] init];
+  [writeTree addOverwriteAtPath:[FPath pathWithString:@"a"]
+                        newData:[FSnapshotUtilities nodeFrom:@"value"]
+                        writeId:1
+                      isVisible:YES];
+  FPath *path = [FPath pathWithString:@"a"];
+
+  id<FNode> excluded = [writeTree calculateCompleteEventCacheAtPath:path
+                                                completeServerCache:[FEmptyNode emptyNode]
+                                                    excludeWriteIds:@[ @1 ]
+                                                includeHiddenWrites:NO];
+  id<FNode> included = [writeTree calculateCompleteEventCacheAtPath:path
+                                                completeServerCache:[FEmptyNode emptyNode]
+                                                    excludeWriteIds:@[ @2 ]
+                                                includeHiddenWrites:NO];
+  XCTAssertTrue([excluded isEmpty]);
+  XCTAssertEqualObjects([included val], @"value");
+}
+
+@end
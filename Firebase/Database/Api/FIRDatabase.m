@@ -213,6 +213,15 @@ static const char *FIREBASE_SEMVER = (const char *)STR(FIRDatabase_VERSION);
     return self->_config.callbackQueue;
 }
 
+- (void)setCoalescesValueEvents:(BOOL)coalescesValueEvents {
+    [self assertUnfrozen:@"setCoalescesValueEvents"];
+    self->_config.coalescesValueEvents = coalescesValueEvents;
+}
+
+- (BOOL)coalescesValueEvents {
+    return self->_config.coalescesValueEvents;
+}
+
 - (void)assertUnfrozen:(NSString *)methodName {
     if (self.repo != nil) {
         [NSException
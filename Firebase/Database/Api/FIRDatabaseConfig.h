@@ -65,6 +65,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, strong) dispatch_queue_t callbackQueue;
 
+/**
+ * When YES, a value listener is only called with the latest of the value
+ * events that are waiting on the callback queue. Defaults to NO.
+ */
+@property(nonatomic) BOOL coalescesValueEvents;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -85,6 +85,11 @@
     self->_callbackQueue = callbackQueue;
 }
 
+- (void)setCoalescesValueEvents:(BOOL)coalescesValueEvents {
+    [self assertUnfrozen];
+    self->_coalescesValueEvents = coalescesValueEvents;
+}
+
 - (void)freeze {
     self->_isFrozen = YES;
 }
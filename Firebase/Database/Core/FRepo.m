@@ -99,6 +99,8 @@
         // Needs to be called before authentication manager is instantiated
         self.eventRaiser =
             [[FEventRaiser alloc] initWithQueue:self.config.callbackQueue];
+        self.eventRaiser.coalescesValueEvents =
+            self.config.coalescesValueEvents;
 
         dispatch_async([FIRDatabaseQuery sharedQueue], ^{
           [self deferredInit];
@@ -752,6 +754,7 @@
 
     NSDate *start = [NSDate date];
     dispatch_async([FIRDatabaseQuery sharedQueue], ^{
+      [self.persistenceManager flushTrackedQueries];
       NSTimeInterval finishTime = [start timeIntervalSinceNow] * -1;
       FFLog(@"I-RDB038018", @"Background task completed.  Queue time: %f",
             finishTime);
@@ -58,6 +58,13 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
 @property(nonatomic, strong) FView *view;
 @property(nonatomic, copy) fbt_nsarray_nsstring onComplete;
 
+// The hash of the server cache the last time one was computed. Nodes are
+// immutable, so it stays valid until the view's server cache changes, and
+// re-listens that happen without new server data don't walk the whole cache.
+@property(nonatomic, strong) id<FNode> hashedServerCache;
+@property(nonatomic, strong) FCompoundHash *cachedCompoundHash;
+@property(nonatomic) NSUInteger cachedEstimatedSize;
+
 @end
 
 @implementation FListenContainer
@@ -76,8 +83,23 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
     return self.view.serverCache;
 }
 
+- (void)updateHashedServerCache {
+    id<FNode> serverCache = [self serverCache];
+    if (serverCache != self.hashedServerCache) {
+        self.hashedServerCache = serverCache;
+        self.cachedCompoundHash = nil;
+        self.cachedEstimatedSize =
+            [FSnapshotUtilities estimateSerializedNodeSize:serverCache];
+    }
+}
+
 - (FCompoundHash *)compoundHash {
-    return [FCompoundHash fromNode:[self serverCache]];
+    [self updateHashedServerCache];
+    if (self.cachedCompoundHash == nil) {
+        self.cachedCompoundHash =
+            [FCompoundHash fromNode:self.hashedServerCache];
+    }
+    return self.cachedCompoundHash;
 }
 
 - (NSString *)simpleHash {
@@ -85,8 +107,8 @@ static const NSUInteger kFSizeThresholdForCompoundHash = 1024;
 }
 
 - (BOOL)includeCompoundHash {
-    return [FSnapshotUtilities estimateSerializedNodeSize:[self serverCache]] >
-           kFSizeThresholdForCompoundHash;
+    [self updateHashedServerCache];
+    return self.cachedEstimatedSize > kFSizeThresholdForCompoundHash;
 }
 
 @end
@@ -42,8 +42,19 @@
  */
 @property(nonatomic, strong) NSMutableArray *allWrites;
 @property(nonatomic) NSInteger lastWriteId;
+/**
+ * Merges of the writes relevant to a path, for event cache calculations that
+ * exclude some writes or include hidden ones and so can't use visibleWrites.
+ * Keyed by the path and the write filter. An entry is dropped as soon as a
+ * write overlapping its path is added or removed, so transactions rerunning
+ * against the same path don't walk every pending write each time.
+ */
+@property(nonatomic, strong) NSMutableDictionary *layeredWritesCache;
 @end
 
+// The number of layered merges kept before the cache is cleared.
+static const NSUInteger kFLayeredWritesCacheLimit = 64;
+
 /**
  * FWriteTree tracks all pending user-initiated writes and has methods to
  * calcuate the result of merging them with underlying server data (to create
@@ -61,6 +72,7 @@
         self.visibleWrites = [FCompoundWrite emptyWrite];
         self.allWrites = [[NSMutableArray alloc] init];
         self.lastWriteId = -1;
+        self.layeredWritesCache = [[NSMutableDictionary alloc] init];
     }
     return self;
 }
@@ -89,6 +101,7 @@
                                                       writeId:writeId
                                                       visible:visible];
     [self.allWrites addObject:record];
+    [self invalidateLayeredWritesAtPath:path];
 
     if (visible) {
         self.visibleWrites = [self.visibleWrites addWrite:newData atPath:path];
@@ -110,6 +123,7 @@
                                                         merge:changedChildren
                                                       writeId:writeId];
     [self.allWrites addObject:record];
+    [self invalidateLayeredWritesAtPath:path];
 
     self.visibleWrites = [self.visibleWrites addCompoundWrite:changedChildren
                                                        atPath:path];
@@ -148,6 +162,7 @@
              @"[FWriteTree removeWriteId:] called with nonexistent writeId.");
     FWriteRecord *writeToRemove = self.allWrites[index];
     [self.allWrites removeObjectAtIndex:index];
+    [self invalidateLayeredWritesAtPath:writeToRemove.path];
 
     BOOL removedWriteWasVisible = writeToRemove.visible;
     BOOL removedWriteOverlapsWithOtherWrites = NO;
@@ -198,6 +213,7 @@
     NSArray *writes = self.allWrites;
     self.visibleWrites = [FCompoundWrite emptyWrite];
     self.allWrites = [NSMutableArray array];
+    [self.layeredWritesCache removeAllObjects];
     return writes;
 }
 
@@ -255,20 +271,10 @@
                 ![merge hasCompleteWriteAtPath:[FPath empty]]) {
                 return nil;
             } else {
-                BOOL (^filter)(FWriteRecord *) = ^(FWriteRecord *record) {
-                  return (BOOL)(
-                      (record.visible || includeHiddenWrites) &&
-                      (writeIdsToExclude == nil ||
-                       ![writeIdsToExclude
-                           containsObject:
-                               [NSNumber numberWithInteger:record.writeId]]) &&
-                      ([record.path contains:treePath] ||
-                       [treePath contains:record.path]));
-                };
                 FCompoundWrite *mergeAtPath =
-                    [FWriteTree layerTreeFromWrites:self.allWrites
-                                             filter:filter
-                                           treeRoot:treePath];
+                    [self layeredWritesAtPath:treePath
+                              excludeWriteIds:writeIdsToExclude
+                          includeHiddenWrites:includeHiddenWrites];
                 id<FNode> layeredCache = completeServerCache
                                              ? completeServerCache
                                              : [FEmptyNode emptyNode];
@@ -473,6 +479,56 @@
     }
 }
 
+/**
+ * Returns the merge of the writes that overlap the given path, filtered as
+ * requested, from the cache if it is still valid.
+ */
+- (FCompoundWrite *)layeredWritesAtPath:(FPath *)treePath
+                        excludeWriteIds:(NSArray *)writeIdsToExclude
+                    includeHiddenWrites:(BOOL)includeHiddenWrites {
+    NSArray *key = @[
+        treePath, writeIdsToExclude ?: [NSNull null], @(includeHiddenWrites)
+    ];
+    FCompoundWrite *cached = self.layeredWritesCache[key];
+    if (cached != nil) {
+        return cached;
+    }
+
+    BOOL (^filter)(FWriteRecord *) = ^(FWriteRecord *record) {
+      return (BOOL)(
+          (record.visible || includeHiddenWrites) &&
+          (writeIdsToExclude == nil ||
+           ![writeIdsToExclude
+               containsObject:[NSNumber numberWithInteger:record.writeId]]) &&
+          ([record.path contains:treePath] || [treePath contains:record.path]));
+    };
+    FCompoundWrite *merge = [FWriteTree layerTreeFromWrites:self.allWrites
+                                                     filter:filter
+                                                   treeRoot:treePath];
+    if (self.layeredWritesCache.count >= kFLayeredWritesCacheLimit) {
+        [self.layeredWritesCache removeAllObjects];
+    }
+    self.layeredWritesCache[key] = merge;
+    return merge;
+}
+
+/**
+ * Drops the cached merges that a write at the given path could change.
+ */
+- (void)invalidateLayeredWritesAtPath:(FPath *)path {
+    if (self.layeredWritesCache.count == 0) {
+        return;
+    }
+    NSMutableArray *staleKeys = [NSMutableArray array];
+    for (NSArray *key in self.layeredWritesCache) {
+        FPath *cachedPath = key[0];
+        if ([cachedPath contains:path] || [path contains:cachedPath]) {
+            [staleKeys addObject:key];
+        }
+    }
+    [self.layeredWritesCache removeObjectsForKeys:staleKeys];
+}
+
 /**
  * Re-layer the writes and merges into a tree so we can efficiently calculate
  * event snapshots
@@ -42,8 +42,8 @@
     return self;
 }
 
-- (void)fireEventOnQueue:(dispatch_queue_t)queue {
-    [self.eventRegistration fireEvent:self queue:queue];
+- (void)fireEvent {
+    [self.eventRegistration fireEvent:self];
 }
 
 - (BOOL)isCancelEvent {
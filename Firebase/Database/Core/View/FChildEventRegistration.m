@@ -68,16 +68,14 @@
     return eventData;
 }
 
-- (void)fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue {
+- (void)fireEvent:(id<FEvent>)event {
     if ([event isCancelEvent]) {
         FCancelEvent *cancelEvent = event;
         FFLog(@"I-RDB061001", @"Raising cancel value event on %@", event.path);
         NSAssert(
             self.cancelCallback != nil,
             @"Raising a cancel event on a listener with no cancel callback");
-        dispatch_async(queue, ^{
-          self.cancelCallback(cancelEvent.error);
-        });
+        self.cancelCallback(cancelEvent.error);
     } else if (self.callbacks != nil) {
         FDataEvent *dataEvent = event;
         FFLog(@"I-RDB061002", @"Raising event callback (%ld) on %@",
@@ -86,9 +84,7 @@
             objectForKey:[NSNumber numberWithInteger:dataEvent.eventType]];
 
         if (callback != nil) {
-            dispatch_async(queue, ^{
-              callback(dataEvent.snapshot, dataEvent.prevName);
-            });
+            callback(dataEvent.snapshot, dataEvent.prevName);
         }
     }
 }
@@ -21,7 +21,7 @@
 
 @protocol FEvent <NSObject>
 - (FPath *)path;
-- (void)fireEventOnQueue:(dispatch_queue_t)queue;
+- (void)fireEvent;
 - (BOOL)isCancelEvent;
 - (NSString *)description;
 @end
@@ -29,6 +29,12 @@
 
 - (id)initWithQueue:(dispatch_queue_t)queue;
 
+/**
+ * When YES, a value event is skipped if a later value event for the same
+ * registration has been raised before it's delivered.
+ */
+@property(nonatomic) BOOL coalescesValueEvents;
+
 - (void)raiseEvents:(NSArray *)eventDataList;
 - (void)raiseCallback:(fbt_void_void)callback;
 - (void)raiseCallbacks:(NSArray *)callbackList;
@@ -26,6 +26,13 @@
 
 @property(nonatomic, strong) dispatch_queue_t queue;
 
+/**
+ * The latest value event raised for each registration that hasn't been
+ * delivered yet. Only used when coalescing value events. Written on the repo
+ * queue and read on the callback queue, so access is synchronized.
+ */
+@property(nonatomic, strong) NSMapTable *pendingValueEvents;
+
 @end
 
 /**
@@ -45,13 +52,66 @@
     self = [super init];
     if (self != nil) {
         self->_queue = queue;
+        self->_pendingValueEvents =
+            [NSMapTable strongToStrongObjectsMapTable];
     }
     return self;
 }
 
 - (void)raiseEvents:(NSArray *)eventDataList {
-    for (id<FEvent> event in eventDataList) {
-        [event fireEventOnQueue:self.queue];
+    if (eventDataList.count == 0) {
+        return;
+    }
+    // Raise the whole list from a single block, in order, instead of
+    // dispatching every event on its own.
+    NSArray *events = [eventDataList copy];
+    BOOL coalesce = self.coalescesValueEvents;
+    if (coalesce) {
+        [self notePendingValueEvents:events];
+    }
+    dispatch_async(self.queue, ^{
+      for (id<FEvent> event in events) {
+          if (coalesce && ![self takePendingValueEvent:event]) {
+              continue;
+          }
+          [event fireEvent];
+      }
+    });
+}
+
+- (BOOL)isValueEvent:(id<FEvent>)event {
+    return [event isKindOfClass:[FDataEvent class]] &&
+           ((FDataEvent *)event).eventType == FIRDataEventTypeValue;
+}
+
+- (void)notePendingValueEvents:(NSArray *)events {
+    @synchronized(self.pendingValueEvents) {
+        for (id<FEvent> event in events) {
+            if ([self isValueEvent:event]) {
+                FDataEvent *dataEvent = event;
+                [self.pendingValueEvents setObject:dataEvent
+                                            forKey:dataEvent.eventRegistration];
+            }
+        }
+    }
+}
+
+/**
+ * Returns whether the event should still be raised, which is the case for
+ * everything except value events that were superseded by a later one.
+ */
+- (BOOL)takePendingValueEvent:(id<FEvent>)event {
+    if (![self isValueEvent:event]) {
+        return YES;
+    }
+    FDataEvent *dataEvent = event;
+    @synchronized(self.pendingValueEvents) {
+        id<FEventRegistration> registration = dataEvent.eventRegistration;
+        if ([self.pendingValueEvents objectForKey:registration] != dataEvent) {
+            return NO;
+        }
+        [self.pendingValueEvents removeObjectForKey:registration];
+        return YES;
     }
 }
 
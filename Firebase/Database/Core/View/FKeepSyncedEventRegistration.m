@@ -42,7 +42,7 @@
     return nil;
 }
 
-- (void)fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue {
+- (void)fireEvent:(id<FEvent>)event {
     [NSException
          raise:NSInternalInconsistencyException
         format:@"Should never raise event for FKeepSyncedEventRegistration"];
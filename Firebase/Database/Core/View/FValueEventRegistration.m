@@ -63,23 +63,19 @@
     return eventData;
 }
 
-- (void)fireEvent:(id<FEvent>)event queue:(dispatch_queue_t)queue {
+- (void)fireEvent:(id<FEvent>)event {
     if ([event isCancelEvent]) {
         FCancelEvent *cancelEvent = event;
         FFLog(@"I-RDB065001", @"Raising cancel value event on %@", event.path);
         NSAssert(
             self.cancelCallback != nil,
             @"Raising a cancel event on a listener with no cancel callback");
-        dispatch_async(queue, ^{
-          self.cancelCallback(cancelEvent.error);
-        });
+        self.cancelCallback(cancelEvent.error);
     } else if (self.callback != nil) {
         FDataEvent *dataEvent = event;
         FFLog(@"I-RDB065002", @"Raising value event on %@",
               dataEvent.snapshot.key);
-        dispatch_async(queue, ^{
-          self.callback(dataEvent.snapshot);
-        });
+        self.callback(dataEvent.snapshot);
     }
 }
 
@@ -34,11 +34,24 @@
 @property(nonatomic, strong) NSString *basePath;
 @property(nonatomic, strong) APLevelDB *writesDB;
 @property(nonatomic, strong) APLevelDB *serverCacheDB;
+@property(nonatomic) BOOL needsBinaryLeafMigration;
+
+// The total size of the server cache values. It is measured once, when first
+// asked for, and then kept up to date as the cache is written, so checking it
+// doesn't scan the whole cache. NSNotFound until it's measured.
+@property(nonatomic) NSUInteger serverCacheSize;
+// The size changes of the server cache batch being written. Removals are by
+// key, because a batch can remove the same key more than once.
+@property(nonatomic, strong)
+    NSMutableDictionary<NSString *, NSNumber *> *pendingRemovedSizes;
+@property(nonatomic) NSUInteger pendingWrittenSize;
 
 @end
 
 // WARNING: If you change this, you need to write a migration script
-static NSString *const kFPersistenceVersion = @"1";
+static NSString *const kFPersistenceVersion = @"2";
+// Version 1 stored server cache leaves as JSON fragments
+static NSString *const kFPersistenceVersionJSONLeaves = @"1";
 
 static NSString *const kFServerDBPath = @"server_data";
 static NSString *const kFWritesDBPath = @"writes";
@@ -66,6 +79,23 @@ static NSString *const kFTrackedQueryKeysPrefix = @"/tracked_query_keys/";
 // deserializing
 static const NSInteger kFNanFailureCode = 3840;
 
+// Server cache leaves are stored in a compact binary encoding: one of these
+// tags, followed by the value. The tags are control characters, which can't
+// start a JSON value, so leaves that are still JSON can be told apart.
+typedef NS_ENUM(uint8_t, FLevelDBLeafTag) {
+    FLevelDBLeafTagString = 0x01,  // followed by the UTF-8 bytes
+    FLevelDBLeafTagInteger = 0x02, // followed by 8 bytes, little endian
+    FLevelDBLeafTagDouble = 0x03,  // followed by 8 bytes, little endian
+    FLevelDBLeafTagTrue = 0x04,
+    FLevelDBLeafTagFalse = 0x05,
+};
+
+static const uint8_t kFLevelDBLeafTagLimit = 0x20;
+
+// Pruning commits its removals in batches of this many keys, so a large prune
+// doesn't build up one huge batch in memory.
+static const NSUInteger kFPruneBatchSize = 1000;
+
 static NSString *writeRecordKey(NSUInteger writeId) {
     return [NSString stringWithFormat:@"%lu", (unsigned long)(writeId)];
 }
@@ -104,34 +134,48 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
          createDbByName:@"server_complete"];
          */
         [FLevelDBStorageEngine ensureDir:self.basePath markAsDoNotBackup:YES];
+        self.serverCacheSize = NSNotFound;
+        self.pendingRemovedSizes = [NSMutableDictionary dictionary];
         [self runMigration];
         [self openDatabases];
+        if (self.needsBinaryLeafMigration) {
+            [self migrateServerCacheToBinaryLeaves];
+        }
     }
     return self;
 }
 
+- (NSString *)versionFile {
+    return [self.basePath stringByAppendingPathComponent:@"version"];
+}
+
+- (void)writeVersionFile {
+    NSError *error;
+    BOOL success = [kFPersistenceVersion writeToFile:[self versionFile]
+                                          atomically:NO
+                                            encoding:NSUTF8StringEncoding
+                                               error:&error];
+    if (!success) {
+        FFWarn(@"I-RDB076001", @"Failed to write version for database: %@",
+               error);
+    }
+}
+
 - (void)runMigration {
-    // Currently we're at version 1, so all we need to do is write that to a
-    // file
-    NSString *versionFile =
-        [self.basePath stringByAppendingPathComponent:@"version"];
     NSError *error;
     NSString *oldVersion =
-        [NSString stringWithContentsOfFile:versionFile
+        [NSString stringWithContentsOfFile:[self versionFile]
                                   encoding:NSUTF8StringEncoding
                                      error:&error];
     if (!oldVersion) {
         // This is probably fine, we don't have a version file yet
-        BOOL success = [kFPersistenceVersion writeToFile:versionFile
-                                              atomically:NO
-                                                encoding:NSUTF8StringEncoding
-                                                   error:&error];
-        if (!success) {
-            FFWarn(@"I-RDB076001", @"Failed to write version for database: %@",
-                   error);
-        }
+        [self writeVersionFile];
     } else if ([oldVersion isEqualToString:kFPersistenceVersion]) {
         // Everythings fine no need for migration
+    } else if ([oldVersion isEqualToString:kFPersistenceVersionJSONLeaves]) {
+        // The leaves are re-encoded once the databases are open. The version
+        // is only bumped after that, so an interrupted migration runs again.
+        self.needsBinaryLeafMigration = YES;
     } else {
         // If we add more versions in the future, we need to run migration here
         [NSException raise:NSInternalInconsistencyException
@@ -139,6 +183,29 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
+- (void)migrateServerCacheToBinaryLeaves {
+    NSDate *start = [NSDate date];
+    __block NSUInteger counter = 0;
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    [self.serverCacheDB
+        enumerateKeysWithPrefix:kFServerCachePrefix
+                         asData:^(NSString *key, NSData *data, BOOL *stop) {
+                           id value = [self decodePrimitive:data];
+                           [batch setData:[self encodePrimitive:value]
+                                   forKey:key];
+                           counter++;
+                         }];
+    BOOL success = [batch commit];
+    if (!success) {
+        FFWarn(@"I-RDB076037", @"Failed to migrate server cache on disk!");
+        return;
+    }
+    self.needsBinaryLeafMigration = NO;
+    [self writeVersionFile];
+    FFDebug(@"I-RDB076038", @"Migrated %lu leaf nodes in %fms",
+            (unsigned long)counter, [start timeIntervalSinceNow] * -1000);
+}
+
 - (void)runLegacyMigration:(FRepoInfo *)info {
     NSArray *dirPaths = NSSearchPathForDirectoriesInDomains(
         NSDocumentDirectory, NSUserDomainMask, YES);
@@ -246,6 +313,7 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
           [self purgeDatabase:dbPath];
         }];
 
+    self.serverCacheSize = NSNotFound;
     [self openDatabases];
 }
 
@@ -471,7 +539,7 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
                          database:self.serverCacheDB];
         [self saveNodeInternal:node atPath:path batch:batch counter:&counter];
     }
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076017", @"Failed to update server cache on disk!");
     } else {
@@ -497,7 +565,7 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
                        batch:batch
                      counter:&counter];
     }];
-    BOOL success = [batch commit];
+    BOOL success = [self commitServerCacheBatch:batch];
     if (!success) {
         FFWarn(@"I-RDB076019", @"Failed to update server cache on disk!");
     } else {
@@ -520,38 +588,61 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 }
 
 - (NSUInteger)serverCacheEstimatedSizeInBytes {
-    // Use the exact size, because for pruning the approximate size can lead to
-    // weird situations where we prune everything because no compaction is ever
-    // run
-    return [self.serverCacheDB exactSizeFrom:kFServerCachePrefix
-                                          to:kFServerCacheRangeEnd];
+    if (self.serverCacheSize == NSNotFound) {
+        // Use the exact size, because for pruning the approximate size can
+        // lead to weird situations where we prune everything because no
+        // compaction is ever run
+        self.serverCacheSize =
+            [self.serverCacheDB exactSizeFrom:kFServerCachePrefix
+                                           to:kFServerCacheRangeEnd];
+    }
+    return self.serverCacheSize;
 }
 
 - (void)pruneCache:(FPruneForest *)pruneForest atPath:(FPath *)path {
-    // TODO: be more intelligent, don't scan entire database...
-
     __block NSUInteger pruned = 0;
     __block NSUInteger kept = 0;
     NSDate *start = [NSDate date];
 
     NSString *prefix = serverCacheKey(path);
-    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
-
-    [self.serverCacheDB
-        enumerateKeysWithPrefix:prefix
-                     usingBlock:^(NSString *dbKey, BOOL *stop) {
-                       NSString *pathStr =
-                           [dbKey substringFromIndex:prefix.length];
-                       FPath *relativePath = [[FPath alloc] initWith:pathStr];
-                       if ([pruneForest shouldPruneUnkeptDescendantsAtPath:
-                                            relativePath]) {
-                           pruned++;
-                           [batch removeKey:dbKey];
-                       } else {
-                           kept++;
-                       }
-                     }];
-    BOOL success = [batch commit];
+    __block id<APLevelDBWriteBatch> batch =
+        [self.serverCacheDB beginWriteBatch];
+    __block NSUInteger batchCount = 0;
+    __block BOOL success = YES;
+
+    // Only the subtrees that are pruned can have anything to remove, so
+    // there's no need to look at the rest of the cache.
+    [pruneForest enumeratePrunedRootsUsingBlock:^(FPath *prunedRoot) {
+      NSString *rootPrefix = serverCacheKey([path child:prunedRoot]);
+      [self.serverCacheDB
+          enumerateKeysWithPrefix:rootPrefix
+                           asData:^(NSString *dbKey, NSData *data,
+                                    BOOL *stop) {
+                             NSString *pathStr =
+                                 [dbKey substringFromIndex:prefix.length];
+                             FPath *relativePath =
+                                 [[FPath alloc] initWith:pathStr];
+                             if (![pruneForest
+                                     shouldPruneUnkeptDescendantsAtPath:
+                                         relativePath]) {
+                                 kept++;
+                                 return;
+                             }
+                             pruned++;
+                             [batch removeKey:dbKey];
+                             [self noteServerCacheRemovalOfKey:dbKey
+                                                          size:data.length];
+                             if (++batchCount == kFPruneBatchSize) {
+                                 success = [self commitServerCacheBatch:batch];
+                                 batch = [self.serverCacheDB beginWriteBatch];
+                                 batchCount = 0;
+                                 *stop = !success;
+                             }
+                           }];
+    }];
+    if (success) {
+        success = [self commitServerCacheBatch:batch];
+    }
     if (!success) {
         FFWarn(@"I-RDB076021", @"Failed to prune cache on disk!");
     } else {
@@ -660,8 +751,7 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
-- (void)saveTrackedQuery:(FTrackedQuery *)query {
-    NSDate *start = [NSDate date];
+- (NSData *)trackedQueryData:(FTrackedQuery *)query {
     NSDictionary *trackedQuery = @{
         kFTrackedQueryId : @(query.queryId),
         kFTrackedQueryPath : [query.query.path toStringWithTrailingSlash],
@@ -675,11 +765,34 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
                                                    options:0
                                                      error:&error];
     NSAssert(data, @"Failed to serialize tracked query (Error: %@)", error);
-    [self.serverCacheDB setData:data forKey:trackedQueryKey(query.queryId)];
+    return data;
+}
+
+- (void)saveTrackedQuery:(FTrackedQuery *)query {
+    NSDate *start = [NSDate date];
+    [self.serverCacheDB setData:[self trackedQueryData:query]
+                         forKey:trackedQueryKey(query.queryId)];
     FFDebug(@"I-RDB076028", @"Saved tracked query %lu in %fms",
             (unsigned long)query.queryId, [start timeIntervalSinceNow] * -1000);
 }
 
+- (void)saveTrackedQueries:(NSArray *)queries {
+    NSDate *start = [NSDate date];
+    id<APLevelDBWriteBatch> batch = [self.serverCacheDB beginWriteBatch];
+    for (FTrackedQuery *query in queries) {
+        [batch setData:[self trackedQueryData:query]
+                forKey:trackedQueryKey(query.queryId)];
+    }
+    BOOL success = [batch commit];
+    if (!success) {
+        FFWarn(@"I-RDB076039", @"Failed to save tracked queries on disk!");
+    } else {
+        FFDebug(@"I-RDB076040", @"Saved %lu tracked queries in %fms",
+                (unsigned long)queries.count,
+                [start timeIntervalSinceNow] * -1000);
+    }
+}
+
 - (void)setTrackedQueryKeys:(NSSet *)keys forQueryId:(NSUInteger)queryId {
     NSDate *start = [NSDate date];
     __block NSUInteger removed = 0;
@@ -765,11 +878,22 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
 - (void)removeAllLeafNodesOnPath:(FPath *)path
                            batch:(id<APLevelDBWriteBatch>)batch {
     while (!path.isEmpty) {
-        [batch removeKey:serverCacheKey(path)];
+        [self removeServerCacheKey:serverCacheKey(path) batch:batch];
         path = [path parent];
     }
     // Make sure to delete any nodes at the root
-    [batch removeKey:serverCacheKey([FPath empty])];
+    [self removeServerCacheKey:serverCacheKey([FPath empty]) batch:batch];
+}
+
+- (void)removeServerCacheKey:(NSString *)key
+                       batch:(id<APLevelDBWriteBatch>)batch {
+    if (self.serverCacheSize != NSNotFound) {
+        NSData *data = [self.serverCacheDB dataForKey:key];
+        if (data != nil) {
+            [self noteServerCacheRemovalOfKey:key size:data.length];
+        }
+    }
+    [batch removeKey:key];
 }
 
 - (void)removeAllWithPrefix:(NSString *)prefix
@@ -777,12 +901,53 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
                    database:(APLevelDB *)database {
     assert(prefix != nil);
 
+    if (database == self.serverCacheDB && self.serverCacheSize != NSNotFound) {
+        [database enumerateKeysWithPrefix:prefix
+                                   asData:^(NSString *key, NSData *data,
+                                            BOOL *stop) {
+                                     NSUInteger size = data.length;
+                                     [batch removeKey:key];
+                                     [self noteServerCacheRemovalOfKey:key
+                                                                  size:size];
+                                   }];
+        return;
+    }
+
     [database enumerateKeysWithPrefix:prefix
                            usingBlock:^(NSString *key, BOOL *stop) {
                              [batch removeKey:key];
                            }];
 }
 
+#pragma mark - Server cache size
+
+- (void)noteServerCacheRemovalOfKey:(NSString *)key size:(NSUInteger)size {
+    if (self.serverCacheSize != NSNotFound) {
+        self.pendingRemovedSizes[key] = @(size);
+    }
+}
+
+- (void)noteServerCacheWriteOfSize:(NSUInteger)size {
+    if (self.serverCacheSize != NSNotFound) {
+        self.pendingWrittenSize += size;
+    }
+}
+
+- (BOOL)commitServerCacheBatch:(id<APLevelDBWriteBatch>)batch {
+    BOOL success = [batch commit];
+    if (success && self.serverCacheSize != NSNotFound) {
+        NSUInteger removed = 0;
+        for (NSNumber *size in self.pendingRemovedSizes.objectEnumerator) {
+            removed += size.unsignedIntegerValue;
+        }
+        NSUInteger total = self.serverCacheSize + self.pendingWrittenSize;
+        self.serverCacheSize = total > removed ? total - removed : 0;
+    }
+    [self.pendingRemovedSizes removeAllObjects];
+    self.pendingWrittenSize = 0;
+    return success;
+}
+
 #pragma mark - Internal helper methods
 
 - (void)internalSetNestedData:(id)value
@@ -802,8 +967,9 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
                               counter:counter];
         }];
     } else {
-        NSData *data = [self serializePrimitive:value];
+        NSData *data = [self encodePrimitive:value];
         [batch setData:data forKey:key];
+        [self noteServerCacheWriteOfSize:data.length];
         (*counter)++;
     }
 }
@@ -835,7 +1001,7 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     NSString *key = iterator.key;
 
     if ([key isEqualToString:prefix]) {
-        id result = [self deserializePrimitive:iterator.valueAsData];
+        id result = [self decodePrimitive:iterator.valueAsData];
         [iterator nextKey];
         return result;
     } else {
@@ -858,6 +1024,87 @@ static NSString *trackedQueryKeysKey(NSUInteger trackedQueryId, NSString *key) {
     }
 }
 
+- (NSData *)encodePrimitive:(id)value {
+    uint8_t tag;
+    if (value == (id)kCFBooleanTrue || value == (id)kCFBooleanFalse) {
+        tag = value == (id)kCFBooleanTrue ? FLevelDBLeafTagTrue
+                                          : FLevelDBLeafTagFalse;
+        return [NSData dataWithBytes:&tag length:sizeof(tag)];
+    } else if ([value isKindOfClass:[NSString class]]) {
+        NSData *utf8 = [value dataUsingEncoding:NSUTF8StringEncoding];
+        NSMutableData *data =
+            [NSMutableData dataWithCapacity:sizeof(tag) + utf8.length];
+        tag = FLevelDBLeafTagString;
+        [data appendBytes:&tag length:sizeof(tag)];
+        [data appendData:utf8];
+        return data;
+    } else if ([value isKindOfClass:[NSNumber class]]) {
+        // Normalize the number the same way a JSON round trip did, so the
+        // values read back (and their hashes) don't change.
+        NSNumber *number = [self fixDoubleParsing:value];
+        uint64_t bits;
+        if (CFNumberIsFloatType((CFNumberRef)number)) {
+            double doubleValue = [number doubleValue];
+            memcpy(&bits, &doubleValue, sizeof(bits));
+            tag = FLevelDBLeafTagDouble;
+        } else if ([number compare:@(INT64_MAX)] != NSOrderedDescending) {
+            int64_t integerValue = [number longLongValue];
+            memcpy(&bits, &integerValue, sizeof(bits));
+            tag = FLevelDBLeafTagInteger;
+        } else {
+            // Doesn't fit in a signed integer, keep what JSON did with it
+            return [self serializePrimitive:value];
+        }
+        bits = CFSwapInt64HostToLittle(bits);
+        NSMutableData *data =
+            [NSMutableData dataWithCapacity:sizeof(tag) + sizeof(bits)];
+        [data appendBytes:&tag length:sizeof(tag)];
+        [data appendBytes:&bits length:sizeof(bits)];
+        return data;
+    } else {
+        return [self serializePrimitive:value];
+    }
+}
+
+- (id)decodePrimitive:(NSData *)data {
+    const uint8_t *bytes = data.bytes;
+    if (data.length == 0 || bytes[0] >= kFLevelDBLeafTagLimit) {
+        return [self deserializePrimitive:data];
+    }
+
+    uint64_t bits = 0;
+    switch (bytes[0]) {
+        case FLevelDBLeafTagString:
+            return [[NSString alloc] initWithBytes:bytes + 1
+                                            length:data.length - 1
+                                          encoding:NSUTF8StringEncoding];
+        case FLevelDBLeafTagTrue:
+            return @YES;
+        case FLevelDBLeafTagFalse:
+            return @NO;
+        case FLevelDBLeafTagInteger:
+        case FLevelDBLeafTagDouble:
+            if (data.length != 1 + sizeof(bits)) {
+                break;
+            }
+            memcpy(&bits, bytes + 1, sizeof(bits));
+            bits = CFSwapInt64LittleToHost(bits);
+            if (bytes[0] == FLevelDBLeafTagInteger) {
+                int64_t integerValue;
+                memcpy(&integerValue, &bits, sizeof(integerValue));
+                return [NSNumber numberWithLongLong:integerValue];
+            } else {
+                double doubleValue;
+                memcpy(&doubleValue, &bits, sizeof(doubleValue));
+                return [NSNumber numberWithDouble:doubleValue];
+            }
+    }
+
+    [NSException raise:NSInternalInconsistencyException
+                format:@"Failed to decode primitive with tag %d", bytes[0]];
+    return nil;
+}
+
 - (NSData *)serializePrimitive:(id)value {
     // HACK: The built-in serialization only works on dicts and arrays.  So we
     // create an array and then strip off the leading / trailing byte (the [ and
@@ -30,6 +30,12 @@
                 cachePolicy:(id<FCachePolicy>)cachePolicy;
 - (void)close;
 
+/**
+ * Saves any tracked query changes that are waiting to be written, e.g. before
+ * the app goes into the background.
+ */
+- (void)flushTrackedQueries;
+
 - (void)saveUserOverwrite:(id<FNode>)node
                    atPath:(FPath *)path
                   writeId:(NSUInteger)writeId;
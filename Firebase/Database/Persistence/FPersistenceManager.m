@@ -50,11 +50,16 @@
 }
 
 - (void)close {
+    [self.trackedQueryManager flush];
     [self.storageEngine close];
     self.storageEngine = nil;
     self.trackedQueryManager = nil;
 }
 
+- (void)flushTrackedQueries {
+    [self.trackedQueryManager flush];
+}
+
 - (void)saveUserOverwrite:(id<FNode>)node
                    atPath:(FPath *)path
                   writeId:(NSUInteger)writeId {
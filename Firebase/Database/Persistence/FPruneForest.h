@@ -34,5 +34,8 @@
 - (FPruneForest *)pruneAll:(NSSet *)children atPath:(FPath *)path;
 
 - (void)enumarateKeptNodesUsingBlock:(void (^)(FPath *path))block;
+// The root-most paths that are pruned, which contain everything that can be
+// pruned.
+- (void)enumeratePrunedRootsUsingBlock:(void (^)(FPath *path))block;
 
 @end
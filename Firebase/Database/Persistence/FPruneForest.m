@@ -191,4 +191,19 @@ static BOOL (^kFKeepPredicate)(id) = ^BOOL(NSNumber *pruneValue) {
     }];
 }
 
+- (void)enumeratePrunedRootsUsingBlock:(void (^)(FPath *))block {
+    [self.pruneForest forEach:^(FPath *path, id value) {
+      if (value == nil || ![value boolValue]) {
+          return;
+      }
+      // Skip paths inside a subtree that is already pruned
+      if (!path.isEmpty &&
+          [self.pruneForest rootMostValueOnPath:path.parent
+                                       matching:kFPrunePredicate]) {
+          return;
+      }
+      block(path);
+    }];
+}
+
 @end
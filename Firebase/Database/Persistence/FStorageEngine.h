@@ -50,6 +50,7 @@
 - (NSArray *)loadTrackedQueries;
 - (void)removeTrackedQuery:(NSUInteger)queryId;
 - (void)saveTrackedQuery:(FTrackedQuery *)query;
+- (void)saveTrackedQueries:(NSArray *)queries;
 
 - (void)setTrackedQueryKeys:(NSSet *)keys forQueryId:(NSUInteger)queryId;
 - (void)updateTrackedQueryKeysWithAddedKeys:(NSSet *)added
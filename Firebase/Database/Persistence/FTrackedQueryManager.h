@@ -46,6 +46,12 @@
 - (NSUInteger)numberOfPrunableQueries;
 - (NSSet *)knownCompleteChildrenAtPath:(FPath *)path;
 
+/**
+ * Saves the changes to tracked queries that are waiting to be written, in one
+ * batch.
+ */
+- (void)flush;
+
 // For testing
 - (void)verifyCache;
 
@@ -24,6 +24,15 @@
 #import "FUtilities.h"
 #import <FirebaseCore/FIRLogger.h>
 
+// Changes to tracked queries that are already on disk are saved together at
+// most this often (in seconds), or when the app goes into the background.
+static const NSTimeInterval kFTrackedQueryFlushInterval = 5;
+
+typedef struct {
+    NSTimeInterval lastUse;
+    NSUInteger index;
+} FPrunableQueryEntry;
+
 @interface FTrackedQueryManager ()
 
 @property(nonatomic, strong) FImmutableTree *trackedQueryTree;
@@ -31,6 +40,10 @@
 @property(nonatomic, strong) id<FClock> clock;
 @property(nonatomic) NSUInteger currentQueryId;
 
+// Tracked queries with changes that haven't been saved yet, by query id
+@property(nonatomic, strong) NSMutableDictionary *dirtyTrackedQueries;
+@property(nonatomic) NSTimeInterval lastFlushTime;
+
 @end
 
 @implementation FTrackedQueryManager
@@ -42,8 +55,11 @@
         self->_storageEngine = storageEngine;
         self->_clock = clock;
         self->_trackedQueryTree = [FImmutableTree empty];
+        self->_dirtyTrackedQueries = [NSMutableDictionary dictionary];
 
         NSTimeInterval lastUse = [clock currentTime];
+        self->_lastFlushTime = lastUse;
+        NSMutableArray *deactivatedQueries = [NSMutableArray array];
 
         NSArray *trackedQueries = [self.storageEngine loadTrackedQueries];
         [trackedQueries enumerateObjectsUsingBlock:^(
@@ -58,10 +74,13 @@
                   @"I-RDB081001",
                   @"Setting active query %lu from previous app start inactive",
                   (unsigned long)trackedQuery.queryId);
-              [self.storageEngine saveTrackedQuery:trackedQuery];
+              [deactivatedQueries addObject:trackedQuery];
           }
           [self cacheTrackedQuery:trackedQuery];
         }];
+        if (deactivatedQueries.count > 0) {
+            [self.storageEngine saveTrackedQueries:deactivatedQueries];
+        }
     }
     return self;
 }
@@ -87,6 +106,7 @@
     FTrackedQuery *trackedQuery = [self findTrackedQuery:query];
     NSAssert(trackedQuery, @"Tracked query must exist to be removed!");
 
+    [self.dirtyTrackedQueries removeObjectForKey:@(trackedQuery.queryId)];
     [self.storageEngine removeTrackedQuery:trackedQuery.queryId];
     NSMutableDictionary *trackedQueries =
         [self.trackedQueryTree valueAtPath:query.path];
@@ -111,7 +131,7 @@
     if (trackedQuery != nil) {
         trackedQuery =
             [[trackedQuery updateLastUse:lastUse] setActiveState:isActive];
-        [self.storageEngine saveTrackedQuery:trackedQuery];
+        [self saveTrackedQueryLater:trackedQuery];
     } else {
         NSAssert(isActive, @"If we're setting the query to inactive, we should "
                            @"already be tracking it!");
@@ -119,7 +139,7 @@
                                                    query:query
                                                  lastUse:lastUse
                                                 isActive:isActive];
-        [self.storageEngine saveTrackedQuery:trackedQuery];
+        [self saveNewTrackedQuery:trackedQuery];
     }
 
     [self cacheTrackedQuery:trackedQuery];
@@ -135,7 +155,7 @@
                @"Trying to set a query complete that is not tracked!");
     } else if (!trackedQuery.isComplete) {
         trackedQuery = [trackedQuery setComplete];
-        [self.storageEngine saveTrackedQuery:trackedQuery];
+        [self saveTrackedQueryLater:trackedQuery];
         [self cacheTrackedQuery:trackedQuery];
     } else {
         // Nothing to do, already marked complete
@@ -150,7 +170,7 @@
                               BOOL *stop) {
             if (!trackedQuery.isComplete) {
                 FTrackedQuery *newTrackedQuery = [trackedQuery setComplete];
-                [self.storageEngine saveTrackedQuery:newTrackedQuery];
+                [self saveTrackedQueryLater:newTrackedQuery];
                 [self cacheTrackedQuery:newTrackedQuery];
             }
           }];
@@ -191,12 +211,13 @@
                                           lastUse:[self.clock currentTime]
                                          isActive:NO
                                        isComplete:YES];
+            [self saveNewTrackedQuery:trackedQuery];
         } else {
             NSAssert(!trackedQuery.isComplete,
                      @"This should have been handled above!");
             trackedQuery = [trackedQuery setComplete];
+            [self saveTrackedQueryLater:trackedQuery];
         }
-        [self.storageEngine saveTrackedQuery:trackedQuery];
         [self cacheTrackedQuery:trackedQuery];
     }
 }
@@ -212,6 +233,37 @@
                            }] != nil;
 }
 
+/**
+ * New tracked queries are saved right away, because their ids are reused after
+ * a restart if they aren't on disk, and tracked query keys are saved by id.
+ */
+- (void)saveNewTrackedQuery:(FTrackedQuery *)query {
+    [self.storageEngine saveTrackedQuery:query];
+}
+
+/**
+ * Changes to the last use time, and the active and complete states, are only
+ * saved periodically. Losing them in a crash at worst makes a query look older
+ * or incomplete, and queries are set inactive on every start anyway.
+ */
+- (void)saveTrackedQueryLater:(FTrackedQuery *)query {
+    self.dirtyTrackedQueries[@(query.queryId)] = query;
+    if ([self.clock currentTime] - self.lastFlushTime >=
+        kFTrackedQueryFlushInterval) {
+        [self flush];
+    }
+}
+
+- (void)flush {
+    self.lastFlushTime = [self.clock currentTime];
+    if (self.dirtyTrackedQueries.count == 0) {
+        return;
+    }
+    [self.storageEngine
+        saveTrackedQueries:self.dirtyTrackedQueries.allValues];
+    [self.dirtyTrackedQueries removeAllObjects];
+}
+
 - (void)cacheTrackedQuery:(FTrackedQuery *)query {
     [FTrackedQueryManager assertValidTrackedQuery:query.query];
     NSMutableDictionary *trackedDict =
@@ -235,6 +287,42 @@
     return MAX(numMax, numPercent);
 }
 
+/**
+ * Orders the prunable queries by last use, and then by the order they were
+ * found in, so that ties are pruned in the same order as a stable sort.
+ */
+static BOOL FPrunableQueryEntryLessThan(FPrunableQueryEntry a,
+                                        FPrunableQueryEntry b) {
+    if (a.lastUse != b.lastUse) {
+        return a.lastUse < b.lastUse;
+    }
+    return a.index < b.index;
+}
+
+static void FPrunableQueryHeapSiftDown(FPrunableQueryEntry *heap,
+                                       NSUInteger size, NSUInteger i) {
+    while (YES) {
+        NSUInteger smallest = i;
+        NSUInteger left = 2 * i + 1;
+        NSUInteger right = left + 1;
+        if (left < size &&
+            FPrunableQueryEntryLessThan(heap[left], heap[smallest])) {
+            smallest = left;
+        }
+        if (right < size &&
+            FPrunableQueryEntryLessThan(heap[right], heap[smallest])) {
+            smallest = right;
+        }
+        if (smallest == i) {
+            return;
+        }
+        FPrunableQueryEntry tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+}
+
 - (FPruneForest *)pruneOldQueries:(id<FCachePolicy>)cachePolicy {
     NSMutableArray *pruneableQueries = [NSMutableArray array];
     NSMutableArray *unpruneableQueries = [NSMutableArray array];
@@ -250,33 +338,46 @@
             }
           }];
         }];
-    [pruneableQueries sortUsingComparator:^NSComparisonResult(
-                          FTrackedQuery *q1, FTrackedQuery *q2) {
-      if (q1.lastUse < q2.lastUse) {
-          return NSOrderedAscending;
-      } else if (q1.lastUse > q2.lastUse) {
-          return NSOrderedDescending;
-      } else {
-          return NSOrderedSame;
-      }
-    }];
-
     __block FPruneForest *pruneForest = [FPruneForest empty];
-    NSUInteger numToPrune =
-        [self numberOfQueriesToPrune:cachePolicy
-                       prunableCount:pruneableQueries.count];
+    NSUInteger count = pruneableQueries.count;
+    NSUInteger numToPrune = MIN(
+        [self numberOfQueriesToPrune:cachePolicy prunableCount:count], count);
+
+    // Only the least recently used queries are pruned, so pop them off a heap
+    // rather than sorting every prunable query.
+    FPrunableQueryEntry *heap = NULL;
+    if (numToPrune > 0) {
+        heap = malloc(count * sizeof(FPrunableQueryEntry));
+        NSAssert(heap, @"Failed to allocate the prunable query heap");
+        for (NSUInteger i = 0; i < count; i++) {
+            FTrackedQuery *trackedQuery = pruneableQueries[i];
+            heap[i] = (FPrunableQueryEntry){trackedQuery.lastUse, i};
+        }
+        for (NSUInteger i = count / 2; i > 0; i--) {
+            FPrunableQueryHeapSiftDown(heap, count, i - 1);
+        }
+    }
 
     // TODO: do in transaction
+    NSMutableIndexSet *prunedIndexes = [NSMutableIndexSet indexSet];
+    NSUInteger heapSize = count;
     for (NSUInteger i = 0; i < numToPrune; i++) {
-        FTrackedQuery *toPrune = pruneableQueries[i];
+        FTrackedQuery *toPrune = pruneableQueries[heap[0].index];
+        [prunedIndexes addIndex:heap[0].index];
+        heap[0] = heap[--heapSize];
+        FPrunableQueryHeapSiftDown(heap, heapSize, 0);
+
         pruneForest = [pruneForest prunePath:toPrune.query.path];
         [self removeTrackedQuery:toPrune.query];
     }
+    free(heap);
 
     // Keep the rest of the prunable queries
-    for (NSUInteger i = numToPrune; i < pruneableQueries.count; i++) {
-        FTrackedQuery *toKeep = pruneableQueries[i];
-        pruneForest = [pruneForest keepPath:toKeep.query.path];
+    for (NSUInteger i = 0; i < count; i++) {
+        if (![prunedIndexes containsIndex:i]) {
+            FTrackedQuery *toKeep = pruneableQueries[i];
+            pruneForest = [pruneForest keepPath:toKeep.query.path];
+        }
     }
 
     // Also keep unprunable queries
@@ -345,6 +446,7 @@
 }
 
 - (void)verifyCache {
+    [self flush];
     NSArray *storedTrackedQueries = [self.storageEngine loadTrackedQueries];
     NSMutableArray *trackedQueries = [NSMutableArray array];
 
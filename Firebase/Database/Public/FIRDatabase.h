@@ -167,6 +167,16 @@ NS_SWIFT_NAME(Database)
  */
 @property(nonatomic, strong) dispatch_queue_t callbackQueue;
 
+/**
+ * By default every value event is raised. By setting this value to YES, a
+ * value listener that receives several updates before the callback queue gets
+ * to them is only called with the latest one. This is useful for listeners
+ * that just render the current value of a location that changes often.
+ *
+ * Note that this must be set before creating your first Database reference.
+ */
+@property(nonatomic) BOOL coalescesValueEvents;
+
 /**
  * Enables verbose diagnostic logging.
  *
@@ -47,6 +47,7 @@
 @property(nonatomic, readonly) BOOL buffering;
 @property(nonatomic, readonly) NSString *userAgent;
 @property(nonatomic) dispatch_queue_t dispatchQueue;
+@property(nonatomic) dispatch_queue_t serializationQueue;
 
 - (void)nop:(NSTimer *)timer;
 
@@ -68,6 +69,9 @@
         self.connectionId = [FUtilities LUIDGenerator];
         self.totalFrames = 0;
         self.dispatchQueue = queue;
+        self.serializationQueue = dispatch_queue_create(
+            "com.firebase.database.websocket.serialization",
+            DISPATCH_QUEUE_SERIAL);
         frame = nil;
 
         NSString *connectionUrl =
@@ -164,28 +168,35 @@
 
     [self resetKeepAlive];
 
-    NSData *jsonData = [NSJSONSerialization dataWithJSONObject:dictionary
-                                                       options:kNilOptions
-                                                         error:nil];
-
-    NSString *data = [[NSString alloc] initWithData:jsonData
-                                           encoding:NSUTF8StringEncoding];
-
-    NSArray *dataSegs = [FUtilities splitString:data
-                                    intoMaxSize:kWebsocketMaxFrameSize];
-
-    // First send the header so the server knows how many segments are
-    // forthcoming
-    if (dataSegs.count > 1) {
-        [self.webSocket
-            send:[NSString
-                     stringWithFormat:@"%u", (unsigned int)dataSegs.count]];
-    }
-
-    // Then, actually send the segments.
-    for (NSString *segment in dataSegs) {
-        [self.webSocket send:segment];
-    }
+    // Serialize large writes without holding up the repo queue. The queue is
+    // serial and the websocket queues frames in the order they are sent, so
+    // messages still go out in order. Requests aren't mutated once they are
+    // sent.
+    FSRWebSocket *socket = self.webSocket;
+    dispatch_async(self.serializationQueue, ^{
+      NSData *jsonData =
+          [NSJSONSerialization dataWithJSONObject:dictionary
+                                          options:kNilOptions
+                                            error:nil];
+
+      NSString *data = [[NSString alloc] initWithData:jsonData
+                                             encoding:NSUTF8StringEncoding];
+
+      NSArray *dataSegs = [FUtilities splitString:data
+                                      intoMaxSize:kWebsocketMaxFrameSize];
+
+      // First send the header so the server knows how many segments are
+      // forthcoming
+      if (dataSegs.count > 1) {
+          [socket send:[NSString stringWithFormat:@"%u",
+                                                  (unsigned int)dataSegs.count]];
+      }
+
+      // Then, actually send the segments.
+      for (NSString *segment in dataSegs) {
+          [socket send:segment];
+      }
+    });
 }
 
 - (void)nop:(NSTimer *)timer {
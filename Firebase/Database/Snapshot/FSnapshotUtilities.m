@@ -176,8 +176,12 @@
         }
     } else if ([value isKindOfClass:[NSArray class]]) {
         NSArray *aval = (NSArray *)value;
-        NSMutableDictionary *children =
-            [NSMutableDictionary dictionaryWithCapacity:aval.count];
+        // Index keys are generated in ascending order, so the children can
+        // be built without sorting them.
+        NSMutableArray *childKeys =
+            [NSMutableArray arrayWithCapacity:aval.count];
+        NSMutableArray *children =
+            [NSMutableArray arrayWithCapacity:aval.count];
 
         for (int i = 0; i < [aval count]; i++) {
             NSString *key = [NSString stringWithFormat:@"%i", i];
@@ -191,7 +195,8 @@
             [path removeLastObject];
 
             if (![childNode isEmpty]) {
-                children[key] = childNode;
+                [childKeys addObject:key];
+                [children addObject:childNode];
             }
         }
 
@@ -200,7 +205,8 @@
         } else {
             FImmutableSortedDictionary *childrenDict =
                 [FImmutableSortedDictionary
-                    fromDictionary:children
+                    fromSortedKeys:childKeys
+                            values:children
                     withComparator:[FUtilities keyComparator]];
             return [[FChildrenNode alloc] initWithPriority:priority
                                                   children:childrenDict];
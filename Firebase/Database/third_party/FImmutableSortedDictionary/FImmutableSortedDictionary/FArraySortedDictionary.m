@@ -62,6 +62,18 @@
     }];
     [keys sortUsingComparator:comparator];
 
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:keys.count];
+    NSInteger pos = 0;
+    for (id key in keys) {
+        values[pos++] = dictionary[key];
+    }
+    NSAssert(values.count == keys.count, @"We added as many keys as values");
+    return [self fromSortedKeys:keys values:values withComparator:comparator];
+}
+
++ (FArraySortedDictionary *)fromSortedKeys:(NSArray *)keys values:(NSArray *)values withComparator:(NSComparator)comparator
+{
+    NSAssert(values.count == keys.count, @"There must be as many keys as values");
     [keys enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
         if (idx > 0) {
             if (comparator(keys[idx - 1], obj) != NSOrderedAscending) {
@@ -70,13 +82,7 @@
         }
     }];
 
-    NSMutableArray *values = [NSMutableArray arrayWithCapacity:keys.count];
-    NSInteger pos = 0;
-    for (id key in keys) {
-        values[pos++] = dictionary[key];
-    }
-    NSAssert(values.count == keys.count, @"We added as many keys as values");
-    return [[FArraySortedDictionary alloc] initWithComparator:comparator keys:keys values:values];
+    return [[FArraySortedDictionary alloc] initWithComparator:comparator keys:[keys copy] values:[values copy]];
 }
 
 - (id)initWithComparator:(NSComparator)comparator
@@ -26,6 +26,11 @@
 
 + (FImmutableSortedDictionary *)dictionaryWithComparator:(NSComparator)comparator;
 + (FImmutableSortedDictionary *)fromDictionary:(NSDictionary *)dictionary withComparator:(NSComparator)comparator;
+/**
+ * Builds a dictionary from keys that are already in ascending order, in linear time. Use this when the keys come out
+ * of the data in order, to skip the sort that fromDictionary:withComparator: has to do.
+ */
++ (FImmutableSortedDictionary *)fromSortedKeys:(NSArray *)keys values:(NSArray *)values withComparator:(NSComparator)comparator;
 
 - (FImmutableSortedDictionary *) insertKey:(id)aKey withValue:(id)aValue;
 - (FImmutableSortedDictionary *) removeKey:(id)aKey;
@@ -24,6 +24,15 @@
     }
 }
 
++ (FImmutableSortedDictionary *)fromSortedKeys:(NSArray *)keys values:(NSArray *)values withComparator:(NSComparator)comparator
+{
+    if (keys.count <= SORTED_DICTIONARY_ARRAY_TO_RB_TREE_SIZE_THRESHOLD) {
+        return [FArraySortedDictionary fromSortedKeys:keys values:values withComparator:comparator];
+    } else {
+        return [FTreeSortedDictionary fromSortedKeys:keys values:values withComparator:comparator];
+    }
+}
+
 - (FImmutableSortedDictionary *) insertKey:(id)aKey withValue:(id)aValue {
     THROW_ABSTRACT_METHOD_EXCEPTION(@selector(insertKey:withValue:));
 }
@@ -231,23 +231,22 @@ void base1_2List_free(Base1_2List* list) {
     free(list);
 }
 
-+ (id<FLLRBNode>) buildBalancedTree:(NSArray *)keys dictionary:(NSDictionary *)dictionary subArrayStartIndex:(NSUInteger)startIndex length:(NSUInteger)length {
++ (id<FLLRBNode>) buildBalancedTree:(NSArray *)keys values:(NSArray *)values subArrayStartIndex:(NSUInteger)startIndex length:(NSUInteger)length {
     length = MIN(keys.count - startIndex, length); // Bound length by the actual length of the array
     if (length == 0) {
         return nil;
     } else if (length == 1) {
-        id key = keys[startIndex];
-        return [[FLLRBValueNode alloc] initWithKey:key withValue:dictionary[key] withColor:BLACK withLeft:nil withRight:nil];
+        return [[FLLRBValueNode alloc] initWithKey:keys[startIndex] withValue:values[startIndex] withColor:BLACK withLeft:nil withRight:nil];
     } else {
         NSUInteger middle = length / 2;
-        id<FLLRBNode> left = [FTreeSortedDictionary buildBalancedTree:keys dictionary:dictionary subArrayStartIndex:startIndex length:middle];
-        id<FLLRBNode> right = [FTreeSortedDictionary buildBalancedTree:keys dictionary:dictionary subArrayStartIndex:(startIndex+middle+1) length:middle];
-        id key = keys[startIndex + middle];
-        return [[FLLRBValueNode alloc] initWithKey:key withValue:dictionary[key] withColor:BLACK withLeft:left withRight:right];
+        id<FLLRBNode> left = [FTreeSortedDictionary buildBalancedTree:keys values:values subArrayStartIndex:startIndex length:middle];
+        id<FLLRBNode> right = [FTreeSortedDictionary buildBalancedTree:keys values:values subArrayStartIndex:(startIndex+middle+1) length:middle];
+        NSUInteger index = startIndex + middle;
+        return [[FLLRBValueNode alloc] initWithKey:keys[index] withValue:values[index] withColor:BLACK withLeft:left withRight:right];
     }
 }
 
-+ (id<FLLRBNode>) rootFrom12List:(Base1_2List *)base1_2List keyList:(NSArray *)keyList dictionary:(NSDictionary *)dictionary {
++ (id<FLLRBNode>) rootFrom12List:(Base1_2List *)base1_2List keyList:(NSArray *)keyList values:(NSArray *)values {
     __block id<FLLRBNode> root = nil;
     __block id<FLLRBNode> node = nil;
     __block NSUInteger index = keyList.count;
@@ -255,9 +254,8 @@ void base1_2List_free(Base1_2List* list) {
     fbt_void_nsnumber_int buildPennant = ^(NSNumber* color, NSUInteger chunkSize) {
         NSUInteger startIndex = index - chunkSize + 1;
         index -= chunkSize;
-        id key = keyList[index];
-        id<FLLRBNode> childTree = [self buildBalancedTree:keyList dictionary:dictionary subArrayStartIndex:startIndex length:(chunkSize - 1)];
-        id<FLLRBNode> pennant = [[FLLRBValueNode alloc] initWithKey:key withValue:dictionary[key] withColor:color withLeft:nil withRight:childTree];
+        id<FLLRBNode> childTree = [self buildBalancedTree:keyList values:values subArrayStartIndex:startIndex length:(chunkSize - 1)];
+        id<FLLRBNode> pennant = [[FLLRBValueNode alloc] initWithKey:keyList[index] withValue:values[index] withColor:color withLeft:nil withRight:childTree];
         //attachPennant(pennant);
         if (node) {
             node.left = pennant;
@@ -287,9 +285,24 @@ void base1_2List_free(Base1_2List* list) {
  */
 
 + (FImmutableSortedDictionary *)fromDictionary:(NSDictionary *)dictionary withComparator:(NSComparator)comparator
+{
+    NSMutableArray *sortedKeyList = [NSMutableArray arrayWithCapacity:dictionary.count];
+    [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
+        [sortedKeyList addObject:key];
+    }];
+    [sortedKeyList sortUsingComparator:comparator];
+
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:sortedKeyList.count];
+    for (id key in sortedKeyList) {
+        [values addObject:dictionary[key]];
+    }
+    return [self fromSortedKeys:sortedKeyList values:values withComparator:comparator];
+}
+
++ (FImmutableSortedDictionary *)fromSortedKeys:(NSArray *)keys values:(NSArray *)values withComparator:(NSComparator)comparator
 {
     // Steps:
-    // 0. Sort the array
+    // 0. Check the keys are strictly ascending
     // 1. Calculate the 1-2 number
     // 2. Build From 1-2 number
     //   0. for each digit in 1-2 number
@@ -297,22 +310,16 @@ void base1_2List_free(Base1_2List* list) {
     //     1. build 1 or 2 pennants of that size
     //     2. attach pennants and update node pointer
     //   1. return root
-    NSMutableArray *sortedKeyList = [NSMutableArray arrayWithCapacity:dictionary.count];
-    [dictionary enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-        [sortedKeyList addObject:key];
-    }];
-    [sortedKeyList sortUsingComparator:comparator];
-
-    [sortedKeyList enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
+    [keys enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
         if (idx > 0) {
-            if (comparator(sortedKeyList[idx - 1], obj) != NSOrderedAscending) {
+            if (comparator(keys[idx - 1], obj) != NSOrderedAscending) {
                 [NSException raise:NSInvalidArgumentException format:@"Can't create FImmutableSortedDictionary with keys with same ordering!"];
             }
         }
     }];
 
-    Base1_2List* list = base1_2List_new((unsigned int)sortedKeyList.count);
-    id<FLLRBNode> root = [self rootFrom12List:list keyList:sortedKeyList dictionary:dictionary];
+    Base1_2List* list = base1_2List_new((unsigned int)keys.count);
+    id<FLLRBNode> root = [self rootFrom12List:list keyList:keys values:values];
     base1_2List_free(list);
 
     if (root != nil) {
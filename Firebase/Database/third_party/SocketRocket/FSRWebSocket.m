@@ -257,6 +257,7 @@ typedef void (^data_callback)(FSRWebSocket *webSocket,  NSData *data);
     BOOL _consumerStopped;
 
     BOOL _closeWhenFinishedWriting;
+    BOOL _pumpWritingScheduled;
     BOOL _failed;
 
     BOOL _secure;
@@ -733,7 +734,16 @@ static __strong NSData *CRLFCRLF;
             return;
     }
     [_outputBuffer appendData:data];
-    [self _pumpWriting];
+
+    // Frames sent in a burst are queued on the work queue one after another, so pumping once they
+    // have all been appended writes them to the stream together instead of one write per frame.
+    if (!_pumpWritingScheduled) {
+        _pumpWritingScheduled = YES;
+        dispatch_async(_workQueue, ^{
+            self->_pumpWritingScheduled = NO;
+            [self _pumpWriting];
+        });
+    }
 }
 - (void)send:(id)data;
 {
@@ -18,6 +18,7 @@
 #import <FirebaseCore/FIRLogger.h>
 
 #import "FIRCore+InAppMessaging.h"
+#import "FIRIAMImageCache.h"
 #import "FIRIAMMessageContentData.h"
 #import "FIRIAMMessageContentDataWithImageURL.h"
 #import "FIRIAMSDKRuntimeErrorCodes.h"
@@ -148,6 +149,31 @@ static NSInteger const SuccessHTTPStatusCode = 200;
 
 - (void)fetchImageFromURL:(NSURL *)imageURL
                 withBlock:(void (^)(NSData *_Nullable imageData, NSError *_Nullable error))block {
+  FIRIAMImageCache *imageCache = self.imageCache;
+  if (!imageCache) {
+    [self downloadImageFromURL:imageURL withBlock:block];
+    return;
+  }
+
+  [imageCache
+      loadImageDataForURL:imageURL
+               completion:^(NSData *_Nullable cachedData) {
+                 if (cachedData) {
+                   block(cachedData, nil);
+                   return;
+                 }
+                 [self downloadImageFromURL:imageURL
+                                  withBlock:^(NSData *_Nullable imageData, NSError *_Nullable error) {
+                                    if (imageData) {
+                                      [imageCache storeImageData:imageData forURL:imageURL];
+                                    }
+                                    block(imageData, error);
+                                  }];
+               }];
+}
+
+- (void)downloadImageFromURL:(NSURL *)imageURL
+                   withBlock:(void (^)(NSData *_Nullable imageData, NSError *_Nullable error))block {
   NSURLRequest *imageDataRequest = [NSURLRequest requestWithURL:imageURL];
   NSURLSessionDataTask *task = [_URLSession
       dataTaskWithRequest:imageDataRequest
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2020 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <CommonCrypto/CommonDigest.h>
+#import <FirebaseCore/FIRLogger.h>
+
+#import "FIRCore+InAppMessaging.h"
+#import "FIRIAMImageCache.h"
+#import "FIRIAMMessageContentData.h"
+#import "FIRIAMMessageDefinition.h"
+
+static NSUInteger const kMaxMemoryBytes = 10 * 1024 * 1024;
+static NSUInteger const kMaxDiskBytes = 20 * 1024 * 1024;
+// Messages are listed in display priority order, so only the first ones are worth prefetching.
+static NSUInteger const kMaxPrefetchedMessages = 10;
+static NSInteger const SuccessHTTPStatusCode = 200;
+
+// Returns the file name under which the image at the URL is cached.
+static NSString *FIRIAMImageCacheKeyForURL(NSURL *URL) {
+  NSData *URLData = [URL.absoluteString dataUsingEncoding:NSUTF8StringEncoding];
+  unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+  CC_SHA256(URLData.bytes, (CC_LONG)URLData.length, digest);
+
+  NSMutableString *key = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+  for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+    [key appendFormat:@"%02x", digest[i]];
+  }
+  return key;
+}
+
+@interface FIRIAMImageCache ()
+@property(nonatomic, readonly) NSString *cacheDirectory;
+@property(nonatomic, readonly) NSUInteger maxDiskBytes;
+@property(nonatomic, readonly) NSCache<NSString *, NSData *> *memoryCache;
+@property(nonatomic, readonly) NSURLSession *prefetchURLSession;
+// serial queue for all the disk reads and writes
+@property(nonatomic, readonly) dispatch_queue_t diskQueue;
+// URLs being prefetched, guarded by synchronizing on self
+@property(nonatomic, readonly) NSMutableSet<NSURL *> *pendingPrefetchURLs;
+@end
+
+@implementation FIRIAMImageCache
+
++ (instancetype)sharedCache {
+  static FIRIAMImageCache *sharedCache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSString *cachesDirectory =
+        NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES).firstObject;
+
+    // Prefetching is opportunistic, so it shouldn't spend the user's cellular data.
+    NSURLSessionConfiguration *configuration =
+        [NSURLSessionConfiguration defaultSessionConfiguration];
+    configuration.allowsCellularAccess = NO;
+
+    sharedCache = [[FIRIAMImageCache alloc]
+        initWithCacheDirectory:[cachesDirectory stringByAppendingPathComponent:@"google-fiam-images"]
+                maxMemoryBytes:kMaxMemoryBytes
+                  maxDiskBytes:kMaxDiskBytes
+            prefetchURLSession:[NSURLSession sessionWithConfiguration:configuration]];
+  });
+  return sharedCache;
+}
+
+- (instancetype)initWithCacheDirectory:(NSString *)cacheDirectory
+                        maxMemoryBytes:(NSUInteger)maxMemoryBytes
+                          maxDiskBytes:(NSUInteger)maxDiskBytes
+                   prefetchURLSession:(NSURLSession *)prefetchURLSession {
+  if (self = [super init]) {
+    _cacheDirectory = [cacheDirectory copy];
+    _maxDiskBytes = maxDiskBytes;
+    _memoryCache = [[NSCache alloc] init];
+    _memoryCache.totalCostLimit = maxMemoryBytes;
+    _prefetchURLSession = prefetchURLSession;
+    _diskQueue =
+        dispatch_queue_create("com.google.firebase.inappmessaging.imagecache", DISPATCH_QUEUE_SERIAL);
+    _pendingPrefetchURLs = [[NSMutableSet alloc] init];
+  }
+  return self;
+}
+
+- (NSString *)filePathForKey:(NSString *)key {
+  return [self.cacheDirectory stringByAppendingPathComponent:key];
+}
+
+- (void)loadImageDataForURL:(NSURL *)URL completion:(void (^)(NSData *_Nullable data))completion {
+  NSString *key = FIRIAMImageCacheKeyForURL(URL);
+  NSData *data = [self.memoryCache objectForKey:key];
+  if (data) {
+    completion(data);
+    return;
+  }
+
+  dispatch_async(self.diskQueue, ^{
+    NSString *filePath = [self filePathForKey:key];
+    NSData *diskData = [NSData dataWithContentsOfFile:filePath];
+    if (diskData) {
+      // mark the image as recently used so that trimming the disk cache keeps it
+      [[NSFileManager defaultManager] setAttributes:@{NSFileModificationDate : [NSDate date]}
+                                       ofItemAtPath:filePath
+                                              error:nil];
+      [self.memoryCache setObject:diskData forKey:key cost:diskData.length];
+    }
+    completion(diskData);
+  });
+}
+
+- (void)storeImageData:(NSData *)data forURL:(NSURL *)URL {
+  NSString *key = FIRIAMImageCacheKeyForURL(URL);
+  [self.memoryCache setObject:data forKey:key cost:data.length];
+
+  dispatch_async(self.diskQueue, ^{
+    NSError *error;
+    if (![[NSFileManager defaultManager] createDirectoryAtPath:self.cacheDirectory
+                                   withIntermediateDirectories:YES
+                                                    attributes:nil
+                                                         error:&error] ||
+        ![data writeToFile:[self filePathForKey:key] options:NSDataWritingAtomic error:&error]) {
+      FIRLogWarning(kFIRLoggerInAppMessaging, @"I-IAM320001",
+                    @"Failed to write image for URL %@ to the disk cache: %@", URL, error);
+      return;
+    }
+    [self trimDiskCache];
+  });
+}
+
+// Deletes the least recently used images until the disk cache fits in its bound. Must be called
+// on the disk queue.
+- (void)trimDiskCache {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  NSArray<NSURLResourceKey> *resourceKeys =
+      @[ NSURLContentModificationDateKey, NSURLTotalFileAllocatedSizeKey ];
+  NSArray<NSURL *> *files =
+      [fileManager contentsOfDirectoryAtURL:[NSURL fileURLWithPath:self.cacheDirectory]
+                 includingPropertiesForKeys:resourceKeys
+                                    options:NSDirectoryEnumerationSkipsHiddenFiles
+                                      error:nil];
+
+  NSUInteger totalBytes = 0;
+  for (NSURL *file in files) {
+    NSNumber *fileBytes;
+    [file getResourceValue:&fileBytes forKey:NSURLTotalFileAllocatedSizeKey error:nil];
+    totalBytes += fileBytes.unsignedIntegerValue;
+  }
+  if (totalBytes <= self.maxDiskBytes) {
+    return;
+  }
+
+  NSArray<NSURL *> *sortedFiles = [files
+      sortedArrayUsingComparator:^NSComparisonResult(NSURL *file1, NSURL *file2) {
+        NSDate *date1, *date2;
+        [file1 getResourceValue:&date1 forKey:NSURLContentModificationDateKey error:nil];
+        [file2 getResourceValue:&date2 forKey:NSURLContentModificationDateKey error:nil];
+        return [date1 compare:date2];
+      }];
+  for (NSURL *file in sortedFiles) {
+    if (totalBytes <= self.maxDiskBytes) {
+      break;
+    }
+    NSNumber *fileBytes;
+    [file getResourceValue:&fileBytes forKey:NSURLTotalFileAllocatedSizeKey error:nil];
+    if ([fileManager removeItemAtURL:file error:nil]) {
+      totalBytes -= MIN(totalBytes, fileBytes.unsignedIntegerValue);
+    }
+  }
+  FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM320002",
+              @"Trimmed the image disk cache to %lu bytes", (unsigned long)totalBytes);
+}
+
+- (void)prefetchImagesForMessages:(NSArray<FIRIAMMessageDefinition *> *)messages {
+  NSUInteger prefetchedMessages = 0;
+  for (FIRIAMMessageDefinition *message in messages) {
+    if (prefetchedMessages >= kMaxPrefetchedMessages) {
+      break;
+    }
+    if ([message messageHasExpired]) {
+      continue;
+    }
+    prefetchedMessages++;
+
+    id<FIRIAMMessageContentData> contentData = message.renderData.contentData;
+    if (contentData.imageURL) {
+      [self prefetchImageFromURL:contentData.imageURL];
+    }
+    if (contentData.landscapeImageURL) {
+      [self prefetchImageFromURL:contentData.landscapeImageURL];
+    }
+  }
+}
+
+- (void)prefetchImageFromURL:(NSURL *)URL {
+  @synchronized(self) {
+    if ([self.pendingPrefetchURLs containsObject:URL]) {
+      return;
+    }
+    [self.pendingPrefetchURLs addObject:URL];
+  }
+
+  [self loadImageDataForURL:URL
+                 completion:^(NSData *_Nullable cachedData) {
+                   if (cachedData) {
+                     [self finishPrefetchFromURL:URL];
+                     return;
+                   }
+
+                   NSURLSessionDataTask *task = [self.prefetchURLSession
+                         dataTaskWithURL:URL
+                       completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+                         [self finishPrefetchFromURL:URL];
+                         if (data && [FIRIAMImageCache isImageResponse:response]) {
+                           [self storeImageData:data forURL:URL];
+                         } else {
+                           FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM320003",
+                                       @"Skipped prefetching image from %@, error: %@", URL,
+                                       error);
+                         }
+                       }];
+                   // Images fetched for display should go first.
+                   task.priority = NSURLSessionTaskPriorityLow;
+                   [task resume];
+                 }];
+}
+
+- (void)finishPrefetchFromURL:(NSURL *)URL {
+  @synchronized(self) {
+    [self.pendingPrefetchURLs removeObject:URL];
+  }
+}
+
++ (BOOL)isImageResponse:(NSURLResponse *)response {
+  if (![response isKindOfClass:[NSHTTPURLResponse class]]) {
+    return NO;
+  }
+  NSHTTPURLResponse *httpResponse = (NSHTTPURLResponse *)response;
+  return httpResponse.statusCode == SuccessHTTPStatusCode &&
+         [httpResponse.MIMEType hasPrefix:@"image"];
+}
+
+- (void)removeAllImages {
+  [self.memoryCache removeAllObjects];
+  dispatch_sync(self.diskQueue, ^{
+    [[NSFileManager defaultManager] removeItemAtPath:self.cacheDirectory error:nil];
+  });
+}
+@end
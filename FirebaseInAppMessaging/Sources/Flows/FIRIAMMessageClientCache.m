@@ -20,7 +20,9 @@
 #import "FIRIAMDisplayCheckOnAnalyticEventsFlow.h"
 #import "FIRIAMDisplayTriggerDefinition.h"
 #import "FIRIAMFetchResponseParser.h"
+#import "FIRIAMImageCache.h"
 #import "FIRIAMMessageClientCache.h"
+#import "FIRIAMMessageContentDataWithImageURL.h"
 #import "FIRIAMServerMsgFetchStorage.h"
 
 @interface FIRIAMMessageClientCache ()
@@ -83,6 +85,8 @@
     [self setupAnalyticsEventListening];
   }
 
+  [self prefetchImagesForMessages:messages];
+
   FIRLogDebug(kFIRLoggerInAppMessaging, @"I-IAM160001",
               @"There are %lu test messages and %lu regular messages and "
                "%lu Firebase Analytics events to watch after "
@@ -92,6 +96,27 @@
   [self.observer dataChanged];
 }
 
+// attaches the image cache to the messages and starts downloading their images in the background,
+// test messages first since they are displayed first
+- (void)prefetchImagesForMessages:(NSArray<FIRIAMMessageDefinition *> *)messages {
+  FIRIAMImageCache *imageCache = self.imageCache;
+  if (!imageCache) {
+    return;
+  }
+
+  NSArray<FIRIAMMessageDefinition *> *messagesToPrefetch;
+  @synchronized(self) {
+    messagesToPrefetch = [self.testMessages arrayByAddingObjectsFromArray:self.regularMessages];
+  }
+  for (FIRIAMMessageDefinition *message in messages) {
+    id contentData = message.renderData.contentData;
+    if ([contentData isKindOfClass:[FIRIAMMessageContentDataWithImageURL class]]) {
+      ((FIRIAMMessageContentDataWithImageURL *)contentData).imageCache = imageCache;
+    }
+  }
+  [imageCache prefetchImagesForMessages:messagesToPrefetch];
+}
+
 // triggered after self.messages are updated so that we can correctly enable/disable listening
 // on analytics event based on current fiam message set
 - (void)setupAnalyticsEventListening {
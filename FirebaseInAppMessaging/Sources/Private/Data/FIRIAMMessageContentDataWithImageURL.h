@@ -18,6 +18,8 @@
 
 #import "FIRIAMMessageContentData.h"
 
+@class FIRIAMImageCache;
+
 NS_ASSUME_NONNULL_BEGIN
 /**
  * An implementation for protocol FIRIAMMessageContentData. This class takes a image url
@@ -46,5 +48,8 @@ NS_ASSUME_NONNULL_BEGIN
                             imageURL:(nullable NSURL *)imageURL
                    landscapeImageURL:(nullable NSURL *)landscapeImageURL
                      usingURLSession:(nullable NSURLSession *)URLSession;
+
+// If set, images are looked up in this cache before being downloaded, and stored in it after.
+@property(nonatomic, nullable) FIRIAMImageCache *imageCache;
 @end
 NS_ASSUME_NONNULL_END
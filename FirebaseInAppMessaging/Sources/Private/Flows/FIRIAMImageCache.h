@@ -0,0 +1,55 @@
+/*
+ * Copyright 2020 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class FIRIAMMessageDefinition;
+
+NS_ASSUME_NONNULL_BEGIN
+
+// A bounded cache of message image data, kept in memory and on disk, so that a message's images
+// are usually already on the device when its display trigger fires.
+//
+// Images are prefetched in the background when messages are fetched, over Wi-Fi only. Images
+// requested at display time are stored too, so that messages shown again don't download their
+// images again. The least recently used images are evicted once either bound is exceeded.
+@interface FIRIAMImageCache : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+- (instancetype)initWithCacheDirectory:(NSString *)cacheDirectory
+                        maxMemoryBytes:(NSUInteger)maxMemoryBytes
+                          maxDiskBytes:(NSUInteger)maxDiskBytes
+                   prefetchURLSession:(NSURLSession *)prefetchURLSession NS_DESIGNATED_INITIALIZER;
+
+// The cache shared by the SDK components, stored in the app's caches directory.
++ (instancetype)sharedCache;
+
+// Looks up the image data for the URL. The completion is called right away for images held in
+// memory, and otherwise on a background queue after reading the disk cache. The data is nil if
+// the image isn't cached.
+- (void)loadImageDataForURL:(NSURL *)URL completion:(void (^)(NSData *_Nullable data))completion;
+
+// Stores the image data for the URL in memory, and writes it to disk in the background.
+- (void)storeImageData:(NSData *)data forURL:(NSURL *)URL;
+
+// Downloads the images of the messages that haven't expired and aren't cached yet, in the
+// background and over Wi-Fi only.
+- (void)prefetchImagesForMessages:(NSArray<FIRIAMMessageDefinition *> *)messages;
+
+// Removes all the images from memory and disk.
+- (void)removeAllImages;
+@end
+NS_ASSUME_NONNULL_END
@@ -21,6 +21,7 @@
 
 NS_ASSUME_NONNULL_BEGIN
 
+@class FIRIAMImageCache;
 @class FIRIAMServerMsgFetchStorage;
 @class FIRIAMDisplayCheckOnAnalyticEventsFlow;
 
@@ -57,6 +58,10 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic, weak, nullable)
     FIRIAMDisplayCheckOnAnalyticEventsFlow *analycisEventDislayCheckFlow;
 
+// if set, the images of messages are prefetched into this cache whenever the messages are reset,
+// and loaded from it when the messages are displayed
+@property(nonatomic, nullable) FIRIAMImageCache *imageCache;
+
 - (instancetype)init NS_UNAVAILABLE;
 - (instancetype)initWithBookkeeper:(id<FIRIAMBookKeeper>)bookKeeper
                usingResponseParser:(FIRIAMFetchResponseParser *)responseParser;
@@ -31,6 +31,7 @@
 #import "FIRIAMDisplayExecutor.h"
 #import "FIRIAMFetchOnAppForegroundFlow.h"
 #import "FIRIAMFetchResponseParser.h"
+#import "FIRIAMImageCache.h"
 #import "FIRIAMMessageClientCache.h"
 #import "FIRIAMMsgFetcherUsingRestful.h"
 #import "FIRIAMRuntimeManager.h"
@@ -263,6 +264,7 @@ static NSString *const kFirebaseInAppMessagingAutoDataCollectionKey =
 
   self.messageCache = [[FIRIAMMessageClientCache alloc] initWithBookkeeper:self.bookKeeper
                                                        usingResponseParser:self.responseParser];
+  self.messageCache.imageCache = [FIRIAMImageCache sharedCache];
   self.fetchResultStorage = [[FIRIAMServerMsgFetchStorage alloc] init];
 
   self.clientInfoFetcher = [[FIRIAMClientInfoFetcher alloc]
@@ -19,6 +19,7 @@
 
 #import "FIRIAMDisplayCheckOnAnalyticEventsFlow.h"
 #import "FIRIAMDisplayTriggerDefinition.h"
+#import "FIRIAMImageCache.h"
 #import "FIRIAMMessageClientCache.h"
 #import "FIRIAMMessageContentDataWithImageURL.h"
 #import "FIRIAMMessageDefinition.h"
@@ -176,6 +177,22 @@
   XCTAssert([self.clientCache.firebaseAnalyticEventsToWatch containsObject:@"second_event"]);
 }
 
+- (void)testResetMessagesPrefetchesRemainingMessageImages {
+  NSArray<NSString *> *impressionList = @[ @"m1" ];
+  OCMStub([self.mockBookkeeper getMessageIDsFromImpressions]).andReturn(impressionList);
+  FIRIAMImageCache *mockImageCache = OCMClassMock(FIRIAMImageCache.class);
+  self.clientCache.imageCache = mockImageCache;
+
+  // m1 has been impressed, so its images are not needed anymore
+  OCMExpect([mockImageCache prefetchImagesForMessages:@[ m2, m3 ]]);
+  [self.clientCache setMessageData:@[ m1, m2, m3 ]];
+  OCMVerifyAll((id)mockImageCache);
+
+  FIRIAMMessageContentDataWithImageURL *contentData =
+      (FIRIAMMessageContentDataWithImageURL *)m2.renderData.contentData;
+  XCTAssertEqual(contentData.imageCache, mockImageCache);
+}
+
 - (void)testNextOnAppOpenDisplayMsg_ok {
   OCMStub([self.mockBookkeeper getImpressions]).andReturn(@[]);
   // m1 and m3 are messages rendered on app open
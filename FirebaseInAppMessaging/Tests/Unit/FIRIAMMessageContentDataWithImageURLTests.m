@@ -16,6 +16,7 @@
 
 #import <OCMock/OCMock.h>
 #import <XCTest/XCTest.h>
+#import "FIRIAMImageCache.h"
 #import "FIRIAMMessageContentDataWithImageURL.h"
 
 static NSString *defaultTitle = @"Message Title";
@@ -424,4 +425,45 @@ typedef void (^ImageFetchExpectationsBlock)(NSData *, NSData *, NSError *);
   [self waitForExpectationsWithTimeout:5.0 handler:nil];
 }
 
+- (void)testLoadingCachedImageSkipsTheNetwork {
+  NSString *cacheDirectory =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+  FIRIAMImageCache *imageCache =
+      [[FIRIAMImageCache alloc] initWithCacheDirectory:cacheDirectory
+                                        maxMemoryBytes:1024
+                                          maxDiskBytes:1024
+                                    prefetchURLSession:self.mockedNSURLSession];
+  NSData *imageData = [@"image data" dataUsingEncoding:NSUTF8StringEncoding];
+  [imageCache storeImageData:imageData forURL:[NSURL URLWithString:defaultImageURL]];
+
+  FIRIAMMessageContentDataWithImageURL *portraitOnlyContentData =
+      [[FIRIAMMessageContentDataWithImageURL alloc]
+               initWithMessageTitle:defaultTitle
+                        messageBody:defaultBody
+                   actionButtonText:defaultActionButtonText
+          secondaryActionButtonText:defaultSecondaryActionButtonText
+                          actionURL:[NSURL URLWithString:defaultActionURL]
+                 secondaryActionURL:[NSURL URLWithString:defaultSecondaryActionURL]
+                           imageURL:[NSURL URLWithString:defaultImageURL]
+                  landscapeImageURL:nil
+                    usingURLSession:_mockedNSURLSession];
+  portraitOnlyContentData.imageCache = imageCache;
+
+  OCMReject([self.mockedNSURLSession dataTaskWithRequest:[OCMArg any]
+                                       completionHandler:[OCMArg any]]);
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"image loaded from cache"];
+  [portraitOnlyContentData
+      loadImageDataWithBlock:^(NSData *_Nullable loadedImageData,
+                               NSData *_Nullable landscapeImageData, NSError *error) {
+        XCTAssertEqualObjects(loadedImageData, imageData);
+        XCTAssertNil(landscapeImageData);
+        XCTAssertNil(error);
+        [expectation fulfill];
+      }];
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+
+  [imageCache removeAllImages];
+}
 @end
+
@@ -130,12 +130,8 @@ static const NSTimeInterval kDatabaseLoadTimeoutSecs = 30.0;
       break;
   }
 
-  // Completely wipe out DB first.
-  [_DBManager deleteRecordFromMainTableWithNamespace:FIRNamespace
-                                    bundleIdentifier:_bundleIdentifier
-                                          fromSource:DBSource];
-
   toDict[FIRNamespace] = [[NSMutableDictionary alloc] init];
+  NSMutableArray<NSArray *> *rows = [[NSMutableArray alloc] init];
   NSDictionary *config = fromDict[FIRNamespace];
   for (NSString *key in config) {
     if (DBSource == FIRRemoteConfigSourceDefault) {
@@ -158,16 +154,17 @@ static const NSTimeInterval kDatabaseLoadTimeoutSecs = 30.0;
       }
       toDict[FIRNamespace][key] = [[FIRRemoteConfigValue alloc] initWithData:valueData
                                                                       source:source];
-      NSArray *values = @[ _bundleIdentifier, FIRNamespace, key, valueData ];
-      [self updateMainTableWithValues:values fromSource:DBSource];
+      [rows addObject:@[ _bundleIdentifier, FIRNamespace, key, valueData ]];
     } else {
       FIRRemoteConfigValue *value = config[key];
       toDict[FIRNamespace][key] = [[FIRRemoteConfigValue alloc] initWithData:value.dataValue
                                                                       source:source];
-      NSArray *values = @[ _bundleIdentifier, FIRNamespace, key, value.dataValue ];
-      [self updateMainTableWithValues:values fromSource:DBSource];
+      [rows addObject:@[ _bundleIdentifier, FIRNamespace, key, value.dataValue ]];
     }
   }
+
+  // Completely wipe out the namespace in DB and write the new values in one transaction.
+  [self replaceMainTableNamespace:FIRNamespace withValuesArray:rows fromSource:DBSource];
 }
 
 - (void)updateConfigContentWithResponse:(NSDictionary *)response
@@ -241,10 +238,6 @@ static const NSTimeInterval kDatabaseLoadTimeoutSecs = 30.0;
                                 withEntries:(NSDictionary *)entries {
   FIRLogDebug(kFIRLoggerRemoteConfig, @"I-RCN000058", @"Update config in DB for namespace:%@",
               currentNamespace);
-  // Clear before updating
-  [_DBManager deleteRecordFromMainTableWithNamespace:currentNamespace
-                                    bundleIdentifier:_bundleIdentifier
-                                          fromSource:RCNDBSourceFetched];
   if ([_fetchedConfig objectForKey:currentNamespace]) {
     [_fetchedConfig[currentNamespace] removeAllObjects];
   } else {
@@ -252,6 +245,7 @@ static const NSTimeInterval kDatabaseLoadTimeoutSecs = 30.0;
   }
 
   // Store the fetched config values.
+  NSMutableArray<NSArray *> *rows = [[NSMutableArray alloc] init];
   for (NSString *key in entries) {
     NSData *valueData = [entries[key] dataUsingEncoding:NSUTF8StringEncoding];
     if (!valueData) {
@@ -259,9 +253,12 @@ static const NSTimeInterval kDatabaseLoadTimeoutSecs = 30.0;
     }
     _fetchedConfig[currentNamespace][key] =
         [[FIRRemoteConfigValue alloc] initWithData:valueData source:FIRRemoteConfigSourceRemote];
-    NSArray *values = @[ _bundleIdentifier, currentNamespace, key, valueData ];
-    [self updateMainTableWithValues:values fromSource:RCNDBSourceFetched];
+    [rows addObject:@[ _bundleIdentifier, currentNamespace, key, valueData ]];
   }
+  // Clear the namespace and write the new values in one transaction.
+  [self replaceMainTableNamespace:currentNamespace
+                  withValuesArray:rows
+                       fromSource:RCNDBSourceFetched];
 }
 
 #pragma mark - database
@@ -287,11 +284,17 @@ static const NSTimeInterval kDatabaseLoadTimeoutSecs = 30.0;
                  }];
 }
 
-/// Update the current config result to main table.
-/// @param values Values in a row to write to the table.
+/// Replace the config of a namespace in main table.
+/// @param rows   Values of the rows to write to the table.
 /// @param source The source the config data is coming from. It determines which table to write to.
-- (void)updateMainTableWithValues:(NSArray *)values fromSource:(RCNDBSource)source {
-  [_DBManager insertMainTableWithValues:values fromSource:source completionHandler:nil];
+- (void)replaceMainTableNamespace:(NSString *)FIRNamespace
+                  withValuesArray:(NSArray<NSArray *> *)rows
+                       fromSource:(RCNDBSource)source {
+  [_DBManager replaceMainTableNamespace:FIRNamespace
+                       bundleIdentifier:_bundleIdentifier
+                        withValuesArray:rows
+                             fromSource:source
+                      completionHandler:nil];
 }
 #pragma mark - getter/setter
 - (NSDictionary *)fetchedConfig {
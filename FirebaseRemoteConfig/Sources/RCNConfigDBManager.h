@@ -84,6 +84,21 @@ typedef void (^RCNDBLoadCompletion)(BOOL success,
 - (void)insertMainTableWithValues:(NSArray *)values
                        fromSource:(RCNDBSource)source
                 completionHandler:(RCNDBCompletion)handler;
+/// Insert records in main table in a single transaction.
+/// @param rows    Rows to be inserted, each with the values of `insertMainTableWithValues:`.
+/// @param handler The callback.
+- (void)insertMainTableWithValuesArray:(NSArray<NSArray *> *)rows
+                            fromSource:(RCNDBSource)source
+                     completionHandler:(RCNDBCompletion)handler;
+/// Replace the records of given namespace and package name in main table with the given rows, in
+/// a single transaction.
+/// @param rows    Rows to be inserted, each with the values of `insertMainTableWithValues:`.
+/// @param handler The callback.
+- (void)replaceMainTableNamespace:(NSString *)namespace_p
+                 bundleIdentifier:(NSString *)bundleIdentifier
+                  withValuesArray:(NSArray<NSArray *> *)rows
+                       fromSource:(RCNDBSource)source
+                completionHandler:(RCNDBCompletion)handler;
 /// Insert a record in internal metadata table.
 /// @param values Values to be inserted.
 - (void)insertInternalMetadataTableWithValues:(NSArray *)values
@@ -101,6 +101,40 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
   ];
 }
 
+/// Returns the SQL that inserts a row into the main table of the given source.
+static const char *RemoteConfigMainTableInsertSQL(RCNDBSource source) {
+  if (source == RCNDBSourceDefault) {
+    return "INSERT INTO " RCNTableNameMainDefault
+           " (bundle_identifier, namespace, key, value) values (?, ?, ?, ?)";
+  } else if (source == RCNDBSourceActive) {
+    return "INSERT INTO " RCNTableNameMainActive
+           " (bundle_identifier, namespace, key, value) values (?, ?, ?, ?)";
+  }
+  return "INSERT INTO " RCNTableNameMain
+         " (bundle_identifier, namespace, key, value) values (?, ?, ?, ?)";
+}
+
+/// Returns the SQL that deletes a namespace from the main table of the given source.
+static const char *RemoteConfigMainTableDeleteSQL(RCNDBSource source) {
+  if (source == RCNDBSourceDefault) {
+    return "DELETE FROM " RCNTableNameMainDefault " WHERE bundle_identifier = ? and namespace = ?";
+  } else if (source == RCNDBSourceActive) {
+    return "DELETE FROM " RCNTableNameMainActive " WHERE bundle_identifier = ? and namespace = ?";
+  }
+  return "DELETE FROM " RCNTableNameMain " WHERE bundle_identifier = ? and namespace = ?";
+}
+
+/// Removes the write-ahead log and shared memory files SQLite keeps next to the database.
+static void RemoteConfigRemoveJournalFilesOfDatabase(NSString *path) {
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  for (NSString *suffix in @[ @"-wal", @"-shm" ]) {
+    NSString *journalPath = [path stringByAppendingString:suffix];
+    if ([fileManager fileExistsAtPath:journalPath]) {
+      [fileManager removeItemAtPath:journalPath error:nil];
+    }
+  }
+}
+
 @interface RCNConfigDBManager () {
   /// Database storing all the config information.
   sqlite3 *_database;
@@ -213,6 +247,7 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
     int flags = SQLITE_OPEN_CREATE | SQLITE_OPEN_READWRITE | SQLITE_OPEN_FILEPROTECTION_COMPLETE |
                 SQLITE_OPEN_FULLMUTEX;
     if (sqlite3_open_v2(databasePath, &strongSelf->_database, flags, NULL) == SQLITE_OK) {
+      [strongSelf enableWriteAheadLogging];
       // Always try to create table if not exists for backward compatibility.
       if (![strongSelf createTableSchema]) {
         // Remove database before fail.
@@ -223,6 +258,7 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
           return;
         }
         if (sqlite3_open_v2(databasePath, &strongSelf->_database, flags, NULL) == SQLITE_OK) {
+          [strongSelf enableWriteAheadLogging];
           if (![strongSelf createTableSchema]) {
             // Remove database before fail.
             [strongSelf removeDatabase:dbPath];
@@ -248,6 +284,18 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
   });
 }
 
+/// Switches the database to write-ahead logging, so that writes append to a log instead of
+/// rewriting the database pages, and readers don't wait on writers. Config can always be fetched
+/// again, so commits only need to survive app crashes, not power loss.
+- (void)enableWriteAheadLogging {
+  RCN_MUST_NOT_BE_MAIN_THREAD();
+  if (![self executeQuery:"PRAGMA journal_mode=WAL"] ||
+      ![self executeQuery:"PRAGMA synchronous=NORMAL"]) {
+    FIRLogWarning(kFIRLoggerRemoteConfig, @"I-RCN000075",
+                  @"Failed to enable write-ahead logging, using the default journal.");
+  }
+}
+
 - (BOOL)createTableSchema {
   RCN_MUST_NOT_BE_MAIN_THREAD();
   static const char *createTableMain =
@@ -300,6 +348,7 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
       FIRLogError(kFIRLoggerRemoteConfig, @"I-RCN000011",
                   @"Failed to remove database at path %@ for error %@.", path, error);
     }
+    RemoteConfigRemoveJournalFilesOfDatabase(path);
   });
 }
 
@@ -315,6 +364,7 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
     FIRLogError(kFIRLoggerRemoteConfig, @"I-RCN000011",
                 @"Failed to remove database at path %@ for error %@.", path, error);
   }
+  RemoteConfigRemoveJournalFilesOfDatabase(path);
 }
 
 #pragma mark - execute
@@ -329,6 +379,20 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
   return YES;
 }
 
+/// Runs `block` in a single transaction, which is committed if the block returns YES and rolled
+/// back otherwise.
+- (BOOL)executeInTransaction:(BOOL (^)(void))block {
+  RCN_MUST_NOT_BE_MAIN_THREAD();
+  if (![self executeQuery:"BEGIN IMMEDIATE TRANSACTION"]) {
+    return NO;
+  }
+  if (!block() || ![self executeQuery:"COMMIT TRANSACTION"]) {
+    [self executeQuery:"ROLLBACK TRANSACTION"];
+    return NO;
+  }
+  return YES;
+}
+
 #pragma mark - insert
 - (void)insertMetadataTableWithValues:(NSDictionary *)columnNameToValue
                     completionHandler:(RCNDBCompletion)handler {
@@ -408,47 +472,85 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
 }
 
 - (BOOL)insertMainTableWithValues:(NSArray *)values fromSource:(RCNDBSource)source {
-  RCN_MUST_NOT_BE_MAIN_THREAD();
-  if (values.count != 4) {
-    FIRLogError(kFIRLoggerRemoteConfig, @"I-RCN000013",
-                @"Failed to insert config record. Wrong number of give parameters, current "
-                @"number is %ld, correct number is 4.",
-                (long)values.count);
-    return NO;
-  }
-  const char *SQL = "INSERT INTO " RCNTableNameMain
-                    " (bundle_identifier, namespace, key, value) values (?, ?, ?, ?)";
-  if (source == RCNDBSourceDefault) {
-    SQL = "INSERT INTO " RCNTableNameMainDefault
-          " (bundle_identifier, namespace, key, value) values (?, ?, ?, ?)";
-  } else if (source == RCNDBSourceActive) {
-    SQL = "INSERT INTO " RCNTableNameMainActive
-          " (bundle_identifier, namespace, key, value) values (?, ?, ?, ?)";
-  }
+  return [self insertMainTableWithValuesArray:@[ values ] fromSource:source];
+}
+
+- (void)insertMainTableWithValuesArray:(NSArray<NSArray *> *)rows
+                            fromSource:(RCNDBSource)source
+                     completionHandler:(RCNDBCompletion)handler {
+  __weak RCNConfigDBManager *weakSelf = self;
+  dispatch_async(_databaseOperationQueue, ^{
+    RCNConfigDBManager *strongSelf = weakSelf;
+    BOOL success = [strongSelf executeInTransaction:^BOOL {
+      return [strongSelf insertMainTableWithValuesArray:rows fromSource:source];
+    }];
+    if (handler) {
+      dispatch_async(dispatch_get_main_queue(), ^{
+        handler(success, nil);
+      });
+    }
+  });
+}
 
+- (void)replaceMainTableNamespace:(NSString *)namespace_p
+                 bundleIdentifier:(NSString *)bundleIdentifier
+                  withValuesArray:(NSArray<NSArray *> *)rows
+                       fromSource:(RCNDBSource)source
+                completionHandler:(RCNDBCompletion)handler {
+  __weak RCNConfigDBManager *weakSelf = self;
+  dispatch_async(_databaseOperationQueue, ^{
+    RCNConfigDBManager *strongSelf = weakSelf;
+    BOOL success = [strongSelf executeInTransaction:^BOOL {
+      return [strongSelf executeQuery:RemoteConfigMainTableDeleteSQL(source)
+                           withParams:@[ bundleIdentifier, namespace_p ]] &&
+             [strongSelf insertMainTableWithValuesArray:rows fromSource:source];
+    }];
+    if (handler) {
+      dispatch_async(dispatch_get_main_queue(), ^{
+        handler(success, nil);
+      });
+    }
+  });
+}
+
+/// Inserts the rows with a single prepared statement, which is reset and rebound for each row.
+- (BOOL)insertMainTableWithValuesArray:(NSArray<NSArray *> *)rows
+                            fromSource:(RCNDBSource)source {
+  RCN_MUST_NOT_BE_MAIN_THREAD();
+  const char *SQL = RemoteConfigMainTableInsertSQL(source);
   sqlite3_stmt *statement = [self prepareSQL:SQL];
   if (!statement) {
     return NO;
   }
 
-  NSString *aString = values[0];
-  if (![self bindStringToStatement:statement index:1 string:aString]) {
-    return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
-  }
-  aString = values[1];
-  if (![self bindStringToStatement:statement index:2 string:aString]) {
-    return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
-  }
-  aString = values[2];
-  if (![self bindStringToStatement:statement index:3 string:aString]) {
-    return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
-  }
-  NSData *blobData = values[3];
-  if (sqlite3_bind_blob(statement, 4, blobData.bytes, (int)blobData.length, NULL) != SQLITE_OK) {
-    return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
-  }
-  if (sqlite3_step(statement) != SQLITE_DONE) {
-    return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
+  for (NSArray *values in rows) {
+    if (values.count != 4) {
+      FIRLogError(kFIRLoggerRemoteConfig, @"I-RCN000013",
+                  @"Failed to insert config record. Wrong number of give parameters, current "
+                  @"number is %ld, correct number is 4.",
+                  (long)values.count);
+      sqlite3_finalize(statement);
+      return NO;
+    }
+    // Bind directly rather than with bindStringToStatement:, which finalizes the statement on
+    // failure.
+    for (int index = 0; index < 3; index++) {
+      NSString *aString = values[index];
+      if (sqlite3_bind_text(statement, index + 1, aString.UTF8String, -1, SQLITE_TRANSIENT) !=
+          SQLITE_OK) {
+        return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
+      }
+    }
+    NSData *blobData = values[3];
+    if (sqlite3_bind_blob(statement, 4, blobData.bytes, (int)blobData.length, NULL) !=
+        SQLITE_OK) {
+      return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
+    }
+    if (sqlite3_step(statement) != SQLITE_DONE) {
+      return [self logErrorWithSQL:SQL finalizeStatement:statement returnValue:NO];
+    }
+    sqlite3_reset(statement);
+    sqlite3_clear_bindings(statement);
   }
   sqlite3_finalize(statement);
   return YES;
@@ -909,14 +1011,7 @@ static NSArray *RemoteConfigMetadataTableColumnsInOrder() {
       return;
     }
     NSArray *params = @[ bundleIdentifier, namespace_p ];
-    const char *SQL =
-        "DELETE FROM " RCNTableNameMain " WHERE bundle_identifier = ? and namespace = ?";
-    if (source == RCNDBSourceDefault) {
-      SQL = "DELETE FROM " RCNTableNameMainDefault " WHERE bundle_identifier = ? and namespace = ?";
-    } else if (source == RCNDBSourceActive) {
-      SQL = "DELETE FROM " RCNTableNameMainActive " WHERE bundle_identifier = ? and namespace = ?";
-    }
-    [strongSelf executeQuery:SQL withParams:params];
+    [strongSelf executeQuery:RemoteConfigMainTableDeleteSQL(source) withParams:params];
   });
 }
 
@@ -154,6 +154,55 @@
                                }];
 }
 
+- (void)testReplaceAndLoadMainTableResult {
+  XCTestExpectation *loadConfigContentExpectation =
+      [self expectationWithDescription:@"Replace a namespace in main table in one transaction"];
+  NSString *namespace_p = @"namespace_replace";
+  NSString *bundleIdentifier = [NSBundle mainBundle].bundleIdentifier;
+
+  NSArray *staleValues = @[
+    bundleIdentifier, namespace_p, @"stale_key", [@"stale" dataUsingEncoding:NSUTF8StringEncoding]
+  ];
+  [_DBManager insertMainTableWithValues:staleValues
+                             fromSource:RCNDBSourceActive
+                      completionHandler:nil];
+
+  NSMutableArray<NSArray *> *rows = [[NSMutableArray alloc] init];
+  for (int i = 0; i < 2000; ++i) {
+    NSString *value = [NSString stringWithFormat:@"value%d", i];
+    NSString *key = [NSString stringWithFormat:@"key%d", i];
+    [rows addObject:@[
+      bundleIdentifier, namespace_p, key, [value dataUsingEncoding:NSUTF8StringEncoding]
+    ]];
+  }
+  [_DBManager
+      replaceMainTableNamespace:namespace_p
+               bundleIdentifier:bundleIdentifier
+                withValuesArray:rows
+                     fromSource:RCNDBSourceActive
+              completionHandler:^(BOOL success, NSDictionary *result) {
+                XCTAssertTrue(success);
+                [self->_DBManager
+                    loadMainWithBundleIdentifier:bundleIdentifier
+                               completionHandler:^(BOOL loadSuccess, NSDictionary *fetchedConfig,
+                                                   NSDictionary *activeConfig,
+                                                   NSDictionary *defaultConfig) {
+                                 XCTAssertTrue(loadSuccess);
+                                 XCTAssertEqual([activeConfig[namespace_p] count], 2000U);
+                                 XCTAssertNil(activeConfig[namespace_p][@"stale_key"]);
+                                 FIRRemoteConfigValue *value =
+                                     activeConfig[namespace_p][@"key1999"];
+                                 XCTAssertEqualObjects(value.stringValue, @"value1999");
+                                 [loadConfigContentExpectation fulfill];
+                               }];
+              }];
+
+  [self waitForExpectationsWithTimeout:_expectionTimeout
+                               handler:^(NSError *error) {
+                                 XCTAssertNil(error);
+                               }];
+}
+
 - (void)testWriteAndLoadInternalMetadataResult {
   XCTestExpectation *loadConfigContentExpectation = [self
       expectationWithDescription:@"Write and read internal metadata in database successfully"];
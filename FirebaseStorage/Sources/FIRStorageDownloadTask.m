@@ -17,6 +17,7 @@
 #import "FirebaseStorage/Sources/FIRStorageConstants_Private.h"
 #import "FirebaseStorage/Sources/FIRStorageDownloadTask_Private.h"
 #import "FirebaseStorage/Sources/FIRStorageObservableTask_Private.h"
+#import "FirebaseStorage/Sources/FIRStorageReference_Private.h"
 #import "FirebaseStorage/Sources/FIRStorageTask_Private.h"
 
 @implementation FIRStorageDownloadTask
@@ -77,6 +78,10 @@
       FIRStorageDownloadTask *strong = weakSelf;
       if (strong && data) {
         strong->_downloadData = data;
+        // Keep file downloads resumable across app launches.
+        if (strong->_fileURL && strong.state != FIRStorageTaskStateCancelled) {
+          [strong.reference setDownloadResumeData:data forFile:strong->_fileURL];
+        }
       }
     }];
 
@@ -128,6 +133,10 @@
       // Download completed successfully, fire completion callbacks
       self.state = FIRStorageTaskStateSuccess;
 
+      if (self->_fileURL) {
+        [self.reference setDownloadResumeData:nil forFile:self->_fileURL];
+      }
+
       if (data) {
         self->_downloadData = data;
       }
@@ -157,6 +166,11 @@
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStateCancelled;
     [weakSelf.fetcher stopFetching];
+    // A cancelled download is not meant to be resumed.
+    NSURL *fileURL = weakSelf.fileURL;
+    if (fileURL) {
+      [weakSelf.reference setDownloadResumeData:nil forFile:fileURL];
+    }
     weakSelf.error = error;
     [weakSelf fireHandlersForStatus:FIRStorageTaskStatusFailure snapshot:weakSelf.snapshot];
   }];
@@ -48,6 +48,12 @@ NS_ASSUME_NONNULL_BEGIN
                     dispatchQueue:(dispatch_queue_t)queue
                              file:(nullable NSURL *)fileURL;
 
+/**
+ * Starts the download task, resuming from the given resume data if any.
+ * @param resumeData Resume data from an earlier, interrupted download of the same object.
+ */
+- (void)enqueueWithData:(nullable NSData *)resumeData;
+
 /**
  * Cancels the download task and passes an appropriate error to the developer.
  * @param error NSError to propegate to the developer.
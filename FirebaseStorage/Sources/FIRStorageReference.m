@@ -34,6 +34,8 @@
 #import <FirebaseCore/FIRApp.h>
 #import <FirebaseCore/FIROptions.h>
 
+#import <CommonCrypto/CommonDigest.h>
+
 #import <GTMSessionFetcher/GTMSessionFetcher.h>
 #import <GTMSessionFetcher/GTMSessionFetcherService.h>
 
@@ -320,7 +322,7 @@
                   });
                 }];
   }
-  [task enqueue];
+  [task enqueueWithData:[self downloadResumeDataForFile:fileURL]];
   return task;
 }
 
@@ -333,6 +335,66 @@
   [task enqueue];
 }
 
+#pragma mark - Download Resume Data
+
+// Keys of the dictionary saved for an interrupted download.
+static NSString *const kFIRStorageResumeReferenceKey = @"reference";
+static NSString *const kFIRStorageResumeFileKey = @"file";
+static NSString *const kFIRStorageResumeDataKey = @"resumeData";
+
+/**
+ * The file holding the resume data of a download of this object to the given file. The name is a
+ * digest of both, and the saved dictionary records them in full to rule out collisions.
+ */
+- (NSURL *)downloadResumeDataURLForFile:(NSURL *)fileURL {
+  NSString *key = [NSString stringWithFormat:@"%@\n%@", [self stringValue], fileURL.absoluteString];
+  NSData *keyData = [key dataUsingEncoding:NSUTF8StringEncoding];
+  unsigned char digest[CC_SHA256_DIGEST_LENGTH];
+  CC_SHA256(keyData.bytes, (CC_LONG)keyData.length, digest);
+  NSMutableString *name = [NSMutableString stringWithCapacity:CC_SHA256_DIGEST_LENGTH * 2];
+  for (int i = 0; i < CC_SHA256_DIGEST_LENGTH; i++) {
+    [name appendFormat:@"%02x", digest[i]];
+  }
+
+  NSURL *cachesURL = [[NSFileManager defaultManager] URLsForDirectory:NSCachesDirectory
+                                                            inDomains:NSUserDomainMask]
+                         .firstObject;
+  NSURL *directoryURL = [cachesURL URLByAppendingPathComponent:@"FIRStorageDownloads"
+                                                   isDirectory:YES];
+  return [directoryURL URLByAppendingPathComponent:name];
+}
+
+- (nullable NSData *)downloadResumeDataForFile:(NSURL *)fileURL {
+  NSDictionary *saved =
+      [NSDictionary dictionaryWithContentsOfURL:[self downloadResumeDataURLForFile:fileURL]];
+  if (![saved[kFIRStorageResumeReferenceKey] isEqual:[self stringValue]] ||
+      ![saved[kFIRStorageResumeFileKey] isEqual:fileURL.absoluteString]) {
+    return nil;
+  }
+  NSData *resumeData = saved[kFIRStorageResumeDataKey];
+  return [resumeData isKindOfClass:[NSData class]] ? resumeData : nil;
+}
+
+- (void)setDownloadResumeData:(nullable NSData *)resumeData forFile:(NSURL *)fileURL {
+  NSURL *resumeDataURL = [self downloadResumeDataURLForFile:fileURL];
+  NSFileManager *fileManager = [NSFileManager defaultManager];
+  if (!resumeData) {
+    [fileManager removeItemAtURL:resumeDataURL error:NULL];
+    return;
+  }
+
+  [fileManager createDirectoryAtURL:[resumeDataURL URLByDeletingLastPathComponent]
+        withIntermediateDirectories:YES
+                         attributes:nil
+                              error:NULL];
+  NSDictionary *saved = @{
+    kFIRStorageResumeReferenceKey : [self stringValue],
+    kFIRStorageResumeFileKey : fileURL.absoluteString,
+    kFIRStorageResumeDataKey : resumeData
+  };
+  [saved writeToURL:resumeDataURL atomically:YES];
+}
+
 #pragma mark - List
 
 - (void)listWithMaxResults:(int64_t)maxResults completion:(FIRStorageVoidListError)completion {
@@ -34,6 +34,21 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSString *)stringValue;
 
+/**
+ * Returns the resume data saved by an interrupted download of this object to the given file, so
+ * the download can continue where it stopped, even after the app was relaunched.
+ * @param fileURL The file the object was being downloaded to.
+ * @return The saved resume data, or nil if there is none.
+ */
+- (nullable NSData *)downloadResumeDataForFile:(NSURL *)fileURL;
+
+/**
+ * Saves the resume data of an interrupted download of this object to the given file.
+ * @param resumeData The resume data to save, or nil to remove any saved resume data.
+ * @param fileURL The file the object is being downloaded to.
+ */
+- (void)setDownloadResumeData:(nullable NSData *)resumeData forFile:(NSURL *)fileURL;
+
 @end
 
 NS_ASSUME_NONNULL_END
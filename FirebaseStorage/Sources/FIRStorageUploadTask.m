@@ -22,7 +22,24 @@
 
 #import <GTMSessionFetcher/GTMSessionUploadFetcher.h>
 
-@implementation FIRStorageUploadTask
+// Resumable uploads must send chunks in multiples of this size, except for the last one.
+static const int64_t kFIRStorageUploadChunkGranularity = 256 * 1024;
+
+// The chunk size used until the throughput has been measured.
+static const int64_t kFIRStorageUploadInitialChunkSize = 4 * 1024 * 1024;
+
+// The bounds of the adaptive chunk size.
+static const int64_t kFIRStorageUploadMinimumChunkSize = kFIRStorageUploadChunkGranularity;
+static const int64_t kFIRStorageUploadMaximumChunkSize = 64 * 1024 * 1024;
+
+// The time each chunk should take to send at the measured throughput.
+static const double kFIRStorageUploadTargetChunkSeconds = 8.0;
+
+@implementation FIRStorageUploadTask {
+  // The total bytes sent and the time when the current chunk started, to measure throughput.
+  int64_t _chunkStartBytes;
+  CFAbsoluteTime _chunkStartTime;
+}
 
 @synthesize progress = _progress;
 @synthesize fetcherCompletion = _fetcherCompletion;
@@ -65,6 +82,18 @@
   return self;
 }
 
++ (int64_t)chunkSizeForThroughput:(double)bytesPerSecond {
+  double targetSize = bytesPerSecond * kFIRStorageUploadTargetChunkSeconds;
+  if (!(targetSize > kFIRStorageUploadMinimumChunkSize)) {
+    return kFIRStorageUploadMinimumChunkSize;
+  }
+  if (targetSize >= kFIRStorageUploadMaximumChunkSize) {
+    return kFIRStorageUploadMaximumChunkSize;
+  }
+  int64_t granules = (int64_t)(targetSize / kFIRStorageUploadChunkGranularity);
+  return granules * kFIRStorageUploadChunkGranularity;
+}
+
 - (void)dealloc {
   [_uploadFetcher stopFetching];
 }
@@ -113,7 +142,7 @@
     GTMSessionUploadFetcher *uploadFetcher =
         [GTMSessionUploadFetcher uploadFetcherWithRequest:request
                                            uploadMIMEType:strongSelf->_uploadMetadata.contentType
-                                                chunkSize:kGTMSessionUploadFetcherStandardChunkSize
+                                                chunkSize:kFIRStorageUploadInitialChunkSize
                                            fetcherService:self.fetcherService];
 
     if (strongSelf->_uploadData) {
@@ -128,6 +157,7 @@
 
     [uploadFetcher setSendProgressBlock:^(int64_t bytesSent, int64_t totalBytesSent,
                                           int64_t totalBytesExpectedToSend) {
+      [weakSelf adaptChunkSizeWithTotalBytesSent:totalBytesSent];
       weakSelf.state = FIRStorageTaskStateProgress;
       weakSelf.progress.completedUnitCount = totalBytesSent;
       weakSelf.progress.totalUnitCount = totalBytesExpectedToSend;
@@ -137,6 +167,8 @@
     }];
 
     strongSelf->_uploadFetcher = uploadFetcher;
+    strongSelf->_chunkStartBytes = 0;
+    strongSelf->_chunkStartTime = CFAbsoluteTimeGetCurrent();
 
     // Process fetches
     strongSelf.state = FIRStorageTaskStateRunning;
@@ -214,6 +246,24 @@
   return YES;
 }
 
+/**
+ * Resizes the next chunk once the current one has been sent, based on how fast it went.
+ */
+- (void)adaptChunkSizeWithTotalBytesSent:(int64_t)totalBytesSent {
+  GTMSessionUploadFetcher *uploadFetcher = self.uploadFetcher;
+  int64_t chunkBytesSent = totalBytesSent - _chunkStartBytes;
+  if (chunkBytesSent < uploadFetcher.chunkSize) {
+    return;
+  }
+  CFAbsoluteTime now = CFAbsoluteTimeGetCurrent();
+  CFTimeInterval elapsed = now - _chunkStartTime;
+  if (elapsed > 0) {
+    uploadFetcher.chunkSize = [[self class] chunkSizeForThroughput:chunkBytesSent / elapsed];
+  }
+  _chunkStartBytes = totalBytesSent;
+  _chunkStartTime = now;
+}
+
 #pragma mark - Upload Management
 
 - (void)cancel {
@@ -248,6 +298,11 @@
 
   [self dispatchAsync:^() {
     weakSelf.state = FIRStorageTaskStateResuming;
+    // Time spent paused shouldn't count against the throughput of the current chunk.
+    FIRStorageUploadTask *strongSelf = weakSelf;
+    if (strongSelf) {
+      strongSelf->_chunkStartTime = CFAbsoluteTimeGetCurrent();
+    }
     [weakSelf.uploadFetcher resumeFetching];
     if (weakSelf.state != FIRStorageTaskStateSuccess) {
       weakSelf.metadata = weakSelf.uploadMetadata;
@@ -40,6 +40,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(strong, atomic) GTMSessionUploadFetcher *uploadFetcher;
 
+/**
+ * Returns the chunk size to use for the next chunk of an upload, given the throughput measured
+ * while sending the previous one. Chunks are sized to take about the same time to send, so fast
+ * networks make fewer requests and slow ones resend less after a failure.
+ * @param bytesPerSecond The measured upload throughput.
+ * @return A chunk size that is a multiple of 256 KiB, as resumable uploads require.
+ */
++ (int64_t)chunkSizeForThroughput:(double)bytesPerSecond;
+
 /**
  * Initializes an upload task with a base FIRStorageReference and GTMSessionFetcherService.
  * @param reference The base FIRStorageReference which fetchers use for configuration.
@@ -44,6 +44,22 @@
   [super tearDown];
 }
 
+- (void)testDownloadResumeDataIsSavedPerObjectAndFile {
+  FIRStorageReference *ref = [self.storage referenceForURL:@"gs://bucket/path/to/object"];
+  FIRStorageReference *otherRef = [self.storage referenceForURL:@"gs://bucket/path/to/other"];
+  NSURL *fileURL = [NSURL fileURLWithPath:NSTemporaryDirectory() isDirectory:YES];
+  fileURL = [fileURL URLByAppendingPathComponent:@"object"];
+  NSData *resumeData = [@"resume" dataUsingEncoding:NSUTF8StringEncoding];
+
+  [ref setDownloadResumeData:resumeData forFile:fileURL];
+  XCTAssertEqualObjects([ref downloadResumeDataForFile:fileURL], resumeData);
+  XCTAssertNil([otherRef downloadResumeDataForFile:fileURL]);
+  XCTAssertNil([ref downloadResumeDataForFile:[fileURL URLByAppendingPathExtension:@"copy"]]);
+
+  [ref setDownloadResumeData:nil forFile:fileURL];
+  XCTAssertNil([ref downloadResumeDataForFile:fileURL]);
+}
+
 - (void)testRoot {
   FIRStorageReference *ref = [self.storage referenceForURL:@"gs://bucket/path/to/object"];
   XCTAssertEqualObjects([ref.root stringValue], @"gs://bucket/");
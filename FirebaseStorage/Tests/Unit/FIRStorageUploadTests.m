@@ -0,0 +1,44 @@
+// Copyright 2020 Google
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#import "FIRStorageTestHelpers.h"
+#import "FirebaseStorage/Sources/FIRStorageUploadTask_Private.h"
+
+@interface FIRStorageUploadTests : XCTestCase
+
+@end
+
+@implementation FIRStorageUploadTests
+
+- (void)testChunkSizeIsAMultipleOfTheGranularity {
+  int64_t chunkSize = [FIRStorageUploadTask chunkSizeForThroughput:1000 * 1000];
+  XCTAssertEqual(chunkSize % (256 * 1024), 0);
+  XCTAssertLessThanOrEqual(chunkSize, 8 * 1000 * 1000);
+  XCTAssertGreaterThan(chunkSize, 8 * 1000 * 1000 - 256 * 1024);
+}
+
+- (void)testChunkSizeGrowsWithThroughput {
+  int64_t slowChunkSize = [FIRStorageUploadTask chunkSizeForThroughput:100 * 1024];
+  int64_t fastChunkSize = [FIRStorageUploadTask chunkSizeForThroughput:2 * 1024 * 1024];
+  XCTAssertLessThan(slowChunkSize, fastChunkSize);
+}
+
+- (void)testChunkSizeIsClamped {
+  XCTAssertEqual([FIRStorageUploadTask chunkSizeForThroughput:0], 256 * 1024);
+  XCTAssertEqual([FIRStorageUploadTask chunkSizeForThroughput:NAN], 256 * 1024);
+  XCTAssertEqual([FIRStorageUploadTask chunkSizeForThroughput:1024 * 1024 * 1024],
+                 64 * 1024 * 1024);
+}
+
+@end
@@ -88,6 +88,24 @@ NS_ASSUME_NONNULL_BEGIN
   XCTAssertNotEqual([foo hash], [fromCache hash]);
 }
 
+- (void)testDocumentsReturnStableSnapshots {
+  FIRQuerySnapshot *snapshot = FSTTestQuerySnapshot(
+      "foo", @{}, @{@"a" : @{@"a" : @1}, @"b" : @{@"b" : @2}}, false, false);
+  NSArray<FIRQueryDocumentSnapshot *> *documents = snapshot.documents;
+  XCTAssertEqual(documents.count, 2u);
+  XCTAssertEqual(snapshot.count, 2);
+
+  FIRQueryDocumentSnapshot *first = documents[0];
+  XCTAssertEqualObjects(first.documentID, @"a");
+  XCTAssertEqualObjects(first.data, @{@"a" : @1});
+  XCTAssertEqual(documents[0], first);
+  XCTAssertEqualObjects(documents[1].documentID, @"b");
+
+  XCTAssertEqual(snapshot.documents, documents);
+  XCTAssertEqualObjects([documents copy], documents);
+  XCTAssertThrows(documents[2]);
+}
+
 - (void)testIncludeMetadataChanges {
   Document doc1Old = Doc("foo/bar", 1, Map("a", "b"), DocumentState::kLocalMutations);
   Document doc1New = Doc("foo/bar", 1, Map("a", "b"), DocumentState::kSynced);
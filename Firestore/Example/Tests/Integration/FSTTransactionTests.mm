@@ -630,6 +630,39 @@ TransactionStage get = ^(FIRTransaction *transaction, FIRDocumentReference *doc)
   XCTAssertEqualObjects(snapshot[@"foo"], @"bar");
 }
 
+- (void)testGetsSeveralDocumentsAtOnce {
+  FIRFirestore *firestore = [self firestore];
+  FIRCollectionReference *collection = [firestore collectionWithPath:@"foo"];
+  FIRDocumentReference *doc1 = [collection documentWithPath:@"b"];
+  FIRDocumentReference *doc2 = [collection documentWithPath:@"a"];
+  FIRDocumentReference *missing = [collection documentWithPath:@"c"];
+
+  [self writeDocumentRef:doc1 data:@{@"value" : @1}];
+  [self writeDocumentRef:doc2 data:@{@"value" : @2}];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"transaction"];
+  [firestore
+      runTransactionWithBlock:^id _Nullable(FIRTransaction *transaction, NSError **error) {
+        NSArray<FIRDocumentSnapshot *> *snapshots =
+            [transaction getDocuments:@[ doc1, missing, doc2 ] error:error];
+        XCTAssertNil(*error);
+        XCTAssertEqual(snapshots.count, 3);
+        // Snapshots come back in the order of the references, not of the keys.
+        XCTAssertEqualObjects(snapshots[0][@"value"], @1);
+        XCTAssertFalse(snapshots[1].exists);
+        XCTAssertEqualObjects(snapshots[2][@"value"], @2);
+
+        [transaction updateData:@{@"value" : @3} forDocument:doc1];
+        return nil;
+      }
+      completion:^(id _Nullable result, NSError *_Nullable error) {
+        XCTAssertNil(error);
+        [expectation fulfill];
+      }];
+  [self awaitExpectations];
+  FIRDocumentSnapshot *snapshot = [self readDocumentForRef:doc1];
+  XCTAssertEqualObjects(snapshot[@"value"], @3);
+}
+
 - (void)testDoesNotRetryOnPermanentError {
   FIRFirestore *firestore = [self firestore];
   auto counter = std::make_shared<std::atomic_int>(0);
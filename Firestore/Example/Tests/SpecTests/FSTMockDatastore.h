@@ -64,15 +64,27 @@ class MockDatastore : public Datastore {
     ++write_stream_request_count_;
   }
 
-  /** Injects a WatchChange as though it had come from the backend. */
-  void WriteWatchChange(const WatchChange& change, const model::SnapshotVersion& snap);
+  /**
+   * Injects a WatchChange as though it had come from the backend on the watch stream with the
+   * given index, in the order the streams were created.
+   */
+  void WriteWatchChange(const WatchChange& change,
+                        const model::SnapshotVersion& snap,
+                        size_t stream_index = 0);
   /** Injects a stream failure as though it had come from the backend. */
-  void FailWatchStream(const util::Status& error);
-
-  /** Returns the set of active targets on the watch stream. */
-  const std::unordered_map<model::TargetId, local::TargetData>& ActiveTargets() const;
+  void FailWatchStream(const util::Status& error, size_t stream_index = 0);
+
+  /** Returns the set of active targets on all watch streams. */
+  std::unordered_map<model::TargetId, local::TargetData> ActiveTargets() const;
+  /** Returns the set of active targets on the watch stream with the given index. */
+  const std::unordered_map<model::TargetId, local::TargetData>& ActiveTargets(
+      size_t stream_index) const;
+  /** Returns the number of watch streams created by the remote store. */
+  size_t watch_stream_count() const {
+    return watch_streams_.size();
+  }
   /** Helper method to expose watch stream state to verify in tests. */
-  bool IsWatchStreamOpen() const;
+  bool IsWatchStreamOpen(size_t stream_index = 0) const;
 
   /**
    * Returns the next write that was "sent to the backend", failing if there are no queued sent
@@ -94,7 +106,7 @@ class MockDatastore : public Datastore {
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   std::shared_ptr<auth::CredentialsProvider> credentials_;
 
-  std::shared_ptr<MockWatchStream> watch_stream_;
+  std::vector<std::shared_ptr<MockWatchStream>> watch_streams_;
   std::shared_ptr<MockWriteStream> write_stream_;
 
   int watch_stream_request_count_ = 0;
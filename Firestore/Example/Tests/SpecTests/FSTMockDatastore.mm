@@ -251,11 +251,11 @@ MockDatastore::MockDatastore(const core::DatabaseInfo& database_info,
 }
 
 std::shared_ptr<WatchStream> MockDatastore::CreateWatchStream(WatchStreamCallback* callback) {
-  watch_stream_ = std::make_shared<MockWatchStream>(worker_queue_, credentials_,
-                                                    Serializer{database_info_->database_id()},
-                                                    grpc_connection(), callback, this);
+  watch_streams_.push_back(std::make_shared<MockWatchStream>(
+      worker_queue_, credentials_, Serializer{database_info_->database_id()}, grpc_connection(),
+      callback, this));
 
-  return watch_stream_;
+  return watch_streams_.back();
 }
 
 std::shared_ptr<WriteStream> MockDatastore::CreateWriteStream(WriteStreamCallback* callback) {
@@ -266,20 +266,31 @@ std::shared_ptr<WriteStream> MockDatastore::CreateWriteStream(WriteStreamCallbac
   return write_stream_;
 }
 
-void MockDatastore::WriteWatchChange(const WatchChange& change, const SnapshotVersion& snap) {
-  watch_stream_->WriteWatchChange(change, snap);
+void MockDatastore::WriteWatchChange(const WatchChange& change,
+                                     const SnapshotVersion& snap,
+                                     size_t stream_index) {
+  watch_streams_.at(stream_index)->WriteWatchChange(change, snap);
 }
 
-void MockDatastore::FailWatchStream(const Status& error) {
-  watch_stream_->FailStream(error);
+void MockDatastore::FailWatchStream(const Status& error, size_t stream_index) {
+  watch_streams_.at(stream_index)->FailStream(error);
+}
+
+std::unordered_map<TargetId, TargetData> MockDatastore::ActiveTargets() const {
+  std::unordered_map<TargetId, TargetData> active_targets;
+  for (const auto& stream : watch_streams_) {
+    active_targets.insert(stream->ActiveTargets().begin(), stream->ActiveTargets().end());
+  }
+  return active_targets;
 }
 
-const std::unordered_map<TargetId, TargetData>& MockDatastore::ActiveTargets() const {
-  return watch_stream_->ActiveTargets();
+const std::unordered_map<TargetId, TargetData>& MockDatastore::ActiveTargets(
+    size_t stream_index) const {
+  return watch_streams_.at(stream_index)->ActiveTargets();
 }
 
-bool MockDatastore::IsWatchStreamOpen() const {
-  return watch_stream_->IsOpen();
+bool MockDatastore::IsWatchStreamOpen(size_t stream_index) const {
+  return watch_streams_.at(stream_index)->IsOpen();
 }
 
 std::vector<Mutation> MockDatastore::NextSentWrite() {
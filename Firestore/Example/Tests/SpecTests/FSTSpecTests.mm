@@ -82,6 +82,7 @@ using firebase::firestore::model::MaybeDocument;
 using firebase::firestore::model::MutationResult;
 using firebase::firestore::model::NoDocument;
 using firebase::firestore::model::ObjectValue;
+using firebase::firestore::model::OnlineState;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
@@ -150,6 +151,10 @@ ByteString MakeResumeToken(NSString *specString) {
 
 @implementation FSTSpecTests {
   BOOL _gcEnabled;
+  BOOL _containedQueriesServedLocally;
+  BOOL _writeCompactionEnabled;
+  int _watchStreamCount;
+  int _maxConcurrentLimboResolutions;
   BOOL _networkEnabled;
   FSTUserDataConverter *_converter;
 }
@@ -185,8 +190,22 @@ ByteString MakeResumeToken(NSString *specString) {
   if (numClients) {
     XCTAssertEqualObjects(numClients, @1, @"The iOS client does not support multi-client tests");
   }
+  _containedQueriesServedLocally = [config[@"containedQueriesServedLocally"] boolValue];
+  _writeCompactionEnabled = [config[@"writeCompaction"] boolValue];
+  NSNumber *watchStreamCount = config[@"watchStreamCount"];
+  _watchStreamCount = watchStreamCount ? [watchStreamCount intValue] : 1;
+  _maxConcurrentLimboResolutions = [config[@"maxConcurrentLimboResolutions"] intValue];
   std::unique_ptr<Persistence> persistence = [self persistenceWithGCEnabled:_gcEnabled];
-  self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:std::move(persistence)];
+  self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:std::move(persistence)
+                                                    watchStreamCount:_watchStreamCount];
+  [self startDriver];
+}
+
+/** Applies the settings of the spec's config to the driver and starts it. */
+- (void)startDriver {
+  [self.driver setContainedQueriesServedLocally:_containedQueriesServedLocally];
+  [self.driver setWriteCompactionEnabled:_writeCompactionEnabled];
+  [self.driver setMaxConcurrentLimboResolutions:_maxConcurrentLimboResolutions];
   [self.driver start];
 }
 
@@ -258,6 +277,16 @@ ByteString MakeResumeToken(NSString *specString) {
   return testutil::Version(version.longLongValue);
 }
 
+- (OnlineState)parseOnlineState:(NSString *)onlineState {
+  if ([onlineState isEqualToString:@"Online"]) {
+    return OnlineState::Online;
+  } else if ([onlineState isEqualToString:@"Offline"]) {
+    return OnlineState::Offline;
+  }
+  XCTAssertEqualObjects(onlineState, @"Unknown");
+  return OnlineState::Unknown;
+}
+
 - (DocumentViewChange)parseChange:(NSDictionary *)jsonDoc ofType:(DocumentViewChange::Type)type {
   NSNumber *version = jsonDoc[@"version"];
   NSDictionary *options = jsonDoc[@"options"];
@@ -493,14 +522,18 @@ ByteString MakeResumeToken(NSString *specString) {
   std::unique_ptr<Persistence> persistence = [self persistenceWithGCEnabled:_gcEnabled];
   self.driver = [[FSTSyncEngineTestDriver alloc] initWithPersistence:std::move(persistence)
                                                          initialUser:currentUser
-                                                   outstandingWrites:outstandingWrites];
-  [self.driver start];
+                                                   outstandingWrites:outstandingWrites
+                                                    watchStreamCount:_watchStreamCount];
+  [self startDriver];
 }
 
 - (void)doStep:(NSDictionary *)step {
   NSNumber *clientIndex = step[@"clientIndex"];
   XCTAssertNil(clientIndex, @"The iOS client does not support switching clients");
 
+  // Watch steps go to the first watch stream unless they name another one.
+  self.driver.watchStreamIndex = [step[@"watchStream"] intValue];
+
   if (step[@"userListen"]) {
     [self doListen:step[@"userListen"]];
   } else if (step[@"userUnlisten"]) {
@@ -652,6 +685,14 @@ ByteString MakeResumeToken(NSString *specString) {
       XCTAssertEqual([self.driver watchStreamRequestCount],
                      [expectedState[@"watchStreamRequestCount"] intValue]);
     }
+    if (expectedState[@"watchStreamTargets"]) {
+      XCTAssertEqualObjects([self.driver activeTargetIDsByWatchStream],
+                            expectedState[@"watchStreamTargets"]);
+    }
+    if (expectedState[@"onlineState"]) {
+      XCTAssertEqual([self.driver onlineState],
+                     [self parseOnlineState:expectedState[@"onlineState"]]);
+    }
     if (expectedState[@"limboDocs"]) {
       DocumentKeySet expectedLimboDocuments;
       NSArray *docNames = expectedState[@"limboDocs"];
@@ -661,6 +702,13 @@ ByteString MakeResumeToken(NSString *specString) {
       // Update the expected limbo documents
       [self.driver setExpectedLimboDocuments:std::move(expectedLimboDocuments)];
     }
+    if (expectedState[@"enqueuedLimboDocs"]) {
+      NSMutableArray<NSString *> *enqueuedLimboDocs = [NSMutableArray array];
+      for (const DocumentKey &key : [self.driver enqueuedLimboDocuments]) {
+        [enqueuedLimboDocs addObject:util::MakeNSString(key.ToString())];
+      }
+      XCTAssertEqualObjects(enqueuedLimboDocs, expectedState[@"enqueuedLimboDocs"]);
+    }
     if (expectedState[@"activeTargets"]) {
       __block ActiveTargetMap expectedActiveTargets;
       [expectedState[@"activeTargets"]
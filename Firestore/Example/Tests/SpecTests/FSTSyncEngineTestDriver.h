@@ -86,6 +86,9 @@ NS_ASSUME_NONNULL_BEGIN
 /** The error - if any - of this write. */
 @property(nonatomic, strong, nullable, readwrite) NSError *error;
 
+/** The ID of the batch the write was added to, shared by writes compacted into one batch. */
+@property(nonatomic, assign, readwrite) model::BatchId batchID;
+
 @end
 
 /** Mapping of user => array of FSTMutations for that user. */
@@ -117,22 +120,40 @@ typedef std::unordered_map<auth::User, NSMutableArray<FSTOutstandingWrite *> *,
 
 /**
  * Initializes the underlying FSTSyncEngine with the given local persistence implementation and
- * garbage collection policy.
+ * number of watch streams.
  */
-- (instancetype)initWithPersistence:(std::unique_ptr<local::Persistence>)persistence;
+- (instancetype)initWithPersistence:(std::unique_ptr<local::Persistence>)persistence
+                   watchStreamCount:(int)watchStreamCount;
 
 /**
- * Initializes the underlying FSTSyncEngine with the given local persistence implementation and
+ * Initializes the underlying FSTSyncEngine with the given local persistence implementation,
  * a set of existing outstandingWrites (useful when your Persistence object has persisted
- * mutation queues).
+ * mutation queues) and number of watch streams.
  */
 - (instancetype)initWithPersistence:(std::unique_ptr<local::Persistence>)persistence
                         initialUser:(const auth::User &)initialUser
                   outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
-    NS_DESIGNATED_INITIALIZER;
+                   watchStreamCount:(int)watchStreamCount NS_DESIGNATED_INITIALIZER;
 
 - (instancetype)init NS_UNAVAILABLE;
 
+/**
+ * Sets whether queries contained in a synced query are served from its target. Must be called
+ * before start.
+ */
+- (void)setContainedQueriesServedLocally:(BOOL)enabled;
+
+/**
+ * Sets whether writes are compacted into the last pending batch. Must be called before start.
+ */
+- (void)setWriteCompactionEnabled:(BOOL)enabled;
+
+/**
+ * Sets how many limbo resolutions may be in flight at once, where 0 means no limit. Must be called
+ * before start.
+ */
+- (void)setMaxConcurrentLimboResolutions:(size_t)maxResolutions;
+
 /** Starts the FSTSyncEngine and its underlying components. */
 - (void)start;
 
@@ -177,6 +198,12 @@ typedef std::unordered_map<auth::User, NSMutableArray<FSTOutstandingWrite *> *,
 - (void)receiveWatchChange:(const remote::WatchChange &)change
            snapshotVersion:(const model::SnapshotVersion &)snapshot;
 
+/**
+ * The index of the watch stream that receives the watch changes and errors delivered next, in the
+ * order the remote store created its streams. Defaults to 0.
+ */
+@property(nonatomic, assign) int watchStreamIndex;
+
 /**
  * Delivers a watch stream error as if the Streaming Watch backend has generated some kind of error.
  *
@@ -292,6 +319,9 @@ typedef std::unordered_map<auth::User, NSMutableArray<FSTOutstandingWrite *> *,
 /** The current set of documents in limbo. */
 - (std::map<model::DocumentKey, model::TargetId>)currentLimboDocuments;
 
+/** The documents waiting for a limbo resolution to start, in the order they will start. */
+- (std::vector<model::DocumentKey>)enqueuedLimboDocuments;
+
 /** The expected set of documents in limbo. */
 - (const model::DocumentKeySet &)expectedLimboDocuments;
 
@@ -339,8 +369,14 @@ typedef std::unordered_map<auth::User, NSMutableArray<FSTOutstandingWrite *> *,
  */
 - (void)removeSnapshotsInSyncListener;
 
-/** The set of active targets as observed on the watch stream. */
-- (const std::unordered_map<model::TargetId, local::TargetData> &)activeTargets;
+/** The set of active targets as observed on all watch streams. */
+- (std::unordered_map<model::TargetId, local::TargetData>)activeTargets;
+
+/** The sorted IDs of the active targets on each watch stream. */
+- (NSArray<NSArray<NSNumber *> *> *)activeTargetIDsByWatchStream;
+
+/** The online state last reported by the remote store. */
+- (model::OnlineState)onlineState;
 
 /** The expected set of active targets, keyed by target ID. */
 - (const ActiveTargetMap &)expectedActiveTargets;
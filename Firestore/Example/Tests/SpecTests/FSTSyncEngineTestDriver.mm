@@ -40,6 +40,7 @@
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
@@ -56,6 +57,7 @@
 
 namespace testutil = firebase::firestore::testutil;
 
+using firebase::Timestamp;
 using firebase::firestore::Error;
 using firebase::firestore::auth::EmptyCredentialsProvider;
 using firebase::firestore::auth::HashUser;
@@ -72,10 +74,13 @@ using firebase::firestore::local::IndexFreeQueryEngine;
 using firebase::firestore::local::LocalStore;
 using firebase::firestore::local::Persistence;
 using firebase::firestore::local::TargetData;
+using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DatabaseId;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeySet;
+using firebase::firestore::model::kBatchIdUnknown;
 using firebase::firestore::model::Mutation;
+using firebase::firestore::model::MutationBatch;
 using firebase::firestore::model::MutationResult;
 using firebase::firestore::model::OnlineState;
 using firebase::firestore::model::SnapshotVersion;
@@ -186,17 +191,22 @@ NS_ASSUME_NONNULL_BEGIN
   IndexFreeQueryEngine _queryEngine;
 
   int _snapshotsInSyncEvents;
+
+  OnlineState _onlineState;
 }
 
-- (instancetype)initWithPersistence:(std::unique_ptr<Persistence>)persistence {
+- (instancetype)initWithPersistence:(std::unique_ptr<Persistence>)persistence
+                   watchStreamCount:(int)watchStreamCount {
   return [self initWithPersistence:std::move(persistence)
                        initialUser:User::Unauthenticated()
-                 outstandingWrites:{}];
+                 outstandingWrites:{}
+                  watchStreamCount:watchStreamCount];
 }
 
 - (instancetype)initWithPersistence:(std::unique_ptr<Persistence>)persistence
                         initialUser:(const User &)initialUser
-                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites {
+                  outstandingWrites:(const FSTOutstandingWriteQueues &)outstandingWrites
+                   watchStreamCount:(int)watchStreamCount {
   if (self = [super init]) {
     // Do a deep copy.
     for (const auto &pair : outstandingWrites) {
@@ -214,10 +224,14 @@ NS_ASSUME_NONNULL_BEGIN
 
     _datastore = std::make_shared<MockDatastore>(_databaseInfo, _workerQueue,
                                                  std::make_shared<EmptyCredentialsProvider>());
+    _onlineState = OnlineState::Unknown;
     _remoteStore = absl::make_unique<RemoteStore>(
         _localStore.get(), _datastore, _workerQueue,
-        [self](OnlineState onlineState) { _syncEngine->HandleOnlineStateChange(onlineState); });
-    ;
+        [self](OnlineState onlineState) {
+          _onlineState = onlineState;
+          _syncEngine->HandleOnlineStateChange(onlineState);
+        },
+        watchStreamCount);
 
     _syncEngine = absl::make_unique<SyncEngine>(_localStore.get(), _remoteStore.get(), initialUser);
     _remoteStore->set_sync_engine(_syncEngine.get());
@@ -287,6 +301,18 @@ NS_ASSUME_NONNULL_BEGIN
   return _snapshotsInSyncEvents;
 }
 
+- (void)setContainedQueriesServedLocally:(BOOL)enabled {
+  _syncEngine->SetContainedQueriesServedLocally(enabled);
+}
+
+- (void)setWriteCompactionEnabled:(BOOL)enabled {
+  _localStore->set_write_compaction_enabled(enabled);
+}
+
+- (void)setMaxConcurrentLimboResolutions:(size_t)maxResolutions {
+  _syncEngine->SetMaxConcurrentLimboResolutions(maxResolutions);
+}
+
 - (void)start {
   _workerQueue->EnqueueBlocking([&] {
     _localStore->Start();
@@ -437,9 +463,9 @@ NS_ASSUME_NONNULL_BEGIN
 - (void)writeUserMutation:(Mutation)mutation {
   FSTOutstandingWrite *write = [[FSTOutstandingWrite alloc] init];
   write.write = mutation;
-  [[self currentOutstandingWrites] addObject:write];
   LOG_DEBUG("sending a user write.");
-  _workerQueue->EnqueueBlocking([=] {
+  BatchId batchID = kBatchIdUnknown;
+  _workerQueue->EnqueueBlocking([&] {
     _syncEngine->WriteMutations({mutation}, [self, write, mutation](Status error) {
       LOG_DEBUG("A callback was called with error: %s", error.error_message());
       write.done = YES;
@@ -452,22 +478,34 @@ NS_ASSUME_NONNULL_BEGIN
         [self.acknowledgedDocs addObject:mutationKey];
       }
     });
+    batchID = _localStore->GetHighestUnacknowledgedBatchId();
   });
+  write.batchID = batchID;
+
+  FSTOutstandingWrite *lastWrite = [self currentOutstandingWrites].lastObject;
+  if (lastWrite && lastWrite.batchID == batchID) {
+    // The write was compacted into the last batch, so both are sent as one write.
+    MutationBatch batch(batchID, Timestamp::Now(), {}, {lastWrite.write});
+    lastWrite.write = batch.CompactWith({mutation})->mutations()[0];
+  } else {
+    [[self currentOutstandingWrites] addObject:write];
+  }
 }
 
 - (void)receiveWatchChange:(const WatchChange &)change
            snapshotVersion:(const SnapshotVersion &)snapshot {
-  _workerQueue->EnqueueBlocking([&] { _datastore->WriteWatchChange(change, snapshot); });
+  _workerQueue->EnqueueBlocking(
+      [&] { _datastore->WriteWatchChange(change, snapshot, self.watchStreamIndex); });
 }
 
 - (void)receiveWatchStreamError:(int)errorCode userInfo:(NSDictionary<NSString *, id> *)userInfo {
   Status error{static_cast<Error>(errorCode), MakeString([userInfo description])};
 
   _workerQueue->EnqueueBlocking([&] {
-    _datastore->FailWatchStream(error);
-    // Unlike web, stream should re-open synchronously (if we have any listeners)
-    if (!_queryListeners.empty()) {
-      HARD_ASSERT(_datastore->IsWatchStreamOpen(), "Watch stream is open");
+    _datastore->FailWatchStream(error, self.watchStreamIndex);
+    // Unlike web, stream should re-open synchronously (if it has any targets)
+    if (!_datastore->ActiveTargets(self.watchStreamIndex).empty()) {
+      HARD_ASSERT(_datastore->IsWatchStreamOpen(self.watchStreamIndex), "Watch stream is open");
     }
   });
 }
@@ -476,10 +514,30 @@ NS_ASSUME_NONNULL_BEGIN
   return _syncEngine->GetCurrentLimboDocuments();
 }
 
-- (const std::unordered_map<TargetId, TargetData> &)activeTargets {
+- (std::vector<DocumentKey>)enqueuedLimboDocuments {
+  return _syncEngine->GetEnqueuedLimboDocuments();
+}
+
+- (std::unordered_map<TargetId, TargetData>)activeTargets {
   return _datastore->ActiveTargets();
 }
 
+- (NSArray<NSArray<NSNumber *> *> *)activeTargetIDsByWatchStream {
+  NSMutableArray<NSArray<NSNumber *> *> *result = [NSMutableArray array];
+  for (size_t i = 0; i < _datastore->watch_stream_count(); ++i) {
+    NSMutableArray<NSNumber *> *targetIDs = [NSMutableArray array];
+    for (const auto &kv : _datastore->ActiveTargets(i)) {
+      [targetIDs addObject:@(kv.first)];
+    }
+    [result addObject:[targetIDs sortedArrayUsingSelector:@selector(compare:)]];
+  }
+  return result;
+}
+
+- (OnlineState)onlineState {
+  return _onlineState;
+}
+
 - (const ActiveTargetMap &)expectedActiveTargets {
   return _expectedActiveTargets;
 }
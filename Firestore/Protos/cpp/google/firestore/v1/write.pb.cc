@@ -32,6 +32,8 @@
 // @@protoc_insertion_point(includes)
 #include <google/protobuf/port_def.inc>
 extern PROTOBUF_INTERNAL_EXPORT_google_2ffirestore_2fv1_2fdocument_2eproto ::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<2> scc_info_ArrayValue_google_2ffirestore_2fv1_2fdocument_2eproto;
+extern PROTOBUF_INTERNAL_EXPORT_google_2ffirestore_2fv1_2fwrite_2eproto ::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<0> scc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto;
+extern PROTOBUF_INTERNAL_EXPORT_google_2ffirestore_2fv1_2fwrite_2eproto ::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<1> scc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto;
 extern PROTOBUF_INTERNAL_EXPORT_google_2ffirestore_2fv1_2fdocument_2eproto ::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<2> scc_info_Document_google_2ffirestore_2fv1_2fdocument_2eproto;
 extern PROTOBUF_INTERNAL_EXPORT_google_2ffirestore_2fv1_2fcommon_2eproto ::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<0> scc_info_DocumentMask_google_2ffirestore_2fv1_2fcommon_2eproto;
 extern PROTOBUF_INTERNAL_EXPORT_google_2ffirestore_2fv1_2fwrite_2eproto ::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<1> scc_info_DocumentTransform_google_2ffirestore_2fv1_2fwrite_2eproto;
@@ -83,9 +85,46 @@ class ExistenceFilterDefaultTypeInternal {
  public:
   ::PROTOBUF_NAMESPACE_ID::internal::ExplicitlyConstructed<ExistenceFilter> _instance;
 } _ExistenceFilter_default_instance_;
+class BitSequenceDefaultTypeInternal {
+ public:
+  ::PROTOBUF_NAMESPACE_ID::internal::ExplicitlyConstructed<BitSequence> _instance;
+} _BitSequence_default_instance_;
+class BloomFilterDefaultTypeInternal {
+ public:
+  ::PROTOBUF_NAMESPACE_ID::internal::ExplicitlyConstructed<BloomFilter> _instance;
+} _BloomFilter_default_instance_;
 }  // namespace v1
 }  // namespace firestore
 }  // namespace google
+static void InitDefaultsscc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto() {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  {
+    void* ptr = &::google::firestore::v1::_BitSequence_default_instance_;
+    new (ptr) ::google::firestore::v1::BitSequence();
+    ::PROTOBUF_NAMESPACE_ID::internal::OnShutdownDestroyMessage(ptr);
+  }
+  ::google::firestore::v1::BitSequence::InitAsDefaultInstance();
+}
+
+::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<0> scc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto =
+    {{ATOMIC_VAR_INIT(::PROTOBUF_NAMESPACE_ID::internal::SCCInfoBase::kUninitialized), 0, InitDefaultsscc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto}, {}};
+
+static void InitDefaultsscc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto() {
+  GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+  {
+    void* ptr = &::google::firestore::v1::_BloomFilter_default_instance_;
+    new (ptr) ::google::firestore::v1::BloomFilter();
+    ::PROTOBUF_NAMESPACE_ID::internal::OnShutdownDestroyMessage(ptr);
+  }
+  ::google::firestore::v1::BloomFilter::InitAsDefaultInstance();
+}
+
+::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<1> scc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto =
+    {{ATOMIC_VAR_INIT(::PROTOBUF_NAMESPACE_ID::internal::SCCInfoBase::kUninitialized), 1, InitDefaultsscc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto}, {
+      &scc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto.base,}};
+
 static void InitDefaultsscc_info_DocumentChange_google_2ffirestore_2fv1_2fwrite_2eproto() {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
@@ -172,8 +211,9 @@ static void InitDefaultsscc_info_ExistenceFilter_google_2ffirestore_2fv1_2fwrite
   ::google::firestore::v1::ExistenceFilter::InitAsDefaultInstance();
 }
 
-::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<0> scc_info_ExistenceFilter_google_2ffirestore_2fv1_2fwrite_2eproto =
-    {{ATOMIC_VAR_INIT(::PROTOBUF_NAMESPACE_ID::internal::SCCInfoBase::kUninitialized), 0, InitDefaultsscc_info_ExistenceFilter_google_2ffirestore_2fv1_2fwrite_2eproto}, {}};
+::PROTOBUF_NAMESPACE_ID::internal::SCCInfo<1> scc_info_ExistenceFilter_google_2ffirestore_2fv1_2fwrite_2eproto =
+    {{ATOMIC_VAR_INIT(::PROTOBUF_NAMESPACE_ID::internal::SCCInfoBase::kUninitialized), 1, InitDefaultsscc_info_ExistenceFilter_google_2ffirestore_2fv1_2fwrite_2eproto}, {
+      &scc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto.base,}};
 
 static void InitDefaultsscc_info_Write_google_2ffirestore_2fv1_2fwrite_2eproto() {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
@@ -209,7 +249,7 @@ static void InitDefaultsscc_info_WriteResult_google_2ffirestore_2fv1_2fwrite_2ep
       &scc_info_Timestamp_google_2fprotobuf_2ftimestamp_2eproto.base,
       &scc_info_ArrayValue_google_2ffirestore_2fv1_2fdocument_2eproto.base,}};
 
-static ::PROTOBUF_NAMESPACE_ID::Metadata file_level_metadata_google_2ffirestore_2fv1_2fwrite_2eproto[8];
+static ::PROTOBUF_NAMESPACE_ID::Metadata file_level_metadata_google_2ffirestore_2fv1_2fwrite_2eproto[10];
 static const ::PROTOBUF_NAMESPACE_ID::EnumDescriptor* file_level_enum_descriptors_google_2ffirestore_2fv1_2fwrite_2eproto[1];
 static constexpr ::PROTOBUF_NAMESPACE_ID::ServiceDescriptor const** file_level_service_descriptors_google_2ffirestore_2fv1_2fwrite_2eproto = nullptr;
 
@@ -284,6 +324,21 @@ const ::PROTOBUF_NAMESPACE_ID::uint32 TableStruct_google_2ffirestore_2fv1_2fwrit
   ~0u,  // no _weak_field_map_
   PROTOBUF_FIELD_OFFSET(::google::firestore::v1::ExistenceFilter, target_id_),
   PROTOBUF_FIELD_OFFSET(::google::firestore::v1::ExistenceFilter, count_),
+  PROTOBUF_FIELD_OFFSET(::google::firestore::v1::ExistenceFilter, unchanged_names_),
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::google::firestore::v1::BitSequence, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  PROTOBUF_FIELD_OFFSET(::google::firestore::v1::BitSequence, bitmap_),
+  PROTOBUF_FIELD_OFFSET(::google::firestore::v1::BitSequence, padding_),
+  ~0u,  // no _has_bits_
+  PROTOBUF_FIELD_OFFSET(::google::firestore::v1::BloomFilter, _internal_metadata_),
+  ~0u,  // no _extensions_
+  ~0u,  // no _oneof_case_
+  ~0u,  // no _weak_field_map_
+  PROTOBUF_FIELD_OFFSET(::google::firestore::v1::BloomFilter, bits_),
+  PROTOBUF_FIELD_OFFSET(::google::firestore::v1::BloomFilter, hash_count_),
 };
 static const ::PROTOBUF_NAMESPACE_ID::internal::MigrationSchema schemas[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) = {
   { 0, -1, sizeof(::google::firestore::v1::Write)},
@@ -294,6 +349,8 @@ static const ::PROTOBUF_NAMESPACE_ID::internal::MigrationSchema schemas[] PROTOB
   { 47, -1, sizeof(::google::firestore::v1::DocumentDelete)},
   { 55, -1, sizeof(::google::firestore::v1::DocumentRemove)},
   { 63, -1, sizeof(::google::firestore::v1::ExistenceFilter)},
+  { 71, -1, sizeof(::google::firestore::v1::BitSequence)},
+  { 78, -1, sizeof(::google::firestore::v1::BloomFilter)},
 };
 
 static ::PROTOBUF_NAMESPACE_ID::Message const * const file_default_instances[] = {
@@ -305,6 +362,8 @@ static ::PROTOBUF_NAMESPACE_ID::Message const * const file_default_instances[] =
   reinterpret_cast<const ::PROTOBUF_NAMESPACE_ID::Message*>(&::google::firestore::v1::_DocumentDelete_default_instance_),
   reinterpret_cast<const ::PROTOBUF_NAMESPACE_ID::Message*>(&::google::firestore::v1::_DocumentRemove_default_instance_),
   reinterpret_cast<const ::PROTOBUF_NAMESPACE_ID::Message*>(&::google::firestore::v1::_ExistenceFilter_default_instance_),
+  reinterpret_cast<const ::PROTOBUF_NAMESPACE_ID::Message*>(&::google::firestore::v1::_BitSequence_default_instance_),
+  reinterpret_cast<const ::PROTOBUF_NAMESPACE_ID::Message*>(&::google::firestore::v1::_BloomFilter_default_instance_),
 };
 
 const char descriptor_table_protodef_google_2ffirestore_2fv1_2fwrite_2eproto[] PROTOBUF_SECTION_VARIABLE(protodesc_cold) =
@@ -346,13 +405,18 @@ const char descriptor_table_protodef_google_2ffirestore_2fv1_2fwrite_2eproto[] P
   "\030\004 \001(\0132\032.google.protobuf.Timestamp\"m\n\016Do"
   "cumentRemove\022\020\n\010document\030\001 \001(\t\022\032\n\022remove"
   "d_target_ids\030\002 \003(\005\022-\n\tread_time\030\004 \001(\0132\032."
-  "google.protobuf.Timestamp\"3\n\017ExistenceFi"
-  "lter\022\021\n\ttarget_id\030\001 \001(\005\022\r\n\005count\030\002 \001(\005B\256"
-  "\001\n\027com.google.firestore.v1B\nWriteProtoP\001"
-  "Z<google.golang.org/genproto/googleapis/"
-  "firestore/v1;firestore\242\002\004GCFS\252\002\036Google.C"
-  "loud.Firestore.V1Beta1\312\002\036Google\\Cloud\\Fi"
-  "restore\\V1beta1b\006proto3"
+  "google.protobuf.Timestamp\"n\n\017ExistenceFi"
+  "lter\022\021\n\ttarget_id\030\001 \001(\005\022\r\n\005count\030\002 \001(\005\0229"
+  "\n\017unchanged_names\030\003 \001(\0132 .google.firesto"
+  "re.v1.BloomFilter\".\n\013BitSequence\022\016\n\006bitm"
+  "ap\030\001 \001(\014\022\017\n\007padding\030\002 \001(\005\"Q\n\013BloomFilter"
+  "\022.\n\004bits\030\001 \001(\0132 .google.firestore.v1.Bit"
+  "Sequence\022\022\n\nhash_count\030\002 \001(\005B\256\001\n\027com.goo"
+  "gle.firestore.v1B\nWriteProtoP\001Z<google.g"
+  "olang.org/genproto/googleapis/firestore/"
+  "v1;firestore\242\002\004GCFS\252\002\036Google.Cloud.Fires"
+  "tore.V1Beta1\312\002\036Google\\Cloud\\Firestore\\V1"
+  "beta1b\006proto3"
   ;
 static const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable*const descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_deps[4] = {
   &::descriptor_table_google_2fapi_2fannotations_2eproto,
@@ -360,7 +424,9 @@ static const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable*const descriptor
   &::descriptor_table_google_2ffirestore_2fv1_2fdocument_2eproto,
   &::descriptor_table_google_2fprotobuf_2ftimestamp_2eproto,
 };
-static ::PROTOBUF_NAMESPACE_ID::internal::SCCInfoBase*const descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_sccs[8] = {
+static ::PROTOBUF_NAMESPACE_ID::internal::SCCInfoBase*const descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_sccs[10] = {
+  &scc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto.base,
+  &scc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto.base,
   &scc_info_DocumentChange_google_2ffirestore_2fv1_2fwrite_2eproto.base,
   &scc_info_DocumentDelete_google_2ffirestore_2fv1_2fwrite_2eproto.base,
   &scc_info_DocumentRemove_google_2ffirestore_2fv1_2fwrite_2eproto.base,
@@ -373,10 +439,10 @@ static ::PROTOBUF_NAMESPACE_ID::internal::SCCInfoBase*const descriptor_table_goo
 static ::PROTOBUF_NAMESPACE_ID::internal::once_flag descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_once;
 static bool descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_initialized = false;
 const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto = {
-  &descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_initialized, descriptor_table_protodef_google_2ffirestore_2fv1_2fwrite_2eproto, "google/firestore/v1/write.proto", 1783,
-  &descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_once, descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_sccs, descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_deps, 8, 4,
+  &descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_initialized, descriptor_table_protodef_google_2ffirestore_2fv1_2fwrite_2eproto, "google/firestore/v1/write.proto", 1973,
+  &descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_once, descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_sccs, descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto_deps, 10, 4,
   schemas, file_default_instances, TableStruct_google_2ffirestore_2fv1_2fwrite_2eproto::offsets,
-  file_level_metadata_google_2ffirestore_2fv1_2fwrite_2eproto, 8, file_level_enum_descriptors_google_2ffirestore_2fv1_2fwrite_2eproto, file_level_service_descriptors_google_2ffirestore_2fv1_2fwrite_2eproto,
+  file_level_metadata_google_2ffirestore_2fv1_2fwrite_2eproto, 10, file_level_enum_descriptors_google_2ffirestore_2fv1_2fwrite_2eproto, file_level_service_descriptors_google_2ffirestore_2fv1_2fwrite_2eproto,
 };
 
 // Force running AddDescriptors() at dynamic initialization time.
@@ -3671,11 +3737,18 @@ void DocumentRemove::InternalSwap(DocumentRemove* other) {
 // ===================================================================
 
 void ExistenceFilter::InitAsDefaultInstance() {
+  ::google::firestore::v1::_ExistenceFilter_default_instance_._instance.get_mutable()->unchanged_names_ = const_cast< ::google::firestore::v1::BloomFilter*>(
+      ::google::firestore::v1::BloomFilter::internal_default_instance());
 }
 class ExistenceFilter::_Internal {
  public:
+  static const ::google::firestore::v1::BloomFilter& unchanged_names(const ExistenceFilter* msg);
 };
 
+const ::google::firestore::v1::BloomFilter&
+ExistenceFilter::_Internal::unchanged_names(const ExistenceFilter* msg) {
+  return *msg->unchanged_names_;
+}
 ExistenceFilter::ExistenceFilter()
   : ::PROTOBUF_NAMESPACE_ID::Message(), _internal_metadata_(nullptr) {
   SharedCtor();
@@ -3685,6 +3758,11 @@ ExistenceFilter::ExistenceFilter(const ExistenceFilter& from)
   : ::PROTOBUF_NAMESPACE_ID::Message(),
       _internal_metadata_(nullptr) {
   _internal_metadata_.MergeFrom(from._internal_metadata_);
+  if (from.has_unchanged_names()) {
+    unchanged_names_ = new ::google::firestore::v1::BloomFilter(*from.unchanged_names_);
+  } else {
+    unchanged_names_ = nullptr;
+  }
   ::memcpy(&target_id_, &from.target_id_,
     static_cast<size_t>(reinterpret_cast<char*>(&count_) -
     reinterpret_cast<char*>(&target_id_)) + sizeof(count_));
@@ -3692,9 +3770,10 @@ ExistenceFilter::ExistenceFilter(const ExistenceFilter& from)
 }
 
 void ExistenceFilter::SharedCtor() {
-  ::memset(&target_id_, 0, static_cast<size_t>(
+  ::PROTOBUF_NAMESPACE_ID::internal::InitSCC(&scc_info_ExistenceFilter_google_2ffirestore_2fv1_2fwrite_2eproto.base);
+  ::memset(&unchanged_names_, 0, static_cast<size_t>(
       reinterpret_cast<char*>(&count_) -
-      reinterpret_cast<char*>(&target_id_)) + sizeof(count_));
+      reinterpret_cast<char*>(&unchanged_names_)) + sizeof(count_));
 }
 
 ExistenceFilter::~ExistenceFilter() {
@@ -3703,6 +3782,7 @@ ExistenceFilter::~ExistenceFilter() {
 }
 
 void ExistenceFilter::SharedDtor() {
+  if (this != internal_default_instance()) delete unchanged_names_;
 }
 
 void ExistenceFilter::SetCachedSize(int size) const {
@@ -3720,6 +3800,10 @@ void ExistenceFilter::Clear() {
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
+  if (GetArenaNoVirtual() == nullptr && unchanged_names_ != nullptr) {
+    delete unchanged_names_;
+  }
+  unchanged_names_ = nullptr;
   ::memset(&target_id_, 0, static_cast<size_t>(
       reinterpret_cast<char*>(&count_) -
       reinterpret_cast<char*>(&target_id_)) + sizeof(count_));
@@ -3748,6 +3832,13 @@ const char* ExistenceFilter::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPAC
           CHK_(ptr);
         } else goto handle_unusual;
         continue;
+      // .google.firestore.v1.BloomFilter unchanged_names = 3;
+      case 3:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 26)) {
+          ptr = ctx->ParseMessage(mutable_unchanged_names(), ptr);
+          CHK_(ptr);
+        } else goto handle_unusual;
+        continue;
       default: {
       handle_unusual:
         if ((tag & 7) == 4 || tag == 0) {
@@ -3804,6 +3895,17 @@ bool ExistenceFilter::MergePartialFromCodedStream(
         break;
       }
 
+      // .google.firestore.v1.BloomFilter unchanged_names = 3;
+      case 3: {
+        if (static_cast< ::PROTOBUF_NAMESPACE_ID::uint8>(tag) == (26 & 0xFF)) {
+          DO_(::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::ReadMessage(
+               input, mutable_unchanged_names()));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
       default: {
       handle_unusual:
         if (tag == 0) {
@@ -3841,6 +3943,12 @@ void ExistenceFilter::SerializeWithCachedSizes(
     ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32(2, this->count(), output);
   }
 
+  // .google.firestore.v1.BloomFilter unchanged_names = 3;
+  if (this->has_unchanged_names()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteMessageMaybeToArray(
+      3, _Internal::unchanged_names(this), output);
+  }
+
   if (_internal_metadata_.have_unknown_fields()) {
     ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SerializeUnknownFields(
         _internal_metadata_.unknown_fields(), output);
@@ -3864,6 +3972,13 @@ void ExistenceFilter::SerializeWithCachedSizes(
     target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32ToArray(2, this->count(), target);
   }
 
+  // .google.firestore.v1.BloomFilter unchanged_names = 3;
+  if (this->has_unchanged_names()) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+      InternalWriteMessageToArray(
+        3, _Internal::unchanged_names(this), target);
+  }
+
   if (_internal_metadata_.have_unknown_fields()) {
     target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SerializeUnknownFieldsToArray(
         _internal_metadata_.unknown_fields(), target);
@@ -3885,6 +4000,13 @@ size_t ExistenceFilter::ByteSizeLong() const {
   // Prevent compiler warnings about cached_has_bits being unused
   (void) cached_has_bits;
 
+  // .google.firestore.v1.BloomFilter unchanged_names = 3;
+  if (this->has_unchanged_names()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(
+        *unchanged_names_);
+  }
+
   // int32 target_id = 1;
   if (this->target_id() != 0) {
     total_size += 1 +
@@ -3926,6 +4048,9 @@ void ExistenceFilter::MergeFrom(const ExistenceFilter& from) {
   ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
   (void) cached_has_bits;
 
+  if (from.has_unchanged_names()) {
+    mutable_unchanged_names()->::google::firestore::v1::BloomFilter::MergeFrom(from.unchanged_names());
+  }
   if (from.target_id() != 0) {
     set_target_id(from.target_id());
   }
@@ -3955,6 +4080,7 @@ bool ExistenceFilter::IsInitialized() const {
 void ExistenceFilter::InternalSwap(ExistenceFilter* other) {
   using std::swap;
   _internal_metadata_.Swap(&other->_internal_metadata_);
+  swap(unchanged_names_, other->unchanged_names_);
   swap(target_id_, other->target_id_);
   swap(count_, other->count_);
 }
@@ -3964,6 +4090,618 @@ void ExistenceFilter::InternalSwap(ExistenceFilter* other) {
 }
 
 
+// ===================================================================
+
+void BitSequence::InitAsDefaultInstance() {
+}
+class BitSequence::_Internal {
+ public:
+};
+
+BitSequence::BitSequence()
+  : ::PROTOBUF_NAMESPACE_ID::Message(), _internal_metadata_(nullptr) {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:google.firestore.v1.BitSequence)
+}
+BitSequence::BitSequence(const BitSequence& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message(),
+      _internal_metadata_(nullptr) {
+  _internal_metadata_.MergeFrom(from._internal_metadata_);
+  bitmap_.UnsafeSetDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited());
+  if (!from.bitmap().empty()) {
+    bitmap_.AssignWithDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(), from.bitmap_);
+  }
+  padding_ = from.padding_;
+  // @@protoc_insertion_point(copy_constructor:google.firestore.v1.BitSequence)
+}
+
+void BitSequence::SharedCtor() {
+  ::PROTOBUF_NAMESPACE_ID::internal::InitSCC(&scc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto.base);
+  bitmap_.UnsafeSetDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited());
+  padding_ = 0;
+}
+
+BitSequence::~BitSequence() {
+  // @@protoc_insertion_point(destructor:google.firestore.v1.BitSequence)
+  SharedDtor();
+}
+
+void BitSequence::SharedDtor() {
+  bitmap_.DestroyNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited());
+}
+
+void BitSequence::SetCachedSize(int size) const {
+  _cached_size_.Set(size);
+}
+const BitSequence& BitSequence::default_instance() {
+  ::PROTOBUF_NAMESPACE_ID::internal::InitSCC(&::scc_info_BitSequence_google_2ffirestore_2fv1_2fwrite_2eproto.base);
+  return *internal_default_instance();
+}
+
+
+void BitSequence::Clear() {
+// @@protoc_insertion_point(message_clear_start:google.firestore.v1.BitSequence)
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  bitmap_.ClearToEmptyNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited());
+  padding_ = 0;
+  _internal_metadata_.Clear();
+}
+
+#if GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+const char* BitSequence::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  while (!ctx->Done(&ptr)) {
+    ::PROTOBUF_NAMESPACE_ID::uint32 tag;
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::ReadTag(ptr, &tag);
+    CHK_(ptr);
+    switch (tag >> 3) {
+      // bytes bitmap = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
+          ptr = ::PROTOBUF_NAMESPACE_ID::internal::InlineGreedyStringParser(mutable_bitmap(), ptr, ctx);
+          CHK_(ptr);
+        } else goto handle_unusual;
+        continue;
+      // int32 padding = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 16)) {
+          padding_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint(&ptr);
+          CHK_(ptr);
+        } else goto handle_unusual;
+        continue;
+      default: {
+      handle_unusual:
+        if ((tag & 7) == 4 || tag == 0) {
+          ctx->SetLastTag(tag);
+          goto success;
+        }
+        ptr = UnknownFieldParse(tag, &_internal_metadata_, ptr, ctx);
+        CHK_(ptr != nullptr);
+        continue;
+      }
+    }  // switch
+  }  // while
+success:
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto success;
+#undef CHK_
+}
+#else  // GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+bool BitSequence::MergePartialFromCodedStream(
+    ::PROTOBUF_NAMESPACE_ID::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!PROTOBUF_PREDICT_TRUE(EXPRESSION)) goto failure
+  ::PROTOBUF_NAMESPACE_ID::uint32 tag;
+  // @@protoc_insertion_point(parse_start:google.firestore.v1.BitSequence)
+  for (;;) {
+    ::std::pair<::PROTOBUF_NAMESPACE_ID::uint32, bool> p = input->ReadTagWithCutoffNoLastTag(127u);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // bytes bitmap = 1;
+      case 1: {
+        if (static_cast< ::PROTOBUF_NAMESPACE_ID::uint8>(tag) == (10 & 0xFF)) {
+          DO_(::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::ReadBytes(
+                input, this->mutable_bitmap()));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // int32 padding = 2;
+      case 2: {
+        if (static_cast< ::PROTOBUF_NAMESPACE_ID::uint8>(tag) == (16 & 0xFF)) {
+
+          DO_((::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::ReadPrimitive<
+                   ::PROTOBUF_NAMESPACE_ID::int32, ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::TYPE_INT32>(
+                 input, &padding_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0) {
+          goto success;
+        }
+        DO_(::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SkipField(
+              input, tag, _internal_metadata_.mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:google.firestore.v1.BitSequence)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:google.firestore.v1.BitSequence)
+  return false;
+#undef DO_
+}
+#endif  // GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+
+void BitSequence::SerializeWithCachedSizes(
+    ::PROTOBUF_NAMESPACE_ID::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:google.firestore.v1.BitSequence)
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // bytes bitmap = 1;
+  if (this->bitmap().size() > 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteBytesMaybeAliased(
+      1, this->bitmap(), output);
+  }
+
+  // int32 padding = 2;
+  if (this->padding() != 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32(2, this->padding(), output);
+  }
+
+  if (_internal_metadata_.have_unknown_fields()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SerializeUnknownFields(
+        _internal_metadata_.unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:google.firestore.v1.BitSequence)
+}
+
+::PROTOBUF_NAMESPACE_ID::uint8* BitSequence::InternalSerializeWithCachedSizesToArray(
+    ::PROTOBUF_NAMESPACE_ID::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:google.firestore.v1.BitSequence)
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // bytes bitmap = 1;
+  if (this->bitmap().size() > 0) {
+    target =
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteBytesToArray(
+        1, this->bitmap(), target);
+  }
+
+  // int32 padding = 2;
+  if (this->padding() != 0) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32ToArray(2, this->padding(), target);
+  }
+
+  if (_internal_metadata_.have_unknown_fields()) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:google.firestore.v1.BitSequence)
+  return target;
+}
+
+size_t BitSequence::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:google.firestore.v1.BitSequence)
+  size_t total_size = 0;
+
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size +=
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::ComputeUnknownFieldsSize(
+        _internal_metadata_.unknown_fields());
+  }
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // bytes bitmap = 1;
+  if (this->bitmap().size() > 0) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::BytesSize(
+        this->bitmap());
+  }
+
+  // int32 padding = 2;
+  if (this->padding() != 0) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::Int32Size(
+        this->padding());
+  }
+
+  int cached_size = ::PROTOBUF_NAMESPACE_ID::internal::ToCachedSize(total_size);
+  SetCachedSize(cached_size);
+  return total_size;
+}
+
+void BitSequence::MergeFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) {
+// @@protoc_insertion_point(generalized_merge_from_start:google.firestore.v1.BitSequence)
+  GOOGLE_DCHECK_NE(&from, this);
+  const BitSequence* source =
+      ::PROTOBUF_NAMESPACE_ID::DynamicCastToGenerated<BitSequence>(
+          &from);
+  if (source == nullptr) {
+  // @@protoc_insertion_point(generalized_merge_from_cast_fail:google.firestore.v1.BitSequence)
+    ::PROTOBUF_NAMESPACE_ID::internal::ReflectionOps::Merge(from, this);
+  } else {
+  // @@protoc_insertion_point(generalized_merge_from_cast_success:google.firestore.v1.BitSequence)
+    MergeFrom(*source);
+  }
+}
+
+void BitSequence::MergeFrom(const BitSequence& from) {
+// @@protoc_insertion_point(class_specific_merge_from_start:google.firestore.v1.BitSequence)
+  GOOGLE_DCHECK_NE(&from, this);
+  _internal_metadata_.MergeFrom(from._internal_metadata_);
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  if (from.bitmap().size() > 0) {
+
+    bitmap_.AssignWithDefault(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(), from.bitmap_);
+  }
+  if (from.padding() != 0) {
+    set_padding(from.padding());
+  }
+}
+
+void BitSequence::CopyFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) {
+// @@protoc_insertion_point(generalized_copy_from_start:google.firestore.v1.BitSequence)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void BitSequence::CopyFrom(const BitSequence& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:google.firestore.v1.BitSequence)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool BitSequence::IsInitialized() const {
+  return true;
+}
+
+void BitSequence::InternalSwap(BitSequence* other) {
+  using std::swap;
+  _internal_metadata_.Swap(&other->_internal_metadata_);
+  bitmap_.Swap(&other->bitmap_, &::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(),
+    GetArenaNoVirtual());
+  swap(padding_, other->padding_);
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata BitSequence::GetMetadata() const {
+  return GetMetadataStatic();
+}
+
+
+// ===================================================================
+
+void BloomFilter::InitAsDefaultInstance() {
+  ::google::firestore::v1::_BloomFilter_default_instance_._instance.get_mutable()->bits_ = const_cast< ::google::firestore::v1::BitSequence*>(
+      ::google::firestore::v1::BitSequence::internal_default_instance());
+}
+class BloomFilter::_Internal {
+ public:
+  static const ::google::firestore::v1::BitSequence& bits(const BloomFilter* msg);
+};
+
+const ::google::firestore::v1::BitSequence&
+BloomFilter::_Internal::bits(const BloomFilter* msg) {
+  return *msg->bits_;
+}
+BloomFilter::BloomFilter()
+  : ::PROTOBUF_NAMESPACE_ID::Message(), _internal_metadata_(nullptr) {
+  SharedCtor();
+  // @@protoc_insertion_point(constructor:google.firestore.v1.BloomFilter)
+}
+BloomFilter::BloomFilter(const BloomFilter& from)
+  : ::PROTOBUF_NAMESPACE_ID::Message(),
+      _internal_metadata_(nullptr) {
+  _internal_metadata_.MergeFrom(from._internal_metadata_);
+  if (from.has_bits()) {
+    bits_ = new ::google::firestore::v1::BitSequence(*from.bits_);
+  } else {
+    bits_ = nullptr;
+  }
+  hash_count_ = from.hash_count_;
+  // @@protoc_insertion_point(copy_constructor:google.firestore.v1.BloomFilter)
+}
+
+void BloomFilter::SharedCtor() {
+  ::PROTOBUF_NAMESPACE_ID::internal::InitSCC(&scc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto.base);
+  ::memset(&bits_, 0, static_cast<size_t>(
+      reinterpret_cast<char*>(&hash_count_) -
+      reinterpret_cast<char*>(&bits_)) + sizeof(hash_count_));
+}
+
+BloomFilter::~BloomFilter() {
+  // @@protoc_insertion_point(destructor:google.firestore.v1.BloomFilter)
+  SharedDtor();
+}
+
+void BloomFilter::SharedDtor() {
+  if (this != internal_default_instance()) delete bits_;
+}
+
+void BloomFilter::SetCachedSize(int size) const {
+  _cached_size_.Set(size);
+}
+const BloomFilter& BloomFilter::default_instance() {
+  ::PROTOBUF_NAMESPACE_ID::internal::InitSCC(&::scc_info_BloomFilter_google_2ffirestore_2fv1_2fwrite_2eproto.base);
+  return *internal_default_instance();
+}
+
+
+void BloomFilter::Clear() {
+// @@protoc_insertion_point(message_clear_start:google.firestore.v1.BloomFilter)
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  if (GetArenaNoVirtual() == nullptr && bits_ != nullptr) {
+    delete bits_;
+  }
+  bits_ = nullptr;
+  hash_count_ = 0;
+  _internal_metadata_.Clear();
+}
+
+#if GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+const char* BloomFilter::_InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) {
+#define CHK_(x) if (PROTOBUF_PREDICT_FALSE(!(x))) goto failure
+  while (!ctx->Done(&ptr)) {
+    ::PROTOBUF_NAMESPACE_ID::uint32 tag;
+    ptr = ::PROTOBUF_NAMESPACE_ID::internal::ReadTag(ptr, &tag);
+    CHK_(ptr);
+    switch (tag >> 3) {
+      // .google.firestore.v1.BitSequence bits = 1;
+      case 1:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 10)) {
+          ptr = ctx->ParseMessage(mutable_bits(), ptr);
+          CHK_(ptr);
+        } else goto handle_unusual;
+        continue;
+      // int32 hash_count = 2;
+      case 2:
+        if (PROTOBUF_PREDICT_TRUE(static_cast<::PROTOBUF_NAMESPACE_ID::uint8>(tag) == 16)) {
+          hash_count_ = ::PROTOBUF_NAMESPACE_ID::internal::ReadVarint(&ptr);
+          CHK_(ptr);
+        } else goto handle_unusual;
+        continue;
+      default: {
+      handle_unusual:
+        if ((tag & 7) == 4 || tag == 0) {
+          ctx->SetLastTag(tag);
+          goto success;
+        }
+        ptr = UnknownFieldParse(tag, &_internal_metadata_, ptr, ctx);
+        CHK_(ptr != nullptr);
+        continue;
+      }
+    }  // switch
+  }  // while
+success:
+  return ptr;
+failure:
+  ptr = nullptr;
+  goto success;
+#undef CHK_
+}
+#else  // GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+bool BloomFilter::MergePartialFromCodedStream(
+    ::PROTOBUF_NAMESPACE_ID::io::CodedInputStream* input) {
+#define DO_(EXPRESSION) if (!PROTOBUF_PREDICT_TRUE(EXPRESSION)) goto failure
+  ::PROTOBUF_NAMESPACE_ID::uint32 tag;
+  // @@protoc_insertion_point(parse_start:google.firestore.v1.BloomFilter)
+  for (;;) {
+    ::std::pair<::PROTOBUF_NAMESPACE_ID::uint32, bool> p = input->ReadTagWithCutoffNoLastTag(127u);
+    tag = p.first;
+    if (!p.second) goto handle_unusual;
+    switch (::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::GetTagFieldNumber(tag)) {
+      // .google.firestore.v1.BitSequence bits = 1;
+      case 1: {
+        if (static_cast< ::PROTOBUF_NAMESPACE_ID::uint8>(tag) == (10 & 0xFF)) {
+          DO_(::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::ReadMessage(
+               input, mutable_bits()));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      // int32 hash_count = 2;
+      case 2: {
+        if (static_cast< ::PROTOBUF_NAMESPACE_ID::uint8>(tag) == (16 & 0xFF)) {
+
+          DO_((::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::ReadPrimitive<
+                   ::PROTOBUF_NAMESPACE_ID::int32, ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::TYPE_INT32>(
+                 input, &hash_count_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
+      default: {
+      handle_unusual:
+        if (tag == 0) {
+          goto success;
+        }
+        DO_(::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SkipField(
+              input, tag, _internal_metadata_.mutable_unknown_fields()));
+        break;
+      }
+    }
+  }
+success:
+  // @@protoc_insertion_point(parse_success:google.firestore.v1.BloomFilter)
+  return true;
+failure:
+  // @@protoc_insertion_point(parse_failure:google.firestore.v1.BloomFilter)
+  return false;
+#undef DO_
+}
+#endif  // GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+
+void BloomFilter::SerializeWithCachedSizes(
+    ::PROTOBUF_NAMESPACE_ID::io::CodedOutputStream* output) const {
+  // @@protoc_insertion_point(serialize_start:google.firestore.v1.BloomFilter)
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // .google.firestore.v1.BitSequence bits = 1;
+  if (this->has_bits()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteMessageMaybeToArray(
+      1, _Internal::bits(this), output);
+  }
+
+  // int32 hash_count = 2;
+  if (this->hash_count() != 0) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32(2, this->hash_count(), output);
+  }
+
+  if (_internal_metadata_.have_unknown_fields()) {
+    ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SerializeUnknownFields(
+        _internal_metadata_.unknown_fields(), output);
+  }
+  // @@protoc_insertion_point(serialize_end:google.firestore.v1.BloomFilter)
+}
+
+::PROTOBUF_NAMESPACE_ID::uint8* BloomFilter::InternalSerializeWithCachedSizesToArray(
+    ::PROTOBUF_NAMESPACE_ID::uint8* target) const {
+  // @@protoc_insertion_point(serialize_to_array_start:google.firestore.v1.BloomFilter)
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  // .google.firestore.v1.BitSequence bits = 1;
+  if (this->has_bits()) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::
+      InternalWriteMessageToArray(
+        1, _Internal::bits(this), target);
+  }
+
+  // int32 hash_count = 2;
+  if (this->hash_count() != 0) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::WriteInt32ToArray(2, this->hash_count(), target);
+  }
+
+  if (_internal_metadata_.have_unknown_fields()) {
+    target = ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::SerializeUnknownFieldsToArray(
+        _internal_metadata_.unknown_fields(), target);
+  }
+  // @@protoc_insertion_point(serialize_to_array_end:google.firestore.v1.BloomFilter)
+  return target;
+}
+
+size_t BloomFilter::ByteSizeLong() const {
+// @@protoc_insertion_point(message_byte_size_start:google.firestore.v1.BloomFilter)
+  size_t total_size = 0;
+
+  if (_internal_metadata_.have_unknown_fields()) {
+    total_size +=
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormat::ComputeUnknownFieldsSize(
+        _internal_metadata_.unknown_fields());
+  }
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  // Prevent compiler warnings about cached_has_bits being unused
+  (void) cached_has_bits;
+
+  // .google.firestore.v1.BitSequence bits = 1;
+  if (this->has_bits()) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::MessageSize(
+        *bits_);
+  }
+
+  // int32 hash_count = 2;
+  if (this->hash_count() != 0) {
+    total_size += 1 +
+      ::PROTOBUF_NAMESPACE_ID::internal::WireFormatLite::Int32Size(
+        this->hash_count());
+  }
+
+  int cached_size = ::PROTOBUF_NAMESPACE_ID::internal::ToCachedSize(total_size);
+  SetCachedSize(cached_size);
+  return total_size;
+}
+
+void BloomFilter::MergeFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) {
+// @@protoc_insertion_point(generalized_merge_from_start:google.firestore.v1.BloomFilter)
+  GOOGLE_DCHECK_NE(&from, this);
+  const BloomFilter* source =
+      ::PROTOBUF_NAMESPACE_ID::DynamicCastToGenerated<BloomFilter>(
+          &from);
+  if (source == nullptr) {
+  // @@protoc_insertion_point(generalized_merge_from_cast_fail:google.firestore.v1.BloomFilter)
+    ::PROTOBUF_NAMESPACE_ID::internal::ReflectionOps::Merge(from, this);
+  } else {
+  // @@protoc_insertion_point(generalized_merge_from_cast_success:google.firestore.v1.BloomFilter)
+    MergeFrom(*source);
+  }
+}
+
+void BloomFilter::MergeFrom(const BloomFilter& from) {
+// @@protoc_insertion_point(class_specific_merge_from_start:google.firestore.v1.BloomFilter)
+  GOOGLE_DCHECK_NE(&from, this);
+  _internal_metadata_.MergeFrom(from._internal_metadata_);
+  ::PROTOBUF_NAMESPACE_ID::uint32 cached_has_bits = 0;
+  (void) cached_has_bits;
+
+  if (from.has_bits()) {
+    mutable_bits()->::google::firestore::v1::BitSequence::MergeFrom(from.bits());
+  }
+  if (from.hash_count() != 0) {
+    set_hash_count(from.hash_count());
+  }
+}
+
+void BloomFilter::CopyFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) {
+// @@protoc_insertion_point(generalized_copy_from_start:google.firestore.v1.BloomFilter)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+void BloomFilter::CopyFrom(const BloomFilter& from) {
+// @@protoc_insertion_point(class_specific_copy_from_start:google.firestore.v1.BloomFilter)
+  if (&from == this) return;
+  Clear();
+  MergeFrom(from);
+}
+
+bool BloomFilter::IsInitialized() const {
+  return true;
+}
+
+void BloomFilter::InternalSwap(BloomFilter* other) {
+  using std::swap;
+  _internal_metadata_.Swap(&other->_internal_metadata_);
+  swap(bits_, other->bits_);
+  swap(hash_count_, other->hash_count_);
+}
+
+::PROTOBUF_NAMESPACE_ID::Metadata BloomFilter::GetMetadata() const {
+  return GetMetadataStatic();
+}
+
+
 // @@protoc_insertion_point(namespace_scope)
 }  // namespace v1
 }  // namespace firestore
@@ -3993,6 +4731,12 @@ template<> PROTOBUF_NOINLINE ::google::firestore::v1::DocumentRemove* Arena::Cre
 template<> PROTOBUF_NOINLINE ::google::firestore::v1::ExistenceFilter* Arena::CreateMaybeMessage< ::google::firestore::v1::ExistenceFilter >(Arena* arena) {
   return Arena::CreateInternal< ::google::firestore::v1::ExistenceFilter >(arena);
 }
+template<> PROTOBUF_NOINLINE ::google::firestore::v1::BitSequence* Arena::CreateMaybeMessage< ::google::firestore::v1::BitSequence >(Arena* arena) {
+  return Arena::CreateInternal< ::google::firestore::v1::BitSequence >(arena);
+}
+template<> PROTOBUF_NOINLINE ::google::firestore::v1::BloomFilter* Arena::CreateMaybeMessage< ::google::firestore::v1::BloomFilter >(Arena* arena) {
+  return Arena::CreateInternal< ::google::firestore::v1::BloomFilter >(arena);
+}
 PROTOBUF_NAMESPACE_CLOSE
 
 // @@protoc_insertion_point(global_scope)
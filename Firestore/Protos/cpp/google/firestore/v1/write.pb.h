@@ -68,7 +68,7 @@ struct TableStruct_google_2ffirestore_2fv1_2fwrite_2eproto {
     PROTOBUF_SECTION_VARIABLE(protodesc_cold);
   static const ::PROTOBUF_NAMESPACE_ID::internal::AuxillaryParseTableField aux[]
     PROTOBUF_SECTION_VARIABLE(protodesc_cold);
-  static const ::PROTOBUF_NAMESPACE_ID::internal::ParseTable schema[8]
+  static const ::PROTOBUF_NAMESPACE_ID::internal::ParseTable schema[10]
     PROTOBUF_SECTION_VARIABLE(protodesc_cold);
   static const ::PROTOBUF_NAMESPACE_ID::internal::FieldMetadata field_metadata[];
   static const ::PROTOBUF_NAMESPACE_ID::internal::SerializationTable serialization_table[];
@@ -78,6 +78,12 @@ extern const ::PROTOBUF_NAMESPACE_ID::internal::DescriptorTable descriptor_table
 namespace google {
 namespace firestore {
 namespace v1 {
+class BitSequence;
+class BitSequenceDefaultTypeInternal;
+extern BitSequenceDefaultTypeInternal _BitSequence_default_instance_;
+class BloomFilter;
+class BloomFilterDefaultTypeInternal;
+extern BloomFilterDefaultTypeInternal _BloomFilter_default_instance_;
 class DocumentChange;
 class DocumentChangeDefaultTypeInternal;
 extern DocumentChangeDefaultTypeInternal _DocumentChange_default_instance_;
@@ -106,6 +112,8 @@ extern WriteResultDefaultTypeInternal _WriteResult_default_instance_;
 }  // namespace firestore
 }  // namespace google
 PROTOBUF_NAMESPACE_OPEN
+template<> ::google::firestore::v1::BitSequence* Arena::CreateMaybeMessage<::google::firestore::v1::BitSequence>(Arena*);
+template<> ::google::firestore::v1::BloomFilter* Arena::CreateMaybeMessage<::google::firestore::v1::BloomFilter>(Arena*);
 template<> ::google::firestore::v1::DocumentChange* Arena::CreateMaybeMessage<::google::firestore::v1::DocumentChange>(Arena*);
 template<> ::google::firestore::v1::DocumentDelete* Arena::CreateMaybeMessage<::google::firestore::v1::DocumentDelete>(Arena*);
 template<> ::google::firestore::v1::DocumentRemove* Arena::CreateMaybeMessage<::google::firestore::v1::DocumentRemove>(Arena*);
@@ -1513,9 +1521,18 @@ class ExistenceFilter :
   // accessors -------------------------------------------------------
 
   enum : int {
+    kUnchangedNamesFieldNumber = 3,
     kTargetIdFieldNumber = 1,
     kCountFieldNumber = 2,
   };
+  // .google.firestore.v1.BloomFilter unchanged_names = 3;
+  bool has_unchanged_names() const;
+  void clear_unchanged_names();
+  const ::google::firestore::v1::BloomFilter& unchanged_names() const;
+  ::google::firestore::v1::BloomFilter* release_unchanged_names();
+  ::google::firestore::v1::BloomFilter* mutable_unchanged_names();
+  void set_allocated_unchanged_names(::google::firestore::v1::BloomFilter* unchanged_names);
+
   // int32 target_id = 1;
   void clear_target_id();
   ::PROTOBUF_NAMESPACE_ID::int32 target_id() const;
@@ -1531,11 +1548,297 @@ class ExistenceFilter :
   class _Internal;
 
   ::PROTOBUF_NAMESPACE_ID::internal::InternalMetadataWithArena _internal_metadata_;
+  ::google::firestore::v1::BloomFilter* unchanged_names_;
   ::PROTOBUF_NAMESPACE_ID::int32 target_id_;
   ::PROTOBUF_NAMESPACE_ID::int32 count_;
   mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
   friend struct ::TableStruct_google_2ffirestore_2fv1_2fwrite_2eproto;
 };
+// -------------------------------------------------------------------
+
+class BitSequence :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:google.firestore.v1.BitSequence) */ {
+ public:
+  BitSequence();
+  virtual ~BitSequence();
+
+  BitSequence(const BitSequence& from);
+  BitSequence(BitSequence&& from) noexcept
+    : BitSequence() {
+    *this = ::std::move(from);
+  }
+
+  inline BitSequence& operator=(const BitSequence& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline BitSequence& operator=(BitSequence&& from) noexcept {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return GetMetadataStatic().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return GetMetadataStatic().reflection;
+  }
+  static const BitSequence& default_instance();
+
+  static void InitAsDefaultInstance();  // FOR INTERNAL USE ONLY
+  static inline const BitSequence* internal_default_instance() {
+    return reinterpret_cast<const BitSequence*>(
+               &_BitSequence_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    8;
+
+  friend void swap(BitSequence& a, BitSequence& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(BitSequence* other) {
+    if (other == this) return;
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  inline BitSequence* New() const final {
+    return CreateMaybeMessage<BitSequence>(nullptr);
+  }
+
+  BitSequence* New(::PROTOBUF_NAMESPACE_ID::Arena* arena) const final {
+    return CreateMaybeMessage<BitSequence>(arena);
+  }
+  void CopyFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) final;
+  void MergeFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) final;
+  void CopyFrom(const BitSequence& from);
+  void MergeFrom(const BitSequence& from);
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  #if GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  #else
+  bool MergePartialFromCodedStream(
+      ::PROTOBUF_NAMESPACE_ID::io::CodedInputStream* input) final;
+  #endif  // GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+  void SerializeWithCachedSizes(
+      ::PROTOBUF_NAMESPACE_ID::io::CodedOutputStream* output) const final;
+  ::PROTOBUF_NAMESPACE_ID::uint8* InternalSerializeWithCachedSizesToArray(
+      ::PROTOBUF_NAMESPACE_ID::uint8* target) const final;
+  int GetCachedSize() const final { return _cached_size_.Get(); }
+
+  private:
+  inline void SharedCtor();
+  inline void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(BitSequence* other);
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "google.firestore.v1.BitSequence";
+  }
+  private:
+  inline ::PROTOBUF_NAMESPACE_ID::Arena* GetArenaNoVirtual() const {
+    return nullptr;
+  }
+  inline void* MaybeArenaPtr() const {
+    return nullptr;
+  }
+  public:
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+  private:
+  static ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadataStatic() {
+    ::PROTOBUF_NAMESPACE_ID::internal::AssignDescriptors(&::descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto);
+    return ::descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto.file_level_metadata[kIndexInFileMessages];
+  }
+
+  public:
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kBitmapFieldNumber = 1,
+    kPaddingFieldNumber = 2,
+  };
+  // bytes bitmap = 1;
+  void clear_bitmap();
+  const std::string& bitmap() const;
+  void set_bitmap(const std::string& value);
+  void set_bitmap(std::string&& value);
+  void set_bitmap(const char* value);
+  void set_bitmap(const void* value, size_t size);
+  std::string* mutable_bitmap();
+  std::string* release_bitmap();
+  void set_allocated_bitmap(std::string* bitmap);
+
+  // int32 padding = 2;
+  void clear_padding();
+  ::PROTOBUF_NAMESPACE_ID::int32 padding() const;
+  void set_padding(::PROTOBUF_NAMESPACE_ID::int32 value);
+
+  // @@protoc_insertion_point(class_scope:google.firestore.v1.BitSequence)
+ private:
+  class _Internal;
+
+  ::PROTOBUF_NAMESPACE_ID::internal::InternalMetadataWithArena _internal_metadata_;
+  ::PROTOBUF_NAMESPACE_ID::internal::ArenaStringPtr bitmap_;
+  ::PROTOBUF_NAMESPACE_ID::int32 padding_;
+  mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+  friend struct ::TableStruct_google_2ffirestore_2fv1_2fwrite_2eproto;
+};
+// -------------------------------------------------------------------
+
+class BloomFilter :
+    public ::PROTOBUF_NAMESPACE_ID::Message /* @@protoc_insertion_point(class_definition:google.firestore.v1.BloomFilter) */ {
+ public:
+  BloomFilter();
+  virtual ~BloomFilter();
+
+  BloomFilter(const BloomFilter& from);
+  BloomFilter(BloomFilter&& from) noexcept
+    : BloomFilter() {
+    *this = ::std::move(from);
+  }
+
+  inline BloomFilter& operator=(const BloomFilter& from) {
+    CopyFrom(from);
+    return *this;
+  }
+  inline BloomFilter& operator=(BloomFilter&& from) noexcept {
+    if (GetArenaNoVirtual() == from.GetArenaNoVirtual()) {
+      if (this != &from) InternalSwap(&from);
+    } else {
+      CopyFrom(from);
+    }
+    return *this;
+  }
+
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* descriptor() {
+    return GetDescriptor();
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Descriptor* GetDescriptor() {
+    return GetMetadataStatic().descriptor;
+  }
+  static const ::PROTOBUF_NAMESPACE_ID::Reflection* GetReflection() {
+    return GetMetadataStatic().reflection;
+  }
+  static const BloomFilter& default_instance();
+
+  static void InitAsDefaultInstance();  // FOR INTERNAL USE ONLY
+  static inline const BloomFilter* internal_default_instance() {
+    return reinterpret_cast<const BloomFilter*>(
+               &_BloomFilter_default_instance_);
+  }
+  static constexpr int kIndexInFileMessages =
+    9;
+
+  friend void swap(BloomFilter& a, BloomFilter& b) {
+    a.Swap(&b);
+  }
+  inline void Swap(BloomFilter* other) {
+    if (other == this) return;
+    InternalSwap(other);
+  }
+
+  // implements Message ----------------------------------------------
+
+  inline BloomFilter* New() const final {
+    return CreateMaybeMessage<BloomFilter>(nullptr);
+  }
+
+  BloomFilter* New(::PROTOBUF_NAMESPACE_ID::Arena* arena) const final {
+    return CreateMaybeMessage<BloomFilter>(arena);
+  }
+  void CopyFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) final;
+  void MergeFrom(const ::PROTOBUF_NAMESPACE_ID::Message& from) final;
+  void CopyFrom(const BloomFilter& from);
+  void MergeFrom(const BloomFilter& from);
+  PROTOBUF_ATTRIBUTE_REINITIALIZES void Clear() final;
+  bool IsInitialized() const final;
+
+  size_t ByteSizeLong() const final;
+  #if GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+  const char* _InternalParse(const char* ptr, ::PROTOBUF_NAMESPACE_ID::internal::ParseContext* ctx) final;
+  #else
+  bool MergePartialFromCodedStream(
+      ::PROTOBUF_NAMESPACE_ID::io::CodedInputStream* input) final;
+  #endif  // GOOGLE_PROTOBUF_ENABLE_EXPERIMENTAL_PARSER
+  void SerializeWithCachedSizes(
+      ::PROTOBUF_NAMESPACE_ID::io::CodedOutputStream* output) const final;
+  ::PROTOBUF_NAMESPACE_ID::uint8* InternalSerializeWithCachedSizesToArray(
+      ::PROTOBUF_NAMESPACE_ID::uint8* target) const final;
+  int GetCachedSize() const final { return _cached_size_.Get(); }
+
+  private:
+  inline void SharedCtor();
+  inline void SharedDtor();
+  void SetCachedSize(int size) const final;
+  void InternalSwap(BloomFilter* other);
+  friend class ::PROTOBUF_NAMESPACE_ID::internal::AnyMetadata;
+  static ::PROTOBUF_NAMESPACE_ID::StringPiece FullMessageName() {
+    return "google.firestore.v1.BloomFilter";
+  }
+  private:
+  inline ::PROTOBUF_NAMESPACE_ID::Arena* GetArenaNoVirtual() const {
+    return nullptr;
+  }
+  inline void* MaybeArenaPtr() const {
+    return nullptr;
+  }
+  public:
+
+  ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadata() const final;
+  private:
+  static ::PROTOBUF_NAMESPACE_ID::Metadata GetMetadataStatic() {
+    ::PROTOBUF_NAMESPACE_ID::internal::AssignDescriptors(&::descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto);
+    return ::descriptor_table_google_2ffirestore_2fv1_2fwrite_2eproto.file_level_metadata[kIndexInFileMessages];
+  }
+
+  public:
+
+  // nested types ----------------------------------------------------
+
+  // accessors -------------------------------------------------------
+
+  enum : int {
+    kBitsFieldNumber = 1,
+    kHashCountFieldNumber = 2,
+  };
+  // .google.firestore.v1.BitSequence bits = 1;
+  bool has_bits() const;
+  void clear_bits();
+  const ::google::firestore::v1::BitSequence& bits() const;
+  ::google::firestore::v1::BitSequence* release_bits();
+  ::google::firestore::v1::BitSequence* mutable_bits();
+  void set_allocated_bits(::google::firestore::v1::BitSequence* bits);
+
+  // int32 hash_count = 2;
+  void clear_hash_count();
+  ::PROTOBUF_NAMESPACE_ID::int32 hash_count() const;
+  void set_hash_count(::PROTOBUF_NAMESPACE_ID::int32 value);
+
+  // @@protoc_insertion_point(class_scope:google.firestore.v1.BloomFilter)
+ private:
+  class _Internal;
+
+  ::PROTOBUF_NAMESPACE_ID::internal::InternalMetadataWithArena _internal_metadata_;
+  ::google::firestore::v1::BitSequence* bits_;
+  ::PROTOBUF_NAMESPACE_ID::int32 hash_count_;
+  mutable ::PROTOBUF_NAMESPACE_ID::internal::CachedSize _cached_size_;
+  friend struct ::TableStruct_google_2ffirestore_2fv1_2fwrite_2eproto;
+};
 // ===================================================================
 
 
@@ -2735,6 +3038,195 @@ inline void ExistenceFilter::set_count(::PROTOBUF_NAMESPACE_ID::int32 value) {
   // @@protoc_insertion_point(field_set:google.firestore.v1.ExistenceFilter.count)
 }
 
+// .google.firestore.v1.BloomFilter unchanged_names = 3;
+inline bool ExistenceFilter::has_unchanged_names() const {
+  return this != internal_default_instance() && unchanged_names_ != nullptr;
+}
+inline void ExistenceFilter::clear_unchanged_names() {
+  if (GetArenaNoVirtual() == nullptr && unchanged_names_ != nullptr) {
+    delete unchanged_names_;
+  }
+  unchanged_names_ = nullptr;
+}
+inline const ::google::firestore::v1::BloomFilter& ExistenceFilter::unchanged_names() const {
+  const ::google::firestore::v1::BloomFilter* p = unchanged_names_;
+  // @@protoc_insertion_point(unchanged_names_get:google.firestore.v1.ExistenceFilter.unchanged_names)
+  return p != nullptr ? *p : *reinterpret_cast<const ::google::firestore::v1::BloomFilter*>(
+      &::google::firestore::v1::_BloomFilter_default_instance_);
+}
+inline ::google::firestore::v1::BloomFilter* ExistenceFilter::release_unchanged_names() {
+  // @@protoc_insertion_point(unchanged_names_release:google.firestore.v1.ExistenceFilter.unchanged_names)
+  
+  ::google::firestore::v1::BloomFilter* temp = unchanged_names_;
+  unchanged_names_ = nullptr;
+  return temp;
+}
+inline ::google::firestore::v1::BloomFilter* ExistenceFilter::mutable_unchanged_names() {
+  
+  if (unchanged_names_ == nullptr) {
+    auto* p = CreateMaybeMessage<::google::firestore::v1::BloomFilter>(GetArenaNoVirtual());
+    unchanged_names_ = p;
+  }
+  // @@protoc_insertion_point(unchanged_names_mutable:google.firestore.v1.ExistenceFilter.unchanged_names)
+  return unchanged_names_;
+}
+inline void ExistenceFilter::set_allocated_unchanged_names(::google::firestore::v1::BloomFilter* unchanged_names) {
+  ::PROTOBUF_NAMESPACE_ID::Arena* message_arena = GetArenaNoVirtual();
+  if (message_arena == nullptr) {
+    delete unchanged_names_;
+  }
+  if (unchanged_names) {
+    ::PROTOBUF_NAMESPACE_ID::Arena* submessage_arena = nullptr;
+    if (message_arena != submessage_arena) {
+      unchanged_names = ::PROTOBUF_NAMESPACE_ID::internal::GetOwnedMessage(
+          message_arena, unchanged_names, submessage_arena);
+    }
+    
+  } else {
+    
+  }
+  unchanged_names_ = unchanged_names;
+  // @@protoc_insertion_point(unchanged_names_set_allocated:google.firestore.v1.ExistenceFilter.unchanged_names)
+}
+
+// -------------------------------------------------------------------
+
+// BitSequence
+
+// bytes bitmap = 1;
+inline void BitSequence::clear_bitmap() {
+  bitmap_.ClearToEmptyNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited());
+}
+inline const std::string& BitSequence::bitmap() const {
+  // @@protoc_insertion_point(field_get:google.firestore.v1.BitSequence.bitmap)
+  return bitmap_.GetNoArena();
+}
+inline void BitSequence::set_bitmap(const std::string& value) {
+  
+  bitmap_.SetNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(), value);
+  // @@protoc_insertion_point(field_set:google.firestore.v1.BitSequence.bitmap)
+}
+inline void BitSequence::set_bitmap(std::string&& value) {
+  
+  bitmap_.SetNoArena(
+    &::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(), ::std::move(value));
+  // @@protoc_insertion_point(field_set_rvalue:google.firestore.v1.BitSequence.bitmap)
+}
+inline void BitSequence::set_bitmap(const char* value) {
+  GOOGLE_DCHECK(value != nullptr);
+  
+  bitmap_.SetNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(), ::std::string(value));
+  // @@protoc_insertion_point(field_set_char:google.firestore.v1.BitSequence.bitmap)
+}
+inline void BitSequence::set_bitmap(const void* value, size_t size) {
+  
+  bitmap_.SetNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(),
+      ::std::string(reinterpret_cast<const char*>(value), size));
+  // @@protoc_insertion_point(field_set_pointer:google.firestore.v1.BitSequence.bitmap)
+}
+inline std::string* BitSequence::mutable_bitmap() {
+  
+  // @@protoc_insertion_point(field_mutable:google.firestore.v1.BitSequence.bitmap)
+  return bitmap_.MutableNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited());
+}
+inline std::string* BitSequence::release_bitmap() {
+  // @@protoc_insertion_point(field_release:google.firestore.v1.BitSequence.bitmap)
+  
+  return bitmap_.ReleaseNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited());
+}
+inline void BitSequence::set_allocated_bitmap(std::string* bitmap) {
+  if (bitmap != nullptr) {
+    
+  } else {
+    
+  }
+  bitmap_.SetAllocatedNoArena(&::PROTOBUF_NAMESPACE_ID::internal::GetEmptyStringAlreadyInited(), bitmap);
+  // @@protoc_insertion_point(field_set_allocated:google.firestore.v1.BitSequence.bitmap)
+}
+
+// int32 padding = 2;
+inline void BitSequence::clear_padding() {
+  padding_ = 0;
+}
+inline ::PROTOBUF_NAMESPACE_ID::int32 BitSequence::padding() const {
+  // @@protoc_insertion_point(field_get:google.firestore.v1.BitSequence.padding)
+  return padding_;
+}
+inline void BitSequence::set_padding(::PROTOBUF_NAMESPACE_ID::int32 value) {
+  
+  padding_ = value;
+  // @@protoc_insertion_point(field_set:google.firestore.v1.BitSequence.padding)
+}
+
+// -------------------------------------------------------------------
+
+// BloomFilter
+
+// .google.firestore.v1.BitSequence bits = 1;
+inline bool BloomFilter::has_bits() const {
+  return this != internal_default_instance() && bits_ != nullptr;
+}
+inline void BloomFilter::clear_bits() {
+  if (GetArenaNoVirtual() == nullptr && bits_ != nullptr) {
+    delete bits_;
+  }
+  bits_ = nullptr;
+}
+inline const ::google::firestore::v1::BitSequence& BloomFilter::bits() const {
+  const ::google::firestore::v1::BitSequence* p = bits_;
+  // @@protoc_insertion_point(bits_get:google.firestore.v1.BloomFilter.bits)
+  return p != nullptr ? *p : *reinterpret_cast<const ::google::firestore::v1::BitSequence*>(
+      &::google::firestore::v1::_BitSequence_default_instance_);
+}
+inline ::google::firestore::v1::BitSequence* BloomFilter::release_bits() {
+  // @@protoc_insertion_point(bits_release:google.firestore.v1.BloomFilter.bits)
+  
+  ::google::firestore::v1::BitSequence* temp = bits_;
+  bits_ = nullptr;
+  return temp;
+}
+inline ::google::firestore::v1::BitSequence* BloomFilter::mutable_bits() {
+  
+  if (bits_ == nullptr) {
+    auto* p = CreateMaybeMessage<::google::firestore::v1::BitSequence>(GetArenaNoVirtual());
+    bits_ = p;
+  }
+  // @@protoc_insertion_point(bits_mutable:google.firestore.v1.BloomFilter.bits)
+  return bits_;
+}
+inline void BloomFilter::set_allocated_bits(::google::firestore::v1::BitSequence* bits) {
+  ::PROTOBUF_NAMESPACE_ID::Arena* message_arena = GetArenaNoVirtual();
+  if (message_arena == nullptr) {
+    delete bits_;
+  }
+  if (bits) {
+    ::PROTOBUF_NAMESPACE_ID::Arena* submessage_arena = nullptr;
+    if (message_arena != submessage_arena) {
+      bits = ::PROTOBUF_NAMESPACE_ID::internal::GetOwnedMessage(
+          message_arena, bits, submessage_arena);
+    }
+    
+  } else {
+    
+  }
+  bits_ = bits;
+  // @@protoc_insertion_point(bits_set_allocated:google.firestore.v1.BloomFilter.bits)
+}
+
+// int32 hash_count = 2;
+inline void BloomFilter::clear_hash_count() {
+  hash_count_ = 0;
+}
+inline ::PROTOBUF_NAMESPACE_ID::int32 BloomFilter::hash_count() const {
+  // @@protoc_insertion_point(field_get:google.firestore.v1.BloomFilter.hash_count)
+  return hash_count_;
+}
+inline void BloomFilter::set_hash_count(::PROTOBUF_NAMESPACE_ID::int32 value) {
+  
+  hash_count_ = value;
+  // @@protoc_insertion_point(field_set:google.firestore.v1.BloomFilter.hash_count)
+}
+
 #ifdef __GNUC__
   #pragma GCC diagnostic pop
 #endif  // __GNUC__
@@ -2752,6 +3244,10 @@ inline void ExistenceFilter::set_count(::PROTOBUF_NAMESPACE_ID::int32 value) {
 
 // -------------------------------------------------------------------
 
+// -------------------------------------------------------------------
+
+// -------------------------------------------------------------------
+
 
 // @@protoc_insertion_point(namespace_scope)
 
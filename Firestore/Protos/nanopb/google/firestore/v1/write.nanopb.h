@@ -59,6 +59,14 @@ typedef struct _google_firestore_v1_DocumentTransform {
 /* @@protoc_insertion_point(struct:google_firestore_v1_DocumentTransform) */
 } google_firestore_v1_DocumentTransform;
 
+typedef struct _google_firestore_v1_BitSequence {
+    pb_bytes_array_t *bitmap;
+    int32_t padding;
+
+    std::string ToString(int indent = 0) const;
+/* @@protoc_insertion_point(struct:google_firestore_v1_BitSequence) */
+} google_firestore_v1_BitSequence;
+
 typedef struct _google_firestore_v1_DocumentChange {
     google_firestore_v1_Document document;
     pb_size_t target_ids_count;
@@ -107,14 +115,6 @@ typedef struct _google_firestore_v1_DocumentTransform_FieldTransform {
 /* @@protoc_insertion_point(struct:google_firestore_v1_DocumentTransform_FieldTransform) */
 } google_firestore_v1_DocumentTransform_FieldTransform;
 
-typedef struct _google_firestore_v1_ExistenceFilter {
-    int32_t target_id;
-    int32_t count;
-
-    std::string ToString(int indent = 0) const;
-/* @@protoc_insertion_point(struct:google_firestore_v1_ExistenceFilter) */
-} google_firestore_v1_ExistenceFilter;
-
 typedef struct _google_firestore_v1_Write {
     pb_size_t which_operation;
     union {
@@ -142,6 +142,24 @@ typedef struct _google_firestore_v1_WriteResult {
 /* @@protoc_insertion_point(struct:google_firestore_v1_WriteResult) */
 } google_firestore_v1_WriteResult;
 
+typedef struct _google_firestore_v1_BloomFilter {
+    google_firestore_v1_BitSequence bits;
+    int32_t hash_count;
+
+    std::string ToString(int indent = 0) const;
+/* @@protoc_insertion_point(struct:google_firestore_v1_BloomFilter) */
+} google_firestore_v1_BloomFilter;
+
+typedef struct _google_firestore_v1_ExistenceFilter {
+    int32_t target_id;
+    int32_t count;
+    bool has_unchanged_names;
+    google_firestore_v1_BloomFilter unchanged_names;
+
+    std::string ToString(int indent = 0) const;
+/* @@protoc_insertion_point(struct:google_firestore_v1_ExistenceFilter) */
+} google_firestore_v1_ExistenceFilter;
+
 /* Default values for struct fields */
 
 /* Initializer values for message structs */
@@ -152,7 +170,9 @@ typedef struct _google_firestore_v1_WriteResult {
 #define google_firestore_v1_DocumentChange_init_default {google_firestore_v1_Document_init_default, 0, NULL, 0, NULL}
 #define google_firestore_v1_DocumentDelete_init_default {NULL, false, google_protobuf_Timestamp_init_default, 0, NULL}
 #define google_firestore_v1_DocumentRemove_init_default {NULL, 0, NULL, google_protobuf_Timestamp_init_default}
-#define google_firestore_v1_ExistenceFilter_init_default {0, 0}
+#define google_firestore_v1_ExistenceFilter_init_default {0, 0, false, google_firestore_v1_BloomFilter_init_default}
+#define google_firestore_v1_BitSequence_init_default {NULL, 0}
+#define google_firestore_v1_BloomFilter_init_default {google_firestore_v1_BitSequence_init_default, 0}
 #define google_firestore_v1_Write_init_zero      {0, {google_firestore_v1_Document_init_zero}, false, google_firestore_v1_DocumentMask_init_zero, false, google_firestore_v1_Precondition_init_zero}
 #define google_firestore_v1_DocumentTransform_init_zero {NULL, 0, NULL}
 #define google_firestore_v1_DocumentTransform_FieldTransform_init_zero {NULL, 0, {_google_firestore_v1_DocumentTransform_FieldTransform_ServerValue_MIN}}
@@ -160,11 +180,15 @@ typedef struct _google_firestore_v1_WriteResult {
 #define google_firestore_v1_DocumentChange_init_zero {google_firestore_v1_Document_init_zero, 0, NULL, 0, NULL}
 #define google_firestore_v1_DocumentDelete_init_zero {NULL, false, google_protobuf_Timestamp_init_zero, 0, NULL}
 #define google_firestore_v1_DocumentRemove_init_zero {NULL, 0, NULL, google_protobuf_Timestamp_init_zero}
-#define google_firestore_v1_ExistenceFilter_init_zero {0, 0}
+#define google_firestore_v1_ExistenceFilter_init_zero {0, 0, false, google_firestore_v1_BloomFilter_init_zero}
+#define google_firestore_v1_BitSequence_init_zero {NULL, 0}
+#define google_firestore_v1_BloomFilter_init_zero {google_firestore_v1_BitSequence_init_zero, 0}
 
 /* Field tags (for use in manual encoding/decoding) */
 #define google_firestore_v1_DocumentTransform_document_tag 1
 #define google_firestore_v1_DocumentTransform_field_transforms_tag 2
+#define google_firestore_v1_BitSequence_bitmap_tag 1
+#define google_firestore_v1_BitSequence_padding_tag 2
 #define google_firestore_v1_DocumentChange_document_tag 1
 #define google_firestore_v1_DocumentChange_target_ids_tag 5
 #define google_firestore_v1_DocumentChange_removed_target_ids_tag 6
@@ -181,8 +205,6 @@ typedef struct _google_firestore_v1_WriteResult {
 #define google_firestore_v1_DocumentTransform_FieldTransform_append_missing_elements_tag 6
 #define google_firestore_v1_DocumentTransform_FieldTransform_remove_all_from_array_tag 7
 #define google_firestore_v1_DocumentTransform_FieldTransform_field_path_tag 1
-#define google_firestore_v1_ExistenceFilter_target_id_tag 1
-#define google_firestore_v1_ExistenceFilter_count_tag 2
 #define google_firestore_v1_Write_update_tag     1
 #define google_firestore_v1_Write_delete_tag     2
 #define google_firestore_v1_Write_verify_tag     5
@@ -191,6 +213,11 @@ typedef struct _google_firestore_v1_WriteResult {
 #define google_firestore_v1_Write_current_document_tag 4
 #define google_firestore_v1_WriteResult_update_time_tag 1
 #define google_firestore_v1_WriteResult_transform_results_tag 2
+#define google_firestore_v1_BloomFilter_bits_tag 1
+#define google_firestore_v1_BloomFilter_hash_count_tag 2
+#define google_firestore_v1_ExistenceFilter_target_id_tag 1
+#define google_firestore_v1_ExistenceFilter_count_tag 2
+#define google_firestore_v1_ExistenceFilter_unchanged_names_tag 3
 
 /* Struct field encoding specification for nanopb */
 extern const pb_field_t google_firestore_v1_Write_fields[7];
@@ -200,7 +227,9 @@ extern const pb_field_t google_firestore_v1_WriteResult_fields[3];
 extern const pb_field_t google_firestore_v1_DocumentChange_fields[4];
 extern const pb_field_t google_firestore_v1_DocumentDelete_fields[4];
 extern const pb_field_t google_firestore_v1_DocumentRemove_fields[4];
-extern const pb_field_t google_firestore_v1_ExistenceFilter_fields[3];
+extern const pb_field_t google_firestore_v1_ExistenceFilter_fields[4];
+extern const pb_field_t google_firestore_v1_BitSequence_fields[3];
+extern const pb_field_t google_firestore_v1_BloomFilter_fields[3];
 
 /* Maximum encoded size of messages (where known) */
 /* google_firestore_v1_Write_size depends on runtime parameters */
@@ -210,7 +239,9 @@ extern const pb_field_t google_firestore_v1_ExistenceFilter_fields[3];
 /* google_firestore_v1_DocumentChange_size depends on runtime parameters */
 /* google_firestore_v1_DocumentDelete_size depends on runtime parameters */
 /* google_firestore_v1_DocumentRemove_size depends on runtime parameters */
-#define google_firestore_v1_ExistenceFilter_size 22
+/* google_firestore_v1_ExistenceFilter_size depends on runtime parameters */
+/* google_firestore_v1_BitSequence_size depends on runtime parameters */
+/* google_firestore_v1_BloomFilter_size depends on runtime parameters */
 
 /* Message IDs (where set with "msgid" option) */
 #ifdef PB_MSGID
@@ -16,6 +16,7 @@
 
 #import "FIRDocumentSnapshot+Internal.h"
 
+#include <memory>
 #include <utility>
 #include <vector>
 
@@ -58,7 +59,6 @@ using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::FieldValue;
 using firebase::firestore::model::FieldValueOptions;
-using firebase::firestore::model::ObjectValue;
 using firebase::firestore::model::ServerTimestampBehavior;
 using firebase::firestore::nanopb::MakeNSData;
 using firebase::firestore::util::MakeString;
@@ -84,6 +84,11 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
   }
 }
 
+/** The data of a document converted for the user, as memoized in the document. */
+struct ConvertedData {
+  NSDictionary<NSString *, id> *data;
+};
+
 }  // namespace
 
 @implementation FIRDocumentSnapshot {
@@ -172,10 +177,18 @@ ServerTimestampBehavior InternalServerTimestampBehavior(FIRServerTimestampBehavi
 - (nullable NSDictionary<NSString *, id> *)dataWithServerTimestampBehavior:
     (FIRServerTimestampBehavior)serverTimestampBehavior {
   FieldValueOptions options = [self optionsForServerTimestampBehavior:serverTimestampBehavior];
-  absl::optional<ObjectValue> data = _snapshot.GetData();
-  if (!data) return nil;
-
-  return [self convertedObject:data->GetInternalValue() options:options];
+  const absl::optional<Document> &document = _snapshot.internal_document();
+  if (!document) return nil;
+
+  // The conversion is memoized in the document, which is shared by every snapshot of the same
+  // version of it.
+  int slot = static_cast<int>(options.server_timestamp_behavior()) * 2 +
+             (options.timestamps_in_snapshots_enabled() ? 1 : 0);
+  std::shared_ptr<void> converted = document->Memoize(slot, [&] {
+    return std::make_shared<ConvertedData>(
+        ConvertedData{[self convertedObject:document->data().GetInternalValue() options:options]});
+  });
+  return static_cast<ConvertedData *>(converted.get())->data;
 }
 
 - (nullable id)valueForField:(id)field {
@@ -63,6 +63,12 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (void)terminateInternalWithCompletion:(nullable void (^)(NSError *_Nullable error))completion;
 
+/**
+ * Drops the in-memory caches that can be rebuilt and runs a slice of garbage collection. Called on
+ * memory warnings; the completion receives an estimate of the number of bytes released.
+ */
+- (void)releaseMemoryWithCompletion:(nullable void (^)(NSUInteger releasedBytes))completion;
+
 - (const std::shared_ptr<util::AsyncQueue> &)workerQueue;
 
 @property(nonatomic, assign, readonly) std::shared_ptr<api::Firestore> wrapped;
@@ -24,6 +24,10 @@
 #include <string>
 #include <utility>
 
+#if TARGET_OS_IOS || TARGET_OS_TV
+#import <UIKit/UIKit.h>
+#endif
+
 #import "FIRFirestoreSettings+Internal.h"
 
 #import "Firestore/Source/API/FIRCollectionReference+Internal.h"
@@ -93,6 +97,9 @@ NS_ASSUME_NONNULL_BEGIN
   std::shared_ptr<Firestore> _firestore;
   FIRFirestoreSettings *_settings;
   __weak id<FSTFirestoreInstanceRegistry> _registry;
+#if TARGET_OS_IOS || TARGET_OS_TV
+  id<NSObject> _memoryWarningObserver;
+#endif
 }
 
 + (void)initialize {
@@ -159,10 +166,27 @@ NS_ASSUME_NONNULL_BEGIN
                                                          preConverter:block];
     // Use the property setter so the default settings get plumbed into _firestoreClient.
     self.settings = [[FIRFirestoreSettings alloc] init];
+
+#if TARGET_OS_IOS || TARGET_OS_TV
+    __weak FIRFirestore *weakSelf = self;
+    _memoryWarningObserver = [[NSNotificationCenter defaultCenter]
+        addObserverForName:UIApplicationDidReceiveMemoryWarningNotification
+                    object:nil
+                     queue:nil
+                usingBlock:^(NSNotification *note) {
+                  [weakSelf releaseMemoryWithCompletion:nil];
+                }];
+#endif
   }
   return self;
 }
 
+- (void)dealloc {
+#if TARGET_OS_IOS || TARGET_OS_TV
+  [[NSNotificationCenter defaultCenter] removeObserver:_memoryWarningObserver];
+#endif
+}
+
 - (FIRFirestoreSettings *)settings {
   // Disallow mutation of our internal settings
   return [_settings copy];
@@ -380,6 +404,14 @@ NS_ASSUME_NONNULL_BEGIN
   _firestore->Terminate(MakeCallback(completion));
 }
 
+- (void)releaseMemoryWithCompletion:(nullable void (^)(NSUInteger releasedBytes))completion {
+  std::function<void(size_t)> callback;
+  if (completion) {
+    callback = [completion](size_t released) { completion(static_cast<NSUInteger>(released)); };
+  }
+  _firestore->ReleaseMemory(std::move(callback));
+}
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -194,9 +194,13 @@ int32_t SaturatedLimitValue(NSInteger limit) {
                  nil);
       });
 
-  // Call the view_listener on the user Executor.
+  // Call the view_listener on the Executor of the options, by default the user Executor.
   auto async_listener = AsyncEventListener<ViewSnapshot>::Create(
-      firestore->client()->user_executor(), std::move(view_listener));
+      internalOptions.executor().value_or(firestore->client()->user_executor()),
+      std::move(view_listener));
+  if (internalOptions.conflate_snapshots()) {
+    async_listener->ConflateEvents(ViewSnapshot::Merge);
+  }
 
   std::shared_ptr<QueryListener> query_listener =
       firestore->client()->ListenToQuery(query, internalOptions, async_listener);
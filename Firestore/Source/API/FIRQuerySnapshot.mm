@@ -14,7 +14,9 @@
  * limitations under the License.
  */
 
+#include <mutex>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #import "Firestore/Source/API/FIRQuerySnapshot+Internal.h"
 
@@ -38,11 +40,70 @@ using firebase::firestore::api::Firestore;
 using firebase::firestore::api::QuerySnapshot;
 using firebase::firestore::api::SnapshotMetadata;
 using firebase::firestore::core::ViewSnapshot;
+using firebase::firestore::model::Document;
 using firebase::firestore::util::DelayedConstructor;
 using firebase::firestore::util::ThrowInvalidArgument;
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ * The documents of a query snapshot, as an immutable array whose FIRQueryDocumentSnapshots are
+ * created as they're accessed, so that apps displaying a few rows of a large result don't pay for
+ * a wrapper per document.
+ */
+@interface FSTQueryDocumentArray : NSArray <FIRQueryDocumentSnapshot *>
+
+- (instancetype)initWithSnapshot:(const QuerySnapshot &)snapshot;
+
+@end
+
+@implementation FSTQueryDocumentArray {
+  DelayedConstructor<QuerySnapshot> _snapshot;
+  std::vector<Document> _documents;
+
+  // The wrappers created so far, nil for those not yet accessed. Guarded by _mutex, since
+  // immutable arrays can be read from any thread.
+  std::vector<FIRQueryDocumentSnapshot *> _wrappers;
+  std::mutex _mutex;
+}
+
+- (instancetype)initWithSnapshot:(const QuerySnapshot &)snapshot {
+  if (self = [super init]) {
+    _snapshot.Init(snapshot);
+    _documents = snapshot.GetDocuments();
+    _wrappers.resize(_documents.size());
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  return _documents.size();
+}
+
+- (FIRQueryDocumentSnapshot *)objectAtIndex:(NSUInteger)index {
+  if (index >= _documents.size()) {
+    [NSException raise:NSRangeException
+                format:@"Index %lu is out of bounds for %lu documents", (unsigned long)index,
+                       (unsigned long)_documents.size()];
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  FIRQueryDocumentSnapshot *wrapper = _wrappers[index];
+  if (!wrapper) {
+    wrapper = [[FIRQueryDocumentSnapshot alloc]
+        initWithSnapshot:_snapshot->MakeDocumentSnapshot(_documents[index])];
+    _wrappers[index] = wrapper;
+  }
+  return wrapper;
+}
+
+- (id)copyWithZone:(nullable NSZone *)zone {
+  // Immutable, so copies can share the wrappers already created.
+  return self;
+}
+
+@end
+
 @implementation FIRQuerySnapshot {
   DelayedConstructor<QuerySnapshot> _snapshot;
 
@@ -109,12 +170,7 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSArray<FIRQueryDocumentSnapshot *> *)documents {
   if (!_documents) {
-    NSMutableArray<FIRQueryDocumentSnapshot *> *result = [NSMutableArray array];
-    _snapshot->ForEachDocument([&result](DocumentSnapshot snapshot) {
-      [result addObject:[[FIRQueryDocumentSnapshot alloc] initWithSnapshot:std::move(snapshot)]];
-    });
-
-    _documents = result;
+    _documents = [[FSTQueryDocumentArray alloc] initWithSnapshot:*_snapshot];
   }
   return _documents;
 }
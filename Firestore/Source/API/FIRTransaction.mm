@@ -17,6 +17,7 @@
 #import "FIRTransaction.h"
 
 #include <memory>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -29,6 +30,7 @@
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/core/user_data.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
 #include "Firestore/core/src/firebase/firestore/util/exception.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -39,6 +41,8 @@ using firebase::firestore::core::ParsedSetData;
 using firebase::firestore::core::ParsedUpdateData;
 using firebase::firestore::core::Transaction;
 using firebase::firestore::model::Document;
+using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::DocumentKeyHash;
 using firebase::firestore::model::MaybeDocument;
 using firebase::firestore::util::MakeNSError;
 using firebase::firestore::util::Status;
@@ -118,57 +122,75 @@ NS_ASSUME_NONNULL_BEGIN
   return self;
 }
 
-- (void)getDocument:(FIRDocumentReference *)document
-         completion:(void (^)(FIRDocumentSnapshot *_Nullable document,
-                              NSError *_Nullable error))completion {
-  [self validateReference:document];
+- (void)getDocuments:(NSArray<FIRDocumentReference *> *)documents
+          completion:(void (^)(NSArray<FIRDocumentSnapshot *> *_Nullable snapshots,
+                               NSError *_Nullable error))completion {
+  std::vector<DocumentKey> keys;
+  keys.reserve(documents.count);
+  for (FIRDocumentReference *document in documents) {
+    [self validateReference:document];
+    keys.push_back(document.key);
+  }
+
   _internalTransaction->Lookup(
-      {document.key},
-      [self, document, completion](const StatusOr<std::vector<MaybeDocument>> &maybe_documents) {
+      keys, [self, keys, completion](const StatusOr<std::vector<MaybeDocument>> &maybe_documents) {
         if (!maybe_documents.ok()) {
           completion(nil, MakeNSError(maybe_documents.status()));
           return;
         }
 
-        const auto &documents = maybe_documents.ValueOrDie();
-        HARD_ASSERT(documents.size() == 1, "Mismatch in docs returned from document lookup.");
-        const MaybeDocument &internalDoc = documents.front();
-        if (internalDoc.is_no_document()) {
-          FIRDocumentSnapshot *doc =
-              [[FIRDocumentSnapshot alloc] initWithFirestore:self.firestore.wrapped
-                                                 documentKey:document.key
-                                                    document:absl::nullopt
-                                                   fromCache:false
-                                            hasPendingWrites:false];
-          completion(doc, nil);
-        } else if (internalDoc.is_document()) {
-          FIRDocumentSnapshot *doc =
-              [[FIRDocumentSnapshot alloc] initWithFirestore:self.firestore.wrapped
-                                                 documentKey:internalDoc.key()
-                                                    document:Document(internalDoc)
-                                                   fromCache:false
-                                            hasPendingWrites:false];
-          completion(doc, nil);
-        } else {
-          HARD_FAIL("BatchGetDocumentsRequest returned unexpected document type: %s",
-                    internalDoc.type());
+        // The lookup returns the documents sorted by key, so match them back up with the
+        // references.
+        std::unordered_map<DocumentKey, MaybeDocument, DocumentKeyHash> found;
+        for (const MaybeDocument &internalDoc : maybe_documents.ValueOrDie()) {
+          found.emplace(internalDoc.key(), internalDoc);
+        }
+
+        NSMutableArray<FIRDocumentSnapshot *> *snapshots =
+            [NSMutableArray arrayWithCapacity:keys.size()];
+        for (const DocumentKey &key : keys) {
+          auto found_iter = found.find(key);
+          HARD_ASSERT(found_iter != found.end(), "Mismatch in docs returned from document lookup.");
+          [snapshots addObject:[self snapshotForKey:key document:found_iter->second]];
         }
+        completion(snapshots, nil);
       });
 }
 
-- (FIRDocumentSnapshot *_Nullable)getDocument:(FIRDocumentReference *)document
-                                        error:(NSError *__autoreleasing *)error {
-  [self validateReference:document];
+- (FIRDocumentSnapshot *)snapshotForKey:(const DocumentKey &)key
+                               document:(const MaybeDocument &)internalDoc {
+  if (internalDoc.is_no_document()) {
+    return [[FIRDocumentSnapshot alloc] initWithFirestore:self.firestore.wrapped
+                                              documentKey:key
+                                                 document:absl::nullopt
+                                                fromCache:false
+                                         hasPendingWrites:false];
+  } else if (internalDoc.is_document()) {
+    return [[FIRDocumentSnapshot alloc] initWithFirestore:self.firestore.wrapped
+                                              documentKey:key
+                                                 document:Document(internalDoc)
+                                                fromCache:false
+                                         hasPendingWrites:false];
+  } else {
+    HARD_FAIL("BatchGetDocumentsRequest returned unexpected document type: %s",
+              internalDoc.type());
+  }
+}
+
+- (NSArray<FIRDocumentSnapshot *> *_Nullable)getDocuments:
+                                                 (NSArray<FIRDocumentReference *> *)documents
+                                                    error:(NSError *__autoreleasing *)error {
   dispatch_semaphore_t semaphore = dispatch_semaphore_create(0);
-  __block FIRDocumentSnapshot *result;
+  __block NSArray<FIRDocumentSnapshot *> *result;
   // We have to explicitly assign the innerError into a local to cause it to retain correctly.
   __block NSError *outerError = nil;
-  [self getDocument:document
-         completion:^(FIRDocumentSnapshot *_Nullable snapshot, NSError *_Nullable innerError) {
-           result = snapshot;
-           outerError = innerError;
-           dispatch_semaphore_signal(semaphore);
-         }];
+  [self getDocuments:documents
+          completion:^(NSArray<FIRDocumentSnapshot *> *_Nullable snapshots,
+                       NSError *_Nullable innerError) {
+            result = snapshots;
+            outerError = innerError;
+            dispatch_semaphore_signal(semaphore);
+          }];
   dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
   if (error) {
     *error = outerError;
@@ -176,6 +198,11 @@ NS_ASSUME_NONNULL_BEGIN
   return result;
 }
 
+- (FIRDocumentSnapshot *_Nullable)getDocument:(FIRDocumentReference *)document
+                                        error:(NSError *__autoreleasing *)error {
+  return [self getDocuments:@[ document ] error:error].firstObject;
+}
+
 - (void)validateReference:(FIRDocumentReference *)reference {
   if (reference.firestore != self.firestore) {
     ThrowInvalidArgument("Provided document reference is from a different Firestore instance.");
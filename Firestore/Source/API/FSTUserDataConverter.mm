@@ -16,6 +16,8 @@
 
 #import "Firestore/Source/API/FSTUserDataConverter.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <set>
 #include <string>
@@ -104,6 +106,86 @@ NS_ASSUME_NONNULL_BEGIN
 
 #pragma mark - Conversion helpers
 
+namespace {
+
+/** The kinds of values users can pass, named after the classes that hold them. */
+enum class ValueKind {
+  Dictionary,
+  FieldValue,
+  Array,
+  Null,
+  Number,
+  String,
+  Date,
+  Timestamp,
+  GeoPoint,
+  Data,
+  DocumentKeyReference,
+  Unsupported,
+};
+
+ValueKind ClassifyClass(Class cls) {
+  if ([cls isSubclassOfClass:[NSDictionary class]]) {
+    return ValueKind::Dictionary;
+  } else if ([cls isSubclassOfClass:[FIRFieldValue class]]) {
+    return ValueKind::FieldValue;
+  } else if ([cls isSubclassOfClass:[NSArray class]]) {
+    return ValueKind::Array;
+  } else if (cls == [NSNull class]) {
+    return ValueKind::Null;
+  } else if ([cls isSubclassOfClass:[NSNumber class]]) {
+    return ValueKind::Number;
+  } else if ([cls isSubclassOfClass:[NSString class]]) {
+    return ValueKind::String;
+  } else if ([cls isSubclassOfClass:[NSDate class]]) {
+    return ValueKind::Date;
+  } else if ([cls isSubclassOfClass:[FIRTimestamp class]]) {
+    return ValueKind::Timestamp;
+  } else if ([cls isSubclassOfClass:[FIRGeoPoint class]]) {
+    return ValueKind::GeoPoint;
+  } else if ([cls isSubclassOfClass:[NSData class]]) {
+    return ValueKind::Data;
+  } else if ([cls isSubclassOfClass:[FSTDocumentKeyReference class]]) {
+    return ValueKind::DocumentKeyReference;
+  } else {
+    return ValueKind::Unsupported;
+  }
+}
+
+/**
+ * Returns the kind of the given value.
+ *
+ * User data holds instances of only a few distinct classes, mostly the private subclasses of the
+ * Foundation class clusters, so each thread remembers the kinds of the classes it has seen in a
+ * small direct-mapped table. Most values are then classified with a single lookup instead of a
+ * chain of class checks.
+ */
+ValueKind KindOfValue(id _Nullable value) {
+  if (!value) {
+    return ValueKind::Null;
+  }
+
+  struct Entry {
+    // Classes are never deallocated, so the table doesn't retain them.
+    __unsafe_unretained Class cls;
+    ValueKind kind;
+  };
+  static constexpr size_t kCacheSize = 32;
+  thread_local Entry cache[kCacheSize] = {};
+
+  // Use -class rather than the isa pointer, so that proxies report the class of the objects they
+  // stand for, as they do for -isKindOfClass:.
+  Class cls = [value class];
+  Entry &entry = cache[(reinterpret_cast<uintptr_t>(cls) >> 4) % kCacheSize];
+  if (entry.cls != cls) {
+    entry.cls = cls;
+    entry.kind = ClassifyClass(cls);
+  }
+  return entry.kind;
+}
+
+}  // namespace
+
 #pragma mark - FSTUserDataConverter
 
 @interface FSTUserDataConverter ()
@@ -172,14 +254,14 @@ NS_ASSUME_NONNULL_BEGIN
             path.CanonicalString());
       }
 
-      validatedFieldPaths.insert(path);
+      validatedFieldPaths.insert(std::move(path));
     }
 
     return std::move(accumulator)
-        .MergeData(updateObject, FieldMask{std::move(validatedFieldPaths)});
+        .MergeData(std::move(updateObject), FieldMask{std::move(validatedFieldPaths)});
 
   } else {
-    return std::move(accumulator).MergeData(updateObject);
+    return std::move(accumulator).MergeData(std::move(updateObject));
   }
 }
 
@@ -194,7 +276,9 @@ NS_ASSUME_NONNULL_BEGIN
 
   ParseAccumulator accumulator{UserDataSource::Update};
   __block ParseContext context = accumulator.RootContext();
-  __block ObjectValue updateData = ObjectValue::Empty();
+  // Collect all the fields first so that each map is only built once, however many of the fields
+  // it holds.
+  __block ObjectValue::Builder updateData{ObjectValue::Empty()};
 
   [dict enumerateKeysAndObjectsUsingBlock:^(id key, id value, BOOL *stop) {
     FieldPath path;
@@ -215,13 +299,13 @@ NS_ASSUME_NONNULL_BEGIN
       absl::optional<FieldValue> parsedValue = [self parseData:value
                                                        context:context.ChildContext(path)];
       if (parsedValue) {
-        context.AddToFieldMask(path);
-        updateData = updateData.Set(path, *parsedValue);
+        updateData.Set(path, *parsedValue);
+        context.AddToFieldMask(std::move(path));
       }
     }
   }];
 
-  return std::move(accumulator).UpdateData(updateData);
+  return std::move(accumulator).UpdateData(updateData.Build());
 }
 
 - (FieldValue)parsedQueryValue:(id)input {
@@ -251,10 +335,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (absl::optional<FieldValue>)parseData:(id)input context:(ParseContext &&)context {
   input = self.preConverter(input);
-  if ([input isKindOfClass:[NSDictionary class]]) {
+  ValueKind kind = KindOfValue(input);
+  if (kind == ValueKind::Dictionary) {
     return [self parseDictionary:(NSDictionary *)input context:std::move(context)];
 
-  } else if ([input isKindOfClass:[FIRFieldValue class]]) {
+  } else if (kind == ValueKind::FieldValue) {
     // FieldValues usually parse into transforms (except FieldValue.delete()) in which case we
     // do not want to include this field in our parsed data (as doing so will overwrite the field
     // directly prior to the transform trying to transform it). So we don't call appendToFieldMask
@@ -269,7 +354,7 @@ NS_ASSUME_NONNULL_BEGIN
       context.AddToFieldMask(*context.path());
     }
 
-    if ([input isKindOfClass:[NSArray class]]) {
+    if (kind == ValueKind::Array) {
       // TODO(b/34871131): Include the path containing the array in the error message.
       // In the case of IN queries, the parsed data is an array (representing the set of values to
       // be included for the IN query) that may directly contain additional arrays (each
@@ -279,7 +364,7 @@ NS_ASSUME_NONNULL_BEGIN
       }
       return [self parseArray:(NSArray *)input context:std::move(context)];
     } else {
-      return [self parseScalarValue:input context:std::move(context)];
+      return [self parseScalarValue:input kind:kind context:std::move(context)];
     }
   }
 }
@@ -293,18 +378,23 @@ NS_ASSUME_NONNULL_BEGIN
     }
     return ObjectValue::Empty().AsFieldValue();
   } else {
-    __block ObjectValue result = ObjectValue::Empty();
+    // Build the map in one go from its sorted fields, rather than inserting them one at a time.
+    __block std::vector<std::pair<std::string, FieldValue>> fields;
+    fields.reserve(dict.count);
 
     [dict enumerateKeysAndObjectsUsingBlock:^(NSString *key, id value, BOOL *stop) {
-      absl::optional<FieldValue> parsedValue =
-          [self parseData:value context:context.ChildContext(util::MakeString(key))];
+      std::string fieldName = util::MakeString(key);
+      absl::optional<FieldValue> parsedValue = [self parseData:value
+                                                       context:context.ChildContext(fieldName)];
       if (parsedValue) {
-        FieldPath path = FieldPath{util::MakeString(key)};
-        result = result.Set(path, *parsedValue);
+        fields.emplace_back(std::move(fieldName), std::move(*parsedValue));
       }
     }];
 
-    return result;
+    std::sort(fields.begin(), fields.end(),
+              [](const std::pair<std::string, FieldValue> &lhs,
+                 const std::pair<std::string, FieldValue> &rhs) { return lhs.first < rhs.first; });
+    return FieldValue::FromMap(FieldValue::Map::FromSortedRange(fields.begin(), fields.end()));
   }
 }
 
@@ -393,13 +483,16 @@ NS_ASSUME_NONNULL_BEGIN
  * any value outside what is representable by int64_t (a signed 64-bit value) will throw an
  * exception.
  *
+ * @param kind The kind of `input`, as returned by `KindOfValue`.
  * @return The parsed value.
  */
-- (absl::optional<FieldValue>)parseScalarValue:(nullable id)input context:(ParseContext &&)context {
-  if (!input || [input isMemberOfClass:[NSNull class]]) {
+- (absl::optional<FieldValue>)parseScalarValue:(nullable id)input
+                                          kind:(ValueKind)kind
+                                       context:(ParseContext &&)context {
+  if (kind == ValueKind::Null) {
     return FieldValue::Null();
 
-  } else if ([input isKindOfClass:[NSNumber class]]) {
+  } else if (kind == ValueKind::Number) {
     // Recover the underlying type of the number, using the method described here:
     // http://stackoverflow.com/questions/2518761/get-type-of-nsnumber
     const char *cType = [input objCType];
@@ -463,26 +556,26 @@ NS_ASSUME_NONNULL_BEGIN
         HARD_FAIL("Unknown NSNumber objCType %s on %s", cType, input);
     }
 
-  } else if ([input isKindOfClass:[NSString class]]) {
+  } else if (kind == ValueKind::String) {
     return FieldValue::FromString(util::MakeString(input));
 
-  } else if ([input isKindOfClass:[NSDate class]]) {
+  } else if (kind == ValueKind::Date) {
     NSDate *inputDate = input;
     return FieldValue::FromTimestamp(api::MakeTimestamp(inputDate));
 
-  } else if ([input isKindOfClass:[FIRTimestamp class]]) {
+  } else if (kind == ValueKind::Timestamp) {
     FIRTimestamp *inputTimestamp = input;
     Timestamp timestamp = TimestampInternal::Truncate(api::MakeTimestamp(inputTimestamp));
     return FieldValue::FromTimestamp(timestamp);
 
-  } else if ([input isKindOfClass:[FIRGeoPoint class]]) {
+  } else if (kind == ValueKind::GeoPoint) {
     return FieldValue::FromGeoPoint(api::MakeGeoPoint(input));
 
-  } else if ([input isKindOfClass:[NSData class]]) {
+  } else if (kind == ValueKind::Data) {
     NSData *inputData = input;
     return FieldValue::FromBlob(MakeByteString(inputData));
 
-  } else if ([input isKindOfClass:[FSTDocumentKeyReference class]]) {
+  } else if (kind == ValueKind::DocumentKeyReference) {
     FSTDocumentKeyReference *reference = input;
     if (reference.databaseID != _databaseID) {
       const DatabaseId &other = reference.databaseID;
@@ -122,6 +122,20 @@ NS_SWIFT_NAME(Transaction)
                                         error:(NSError *__autoreleasing *)error
     NS_SWIFT_NAME(getDocument(_:));
 
+/**
+ * Reads the documents referenced by `documents` with a single request, which is
+ * considerably faster than reading them one by one.
+ *
+ * @param documents References to the documents to be read.
+ * @param error An out parameter to capture an error, if one occurred.
+ * @return Snapshots of the documents, in the order of `documents`, or nil if an error
+ *     occurred.
+ */
+- (NSArray<FIRDocumentSnapshot *> *_Nullable)getDocuments:
+                                                 (NSArray<FIRDocumentReference *> *)documents
+                                                    error:(NSError *__autoreleasing *)error
+    NS_SWIFT_NAME(getDocuments(_:));
+
 @end
 
 NS_ASSUME_NONNULL_END
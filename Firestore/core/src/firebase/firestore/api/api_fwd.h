@@ -29,6 +29,7 @@ class EventListener;
 
 namespace api {
 
+class BulkWriter;
 class CollectionReference;
 class DocumentChange;
 class DocumentReference;
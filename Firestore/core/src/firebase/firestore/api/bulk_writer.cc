@@ -0,0 +1,107 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/api/bulk_writer.h"
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/api/document_reference.h"
+#include "Firestore/core/src/firebase/firestore/api/firestore.h"
+#include "Firestore/core/src/firebase/firestore/core/bulk_writer.h"
+#include "Firestore/core/src/firebase/firestore/core/firestore_client.h"
+#include "Firestore/core/src/firebase/firestore/core/user_data.h"
+#include "Firestore/core/src/firebase/firestore/model/delete_mutation.h"
+#include "Firestore/core/src/firebase/firestore/util/exception.h"
+
+namespace firebase {
+namespace firestore {
+namespace api {
+
+using model::DeleteMutation;
+using model::Mutation;
+using model::Precondition;
+using util::ThrowIllegalState;
+using util::ThrowInvalidArgument;
+
+BulkWriter::BulkWriter(std::shared_ptr<Firestore> firestore)
+    : firestore_{std::move(firestore)},
+      writer_{firestore_->client()->CreateBulkWriter()} {
+}
+
+void BulkWriter::SetData(const DocumentReference& reference,
+                         core::ParsedSetData&& set_data,
+                         util::StatusCallback callback) {
+  VerifyNotClosed();
+  ValidateReference(reference);
+
+  writer_->Write(
+      std::move(set_data).ToMutations(reference.key(), Precondition::None()),
+      std::move(callback));
+}
+
+void BulkWriter::UpdateData(const DocumentReference& reference,
+                            core::ParsedUpdateData&& update_data,
+                            util::StatusCallback callback) {
+  VerifyNotClosed();
+  ValidateReference(reference);
+
+  writer_->Write(std::move(update_data)
+                     .ToMutations(reference.key(), Precondition::Exists(true)),
+                 std::move(callback));
+}
+
+void BulkWriter::DeleteData(const DocumentReference& reference,
+                            util::StatusCallback callback) {
+  VerifyNotClosed();
+  ValidateReference(reference);
+
+  std::vector<Mutation> mutations;
+  mutations.push_back(DeleteMutation(reference.key(), Precondition::None()));
+  writer_->Write(std::move(mutations), std::move(callback));
+}
+
+void BulkWriter::Flush(util::StatusCallback callback) {
+  VerifyNotClosed();
+  writer_->Flush(std::move(callback));
+}
+
+void BulkWriter::Close(util::StatusCallback callback) {
+  VerifyNotClosed();
+
+  closed_ = true;
+  writer_->Flush(std::move(callback));
+}
+
+void BulkWriter::VerifyNotClosed() const {
+  if (closed_) {
+    ThrowIllegalState(
+        "A bulk writer can no longer be used after close has been called.");
+  }
+}
+
+void BulkWriter::ValidateReference(const DocumentReference& reference) const {
+  if (reference.firestore() != firestore_) {
+    ThrowInvalidArgument(
+        "Provided document reference is from a different "
+        "Firestore instance.");
+  }
+}
+
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
+
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/api/api_fwd.h"
+#include "Firestore/core/src/firebase/firestore/core/core_fwd.h"
+#include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
+
+namespace firebase {
+namespace firestore {
+namespace api {
+
+/**
+ * Writes large numbers of documents in independent, non-atomic commits. See
+ * `core::BulkWriter` for how writes are scheduled and retried.
+ *
+ * Unlike `WriteBatch`, each write reports its own outcome through its
+ * callback, and a failed write does not affect the others.
+ */
+class BulkWriter {
+ public:
+  explicit BulkWriter(std::shared_ptr<Firestore> firestore);
+
+  void SetData(const DocumentReference& reference,
+               core::ParsedSetData&& set_data,
+               util::StatusCallback callback);
+  void UpdateData(const DocumentReference& reference,
+                  core::ParsedUpdateData&& update_data,
+                  util::StatusCallback callback);
+  void DeleteData(const DocumentReference& reference,
+                  util::StatusCallback callback);
+
+  /**
+   * Invokes the callback once all writes made so far have completed,
+   * successfully or not.
+   */
+  void Flush(util::StatusCallback callback);
+
+  /**
+   * Like `Flush`, but also prevents any further writes through this
+   * `BulkWriter`.
+   */
+  void Close(util::StatusCallback callback);
+
+  const std::shared_ptr<Firestore>& firestore() const {
+    return firestore_;
+  }
+
+ private:
+  std::shared_ptr<Firestore> firestore_;
+  std::shared_ptr<core::BulkWriter> writer_;
+  bool closed_ = false;
+
+  void VerifyNotClosed() const;
+  void ValidateReference(const DocumentReference& reference) const;
+};
+
+}  // namespace api
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_BULK_WRITER_H_
@@ -117,7 +117,16 @@ void DocumentReference::GetDocument(Source source,
     firestore_->client()->GetDocumentFromLocalCache(*this, std::move(callback));
     return;
   }
+  if (source == Source::Server) {
+    firestore_->client()->GetDocumentFromServer(*this, std::move(callback));
+    return;
+  }
 
+  GetDocumentByListening(source, std::move(callback));
+}
+
+void DocumentReference::GetDocumentByListening(
+    Source source, DocumentSnapshotListener&& callback) {
   ListenOptions options(
       /*include_query_metadata_changes=*/true,
       /*include_document_metadata_changes=*/true,
@@ -231,9 +240,14 @@ std::unique_ptr<ListenerRegistration> DocumentReference::AddSnapshotListener(
   auto view_listener =
       absl::make_unique<Converter>(this, std::move(user_listener));
 
-  // Call the view_listener on the user Executor.
+  // Call the view_listener on the Executor of the options, by default the user
+  // Executor.
   auto async_listener = AsyncEventListener<ViewSnapshot>::Create(
-      firestore_->client()->user_executor(), std::move(view_listener));
+      options.executor().value_or(firestore_->client()->user_executor()),
+      std::move(view_listener));
+  if (options.conflate_snapshots()) {
+    async_listener->ConflateEvents(ViewSnapshot::Merge);
+  }
 
   core::Query query(key_.path());
   std::shared_ptr<QueryListener> query_listener =
@@ -72,6 +72,14 @@ class DocumentReference {
 
   void GetDocument(Source source, DocumentSnapshotListener&& callback);
 
+  /**
+   * Reads the document by listening to it until it is in sync with the
+   * backend. Unlike a direct read from the server, the result includes
+   * pending local writes.
+   */
+  void GetDocumentByListening(Source source,
+                              DocumentSnapshotListener&& callback);
+
   std::unique_ptr<ListenerRegistration> AddSnapshotListener(
       core::ListenOptions options, DocumentSnapshotListener&& listener);
 
@@ -18,6 +18,7 @@
 
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/api/bulk_writer.h"
 #include "Firestore/core/src/firebase/firestore/api/collection_reference.h"
 #include "Firestore/core/src/firebase/firestore/api/document_reference.h"
 #include "Firestore/core/src/firebase/firestore/api/listener_registration.h"
@@ -127,6 +128,11 @@ WriteBatch Firestore::GetBatch() {
   return WriteBatch(shared_from_this());
 }
 
+BulkWriter Firestore::GetBulkWriter() {
+  EnsureClientConfigured();
+  return BulkWriter(shared_from_this());
+}
+
 core::Query Firestore::GetCollectionGroup(std::string collection_id) {
   EnsureClientConfigured();
 
@@ -187,6 +193,15 @@ void Firestore::DisableNetwork(util::StatusCallback callback) {
   client_->DisableNetwork(std::move(callback));
 }
 
+void Firestore::ReleaseMemory(std::function<void(size_t)> callback) {
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  // Don't start the client just to release the memory it hasn't taken up.
+  if (!client_) return;
+
+  client_->ReleaseMemory(std::move(callback));
+}
+
 std::unique_ptr<ListenerRegistration> Firestore::AddSnapshotsInSyncListener(
     std::unique_ptr<core::EventListener<Empty>> listener) {
   EnsureClientConfigured();
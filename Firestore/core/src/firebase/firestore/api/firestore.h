@@ -79,6 +79,7 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   CollectionReference GetCollection(const std::string& collection_path);
   DocumentReference GetDocument(const std::string& document_path);
   WriteBatch GetBatch();
+  BulkWriter GetBulkWriter();
   core::Query GetCollectionGroup(std::string collection_id);
 
   void RunTransaction(core::TransactionUpdateCallback update_callback,
@@ -93,6 +94,12 @@ class Firestore : public std::enable_shared_from_this<Firestore> {
   void EnableNetwork(util::StatusCallback callback);
   void DisableNetwork(util::StatusCallback callback);
 
+  /**
+   * See `FirestoreClient::ReleaseMemory`. Does nothing, and doesn't call the
+   * callback, if the client hasn't started yet or has been terminated.
+   */
+  void ReleaseMemory(std::function<void(size_t)> callback);
+
  private:
   void EnsureClientConfigured();
   core::DatabaseInfo MakeDatabaseInfo() const;
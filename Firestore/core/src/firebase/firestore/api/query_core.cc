@@ -58,6 +58,7 @@ using model::FieldValue;
 using model::ResourcePath;
 using util::Status;
 using util::StatusOr;
+using util::StatusOrCallback;
 using util::ThrowInvalidArgument;
 
 using Operator = Filter::Operator;
@@ -81,7 +82,16 @@ void Query::GetDocuments(Source source, QuerySnapshotListener&& callback) {
                                                      std::move(callback));
     return;
   }
+  if (source == Source::Server) {
+    firestore_->client()->GetDocumentsFromServer(*this, std::move(callback));
+    return;
+  }
+
+  GetDocumentsByListening(source, std::move(callback));
+}
 
+void Query::GetDocumentsByListening(Source source,
+                                    QuerySnapshotListener&& callback) {
   ListenOptions options(
       /*include_query_metadata_changes=*/true,
       /*include_document_metadata_changes=*/true,
@@ -138,6 +148,16 @@ void Query::GetDocuments(Source source, QuerySnapshotListener&& callback) {
   listener_unowned->Resolve(std::move(registration));
 }
 
+void Query::Count(Source source, StatusOrCallback<int64_t> callback) const {
+  ValidateHasExplicitOrderByForLimitToLast();
+  firestore_->client()->CountQuery(query_, source, std::move(callback));
+}
+
+void Query::Explain(local::QueryExplanationCallback callback) const {
+  ValidateHasExplicitOrderByForLimitToLast();
+  firestore_->client()->ExplainQuery(query_, std::move(callback));
+}
+
 std::unique_ptr<ListenerRegistration> Query::AddSnapshotListener(
     ListenOptions options, QuerySnapshotListener&& user_listener) {
   ValidateHasExplicitOrderByForLimitToLast();
@@ -174,9 +194,14 @@ std::unique_ptr<ListenerRegistration> Query::AddSnapshotListener(
   auto view_listener =
       absl::make_unique<Converter>(this, std::move(user_listener));
 
-  // Call the view_listener on the user Executor.
+  // Call the view_listener on the Executor of the options, by default the user
+  // Executor.
   auto async_listener = AsyncEventListener<ViewSnapshot>::Create(
-      firestore_->client()->user_executor(), std::move(view_listener));
+      options.executor().value_or(firestore_->client()->user_executor()),
+      std::move(view_listener));
+  if (options.conflate_snapshots()) {
+    async_listener->ConflateEvents(ViewSnapshot::Merge);
+  }
 
   std::shared_ptr<QueryListener> query_listener =
       firestore_->client()->ListenToQuery(this->query(), options,
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_QUERY_CORE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_API_QUERY_CORE_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -25,6 +26,8 @@
 #include "Firestore/core/src/firebase/firestore/core/core_fwd.h"
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/query_explanation.h"
+#include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
 
 namespace firebase {
 namespace firestore {
@@ -66,6 +69,33 @@ class Query {
    */
   void GetDocuments(Source source, QuerySnapshotListener&& callback);
 
+  /**
+   * Reads the documents matching this query by listening to it until its
+   * results are in sync with the backend. Unlike a direct read from the
+   * server, the results include pending local writes.
+   */
+  void GetDocumentsByListening(Source source,
+                               QuerySnapshotListener&& callback);
+
+  /**
+   * Counts the documents matching this query, without reading them.
+   *
+   * @param source indicates whether the documents should be counted in the
+   *     cache only (`Source::Cache`), on the server only (`Source::Server`), or
+   *     to attempt the server and fall back to the cache (`Source::Default`).
+   * @param callback a callback to execute with the count.
+   */
+  void Count(Source source, util::StatusOrCallback<int64_t> callback) const;
+
+  /**
+   * Runs this query against the local cache and describes how it was
+   * executed, for debugging slow queries: which path the query engine took
+   * (re-using previous results, an index scan or a full collection scan), the
+   * documents read and matched, the mutation batches applied and the time
+   * spent in each phase. No listener is attached and no results are returned.
+   */
+  void Explain(local::QueryExplanationCallback callback) const;
+
   /**
    * Attaches a listener for QuerySnapshot events.
    *
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/api/query_snapshot.h"
 
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/api/document_change.h"
 #include "Firestore/core/src/firebase/firestore/api/document_snapshot.h"
@@ -67,16 +68,28 @@ size_t QuerySnapshot::Hash() const {
   return util::Hash(firestore_.get(), internal_query_, snapshot_, metadata_);
 }
 
+std::vector<Document> QuerySnapshot::GetDocuments() const {
+  const DocumentSet& document_set = snapshot_.documents();
+  std::vector<Document> result;
+  result.reserve(document_set.size());
+  for (const Document& document : document_set) {
+    result.push_back(document);
+  }
+  return result;
+}
+
+DocumentSnapshot QuerySnapshot::MakeDocumentSnapshot(
+    const Document& document) const {
+  bool has_pending_writes = snapshot_.mutated_keys().contains(document.key());
+  return DocumentSnapshot::FromDocument(
+      firestore_, document,
+      SnapshotMetadata(has_pending_writes, metadata_.from_cache()));
+}
+
 void QuerySnapshot::ForEachDocument(
     const std::function<void(DocumentSnapshot)>& callback) const {
-  DocumentSet document_set = snapshot_.documents();
-  bool from_cache = metadata_.from_cache();
-
-  for (const Document& document : document_set) {
-    bool has_pending_writes = snapshot_.mutated_keys().contains(document.key());
-    auto snap = DocumentSnapshot::FromDocument(
-        firestore_, document, SnapshotMetadata(has_pending_writes, from_cache));
-    callback(std::move(snap));
+  for (const Document& document : snapshot_.documents()) {
+    callback(MakeDocumentSnapshot(document));
   }
 }
 
@@ -20,12 +20,14 @@
 #include <functional>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/api/api_fwd.h"
 #include "Firestore/core/src/firebase/firestore/api/snapshot_metadata.h"
 #include "Firestore/core/src/firebase/firestore/core/event_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
 
 namespace firebase {
 namespace firestore {
@@ -71,6 +73,16 @@ class QuerySnapshot {
     return metadata_;
   }
 
+  /**
+   * Returns the documents in this snapshot in query order, without creating a
+   * `DocumentSnapshot` for each of them. Pass them to `MakeDocumentSnapshot`
+   * to create snapshots only for the documents that are actually read.
+   */
+  std::vector<model::Document> GetDocuments() const;
+
+  /** Returns the `DocumentSnapshot` for one of `GetDocuments()`. */
+  DocumentSnapshot MakeDocumentSnapshot(const model::Document& document) const;
+
   /** Iterates over the `DocumentSnapshots` that make up this query snapshot. */
   void ForEachDocument(
       const std::function<void(DocumentSnapshot)>& callback) const;
@@ -28,10 +28,59 @@ constexpr bool Settings::DefaultPersistenceEnabled;
 constexpr int64_t Settings::DefaultCacheSizeBytes;
 constexpr int64_t Settings::MinimumCacheSizeBytes;
 constexpr bool Settings::DefaultTimestampsInSnapshotsEnabled;
+constexpr bool Settings::DefaultDocumentSnapshotEnabled;
+constexpr bool Settings::DefaultWriteCoalescingEnabled;
+constexpr int Settings::DefaultSharedRpcPollingThreads;
+constexpr Settings::RpcCompression Settings::DefaultRpcCompression;
+constexpr int64_t Settings::DefaultRpcCompressionThresholdBytes;
+constexpr int Settings::DefaultGcSampleSize;
+constexpr int64_t Settings::DefaultLevelDbBlockCacheSizeBytes;
+constexpr int Settings::DefaultLevelDbBloomFilterBitsPerKey;
+constexpr int64_t Settings::DefaultLevelDbWriteBufferSizeBytes;
+constexpr bool Settings::DefaultLevelDbSharedBlockCacheEnabled;
+constexpr int Settings::DefaultLevelDbMaxOpenFiles;
+constexpr int64_t Settings::DefaultStreamIdleTimeoutMs;
+constexpr int64_t Settings::DefaultMaxStreamIdleTimeoutMs;
+constexpr int64_t Settings::DefaultRpcKeepaliveTimeMs;
+constexpr int64_t Settings::DefaultMaxTransactionReadStalenessMs;
+constexpr bool Settings::DefaultCompactMemoryCacheEnabled;
+constexpr int64_t Settings::DefaultMemoryCacheSnapshotIntervalMs;
+constexpr int Settings::DefaultMaxConcurrentLimboResolutions;
+constexpr bool Settings::DefaultContainedQueriesServedLocally;
+constexpr int Settings::DefaultWatchStreamCount;
+constexpr int64_t Settings::DefaultListenLingerMs;
+constexpr bool Settings::DefaultWriteCompactionEnabled;
+constexpr int Settings::DefaultMaxPendingWrites;
+constexpr int64_t Settings::DefaultMaxPendingWriteBytes;
+constexpr int64_t Settings::DefaultLevelDbGroupCommitDelayMs;
+constexpr bool Settings::DefaultLevelDbSyncMutationQueueWrites;
+constexpr bool Settings::DefaultLevelDbDocumentCompressionEnabled;
 
 size_t Settings::Hash() const {
   return util::Hash(host_, ssl_enabled_, persistence_enabled_,
-                    timestamps_in_snapshots_enabled_, cache_size_bytes_);
+                    timestamps_in_snapshots_enabled_, cache_size_bytes_,
+                    document_snapshot_enabled_, write_coalescing_enabled_,
+                    shared_rpc_polling_threads_,
+                    static_cast<int>(rpc_compression_),
+                    rpc_compression_threshold_bytes_, gc_sample_size_,
+                    leveldb_block_cache_size_bytes_,
+                    leveldb_bloom_filter_bits_per_key_,
+                    leveldb_write_buffer_size_bytes_, stream_idle_timeout_ms_,
+                    max_stream_idle_timeout_ms_, rpc_keepalive_time_ms_,
+                    max_transaction_read_staleness_ms_,
+                    compact_memory_cache_enabled_,
+                    memory_cache_snapshot_interval_ms_,
+                    leveldb_shared_block_cache_enabled_,
+                    leveldb_max_open_files_,
+                    max_concurrent_limbo_resolutions_,
+                    contained_queries_served_locally_, watch_stream_count_,
+                    listen_linger_ms_,
+                    write_compaction_enabled_, max_pending_writes_,
+                    max_pending_write_bytes_,
+                    leveldb_group_commit_delay_ms_,
+                    leveldb_sync_mutation_queue_writes_,
+                    leveldb_document_compression_enabled_,
+                    stream_recording_path_);
 }
 
 bool operator==(const Settings& lhs, const Settings& rhs) {
@@ -39,7 +88,48 @@ bool operator==(const Settings& lhs, const Settings& rhs) {
          lhs.persistence_enabled_ == rhs.persistence_enabled_ &&
          lhs.timestamps_in_snapshots_enabled_ ==
              rhs.timestamps_in_snapshots_enabled_ &&
-         lhs.cache_size_bytes_ == rhs.cache_size_bytes_;
+         lhs.cache_size_bytes_ == rhs.cache_size_bytes_ &&
+         lhs.document_snapshot_enabled_ == rhs.document_snapshot_enabled_ &&
+         lhs.write_coalescing_enabled_ == rhs.write_coalescing_enabled_ &&
+         lhs.shared_rpc_polling_threads_ == rhs.shared_rpc_polling_threads_ &&
+         lhs.rpc_compression_ == rhs.rpc_compression_ &&
+         lhs.rpc_compression_threshold_bytes_ ==
+             rhs.rpc_compression_threshold_bytes_ &&
+         lhs.gc_sample_size_ == rhs.gc_sample_size_ &&
+         lhs.leveldb_block_cache_size_bytes_ ==
+             rhs.leveldb_block_cache_size_bytes_ &&
+         lhs.leveldb_bloom_filter_bits_per_key_ ==
+             rhs.leveldb_bloom_filter_bits_per_key_ &&
+         lhs.leveldb_write_buffer_size_bytes_ ==
+             rhs.leveldb_write_buffer_size_bytes_ &&
+         lhs.stream_idle_timeout_ms_ == rhs.stream_idle_timeout_ms_ &&
+         lhs.max_stream_idle_timeout_ms_ == rhs.max_stream_idle_timeout_ms_ &&
+         lhs.rpc_keepalive_time_ms_ == rhs.rpc_keepalive_time_ms_ &&
+         lhs.max_transaction_read_staleness_ms_ ==
+             rhs.max_transaction_read_staleness_ms_ &&
+         lhs.compact_memory_cache_enabled_ ==
+             rhs.compact_memory_cache_enabled_ &&
+         lhs.memory_cache_snapshot_interval_ms_ ==
+             rhs.memory_cache_snapshot_interval_ms_ &&
+         lhs.leveldb_shared_block_cache_enabled_ ==
+             rhs.leveldb_shared_block_cache_enabled_ &&
+         lhs.leveldb_max_open_files_ == rhs.leveldb_max_open_files_ &&
+         lhs.max_concurrent_limbo_resolutions_ ==
+             rhs.max_concurrent_limbo_resolutions_ &&
+         lhs.contained_queries_served_locally_ ==
+             rhs.contained_queries_served_locally_ &&
+         lhs.watch_stream_count_ == rhs.watch_stream_count_ &&
+         lhs.listen_linger_ms_ == rhs.listen_linger_ms_ &&
+         lhs.write_compaction_enabled_ == rhs.write_compaction_enabled_ &&
+         lhs.max_pending_writes_ == rhs.max_pending_writes_ &&
+         lhs.max_pending_write_bytes_ == rhs.max_pending_write_bytes_ &&
+         lhs.leveldb_group_commit_delay_ms_ ==
+             rhs.leveldb_group_commit_delay_ms_ &&
+         lhs.leveldb_sync_mutation_queue_writes_ ==
+             rhs.leveldb_sync_mutation_queue_writes_ &&
+         lhs.leveldb_document_compression_enabled_ ==
+             rhs.leveldb_document_compression_enabled_ &&
+         lhs.stream_recording_path_ == rhs.stream_recording_path_;
 }
 
 }  // namespace api
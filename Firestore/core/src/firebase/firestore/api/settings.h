@@ -32,6 +32,13 @@ namespace api {
  */
 class Settings {
  public:
+  /** The compression applied to messages on gRPC streams. */
+  enum class RpcCompression {
+    None,
+    Gzip,
+    Deflate,
+  };
+
   // Note: a constexpr array of char (`char[]`) doesn't work with Visual Studio
   // 2015.
   static constexpr const char* DefaultHost = "firestore.googleapis.com";
@@ -41,6 +48,33 @@ class Settings {
   static constexpr int64_t MinimumCacheSizeBytes = 1 * 1024 * 1024;
   static constexpr int64_t CacheSizeUnlimited = -1;
   static constexpr bool DefaultTimestampsInSnapshotsEnabled = true;
+  static constexpr bool DefaultDocumentSnapshotEnabled = false;
+  static constexpr bool DefaultWriteCoalescingEnabled = false;
+  static constexpr int DefaultSharedRpcPollingThreads = 0;
+  static constexpr RpcCompression DefaultRpcCompression = RpcCompression::None;
+  static constexpr int64_t DefaultRpcCompressionThresholdBytes = 1024;
+  static constexpr int DefaultGcSampleSize = 0;
+  static constexpr int64_t DefaultLevelDbBlockCacheSizeBytes = 0;
+  static constexpr int DefaultLevelDbBloomFilterBitsPerKey = 10;
+  static constexpr int64_t DefaultLevelDbWriteBufferSizeBytes = 0;
+  static constexpr bool DefaultLevelDbSharedBlockCacheEnabled = false;
+  static constexpr int DefaultLevelDbMaxOpenFiles = 0;
+  static constexpr int64_t DefaultStreamIdleTimeoutMs = 60 * 1000;
+  static constexpr int64_t DefaultMaxStreamIdleTimeoutMs = 5 * 60 * 1000;
+  static constexpr int64_t DefaultRpcKeepaliveTimeMs = 30 * 1000;
+  static constexpr int64_t DefaultMaxTransactionReadStalenessMs = 0;
+  static constexpr bool DefaultCompactMemoryCacheEnabled = false;
+  static constexpr int64_t DefaultMemoryCacheSnapshotIntervalMs = 0;
+  static constexpr int DefaultMaxConcurrentLimboResolutions = 100;
+  static constexpr bool DefaultContainedQueriesServedLocally = true;
+  static constexpr int DefaultWatchStreamCount = 1;
+  static constexpr int64_t DefaultListenLingerMs = 0;
+  static constexpr bool DefaultWriteCompactionEnabled = false;
+  static constexpr int DefaultMaxPendingWrites = 0;
+  static constexpr int64_t DefaultMaxPendingWriteBytes = 0;
+  static constexpr int64_t DefaultLevelDbGroupCommitDelayMs = 0;
+  static constexpr bool DefaultLevelDbSyncMutationQueueWrites = true;
+  static constexpr bool DefaultLevelDbDocumentCompressionEnabled = false;
 
   Settings() = default;
 
@@ -82,6 +116,357 @@ class Settings {
     return cache_size_bytes_ != CacheSizeUnlimited;
   }
 
+  /**
+   * Whether persistence keeps a memory-mapped snapshot of the remote document
+   * cache for faster collection scans. The snapshot is rebuilt in the
+   * background and takes additional disk space roughly equal to the size of
+   * the cached documents. Has no effect if persistence is disabled.
+   */
+  void set_document_snapshot_enabled(bool value) {
+    document_snapshot_enabled_ = value;
+  }
+  bool document_snapshot_enabled() const {
+    return document_snapshot_enabled_;
+  }
+
+  /**
+   * Whether consecutive small writes are sent to the backend in a single
+   * request. Each write is still acknowledged separately.
+   */
+  void set_write_coalescing_enabled(bool value) {
+    write_coalescing_enabled_ = value;
+  }
+  bool write_coalescing_enabled() const {
+    return write_coalescing_enabled_;
+  }
+
+  /**
+   * If nonzero, the instance polls for gRPC completions on a pool of threads
+   * shared with all other instances that set this, instead of on a thread of
+   * its own. The pool is created with this many threads by the first instance
+   * that uses it. Useful for processes that run many instances at once.
+   */
+  void set_shared_rpc_polling_threads(int value) {
+    shared_rpc_polling_threads_ = value;
+  }
+  int shared_rpc_polling_threads() const {
+    return shared_rpc_polling_threads_;
+  }
+
+  /**
+   * The compression algorithm negotiated for the watch and write streams and
+   * for document lookups. The backend compresses its responses in kind, which
+   * mostly pays off for large initial listens.
+   */
+  void set_rpc_compression(RpcCompression value) {
+    rpc_compression_ = value;
+  }
+  RpcCompression rpc_compression() const {
+    return rpc_compression_;
+  }
+
+  /**
+   * Messages sent to the backend that are smaller than this many bytes are not
+   * compressed, even if `rpc_compression` is set.
+   */
+  void set_rpc_compression_threshold_bytes(int64_t value) {
+    rpc_compression_threshold_bytes_ = value;
+  }
+  int64_t rpc_compression_threshold_bytes() const {
+    return rpc_compression_threshold_bytes_;
+  }
+
+  /**
+   * If nonzero, garbage collection estimates which sequence numbers to collect
+   * from a random sample of this many targets and documents rather than from
+   * all of them. Larger samples give a more accurate estimate at the cost of
+   * more memory per collection.
+   */
+  void set_gc_sample_size(int value) {
+    gc_sample_size_ = value;
+  }
+  int gc_sample_size() const {
+    return gc_sample_size_;
+  }
+
+  /**
+   * The size of the in-memory cache of uncompressed LevelDB blocks, or zero to
+   * use LevelDB's default. Has no effect if persistence is disabled.
+   */
+  void set_leveldb_block_cache_size_bytes(int64_t value) {
+    leveldb_block_cache_size_bytes_ = value;
+  }
+  int64_t leveldb_block_cache_size_bytes() const {
+    return leveldb_block_cache_size_bytes_;
+  }
+
+  /**
+   * The number of bits per key of the bloom filters LevelDB keeps for its
+   * tables, or zero for no filters. The filters let lookups of keys that don't
+   * exist skip reading most tables, at the cost of some extra disk space.
+   * Has no effect if persistence is disabled.
+   */
+  void set_leveldb_bloom_filter_bits_per_key(int value) {
+    leveldb_bloom_filter_bits_per_key_ = value;
+  }
+  int leveldb_bloom_filter_bits_per_key() const {
+    return leveldb_bloom_filter_bits_per_key_;
+  }
+
+  /**
+   * The amount of data LevelDB buffers in memory before writing it out to a
+   * sorted table, or zero to use LevelDB's default. Larger buffers speed up
+   * bulk writes but take longer to recover on startup. Has no effect if
+   * persistence is disabled.
+   */
+  void set_leveldb_write_buffer_size_bytes(int64_t value) {
+    leveldb_write_buffer_size_bytes_ = value;
+  }
+  int64_t leveldb_write_buffer_size_bytes() const {
+    return leveldb_write_buffer_size_bytes_;
+  }
+
+  /**
+   * Whether the LevelDB databases of all instances in the process with this
+   * setting and the same `leveldb_block_cache_size_bytes` share one block
+   * cache, instead of each holding a cache of that size. Has no effect if
+   * persistence is disabled.
+   */
+  void set_leveldb_shared_block_cache_enabled(bool value) {
+    leveldb_shared_block_cache_enabled_ = value;
+  }
+  bool leveldb_shared_block_cache_enabled() const {
+    return leveldb_shared_block_cache_enabled_;
+  }
+
+  /**
+   * The number of table files LevelDB keeps open, or zero to use LevelDB's
+   * default. Processes with many instances can lower it to bound the file
+   * descriptors they use. Has no effect if persistence is disabled.
+   */
+  void set_leveldb_max_open_files(int value) {
+    leveldb_max_open_files_ = value;
+  }
+  int leveldb_max_open_files() const {
+    return leveldb_max_open_files_;
+  }
+
+  /**
+   * How long the watch and write streams stay open once they have nothing to
+   * do, so that they can be reused without reconnecting. Every time an idle
+   * stream gets reused, it stays open twice as long the next time, up to
+   * `max_stream_idle_timeout_ms`; apps that keep attaching and detaching
+   * listeners then keep their streams open instead of reconnecting and
+   * re-sending all their targets.
+   */
+  void set_stream_idle_timeout_ms(int64_t value) {
+    stream_idle_timeout_ms_ = value;
+  }
+  int64_t stream_idle_timeout_ms() const {
+    return stream_idle_timeout_ms_;
+  }
+
+  void set_max_stream_idle_timeout_ms(int64_t value) {
+    max_stream_idle_timeout_ms_ = value;
+  }
+  int64_t max_stream_idle_timeout_ms() const {
+    return max_stream_idle_timeout_ms_;
+  }
+
+  /**
+   * How often gRPC pings the backend to detect connections that died without
+   * the OS noticing.
+   */
+  void set_rpc_keepalive_time_ms(int64_t value) {
+    rpc_keepalive_time_ms_ = value;
+  }
+  int64_t rpc_keepalive_time_ms() const {
+    return rpc_keepalive_time_ms_;
+  }
+
+  /**
+   * How recently the watch stream must have delivered a consistent snapshot
+   * for transactions to read documents from the local cache instead of the
+   * backend. Only documents in the results of active listeners are read
+   * locally. The backend still checks the versions read when the transaction
+   * commits, so a stale read costs a retry, which then reads from the backend.
+   * Zero, the default, makes transactions always read from the backend.
+   */
+  void set_max_transaction_read_staleness_ms(int64_t value) {
+    max_transaction_read_staleness_ms_ = value;
+  }
+  int64_t max_transaction_read_staleness_ms() const {
+    return max_transaction_read_staleness_ms_;
+  }
+
+  /**
+   * Without persistence, keeps cached documents encoded rather than decoded,
+   * decoding them each time they are read. Takes a fraction of the memory,
+   * which suits processes that cache very many documents.
+   */
+  void set_compact_memory_cache_enabled(bool value) {
+    compact_memory_cache_enabled_ = value;
+  }
+  bool compact_memory_cache_enabled() const {
+    return compact_memory_cache_enabled_;
+  }
+
+  /**
+   * Without persistence, how often the memory cache is written to a file in
+   * the app's data directory, or zero to never write it. When set, a process
+   * that restarts loads the cache back from the file before it starts, so its
+   * listeners can show cached documents at once. The cache is also written
+   * when Firestore terminates.
+   */
+  void set_memory_cache_snapshot_interval_ms(int64_t value) {
+    memory_cache_snapshot_interval_ms_ = value;
+  }
+  int64_t memory_cache_snapshot_interval_ms() const {
+    return memory_cache_snapshot_interval_ms_;
+  }
+
+  /**
+   * How many documents in limbo, that is, cached documents the backend may have
+   * deleted, are looked up at once, or zero for no limit. The rest wait in a
+   * queue, documents in the results of more listeners first, so that a large
+   * change in query results doesn't open thousands of listens at once.
+   */
+  void set_max_concurrent_limbo_resolutions(int value) {
+    max_concurrent_limbo_resolutions_ = value;
+  }
+  int max_concurrent_limbo_resolutions() const {
+    return max_concurrent_limbo_resolutions_;
+  }
+
+  /**
+   * Serves a query whose results are a subset of those of a synced listener,
+   * such as the same collection with more filters, from the cache instead of
+   * watching it separately.
+   */
+  void set_contained_queries_served_locally(bool value) {
+    contained_queries_served_locally_ = value;
+  }
+  bool contained_queries_served_locally() const {
+    return contained_queries_served_locally_;
+  }
+
+  /**
+   * How many watch streams the listened targets are spread across. With more
+   * than one, a large initial load on one stream doesn't delay the snapshots
+   * of targets on the others.
+   */
+  void set_watch_stream_count(int value) {
+    watch_stream_count_ = value;
+  }
+  int watch_stream_count() const {
+    return watch_stream_count_;
+  }
+
+  /**
+   * How long the target of a query stays active after its last listener is
+   * removed, or zero to release it at once. A listener added for the same
+   * query in the meantime gets the latest snapshot at once, without
+   * allocating a target, running a local query or listening again.
+   */
+  void set_listen_linger_ms(int64_t value) {
+    listen_linger_ms_ = value;
+  }
+  int64_t listen_linger_ms() const {
+    return listen_linger_ms_;
+  }
+
+  /**
+   * Merges a write into the previous one if both only set or patch the same
+   * documents and the previous one hasn't been sent yet, so that repeated
+   * edits made offline upload only their final state.
+   */
+  void set_write_compaction_enabled(bool value) {
+    write_compaction_enabled_ = value;
+  }
+  bool write_compaction_enabled() const {
+    return write_compaction_enabled_;
+  }
+
+  /**
+   * The number of writes that can wait to be acknowledged by the backend, or
+   * zero for no limit. Writes made while the limit is reached fail with
+   * `resource-exhausted` without being applied, so that apps writing while
+   * offline for a long time slow down before the growing queue slows down
+   * every query.
+   */
+  void set_max_pending_writes(int value) {
+    max_pending_writes_ = value;
+  }
+  int max_pending_writes() const {
+    return max_pending_writes_;
+  }
+
+  /**
+   * The total size of the writes that can wait to be acknowledged by the
+   * backend, or zero for no limit. Behaves like `max_pending_writes`. Only
+   * enforced if persistence is enabled, since the memory cache doesn't track
+   * the size of its writes.
+   */
+  void set_max_pending_write_bytes(int64_t value) {
+    max_pending_write_bytes_ = value;
+  }
+  int64_t max_pending_write_bytes() const {
+    return max_pending_write_bytes_;
+  }
+
+  /**
+   * How long LevelDB holds on to committed transactions so that those that
+   * follow within the delay are written together, or zero to write each one
+   * as it commits. Has no effect if persistence is disabled.
+   */
+  void set_leveldb_group_commit_delay_ms(int64_t value) {
+    leveldb_group_commit_delay_ms_ = value;
+  }
+  int64_t leveldb_group_commit_delay_ms() const {
+    return leveldb_group_commit_delay_ms_;
+  }
+
+  /**
+   * Whether LevelDB waits for local writes to reach the disk before reporting
+   * them as saved, so that they survive a crash of the device. Writes of data
+   * received from the backend are never synced, since the backend can send
+   * it again, so heavy downloads don't wait on the disk. Has no effect if
+   * persistence is disabled.
+   */
+  void set_leveldb_sync_mutation_queue_writes(bool value) {
+    leveldb_sync_mutation_queue_writes_ = value;
+  }
+  bool leveldb_sync_mutation_queue_writes() const {
+    return leveldb_sync_mutation_queue_writes_;
+  }
+
+  /**
+   * Whether LevelDB stores cached documents compressed, with a dictionary
+   * built from the first documents of each collection, so that the cache size
+   * holds more documents at the cost of decompressing them when read.
+   * Documents already stored stay readable when this is turned off. Has no
+   * effect if persistence is disabled.
+   */
+  void set_leveldb_document_compression_enabled(bool value) {
+    leveldb_document_compression_enabled_ = value;
+  }
+  bool leveldb_document_compression_enabled() const {
+    return leveldb_document_compression_enabled_;
+  }
+
+  /**
+   * The file to record the responses of the watch and write streams to, or
+   * empty to not record them. Recordings capture production traffic so that
+   * it can be replayed in tests and benchmarks; they can hold any document the
+   * client receives, so only enable this for debugging.
+   */
+  void set_stream_recording_path(const std::string& value) {
+    stream_recording_path_ = value;
+  }
+  const std::string& stream_recording_path() const {
+    return stream_recording_path_;
+  }
+
   friend bool operator==(const Settings& lhs, const Settings& rhs);
 
   size_t Hash() const;
@@ -92,6 +477,43 @@ class Settings {
   bool persistence_enabled_ = DefaultPersistenceEnabled;
   bool timestamps_in_snapshots_enabled_ = DefaultTimestampsInSnapshotsEnabled;
   int64_t cache_size_bytes_ = DefaultCacheSizeBytes;
+  bool document_snapshot_enabled_ = DefaultDocumentSnapshotEnabled;
+  bool write_coalescing_enabled_ = DefaultWriteCoalescingEnabled;
+  int shared_rpc_polling_threads_ = DefaultSharedRpcPollingThreads;
+  RpcCompression rpc_compression_ = DefaultRpcCompression;
+  int64_t rpc_compression_threshold_bytes_ =
+      DefaultRpcCompressionThresholdBytes;
+  int gc_sample_size_ = DefaultGcSampleSize;
+  int64_t leveldb_block_cache_size_bytes_ = DefaultLevelDbBlockCacheSizeBytes;
+  int leveldb_bloom_filter_bits_per_key_ =
+      DefaultLevelDbBloomFilterBitsPerKey;
+  int64_t leveldb_write_buffer_size_bytes_ =
+      DefaultLevelDbWriteBufferSizeBytes;
+  bool leveldb_shared_block_cache_enabled_ =
+      DefaultLevelDbSharedBlockCacheEnabled;
+  int leveldb_max_open_files_ = DefaultLevelDbMaxOpenFiles;
+  int64_t stream_idle_timeout_ms_ = DefaultStreamIdleTimeoutMs;
+  int64_t max_stream_idle_timeout_ms_ = DefaultMaxStreamIdleTimeoutMs;
+  int64_t rpc_keepalive_time_ms_ = DefaultRpcKeepaliveTimeMs;
+  int64_t max_transaction_read_staleness_ms_ =
+      DefaultMaxTransactionReadStalenessMs;
+  bool compact_memory_cache_enabled_ = DefaultCompactMemoryCacheEnabled;
+  int64_t memory_cache_snapshot_interval_ms_ =
+      DefaultMemoryCacheSnapshotIntervalMs;
+  int max_concurrent_limbo_resolutions_ = DefaultMaxConcurrentLimboResolutions;
+  bool contained_queries_served_locally_ =
+      DefaultContainedQueriesServedLocally;
+  int watch_stream_count_ = DefaultWatchStreamCount;
+  int64_t listen_linger_ms_ = DefaultListenLingerMs;
+  bool write_compaction_enabled_ = DefaultWriteCompactionEnabled;
+  int max_pending_writes_ = DefaultMaxPendingWrites;
+  int64_t max_pending_write_bytes_ = DefaultMaxPendingWriteBytes;
+  int64_t leveldb_group_commit_delay_ms_ = DefaultLevelDbGroupCommitDelayMs;
+  bool leveldb_sync_mutation_queue_writes_ =
+      DefaultLevelDbSyncMutationQueueWrites;
+  bool leveldb_document_compression_enabled_ =
+      DefaultLevelDbDocumentCompressionEnabled;
+  std::string stream_recording_path_;
 };
 
 }  // namespace api
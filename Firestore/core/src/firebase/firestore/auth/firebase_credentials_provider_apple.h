@@ -23,13 +23,16 @@
 
 #import <Foundation/Foundation.h>
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/auth/token.h"
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 @class FIRApp;
 @protocol FIRAuthInterop;
@@ -50,6 +53,12 @@ namespace auth {
  * from the thread backing our internal worker queue and the callbacks from
  * FIRAuth will be executed on an arbitrary different thread.
  *
+ * The last token received is cached for a few minutes, during which `GetToken`
+ * calls back synchronously instead of waiting for FIRAuth to call back on
+ * another thread. Once the cached token gets old, it is refreshed in the
+ * background. The cache is dropped when the user changes or the token is
+ * invalidated.
+ *
  * For non-Apple desktop build, this is right now just a stub.
  */
 class FirebaseCredentialsProvider : public CredentialsProvider {
@@ -104,8 +113,27 @@ class FirebaseCredentialsProvider : public CredentialsProvider {
     std::mutex mutex;
 
     bool force_refresh = false;
+
+    /**
+     * Counter used to keep a request that was outstanding when the token was
+     * invalidated from caching the rejected token.
+     */
+    int invalidation_counter = 0;
+
+    /** The last token received for `current_user`, if still usable. */
+    absl::optional<Token> cached_token;
+    std::chrono::steady_clock::time_point cached_token_time;
+
+    /** Whether a background refresh of the cached token is outstanding. */
+    bool refreshing = false;
   };
 
+  /**
+   * Requests a token from FIRAuth, caches it and passes it to `completion`,
+   * if any.
+   */
+  void FetchToken(TokenListener completion);
+
   /**
    * Handle used to stop receiving auth changes once CredentialChangeListener is
    * removed.
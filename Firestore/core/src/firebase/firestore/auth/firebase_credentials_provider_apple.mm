@@ -29,6 +29,18 @@
 namespace firebase {
 namespace firestore {
 namespace auth {
+namespace {
+
+// FIRAuth hands out ID tokens that are valid for at least five more minutes,
+// refreshing them first if need be, so a token can be reused for a little less
+// than that without asking FIRAuth again.
+const auto kTokenCacheDuration = std::chrono::minutes(4);
+
+// Past this age, the cached token is still used but a fresh one is requested
+// in the background so that it's ready before the cached one expires.
+const auto kTokenRefreshAge = std::chrono::minutes(3);
+
+}  // namespace
 
 FirebaseCredentialsProvider::FirebaseCredentialsProvider(
     FIRApp* app, id<FIRAuthInterop> auth) {
@@ -60,6 +72,7 @@ FirebaseCredentialsProvider::FirebaseCredentialsProvider(
                     user_info[FIRAuthStateDidChangeInternalNotificationUIDKey];
                 contents->current_user = User::FromUid(user_id);
                 contents->token_counter++;
+                contents->cached_token.reset();
                 CredentialChangeListener listener = change_listener_;
                 if (listener) {
                   listener(contents->current_user);
@@ -80,9 +93,42 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
   HARD_ASSERT(auth_listener_handle_,
               "GetToken cannot be called after listener removed.");
 
+  absl::optional<Token> cached_token;
+  bool refresh = false;
+  {
+    std::lock_guard<std::mutex> lock(contents_->mutex);
+    auto age = std::chrono::steady_clock::now() - contents_->cached_token_time;
+    if (contents_->cached_token && !contents_->force_refresh &&
+        age < kTokenCacheDuration) {
+      cached_token = contents_->cached_token;
+      if (age >= kTokenRefreshAge && !contents_->refreshing) {
+        refresh = true;
+        contents_->refreshing = true;
+      }
+    }
+  }
+
+  if (!cached_token) {
+    FetchToken(std::move(completion));
+    return;
+  }
+
+  completion(std::move(*cached_token));
+  if (refresh) {
+    FetchToken(nullptr);
+  }
+}
+
+void FirebaseCredentialsProvider::FetchToken(TokenListener completion) {
+  std::unique_lock<std::mutex> lock(contents_->mutex);
   // Take note of the current value of the token_counter so that this method can
   // fail if there is a token change while the request is outstanding.
   int initial_token_counter = contents_->token_counter;
+  int initial_invalidation_counter = contents_->invalidation_counter;
+  bool force_refresh = contents_->force_refresh;
+  contents_->force_refresh = false;
+  // FIRAuth may call back synchronously.
+  lock.unlock();
 
   std::weak_ptr<Contents> weak_contents = contents_;
   void (^get_token_callback)(NSString*, NSError*) = ^(
@@ -93,20 +139,31 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
     }
 
     std::unique_lock<std::mutex> lock(contents->mutex);
+    if (!completion) {
+      contents->refreshing = false;
+    }
+
     if (initial_token_counter != contents->token_counter) {
       // Cancel the request since the user changed while the request was
       // outstanding so the response is likely for a previous user (which
       // user, we can't be sure).
-      completion(util::Status(Error::kAborted,
-                              "GetToken aborted due to token change."));
+      if (completion) {
+        completion(util::Status(Error::kAborted,
+                                "GetToken aborted due to token change."));
+      }
     } else {
       if (error == nil) {
-        if (token != nil) {
-          completion(Token{util::MakeString(token), contents->current_user});
-        } else {
-          completion(Token::Unauthenticated());
+        Token result = token != nil ? Token{util::MakeString(token),
+                                            contents->current_user}
+                                    : Token::Unauthenticated();
+        if (initial_invalidation_counter == contents->invalidation_counter) {
+          contents->cached_token.emplace(result);
+          contents->cached_token_time = std::chrono::steady_clock::now();
         }
-      } else {
+        if (completion) {
+          completion(std::move(result));
+        }
+      } else if (completion) {
         Error error_code = Error::kUnknown;
         if (error.domain == FIRFirestoreErrorDomain) {
           error_code = static_cast<Error>(error.code);
@@ -119,18 +176,20 @@ void FirebaseCredentialsProvider::GetToken(TokenListener completion) {
 
   // TODO(wilhuff): Need a better abstraction over a missing auth provider.
   if (contents_->auth) {
-    [contents_->auth getTokenForcingRefresh:contents_->force_refresh
+    [contents_->auth getTokenForcingRefresh:force_refresh
                                withCallback:get_token_callback];
   } else {
     // If there's no Auth provider, call back immediately with a nil
     // (unauthenticated) token.
     get_token_callback(nil, nil);
   }
-  contents_->force_refresh = false;
 }
 
 void FirebaseCredentialsProvider::InvalidateToken() {
+  std::lock_guard<std::mutex> lock(contents_->mutex);
   contents_->force_refresh = true;
+  contents_->invalidation_counter++;
+  contents_->cached_token.reset();
 }
 
 void FirebaseCredentialsProvider::SetCredentialChangeListener(
@@ -17,18 +17,18 @@
 #include "Firestore/core/src/firebase/firestore/core/array_contains_any_filter.h"
 
 #include <memory>
+#include <unordered_set>
 #include <utility>
 
-#include "Firestore/core/src/firebase/firestore/model/document.h"
-#include "absl/algorithm/container.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 namespace firebase {
 namespace firestore {
 namespace core {
 
-using model::Document;
 using model::FieldPath;
 using model::FieldValue;
+using model::FieldValueHash;
 
 using Operator = Filter::Operator;
 
@@ -37,13 +37,19 @@ class ArrayContainsAnyFilter::Rep : public FieldFilter::Rep {
   Rep(FieldPath field, FieldValue value)
       : FieldFilter::Rep(
             std::move(field), Operator::ArrayContainsAny, std::move(value)) {
+    const FieldValue::Array& array_value = this->value().array_value();
+    values_.insert(array_value.begin(), array_value.end());
   }
 
   Type type() const override {
     return Type::kArrayContainsAnyFilter;
   }
 
-  bool Matches(const model::Document& doc) const override;
+  bool MatchesValue(const FieldValue& lhs) const override;
+
+ private:
+  /** The values of the filter's array, so that matching doesn't scan it. */
+  std::unordered_set<FieldValue, FieldValueHash> values_;
 };
 
 ArrayContainsAnyFilter::ArrayContainsAnyFilter(FieldPath field,
@@ -51,16 +57,11 @@ ArrayContainsAnyFilter::ArrayContainsAnyFilter(FieldPath field,
     : FieldFilter(std::make_shared<Rep>(std::move(field), std::move(value))) {
 }
 
-bool ArrayContainsAnyFilter::Rep::Matches(const Document& doc) const {
-  const FieldValue::Array& array_value = value().array_value();
-  absl::optional<FieldValue> maybe_lhs = doc.field(field());
-  if (!maybe_lhs) return false;
-
-  const FieldValue& lhs = *maybe_lhs;
+bool ArrayContainsAnyFilter::Rep::MatchesValue(const FieldValue& lhs) const {
   if (lhs.type() != FieldValue::Type::Array) return false;
 
   for (const auto& val : lhs.array_value()) {
-    if (absl::c_linear_search(array_value, val)) {
+    if (values_.find(val) != values_.end()) {
       return true;
     }
   }
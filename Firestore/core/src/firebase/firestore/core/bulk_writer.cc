@@ -0,0 +1,272 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/core/bulk_writer.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::DocumentKey;
+using model::DocumentKeyHash;
+using model::Mutation;
+using remote::Datastore;
+using util::AsyncQueue;
+using util::Executor;
+using util::RateLimiter;
+using util::Status;
+using util::StatusCallback;
+using util::TimerId;
+
+namespace {
+
+/** The initial number of writes per second (the "500" of 500/50/5). */
+constexpr int64_t kInitialWritesPerSecond = 500;
+
+/** The rate increase per period (the "50%" of 500/50/5). */
+constexpr double kRateMultiplier = 1.5;
+
+/** How often the rate increases (the "5 minutes" of 500/50/5). */
+constexpr std::chrono::minutes kRateMultiplierPeriod{5};
+
+/** The rate at which the ramp-up stops. */
+constexpr int64_t kMaxWritesPerSecond = 10000;
+
+}  // namespace
+
+constexpr size_t BulkWriter::kMaxBatchSize;
+constexpr int BulkWriter::kMaxAttempts;
+
+BulkWriter::BulkWriter(std::shared_ptr<AsyncQueue> worker_queue,
+                       std::shared_ptr<Executor> user_executor,
+                       CommitFunction commit)
+    : worker_queue_{std::move(worker_queue)},
+      user_executor_{std::move(user_executor)},
+      commit_{std::move(commit)},
+      rate_limiter_{kInitialWritesPerSecond, kRateMultiplier,
+                    kRateMultiplierPeriod, kMaxWritesPerSecond,
+                    RateLimiter::Clock::now()},
+      backoff_{worker_queue_, TimerId::BulkWriterRetry} {
+}
+
+void BulkWriter::Write(std::vector<Mutation> mutations,
+                       StatusCallback callback) {
+  HARD_ASSERT(!mutations.empty(), "Bulk write without mutations");
+  for (const Mutation& mutation : mutations) {
+    HARD_ASSERT(mutation.key() == mutations.front().key(),
+                "Bulk write mutations must apply to the same document");
+  }
+
+  auto shared_this = shared_from_this();
+  // TODO(c++14): move `mutations` and `callback` into lambda.
+  worker_queue_->Enqueue([shared_this, mutations, callback] {
+    Operation operation;
+    operation.id = shared_this->next_id_++;
+    operation.mutations = mutations;
+    operation.callback = callback;
+
+    shared_this->outstanding_ids_.insert(operation.id);
+    shared_this->pending_.push_back(std::move(operation));
+    shared_this->SendReadyBatches();
+  });
+}
+
+void BulkWriter::Flush(StatusCallback callback) {
+  auto shared_this = shared_from_this();
+  worker_queue_->Enqueue([shared_this, callback] {
+    shared_this->flush_id_ = shared_this->next_id_;
+    shared_this->flushes_.emplace_back(shared_this->next_id_, callback);
+    shared_this->RaiseCompletedFlushes();
+    shared_this->SendReadyBatches();
+  });
+}
+
+void BulkWriter::SendReadyBatches() {
+  worker_queue_->VerifyIsCurrentQueue();
+
+  // Writes will be resumed by the pending delayed operation.
+  if (backing_off_ || rate_limit_delay_) {
+    return;
+  }
+
+  while (!pending_.empty()) {
+    size_t batch_size = NextBatchSize();
+    if (batch_size == 0 || !IsBatchReady(batch_size)) {
+      break;
+    }
+
+    auto now = RateLimiter::Clock::now();
+    auto num_operations = static_cast<int64_t>(batch_size);
+    if (!rate_limiter_.TryMakeRequest(num_operations, now)) {
+      auto delay = rate_limiter_.GetNextRequestDelay(num_operations, now);
+      auto shared_this = shared_from_this();
+      rate_limit_delay_ = worker_queue_->EnqueueAfterDelay(
+          delay, TimerId::BulkWriterRateLimit, [shared_this] {
+            shared_this->rate_limit_delay_ = {};
+            shared_this->SendReadyBatches();
+          });
+      break;
+    }
+
+    Batch batch;
+    std::vector<Mutation> mutations;
+    for (size_t i = 0; i < batch_size; ++i) {
+      Operation operation = std::move(pending_.front());
+      pending_.pop_front();
+
+      operation.attempts += 1;
+      in_flight_.insert(operation.key());
+      mutations.insert(mutations.end(), operation.mutations.begin(),
+                       operation.mutations.end());
+      batch.push_back(std::move(operation));
+    }
+
+    auto shared_this = shared_from_this();
+    // TODO(c++14): move `batch` into lambda.
+    commit_(mutations, [shared_this, batch](const Status& status) {
+      shared_this->HandleCommitResult(batch, status);
+    });
+  }
+}
+
+size_t BulkWriter::NextBatchSize() const {
+  std::unordered_set<DocumentKey, DocumentKeyHash> batch_keys;
+  size_t size = 0;
+  for (const Operation& operation : pending_) {
+    if (size == kMaxBatchSize) {
+      break;
+    }
+
+    // A document may only be written by one commit at a time, so that its
+    // writes are applied in order.
+    const DocumentKey& key = operation.key();
+    if (in_flight_.count(key) > 0 || batch_keys.count(key) > 0) {
+      break;
+    }
+
+    if (operation.isolated) {
+      return size == 0 ? 1 : size;
+    }
+
+    batch_keys.insert(key);
+    ++size;
+  }
+  return size;
+}
+
+bool BulkWriter::IsBatchReady(size_t batch_size) const {
+  // Writes that were cut off are waiting for an earlier write to the same
+  // document, or must be sent alone.
+  if (batch_size == kMaxBatchSize || batch_size < pending_.size()) {
+    return true;
+  }
+
+  for (size_t i = 0; i < batch_size; ++i) {
+    const Operation& operation = pending_[i];
+    if (operation.id < flush_id_ || operation.attempts > 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void BulkWriter::HandleCommitResult(Batch batch, const Status& status) {
+  for (const Operation& operation : batch) {
+    in_flight_.erase(operation.key());
+  }
+
+  if (status.ok()) {
+    backoff_.Reset();
+    for (const Operation& operation : batch) {
+      Complete(operation, status);
+    }
+
+  } else if (!Datastore::IsPermanentWriteError(status)) {
+    Batch retry;
+    for (Operation& operation : batch) {
+      if (operation.attempts >= kMaxAttempts) {
+        Complete(operation, status);
+      } else {
+        retry.push_back(std::move(operation));
+      }
+    }
+
+    if (!retry.empty()) {
+      Requeue(std::move(retry));
+      if (!backing_off_) {
+        backing_off_ = true;
+        auto shared_this = shared_from_this();
+        backoff_.BackoffAndRun([shared_this] {
+          shared_this->backing_off_ = false;
+          shared_this->SendReadyBatches();
+        });
+      }
+    }
+
+  } else if (batch.size() > 1) {
+    // The commit was rejected as a whole, so it's unknown which write caused
+    // the failure. Retry each write separately so that only that one fails.
+    for (Operation& operation : batch) {
+      operation.isolated = true;
+    }
+    Requeue(std::move(batch));
+
+  } else {
+    Complete(batch.front(), status);
+  }
+
+  RaiseCompletedFlushes();
+  SendReadyBatches();
+}
+
+void BulkWriter::Requeue(Batch batch) {
+  pending_.insert(pending_.begin(), std::make_move_iterator(batch.begin()),
+                  std::make_move_iterator(batch.end()));
+}
+
+void BulkWriter::Complete(const Operation& operation, const Status& status) {
+  outstanding_ids_.erase(operation.id);
+
+  StatusCallback callback = operation.callback;
+  if (callback) {
+    // Dispatch the result back onto the user dispatch queue.
+    user_executor_->Execute([callback, status] { callback(status); });
+  }
+}
+
+void BulkWriter::RaiseCompletedFlushes() {
+  uint64_t first_outstanding_id =
+      outstanding_ids_.empty() ? next_id_ : *outstanding_ids_.begin();
+
+  while (!flushes_.empty() && flushes_.front().first <= first_outstanding_id) {
+    StatusCallback callback = std::move(flushes_.front().second);
+    flushes_.pop_front();
+    if (callback) {
+      user_executor_->Execute([callback] { callback(Status::OK()); });
+    }
+  }
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
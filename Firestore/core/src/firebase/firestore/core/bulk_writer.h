@@ -0,0 +1,167 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_BULK_WRITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_BULK_WRITER_H_
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/remote/exponential_backoff.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/rate_limiter.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * Writes large numbers of documents to the backend, e.g. for data migrations.
+ *
+ * Unlike `WriteBatch`, writes are not atomic: they are grouped into many small
+ * independent commits that are sent concurrently, and each write succeeds or
+ * fails on its own. The rate of writes starts at 500 per second and increases
+ * by 50% every 5 minutes (the "500/50/5" rule) so that the backend has time to
+ * scale up. Transient failures are retried with exponential backoff.
+ *
+ * Bulk writes bypass the local store. They are not latency compensated or
+ * persisted, and listeners only see them once the backend reports them.
+ *
+ * Writes are sent once enough of them have been made to fill a commit, or
+ * when `Flush` is called. Writes to the same document are applied in the order
+ * they were made: a write waits until earlier writes to its document have
+ * completed.
+ *
+ * The public methods may be called from any thread. Callbacks are invoked on
+ * the user executor.
+ */
+class BulkWriter : public std::enable_shared_from_this<BulkWriter> {
+ public:
+  /**
+   * Sends the given mutations to the backend in a single commit. Called on
+   * the worker queue; must invoke the callback on the worker queue.
+   */
+  using CommitFunction = std::function<void(
+      const std::vector<model::Mutation>& mutations, util::StatusCallback)>;
+
+  /** The maximum number of writes sent in a single commit. */
+  static constexpr size_t kMaxBatchSize = 20;
+
+  /** The number of times a write is attempted before it fails. */
+  static constexpr int kMaxAttempts = 10;
+
+  BulkWriter(std::shared_ptr<util::AsyncQueue> worker_queue,
+             std::shared_ptr<util::Executor> user_executor,
+             CommitFunction commit);
+
+  /**
+   * Schedules a write of a single document. The mutations, which must all
+   * apply to the same document, are committed atomically (e.g. a set followed
+   * by the transform for its server timestamps). The callback, if any,
+   * receives the outcome of this write alone.
+   */
+  void Write(std::vector<model::Mutation> mutations,
+             util::StatusCallback callback);
+
+  /**
+   * Invokes the callback once all writes scheduled before this call have
+   * completed, successfully or not.
+   */
+  void Flush(util::StatusCallback callback);
+
+ private:
+  struct Operation {
+    uint64_t id = 0;
+    std::vector<model::Mutation> mutations;
+    util::StatusCallback callback;
+    int attempts = 0;
+
+    /**
+     * Whether this write must be committed alone because a commit containing
+     * it failed with a permanent error, which doesn't identify the culprit.
+     */
+    bool isolated = false;
+
+    const model::DocumentKey& key() const {
+      return mutations.front().key();
+    }
+  };
+
+  using Batch = std::vector<Operation>;
+
+  /** Commits as many batches of pending writes as the rate limit allows. */
+  void SendReadyBatches();
+
+  /**
+   * Returns the number of writes at the front of `pending_` that can be
+   * committed together right now.
+   */
+  size_t NextBatchSize() const;
+
+  /**
+   * Returns whether the first `batch_size` writes in `pending_` should be sent
+   * now rather than wait for more writes to fill the commit.
+   */
+  bool IsBatchReady(size_t batch_size) const;
+
+  void HandleCommitResult(Batch batch, const util::Status& status);
+
+  /** Puts the writes of a failed commit back at the front of `pending_`. */
+  void Requeue(Batch batch);
+
+  void Complete(const Operation& operation, const util::Status& status);
+
+  void RaiseCompletedFlushes();
+
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  std::shared_ptr<util::Executor> user_executor_;
+  CommitFunction commit_;
+
+  util::RateLimiter rate_limiter_;
+  remote::ExponentialBackoff backoff_;
+  bool backing_off_ = false;
+  util::DelayedOperation rate_limit_delay_;
+
+  std::deque<Operation> pending_;
+  std::unordered_set<model::DocumentKey, model::DocumentKeyHash> in_flight_;
+
+  /** The IDs of all writes that haven't completed yet. */
+  std::set<uint64_t> outstanding_ids_;
+  uint64_t next_id_ = 0;
+
+  /** Writes with lower IDs than this are sent without waiting for more. */
+  uint64_t flush_id_ = 0;
+
+  /** Flush callbacks, with the first write ID they don't wait for. */
+  std::deque<std::pair<uint64_t, util::StatusCallback>> flushes_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_BULK_WRITER_H_
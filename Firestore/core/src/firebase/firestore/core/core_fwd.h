@@ -40,6 +40,7 @@ using StatusCallback = std::function<void(Status)>;
 namespace core {
 
 class Bound;
+class BulkWriter;
 class DatabaseInfo;
 class Direction;
 class EventManager;
@@ -18,12 +18,16 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_EVENT_LISTENER_H_
 
 #include <atomic>
+#include <functional>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -52,6 +56,11 @@ class EventListener {
 
 /**
  * A wrapper around another EventListener that dispatches events asynchronously.
+ *
+ * Events raised while earlier ones are still waiting for the executor are
+ * delivered together with them, in order, in a single operation on the
+ * executor. A listener without an executor delivers its events inline, on the
+ * thread that raises them.
  */
 template <typename T>
 class AsyncEventListener
@@ -60,6 +69,9 @@ class AsyncEventListener
  public:
   using DelegateListener = std::unique_ptr<EventListener<T>>;
 
+  /** Combines a value waiting to be dispatched with a newer one. */
+  using MergeFunction = std::function<T(const T& pending, const T& next)>;
+
   AsyncEventListener(const std::shared_ptr<util::Executor>& executor,
                      DelegateListener&& delegate)
       : executor_(executor), delegate_(std::move(delegate)) {
@@ -79,6 +91,19 @@ class AsyncEventListener
 
   void OnEvent(util::StatusOr<T> maybe_value) override;
 
+  /**
+   * Makes this listener conflate values: while a value is still waiting for
+   * the executor, a newer value is merged into it with the given function
+   * instead of being dispatched separately, so a slow executor only sees the
+   * latest state. Errors are never merged, and values are never merged across
+   * an error.
+   *
+   * Must be called before the first event is raised.
+   */
+  void ConflateEvents(MergeFunction merge) {
+    merge_ = std::move(merge);
+  }
+
   /**
    * Synchronously mutes the listener and raises no further events. This method
    * is thread safe and can be called from any queue.
@@ -86,9 +111,22 @@ class AsyncEventListener
   void Mute();
 
  private:
+  struct PendingEvent {
+    util::StatusOr<T> maybe_value;
+    /** The span that raised the event. */
+    util::SpanId span;
+  };
+
+  void DispatchPending();
+
   std::atomic<bool> muted_;
   std::shared_ptr<util::Executor> executor_;
   DelegateListener delegate_;
+
+  MergeFunction merge_;
+  std::mutex pending_mutex_;
+  /** The events waiting to be dispatched, oldest first. */
+  std::vector<PendingEvent> pending_;
 };
 
 template <typename T>
@@ -124,17 +162,51 @@ void AsyncEventListener<T>::Mute() {
 
 template <typename T>
 void AsyncEventListener<T>::OnEvent(util::StatusOr<T> maybe_value) {
+  util::SpanId parent_span = util::TraceSpan::Current();
+
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (merge_ && maybe_value.ok() && !pending_.empty() &&
+        pending_.back().maybe_value.ok()) {
+      PendingEvent& last = pending_.back();
+      last.maybe_value =
+          merge_(last.maybe_value.ValueOrDie(), maybe_value.ValueOrDie());
+      last.span = parent_span;
+      return;
+    }
+
+    bool dispatch_scheduled = !pending_.empty();
+    pending_.push_back(PendingEvent{std::move(maybe_value), parent_span});
+    if (dispatch_scheduled) return;
+  }
+
+  if (!executor_) {
+    DispatchPending();
+    return;
+  }
+
   // Retain a strong reference to this. If the EventManager is sending an error
   // it will immediately clear its strong reference to this after posting the
   // event. The strong reference here allows the AsyncEventListener to survive
   // until the executor gets around to calling.
   std::shared_ptr<AsyncEventListener<T>> shared_this = this->shared_from_this();
+  executor_->Execute([shared_this] { shared_this->DispatchPending(); });
+}
 
-  executor_->Execute([shared_this, maybe_value]() {
-    if (!shared_this->muted_) {
-      shared_this->delegate_->OnEvent(std::move(maybe_value));
-    }
-  });
+template <typename T>
+void AsyncEventListener<T>::DispatchPending() {
+  std::vector<PendingEvent> events;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    events.swap(pending_);
+  }
+
+  for (PendingEvent& event : events) {
+    if (muted_) return;
+
+    util::TraceSpan span("UserCallback", event.span);
+    delegate_->OnEvent(std::move(event.maybe_value));
+  }
 }
 
 }  // namespace core
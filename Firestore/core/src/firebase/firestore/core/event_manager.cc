@@ -27,20 +27,68 @@ namespace firestore {
 namespace core {
 
 using util::Empty;
+using util::TimerId;
 
 EventManager::EventManager(QueryEventSource* query_event_source)
     : query_event_source_(query_event_source) {
   query_event_source->SetCallback(this);
 }
 
+EventManager::~EventManager() {
+  for (auto&& kv : queries_) {
+    kv.second.linger.Cancel();
+  }
+}
+
+void EventManager::SetListenLinger(
+    std::shared_ptr<util::AsyncQueue> worker_queue,
+    std::chrono::milliseconds linger) {
+  worker_queue_ = std::move(worker_queue);
+  listen_linger_ = linger;
+}
+
 model::TargetId EventManager::AddQueryListener(
     std::shared_ptr<core::QueryListener> listener) {
   const Query& query = listener->query();
+  bool first_listen = RegisterQueryListener(listener);
+
+  QueryListenersInfo& query_info = queries_[query];
+  if (first_listen) {
+    query_info.target_id = query_event_source_->Listen(query);
+  }
+  return query_info.target_id;
+}
+
+void EventManager::AddQueryListeners(
+    const std::vector<std::shared_ptr<core::QueryListener>>& listeners) {
+  std::vector<Query> new_queries;
+  for (const auto& listener : listeners) {
+    if (RegisterQueryListener(listener)) {
+      new_queries.push_back(listener->query());
+    }
+  }
+
+  if (new_queries.empty()) {
+    return;
+  }
+
+  std::vector<model::TargetId> target_ids =
+      query_event_source_->ListenAll(new_queries);
+  for (size_t i = 0; i < new_queries.size(); ++i) {
+    queries_[new_queries[i]].target_id = target_ids[i];
+  }
+}
+
+bool EventManager::RegisterQueryListener(
+    const std::shared_ptr<QueryListener>& listener) {
+  const Query& query = listener->query();
 
   auto inserted = queries_.emplace(query, QueryListenersInfo{});
   bool first_listen = inserted.second;
   QueryListenersInfo& query_info = inserted.first->second;
 
+  // The query may be lingering after its last listener was removed.
+  query_info.linger.Cancel();
   query_info.listeners.push_back(listener);
 
   bool raised_event = listener->OnOnlineStateChanged(online_state_);
@@ -48,17 +96,21 @@ model::TargetId EventManager::AddQueryListener(
               "OnOnlineStateChanged() shouldn't raise an event "
               "for brand-new listeners.");
 
+  if (query_info.documents_dropped) {
+    // The new listener needs the documents for its first snapshot.
+    query_info.set_view_snapshot(query_event_source_->RestoreDocuments(query));
+    query_info.documents_dropped = false;
+  }
+
   if (query_info.view_snapshot().has_value()) {
     raised_event = listener->OnViewSnapshot(query_info.view_snapshot().value());
     if (raised_event) {
       RaiseSnapshotsInSyncEvent();
     }
+    UpdateDocumentRetention(query, &query_info);
   }
 
-  if (first_listen) {
-    query_info.target_id = query_event_source_->Listen(query);
-  }
-  return query_info.target_id;
+  return first_listen;
 }
 
 void EventManager::RemoveQueryListener(
@@ -71,12 +123,35 @@ void EventManager::RemoveQueryListener(
     QueryListenersInfo& query_info = found_iter->second;
     query_info.Erase(listener);
     last_listen = query_info.listeners.empty();
+    if (!last_listen) {
+      UpdateDocumentRetention(query, &query_info);
+    }
   }
 
-  if (last_listen) {
-    queries_.erase(found_iter);
-    query_event_source_->StopListening(query);
+  if (!last_listen) {
+    return;
+  }
+
+  if (worker_queue_ && listen_linger_.count() > 0) {
+    Query lingering = query;
+    found_iter->second.linger = worker_queue_->EnqueueAfterDelay(
+        listen_linger_, TimerId::ListenLinger,
+        [this, lingering] { StopLingering(lingering); });
+    return;
   }
+
+  queries_.erase(found_iter);
+  query_event_source_->StopListening(query);
+}
+
+void EventManager::StopLingering(const Query& query) {
+  auto found_iter = queries_.find(query);
+  if (found_iter == queries_.end() || !found_iter->second.listeners.empty()) {
+    return;
+  }
+
+  queries_.erase(found_iter);
+  query_event_source_->StopListening(query);
 }
 
 void EventManager::AddSnapshotsInSyncListener(
@@ -101,6 +176,7 @@ void EventManager::HandleOnlineStateChange(model::OnlineState online_state) {
         raised_event = true;
       }
     }
+    UpdateDocumentRetention(kv.first, &info);
   }
   if (raised_event) {
     RaiseSnapshotsInSyncEvent();
@@ -122,12 +198,25 @@ void EventManager::OnViewSnapshots(
     auto found_iter = queries_.find(query);
     if (found_iter != queries_.end()) {
       QueryListenersInfo& query_info = found_iter->second;
+
+      // Listeners that exclude metadata changes share a single filtered
+      // snapshot, built the first time one of them needs it.
+      absl::optional<ViewSnapshot> without_metadata;
       for (const auto& listener : query_info.listeners) {
-        if (listener->OnViewSnapshot(snapshot)) {
+        const ViewSnapshot* delivered = &snapshot;
+        if (!listener->options().include_document_metadata_changes()) {
+          if (!without_metadata) {
+            without_metadata = snapshot.ExcludingMetadataChanges();
+          }
+          delivered = &*without_metadata;
+        }
+
+        if (listener->OnViewSnapshot(*delivered)) {
           raised_event = true;
         }
       }
       query_info.set_view_snapshot(std::move(snapshot));
+      UpdateDocumentRetention(found_iter->first, &query_info);
     }
   }
   if (raised_event) {
@@ -135,6 +224,27 @@ void EventManager::OnViewSnapshots(
   }
 }
 
+void EventManager::UpdateDocumentRetention(const Query& query,
+                                           QueryListenersInfo* query_info) {
+  // A lingering query keeps its documents for the next listener.
+  if (query_info->documents_dropped || query_info->listeners.empty()) {
+    return;
+  }
+  for (const auto& listener : query_info->listeners) {
+    if (!listener->options().changes_only() ||
+        !listener->raised_initial_event()) {
+      return;
+    }
+  }
+
+  if (query_event_source_->DropDocuments(query)) {
+    query_info->documents_dropped = true;
+    // Release the documents held by the last snapshot, too. Listeners that
+    // join later get a snapshot of the restored documents instead.
+    query_info->set_view_snapshot(absl::nullopt);
+  }
+}
+
 void EventManager::OnError(const core::Query& query,
                            const util::Status& error) {
   auto found_iter = queries_.find(query);
@@ -149,6 +259,7 @@ void EventManager::OnError(const core::Query& query,
 
   // Remove all listeners. NOTE: We don't need to call
   // `SyncEngine::StopListening()` after an error.
+  query_info.linger.Cancel();
   queries_.erase(found_iter);
 }
 
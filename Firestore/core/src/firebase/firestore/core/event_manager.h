@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_EVENT_MANAGER_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_EVENT_MANAGER_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
@@ -26,7 +27,9 @@
 #include "Firestore/core/src/firebase/firestore/core/sync_engine_callback.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/empty.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
 #include "absl/types/optional.h"
 
@@ -46,6 +49,18 @@ class EventManager : public SyncEngineCallback {
  public:
   explicit EventManager(QueryEventSource* query_event_source_);
 
+  ~EventManager();
+
+  /**
+   * Keeps listening to a query for `linger` after its last listener is
+   * removed, so that a listener added in the meantime gets the latest snapshot
+   * at once instead of starting a new listen. The listen is stopped on
+   * `worker_queue` once the period passes. A zero `linger` stops listening at
+   * once, which is the default.
+   */
+  void SetListenLinger(std::shared_ptr<util::AsyncQueue> worker_queue,
+                       std::chrono::milliseconds linger);
+
   /**
    * Adds a query listener that will be called with new snapshots for the query.
    * The EventManager is responsible for multiplexing many listeners to a single
@@ -57,6 +72,14 @@ class EventManager : public SyncEngineCallback {
   model::TargetId AddQueryListener(
       std::shared_ptr<core::QueryListener> listener);
 
+  /**
+   * Adds several query listeners at once. Listens for all the queries that
+   * don't have a listener yet are started with a single call to the
+   * SyncEngine, so their targets are allocated together.
+   */
+  void AddQueryListeners(
+      const std::vector<std::shared_ptr<core::QueryListener>>& listeners);
+
   /**
    * Removes a previously added listener. It's a no-op if the listener is not
    * found.
@@ -74,11 +97,33 @@ class EventManager : public SyncEngineCallback {
   void OnError(const core::Query& query, const util::Status& error) override;
 
  private:
+  /**
+   * Registers the listener with the listeners of its query. Returns whether
+   * this is the first listener for the query.
+   */
+  bool RegisterQueryListener(const std::shared_ptr<QueryListener>& listener);
+
+  struct QueryListenersInfo;
+
+  /**
+   * Has the query stop keeping the contents of its documents once all of its
+   * listeners only read document changes and have raised their first
+   * snapshot.
+   */
+  void UpdateDocumentRetention(const Query& query,
+                               QueryListenersInfo* query_info);
+
   /**
    * Call all global snapshot listeners that have been set.
    */
   void RaiseSnapshotsInSyncEvent();
 
+  /**
+   * Stops listening to `query` if it still has no listeners once its linger
+   * period has passed.
+   */
+  void StopLingering(const Query& query);
+
   /**
    * Holds the listeners and the last received ViewSnapshot for a query being
    * tracked by EventManager.
@@ -87,6 +132,12 @@ class EventManager : public SyncEngineCallback {
     model::TargetId target_id;
     std::vector<std::shared_ptr<QueryListener>> listeners;
 
+    /** Whether the query's documents were dropped by the event source. */
+    bool documents_dropped = false;
+
+    /** Stops the listen once it has lingered without listeners. */
+    util::DelayedOperation linger;
+
     bool Erase(const std::shared_ptr<QueryListener>& listener);
 
     const absl::optional<ViewSnapshot>& view_snapshot() const {
@@ -104,6 +155,8 @@ class EventManager : public SyncEngineCallback {
   };
 
   QueryEventSource* query_event_source_ = nullptr;
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  std::chrono::milliseconds listen_linger_{0};
   model::OnlineState online_state_ = model::OnlineState::Unknown;
   std::unordered_map<core::Query, QueryListenersInfo> queries_;
   std::unordered_set<std::shared_ptr<EventListener<util::Empty>>>
@@ -142,11 +142,11 @@ bool FieldFilter::Rep::IsInequality() const {
 }
 
 bool FieldFilter::Rep::Matches(const model::Document& doc) const {
-  absl::optional<FieldValue> maybe_lhs = doc.field(field_);
-  if (!maybe_lhs) return false;
-
-  const FieldValue& lhs = *maybe_lhs;
+  const FieldValue* lhs = doc.data().Find(field_);
+  return lhs != nullptr && MatchesValue(*lhs);
+}
 
+bool FieldFilter::Rep::MatchesValue(const FieldValue& lhs) const {
   // Only compare types with matching backend order (such as double and int).
   return FieldValue::Comparable(lhs.type(), value_rhs_.type()) &&
          MatchesComparison(lhs.CompareTo(value_rhs_));
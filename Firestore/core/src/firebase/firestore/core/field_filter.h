@@ -60,6 +60,14 @@ class FieldFilter : public Filter {
     return field_filter_rep().value_rhs_;
   }
 
+  /**
+   * Returns true if the given value of `field()` satisfies the filter. Not
+   * meaningful for filters on the document key, which match the key instead.
+   */
+  bool MatchesValue(const model::FieldValue& lhs) const {
+    return field_filter_rep().MatchesValue(lhs);
+  }
+
  protected:
   class Rep : public Filter::Rep {
    public:
@@ -108,13 +116,18 @@ class FieldFilter : public Filter {
 
     bool MatchesComparison(util::ComparisonResult result) const;
 
+    /**
+     * Matches the value of `field_` in a document. `Matches` looks the value
+     * up and calls this, so subclasses that match field values override this
+     * instead.
+     */
+    virtual bool MatchesValue(const model::FieldValue& lhs) const;
+
    private:
     friend class FieldFilter;
 
     bool Equals(const Filter::Rep& other) const override;
 
-    bool MatchesValue(const model::FieldValue& lhs) const;
-
     /** The left hand side of the relation. A path into a document field. */
     model::FieldPath field_;
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/filter_program.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/append_only_list.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Document;
+using model::FieldPath;
+using model::FieldValue;
+
+namespace {
+
+/**
+ * Fields nested more deeply than this are matched by their filters directly.
+ * Documents can't nest maps more deeply than the backend's limit of 20.
+ */
+constexpr size_t kMaxResolvedDepth = 20;
+
+}  // namespace
+
+FilterProgram::FilterProgram(const FilterList& filters) {
+  std::vector<FieldFilter> field_filters;
+  for (const Filter& filter : filters) {
+    if (filter.type() == Filter::Type::kKeyFieldFilter ||
+        filter.type() == Filter::Type::kKeyFieldInFilter ||
+        filter.field().size() > kMaxResolvedDepth) {
+      other_filters_.push_back(filter);
+    } else {
+      field_filters.emplace_back(filter);
+    }
+  }
+
+  std::stable_sort(field_filters.begin(), field_filters.end(),
+                   [](const FieldFilter& lhs, const FieldFilter& rhs) {
+                     return lhs.field() < rhs.field();
+                   });
+
+  steps_.reserve(field_filters.size());
+  const FieldPath* previous = nullptr;
+  for (const FieldFilter& filter : field_filters) {
+    const FieldPath& field = filter.field();
+    size_t shared = 0;
+    if (previous) {
+      size_t limit = std::min(previous->size(), field.size());
+      while (shared < limit && (*previous)[shared] == field[shared]) {
+        ++shared;
+      }
+    }
+    steps_.push_back(Step{filter, shared});
+    previous = &field;
+  }
+}
+
+bool FilterProgram::Matches(const Document& doc) const {
+  for (const Filter& filter : other_filters_) {
+    if (!filter.Matches(doc)) return false;
+  }
+
+  // `resolved[i]` is the value at the first `i` segments of the field of the
+  // previous step. Every filter fails for documents that lack its field, so
+  // the previous field is always resolved in full.
+  const FieldValue* resolved[kMaxResolvedDepth + 1];
+  resolved[0] = &doc.data().AsFieldValue();
+  for (const Step& step : steps_) {
+    const FieldPath& field = step.filter.field();
+    for (size_t i = step.shared_segments; i < field.size(); ++i) {
+      const FieldValue& parent = *resolved[i];
+      if (parent.type() != FieldValue::Type::Object) return false;
+
+      const FieldValue::Map& entries = parent.object_value();
+      auto found = entries.find(field[i]);
+      if (found == entries.end()) return false;
+      resolved[i + 1] = &found->second;
+    }
+
+    if (!step.filter.MatchesValue(*resolved[field.size()])) return false;
+  }
+  return true;
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
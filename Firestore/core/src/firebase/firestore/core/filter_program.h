@@ -0,0 +1,74 @@
+/*
+ * Copyright 2019 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FILTER_PROGRAM_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FILTER_PROGRAM_H_
+
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace model {
+class Document;
+}  // namespace model
+
+namespace core {
+
+/**
+ * The filters of a query, arranged to be matched against many documents.
+ *
+ * Filters on document fields are ordered by field path, so that filters on the
+ * same field or on fields of the same map share the lookups of their common
+ * path segments. Each field value is checked where it lies in the document
+ * instead of being copied out of it first.
+ */
+class FilterProgram {
+ public:
+  explicit FilterProgram(const FilterList& filters);
+
+  /** Returns true if the document matches all of the filters. */
+  bool Matches(const model::Document& doc) const;
+
+ private:
+  struct Step {
+    FieldFilter filter;
+
+    /**
+     * The number of leading segments that the filter's field shares with the
+     * field of the previous step, which are already resolved.
+     */
+    size_t shared_segments;
+  };
+
+  /**
+   * Filters matched on their own: filters on the document key, which don't
+   * look up any field, and filters on fields nested too deeply to resolve in
+   * place.
+   */
+  std::vector<Filter> other_filters_;
+
+  std::vector<Step> steps_;
+};
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FILTER_PROGRAM_H_
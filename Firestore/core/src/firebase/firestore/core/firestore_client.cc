@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/core/firestore_client.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
 #include <future>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
@@ -25,34 +27,46 @@
 #include "Firestore/core/src/firebase/firestore/api/query_core.h"
 #include "Firestore/core/src/firebase/firestore/api/query_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/api/source.h"
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/bulk_writer.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/core/event_manager.h"
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 #include "Firestore/core/src/firebase/firestore/core/sync_engine.h"
 #include "Firestore/core/src/firebase/firestore/core/view.h"
+#include "Firestore/core/src/firebase/firestore/local/bundle_loader.h"
 #include "Firestore/core/src/firebase/firestore/local/index_free_query_engine.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_opener.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 #include "Firestore/core/src/firebase/firestore/local/local_store.h"
+#include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/query_explanation.h"
 #include "Firestore/core/src/firebase/firestore/local/query_result.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion_poller.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 #include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/remote/stream_recorder.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
 #include "Firestore/core/src/firebase/firestore/util/exception.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -67,31 +81,47 @@ using api::QuerySnapshot;
 using api::QuerySnapshotListener;
 using api::Settings;
 using api::SnapshotMetadata;
+using api::Source;
 using auth::CredentialsProvider;
+using auth::Token;
 using auth::User;
 using firestore::Error;
+using local::BundleLoader;
 using local::IndexFreeQueryEngine;
 using local::LevelDbOpener;
+using local::LevelDbOptions;
+using local::LevelDbPersistence;
 using local::LocalSerializer;
 using local::LocalStore;
+using local::LruGarbageCollector;
 using local::LruParams;
 using local::MemoryPersistence;
+using local::NamedQuery;
+using local::PersistenceMetrics;
+using local::PersistenceMetricsCallback;
+using local::QueryExplanation;
+using local::QueryExplanationCallback;
 using local::QueryResult;
 using model::DatabaseId;
 using model::Document;
 using model::DocumentKeySet;
 using model::DocumentMap;
+using model::kBatchIdUnknown;
 using model::MaybeDocument;
 using model::Mutation;
 using model::OnlineState;
 using remote::Datastore;
+using remote::GrpcCompletionPoller;
 using remote::RemoteStore;
+using remote::RunQueryResult;
 using remote::Serializer;
+using remote::StreamRecorder;
 using util::AsyncQueue;
 using util::DelayedConstructor;
 using util::DelayedOperation;
 using util::Empty;
 using util::Executor;
+using util::Filesystem;
 using util::Path;
 using util::Status;
 using util::StatusCallback;
@@ -100,16 +130,45 @@ using util::StatusOrCallback;
 using util::ThrowIllegalState;
 using util::TimerId;
 
+namespace {
+
+/**
+ * The maximum number of targets or documents examined by a single slice of LRU
+ * garbage collection. Each slice runs in its own transaction and yields the
+ * worker queue afterwards, so user operations are not held up for the length
+ * of a whole collection.
+ */
+const int kLruGarbageCollectionSliceSize = 1000;
+
+/** The number of rows each step of a background migration goes through. */
+const size_t kBackgroundMigrationSliceSize = 1000;
+
+grpc_compression_algorithm ToGrpcCompression(
+    Settings::RpcCompression compression) {
+  switch (compression) {
+    case Settings::RpcCompression::None:
+      return GRPC_COMPRESS_NONE;
+    case Settings::RpcCompression::Gzip:
+      return GRPC_COMPRESS_GZIP;
+    case Settings::RpcCompression::Deflate:
+      return GRPC_COMPRESS_DEFLATE;
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
 std::shared_ptr<FirestoreClient> FirestoreClient::Create(
     const DatabaseInfo& database_info,
     const api::Settings& settings,
     std::shared_ptr<auth::CredentialsProvider> credentials_provider,
     std::shared_ptr<util::Executor> user_executor,
-    std::shared_ptr<util::AsyncQueue> worker_queue) {
+    std::shared_ptr<util::AsyncQueue> worker_queue,
+    DatastoreFactory datastore_factory) {
   // Have to use `new` because `make_shared` cannot access private constructor.
-  std::shared_ptr<FirestoreClient> shared_client(
-      new FirestoreClient(database_info, std::move(credentials_provider),
-                          std::move(user_executor), std::move(worker_queue)));
+  std::shared_ptr<FirestoreClient> shared_client(new FirestoreClient(
+      database_info, std::move(credentials_provider), std::move(user_executor),
+      std::move(worker_queue), std::move(datastore_factory)));
 
   std::weak_ptr<FirestoreClient> weak_client(shared_client);
   auto credential_change_listener = [weak_client, settings](User user) mutable {
@@ -150,11 +209,13 @@ FirestoreClient::FirestoreClient(
     const DatabaseInfo& database_info,
     std::shared_ptr<auth::CredentialsProvider> credentials_provider,
     std::shared_ptr<util::Executor> user_executor,
-    std::shared_ptr<util::AsyncQueue> worker_queue)
+    std::shared_ptr<util::AsyncQueue> worker_queue,
+    DatastoreFactory datastore_factory)
     : database_info_(database_info),
       credentials_provider_(std::move(credentials_provider)),
       worker_queue_(std::move(worker_queue)),
-      user_executor_(std::move(user_executor)) {
+      user_executor_(std::move(user_executor)),
+      datastore_factory_(std::move(datastore_factory)) {
 }
 
 void FirestoreClient::Initialize(const User& user, const Settings& settings) {
@@ -165,11 +226,84 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
   // Note: The initialization work must all be synchronous (we can't dispatch
   // more work) since external write/listen operations could get queued to run
   // before that subsequent work completes.
+  //
+  // Opening LevelDB may have to run migrations, so it runs on a thread of its
+  // own while the connection to the backend is set up, and this waits for it
+  // before going on.
+  using OpenResult = StatusOr<std::unique_ptr<LevelDbPersistence>>;
+  std::unique_ptr<Executor> open_executor;
+  std::future<OpenResult> opened;
   if (settings.persistence_enabled()) {
-    LevelDbOpener opener(database_info_);
+    LruParams lru_params = LruParams::WithCacheSize(settings.cache_size_bytes());
+    lru_params.sequence_number_sample_size = settings.gc_sample_size();
+
+    LevelDbOptions leveldb_options;
+    leveldb_options.block_cache_size_bytes =
+        static_cast<size_t>(settings.leveldb_block_cache_size_bytes());
+    leveldb_options.bloom_filter_bits_per_key =
+        settings.leveldb_bloom_filter_bits_per_key();
+    leveldb_options.write_buffer_size_bytes =
+        static_cast<size_t>(settings.leveldb_write_buffer_size_bytes());
+    leveldb_options.shared_block_cache =
+        settings.leveldb_shared_block_cache_enabled();
+    leveldb_options.max_open_files = settings.leveldb_max_open_files();
+    leveldb_options.sync_mutation_queue_writes =
+        settings.leveldb_sync_mutation_queue_writes();
+    leveldb_options.compress_documents =
+        settings.leveldb_document_compression_enabled();
+
+    auto result = std::make_shared<std::promise<OpenResult>>();
+    opened = result->get_future();
+    open_executor =
+        Executor::CreateSerial("com.google.firebase.firestore.persistence");
+    DatabaseInfo database_info = database_info_;
+    open_executor->Execute(
+        [result, database_info, lru_params, leveldb_options] {
+          LevelDbOpener opener(database_info);
+          result->set_value(opener.Create(lru_params, leveldb_options));
+        });
+  }
+
+  std::shared_ptr<Datastore> datastore;
+  if (datastore_factory_) {
+    datastore = datastore_factory_(database_info_, worker_queue(),
+                                   credentials_provider_);
+  } else {
+    std::shared_ptr<GrpcCompletionPoller> poller;
+    if (settings.shared_rpc_polling_threads() > 0) {
+      poller = GrpcCompletionPoller::GetShared(
+          static_cast<size_t>(settings.shared_rpc_polling_threads()));
+    }
+    datastore = std::make_shared<Datastore>(database_info_, worker_queue(),
+                                            credentials_provider_,
+                                            std::move(poller));
+    if (settings.rpc_compression() != Settings::RpcCompression::None) {
+      datastore->EnableCompression(
+          ToGrpcCompression(settings.rpc_compression()),
+          static_cast<size_t>(settings.rpc_compression_threshold_bytes()));
+    }
+    datastore->SetKeepaliveTime(
+        std::chrono::milliseconds(settings.rpc_keepalive_time_ms()));
+    if (!settings.stream_recording_path().empty()) {
+      auto recorder = StreamRecorder::Create(
+          Path::FromUtf8(settings.stream_recording_path()));
+      if (recorder.ok()) {
+        datastore->SetStreamRecorder(std::move(recorder).ValueOrDie());
+      } else {
+        LOG_WARN("Not recording streams: %s", recorder.status().ToString());
+      }
+    }
+    datastore->Connect();
+  }
+
+  // Likewise, fetch a token while the database opens. Firebase Auth caches the
+  // token and, once asked for one, refreshes it ahead of its expiry, so the
+  // first stream doesn't have to wait for a token before it can connect.
+  credentials_provider_->GetToken([](const StatusOr<Token>&) {});
 
-    auto created =
-        opener.Create(LruParams::WithCacheSize(settings.cache_size_bytes()));
+  if (settings.persistence_enabled()) {
+    OpenResult created = opened.get();
+    open_executor.reset();
     // If leveldb fails to start then just throw up our hands: the error is
     // unrecoverable. There's nothing an end-user can do and nearly all
     // failures indicate the developer is doing something grossly wrong so we
@@ -179,36 +313,85 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
 
     auto ldb = std::move(created).ValueOrDie();
     lru_delegate_ = ldb->reference_delegate();
+    ldb->ConfigureDocumentSnapshot(settings.document_snapshot_enabled());
+    leveldb_persistence_ = ldb.get();
+    if (settings.leveldb_group_commit_delay_ms() > 0) {
+      group_commit_delay_ =
+          std::chrono::milliseconds(settings.leveldb_group_commit_delay_ms());
+      std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
+      ldb->EnableGroupCommit([weak_this] {
+        auto shared_this = weak_this.lock();
+        if (!shared_this) return;
+
+        shared_this->ScheduleGroupCommitFlush();
+      });
+    }
 
     persistence_ = std::move(ldb);
     if (settings.gc_enabled()) {
       ScheduleLruGarbageCollection();
     }
+    if (settings.document_snapshot_enabled()) {
+      ScheduleDocumentSnapshotCompaction();
+    }
+    ScheduleBackgroundMigration(initial_migration_delay_);
   } else {
-    persistence_ = MemoryPersistence::WithEagerGarbageCollector();
+    auto memory_persistence = MemoryPersistence::WithEagerGarbageCollector();
+    if (settings.compact_memory_cache_enabled()) {
+      memory_persistence->remote_document_cache()->EnableCompactStorage(
+          LocalSerializer(Serializer(database_info_.database_id())));
+    }
+    if (settings.memory_cache_snapshot_interval_ms() > 0) {
+      memory_persistence_ = memory_persistence.get();
+      memory_snapshot_interval_ = std::chrono::milliseconds(
+          settings.memory_cache_snapshot_interval_ms());
+    }
+    persistence_ = std::move(memory_persistence);
+    if (memory_persistence_) {
+      LoadMemoryCacheSnapshot();
+      ScheduleMemoryCacheSnapshot();
+    }
   }
 
   query_engine_ = absl::make_unique<IndexFreeQueryEngine>();
   local_store_ = absl::make_unique<LocalStore>(persistence_.get(),
                                                query_engine_.get(), user);
-
-  auto datastore = std::make_shared<Datastore>(database_info_, worker_queue(),
-                                               credentials_provider_);
+  local_store_->set_write_compaction_enabled(
+      settings.write_compaction_enabled());
+  local_store_->set_mutation_queue_limits(
+      static_cast<size_t>(std::max(0, settings.max_pending_writes())),
+      std::max<int64_t>(0, settings.max_pending_write_bytes()));
 
   std::weak_ptr<FirestoreClient> weak_this(shared_from_this());
   remote_store_ = absl::make_unique<RemoteStore>(
       local_store_.get(), std::move(datastore), worker_queue(),
       [weak_this](OnlineState online_state) {
         weak_this.lock()->sync_engine_->HandleOnlineStateChange(online_state);
-      });
+      },
+      settings.watch_stream_count());
 
   sync_engine_ = absl::make_unique<SyncEngine>(local_store_.get(),
                                                remote_store_.get(), user);
+  sync_engine_->SetMaxConcurrentLimboResolutions(static_cast<size_t>(
+      std::max(0, settings.max_concurrent_limbo_resolutions())));
+  sync_engine_->SetContainedQueriesServedLocally(
+      settings.contained_queries_served_locally());
 
   event_manager_ = absl::make_unique<EventManager>(sync_engine_.get());
+  event_manager_->SetListenLinger(
+      worker_queue(), std::chrono::milliseconds(settings.listen_linger_ms()));
 
   // Setup wiring for remote store.
   remote_store_->set_sync_engine(sync_engine_.get());
+  remote_store_->set_write_coalescing_enabled(
+      settings.write_coalescing_enabled());
+  int64_t idle_timeout_ms = settings.stream_idle_timeout_ms();
+  remote_store_->SetStreamIdleTimeouts(
+      std::chrono::milliseconds(idle_timeout_ms),
+      std::chrono::milliseconds(
+          std::max(idle_timeout_ms, settings.max_stream_idle_timeout_ms())));
+  remote_store_->set_max_transaction_read_staleness(
+      std::chrono::milliseconds(settings.max_transaction_read_staleness_ms()));
 
   // NOTE: RemoteStore depends on LocalStore (for persisting stream tokens,
   // refilling mutation queue, etc.) so must be started after LocalStore.
@@ -217,25 +400,161 @@ void FirestoreClient::Initialize(const User& user, const Settings& settings) {
 }
 
 /**
- * Schedules a callback to try running LRU garbage collection. Reschedules
- * itself after the GC has run.
+ * Schedules a callback to try running LRU garbage collection. Each callback
+ * runs one slice of the collection; while a collection is in progress the next
+ * slice is scheduled immediately, otherwise the callback reschedules itself
+ * after the regular delay.
  */
 void FirestoreClient::ScheduleLruGarbageCollection() {
-  std::chrono::milliseconds delay =
-      gc_has_run_ ? regular_gc_delay_ : initial_gc_delay_;
+  LruGarbageCollector* gc = lru_delegate_->garbage_collector();
+  std::chrono::milliseconds delay{0};
+  if (!gc->collection_in_progress()) {
+    delay = gc_has_run_ ? regular_gc_delay_ : initial_gc_delay_;
+  }
   std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
   lru_callback_ = worker_queue()->EnqueueAfterDelay(
-      delay, TimerId::GarbageCollectionDelay, [weak_this] {
+      delay, TimerId::GarbageCollectionDelay, [weak_this, gc] {
         auto shared_this = weak_this.lock();
         if (!shared_this) return;
 
-        shared_this->local_store_->CollectGarbage(
-            shared_this->lru_delegate_->garbage_collector());
-        shared_this->gc_has_run_ = true;
+        shared_this->local_store_->CollectGarbageSlice(
+            gc, kLruGarbageCollectionSliceSize);
+        if (!gc->collection_in_progress()) {
+          shared_this->gc_has_run_ = true;
+        }
         shared_this->ScheduleLruGarbageCollection();
       });
 }
 
+/**
+ * Schedules a callback to advance the rebuild of the remote document snapshot.
+ * Reschedules itself after each step.
+ */
+void FirestoreClient::ScheduleDocumentSnapshotCompaction() {
+  std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
+  snapshot_compaction_callback_ = worker_queue()->EnqueueAfterDelay(
+      snapshot_compaction_delay_, TimerId::DocumentSnapshotCompaction,
+      [weak_this] {
+        auto shared_this = weak_this.lock();
+        if (!shared_this) return;
+
+        shared_this->leveldb_persistence_->CompactDocumentSnapshot();
+        shared_this->ScheduleDocumentSnapshotCompaction();
+      });
+}
+
+/**
+ * Fills the memory cache from the snapshot that the previous process left,
+ * before the local store starts reading it.
+ */
+void FirestoreClient::LoadMemoryCacheSnapshot() {
+  StatusOr<Path> maybe_dir = LevelDbOpener(database_info_).LevelDbDataDir();
+  if (!maybe_dir.ok()) {
+    LOG_WARN("Not saving the memory cache: %s", maybe_dir.status().ToString());
+    memory_persistence_ = nullptr;
+    return;
+  }
+  Path dir = std::move(maybe_dir).ValueOrDie();
+  Status created = Filesystem::Default()->RecursivelyCreateDir(dir);
+  if (!created.ok()) {
+    LOG_WARN("Not saving the memory cache: %s", created.ToString());
+    memory_persistence_ = nullptr;
+    return;
+  }
+  memory_snapshot_path_ = dir.AppendUtf8("memory_cache.snapshot");
+
+  Status loaded = memory_persistence_->LoadSnapshot(
+      memory_snapshot_path_,
+      LocalSerializer(Serializer(database_info_.database_id())));
+  if (!loaded.ok() && loaded.code() != Error::kNotFound) {
+    LOG_WARN("Failed to load the memory cache snapshot: %s", loaded.ToString());
+  }
+}
+
+/**
+ * Schedules a callback to write the memory cache to its snapshot file.
+ * Reschedules itself after each write.
+ */
+void FirestoreClient::ScheduleMemoryCacheSnapshot() {
+  if (!memory_persistence_) return;
+
+  std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
+  memory_snapshot_callback_ = worker_queue()->EnqueueAfterDelay(
+      memory_snapshot_interval_, TimerId::MemoryCacheSnapshot, [weak_this] {
+        auto shared_this = weak_this.lock();
+        if (!shared_this) return;
+
+        shared_this->SaveMemoryCacheSnapshot();
+        shared_this->ScheduleMemoryCacheSnapshot();
+      });
+}
+
+void FirestoreClient::SaveMemoryCacheSnapshot() {
+  Status saved = memory_persistence_->SaveSnapshot(
+      memory_snapshot_path_,
+      LocalSerializer(Serializer(database_info_.database_id())));
+  if (!saved.ok()) {
+    LOG_WARN("Failed to save the memory cache snapshot: %s", saved.ToString());
+  }
+}
+
+/**
+ * Schedules a callback to advance the migrations that LevelDbPersistence left
+ * to run in the background, if any. Once they have started, each step
+ * schedules the next one immediately, at background priority, until they are
+ * complete.
+ */
+void FirestoreClient::ScheduleBackgroundMigration(
+    std::chrono::milliseconds delay) {
+  std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
+  migration_callback_ = worker_queue()->EnqueueAfterDelay(
+      delay, TimerId::BackgroundMigration, [weak_this] {
+        auto shared_this = weak_this.lock();
+        if (!shared_this) return;
+
+        if (shared_this->leveldb_persistence_->ContinueMigrations(
+                kBackgroundMigrationSliceSize)) {
+          shared_this->ScheduleBackgroundMigration(
+              std::chrono::milliseconds(0));
+        }
+      });
+}
+
+/**
+ * Schedules a callback to write the transactions that LevelDbPersistence holds
+ * on to for group commit.
+ */
+void FirestoreClient::ScheduleGroupCommitFlush() {
+  std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
+  group_commit_callback_ = worker_queue()->EnqueueAfterDelay(
+      group_commit_delay_, TimerId::GroupCommitFlush, [weak_this] {
+        auto shared_this = weak_this.lock();
+        if (!shared_this) return;
+
+        shared_this->leveldb_persistence_->FlushPendingCommits();
+      });
+}
+
+/**
+ * Schedules a callback to report the persistence metrics to the registered
+ * listener. Reschedules itself after each report.
+ */
+void FirestoreClient::SchedulePersistenceMetricsReport() {
+  std::weak_ptr<FirestoreClient> weak_this = shared_from_this();
+  metrics_callback_ = worker_queue()->EnqueueAfterDelay(
+      metrics_interval_, TimerId::PersistenceMetricsReport, [weak_this] {
+        auto shared_this = weak_this.lock();
+        if (!shared_this || !shared_this->metrics_listener_) return;
+
+        PersistenceMetrics::Snapshot snapshot =
+            shared_this->persistence_->metrics()->GetSnapshot();
+        PersistenceMetricsCallback listener = shared_this->metrics_listener_;
+        shared_this->user_executor()->Execute(
+            [listener, snapshot] { listener(snapshot); });
+        shared_this->SchedulePersistenceMetricsReport();
+      });
+}
+
 void FirestoreClient::DisableNetwork(StatusCallback callback) {
   VerifyNotTerminated();
   auto shared_this = shared_from_this();
@@ -287,7 +606,26 @@ void FirestoreClient::TerminateInternal() {
   if (lru_callback_) {
     lru_callback_.Cancel();
   }
+  if (metrics_callback_) {
+    metrics_callback_.Cancel();
+  }
+  if (snapshot_compaction_callback_) {
+    snapshot_compaction_callback_.Cancel();
+  }
+  if (migration_callback_) {
+    migration_callback_.Cancel();
+  }
+  if (group_commit_callback_) {
+    group_commit_callback_.Cancel();
+  }
+  if (memory_snapshot_callback_) {
+    memory_snapshot_callback_.Cancel();
+  }
   remote_store_->Shutdown();
+  local_store_->PersistBufferedTargetData();
+  if (memory_persistence_) {
+    SaveMemoryCacheSnapshot();
+  }
   persistence_->Shutdown();
 
   // Clear the remote store to indicate terminate is complete.
@@ -312,6 +650,81 @@ void FirestoreClient::WaitForPendingWrites(StatusCallback callback) {
   });
 }
 
+void FirestoreClient::GetPersistenceMetrics(
+    PersistenceMetricsCallback callback) {
+  VerifyNotTerminated();
+
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue([shared_this, callback] {
+    PersistenceMetrics::Snapshot snapshot =
+        shared_this->persistence_->metrics()->GetSnapshot();
+    if (callback) {
+      shared_this->user_executor()->Execute(
+          [callback, snapshot] { callback(snapshot); });
+    }
+  });
+}
+
+void FirestoreClient::GetTargetCosts(size_t count,
+                                     TargetCostOrder order,
+                                     TargetCostsCallback callback) {
+  VerifyNotTerminated();
+
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue([shared_this, count, order, callback] {
+    std::vector<TargetCost> costs =
+        shared_this->sync_engine_->GetTargetCosts(count, order);
+    if (callback) {
+      shared_this->user_executor()->Execute(
+          [callback, costs] { callback(costs); });
+    }
+  });
+}
+
+void FirestoreClient::ReleaseMemory(std::function<void(size_t)> callback) {
+  if (is_terminated()) return;
+
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue([shared_this, callback] {
+    if (shared_this->lru_callback_) {
+      // Run the slice that was scheduled for later now, and let the next one
+      // follow right away if the collection isn't done.
+      shared_this->lru_callback_.Cancel();
+      LruGarbageCollector* gc = shared_this->lru_delegate_->garbage_collector();
+      shared_this->local_store_->CollectGarbageSlice(
+          gc, kLruGarbageCollectionSliceSize);
+      if (!gc->collection_in_progress()) {
+        shared_this->gc_has_run_ = true;
+      }
+      shared_this->ScheduleLruGarbageCollection();
+    }
+
+    size_t released = shared_this->local_store_->ReleaseMemory();
+    if (callback) {
+      shared_this->user_executor()->Execute(
+          [callback, released] { callback(released); });
+    }
+  });
+}
+
+void FirestoreClient::SetPersistenceMetricsListener(
+    std::chrono::milliseconds interval, PersistenceMetricsCallback callback) {
+  VerifyNotTerminated();
+
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue([shared_this, interval, callback] {
+    if (shared_this->metrics_callback_) {
+      shared_this->metrics_callback_.Cancel();
+    }
+
+    shared_this->metrics_interval_ = interval;
+    shared_this->metrics_listener_ = callback;
+    if (callback) {
+      shared_this->SchedulePersistenceMetricsReport();
+    }
+  });
+}
+
 void FirestoreClient::VerifyNotTerminated() {
   if (is_terminated()) {
     ThrowIllegalState("The client has already been terminated.");
@@ -329,17 +742,34 @@ std::shared_ptr<QueryListener> FirestoreClient::ListenToQuery(
     Query query, ListenOptions options, ViewSnapshotSharedListener&& listener) {
   VerifyNotTerminated();
 
+  util::TraceSpan span("FirestoreClient::ListenToQuery");
+  if (span.active()) {
+    span.SetAttribute("query", query.CanonicalId());
+  }
+
   auto query_listener = QueryListener::Create(
       std::move(query), std::move(options), std::move(listener));
 
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, query_listener] {
+  util::SpanId parent_span = span.id();
+  worker_queue()->Enqueue([shared_this, query_listener, parent_span] {
+    util::TraceSpan worker_span("EventManager::AddQueryListener", parent_span);
     shared_this->event_manager_->AddQueryListener(std::move(query_listener));
   });
 
   return query_listener;
 }
 
+void FirestoreClient::ListenToQueries(
+    std::vector<std::shared_ptr<QueryListener>> listeners) {
+  VerifyNotTerminated();
+
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue([shared_this, listeners] {
+    shared_this->event_manager_->AddQueryListeners(listeners);
+  });
+}
+
 void FirestoreClient::RemoveListener(
     const std::shared_ptr<QueryListener>& listener) {
   // Checks for termination but does not throw error, allowing it to be an no-op
@@ -403,17 +833,8 @@ void FirestoreClient::GetDocumentsFromLocalCache(
     QueryResult query_result = shared_this->local_store_->ExecuteQuery(
         query.query(), /* use_previous_results= */ true);
 
-    View view(query.query(), query_result.remote_keys());
-    ViewDocumentChanges view_doc_changes =
-        view.ComputeDocumentChanges(query_result.documents().underlying_map());
-    ViewChange view_change = view.ApplyChanges(view_doc_changes);
-    HARD_ASSERT(
-        view_change.limbo_changes().empty(),
-        "View returned limbo documents during local-only query execution.");
-
-    HARD_ASSERT(view_change.snapshot().has_value(), "Expected a snapshot");
-
-    ViewSnapshot snapshot = std::move(view_change.snapshot()).value();
+    ViewSnapshot snapshot =
+        View::ComputeLocalSnapshot(query.query(), query_result.documents());
     SnapshotMetadata metadata(snapshot.has_pending_writes(),
                               snapshot.from_cache());
 
@@ -427,24 +848,314 @@ void FirestoreClient::GetDocumentsFromLocalCache(
   });
 }
 
+void FirestoreClient::GetDocumentFromServer(
+    const DocumentReference& doc, DocumentSnapshotListener&& callback) {
+  VerifyNotTerminated();
+
+  // TODO(c++14): move `callback` into lambda.
+  auto shared_callback = absl::ShareUniquePtr(std::move(callback));
+  auto shared_this = shared_from_this();
+  auto deliver = [shared_this,
+                  shared_callback](StatusOr<DocumentSnapshot> maybe_snapshot) {
+    if (shared_callback) {
+      shared_this->user_executor()->Execute(
+          [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+    }
+  };
+
+  worker_queue()->Enqueue([shared_this, doc, shared_callback, deliver] {
+    if (shared_this->local_store_->GetHighestUnacknowledgedBatchId() !=
+        kBatchIdUnknown) {
+      shared_this->user_executor()->Execute([doc, shared_callback] {
+        DocumentReference(doc).GetDocumentByListening(
+            Source::Server, EventListener<DocumentSnapshot>::Create(
+                                [shared_callback](
+                                    StatusOr<DocumentSnapshot> snapshot) {
+                                  if (shared_callback) {
+                                    shared_callback->OnEvent(
+                                        std::move(snapshot));
+                                  }
+                                }));
+      });
+      return;
+    }
+
+    if (!shared_this->remote_store_->CanUseNetwork()) {
+      deliver(Status{Error::kUnavailable,
+                     "Failed to get document from server because the client "
+                     "is offline."});
+      return;
+    }
+
+    shared_this->remote_store_->LookupDocuments(
+        {doc.key()},
+        [shared_this, doc,
+         deliver](const StatusOr<std::vector<MaybeDocument>>& result) {
+          if (!result.ok()) {
+            deliver(result.status());
+            return;
+          }
+
+          SnapshotMetadata metadata{/*has_pending_writes=*/false,
+                                    /*from_cache=*/false};
+          for (const MaybeDocument& maybe_doc : result.ValueOrDie()) {
+            if (maybe_doc.is_document()) {
+              Document document(maybe_doc);
+              // The document was current as of its own version, which is the
+              // latest read time that is known for it.
+              shared_this->local_store_->SaveReadDocuments({document},
+                                                           document.version());
+              deliver(DocumentSnapshot::FromDocument(doc.firestore(), document,
+                                                     metadata));
+              return;
+            }
+          }
+          deliver(DocumentSnapshot::FromNoDocument(doc.firestore(), doc.key(),
+                                                   metadata));
+        });
+  });
+}
+
+void FirestoreClient::GetDocumentsFromServer(const api::Query& query,
+                                             QuerySnapshotListener&& callback) {
+  VerifyNotTerminated();
+
+  // TODO(c++14): move `callback` into lambda.
+  auto shared_callback = absl::ShareUniquePtr(std::move(callback));
+  auto shared_this = shared_from_this();
+  auto deliver = [shared_this,
+                  shared_callback](StatusOr<QuerySnapshot> maybe_snapshot) {
+    if (shared_callback) {
+      shared_this->user_executor()->Execute(
+          [=] { shared_callback->OnEvent(std::move(maybe_snapshot)); });
+    }
+  };
+
+  worker_queue()->Enqueue([shared_this, query, shared_callback, deliver] {
+    if (shared_this->local_store_->GetHighestUnacknowledgedBatchId() !=
+        kBatchIdUnknown) {
+      shared_this->user_executor()->Execute([query, shared_callback] {
+        api::Query(query).GetDocumentsByListening(
+            Source::Server,
+            EventListener<QuerySnapshot>::Create(
+                [shared_callback](StatusOr<QuerySnapshot> snapshot) {
+                  if (shared_callback) {
+                    shared_callback->OnEvent(std::move(snapshot));
+                  }
+                }));
+      });
+      return;
+    }
+
+    if (!shared_this->remote_store_->CanUseNetwork()) {
+      deliver(Status{Error::kUnavailable,
+                     "Failed to get documents from server because the client "
+                     "is offline."});
+      return;
+    }
+
+    shared_this->remote_store_->RunQuery(
+        query.query().ToTarget(),
+        [shared_this, query,
+         deliver](const StatusOr<RunQueryResult>& result) {
+          if (!result.ok()) {
+            deliver(result.status());
+            return;
+          }
+
+          const RunQueryResult& query_result = result.ValueOrDie();
+          shared_this->local_store_->SaveReadDocuments(query_result.documents,
+                                                       query_result.read_time);
+
+          DocumentMap documents;
+          for (const Document& doc : query_result.documents) {
+            documents = documents.insert(doc.key(), doc);
+          }
+          ViewSnapshot snapshot = View::ComputeLocalSnapshot(
+              query.query(), documents, /*from_cache=*/false);
+          SnapshotMetadata metadata(snapshot.has_pending_writes(),
+                                    snapshot.from_cache());
+          deliver(QuerySnapshot(query.firestore(), query.query(),
+                                std::move(snapshot), std::move(metadata)));
+        });
+  });
+}
+
+void FirestoreClient::CountQuery(const Query& query,
+                                 Source source,
+                                 StatusOrCallback<int64_t> callback) {
+  VerifyNotTerminated();
+
+  auto shared_this = shared_from_this();
+  auto count_locally = [shared_this, query, callback] {
+    auto count =
+        static_cast<int64_t>(shared_this->local_store_->CountQuery(query));
+    if (callback) {
+      shared_this->user_executor()->Execute(
+          [callback, count] { callback(count); });
+    }
+  };
+
+  worker_queue()->Enqueue([shared_this, query, source, callback,
+                           count_locally] {
+    if (source == Source::Cache ||
+        (source == Source::Default &&
+         !shared_this->remote_store_->CanUseNetwork())) {
+      count_locally();
+      return;
+    }
+
+    shared_this->remote_store_->CountQuery(
+        query.ToTarget(), [shared_this, source, callback,
+                           count_locally](const StatusOr<int64_t>& result) {
+          if (!result.ok() && source == Source::Default &&
+              result.status().code() == Error::kUnavailable) {
+            count_locally();
+            return;
+          }
+          if (callback) {
+            shared_this->user_executor()->Execute(
+                [callback, result] { callback(result); });
+          }
+        });
+  });
+}
+
+void FirestoreClient::ExplainQuery(const Query& query,
+                                   QueryExplanationCallback callback) {
+  VerifyNotTerminated();
+
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue([shared_this, query, callback] {
+    QueryExplanation explanation =
+        shared_this->local_store_->ExplainQuery(query);
+    if (callback) {
+      shared_this->user_executor()->Execute(
+          [callback, explanation] { callback(explanation); });
+    }
+  });
+}
+
+void FirestoreClient::PrefetchQueries(std::vector<Query> queries,
+                                      PrefetchProgressCallback progress,
+                                      StatusCallback callback) {
+  VerifyNotTerminated();
+
+  struct PrefetchState {
+    PrefetchProgress progress;
+    Status status;
+  };
+
+  // TODO(c++14): move `queries` into lambda.
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue([shared_this, queries, progress, callback] {
+    if (queries.empty()) {
+      if (callback) {
+        shared_this->user_executor()->Execute([=] { callback(Status::OK()); });
+      }
+      return;
+    }
+
+    auto state = std::make_shared<PrefetchState>();
+    state->progress.queries_total = queries.size();
+
+    for (const Query& query : queries) {
+      const Target& target = query.ToTarget();
+      shared_this->remote_store_->RunQuery(
+          target, [shared_this, target, state, progress,
+                   callback](const StatusOr<RunQueryResult>& result) {
+            if (result.ok()) {
+              const RunQueryResult& query_result = result.ValueOrDie();
+              shared_this->local_store_->SavePrefetchedTarget(
+                  target, query_result.documents, query_result.read_time);
+              state->progress.documents_loaded +=
+                  query_result.documents.size();
+              state->progress.bytes_loaded += query_result.byte_size;
+            } else if (state->status.ok()) {
+              state->status = result.status();
+            }
+            ++state->progress.queries_loaded;
+
+            if (progress) {
+              PrefetchProgress snapshot = state->progress;
+              shared_this->user_executor()->Execute(
+                  [progress, snapshot] { progress(snapshot); });
+            }
+            if (state->progress.queries_loaded ==
+                    state->progress.queries_total &&
+                callback) {
+              Status status = state->status;
+              shared_this->user_executor()->Execute(
+                  [callback, status] { callback(status); });
+            }
+          });
+    }
+  });
+}
+
+void FirestoreClient::LoadBundle(
+    std::string bundle,
+    StatusOrCallback<std::vector<NamedQuery>> callback) {
+  VerifyNotTerminated();
+
+  // TODO(c++14): move `bundle` into lambda.
+  auto shared_bundle = std::make_shared<std::string>(std::move(bundle));
+  auto shared_this = shared_from_this();
+  worker_queue()->Enqueue(
+      [shared_this, shared_bundle, callback] {
+        // Don't touch the stores if the client was terminated while this
+        // waited in the background lane.
+        if (!shared_this->remote_store_) {
+          if (callback) {
+            shared_this->user_executor()->Execute([callback] {
+              callback(Status(Error::kFailedPrecondition,
+                              "The client has already been terminated."));
+            });
+          }
+          return;
+        }
+
+        BundleLoader loader(shared_this->local_store_.get(),
+                            shared_this->database_id());
+        // Any error is reported again by `Finish`.
+        loader.AddChunk(*shared_bundle).IgnoreError();
+        StatusOr<std::vector<NamedQuery>> result = loader.Finish();
+
+        if (callback) {
+          shared_this->user_executor()->Execute(
+              [callback, result] { callback(result); });
+        }
+      },
+      AsyncQueue::Priority::Background);
+}
+
 void FirestoreClient::WriteMutations(std::vector<Mutation>&& mutations,
                                      StatusCallback callback) {
   VerifyNotTerminated();
 
+  util::TraceSpan span("FirestoreClient::WriteMutations");
+  span.SetAttribute("mutations", static_cast<int64_t>(mutations.size()));
+
   // TODO(c++14): move `mutations` into lambda (C++14).
   auto shared_this = shared_from_this();
-  worker_queue()->Enqueue([shared_this, mutations, callback]() mutable {
+  util::SpanId parent_span = span.id();
+  worker_queue()->Enqueue([shared_this, mutations, callback,
+                           parent_span]() mutable {
     if (mutations.empty()) {
       if (callback) {
         shared_this->user_executor()->Execute([=] { callback(Status::OK()); });
       }
     } else {
+      util::TraceSpan worker_span("SyncEngine::WriteMutations", parent_span);
       shared_this->sync_engine_->WriteMutations(
           std::move(mutations), [callback, shared_this](Status error) {
             // Dispatch the result back onto the user dispatch queue.
             if (callback) {
-              shared_this->user_executor()->Execute(
-                  [=] { callback(std::move(error)); });
+              util::SpanId parent_span = util::TraceSpan::Current();
+              shared_this->user_executor()->Execute([=] {
+                util::TraceSpan callback_span("UserCallback", parent_span);
+                callback(std::move(error));
+              });
             }
           });
     }
@@ -473,6 +1184,25 @@ void FirestoreClient::Transaction(int retries,
   });
 }
 
+std::shared_ptr<BulkWriter> FirestoreClient::CreateBulkWriter() {
+  VerifyNotTerminated();
+
+  std::weak_ptr<FirestoreClient> weak_this(shared_from_this());
+  auto commit = [weak_this](const std::vector<Mutation>& mutations,
+                            StatusCallback callback) {
+    auto shared_this = weak_this.lock();
+    if (!shared_this || !shared_this->remote_store_) {
+      callback(Status(Error::kFailedPrecondition,
+                      "The client has already been terminated."));
+      return;
+    }
+    shared_this->remote_store_->CommitMutations(mutations, std::move(callback));
+  };
+
+  return std::make_shared<BulkWriter>(worker_queue(), user_executor(),
+                                      std::move(commit));
+}
+
 void FirestoreClient::AddSnapshotsInSyncListener(
     const std::shared_ptr<EventListener<Empty>>& user_listener) {
   auto shared_this = shared_from_this();
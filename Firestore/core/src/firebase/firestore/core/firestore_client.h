@@ -17,18 +17,26 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FIRESTORE_CLIENT_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_FIRESTORE_CLIENT_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/api/api_fwd.h"
 #include "Firestore/core/src/firebase/firestore/core/core_fwd.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/target_cost.h"
+#include "Firestore/core/src/firebase/firestore/local/persistence_metrics.h"
+#include "Firestore/core/src/firebase/firestore/local/query_explanation.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
 #include "Firestore/core/src/firebase/firestore/util/empty.h"
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/nullability.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
 
 namespace firebase {
@@ -40,8 +48,11 @@ class User;
 }  // namespace auth
 
 namespace local {
+struct NamedQuery;
 class LocalStore;
+class LevelDbPersistence;
 class LruDelegate;
+class MemoryPersistence;
 class Persistence;
 class QueryEngine;
 }  // namespace local
@@ -51,11 +62,33 @@ class Mutation;
 }  // namespace model
 
 namespace remote {
+class Datastore;
 class RemoteStore;
 }  // namespace remote
 
 namespace core {
 
+/** The progress of a `FirestoreClient::PrefetchQueries` call. */
+struct PrefetchProgress {
+  size_t queries_loaded = 0;
+  size_t queries_total = 0;
+  size_t documents_loaded = 0;
+  /** The size of the responses received from the backend so far. */
+  size_t bytes_loaded = 0;
+};
+
+using PrefetchProgressCallback = std::function<void(const PrefetchProgress&)>;
+
+/**
+ * Creates the `Datastore` a `FirestoreClient` talks to the backend through, in
+ * place of one connected over gRPC (e.g. to run clients against a fake
+ * backend).
+ */
+using DatastoreFactory = std::function<std::shared_ptr<remote::Datastore>(
+    const DatabaseInfo&,
+    const std::shared_ptr<util::AsyncQueue>&,
+    std::shared_ptr<auth::CredentialsProvider>)>;
+
 /**
  * FirestoreClient is a top-level class that constructs and owns all of the
  * pieces of the client SDK architecture.
@@ -70,13 +103,18 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    * it is invalid to call `shared_from_this()` from constructors.
    * The factory function enforces that `FirestoreClient` has to be managed
    * by a shared pointer.
+   *
+   * If `datastore_factory` is given, the client uses the `Datastore` it
+   * creates instead of connecting to `database_info.host()`, and ignores the
+   * settings of the connection.
    */
   static std::shared_ptr<FirestoreClient> Create(
       const DatabaseInfo& database_info,
       const api::Settings& settings,
       std::shared_ptr<auth::CredentialsProvider> credentials_provider,
       std::shared_ptr<util::Executor> user_executor,
-      std::shared_ptr<util::AsyncQueue> worker_queue);
+      std::shared_ptr<util::AsyncQueue> worker_queue,
+      DatastoreFactory datastore_factory = nullptr);
 
   /**
    * Terminates this client, cancels all writes / listeners, and releases all
@@ -109,6 +147,14 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
       ListenOptions options,
       ViewSnapshotSharedListener&& listener);
 
+  /**
+   * Starts all the given query listeners, created with
+   * `QueryListener::Create`, in a single operation on the worker queue. The
+   * targets of the queries are allocated together and their listens are sent
+   * to the backend back to back.
+   */
+  void ListenToQueries(std::vector<std::shared_ptr<QueryListener>> listeners);
+
   /** Stops listening to a query previously listened to. */
   void RemoveListener(const std::shared_ptr<core::QueryListener>& listener);
 
@@ -126,6 +172,70 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   void GetDocumentsFromLocalCache(const api::Query& query,
                                   api::QuerySnapshotListener&& callback);
 
+  /**
+   * Reads a document once from the backend with a BatchGetDocuments call,
+   * without listening to it, and saves it in the local cache.
+   *
+   * While there are pending writes, which have to be applied to the result,
+   * the document is read by listening to it instead.
+   */
+  void GetDocumentFromServer(const api::DocumentReference& doc,
+                             api::DocumentSnapshotListener&& callback);
+
+  /**
+   * Reads the documents matching the given query once from the backend with a
+   * RunQuery call, without listening to it, and saves them in the local cache
+   * in a single transaction.
+   *
+   * While there are pending writes, which have to be applied to the results,
+   * the query is read by listening to it instead.
+   */
+  void GetDocumentsFromServer(const api::Query& query,
+                              api::QuerySnapshotListener&& callback);
+
+  /**
+   * Counts the documents matching the given query, up to its limit.
+   *
+   * With `Source::Default`, the count comes from the backend, which sends back
+   * only the names of the matching documents, and none are cached. If the
+   * backend can't be reached, the documents in the local cache are counted
+   * instead, as they are with `Source::Cache`.
+   */
+  void CountQuery(const Query& query,
+                  api::Source source,
+                  util::StatusOrCallback<int64_t> callback);
+
+  /**
+   * Runs the given query against the local cache and passes a description of
+   * how it was executed to the callback: the query engine path taken, the
+   * documents read and matched, the mutation batches applied and the time
+   * spent in each phase.
+   */
+  void ExplainQuery(const Query& query,
+                    local::QueryExplanationCallback callback);
+
+  /**
+   * Reads the results of the given queries from the backend once and saves
+   * them in the local cache, so that they are available offline. No listeners
+   * are attached and no snapshots are raised.
+   *
+   * `progress` is called as each query's results are saved, and `callback`
+   * once all the queries have finished, with the first error encountered, if
+   * any.
+   */
+  void PrefetchQueries(std::vector<Query> queries,
+                       PrefetchProgressCallback progress,
+                       util::StatusCallback callback);
+
+  /**
+   * Loads a bundle built with `local::BundleBuilder` into the local cache and
+   * passes the named queries it contains to the callback. Listening to one of
+   * them then starts from the bundled results.
+   */
+  void LoadBundle(
+      std::string bundle,
+      util::StatusOrCallback<std::vector<local::NamedQuery>> callback);
+
   /**
    * Write mutations. callback will be notified when it's written to the
    * backend.
@@ -140,6 +250,12 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
                    TransactionUpdateCallback update_callback,
                    TransactionResultCallback result_callback);
 
+  /**
+   * Returns a new `BulkWriter` whose commits are sent through this client.
+   * Writes made after the client is terminated fail.
+   */
+  std::shared_ptr<BulkWriter> CreateBulkWriter();
+
   /**
    * Adds a listener to be called when a snapshots-in-sync event fires.
    */
@@ -152,6 +268,44 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   void RemoveSnapshotsInSyncListener(
       const std::shared_ptr<EventListener<util::Empty>>& listener);
 
+  /**
+   * Retrieves a snapshot of the counters describing the work done by the local
+   * persistence layer via the indicated callback.
+   */
+  void GetPersistenceMetrics(local::PersistenceMetricsCallback callback);
+
+  /**
+   * Retrieves, via the indicated callback, what it has cost so far to keep
+   * each active query up to date: the time spent running it against the
+   * local store, computing its view changes and building its snapshots, the
+   * documents scanned, and the memory its view retains. Only the `count` most
+   * expensive queries by the given measure are reported, most expensive
+   * first.
+   */
+  void GetTargetCosts(size_t count,
+                      TargetCostOrder order,
+                      TargetCostsCallback callback);
+
+  /**
+   * Responds to memory pressure: drops the in-memory caches that can be
+   * rebuilt from the local store and runs a slice of garbage collection right
+   * away, if it is enabled. The callback receives an estimate of the number of
+   * bytes released.
+   *
+   * Unlike other methods, this does nothing once the client is terminated, so
+   * that it can be called from system notifications at any time.
+   */
+  void ReleaseMemory(std::function<void(size_t)> callback);
+
+  /**
+   * Registers a callback that receives a snapshot of the persistence metrics
+   * every `interval`, replacing any previously registered callback. Passing a
+   * null callback stops the reports.
+   */
+  void SetPersistenceMetricsListener(
+      std::chrono::milliseconds interval,
+      local::PersistenceMetricsCallback callback);
+
   /** The database ID of the DatabaseInfo this client was initialized with. */
   const model::DatabaseId& database_id() const {
     return database_info_.database_id();
@@ -177,7 +331,8 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
       const DatabaseInfo& database_info,
       std::shared_ptr<auth::CredentialsProvider> credentials_provider,
       std::shared_ptr<util::Executor> user_executor,
-      std::shared_ptr<util::AsyncQueue> worker_queue);
+      std::shared_ptr<util::AsyncQueue> worker_queue,
+      DatastoreFactory datastore_factory);
 
   void Initialize(const auth::User& user, const api::Settings& settings);
 
@@ -187,6 +342,20 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
 
   void ScheduleLruGarbageCollection();
 
+  void SchedulePersistenceMetricsReport();
+
+  void ScheduleDocumentSnapshotCompaction();
+
+  void ScheduleBackgroundMigration(std::chrono::milliseconds delay);
+
+  void ScheduleGroupCommitFlush();
+
+  void LoadMemoryCacheSnapshot();
+
+  void ScheduleMemoryCacheSnapshot();
+
+  void SaveMemoryCacheSnapshot();
+
   DatabaseInfo database_info_;
   std::shared_ptr<auth::CredentialsProvider> credentials_provider_;
   /**
@@ -198,6 +367,7 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
    */
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   std::shared_ptr<util::Executor> user_executor_;
+  DatastoreFactory datastore_factory_;
 
   std::unique_ptr<local::Persistence> persistence_;
   std::unique_ptr<local::LocalStore> local_store_;
@@ -212,6 +382,26 @@ class FirestoreClient : public std::enable_shared_from_this<FirestoreClient> {
   bool credentials_initialized_ = false;
   local::LruDelegate* _Nullable lru_delegate_;
   util::DelayedOperation lru_callback_;
+
+  std::chrono::milliseconds metrics_interval_{0};
+  local::PersistenceMetricsCallback metrics_listener_;
+  util::DelayedOperation metrics_callback_;
+
+  std::chrono::milliseconds snapshot_compaction_delay_ =
+      std::chrono::minutes(1);
+  local::LevelDbPersistence* _Nullable leveldb_persistence_ = nullptr;
+  util::DelayedOperation snapshot_compaction_callback_;
+
+  std::chrono::milliseconds initial_migration_delay_ = std::chrono::seconds(5);
+  util::DelayedOperation migration_callback_;
+
+  std::chrono::milliseconds group_commit_delay_{0};
+  util::DelayedOperation group_commit_callback_;
+
+  std::chrono::milliseconds memory_snapshot_interval_{0};
+  local::MemoryPersistence* _Nullable memory_persistence_ = nullptr;
+  util::Path memory_snapshot_path_;
+  util::DelayedOperation memory_snapshot_callback_;
 };
 
 }  // namespace core
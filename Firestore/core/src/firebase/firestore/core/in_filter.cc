@@ -17,18 +17,18 @@
 #include "Firestore/core/src/firebase/firestore/core/in_filter.h"
 
 #include <memory>
+#include <unordered_set>
 #include <utility>
 
-#include "Firestore/core/src/firebase/firestore/model/document.h"
-#include "absl/algorithm/container.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 namespace firebase {
 namespace firestore {
 namespace core {
 
-using model::Document;
 using model::FieldPath;
 using model::FieldValue;
+using model::FieldValueHash;
 
 using Operator = Filter::Operator;
 
@@ -36,13 +36,19 @@ class InFilter::Rep : public FieldFilter::Rep {
  public:
   Rep(FieldPath field, FieldValue value)
       : FieldFilter::Rep(std::move(field), Operator::In, std::move(value)) {
+    const FieldValue::Array& array_value = this->value().array_value();
+    values_.insert(array_value.begin(), array_value.end());
   }
 
   Type type() const override {
     return Type::kInFilter;
   }
 
-  bool Matches(const model::Document& doc) const override;
+  bool MatchesValue(const FieldValue& lhs) const override;
+
+ private:
+  /** The values of the `in` array, so that matching doesn't scan it. */
+  std::unordered_set<FieldValue, FieldValueHash> values_;
 };
 
 InFilter::InFilter(FieldPath field, FieldValue value)
@@ -50,11 +56,8 @@ InFilter::InFilter(FieldPath field, FieldValue value)
           std::make_shared<const Rep>(std::move(field), std::move(value))) {
 }
 
-bool InFilter::Rep::Matches(const Document& doc) const {
-  const FieldValue::Array& array_value = value().array_value();
-  absl::optional<FieldValue> maybe_lhs = doc.field(field());
-  if (!maybe_lhs) return false;
-  return absl::c_linear_search(array_value, *maybe_lhs);
+bool InFilter::Rep::MatchesValue(const FieldValue& lhs) const {
+  return values_.find(lhs) != values_.end();
 }
 
 }  // namespace core
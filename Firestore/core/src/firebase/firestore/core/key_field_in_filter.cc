@@ -17,11 +17,11 @@
 #include "Firestore/core/src/firebase/firestore/core/key_field_in_filter.h"
 
 #include <memory>
+#include <unordered_set>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
-#include "absl/algorithm/container.h"
 
 namespace firebase {
 namespace firestore {
@@ -29,6 +29,7 @@ namespace core {
 
 using model::Document;
 using model::DocumentKey;
+using model::DocumentKeyHash;
 using model::FieldPath;
 using model::FieldValue;
 
@@ -43,6 +44,7 @@ class KeyFieldInFilter::Rep : public FieldFilter::Rep {
       HARD_ASSERT(ref_value.type() == FieldValue::Type::Reference,
                   "Comparing on key with IN, but an array value was not"
                   " a Reference");
+      keys_.insert(ref_value.reference_value().key());
     }
   }
 
@@ -51,6 +53,10 @@ class KeyFieldInFilter::Rep : public FieldFilter::Rep {
   }
 
   bool Matches(const model::Document& doc) const override;
+
+ private:
+  /** The keys referenced by the `in` array. */
+  std::unordered_set<DocumentKey, DocumentKeyHash> keys_;
 };
 
 KeyFieldInFilter::KeyFieldInFilter(FieldPath field, FieldValue value)
@@ -59,13 +65,7 @@ KeyFieldInFilter::KeyFieldInFilter(FieldPath field, FieldValue value)
 }
 
 bool KeyFieldInFilter::Rep::Matches(const Document& doc) const {
-  const FieldValue::Array& array_value = value().array_value();
-  for (const auto& rhs : array_value) {
-    if (doc.key() == rhs.reference_value().key()) {
-      return true;
-    }
-  }
-  return false;
+  return keys_.find(doc.key()) != keys_.end();
 }
 
 }  // namespace core
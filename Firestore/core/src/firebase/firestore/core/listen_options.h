@@ -17,8 +17,18 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_LISTEN_OPTIONS_H_
 
+#include <memory>
+#include <utility>
+
+#include "absl/types/optional.h"
+
 namespace firebase {
 namespace firestore {
+
+namespace util {
+class Executor;
+}  // namespace util
+
 namespace core {
 
 class ListenOptions {
@@ -34,13 +44,23 @@ class ListenOptions {
    *     documents changes.
    * @param wait_for_sync_when_online Wait for a sync with the server when
    *     online, but still raise events while offline
+   * @param conflate_snapshots Merge snapshots that are raised while an earlier
+   *     one is still waiting to be delivered, so that the listener only
+   *     receives the latest state.
+   * @param changes_only Only read the document changes of snapshots after the
+   *     first one, so that the documents of the query don't need to be kept in
+   *     memory once the first snapshot was raised.
    */
   ListenOptions(bool include_query_metadata_changes,
                 bool include_document_metadata_changes,
-                bool wait_for_sync_when_online)
+                bool wait_for_sync_when_online,
+                bool conflate_snapshots = false,
+                bool changes_only = false)
       : include_query_metadata_changes_(include_query_metadata_changes),
         include_document_metadata_changes_(include_document_metadata_changes),
-        wait_for_sync_when_online_(wait_for_sync_when_online) {
+        wait_for_sync_when_online_(wait_for_sync_when_online),
+        conflate_snapshots_(conflate_snapshots),
+        changes_only_(changes_only) {
   }
 
   /**
@@ -78,10 +98,42 @@ class ListenOptions {
     return wait_for_sync_when_online_;
   }
 
+  bool conflate_snapshots() const {
+    return conflate_snapshots_;
+  }
+
+  /**
+   * Whether the listener only reads the document changes of snapshots after
+   * the first one. While all listeners of a query do, the view of the query
+   * keeps only the sort fields of documents without pending writes, so the
+   * `documents()` of later snapshots, and the documents of their `Removed`
+   * changes, hold only those fields.
+   */
+  bool changes_only() const {
+    return changes_only_;
+  }
+
+  /**
+   * The executor that raises the events of the listener, if not the user
+   * executor of the client. A null executor raises them inline on the worker
+   * queue as soon as they're computed, without a thread hop, which suits
+   * lightweight, thread-safe listeners that hand events off themselves.
+   */
+  const absl::optional<std::shared_ptr<util::Executor>>& executor() const {
+    return executor_;
+  }
+
+  void set_executor(std::shared_ptr<util::Executor> executor) {
+    executor_ = std::move(executor);
+  }
+
  private:
   bool include_query_metadata_changes_ = false;
   bool include_document_metadata_changes_ = false;
   bool wait_for_sync_when_online_ = false;
+  bool conflate_snapshots_ = false;
+  bool changes_only_ = false;
+  absl::optional<std::shared_ptr<util::Executor>> executor_;
 };
 
 }  // namespace core
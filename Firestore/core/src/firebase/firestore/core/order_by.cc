@@ -38,9 +38,9 @@ ComparisonResult OrderBy::Compare(const Document& lhs,
   if (field_ == FieldPath::KeyFieldPath()) {
     result = lhs.key().CompareTo(rhs.key());
   } else {
-    absl::optional<FieldValue> value1 = lhs.field(field_);
-    absl::optional<FieldValue> value2 = rhs.field(field_);
-    HARD_ASSERT(value1.has_value() && value2.has_value(),
+    const FieldValue* value1 = lhs.data().Find(field_);
+    const FieldValue* value2 = rhs.data().Find(field_);
+    HARD_ASSERT(value1 && value2,
                 "Trying to compare documents on fields that don't exist.");
     result = value1->CompareTo(*value2);
   }
@@ -17,19 +17,28 @@
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <ostream>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/bound.h"
 #include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/filter_program.h"
 #include "Firestore/core/src/firebase/firestore/core/operator.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/util/equality.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "absl/algorithm/container.h"
 #include "absl/strings/str_cat.h"
 
@@ -43,9 +52,35 @@ using Type = Filter::Type;
 using model::Document;
 using model::DocumentComparator;
 using model::DocumentKey;
+using model::FieldMask;
 using model::FieldPath;
+using model::FieldValue;
 using model::ResourcePath;
 using util::ComparisonResult;
+using util::OrderedCode;
+
+Query::Query(ResourcePath path,
+             CollectionGroupId collection_group,
+             FilterList filters,
+             OrderByList explicit_order_bys,
+             int32_t limit,
+             LimitType limit_type,
+             std::shared_ptr<Bound> start_at,
+             std::shared_ptr<Bound> end_at,
+             std::shared_ptr<const FieldMask> projection)
+    : path_(std::move(path)),
+      collection_group_(std::move(collection_group)),
+      filters_(std::move(filters)),
+      explicit_order_bys_(std::move(explicit_order_bys)),
+      limit_(limit),
+      limit_type_(limit_type),
+      start_at_(std::move(start_at)),
+      end_at_(std::move(end_at)),
+      projection_(std::move(projection)) {
+  if (!filters_.empty()) {
+    filter_program_ = std::make_shared<const FilterProgram>(filters_);
+  }
+}
 
 Query::Query(ResourcePath path, std::string collection_group)
     : path_(std::move(path)),
@@ -159,6 +194,35 @@ const FieldPath* Query::FirstOrderByField() const {
   return &explicit_order_bys_.front().field();
 }
 
+namespace {
+
+/** Returns the document key a bound of a key-ordered query is positioned at. */
+absl::optional<DocumentKey> BoundKey(const std::shared_ptr<Bound>& bound) {
+  if (!bound || bound->position().empty()) return absl::nullopt;
+
+  const FieldValue& position = bound->position()[0];
+  if (!position.is_reference()) return absl::nullopt;
+  return position.reference_value().key();
+}
+
+}  // namespace
+
+bool Query::IsKeyOrdered() const {
+  const OrderByList& order_bys = this->order_bys();
+  return order_bys.size() == 1 && order_bys[0].field().IsKeyFieldPath() &&
+         order_bys[0].ascending();
+}
+
+absl::optional<DocumentKey> Query::StartKey() const {
+  if (!IsKeyOrdered()) return absl::nullopt;
+  return BoundKey(start_at_);
+}
+
+absl::optional<DocumentKey> Query::EndKey() const {
+  if (!IsKeyOrdered()) return absl::nullopt;
+  return BoundKey(end_at_);
+}
+
 LimitType Query::limit_type() const {
   return limit_type_;
 }
@@ -169,6 +233,22 @@ int32_t Query::limit() const {
   return limit_;
 }
 
+const FieldMask& Query::ReadMask() const {
+  HARD_ASSERT(projection_, "Called ReadMask() on a query without projection");
+  if (!memoized_read_mask_) {
+    std::set<FieldPath> fields(projection_->begin(), projection_->end());
+    for (const Filter& filter : filters_) {
+      fields.insert(filter.field());
+    }
+    for (const OrderBy& order_by : order_bys()) {
+      fields.insert(order_by.field());
+    }
+    fields.erase(FieldPath::KeyFieldPath());
+    memoized_read_mask_ = std::make_shared<const FieldMask>(std::move(fields));
+  }
+  return *memoized_read_mask_;
+}
+
 // MARK: - Builder methods
 
 Query Query::AddingFilter(Filter filter) const {
@@ -186,7 +266,8 @@ Query Query::AddingFilter(Filter filter) const {
   // TODO(rsgowman): ensure first orderby must match inequality field
 
   return Query(path_, collection_group_, filters_.push_back(std::move(filter)),
-               explicit_order_bys_, limit_, limit_type_, start_at_, end_at_);
+               explicit_order_bys_, limit_, limit_type_, start_at_, end_at_,
+               projection_);
 }
 
 Query Query::AddingOrderBy(OrderBy order_by) const {
@@ -200,33 +281,41 @@ Query Query::AddingOrderBy(OrderBy order_by) const {
 
   return Query(path_, collection_group_, filters_,
                explicit_order_bys_.push_back(std::move(order_by)), limit_,
-               limit_type_, start_at_, end_at_);
+               limit_type_, start_at_, end_at_, projection_);
 }
 
 Query Query::WithLimitToFirst(int32_t limit) const {
   return Query(path_, collection_group_, filters_, explicit_order_bys_, limit,
-               LimitType::First, start_at_, end_at_);
+               LimitType::First, start_at_, end_at_, projection_);
 }
 
 Query Query::WithLimitToLast(int32_t limit) const {
   return Query(path_, collection_group_, filters_, explicit_order_bys_, limit,
-               LimitType::Last, start_at_, end_at_);
+               LimitType::Last, start_at_, end_at_, projection_);
 }
 
 Query Query::StartingAt(Bound bound) const {
   return Query(path_, collection_group_, filters_, explicit_order_bys_, limit_,
-               limit_type_, std::make_shared<Bound>(std::move(bound)), end_at_);
+               limit_type_, std::make_shared<Bound>(std::move(bound)), end_at_,
+               projection_);
 }
 
 Query Query::EndingAt(Bound bound) const {
   return Query(path_, collection_group_, filters_, explicit_order_bys_, limit_,
                limit_type_, start_at_,
-               std::make_shared<Bound>(std::move(bound)));
+               std::make_shared<Bound>(std::move(bound)), projection_);
+}
+
+Query Query::WithProjection(FieldMask projection) const {
+  return Query(path_, collection_group_, filters_, explicit_order_bys_, limit_,
+               limit_type_, start_at_, end_at_,
+               std::make_shared<const FieldMask>(std::move(projection)));
 }
 
 Query Query::AsCollectionQueryAtPath(ResourcePath path) const {
   return Query(path, /*collection_group=*/nullptr, filters_,
-               explicit_order_bys_, limit_, limit_type_, start_at_, end_at_);
+               explicit_order_bys_, limit_, limit_type_, start_at_, end_at_,
+               projection_);
 }
 
 // MARK: - Matching
@@ -236,6 +325,14 @@ bool Query::Matches(const Document& doc) const {
          MatchesFilters(doc) && MatchesBounds(doc);
 }
 
+Document Query::Project(const Document& doc) const {
+  if (!projection_) {
+    return doc;
+  }
+  return Document(doc.data().Project(ReadMask()), doc.key(), doc.version(),
+                  doc.document_state());
+}
+
 bool Query::MatchesPathAndCollectionGroup(const Document& doc) const {
   const ResourcePath& doc_path = doc.key().path();
   if (collection_group_) {
@@ -253,10 +350,7 @@ bool Query::MatchesPathAndCollectionGroup(const Document& doc) const {
 }
 
 bool Query::MatchesFilters(const Document& doc) const {
-  for (const auto& filter : filters_) {
-    if (!filter.Matches(doc)) return false;
-  }
-  return true;
+  return !filter_program_ || filter_program_->Matches(doc);
 }
 
 bool Query::MatchesOrderBy(const Document& doc) const {
@@ -282,12 +376,130 @@ bool Query::MatchesBounds(const Document& doc) const {
   return true;
 }
 
+namespace {
+
+/**
+ * Labels written before each part of a sort key. Value labels are ordered
+ * like the value types they stand for.
+ */
+enum class SortKeyLabel {
+  /**
+   * Ends a document key. Sorts before KeySegment so that keys sort before the
+   * keys they are a prefix of.
+   */
+  KeyEnd = 0,
+  KeySegment = 1,
+  Null = 2,
+  Boolean = 3,
+  NaN = 4,
+  Number = 5,
+  Timestamp = 6,
+  String = 7,
+};
+
+// Integers of larger magnitude don't all convert to doubles exactly.
+constexpr int64_t kMaxSafeInteger = int64_t{1} << 53;
+
+constexpr uint64_t kSignBit = uint64_t{1} << 63;
+
+void WriteSortKeyLabel(std::string* dest, SortKeyLabel label) {
+  OrderedCode::WriteNumIncreasing(dest, static_cast<uint64_t>(label));
+}
+
+void WriteSortKeyDouble(std::string* dest, double value) {
+  // NaN sorts before all other numbers.
+  if (std::isnan(value)) {
+    WriteSortKeyLabel(dest, SortKeyLabel::NaN);
+    return;
+  }
+
+  // -0.0 and 0.0 compare equal.
+  if (value == 0.0) {
+    value = 0.0;
+  }
+
+  // Flip the bits so that they compare like the doubles as unsigned integers.
+  uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  bits = (bits & kSignBit) ? ~bits : bits | kSignBit;
+
+  WriteSortKeyLabel(dest, SortKeyLabel::Number);
+  OrderedCode::WriteNumIncreasing(dest, bits);
+}
+
+/**
+ * Appends an encoding of the value that sorts like `FieldValue::CompareTo`.
+ * Returns false for values whose order the encoding doesn't capture.
+ */
+bool WriteSortKeyValue(std::string* dest, const FieldValue& value) {
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      WriteSortKeyLabel(dest, SortKeyLabel::Null);
+      return true;
+
+    case FieldValue::Type::Boolean:
+      WriteSortKeyLabel(dest, SortKeyLabel::Boolean);
+      OrderedCode::WriteNumIncreasing(dest, value.boolean_value() ? 1 : 0);
+      return true;
+
+    case FieldValue::Type::Integer: {
+      int64_t integer = value.integer_value();
+      if (integer > kMaxSafeInteger || integer < -kMaxSafeInteger) {
+        return false;
+      }
+      WriteSortKeyDouble(dest, static_cast<double>(integer));
+      return true;
+    }
+
+    case FieldValue::Type::Double:
+      WriteSortKeyDouble(dest, value.double_value());
+      return true;
+
+    case FieldValue::Type::Timestamp: {
+      Timestamp timestamp = value.timestamp_value();
+      WriteSortKeyLabel(dest, SortKeyLabel::Timestamp);
+      OrderedCode::WriteSignedNumIncreasing(dest, timestamp.seconds());
+      OrderedCode::WriteSignedNumIncreasing(dest, timestamp.nanoseconds());
+      return true;
+    }
+
+    case FieldValue::Type::String:
+      WriteSortKeyLabel(dest, SortKeyLabel::String);
+      OrderedCode::WriteString(dest, value.string_value());
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void WriteSortKeyDocumentKey(std::string* dest, const DocumentKey& key) {
+  for (const std::string& segment : key.path()) {
+    WriteSortKeyLabel(dest, SortKeyLabel::KeySegment);
+    OrderedCode::WriteString(dest, segment);
+  }
+  WriteSortKeyLabel(dest, SortKeyLabel::KeyEnd);
+}
+
+}  // namespace
+
 model::DocumentComparator Query::Comparator() const {
-  OrderByList ordering = order_bys();
+  // Comparators run for every comparison while sorting a view, so work out
+  // which components order by key up front instead of comparing field paths
+  // each time.
+  struct Component {
+    FieldPath field;
+    bool by_key;
+    Direction direction;
+  };
+  std::vector<Component> components;
 
   bool has_key_ordering = false;
-  for (const OrderBy& order_by : ordering) {
-    if (order_by.field() == FieldPath::KeyFieldPath()) {
+  for (const OrderBy& order_by : order_bys()) {
+    bool by_key = order_by.field() == FieldPath::KeyFieldPath();
+    components.push_back({order_by.field(), by_key, order_by.direction()});
+    if (by_key) {
+      // Keys are unique, so later components can never break a tie.
       has_key_ordering = true;
       break;
     }
@@ -295,26 +507,81 @@ model::DocumentComparator Query::Comparator() const {
   HARD_ASSERT(has_key_ordering,
               "QueryComparator needs to have a key ordering.");
 
-  return DocumentComparator(
-      [ordering](const Document& doc1, const Document& doc2) {
-        for (const OrderBy& order_by : ordering) {
-          ComparisonResult comp = order_by.Compare(doc1, doc2);
+  DocumentComparator::ComparisonFunction compare =
+      [components](const Document& doc1, const Document& doc2) {
+        for (const Component& component : components) {
+          ComparisonResult comp;
+          if (component.by_key) {
+            comp = doc1.key().CompareTo(doc2.key());
+          } else {
+            // Compare the values in place rather than copying them out.
+            const FieldValue* value1 = doc1.data().Find(component.field);
+            const FieldValue* value2 = doc2.data().Find(component.field);
+            HARD_ASSERT(
+                value1 && value2,
+                "Trying to compare documents on fields that don't exist.");
+            comp = value1->CompareTo(*value2);
+          }
+
+          comp = component.direction.ApplyTo(comp);
           if (!util::Same(comp)) return comp;
         }
         return ComparisonResult::Same;
-      });
+      };
+
+  // Every component's encoding is self-delimiting, so inverting the bytes of
+  // a descending component reverses its order without affecting the others.
+  DocumentComparator::SortKeyFunction sort_key =
+      [components](const Document& doc) -> absl::optional<std::string> {
+    std::string result;
+    for (const Component& component : components) {
+      size_t start = result.size();
+      if (component.by_key) {
+        WriteSortKeyDocumentKey(&result, doc.key());
+      } else {
+        const FieldValue* value = doc.data().Find(component.field);
+        if (!value || !WriteSortKeyValue(&result, *value)) {
+          return absl::nullopt;
+        }
+      }
+
+      if (component.direction == Direction::Descending) {
+        for (size_t i = start; i < result.size(); ++i) {
+          result[i] = static_cast<char>(~result[i]);
+        }
+      }
+    }
+    return result;
+  };
+
+  // Queries without explicit orderings end up with a single key component.
+  bool orders_by_key = components.size() == 1;
+  return DocumentComparator(std::move(compare), std::move(sort_key),
+                            orders_by_key);
 }
 
 const std::string Query::CanonicalId() const {
+  std::string result = ToTarget().CanonicalId();
   if (limit_type_ != LimitType::None) {
-    return absl::StrCat(ToTarget().CanonicalId(),
-                        "|lt:", (limit_type_ == LimitType::Last) ? "l" : "f");
+    absl::StrAppend(&result,
+                    "|lt:", (limit_type_ == LimitType::Last) ? "l" : "f");
+  }
+  if (projection_) {
+    absl::StrAppend(&result, "|p:");
+    for (const FieldPath& field : *projection_) {
+      absl::StrAppend(&result, field.CanonicalString(), ",");
+    }
   }
-  return ToTarget().CanonicalId();
+  return result;
 }
 
 size_t Query::Hash() const {
-  return util::Hash(CanonicalId());
+  if (memoized_hash_ == 0) {
+    memoized_hash_ =
+        util::Hash(ToTarget().Hash(), static_cast<int>(limit_type_),
+                   projection_ ? projection_->Hash() : 0);
+  }
+  return memoized_hash_;
 }
 
 std::string Query::ToString() const {
@@ -361,8 +628,13 @@ std::ostream& operator<<(std::ostream& os, const Query& query) {
 }
 
 bool operator==(const Query& lhs, const Query& rhs) {
+  // Copies of a query made after its Target was memoized share the Target, so
+  // the structural comparison can be skipped for them.
+  bool same_target =
+      lhs.memoized_target && lhs.memoized_target == rhs.memoized_target;
   return (lhs.limit_type_ == rhs.limit_type_) &&
-         (lhs.ToTarget() == rhs.ToTarget());
+         util::Equals(lhs.projection_, rhs.projection_) &&
+         (same_target || lhs.ToTarget() == rhs.ToTarget());
 }
 
 }  // namespace core
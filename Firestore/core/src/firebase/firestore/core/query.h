@@ -28,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/core/order_by.h"
 #include "Firestore/core/src/firebase/firestore/core/target.h"
 #include "Firestore/core/src/firebase/firestore/immutable/append_only_list.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
@@ -36,6 +37,7 @@ namespace firestore {
 namespace core {
 
 class Bound;
+class FilterProgram;
 
 using CollectionGroupId = std::shared_ptr<const std::string>;
 
@@ -67,16 +69,8 @@ class Query {
         int32_t limit,
         LimitType limit_type,
         std::shared_ptr<Bound> start_at,
-        std::shared_ptr<Bound> end_at)
-      : path_(std::move(path)),
-        collection_group_(std::move(collection_group)),
-        filters_(std::move(filters)),
-        explicit_order_bys_(std::move(explicit_order_bys)),
-        limit_(limit),
-        limit_type_(limit_type),
-        start_at_(std::move(start_at)),
-        end_at_(std::move(end_at)) {
-  }
+        std::shared_ptr<Bound> end_at,
+        std::shared_ptr<const model::FieldMask> projection = nullptr);
 
   Query(model::ResourcePath path, std::string collection_group);
 
@@ -151,6 +145,26 @@ class Query {
   /** Returns the first field in an order-by constraint, or nullptr if none. */
   const model::FieldPath* FirstOrderByField() const;
 
+  /**
+   * Returns true if the results are ordered by document key alone, in
+   * ascending order, so that a scan in key order yields them in query order.
+   */
+  bool IsKeyOrdered() const;
+
+  /**
+   * If the query is key-ordered and has a start bound, returns the key of the
+   * bound: no document with a smaller key matches the query. Otherwise returns
+   * nullopt.
+   */
+  absl::optional<model::DocumentKey> StartKey() const;
+
+  /**
+   * If the query is key-ordered and has an end bound, returns the key of the
+   * bound: no document with a larger key matches the query. Otherwise returns
+   * nullopt.
+   */
+  absl::optional<model::DocumentKey> EndKey() const;
+
   bool has_limit_to_first() const {
     return limit_type_ == LimitType::First && limit_ != Target::kNoLimit;
   }
@@ -171,6 +185,31 @@ class Query {
     return end_at_;
   }
 
+  /**
+   * The fields requested by the user, or nullptr if the query returns whole
+   * documents.
+   *
+   * Projections are applied locally only: the backend is still asked for
+   * whole documents, so queries that differ only in their projection share a
+   * Target.
+   */
+  const std::shared_ptr<const model::FieldMask>& projection() const {
+    return projection_;
+  }
+
+  bool has_projection() const {
+    return projection_ != nullptr;
+  }
+
+  /**
+   * Returns the fields that must be read from each document to return and
+   * order the results of this query: the projected fields plus the fields of
+   * all filters and orderings (other than the document key).
+   *
+   * Only meaningful if the query has a projection.
+   */
+  const model::FieldMask& ReadMask() const;
+
   // MARK: - Builder methods
 
   /**
@@ -216,6 +255,13 @@ class Query {
    */
   Query EndingAt(Bound bound) const;
 
+  /**
+   * Returns a copy of this Query that only returns the given fields of each
+   * document, along with any fields needed to evaluate its filters and
+   * orderings.
+   */
+  Query WithProjection(model::FieldMask projection) const;
+
   // MARK: - Matching
 
   /**
@@ -229,6 +275,12 @@ class Query {
   /** Returns true if the document matches the constraints of this query. */
   bool Matches(const model::Document& doc) const;
 
+  /**
+   * Returns the given document reduced to the fields in `ReadMask()`, or the
+   * document unchanged if this query has no projection.
+   */
+  model::Document Project(const model::Document& doc) const;
+
   /**
    * Returns a comparator that will sort documents according to the order by
    * clauses in this query.
@@ -248,6 +300,11 @@ class Query {
   friend std::ostream& operator<<(std::ostream& os, const Query& query);
 
   friend bool operator==(const Query& lhs, const Query& rhs);
+
+  /**
+   * Returns a hash of the query, combining the memoized hash of its Target
+   * with the constraints applied locally. Computed once per query.
+   */
   size_t Hash() const;
 
  private:
@@ -265,6 +322,11 @@ class Query {
   // immutable.) Filters are not shared across unrelated Query instances.
   FilterList filters_;
 
+  // The filters compiled for matching documents, or null if there are none.
+  // Built up front rather than memoized, since the same query is matched
+  // against documents on several threads at once.
+  std::shared_ptr<const FilterProgram> filter_program_;
+
   // A list of fields given to sort by. This does not include the implicit key
   // sort at the end.
   OrderByList explicit_order_bys_;
@@ -278,8 +340,16 @@ class Query {
   std::shared_ptr<Bound> start_at_;
   std::shared_ptr<Bound> end_at_;
 
+  std::shared_ptr<const model::FieldMask> projection_;
+
+  // The memoized set of fields to read for a projected query.
+  mutable std::shared_ptr<const model::FieldMask> memoized_read_mask_;
+
   // The corresponding Target of this Query instance.
   mutable std::shared_ptr<const Target> memoized_target;
+
+  // The memoized hash, or zero if it hasn't been computed yet.
+  mutable size_t memoized_hash_ = 0;
 };
 
 bool operator==(const Query& lhs, const Query& rhs);
@@ -17,7 +17,6 @@
 #include "Firestore/core/src/firebase/firestore/core/query_listener.h"
 
 #include <utility>
-#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -70,26 +69,12 @@ QueryListener::QueryListener(Query query,
 
 bool QueryListener::OnViewSnapshot(ViewSnapshot snapshot) {
   HARD_ASSERT(
-      !snapshot.document_changes().empty() || snapshot.sync_state_changed(),
+      snapshot.document_change_count() != 0 || snapshot.sync_state_changed(),
       "We got a new snapshot with no changes?");
   bool raised_event = false;
-  if (!options_.include_document_metadata_changes()) {
-    // Remove the metadata-only changes.
-    std::vector<DocumentViewChange> changes;
-    for (const DocumentViewChange& change : snapshot.document_changes()) {
-      if (change.type() != DocumentViewChange::Type::Metadata) {
-        changes.push_back(change);
-      }
-    }
-
-    snapshot = ViewSnapshot{snapshot.query(),
-                            snapshot.documents(),
-                            snapshot.old_documents(),
-                            std::move(changes),
-                            snapshot.mutated_keys(),
-                            snapshot.from_cache(),
-                            snapshot.sync_state_changed(),
-                            /*excludes_metadata_changes=*/true};
+  if (!options_.include_document_metadata_changes() &&
+      !snapshot.excludes_metadata_changes()) {
+    snapshot = snapshot.ExcludingMetadataChanges();
   }
 
   if (!raised_initial_event_) {
@@ -155,7 +140,7 @@ bool QueryListener::ShouldRaiseEvent(const ViewSnapshot& snapshot) const {
   // We don't need to handle include_document_metadata_changes() here because
   // the Metadata only changes have already been stripped out if needed. At this
   // point the only changes we will see are the ones we should propagate.
-  if (!snapshot.document_changes().empty()) {
+  if (snapshot.document_change_count() != 0) {
     return true;
   }
 
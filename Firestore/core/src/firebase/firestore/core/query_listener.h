@@ -63,6 +63,15 @@ class QueryListener {
     return query_;
   }
 
+  const ListenOptions& options() const {
+    return options_;
+  }
+
+  /** Whether the listener has raised its first snapshot. */
+  bool raised_initial_event() const {
+    return raised_initial_event_;
+  }
+
   /** The last received view snapshot. */
   const absl::optional<ViewSnapshot>& snapshot() const {
     return snapshot_;
@@ -73,6 +82,9 @@ class QueryListener {
    * if applicable (depending on what changed, whether the user has opted into
    * metadata-only changes, etc.). Returns true if a user-facing event was
    * indeed raised.
+   *
+   * Snapshots that already exclude metadata changes are used as is, so callers
+   * can filter a snapshot once and share it between listeners.
    */
   virtual bool OnViewSnapshot(ViewSnapshot snapshot);
 
@@ -16,7 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/core/sync_engine.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
+#include "Firestore/core/src/firebase/firestore/core/order_by.h"
 #include "Firestore/core/src/firebase/firestore/core/sync_engine_callback.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/core/transaction_runner.h"
@@ -30,11 +37,18 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch_result.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/background_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/equality.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -51,9 +65,11 @@ using local::QueryPurpose;
 using local::QueryResult;
 using local::TargetData;
 using model::BatchId;
+using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
+using model::FieldPath;
 using model::kBatchIdUnknown;
 using model::ListenSequenceNumber;
 using model::MaybeDocumentMap;
@@ -63,6 +79,8 @@ using model::TargetId;
 using remote::RemoteEvent;
 using remote::TargetChange;
 using util::AsyncQueue;
+using util::BackgroundQueue;
+using util::Executor;
 using util::Status;
 using util::StatusCallback;
 
@@ -70,6 +88,66 @@ using util::StatusCallback;
 // them don't need real sequence numbers.
 const ListenSequenceNumber kIrrelevantSequenceNumber = -1;
 
+// The most documents `ListenAll` packs into a single target.
+const size_t kMaxDocumentsPerTarget = 100;
+
+/**
+ * Returns true if every result of `subset` is provably a result of `superset`:
+ * they're on the same collection, `superset` has no limit or bounds, `subset`
+ * only adds filters to those of `superset`, and `superset` only orders by
+ * fields its filters already require.
+ */
+bool Contains(const Query& superset, const Query& subset) {
+  if (superset.path() != subset.path() ||
+      !util::Equals(superset.collection_group(), subset.collection_group())) {
+    return false;
+  }
+  if (superset.has_limit_to_first() || superset.has_limit_to_last() ||
+      superset.start_at() || superset.end_at()) {
+    return false;
+  }
+  for (const Filter& filter : superset.filters()) {
+    if (std::find(subset.filters().begin(), subset.filters().end(), filter) ==
+        subset.filters().end()) {
+      return false;
+    }
+  }
+  // Ordering by a field excludes the documents that lack it, which `subset`
+  // may still match, unless a filter of `superset` already excludes them.
+  for (const OrderBy& order_by : superset.explicit_order_bys()) {
+    const FieldPath& field = order_by.field();
+    if (field.IsKeyFieldPath()) {
+      continue;
+    }
+    auto filters_field = [&](const Filter& filter) {
+      return filter.field() == field;
+    };
+    if (std::none_of(superset.filters().begin(), superset.filters().end(),
+                     filters_field)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+using Clock = std::chrono::steady_clock;
+
+TargetCost::Duration ElapsedSince(Clock::time_point start) {
+  return std::chrono::duration_cast<TargetCost::Duration>(Clock::now() -
+                                                          start);
+}
+
+/** Returns the change to the document with the given key, if any. */
+MaybeDocumentMap ChangesToDocument(const MaybeDocumentMap& changes,
+                                   const DocumentKey& key) {
+  MaybeDocumentMap document_changes;
+  auto found = changes.find(key);
+  if (found != changes.end()) {
+    document_changes = document_changes.insert(key, found->second);
+  }
+  return document_changes;
+}
+
 bool ErrorIsInteresting(const Status& error) {
   bool missing_index =
       (error.code() == Error::kFailedPrecondition &&
@@ -87,8 +165,18 @@ SyncEngine::SyncEngine(LocalStore* local_store,
       remote_store_(remote_store),
       current_user_(initial_user),
       target_id_generator_(TargetIdGenerator::SyncEngineTargetIdGenerator()) {
+  auto hw_concurrency = std::thread::hardware_concurrency();
+  if (hw_concurrency == 0) {
+    // If the standard library doesn't know, guess something reasonable.
+    hw_concurrency = 4;
+  }
+  view_executor_ = Executor::CreateConcurrent(
+      "com.google.firebase.firestore.views", static_cast<int>(hw_concurrency));
 }
 
+// Out of line because of the unique_ptr to an incomplete type.
+SyncEngine::~SyncEngine() = default;
+
 void SyncEngine::AssertCallbackExists(absl::string_view source) {
   HARD_ASSERT(sync_engine_callback_,
               "Tried to call '%s' before callback was registered.", source);
@@ -96,11 +184,19 @@ void SyncEngine::AssertCallbackExists(absl::string_view source) {
 
 TargetId SyncEngine::Listen(Query query) {
   AssertCallbackExists("Listen");
+  util::TraceSpan span("SyncEngine::Listen");
 
   HARD_ASSERT(query_views_by_query_.find(query) == query_views_by_query_.end(),
               "We already listen to query: %s", query.ToString());
 
+  std::shared_ptr<QueryView> containing_view = FindContainingQueryView(query);
+  if (containing_view) {
+    return ListenWithinQueryView(query, *containing_view);
+  }
+
   TargetData target_data = local_store_->AllocateTarget(query.ToTarget());
+  util::Trace(util::TraceEvent::kListen, target_data.target_id());
+  span.SetAttribute("target_id", target_data.target_id());
   ViewSnapshot view_snapshot =
       InitializeViewAndComputeSnapshot(query, target_data.target_id());
   std::vector<ViewSnapshot> snapshots;
@@ -113,11 +209,179 @@ TargetId SyncEngine::Listen(Query query) {
   return target_data.target_id();
 }
 
+std::shared_ptr<SyncEngine::QueryView> SyncEngine::FindContainingQueryView(
+    const Query& query) {
+  if (!contained_queries_served_locally_) {
+    return nullptr;
+  }
+
+  for (const auto& entry : query_views_by_query_) {
+    const std::shared_ptr<QueryView>& query_view = entry.second;
+    // A synced view is current and has no documents in limbo, so it has all
+    // of the documents of the contained query in the cache.
+    if (contained_queries_.count(entry.first) == 0 &&
+        query_view->view().sync_state() == SyncState::Synced &&
+        Contains(entry.first, query)) {
+      return query_view;
+    }
+  }
+  return nullptr;
+}
+
+TargetId SyncEngine::ListenWithinQueryView(const Query& query,
+                                           QueryView& containing_view) {
+  TargetId target_id = containing_view.target_id();
+  contained_queries_.insert(query);
+
+  TargetCost cost;
+  QueryResult query_result =
+      ExecuteQuery(query, /* use_previous_results= */ true, &cost);
+  View view(query, containing_view.view().synced_documents());
+  auto start = Clock::now();
+  ViewDocumentChanges view_doc_changes =
+      view.ComputeDocumentChanges(query_result.documents().underlying_map());
+  cost.view_time += ElapsedSince(start);
+  ViewSnapshot view_snapshot = InitializeView(
+      query, target_id, std::move(view), view_doc_changes, std::move(cost));
+
+  std::vector<ViewSnapshot> snapshots;
+  snapshots.push_back(std::move(view_snapshot));
+  sync_engine_callback_->OnViewSnapshots(std::move(snapshots));
+  return target_id;
+}
+
+std::vector<TargetId> SyncEngine::ListenAll(const std::vector<Query>& queries) {
+  AssertCallbackExists("ListenAll");
+  util::TraceSpan span("SyncEngine::ListenAll");
+  span.SetAttribute("queries", static_cast<int64_t>(queries.size()));
+
+  std::vector<size_t> document_queries;
+  for (size_t i = 0; i < queries.size(); ++i) {
+    HARD_ASSERT(
+        query_views_by_query_.find(queries[i]) == query_views_by_query_.end(),
+        "We already listen to query: %s", queries[i].ToString());
+    if (queries[i].IsDocumentQuery()) {
+      document_queries.push_back(i);
+    }
+  }
+  std::sort(document_queries.begin(), document_queries.end(),
+            [&](size_t lhs, size_t rhs) {
+              return queries[lhs].path() < queries[rhs].path();
+            });
+
+  // Pack the document queries into multi-document targets, so that watching
+  // many documents doesn't cost the backend a target per document. Each other
+  // query, and a document left alone at the end, gets a target of its own.
+  std::vector<Target> targets;
+  std::vector<size_t> target_indexes(queries.size());
+  std::vector<bool> grouped(queries.size(), false);
+  for (size_t begin = 0; begin < document_queries.size();
+       begin += kMaxDocumentsPerTarget) {
+    size_t end =
+        std::min(begin + kMaxDocumentsPerTarget, document_queries.size());
+    if (end - begin < 2) {
+      break;
+    }
+
+    std::vector<DocumentKey> keys;
+    keys.reserve(end - begin);
+    for (size_t j = begin; j < end; ++j) {
+      size_t i = document_queries[j];
+      keys.emplace_back(queries[i].path());
+      target_indexes[i] = targets.size();
+      grouped[i] = true;
+    }
+    targets.push_back(Target::ForDocuments(std::move(keys)));
+  }
+  size_t group_count = targets.size();
+  for (size_t i = 0; i < queries.size(); ++i) {
+    if (!grouped[i]) {
+      target_indexes[i] = targets.size();
+      targets.push_back(queries[i].ToTarget());
+    }
+  }
+
+  std::vector<TargetData> target_data =
+      local_store_->AllocateTargets(std::move(targets));
+
+  // The documents of a group share its remote keys, so that each view accepts
+  // the changes the group's target reports for the other documents.
+  std::vector<DocumentKeySet> group_remote_keys;
+  group_remote_keys.reserve(group_count);
+  for (size_t t = 0; t < group_count; ++t) {
+    TargetId target_id = target_data[t].target_id();
+    document_group_targets_.insert(target_id);
+    group_remote_keys.push_back(local_store_->GetRemoteDocumentKeys(target_id));
+  }
+
+  // The local queries run one after another, since the local store belongs to
+  // the worker queue, but the views compute their initial changes in
+  // parallel.
+  std::vector<View> views;
+  std::vector<QueryResult> query_results;
+  std::vector<TargetCost> costs(queries.size());
+  views.reserve(queries.size());
+  query_results.reserve(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    query_results.push_back(ExecuteQuery(
+        queries[i], /* use_previous_results= */ true, &costs[i]));
+    if (grouped[i]) {
+      views.emplace_back(queries[i], group_remote_keys[target_indexes[i]]);
+    } else {
+      views.emplace_back(queries[i], query_results.back().remote_keys());
+    }
+  }
+
+  std::vector<ViewDocumentChanges> view_doc_changes =
+      ComputeInParallel(queries.size(), [&](size_t i) {
+        auto start = Clock::now();
+        ViewDocumentChanges changes = views[i].ComputeDocumentChanges(
+            query_results[i].documents().underlying_map());
+        costs[i].view_time += ElapsedSince(start);
+        return changes;
+      });
+
+  std::vector<ViewSnapshot> snapshots;
+  std::vector<TargetId> target_ids;
+  snapshots.reserve(queries.size());
+  target_ids.reserve(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    TargetId target_id = target_data[target_indexes[i]].target_id();
+    snapshots.push_back(InitializeView(queries[i], target_id,
+                                       std::move(views[i]),
+                                       view_doc_changes[i],
+                                       std::move(costs[i])));
+    target_ids.push_back(target_id);
+  }
+  sync_engine_callback_->OnViewSnapshots(std::move(snapshots));
+
+  for (const TargetData& data : target_data) {
+    remote_store_->Listen(data);
+  }
+  return target_ids;
+}
+
 ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(const Query& query,
                                                           TargetId target_id) {
+  TargetCost cost;
   QueryResult query_result =
-      local_store_->ExecuteQuery(query, /* use_previous_results= */ true);
+      ExecuteQuery(query, /* use_previous_results= */ true, &cost);
+
+  View view(query, query_result.remote_keys());
+  auto start = Clock::now();
+  ViewDocumentChanges view_doc_changes =
+      view.ComputeDocumentChanges(query_result.documents().underlying_map());
+  cost.view_time += ElapsedSince(start);
+  return InitializeView(query, target_id, std::move(view), view_doc_changes,
+                        std::move(cost));
+}
 
+ViewSnapshot SyncEngine::InitializeView(
+    const Query& query,
+    TargetId target_id,
+    View view,
+    const ViewDocumentChanges& view_doc_changes,
+    TargetCost cost) {
   // If there are already queries mapped to the target id, create a synthesized
   // target change to apply the sync state from those queries to the new query.
   auto current_sync_state = SyncState::None;
@@ -130,16 +394,15 @@ ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(const Query& query,
         current_sync_state == SyncState::Synced);
   }
 
-  View view(query, query_result.remote_keys());
-  ViewDocumentChanges view_doc_changes =
-      view.ComputeDocumentChanges(query_result.documents().underlying_map());
+  auto start = Clock::now();
   ViewChange view_change =
       view.ApplyChanges(view_doc_changes, synthesized_current_change);
+  cost.snapshot_time += ElapsedSince(start);
   HARD_ASSERT(view_change.limbo_changes().empty(),
               "View returned limbo docs before target ack from the server.");
 
-  auto query_view =
-      std::make_shared<QueryView>(query, target_id, std::move(view));
+  auto query_view = std::make_shared<QueryView>(
+      query, target_id, std::move(view), std::move(cost));
   query_views_by_query_[query] = query_view;
 
   queries_by_target_[target_id].push_back(query);
@@ -150,6 +413,60 @@ ViewSnapshot SyncEngine::InitializeViewAndComputeSnapshot(const Query& query,
   return view_change.snapshot().value();
 }
 
+QueryResult SyncEngine::ExecuteQuery(const Query& query,
+                                     bool use_previous_results,
+                                     TargetCost* cost) {
+  auto start = Clock::now();
+  QueryResult result = local_store_->ExecuteQuery(query, use_previous_results);
+  cost->query_time += ElapsedSince(start);
+  cost->queries_executed++;
+  cost->documents_scanned += result.documents_scanned();
+  return result;
+}
+
+std::vector<TargetCost> SyncEngine::GetTargetCosts(size_t count,
+                                                   TargetCostOrder order) {
+  std::vector<TargetCost> costs;
+  costs.reserve(query_views_by_query_.size());
+  for (const auto& entry : query_views_by_query_) {
+    QueryView& query_view = *entry.second;
+    TargetCost cost = query_view.cost();
+    for (const model::DocumentSet* documents :
+         {&query_view.view().documents(),
+          &query_view.view().overflow_documents()}) {
+      cost.documents_retained += static_cast<int64_t>(documents->size());
+      for (const Document& document : *documents) {
+        cost.bytes_retained += EstimateByteSize(document);
+      }
+    }
+    costs.push_back(std::move(cost));
+  }
+  return TopTargetCosts(std::move(costs), count, order);
+}
+
+std::vector<ViewDocumentChanges> SyncEngine::ComputeInParallel(
+    size_t count, const std::function<ViewDocumentChanges(size_t)>& compute) {
+  std::vector<absl::optional<ViewDocumentChanges>> results(count);
+  if (count == 1) {
+    results[0] = compute(0);
+  } else {
+    // Each task writes only its own slot, and AwaitAll orders those writes
+    // before the reads below.
+    BackgroundQueue tasks(view_executor_.get());
+    for (size_t i = 0; i < count; ++i) {
+      tasks.Execute([&results, &compute, i] { results[i] = compute(i); });
+    }
+    tasks.AwaitAll();
+  }
+
+  std::vector<ViewDocumentChanges> changes;
+  changes.reserve(count);
+  for (absl::optional<ViewDocumentChanges>& result : results) {
+    changes.push_back(std::move(result).value());
+  }
+  return changes;
+}
+
 void SyncEngine::StopListening(const Query& query) {
   AssertCallbackExists("StopListening");
 
@@ -157,21 +474,46 @@ void SyncEngine::StopListening(const Query& query) {
   HARD_ASSERT(query_view, "Trying to stop listening to a query not found");
 
   query_views_by_query_.erase(query);
+  contained_queries_.erase(query);
 
   TargetId target_id = query_view->target_id();
   auto& queries = queries_by_target_[target_id];
   queries.erase(std::remove(queries.begin(), queries.end(), query));
 
   if (queries.empty()) {
+    util::Trace(util::TraceEvent::kStopListening, target_id);
     local_store_->ReleaseTarget(target_id);
     remote_store_->StopListening(target_id);
     RemoveAndCleanupTarget(target_id, Status::OK());
   }
 }
 
+bool SyncEngine::DropDocuments(const Query& query) {
+  auto found = query_views_by_query_.find(query);
+  if (found == query_views_by_query_.end()) {
+    return false;
+  }
+
+  found->second->view().DropDocuments();
+  return true;
+}
+
+absl::optional<ViewSnapshot> SyncEngine::RestoreDocuments(const Query& query) {
+  auto found = query_views_by_query_.find(query);
+  if (found == query_views_by_query_.end()) {
+    return absl::nullopt;
+  }
+
+  QueryView& query_view = *found->second;
+  QueryResult query_result =
+      ExecuteQuery(query, /* use_previous_results= */ true, &query_view.cost());
+  return query_view.view().RestoreDocuments(query_result.documents());
+}
+
 void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
   for (const Query& query : queries_by_target_.at(target_id)) {
     query_views_by_query_.erase(query);
+    contained_queries_.erase(query);
     if (!status.ok()) {
       sync_engine_callback_->OnError(query, status);
       if (ErrorIsInteresting(status)) {
@@ -188,17 +530,37 @@ void SyncEngine::RemoveAndCleanupTarget(TargetId target_id, Status status) {
     if (!limbo_document_refs_.ContainsKey(key)) {
       // We removed the last reference for this key.
       RemoveLimboTarget(key);
+    } else {
+      UpdateEnqueuedLimboViews(key, -1);
     }
   }
+  PumpEnqueuedLimboResolutions();
 }
 
 void SyncEngine::WriteMutations(std::vector<model::Mutation>&& mutations,
                                 StatusCallback callback) {
   AssertCallbackExists("WriteMutations");
 
+  if (local_store_->IsMutationQueueFull()) {
+    callback(Status{Error::kResourceExhausted,
+                    "Too many writes are waiting to be sent to the backend. "
+                    "Wait for some of them to complete and try again."});
+    return;
+  }
+
   LocalWriteResult result = local_store_->WriteLocally(std::move(mutations));
-  mutation_callbacks_[current_user_].insert(
-      std::make_pair(result.batch_id(), std::move(callback)));
+  auto& callbacks = mutation_callbacks_[current_user_];
+  auto existing = callbacks.find(result.batch_id());
+  if (existing == callbacks.end()) {
+    callbacks.insert(std::make_pair(result.batch_id(), std::move(callback)));
+  } else {
+    // The write was compacted into a pending batch, so it completes with it.
+    StatusCallback earlier = std::move(existing->second);
+    existing->second = [earlier, callback](Status status) {
+      earlier(status);
+      callback(std::move(status));
+    };
+  }
 
   EmitNewSnapshotsAndNotifyLocalStore(result.changes(), absl::nullopt);
   remote_store_->FillWritePipeline();
@@ -258,8 +620,20 @@ void SyncEngine::HandleCredentialChange(const auth::User& user) {
   remote_store_->HandleCredentialChange();
 }
 
+void SyncEngine::SetMaxConcurrentLimboResolutions(size_t max_concurrent) {
+  max_concurrent_limbo_resolutions_ = max_concurrent;
+  PumpEnqueuedLimboResolutions();
+}
+
 void SyncEngine::ApplyRemoteEvent(const RemoteEvent& remote_event) {
   AssertCallbackExists("HandleRemoteEvent");
+  util::Trace(util::TraceEvent::kRemoteEvent,
+              remote_event.target_changes().size(),
+              remote_event.document_updates().size());
+  util::TraceSpan span("SyncEngine::ApplyRemoteEvent");
+  span.SetAttribute("target_changes", remote_event.target_changes().size());
+  span.SetAttribute("document_updates",
+                    remote_event.document_updates().size());
 
   // Update received document as appropriate for any limbo targets.
   for (const auto& entry : remote_event.target_changes()) {
@@ -331,15 +705,50 @@ void SyncEngine::HandleRejectedListen(TargetId target_id, Status error) {
                       std::move(target_mismatches), std::move(document_updates),
                       std::move(limbo_documents)};
     ApplyRemoteEvent(event);
+  } else if (document_group_targets_.erase(target_id) > 0) {
+    // The backend refused to watch the documents together, so watch each of
+    // them on its own. Any document that really can't be listened to gets
+    // rejected again, with an error for its own query.
+    local_store_->ReleaseTarget(target_id);
+    ListenToDocumentsIndividually(target_id);
   } else {
     local_store_->ReleaseTarget(target_id);
     RemoveAndCleanupTarget(target_id, error);
   }
 }
 
+void SyncEngine::ListenToDocumentsIndividually(TargetId group_target_id) {
+  std::vector<Query> queries = queries_by_target_.at(group_target_id);
+  queries_by_target_.erase(group_target_id);
+
+  // Only a document query's own document can be in limbo in its view, so each
+  // limbo reference moves to the target of that document.
+  DocumentKeySet limbo_keys =
+      limbo_document_refs_.RemoveReferences(group_target_id);
+
+  for (const Query& query : queries) {
+    std::shared_ptr<QueryView>& query_view = query_views_by_query_.at(query);
+    TargetData target_data = local_store_->AllocateTarget(query.ToTarget());
+    TargetId target_id = target_data.target_id();
+
+    query_view = std::make_shared<QueryView>(
+        query, target_id, query_view->view(), query_view->cost());
+    queries_by_target_[target_id].push_back(query);
+
+    DocumentKey key{query.path()};
+    if (limbo_keys.contains(key)) {
+      limbo_document_refs_.AddReference(key, target_id);
+    }
+
+    remote_store_->Listen(target_data);
+  }
+}
+
 void SyncEngine::HandleSuccessfulWrite(
     const model::MutationBatchResult& batch_result) {
   AssertCallbackExists("HandleSuccessfulWrite");
+  util::TraceSpan span("SyncEngine::HandleSuccessfulWrite");
+  span.SetAttribute("batch_id", batch_result.batch().batch_id());
 
   // The local store may or may not be able to apply the write result and
   // raise events immediately (depending on whether the watcher is caught up),
@@ -459,18 +868,48 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
   std::vector<ViewSnapshot> new_snapshots;
   std::vector<LocalViewChanges> document_changes_in_all_views;
 
+  std::vector<std::shared_ptr<QueryView>> query_views;
+  query_views.reserve(query_views_by_query_.size());
   for (const auto& entry : query_views_by_query_) {
-    const auto& query_view = entry.second;
+    query_views.push_back(entry.second);
+  }
+
+  // Views are independent of each other, so they can compute their changes
+  // in parallel. Everything else runs in order on the worker queue. A view of
+  // a single document only needs the change to that document, if any, which
+  // keeps many document listens from each scanning all the changes.
+  util::SpanId parent_span = util::TraceSpan::Current();
+  std::vector<ViewDocumentChanges> all_view_doc_changes =
+      ComputeInParallel(query_views.size(), [&](size_t i) {
+        View& view = query_views[i]->view();
+        const Query& query = query_views[i]->query();
+        util::TraceSpan span("View::ComputeDocumentChanges", parent_span);
+        span.SetAttribute("target_id", query_views[i]->target_id());
+        auto start = Clock::now();
+        ViewDocumentChanges view_doc_changes =
+            query.IsDocumentQuery()
+                ? view.ComputeDocumentChanges(
+                      ChangesToDocument(changes, DocumentKey{query.path()}))
+                : view.ComputeDocumentChanges(changes);
+        query_views[i]->cost().view_time += ElapsedSince(start);
+        return view_doc_changes;
+      });
+
+  for (size_t i = 0; i < query_views.size(); ++i) {
+    const auto& query_view = query_views[i];
     View& view = query_view->view();
-    ViewDocumentChanges view_doc_changes = view.ComputeDocumentChanges(changes);
+    TargetCost& cost = query_view->cost();
+    ViewDocumentChanges& view_doc_changes = all_view_doc_changes[i];
     if (view_doc_changes.needs_refill()) {
       // The query has a limit and some docs were removed/updated, so we need to
       // re-run the query against the local store to make sure we didn't lose
       // any good docs that had been past the limit.
-      QueryResult query_result = local_store_->ExecuteQuery(
-          query_view->query(), /* use_previous_results= */ false);
+      QueryResult query_result = ExecuteQuery(
+          query_view->query(), /* use_previous_results= */ false, &cost);
+      auto start = Clock::now();
       view_doc_changes = view.ComputeDocumentChanges(
           query_result.documents().underlying_map(), view_doc_changes);
+      cost.view_time += ElapsedSince(start);
     }
 
     absl::optional<TargetChange> target_changes;
@@ -481,20 +920,30 @@ void SyncEngine::EmitNewSnapshotsAndNotifyLocalStore(
         target_changes = it->second;
       }
     }
+    auto start = Clock::now();
     ViewChange view_change =
         view.ApplyChanges(view_doc_changes, target_changes);
+    cost.snapshot_time += ElapsedSince(start);
 
     UpdateTrackedLimboDocuments(view_change.limbo_changes(),
                                 query_view->target_id());
 
     if (view_change.snapshot().has_value()) {
       new_snapshots.push_back(*view_change.snapshot());
-      LocalViewChanges doc_changes = LocalViewChanges::FromViewSnapshot(
-          *view_change.snapshot(), query_view->target_id());
-      document_changes_in_all_views.push_back(std::move(doc_changes));
+      // The documents of a contained query are all in the view it's served
+      // from, which already pins them and owns the target.
+      if (contained_queries_.count(query_view->query()) == 0) {
+        LocalViewChanges doc_changes = LocalViewChanges::FromViewSnapshot(
+            *view_change.snapshot(), query_view->target_id());
+        document_changes_in_all_views.push_back(std::move(doc_changes));
+      }
     }
   }
 
+  // Start the limbo resolutions only once all views have reported their
+  // limbo documents, so that the queue orders them by all their views.
+  PumpEnqueuedLimboResolutions();
+
   sync_engine_callback_->OnViewSnapshots(std::move(new_snapshots));
   local_store_->NotifyLocalViewChanges(document_changes_in_all_views);
 }
@@ -515,6 +964,8 @@ void SyncEngine::UpdateTrackedLimboDocuments(
         if (!limbo_document_refs_.ContainsKey(limbo_change.key())) {
           // We removed the last reference for this key
           RemoveLimboTarget(limbo_change.key());
+        } else {
+          UpdateEnqueuedLimboViews(limbo_change.key(), -1);
         }
         break;
 
@@ -527,21 +978,67 @@ void SyncEngine::UpdateTrackedLimboDocuments(
 void SyncEngine::TrackLimboChange(const LimboDocumentChange& limbo_change) {
   const DocumentKey& key = limbo_change.key();
 
-  if (limbo_targets_by_key_.find(key) == limbo_targets_by_key_.end()) {
-    LOG_DEBUG("New document in limbo: %s", key.ToString());
+  if (limbo_targets_by_key_.find(key) != limbo_targets_by_key_.end()) {
+    return;
+  }
 
-    TargetId limbo_target_id = target_id_generator_.NextId();
-    Query query(key.path());
-    TargetData target_data(query.ToTarget(), limbo_target_id,
-                           kIrrelevantSequenceNumber,
-                           QueryPurpose::LimboResolution);
-    limbo_resolutions_by_target_.emplace(limbo_target_id, LimboResolution{key});
-    remote_store_->Listen(target_data);
-    limbo_targets_by_key_[key] = limbo_target_id;
+  if (enqueued_limbo_positions_.find(key) != enqueued_limbo_positions_.end()) {
+    UpdateEnqueuedLimboViews(key, 1);
+    return;
   }
+
+  LOG_DEBUG("New document in limbo: %s", key.ToString());
+  LimboQueuePosition position;
+  position.views = 1;
+  position.order = next_limbo_queue_order_++;
+  enqueued_limbo_resolutions_.emplace(position, key);
+  enqueued_limbo_positions_.emplace(key, position);
+}
+
+void SyncEngine::UpdateEnqueuedLimboViews(const DocumentKey& key, int delta) {
+  auto found = enqueued_limbo_positions_.find(key);
+  if (found == enqueued_limbo_positions_.end()) {
+    return;
+  }
+
+  LimboQueuePosition& position = found->second;
+  enqueued_limbo_resolutions_.erase(position);
+  position.views += delta;
+  enqueued_limbo_resolutions_.emplace(position, key);
+}
+
+void SyncEngine::PumpEnqueuedLimboResolutions() {
+  while (!enqueued_limbo_resolutions_.empty() &&
+         (max_concurrent_limbo_resolutions_ == 0 ||
+          limbo_targets_by_key_.size() < max_concurrent_limbo_resolutions_)) {
+    auto next = enqueued_limbo_resolutions_.begin();
+    DocumentKey key = next->second;
+    enqueued_limbo_resolutions_.erase(next);
+    enqueued_limbo_positions_.erase(key);
+    StartLimboResolution(key);
+  }
+}
+
+void SyncEngine::StartLimboResolution(const DocumentKey& key) {
+  TargetId limbo_target_id = target_id_generator_.NextId();
+  Query query(key.path());
+  TargetData target_data(query.ToTarget(), limbo_target_id,
+                         kIrrelevantSequenceNumber,
+                         QueryPurpose::LimboResolution);
+  limbo_resolutions_by_target_.emplace(limbo_target_id, LimboResolution{key});
+  remote_store_->Listen(target_data);
+  limbo_targets_by_key_[key] = limbo_target_id;
 }
 
 void SyncEngine::RemoveLimboTarget(const DocumentKey& key) {
+  auto enqueued = enqueued_limbo_positions_.find(key);
+  if (enqueued != enqueued_limbo_positions_.end()) {
+    // The resolution never started.
+    enqueued_limbo_resolutions_.erase(enqueued->second);
+    enqueued_limbo_positions_.erase(enqueued);
+    return;
+  }
+
   auto it = limbo_targets_by_key_.find(key);
   if (it == limbo_targets_by_key_.end()) {
     // This target already got removed, because the query failed.
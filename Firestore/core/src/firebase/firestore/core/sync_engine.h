@@ -17,14 +17,18 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_SYNC_ENGINE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_SYNC_ENGINE_H_
 
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/core/target_cost.h"
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
 #include "Firestore/core/src/firebase/firestore/core/view.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
@@ -32,15 +36,21 @@
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
 
 namespace local {
 class LocalStore;
+class QueryResult;
 class TargetData;
 }  // namespace local
 
+namespace util {
+class Executor;
+}  // namespace util
+
 namespace core {
 
 class SyncEngineCallback;
@@ -68,8 +78,43 @@ class QueryEventSource {
    */
   virtual model::TargetId Listen(Query query) = 0;
 
+  /**
+   * Initiates listens for all the given queries at once. None of the queries
+   * may already be listened to.
+   *
+   * @return the target IDs assigned to the queries, in order.
+   */
+  virtual std::vector<model::TargetId> ListenAll(
+      const std::vector<Query>& queries) {
+    std::vector<model::TargetId> target_ids;
+    for (const Query& query : queries) {
+      target_ids.push_back(Listen(query));
+    }
+    return target_ids;
+  }
+
   /** Stops listening to a query previously listened to via `Listen`. */
   virtual void StopListening(const Query& query) = 0;
+
+  /**
+   * Stops keeping the full contents of the documents of a query that's
+   * listened to, because all of its listeners only read document changes from
+   * now on. Returns whether the documents were dropped.
+   */
+  virtual bool DropDocuments(const Query& query) {
+    (void)query;
+    return false;
+  }
+
+  /**
+   * Keeps the full contents of the documents of a query again after
+   * `DropDocuments`. Returns the snapshot that a new listener of the query
+   * should first see, if the documents were restored.
+   */
+  virtual absl::optional<ViewSnapshot> RestoreDocuments(const Query& query) {
+    (void)query;
+    return absl::nullopt;
+  }
 };
 
 /**
@@ -92,13 +137,28 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
              remote::RemoteStore* remote_store,
              const auth::User& initial_user);
 
+  ~SyncEngine();
+
   // Implements `QueryEventSource`.
   void SetCallback(SyncEngineCallback* callback) override {
     sync_engine_callback_ = callback;
   }
   model::TargetId Listen(Query query) override;
+
+  /**
+   * Allocates the targets of all the queries in a single transaction, raises
+   * their initial snapshots together, and then sends their listens to the
+   * backend back to back. Document queries share multi-document targets,
+   * each with up to 100 documents.
+   */
+  std::vector<model::TargetId> ListenAll(
+      const std::vector<Query>& queries) override;
+
   void StopListening(const Query& query) override;
 
+  bool DropDocuments(const Query& query) override;
+  absl::optional<ViewSnapshot> RestoreDocuments(const Query& query) override;
+
   /**
    * Initiates the write of local mutation batch which involves adding the
    * writes to the mutation queue, notifying the remote store about new
@@ -133,6 +193,29 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   void HandleCredentialChange(const auth::User& user);
 
+  /**
+   * Sets how many limbo resolutions may listen at once. Documents that enter
+   * limbo while that many are listening wait in a queue, and start resolving
+   * as earlier resolutions finish. Zero means no limit.
+   */
+  void SetMaxConcurrentLimboResolutions(size_t max_concurrent);
+
+  /**
+   * Sets whether a query whose results are provably a subset of those of a
+   * synced query (same collection, no limit, and only additional filters) is
+   * served from the cache on that query's target, instead of listening to it
+   * on a target of its own. Off by default.
+   */
+  void SetContainedQueriesServedLocally(bool enabled) {
+    contained_queries_served_locally_ = enabled;
+  }
+
+  /**
+   * Returns what it has cost so far to keep each active query up to date, the
+   * `count` most expensive by the given measure first.
+   */
+  std::vector<TargetCost> GetTargetCosts(size_t count, TargetCostOrder order);
+
   // Implements `RemoteStoreCallback`
   void ApplyRemoteEvent(const remote::RemoteEvent& remote_event) override;
   void HandleRejectedListen(model::TargetId target_id,
@@ -151,6 +234,15 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     return limbo_targets_by_key_;
   }
 
+  // For tests only
+  std::vector<model::DocumentKey> GetEnqueuedLimboDocuments() const {
+    std::vector<model::DocumentKey> keys;
+    for (const auto& entry : enqueued_limbo_resolutions_) {
+      keys.push_back(entry.second);
+    }
+    return keys;
+  }
+
  private:
   /**
    * QueryView contains all of the info that SyncEngine needs to track for a
@@ -158,10 +250,16 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
    */
   class QueryView {
    public:
-    QueryView(Query query, model::TargetId target_id, View view)
+    QueryView(Query query,
+              model::TargetId target_id,
+              View view,
+              TargetCost cost = {})
         : query_(std::move(query)),
           target_id_(target_id),
-          view_(std::move(view)) {
+          view_(std::move(view)),
+          cost_(std::move(cost)) {
+      cost_.target_id = target_id_;
+      cost_.query = query_.CanonicalId();
     }
 
     const Query& query() const {
@@ -186,10 +284,19 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
       return view_;
     }
 
+    /**
+     * The work done so far to keep the view up to date. Doesn't include the
+     * retained sizes, which are only computed on request.
+     */
+    TargetCost& cost() {
+      return cost_;
+    }
+
    private:
     Query query_;
     model::TargetId target_id_;
     View view_;
+    TargetCost cost_;
   };
 
   /** Tracks a limbo resolution. */
@@ -211,13 +318,76 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
     bool document_received = false;
   };
 
+  /**
+   * The position of a document in the queue of limbo resolutions waiting to
+   * start. Documents in limbo in more views come first, since more listeners
+   * are waiting on them, then documents that entered limbo earlier.
+   */
+  struct LimboQueuePosition {
+    /** The number of targets whose views have the document in limbo. */
+    int views = 0;
+    uint64_t order = 0;
+
+    bool operator<(const LimboQueuePosition& other) const {
+      if (views != other.views) {
+        return views > other.views;
+      }
+      return order < other.order;
+    }
+  };
+
   void AssertCallbackExists(absl::string_view source);
 
+  /**
+   * Returns the view of a synced query whose results provably include all of
+   * the results of the given query, if there is one.
+   */
+  std::shared_ptr<QueryView> FindContainingQueryView(const Query& query);
+
+  /**
+   * Serves the query from the cache, on the target of the given view, instead
+   * of listening to it on a target of its own.
+   */
+  model::TargetId ListenWithinQueryView(const Query& query,
+                                        QueryView& containing_view);
+
   ViewSnapshot InitializeViewAndComputeSnapshot(const Query& query,
                                                 model::TargetId target_id);
 
+  /**
+   * Applies the initial changes to a new view for the query and starts
+   * tracking it, along with the work done so far to set it up. Returns the
+   * view's first snapshot.
+   */
+  ViewSnapshot InitializeView(const Query& query,
+                              model::TargetId target_id,
+                              View view,
+                              const ViewDocumentChanges& view_doc_changes,
+                              TargetCost cost);
+
+  /** Runs the query against the local store, adding the work to `cost`. */
+  local::QueryResult ExecuteQuery(const Query& query,
+                                  bool use_previous_results,
+                                  TargetCost* cost);
+
+  /**
+   * Calls `compute` with each index in [0, count) and returns the results in
+   * order. The calls run in parallel on `view_executor_` when there's more
+   * than one, so `compute` must only read state that isn't modified
+   * concurrently, such as a single view.
+   */
+  std::vector<ViewDocumentChanges> ComputeInParallel(
+      size_t count,
+      const std::function<ViewDocumentChanges(size_t)>& compute);
+
   void RemoveAndCleanupTarget(model::TargetId target_id, util::Status status);
 
+  /**
+   * Moves the queries of a rejected multi-document target onto targets of
+   * their own, keeping their views.
+   */
+  void ListenToDocumentsIndividually(model::TargetId group_target_id);
+
   void RemoveLimboTarget(const model::DocumentKey& key);
 
   void EmitNewSnapshotsAndNotifyLocalStore(
@@ -231,6 +401,20 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   void TrackLimboChange(const LimboDocumentChange& limbo_change);
 
+  /**
+   * Moves the given document, if it is waiting for its limbo resolution to
+   * start, `delta` views up or down the queue.
+   */
+  void UpdateEnqueuedLimboViews(const model::DocumentKey& key, int delta);
+
+  /**
+   * Starts the limbo resolutions at the front of the queue until the maximum
+   * number of concurrent limbo resolutions is reached.
+   */
+  void PumpEnqueuedLimboResolutions();
+
+  void StartLimboResolution(const model::DocumentKey& key);
+
   void NotifyUser(model::BatchId batch_id, util::Status status);
 
   /**
@@ -255,6 +439,9 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
    */
   TargetIdGenerator target_id_generator_;
 
+  /** Computes the document changes of independent views in parallel. */
+  std::unique_ptr<util::Executor> view_executor_;
+
   /** Stores user completion blocks, indexed by User and BatchId. */
   std::unordered_map<auth::User,
                      std::unordered_map<model::BatchId, util::StatusCallback>,
@@ -273,6 +460,18 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
   /** Queries mapped to Targets, indexed by target ID. */
   std::unordered_map<model::TargetId, std::vector<Query>> queries_by_target_;
 
+  /**
+   * The targets that watch several document queries at once. Each query
+   * mapped to one of them has a view of its own document.
+   */
+  std::unordered_set<model::TargetId> document_group_targets_;
+
+  /**
+   * Queries served from the target of a query that contains them, rather than
+   * from a target of their own.
+   */
+  std::unordered_set<Query> contained_queries_;
+
   /**
    * When a document is in limbo, we create a special listen to resolve it. This
    * maps the DocumentKey of each limbo document to the TargetId of the listen
@@ -289,6 +488,19 @@ class SyncEngine : public remote::RemoteStoreCallback, public QueryEventSource {
 
   /** Used to track any documents that are currently in limbo. */
   local::ReferenceSet limbo_document_refs_;
+
+  /**
+   * The documents in limbo whose resolution hasn't started yet, in the order
+   * their resolutions start, and the position of each of them in that order.
+   */
+  std::map<LimboQueuePosition, model::DocumentKey> enqueued_limbo_resolutions_;
+  std::map<model::DocumentKey, LimboQueuePosition> enqueued_limbo_positions_;
+  uint64_t next_limbo_queue_order_ = 0;
+
+  /** The maximum size of `limbo_targets_by_key_`, or zero for no limit. */
+  size_t max_concurrent_limbo_resolutions_ = 0;
+
+  bool contained_queries_served_locally_ = false;
 };
 
 }  // namespace core
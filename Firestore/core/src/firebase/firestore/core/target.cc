@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/core/target.h"
 
+#include <algorithm>
 #include <ostream>
 
 #include "Firestore/core/src/firebase/firestore/core/field_filter.h"
@@ -35,6 +36,16 @@ namespace core {
 using model::DocumentKey;
 using model::FieldPath;
 
+Target Target::ForDocuments(std::vector<DocumentKey> keys) {
+  HARD_ASSERT(keys.size() > 1,
+              "A multi-document target must watch more than one document");
+  HARD_ASSERT(std::is_sorted(keys.begin(), keys.end()),
+              "The documents of a multi-document target must be sorted");
+  Target target;
+  target.document_keys_ = std::move(keys);
+  return target;
+}
+
 // MARK: - Accessors
 
 bool Target::IsDocumentQuery() const {
@@ -46,6 +57,15 @@ const std::string& Target::CanonicalId() const {
   if (!canonical_id_.empty()) return canonical_id_;
 
   std::string result;
+  if (IsMultiDocumentTarget()) {
+    absl::StrAppend(&result, "|docs:");
+    for (const DocumentKey& key : document_keys_) {
+      absl::StrAppend(&result, key.path().CanonicalString(), ",");
+    }
+    canonical_id_ = std::move(result);
+    return canonical_id_;
+  }
+
   absl::StrAppend(&result, path_.CanonicalString());
 
   if (collection_group_) {
@@ -82,7 +102,10 @@ const std::string& Target::CanonicalId() const {
 }
 
 size_t Target::Hash() const {
-  return util::Hash(CanonicalId());
+  if (hash_ == 0) {
+    hash_ = util::Hash(CanonicalId());
+  }
+  return hash_;
 }
 
 std::string Target::ToString() const {
@@ -94,12 +117,20 @@ std::ostream& operator<<(std::ostream& os, const Target& target) {
 }
 
 bool operator==(const Target& lhs, const Target& rhs) {
+  if (&lhs == &rhs) return true;
+
+  // Unequal hashes rule out equality without comparing every constraint.
+  if (lhs.hash_ != 0 && rhs.hash_ != 0 && lhs.hash_ != rhs.hash_) {
+    return false;
+  }
+
   return lhs.path() == rhs.path() &&
          util::Equals(lhs.collection_group(), rhs.collection_group()) &&
          lhs.filters() == rhs.filters() && lhs.order_bys() == rhs.order_bys() &&
          lhs.limit() == rhs.limit() &&
          util::Equals(lhs.start_at(), rhs.start_at()) &&
-         util::Equals(lhs.end_at(), rhs.end_at());
+         util::Equals(lhs.end_at(), rhs.end_at()) &&
+         lhs.document_keys() == rhs.document_keys();
 }
 
 }  // namespace core
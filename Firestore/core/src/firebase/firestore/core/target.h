@@ -22,11 +22,13 @@
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/bound.h"
 #include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/core/order_by.h"
 #include "Firestore/core/src/firebase/firestore/immutable/append_only_list.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
 namespace firebase {
@@ -48,6 +50,13 @@ class Target {
 
   Target() = default;
 
+  /**
+   * Creates a target that watches several documents at once, so that
+   * listeners to single documents can share one watch target. `keys` must be
+   * sorted and must hold more than one key.
+   */
+  static Target ForDocuments(std::vector<model::DocumentKey> keys);
+
   // MARK: - Accessors
 
   /** The base path of the target. */
@@ -63,6 +72,16 @@ class Target {
   /** Returns true if this Target is for a specific document. */
   bool IsDocumentQuery() const;
 
+  /** Returns true if this Target watches several specific documents. */
+  bool IsMultiDocumentTarget() const {
+    return !document_keys_.empty();
+  }
+
+  /** The documents watched by a multi-document target, in order. */
+  const std::vector<model::DocumentKey>& document_keys() const {
+    return document_keys_;
+  }
+
   /** The filters on the documents returned by the target. */
   const FilterList& filters() const {
     return filters_;
@@ -91,6 +110,12 @@ class Target {
 
   friend std::ostream& operator<<(std::ostream& os, const Target& target);
 
+  friend bool operator==(const Target& lhs, const Target& rhs);
+
+  /**
+   * Returns a hash of the canonical ID. Computed once, so that maps keyed on
+   * targets don't rehash the canonical ID on every lookup.
+   */
   size_t Hash() const;
 
  private:
@@ -126,8 +151,12 @@ class Target {
   int32_t limit_ = kNoLimit;
   std::shared_ptr<Bound> start_at_;
   std::shared_ptr<Bound> end_at_;
+  std::vector<model::DocumentKey> document_keys_;
 
   mutable std::string canonical_id_;
+
+  // The memoized hash, or zero if it hasn't been computed yet.
+  mutable size_t hash_ = 0;
 };
 
 bool operator==(const Target& lhs, const Target& rhs);
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/target_cost.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Document;
+using model::DocumentKey;
+using model::FieldValue;
+using util::StringFormat;
+
+namespace {
+
+int64_t EstimateByteSize(const DocumentKey& key) {
+  int64_t size = 0;
+  for (const std::string& segment : key.path()) {
+    size += sizeof(std::string) + segment.size();
+  }
+  return size;
+}
+
+int64_t EstimateByteSize(const FieldValue::Map& map);
+
+int64_t EstimateByteSize(const FieldValue& value) {
+  int64_t size = sizeof(FieldValue);
+  switch (value.type()) {
+    case FieldValue::Type::String:
+      size += value.string_value().size();
+      break;
+    case FieldValue::Type::Blob:
+      size += value.blob_value().size();
+      break;
+    case FieldValue::Type::Reference:
+      size += EstimateByteSize(value.reference_value().key());
+      break;
+    case FieldValue::Type::Array:
+      for (const FieldValue& element : value.array_value()) {
+        size += EstimateByteSize(element);
+      }
+      break;
+    case FieldValue::Type::Object:
+      size += EstimateByteSize(value.object_value());
+      break;
+    default:
+      break;
+  }
+  return size;
+}
+
+int64_t EstimateByteSize(const FieldValue::Map& map) {
+  int64_t size = 0;
+  for (const auto& entry : map) {
+    size += sizeof(std::string) + entry.first.size();
+    size += EstimateByteSize(entry.second);
+  }
+  return size;
+}
+
+int64_t Measure(const TargetCost& cost, TargetCostOrder order) {
+  switch (order) {
+    case TargetCostOrder::BytesRetained:
+      return cost.bytes_retained;
+    case TargetCostOrder::DocumentsScanned:
+      return cost.documents_scanned;
+    case TargetCostOrder::TotalTime:
+      return cost.total_time().count();
+  }
+  return 0;
+}
+
+}  // namespace
+
+std::string TargetCost::ToString() const {
+  return StringFormat(
+      "TargetCost(target_id=%s, query=%s, queries_executed=%s, "
+      "documents_scanned=%s, query_time=%sus, view_time=%sus, "
+      "snapshot_time=%sus, documents_retained=%s, bytes_retained=%s)",
+      target_id, query, queries_executed, documents_scanned,
+      query_time.count(), view_time.count(), snapshot_time.count(),
+      documents_retained, bytes_retained);
+}
+
+std::vector<TargetCost> TopTargetCosts(std::vector<TargetCost> costs,
+                                       size_t count,
+                                       TargetCostOrder order) {
+  auto more_expensive = [order](const TargetCost& lhs, const TargetCost& rhs) {
+    return Measure(lhs, order) > Measure(rhs, order);
+  };
+
+  count = std::min(count, costs.size());
+  std::partial_sort(costs.begin(), costs.begin() + count, costs.end(),
+                    more_expensive);
+  costs.resize(count);
+  return costs;
+}
+
+int64_t EstimateByteSize(const Document& document) {
+  return sizeof(Document) + EstimateByteSize(document.key()) +
+         EstimateByteSize(document.data().GetInternalValue());
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_TARGET_COST_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_TARGET_COST_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+/**
+ * The work done on the client to keep the results of a single listened-to
+ * query up to date, meant to help tell which listeners are expensive.
+ *
+ * Counters and durations are cumulative since the query was first listened
+ * to; the retained sizes describe the view as it is now.
+ */
+struct TargetCost {
+  using Duration = std::chrono::microseconds;
+
+  Duration total_time() const {
+    return query_time + view_time + snapshot_time;
+  }
+
+  std::string ToString() const;
+
+  /** The target that serves the query, which may be shared with others. */
+  model::TargetId target_id = 0;
+
+  /** The canonical ID of the query. */
+  std::string query;
+
+  /** The number of times the query ran against the local store. */
+  int64_t queries_executed = 0;
+
+  /** The number of documents read from the cache by those runs. */
+  int64_t documents_scanned = 0;
+
+  /** The time spent running the query against the local store. */
+  Duration query_time{0};
+
+  /** The time spent computing the changes to the view. */
+  Duration view_time{0};
+
+  /** The time spent applying the changes and building view snapshots. */
+  Duration snapshot_time{0};
+
+  /** The number of documents held by the view. */
+  int64_t documents_retained = 0;
+
+  /** An estimate of the memory used by the documents held by the view. */
+  int64_t bytes_retained = 0;
+};
+
+/** The measure by which to rank target costs. */
+enum class TargetCostOrder {
+  BytesRetained,
+  DocumentsScanned,
+  TotalTime,
+};
+
+using TargetCostsCallback = std::function<void(std::vector<TargetCost>)>;
+
+/**
+ * Returns the `count` most expensive of the given costs by the given measure,
+ * most expensive first.
+ */
+std::vector<TargetCost> TopTargetCosts(std::vector<TargetCost> costs,
+                                       size_t count,
+                                       TargetCostOrder order);
+
+/**
+ * Returns a rough estimate of the memory used by the given document, without
+ * encoding it.
+ */
+int64_t EstimateByteSize(const model::Document& document);
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_TARGET_COST_H_
@@ -22,6 +22,7 @@
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/firebase/firestore/core/user_data.h"
+#include "Firestore/core/src/firebase/firestore/local/local_store.h"
 #include "Firestore/core/src/firebase/firestore/model/delete_mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/verify_mutation.h"
 #include "Firestore/core/src/firebase/firestore/remote/datastore.h"
@@ -30,6 +31,7 @@
 using firebase::firestore::Error;
 using firebase::firestore::core::ParsedSetData;
 using firebase::firestore::core::ParsedUpdateData;
+using firebase::firestore::local::LocalStore;
 using firebase::firestore::model::DeleteMutation;
 using firebase::firestore::model::DocumentKey;
 using firebase::firestore::model::DocumentKeyHash;
@@ -39,6 +41,7 @@ using firebase::firestore::model::Precondition;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::VerifyMutation;
 using firebase::firestore::remote::Datastore;
+using firebase::firestore::util::AsyncQueue;
 using firebase::firestore::util::Status;
 using firebase::firestore::util::StatusOr;
 
@@ -77,6 +80,14 @@ Status Transaction::RecordVersion(const MaybeDocument& doc) {
   }
 }
 
+void Transaction::EnableLocalReads(LocalStore* local_store,
+                                   std::shared_ptr<AsyncQueue> worker_queue,
+                                   std::chrono::milliseconds max_staleness) {
+  local_store_ = NOT_NULL(local_store);
+  worker_queue_ = std::move(worker_queue);
+  max_staleness_ = max_staleness;
+}
+
 void Transaction::Lookup(const std::vector<DocumentKey>& keys,
                          LookupCallback&& callback) {
   EnsureCommitNotCalled();
@@ -89,29 +100,54 @@ void Transaction::Lookup(const std::vector<DocumentKey>& keys,
     return;
   }
 
+  if (!local_store_) {
+    LookupRemotely(keys, std::move(callback));
+    return;
+  }
+
+  // The local store may only be used on the worker queue.
+  // TODO(c++14): move `callback` into the lambda.
+  worker_queue_->EnqueueRelaxed([this, keys, callback] {
+    absl::optional<std::vector<MaybeDocument>> documents =
+        local_store_->ReadCurrentRemoteDocuments(keys, max_staleness_);
+    if (documents) {
+      HandleLookupResult(*documents, callback);
+    } else {
+      LookupRemotely(keys, LookupCallback{callback});
+    }
+  });
+}
+
+void Transaction::LookupRemotely(const std::vector<DocumentKey>& keys,
+                                 LookupCallback&& callback) {
   datastore_->LookupDocuments(
       keys, [this, callback](
                 const StatusOr<std::vector<MaybeDocument>>& maybe_documents) {
-        if (!maybe_documents.ok()) {
-          callback(maybe_documents.status());
-          return;
-        }
-
-        const auto& documents = maybe_documents.ValueOrDie();
-        for (const MaybeDocument& doc : documents) {
-          Status record_error = RecordVersion(doc);
-          if (!record_error.ok()) {
-            callback(record_error);
-            return;
-          }
-        }
-
-        // TODO(varconst): see if `maybe_documents` can be moved into the
-        // callback.
-        callback(maybe_documents);
+        HandleLookupResult(maybe_documents, callback);
       });
 }
 
+void Transaction::HandleLookupResult(
+    const StatusOr<std::vector<MaybeDocument>>& maybe_documents,
+    const LookupCallback& callback) {
+  if (!maybe_documents.ok()) {
+    callback(maybe_documents.status());
+    return;
+  }
+
+  const auto& documents = maybe_documents.ValueOrDie();
+  for (const MaybeDocument& doc : documents) {
+    Status record_error = RecordVersion(doc);
+    if (!record_error.ok()) {
+      callback(record_error);
+      return;
+    }
+  }
+
+  // TODO(varconst): see if `maybe_documents` can be moved into the callback.
+  callback(maybe_documents);
+}
+
 void Transaction::WriteMutations(std::vector<Mutation>&& mutations) {
   EnsureCommitNotCalled();
   // `move` will become appropriate once `Mutation` is replaced by the C++
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_TRANSACTION_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_CORE_TRANSACTION_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <functional>
 #include <memory>
 #include <unordered_map>
@@ -26,6 +27,7 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "absl/types/any.h"
@@ -34,6 +36,10 @@
 namespace firebase {
 namespace firestore {
 
+namespace local {
+class LocalStore;
+}  // namespace local
+
 namespace model {
 class Precondition;
 }  // namespace model
@@ -55,6 +61,17 @@ class Transaction {
   Transaction() = default;
   explicit Transaction(remote::Datastore* transaction);
 
+  /**
+   * Lets lookups read documents from the local cache instead of the backend
+   * when the cache is up to date (see
+   * `LocalStore::ReadCurrentRemoteDocuments`). The versions read are still
+   * sent as preconditions on commit, so the backend rejects the transaction if
+   * the cache was out of date after all.
+   */
+  void EnableLocalReads(local::LocalStore* local_store,
+                        std::shared_ptr<util::AsyncQueue> worker_queue,
+                        std::chrono::milliseconds max_staleness);
+
   /**
    * Takes a set of keys and asynchronously attempts to fetch all the documents
    * from the backend, ignoring any local changes.
@@ -107,6 +124,14 @@ class Transaction {
    */
   util::Status RecordVersion(const model::MaybeDocument& doc);
 
+  void LookupRemotely(const std::vector<model::DocumentKey>& keys,
+                      LookupCallback&& callback);
+
+  /** Records the versions of the documents read and passes them on. */
+  void HandleLookupResult(
+      const util::StatusOr<std::vector<model::MaybeDocument>>& maybe_documents,
+      const LookupCallback& callback);
+
   /** Stores mutations to be written when `Commit` is called. */
   void WriteMutations(std::vector<model::Mutation>&& mutations);
 
@@ -130,6 +155,11 @@ class Transaction {
 
   remote::Datastore* datastore_ = nullptr;
 
+  // Set if lookups may read from the local cache.
+  local::LocalStore* local_store_ = nullptr;
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  std::chrono::milliseconds max_staleness_{0};
+
   std::vector<model::Mutation> mutations_;
   bool committed_ = false;
   bool permanent_error_ = false;
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/core/transaction_runner.h"
@@ -25,6 +26,8 @@ namespace firestore {
 namespace core {
 namespace {
 
+using remote::BackoffJitter;
+using remote::BackoffProfile;
 using remote::RemoteStore;
 using util::AsyncQueue;
 using util::Status;
@@ -33,6 +36,14 @@ using util::TimerId;
 /** Maximum number of times a transaction can be retried before failing. */
 constexpr int kRetryCount = 5;
 
+/**
+ * Transactions that contend for the same documents fail together, so their
+ * retries are decorrelated to keep them from contending again.
+ */
+const BackoffProfile kBackoffProfile{3.0, std::chrono::seconds(1),
+                                     std::chrono::seconds(60),
+                                     BackoffJitter::Decorrelated};
+
 bool IsRetryableTransactionError(const util::Status& error) {
   // In transactions, the backend will fail outdated reads with
   // FAILED_PRECONDITION and non-matching document versions with ABORTED. These
@@ -51,7 +62,7 @@ TransactionRunner::TransactionRunner(const std::shared_ptr<AsyncQueue>& queue,
       remote_store_{remote_store},
       update_callback_{std::move(update_callback)},
       result_callback_{std::move(result_callback)},
-      backoff_{queue_, TimerId::RetryTransaction},
+      backoff_{queue_, TimerId::RetryTransaction, kBackoffProfile},
       retries_left_{kRetryCount} {
 }
 
@@ -61,7 +72,8 @@ void TransactionRunner::Run() {
   auto shared_this = this->shared_from_this();
   backoff_.BackoffAndRun([shared_this] {
     std::shared_ptr<Transaction> transaction =
-        shared_this->remote_store_->CreateTransaction();
+        shared_this->remote_store_->CreateTransaction(
+            shared_this->allow_local_reads_);
     shared_this->update_callback_(
         transaction, [transaction, shared_this](const util::Status& status) {
           shared_this->queue_->Enqueue([transaction, shared_this, status] {
@@ -97,6 +109,7 @@ void TransactionRunner::HandleTransactionError(
   if (retries_left_ > 0 && IsRetryableTransactionError(status) &&
       !transaction->IsPermanentlyFailed()) {
     retries_left_ -= 1;
+    allow_local_reads_ = false;
     Run();
   } else {
     result_callback_(std::move(status));
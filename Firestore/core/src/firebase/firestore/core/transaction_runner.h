@@ -68,6 +68,9 @@ class TransactionRunner
   core::TransactionResultCallback result_callback_;
   remote::ExponentialBackoff backoff_;
   int retries_left_;
+  // Retries read from the backend: a failed commit usually means the local
+  // cache was out of date.
+  bool allow_local_reads_ = true;
 };
 
 }  // namespace core
@@ -69,6 +69,12 @@ bool ParseAccumulator::Contains(const FieldPath& field_path) const {
 }
 
 void ParseAccumulator::AddToFieldMask(FieldPath field_path) {
+  // Only merges and updates write the field mask. Other sources skip it, since
+  // it would otherwise hold the path of every leaf value of a large document.
+  if (data_source_ != UserDataSource::MergeSet &&
+      data_source_ != UserDataSource::Update) {
+    return;
+  }
   field_mask_.insert(std::move(field_path));
 }
 
@@ -86,6 +92,7 @@ ParsedSetData ParseAccumulator::MergeData(ObjectValue data) && {
 ParsedSetData ParseAccumulator::MergeData(ObjectValue data,
                                           model::FieldMask user_field_mask) && {
   std::vector<FieldTransform> covered_field_transforms;
+  covered_field_transforms.reserve(field_transforms_.size());
 
   for (FieldTransform& field_transform : field_transforms_) {
     if (user_field_mask.covers(field_transform.path())) {
@@ -102,7 +109,7 @@ ParsedSetData ParseAccumulator::SetData(ObjectValue data) && {
 }
 
 ParsedUpdateData ParseAccumulator::UpdateData(ObjectValue data) && {
-  return ParsedUpdateData{data, FieldMask{std::move(field_mask_)},
+  return ParsedUpdateData{std::move(data), FieldMask{std::move(field_mask_)},
                           std::move(field_transforms_)};
 }
 
@@ -230,15 +237,15 @@ std::vector<Mutation> ParsedSetData::ToMutations(
   if (patch_) {
     PatchMutation mutation(key, std::move(data_), std::move(field_mask_),
                            precondition);
-    mutations.push_back(mutation);
+    mutations.push_back(std::move(mutation));
   } else {
     SetMutation mutation(key, std::move(data_), precondition);
-    mutations.push_back(mutation);
+    mutations.push_back(std::move(mutation));
   }
 
   if (!field_transforms_.empty()) {
     TransformMutation mutation(key, std::move(field_transforms_));
-    mutations.push_back(mutation);
+    mutations.push_back(std::move(mutation));
   }
 
   return mutations;
@@ -261,11 +268,11 @@ std::vector<Mutation> ParsedUpdateData::ToMutations(
 
   PatchMutation mutation(key, std::move(data_), std::move(field_mask_),
                          precondition);
-  mutations.push_back(mutation);
+  mutations.push_back(std::move(mutation));
 
   if (!field_transforms_.empty()) {
     TransformMutation mutation(key, std::move(field_transforms_));
-    mutations.push_back(mutation);
+    mutations.push_back(std::move(mutation));
   }
 
   return mutations;
@@ -113,7 +113,9 @@ class ParseAccumulator {
   bool Contains(const model::FieldPath& field_path) const;
 
   /**
-   * Adds the given `field_path` to the accumulated FieldMask.
+   * Adds the given `field_path` to the accumulated FieldMask. Does nothing
+   * unless the data comes from a merge or an update, the only sources whose
+   * parsed data carries a field mask.
    */
   void AddToFieldMask(model::FieldPath field_path);
 
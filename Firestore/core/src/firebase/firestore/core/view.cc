@@ -16,10 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/core/view.h"
 
+#include <set>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/target.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 namespace firebase {
@@ -29,7 +33,10 @@ namespace core {
 using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
+using model::DocumentMap;
 using model::DocumentSet;
+using model::FieldMask;
+using model::FieldPath;
 using model::MaybeDocument;
 using model::MaybeDocumentMap;
 using model::OnlineState;
@@ -52,10 +59,12 @@ bool operator==(const LimboDocumentChange& lhs,
 // MARK: - ViewDocumentChanges
 
 ViewDocumentChanges::ViewDocumentChanges(model::DocumentSet new_documents,
+                                         model::DocumentSet overflow_documents,
                                          DocumentViewChangeSet changes,
                                          model::DocumentKeySet mutated_keys,
                                          bool needs_refill)
     : document_set_(std::move(new_documents)),
+      overflow_document_set_(std::move(overflow_documents)),
       change_set_(std::move(changes)),
       mutated_keys_(std::move(mutated_keys)),
       needs_refill_(needs_refill) {
@@ -65,28 +74,29 @@ ViewDocumentChanges::ViewDocumentChanges(model::DocumentSet new_documents,
 
 namespace {
 
-int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
-  switch (change_type) {
-    case DocumentViewChange::Type::Removed:
-      return 0;
-    case DocumentViewChange::Type::Added:
-      return 1;
-    case DocumentViewChange::Type::Modified:
-      return 2;
-    case DocumentViewChange::Type::Metadata:
-      // A metadata change is converted to a modified change at the public API
-      // layer. Since we sort by document key and then change type, metadata and
-      // modified changes must be sorted equivalently.
-      return 2;
+/**
+ * The maximum number of docs past the limit of a limit query that a view keeps
+ * track of.
+ */
+constexpr size_t kMaxOverflowDocuments = 20;
+
+FieldMask SortFields(const Query& query) {
+  std::set<FieldPath> fields;
+  for (const OrderBy& order_by : query.order_bys()) {
+    if (!order_by.field().IsKeyFieldPath()) {
+      fields.insert(order_by.field());
+    }
   }
-  HARD_FAIL("Unknown DocumentViewChange::Type %s", change_type);
+  return FieldMask(std::move(fields));
 }
 
 }  // namespace
 
 View::View(Query query, DocumentKeySet remote_documents)
     : query_(std::move(query)),
+      sort_fields_(SortFields(query_)),
       document_set_(query_.Comparator()),
+      overflow_document_set_(query_.Comparator()),
       synced_documents_(std::move(remote_documents)) {
 }
 
@@ -94,6 +104,45 @@ ComparisonResult View::Compare(const Document& lhs, const Document& rhs) const {
   return document_set_.comparator().Compare(lhs, rhs);
 }
 
+ViewSnapshot View::ComputeLocalSnapshot(const Query& query,
+                                         const DocumentMap& documents,
+                                         bool from_cache) {
+  DocumentSet document_set{query.Comparator()};
+  bool has_limit = query.limit_type() != LimitType::None;
+  bool limit_to_last = query.has_limit_to_last();
+  size_t limit = has_limit ? static_cast<size_t>(query.limit()) : 0;
+  for (const auto& kv : documents.underlying_map()) {
+    Document doc(kv.second);
+    if (!query.Matches(doc)) {
+      continue;
+    }
+    if (query.has_projection()) {
+      doc = query.Project(doc);
+    }
+    document_set = document_set.insert(doc);
+
+    // Keep only the documents closest to the start of the limit.
+    if (has_limit && document_set.size() > limit) {
+      absl::optional<Document> furthest =
+          limit_to_last ? document_set.GetFirstDocument()
+                        : document_set.GetLastDocument();
+      document_set = document_set.erase(furthest->key());
+    }
+  }
+
+  DocumentKeySet mutated_keys;
+  for (const Document& doc : document_set) {
+    if (doc.has_local_mutations()) {
+      mutated_keys = mutated_keys.insert(doc.key());
+    }
+  }
+
+  // A new view of cached documents isn't current until Watch says so.
+  return ViewSnapshot::FromInitialDocuments(
+      query, std::move(document_set), std::move(mutated_keys), from_cache,
+      /*excludes_metadata_changes=*/false);
+}
+
 ViewDocumentChanges View::ComputeDocumentChanges(
     const MaybeDocumentMap& doc_changes,
     const absl::optional<ViewDocumentChanges>& previous_changes) const {
@@ -103,37 +152,59 @@ ViewDocumentChanges View::ComputeDocumentChanges(
   }
   DocumentSet old_document_set =
       previous_changes ? previous_changes->document_set() : document_set_;
+  DocumentSet new_overflow_set = previous_changes
+                                     ? previous_changes->overflow_document_set()
+                                     : overflow_document_set_;
 
-  DocumentKeySet new_mutated_keys =
-      previous_changes ? previous_changes->mutated_keys() : mutated_keys_;
+  // Mutated keys are only ever added or removed below, so edit them in place.
+  DocumentKeySet::Transient new_mutated_keys{
+      previous_changes ? previous_changes->mutated_keys() : mutated_keys_};
   DocumentKeySet old_mutated_keys = mutated_keys_;
   DocumentSet new_document_set = old_document_set;
   bool needs_refill = false;
 
-  // Track the last doc in a (full) limit. This is necessary, because some
-  // update (a delete, or an update moving a doc past the old limit) might mean
-  // there is some other document in the local cache that either should come (1)
-  // between the old last limit doc and the new last document, in the case of
-  // updates, or (2) after the new last document, in the case of deletes. So we
-  // keep this doc at the old limit to compare the updates to.
+  // For a limit query, the documents that end up in the limit are the ones
+  // closest to its start, so the remaining helpers work on "the furthest"
+  // document of a set: the last for limitToFirst and the first for
+  // limitToLast.
+  bool limit_to_last = query_.has_limit_to_last();
+  auto furthest = [limit_to_last](const DocumentSet& set) {
+    return limit_to_last ? set.GetFirstDocument() : set.GetLastDocument();
+  };
+  auto nearest = [limit_to_last](const DocumentSet& set) {
+    return limit_to_last ? set.GetLastDocument() : set.GetFirstDocument();
+  };
+  auto is_further = [this, limit_to_last](const Document& lhs,
+                                          const Document& rhs) {
+    ComparisonResult result = Compare(lhs, rhs);
+    return limit_to_last ? util::Ascending(result) : util::Descending(result);
+  };
+
+  // Track the furthest doc known to a (full) limit: the last overflow doc, or
+  // the last doc in the limit if there are none. This is necessary, because
+  // some update (a delete, or an update moving a doc past the limit) might mean
+  // there is some other document in the local cache that should come between
+  // the limit and that update. Every doc up to this boundary is known, so we
+  // keep it to compare the updates to.
   //
-  // Note that this should never get used in a refill (when previous_changes is
-  // set), because there will only be adds -- no deletes or updates.
-  absl::optional<Document> last_doc_in_limit;
-  if (query_.has_limit_to_first() &&
-      old_document_set.size() == static_cast<size_t>(query_.limit())) {
-    last_doc_in_limit = old_document_set.GetLastDocument();
-  }
-  absl::optional<Document> first_doc_in_limit;
-  if (query_.has_limit_to_last() &&
+  // A refill (when previous_changes is set) passes in every document in the
+  // local cache that matches the query, so there is no boundary.
+  absl::optional<Document> boundary_doc;
+  if (query_.limit_type() != LimitType::None && !previous_changes &&
       old_document_set.size() == static_cast<size_t>(query_.limit())) {
-    first_doc_in_limit = old_document_set.GetFirstDocument();
+    boundary_doc = furthest(new_overflow_set.empty() ? old_document_set
+                                                     : new_overflow_set);
   }
 
   for (const auto& kv : doc_changes) {
     const DocumentKey& key = kv.first;
     const MaybeDocument& maybe_new_doc = kv.second;
 
+    // Changed overflow docs are processed like docs that are new to the view.
+    if (new_overflow_set.ContainsKey(key)) {
+      new_overflow_set = new_overflow_set.erase(key);
+    }
+
     absl::optional<Document> old_doc = old_document_set.GetDocument(key);
     absl::optional<Document> new_doc;
     if (maybe_new_doc.is_document()) {
@@ -145,6 +216,9 @@ ViewDocumentChanges View::ComputeDocumentChanges(
                   key.ToString(), new_doc->key().ToString());
       if (!query_.Matches(*new_doc)) {
         new_doc = absl::nullopt;
+      } else if (query_.has_projection()) {
+        // Changes to fields outside the projection are not visible.
+        new_doc = query_.Project(*new_doc);
       }
     }
 
@@ -161,25 +235,12 @@ ViewDocumentChanges View::ComputeDocumentChanges(
     bool change_applied = false;
     // Calculate change
     if (old_doc && new_doc) {
-      bool docs_equal = old_doc->data() == new_doc->data();
+      bool docs_equal = HasSameData(*old_doc, *new_doc);
       if (!docs_equal) {
         if (!ShouldWaitForSyncedDocument(*new_doc, *old_doc)) {
           change_set.AddChange(
               DocumentViewChange{*new_doc, DocumentViewChange::Type::Modified});
           change_applied = true;
-
-          bool outside_limit =
-              last_doc_in_limit &&
-              util::Descending(Compare(*new_doc, *last_doc_in_limit));
-          bool outside_limit_to_last =
-              first_doc_in_limit &&
-              util::Ascending(Compare(*new_doc, *first_doc_in_limit));
-          if (outside_limit || outside_limit_to_last) {
-            // This doc moved from inside the limit to after the limit. That
-            // means there may be some doc in the local cache that's actually
-            // less than this one.
-            needs_refill = true;
-          }
         }
       } else if (old_doc_had_pending_mutations !=
                  new_doc_has_pending_mutations) {
@@ -196,52 +257,112 @@ ViewDocumentChanges View::ComputeDocumentChanges(
       change_set.AddChange(
           DocumentViewChange{*old_doc, DocumentViewChange::Type::Removed});
       change_applied = true;
-
-      if (last_doc_in_limit || first_doc_in_limit) {
-        // A doc was removed from a full limit query. We'll need to re-query
-        // from the local cache to see if we know about some other doc that
-        // should be in the results.
-        needs_refill = true;
-      }
     }
 
     if (change_applied) {
       if (new_doc) {
-        new_document_set = new_document_set.insert(new_doc);
+        new_document_set = new_document_set.insert(Retained(*new_doc));
         if (new_doc->has_local_mutations()) {
-          new_mutated_keys = new_mutated_keys.insert(key);
+          new_mutated_keys.insert(key);
         } else {
-          new_mutated_keys = new_mutated_keys.erase(key);
+          new_mutated_keys.erase(key);
         }
       } else {
         new_document_set = new_document_set.erase(key);
-        new_mutated_keys = new_mutated_keys.erase(key);
+        new_mutated_keys.erase(key);
       }
     }
   }
 
-  // Drop documents out to meet limitToFirst/limitToLast requirement.
   if (query_.limit_type() != LimitType::None) {
     auto limit = static_cast<size_t>(query_.limit());
-    if (limit < new_document_set.size()) {
-      for (size_t i = new_document_set.size() - limit; i > 0; --i) {
-        absl::optional<Document> found =
-            query_.has_limit_to_first() ? new_document_set.GetLastDocument()
-                                        : new_document_set.GetFirstDocument();
-        const Document& old_doc = *found;
-        new_document_set = new_document_set.erase(old_doc.key());
-        new_mutated_keys = new_mutated_keys.erase(old_doc.key());
-        change_set.AddChange(
-            DocumentViewChange{old_doc, DocumentViewChange::Type::Removed});
+
+    // Documents that don't retain their contents can't be moved into the
+    // limit, since they'd be raised as added.
+    bool keep_overflow = retains_documents_ && previous_changes.has_value();
+    if (boundary_doc) {
+      // Docs that moved past the boundary may have been overtaken by docs in
+      // the local cache that the view doesn't know about, so drop them unless
+      // the view would no longer fill the limit. In that case we need to
+      // re-query from the local cache anyway.
+      DocumentSet within_boundary = new_document_set;
+      std::vector<Document> past_boundary;
+      while (!within_boundary.empty()) {
+        Document doc = *furthest(within_boundary);
+        if (!is_further(doc, *boundary_doc)) {
+          break;
+        }
+        within_boundary = within_boundary.erase(doc.key());
+        past_boundary.push_back(std::move(doc));
+      }
+
+      if (within_boundary.size() + new_overflow_set.size() < limit) {
+        // The refill finds the overflow docs again.
+        needs_refill = true;
+        new_overflow_set = DocumentSet{query_.Comparator()};
+      } else {
+        keep_overflow = retains_documents_;
+        new_document_set = within_boundary;
+        for (Document& doc : past_boundary) {
+          new_mutated_keys.erase(doc.key());
+          change_set.AddChange(
+              DocumentViewChange{std::move(doc),
+                                 DocumentViewChange::Type::Removed});
+        }
+      }
+    }
+
+    // Drop documents out to meet limitToFirst/limitToLast requirement, keeping
+    // the ones right after the limit as overflow if every doc before them is
+    // known.
+    while (new_document_set.size() > limit) {
+      Document doc = *furthest(new_document_set);
+      new_document_set = new_document_set.erase(doc.key());
+      new_mutated_keys.erase(doc.key());
+      if (keep_overflow) {
+        new_overflow_set = new_overflow_set.insert(doc);
+      }
+      change_set.AddChange(DocumentViewChange{
+          std::move(doc), DocumentViewChange::Type::Removed});
+    }
+
+    // Move overflow documents into the limit where they now belong.
+    while (!new_overflow_set.empty()) {
+      Document doc = *nearest(new_overflow_set);
+      if (new_document_set.size() == limit) {
+        Document last_doc = *furthest(new_document_set);
+        if (!is_further(last_doc, doc)) {
+          break;
+        }
+        new_document_set = new_document_set.erase(last_doc.key());
+        new_mutated_keys.erase(last_doc.key());
+        new_overflow_set = new_overflow_set.insert(last_doc);
+        change_set.AddChange(DocumentViewChange{
+            std::move(last_doc), DocumentViewChange::Type::Removed});
+      }
+
+      new_overflow_set = new_overflow_set.erase(doc.key());
+      new_document_set = new_document_set.insert(doc);
+      if (doc.has_local_mutations()) {
+        new_mutated_keys.insert(doc.key());
       }
+      change_set.AddChange(
+          DocumentViewChange{std::move(doc), DocumentViewChange::Type::Added});
+    }
+
+    while (new_overflow_set.size() > kMaxOverflowDocuments) {
+      new_overflow_set =
+          new_overflow_set.erase(furthest(new_overflow_set)->key());
     }
   }
 
   HARD_ASSERT(!needs_refill || !previous_changes,
               "View was refilled using docs that themselves needed refilling.");
 
-  return ViewDocumentChanges(std::move(new_document_set), std::move(change_set),
-                             new_mutated_keys, needs_refill);
+  return ViewDocumentChanges(std::move(new_document_set),
+                             std::move(new_overflow_set), std::move(change_set),
+                             std::move(new_mutated_keys).freeze(),
+                             needs_refill);
 }
 
 bool View::ShouldWaitForSyncedDocument(const Document& new_doc,
@@ -257,6 +378,59 @@ bool View::ShouldWaitForSyncedDocument(const Document& new_doc,
           !new_doc.has_local_mutations());
 }
 
+bool View::HasSameData(const Document& old_doc, const Document& new_doc) const {
+  if (retains_documents_ || old_doc.has_local_mutations()) {
+    return old_doc.data() == new_doc.data();
+  }
+
+  // The contents of a document without pending writes are those of its
+  // version on the backend, or of a committed write at that version.
+  return !new_doc.has_local_mutations() &&
+         old_doc.version() == new_doc.version();
+}
+
+Document View::Retained(const Document& doc) const {
+  if (retains_documents_ || doc.has_local_mutations()) {
+    // Pending writes can change the contents of a document without changing
+    // its version, so keep them to compare against.
+    return doc;
+  }
+  return Document(doc.data().Project(sort_fields_), doc.key(), doc.version(),
+                  doc.document_state());
+}
+
+void View::DropDocuments() {
+  retains_documents_ = false;
+
+  DocumentSet dropped{query_.Comparator()};
+  for (const Document& doc : document_set_) {
+    dropped = dropped.insert(Retained(doc));
+  }
+  document_set_ = std::move(dropped);
+  overflow_document_set_ = DocumentSet{query_.Comparator()};
+}
+
+ViewSnapshot View::RestoreDocuments(const DocumentMap& documents) {
+  retains_documents_ = true;
+
+  DocumentSet restored{query_.Comparator()};
+  for (const Document& doc : document_set_) {
+    absl::optional<MaybeDocument> found =
+        documents.underlying_map().get(doc.key());
+    if (found && found->is_document()) {
+      restored = restored.insert(query_.Project(Document(*found)));
+    } else {
+      restored = restored.insert(doc);
+    }
+  }
+  document_set_ = std::move(restored);
+
+  return ViewSnapshot::FromInitialDocuments(
+      query_, document_set_, mutated_keys_,
+      /*from_cache=*/sync_state_ != SyncState::Synced,
+      /*excludes_metadata_changes=*/false);
+}
+
 ViewChange View::ApplyChanges(const ViewDocumentChanges& doc_changes) {
   return ApplyChanges(doc_changes, {});
 }
@@ -269,22 +443,9 @@ ViewChange View::ApplyChanges(
 
   DocumentSet old_documents = document_set_;
   document_set_ = doc_changes.document_set();
+  overflow_document_set_ = doc_changes.overflow_document_set();
   mutated_keys_ = doc_changes.mutated_keys();
 
-  // Sort changes based on type and query comparator.
-  std::vector<DocumentViewChange> changes =
-      doc_changes.change_set().GetChanges();
-  std::sort(
-      changes.begin(), changes.end(),
-      [this](const DocumentViewChange& lhs, const DocumentViewChange& rhs) {
-        int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
-        int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
-        if (pos1 != pos2) {
-          return pos1 < pos2;
-        }
-        return util::Ascending(Compare(lhs.document(), rhs.document()));
-      });
-
   ApplyTargetChange(target_change);
   std::vector<LimboDocumentChange> limbo_changes = UpdateLimboDocuments();
   bool synced = limbo_documents_.empty() && current_;
@@ -292,18 +453,16 @@ ViewChange View::ApplyChanges(
   bool sync_state_changed = new_sync_state != sync_state_;
   sync_state_ = new_sync_state;
 
-  if (changes.empty() && !sync_state_changed) {
+  const DocumentViewChangeSet& changes = doc_changes.change_set();
+  if (changes.change_map().empty() && !sync_state_changed) {
     // No changes.
     return ViewChange(absl::nullopt, std::move(limbo_changes));
   } else {
-    ViewSnapshot snapshot{query_,
-                          doc_changes.document_set(),
-                          old_documents,
-                          std::move(changes),
-                          doc_changes.mutated_keys(),
-                          /*from_cache=*/new_sync_state == SyncState::Local,
-                          sync_state_changed,
-                          /*excludes_metadata_changes=*/false};
+    ViewSnapshot snapshot = ViewSnapshot::FromChangeSet(
+        query_, doc_changes.document_set(), old_documents, changes,
+        doc_changes.mutated_keys(),
+        /*from_cache=*/new_sync_state == SyncState::Local, sync_state_changed,
+        /*excludes_metadata_changes=*/false);
 
     return ViewChange(std::move(snapshot), std::move(limbo_changes));
   }
@@ -317,8 +476,9 @@ ViewChange View::ApplyOnlineStateChange(OnlineState online_state) {
     // once the client is back online.
     current_ = false;
     return ApplyChanges(
-        ViewDocumentChanges(document_set_, DocumentViewChangeSet{},
-                            mutated_keys_, /* needs_refill= */ false));
+        ViewDocumentChanges(document_set_, overflow_document_set_,
+                            DocumentViewChangeSet{}, mutated_keys_,
+                            /* needs_refill= */ false));
   } else {
     // No effect, just return a no-op ViewChange.
     return ViewChange(absl::nullopt, {});
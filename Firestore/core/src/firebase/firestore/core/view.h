@@ -22,7 +22,9 @@
 
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 
@@ -68,6 +70,7 @@ class LimboDocumentChange {
 class ViewDocumentChanges {
  public:
   ViewDocumentChanges(model::DocumentSet new_documents,
+                      model::DocumentSet overflow_documents,
                       DocumentViewChangeSet changes,
                       model::DocumentKeySet mutated_keys,
                       bool needs_refill);
@@ -77,6 +80,14 @@ class ViewDocumentChanges {
     return document_set_;
   }
 
+  /**
+   * For limit queries, the docs that come right after the limit, which the view
+   * can move into its results without going back to the local cache.
+   */
+  const model::DocumentSet& overflow_document_set() const {
+    return overflow_document_set_;
+  }
+
   /** The diff of these docs with the previous set of docs. */
   const core::DocumentViewChangeSet& change_set() const {
     return change_set_;
@@ -97,6 +108,7 @@ class ViewDocumentChanges {
 
  private:
   model::DocumentSet document_set_;
+  model::DocumentSet overflow_document_set_;
   core::DocumentViewChangeSet change_set_;
   model::DocumentKeySet mutated_keys_;
   bool needs_refill_ = false;
@@ -137,6 +149,26 @@ class View {
  public:
   View(Query query, model::DocumentKeySet remote_documents);
 
+  /**
+   * Returns the snapshot that a new view of the query would raise for the
+   * given documents, without setting up the view or diffing the documents
+   * against its empty initial state. Used to answer one-off reads from the
+   * cache, or from the backend when `from_cache` is false.
+   */
+  static ViewSnapshot ComputeLocalSnapshot(const Query& query,
+                                           const model::DocumentMap& documents,
+                                           bool from_cache = true);
+
+  /** The documents currently in the view. */
+  const model::DocumentSet& documents() const {
+    return document_set_;
+  }
+
+  /** The documents kept just past the limit of a limit query. */
+  const model::DocumentSet& overflow_documents() const {
+    return overflow_document_set_;
+  }
+
   /**
    * The set of remote documents that the server has told us belongs to the
    * target associated with this view.
@@ -192,6 +224,30 @@ class View {
     return sync_state_;
   }
 
+  /**
+   * Whether the view keeps the full contents of its documents, which it does
+   * unless `DropDocuments` was called.
+   */
+  bool retains_documents() const {
+    return retains_documents_;
+  }
+
+  /**
+   * Makes the view keep only the key, metadata and sort fields of each
+   * document without pending writes, for listeners that only read document
+   * changes. Documents without pending writes are compared by version instead
+   * of contents from then on, and a limit query no longer keeps documents past
+   * its limit.
+   */
+  void DropDocuments();
+
+  /**
+   * Makes the view keep the full contents of its documents again, taking them
+   * from the given results of the query in the local cache. Returns the
+   * snapshot that a new listener of the view would first see.
+   */
+  ViewSnapshot RestoreDocuments(const model::DocumentMap& documents);
+
  private:
   util::ComparisonResult Compare(const model::Document& lhs,
                                  const model::Document& rhs) const;
@@ -201,6 +257,13 @@ class View {
   bool ShouldWaitForSyncedDocument(const model::Document& new_doc,
                                    const model::Document& old_doc) const;
 
+  /** Whether the two versions of a document have the same contents. */
+  bool HasSameData(const model::Document& old_doc,
+                   const model::Document& new_doc) const;
+
+  /** Returns the given document as this view keeps it. */
+  model::Document Retained(const model::Document& doc) const;
+
   void ApplyTargetChange(
       const absl::optional<remote::TargetChange>& maybe_target_change);
 
@@ -208,8 +271,19 @@ class View {
 
   Query query_;
 
+  /** The fields that order the query, other than the key. */
+  model::FieldMask sort_fields_;
+
   model::DocumentSet document_set_;
 
+  /**
+   * For limit queries, a small number of docs that come right after the limit.
+   * Every doc in the local cache that sorts between the limit and the furthest
+   * of these is either in `document_set_` or here, so docs that leave the limit
+   * can be replaced without a refill from the local cache.
+   */
+  model::DocumentSet overflow_document_set_;
+
   /** Documents included in the remote target. */
   model::DocumentKeySet synced_documents_;
 
@@ -228,6 +302,8 @@ class View {
    * filter mismatch).
    */
   bool current_ = false;
+
+  bool retains_documents_ = true;
 };
 
 }  // namespace core
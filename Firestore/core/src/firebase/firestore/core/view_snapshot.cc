@@ -16,23 +16,54 @@
 
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 
+#include <algorithm>
+#include <mutex>  // NOLINT(build/c++11)
 #include <ostream>
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
+#include "absl/algorithm/container.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
 namespace core {
 
+using immutable::SortedMap;
 using model::Document;
+using model::DocumentComparator;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentSet;
 using util::StringFormat;
 
+namespace {
+
+bool IsMetadataChange(const DocumentViewChange& change) {
+  return change.type() == DocumentViewChange::Type::Metadata;
+}
+
+int GetDocumentViewChangeTypePosition(DocumentViewChange::Type change_type) {
+  switch (change_type) {
+    case DocumentViewChange::Type::Removed:
+      return 0;
+    case DocumentViewChange::Type::Added:
+      return 1;
+    case DocumentViewChange::Type::Modified:
+      return 2;
+    case DocumentViewChange::Type::Metadata:
+      // A metadata change is converted to a modified change at the public API
+      // layer. Since we sort by document key and then change type, metadata and
+      // modified changes must be sorted equivalently.
+      return 2;
+  }
+  HARD_FAIL("Unknown DocumentViewChange::Type %s", change_type);
+}
+
+}  // namespace
+
 // DocumentViewChange
 
 DocumentViewChange::DocumentViewChange(Document document, Type type)
@@ -134,6 +165,131 @@ std::string DocumentViewChangeSet::ToString() const {
   return util::ToString(change_map_);
 }
 
+// ViewSnapshot::ChangeList
+
+/**
+ * The document changes of a view snapshot. Either holds the sorted list of
+ * changes directly, or builds it from a change set the first time it's read.
+ * Reads may come from any thread that a listener of the query runs on.
+ */
+class ViewSnapshot::ChangeList {
+ public:
+  using ChangeMap = SortedMap<DocumentKey, DocumentViewChange>;
+
+  explicit ChangeList(std::vector<DocumentViewChange> changes)
+      : changes_{std::move(changes)},
+        size_{changes_.size()},
+        metadata_change_count_{static_cast<size_t>(
+            absl::c_count_if(changes_, IsMetadataChange))} {
+  }
+
+  ChangeList(ChangeMap change_map,
+             DocumentComparator comparator,
+             bool excludes_metadata_changes)
+      : change_map_{std::move(change_map)},
+        comparator_{std::move(comparator)},
+        excludes_metadata_changes_{excludes_metadata_changes} {
+    size_t metadata_changes = 0;
+    for (const auto& kv : change_map_) {
+      if (IsMetadataChange(kv.second)) {
+        ++metadata_changes;
+      }
+    }
+
+    size_ = change_map_.size();
+    if (excludes_metadata_changes_) {
+      size_ -= metadata_changes;
+    } else {
+      metadata_change_count_ = metadata_changes;
+    }
+  }
+
+  /**
+   * Returns the given list without its metadata-only changes, or the list
+   * itself if it has none.
+   */
+  static std::shared_ptr<const ChangeList> ExcludingMetadataChanges(
+      const std::shared_ptr<const ChangeList>& list) {
+    if (list->metadata_change_count_ == 0) {
+      return list;
+    }
+
+    if (list->comparator_) {
+      return std::make_shared<const ChangeList>(
+          list->change_map_, *list->comparator_,
+          /*excludes_metadata_changes=*/true);
+    }
+
+    std::vector<DocumentViewChange> filtered;
+    for (const DocumentViewChange& change : list->changes_) {
+      if (!IsMetadataChange(change)) {
+        filtered.push_back(change);
+      }
+    }
+    return std::make_shared<const ChangeList>(std::move(filtered));
+  }
+
+  const std::vector<DocumentViewChange>& changes() const {
+    if (comparator_) {
+      std::call_once(build_once_, [this] { Build(); });
+    }
+    return changes_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  void ForEach(
+      const std::function<void(const DocumentViewChange&)>& callback) const {
+    if (!comparator_) {
+      for (const DocumentViewChange& change : changes_) {
+        callback(change);
+      }
+      return;
+    }
+
+    for (const auto& kv : change_map_) {
+      if (!excludes_metadata_changes_ || !IsMetadataChange(kv.second)) {
+        callback(kv.second);
+      }
+    }
+  }
+
+ private:
+  void Build() const {
+    changes_.reserve(size_);
+    ForEach([this](const DocumentViewChange& change) {
+      changes_.push_back(change);
+    });
+
+    // Sort changes based on type and query comparator.
+    const DocumentComparator& comparator = *comparator_;
+    std::sort(changes_.begin(), changes_.end(),
+              [&comparator](const DocumentViewChange& lhs,
+                            const DocumentViewChange& rhs) {
+                int pos1 = GetDocumentViewChangeTypePosition(lhs.type());
+                int pos2 = GetDocumentViewChangeTypePosition(rhs.type());
+                if (pos1 != pos2) {
+                  return pos1 < pos2;
+                }
+                return util::Ascending(
+                    comparator.Compare(lhs.document(), rhs.document()));
+              });
+  }
+
+  // Set only when the list is built lazily from `change_map_`.
+  ChangeMap change_map_;
+  absl::optional<DocumentComparator> comparator_;
+  bool excludes_metadata_changes_ = false;
+
+  mutable std::once_flag build_once_;
+  mutable std::vector<DocumentViewChange> changes_;
+
+  size_t size_ = 0;
+  size_t metadata_change_count_ = 0;
+};
+
 // ViewSnapshot
 
 ViewSnapshot::ViewSnapshot(Query query,
@@ -147,7 +303,8 @@ ViewSnapshot::ViewSnapshot(Query query,
     : query_{std::move(query)},
       documents_{std::move(documents)},
       old_documents_{std::move(old_documents)},
-      document_changes_{std::move(document_changes)},
+      document_changes_{
+          std::make_shared<const ChangeList>(std::move(document_changes))},
       mutated_keys_{std::move(mutated_keys)},
       from_cache_{from_cache},
       sync_state_changed_{sync_state_changed},
@@ -176,10 +333,74 @@ ViewSnapshot ViewSnapshot::FromInitialDocuments(
                       excludes_metadata_changes};
 }
 
+ViewSnapshot ViewSnapshot::FromChangeSet(Query query,
+                                         DocumentSet documents,
+                                         DocumentSet old_documents,
+                                         const DocumentViewChangeSet& changes,
+                                         DocumentKeySet mutated_keys,
+                                         bool from_cache,
+                                         bool sync_state_changed,
+                                         bool excludes_metadata_changes) {
+  ViewSnapshot result{std::move(query),
+                      std::move(documents),
+                      std::move(old_documents),
+                      {},
+                      std::move(mutated_keys),
+                      from_cache,
+                      sync_state_changed,
+                      excludes_metadata_changes};
+  result.document_changes_ = std::make_shared<const ChangeList>(
+      changes.change_map(), result.documents_.comparator(),
+      excludes_metadata_changes);
+  return result;
+}
+
+ViewSnapshot ViewSnapshot::Merge(const ViewSnapshot& earlier,
+                                 const ViewSnapshot& later) {
+  DocumentViewChangeSet changes;
+  auto add_change = [&changes](const DocumentViewChange& change) {
+    changes.AddChange(DocumentViewChange{change});
+  };
+  earlier.ForEachDocumentChange(add_change);
+  later.ForEachDocumentChange(add_change);
+
+  return FromChangeSet(later.query_, later.documents_, earlier.old_documents_,
+                       changes, later.mutated_keys_, later.from_cache_,
+                       earlier.sync_state_changed_ || later.sync_state_changed_,
+                       later.excludes_metadata_changes_);
+}
+
+ViewSnapshot ViewSnapshot::ExcludingMetadataChanges() const {
+  ViewSnapshot result{query_,
+                      documents_,
+                      old_documents_,
+                      {},
+                      mutated_keys_,
+                      from_cache_,
+                      sync_state_changed_,
+                      /*excludes_metadata_changes=*/true};
+  result.document_changes_ =
+      ChangeList::ExcludingMetadataChanges(document_changes_);
+  return result;
+}
+
 const Query& ViewSnapshot::query() const {
   return query_;
 }
 
+const std::vector<DocumentViewChange>& ViewSnapshot::document_changes() const {
+  return document_changes_->changes();
+}
+
+size_t ViewSnapshot::document_change_count() const {
+  return document_changes_->size();
+}
+
+void ViewSnapshot::ForEachDocumentChange(
+    const std::function<void(const DocumentViewChange&)>& callback) const {
+  document_changes_->ForEach(callback);
+}
+
 std::string ViewSnapshot::ToString() const {
   return StringFormat(
       "<ViewSnapshot query: %s documents: %s old_documents: %s changes: %s "
@@ -84,6 +84,12 @@ class DocumentViewChangeSet {
   /** Returns the set of all changes tracked in this set. */
   std::vector<DocumentViewChange> GetChanges() const;
 
+  /** The changes tracked in this set, keyed by document key. */
+  const immutable::SortedMap<model::DocumentKey, DocumentViewChange>&
+  change_map() const {
+    return change_map_;
+  }
+
   std::string ToString() const;
 
  private:
@@ -116,6 +122,37 @@ class ViewSnapshot {
                                            bool from_cache,
                                            bool excludes_metadata_changes);
 
+  /**
+   * Returns a view snapshot whose changes are those in the given change set.
+   * The changes are only copied out of the set and sorted when
+   * `document_changes()` is first called, so listeners that never look at
+   * individual changes don't pay for them.
+   */
+  static ViewSnapshot FromChangeSet(Query query,
+                                    model::DocumentSet documents,
+                                    model::DocumentSet old_documents,
+                                    const DocumentViewChangeSet& changes,
+                                    model::DocumentKeySet mutated_keys,
+                                    bool from_cache,
+                                    bool sync_state_changed,
+                                    bool excludes_metadata_changes);
+
+  /**
+   * Returns a view snapshot that combines two successive snapshots of the same
+   * view, as if the changes of both had been raised in one snapshot. Used to
+   * conflate snapshots that a listener hasn't seen yet.
+   */
+  static ViewSnapshot Merge(const ViewSnapshot& earlier,
+                            const ViewSnapshot& later);
+
+  /**
+   * Returns this snapshot without its metadata-only document changes, as seen
+   * by listeners that don't include document metadata changes. The documents
+   * are shared with this snapshot, as is the list of changes if none of them
+   * are metadata-only.
+   */
+  ViewSnapshot ExcludingMetadataChanges() const;
+
   /** The query this view is tracking the results for. */
   const Query& query() const;
 
@@ -129,10 +166,21 @@ class ViewSnapshot {
     return old_documents_;
   }
 
-  /** The set of changes that have been applied to the documents. */
-  const std::vector<DocumentViewChange>& document_changes() const {
-    return document_changes_;
-  }
+  /**
+   * The set of changes that have been applied to the documents, sorted by
+   * change type and then by the query's order.
+   */
+  const std::vector<DocumentViewChange>& document_changes() const;
+
+  /** The number of changes in `document_changes()`, without building it. */
+  size_t document_change_count() const;
+
+  /**
+   * Calls the given callback with each change in `document_changes()`, in no
+   * particular order, without building the sorted list.
+   */
+  void ForEachDocumentChange(
+      const std::function<void(const DocumentViewChange&)>& callback) const;
 
   /** Whether any document in the snapshot was served from the local cache. */
   bool from_cache() const {
@@ -164,11 +212,17 @@ class ViewSnapshot {
   size_t Hash() const;
 
  private:
+  class ChangeList;
+
   Query query_;
 
   model::DocumentSet documents_;
   model::DocumentSet old_documents_;
-  std::vector<DocumentViewChange> document_changes_;
+
+  // Logically immutable once the snapshot is created, so that copies of the
+  // snapshot handed to each listener of a query share the list, and the work
+  // of building it, instead of copying it.
+  std::shared_ptr<const ChangeList> document_changes_;
   model::DocumentKeySet mutated_keys_;
 
   bool from_cache_ = false;
@@ -152,6 +152,21 @@ class ArraySortedMap : public SortedMapBase {
       : array_{SortedArray(entries, comparator)}, comparator_{comparator} {
   }
 
+  /**
+   * Creates an ArraySortedMap from a range of at most kFixedSize pairs that are
+   * already sorted by key and contain no duplicate keys.
+   */
+  template <typename Iterator>
+  static ArraySortedMap FromSortedRange(Iterator begin,
+                                        Iterator end,
+                                        const C& comparator) {
+    auto array = std::make_shared<array_type>();
+    for (; begin != end; ++begin) {
+      array->append(value_type{*begin});
+    }
+    return ArraySortedMap{array, comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return size() == 0;
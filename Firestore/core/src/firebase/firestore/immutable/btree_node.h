@@ -0,0 +1,542 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/immutable/btree_node_iterator.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * BTreeNode is a node in a BTreeSortedMap.
+ *
+ * Each node holds between kMinEntries and kMaxEntries sorted entries (the root
+ * may hold fewer) and, unless it is a leaf, one more child than it has
+ * entries. All leaves are at the same depth.
+ *
+ * Nodes are immutable once constructed: mutations copy the nodes along the
+ * path from the root to the affected leaf and share everything else with the
+ * original tree.
+ */
+template <typename K, typename V>
+class BTreeNode : public SortedMapBase {
+ public:
+  using first_type = K;
+  using second_type = V;
+
+  /**
+   * The type of the entries stored in the map.
+   */
+  using value_type = std::pair<K, V>;
+  using pointer = std::shared_ptr<const BTreeNode>;
+  using const_iterator = BTreeNodeIterator<BTreeNode<K, V>>;
+
+  /**
+   * The minimum number of entries in any node other than the root. Wide nodes
+   * keep the tree shallow and the entries of a node contiguous in memory, so
+   * lookups touch far fewer cache lines than in a binary tree.
+   */
+  static constexpr size_type kMinEntries = 16;
+
+  /** The maximum number of entries in any node. */
+  static constexpr size_type kMaxEntries = 2 * kMinEntries;
+
+  BTreeNode(std::vector<value_type> entries, std::vector<pointer> children)
+      : entries_{std::move(entries)}, children_{std::move(children)} {
+    size_ = static_cast<size_type>(entries_.size());
+    for (const pointer& child : children_) {
+      size_ += child->size();
+    }
+  }
+
+  /** Returns true if this node has no children. */
+  bool leaf() const {
+    return children_.empty();
+  }
+
+  /** Returns the number of entries at this node or beneath it in the tree. */
+  size_type size() const {
+    return size_;
+  }
+
+  /** Returns the number of entries held directly by this node. */
+  size_type entry_count() const {
+    return static_cast<size_type>(entries_.size());
+  }
+
+  const value_type& entry(size_type index) const {
+    return entries_[index];
+  }
+
+  /**
+   * Returns the child containing the entries that sort before entry(index).
+   * child(entry_count()) contains the entries that sort after the last entry.
+   */
+  const BTreeNode& child(size_type index) const {
+    return *children_[index];
+  }
+
+  /**
+   * Returns the index of the first entry in this node whose key is not less
+   * than the given key, or entry_count() if there is no such entry.
+   */
+  template <typename Comparator>
+  size_type LowerBoundIndex(const K& key, const Comparator& comparator) const {
+    auto found = std::lower_bound(
+        entries_.begin(), entries_.end(), key,
+        [&comparator](const value_type& entry, const K& key) {
+          return util::Ascending(comparator.Compare(entry.first, key));
+        });
+    return static_cast<size_type>(found - entries_.begin());
+  }
+
+  /**
+   * Returns a tree with the given key-value pair set/updated. The given root
+   * may be null, denoting an empty tree.
+   */
+  template <typename Comparator>
+  static pointer Insert(const pointer& root,
+                        const K& key,
+                        const V& value,
+                        const Comparator& comparator);
+
+  /**
+   * Returns a tree without the given key, which is null if the tree becomes
+   * empty. Returns the given root itself if it does not contain the key.
+   */
+  template <typename Comparator>
+  static pointer Erase(const pointer& root,
+                       const K& key,
+                       const Comparator& comparator);
+
+  /**
+   * Builds a tree from the given range of entries, which must be sorted by key
+   * and free of duplicates, in linear time. Returns null if the range is
+   * empty.
+   */
+  template <typename Iterator>
+  static pointer BuildFromSorted(Iterator begin, Iterator end);
+
+ private:
+  /**
+   * The result of inserting into a node that overflowed: the node was split
+   * in two around `median`, which must be inserted into the parent along with
+   * `right`, the new node holding the entries after the median.
+   */
+  struct Split {
+    value_type median;
+    pointer right;
+  };
+
+  static pointer Make(std::vector<value_type>&& entries,
+                      std::vector<pointer>&& children) {
+    return std::make_shared<const BTreeNode>(std::move(entries),
+                                             std::move(children));
+  }
+
+  /**
+   * Copies the entries of this node, reserving room for `extra` more so that
+   * inserting into the copy does not reallocate.
+   */
+  std::vector<value_type> CopyEntries(size_type extra = 0) const {
+    std::vector<value_type> result;
+    result.reserve(entries_.size() + extra);
+    result.insert(result.end(), entries_.begin(), entries_.end());
+    return result;
+  }
+
+  std::vector<pointer> CopyChildren(size_type extra = 0) const {
+    std::vector<pointer> result;
+    result.reserve(children_.size() + extra);
+    result.insert(result.end(), children_.begin(), children_.end());
+    return result;
+  }
+
+  template <typename Comparator>
+  pointer InnerInsert(const K& key,
+                      const V& value,
+                      const Comparator& comparator,
+                      Split* split) const;
+
+  /**
+   * Returns a copy of this subtree without the given key, or null if the key
+   * is not in this subtree. The result may hold one entry fewer than
+   * kMinEntries; the caller is responsible for rebalancing it.
+   */
+  template <typename Comparator>
+  pointer InnerErase(const K& key, const Comparator& comparator) const;
+
+  /**
+   * Returns a copy of this subtree without its largest entry, which is moved
+   * into `removed`.
+   */
+  pointer EraseMax(value_type* removed) const;
+
+  /**
+   * Restores the minimum entry count of `children[index]` after an erase by
+   * borrowing an entry from one of its siblings or merging with one of them.
+   */
+  static void Rebalance(std::vector<value_type>* entries,
+                        std::vector<pointer>* children,
+                        size_type index);
+
+  std::vector<value_type> entries_;
+  std::vector<pointer> children_;
+  size_type size_ = 0;
+};
+
+// Define external storage for constants:
+template <typename K, typename V>
+constexpr typename BTreeNode<K, V>::size_type BTreeNode<K, V>::kMinEntries;
+template <typename K, typename V>
+constexpr typename BTreeNode<K, V>::size_type BTreeNode<K, V>::kMaxEntries;
+
+template <typename K, typename V>
+template <typename Comparator>
+typename BTreeNode<K, V>::pointer BTreeNode<K, V>::Insert(
+    const pointer& root,
+    const K& key,
+    const V& value,
+    const Comparator& comparator) {
+  if (!root) {
+    std::vector<value_type> entries;
+    entries.emplace_back(key, value);
+    return Make(std::move(entries), {});
+  }
+
+  Split split;
+  pointer result = root->InnerInsert(key, value, comparator, &split);
+  if (!split.right) {
+    return result;
+  }
+
+  // The root itself split, so the tree grows by one level.
+  std::vector<value_type> entries;
+  entries.push_back(std::move(split.median));
+  std::vector<pointer> children;
+  children.push_back(std::move(result));
+  children.push_back(std::move(split.right));
+  return Make(std::move(entries), std::move(children));
+}
+
+template <typename K, typename V>
+template <typename Comparator>
+typename BTreeNode<K, V>::pointer BTreeNode<K, V>::InnerInsert(
+    const K& key,
+    const V& value,
+    const Comparator& comparator,
+    Split* split) const {
+  size_type pos = LowerBoundIndex(key, comparator);
+  std::vector<value_type> entries = CopyEntries(1);
+
+  if (pos < entries.size() &&
+      util::Same(comparator.Compare(key, entries[pos].first))) {
+    entries[pos].second = value;
+    return Make(std::move(entries), CopyChildren());
+  }
+
+  std::vector<pointer> children;
+  if (leaf()) {
+    entries.emplace(entries.begin() + pos, key, value);
+  } else {
+    children = CopyChildren(1);
+    Split child_split;
+    children[pos] =
+        children_[pos]->InnerInsert(key, value, comparator, &child_split);
+    if (child_split.right) {
+      entries.insert(entries.begin() + pos, std::move(child_split.median));
+      children.insert(children.begin() + pos + 1,
+                      std::move(child_split.right));
+    }
+  }
+
+  if (entries.size() <= kMaxEntries) {
+    return Make(std::move(entries), std::move(children));
+  }
+
+  // Split around the median, leaving kMinEntries entries on each side.
+  size_type mid = static_cast<size_type>(entries.size() / 2);
+  std::vector<value_type> right_entries{
+      std::make_move_iterator(entries.begin() + mid + 1),
+      std::make_move_iterator(entries.end())};
+  split->median = std::move(entries[mid]);
+  entries.erase(entries.begin() + mid, entries.end());
+
+  std::vector<pointer> right_children;
+  if (!children.empty()) {
+    right_children.assign(std::make_move_iterator(children.begin() + mid + 1),
+                          std::make_move_iterator(children.end()));
+    children.erase(children.begin() + mid + 1, children.end());
+  }
+
+  split->right = Make(std::move(right_entries), std::move(right_children));
+  return Make(std::move(entries), std::move(children));
+}
+
+template <typename K, typename V>
+template <typename Comparator>
+typename BTreeNode<K, V>::pointer BTreeNode<K, V>::Erase(
+    const pointer& root, const K& key, const Comparator& comparator) {
+  if (!root) {
+    return root;
+  }
+
+  pointer result = root->InnerErase(key, comparator);
+  if (!result) {
+    return root;
+  }
+
+  // The root may shrink to nothing: either the tree is now empty or its only
+  // child becomes the new root.
+  if (result->entries_.empty()) {
+    return result->leaf() ? nullptr : result->children_.front();
+  }
+  return result;
+}
+
+template <typename K, typename V>
+template <typename Comparator>
+typename BTreeNode<K, V>::pointer BTreeNode<K, V>::InnerErase(
+    const K& key, const Comparator& comparator) const {
+  size_type pos = LowerBoundIndex(key, comparator);
+  bool found = pos < entries_.size() &&
+               util::Same(comparator.Compare(key, entries_[pos].first));
+
+  if (leaf()) {
+    if (!found) {
+      return nullptr;
+    }
+    std::vector<value_type> entries = CopyEntries();
+    entries.erase(entries.begin() + pos);
+    return Make(std::move(entries), {});
+  }
+
+  pointer child;
+  value_type predecessor;
+  if (found) {
+    // Replace the entry with its predecessor, the largest entry in the subtree
+    // to its left, and remove that from the subtree instead.
+    child = children_[pos]->EraseMax(&predecessor);
+  } else {
+    child = children_[pos]->InnerErase(key, comparator);
+    if (!child) {
+      return nullptr;
+    }
+  }
+
+  std::vector<value_type> entries = CopyEntries();
+  std::vector<pointer> children = CopyChildren();
+  if (found) {
+    entries[pos] = std::move(predecessor);
+  }
+  children[pos] = std::move(child);
+  Rebalance(&entries, &children, pos);
+  return Make(std::move(entries), std::move(children));
+}
+
+template <typename K, typename V>
+typename BTreeNode<K, V>::pointer BTreeNode<K, V>::EraseMax(
+    value_type* removed) const {
+  std::vector<value_type> entries = CopyEntries();
+  if (leaf()) {
+    *removed = std::move(entries.back());
+    entries.pop_back();
+    return Make(std::move(entries), {});
+  }
+
+  std::vector<pointer> children = CopyChildren();
+  size_type last = static_cast<size_type>(children.size() - 1);
+  children[last] = children_[last]->EraseMax(removed);
+  Rebalance(&entries, &children, last);
+  return Make(std::move(entries), std::move(children));
+}
+
+template <typename K, typename V>
+void BTreeNode<K, V>::Rebalance(std::vector<value_type>* entries,
+                                std::vector<pointer>* children,
+                                size_type index) {
+  std::vector<pointer>& kids = *children;
+  if (kids[index]->entries_.size() >= kMinEntries) {
+    return;
+  }
+
+  if (index > 0 && kids[index - 1]->entries_.size() > kMinEntries) {
+    // Borrow the largest entry of the left sibling by rotating it through the
+    // separating entry in the parent.
+    const BTreeNode& left = *kids[index - 1];
+    const BTreeNode& node = *kids[index];
+
+    std::vector<value_type> left_entries = left.CopyEntries();
+    std::vector<pointer> left_children = left.CopyChildren();
+    std::vector<value_type> node_entries = node.CopyEntries(1);
+    std::vector<pointer> node_children = node.CopyChildren(1);
+
+    node_entries.insert(node_entries.begin(),
+                        std::move((*entries)[index - 1]));
+    (*entries)[index - 1] = std::move(left_entries.back());
+    left_entries.pop_back();
+    if (!left_children.empty()) {
+      node_children.insert(node_children.begin(),
+                           std::move(left_children.back()));
+      left_children.pop_back();
+    }
+
+    kids[index - 1] = Make(std::move(left_entries), std::move(left_children));
+    kids[index] = Make(std::move(node_entries), std::move(node_children));
+
+  } else if (index + 1 < kids.size() &&
+             kids[index + 1]->entries_.size() > kMinEntries) {
+    // Borrow the smallest entry of the right sibling.
+    const BTreeNode& node = *kids[index];
+    const BTreeNode& right = *kids[index + 1];
+
+    std::vector<value_type> node_entries = node.CopyEntries(1);
+    std::vector<pointer> node_children = node.CopyChildren(1);
+    std::vector<value_type> right_entries = right.CopyEntries();
+    std::vector<pointer> right_children = right.CopyChildren();
+
+    node_entries.push_back(std::move((*entries)[index]));
+    (*entries)[index] = std::move(right_entries.front());
+    right_entries.erase(right_entries.begin());
+    if (!right_children.empty()) {
+      node_children.push_back(std::move(right_children.front()));
+      right_children.erase(right_children.begin());
+    }
+
+    kids[index] = Make(std::move(node_entries), std::move(node_children));
+    kids[index + 1] =
+        Make(std::move(right_entries), std::move(right_children));
+
+  } else {
+    // Neither sibling can spare an entry, so merge with one of them. The
+    // sibling holds kMinEntries entries, so the merged node holds at most
+    // kMaxEntries.
+    size_type left_index = index > 0 ? index - 1 : index;
+    const BTreeNode& left = *kids[left_index];
+    const BTreeNode& right = *kids[left_index + 1];
+
+    std::vector<value_type> merged_entries =
+        left.CopyEntries(1 + right.entry_count());
+    merged_entries.push_back(std::move((*entries)[left_index]));
+    merged_entries.insert(merged_entries.end(), right.entries_.begin(),
+                          right.entries_.end());
+
+    std::vector<pointer> merged_children =
+        left.CopyChildren(right.children_.size());
+    merged_children.insert(merged_children.end(), right.children_.begin(),
+                           right.children_.end());
+
+    entries->erase(entries->begin() + left_index);
+    kids[left_index] =
+        Make(std::move(merged_entries), std::move(merged_children));
+    kids.erase(kids.begin() + left_index + 1);
+  }
+}
+
+template <typename K, typename V>
+template <typename Iterator>
+typename BTreeNode<K, V>::pointer BTreeNode<K, V>::BuildFromSorted(
+    Iterator begin, Iterator end) {
+  std::vector<value_type> sorted{begin, end};
+  size_type n = static_cast<size_type>(sorted.size());
+  if (n == 0) {
+    return nullptr;
+  }
+
+  // Split the entries into the fewest leaves that can hold them, with one
+  // entry between each pair of adjacent leaves left over to separate them in
+  // the parent level. Spreading the entries evenly keeps every leaf at or
+  // above kMinEntries whenever there are at least two.
+  size_type leaf_count = (n + 1 + kMaxEntries) / (kMaxEntries + 1);
+  size_type per_leaf = (n - (leaf_count - 1)) / leaf_count;
+  size_type extra = (n - (leaf_count - 1)) % leaf_count;
+
+  std::vector<pointer> nodes;
+  std::vector<value_type> separators;
+  nodes.reserve(leaf_count);
+  separators.reserve(leaf_count - 1);
+
+  auto next = std::make_move_iterator(sorted.begin());
+  for (size_type i = 0; i < leaf_count; ++i) {
+    size_type count = per_leaf + (i < extra ? 1 : 0);
+    std::vector<value_type> entries{next, next + count};
+    next += count;
+    nodes.push_back(Make(std::move(entries), {}));
+    if (i + 1 < leaf_count) {
+      separators.push_back(*next);
+      ++next;
+    }
+  }
+
+  // Group the nodes of each level under parents the same way, until a single
+  // root remains.
+  while (nodes.size() > 1) {
+    size_type node_count = static_cast<size_type>(nodes.size());
+    size_type parent_count =
+        (node_count + kMaxEntries) / (kMaxEntries + 1);
+    size_type per_parent = node_count / parent_count;
+    size_type extra_children = node_count % parent_count;
+
+    std::vector<pointer> parents;
+    std::vector<value_type> parent_separators;
+    parents.reserve(parent_count);
+    parent_separators.reserve(parent_count - 1);
+
+    size_type child = 0;
+    for (size_type i = 0; i < parent_count; ++i) {
+      size_type count = per_parent + (i < extra_children ? 1 : 0);
+      std::vector<value_type> entries{
+          std::make_move_iterator(separators.begin() + child),
+          std::make_move_iterator(separators.begin() + child + count - 1)};
+      std::vector<pointer> children{
+          std::make_move_iterator(nodes.begin() + child),
+          std::make_move_iterator(nodes.begin() + child + count)};
+      parents.push_back(Make(std::move(entries), std::move(children)));
+
+      child += count;
+      if (i + 1 < parent_count) {
+        parent_separators.push_back(std::move(separators[child - 1]));
+      }
+    }
+
+    nodes = std::move(parents);
+    separators = std::move(parent_separators);
+  }
+
+  HARD_ASSERT(separators.empty());
+  return std::move(nodes.front());
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_H_
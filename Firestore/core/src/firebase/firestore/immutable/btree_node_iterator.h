@@ -0,0 +1,254 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
+
+#include <array>
+#include <cstddef>
+#include <iterator>
+
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+/**
+ * A forward iterator for traversing BTreeNodes in key order.
+ *
+ * Like LlrbNodeIterator, this iterator keeps an explicit stack because the
+ * immutable tree has no parent pointers. Every non-root node of a B-tree has
+ * at least BTreeNode::kMinEntries + 1 children, so the depth of the tree is
+ * bounded by a small constant for any size the map can represent. The stack is
+ * therefore a fixed-size array and creating or copying an iterator never
+ * allocates.
+ *
+ * For an underlying tree of size `n`, incrementing an iterator is amortized
+ * `O(1)` and `O(log(n))` in the worst case.
+ *
+ * BTreeNodeIterators compare equal if they point at the same entry of the same
+ * node. Mutations create new trees, so iterators obtained from different
+ * versions of a map do not compare equal.
+ *
+ * Note: BTreeNodeIterator does not extend the lifetime of its underlying tree.
+ */
+template <typename N>
+class BTreeNodeIterator {
+ public:
+  using node_type = N;
+  using key_type = typename node_type::first_type;
+  using size_type = typename node_type::size_type;
+
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = typename node_type::value_type;
+
+  using pointer = typename node_type::value_type const*;
+  using reference = typename node_type::value_type const&;
+  using difference_type = std::ptrdiff_t;
+
+  // Default constructor to conform to the requirements of ForwardIterator
+  BTreeNodeIterator() {
+  }
+
+  /**
+   * Constructs an iterator pointing at the first entry of the tree with the
+   * given root, which may be null.
+   */
+  static BTreeNodeIterator Begin(const node_type* root) {
+    BTreeNodeIterator result;
+    if (root) {
+      result.AccumulateLeft(root);
+    }
+    return result;
+  }
+
+  /**
+   * Constructs an iterator pointing at the end of the iteration sequence.
+   */
+  static BTreeNodeIterator End() {
+    return BTreeNodeIterator{};
+  }
+
+  /**
+   * Constructs an iterator pointing at the last entry of the tree with the
+   * given root, which may be null.
+   */
+  static BTreeNodeIterator Max(const node_type* root) {
+    BTreeNodeIterator result;
+    const node_type* node = root;
+    while (node) {
+      size_type count = node->entry_count();
+      if (node->leaf()) {
+        result.Push(node, count - 1);
+        break;
+      }
+
+      // Frames in interior nodes point at the entry that follows the child
+      // being traversed. Here that is one past the last entry, which the
+      // iterator pops once the last child is exhausted.
+      result.Push(node, count);
+      node = &node->child(count);
+    }
+    return result;
+  }
+
+  /**
+   * Constructs an iterator pointing to the first entry whose key is not less
+   * than the given key, or an equivalent to `End()` if all keys in the tree
+   * are less than the given key.
+   */
+  template <typename C>
+  static BTreeNodeIterator LowerBound(const node_type* root,
+                                      const key_type& key,
+                                      const C& comparator) {
+    BTreeNodeIterator result;
+
+    const node_type* node = root;
+    while (node) {
+      size_type pos = node->LowerBoundIndex(key, comparator);
+      result.Push(node, pos);
+      if (pos < node->entry_count() &&
+          util::Same(comparator.Compare(key, node->entry(pos).first))) {
+        return result;
+      }
+      if (node->leaf()) {
+        break;
+      }
+      node = &node->child(pos);
+    }
+
+    result.PopExhausted();
+    return result;
+  }
+
+  /**
+   * Returns true if this iterator points at the end of the iteration sequence.
+   */
+  bool is_end() const {
+    return depth_ == 0;
+  }
+
+  /**
+   * Returns the address of the entry in the node that this iterator points to.
+   * This can only be called if `end()` is false.
+   */
+  pointer get() const {
+    HARD_ASSERT(!is_end());
+    const Frame& top = frames_[depth_ - 1];
+    return &top.node->entry(top.index);
+  }
+
+  reference operator*() const {
+    return *get();
+  }
+
+  pointer operator->() const {
+    return get();
+  }
+
+  BTreeNodeIterator& operator++() {
+    HARD_ASSERT(!is_end());
+
+    Frame& top = frames_[depth_ - 1];
+    ++top.index;
+    if (top.node->leaf()) {
+      PopExhausted();
+    } else {
+      // The entries of the child following the current entry come next.
+      AccumulateLeft(&top.node->child(top.index));
+    }
+    return *this;
+  }
+
+  BTreeNodeIterator operator++(int /*unused*/) {
+    BTreeNodeIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  friend bool operator==(const BTreeNodeIterator& a,
+                         const BTreeNodeIterator& b) {
+    if (a.is_end() || b.is_end()) {
+      return a.is_end() == b.is_end();
+    }
+    const Frame& left = a.frames_[a.depth_ - 1];
+    const Frame& right = b.frames_[b.depth_ - 1];
+    return left.node == right.node && left.index == right.index;
+  }
+
+  bool operator!=(const BTreeNodeIterator& b) const {
+    return !(*this == b);
+  }
+
+ private:
+  /**
+   * A position in the traversal of a node: the index of the entry the
+   * iterator is at or, in an interior node, of the entry that follows the
+   * child currently being traversed.
+   */
+  struct Frame {
+    const node_type* node;
+    size_type index;
+  };
+
+  // A tree of this depth would hold more entries than size_type can count.
+  static constexpr int kMaxDepth = 16;
+
+  void Push(const node_type* node, size_type index) {
+    HARD_ASSERT(depth_ < kMaxDepth, "B-tree is deeper than expected");
+    frames_[depth_] = Frame{node, index};
+    ++depth_;
+  }
+
+  /** Pushes the path to the left-most entry of the given subtree. */
+  void AccumulateLeft(const node_type* node) {
+    while (true) {
+      Push(node, 0);
+      if (node->leaf()) {
+        break;
+      }
+      node = &node->child(0);
+    }
+  }
+
+  /**
+   * Pops frames that are past the last entry of their node, moving up to the
+   * next entry in the iteration order (if any).
+   */
+  void PopExhausted() {
+    while (depth_ > 0) {
+      const Frame& top = frames_[depth_ - 1];
+      if (top.index < top.node->entry_count()) {
+        break;
+      }
+      --depth_;
+    }
+  }
+
+  std::array<Frame, kMaxDepth> frames_{};
+  int depth_ = 0;
+};
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_BTREE_NODE_ITERATOR_H_
@@ -17,12 +17,15 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_H_
 
+#include <atomic>
+#include <iterator>
 #include <memory>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/llrb_node_iterator.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 
 namespace firebase {
 namespace firestore {
@@ -101,6 +104,32 @@ class LlrbNode : public SortedMapBase {
   template <typename Comparator>
   LlrbNode erase(const K& key, const Comparator& comparator) const;
 
+  /**
+   * Sets/updates the given key-value pair in this tree, modifying any nodes
+   * that are not shared with another tree in place instead of copying them.
+   * Nodes that are shared are copied as by insert(), so other trees never
+   * observe the change.
+   */
+  template <typename Comparator>
+  void insert_in_place(const K& key,
+                       const V& value,
+                       const Comparator& comparator);
+
+  /**
+   * Removes the given key from this tree, modifying unshared nodes in place
+   * as in insert_in_place().
+   */
+  template <typename Comparator>
+  void erase_in_place(const K& key, const Comparator& comparator);
+
+  /**
+   * Returns a tree containing the entries in the given range, which must be
+   * sorted by key and free of duplicates. Runs in linear time, allocating each
+   * node exactly once.
+   */
+  template <typename Iterator>
+  static LlrbNode BuildFromSorted(Iterator begin, Iterator end);
+
   const LlrbNode& min() const {
     const LlrbNode* node = this;
     while (!node->left().empty()) {
@@ -184,6 +213,24 @@ class LlrbNode : public SortedMapBase {
     return LlrbNode{*rep_};
   }
 
+  /**
+   * Returns a node that can be modified in place of this one: this node
+   * itself if `in_place` is true and no other node or tree holds a reference
+   * to it, or a Clone() otherwise.
+   *
+   * The shared empty node always has several owners, so it is never handed
+   * out for modification.
+   */
+  LlrbNode Edit(bool in_place) const {
+    if (in_place && rep_.use_count() == 1) {
+      // Pairs with the release performed when other owners dropped their
+      // references, so their last accesses happen before our writes.
+      std::atomic_thread_fence(std::memory_order_acquire);
+      return LlrbNode{rep_};
+    }
+    return Clone();
+  }
+
   void set_size(size_type size) {
     rep_->size_ = size;
   }
@@ -216,21 +263,44 @@ class LlrbNode : public SortedMapBase {
   template <typename Comparator>
   LlrbNode InnerInsert(const K& key,
                        const V& value,
-                       const Comparator& comparator) const;
+                       const Comparator& comparator,
+                       bool in_place) const;
 
   template <typename Comparator>
-  LlrbNode InnerErase(const K& key, const Comparator& comparator) const;
+  LlrbNode InnerErase(const K& key,
+                      const Comparator& comparator,
+                      bool in_place) const;
 
-  void FixUp();
+  /**
+   * Builds a perfectly balanced, all black tree of `size` nodes (which must be
+   * one less than a power of two), consuming entries from `next`.
+   */
+  template <typename Iterator>
+  static LlrbNode BuildPerfect(Iterator* next, size_type size);
+
+  /**
+   * Builds a node of the given color holding the entry at `next`, with the
+   * given left child and a perfect tree of `right_size` entries following it
+   * as its right child.
+   */
+  template <typename Iterator>
+  static LlrbNode BuildNode(Iterator* next,
+                            Color color,
+                            LlrbNode left,
+                            size_type right_size);
+
+  // The `in_place` arguments below are passed on to Edit() when copying
+  // children.
+  void FixUp(bool in_place);
   void FixRootColor();
 
   void RotateLeft();
   void RotateRight();
-  void FlipColor();
+  void FlipColor(bool in_place);
 
-  void RemoveMin();
-  void MoveRedLeft();
-  void MoveRedRight();
+  void RemoveMin(bool in_place);
+  void MoveRedLeft(bool in_place);
+  void MoveRedRight(bool in_place);
 
   size_type OppositeColor() const noexcept {
     return rep_->color_ == Color::Red ? Color::Black : Color::Red;
@@ -244,16 +314,26 @@ template <typename Comparator>
 LlrbNode<K, V> LlrbNode<K, V>::insert(const K& key,
                                       const V& value,
                                       const Comparator& comparator) const {
-  LlrbNode root = InnerInsert(key, value, comparator);
+  LlrbNode root = InnerInsert(key, value, comparator, /* in_place= */ false);
   root.FixRootColor();
   return root;
 }
 
+template <typename K, typename V>
+template <typename Comparator>
+void LlrbNode<K, V>::insert_in_place(const K& key,
+                                     const V& value,
+                                     const Comparator& comparator) {
+  *this = InnerInsert(key, value, comparator, /* in_place= */ true);
+  FixRootColor();
+}
+
 template <typename K, typename V>
 template <typename Comparator>
 LlrbNode<K, V> LlrbNode<K, V>::InnerInsert(const K& key,
                                            const V& value,
-                                           const Comparator& comparator) const {
+                                           const Comparator& comparator,
+                                           bool in_place) const {
   if (empty()) {
     return LlrbNode{Rep{{key, value}, Color::Red, LlrbNode{}, LlrbNode{}}};
   }
@@ -261,17 +341,19 @@ LlrbNode<K, V> LlrbNode<K, V>::InnerInsert(const K& key,
   // Inserting is going to result in a copy but we can save some allocations by
   // creating the copy once and fixing that up, rather than copying and
   // re-copying the result.
-  LlrbNode result = Clone();
+  LlrbNode result = Edit(in_place);
 
   const K& this_key = this->key();
   util::ComparisonResult cmp = comparator.Compare(this_key, key);
   if (cmp == util::ComparisonResult::Descending) {
-    result.set_left(result.left().InnerInsert(key, value, comparator));
-    result.FixUp();
+    result.set_left(
+        result.left().InnerInsert(key, value, comparator, in_place));
+    result.FixUp(in_place);
 
   } else if (cmp == util::ComparisonResult::Ascending) {
-    result.set_right(result.right().InnerInsert(key, value, comparator));
-    result.FixUp();
+    result.set_right(
+        result.right().InnerInsert(key, value, comparator, in_place));
+    result.FixUp(in_place);
 
   } else {
     // keys are equal so update the value.
@@ -284,27 +366,39 @@ template <typename K, typename V>
 template <typename Comparator>
 LlrbNode<K, V> LlrbNode<K, V>::erase(const K& key,
                                      const Comparator& comparator) const {
-  LlrbNode root = InnerErase(key, comparator);
+  LlrbNode root = InnerErase(key, comparator, /* in_place= */ false);
   root.FixRootColor();
   return root;
 }
 
+template <typename K, typename V>
+template <typename Comparator>
+void LlrbNode<K, V>::erase_in_place(const K& key,
+                                    const Comparator& comparator) {
+  // Rotations move entries out of the nodes being modified, so copy the key
+  // in case it refers to one of them.
+  K target = key;
+  *this = InnerErase(target, comparator, /* in_place= */ true);
+  FixRootColor();
+}
+
 template <typename K, typename V>
 template <typename Comparator>
 LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
-                                          const Comparator& comparator) const {
+                                          const Comparator& comparator,
+                                          bool in_place) const {
   if (empty()) {
     // Empty node already frozen
     return LlrbNode{};
   }
 
-  LlrbNode n = Clone();
+  LlrbNode n = Edit(in_place);
 
   if (util::Ascending(comparator.Compare(key, n.key()))) {
     if (!n.left().empty() && !n.left().red() && !n.left().left().red()) {
-      n.MoveRedLeft();
+      n.MoveRedLeft(in_place);
     }
-    n.set_left(n.left().InnerErase(key, comparator));
+    n.set_left(n.left().InnerErase(key, comparator, in_place));
 
   } else {
     if (n.left().red()) {
@@ -312,7 +406,7 @@ LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
     }
 
     if (!n.right().empty() && !n.right().red() && !n.right().left().red()) {
-      n.MoveRedRight();
+      n.MoveRedRight(in_place);
     }
 
     if (util::Same(comparator.Compare(key, n.key()))) {
@@ -321,23 +415,81 @@ LlrbNode<K, V> LlrbNode<K, V>::InnerErase(const K& key,
 
       } else {
         // Move the minimum node from the right subtree in place of this node.
-        LlrbNode smallest = n.right().min();
-        LlrbNode new_right = n.right().Clone();
-        new_right.RemoveMin();
+        value_type smallest = n.right().min().entry();
+        LlrbNode new_right = n.right().Edit(in_place);
+        new_right.RemoveMin(in_place);
 
-        n.set_entry(smallest.entry());
+        n.set_entry(std::move(smallest));
         n.set_right(std::move(new_right));
       }
     } else {
-      n.set_right(n.right().InnerErase(key, comparator));
+      n.set_right(n.right().InnerErase(key, comparator, in_place));
     }
   }
-  n.FixUp();
+  n.FixUp(in_place);
   return n;
 }
 
 template <typename K, typename V>
-void LlrbNode<K, V>::FixUp() {
+template <typename Iterator>
+LlrbNode<K, V> LlrbNode<K, V>::BuildFromSorted(Iterator begin, Iterator end) {
+  auto size = static_cast<size_type>(std::distance(begin, end));
+
+  // Build the tree as a spine of left links to "pennants": nodes whose right
+  // child is a perfect, all black tree of 2^k - 1 nodes. Writing size + 1 as
+  // 2^length + rest, the spine holds a black pennant with 2^k nodes for each
+  // k < length, plus a red one of the same size just below it if bit k of
+  // rest is set. Red nodes only ever appear as left children, never twice in
+  // a row, and all paths cross the same number of black nodes, so the result
+  // is a valid left-leaning red-black tree. This is the construction from
+  // Hinze's "Constructing Red-Black Trees" (1999).
+  size_type length = 0;
+  while (((size + 1) >> (length + 1)) != 0) {
+    ++length;
+  }
+  size_type rest = (size + 1) - (1u << length);
+
+  // The smallest keys are at the bottom of the spine, so build upwards.
+  LlrbNode spine;
+  Iterator next = begin;
+  for (size_type k = 0; k < length; ++k) {
+    size_type perfect_size = (1u << k) - 1;
+    if ((rest & (1u << k)) != 0) {
+      spine = BuildNode(&next, Color::Red, std::move(spine), perfect_size);
+    }
+    spine = BuildNode(&next, Color::Black, std::move(spine), perfect_size);
+  }
+  HARD_ASSERT(next == end);
+  return spine;
+}
+
+template <typename K, typename V>
+template <typename Iterator>
+LlrbNode<K, V> LlrbNode<K, V>::BuildPerfect(Iterator* next, size_type size) {
+  if (size == 0) {
+    return LlrbNode{};
+  }
+
+  size_type half = size / 2;
+  LlrbNode left = BuildPerfect(next, half);
+  return BuildNode(next, Color::Black, std::move(left), half);
+}
+
+template <typename K, typename V>
+template <typename Iterator>
+LlrbNode<K, V> LlrbNode<K, V>::BuildNode(Iterator* next,
+                                         Color color,
+                                         LlrbNode left,
+                                         size_type right_size) {
+  value_type entry{**next};
+  ++*next;
+  LlrbNode right = BuildPerfect(next, right_size);
+  return LlrbNode{
+      Rep{std::move(entry), color, std::move(left), std::move(right)}};
+}
+
+template <typename K, typename V>
+void LlrbNode<K, V>::FixUp(bool in_place) {
   set_size(left().size() + 1 + right().size());
 
   if (right().red() && !left().red()) {
@@ -347,7 +499,7 @@ void LlrbNode<K, V>::FixUp() {
     RotateRight();
   }
   if (left().red() && right().red()) {
-    FlipColor();
+    FlipColor(in_place);
   }
 }
 
@@ -368,7 +520,7 @@ void LlrbNode<K, V>::FixRootColor() {
 }
 
 template <typename K, typename V>
-void LlrbNode<K, V>::RemoveMin() {
+void LlrbNode<K, V>::RemoveMin(bool in_place) {
   // If the left node is empty then the right node must be empty (because the
   // tree is left-leaning) and this node must be the minimum.
   if (left().empty()) {
@@ -377,33 +529,33 @@ void LlrbNode<K, V>::RemoveMin() {
   }
 
   if (!left().red() && !left().left().red()) {
-    MoveRedLeft();
+    MoveRedLeft(in_place);
   }
 
-  LlrbNode new_left = left().Clone();
-  new_left.RemoveMin();
+  LlrbNode new_left = left().Edit(in_place);
+  new_left.RemoveMin(in_place);
   set_left(std::move(new_left));
-  FixUp();
+  FixUp(in_place);
 }
 
 template <typename K, typename V>
-void LlrbNode<K, V>::MoveRedLeft() {
-  FlipColor();
+void LlrbNode<K, V>::MoveRedLeft(bool in_place) {
+  FlipColor(in_place);
   if (right().left().red()) {
-    LlrbNode new_right = right().Clone();
+    LlrbNode new_right = right().Edit(in_place);
     new_right.RotateRight();
     set_right(std::move(new_right));
     RotateLeft();
-    FlipColor();
+    FlipColor(in_place);
   }
 }
 
 template <typename K, typename V>
-void LlrbNode<K, V>::MoveRedRight() {
-  FlipColor();
+void LlrbNode<K, V>::MoveRedRight(bool in_place) {
+  FlipColor(in_place);
   if (left().left().red()) {
     RotateRight();
-    FlipColor();
+    FlipColor(in_place);
   }
 }
 
@@ -446,11 +598,11 @@ void LlrbNode<K, V>::RotateRight() {
 }
 
 template <typename K, typename V>
-void LlrbNode<K, V>::FlipColor() {
-  LlrbNode new_left = left().Clone();
+void LlrbNode<K, V>::FlipColor(bool in_place) {
+  LlrbNode new_left = left().Edit(in_place);
   new_left.set_color(left().OppositeColor());
 
-  LlrbNode new_right = right().Clone();
+  LlrbNode new_right = right().Edit(in_place);
   new_right.set_color(right().OppositeColor());
 
   // Preserve contents_ and size_
@@ -17,8 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_LLRB_NODE_ITERATOR_H_
 
+#include <algorithm>
+#include <cstddef>
 #include <iterator>
-#include <stack>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
@@ -29,6 +30,54 @@ namespace firestore {
 namespace immutable {
 namespace impl {
 
+/**
+ * The stack of nodes an LlrbNodeIterator keeps, with its capacity inline so
+ * that creating and copying iterators (e.g. the `begin()`/`end()` pairs behind
+ * every `find` and range loop) doesn't allocate.
+ *
+ * A left-leaning red-black tree of `n` nodes is at most `2 * lg(n + 1)` deep,
+ * so `kCapacity` entries cover any tree of fewer than 2^32 nodes.
+ */
+template <typename N>
+class LlrbNodeStack {
+ public:
+  static constexpr size_t kCapacity = 64;
+
+  LlrbNodeStack() = default;
+
+  LlrbNodeStack(const LlrbNodeStack& other) : size_(other.size_) {
+    std::copy_n(other.nodes_, size_, nodes_);
+  }
+
+  LlrbNodeStack& operator=(const LlrbNodeStack& other) {
+    size_ = other.size_;
+    std::copy_n(other.nodes_, size_, nodes_);
+    return *this;
+  }
+
+  bool empty() const {
+    return size_ == 0;
+  }
+
+  const N* top() const {
+    return nodes_[size_ - 1];
+  }
+
+  void push(const N* node) {
+    HARD_ASSERT(size_ < kCapacity, "LlrbNode tree is too deep to iterate");
+    nodes_[size_++] = node;
+  }
+
+  void pop() {
+    --size_;
+  }
+
+ private:
+  // Only the first `size_` entries are initialized.
+  const N* nodes_[kCapacity];
+  size_t size_ = 0;
+};
+
 /**
  * A forward iterator for traversing LlrbNodes. LlrbNodes represent the nodes
  * in a tree implementing a sorted map so iterating with LlrbNodeIterator is
@@ -43,7 +92,7 @@ namespace impl {
  *
  * For an underlying tree of size `n`:
  *
- *   * LlrbNodeIterator uses `O(lg(n))` memory for its stack, and
+ *   * LlrbNodeIterator uses `O(lg(n))` entries of its fixed-size stack, and
  *   * incrementing an iterator is an `O(lg(n))` operation.
  *
  * ## Invalidation and Comparison
@@ -66,7 +115,7 @@ class LlrbNodeIterator {
   using node_type = N;
   using key_type = typename node_type::first_type;
 
-  using stack_type = std::stack<const node_type*>;
+  using stack_type = LlrbNodeStack<node_type>;
 
   using iterator_category = std::forward_iterator_tag;
   using value_type = typename node_type::value_type;
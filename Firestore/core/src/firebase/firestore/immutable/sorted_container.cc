@@ -23,6 +23,7 @@ namespace immutable {
 // Define external storage for constants:
 constexpr SortedContainer::size_type SortedContainer::npos;
 constexpr SortedMapBase::size_type SortedMapBase::kFixedSize;
+constexpr SortedMapBase::size_type SortedMapBase::kMaxTreeSize;
 
 }  // namespace immutable
 }  // namespace firestore
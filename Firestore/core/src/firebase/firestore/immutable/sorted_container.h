@@ -70,6 +70,17 @@ class SortedMapBase : public SortedContainer {
    * but don't expect much gain in real world performance.
    */
   static constexpr size_type kFixedSize = 25;
+
+  /**
+   * The maximum size of a TreeSortedMap within a SortedMap.
+   *
+   * This is the size threshold where we use a B-tree backed sorted map instead
+   * of a binary tree backed sorted map. Below it the LLRB tree's cheaper
+   * mutations win; above it the B-tree's shallow depth and contiguous entries
+   * make lookups and iteration over large maps (e.g. whole collections of
+   * documents) considerably faster and use far fewer allocations.
+   */
+  static constexpr size_type kMaxTreeSize = 512;
 };
 
 }  // namespace immutable
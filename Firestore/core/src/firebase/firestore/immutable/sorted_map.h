@@ -17,9 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_IMMUTABLE_SORTED_MAP_H_
 
+#include <iterator>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/immutable/keys_view.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map_iterator.h"
@@ -45,14 +47,18 @@ class SortedMap : public SortedMapBase {
   using value_type = std::pair<K, V>;
   using array_type = impl::ArraySortedMap<K, V, C>;
   using tree_type = impl::TreeSortedMap<K, V, C>;
+  using btree_type = impl::BTreeSortedMap<K, V, C>;
 
   using const_iterator = impl::SortedMapIterator<
       value_type,
       typename impl::FixedArray<value_type>::const_iterator,
-      typename impl::LlrbNode<K, V>::const_iterator>;
+      typename impl::LlrbNode<K, V>::const_iterator,
+      typename impl::BTreeNode<K, V>::const_iterator>;
 
   using const_key_iterator = util::iterator_first<const_iterator>;
 
+  class Transient;
+
   /**
    * Creates an empty SortedMap.
    */
@@ -68,8 +74,34 @@ class SortedMap : public SortedMapBase {
     if (entries.size() <= kFixedSize) {
       tag_ = Tag::Array;
       new (&array_) array_type{entries, comparator};
-    } else {
+    } else if (entries.size() <= kMaxTreeSize) {
+      tag_ = Tag::Tree;
       new (&tree_) tree_type{tree_type::Create(entries, comparator)};
+    } else {
+      tag_ = Tag::BTree;
+      new (&btree_) btree_type{btree_type::Create(entries, comparator)};
+    }
+  }
+
+  /**
+   * Creates a SortedMap from a range of pairs that are already sorted by key
+   * and contain no duplicate keys, such as the results of a LevelDB scan.
+   *
+   * This runs in linear time and picks the representation for the final size
+   * up front, which is considerably cheaper than inserting the entries one at
+   * a time.
+   */
+  template <typename Iterator>
+  static SortedMap FromSortedRange(Iterator begin,
+                                   Iterator end,
+                                   const C& comparator = {}) {
+    auto size = static_cast<size_type>(std::distance(begin, end));
+    if (size <= kFixedSize) {
+      return SortedMap{array_type::FromSortedRange(begin, end, comparator)};
+    } else if (size <= kMaxTreeSize) {
+      return SortedMap{tree_type::FromSortedRange(begin, end, comparator)};
+    } else {
+      return SortedMap{btree_type::FromSortedRange(begin, end, comparator)};
     }
   }
 
@@ -81,6 +113,9 @@ class SortedMap : public SortedMapBase {
       case Tag::Tree:
         new (&tree_) tree_type{other.tree_};
         break;
+      case Tag::BTree:
+        new (&btree_) btree_type{other.btree_};
+        break;
     }
   }
 
@@ -92,6 +127,9 @@ class SortedMap : public SortedMapBase {
       case Tag::Tree:
         new (&tree_) tree_type{std::move(other.tree_)};
         break;
+      case Tag::BTree:
+        new (&btree_) btree_type{std::move(other.btree_)};
+        break;
     }
   }
 
@@ -103,6 +141,9 @@ class SortedMap : public SortedMapBase {
       case Tag::Tree:
         tree_.~TreeSortedMap();
         break;
+      case Tag::BTree:
+        btree_.~BTreeSortedMap();
+        break;
     }
   }
 
@@ -115,6 +156,9 @@ class SortedMap : public SortedMapBase {
         case Tag::Tree:
           tree_ = other.tree_;
           break;
+        case Tag::BTree:
+          btree_ = other.btree_;
+          break;
       }
     } else {
       this->~SortedMap();
@@ -132,6 +176,9 @@ class SortedMap : public SortedMapBase {
         case Tag::Tree:
           tree_ = std::move(other.tree_);
           break;
+        case Tag::BTree:
+          btree_ = std::move(other.btree_);
+          break;
       }
     } else {
       this->~SortedMap();
@@ -147,6 +194,8 @@ class SortedMap : public SortedMapBase {
         return array_.empty();
       case Tag::Tree:
         return tree_.empty();
+      case Tag::BTree:
+        return btree_.empty();
     }
     UNREACHABLE();
   }
@@ -158,6 +207,8 @@ class SortedMap : public SortedMapBase {
         return array_.size();
       case Tag::Tree:
         return tree_.size();
+      case Tag::BTree:
+        return btree_.size();
     }
     UNREACHABLE();
   }
@@ -168,6 +219,8 @@ class SortedMap : public SortedMapBase {
         return array_.comparator();
       case Tag::Tree:
         return tree_.comparator();
+      case Tag::BTree:
+        return btree_.comparator();
     }
     UNREACHABLE();
   }
@@ -196,7 +249,18 @@ class SortedMap : public SortedMapBase {
           return SortedMap{array_.insert(key, value)};
         }
       case Tag::Tree:
-        return SortedMap{tree_.insert(key, value)};
+        if (tree_.size() >= kMaxTreeSize) {
+          // As above, convert eagerly once the next insertion could push the
+          // tree past its maximum size. The tree is already sorted, so the
+          // B-tree can be built in linear time.
+          btree_type btree = btree_type::FromSortedRange(
+              tree_.begin(), tree_.end(), comparator());
+          return SortedMap{btree.insert(key, value)};
+        } else {
+          return SortedMap{tree_.insert(key, value)};
+        }
+      case Tag::BTree:
+        return SortedMap{btree_.insert(key, value)};
     }
     UNREACHABLE();
   }
@@ -211,13 +275,21 @@ class SortedMap : public SortedMapBase {
     switch (tag_) {
       case Tag::Array:
         return SortedMap{array_.erase(key)};
-      case Tag::Tree:
+      case Tag::Tree: {
         tree_type result = tree_.erase(key);
         if (result.empty()) {
           // Flip back to the array representation for empty arrays.
           return SortedMap{comparator()};
         }
         return SortedMap{std::move(result)};
+      }
+      case Tag::BTree: {
+        btree_type result = btree_.erase(key);
+        if (result.empty()) {
+          return SortedMap{comparator()};
+        }
+        return SortedMap{std::move(result)};
+      }
     }
     UNREACHABLE();
   }
@@ -228,6 +300,8 @@ class SortedMap : public SortedMapBase {
         return array_.contains(key);
       case Tag::Tree:
         return tree_.contains(key);
+      case Tag::BTree:
+        return btree_.contains(key);
     }
     UNREACHABLE();
   }
@@ -245,6 +319,8 @@ class SortedMap : public SortedMapBase {
         return const_iterator(array_.find(key));
       case Tag::Tree:
         return const_iterator{tree_.find(key)};
+      case Tag::BTree:
+        return const_iterator{btree_.find(key)};
     }
     UNREACHABLE();
   }
@@ -261,6 +337,8 @@ class SortedMap : public SortedMapBase {
         return array_.find_index(key);
       case Tag::Tree:
         return tree_.find_index(key);
+      case Tag::BTree:
+        return btree_.find_index(key);
     }
     UNREACHABLE();
   }
@@ -289,6 +367,8 @@ class SortedMap : public SortedMapBase {
         return const_iterator(array_.lower_bound(key));
       case Tag::Tree:
         return const_iterator{tree_.lower_bound(key)};
+      case Tag::BTree:
+        return const_iterator{btree_.lower_bound(key)};
     }
     UNREACHABLE();
   }
@@ -299,6 +379,8 @@ class SortedMap : public SortedMapBase {
         return const_iterator(array_.min());
       case Tag::Tree:
         return const_iterator{tree_.min()};
+      case Tag::BTree:
+        return const_iterator{btree_.min()};
     }
     UNREACHABLE();
   }
@@ -309,6 +391,8 @@ class SortedMap : public SortedMapBase {
         return const_iterator(array_.max());
       case Tag::Tree:
         return const_iterator{tree_.max()};
+      case Tag::BTree:
+        return const_iterator{btree_.max()};
     }
     UNREACHABLE();
   }
@@ -323,6 +407,8 @@ class SortedMap : public SortedMapBase {
         return const_iterator{array_.begin()};
       case Tag::Tree:
         return const_iterator{tree_.begin()};
+      case Tag::BTree:
+        return const_iterator{btree_.begin()};
     }
     UNREACHABLE();
   }
@@ -336,6 +422,8 @@ class SortedMap : public SortedMapBase {
         return const_iterator{array_.end()};
       case Tag::Tree:
         return const_iterator{tree_.end()};
+      case Tag::BTree:
+        return const_iterator{btree_.end()};
     }
     UNREACHABLE();
   }
@@ -375,18 +463,106 @@ class SortedMap : public SortedMapBase {
       : tag_{Tag::Tree}, tree_{std::move(tree)} {
   }
 
+  explicit SortedMap(btree_type&& btree)
+      : tag_{Tag::BTree}, btree_{std::move(btree)} {
+  }
+
   enum class Tag {
     Array,
     Tree,
+    BTree,
   };
 
   Tag tag_;
   union {
     array_type array_;
     tree_type tree_;
+    btree_type btree_;
   };
 };
 
+/**
+ * A mutable builder over a SortedMap, for applying a batch of changes without
+ * paying for a fresh copy of the path to each changed entry.
+ *
+ * Nodes the Transient has created itself are modified in place on later
+ * changes, while nodes still shared with the map it started from (or any
+ * other map) are copied first, so that map is never affected. Once the batch
+ * is done, freeze() returns the result as a regular immutable SortedMap.
+ *
+ * Only the tree representation is modified in place: arrays are small enough
+ * that copying them is cheap, and B-tree nodes already amortize each copy over
+ * many entries.
+ */
+template <typename K, typename V, typename C>
+class SortedMap<K, V, C>::Transient {
+ public:
+  /** Creates a Transient that starts out empty. */
+  Transient() = default;
+
+  /** Creates a Transient that starts out with the contents of `map`. */
+  explicit Transient(SortedMap map) : map_{std::move(map)} {
+  }
+
+  bool empty() const {
+    return map_.empty();
+  }
+
+  size_type size() const {
+    return map_.size();
+  }
+
+  bool contains(const K& key) const {
+    return map_.contains(key);
+  }
+
+  absl::optional<V> get(const K& key) const {
+    return map_.get(key);
+  }
+
+  /** Adds or updates the given key-value pair. */
+  void insert(const K& key, const V& value) {
+    if (map_.tag_ == Tag::Tree) {
+      // The tree is allowed to grow past kMaxTreeSize until freeze() so that
+      // the whole batch can be applied in place.
+      map_.tree_.insert_in_place(key, value);
+    } else {
+      map_ = map_.insert(key, value);
+    }
+  }
+
+  /** Removes the given key, if present. */
+  void erase(const K& key) {
+    if (map_.tag_ == Tag::Tree) {
+      map_.tree_.erase_in_place(key);
+      if (map_.tree_.empty()) {
+        map_ = SortedMap{map_.comparator()};
+      }
+    } else {
+      map_ = map_.erase(key);
+    }
+  }
+
+  /**
+   * Returns the edited map. The Transient must not be used afterwards.
+   */
+  SortedMap freeze() && {
+    if (map_.tag_ == Tag::Tree && map_.tree_.size() > kMaxTreeSize) {
+      const tree_type& tree = map_.tree_;
+      return SortedMap{
+          btree_type::FromSortedRange(tree.begin(), tree.end(), comparator())};
+    }
+    return std::move(map_);
+  }
+
+ private:
+  const C& comparator() const {
+    return map_.comparator();
+  }
+
+  SortedMap map_;
+};
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
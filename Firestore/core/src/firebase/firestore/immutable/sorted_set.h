@@ -19,6 +19,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
@@ -42,6 +43,8 @@ class SortedSet : public SortedContainer {
 
   using const_iterator = typename map_type::const_key_iterator;
 
+  class Transient;
+
   explicit SortedSet(const C& comparator = C()) : map_{comparator} {
   }
 
@@ -53,9 +56,27 @@ class SortedSet : public SortedContainer {
 
   SortedSet(std::initializer_list<value_type> entries, const C& comparator = {})
       : map_{comparator} {
+    typename map_type::Transient map{std::move(map_)};
     for (auto&& value : entries) {
-      map_ = map_.insert(value, {});
+      map.insert(value, {});
     }
+    map_ = std::move(map).freeze();
+  }
+
+  /**
+   * Creates a SortedSet from a range of values that are already sorted and
+   * contain no duplicates, in linear time. See SortedMap::FromSortedRange.
+   */
+  template <typename Iterator>
+  static SortedSet FromSortedRange(Iterator begin,
+                                   Iterator end,
+                                   const C& comparator = {}) {
+    std::vector<typename map_type::value_type> entries;
+    for (; begin != end; ++begin) {
+      entries.emplace_back(*begin, util::Empty{});
+    }
+    return SortedSet{map_type::FromSortedRange(entries.begin(), entries.end(),
+                                               comparator)};
   }
 
   bool empty() const {
@@ -84,11 +105,11 @@ class SortedSet : public SortedContainer {
       other_ptr = this;
     }
 
-    auto result = *result_ptr;
+    Transient result{*result_ptr};
     for (const auto& k : *other_ptr) {
-      result = result.insert(k);
+      result.insert(k);
     }
-    return result;
+    return std::move(result).freeze();
   }
 
   ABSL_MUST_USE_RESULT SortedSet erase(const K& key) const {
@@ -156,6 +177,48 @@ class SortedSet : public SortedContainer {
   map_type map_;
 };
 
+/**
+ * A mutable builder over a SortedSet. See SortedMap::Transient.
+ */
+template <typename K, typename C>
+class SortedSet<K, C>::Transient {
+ public:
+  Transient() = default;
+
+  explicit Transient(SortedSet set) : map_{std::move(set.map_)} {
+  }
+
+  bool empty() const {
+    return map_.empty();
+  }
+
+  size_type size() const {
+    return map_.size();
+  }
+
+  bool contains(const K& key) const {
+    return map_.contains(key);
+  }
+
+  void insert(const K& key) {
+    map_.insert(key, {});
+  }
+
+  void erase(const K& key) {
+    map_.erase(key);
+  }
+
+  /**
+   * Returns the edited set. The Transient must not be used afterwards.
+   */
+  SortedSet freeze() && {
+    return SortedSet{std::move(map_).freeze()};
+  }
+
+ private:
+  typename map_type::Transient map_;
+};
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
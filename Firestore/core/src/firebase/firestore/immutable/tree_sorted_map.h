@@ -74,6 +74,18 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return TreeSortedMap{std::move(node), comparator};
   }
 
+  /**
+   * Creates a TreeSortedMap from a range of pairs that are already sorted by
+   * key and contain no duplicate keys. This runs in linear time and allocates
+   * each node once, instead of a path of nodes per insertion.
+   */
+  template <typename Iterator>
+  static TreeSortedMap FromSortedRange(Iterator begin,
+                                       Iterator end,
+                                       const C& comparator) {
+    return TreeSortedMap{node_type::BuildFromSorted(begin, end), comparator};
+  }
+
   /** Returns true if the map contains no elements. */
   bool empty() const {
     return root_.empty();
@@ -116,6 +128,22 @@ class TreeSortedMap : public SortedMapBase, private util::CompressedMember<C> {
     return TreeSortedMap{root_.erase(key, comparator), comparator};
   }
 
+  /**
+   * Adds or updates a key-value pair in this map, modifying nodes that are
+   * not shared with any other map in place.
+   */
+  void insert_in_place(const K& key, const V& value) {
+    root_.insert_in_place(key, value, this->comparator());
+  }
+
+  /**
+   * Removes a key from this map, modifying nodes that are not shared with any
+   * other map in place.
+   */
+  void erase_in_place(const K& key) {
+    root_.erase_in_place(key, this->comparator());
+  }
+
   bool contains(const K& key) const {
     // Inline the tree traversal here to avoid building up the stack required
     // to construct a full iterator.
@@ -0,0 +1,345 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/bundle_loader.h"
+
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/core/target.h"
+#include "Firestore/core/src/firebase/firestore/local/local_store.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/message.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using core::LimitType;
+using core::Query;
+using core::Target;
+using model::DatabaseId;
+using model::Document;
+using model::DocumentKeySet;
+using model::SnapshotVersion;
+using nanopb::MakeStdString;
+using nanopb::Message;
+using nanopb::StringReader;
+using remote::Serializer;
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+const uint64_t kMetadataRecord = 1;
+const uint64_t kNamedQueryRecord = 2;
+const uint64_t kDocumentRecord = 3;
+
+// A varint encodes 7 bits per byte, so 64 bits take at most 10 bytes.
+const size_t kMaxVarintSize = 10;
+
+// The number of documents saved in each transaction. Large enough to amortize
+// the cost of a transaction, small enough to keep the decoded documents of a
+// large bundle from piling up in memory.
+const size_t kDocumentsPerTransaction = 500;
+
+void AppendVarint(std::string* output, uint64_t value) {
+  while (value >= 0x80) {
+    output->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  output->push_back(static_cast<char>(value));
+}
+
+}  // namespace
+
+// BundleBuilder
+
+BundleBuilder::BundleBuilder(const DatabaseId& database_id,
+                             const SnapshotVersion& read_time)
+    : serializer_{database_id} {
+  Message<google_protobuf_Timestamp> metadata;
+  *metadata = Serializer::EncodeVersion(read_time);
+  AppendRecord(kMetadataRecord, MakeStdString(metadata));
+}
+
+void BundleBuilder::AddNamedQuery(const std::string& name,
+                                  const Query& query,
+                                  const SnapshotVersion& read_time) {
+  HARD_ASSERT(!has_documents_,
+              "Named queries must be added before any documents");
+
+  Message<google_firestore_v1_RunQueryRequest> request;
+  // The message takes ownership of the query target's allocations.
+  google_firestore_v1_Target_QueryTarget query_target =
+      serializer_.EncodeQueryTarget(query.ToTarget());
+  request->parent = query_target.parent;
+  request->which_query_type =
+      google_firestore_v1_RunQueryRequest_structured_query_tag;
+  request->query_type.structured_query = query_target.structured_query;
+  request->which_consistency_selector =
+      google_firestore_v1_RunQueryRequest_read_time_tag;
+  request->consistency_selector.read_time =
+      Serializer::EncodeVersion(read_time);
+
+  std::string payload;
+  AppendVarint(&payload, name.size());
+  payload += name;
+  payload += MakeStdString(request);
+  AppendRecord(kNamedQueryRecord, payload);
+}
+
+void BundleBuilder::AddDocument(const Document& document) {
+  has_documents_ = true;
+
+  Message<google_firestore_v1_Document> proto;
+  *proto = serializer_.EncodeDocument(document.key(), document.data());
+  proto->has_update_time = true;
+  proto->update_time = Serializer::EncodeVersion(document.version());
+  AppendRecord(kDocumentRecord, MakeStdString(proto));
+}
+
+void BundleBuilder::AppendRecord(uint64_t type, absl::string_view payload) {
+  AppendVarint(&bundle_, type);
+  AppendVarint(&bundle_, payload.size());
+  bundle_.append(payload.data(), payload.size());
+}
+
+// BundleLoader
+
+BundleLoader::BundleLoader(LocalStore* local_store,
+                           const DatabaseId& database_id)
+    : local_store_{local_store}, serializer_{database_id} {
+}
+
+Status BundleLoader::AddChunk(absl::string_view chunk) {
+  if (!status_.ok()) {
+    return status_;
+  }
+
+  progress_.bytes_loaded += chunk.size();
+  buffer_.append(chunk.data(), chunk.size());
+
+  absl::string_view remaining = buffer_;
+  while (status_.ok()) {
+    absl::string_view record = remaining;
+    uint64_t type = 0;
+    uint64_t length = 0;
+    if (!ReadVarint(&record, &type) || !ReadVarint(&record, &length) ||
+        record.size() < length) {
+      break;
+    }
+
+    ReadRecord(type, record.substr(0, length));
+    remaining = record.substr(length);
+  }
+  buffer_.erase(0, buffer_.size() - remaining.size());
+  return status_;
+}
+
+StatusOr<std::vector<NamedQuery>> BundleLoader::Finish() {
+  if (status_.ok() && !buffer_.empty()) {
+    Fail("Bundle ends in the middle of a record");
+  }
+  if (status_.ok() && !has_metadata_) {
+    Fail("Bundle has no metadata");
+  }
+  if (!status_.ok()) {
+    return status_;
+  }
+
+  SaveDocuments();
+
+  std::vector<NamedQuery> named_queries;
+  for (const QueryResults& results : query_results_) {
+    const NamedQuery& named_query = results.named_query;
+    DocumentKeySet keys = results.keys;
+    for (const Document& doc : results.limited_documents) {
+      keys = keys.insert(doc.key());
+    }
+    local_store_->SaveBundledTarget(named_query.query.ToTarget(), keys,
+                                    named_query.read_time);
+    named_queries.push_back(named_query);
+  }
+  return named_queries;
+}
+
+bool BundleLoader::ReadVarint(absl::string_view* input, uint64_t* value) {
+  uint64_t result = 0;
+  for (size_t i = 0; i < input->size(); ++i) {
+    if (i == kMaxVarintSize) {
+      Fail("Malformed varint in bundle");
+      return false;
+    }
+
+    auto byte = static_cast<uint8_t>((*input)[i]);
+    result |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+    if ((byte & 0x80) == 0) {
+      *value = result;
+      input->remove_prefix(i + 1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void BundleLoader::ReadRecord(uint64_t type, absl::string_view payload) {
+  if (type != kMetadataRecord && !has_metadata_) {
+    Fail("Bundle doesn't start with its metadata");
+    return;
+  }
+
+  switch (type) {
+    case kMetadataRecord:
+      ReadMetadata(payload);
+      break;
+    case kNamedQueryRecord:
+      ReadNamedQuery(payload);
+      break;
+    case kDocumentRecord:
+      ReadDocument(payload);
+      break;
+    default:
+      // Skip records added by later versions of the format.
+      break;
+  }
+}
+
+void BundleLoader::ReadMetadata(absl::string_view payload) {
+  if (has_metadata_) {
+    Fail("Bundle has more than one metadata record");
+    return;
+  }
+
+  StringReader reader{payload};
+  auto metadata = Message<google_protobuf_Timestamp>::TryParse(&reader);
+  read_time_ = Serializer::DecodeVersion(&reader, *metadata);
+  if (!reader.ok()) {
+    status_ = reader.status();
+    return;
+  }
+  has_metadata_ = true;
+}
+
+void BundleLoader::ReadNamedQuery(absl::string_view payload) {
+  if (progress_.documents_loaded > 0 || !pending_documents_.empty()) {
+    Fail("Bundle has a named query after its documents");
+    return;
+  }
+
+  uint64_t name_length = 0;
+  if (!ReadVarint(&payload, &name_length) || payload.size() < name_length) {
+    Fail("Malformed named query in bundle");
+    return;
+  }
+  std::string name{payload.substr(0, name_length)};
+  payload.remove_prefix(name_length);
+
+  StringReader reader{payload};
+  auto request =
+      Message<google_firestore_v1_RunQueryRequest>::TryParse(&reader);
+  if (!reader.ok()) {
+    status_ = reader.status();
+    return;
+  }
+  if (request->which_query_type !=
+          google_firestore_v1_RunQueryRequest_structured_query_tag ||
+      request->which_consistency_selector !=
+          google_firestore_v1_RunQueryRequest_read_time_tag) {
+    Fail(StringFormat("Named query %s has no structured query or read time",
+                      name));
+    return;
+  }
+
+  // A shallow copy: the request still owns the allocations.
+  google_firestore_v1_Target_QueryTarget query_target{};
+  query_target.parent = request->parent;
+  query_target.which_query_type =
+      google_firestore_v1_Target_QueryTarget_structured_query_tag;
+  query_target.structured_query = request->query_type.structured_query;
+
+  Target target = serializer_.DecodeQueryTarget(&reader, query_target);
+  SnapshotVersion read_time = Serializer::DecodeVersion(
+      &reader, request->consistency_selector.read_time);
+  if (!reader.ok()) {
+    status_ = reader.status();
+    return;
+  }
+
+  // Targets only have limits from the front; a query limited to its last
+  // results is sent as the reversed query.
+  LimitType limit_type =
+      target.limit() != Target::kNoLimit ? LimitType::First : LimitType::None;
+  Query query(target.path(), target.collection_group(), target.filters(),
+              target.order_bys(), target.limit(), limit_type,
+              target.start_at(), target.end_at());
+  query_results_.emplace_back(
+      NamedQuery{std::move(name), std::move(query), read_time});
+}
+
+void BundleLoader::ReadDocument(absl::string_view payload) {
+  StringReader reader{payload};
+  auto proto = Message<google_firestore_v1_Document>::TryParse(&reader);
+  Document doc = serializer_.DecodeDocument(&reader, *proto);
+  if (!reader.ok()) {
+    status_ = reader.status();
+    return;
+  }
+
+  for (QueryResults& results : query_results_) {
+    const Query& query = results.named_query.query;
+    if (!query.Matches(doc)) {
+      continue;
+    }
+
+    if (!query.has_limit_to_first()) {
+      results.keys = results.keys.insert(doc.key());
+      continue;
+    }
+
+    results.limited_documents = results.limited_documents.insert(doc);
+    if (results.limited_documents.size() > static_cast<size_t>(query.limit())) {
+      results.limited_documents = results.limited_documents.erase(
+          results.limited_documents.GetLastDocument()->key());
+    }
+  }
+
+  pending_documents_.push_back(std::move(doc));
+  if (pending_documents_.size() >= kDocumentsPerTransaction) {
+    SaveDocuments();
+  }
+}
+
+void BundleLoader::SaveDocuments() {
+  if (pending_documents_.empty()) {
+    return;
+  }
+
+  local_store_->SaveBundledDocuments(pending_documents_, read_time_);
+  progress_.documents_loaded += pending_documents_.size();
+  pending_documents_.clear();
+}
+
+void BundleLoader::Fail(std::string description) {
+  status_ = Status(Error::kDataLoss, std::move(description));
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_BUNDLE_LOADER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_BUNDLE_LOADER_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+class LocalStore;
+
+/**
+ * A query saved in a bundle under a name, along with the time at which its
+ * results were read.
+ */
+struct NamedQuery {
+  std::string name;
+  core::Query query;
+  model::SnapshotVersion read_time;
+};
+
+/** The progress of loading a bundle. */
+struct BundleLoadProgress {
+  size_t documents_loaded = 0;
+  size_t bytes_loaded = 0;
+};
+
+/**
+ * Builds a bundle: documents and the queries they answer, read from the
+ * backend ahead of time so that clients can load them into their cache
+ * without a listen, e.g. from a file served by a CDN.
+ *
+ * A bundle is a sequence of records. Each record starts with its type and the
+ * length of its payload, both encoded as varints, followed by the payload:
+ *
+ *   - a single metadata record, whose payload is a `google.protobuf.Timestamp`
+ *     with the time at which the documents were read;
+ *   - named query records, whose payload is the name, prefixed with its length
+ *     as a varint, followed by a `google.firestore.v1.RunQueryRequest` with the
+ *     query and the time at which its results were read;
+ *   - document records, whose payload is a `google.firestore.v1.Document`.
+ *
+ * The named queries come before the documents so that the loader can tell
+ * which queries a document belongs to as soon as it is read.
+ */
+class BundleBuilder {
+ public:
+  BundleBuilder(const model::DatabaseId& database_id,
+                const model::SnapshotVersion& read_time);
+
+  /** Must be called before any documents are added. */
+  void AddNamedQuery(const std::string& name,
+                     const core::Query& query,
+                     const model::SnapshotVersion& read_time);
+
+  void AddDocument(const model::Document& document);
+
+  const std::string& bundle() const {
+    return bundle_;
+  }
+
+ private:
+  void AppendRecord(uint64_t type, absl::string_view payload);
+
+  remote::Serializer serializer_;
+  std::string bundle_;
+  bool has_documents_ = false;
+};
+
+/**
+ * Decodes a bundle built by `BundleBuilder` as it is received and saves its
+ * contents in the local store: the documents in batches, each in a single
+ * transaction, and then the results of the named queries, so that listening
+ * to any of them starts from the bundled results.
+ *
+ * Must be used on the worker queue.
+ */
+class BundleLoader {
+ public:
+  BundleLoader(LocalStore* local_store, const model::DatabaseId& database_id);
+
+  /**
+   * Decodes the records completed by the given chunk of the bundle and saves
+   * the documents decoded so far once there are enough for a batch. Returns an
+   * error if the bundle is malformed, after which the loader ignores further
+   * chunks.
+   */
+  util::Status AddChunk(absl::string_view chunk);
+
+  /**
+   * Saves the remaining documents and the results of the named queries, and
+   * returns the named queries. Fails if the bundle is incomplete.
+   */
+  util::StatusOr<std::vector<NamedQuery>> Finish();
+
+  const BundleLoadProgress& progress() const {
+    return progress_;
+  }
+
+ private:
+  /** The documents read so far that match a named query. */
+  struct QueryResults {
+    explicit QueryResults(NamedQuery query)
+        : named_query(std::move(query)),
+          limited_documents(named_query.query.Comparator()) {
+    }
+
+    NamedQuery named_query;
+    // The keys of the matching documents, for queries without a limit.
+    model::DocumentKeySet keys;
+    // The first matching documents in query order, for queries with a limit.
+    model::DocumentSet limited_documents;
+  };
+
+  /**
+   * Reads a varint from the front of `input`. Returns false if `input` ends
+   * before the varint does, or if the varint is malformed, in which case the
+   * loader fails.
+   */
+  bool ReadVarint(absl::string_view* input, uint64_t* value);
+
+  void ReadRecord(uint64_t type, absl::string_view payload);
+  void ReadMetadata(absl::string_view payload);
+  void ReadNamedQuery(absl::string_view payload);
+  void ReadDocument(absl::string_view payload);
+
+  void SaveDocuments();
+
+  void Fail(std::string description);
+
+  LocalStore* local_store_ = nullptr;
+  remote::Serializer serializer_;
+
+  util::Status status_;
+  // Bytes received that don't form a complete record yet.
+  std::string buffer_;
+  BundleLoadProgress progress_;
+
+  bool has_metadata_ = false;
+  model::SnapshotVersion read_time_;
+  std::vector<QueryResults> query_results_;
+  std::vector<model::Document> pending_documents_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_BUNDLE_LOADER_H_
@@ -0,0 +1,244 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/cost_based_query_engine.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
+#include "Firestore/core/src/firebase/firestore/local/query_explanation.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using core::FieldFilter;
+using core::Filter;
+using core::Query;
+using model::Document;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::FieldPath;
+using model::ResourcePath;
+using model::SnapshotVersion;
+
+namespace {
+
+/**
+ * The cost of reading a document with a point lookup, relative to reading it
+ * as part of a sequential scan.
+ */
+constexpr double kLookupCost = 2.0;
+
+/** The assumed selectivity of an equality filter on an untracked field. */
+constexpr double kDefaultEqualitySelectivity = 0.1;
+
+/** The assumed selectivity of an inequality filter. */
+constexpr double kRangeSelectivity = 1.0 / 3;
+
+constexpr double kNotApplicable = std::numeric_limits<double>::infinity();
+
+}  // namespace
+
+constexpr size_t CollectionStatistics::kMaxTrackedDistinctValues;
+constexpr size_t CostBasedQueryEngine::kDefaultDocumentCount;
+
+void CollectionStatistics::Update(const DocumentMap& documents) {
+  std::unordered_map<std::string, std::unordered_set<size_t>> value_hashes;
+  for (const auto& kv : documents.underlying_map()) {
+    Document doc(kv.second);
+    for (const auto& field : doc.data().GetInternalValue()) {
+      std::unordered_set<size_t>& hashes = value_hashes[field.first];
+      if (hashes.size() < kMaxTrackedDistinctValues) {
+        hashes.insert(field.second.Hash());
+      }
+    }
+  }
+
+  document_count_ = documents.size();
+  distinct_values_.clear();
+  for (const auto& entry : value_hashes) {
+    distinct_values_[entry.first] = entry.second.size();
+  }
+}
+
+size_t CollectionStatistics::DistinctValues(const FieldPath& field) const {
+  if (field.size() != 1) {
+    return 0;
+  }
+
+  auto found = distinct_values_.find(field.first_segment());
+  return found != distinct_values_.end() ? found->second : 0;
+}
+
+DocumentMap CostBasedQueryEngine::GetDocumentsMatchingQuery(
+    const Query& query,
+    const SnapshotVersion& last_limbo_free_snapshot_version,
+    const DocumentKeySet& remote_keys) {
+  HARD_ASSERT(local_documents_view(), "SetLocalDocumentsView() not called");
+
+  // A document query is a single lookup regardless of the plan.
+  if (query.IsDocumentQuery()) {
+    return ExecuteFullCollectionScan(query);
+  }
+
+  const CollectionStatistics* statistics =
+      query.IsCollectionGroupQuery() ? nullptr : GetStatistics(query.path());
+  double document_count = static_cast<double>(
+      statistics ? statistics->document_count() : kDefaultDocumentCount);
+
+  bool can_reuse_previous_results =
+      !query.MatchesAllDocuments() &&
+      last_limbo_free_snapshot_version != SnapshotVersion::None();
+
+  std::array<std::pair<double, Path>, 3> plans{{
+      {can_reuse_previous_results
+           ? static_cast<double>(remote_keys.size()) * kLookupCost
+           : kNotApplicable,
+       Path::PreviousResults},
+      {query.filters().empty() || query.IsCollectionGroupQuery()
+           ? kNotApplicable
+           : document_count * EstimateSelectivity(query, statistics) *
+                 kLookupCost,
+       Path::IndexScan},
+      {document_count, Path::FullScan},
+  }};
+  std::stable_sort(plans.begin(), plans.end(),
+                   [](const std::pair<double, Path>& lhs,
+                      const std::pair<double, Path>& rhs) {
+                     return lhs.first < rhs.first;
+                   });
+
+  LOG_DEBUG("Estimated costs for query %s: %s=%s, %s=%s, %s=%s",
+            query.ToString(), PathName(plans[0].second), plans[0].first,
+            PathName(plans[1].second), plans[1].first,
+            PathName(plans[2].second), plans[2].first);
+
+  // Try the plans from cheapest to most expensive. The full scan is always
+  // applicable, so this always produces a result.
+  for (const auto& plan : plans) {
+    if (plan.first == kNotApplicable) continue;
+
+    switch (plan.second) {
+      case Path::PreviousResults: {
+        absl::optional<DocumentMap> results = ExecuteUsingPreviousResults(
+            query, last_limbo_free_snapshot_version, remote_keys);
+        if (results) return std::move(*results);
+        break;
+      }
+
+      case Path::IndexScan: {
+        absl::optional<DocumentMap> results = ExecuteIndexScan(query);
+        if (results) return std::move(*results);
+        break;
+      }
+
+      case Path::FullScan:
+        return ExecuteFullScanWithStatistics(query);
+    }
+  }
+  UNREACHABLE();
+}
+
+const CollectionStatistics* CostBasedQueryEngine::GetStatistics(
+    const ResourcePath& collection_path) const {
+  auto found = statistics_.find(collection_path.CanonicalString());
+  return found != statistics_.end() ? &found->second : nullptr;
+}
+
+double CostBasedQueryEngine::EstimateSelectivity(
+    const Query& query, const CollectionStatistics* statistics) const {
+  // Assume filters are independent of each other.
+  double selectivity = 1.0;
+  for (const Filter& filter : query.filters()) {
+    if (!filter.IsAFieldFilter()) continue;
+
+    FieldFilter field_filter(filter);
+    size_t distinct_values =
+        statistics ? statistics->DistinctValues(field_filter.field()) : 0;
+    double equality_selectivity =
+        distinct_values > 0 ? 1.0 / static_cast<double>(distinct_values)
+                            : kDefaultEqualitySelectivity;
+
+    switch (field_filter.op()) {
+      case Filter::Operator::Equal:
+      case Filter::Operator::ArrayContains:
+        selectivity *= equality_selectivity;
+        break;
+
+      case Filter::Operator::In:
+      case Filter::Operator::ArrayContainsAny: {
+        auto value_count =
+            static_cast<double>(field_filter.value().array_value().size());
+        selectivity *= std::min(1.0, value_count * equality_selectivity);
+        break;
+      }
+
+      default:
+        selectivity *= kRangeSelectivity;
+        break;
+    }
+  }
+  return selectivity;
+}
+
+DocumentMap CostBasedQueryEngine::ExecuteFullScanWithStatistics(
+    const Query& query) {
+  if (query.IsCollectionGroupQuery()) {
+    return ExecuteFullCollectionScan(query);
+  }
+
+  LOG_DEBUG("Using full collection scan to execute query: %s",
+            query.ToString());
+  last_path_ = Path::FullScan;
+
+  // Reading the whole collection costs the same as reading the query results,
+  // since the remote document cache has to decode every document anyway.
+  DocumentMap documents = local_documents_view()->GetDocumentsMatchingQuery(
+      Query(query.path()), SnapshotVersion::None());
+  statistics_[query.path().CanonicalString()].Update(documents);
+
+  // The extra reference prevents the unfiltered documents from being
+  // deallocated while iterating over them.
+  DocumentMap results = documents;
+  for (const auto& kv : documents.underlying_map()) {
+    Document doc(kv.second);
+    if (!query.Matches(doc)) {
+      results = results.erase(kv.first);
+    } else if (query.has_projection()) {
+      results = results.insert(kv.first, query.Project(doc));
+    }
+  }
+  return results;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_COST_BASED_QUERY_ENGINE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_COST_BASED_QUERY_ENGINE_H_
+
+#include <string>
+#include <unordered_map>
+
+#include "Firestore/core/src/firebase/firestore/local/index_free_query_engine.h"
+#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace model {
+class ResourcePath;
+}  // namespace model
+
+namespace local {
+
+/**
+ * Rough cardinality estimates for the documents of a collection, gathered
+ * whenever the CostBasedQueryEngine scans the whole collection.
+ */
+class CollectionStatistics {
+ public:
+  /** Replaces the statistics with those of the given documents. */
+  void Update(const model::DocumentMap& documents);
+
+  /** The number of documents in the collection at the last scan. */
+  size_t document_count() const {
+    return document_count_;
+  }
+
+  /**
+   * Returns the approximate number of distinct values of the given field, or
+   * 0 if the field is not tracked. Only top-level fields are tracked, and
+   * counts are capped at `kMaxTrackedDistinctValues`.
+   */
+  size_t DistinctValues(const model::FieldPath& field) const;
+
+  static constexpr size_t kMaxTrackedDistinctValues = 1000;
+
+ private:
+  size_t document_count_ = 0;
+  std::unordered_map<std::string, size_t> distinct_values_;
+};
+
+/**
+ * A query engine that estimates the cost of each way it can execute a query
+ * and picks the cheapest:
+ *
+ * - Re-using previous results (like IndexFreeQueryEngine), which costs one
+ *   document lookup per previously matching document.
+ * - Scanning a field index, which costs one document lookup per estimated
+ *   match.
+ * - Scanning the whole collection, which costs one sequential read per
+ *   document in the collection.
+ *
+ * Estimates are based on CollectionStatistics that are refreshed by every
+ * full collection scan. Collections that have never been scanned are assumed
+ * to hold `kDefaultDocumentCount` documents. Plans that turn out not to be
+ * applicable (e.g. when no field index can serve the query) fall back to the
+ * next cheapest plan.
+ */
+class CostBasedQueryEngine : public IndexFreeQueryEngine {
+ public:
+  model::DocumentMap GetDocumentsMatchingQuery(
+      const core::Query& query,
+      const model::SnapshotVersion& last_limbo_free_snapshot_version,
+      const model::DocumentKeySet& remote_keys) override;
+
+  Type type() const override {
+    return Type::CostBased;
+  }
+
+  /**
+   * Returns the statistics of the collection at the given path, or nullptr if
+   * the collection hasn't been scanned yet.
+   */
+  const CollectionStatistics* GetStatistics(
+      const model::ResourcePath& collection_path) const;
+
+  static constexpr size_t kDefaultDocumentCount = 1000;
+
+ private:
+  double EstimateSelectivity(const core::Query& query,
+                             const CollectionStatistics* statistics) const;
+
+  /**
+   * Scans the whole collection, reading all documents to refresh the
+   * collection's statistics before filtering them.
+   */
+  model::DocumentMap ExecuteFullScanWithStatistics(const core::Query& query);
+
+  std::unordered_map<std::string, CollectionStatistics> statistics_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_COST_BASED_QUERY_ENGINE_H_
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/document_compression.h"
+
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+/** The first byte of every compressed row. */
+constexpr char kCompressedMarker = '\0';
+
+/** The second byte of a compressed row, telling how it was compressed. */
+constexpr char kFormatDeflate = 0;
+constexpr char kFormatDeflateWithDictionary = 1;
+
+constexpr size_t kHeaderSize = 2;
+
+/**
+ * Deflate only looks back this far, so the rest of a larger dictionary would
+ * never be referenced.
+ */
+constexpr size_t kMaxDictionaryBytes = 32 * 1024;
+
+/** Raw deflate streams, since the row header already identifies them. */
+constexpr int kWindowBits = -15;
+
+const Bytef* ToBytes(absl::string_view data) {
+  return reinterpret_cast<const Bytef*>(data.data());
+}
+
+}  // namespace
+
+bool IsCompressedDocumentRow(absl::string_view row) {
+  return row.size() >= kHeaderSize && row[0] == kCompressedMarker;
+}
+
+bool UsesCompressionDictionary(absl::string_view row) {
+  return IsCompressedDocumentRow(row) && row[1] == kFormatDeflateWithDictionary;
+}
+
+absl::optional<std::string> CompressDocumentRow(absl::string_view encoded,
+                                                absl::string_view dictionary) {
+  z_stream stream{};
+  int result = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                            kWindowBits, 8, Z_DEFAULT_STRATEGY);
+  HARD_ASSERT(result == Z_OK, "deflateInit2 failed with code %s", result);
+
+  if (!dictionary.empty()) {
+    result = deflateSetDictionary(&stream, ToBytes(dictionary),
+                                  static_cast<uInt>(dictionary.size()));
+    HARD_ASSERT(result == Z_OK, "deflateSetDictionary failed with code %s",
+                result);
+  }
+
+  std::string row(kHeaderSize + deflateBound(&stream, encoded.size()), '\0');
+  row[0] = kCompressedMarker;
+  row[1] = dictionary.empty() ? kFormatDeflate : kFormatDeflateWithDictionary;
+
+  stream.next_in = const_cast<Bytef*>(ToBytes(encoded));
+  stream.avail_in = static_cast<uInt>(encoded.size());
+  stream.next_out = reinterpret_cast<Bytef*>(&row[kHeaderSize]);
+  stream.avail_out = static_cast<uInt>(row.size() - kHeaderSize);
+  result = deflate(&stream, Z_FINISH);
+  HARD_ASSERT(result == Z_STREAM_END, "deflate failed with code %s", result);
+  row.resize(kHeaderSize + stream.total_out);
+  deflateEnd(&stream);
+
+  if (row.size() >= encoded.size()) {
+    return absl::nullopt;
+  }
+  return row;
+}
+
+StatusOr<std::string> DecompressDocumentRow(absl::string_view row,
+                                            absl::string_view dictionary) {
+  HARD_ASSERT(IsCompressedDocumentRow(row), "Row is not compressed");
+
+  z_stream stream{};
+  int result = inflateInit2(&stream, kWindowBits);
+  HARD_ASSERT(result == Z_OK, "inflateInit2 failed with code %s", result);
+
+  if (UsesCompressionDictionary(row)) {
+    result = inflateSetDictionary(&stream, ToBytes(dictionary),
+                                  static_cast<uInt>(dictionary.size()));
+    if (result != Z_OK) {
+      inflateEnd(&stream);
+      return Status(Error::kDataLoss,
+                    StringFormat("Invalid compression dictionary (code %s)",
+                                 result));
+    }
+  }
+
+  absl::string_view compressed = row.substr(kHeaderSize);
+  stream.next_in = const_cast<Bytef*>(ToBytes(compressed));
+  stream.avail_in = static_cast<uInt>(compressed.size());
+
+  // Documents typically compress to a third of their size or less.
+  std::string encoded(compressed.size() * 4, '\0');
+  do {
+    if (stream.total_out == encoded.size()) {
+      encoded.resize(encoded.size() * 2);
+    }
+    stream.next_out = reinterpret_cast<Bytef*>(&encoded[stream.total_out]);
+    stream.avail_out = static_cast<uInt>(encoded.size() - stream.total_out);
+    result = inflate(&stream, Z_NO_FLUSH);
+  } while (result == Z_OK);
+
+  encoded.resize(stream.total_out);
+  inflateEnd(&stream);
+  if (result != Z_STREAM_END) {
+    return Status(Error::kDataLoss,
+                  StringFormat("Compressed document is corrupt (code %s)",
+                               result));
+  }
+  return encoded;
+}
+
+std::string BuildCompressionDictionary(
+    const std::vector<std::string>& samples) {
+  // Deflate encodes nearer references more cheaply, so the samples written
+  // last, which are the most representative of new documents, go at the end.
+  std::string dictionary;
+  for (const std::string& sample : samples) {
+    dictionary += sample;
+  }
+  if (dictionary.size() > kMaxDictionaryBytes) {
+    dictionary.erase(0, dictionary.size() - kMaxDictionaryBytes);
+  }
+  return dictionary;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
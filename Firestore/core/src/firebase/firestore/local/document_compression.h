@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_COMPRESSION_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_COMPRESSION_H_
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Returns true if `row`, a row of the remote document table, was written by
+ * `CompressDocumentRow`. Compressed rows start with a zero byte, which no
+ * encoded MaybeDocument does, since zero is not a valid protobuf tag.
+ */
+bool IsCompressedDocumentRow(absl::string_view row);
+
+/**
+ * Returns true if the given compressed row needs the dictionary of its
+ * collection to be decompressed.
+ */
+bool UsesCompressionDictionary(absl::string_view row);
+
+/**
+ * Compresses an encoded document with deflate, primed with `dictionary` if
+ * it's not empty. Returns nullopt if compressing doesn't make the row smaller.
+ */
+absl::optional<std::string> CompressDocumentRow(absl::string_view encoded,
+                                                absl::string_view dictionary);
+
+/**
+ * Restores the encoded document from a row written by `CompressDocumentRow`,
+ * given the same dictionary.
+ */
+util::StatusOr<std::string> DecompressDocumentRow(absl::string_view row,
+                                                  absl::string_view dictionary);
+
+/**
+ * Builds a compression dictionary from encoded documents of a collection.
+ * Documents of a collection tend to share their field names and many of their
+ * values, which a dictionary lets deflate reference even in the first bytes
+ * of a small document.
+ */
+std::string BuildCompressionDictionary(const std::vector<std::string>& samples);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_COMPRESSION_H_
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/document_cursor.h"
+
+#include <utility>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::Document;
+using model::DocumentMap;
+
+DocumentMapCursor::DocumentMapCursor(DocumentMap documents)
+    : documents_(std::move(documents)),
+      iter_(documents_.underlying_map().begin()) {
+  UpdateCurrent();
+}
+
+void DocumentMapCursor::Next() {
+  ++iter_;
+  UpdateCurrent();
+}
+
+void DocumentMapCursor::UpdateCurrent() {
+  if (iter_ == documents_.underlying_map().end()) {
+    current_ = absl::nullopt;
+  } else {
+    current_ = Document(iter_->second);
+  }
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
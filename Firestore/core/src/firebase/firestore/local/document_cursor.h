@@ -0,0 +1,74 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_CURSOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_CURSOR_H_
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A pull-based cursor over documents in key order. Documents are produced only
+ * as the cursor advances, so consumers that need just the first few results
+ * can stop without paying for the rest.
+ */
+class DocumentCursor {
+ public:
+  virtual ~DocumentCursor() = default;
+
+  /** Returns true if the cursor is positioned at a document. */
+  virtual bool Valid() const = 0;
+
+  /** Returns the current document. Must only be called while `Valid()`. */
+  virtual const model::Document& document() const = 0;
+
+  /** Advances to the next document. Must only be called while `Valid()`. */
+  virtual void Next() = 0;
+};
+
+/** A `DocumentCursor` over the documents of an already built DocumentMap. */
+class DocumentMapCursor : public DocumentCursor {
+ public:
+  explicit DocumentMapCursor(model::DocumentMap documents);
+
+  bool Valid() const override {
+    return current_.has_value();
+  }
+
+  const model::Document& document() const override {
+    return *current_;
+  }
+
+  void Next() override;
+
+ private:
+  void UpdateCurrent();
+
+  model::DocumentMap documents_;
+  model::MaybeDocumentMap::const_iterator iter_;
+  absl::optional<model::Document> current_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_CURSOR_H_
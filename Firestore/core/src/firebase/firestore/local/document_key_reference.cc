@@ -37,7 +37,7 @@ bool operator==(const DocumentKeyReference& lhs,
 }
 
 size_t DocumentKeyReference::Hash() const {
-  return util::Hash(key_.ToString(), ref_id_);
+  return util::Hash(key_, ref_id_);
 }
 
 std::string DocumentKeyReference::ToString() const {
@@ -0,0 +1,288 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/document_snapshot.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <iterator>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif  // !defined(_WIN32)
+
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using util::Filesystem;
+using util::Path;
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+constexpr uint32_t kMagic = 0x46534453;  // "FSDS"
+constexpr uint32_t kFormatVersion = 1;
+
+constexpr size_t kHeaderSize = 4 + 4 + 8;
+constexpr size_t kFooterSize = 8 + 8 + 4;
+
+uint32_t ReadUint32(const char* data) {
+  const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+  uint32_t result = 0;
+  for (int i = 3; i >= 0; --i) {
+    result = (result << 8) | bytes[i];
+  }
+  return result;
+}
+
+uint64_t ReadUint64(const char* data) {
+  const auto* bytes = reinterpret_cast<const unsigned char*>(data);
+  uint64_t result = 0;
+  for (int i = 7; i >= 0; --i) {
+    result = (result << 8) | bytes[i];
+  }
+  return result;
+}
+
+Status Corrupt(absl::string_view reason) {
+  return Status{Error::kDataLoss,
+                StringFormat("Invalid document snapshot file: %s", reason)};
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<DocumentSnapshot>> DocumentSnapshot::Open(
+    const Path& path) {
+  // The constructor is private, so absl::make_unique can't be used.
+  std::unique_ptr<DocumentSnapshot> snapshot(new DocumentSnapshot());
+
+#if !defined(_WIN32)
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return Status::FromErrno(errno, path.ToUtf8String());
+  }
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0) {
+    Status status = Status::FromErrno(errno, path.ToUtf8String());
+    ::close(fd);
+    return status;
+  }
+
+  size_t size = static_cast<size_t>(info.st_size);
+  if (size < kHeaderSize + kFooterSize) {
+    ::close(fd);
+    return Corrupt("file is truncated");
+  }
+
+  void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+  if (mapping == MAP_FAILED) {
+    return Status::FromErrno(errno, path.ToUtf8String());
+  }
+
+  snapshot->mapping_ = mapping;
+  snapshot->data_ = static_cast<const char*>(mapping);
+  snapshot->data_size_ = size;
+#else
+  // Without mmap, fall back to reading the whole file, which still avoids
+  // decompressing and copying through LevelDB.
+  std::ifstream file{path.native_value(), std::ios::binary};
+  if (!file) {
+    return Status{Error::kNotFound,
+                  StringFormat("File at path '%s' cannot be opened",
+                               path.ToUtf8String())};
+  }
+  snapshot->buffer_.assign(std::istreambuf_iterator<char>(file),
+                           std::istreambuf_iterator<char>());
+  snapshot->data_ = snapshot->buffer_.data();
+  snapshot->data_size_ = snapshot->buffer_.size();
+#endif  // !defined(_WIN32)
+
+  Status status = snapshot->Parse();
+  if (!status.ok()) return status;
+
+  return {std::move(snapshot)};
+}
+
+DocumentSnapshot::~DocumentSnapshot() {
+#if !defined(_WIN32)
+  if (mapping_) {
+    ::munmap(mapping_, data_size_);
+  }
+#endif  // !defined(_WIN32)
+}
+
+Status DocumentSnapshot::Parse() {
+  if (data_size_ < kHeaderSize + kFooterSize) {
+    return Corrupt("file is truncated");
+  }
+  if (ReadUint32(data_) != kMagic ||
+      ReadUint32(data_ + data_size_ - 4) != kMagic) {
+    return Corrupt("bad magic number");
+  }
+  if (ReadUint32(data_ + 4) != kFormatVersion) {
+    return Corrupt("unsupported format version");
+  }
+  generation_ = static_cast<int64_t>(ReadUint64(data_ + 8));
+
+  const char* footer = data_ + data_size_ - kFooterSize;
+  uint64_t count = ReadUint64(footer);
+  uint64_t table_offset = ReadUint64(footer + 8);
+  uint64_t table_end = data_size_ - kFooterSize;
+  if (table_offset < kHeaderSize || table_offset > table_end ||
+      (table_end - table_offset) / 8 != count ||
+      (table_end - table_offset) % 8 != 0) {
+    return Corrupt("bad offsets table");
+  }
+
+  // Check that every entry lies between its offset and the next one, so that
+  // key() and value() can't read outside of the file.
+  offsets_.reserve(static_cast<size_t>(count));
+  uint64_t entry_start = kHeaderSize;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t offset = ReadUint64(data_ + table_offset + i * 8);
+    if (offset != entry_start || table_offset - offset < 4) {
+      return Corrupt("bad entry offset");
+    }
+    uint64_t key_size = ReadUint32(data_ + offset);
+    uint64_t value_offset = offset + 4 + key_size;
+    if (value_offset > table_offset || table_offset - value_offset < 4) {
+      return Corrupt("bad entry key");
+    }
+    uint64_t value_size = ReadUint32(data_ + value_offset);
+    entry_start = value_offset + 4 + value_size;
+    if (entry_start > table_offset) {
+      return Corrupt("bad entry value");
+    }
+    offsets_.push_back(offset);
+  }
+  if (entry_start != table_offset) {
+    return Corrupt("unexpected data after entries");
+  }
+
+  return Status::OK();
+}
+
+absl::string_view DocumentSnapshot::key(size_t index) const {
+  HARD_ASSERT(index < offsets_.size(), "Snapshot index out of range");
+  const char* entry = data_ + offsets_[index];
+  return absl::string_view{entry + 4, ReadUint32(entry)};
+}
+
+absl::string_view DocumentSnapshot::value(size_t index) const {
+  HARD_ASSERT(index < offsets_.size(), "Snapshot index out of range");
+  const char* entry = data_ + offsets_[index];
+  const char* value = entry + 4 + ReadUint32(entry);
+  return absl::string_view{value + 4, ReadUint32(value)};
+}
+
+size_t DocumentSnapshot::LowerBound(absl::string_view key) const {
+  size_t low = 0;
+  size_t high = offsets_.size();
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (this->key(mid) < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+DocumentSnapshotWriter::DocumentSnapshotWriter(Path path, int64_t generation)
+    : path_(std::move(path)),
+      temp_path_(Path::FromUtf8(path_.ToUtf8String() + ".tmp")),
+      file_(temp_path_.native_value(),
+            std::ios::binary | std::ios::out | std::ios::trunc) {
+  WriteUint32(kMagic);
+  WriteUint32(kFormatVersion);
+  WriteUint64(static_cast<uint64_t>(generation));
+}
+
+void DocumentSnapshotWriter::Add(absl::string_view key,
+                                 absl::string_view value) {
+  HARD_ASSERT(offsets_.empty() || last_key_ < key,
+              "Snapshot entries must be added in increasing key order");
+  offsets_.push_back(offset_);
+  last_key_ = std::string{key};
+
+  WriteUint32(static_cast<uint32_t>(key.size()));
+  WriteBytes(key);
+  WriteUint32(static_cast<uint32_t>(value.size()));
+  WriteBytes(value);
+}
+
+Status DocumentSnapshotWriter::Finish() {
+  uint64_t table_offset = offset_;
+  for (uint64_t offset : offsets_) {
+    WriteUint64(offset);
+  }
+  WriteUint64(offsets_.size());
+  WriteUint64(table_offset);
+  WriteUint32(kMagic);
+
+  file_.close();
+  if (!file_) {
+    Filesystem::Default()->RemoveFile(temp_path_);
+    return Status{Error::kInternal,
+                  StringFormat("Failed to write document snapshot to %s",
+                               temp_path_.ToUtf8String())};
+  }
+
+  return Filesystem::Default()->Rename(temp_path_, path_);
+}
+
+void DocumentSnapshotWriter::WriteUint32(uint32_t value) {
+  char bytes[4];
+  for (char& byte : bytes) {
+    byte = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  WriteBytes(absl::string_view{bytes, sizeof(bytes)});
+}
+
+void DocumentSnapshotWriter::WriteUint64(uint64_t value) {
+  char bytes[8];
+  for (char& byte : bytes) {
+    byte = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  WriteBytes(absl::string_view{bytes, sizeof(bytes)});
+}
+
+void DocumentSnapshotWriter::WriteBytes(absl::string_view bytes) {
+  file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+  offset_ += bytes.size();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_SNAPSHOT_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_SNAPSHOT_H_
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A read-only, memory-mapped file of sorted key/value entries, used as a
+ * read-optimized copy of the remote document cache.
+ *
+ * Entries are stored uncompressed and contiguously, so a range scan touches
+ * only the pages it reads and never copies keys or values: `key()` and
+ * `value()` point directly into the mapped file and remain valid for the
+ * lifetime of the DocumentSnapshot.
+ *
+ * Each file records the generation it was built at. The owner decides which
+ * changes made after that generation must be read from elsewhere.
+ *
+ * File layout (all integers little-endian):
+ *
+ *   header:  magic (u32), format version (u32), generation (i64)
+ *   entries: key size (u32), key bytes, value size (u32), value bytes
+ *   offsets: the offset of each entry (u64), in key order
+ *   footer:  entry count (u64), offset of the offsets table (u64), magic (u32)
+ */
+class DocumentSnapshot {
+ public:
+  /**
+   * Opens and validates the snapshot file at the given path. Returns an error
+   * if the file doesn't exist or isn't a complete snapshot file.
+   */
+  static util::StatusOr<std::unique_ptr<DocumentSnapshot>> Open(
+      const util::Path& path);
+
+  ~DocumentSnapshot();
+
+  DocumentSnapshot(const DocumentSnapshot&) = delete;
+  DocumentSnapshot& operator=(const DocumentSnapshot&) = delete;
+
+  /** The generation the snapshot was built at. */
+  int64_t generation() const {
+    return generation_;
+  }
+
+  /** The number of entries in the snapshot. */
+  size_t size() const {
+    return offsets_.size();
+  }
+
+  absl::string_view key(size_t index) const;
+  absl::string_view value(size_t index) const;
+
+  /**
+   * Returns the index of the first entry whose key is not less than the given
+   * key, or `size()` if there is no such entry.
+   */
+  size_t LowerBound(absl::string_view key) const;
+
+ private:
+  DocumentSnapshot() = default;
+
+  util::Status Parse();
+
+  const char* data_ = nullptr;
+  size_t data_size_ = 0;
+
+  // The mapping of the file, or nullptr if the file was read into `buffer_`
+  // on platforms without mmap.
+  void* mapping_ = nullptr;
+  std::string buffer_;
+
+  int64_t generation_ = 0;
+
+  // The decoded offsets table. Only the table is copied out of the file, so
+  // that lookups don't need to re-validate the offsets they read.
+  std::vector<uint64_t> offsets_;
+};
+
+/**
+ * Writes a DocumentSnapshot file. Entries must be added in strictly increasing
+ * key order.
+ *
+ * The file is written next to its final path and only renamed into place by
+ * Finish(), so a reader never observes a partially written snapshot.
+ */
+class DocumentSnapshotWriter {
+ public:
+  DocumentSnapshotWriter(util::Path path, int64_t generation);
+
+  void Add(absl::string_view key, absl::string_view value);
+
+  /**
+   * Completes the file and atomically replaces any previous snapshot at the
+   * path given to the constructor.
+   */
+  util::Status Finish();
+
+ private:
+  void WriteUint32(uint32_t value);
+  void WriteUint64(uint64_t value);
+  void WriteBytes(absl::string_view bytes);
+
+  util::Path path_;
+  util::Path temp_path_;
+  std::ofstream file_;
+  uint64_t offset_ = 0;
+  std::vector<uint64_t> offsets_;
+  std::string last_key_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_DOCUMENT_SNAPSHOT_H_
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/geohash.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+constexpr char kBase32Alphabet[] = "0123456789bcdefghjkmnpqrstuvwxyz";
+
+constexpr size_t kBitsPerCharacter = 5;
+
+/** The number of bits a geohash of `precision` characters has for longitude. */
+int LongitudeBits(size_t precision) {
+  return static_cast<int>((precision * kBitsPerCharacter + 1) / 2);
+}
+
+/** The number of bits a geohash of `precision` characters has for latitude. */
+int LatitudeBits(size_t precision) {
+  return static_cast<int>(precision * kBitsPerCharacter / 2);
+}
+
+/**
+ * Returns the index of the cell containing `degrees` when the range
+ * [min, min + span] is divided into 2^bits cells. Values outside the range are
+ * clamped to the first or last cell.
+ */
+uint64_t CellIndex(double degrees, double min, double span, int bits) {
+  uint64_t cells = uint64_t{1} << bits;
+  double scaled = (degrees - min) / span * static_cast<double>(cells);
+  if (!(scaled > 0)) {
+    return 0;
+  }
+  if (scaled >= static_cast<double>(cells)) {
+    return cells - 1;
+  }
+  return static_cast<uint64_t>(scaled);
+}
+
+/** Returns the geohash of the cell with the given column and row. */
+std::string EncodeCell(uint64_t longitude_index,
+                       uint64_t latitude_index,
+                       size_t precision) {
+  int longitude_bits = LongitudeBits(precision);
+  int latitude_bits = LatitudeBits(precision);
+
+  std::string result;
+  result.reserve(precision);
+  int character = 0;
+  for (size_t bit = 0; bit < precision * kBitsPerCharacter; ++bit) {
+    uint64_t value = bit % 2 == 0
+                         ? longitude_index >> --longitude_bits
+                         : latitude_index >> --latitude_bits;
+    character = (character << 1) | static_cast<int>(value & 1);
+    if (bit % kBitsPerCharacter == kBitsPerCharacter - 1) {
+      result.push_back(kBase32Alphabet[character]);
+      character = 0;
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+std::string GeohashEncode(const GeoPoint& point, size_t precision) {
+  HARD_ASSERT(precision <= kGeohashPrecision,
+              "Geohash precision %s is too large", precision);
+
+  return EncodeCell(
+      CellIndex(point.longitude(), -180, 360, LongitudeBits(precision)),
+      CellIndex(point.latitude(), -90, 180, LatitudeBits(precision)),
+      precision);
+}
+
+std::vector<std::string> GeohashCoveringCells(const GeoPoint& south_west,
+                                              const GeoPoint& north_east,
+                                              size_t max_cells) {
+  if (south_west.latitude() > north_east.latitude()) {
+    return {};
+  }
+
+  bool wraps = south_west.longitude() > north_east.longitude();
+  for (size_t precision = kGeohashPrecision; precision > 0; --precision) {
+    int longitude_bits = LongitudeBits(precision);
+    int latitude_bits = LatitudeBits(precision);
+
+    uint64_t south =
+        CellIndex(south_west.latitude(), -90, 180, latitude_bits);
+    uint64_t north =
+        CellIndex(north_east.latitude(), -90, 180, latitude_bits);
+    uint64_t rows = north - south + 1;
+
+    // Columns run east from the western edge, wrapping around the
+    // antimeridian if the box crosses it.
+    uint64_t longitude_cells = uint64_t{1} << longitude_bits;
+    uint64_t west =
+        CellIndex(south_west.longitude(), -180, 360, longitude_bits);
+    uint64_t east =
+        CellIndex(north_east.longitude(), -180, 360, longitude_bits);
+    uint64_t columns =
+        wraps ? longitude_cells - west + east + 1 : east - west + 1;
+    columns = std::min(columns, longitude_cells);
+
+    if (rows * columns > max_cells) {
+      continue;
+    }
+
+    std::vector<std::string> cells;
+    cells.reserve(static_cast<size_t>(rows * columns));
+    for (uint64_t column = 0; column < columns; ++column) {
+      uint64_t longitude_index = (west + column) % longitude_cells;
+      for (uint64_t row = south; row <= north; ++row) {
+        cells.push_back(EncodeCell(longitude_index, row, precision));
+      }
+    }
+    return cells;
+  }
+
+  return {""};
+}
+
+bool BoundingBoxContains(const GeoPoint& south_west,
+                         const GeoPoint& north_east,
+                         const GeoPoint& point) {
+  if (point.latitude() < south_west.latitude() ||
+      point.latitude() > north_east.latitude()) {
+    return false;
+  }
+
+  if (south_west.longitude() <= north_east.longitude()) {
+    return point.longitude() >= south_west.longitude() &&
+           point.longitude() <= north_east.longitude();
+  }
+  return point.longitude() >= south_west.longitude() ||
+         point.longitude() <= north_east.longitude();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
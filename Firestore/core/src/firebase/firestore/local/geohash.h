@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_GEOHASH_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_GEOHASH_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/geo_point.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/** The number of characters in the geohashes written to spatial indexes. */
+constexpr size_t kGeohashPrecision = 12;
+
+/**
+ * Returns the geohash of `point` with the given number of characters.
+ *
+ * Each character holds 5 bits that alternately halve the longitude and the
+ * latitude range, starting with longitude, so the points within a cell are
+ * exactly those whose geohashes start with the cell's geohash.
+ */
+std::string GeohashEncode(const GeoPoint& point,
+                          size_t precision = kGeohashPrecision);
+
+/**
+ * Returns the geohashes of cells that together cover the bounding box with the
+ * given corners, at the finest precision that needs no more than `max_cells`
+ * cells. A box whose south-west longitude is greater than its north-east
+ * longitude crosses the antimeridian.
+ *
+ * Returns a single empty geohash (the whole world) if even the coarsest
+ * precision needs too many cells, and no cells if the box is empty.
+ */
+std::vector<std::string> GeohashCoveringCells(const GeoPoint& south_west,
+                                              const GeoPoint& north_east,
+                                              size_t max_cells);
+
+/**
+ * Returns true if `point` lies within the bounding box with the given corners,
+ * with the same conventions as `GeohashCoveringCells`.
+ */
+bool BoundingBoxContains(const GeoPoint& south_west,
+                         const GeoPoint& north_east,
+                         const GeoPoint& point);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_GEOHASH_H_
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/hot_document_cache.h"
+
+#include <algorithm>
+
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+using model::DocumentKeyHash;
+using model::MaybeDocument;
+
+HotDocumentCache::HotDocumentCache(size_t capacity, size_t shard_count) {
+  if (capacity == 0) return;
+
+  shard_count = std::max<size_t>(1, std::min(shard_count, capacity));
+  shard_capacity_ = (capacity + shard_count - 1) / shard_count;
+  for (size_t i = 0; i != shard_count; ++i) {
+    shards_.push_back(absl::make_unique<Shard>());
+  }
+}
+
+absl::optional<MaybeDocument> HotDocumentCache::Get(const DocumentKey& key) {
+  if (shards_.empty()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return absl::nullopt;
+  }
+
+  Shard& shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto found = shard.index.find(key);
+  if (found == shard.index.end()) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return absl::nullopt;
+  }
+
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+  return found->second->document;
+}
+
+void HotDocumentCache::Put(const MaybeDocument& document, size_t byte_size) {
+  if (shards_.empty()) return;
+
+  const DocumentKey& key = document.key();
+  Shard& shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+
+  auto found = shard.index.find(key);
+  if (found != shard.index.end()) {
+    Entry& entry = *found->second;
+    shard.byte_size += byte_size - entry.byte_size;
+    entry.document = document;
+    entry.byte_size = byte_size;
+    shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+    return;
+  }
+
+  shard.entries.emplace_front(key, document, byte_size);
+  shard.index.emplace(key, shard.entries.begin());
+  shard.byte_size += byte_size;
+  if (shard.entries.size() > shard_capacity_) {
+    const Entry& evicted = shard.entries.back();
+    shard.byte_size -= evicted.byte_size;
+    shard.index.erase(evicted.key);
+    shard.entries.pop_back();
+  }
+}
+
+void HotDocumentCache::Invalidate(const DocumentKey& key) {
+  if (shards_.empty()) return;
+
+  Shard& shard = ShardFor(key);
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto found = shard.index.find(key);
+  if (found != shard.index.end()) {
+    shard.byte_size -= found->second->byte_size;
+    shard.entries.erase(found->second);
+    shard.index.erase(found);
+  }
+}
+
+size_t HotDocumentCache::Clear() {
+  size_t released = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    released += shard->byte_size;
+    shard->entries.clear();
+    shard->index.clear();
+    shard->byte_size = 0;
+  }
+  return released;
+}
+
+size_t HotDocumentCache::size() const {
+  size_t result = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    result += shard->entries.size();
+  }
+  return result;
+}
+
+size_t HotDocumentCache::byte_size() const {
+  size_t result = 0;
+  for (const auto& shard : shards_) {
+    std::lock_guard<std::mutex> lock(shard->mutex);
+    result += shard->byte_size;
+  }
+  return result;
+}
+
+HotDocumentCache::Shard& HotDocumentCache::ShardFor(const DocumentKey& key) {
+  size_t hash = DocumentKeyHash{}(key);
+  return *shards_[hash % shards_.size()];
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
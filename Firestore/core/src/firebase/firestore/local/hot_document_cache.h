@@ -0,0 +1,133 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_HOT_DOCUMENT_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_HOT_DOCUMENT_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * A bounded cache of recently read, decoded documents, placed in front of a
+ * persistent remote document cache so that repeated lookups of the same keys
+ * don't have to read and decode them again.
+ *
+ * The cache is split into shards, each with its own lock and least recently
+ * used eviction, so that lookups decoding in parallel rarely contend.
+ *
+ * The owner must invalidate a key whenever the persisted document changes.
+ */
+class HotDocumentCache {
+ public:
+  /**
+   * Creates a cache holding at most `capacity` documents in total, spread over
+   * `shard_count` shards. A capacity of zero disables caching.
+   */
+  explicit HotDocumentCache(size_t capacity, size_t shard_count = 8);
+
+  /**
+   * Returns the cached document for the given key, or nullopt if it is not
+   * cached. Updates the hit and miss counters.
+   */
+  absl::optional<model::MaybeDocument> Get(const model::DocumentKey& key);
+
+  /**
+   * Caches the given document, evicting the shard's least recently used.
+   * `byte_size` is an estimate of the memory the document takes up, such as
+   * the size of its encoding, and only counts towards `byte_size()`.
+   */
+  void Put(const model::MaybeDocument& document, size_t byte_size = 0);
+
+  /** Drops the given key from the cache, if present. */
+  void Invalidate(const model::DocumentKey& key);
+
+  /**
+   * Drops all cached documents and returns their total `byte_size()`. The
+   * counters are not reset.
+   */
+  size_t Clear();
+
+  /** The number of documents currently cached. */
+  size_t size() const;
+
+  /** The sum of the byte sizes given to `Put` of the documents cached. */
+  size_t byte_size() const;
+
+  /** The number of lookups that found a cached document. */
+  int64_t hits() const {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  /** The number of lookups that did not find a cached document. */
+  int64_t misses() const {
+    return misses_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Entry {
+    Entry(model::DocumentKey key,
+          model::MaybeDocument document,
+          size_t byte_size)
+        : key{std::move(key)},
+          document{std::move(document)},
+          byte_size{byte_size} {
+    }
+
+    model::DocumentKey key;
+    model::MaybeDocument document;
+    size_t byte_size = 0;
+  };
+
+  struct Shard {
+    mutable std::mutex mutex;
+
+    // Most recently used first.
+    std::list<Entry> entries;
+    size_t byte_size = 0;
+    std::unordered_map<model::DocumentKey,
+                       std::list<Entry>::iterator,
+                       model::DocumentKeyHash>
+        index;
+  };
+
+  Shard& ShardFor(const model::DocumentKey& key);
+
+  size_t shard_capacity_ = 0;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  std::atomic<int64_t> hits_{0};
+  std::atomic<int64_t> misses_{0};
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_HOT_DOCUMENT_CACHE_H_
@@ -22,6 +22,7 @@
 #include "Firestore/core/src/firebase/firestore/core/target.h"
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
@@ -52,26 +53,39 @@ DocumentMap IndexFreeQueryEngine::GetDocumentsMatchingQuery(
   // It is more efficient to scan all documents in a collection, rather than to
   // perform individual lookups.
   if (query.MatchesAllDocuments()) {
-    return ExecuteFullCollectionScan(query);
+    return ExecuteCollectionQuery(query);
   }
 
   // Queries that have never seen a snapshot without limbo free documents should
   // also be run as a full collection scan.
   if (last_limbo_free_snapshot_version == SnapshotVersion::None()) {
-    return ExecuteFullCollectionScan(query);
+    return ExecuteCollectionQuery(query);
   }
 
+  absl::optional<DocumentMap> results = ExecuteUsingPreviousResults(
+      query, last_limbo_free_snapshot_version, remote_keys);
+  if (results) {
+    return std::move(*results);
+  }
+  return ExecuteCollectionQuery(query);
+}
+
+absl::optional<DocumentMap> IndexFreeQueryEngine::ExecuteUsingPreviousResults(
+    const Query& query,
+    const SnapshotVersion& last_limbo_free_snapshot_version,
+    const DocumentKeySet& remote_keys) {
   MaybeDocumentMap documents = local_documents_view_->GetDocuments(remote_keys);
   DocumentSet previous_results = ApplyQuery(query, documents);
 
   if (query.limit_type() != LimitType::None &&
       NeedsRefill(query.limit_type(), previous_results, remote_keys,
                   last_limbo_free_snapshot_version)) {
-    return ExecuteFullCollectionScan(query);
+    return absl::nullopt;
   }
 
   LOG_DEBUG("Re-using previous result from %s to execute query: %s",
             last_limbo_free_snapshot_version.ToString(), query.ToString());
+  last_path_ = Path::PreviousResults;
 
   // Retrieve all results for documents that were updated since the last
   // remote snapshot that did not contain any Limbo documents.
@@ -100,7 +114,7 @@ DocumentSet IndexFreeQueryEngine::ApplyQuery(
     if (maybe_doc.is_document()) {
       Document doc(maybe_doc);
       if (query.Matches(doc)) {
-        query_results = query_results.insert(std::move(doc));
+        query_results = query_results.insert(query.Project(doc));
       }
     }
   }
@@ -138,10 +152,30 @@ bool IndexFreeQueryEngine::NeedsRefill(
          document_at_limit_edge->version() > limbo_free_snapshot_version;
 }
 
+DocumentMap IndexFreeQueryEngine::ExecuteCollectionQuery(const Query& query) {
+  absl::optional<DocumentMap> indexed_results = ExecuteIndexScan(query);
+  if (indexed_results) {
+    return std::move(*indexed_results);
+  }
+  return ExecuteFullCollectionScan(query);
+}
+
+absl::optional<DocumentMap> IndexFreeQueryEngine::ExecuteIndexScan(
+    const Query& query) {
+  absl::optional<DocumentMap> indexed_results =
+      local_documents_view_->GetDocumentsMatchingQueryFromIndex(query);
+  if (indexed_results) {
+    LOG_DEBUG("Using field index to execute query: %s", query.ToString());
+    last_path_ = Path::IndexScan;
+  }
+  return indexed_results;
+}
+
 DocumentMap IndexFreeQueryEngine::ExecuteFullCollectionScan(
     const Query& query) {
   LOG_DEBUG("Using full collection scan to execute query: %s",
             query.ToString());
+  last_path_ = Path::FullScan;
   return local_documents_view_->GetDocumentsMatchingQuery(
       query, SnapshotVersion::None());
 }
@@ -20,6 +20,7 @@
 #include "Firestore/core/src/firebase/firestore/local/query_engine.h"
 
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -61,6 +62,32 @@ class IndexFreeQueryEngine : public QueryEngine {
     return Type::IndexFree;
   }
 
+ protected:
+  /**
+   * Computes the query results from the documents that matched the query at
+   * `last_limbo_free_snapshot_version` plus the documents that changed since.
+   *
+   * @return The query results, or nullopt if the previous results can't be
+   *     reused because a limit query needs to be refilled.
+   */
+  absl::optional<model::DocumentMap> ExecuteUsingPreviousResults(
+      const core::Query& query,
+      const model::SnapshotVersion& last_limbo_free_snapshot_version,
+      const model::DocumentKeySet& remote_keys);
+
+  /**
+   * Reads the query results via a field index, or returns nullopt if no field
+   * index can serve the query.
+   */
+  absl::optional<model::DocumentMap> ExecuteIndexScan(const core::Query& query);
+
+  /** Reads the query results by scanning all documents in the collection. */
+  model::DocumentMap ExecuteFullCollectionScan(const core::Query& query);
+
+  LocalDocumentsView* local_documents_view() {
+    return local_documents_view_;
+  }
+
  private:
   /** Applies the query filter and sorting to the provided documents. */
   model::DocumentSet ApplyQuery(const core::Query& query,
@@ -84,7 +111,8 @@ class IndexFreeQueryEngine : public QueryEngine {
       const model::DocumentKeySet& remote_keys,
       const model::SnapshotVersion& limbo_free_snapshot_version) const;
 
-  model::DocumentMap ExecuteFullCollectionScan(const core::Query& query);
+  /** Uses a field index if possible, and a full collection scan otherwise. */
+  model::DocumentMap ExecuteCollectionQuery(const core::Query& query);
 
   LocalDocumentsView* local_documents_view_ = nullptr;
 };
@@ -20,10 +20,21 @@
 #include <string>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
+#include "absl/types/optional.h"
+
 namespace firebase {
 namespace firestore {
 
+class GeoPoint;
+
+namespace core {
+class Query;
+}  // namespace core
+
 namespace model {
+class FieldPath;
 class ResourcePath;
 }  // namespace model
 
@@ -32,8 +43,10 @@ namespace local {
 /**
  * Represents a set of indexes that are used to execute queries efficiently.
  *
- * Currently the only index is a [collection id] => [parent path] index, used
- * to execute Collection Group queries.
+ * There is always a [collection id] => [parent path] index, used to execute
+ * Collection Group queries. Additionally, field indexes can be configured per
+ * collection group to answer filtered queries without scanning the whole
+ * collection.
  */
 class IndexManager {
  public:
@@ -58,6 +71,48 @@ class IndexManager {
    */
   virtual std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) = 0;
+
+  /**
+   * Adds a field index definition and indexes all documents that are already
+   * cached in the index's collection group. Adding an index that already
+   * exists is a no-op.
+   */
+  virtual void AddFieldIndex(const model::FieldIndex& index) = 0;
+
+  /** Returns the field indexes configured for the given collection group. */
+  virtual std::vector<model::FieldIndex> GetFieldIndexes(
+      const std::string& collection_id) = 0;
+
+  /**
+   * Returns the keys of the cached documents that may match the given query,
+   * as determined by a field index.
+   *
+   * The result is a superset of the matching remote documents: index entries
+   * are only as precise as their encoding, so callers must still apply the
+   * query to the documents. Local mutations are not reflected in the indexes.
+   *
+   * @return The candidate keys, or nullopt if no configured field index can
+   * serve the query.
+   */
+  virtual absl::optional<model::DocumentKeySet> GetDocumentsMatchingQuery(
+      const core::Query& query) = 0;
+
+  /**
+   * Returns the keys of the cached documents in the given collection whose
+   * GeoPoint `field_path` may lie within the bounding box with the given
+   * corners, as determined by an index whose first segment is a Geohash
+   * segment on the field.
+   *
+   * The result is a superset of the remote documents in the box, since whole
+   * geohash cells are read; callers must still check the exact bounds.
+   *
+   * @return The candidate keys, or nullopt if no such index is configured.
+   */
+  virtual absl::optional<model::DocumentKeySet> GetDocumentsInBoundingBox(
+      const model::ResourcePath& collection_path,
+      const model::FieldPath& field_path,
+      const GeoPoint& south_west,
+      const GeoPoint& north_east) = 0;
 };
 
 }  // namespace local
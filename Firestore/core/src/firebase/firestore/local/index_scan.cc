@@ -0,0 +1,285 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/index_scan.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/geohash.h"
+#include "Firestore/core/src/firebase/firestore/local/index_value_writer.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_util.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using core::FieldFilter;
+using core::Filter;
+using core::OrderBy;
+using core::Query;
+using model::Document;
+using model::FieldIndex;
+using model::FieldValue;
+
+namespace {
+
+using Segment = FieldIndex::Segment;
+
+/**
+ * The maximum number of separate scans a single query may expand to, e.g. due
+ * to `in` filters on several index segments.
+ */
+constexpr size_t kMaxIndexScans = 100;
+
+/**
+ * Returns the encoded values of the first filter that constrains the segment
+ * to discrete values, or nullopt if there's no such filter.
+ */
+absl::optional<std::vector<std::string>> EqualityValues(const Segment& segment,
+                                                        const Query& query) {
+  if (segment.kind() == Segment::Kind::Geohash) {
+    return absl::nullopt;
+  }
+
+  for (const Filter& filter : query.filters()) {
+    if (!filter.IsAFieldFilter() || filter.field() != segment.field_path()) {
+      continue;
+    }
+
+    FieldFilter field_filter(filter);
+    Filter::Operator op = field_filter.op();
+    const FieldValue& value = field_filter.value();
+
+    bool matches_single = segment.kind() == Segment::Kind::Ordered
+                              ? op == Filter::Operator::Equal
+                              : op == Filter::Operator::ArrayContains;
+    bool matches_any = segment.kind() == Segment::Kind::Ordered
+                           ? op == Filter::Operator::In
+                           : op == Filter::Operator::ArrayContainsAny;
+
+    if (matches_single) {
+      return std::vector<std::string>{EncodeIndexValue(value)};
+    } else if (matches_any) {
+      std::vector<std::string> values;
+      for (const FieldValue& element : value.array_value()) {
+        values.push_back(EncodeIndexValue(element));
+      }
+      return values;
+    }
+  }
+  return absl::nullopt;
+}
+
+/**
+ * Narrows the scan to the range of values allowed by the inequality filters on
+ * the given segment.
+ *
+ * Bounds are always inclusive because distinct values may share an encoding;
+ * documents that fail strict bounds are removed when the query is re-applied.
+ *
+ * @return true if any inequality filter constrains the segment.
+ */
+bool AddRangeBounds(const Segment& segment,
+                    const Query& query,
+                    IndexScan* scan) {
+  if (segment.kind() != Segment::Kind::Ordered) {
+    return false;
+  }
+
+  for (const Filter& filter : query.filters()) {
+    if (!filter.IsAFieldFilter() || !filter.IsInequality() ||
+        filter.field() != segment.field_path()) {
+      continue;
+    }
+
+    FieldFilter field_filter(filter);
+    const FieldValue& value = field_filter.value();
+
+    // Inequalities only match values of the same type order group.
+    std::string lower = IndexValueTypeLowerBound(value);
+    std::string upper = IndexValueTypeUpperBound(value);
+    switch (field_filter.op()) {
+      case Filter::Operator::LessThan:
+      case Filter::Operator::LessThanOrEqual:
+        upper = util::ImmediateSuccessor(EncodeIndexValue(value));
+        break;
+      case Filter::Operator::GreaterThan:
+      case Filter::Operator::GreaterThanOrEqual:
+        lower = EncodeIndexValue(value);
+        break;
+      default:
+        HARD_FAIL("Unexpected inequality operator %s", field_filter.op());
+    }
+
+    if (scan->has_range) {
+      scan->range_lower = std::max(scan->range_lower, lower);
+      scan->range_upper = std::min(scan->range_upper, upper);
+    } else {
+      scan->has_range = true;
+      scan->range_lower = std::move(lower);
+      scan->range_upper = std::move(upper);
+    }
+  }
+
+  return scan->has_range;
+}
+
+/**
+ * Returns true if the query only matches documents that have a value for the
+ * given segment, so that the index holds an entry for every matching document
+ * even though the scan doesn't constrain the segment.
+ */
+bool IsCovered(const Segment& segment, const Query& query) {
+  if (segment.kind() == Segment::Kind::Geohash) {
+    return false;
+  }
+
+  for (const Filter& filter : query.filters()) {
+    if (!filter.IsAFieldFilter() || filter.field() != segment.field_path()) {
+      continue;
+    }
+
+    if (segment.kind() == Segment::Kind::Ordered) {
+      return true;
+    }
+
+    Filter::Operator op = FieldFilter(filter).op();
+    if (op == Filter::Operator::ArrayContains ||
+        op == Filter::Operator::ArrayContainsAny) {
+      return true;
+    }
+  }
+
+  if (segment.kind() == Segment::Kind::Ordered) {
+    for (const OrderBy& order_by : query.order_bys()) {
+      if (order_by.field() == segment.field_path()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+absl::optional<IndexScan> PlanIndexScan(const FieldIndex& index,
+                                        const Query& query) {
+  IndexScan scan;
+  const std::vector<Segment>& segments = index.segments();
+
+  size_t i = 0;
+  for (; i < segments.size(); ++i) {
+    absl::optional<std::vector<std::string>> values =
+        EqualityValues(segments[i], query);
+    if (!values) break;
+
+    std::vector<std::vector<std::string>> prefixes;
+    for (const std::vector<std::string>& prefix : scan.prefixes) {
+      for (const std::string& value : *values) {
+        std::vector<std::string> extended = prefix;
+        extended.push_back(value);
+        prefixes.push_back(std::move(extended));
+      }
+    }
+    if (prefixes.size() > kMaxIndexScans) {
+      return absl::nullopt;
+    }
+    scan.prefixes = std::move(prefixes);
+  }
+  scan.equality_segments = i;
+
+  if (i < segments.size() && AddRangeBounds(segments[i], query, &scan)) {
+    ++i;
+  }
+
+  // Scanning an index without constraining it is never cheaper than scanning
+  // the collection.
+  if (scan.Score() == 0) {
+    return absl::nullopt;
+  }
+
+  for (; i < segments.size(); ++i) {
+    if (!IsCovered(segments[i], query)) {
+      return absl::nullopt;
+    }
+  }
+
+  return scan;
+}
+
+absl::optional<IndexScan> PlanBestIndexScan(
+    const std::vector<FieldIndex>& indexes,
+    const Query& query,
+    const FieldIndex** best_index) {
+  absl::optional<IndexScan> best_scan;
+  for (const FieldIndex& index : indexes) {
+    absl::optional<IndexScan> scan = PlanIndexScan(index, query);
+    if (scan && (!best_scan || scan->Score() > best_scan->Score())) {
+      if (best_index) *best_index = &index;
+      best_scan = std::move(scan);
+    }
+  }
+  return best_scan;
+}
+
+std::vector<std::vector<std::string>> EncodeIndexEntries(
+    const FieldIndex& index, const Document& document) {
+  std::vector<std::vector<std::string>> entries{{}};
+
+  for (const Segment& segment : index.segments()) {
+    absl::optional<FieldValue> value = document.field(segment.field_path());
+    if (!value) return {};
+
+    std::set<std::string> encoded_values;
+    if (segment.kind() == Segment::Kind::Ordered) {
+      encoded_values.insert(EncodeIndexValue(*value));
+    } else if (segment.kind() == Segment::Kind::Geohash) {
+      if (value->is_geo_point()) {
+        encoded_values.insert(GeohashEncode(value->geo_point_value()));
+      }
+    } else if (value->is_array()) {
+      for (const FieldValue& element : value->array_value()) {
+        encoded_values.insert(EncodeIndexValue(element));
+      }
+    }
+    if (encoded_values.empty()) return {};
+
+    std::vector<std::vector<std::string>> extended_entries;
+    for (const std::vector<std::string>& entry : entries) {
+      for (const std::string& encoded_value : encoded_values) {
+        std::vector<std::string> extended = entry;
+        extended.push_back(encoded_value);
+        extended_entries.push_back(std::move(extended));
+      }
+    }
+    entries = std::move(extended_entries);
+  }
+
+  return entries;
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_SCAN_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_SCAN_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace core {
+class Query;
+}  // namespace core
+
+namespace model {
+class Document;
+}  // namespace model
+
+namespace local {
+
+/**
+ * The maximum number of geohash cells scanned to cover a bounding box. Fewer,
+ * larger cells mean fewer seeks but more documents outside the box.
+ */
+constexpr size_t kMaxGeohashCells = 16;
+
+/**
+ * Describes how to read the candidate documents of a query from a field index
+ * whose entries are ordered by their encoded values.
+ */
+struct IndexScan {
+  /**
+   * Encoded values of the leading index segments that are constrained by
+   * equality filters. Each entry is scanned separately.
+   */
+  std::vector<std::vector<std::string>> prefixes{{}};
+
+  /**
+   * Whether the segment following the prefix is constrained to the range
+   * [range_lower, range_upper). The bounds are encoded index values.
+   */
+  bool has_range = false;
+  std::string range_lower;
+  std::string range_upper;
+
+  /** The number of segments constrained by equality filters. */
+  size_t equality_segments = 0;
+
+  size_t Score() const {
+    return equality_segments * 2 + (has_range ? 1 : 0);
+  }
+};
+
+/**
+ * Determines how the given index can be used to find the candidate documents
+ * for the query, or returns nullopt if the index can't serve the query.
+ */
+absl::optional<IndexScan> PlanIndexScan(const model::FieldIndex& index,
+                                        const core::Query& query);
+
+/**
+ * Picks the index among `indexes` that constrains the most segments of the
+ * query, and stores it in `best_index` if `best_index` isn't null.
+ */
+absl::optional<IndexScan> PlanBestIndexScan(
+    const std::vector<model::FieldIndex>& indexes,
+    const core::Query& query,
+    const model::FieldIndex** best_index);
+
+/**
+ * Returns the encoded values of each index entry the given index holds for the
+ * document. A document has no entries if it lacks any of the indexed fields,
+ * and more than one entry if it has multiple values in a Contains segment.
+ * Geohash segments hold the geohash itself rather than an encoded index value,
+ * so that cells can be scanned by prefix.
+ */
+std::vector<std::vector<std::string>> EncodeIndexEntries(
+    const model::FieldIndex& index, const model::Document& document);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_SCAN_H_
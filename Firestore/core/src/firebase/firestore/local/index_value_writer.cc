@@ -0,0 +1,252 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/index_value_writer.h"
+
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::FieldValue;
+using nanopb::MakeStringView;
+using util::OrderedCode;
+
+namespace {
+
+/**
+ * Labels written before each value. The labels are ordered like
+ * FieldValue::Type so that values of different types sort in the backend's
+ * type order.
+ *
+ * Labels are spaced out to leave room for types added in the future without
+ * invalidating existing index entries.
+ */
+enum class IndexTypeLabel {
+  /** Terminates arrays, maps, and reference paths. */
+  End = 0,
+
+  /**
+   * Precedes each map key and reference path segment. Must sort after End so
+   * that shorter arrays/maps/paths sort before those they are a prefix of.
+   */
+  Separator = 1,
+
+  Null = 5,
+  Boolean = 10,
+  NaN = 13,
+  Number = 15,
+  Timestamp = 20,
+  String = 25,
+  Blob = 30,
+  Reference = 35,
+  GeoPoint = 40,
+  Array = 45,
+  Object = 50,
+};
+
+constexpr uint64_t kSignBit = 1ULL << 63;
+
+/**
+ * Returns the bits of the given double, transformed so that comparing them as
+ * unsigned integers yields the same order as comparing the doubles.
+ */
+uint64_t SortableDoubleBits(double value) {
+  // -0.0 and 0.0 compare equal, so they should be indexed the same way.
+  if (value == 0.0) {
+    value = 0.0;
+  }
+
+  uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & kSignBit) ? ~bits : bits | kSignBit;
+}
+
+class IndexValueWriter {
+ public:
+  std::string result() && {
+    return std::move(dest_);
+  }
+
+  void WriteValue(const FieldValue& value) {
+    switch (value.type()) {
+      case FieldValue::Type::Null:
+        WriteLabel(IndexTypeLabel::Null);
+        break;
+
+      case FieldValue::Type::Boolean:
+        WriteLabel(IndexTypeLabel::Boolean);
+        OrderedCode::WriteNumIncreasing(&dest_, value.boolean_value() ? 1 : 0);
+        break;
+
+      case FieldValue::Type::Integer:
+        WriteDouble(static_cast<double>(value.integer_value()));
+        break;
+
+      case FieldValue::Type::Double:
+        WriteDouble(value.double_value());
+        break;
+
+      case FieldValue::Type::Timestamp: {
+        Timestamp timestamp = value.timestamp_value();
+        WriteLabel(IndexTypeLabel::Timestamp);
+        OrderedCode::WriteSignedNumIncreasing(&dest_, timestamp.seconds());
+        OrderedCode::WriteSignedNumIncreasing(&dest_, timestamp.nanoseconds());
+        break;
+      }
+
+      case FieldValue::Type::ServerTimestamp:
+        HARD_FAIL("Server timestamps cannot be indexed");
+
+      case FieldValue::Type::String:
+        WriteLabel(IndexTypeLabel::String);
+        OrderedCode::WriteString(&dest_, value.string_value());
+        break;
+
+      case FieldValue::Type::Blob:
+        WriteLabel(IndexTypeLabel::Blob);
+        OrderedCode::WriteString(&dest_, MakeStringView(value.blob_value()));
+        break;
+
+      case FieldValue::Type::Reference: {
+        const FieldValue::Reference& reference = value.reference_value();
+        WriteLabel(IndexTypeLabel::Reference);
+        OrderedCode::WriteString(&dest_, reference.database_id().project_id());
+        OrderedCode::WriteString(&dest_,
+                                 reference.database_id().database_id());
+        for (const std::string& segment : reference.key().path()) {
+          WriteLabel(IndexTypeLabel::Separator);
+          OrderedCode::WriteString(&dest_, segment);
+        }
+        WriteLabel(IndexTypeLabel::End);
+        break;
+      }
+
+      case FieldValue::Type::GeoPoint: {
+        const GeoPoint& geo_point = value.geo_point_value();
+        WriteLabel(IndexTypeLabel::GeoPoint);
+        OrderedCode::WriteNumIncreasing(
+            &dest_, SortableDoubleBits(geo_point.latitude()));
+        OrderedCode::WriteNumIncreasing(
+            &dest_, SortableDoubleBits(geo_point.longitude()));
+        break;
+      }
+
+      case FieldValue::Type::Array:
+        WriteLabel(IndexTypeLabel::Array);
+        for (const FieldValue& element : value.array_value()) {
+          WriteValue(element);
+        }
+        WriteLabel(IndexTypeLabel::End);
+        break;
+
+      case FieldValue::Type::Object:
+        WriteLabel(IndexTypeLabel::Object);
+        for (const auto& entry : value.object_value()) {
+          WriteLabel(IndexTypeLabel::Separator);
+          OrderedCode::WriteString(&dest_, entry.first);
+          WriteValue(entry.second);
+        }
+        WriteLabel(IndexTypeLabel::End);
+        break;
+    }
+  }
+
+  void WriteLabel(IndexTypeLabel label) {
+    OrderedCode::WriteSignedNumIncreasing(&dest_, static_cast<int64_t>(label));
+  }
+
+ private:
+  void WriteDouble(double value) {
+    // NaN sorts before all other numbers.
+    if (std::isnan(value)) {
+      WriteLabel(IndexTypeLabel::NaN);
+      return;
+    }
+
+    WriteLabel(IndexTypeLabel::Number);
+    OrderedCode::WriteNumIncreasing(&dest_, SortableDoubleBits(value));
+  }
+
+  std::string dest_;
+};
+
+/** Returns the labels of the first and last types in the value's group. */
+std::pair<IndexTypeLabel, IndexTypeLabel> TypeGroup(const FieldValue& value) {
+  switch (value.type()) {
+    case FieldValue::Type::Null:
+      return {IndexTypeLabel::Null, IndexTypeLabel::Null};
+    case FieldValue::Type::Boolean:
+      return {IndexTypeLabel::Boolean, IndexTypeLabel::Boolean};
+    case FieldValue::Type::Integer:
+    case FieldValue::Type::Double:
+      return {IndexTypeLabel::NaN, IndexTypeLabel::Number};
+    case FieldValue::Type::Timestamp:
+    case FieldValue::Type::ServerTimestamp:
+      return {IndexTypeLabel::Timestamp, IndexTypeLabel::Timestamp};
+    case FieldValue::Type::String:
+      return {IndexTypeLabel::String, IndexTypeLabel::String};
+    case FieldValue::Type::Blob:
+      return {IndexTypeLabel::Blob, IndexTypeLabel::Blob};
+    case FieldValue::Type::Reference:
+      return {IndexTypeLabel::Reference, IndexTypeLabel::Reference};
+    case FieldValue::Type::GeoPoint:
+      return {IndexTypeLabel::GeoPoint, IndexTypeLabel::GeoPoint};
+    case FieldValue::Type::Array:
+      return {IndexTypeLabel::Array, IndexTypeLabel::Array};
+    case FieldValue::Type::Object:
+      return {IndexTypeLabel::Object, IndexTypeLabel::Object};
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
+std::string EncodeIndexValue(const FieldValue& value) {
+  IndexValueWriter writer;
+  writer.WriteValue(value);
+  return std::move(writer).result();
+}
+
+std::string IndexValueTypeLowerBound(const FieldValue& value) {
+  IndexValueWriter writer;
+  writer.WriteLabel(TypeGroup(value).first);
+  return std::move(writer).result();
+}
+
+std::string IndexValueTypeUpperBound(const FieldValue& value) {
+  // All encodings of a type start with its label, so the next label value
+  // sorts after all of them.
+  IndexValueWriter writer;
+  int64_t last_label = static_cast<int64_t>(TypeGroup(value).second);
+  writer.WriteLabel(static_cast<IndexTypeLabel>(last_label + 1));
+  return std::move(writer).result();
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
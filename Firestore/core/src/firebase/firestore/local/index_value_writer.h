@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_VALUE_WRITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_VALUE_WRITER_H_
+
+#include <string>
+
+namespace firebase {
+namespace firestore {
+
+namespace model {
+class FieldValue;
+}  // namespace model
+
+namespace local {
+
+/**
+ * Encodes a FieldValue into a string whose lexicographic (byte-wise) order
+ * matches the order of values defined by FieldValue::CompareTo, for use in
+ * field index entries.
+ *
+ * The encoding is not reversible and may map distinct values to the same
+ * encoding (for example, integers that cannot be represented exactly as a
+ * double collapse onto their nearest double). It never reorders values, so
+ * index scans built on it always return a superset of the matching documents
+ * and callers must re-apply the query to the documents they read.
+ *
+ * Server timestamps never appear in the remote document cache and have no
+ * encoding.
+ */
+std::string EncodeIndexValue(const model::FieldValue& value);
+
+/**
+ * Returns the smallest encoding of any value that is comparable to the given
+ * value (i.e. in the same type order group, such as all numbers).
+ */
+std::string IndexValueTypeLowerBound(const model::FieldValue& value);
+
+/**
+ * Returns an encoding that sorts after the encoding of any value that is
+ * comparable to the given value, but before any value of the following type
+ * order group.
+ */
+std::string IndexValueTypeUpperBound(const model::FieldValue& value);
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_INDEX_VALUE_WRITER_H_
@@ -16,13 +16,24 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_index_manager.h"
 
+#include <algorithm>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/geohash.h"
+#include "Firestore/core/src/firebase/firestore/local/index_scan.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "absl/strings/match.h"
 
@@ -30,7 +41,18 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using core::Query;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::FieldIndex;
+using model::FieldPath;
+using model::MaybeDocument;
 using model::ResourcePath;
+using model::SnapshotVersion;
+
+using Segment = FieldIndex::Segment;
 
 LevelDbIndexManager::LevelDbIndexManager(LevelDbPersistence* db) : db_(db) {
 }
@@ -68,9 +90,224 @@ std::vector<ResourcePath> LevelDbIndexManager::GetCollectionParents(
 
     results.push_back(row_key.parent());
   }
+
+  // Until the index is backfilled, fall back to scanning what it's missing.
+  if (!collection_parents_backfilled_) {
+    collection_parents_backfilled_ =
+        !LevelDbMigrations::AddUnindexedCollectionParents(
+            db_->current_transaction(), collection_id, &results);
+  }
   return results;
 }
 
+void LevelDbIndexManager::AddFieldIndex(const FieldIndex& index) {
+  HARD_ASSERT(!index.segments().empty(),
+              "Field indexes must have at least one segment");
+
+  EnsureFieldIndexesLoaded();
+  std::vector<FieldIndex>& indexes = field_indexes_[index.collection_id()];
+  if (std::find(indexes.begin(), indexes.end(), index) != indexes.end()) {
+    return;
+  }
+
+  std::string empty_buffer;
+  db_->current_transaction()->Put(LevelDbIndexConfigurationKey::Key(index),
+                                  empty_buffer);
+  indexes.push_back(index);
+
+  // Index the documents that are already cached in the collection group.
+  const std::string& collection_id = index.collection_id();
+  for (const ResourcePath& parent : GetCollectionParents(collection_id)) {
+    Query collection_query(parent.Append(collection_id));
+    DocumentMap documents = db_->remote_document_cache()->GetMatching(
+        collection_query, SnapshotVersion::None());
+    for (const auto& kv : documents.underlying_map()) {
+      WriteIndexEntries(index, Document(kv.second));
+    }
+  }
+}
+
+std::vector<FieldIndex> LevelDbIndexManager::GetFieldIndexes(
+    const std::string& collection_id) {
+  EnsureFieldIndexesLoaded();
+  auto found = field_indexes_.find(collection_id);
+  if (found == field_indexes_.end()) {
+    return {};
+  }
+  return found->second;
+}
+
+absl::optional<DocumentKeySet> LevelDbIndexManager::GetDocumentsMatchingQuery(
+    const Query& query) {
+  if (query.IsDocumentQuery() || query.IsCollectionGroupQuery() ||
+      query.filters().empty()) {
+    return absl::nullopt;
+  }
+
+  const ResourcePath& collection_path = query.path();
+  std::vector<FieldIndex> indexes =
+      GetFieldIndexes(collection_path.last_segment());
+
+  const FieldIndex* best_index = nullptr;
+  absl::optional<IndexScan> best_scan =
+      PlanBestIndexScan(indexes, query, &best_index);
+  if (!best_scan) {
+    return absl::nullopt;
+  }
+
+  std::string index_id = best_index->CanonicalId();
+  DocumentKeySet result;
+  LevelDbIndexEntryKey row_key;
+  auto it = db_->current_transaction()->NewIterator();
+
+  for (const std::vector<std::string>& prefix_values : best_scan->prefixes) {
+    std::string prefix = LevelDbIndexEntryKey::KeyPrefix(
+        index_id, collection_path, prefix_values);
+
+    std::string start_key = prefix;
+    if (best_scan->has_range) {
+      std::vector<std::string> start_values = prefix_values;
+      start_values.push_back(best_scan->range_lower);
+      start_key = LevelDbIndexEntryKey::KeyPrefix(index_id, collection_path,
+                                                  start_values);
+    }
+
+    size_t range_index = prefix_values.size();
+    for (it->Seek(start_key); it->Valid(); it->Next()) {
+      // The prefix also matches entries of subcollections of the query's
+      // collection, but those sort after all entries of the collection itself.
+      if (!absl::StartsWith(it->key(), prefix) || !row_key.Decode(it->key()) ||
+          row_key.collection_path() != collection_path) {
+        break;
+      }
+
+      if (best_scan->has_range &&
+          row_key.values()[range_index] >= best_scan->range_upper) {
+        break;
+      }
+
+      DocumentKey key{collection_path.Append(row_key.document_id())};
+      result = result.insert(std::move(key));
+    }
+  }
+
+  return result;
+}
+
+absl::optional<DocumentKeySet> LevelDbIndexManager::GetDocumentsInBoundingBox(
+    const ResourcePath& collection_path,
+    const FieldPath& field_path,
+    const GeoPoint& south_west,
+    const GeoPoint& north_east) {
+  absl::optional<FieldIndex> spatial_index;
+  for (FieldIndex& index : GetFieldIndexes(collection_path.last_segment())) {
+    const Segment& first = index.segments().front();
+    if (first.kind() == Segment::Kind::Geohash &&
+        first.field_path() == field_path) {
+      spatial_index = std::move(index);
+      break;
+    }
+  }
+  if (!spatial_index) {
+    return absl::nullopt;
+  }
+
+  std::string index_id = spatial_index->CanonicalId();
+  std::string collection_prefix =
+      LevelDbIndexEntryKey::KeyPrefix(index_id, collection_path);
+  DocumentKeySet result;
+  LevelDbIndexEntryKey row_key;
+  auto it = db_->current_transaction()->NewIterator();
+
+  // The geohashes in a cell all start with the cell's geohash, and sort just
+  // after it.
+  for (const std::string& cell :
+       GeohashCoveringCells(south_west, north_east, kMaxGeohashCells)) {
+    std::string start_key =
+        LevelDbIndexEntryKey::KeyPrefix(index_id, collection_path, {cell});
+    for (it->Seek(start_key); it->Valid(); it->Next()) {
+      if (!absl::StartsWith(it->key(), collection_prefix) ||
+          !row_key.Decode(it->key()) ||
+          row_key.collection_path() != collection_path ||
+          !absl::StartsWith(row_key.values().front(), cell)) {
+        break;
+      }
+
+      DocumentKey key{collection_path.Append(row_key.document_id())};
+      result = result.insert(std::move(key));
+    }
+  }
+
+  return result;
+}
+
+bool LevelDbIndexManager::HasFieldIndexes(const ResourcePath& collection_path) {
+  EnsureFieldIndexesLoaded();
+  return field_indexes_.find(collection_path.last_segment()) !=
+         field_indexes_.end();
+}
+
+void LevelDbIndexManager::AddIndexEntries(const MaybeDocument& document) {
+  if (!document.is_document()) return;
+
+  Document doc(document);
+  for (const FieldIndex& index :
+       GetFieldIndexes(doc.key().path().PopLast().last_segment())) {
+    WriteIndexEntries(index, doc);
+  }
+}
+
+void LevelDbIndexManager::RemoveIndexEntries(const MaybeDocument& document) {
+  if (!document.is_document()) return;
+
+  Document doc(document);
+  for (const FieldIndex& index :
+       GetFieldIndexes(doc.key().path().PopLast().last_segment())) {
+    DeleteIndexEntries(index, doc);
+  }
+}
+
+void LevelDbIndexManager::EnsureFieldIndexesLoaded() {
+  if (field_indexes_loaded_) return;
+
+  auto it = db_->current_transaction()->NewIterator();
+  std::string prefix = LevelDbIndexConfigurationKey::KeyPrefix();
+  LevelDbIndexConfigurationKey row_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    bool decoded = row_key.Decode(it->key());
+    HARD_ASSERT(decoded, "Invalid index configuration key: %s",
+                DescribeKey(it->key()));
+    field_indexes_[row_key.index().collection_id()].push_back(row_key.index());
+  }
+  field_indexes_loaded_ = true;
+}
+
+void LevelDbIndexManager::WriteIndexEntries(const FieldIndex& index,
+                                            const Document& document) {
+  const ResourcePath& path = document.key().path();
+  std::string index_id = index.CanonicalId();
+  std::string empty_buffer;
+  for (const std::vector<std::string>& values :
+       EncodeIndexEntries(index, document)) {
+    db_->current_transaction()->Put(
+        LevelDbIndexEntryKey::Key(index_id, path.PopLast(), values,
+                                  path.last_segment()),
+        empty_buffer);
+  }
+}
+
+void LevelDbIndexManager::DeleteIndexEntries(const FieldIndex& index,
+                                             const Document& document) {
+  const ResourcePath& path = document.key().path();
+  std::string index_id = index.CanonicalId();
+  for (const std::vector<std::string>& values :
+       EncodeIndexEntries(index, document)) {
+    db_->current_transaction()->Delete(LevelDbIndexEntryKey::Key(
+        index_id, path.PopLast(), values, path.last_segment()));
+  }
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
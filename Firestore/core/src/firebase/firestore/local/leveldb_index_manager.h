@@ -18,10 +18,12 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_INDEX_MANAGER_H_
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
+#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
 
 namespace firebase {
 namespace firestore {
@@ -40,7 +42,49 @@ class LevelDbIndexManager : public IndexManager {
   std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) override;
 
+  void AddFieldIndex(const model::FieldIndex& index) override;
+
+  std::vector<model::FieldIndex> GetFieldIndexes(
+      const std::string& collection_id) override;
+
+  absl::optional<model::DocumentKeySet> GetDocumentsMatchingQuery(
+      const core::Query& query) override;
+
+  absl::optional<model::DocumentKeySet> GetDocumentsInBoundingBox(
+      const model::ResourcePath& collection_path,
+      const model::FieldPath& field_path,
+      const GeoPoint& south_west,
+      const GeoPoint& north_east) override;
+
+  /**
+   * Returns true if any field index is configured for the collection group of
+   * the given collection. The remote document cache uses this to avoid reading
+   * back documents it overwrites when there are no index entries to update.
+   */
+  bool HasFieldIndexes(const model::ResourcePath& collection_path);
+
+  /**
+   * Writes the field index entries for the given document. Does nothing unless
+   * the document is a Document in a collection with field indexes.
+   */
+  void AddIndexEntries(const model::MaybeDocument& document);
+
+  /**
+   * Deletes the field index entries previously written for the given document
+   * by AddIndexEntries.
+   */
+  void RemoveIndexEntries(const model::MaybeDocument& document);
+
  private:
+  /** Lazily reads all index configurations into `field_indexes_`. */
+  void EnsureFieldIndexesLoaded();
+
+  void WriteIndexEntries(const model::FieldIndex& index,
+                         const model::Document& document);
+
+  void DeleteIndexEntries(const model::FieldIndex& index,
+                          const model::Document& document);
+
   // The LevelDbIndexManager is owned by LevelDbPersistence.
   LevelDbPersistence* db_;
 
@@ -52,6 +96,22 @@ class LevelDbIndexManager : public IndexManager {
    * be used to satisfy reads.
    */
   MemoryCollectionParentIndex collection_parents_cache_;
+
+  /**
+   * Whether the backfill of the collection parents index started by a schema
+   * migration was found to be complete. The backfill never restarts while the
+   * database is open, so once set this stays set.
+   */
+  bool collection_parents_backfilled_ = false;
+
+  /**
+   * The field index configurations keyed by collection ID. Unlike
+   * `collection_parents_cache_`, this is a complete copy of the persisted
+   * configurations once `field_indexes_loaded_` is set.
+   */
+  std::unordered_map<std::string, std::vector<model::FieldIndex>>
+      field_indexes_;
+  bool field_indexes_loaded_ = false;
 };
 
 }  // namespace local
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -24,9 +25,12 @@
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "absl/base/attributes.h"
 #include "absl/strings/escaping.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldIndex;
+using firebase::firestore::model::FieldPath;
 using firebase::firestore::model::ResourcePath;
 using firebase::firestore::util::OrderedCode;
 
@@ -44,10 +48,23 @@ const char* kTargetGlobalTable = "target_global";
 const char* kTargetsTable = "target";
 const char* kQueryTargetsTable = "query_target";
 const char* kTargetDocumentsTable = "target_document";
+const char* kTargetDocumentChunksTable = "target_document_chunk";
 const char* kDocumentTargetsTable = "document_target";
 const char* kRemoteDocumentsTable = "remote_document";
 const char* kCollectionParentsTable = "collection_parent";
 const char* kRemoteDocumentReadTimeTable = "remote_document_read_time";
+const char* kIndexConfigurationsTable = "index_configuration";
+const char* kIndexEntriesTable = "index_entry";
+const char* kRemoteDocumentChangesTable = "remote_document_change";
+const char* kRemoteDocumentSnapshotTable = "remote_document_snapshot";
+const char* kCollectionParentsBackfillTable = "collection_parents_backfill";
+const char* kCollectionGroupDocumentsTable = "collection_group_document";
+const char* kCollectionGroupDocumentsBackfillTable =
+    "collection_group_documents_backfill";
+const char* kRemoteDocumentChunksTable = "remote_document_chunk";
+const char* kTargetSequencesTable = "target_sequence";
+const char* kStartupTargetsTable = "startup_targets";
+const char* kCompressionDictionariesTable = "compression_dictionary";
 
 /**
  * Labels for the components of keys. These serve to make keys self-describing.
@@ -107,6 +124,43 @@ enum ComponentLabel {
   /** A component containing a snapshot version. */
   SnapshotVersion = 16,
 
+  /**
+   * A component containing the canonical string form of a field path (as used
+   * by the index_configuration table).
+   */
+  FieldPath = 17,
+
+  /** A component containing the kind of a field index segment. */
+  IndexKind = 18,
+
+  /** A component containing the canonical ID of a field index. */
+  IndexId = 19,
+
+  /**
+   * A component containing an encoded field value (as produced by
+   * EncodeIndexValue) in an index entry.
+   */
+  IndexValue = 20,
+
+  /**
+   * A component containing the bound of a chunk of document keys (as used by
+   * the target_document_chunk table). The bound is a resource path, encoded
+   * with its bits inverted so that greater bounds sort first.
+   */
+  ChunkBound = 21,
+
+  /**
+   * A component containing the hash of the contents of a chunk of a remote
+   * document (as used by the remote_document_chunk table).
+   */
+  ChunkId = 22,
+
+  /**
+   * A component containing a listen sequence number (as used by the
+   * target_sequence table).
+   */
+  SequenceNumber = 23,
+
   /**
    * A path segment describes just a single segment in a resource path. Path
    * segments that occur sequentially in a key represent successive segments in
@@ -127,6 +181,17 @@ enum ComponentLabel {
   Unknown = 63,
 };
 
+/**
+ * Flips every bit of the given bytes. Inverting the bytes of encoded keys
+ * reverses their order, since no complete key is a prefix of another.
+ */
+std::string InvertBits(std::string bytes) {
+  for (char& c : bytes) {
+    c = static_cast<char>(~c);
+  }
+  return bytes;
+}
+
 /**
  * A helper for reading through the string form of a LevelDB key, as written
  * by Writer.
@@ -149,6 +214,11 @@ class Reader {
     return !ok_ || src_.empty();
   }
 
+  /** Returns the number of bytes left to read. */
+  size_t remaining() const {
+    return src_.size();
+  }
+
   /**
    * Parses the components of the key and returns a string description of them.
    */
@@ -185,6 +255,21 @@ class Reader {
     return ReadLabeledString(ComponentLabel::DocumentId);
   }
 
+  std::string ReadIndexId() {
+    return ReadLabeledString(ComponentLabel::IndexId);
+  }
+
+  std::string ReadChunkId() {
+    return ReadLabeledString(ComponentLabel::ChunkId);
+  }
+
+  model::ListenSequenceNumber ReadSequenceNumber() {
+    if (!ReadComponentLabelMatching(ComponentLabel::SequenceNumber)) {
+      Fail();
+    }
+    return ReadInt64();
+  }
+
   /**
    * Reads a snapshot version, encoded as a component label and a pair of
    * seconds (int64) and nanoseconds (int32).
@@ -198,6 +283,23 @@ class Reader {
    */
   ResourcePath ReadResourcePath();
 
+  /**
+   * Like ReadResourcePath, but only counts the path segments instead of
+   * decoding them, and so never allocates.
+   */
+  size_t SkipResourcePath();
+
+  /**
+   * Reads a single ComponentLabel::PathSegment component without decoding
+   * it, failing the Reader if the next component is not a path segment.
+   */
+  void SkipPathSegment() {
+    if (!ReadComponentLabelMatching(ComponentLabel::PathSegment)) {
+      Fail();
+    }
+    SkipString();
+  }
+
   /**
    * Reads component labels and strings from the key until it finds a component
    * label other than ComponentLabel::PathSegment (or the key is exhausted).
@@ -212,6 +314,29 @@ class Reader {
    */
   DocumentKey ReadDocumentKey();
 
+  /**
+   * Reads a ComponentLabel::ChunkBound component and decodes the resource path
+   * it holds.
+   *
+   * If the read is unsuccessful or the bound is invalid, returns an empty path
+   * and fails the Reader.
+   */
+  ResourcePath ReadChunkBound();
+
+  /**
+   * Reads pairs of field path and index kind components from the key until it
+   * finds a component label other than ComponentLabel::FieldPath (or the key is
+   * exhausted).
+   */
+  std::vector<FieldIndex::Segment> ReadIndexSegments();
+
+  /**
+   * Reads component labels and encoded index values from the key until it
+   * finds a component label other than ComponentLabel::IndexValue (or the key
+   * is exhausted).
+   */
+  std::vector<std::string> ReadIndexValues();
+
   /**
    * Reads a terminator component from the key.
    *
@@ -258,6 +383,19 @@ class Reader {
     return "";
   }
 
+  /** Reads a string from the key without decoding it. */
+  void SkipString() {
+    if (ok_) {
+      absl::string_view tmp = MakeStringView(src_);
+      if (OrderedCode::ReadString(&tmp, nullptr)) {
+        src_ = MakeSlice(tmp);
+        return;
+      }
+    }
+
+    Fail();
+  }
+
   /**
    * Reads a component label from the key.
    *
@@ -429,6 +567,38 @@ ResourcePath Reader::ReadResourcePath() {
   return ResourcePath{std::move(path_segments)};
 }
 
+size_t Reader::SkipResourcePath() {
+  size_t count = 0;
+  while (!empty()) {
+    leveldb::Slice saved_position = src_;
+    if (!ReadComponentLabelMatching(ComponentLabel::PathSegment)) {
+      src_ = saved_position;
+      break;
+    }
+
+    SkipString();
+    if (!ok_) break;
+
+    ++count;
+  }
+  return count;
+}
+
+ResourcePath Reader::ReadChunkBound() {
+  std::string inverted = ReadLabeledString(ComponentLabel::ChunkBound);
+  if (!ok_) return ResourcePath{};
+
+  std::string encoded = InvertBits(std::move(inverted));
+  Reader path_reader{absl::string_view{encoded}};
+  ResourcePath bound = path_reader.ReadResourcePath();
+  path_reader.ReadTerminator();
+  if (!path_reader.ok() || path_reader.remaining() != 0) {
+    Fail();
+    return ResourcePath{};
+  }
+  return bound;
+}
+
 DocumentKey Reader::ReadDocumentKey() {
   ResourcePath path = ReadResourcePath();
 
@@ -441,6 +611,51 @@ DocumentKey Reader::ReadDocumentKey() {
   return DocumentKey{};
 }
 
+std::vector<FieldIndex::Segment> Reader::ReadIndexSegments() {
+  std::vector<FieldIndex::Segment> segments;
+  while (!empty()) {
+    leveldb::Slice saved_position = src_;
+    if (!ReadComponentLabelMatching(ComponentLabel::FieldPath)) {
+      src_ = saved_position;
+      break;
+    }
+
+    std::string canonical_path = ReadString();
+    int32_t kind = ReadLabeledInt32(ComponentLabel::IndexKind);
+    if (!ok_) break;
+
+    if (kind != static_cast<int32_t>(FieldIndex::Segment::Kind::Ordered) &&
+        kind != static_cast<int32_t>(FieldIndex::Segment::Kind::Contains) &&
+        kind != static_cast<int32_t>(FieldIndex::Segment::Kind::Geohash)) {
+      Fail();
+      break;
+    }
+
+    segments.emplace_back(FieldPath::FromServerFormat(canonical_path),
+                          static_cast<FieldIndex::Segment::Kind>(kind));
+  }
+
+  return segments;
+}
+
+std::vector<std::string> Reader::ReadIndexValues() {
+  std::vector<std::string> values;
+  while (!empty()) {
+    leveldb::Slice saved_position = src_;
+    if (!ReadComponentLabelMatching(ComponentLabel::IndexValue)) {
+      src_ = saved_position;
+      break;
+    }
+
+    std::string value = ReadString();
+    if (!ok_) break;
+
+    values.push_back(std::move(value));
+  }
+
+  return values;
+}
+
 model::SnapshotVersion Reader::ReadSnapshotVersion() {
   if (!ReadComponentLabelMatching(ComponentLabel::SnapshotVersion)) {
     Fail();
@@ -541,6 +756,50 @@ std::string Reader::Describe() {
         absl::StrAppend(&description,
                         " snapshot_version=", snapshot_version.ToString());
       }
+
+    } else if (label == ComponentLabel::FieldPath) {
+      std::vector<FieldIndex::Segment> segments = ReadIndexSegments();
+      if (ok_) {
+        for (const FieldIndex::Segment& segment : segments) {
+          absl::StrAppend(
+              &description, " field_path=",
+              segment.field_path().CanonicalString(),
+              " kind=", static_cast<int>(segment.kind()));
+        }
+      }
+
+    } else if (label == ComponentLabel::IndexId) {
+      std::string index_id = ReadIndexId();
+      if (ok_) {
+        absl::StrAppend(&description, " index_id=", index_id);
+      }
+
+    } else if (label == ComponentLabel::ChunkBound) {
+      ResourcePath bound = ReadChunkBound();
+      if (ok_) {
+        absl::StrAppend(&description, " bound=", bound.CanonicalString());
+      }
+
+    } else if (label == ComponentLabel::ChunkId) {
+      std::string chunk_id = ReadChunkId();
+      if (ok_) {
+        absl::StrAppend(&description, " chunk_id=", chunk_id);
+      }
+
+    } else if (label == ComponentLabel::SequenceNumber) {
+      model::ListenSequenceNumber sequence_number = ReadSequenceNumber();
+      if (ok_) {
+        absl::StrAppend(&description, " sequence_number=", sequence_number);
+      }
+
+    } else if (label == ComponentLabel::IndexValue) {
+      std::vector<std::string> values = ReadIndexValues();
+      if (ok_) {
+        for (const std::string& value : values) {
+          absl::StrAppend(&description,
+                          " index_value=", absl::BytesToHexString(value));
+        }
+      }
     } else {
       absl::StrAppend(&description, " unknown label=", static_cast<int>(label));
       Fail();
@@ -596,6 +855,55 @@ class Writer {
     WriteLabeledString(ComponentLabel::DocumentId, document_id);
   }
 
+  void WriteIndexId(absl::string_view index_id) {
+    WriteLabeledString(ComponentLabel::IndexId, index_id);
+  }
+
+  void WriteChunkId(absl::string_view chunk_id) {
+    WriteLabeledString(ComponentLabel::ChunkId, chunk_id);
+  }
+
+  void WriteSequenceNumber(model::ListenSequenceNumber sequence_number) {
+    WriteComponentLabel(ComponentLabel::SequenceNumber);
+    OrderedCode::WriteSignedNumIncreasing(&dest_, sequence_number);
+  }
+
+  /**
+   * For each segment of the given index writes a ComponentLabel::FieldPath
+   * component label, the canonical form of the segment's field path, and a
+   * ComponentLabel::IndexKind labeled kind.
+   */
+  void WriteIndexSegments(const std::vector<FieldIndex::Segment>& segments) {
+    for (const FieldIndex::Segment& segment : segments) {
+      WriteLabeledString(ComponentLabel::FieldPath,
+                         segment.field_path().CanonicalString());
+      WriteLabeledInt32(ComponentLabel::IndexKind,
+                        static_cast<int32_t>(segment.kind()));
+    }
+  }
+
+  /**
+   * For each value writes a ComponentLabel::IndexValue component label and a
+   * string containing the encoded value.
+   */
+  void WriteIndexValues(const std::vector<std::string>& values) {
+    for (const std::string& value : values) {
+      WriteLabeledString(ComponentLabel::IndexValue, value);
+    }
+  }
+
+  /**
+   * Writes a ComponentLabel::ChunkBound component label and the given path,
+   * encoded as a complete key with its bits inverted.
+   */
+  void WriteChunkBound(const ResourcePath& bound) {
+    Writer path_writer;
+    path_writer.WriteResourcePath(bound);
+    path_writer.WriteTerminator();
+    WriteLabeledString(ComponentLabel::ChunkBound,
+                       InvertBits(path_writer.result()));
+  }
+
   void WriteSnapshotVersion(model::SnapshotVersion snapshot_version) {
     WriteComponentLabel(ComponentLabel::SnapshotVersion);
     OrderedCode::WriteSignedNumIncreasing(
@@ -834,6 +1142,58 @@ bool LevelDbQueryTargetKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbTargetSequenceKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kTargetSequencesTable);
+  return writer.result();
+}
+
+std::string LevelDbTargetSequenceKey::Key(
+    model::ListenSequenceNumber sequence_number, model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kTargetSequencesTable);
+  writer.WriteSequenceNumber(sequence_number);
+  writer.WriteTargetId(target_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbTargetSequenceKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTargetSequencesTable);
+  sequence_number_ = reader.ReadSequenceNumber();
+  target_id_ = reader.ReadTargetId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbStartupTargetsKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kStartupTargetsTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbStartupTargetsKey::EncodeTargetIds(
+    const std::vector<model::TargetId>& target_ids) {
+  std::string encoded;
+  for (model::TargetId target_id : target_ids) {
+    OrderedCode::WriteSignedNumIncreasing(&encoded, target_id);
+  }
+  return encoded;
+}
+
+std::vector<model::TargetId> LevelDbStartupTargetsKey::DecodeTargetIds(
+    absl::string_view encoded) {
+  std::vector<model::TargetId> target_ids;
+  int64_t target_id = 0;
+  while (!encoded.empty() &&
+         OrderedCode::ReadSignedNumIncreasing(&encoded, &target_id)) {
+    target_ids.push_back(static_cast<model::TargetId>(target_id));
+  }
+  return target_ids;
+}
+
 std::string LevelDbTargetDocumentKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kTargetDocumentsTable);
@@ -866,6 +1226,81 @@ bool LevelDbTargetDocumentKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+constexpr size_t LevelDbTargetDocumentChunkKey::kMaxDocuments;
+
+std::string LevelDbTargetDocumentChunkKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentChunksTable);
+  return writer.result();
+}
+
+std::string LevelDbTargetDocumentChunkKey::KeyPrefix(
+    model::TargetId target_id) {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentChunksTable);
+  writer.WriteTargetId(target_id);
+  return writer.result();
+}
+
+std::string LevelDbTargetDocumentChunkKey::Key(model::TargetId target_id,
+                                               const ResourcePath& bound) {
+  Writer writer;
+  writer.WriteTableName(kTargetDocumentChunksTable);
+  writer.WriteTargetId(target_id);
+  writer.WriteChunkBound(bound);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbTargetDocumentChunkKey::EncodeDocumentKeys(
+    std::vector<DocumentKey>::const_iterator begin,
+    std::vector<DocumentKey>::const_iterator end) {
+  std::string encoded;
+  std::string previous;
+  for (auto it = begin; it != end; ++it) {
+    std::string path = it->path().CanonicalString();
+    size_t shared = 0;
+    size_t max_shared = std::min(path.size(), previous.size());
+    while (shared < max_shared && path[shared] == previous[shared]) {
+      ++shared;
+    }
+
+    OrderedCode::WriteNumIncreasing(&encoded, shared);
+    OrderedCode::WriteNumIncreasing(&encoded, path.size() - shared);
+    encoded.append(path, shared, std::string::npos);
+    previous = std::move(path);
+  }
+  return encoded;
+}
+
+void LevelDbTargetDocumentChunkKey::DecodeDocumentKeys(
+    absl::string_view encoded, std::vector<DocumentKey>* keys) {
+  std::string path;
+  while (!encoded.empty()) {
+    uint64_t shared = 0;
+    uint64_t rest = 0;
+    if (!OrderedCode::ReadNumIncreasing(&encoded, &shared) ||
+        !OrderedCode::ReadNumIncreasing(&encoded, &rest) ||
+        shared > path.size() || rest > encoded.size()) {
+      HARD_FAIL("Failed to read the documents of a target document chunk");
+    }
+
+    path.resize(shared);
+    path.append(encoded.data(), rest);
+    encoded.remove_prefix(rest);
+    keys->push_back(DocumentKey::FromPathString(path));
+  }
+}
+
+bool LevelDbTargetDocumentChunkKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kTargetDocumentChunksTable);
+  target_id_ = reader.ReadTargetId();
+  bound_ = reader.ReadChunkBound();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
 std::string LevelDbDocumentTargetKey::KeyPrefix() {
   Writer writer;
   writer.WriteTableName(kDocumentTargetsTable);
@@ -942,6 +1377,37 @@ std::string LevelDbRemoteDocumentKey::Key(const DocumentKey& key) {
   return writer.result();
 }
 
+absl::optional<size_t> LevelDbRemoteDocumentKey::CountSegmentsAfterPrefix(
+    absl::string_view key, absl::string_view prefix) {
+  // Path segments are encoded with a trailing separator, so a key starts with
+  // the encoded prefix if and only if its path starts with the prefix's path.
+  if (!absl::StartsWith(key, prefix)) {
+    return absl::nullopt;
+  }
+
+  Reader reader{key.substr(prefix.size())};
+  size_t count = reader.SkipResourcePath();
+  reader.ReadTerminator();
+  if (!reader.ok()) {
+    return absl::nullopt;
+  }
+  return count;
+}
+
+absl::optional<absl::string_view> LevelDbRemoteDocumentKey::ChildKeyPrefix(
+    absl::string_view key, absl::string_view prefix) {
+  if (!absl::StartsWith(key, prefix)) {
+    return absl::nullopt;
+  }
+
+  Reader reader{key.substr(prefix.size())};
+  reader.SkipPathSegment();
+  if (!reader.ok()) {
+    return absl::nullopt;
+  }
+  return key.substr(0, key.size() - reader.remaining());
+}
+
 bool LevelDbRemoteDocumentKey::Decode(absl::string_view key) {
   Reader reader{key};
   reader.ReadTableNameMatching(kRemoteDocumentsTable);
@@ -1016,6 +1482,239 @@ bool LevelDbRemoteDocumentReadTimeKey::Decode(absl::string_view key) {
   return reader.ok();
 }
 
+std::string LevelDbIndexConfigurationKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kIndexConfigurationsTable);
+  return writer.result();
+}
+
+std::string LevelDbIndexConfigurationKey::KeyPrefix(
+    absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kIndexConfigurationsTable);
+  writer.WriteCollectionId(collection_id);
+  return writer.result();
+}
+
+std::string LevelDbIndexConfigurationKey::Key(const FieldIndex& index) {
+  Writer writer;
+  writer.WriteTableName(kIndexConfigurationsTable);
+  writer.WriteCollectionId(index.collection_id());
+  writer.WriteIndexSegments(index.segments());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbIndexConfigurationKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kIndexConfigurationsTable);
+  std::string collection_id = reader.ReadCollectionId();
+  std::vector<FieldIndex::Segment> segments = reader.ReadIndexSegments();
+  reader.ReadTerminator();
+  index_ = FieldIndex(std::move(collection_id), std::move(segments));
+  return reader.ok();
+}
+
+std::string LevelDbIndexEntryKey::KeyPrefix(
+    absl::string_view index_id,
+    const ResourcePath& collection_path,
+    const std::vector<std::string>& values) {
+  Writer writer;
+  writer.WriteTableName(kIndexEntriesTable);
+  writer.WriteIndexId(index_id);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteIndexValues(values);
+  return writer.result();
+}
+
+std::string LevelDbIndexEntryKey::Key(absl::string_view index_id,
+                                      const ResourcePath& collection_path,
+                                      const std::vector<std::string>& values,
+                                      absl::string_view document_id) {
+  Writer writer;
+  writer.WriteTableName(kIndexEntriesTable);
+  writer.WriteIndexId(index_id);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteIndexValues(values);
+  writer.WriteDocumentId(document_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbIndexEntryKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kIndexEntriesTable);
+  index_id_ = reader.ReadIndexId();
+  collection_path_ = reader.ReadResourcePath();
+  values_ = reader.ReadIndexValues();
+  document_id_ = reader.ReadDocumentId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbRemoteDocumentChangeKey::KeyPrefix() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentChangesTable);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentChangeKey::KeyPrefix(
+    const ResourcePath& resource_path) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentChangesTable);
+  writer.WriteResourcePath(resource_path);
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentChangeKey::Key(const DocumentKey& key) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentChangesTable);
+  writer.WriteResourcePath(key.path());
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentChangeKey::EncodeGeneration(
+    int64_t generation) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded, generation);
+  return encoded;
+}
+
+int64_t LevelDbRemoteDocumentChangeKey::DecodeGeneration(
+    absl::string_view slice) {
+  int64_t decoded;
+  if (!OrderedCode::ReadSignedNumIncreasing(&slice, &decoded)) {
+    HARD_FAIL("Failed to read generation from a remote document change row");
+  }
+  return decoded;
+}
+
+bool LevelDbRemoteDocumentChangeKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentChangesTable);
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbRemoteDocumentSnapshotKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentSnapshotTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentChunkKey::KeyPrefix(
+    const DocumentKey& document_key) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentChunksTable);
+  writer.WriteResourcePath(document_key.path());
+  return writer.result();
+}
+
+std::string LevelDbRemoteDocumentChunkKey::Key(const DocumentKey& document_key,
+                                               absl::string_view chunk_id) {
+  Writer writer;
+  writer.WriteTableName(kRemoteDocumentChunksTable);
+  writer.WriteResourcePath(document_key.path());
+  writer.WriteChunkId(chunk_id);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbRemoteDocumentChunkKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kRemoteDocumentChunksTable);
+  document_key_ = reader.ReadDocumentKey();
+  chunk_id_ = reader.ReadChunkId();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbCompressionDictionaryKey::Key(
+    const ResourcePath& collection_path) {
+  Writer writer;
+  writer.WriteTableName(kCompressionDictionariesTable);
+  writer.WriteResourcePath(collection_path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+bool LevelDbCompressionDictionaryKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCompressionDictionariesTable);
+  collection_path_ = reader.ReadResourcePath();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbCollectionParentsBackfillKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kCollectionParentsBackfillTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupDocumentKey::KeyPrefix(
+    absl::string_view collection_id) {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  writer.WriteCollectionId(collection_id);
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupDocumentKey::Key(const DocumentKey& key) {
+  const ResourcePath& path = key.path();
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsTable);
+  writer.WriteCollectionId(path[path.size() - 2]);
+  writer.WriteResourcePath(path);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
+std::string LevelDbCollectionGroupDocumentKey::EncodeReadTime(
+    const model::SnapshotVersion& read_time) {
+  std::string encoded;
+  OrderedCode::WriteSignedNumIncreasing(&encoded,
+                                        read_time.timestamp().seconds());
+  OrderedCode::WriteSignedNumIncreasing(&encoded,
+                                        read_time.timestamp().nanoseconds());
+  return encoded;
+}
+
+absl::optional<model::SnapshotVersion>
+LevelDbCollectionGroupDocumentKey::DecodeReadTime(absl::string_view encoded) {
+  if (encoded.empty()) {
+    return absl::nullopt;
+  }
+
+  int64_t seconds = 0;
+  int64_t nanos = 0;
+  if (!OrderedCode::ReadSignedNumIncreasing(&encoded, &seconds) ||
+      !OrderedCode::ReadSignedNumIncreasing(&encoded, &nanos)) {
+    HARD_FAIL("Failed to read the read time of a collection group document");
+  }
+  return model::SnapshotVersion({seconds, static_cast<int32_t>(nanos)});
+}
+
+bool LevelDbCollectionGroupDocumentKey::Decode(absl::string_view key) {
+  Reader reader{key};
+  reader.ReadTableNameMatching(kCollectionGroupDocumentsTable);
+  collection_id_ = reader.ReadCollectionId();
+  document_key_ = reader.ReadDocumentKey();
+  reader.ReadTerminator();
+  return reader.ok();
+}
+
+std::string LevelDbCollectionGroupDocumentsBackfillKey::Key() {
+  Writer writer;
+  writer.WriteTableName(kCollectionGroupDocumentsBackfillTable);
+  writer.WriteTerminator();
+  return writer.result();
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
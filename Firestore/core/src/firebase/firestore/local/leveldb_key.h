@@ -18,12 +18,16 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_KEY_H_
 
 #include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 #include "leveldb/slice.h"
 
 namespace firebase {
@@ -70,6 +74,11 @@ namespace local {
 //   - target_id: model::TargetId
 //   - path: ResourcePath
 //
+// target_document_chunks:
+//   - table_name: string = "target_document_chunk"
+//   - target_id: model::TargetId
+//   - bound: ResourcePath (encoded so that greater bounds sort first)
+//
 // document_targets:
 //   - table_name: string = "document_target"
 //   - path: ResourcePath
@@ -89,6 +98,25 @@ namespace local {
 //   - collection: ResourcePath
 //   - read_time: SnapshotVersion
 //   - document_id: string
+//
+// index_configurations:
+//   - table_name: string = "index_configuration"
+//   - collection_id: string
+//   - segments: repeated (field_path: string, kind: int32)
+//
+// index_entries:
+//   - table_name: string = "index_entry"
+//   - index_id: string
+//   - collection: ResourcePath
+//   - values: repeated string (encoded with EncodeIndexValue)
+//   - document_id: string
+//
+// remote_document_changes:
+//   - table_name: string = "remote_document_change"
+//   - path: ResourcePath
+//
+// remote_document_snapshot:
+//   - table_name: string = "remote_document_snapshot"
 
 /**
  * Parses the given key and returns a human readable description of its
@@ -356,6 +384,72 @@ class LevelDbQueryTargetKey {
   model::TargetId target_id_ = 0;
 };
 
+/**
+ * A key in the target sequences table, an index of the targets by their
+ * sequence numbers, so that garbage collection can visit them in order without
+ * decoding them. The rows have no value.
+ */
+class LevelDbTargetSequenceKey {
+ public:
+  /**
+   * Creates a key that contains just the target sequences table prefix and
+   * points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a key that points to a specific target's entry. */
+  static std::string Key(model::ListenSequenceNumber sequence_number,
+                         model::TargetId target_id);
+
+  /**
+   * Decodes the contents of a target sequence key, storing the decoded values
+   * in this instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The sequence number of the target, as encoded in the key. */
+  model::ListenSequenceNumber sequence_number() const {
+    return sequence_number_;
+  }
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+ private:
+  model::ListenSequenceNumber sequence_number_ = 0;
+  model::TargetId target_id_ = 0;
+};
+
+/**
+ * A key to a singleton row storing the IDs of the targets executed early in
+ * the previous session, whose documents the next session prefetches. The row
+ * value is encoded with `EncodeTargetIds`.
+ */
+class LevelDbStartupTargetsKey {
+ public:
+  /**
+   * Returns the key pointing to the singleton row storing the startup targets.
+   */
+  static std::string Key();
+
+  static std::string EncodeTargetIds(
+      const std::vector<model::TargetId>& target_ids);
+
+  /**
+   * Decodes a row value written by `EncodeTargetIds`. Returns the IDs decoded
+   * before the first malformed one, if any.
+   */
+  static std::vector<model::TargetId> DecodeTargetIds(
+      absl::string_view encoded);
+};
+
 /**
  * A key in the target documents table, an index of target_ids to the documents
  * they contain.
@@ -405,6 +499,80 @@ class LevelDbTargetDocumentKey {
   model::DocumentKey document_key_;
 };
 
+/**
+ * A key in the target document chunks table, which stores the documents of
+ * each target as sorted runs of document keys.
+ *
+ * Each chunk holds the target's documents from its bound up to the bound of
+ * the next chunk. Chunks are stored from the greatest bound down, so seeking to
+ * `Key(target_id, path)` finds the chunk that holds (or would hold) the
+ * document at `path`. The chunk with the least bound of a target may have the
+ * empty path as its bound.
+ *
+ * Row values hold the chunk's document keys as written by
+ * `EncodeDocumentKeys`.
+ */
+class LevelDbTargetDocumentChunkKey {
+ public:
+  /** The number of documents a chunk holds at most. */
+  static constexpr size_t kMaxDocuments = 512;
+
+  /**
+   * Creates a key that contains just the target document chunks table prefix
+   * and points just before the first key.
+   */
+  static std::string KeyPrefix();
+
+  /** Creates a key that points to the first chunk of a target_id. */
+  static std::string KeyPrefix(model::TargetId target_id);
+
+  /** Creates a key that points to the chunk of a target with a given bound. */
+  static std::string Key(model::TargetId target_id,
+                         const model::ResourcePath& bound);
+
+  /**
+   * Encodes the given sorted document keys as the value of a chunk row. Each
+   * key's path is stored as the length of the prefix it shares with the
+   * previous one's, followed by the rest of it.
+   */
+  static std::string EncodeDocumentKeys(
+      std::vector<model::DocumentKey>::const_iterator begin,
+      std::vector<model::DocumentKey>::const_iterator end);
+
+  /**
+   * Decodes a row value written by `EncodeDocumentKeys`, appending the keys to
+   * `keys`.
+   */
+  static void DecodeDocumentKeys(absl::string_view encoded,
+                                 std::vector<model::DocumentKey>* keys);
+
+  /**
+   * Decodes the contents of a target document chunk key, storing the decoded
+   * values in this instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The target_id identifying a target. */
+  model::TargetId target_id() const {
+    return target_id_;
+  }
+
+  /** The least path the chunk may hold, as encoded in the key. */
+  const model::ResourcePath& bound() const {
+    return bound_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::TargetId target_id_ = 0;
+  model::ResourcePath bound_;
+};
+
 /**
  * A key in the document targets table, an index from documents to the targets
  * that contain them.
@@ -508,6 +676,36 @@ class LevelDbRemoteDocumentKey {
    */
   static std::string KeyPrefix(const model::ResourcePath& resource_path);
 
+  /**
+   * Returns the number of path segments that the encoded remote document key
+   * `key` has beyond those in `prefix`, a key prefix returned by KeyPrefix().
+   * For example, the key for "rooms/abc" has one segment beyond the prefix for
+   * "rooms", while the key for "rooms/abc/messages/xyz" has three.
+   *
+   * Works directly on the encoded key without decoding or allocating its
+   * segments, so that scans can cheaply skip keys they are not interested in.
+   *
+   * @return The number of segments, or nullopt if `key` is not a valid remote
+   * document key that starts with `prefix`.
+   */
+  static absl::optional<size_t> CountSegmentsAfterPrefix(
+      absl::string_view key, absl::string_view prefix);
+
+  /**
+   * Returns the leading part of the encoded remote document key `key` that
+   * encodes `prefix`, a key prefix returned by KeyPrefix(), followed by the
+   * key's next path segment. This is the KeyPrefix() of the child of the
+   * prefix's path that contains the key, so every key in that child's subtree
+   * starts with it.
+   *
+   * Like CountSegmentsAfterPrefix(), this does not decode the key.
+   *
+   * @return The child's key prefix, which points into `key`, or nullopt if
+   * `key` does not start with `prefix` followed by a path segment.
+   */
+  static absl::optional<absl::string_view> ChildKeyPrefix(
+      absl::string_view key, absl::string_view prefix);
+
   /**
    * Decodes the contents of a remote document key, storing the decoded values
    * in this instance. This can only decode complete document paths (i.e. the
@@ -635,6 +833,338 @@ class LevelDbRemoteDocumentReadTimeKey {
   model::SnapshotVersion read_time_;
 };
 
+/**
+ * A key in the index configurations table, which stores the definitions of the
+ * field indexes that are maintained for each collection group. The entire
+ * definition is encoded in the key; the row value is empty.
+ */
+class LevelDbIndexConfigurationKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_id.
+   */
+  static std::string KeyPrefix(absl::string_view collection_id);
+
+  /** Creates a complete key that points to the given index definition. */
+  static std::string Key(const model::FieldIndex& index);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The index definition, as encoded in the key. */
+  const model::FieldIndex& index() const {
+    return index_;
+  }
+
+ private:
+  model::FieldIndex index_;
+};
+
+/**
+ * A key in the index entries table, which maps the encoded values of the fields
+ * of a field index to the documents that contain them. Entries are grouped by
+ * collection so that a scan for a collection query does not have to skip over
+ * documents in other collections of the same collection group.
+ */
+class LevelDbIndexEntryKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first entry of the given
+   * index in `collection_path` whose leading values equal `values`.
+   */
+  static std::string KeyPrefix(absl::string_view index_id,
+                               const model::ResourcePath& collection_path,
+                               const std::vector<std::string>& values = {});
+
+  /** Creates a complete key that points to a specific index entry. */
+  static std::string Key(absl::string_view index_id,
+                         const model::ResourcePath& collection_path,
+                         const std::vector<std::string>& values,
+                         absl::string_view document_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The canonical ID of the index this entry belongs to. */
+  const std::string& index_id() const {
+    return index_id_;
+  }
+
+  /** The collection containing the indexed document. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+  /** The encoded values of the indexed fields, in index segment order. */
+  const std::vector<std::string>& values() const {
+    return values_;
+  }
+
+  /** The ID of the indexed document within `collection_path`. */
+  const std::string& document_id() const {
+    return document_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string index_id_;
+  model::ResourcePath collection_path_;
+  std::vector<std::string> values_;
+  std::string document_id_;
+};
+
+/**
+ * A key in the remote document changes table, which records the documents that
+ * were added to or removed from the remote document cache since the document
+ * snapshot file was last built. The row value is the snapshot generation that
+ * was current when the document last changed.
+ */
+class LevelDbRemoteDocumentChangeKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key in the table.
+   */
+  static std::string KeyPrefix();
+
+  /**
+   * Creates a key prefix that contains a part of a document path. As with
+   * LevelDbRemoteDocumentKey, an odd number of segments creates a collection
+   * key prefix.
+   */
+  static std::string KeyPrefix(const model::ResourcePath& resource_path);
+
+  /** Creates a complete key that points to a specific document. */
+  static std::string Key(const model::DocumentKey& document_key);
+
+  /** Given a snapshot generation, encodes it for storage in a change row. */
+  static std::string EncodeGeneration(int64_t generation);
+
+  /** Given an encoded change row, returns the snapshot generation. */
+  static int64_t DecodeGeneration(absl::string_view slice);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The path to the document, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key to a singleton row storing the current generation of the remote
+ * document snapshot. The row only exists while the document snapshot is
+ * enabled, and its value is encoded with
+ * LevelDbRemoteDocumentChangeKey::EncodeGeneration.
+ */
+class LevelDbRemoteDocumentSnapshotKey {
+ public:
+  /**
+   * Returns the key pointing to the singleton row storing the snapshot
+   * generation.
+   */
+  static std::string Key();
+};
+
+/**
+ * A key in the remote document chunks table, which holds the large values of
+ * large documents out of line, so that an update of such a document doesn't
+ * rewrite the values that didn't change. A chunk is identified by its
+ * document and by a hash of its contents, and the row value is the encoded
+ * google_firestore_v1_Value.
+ */
+class LevelDbRemoteDocumentChunkKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first chunk of the given
+   * document. Chunks of documents in its subcollections follow its own.
+   */
+  static std::string KeyPrefix(const model::DocumentKey& document_key);
+
+  /** Creates a complete key that points to a specific chunk. */
+  static std::string Key(const model::DocumentKey& document_key,
+                         absl::string_view chunk_id);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The document the chunk belongs to, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+  /** The hash of the chunk's contents, as encoded in the key. */
+  const std::string& chunk_id() const {
+    return chunk_id_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::DocumentKey document_key_;
+  std::string chunk_id_;
+};
+
+/**
+ * A key in the compression dictionaries table, which holds the dictionary that
+ * the compressed rows of a collection's documents were compressed with. A
+ * dictionary is never changed once written, since existing rows depend on it.
+ */
+class LevelDbCompressionDictionaryKey {
+ public:
+  /** Creates a key that points to the dictionary of the given collection. */
+  static std::string Key(const model::ResourcePath& collection_path);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection the dictionary belongs to, as encoded in the key. */
+  const model::ResourcePath& collection_path() const {
+    return collection_path_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  model::ResourcePath collection_path_;
+};
+
+/**
+ * A key to a singleton row storing how far the backfill of the collection
+ * parents index has got. The row only exists while the backfill is pending,
+ * and its value is the next key of the remote documents or document mutations
+ * tables to index.
+ */
+class LevelDbCollectionParentsBackfillKey {
+ public:
+  /**
+   * Returns the key pointing to the singleton row storing the backfill
+   * position.
+   */
+  static std::string Key();
+};
+
+/**
+ * A key in the collection group documents index, which stores the key of each
+ * document in the remote document cache under the ID of the collection that
+ * contains it (e.g. 'messages' for '/chats/123/messages/456'). Collection
+ * Group queries find the documents to read with a single range scan of the
+ * index instead of a scan per parent of the collection group.
+ *
+ * The row value is the read time of the document, encoded with
+ * `EncodeReadTime`, or empty if the row was written by the backfill, which
+ * doesn't know the read time.
+ */
+class LevelDbCollectionGroupDocumentKey {
+ public:
+  /**
+   * Creates a key prefix that points just before the first key for the given
+   * collection_id.
+   */
+  static std::string KeyPrefix(absl::string_view collection_id);
+
+  /** Creates a complete key that points to a specific document. */
+  static std::string Key(const model::DocumentKey& key);
+
+  static std::string EncodeReadTime(const model::SnapshotVersion& read_time);
+
+  /**
+   * Decodes a row value written by `EncodeReadTime`. Returns nullopt for empty
+   * row values.
+   */
+  static absl::optional<model::SnapshotVersion> DecodeReadTime(
+      absl::string_view encoded);
+
+  /**
+   * Decodes the given complete key, storing the decoded values in this
+   * instance.
+   *
+   * @return true if the key successfully decoded, false otherwise. If false is
+   * returned, this instance is in an undefined state until the next call to
+   * `Decode()`.
+   */
+  ABSL_MUST_USE_RESULT
+  bool Decode(absl::string_view key);
+
+  /** The collection_id, as encoded in the key. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  /** The document key, as encoded in the key. */
+  const model::DocumentKey& document_key() const {
+    return document_key_;
+  }
+
+ private:
+  // Deliberately uninitialized: will be assigned in Decode
+  std::string collection_id_;
+  model::DocumentKey document_key_;
+};
+
+/**
+ * A key to a singleton row storing how far the backfill of the collection
+ * group documents index has got. The row only exists while the backfill is
+ * pending, and its value is the next key of the remote documents table to
+ * index.
+ */
+class LevelDbCollectionGroupDocumentsBackfillKey {
+ public:
+  /**
+   * Returns the key pointing to the singleton row storing the backfill
+   * position.
+   */
+  static std::string Key();
+};
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
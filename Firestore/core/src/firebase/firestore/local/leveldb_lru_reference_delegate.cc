@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_lru_reference_delegate.h"
 
+#include <limits>
 #include <set>
 #include <string>
 #include <utility>
@@ -60,8 +61,11 @@ void LevelDbLruReferenceDelegate::AddInMemoryPins(ReferenceSet* set) {
   additional_references_ = set;
 }
 
-void LevelDbLruReferenceDelegate::AddReference(const DocumentKey& key) {
-  WriteSentinel(key);
+void LevelDbLruReferenceDelegate::AddReference(const DocumentKey&) {
+  // A document's sentinel only matters once it is in no target, and is written
+  // when it leaves one (see RemoveReference and
+  // LevelDbTargetCache::RemoveAllKeysForTarget). Not writing it here saves a
+  // row per document when targets gain many documents at once.
 }
 
 void LevelDbLruReferenceDelegate::RemoveReference(const DocumentKey& key) {
@@ -122,6 +126,11 @@ void LevelDbLruReferenceDelegate::EnumerateTargets(
   db_->target_cache()->EnumerateTargets(callback);
 }
 
+void LevelDbLruReferenceDelegate::EnumerateTargetSequenceNumbers(
+    const SequenceNumberCallback& callback) {
+  db_->target_cache()->EnumerateSequenceNumbers(callback);
+}
+
 void LevelDbLruReferenceDelegate::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
   db_->target_cache()->EnumerateOrphanedDocuments(callback);
@@ -129,23 +138,88 @@ void LevelDbLruReferenceDelegate::EnumerateOrphanedDocuments(
 
 int LevelDbLruReferenceDelegate::RemoveOrphanedDocuments(
     ListenSequenceNumber upper_bound) {
+  std::string position;
+  return RemoveOrphanedDocuments(
+      upper_bound, std::numeric_limits<int>::max(), &position);
+}
+
+int LevelDbLruReferenceDelegate::RemoveTargets(
+    ListenSequenceNumber sequence_number, const LiveQueryMap& live_queries) {
+  return db_->target_cache()->RemoveTargets(sequence_number, live_queries);
+}
+
+int LevelDbLruReferenceDelegate::RemoveOrphanedDocuments(
+    ListenSequenceNumber upper_bound,
+    int max_documents,
+    std::string* position) {
   int count = 0;
   db_->target_cache()->EnumerateOrphanedDocuments(
       [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
-        if (sequence_number <= upper_bound) {
-          if (!IsPinned(key)) {
-            count++;
-            db_->remote_document_cache()->Remove(key);
-            RemoveSentinel(key);
-          }
+        if (sequence_number <= upper_bound && EvictOrphanedDocument(key)) {
+          count++;
         }
-      });
+      },
+      static_cast<size_t>(max_documents), position);
   return count;
 }
 
 int LevelDbLruReferenceDelegate::RemoveTargets(
-    ListenSequenceNumber sequence_number, const LiveQueryMap& live_queries) {
-  return db_->target_cache()->RemoveTargets(sequence_number, live_queries);
+    ListenSequenceNumber sequence_number,
+    const LiveQueryMap& live_queries,
+    int max_targets,
+    std::string* position) {
+  return db_->target_cache()->RemoveTargets(
+      sequence_number, live_queries, static_cast<size_t>(max_targets),
+      position);
+}
+
+int LevelDbLruReferenceDelegate::RemoveOrphanedTombstones(
+    int max_documents, std::string* position) {
+  int count = 0;
+  db_->target_cache()->EnumerateOrphanedDocuments(
+      [&](const DocumentKey& key, ListenSequenceNumber) {
+        if (db_->remote_document_cache()->ContainsTombstone(key) &&
+            EvictOrphanedDocument(key)) {
+          count++;
+        }
+      },
+      static_cast<size_t>(max_documents), position);
+  return count;
+}
+
+int64_t LevelDbLruReferenceDelegate::CalculateByteSize(
+    const TargetData& target_data) {
+  std::string value;
+  auto status = db_->current_transaction()->Get(
+      LevelDbTargetKey::Key(target_data.target_id()), &value);
+  return status.ok() ? static_cast<int64_t>(value.size()) : 0;
+}
+
+void LevelDbLruReferenceDelegate::EnumerateOrphanedDocumentSizes(
+    const OrphanedDocumentSizeCallback& callback) {
+  std::string value;
+  EnumerateOrphanedDocuments(
+      [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
+        auto status = db_->current_transaction()->Get(
+            LevelDbRemoteDocumentKey::Key(key), &value);
+        int64_t byte_size =
+            status.ok() ? static_cast<int64_t>(value.size()) : 0;
+        callback(key, sequence_number, byte_size);
+      });
+}
+
+void LevelDbLruReferenceDelegate::EvictTarget(const TargetData& target_data) {
+  db_->target_cache()->RemoveTarget(target_data);
+}
+
+bool LevelDbLruReferenceDelegate::EvictOrphanedDocument(
+    const DocumentKey& key) {
+  if (IsPinned(key)) {
+    return false;
+  }
+  db_->remote_document_cache()->Remove(key);
+  RemoveSentinel(key);
+  return true;
 }
 
 bool LevelDbLruReferenceDelegate::IsPinned(const DocumentKey& key) {
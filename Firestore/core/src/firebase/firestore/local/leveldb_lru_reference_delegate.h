@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_LRU_REFERENCE_DELEGATE_H_
 
 #include <memory>
+#include <string>
 
 #include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
 
@@ -61,6 +62,8 @@ class LevelDbLruReferenceDelegate : public LruDelegate {
   size_t GetSequenceNumberCount() override;
 
   void EnumerateTargets(const TargetCallback& callback) override;
+  void EnumerateTargetSequenceNumbers(
+      const SequenceNumberCallback& callback) override;
   void EnumerateOrphanedDocuments(
       const OrphanedDocumentCallback& callback) override;
 
@@ -68,6 +71,22 @@ class LevelDbLruReferenceDelegate : public LruDelegate {
   int RemoveTargets(model::ListenSequenceNumber sequence_number,
                     const LiveQueryMap& live_queries) override;
 
+  int RemoveOrphanedDocuments(model::ListenSequenceNumber upper_bound,
+                              int max_documents,
+                              std::string* position) override;
+  int RemoveTargets(model::ListenSequenceNumber sequence_number,
+                    const LiveQueryMap& live_queries,
+                    int max_targets,
+                    std::string* position) override;
+  int RemoveOrphanedTombstones(int max_documents,
+                               std::string* position) override;
+
+  int64_t CalculateByteSize(const TargetData& target_data) override;
+  void EnumerateOrphanedDocumentSizes(
+      const OrphanedDocumentSizeCallback& callback) override;
+  void EvictTarget(const TargetData& target_data) override;
+  bool EvictOrphanedDocument(const model::DocumentKey& key) override;
+
  private:
   bool IsPinned(const model::DocumentKey& key);
 
@@ -16,8 +16,10 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 
+#include <algorithm>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
@@ -40,6 +42,7 @@ using leveldb::Status;
 using leveldb::WriteOptions;
 using model::DocumentKey;
 using model::ResourcePath;
+using model::TargetId;
 using nanopb::Message;
 using nanopb::StringReader;
 using nanopb::Writer;
@@ -66,8 +69,12 @@ namespace {
  *     has a sentinel row with a sequence number.
  *   * Migration 5 drops held write acks.
  *   * Migration 6 populates the collection_parents index.
+ *   * Migration 7 populates the collection_group_document index.
+ *   * Migration 8 moves the documents of each target from the target_document
+ *     table into the target_document_chunk table.
+ *   * Migration 9 populates the target_sequence index.
  */
-const LevelDbMigrations::SchemaVersion kSchemaVersion = 6;
+const LevelDbMigrations::SchemaVersion kSchemaVersion = 9;
 
 /**
  * Save the given version number as the current version of the schema of the
@@ -265,45 +272,254 @@ void EnsureCollectionParentRow(LevelDbTransaction* transaction,
 /**
  * Migration 6.
  *
- * Creates appropriate LevelDbCollectionParentKey rows for all collections
- * of documents in the remote document cache and mutation queue.
+ * Starts the backfill of the collection parents index: the rows for the
+ * collections of documents in the remote document cache and mutation queue are
+ * written later, a chunk at a time, by
+ * `LevelDbMigrations::ContinueBackfill`.
  */
-void EnsureCollectionParentsIndex(leveldb::DB* db) {
-  LevelDbTransaction transaction(db, "Ensure Collection Parents Index");
+void StartCollectionParentsBackfill(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Start Collection Parents Backfill");
+  transaction.Put(LevelDbCollectionParentsBackfillKey::Key(),
+                  LevelDbRemoteDocumentKey::KeyPrefix());
+  SaveVersion(6, &transaction);
+  transaction.Commit();
+}
 
-  MemoryCollectionParentIndex cache;
+/**
+ * Migration 7.
+ *
+ * Starts the backfill of the collection group documents index, which indexes
+ * the documents already in the remote document cache a chunk at a time, after
+ * the collection parents backfill.
+ */
+void StartCollectionGroupDocumentsBackfill(leveldb::DB* db) {
+  LevelDbTransaction transaction(db, "Start Collection Group Backfill");
+  transaction.Put(LevelDbCollectionGroupDocumentsBackfillKey::Key(),
+                  LevelDbRemoteDocumentKey::KeyPrefix());
+  SaveVersion(7, &transaction);
+  transaction.Commit();
+}
+
+/**
+ * Indexes up to `max_rows` remote documents from the position of the
+ * collection group documents backfill. Returns true if the backfill isn't
+ * complete yet.
+ */
+bool ContinueCollectionGroupDocumentsBackfill(LevelDbTransaction* transaction,
+                                              size_t max_rows) {
+  std::string position;
+  if (!transaction
+           ->Get(LevelDbCollectionGroupDocumentsBackfillKey::Key(), &position)
+           .ok()) {
+    return false;
+  }
 
-  // Index existing remote documents.
   std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
-  auto it = transaction.NewIterator();
-  it->Seek(documents_prefix);
+  auto it = transaction->NewIterator();
   LevelDbRemoteDocumentKey document_key;
-  for (; it->Valid() && absl::StartsWith(it->key(), documents_prefix);
+  size_t rows = 0;
+  for (it->Seek(position);
+       it->Valid() && absl::StartsWith(it->key(), documents_prefix);
        it->Next()) {
+    if (rows == max_rows) {
+      transaction->Put(LevelDbCollectionGroupDocumentsBackfillKey::Key(),
+                       it->key());
+      return true;
+    }
+
     HARD_ASSERT(document_key.Decode(it->key()),
                 "Failed to decode document key");
+    // Documents added since the migration already have a row with their read
+    // time, which an empty row would hide.
+    std::string index_key =
+        LevelDbCollectionGroupDocumentKey::Key(document_key.document_key());
+    std::string unused_value;
+    if (transaction->Get(index_key, &unused_value).IsNotFound()) {
+      transaction->Put(std::move(index_key), "");
+    }
+    ++rows;
+  }
+
+  transaction->Delete(LevelDbCollectionGroupDocumentsBackfillKey::Key());
+  return false;
+}
 
-    EnsureCollectionParentRow(&transaction, &cache,
-                              document_key.document_key());
+/**
+ * Calls `visit` with the document key of each remote document and document
+ * mutation from `position` on, in that order, until it returns false. Returns
+ * false if stopped early, with `position` set to the key of the row `visit`
+ * declined.
+ */
+template <typename F>
+bool VisitUnindexedDocumentKeys(LevelDbTransaction* transaction,
+                                std::string* position,
+                                const F& visit) {
+  auto it = transaction->NewIterator();
+
+  std::string documents_prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  if (absl::StartsWith(*position, documents_prefix)) {
+    LevelDbRemoteDocumentKey document_key;
+    for (it->Seek(*position);
+         it->Valid() && absl::StartsWith(it->key(), documents_prefix);
+         it->Next()) {
+      HARD_ASSERT(document_key.Decode(it->key()),
+                  "Failed to decode document key");
+      if (!visit(document_key.document_key())) {
+        *position = it->key();
+        return false;
+      }
+    }
+    *position = LevelDbDocumentMutationKey::KeyPrefix();
   }
 
-  // Index existing mutations.
   std::string mutations_prefix = LevelDbDocumentMutationKey::KeyPrefix();
-  it = transaction.NewIterator();
-  it->Seek(mutations_prefix);
-  LevelDbDocumentMutationKey key;
-  for (; it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
+  LevelDbDocumentMutationKey mutation_key;
+  for (it->Seek(*position);
+       it->Valid() && absl::StartsWith(it->key(), mutations_prefix);
        it->Next()) {
-    HARD_ASSERT(key.Decode(it->key()),
+    HARD_ASSERT(mutation_key.Decode(it->key()),
                 "Failed to decode document-mutation key");
+    if (!visit(mutation_key.document_key())) {
+      *position = it->key();
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Migration 8.
+ *
+ * Rewrites the target_document rows as chunks, one transaction per chunk. Any
+ * chunks already present were written before a downgrade and may be stale, so
+ * they are dropped first.
+ */
+void ChunkTargetDocuments(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbTargetDocumentChunkKey::KeyPrefix(), db);
+
+  std::string prefix = LevelDbTargetDocumentKey::KeyPrefix();
+  size_t chunk_size = LevelDbTargetDocumentChunkKey::kMaxDocuments / 2;
+  bool more = true;
+  while (more) {
+    LevelDbTransaction transaction(db, "Chunk target documents");
+    auto it = transaction.NewIterator();
 
-    EnsureCollectionParentRow(&transaction, &cache, key.document_key());
+    more = false;
+    TargetId target_id = 0;
+    std::vector<DocumentKey> documents;
+    LevelDbTargetDocumentKey row_key;
+    for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+         it->Next()) {
+      HARD_ASSERT(row_key.Decode(it->key()),
+                  "Failed to decode target document key");
+      if (!documents.empty() && (row_key.target_id() != target_id ||
+                                 documents.size() == chunk_size)) {
+        more = true;
+        break;
+      }
+      target_id = row_key.target_id();
+      documents.push_back(row_key.document_key());
+      transaction.Delete(it->key());
+    }
+
+    if (!documents.empty()) {
+      // Rows are read in order, so the first chunk of each target holds its
+      // least documents and is bounded by the empty path.
+      std::string chunk_prefix =
+          LevelDbTargetDocumentChunkKey::KeyPrefix(target_id);
+      auto chunk_it = transaction.NewIterator();
+      chunk_it->Seek(chunk_prefix);
+      bool first_chunk = !chunk_it->Valid() ||
+                         !absl::StartsWith(chunk_it->key(), chunk_prefix);
+      ResourcePath bound =
+          first_chunk ? ResourcePath{} : documents.front().path();
+      transaction.Put(LevelDbTargetDocumentChunkKey::Key(target_id, bound),
+                      LevelDbTargetDocumentChunkKey::EncodeDocumentKeys(
+                          documents.begin(), documents.end()));
+    }
+
+    if (!more) {
+      SaveVersion(8, &transaction);
+    }
+    transaction.Commit();
   }
+}
 
-  SaveVersion(6, &transaction);
+/**
+ * Migration 9.
+ *
+ * Indexes every target by its sequence number. Any index rows already present
+ * were written before a downgrade and may be stale, so they are dropped first.
+ */
+void IndexTargetSequenceNumbers(leveldb::DB* db) {
+  DeleteEverythingWithPrefix(LevelDbTargetSequenceKey::KeyPrefix(), db);
+
+  LevelDbTransaction transaction(db, "Index target sequence numbers");
+  std::string prefix = LevelDbTargetKey::KeyPrefix();
+  auto it = transaction.NewIterator();
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    StringReader reader(it->value());
+    auto target = Message<firestore_client_Target>::TryParse(&reader);
+    HARD_ASSERT(reader.status().ok(), "Failed to deserialize Target");
+    transaction.Put(
+        LevelDbTargetSequenceKey::Key(target->last_listen_sequence_number,
+                                      target->target_id),
+        "");
+  }
+  SaveVersion(9, &transaction);
   transaction.Commit();
 }
 
+// The number of rows each step of a backfill indexes.
+const size_t kBackfillChunkSize = 1000;
+
+void RunSchemaMigrations(leveldb::DB* db,
+                         LevelDbMigrations::SchemaVersion to_version) {
+  LevelDbMigrations::SchemaVersion from_version =
+      LevelDbMigrations::ReadSchemaVersion(db);
+  // If this is a downgrade, just save the downgrade version so we can
+  // detect it when we go to upgrade again, allowing us to rerun the
+  // data migrations.
+  if (from_version > to_version) {
+    LevelDbTransaction transaction(db, "Save downgrade version");
+    SaveVersion(to_version, &transaction);
+    transaction.Commit();
+    return;
+  }
+
+  // This must run unconditionally because schema migrations were added to iOS
+  // after the first release. There may be clients that have never run any
+  // migrations that have existing targets.
+  if (from_version < 3 && to_version >= 3) {
+    ClearQueryCache(db);
+  }
+
+  if (from_version < 4 && to_version >= 4) {
+    EnsureSentinelRows(db);
+  }
+
+  if (from_version < 5 && to_version >= 5) {
+    RemoveAcknowledgedMutations(db);
+  }
+
+  if (from_version < 6 && to_version >= 6) {
+    StartCollectionParentsBackfill(db);
+  }
+
+  if (from_version < 7 && to_version >= 7) {
+    StartCollectionGroupDocumentsBackfill(db);
+  }
+
+  if (from_version < 8 && to_version >= 8) {
+    ChunkTargetDocuments(db);
+  }
+
+  if (from_version < 9 && to_version >= 9) {
+    IndexTargetSequenceNumbers(db);
+  }
+}
+
 }  // namespace
 
 LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
@@ -322,41 +538,87 @@ LevelDbMigrations::SchemaVersion LevelDbMigrations::ReadSchemaVersion(
   }
 }
 
+void LevelDbMigrations::StartMigrations(leveldb::DB* db) {
+  RunSchemaMigrations(db, kSchemaVersion);
+}
+
 void LevelDbMigrations::RunMigrations(leveldb::DB* db) {
   RunMigrations(db, kSchemaVersion);
 }
 
 void LevelDbMigrations::RunMigrations(leveldb::DB* db,
                                       SchemaVersion to_version) {
-  SchemaVersion from_version = ReadSchemaVersion(db);
-  // If this is a downgrade, just save the downgrade version so we can
-  // detect it when we go to upgrade again, allowing us to rerun the
-  // data migrations.
-  if (from_version > to_version) {
-    LevelDbTransaction transaction(db, "Save downgrade version");
-    SaveVersion(to_version, &transaction);
+  RunSchemaMigrations(db, to_version);
+
+  bool more = true;
+  while (more) {
+    LevelDbTransaction transaction(db, "Backfill");
+    more = ContinueBackfill(&transaction, kBackfillChunkSize);
     transaction.Commit();
-    return;
   }
+}
 
-  // This must run unconditionally because schema migrations were added to iOS
-  // after the first release. There may be clients that have never run any
-  // migrations that have existing targets.
-  if (from_version < 3 && to_version >= 3) {
-    ClearQueryCache(db);
+bool LevelDbMigrations::ContinueBackfill(LevelDbTransaction* transaction,
+                                         size_t max_rows) {
+  std::string position;
+  if (!transaction->Get(LevelDbCollectionParentsBackfillKey::Key(), &position)
+           .ok()) {
+    return ContinueCollectionGroupDocumentsBackfill(transaction, max_rows);
   }
 
-  if (from_version < 4 && to_version >= 4) {
-    EnsureSentinelRows(db);
+  MemoryCollectionParentIndex cache;
+  size_t rows = 0;
+  bool done = VisitUnindexedDocumentKeys(
+      transaction, &position, [&](const DocumentKey& key) {
+        if (rows == max_rows) return false;
+
+        EnsureCollectionParentRow(transaction, &cache, key);
+        ++rows;
+        return true;
+      });
+
+  if (done) {
+    transaction->Delete(LevelDbCollectionParentsBackfillKey::Key());
+  } else {
+    transaction->Put(LevelDbCollectionParentsBackfillKey::Key(), position);
   }
+  // The collection group documents backfill, if pending, continues in the
+  // next call.
+  return !done || IsCollectionGroupDocumentsBackfillPending(transaction);
+}
 
-  if (from_version < 5 && to_version >= 5) {
-    RemoveAcknowledgedMutations(db);
-  }
+bool LevelDbMigrations::IsCollectionGroupDocumentsBackfillPending(
+    LevelDbTransaction* transaction) {
+  std::string unused_position;
+  return transaction
+      ->Get(LevelDbCollectionGroupDocumentsBackfillKey::Key(),
+            &unused_position)
+      .ok();
+}
 
-  if (from_version < 6 && to_version >= 6) {
-    EnsureCollectionParentsIndex(db);
+bool LevelDbMigrations::AddUnindexedCollectionParents(
+    LevelDbTransaction* transaction,
+    const std::string& collection_id,
+    std::vector<ResourcePath>* parents) {
+  std::string position;
+  if (!transaction->Get(LevelDbCollectionParentsBackfillKey::Key(), &position)
+           .ok()) {
+    return false;
   }
+
+  VisitUnindexedDocumentKeys(
+      transaction, &position, [&](const DocumentKey& key) {
+        const ResourcePath& path = key.path();
+        if (path.size() >= 2 && path[path.size() - 2] == collection_id) {
+          ResourcePath parent = path.PopLast().PopLast();
+          if (std::find(parents->begin(), parents->end(), parent) ==
+              parents->end()) {
+            parents->push_back(std::move(parent));
+          }
+        }
+        return true;
+      });
+  return true;
 }
 
 }  // namespace local
@@ -18,9 +18,12 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MIGRATIONS_H_
 
 #include <cstdint>
+#include <string>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -38,15 +41,50 @@ class LevelDbMigrations {
 
   /**
    * Runs any migrations needed to bring the given database up to the current
-   * schema version
+   * schema version, except that migrations that backfill an index over the
+   * whole cache only record where to start. `ContinueBackfill` then builds the
+   * index a chunk at a time, so that opening a large cache isn't held up by it.
+   */
+  static void StartMigrations(leveldb::DB* db);
+
+  /**
+   * Runs any migrations needed to bring the given database up to the current
+   * schema version, including any backfill.
    */
   static void RunMigrations(leveldb::DB* db);
 
   /**
    * Runs any migrations needed to bring the given database up to the given
-   * schema version
+   * schema version, including any backfill.
    */
   static void RunMigrations(leveldb::DB* db, SchemaVersion version);
+
+  /**
+   * Indexes up to `max_rows` more rows for the first pending backfill, if any,
+   * and records how far it got so that the next call picks up from there.
+   * Returns true if any backfill isn't complete yet.
+   */
+  static bool ContinueBackfill(LevelDbTransaction* transaction,
+                               size_t max_rows);
+
+  /**
+   * While the collection parents index is being backfilled, scans the rows the
+   * backfill hasn't reached yet for parents of collections with the given ID,
+   * and adds those missing from `parents`. Returns false, without scanning, if
+   * the index is complete.
+   */
+  static bool AddUnindexedCollectionParents(
+      LevelDbTransaction* transaction,
+      const std::string& collection_id,
+      std::vector<model::ResourcePath>* parents);
+
+  /**
+   * Returns true while the collection group documents index is being
+   * backfilled, during which it is missing documents and can't be used to
+   * answer queries.
+   */
+  static bool IsCollectionGroupDocumentsBackfillPending(
+      LevelDbTransaction* transaction);
 };
 
 }  // namespace local
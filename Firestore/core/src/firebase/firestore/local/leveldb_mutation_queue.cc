@@ -135,6 +135,31 @@ LevelDbMutationQueue::LevelDbMutationQueue(const User& user,
 void LevelDbMutationQueue::Start() {
   next_batch_id_ = LoadNextBatchIdFromDb(db_->ptr());
   metadata_ = MetadataForKey(mutation_queue_key());
+
+  batch_count_ = 0;
+  byte_size_ = 0;
+  std::string batch_prefix = LevelDbMutationKey::KeyPrefix(user_id_);
+  auto batch_iterator = db_->current_transaction()->NewIterator();
+  for (batch_iterator->Seek(batch_prefix);
+       batch_iterator->Valid() &&
+       absl::StartsWith(batch_iterator->key(), batch_prefix);
+       batch_iterator->Next()) {
+    batch_count_++;
+    byte_size_ += static_cast<int64_t>(batch_iterator->value().size());
+  }
+
+  pending_mutation_counts_.clear();
+  std::string index_prefix = LevelDbDocumentMutationKey::KeyPrefix(user_id_);
+  auto index_iterator = db_->current_transaction()->NewIterator();
+  LevelDbDocumentMutationKey row_key;
+  for (index_iterator->Seek(index_prefix); index_iterator->Valid();
+       index_iterator->Next()) {
+    if (!absl::StartsWith(index_iterator->key(), index_prefix) ||
+        !row_key.Decode(index_iterator->key())) {
+      break;
+    }
+    CountPendingMutation(row_key.document_key(), 1);
+  }
 }
 
 bool LevelDbMutationQueue::IsEmpty() {
@@ -165,7 +190,12 @@ MutationBatch LevelDbMutationQueue::AddMutationBatch(
   MutationBatch batch(batch_id, local_write_time, std::move(base_mutations),
                       std::move(mutations));
   std::string key = mutation_batch_key(batch_id);
-  db_->current_transaction()->Put(key, serializer_->EncodeMutationBatch(batch));
+  auto message = serializer_->EncodeMutationBatch(batch);
+  db_->current_transaction()->Put(key, message);
+  db_->RequireDurableCommit();
+  change_count_++;
+  batch_count_++;
+  byte_size_ += static_cast<int64_t>(nanopb::EncodedSize(message));
 
   // Store an empty value in the index which is equivalent to serializing a
   // GPBEmpty message. In the future if we wanted to store some other kind of
@@ -181,6 +211,12 @@ MutationBatch LevelDbMutationQueue::AddMutationBatch(
         mutation.key().path().PopLast());
   }
 
+  // Count index rows rather than mutations, since a batch can mutate the same
+  // document more than once.
+  for (const DocumentKey& key : batch.keys()) {
+    CountPendingMutation(key, 1);
+  }
+
   return batch;
 }
 
@@ -200,13 +236,42 @@ void LevelDbMutationQueue::RemoveMutationBatch(const MutationBatch& batch) {
               "Mutation batch %s not found; found %s", DescribeKey(key),
               DescribeKey(check_iterator->key()));
 
+  byte_size_ -= static_cast<int64_t>(check_iterator->value().size());
+  batch_count_--;
+
   db_->current_transaction()->Delete(key);
+  db_->RequireDurableCommit();
+  change_count_++;
 
   for (const Mutation& mutation : batch.mutations()) {
     key = LevelDbDocumentMutationKey::Key(user_id_, mutation.key(), batch_id);
     db_->current_transaction()->Delete(key);
     db_->reference_delegate()->RemoveMutationReference(mutation.key());
   }
+
+  for (const DocumentKey& key : batch.keys()) {
+    CountPendingMutation(key, -1);
+  }
+}
+
+void LevelDbMutationQueue::ReplaceLastMutationBatch(
+    const MutationBatch& batch) {
+  BatchId batch_id = batch.batch_id();
+  HARD_ASSERT(batch_id == next_batch_id_ - 1,
+              "Can only replace the last entry of the mutation queue");
+
+  std::string key = mutation_batch_key(batch_id);
+  std::string previous;
+  if (db_->current_transaction()->Get(key, &previous).ok()) {
+    byte_size_ -= static_cast<int64_t>(previous.size());
+  }
+
+  // The document mutation index is unchanged, since the documents are.
+  auto message = serializer_->EncodeMutationBatch(batch);
+  db_->current_transaction()->Put(std::move(key), message);
+  byte_size_ += static_cast<int64_t>(nanopb::EncodedSize(message));
+  db_->RequireDurableCommit();
+  change_count_++;
 }
 
 std::vector<MutationBatch> LevelDbMutationQueue::AllMutationBatches() {
@@ -266,6 +331,12 @@ LevelDbMutationQueue::AllMutationBatchesAffectingDocumentKey(
   return AllMutationBatchesAffectingDocumentKeys(DocumentKeySet{key});
 }
 
+bool LevelDbMutationQueue::MayHaveMutationsInCollection(
+    const ResourcePath& collection_path) {
+  return pending_mutation_counts_.find(collection_path) !=
+         pending_mutation_counts_.end();
+}
+
 std::vector<MutationBatch>
 LevelDbMutationQueue::AllMutationBatchesAffectingQuery(const Query& query) {
   HARD_ASSERT(!query.IsDocumentQuery(),
@@ -275,6 +346,10 @@ LevelDbMutationQueue::AllMutationBatchesAffectingQuery(const Query& query) {
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
   const ResourcePath& query_path = query.path();
+  if (!MayHaveMutationsInCollection(query_path)) {
+    return {};
+  }
+
   size_t immediate_children_path_length = query_path.size() + 1;
 
   // TODO(mcg): Actually implement a single-collection query
@@ -497,6 +572,16 @@ MutationBatch LevelDbMutationQueue::ParseMutationBatch(
   return result;
 }
 
+void LevelDbMutationQueue::CountPendingMutation(const DocumentKey& key,
+                                                int delta) {
+  ResourcePath collection_path = key.path().PopLast();
+  int& count = pending_mutation_counts_[collection_path];
+  count += delta;
+  if (count <= 0) {
+    pending_mutation_counts_.erase(collection_path);
+  }
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
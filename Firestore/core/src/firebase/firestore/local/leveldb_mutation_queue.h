@@ -17,6 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MUTATION_QUEUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_MUTATION_QUEUE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <set>
 #include <string>
 #include <vector>
@@ -24,6 +27,7 @@
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "absl/strings/string_view.h"
@@ -69,6 +73,8 @@ class LevelDbMutationQueue : public MutationQueue {
 
   void RemoveMutationBatch(const model::MutationBatch& batch) override;
 
+  void ReplaceLastMutationBatch(const model::MutationBatch& batch) override;
+
   std::vector<model::MutationBatch> AllMutationBatches() override;
 
   std::vector<model::MutationBatch> AllMutationBatchesAffectingDocumentKeys(
@@ -88,6 +94,22 @@ class LevelDbMutationQueue : public MutationQueue {
 
   model::BatchId GetHighestUnacknowledgedBatchId() override;
 
+  uint64_t GetChangeCount() override {
+    return change_count_;
+  }
+
+  size_t GetBatchCount() override {
+    return batch_count_;
+  }
+
+  /** Returns the total size of the encoded batches stored in LevelDB. */
+  int64_t GetByteSize() override {
+    return byte_size_;
+  }
+
+  bool MayHaveMutationsInCollection(
+      const model::ResourcePath& collection_path) override;
+
   void PerformConsistencyCheck() override;
 
   nanopb::ByteString GetLastStreamToken() override;
@@ -112,6 +134,12 @@ class LevelDbMutationQueue : public MutationQueue {
 
   model::MutationBatch ParseMutationBatch(absl::string_view encoded);
 
+  /**
+   * Adjusts the number of document-mutation index rows for the collection
+   * that contains the given document.
+   */
+  void CountPendingMutation(const model::DocumentKey& key, int delta);
+
   // The LevelDbMutationQueue instance is owned by LevelDbPersistence.
   LevelDbPersistence* db_;
 
@@ -133,6 +161,24 @@ class LevelDbMutationQueue : public MutationQueue {
    */
   model::BatchId next_batch_id_;
 
+  /** Incremented whenever a batch is added or removed. */
+  uint64_t change_count_ = 0;
+
+  /**
+   * The number of batches in the queue and the total size of their rows,
+   * loaded in `Start` and kept up to date as batches are added, replaced and
+   * removed.
+   */
+  size_t batch_count_ = 0;
+  int64_t byte_size_ = 0;
+
+  /**
+   * The number of rows in the document-mutation index for each collection
+   * with pending mutations, loaded in `Start` and kept up to date as batches
+   * are added and removed. Collections without pending mutations are absent.
+   */
+  std::map<model::ResourcePath, int> pending_mutation_counts_;
+
   /**
    * A write-through cache copy of the metadata describing the current queue.
    */
@@ -23,6 +23,8 @@
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 #include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/autoid.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
@@ -37,6 +39,7 @@ namespace {
 
 using core::DatabaseInfo;
 using remote::Serializer;
+using util::Executor;
 using util::Filesystem;
 using util::Path;
 using util::Status;
@@ -45,6 +48,21 @@ using util::StringFormat;
 
 constexpr const char* kReservedPathComponent = "firestore";
 
+constexpr const char* kTrashPathComponent = "trash";
+
+/**
+ * Returns the executor that deletes cleared data. It's shared by all openers
+ * and intentionally leaked, since deletions outlive the openers that start
+ * them.
+ */
+Executor* TrashExecutor() {
+  static Executor* executor =
+      Executor::CreateSerial("com.google.firebase.firestore.trash",
+                             Executor::QualityOfService::Background)
+          .release();
+  return executor;
+}
+
 Status FromCause(const std::string& message, const Status& cause) {
   if (cause.ok()) return cause;
 
@@ -67,6 +85,11 @@ LevelDbOpener::LevelDbOpener(DatabaseInfo database_info,
 
 util::StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbOpener::Create(
     const LruParams& lru_params) {
+  return Create(lru_params, LevelDbOptions());
+}
+
+util::StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbOpener::Create(
+    const LruParams& lru_params, const LevelDbOptions& options) {
   auto maybe_dir = PrepareDataDir();
   if (!maybe_dir.ok()) return maybe_dir.status();
   Path db_data_dir = maybe_dir.ValueOrDie();
@@ -77,7 +100,7 @@ util::StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbOpener::Create(
   LocalSerializer local_serializer(std::move(remote_serializer));
 
   return LevelDbPersistence::Create(db_data_dir, std::move(local_serializer),
-                                    lru_params);
+                                    lru_params, options);
 }
 
 StatusOr<Path> LevelDbOpener::LevelDbDataDir() {
@@ -91,6 +114,12 @@ StatusOr<Path> LevelDbOpener::PrepareDataDir() {
   if (!maybe_dir.ok()) return maybe_dir;
   Path db_data_dir = std::move(maybe_dir).ValueOrDie();
 
+  // Finish deleting data cleared by a previous run.
+  Path trash_dir = TrashDir(db_data_dir);
+  if (fs_->IsDirectory(trash_dir).ok()) {
+    RemoveInBackground(trash_dir);
+  }
+
   // Check for the preferred location. If it exists, we're done.
   Status dir_status = fs_->IsDirectory(db_data_dir);
   if (dir_status.ok()) {
@@ -133,6 +162,34 @@ StatusOr<Path> LevelDbOpener::PrepareDataDir() {
   return db_data_dir;
 }
 
+Status LevelDbOpener::ClearDataDir() {
+  StatusOr<Path> maybe_dir = LevelDbDataDir();
+  if (!maybe_dir.ok()) return maybe_dir.status();
+  Path db_data_dir = std::move(maybe_dir).ValueOrDie();
+
+  Status dir_status = fs_->IsDirectory(db_data_dir);
+  if (dir_status.code() == Error::kNotFound) {
+    return Status::OK();
+  }
+
+  // Renaming within the same parent directory is atomic and doesn't depend on
+  // the size of the data, unlike deleting it.
+  Path trash_dir = TrashDir(db_data_dir);
+  Path trash_path = trash_dir.AppendUtf8(util::CreateAutoId());
+  Status moved = fs_->RecursivelyCreateDir(trash_dir);
+  if (moved.ok()) {
+    moved = fs_->Rename(db_data_dir, trash_path);
+  }
+  if (!moved.ok()) {
+    LOG_WARN("Could not move %s to the trash, deleting it in place: %s",
+             db_data_dir.ToUtf8String(), moved.ToString());
+    return fs_->RecursivelyRemove(db_data_dir);
+  }
+
+  RemoveInBackground(std::move(trash_path));
+  return Status::OK();
+}
+
 StatusOr<Path> LevelDbOpener::FirestoreAppDataDir() {
   if (app_data_dir_.empty()) {
     auto maybe_dir = fs_->AppDataDir(kReservedPathComponent);
@@ -178,6 +235,21 @@ Path LevelDbOpener::StorageDir(const Path& base_path) {
                         project_key, "main");
 }
 
+Path LevelDbOpener::TrashDir(const Path& db_data_dir) {
+  return db_data_dir.Dirname().AppendUtf8(kTrashPathComponent);
+}
+
+void LevelDbOpener::RemoveInBackground(Path path) {
+  Filesystem* fs = fs_;
+  TrashExecutor()->Execute([fs, path] {
+    Status removed = fs->RecursivelyRemove(path);
+    if (!removed.ok()) {
+      LOG_WARN("Could not delete cleared data in %s: %s", path.ToUtf8String(),
+               removed.ToString());
+    }
+  });
+}
+
 StatusOr<Path> LevelDbOpener::MigrateDataDir(
     const firebase::firestore::util::Path& legacy_db_data_dir,
     const firebase::firestore::util::Path& db_data_dir) {
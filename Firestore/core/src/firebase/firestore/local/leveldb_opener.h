@@ -37,6 +37,7 @@ class StatusOr;
 namespace local {
 
 class LevelDbPersistence;
+struct LevelDbOptions;
 struct LruParams;
 
 class LevelDbOpener {
@@ -78,6 +79,13 @@ class LevelDbOpener {
   util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
       const LruParams& lru_params);
 
+  /**
+   * Creates the LevelDbPersistence instance as above, opening the database
+   * with the given tuning options.
+   */
+  util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
+      const LruParams& lru_params, const LevelDbOptions& options);
+
   /**
    * Finds a suitable directory to serve as the root of all Firestore local
    * storage for all Firestore instances.
@@ -96,6 +104,17 @@ class LevelDbOpener {
    */
   util::StatusOr<util::Path> LevelDbDataDir();
 
+  /**
+   * Deletes the data of the single Firestore instance named by the
+   * DatabaseInfo passed to the `LevelDbOpener` constructor.
+   *
+   * The data directory is moved into the instance's trash directory, so that
+   * it's gone as soon as this returns, and then deleted in the background.
+   * Anything left in the trash, e.g. because the app exited before the
+   * deletion finished, is deleted the next time the instance is opened.
+   */
+  util::Status ClearDataDir();
+
  private:
   /**
    * Prepares the directory that contains the instance's data.
@@ -119,6 +138,15 @@ class LevelDbOpener {
 
   void RecursivelyCleanupLegacyDirs(util::Path legacy_dir);
 
+  /**
+   * Returns the directory that holds cleared data of the instance whose data
+   * is in `db_data_dir` until it's deleted.
+   */
+  static util::Path TrashDir(const util::Path& db_data_dir);
+
+  /** Deletes the given path on a low-priority background executor. */
+  void RemoveInBackground(util::Path path);
+
   core::DatabaseInfo database_info_;
   util::Path app_data_dir_;
   util::Path legacy_app_data_dir_;
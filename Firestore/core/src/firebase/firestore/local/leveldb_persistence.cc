@@ -16,7 +16,10 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <limits>
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
@@ -34,6 +37,7 @@
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/string_util.h"
+#include "Firestore/core/src/firebase/firestore/util/thread_local.h"
 #include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 
@@ -51,6 +55,24 @@ using util::Status;
 using util::StatusOr;
 using util::StringFormat;
 
+const char* kDocumentSnapshotFileName = "remote_documents.snapshot";
+
+// The size of the block cache LevelDB creates when given none.
+const size_t kDefaultBlockCacheSizeBytes = 8 * 1024 * 1024;
+
+// The number of changed rows past which group commit writes the pending
+// transactions right away rather than waiting for the scheduled flush.
+const size_t kMaxGroupCommitChanges = 1000;
+
+// The instance whose read-only transaction a thread is running, if any, and
+// that transaction.
+struct ReadOnlyState {
+  const LevelDbPersistence* owner = nullptr;
+  LevelDbTransaction* transaction = nullptr;
+};
+
+util::ThreadLocal<ReadOnlyState> read_only_state;
+
 /**
  * Finds all user ids in the database based on the existence of a mutation
  * queue.
@@ -74,10 +96,32 @@ std::set<std::string> CollectUserSet(LevelDbTransaction* transaction) {
   return result;
 }
 
+/**
+ * Returns the block cache of the given size shared by all databases opened
+ * with `LevelDbOptions::shared_block_cache`, creating it if no open database
+ * uses it.
+ */
+std::shared_ptr<leveldb::Cache> SharedBlockCache(size_t size_bytes) {
+  static std::mutex mutex;
+  static auto* caches = new std::map<size_t, std::weak_ptr<leveldb::Cache>>();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::weak_ptr<leveldb::Cache>& entry = (*caches)[size_bytes];
+  std::shared_ptr<leveldb::Cache> cache = entry.lock();
+  if (!cache) {
+    cache.reset(leveldb::NewLRUCache(size_bytes));
+    entry = cache;
+  }
+  return cache;
+}
+
 }  // namespace
 
 util::StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
-    util::Path dir, LocalSerializer serializer, const LruParams& lru_params) {
+    util::Path dir,
+    LocalSerializer serializer,
+    const LruParams& lru_params,
+    const LevelDbOptions& options) {
   auto* fs = Filesystem::Default();
   Status status = EnsureDirectory(dir);
   if (!status.ok()) return status;
@@ -85,11 +129,26 @@ util::StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
   status = fs->ExcludeFromBackups(dir);
   if (!status.ok()) return status;
 
-  StatusOr<std::unique_ptr<DB>> created = OpenDb(dir);
+  std::shared_ptr<leveldb::Cache> block_cache;
+  if (options.shared_block_cache) {
+    block_cache = SharedBlockCache(options.block_cache_size_bytes > 0
+                                       ? options.block_cache_size_bytes
+                                       : kDefaultBlockCacheSizeBytes);
+  } else if (options.block_cache_size_bytes > 0) {
+    block_cache.reset(leveldb::NewLRUCache(options.block_cache_size_bytes));
+  }
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy;
+  if (options.bloom_filter_bits_per_key > 0) {
+    filter_policy.reset(
+        leveldb::NewBloomFilterPolicy(options.bloom_filter_bits_per_key));
+  }
+
+  StatusOr<std::unique_ptr<DB>> created =
+      OpenDb(dir, options, block_cache.get(), filter_policy.get());
   if (!created.ok()) return created.status();
 
   std::unique_ptr<DB> db = std::move(created).ValueOrDie();
-  LevelDbMigrations::RunMigrations(db.get());
+  LevelDbMigrations::StartMigrations(db.get());
 
   LevelDbTransaction transaction(db.get(), "Start LevelDB");
   std::set<std::string> users = CollectUserSet(&transaction);
@@ -97,23 +156,34 @@ util::StatusOr<std::unique_ptr<LevelDbPersistence>> LevelDbPersistence::Create(
 
   // Explicit conversion is required to allow the StatusOr to be created.
   std::unique_ptr<LevelDbPersistence> result(
-      new LevelDbPersistence(std::move(db), std::move(dir), std::move(users),
-                             std::move(serializer), lru_params));
+      new LevelDbPersistence(std::move(block_cache), std::move(filter_policy),
+                             std::move(db), std::move(dir), std::move(users),
+                             std::move(serializer), lru_params,
+                             options.sync_mutation_queue_writes,
+                             options.compress_documents));
   return {std::move(result)};
 }
 
-LevelDbPersistence::LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
-                                       util::Path directory,
-                                       std::set<std::string> users,
-                                       LocalSerializer serializer,
-                                       const LruParams& lru_params)
-    : db_(std::move(db)),
+LevelDbPersistence::LevelDbPersistence(
+    std::shared_ptr<leveldb::Cache> block_cache,
+    std::unique_ptr<const leveldb::FilterPolicy> filter_policy,
+    std::unique_ptr<leveldb::DB> db,
+    util::Path directory,
+    std::set<std::string> users,
+    LocalSerializer serializer,
+    const LruParams& lru_params,
+    bool sync_mutation_queue_writes,
+    bool compress_documents)
+    : block_cache_(std::move(block_cache)),
+      filter_policy_(std::move(filter_policy)),
+      db_(std::move(db)),
       directory_(std::move(directory)),
       users_(std::move(users)),
-      serializer_(std::move(serializer)) {
+      serializer_(std::move(serializer)),
+      sync_mutation_queue_writes_(sync_mutation_queue_writes) {
   target_cache_ = absl::make_unique<LevelDbTargetCache>(this, &serializer_);
-  document_cache_ =
-      absl::make_unique<LevelDbRemoteDocumentCache>(this, &serializer_);
+  document_cache_ = absl::make_unique<LevelDbRemoteDocumentCache>(
+      this, &serializer_, compress_documents);
   index_manager_ = absl::make_unique<LevelDbIndexManager>(this);
   reference_delegate_ =
       absl::make_unique<LevelDbLruReferenceDelegate>(this, lru_params);
@@ -140,12 +210,24 @@ Status LevelDbPersistence::EnsureDirectory(const Path& dir) {
   return Status::OK();
 }
 
-StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(const Path& dir) {
-  leveldb::Options options;
-  options.create_if_missing = true;
+StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(
+    const Path& dir,
+    const LevelDbOptions& options,
+    leveldb::Cache* block_cache,
+    const leveldb::FilterPolicy* filter_policy) {
+  leveldb::Options db_options;
+  db_options.create_if_missing = true;
+  db_options.block_cache = block_cache;
+  db_options.filter_policy = filter_policy;
+  if (options.write_buffer_size_bytes > 0) {
+    db_options.write_buffer_size = options.write_buffer_size_bytes;
+  }
+  if (options.max_open_files > 0) {
+    db_options.max_open_files = options.max_open_files;
+  }
 
   DB* database = nullptr;
-  leveldb::Status status = DB::Open(options, dir.ToUtf8String(), &database);
+  leveldb::Status status = DB::Open(db_options, dir.ToUtf8String(), &database);
   if (!status.ok()) {
     return Status{Error::kInternal,
                   StringFormat("Failed to open LevelDB database at %s",
@@ -159,6 +241,11 @@ StatusOr<std::unique_ptr<DB>> LevelDbPersistence::OpenDb(const Path& dir) {
 // MARK: - LevelDB utilities
 
 LevelDbTransaction* LevelDbPersistence::current_transaction() {
+  ReadOnlyState& read_only = read_only_state.get();
+  if (read_only.owner == this) {
+    return read_only.transaction;
+  }
+
   HARD_ASSERT(transaction_ != nullptr,
               "Attempting to access transaction before one has started");
   return transaction_.get();
@@ -173,8 +260,7 @@ util::Status LevelDbPersistence::ClearPersistence(
   Path leveldb_dir = std::move(maybe_data_dir).ValueOrDie();
 
   LOG_DEBUG("Clearing persistence for path: %s", leveldb_dir.ToUtf8String());
-  auto* fs = Filesystem::Default();
-  return fs->RecursivelyRemove(leveldb_dir);
+  return opener.ClearDataDir();
 }
 
 int64_t LevelDbPersistence::CalculateByteSize() {
@@ -194,6 +280,28 @@ int64_t LevelDbPersistence::CalculateByteSize() {
   return count;
 }
 
+void LevelDbPersistence::ConfigureDocumentSnapshot(bool enabled) {
+  Run("Configure document snapshot", [&] {
+    document_cache_->ConfigureSnapshot(
+        enabled, directory_.AppendUtf8(kDocumentSnapshotFileName));
+  });
+}
+
+void LevelDbPersistence::CompactDocumentSnapshot() {
+  // The snapshot is built from the rows in LevelDB, which must then include
+  // every change made so far.
+  FlushPendingCommits();
+  Run("Compact document snapshot",
+      [&] { document_cache_->CompactSnapshot(); });
+}
+
+bool LevelDbPersistence::ContinueMigrations(size_t max_rows) {
+  return Run("Continue migrations", [&] {
+    return LevelDbMigrations::ContinueBackfill(current_transaction(),
+                                               max_rows);
+  });
+}
+
 // MARK: - Persistence
 
 model::ListenSequenceNumber LevelDbPersistence::current_sequence_number()
@@ -204,6 +312,10 @@ model::ListenSequenceNumber LevelDbPersistence::current_sequence_number()
 void LevelDbPersistence::Shutdown() {
   HARD_ASSERT(started_, "LevelDbPersistence shutdown without start!");
   started_ = false;
+  FlushPendingCommits();
+  // Snapshot builds and prefetches in the background read from the database.
+  document_cache_->AwaitSnapshotBuild();
+  document_cache_->AwaitPrefetch();
   db_.reset();
 }
 
@@ -223,6 +335,19 @@ LevelDbRemoteDocumentCache* LevelDbPersistence::remote_document_cache() {
   return document_cache_.get();
 }
 
+size_t LevelDbPersistence::ReleaseMemory() {
+  size_t released = document_cache_->ReleaseMemory();
+  if (block_cache_) {
+    size_t charge = block_cache_->TotalCharge();
+    block_cache_->Prune();
+    size_t pruned = block_cache_->TotalCharge();
+    if (pruned < charge) {
+      released += charge - pruned;
+    }
+  }
+  return released;
+}
+
 LevelDbIndexManager* LevelDbPersistence::index_manager() {
   return index_manager_.get();
 }
@@ -236,16 +361,98 @@ void LevelDbPersistence::RunInternal(absl::string_view label,
   HARD_ASSERT(transaction_ == nullptr,
               "Starting a transaction while one is already in progress");
 
-  transaction_ = absl::make_unique<LevelDbTransaction>(db_.get(), label);
+  if (pending_transaction_) {
+    transaction_ = std::move(pending_transaction_);
+  } else {
+    transaction_ = absl::make_unique<LevelDbTransaction>(db_.get(), label);
+  }
+  int64_t keys_read = transaction_->keys_read();
   reference_delegate_->OnTransactionStarted(label);
 
   block();
 
   reference_delegate_->OnTransactionCommitted();
+  metrics()->RecordKeysRead(transaction_->keys_read() - keys_read);
+  write_version_.fetch_add(1, std::memory_order_release);
+
+  if (schedule_flush_ && !transaction_->sync() &&
+      transaction_->changed_keys() < kMaxGroupCommitChanges) {
+    pending_transaction_ = std::move(transaction_);
+    if (!flush_scheduled_) {
+      flush_scheduled_ = true;
+      schedule_flush_();
+    }
+    return;
+  }
+
+  CommitTransaction();
+}
+
+void LevelDbPersistence::CommitTransaction() {
+  auto start = std::chrono::steady_clock::now();
   transaction_->Commit();
+  auto commit_time = std::chrono::steady_clock::now() - start;
+
+  committed_version_.store(write_version(), std::memory_order_release);
+
+  metrics()->RecordTransactionCommit(
+      std::chrono::duration_cast<std::chrono::microseconds>(commit_time));
   transaction_.reset();
 }
 
+void LevelDbPersistence::EnableGroupCommit(
+    std::function<void()> schedule_flush) {
+  schedule_flush_ = std::move(schedule_flush);
+}
+
+void LevelDbPersistence::FlushPendingCommits() {
+  HARD_ASSERT(transaction_ == nullptr,
+              "Flushing commits while a transaction is in progress");
+
+  flush_scheduled_ = false;
+  if (!pending_transaction_) return;
+
+  transaction_ = std::move(pending_transaction_);
+  CommitTransaction();
+}
+
+void LevelDbPersistence::RequireDurableCommit() {
+  if (sync_mutation_queue_writes_) {
+    current_transaction()->set_sync(true);
+  }
+}
+
+int64_t LevelDbPersistence::RunReadOnly(absl::string_view label,
+                                        const std::function<void()>& block) {
+  ReadOnlyState& read_only = read_only_state.get();
+  HARD_ASSERT(read_only.owner == nullptr,
+              "Starting a read-only transaction while one is already in "
+              "progress");
+
+  // Read the version before taking the snapshot: a commit in between makes
+  // the snapshot newer than reported, which only causes a needless reconcile.
+  int64_t version = committed_version_.load(std::memory_order_acquire);
+  const leveldb::Snapshot* snapshot = db_->GetSnapshot();
+
+  leveldb::ReadOptions read_options = LevelDbTransaction::DefaultReadOptions();
+  read_options.snapshot = snapshot;
+  LevelDbTransaction transaction(db_.get(), label, read_options);
+
+  read_only.owner = this;
+  read_only.transaction = &transaction;
+  block();
+  read_only.owner = nullptr;
+  read_only.transaction = nullptr;
+
+  db_->ReleaseSnapshot(snapshot);
+  metrics()->RecordKeysRead(transaction.keys_read());
+  return version;
+}
+
+bool LevelDbPersistence::in_read_only_transaction() const {
+  return read_only_state.get().owner == this;
+}
+
 leveldb::ReadOptions StandardReadOptions() {
   // For now this is paranoid, but perhaps disable that in production builds.
   leveldb::ReadOptions options;
@@ -17,6 +17,8 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_PERSISTENCE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_PERSISTENCE_H_
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
@@ -32,6 +34,8 @@
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "leveldb/cache.h"
+#include "leveldb/filter_policy.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,6 +49,50 @@ namespace local {
 class LevelDbLruReferenceDelegate;
 struct LruParams;
 
+/** Tuning options for the LevelDB database underlying LevelDbPersistence. */
+struct LevelDbOptions {
+  /** The size of the block cache in bytes, or zero for LevelDB's default. */
+  size_t block_cache_size_bytes = 0;
+
+  /**
+   * The number of bits per key of the bloom filter attached to each table, or
+   * zero for no filter. Filters let point lookups of missing keys skip most of
+   * the tables that can't contain them.
+   */
+  int bloom_filter_bits_per_key = 10;
+
+  /** The size of the write buffer in bytes, or zero for LevelDB's default. */
+  size_t write_buffer_size_bytes = 0;
+
+  /**
+   * Whether the database shares its block cache with every other database in
+   * the process opened with this option and the same block cache size. A
+   * process that opens many databases then caches a bounded amount of data
+   * overall, which the busiest databases get the most of.
+   */
+  bool shared_block_cache = false;
+
+  /**
+   * The number of table files LevelDB keeps open, or zero for LevelDB's
+   * default. Bounds the file descriptors held by each database.
+   */
+  int max_open_files = 0;
+
+  /**
+   * Whether transactions that change the mutation queue wait until their
+   * changes have reached the disk. Local writes can't be recovered from the
+   * backend if the device crashes before they're sent, unlike the rest of the
+   * cache, whose transactions are never synced.
+   */
+  bool sync_mutation_queue_writes = false;
+
+  /**
+   * Whether documents are written to the remote document cache compressed.
+   * See LevelDbRemoteDocumentCache.
+   */
+  bool compress_documents = false;
+};
+
 /** A LevelDB-backed implementation of the Persistence interface. */
 class LevelDbPersistence : public Persistence {
  public:
@@ -53,12 +101,71 @@ class LevelDbPersistence : public Persistence {
    * containing details of the failure.
    */
   static util::StatusOr<std::unique_ptr<LevelDbPersistence>> Create(
-      util::Path dir, LocalSerializer serializer, const LruParams& lru_params);
+      util::Path dir,
+      LocalSerializer serializer,
+      const LruParams& lru_params,
+      const LevelDbOptions& options = LevelDbOptions());
 
   ~LevelDbPersistence();
 
+  /**
+   * Returns the transaction in progress: the calling thread's read-only
+   * transaction if it is within `RunReadOnly`, otherwise the read-write
+   * transaction started by `Run`.
+   */
   LevelDbTransaction* current_transaction();
 
+  /**
+   * Runs `block` in a transaction that reads from a consistent snapshot of the
+   * database. Unlike `Run`, this may be called from any thread, concurrently
+   * with read-write transactions on the worker queue, so that long reads such
+   * as full collection scans don't hold up writes.
+   *
+   * Only reads of the remote document cache are supported within `block`; the
+   * other caches keep state in memory that belongs to the worker queue. Writes
+   * made within `block` are discarded.
+   *
+   * @return The `write_version()` that the snapshot reflects. Results read
+   *     within `block` are still current if `write_version()` hasn't changed
+   *     since; otherwise the caller should reconcile them with the writes that
+   *     have been committed in the meantime. Transactions held by group commit
+   *     aren't in the snapshot, so the version returned precedes them.
+   */
+  int64_t RunReadOnly(absl::string_view label,
+                      const std::function<void()>& block);
+
+  /**
+   * Enables group commit: rather than writing each read-write transaction to
+   * LevelDB as it commits, keeps its changes pending so that the transactions
+   * that follow add to them, and later writes them all at once in
+   * `FlushPendingCommits`. Transactions read through the pending changes, so
+   * they see the same data either way.
+   *
+   * `schedule_flush` is called whenever a transaction leaves changes pending
+   * and no flush is due yet. It should arrange for `FlushPendingCommits` to
+   * run on the worker queue shortly after.
+   */
+  void EnableGroupCommit(std::function<void()> schedule_flush);
+
+  /** Writes the changes held by group commit to LevelDB, if there are any. */
+  void FlushPendingCommits();
+
+  /**
+   * Marks the current read-write transaction as holding changes that can't be
+   * recovered from the backend, which syncs it on commit if
+   * `LevelDbOptions::sync_mutation_queue_writes` is set. Group commit doesn't
+   * hold on to such transactions.
+   */
+  void RequireDurableCommit();
+
+  /** Whether the calling thread is within `RunReadOnly` on this instance. */
+  bool in_read_only_transaction() const;
+
+  /** The number of read-write transactions committed so far. */
+  int64_t write_version() const {
+    return write_version_.load(std::memory_order_acquire);
+  }
+
   leveldb::DB* ptr() {
     return db_.get();
   }
@@ -71,6 +178,25 @@ class LevelDbPersistence : public Persistence {
 
   int64_t CalculateByteSize();
 
+  /**
+   * Enables or disables the read-optimized snapshot of the remote document
+   * cache, stored next to the LevelDB files.
+   */
+  void ConfigureDocumentSnapshot(bool enabled);
+
+  /**
+   * Advances the rebuild of the remote document snapshot, if it is enabled.
+   * See LevelDbRemoteDocumentCache::CompactSnapshot.
+   */
+  void CompactDocumentSnapshot();
+
+  /**
+   * Advances the migrations left to run in the background by up to `max_rows`
+   * rows. Returns true while any remain. See
+   * LevelDbMigrations::ContinueBackfill.
+   */
+  bool ContinueMigrations(size_t max_rows);
+
   // MARK: Persistence overrides
 
   model::ListenSequenceNumber current_sequence_number() const override;
@@ -88,25 +214,45 @@ class LevelDbPersistence : public Persistence {
 
   LevelDbLruReferenceDelegate* reference_delegate() override;
 
+  /**
+   * Also evicts the blocks in the LevelDB block cache that no read is using.
+   * A shared block cache is pruned for all the databases using it.
+   */
+  size_t ReleaseMemory() override;
+
  protected:
   void RunInternal(absl::string_view label,
                    std::function<void()> block) override;
 
  private:
-  LevelDbPersistence(std::unique_ptr<leveldb::DB> db,
+  LevelDbPersistence(std::shared_ptr<leveldb::Cache> block_cache,
+                     std::unique_ptr<const leveldb::FilterPolicy> filter_policy,
+                     std::unique_ptr<leveldb::DB> db,
                      util::Path directory,
                      std::set<std::string> users,
                      LocalSerializer serializer,
-                     const LruParams& lru_params);
+                     const LruParams& lru_params,
+                     bool sync_mutation_queue_writes,
+                     bool compress_documents);
 
   /**
    * Ensures that the given directory exists.
    */
   static util::Status EnsureDirectory(const util::Path& dir);
 
-  /** Opens the database within the given directory. */
+  /**
+   * Opens the database within the given directory. The block cache and filter
+   * policy may be null, and must outlive the database.
+   */
   static util::StatusOr<std::unique_ptr<leveldb::DB>> OpenDb(
-      const util::Path& dir);
+      const util::Path& dir,
+      const LevelDbOptions& options,
+      leveldb::Cache* block_cache,
+      const leveldb::FilterPolicy* filter_policy);
+
+  // Referenced by the options of `db_`, so declared first to outlive it.
+  std::shared_ptr<leveldb::Cache> block_cache_;
+  std::unique_ptr<const leveldb::FilterPolicy> filter_policy_;
 
   std::unique_ptr<leveldb::DB> db_;
 
@@ -114,6 +260,7 @@ class LevelDbPersistence : public Persistence {
   std::set<std::string> users_;
   LocalSerializer serializer_;
   bool started_ = false;
+  bool sync_mutation_queue_writes_ = false;
 
   std::unique_ptr<LevelDbMutationQueue> current_mutation_queue_;
   std::unique_ptr<LevelDbTargetCache> target_cache_;
@@ -121,7 +268,20 @@ class LevelDbPersistence : public Persistence {
   std::unique_ptr<LevelDbIndexManager> index_manager_;
   std::unique_ptr<LevelDbLruReferenceDelegate> reference_delegate_;
 
+  /** Writes the changes of `transaction_` to LevelDB and clears it. */
+  void CommitTransaction();
+
   std::unique_ptr<LevelDbTransaction> transaction_;
+  std::atomic<int64_t> write_version_{0};
+
+  // The `write_version_` of the last transaction written to LevelDB.
+  std::atomic<int64_t> committed_version_{0};
+
+  // The transaction holding the changes not yet written, if group commit is
+  // enabled.
+  std::unique_ptr<LevelDbTransaction> pending_transaction_;
+  std::function<void()> schedule_flush_;
+  bool flush_scheduled_ = false;
 };
 
 /** Returns a standard set of read options. */
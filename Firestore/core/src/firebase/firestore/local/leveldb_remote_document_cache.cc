@@ -16,24 +16,47 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_remote_document_cache.h"
 
+#include <pb_decode.h>
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <map>
+#include <set>
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 
+#include "Firestore/core/src/firebase/firestore/core/filter.h"
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/document_compression.h"
+#include "Firestore/core/src/firebase/firestore/local/document_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_util.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
-#include "Firestore/core/src/firebase/firestore/util/background_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/md5.h"
+#include "Firestore/core/src/firebase/firestore/util/parallel_for.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/src/firebase/firestore/util/string_util.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/escaping.h"
+#include "absl/strings/match.h"
+#include "absl/types/optional.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -41,67 +64,203 @@ namespace firestore {
 namespace local {
 namespace {
 
+using core::Filter;
 using core::Query;
 using leveldb::Status;
 using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
+using model::DocumentState;
+using model::FieldMask;
+using model::FieldPath;
+using model::FieldValue;
 using model::MaybeDocument;
 using model::MaybeDocumentMap;
+using model::ObjectValue;
 using model::OptionalMaybeDocumentMap;
 using model::ResourcePath;
 using model::SnapshotVersion;
 using nanopb::ByteString;
 using nanopb::Message;
 using nanopb::StringReader;
-using util::BackgroundQueue;
 using util::Executor;
+using util::Filesystem;
+using util::ParallelCollect;
+using util::Path;
+
+/** The number of decoded documents kept in memory by `hot_documents_`. */
+constexpr size_t kHotDocumentCacheCapacity = 1000;
 
 /**
- * An accumulator for results produced asynchronously. This accumulates
- * values in a vector to avoid contention caused by accumulating into more
- * complex structures like immutable::SortedMap.
+ * The encoded size from which a document's large values are stored in chunks
+ * of their own, so that updating its other fields doesn't rewrite them.
  */
-template <typename T>
-class AsyncResults {
- public:
-  void Insert(T&& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(std::move(value));
+constexpr size_t kChunkedDocumentMinBytes = 256 * 1024;
+
+/** The approximate size from which a value of a chunked document is moved. */
+constexpr size_t kMinChunkBytes = 16 * 1024;
+
+/**
+ * The number of documents written to a collection from which its compression
+ * dictionary is built.
+ */
+constexpr size_t kCompressionDictionarySamples = 8;
+
+/**
+ * Returns true if `encoded`, a row written by `EncodeDocumentRow`, holds a
+ * `NoDocument` or an `UnknownDocument`. Only the header of the first field is
+ * read: the document type is a oneof of the lowest-numbered fields, so it's
+ * always encoded first. Compressed rows, which only hold Documents, start
+ * with a byte that doesn't decode as a tag.
+ */
+bool IsTombstoneRow(absl::string_view encoded) {
+  pb_istream_t stream = pb_istream_from_buffer(
+      reinterpret_cast<const pb_byte_t*>(encoded.data()), encoded.size());
+  pb_wire_type_t wire_type{};
+  uint32_t tag = 0;
+  bool eof = false;
+  if (!pb_decode_tag(&stream, &wire_type, &tag, &eof)) {
+    return false;
   }
+  return tag == firestore_client_MaybeDocument_no_document_tag ||
+         tag == firestore_client_MaybeDocument_unknown_document_tag;
+}
 
-  void Insert(const T& value) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    values_.push_back(value);
+/**
+ * The field of a chunked document's row that maps the paths of its moved
+ * values to their chunk IDs. Field names of the form `__.*__` are reserved, so
+ * it can't clash with the document's own fields.
+ */
+const FieldPath& ChunksFieldPath() {
+  static const auto* path = new FieldPath{"__chunks__"};
+  return *path;
+}
+
+/** Estimates the encoded size of `value`, counting scalars as 8 bytes. */
+size_t ApproximateSize(const FieldValue& value) {
+  switch (value.type()) {
+    case FieldValue::Type::String:
+      return value.string_value().size();
+    case FieldValue::Type::Blob:
+      return value.blob_value().size();
+    case FieldValue::Type::Array: {
+      size_t size = 0;
+      for (const FieldValue& element : value.array_value()) {
+        size += ApproximateSize(element);
+      }
+      return size;
+    }
+    case FieldValue::Type::Object: {
+      size_t size = 0;
+      for (const auto& entry : value.object_value()) {
+        size += entry.first.size() + ApproximateSize(entry.second);
+      }
+      return size;
+    }
+    default:
+      return 8;
   }
+}
 
-  /**
-   * Returns the accumulated result, moving it out of AsyncResults. The
-   * AsyncResults object should not be reused.
-   */
-  std::vector<T> Result() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return std::move(values_);
+/**
+ * Appends the values of `fields`, an object at `prefix`, that are large enough
+ * to be moved to chunks. Objects are never moved as a whole; their own fields
+ * are considered instead.
+ */
+void CollectLargeValues(const FieldValue::Map& fields,
+                        const FieldPath& prefix,
+                        std::vector<std::pair<FieldPath, FieldValue>>* result) {
+  for (const auto& entry : fields) {
+    FieldPath path = prefix.Append(entry.first);
+    const FieldValue& value = entry.second;
+    if (value.type() == FieldValue::Type::Object) {
+      CollectLargeValues(value.object_value(), path, result);
+    } else if (ApproximateSize(value) >= kMinChunkBytes) {
+      result->emplace_back(std::move(path), value);
+    }
   }
+}
 
- private:
-  std::vector<T> values_;
-  std::mutex mutex_;
-};
+/** Names a chunk by the hash of its contents. */
+std::string ChunkId(absl::string_view contents) {
+  std::array<uint8_t, 16> digest = util::CalculateMd5Digest(contents);
+  return absl::BytesToHexString(absl::string_view(
+      reinterpret_cast<const char*>(digest.data()), digest.size()));
+}
+
+/** Returns true if `mask` covers any part of the value at `path`. */
+bool Overlaps(const FieldMask& mask, const FieldPath& path) {
+  for (const FieldPath& field : mask) {
+    if (field.IsPrefixOf(path) || path.IsPrefixOf(field)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Collects documents produced in no particular order (e.g. by ParallelCollect)
+ * into a DocumentMap. Sorting up front lets the map be built in linear time,
+ * without inserting the documents one at a time.
+ */
+DocumentMap ToDocumentMap(std::vector<Document> documents) {
+  std::sort(documents.begin(), documents.end(),
+            [](const Document& lhs, const Document& rhs) {
+              return lhs.key() < rhs.key();
+            });
+  return DocumentMap::FromSortedDocuments(documents);
+}
+
+/**
+ * Writes all rows of the remote document table to a new document snapshot
+ * file at the given path and opens it. Reads directly from the database, so it
+ * can run outside of transactions and off the worker queue.
+ */
+util::StatusOr<std::unique_ptr<DocumentSnapshot>> BuildDocumentSnapshot(
+    leveldb::DB* db, const Path& path, int64_t generation) {
+  DocumentSnapshotWriter writer(path, generation);
+
+  // The scan touches every document once, so keep it from evicting the blocks
+  // that regular queries are using.
+  leveldb::ReadOptions options = StandardReadOptions();
+  options.fill_cache = false;
+
+  std::string prefix = LevelDbRemoteDocumentKey::KeyPrefix();
+  std::unique_ptr<leveldb::Iterator> it(db->NewIterator(options));
+  it->Seek(prefix);
+  for (; it->Valid() && absl::StartsWith(MakeStringView(it->key()), prefix);
+       it->Next()) {
+    writer.Add(MakeStringView(it->key()), MakeStringView(it->value()));
+  }
+  if (!it->status().ok()) {
+    return ConvertStatus(it->status());
+  }
+
+  util::Status status = writer.Finish();
+  if (!status.ok()) return status;
+
+  return DocumentSnapshot::Open(path);
+}
 
 }  // namespace
 
 LevelDbRemoteDocumentCache::LevelDbRemoteDocumentCache(
-    LevelDbPersistence* db, LocalSerializer* serializer)
-    : db_(db), serializer_(NOT_NULL(serializer)) {
+    LevelDbPersistence* db,
+    LocalSerializer* serializer,
+    bool compress_documents)
+    : db_(db),
+      serializer_(NOT_NULL(serializer)),
+      hot_documents_(kHotDocumentCacheCapacity),
+      compress_documents_(compress_documents) {
   auto hw_concurrency = std::thread::hardware_concurrency();
   if (hw_concurrency == 0) {
     // If the standard library doesn't know, guess something reasonable.
     hw_concurrency = 4;
   }
+  executor_threads_ = static_cast<int>(hw_concurrency);
   executor_ = Executor::CreateConcurrent("com.google.firebase.firestore.query",
-                                         static_cast<int>(hw_concurrency));
+                                         executor_threads_);
 }
 
 // Out of line because of unique_ptrs to incomplete types.
@@ -112,32 +271,108 @@ void LevelDbRemoteDocumentCache::Add(const MaybeDocument& document,
   const DocumentKey& key = document.key();
   const ResourcePath& path = key.path();
 
-  std::string ldb_document_key = LevelDbRemoteDocumentKey::Key(key);
-  db_->current_transaction()->Put(ldb_document_key,
-                                  serializer_->EncodeMaybeDocument(document));
+  LevelDbIndexManager* index_manager = db_->index_manager();
+  if (index_manager->HasFieldIndexes(path.PopLast())) {
+    absl::optional<MaybeDocument> existing = Get(key);
+    if (existing) {
+      index_manager->RemoveIndexEntries(*existing);
+    }
+    index_manager->AddIndexEntries(document);
+  }
+
+  std::map<std::string, std::string> chunks;
+  std::string row = EncodeDocumentRow(document, &chunks);
+  if (compress_documents_ && document.is_document()) {
+    row = CompressDocument(key, std::move(row));
+  }
+  db_->current_transaction()->Put(LevelDbRemoteDocumentKey::Key(key), row);
+  WriteChunks(key, chunks);
+  hot_documents_.Invalidate(key);
+  if (prefetch_in_progress_) {
+    prefetch_written_keys_.insert(key);
+  }
 
   std::string ldb_read_time_key = LevelDbRemoteDocumentReadTimeKey::Key(
       path.PopLast(), read_time, path.last_segment());
   db_->current_transaction()->Put(ldb_read_time_key, "");
 
-  db_->index_manager()->AddToCollectionParentIndex(
-      document.key().path().PopLast());
+  db_->current_transaction()->Put(
+      LevelDbCollectionGroupDocumentKey::Key(key),
+      LevelDbCollectionGroupDocumentKey::EncodeReadTime(read_time));
+
+  index_manager->AddToCollectionParentIndex(path.PopLast());
+  RecordSnapshotChange(key);
 }
 
 void LevelDbRemoteDocumentCache::Remove(const DocumentKey& key) {
+  LevelDbIndexManager* index_manager = db_->index_manager();
+  if (index_manager->HasFieldIndexes(key.path().PopLast())) {
+    absl::optional<MaybeDocument> existing = Get(key);
+    if (existing) {
+      index_manager->RemoveIndexEntries(*existing);
+    }
+  }
+
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   db_->current_transaction()->Delete(ldb_key);
+
+  // The collection group row records the read time of the document, which
+  // locates its row in the read time index.
+  std::string collection_group_key =
+      LevelDbCollectionGroupDocumentKey::Key(key);
+  std::string encoded_read_time;
+  if (db_->current_transaction()
+          ->Get(collection_group_key, &encoded_read_time)
+          .ok()) {
+    absl::optional<SnapshotVersion> read_time =
+        LevelDbCollectionGroupDocumentKey::DecodeReadTime(encoded_read_time);
+    if (read_time) {
+      const ResourcePath& path = key.path();
+      db_->current_transaction()->Delete(LevelDbRemoteDocumentReadTimeKey::Key(
+          path.PopLast(), *read_time, path.last_segment()));
+    }
+  }
+  db_->current_transaction()->Delete(collection_group_key);
+  WriteChunks(key, {});
+  hot_documents_.Invalidate(key);
+  if (prefetch_in_progress_) {
+    prefetch_written_keys_.insert(key);
+  }
+  RecordSnapshotChange(key);
+}
+
+bool LevelDbRemoteDocumentCache::ContainsTombstone(const DocumentKey& key) {
+  std::string value;
+  Status status = db_->current_transaction()->Get(
+      LevelDbRemoteDocumentKey::Key(key), &value);
+  return status.ok() && IsTombstoneRow(value);
 }
 
 absl::optional<MaybeDocument> LevelDbRemoteDocumentCache::Get(
     const DocumentKey& key) {
+  // Read-only transactions read from a snapshot that the cached documents may
+  // be newer than, and must not cache documents that may be stale.
+  bool use_hot_documents = !db_->in_read_only_transaction();
+  if (use_hot_documents) {
+    InstallPrefetchedDocuments();
+    absl::optional<MaybeDocument> cached = hot_documents_.Get(key);
+    if (cached) {
+      return cached;
+    }
+  }
+
   std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
   std::string value;
   Status status = db_->current_transaction()->Get(ldb_key, &value);
   if (status.IsNotFound()) {
     return absl::nullopt;
   } else if (status.ok()) {
-    return DecodeMaybeDocument(value, key);
+    MaybeDocument document =
+        DecodeMaybeDocument(value, key, db_->current_transaction());
+    if (use_hot_documents) {
+      hot_documents_.Put(document, value.size());
+    }
+    return document;
   } else {
     HARD_FAIL("Fetch document for key (%s) failed with status: %s",
               key.ToString(), status.ToString());
@@ -146,47 +381,88 @@ absl::optional<MaybeDocument> LevelDbRemoteDocumentCache::Get(
 
 OptionalMaybeDocumentMap LevelDbRemoteDocumentCache::GetAll(
     const DocumentKeySet& keys) {
-  BackgroundQueue tasks(executor_.get());
-  AsyncResults<std::pair<DocumentKey, absl::optional<MaybeDocument>>> results;
-
-  LevelDbRemoteDocumentKey current_key;
-  auto it = db_->current_transaction()->NewIterator();
+  std::vector<LookupResult> results = ReadAll(keys);
+  return OptionalMaybeDocumentMap::FromSortedRange(results.begin(),
+                                                   results.end());
+}
 
-  for (const DocumentKey& key : keys) {
-    it->Seek(LevelDbRemoteDocumentKey::Key(key));
-    if (!it->Valid() || !current_key.Decode(it->key()) ||
-        current_key.document_key() != key) {
-      results.Insert(std::make_pair(key, absl::nullopt));
-    } else {
-      const std::string& contents = it->value();
-      tasks.Execute([this, &results, &key, contents] {
-        results.Insert(std::make_pair(key, DecodeMaybeDocument(contents, key)));
-      });
+DocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
+    const DocumentKeySet& keys) {
+  std::vector<Document> results;
+  for (const auto& entry : ReadAll(keys)) {
+    const absl::optional<MaybeDocument>& maybe_doc = entry.second;
+    if (maybe_doc && maybe_doc->is_document()) {
+      results.emplace_back(*maybe_doc);
     }
   }
+  return DocumentMap::FromSortedDocuments(results);
+}
 
-  tasks.AwaitAll();
+std::vector<LevelDbRemoteDocumentCache::LookupResult>
+LevelDbRemoteDocumentCache::ReadAll(const DocumentKeySet& keys) {
+  std::vector<LookupResult> results;
+  // The keys and contents of the rows that need to be decoded.
+  std::vector<std::pair<const DocumentKey*, std::string>> rows;
 
-  OptionalMaybeDocumentMap map;
-  for (const auto& entry : results.Result()) {
-    map = map.insert(entry.first, entry.second);
+  LevelDbTransaction* transaction = db_->current_transaction();
+  auto it = transaction->NewIterator();
+  bool positioned = false;
+  bool at_previous_key = false;
+  // See `Get`.
+  bool use_hot_documents = !db_->in_read_only_transaction();
+  if (use_hot_documents) {
+    InstallPrefetchedDocuments();
   }
-  return map;
-}
 
-DocumentMap LevelDbRemoteDocumentCache::GetAllExisting(
-    const DocumentKeySet& keys) {
-  DocumentMap results;
+  for (const DocumentKey& key : keys) {
+    if (use_hot_documents) {
+      absl::optional<MaybeDocument> cached = hot_documents_.Get(key);
+      if (cached) {
+        results.emplace_back(key, std::move(cached));
+        continue;
+      }
+    }
 
-  OptionalMaybeDocumentMap docs = LevelDbRemoteDocumentCache::GetAll(keys);
-  for (const auto& kv : docs) {
-    const DocumentKey& key = kv.first;
-    const auto& maybe_doc = kv.second;
-    if (maybe_doc && maybe_doc->is_document()) {
-      results = results.insert(key, Document(*maybe_doc));
+    std::string ldb_key = LevelDbRemoteDocumentKey::Key(key);
+
+    // Keys are visited in order, so the iterator is never past the row for
+    // `key`. Rows of consecutive keys are often adjacent, so step to the next
+    // row and only seek if that row is still before the key.
+    if (at_previous_key) {
+      it->Next();
+    }
+    if (!positioned || (it->Valid() && it->key() < ldb_key)) {
+      it->Seek(ldb_key);
+      positioned = true;
+    }
+
+    at_previous_key = it->Valid() && it->key() == ldb_key;
+    if (!at_previous_key) {
+      results.emplace_back(key, absl::nullopt);
+    } else {
+      rows.emplace_back(&key, it->value());
     }
   }
 
+  std::vector<LookupResult> decoded = ParallelCollect<LookupResult>(
+      executor_.get(), executor_threads_, rows.size(),
+      [&](size_t i, std::vector<LookupResult>* out) {
+        const DocumentKey& key = *rows[i].first;
+        MaybeDocument document =
+            DecodeMaybeDocument(rows[i].second, key, transaction);
+        if (use_hot_documents) {
+          hot_documents_.Put(document, rows[i].second.size());
+        }
+        out->emplace_back(key, std::move(document));
+      });
+  results.insert(results.end(), std::make_move_iterator(decoded.begin()),
+                 std::make_move_iterator(decoded.end()));
+
+  // Decoding finishes in no particular order; restore the order of the keys.
+  std::sort(results.begin(), results.end(),
+            [](const LookupResult& lhs, const LookupResult& rhs) {
+              return lhs.first < rhs.first;
+            });
   return results;
 }
 
@@ -198,7 +474,6 @@ DocumentMap LevelDbRemoteDocumentCache::GetMatching(
 
   // Use the query path as a prefix for testing if a document matches the query.
   const ResourcePath& query_path = query.path();
-  size_t immediate_children_path_length = query_path.size() + 1;
 
   if (since_read_time != SnapshotVersion::None()) {
     // Execute an index-free query and filter by read time. This is safe since
@@ -210,7 +485,7 @@ DocumentMap LevelDbRemoteDocumentCache::GetMatching(
     auto it = db_->current_transaction()->NewIterator();
     it->Seek(util::ImmediateSuccessor(start_key));
 
-    DocumentKeySet remote_keys;
+    std::vector<DocumentKey> remote_keys;
 
     LevelDbRemoteDocumentReadTimeKey current_key;
     for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
@@ -222,61 +497,759 @@ DocumentMap LevelDbRemoteDocumentCache::GetMatching(
       const SnapshotVersion& read_time = current_key.read_time();
       if (read_time > since_read_time) {
         DocumentKey document_key(query_path.Append(current_key.document_id()));
-        remote_keys = remote_keys.insert(document_key);
+        remote_keys.push_back(std::move(document_key));
       }
     }
 
-    return LevelDbRemoteDocumentCache::GetAllExisting(remote_keys);
+    // The read time index is ordered by read time rather than by key.
+    std::sort(remote_keys.begin(), remote_keys.end());
+    db_->metrics()->RecordDocumentsScanned(
+        static_cast<int64_t>(remote_keys.size()));
+    return LevelDbRemoteDocumentCache::GetAllExisting(
+        DocumentKeySet::FromSortedRange(remote_keys.begin(),
+                                        remote_keys.end()));
+  } else if (snapshot_ && !db_->in_read_only_transaction()) {
+    // The document snapshot is replaced on the worker queue, so read-only
+    // transactions on other threads scan the table instead.
+    return GetMatchingFromSnapshot(query);
   } else {
-    BackgroundQueue tasks(executor_.get());
-    AsyncResults<Document> results;
+    // The keys and contents of the rows to decode and match.
+    std::vector<std::pair<DocumentKey, std::string>> rows;
 
     // Documents are ordered by key, so we can use a prefix scan to narrow down
     // the documents we need to match the query against.
     std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(query_path);
-    auto it = db_->current_transaction()->NewIterator();
+    LevelDbTransaction* transaction = db_->current_transaction();
+    auto it = transaction->NewIterator();
     it->Seek(start_key);
 
+    int64_t documents_scanned = 0;
     LevelDbRemoteDocumentKey current_key;
-    for (; it->Valid() && current_key.Decode(it->key()); it->Next()) {
+    while (it->Valid()) {
       // The query is actually returning any path that starts with the query
       // path prefix which may include documents in subcollections. For example,
       // a query on 'rooms' will return rooms/abc/messages/xyx but we shouldn't
       // match it. Fix this by discarding rows with document keys more than one
-      // segment longer than the query path.
+      // segment longer than the query path. Both checks run on the encoded key
+      // so that discarded rows are never decoded.
+      absl::optional<size_t> child_segments =
+          LevelDbRemoteDocumentKey::CountSegmentsAfterPrefix(it->key(),
+                                                             start_key);
+      if (!child_segments) {
+        break;
+      }
+      if (*child_segments != 1) {
+        // The documents in the subcollections of a child document are
+        // adjacent and sort after it, so seek past all of them at once
+        // instead of iterating over them.
+        absl::optional<absl::string_view> child_prefix =
+            LevelDbRemoteDocumentKey::ChildKeyPrefix(it->key(), start_key);
+        if (!child_prefix) {
+          break;
+        }
+        it->Seek(util::PrefixSuccessor(*child_prefix));
+        continue;
+      }
+
+      if (!current_key.Decode(it->key())) {
+        break;
+      }
       const DocumentKey& document_key = current_key.document_key();
-      if (document_key.path().size() != immediate_children_path_length) {
+
+      ++documents_scanned;
+      rows.emplace_back(document_key, it->value());
+
+      it->Next();
+    }
+
+    std::vector<Document> results = ParallelCollect<Document>(
+        executor_.get(), executor_threads_, rows.size(),
+        [&](size_t i, std::vector<Document>* out) {
+          absl::optional<Document> doc = DecodeMatchingDocument(
+              rows[i].second, rows[i].first, query, transaction);
+          if (doc) {
+            out->push_back(std::move(*doc));
+          }
+        });
+    db_->metrics()->RecordDocumentsScanned(documents_scanned);
+    return ToDocumentMap(std::move(results));
+  }
+}
+
+/**
+ * Scans the remote document table for the documents of a collection, decoding
+ * each matching one only when the cursor reaches it.
+ */
+class LevelDbRemoteDocumentCache::MatchingCursor : public DocumentCursor {
+ public:
+  MatchingCursor(LevelDbRemoteDocumentCache* cache, const Query& query)
+      : cache_(cache),
+        query_(query),
+        start_key_(LevelDbRemoteDocumentKey::KeyPrefix(query.path())),
+        it_(cache->db_->current_transaction()->NewIterator()),
+        end_key_(query.EndKey()) {
+    // Key-ordered queries can skip straight to their start bound, which may
+    // lie outside the collection.
+    std::string seek_key = start_key_;
+    absl::optional<DocumentKey> start_key = query.StartKey();
+    if (start_key) {
+      seek_key = std::max(seek_key, LevelDbRemoteDocumentKey::Key(*start_key));
+    }
+    it_->Seek(seek_key);
+    Advance();
+  }
+
+  ~MatchingCursor() override {
+    cache_->db_->metrics()->RecordDocumentsScanned(documents_scanned_);
+  }
+
+  bool Valid() const override {
+    return current_.has_value();
+  }
+
+  const Document& document() const override {
+    return *current_;
+  }
+
+  void Next() override {
+    it_->Next();
+    Advance();
+  }
+
+ private:
+  /**
+   * Moves to the first matching document at or after the position of the
+   * underlying iterator, skipping subcollections as in `GetMatching`.
+   */
+  void Advance() {
+    current_ = absl::nullopt;
+
+    LevelDbRemoteDocumentKey current_key;
+    while (it_->Valid()) {
+      absl::optional<size_t> child_segments =
+          LevelDbRemoteDocumentKey::CountSegmentsAfterPrefix(it_->key(),
+                                                             start_key_);
+      if (!child_segments) {
+        return;
+      }
+      if (*child_segments != 1) {
+        absl::optional<absl::string_view> child_prefix =
+            LevelDbRemoteDocumentKey::ChildKeyPrefix(it_->key(), start_key_);
+        if (!child_prefix) {
+          return;
+        }
+        it_->Seek(util::PrefixSuccessor(*child_prefix));
+        continue;
+      }
+
+      if (!current_key.Decode(it_->key())) {
+        return;
+      }
+      // Nothing after the end bound of a key-ordered query matches.
+      if (end_key_ && *end_key_ < current_key.document_key()) {
+        return;
+      }
+
+      ++documents_scanned_;
+      current_ = cache_->DecodeMatchingDocument(
+          it_->value(), current_key.document_key(), query_,
+          cache_->db_->current_transaction());
+      if (current_) {
+        return;
+      }
+      it_->Next();
+    }
+  }
+
+  LevelDbRemoteDocumentCache* cache_ = nullptr;
+  Query query_;
+  std::string start_key_;
+  std::unique_ptr<LevelDbTransaction::Iterator> it_;
+  absl::optional<DocumentKey> end_key_;
+  absl::optional<Document> current_;
+  int64_t documents_scanned_ = 0;
+};
+
+std::unique_ptr<DocumentCursor> LevelDbRemoteDocumentCache::ScanMatching(
+    const Query& query, const SnapshotVersion& since_read_time) {
+  if (since_read_time != SnapshotVersion::None() ||
+      (snapshot_ && !db_->in_read_only_transaction())) {
+    return RemoteDocumentCache::ScanMatching(query, since_read_time);
+  }
+
+  HARD_ASSERT(
+      !query.IsCollectionGroupQuery(),
+      "CollectionGroup queries should be handled in LocalDocumentsView");
+  return absl::make_unique<MatchingCursor>(this, query);
+}
+
+absl::optional<DocumentMap>
+LevelDbRemoteDocumentCache::GetMatchingCollectionGroup(
+    const Query& query, const SnapshotVersion& since_read_time) {
+  HARD_ASSERT(query.IsCollectionGroupQuery(),
+              "GetMatchingCollectionGroup needs a collection group query");
+
+  LevelDbTransaction* transaction = db_->current_transaction();
+  if (LevelDbMigrations::IsCollectionGroupDocumentsBackfillPending(
+          transaction)) {
+    return absl::nullopt;
+  }
+
+  // The index is ordered by collection ID and then by document key, so the
+  // keys come out sorted.
+  const ResourcePath& query_path = query.path();
+  std::vector<DocumentKey> keys;
+  std::string prefix =
+      LevelDbCollectionGroupDocumentKey::KeyPrefix(*query.collection_group());
+  auto it = transaction->NewIterator();
+  LevelDbCollectionGroupDocumentKey row_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix) &&
+                         row_key.Decode(it->key());
+       it->Next()) {
+    const DocumentKey& document_key = row_key.document_key();
+    if (!query_path.IsPrefixOf(document_key.path())) {
+      continue;
+    }
+
+    if (since_read_time != SnapshotVersion::None()) {
+      // Rows written by the backfill have no read time, so their documents
+      // are always read.
+      absl::optional<SnapshotVersion> read_time =
+          LevelDbCollectionGroupDocumentKey::DecodeReadTime(it->value());
+      if (read_time && *read_time <= since_read_time) {
         continue;
       }
+    }
+    keys.push_back(document_key);
+  }
+
+  db_->metrics()->RecordDocumentsScanned(static_cast<int64_t>(keys.size()));
+  return GetAllExisting(DocumentKeySet::FromSortedRange(keys.begin(),
+                                                        keys.end()));
+}
+
+DocumentMap LevelDbRemoteDocumentCache::GetMatchingFromSnapshot(
+    const Query& query) {
+  const ResourcePath& query_path = query.path();
+  size_t immediate_children_path_length = query_path.size() + 1;
+
+  // The snapshot is out of date for documents changed after it was built, so
+  // those are read from LevelDB instead.
+  std::vector<DocumentKey> changed_key_list;
+  std::string change_prefix =
+      LevelDbRemoteDocumentChangeKey::KeyPrefix(query_path);
+  auto it = db_->current_transaction()->NewIterator();
+  it->Seek(change_prefix);
 
-      if (!query_path.IsPrefixOf(document_key.path())) {
+  LevelDbRemoteDocumentChangeKey change_key;
+  for (; it->Valid() && change_key.Decode(it->key()); it->Next()) {
+    const DocumentKey& document_key = change_key.document_key();
+    if (!query_path.IsPrefixOf(document_key.path())) {
+      break;
+    }
+    if (document_key.path().size() != immediate_children_path_length) {
+      continue;
+    }
+
+    int64_t generation =
+        LevelDbRemoteDocumentChangeKey::DecodeGeneration(it->value());
+    if (generation > snapshot_->generation()) {
+      changed_key_list.push_back(document_key);
+    }
+  }
+  DocumentKeySet changed_keys = DocumentKeySet::FromSortedRange(
+      changed_key_list.begin(), changed_key_list.end());
+
+  // The keys and contents of the rows to decode and match.
+  std::vector<std::pair<DocumentKey, absl::string_view>> rows;
+  // The chunks of the documents that haven't changed since the snapshot was
+  // built haven't changed either, so they are read from LevelDB.
+  LevelDbTransaction* transaction = db_->current_transaction();
+
+  // The snapshot has the same keys and values as the remote document table,
+  // so it is scanned the same way. The values point into the mapped file and
+  // are decoded without copying them.
+  std::string start_key = LevelDbRemoteDocumentKey::KeyPrefix(query_path);
+  int64_t documents_scanned = 0;
+  LevelDbRemoteDocumentKey current_key;
+  for (size_t i = snapshot_->LowerBound(start_key); i < snapshot_->size();
+       ++i) {
+    absl::optional<size_t> child_segments =
+        LevelDbRemoteDocumentKey::CountSegmentsAfterPrefix(snapshot_->key(i),
+                                                           start_key);
+    if (!child_segments) {
+      break;
+    }
+    if (*child_segments != 1) {
+      // Skip the child document's subcollections, as in GetMatching.
+      absl::optional<absl::string_view> child_prefix =
+          LevelDbRemoteDocumentKey::ChildKeyPrefix(snapshot_->key(i),
+                                                   start_key);
+      if (!child_prefix) {
         break;
       }
+      // The next key is past key(i), so this never moves backwards. The loop
+      // increments `i` back to it.
+      i = snapshot_->LowerBound(util::PrefixSuccessor(*child_prefix)) - 1;
+      continue;
+    }
+
+    if (!current_key.Decode(snapshot_->key(i))) {
+      break;
+    }
+    const DocumentKey& document_key = current_key.document_key();
+    if (changed_keys.contains(document_key)) {
+      continue;
+    }
+
+    ++documents_scanned;
+    rows.emplace_back(document_key, snapshot_->value(i));
+  }
 
-      const std::string& contents = it->value();
-      tasks.Execute([this, &results, document_key, contents] {
-        MaybeDocument maybe_doc = DecodeMaybeDocument(contents, document_key);
-        if (maybe_doc.is_document()) {
-          results.Insert(Document(maybe_doc));
+  std::vector<Document> results = ParallelCollect<Document>(
+      executor_.get(), executor_threads_, rows.size(),
+      [&](size_t i, std::vector<Document>* out) {
+        absl::optional<Document> doc = DecodeMatchingDocument(
+            rows[i].second, rows[i].first, query, transaction);
+        if (doc) {
+          out->push_back(std::move(*doc));
         }
       });
+
+  for (const auto& entry : ReadAll(changed_keys)) {
+    const absl::optional<MaybeDocument>& maybe_doc = entry.second;
+    if (maybe_doc && maybe_doc->is_document()) {
+      Document doc(*maybe_doc);
+      if (query.Matches(doc)) {
+        results.push_back(std::move(doc));
+      }
     }
+  }
+  documents_scanned += changed_keys.size();
+  db_->metrics()->RecordDocumentsScanned(documents_scanned);
+  return ToDocumentMap(std::move(results));
+}
+
+void LevelDbRemoteDocumentCache::ConfigureSnapshot(bool enabled,
+                                                   const Path& path) {
+  LevelDbTransaction* transaction = db_->current_transaction();
+  std::string generation_key = LevelDbRemoteDocumentSnapshotKey::Key();
+  std::string generation_value;
+  Status status = transaction->Get(generation_key, &generation_value);
+  if (!status.ok() && !status.IsNotFound()) {
+    HARD_FAIL("Fetch document snapshot generation failed with status: %s",
+              status.ToString());
+  }
+  bool was_enabled = status.ok();
 
-    tasks.AwaitAll();
+  if (!enabled) {
+    if (was_enabled) {
+      transaction->Delete(generation_key);
 
-    DocumentMap map;
-    for (const Document& doc : results.Result()) {
-      map = map.insert(doc.key(), doc);
+      std::string prefix = LevelDbRemoteDocumentChangeKey::KeyPrefix();
+      auto it = transaction->NewIterator();
+      it->Seek(prefix);
+      for (; it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+        transaction->Delete(it->key());
+      }
+
+      util::Status removed = Filesystem::Default()->RemoveFile(path);
+      if (!removed.ok()) {
+        LOG_WARN("Failed to remove document snapshot: %s", removed.ToString());
+      }
     }
-    return map;
+    return;
   }
+
+  if (!was_enabled) {
+    // Changes haven't been recorded while the snapshot was disabled, so a
+    // leftover file can't be used.
+    util::Status removed = Filesystem::Default()->RemoveFile(path);
+    if (!removed.ok()) {
+      LOG_WARN("Not enabling the document snapshot: %s", removed.ToString());
+      return;
+    }
+    snapshot_generation_ = 1;
+    transaction->Put(
+        generation_key,
+        LevelDbRemoteDocumentChangeKey::EncodeGeneration(snapshot_generation_));
+  } else {
+    snapshot_generation_ =
+        LevelDbRemoteDocumentChangeKey::DecodeGeneration(generation_value);
+
+    // A file from a later generation can't have been built by this database,
+    // and is rebuilt by the next compaction like a missing or corrupt one.
+    auto opened = DocumentSnapshot::Open(path);
+    if (opened.ok() &&
+        opened.ValueOrDie()->generation() < snapshot_generation_) {
+      snapshot_ = std::move(opened).ValueOrDie();
+    }
+  }
+
+  snapshot_path_ = path;
+  snapshot_executor_ =
+      Executor::CreateSerial("com.google.firebase.firestore.snapshot",
+                             Executor::QualityOfService::Background);
+}
+
+void LevelDbRemoteDocumentCache::CompactSnapshot() {
+  if (snapshot_generation_ == 0) return;
+
+  if (snapshot_build_in_progress_) {
+    InstallBuiltSnapshot();
+    return;
+  }
+
+  if (snapshot_) {
+    std::string prefix = LevelDbRemoteDocumentChangeKey::KeyPrefix();
+    auto it = db_->current_transaction()->NewIterator();
+    it->Seek(prefix);
+    if (!it->Valid() || !absl::StartsWith(it->key(), prefix)) {
+      // The snapshot is up to date.
+      return;
+    }
+  }
+
+  // All changes of the current generation have been committed. Changes made
+  // from now on belong to the next generation, which the new file may or may
+  // not include, so they keep being read from LevelDB.
+  int64_t generation = snapshot_generation_++;
+  db_->current_transaction()->Put(
+      LevelDbRemoteDocumentSnapshotKey::Key(),
+      LevelDbRemoteDocumentChangeKey::EncodeGeneration(snapshot_generation_));
+  snapshot_build_in_progress_ = true;
+
+  leveldb::DB* db = db_->ptr();
+  Path path = snapshot_path_;
+  snapshot_executor_->Execute([this, db, path, generation] {
+    auto built = BuildDocumentSnapshot(db, path, generation);
+    if (!built.ok()) {
+      LOG_WARN("Failed to build document snapshot: %s",
+               built.status().ToString());
+    }
+
+    std::lock_guard<std::mutex> lock(snapshot_build_mutex_);
+    snapshot_build_finished_ = true;
+    if (built.ok()) {
+      built_snapshot_ = std::move(built).ValueOrDie();
+    }
+  });
+}
+
+void LevelDbRemoteDocumentCache::InstallBuiltSnapshot() {
+  std::unique_ptr<DocumentSnapshot> built;
+  {
+    std::lock_guard<std::mutex> lock(snapshot_build_mutex_);
+    if (!snapshot_build_finished_) return;
+    snapshot_build_finished_ = false;
+    built = std::move(built_snapshot_);
+  }
+  snapshot_build_in_progress_ = false;
+
+  // On failure keep using the previous snapshot, if any. The next compaction
+  // tries again.
+  if (!built) return;
+  snapshot_ = std::move(built);
+
+  // Drop the changes the new file includes.
+  std::string prefix = LevelDbRemoteDocumentChangeKey::KeyPrefix();
+  LevelDbTransaction* transaction = db_->current_transaction();
+  auto it = transaction->NewIterator();
+  it->Seek(prefix);
+  for (; it->Valid() && absl::StartsWith(it->key(), prefix); it->Next()) {
+    int64_t generation =
+        LevelDbRemoteDocumentChangeKey::DecodeGeneration(it->value());
+    if (generation <= snapshot_->generation()) {
+      transaction->Delete(it->key());
+    }
+  }
+}
+
+void LevelDbRemoteDocumentCache::AwaitSnapshotBuild() {
+  if (snapshot_executor_) {
+    snapshot_executor_->ExecuteBlocking([] {});
+  }
+}
+
+void LevelDbRemoteDocumentCache::Prefetch(const DocumentKeySet& keys) {
+  if (prefetch_in_progress_ || keys.empty()) return;
+
+  // Any more would only evict each other from the hot documents.
+  std::vector<DocumentKey> to_read;
+  for (const DocumentKey& key : keys) {
+    if (to_read.size() == kHotDocumentCacheCapacity) break;
+    to_read.push_back(key);
+  }
+
+  if (!prefetch_executor_) {
+    prefetch_executor_ =
+        Executor::CreateSerial("com.google.firebase.firestore.prefetch",
+                               Executor::QualityOfService::Utility);
+  }
+  prefetch_in_progress_ = true;
+  prefetch_written_keys_.clear();
+
+  // Transactions held by group commit are missing from the snapshot read in
+  // the background, and may have written any of the documents.
+  int64_t write_version = db_->write_version();
+  prefetch_executor_->Execute([this, to_read, write_version] {
+    std::vector<std::pair<MaybeDocument, size_t>> prefetched;
+    int64_t snapshot_version = db_->RunReadOnly("Prefetch", [&] {
+      LevelDbTransaction* transaction = db_->current_transaction();
+      std::string value;
+      for (const DocumentKey& key : to_read) {
+        Status status =
+            transaction->Get(LevelDbRemoteDocumentKey::Key(key), &value);
+        if (status.ok()) {
+          prefetched.emplace_back(
+              DecodeMaybeDocument(value, key, transaction), value.size());
+        }
+      }
+    });
+
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    prefetch_finished_ = true;
+    if (snapshot_version >= write_version) {
+      prefetched_ = std::move(prefetched);
+    }
+  });
+}
+
+void LevelDbRemoteDocumentCache::InstallPrefetchedDocuments() {
+  if (!prefetch_in_progress_) return;
+
+  std::vector<std::pair<MaybeDocument, size_t>> prefetched;
+  {
+    std::lock_guard<std::mutex> lock(prefetch_mutex_);
+    if (!prefetch_finished_) return;
+    prefetch_finished_ = false;
+    prefetched.swap(prefetched_);
+  }
+  prefetch_in_progress_ = false;
+
+  for (const auto& entry : prefetched) {
+    if (prefetch_written_keys_.count(entry.first.key()) == 0) {
+      hot_documents_.Put(entry.first, entry.second);
+    }
+  }
+  prefetch_written_keys_.clear();
+}
+
+void LevelDbRemoteDocumentCache::AwaitPrefetch() {
+  if (prefetch_executor_) {
+    prefetch_executor_->ExecuteBlocking([] {});
+  }
+}
+
+size_t LevelDbRemoteDocumentCache::ReleaseMemory() {
+  return hot_documents_.Clear();
+}
+
+void LevelDbRemoteDocumentCache::RecordSnapshotChange(const DocumentKey& key) {
+  if (snapshot_generation_ == 0) return;
+
+  db_->current_transaction()->Put(
+      LevelDbRemoteDocumentChangeKey::Key(key),
+      LevelDbRemoteDocumentChangeKey::EncodeGeneration(snapshot_generation_));
+}
+
+std::string LevelDbRemoteDocumentCache::EncodeDocumentRow(
+    const MaybeDocument& document, std::map<std::string, std::string>* chunks) {
+  absl::optional<std::string> received =
+      serializer_->EncodeReceivedDocument(document);
+  std::string encoded =
+      received
+          ? std::move(*received)
+          : nanopb::MakeStdString(serializer_->EncodeMaybeDocument(document));
+  if (!document.is_document() || encoded.size() < kChunkedDocumentMinBytes) {
+    return encoded;
+  }
+
+  Document doc(document);
+  std::vector<std::pair<FieldPath, FieldValue>> large_values;
+  CollectLargeValues(doc.data().GetInternalValue(), FieldPath::EmptyPath(),
+                     &large_values);
+  if (large_values.empty()) {
+    return encoded;
+  }
+
+  // Chunks are named by the hash of their contents, so a chunk that an update
+  // leaves unchanged keeps its row.
+  ObjectValue::Builder data(doc.data());
+  FieldValue::Map chunk_ids;
+  for (const auto& entry : large_values) {
+    std::string chunk =
+        nanopb::MakeStdString(serializer_->EncodeFieldValue(entry.second));
+    std::string chunk_id = ChunkId(chunk);
+    data.Delete(entry.first);
+    chunk_ids = chunk_ids.insert(entry.first.CanonicalString(),
+                                 FieldValue::FromString(chunk_id));
+    chunks->emplace(std::move(chunk_id), std::move(chunk));
+  }
+  data.Set(ChunksFieldPath(), FieldValue::FromMap(std::move(chunk_ids)));
+
+  Document row(data.Build(), doc.key(), doc.version(), doc.document_state());
+  return nanopb::MakeStdString(serializer_->EncodeMaybeDocument(row));
+}
+
+std::string LevelDbRemoteDocumentCache::CompressDocument(
+    const DocumentKey& key, std::string encoded) {
+  ResourcePath collection_path = key.path().PopLast();
+  std::shared_ptr<const std::string> dictionary =
+      GetCompressionDictionary(collection_path, db_->current_transaction());
+
+  if (!dictionary) {
+    std::vector<std::string>& samples = dictionary_samples_[collection_path];
+    samples.push_back(encoded);
+    if (samples.size() >= kCompressionDictionarySamples) {
+      dictionary = std::make_shared<const std::string>(
+          BuildCompressionDictionary(samples));
+      dictionary_samples_.erase(collection_path);
+
+      db_->current_transaction()->Put(
+          LevelDbCompressionDictionaryKey::Key(collection_path), *dictionary);
+      std::lock_guard<std::mutex> lock(dictionaries_mutex_);
+      dictionaries_[collection_path] = dictionary;
+    }
+  }
+
+  absl::optional<std::string> compressed = CompressDocumentRow(
+      encoded, dictionary ? *dictionary : absl::string_view());
+  return compressed ? std::move(*compressed) : encoded;
+}
+
+absl::string_view LevelDbRemoteDocumentCache::DecompressDocument(
+    absl::string_view row,
+    const DocumentKey& key,
+    LevelDbTransaction* transaction,
+    std::string* buffer) {
+  if (!IsCompressedDocumentRow(row)) {
+    return row;
+  }
+
+  std::shared_ptr<const std::string> dictionary;
+  if (UsesCompressionDictionary(row)) {
+    dictionary = GetCompressionDictionary(key.path().PopLast(), transaction);
+    HARD_ASSERT(dictionary,
+                "Compression dictionary of document (%s) is missing",
+                key.ToString());
+  }
+
+  util::StatusOr<std::string> decompressed = DecompressDocumentRow(
+      row, dictionary ? *dictionary : absl::string_view());
+  if (!decompressed.ok()) {
+    HARD_FAIL("Document (%s) failed to decompress: %s", key.ToString(),
+              decompressed.status().ToString());
+  }
+  *buffer = std::move(decompressed).ValueOrDie();
+  return *buffer;
+}
+
+std::shared_ptr<const std::string>
+LevelDbRemoteDocumentCache::GetCompressionDictionary(
+    const ResourcePath& collection_path, LevelDbTransaction* transaction) {
+  {
+    std::lock_guard<std::mutex> lock(dictionaries_mutex_);
+    auto found = dictionaries_.find(collection_path);
+    if (found != dictionaries_.end()) {
+      return found->second;
+    }
+  }
+
+  std::string contents;
+  Status status = transaction->GetConcurrently(
+      LevelDbCompressionDictionaryKey::Key(collection_path), &contents);
+  if (status.IsNotFound()) {
+    return nullptr;
+  } else if (!status.ok()) {
+    HARD_FAIL("Fetch compression dictionary of %s failed with status: %s",
+              collection_path.CanonicalString(), status.ToString());
+  }
+
+  auto dictionary = std::make_shared<const std::string>(std::move(contents));
+  std::lock_guard<std::mutex> lock(dictionaries_mutex_);
+  return dictionaries_.emplace(collection_path, dictionary).first->second;
+}
+
+void LevelDbRemoteDocumentCache::WriteChunks(
+    const DocumentKey& key, const std::map<std::string, std::string>& chunks) {
+  LevelDbTransaction* transaction = db_->current_transaction();
+
+  // The document's own chunks sort before those of its subcollections.
+  std::set<std::string> stored;
+  auto it = transaction->NewIterator();
+  LevelDbRemoteDocumentChunkKey chunk_key;
+  for (it->Seek(LevelDbRemoteDocumentChunkKey::KeyPrefix(key));
+       it->Valid() && chunk_key.Decode(it->key()) &&
+       chunk_key.document_key() == key;
+       it->Next()) {
+    if (chunks.count(chunk_key.chunk_id()) > 0) {
+      stored.insert(chunk_key.chunk_id());
+    } else {
+      transaction->Delete(it->key());
+    }
+  }
+
+  for (const auto& chunk : chunks) {
+    if (stored.count(chunk.first) == 0) {
+      transaction->Put(LevelDbRemoteDocumentChunkKey::Key(key, chunk.first),
+                       chunk.second);
+    }
+  }
+}
+
+ObjectValue LevelDbRemoteDocumentCache::LoadChunks(
+    const DocumentKey& key,
+    ObjectValue data,
+    const FieldValue& chunk_ids,
+    const FieldMask* mask,
+    LevelDbTransaction* transaction) const {
+  HARD_ASSERT(chunk_ids.type() == FieldValue::Type::Object,
+              "Chunk IDs of document (%s) are not a map: %s", key.ToString(),
+              chunk_ids.ToString());
+
+  ObjectValue::Builder builder(std::move(data));
+  builder.Delete(ChunksFieldPath());
+  for (const auto& entry : chunk_ids.object_value()) {
+    FieldPath path = FieldPath::FromServerFormat(entry.first);
+    if (mask && !Overlaps(*mask, path)) {
+      continue;
+    }
+
+    const std::string& chunk_id = entry.second.string_value();
+    std::string contents;
+    Status status = transaction->GetConcurrently(
+        LevelDbRemoteDocumentChunkKey::Key(key, chunk_id), &contents);
+    if (!status.ok()) {
+      HARD_FAIL("Fetch chunk %s of document (%s) failed with status: %s",
+                chunk_id, key.ToString(), status.ToString());
+    }
+    db_->metrics()->RecordBytesDecoded(contents.size());
+
+    StringReader reader{contents};
+    auto message = Message<google_firestore_v1_Value>::TryParse(&reader);
+    FieldValue value = serializer_->DecodeFieldValue(&reader, *message);
+    if (!reader.ok()) {
+      HARD_FAIL("Value proto failed to parse: %s", reader.status().ToString());
+    }
+    builder.Set(path, value);
+  }
+
+  ObjectValue result = builder.Build();
+  return mask ? result.Project(*mask) : result;
 }
 
 MaybeDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
-    absl::string_view encoded, const DocumentKey& key) {
+    absl::string_view encoded,
+    const DocumentKey& key,
+    LevelDbTransaction* transaction) {
+  std::string decompressed;
+  encoded = DecompressDocument(encoded, key, transaction, &decompressed);
   StringReader reader{encoded};
+  db_->metrics()->RecordBytesDecoded(encoded.size());
 
-  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+  auto message =
+      Message<firestore_client_MaybeDocument>::TryParseWithArena(&reader);
   MaybeDocument maybe_document =
       serializer_->DecodeMaybeDocument(&reader, *message);
 
@@ -288,9 +1261,111 @@ MaybeDocument LevelDbRemoteDocumentCache::DecodeMaybeDocument(
               "Read document has key (%s) instead of expected key (%s).",
               maybe_document.key().ToString(), key.ToString());
 
+  if (maybe_document.is_document()) {
+    Document doc(maybe_document);
+    const FieldValue* chunk_ids = doc.data().Find(ChunksFieldPath());
+    if (chunk_ids) {
+      return Document(
+          LoadChunks(key, doc.data(), *chunk_ids, nullptr, transaction), key,
+          doc.version(), doc.document_state());
+    }
+  }
   return maybe_document;
 }
 
+absl::optional<Document> LevelDbRemoteDocumentCache::DecodeMatchingDocument(
+    absl::string_view encoded,
+    const DocumentKey& key,
+    const Query& query,
+    LevelDbTransaction* transaction) {
+  std::string decompressed;
+  encoded = DecompressDocument(encoded, key, transaction, &decompressed);
+  StringReader reader{encoded};
+  db_->metrics()->RecordBytesDecoded(encoded.size());
+
+  auto message =
+      Message<firestore_client_MaybeDocument>::TryParseWithArena(&reader);
+  if (!reader.ok()) {
+    HARD_FAIL("MaybeDocument proto failed to parse: %s",
+              reader.status().ToString());
+  }
+  if (message->which_document_type !=
+      firestore_client_MaybeDocument_document_tag) {
+    return absl::nullopt;
+  }
+
+  // Most documents of a filtered collection scan don't match, so check the
+  // filters against just the fields they read before decoding the rest of the
+  // document.
+  if (!query.filters().empty()) {
+    ObjectValue fields = ObjectValue::Empty();
+    bool missing_field = false;
+    for (const Filter& filter : query.filters()) {
+      if (!filter.IsAFieldFilter() || filter.field().IsKeyFieldPath()) {
+        continue;
+      }
+      absl::optional<FieldValue> value =
+          serializer_->DecodeDocumentField(&reader, *message, filter.field());
+      if (value) {
+        fields = fields.Set(filter.field(), *value);
+      } else {
+        missing_field = true;
+      }
+    }
+    if (!reader.ok()) {
+      HARD_FAIL("MaybeDocument proto failed to parse: %s",
+                reader.status().ToString());
+    }
+
+    Document partial_doc(std::move(fields), key, SnapshotVersion::None(),
+                         DocumentState::kSynced);
+    for (const Filter& filter : query.filters()) {
+      if (!filter.Matches(partial_doc)) {
+        // A missing field may have been moved to a chunk, which only the full
+        // decode reads.
+        if (!missing_field ||
+            !serializer_->DecodeDocumentField(&reader, *message,
+                                              ChunksFieldPath())) {
+          return absl::nullopt;
+        }
+        break;
+      }
+    }
+  }
+
+  // A projected query never returns the other fields, so don't decode them.
+  MaybeDocument maybe_document =
+      query.has_projection()
+          ? serializer_->DecodeDocumentFields(&reader, *message,
+                                              query.ReadMask())
+          : serializer_->DecodeMaybeDocument(&reader, *message);
+  if (!reader.ok()) {
+    HARD_FAIL("MaybeDocument proto failed to parse: %s",
+              reader.status().ToString());
+  }
+  HARD_ASSERT(maybe_document.key() == key,
+              "Read document has key (%s) instead of expected key (%s).",
+              maybe_document.key().ToString(), key.ToString());
+
+  Document doc(std::move(maybe_document));
+  absl::optional<FieldValue> chunk_ids =
+      query.has_projection()
+          ? serializer_->DecodeDocumentField(&reader, *message,
+                                             ChunksFieldPath())
+          : doc.field(ChunksFieldPath());
+  if (chunk_ids) {
+    const FieldMask* mask =
+        query.has_projection() ? &query.ReadMask() : nullptr;
+    doc = Document(LoadChunks(key, doc.data(), *chunk_ids, mask, transaction),
+                   key, doc.version(), doc.document_state());
+  }
+
+  if (!query.Matches(doc)) {
+    return absl::nullopt;
+  }
+  return doc;
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -17,14 +17,25 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_REMOTE_DOCUMENT_CACHE_H_
 
+#include <map>
 #include <memory>
+#include <mutex>   // NOLINT(build/c++11)
+#include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/hot_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -35,14 +46,23 @@ class Executor;
 
 namespace local {
 
+class DocumentSnapshot;
 class LevelDbPersistence;
+class LevelDbTransaction;
 class LocalSerializer;
 
 /** Cached Remote Documents backed by leveldb. */
 class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
  public:
+  /**
+   * Creates a cache over the remote document table of `db`. If
+   * `compress_documents` is true, documents are written compressed with a
+   * dictionary of their collection; see LevelDbCompressionDictionaryKey.
+   * Compressed rows are read back regardless of the option.
+   */
   LevelDbRemoteDocumentCache(LevelDbPersistence* db,
-                             LocalSerializer* serializer);
+                             LocalSerializer* serializer,
+                             bool compress_documents = false);
   ~LevelDbRemoteDocumentCache();
 
   void Add(const model::MaybeDocument& document,
@@ -51,28 +71,243 @@ class LevelDbRemoteDocumentCache : public RemoteDocumentCache {
 
   absl::optional<model::MaybeDocument> Get(
       const model::DocumentKey& key) override;
+
+  /**
+   * Returns true if the cache holds a `NoDocument` or an `UnknownDocument`
+   * for the given key, without decoding it.
+   */
+  bool ContainsTombstone(const model::DocumentKey& key);
+
   model::OptionalMaybeDocumentMap GetAll(
       const model::DocumentKeySet& keys) override;
   model::DocumentMap GetMatching(
       const core::Query& query,
       const model::SnapshotVersion& since_read_time) override;
 
+  /**
+   * Decodes documents one at a time as the cursor advances, for full
+   * collection scans that don't use the document snapshot. Other scans fall
+   * back to `GetMatching`.
+   */
+  std::unique_ptr<DocumentCursor> ScanMatching(
+      const core::Query& query,
+      const model::SnapshotVersion& since_read_time) override;
+
+  /**
+   * Finds the documents of the collection group with a single scan of the
+   * collection group documents index. Returns nullopt while the index is
+   * being backfilled.
+   */
+  absl::optional<model::DocumentMap> GetMatchingCollectionGroup(
+      const core::Query& query,
+      const model::SnapshotVersion& since_read_time) override;
+
+  /**
+   * Enables or disables the read-optimized document snapshot stored at the
+   * given path. When enabled, full collection scans in GetMatching read
+   * documents from the snapshot file instead of LevelDB, and only documents
+   * changed since the file was built are read from LevelDB.
+   *
+   * Must be called in a transaction, before the cache is otherwise used.
+   * Disabling the snapshot deletes the file and any bookkeeping rows.
+   */
+  void ConfigureSnapshot(bool enabled, const util::Path& path);
+
+  /**
+   * Advances the document snapshot, if it is enabled. Compaction happens in
+   * two steps so that the worker queue never waits for the file to be
+   * written: one call starts rebuilding the file in the background from the
+   * current contents of LevelDB, and a later call installs the new file and
+   * drops the changes it now includes.
+   *
+   * Must be called in a transaction.
+   */
+  void CompactSnapshot();
+
+  /** Blocks until any snapshot being built in the background is written. */
+  void AwaitSnapshotBuild();
+
+  /**
+   * Reads and decodes the given documents on a background executor, up to the
+   * capacity of `hot_documents()`. The next lookup on the worker queue after
+   * they are ready adds them to `hot_documents()`, except for any that have
+   * been written since the prefetch started.
+   *
+   * Must be called in a transaction, before it writes any documents. Does
+   * nothing if a prefetch is already in progress.
+   */
+  void Prefetch(const model::DocumentKeySet& keys) override;
+
+  /** Blocks until any documents being prefetched have been read. */
+  void AwaitPrefetch();
+
+  /**
+   * The recently read documents kept in memory in front of LevelDB. Exposed
+   * for its hit and miss counters.
+   */
+  const HotDocumentCache& hot_documents() const {
+    return hot_documents_;
+  }
+
+  /** Drops the recently read documents kept in memory. */
+  size_t ReleaseMemory() override;
+
  private:
+  class MatchingCursor;
+
   /**
    * Looks up a set of entries in the cache, returning only existing entries of
    * Type::Document.
    */
   model::DocumentMap GetAllExisting(const model::DocumentKeySet& keys);
 
+  using LookupResult =
+      std::pair<model::DocumentKey, absl::optional<model::MaybeDocument>>;
+
+  /**
+   * Looks up the given keys with a single forward pass over the cache,
+   * decoding the documents found in parallel. The results are unordered.
+   */
+  std::vector<LookupResult> ReadAll(const model::DocumentKeySet& keys);
+
+  /**
+   * Decodes the given row of the remote document table. `transaction` is the
+   * transaction the row was read in, which the document's chunks are read
+   * from. This may be called from several threads at once.
+   */
   model::MaybeDocument DecodeMaybeDocument(absl::string_view encoded,
-                                           const model::DocumentKey& key);
+                                           const model::DocumentKey& key,
+                                           LevelDbTransaction* transaction);
+
+  /**
+   * Decodes the given encoded MaybeDocument if it is a Document that matches
+   * the query. Only the fields the query filters on are decoded until the
+   * document is known to match.
+   */
+  absl::optional<model::Document> DecodeMatchingDocument(
+      absl::string_view encoded,
+      const model::DocumentKey& key,
+      const core::Query& query,
+      LevelDbTransaction* transaction);
+
+  /**
+   * Encodes `document` for its row in the remote document table. If the
+   * encoding is large, the large values of the document are left out of the
+   * row and returned in `chunks` by chunk ID, to be stored in rows of their
+   * own; see LevelDbRemoteDocumentChunkKey.
+   */
+  std::string EncodeDocumentRow(const model::MaybeDocument& document,
+                                std::map<std::string, std::string>* chunks);
+
+  /**
+   * Compresses `encoded`, the row of a Document, with the dictionary of its
+   * collection. Until the collection has a dictionary, rows are kept as
+   * samples to build it from, and compressed without one.
+   */
+  std::string CompressDocument(const model::DocumentKey& key,
+                               std::string encoded);
+
+  /**
+   * Returns the encoded MaybeDocument stored in `row`, decompressing it into
+   * `buffer` if it's compressed. May be called from several threads at once.
+   */
+  absl::string_view DecompressDocument(absl::string_view row,
+                                       const model::DocumentKey& key,
+                                       LevelDbTransaction* transaction,
+                                       std::string* buffer);
+
+  /**
+   * Returns the compression dictionary of the given collection, or null if it
+   * has none yet. May be called from several threads at once.
+   */
+  std::shared_ptr<const std::string> GetCompressionDictionary(
+      const model::ResourcePath& collection_path,
+      LevelDbTransaction* transaction);
+
+  /**
+   * Replaces the chunks of the given document with `chunks`, only writing the
+   * rows of chunks that aren't stored yet.
+   */
+  void WriteChunks(const model::DocumentKey& key,
+                   const std::map<std::string, std::string>& chunks);
+
+  /**
+   * Puts the values of a chunked document back into its `data`, as decoded
+   * from its row. `chunk_ids` maps the paths of the values to their chunks.
+   * If `mask` is given, only the chunks of the values it covers are read.
+   */
+  model::ObjectValue LoadChunks(const model::DocumentKey& key,
+                                model::ObjectValue data,
+                                const model::FieldValue& chunk_ids,
+                                const model::FieldMask* mask,
+                                LevelDbTransaction* transaction) const;
+
+  /**
+   * Records that the given document changed since the document snapshot was
+   * last built, if the snapshot is enabled.
+   */
+  void RecordSnapshotChange(const model::DocumentKey& key);
+
+  /** Performs a full collection scan using the document snapshot. */
+  model::DocumentMap GetMatchingFromSnapshot(const core::Query& query);
+
+  /** Installs the snapshot built in the background, if it has finished. */
+  void InstallBuiltSnapshot();
+
+  void InstallPrefetchedDocuments();
 
   // The LevelDbRemoteDocumentCache instance is owned by LevelDbPersistence.
   LevelDbPersistence* db_;
   // Owned by LevelDbPersistence.
   LocalSerializer* serializer_ = nullptr;
 
+  // Decoded documents read by Get and GetAll. Invalidated by Add and Remove,
+  // which are the only writers of document rows.
+  HotDocumentCache hot_documents_;
+
   std::unique_ptr<util::Executor> executor_;
+  // The number of threads that decode documents, including the calling one.
+  int executor_threads_ = 1;
+
+  // The generation assigned to document changes, or 0 if the document
+  // snapshot is disabled. Documents changed at a generation later than the
+  // installed snapshot's are read from LevelDB.
+  int64_t snapshot_generation_ = 0;
+  util::Path snapshot_path_;
+  std::unique_ptr<DocumentSnapshot> snapshot_;
+
+  // A snapshot built in the background is handed back to the worker queue
+  // under `snapshot_build_mutex_`.
+  bool snapshot_build_in_progress_ = false;
+  std::mutex snapshot_build_mutex_;
+  bool snapshot_build_finished_ = false;
+  std::unique_ptr<DocumentSnapshot> built_snapshot_;
+
+  // Documents prefetched in the background are handed back to the worker
+  // queue under `prefetch_mutex_`. Keys written since the prefetch started
+  // are left out, since the prefetched documents may predate the writes.
+  bool prefetch_in_progress_ = false;
+  std::unordered_set<model::DocumentKey, model::DocumentKeyHash>
+      prefetch_written_keys_;
+  std::mutex prefetch_mutex_;
+  bool prefetch_finished_ = false;
+  std::vector<std::pair<model::MaybeDocument, size_t>> prefetched_;
+
+  bool compress_documents_ = false;
+  // Encoded documents of collections that don't have a compression dictionary
+  // yet, from which it's built. Only used on the worker queue.
+  std::map<model::ResourcePath, std::vector<std::string>> dictionary_samples_;
+  // The dictionaries read or written so far. Dictionaries never change once
+  // written, so they're kept for the lifetime of the cache.
+  std::mutex dictionaries_mutex_;
+  std::map<model::ResourcePath, std::shared_ptr<const std::string>>
+      dictionaries_;
+
+  // Build snapshot files and prefetch documents off the worker queue.
+  // Declared last so that they are destroyed, finishing their work, before the
+  // state that work writes to.
+  std::unique_ptr<util::Executor> snapshot_executor_;
+  std::unique_ptr<util::Executor> prefetch_executor_;
 };
 
 }  // namespace local
@@ -16,8 +16,13 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_target_cache.h"
 
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
@@ -27,8 +32,11 @@
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "absl/strings/match.h"
 
@@ -41,6 +49,7 @@ using leveldb::Status;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::ListenSequenceNumber;
+using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetId;
 using nanopb::ByteString;
@@ -96,6 +105,18 @@ void LevelDbTargetCache::Start() {
     HARD_FAIL("Failed to decode last remote snapshot version, reason: '%s'",
               reader.status().ToString());
   }
+
+  std::string prefix = LevelDbTargetSequenceKey::KeyPrefix();
+  std::unique_ptr<leveldb::Iterator> it(
+      db_->ptr()->NewIterator(StandardReadOptions()));
+  LevelDbTargetSequenceKey row_key;
+  for (it->Seek(prefix);
+       it->Valid() && absl::StartsWith(MakeStringView(it->key()), prefix);
+       it->Next()) {
+    HARD_ASSERT(row_key.Decode(MakeStringView(it->key())),
+                "Failed to decode target sequence key");
+    sequence_numbers_[row_key.target_id()] = row_key.sequence_number();
+  }
 }
 
 void LevelDbTargetCache::AddTarget(const TargetData& target_data) {
@@ -123,7 +144,7 @@ void LevelDbTargetCache::UpdateTarget(const TargetData& target_data) {
 void LevelDbTargetCache::RemoveTarget(const TargetData& target_data) {
   TargetId target_id = target_data.target_id();
 
-  RemoveAllKeysForTarget(target_id);
+  RemoveAllKeysForTarget(target_id, target_data.sequence_number());
 
   std::string key = LevelDbTargetKey::Key(target_id);
   db_->current_transaction()->Delete(key);
@@ -132,6 +153,13 @@ void LevelDbTargetCache::RemoveTarget(const TargetData& target_data) {
       LevelDbQueryTargetKey::Key(target_data.target().CanonicalId(), target_id);
   db_->current_transaction()->Delete(index_key);
 
+  auto found = sequence_numbers_.find(target_id);
+  if (found != sequence_numbers_.end()) {
+    db_->current_transaction()->Delete(
+        LevelDbTargetSequenceKey::Key(found->second, target_id));
+    sequence_numbers_.erase(found);
+  }
+
   metadata_->target_count--;
   SaveMetadata();
 }
@@ -201,16 +229,46 @@ void LevelDbTargetCache::EnumerateTargets(const TargetCallback& callback) {
 int LevelDbTargetCache::RemoveTargets(
     ListenSequenceNumber upper_bound,
     const std::unordered_map<model::TargetId, TargetData>& live_targets) {
+  std::string position;
+  return RemoveTargets(upper_bound, live_targets,
+                       std::numeric_limits<size_t>::max(), &position);
+}
+
+int LevelDbTargetCache::RemoveTargets(
+    ListenSequenceNumber upper_bound,
+    const std::unordered_map<model::TargetId, TargetData>& live_targets,
+    size_t max_targets,
+    std::string* position) {
   int count = 0;
-  std::string target_prefix = LevelDbTargetKey::KeyPrefix();
+  size_t examined = 0;
+  std::string index_prefix = LevelDbTargetSequenceKey::KeyPrefix();
   auto it = db_->current_transaction()->NewIterator();
-  it->Seek(target_prefix);
-  for (; it->Valid() && absl::StartsWith(it->key(), target_prefix);
+  it->Seek(position->empty() ? index_prefix : *position);
+  position->clear();
+  LevelDbTargetSequenceKey row_key;
+  for (; it->Valid() && absl::StartsWith(it->key(), index_prefix);
        it->Next()) {
-    TargetData target_data = DecodeTarget(it->value());
-    if (target_data.sequence_number() <= upper_bound &&
-        live_targets.find(target_data.target_id()) == live_targets.end()) {
-      RemoveTarget(target_data);
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode target sequence key");
+    // The index is ordered by sequence number, so no later target is
+    // collectable either.
+    if (row_key.sequence_number() > upper_bound) {
+      break;
+    }
+    if (examined == max_targets) {
+      *position = it->key();
+      break;
+    }
+    ++examined;
+
+    // Only the targets being removed are read.
+    if (live_targets.find(row_key.target_id()) == live_targets.end()) {
+      std::string value;
+      Status status = db_->current_transaction()->Get(
+          LevelDbTargetKey::Key(row_key.target_id()), &value);
+      HARD_ASSERT(status.ok(), "Dangling target sequence reference: %s",
+                  DescribeKey(it));
+      RemoveTarget(DecodeTarget(value));
       count++;
     }
   }
@@ -226,66 +284,156 @@ void LevelDbTargetCache::AddMatchingKeys(const DocumentKeySet& keys,
   std::string empty_buffer;
 
   for (const DocumentKey& key : keys) {
-    db_->current_transaction()->Put(
-        LevelDbTargetDocumentKey::Key(target_id, key), empty_buffer);
     db_->current_transaction()->Put(
         LevelDbDocumentTargetKey::Key(key, target_id), empty_buffer);
     db_->reference_delegate()->AddReference(key);
   }
+  UpdateChunks(keys, target_id, /*add=*/true);
 }
 
 void LevelDbTargetCache::RemoveMatchingKeys(const DocumentKeySet& keys,
                                             TargetId target_id) {
   for (const DocumentKey& key : keys) {
-    db_->current_transaction()->Delete(
-        LevelDbTargetDocumentKey::Key(target_id, key));
     db_->current_transaction()->Delete(
         LevelDbDocumentTargetKey::Key(key, target_id));
     db_->reference_delegate()->RemoveReference(key);
   }
+  UpdateChunks(keys, target_id, /*add=*/false);
 }
 
-void LevelDbTargetCache::RemoveAllKeysForTarget(TargetId target_id) {
-  std::string index_prefix = LevelDbTargetDocumentKey::KeyPrefix(target_id);
-  auto index_iterator = db_->current_transaction()->NewIterator();
-  index_iterator->Seek(index_prefix);
+void LevelDbTargetCache::UpdateChunks(const DocumentKeySet& keys,
+                                      TargetId target_id,
+                                      bool add) {
+  std::vector<DocumentKey> pending(keys.begin(), keys.end());
+  std::string chunk_prefix =
+      LevelDbTargetDocumentChunkKey::KeyPrefix(target_id);
+  auto it = db_->current_transaction()->NewIterator();
+  LevelDbTargetDocumentChunkKey chunk_key;
+
+  // Chunks are stored from the greatest bound down, so seeking to the greatest
+  // pending key finds the chunk that holds it along with every other pending
+  // key from the chunk's bound up.
+  while (!pending.empty()) {
+    it->Seek(LevelDbTargetDocumentChunkKey::Key(target_id,
+                                                pending.back().path()));
+
+    ResourcePath bound;
+    std::vector<DocumentKey> documents;
+    if (it->Valid() && absl::StartsWith(it->key(), chunk_prefix)) {
+      HARD_ASSERT(chunk_key.Decode(it->key()),
+                  "Failed to decode target document chunk key");
+      bound = chunk_key.bound();
+      LevelDbTargetDocumentChunkKey::DecodeDocumentKeys(it->value(),
+                                                        &documents);
+    }
+    // Otherwise all chunks of the target lie above the remaining keys, which
+    // go into a new chunk bounded by the empty path.
+
+    auto first = std::lower_bound(
+        pending.begin(), pending.end(), bound,
+        [](const DocumentKey& key, const ResourcePath& chunk_bound) {
+          return key.path().CompareTo(chunk_bound) ==
+                 util::ComparisonResult::Ascending;
+        });
+
+    std::vector<DocumentKey> updated;
+    if (add) {
+      std::set_union(documents.begin(), documents.end(), first, pending.end(),
+                     std::back_inserter(updated));
+    } else {
+      std::set_difference(documents.begin(), documents.end(), first,
+                          pending.end(), std::back_inserter(updated));
+    }
+    pending.erase(first, pending.end());
 
-  LevelDbTargetDocumentKey row_key;
-  for (; index_iterator->Valid(); index_iterator->Next()) {
-    absl::string_view index_key = index_iterator->key();
+    if (updated.size() == documents.size()) {
+      continue;
+    }
+    std::string key = LevelDbTargetDocumentChunkKey::Key(target_id, bound);
+    if (updated.empty()) {
+      db_->current_transaction()->Delete(key);
+      continue;
+    }
 
-    // Only consider rows matching this specific target_id.
-    if (!row_key.Decode(index_key) || row_key.target_id() != target_id) {
-      break;
+    // Split full chunks in halves, so that the next few additions don't each
+    // split them again.
+    size_t max_documents = LevelDbTargetDocumentChunkKey::kMaxDocuments;
+    size_t split_size =
+        updated.size() <= max_documents ? updated.size() : max_documents / 2;
+    for (size_t start = 0; start < updated.size(); start += split_size) {
+      size_t end = std::min(start + split_size, updated.size());
+      if (start > 0) {
+        key = LevelDbTargetDocumentChunkKey::Key(target_id,
+                                                 updated[start].path());
+      }
+      db_->current_transaction()->Put(
+          key, LevelDbTargetDocumentChunkKey::EncodeDocumentKeys(
+                   updated.begin() + start, updated.begin() + end));
     }
-    const DocumentKey& document_key = row_key.document_key();
+  }
+}
 
-    // Delete both index rows
-    db_->current_transaction()->Delete(index_key);
-    db_->current_transaction()->Delete(
-        LevelDbDocumentTargetKey::Key(document_key, target_id));
+void LevelDbTargetCache::RemoveAllKeysForTarget(
+    TargetId target_id, ListenSequenceNumber sequence_number) {
+  std::string chunk_prefix =
+      LevelDbTargetDocumentChunkKey::KeyPrefix(target_id);
+  auto it = db_->current_transaction()->NewIterator();
+  it->Seek(chunk_prefix);
+
+  std::vector<DocumentKey> documents;
+  for (; it->Valid() && absl::StartsWith(it->key(), chunk_prefix);
+       it->Next()) {
+    documents.clear();
+    LevelDbTargetDocumentChunkKey::DecodeDocumentKeys(it->value(), &documents);
+    for (const DocumentKey& document_key : documents) {
+      db_->current_transaction()->Delete(
+          LevelDbDocumentTargetKey::Key(document_key, target_id));
+      // Documents get no sentinel while they are in a target, see
+      // LevelDbLruReferenceDelegate::AddReference.
+      EnsureSentinel(document_key, sequence_number);
+    }
+    db_->current_transaction()->Delete(it->key());
   }
 }
 
+void LevelDbTargetCache::EnsureSentinel(const DocumentKey& key,
+                                        ListenSequenceNumber sequence_number) {
+  std::string sentinel_key = LevelDbDocumentTargetKey::SentinelKey(key);
+  std::string value;
+  Status status = db_->current_transaction()->Get(sentinel_key, &value);
+  if (status.ok() &&
+      LevelDbDocumentTargetKey::DecodeSentinelValue(value) >= sequence_number) {
+    return;
+  }
+  db_->current_transaction()->Put(
+      sentinel_key,
+      LevelDbDocumentTargetKey::EncodeSentinelValue(sequence_number));
+}
+
 DocumentKeySet LevelDbTargetCache::GetMatchingKeys(TargetId target_id) {
-  std::string index_prefix = LevelDbTargetDocumentKey::KeyPrefix(target_id);
-  auto index_iterator = db_->current_transaction()->NewIterator();
-  index_iterator->Seek(index_prefix);
+  std::string chunk_prefix =
+      LevelDbTargetDocumentChunkKey::KeyPrefix(target_id);
+  auto it = db_->current_transaction()->NewIterator();
+  it->Seek(chunk_prefix);
 
-  DocumentKeySet result;
-  LevelDbTargetDocumentKey row_key;
-  for (; index_iterator->Valid(); index_iterator->Next()) {
-    // TODO(gsoltis): could we use a StartsWith instead?
-    // Only consider rows matching this specific target_id.
-    if (!row_key.Decode(index_iterator->key()) ||
-        row_key.target_id() != target_id) {
-      break;
-    }
+  // Chunks are stored from the greatest bound down, and each holds its
+  // documents in order, so the set can be built in one pass once the chunks
+  // are read in reverse.
+  std::vector<std::string> chunks;
+  for (; it->Valid() && absl::StartsWith(it->key(), chunk_prefix);
+       it->Next()) {
+    chunks.push_back(it->value());
+  }
 
-    result = result.insert(row_key.document_key());
+  std::vector<DocumentKey> result;
+  for (auto chunk = chunks.rbegin(); chunk != chunks.rend(); ++chunk) {
+    LevelDbTargetDocumentChunkKey::DecodeDocumentKeys(*chunk, &result);
+  }
+  for (DocumentKey& key : result) {
+    key = key_interner_.Intern(key);
   }
 
-  return result;
+  return DocumentKeySet::FromSortedRange(result.begin(), result.end());
 }
 
 bool LevelDbTargetCache::Contains(const DocumentKey& key) {
@@ -321,11 +469,52 @@ void LevelDbTargetCache::SetLastRemoteSnapshotVersion(SnapshotVersion version) {
   SaveMetadata();
 }
 
+std::vector<TargetId> LevelDbTargetCache::GetStartupTargets() {
+  std::string encoded;
+  Status status = db_->current_transaction()->Get(
+      LevelDbStartupTargetsKey::Key(), &encoded);
+  if (!status.ok()) {
+    return {};
+  }
+  return LevelDbStartupTargetsKey::DecodeTargetIds(encoded);
+}
+
+void LevelDbTargetCache::SetStartupTargets(
+    const std::vector<TargetId>& target_ids) {
+  db_->current_transaction()->Put(
+      LevelDbStartupTargetsKey::Key(),
+      LevelDbStartupTargetsKey::EncodeTargetIds(target_ids));
+}
+
+void LevelDbTargetCache::EnumerateSequenceNumbers(
+    const SequenceNumberCallback& callback) {
+  std::string prefix = LevelDbTargetSequenceKey::KeyPrefix();
+  auto it = db_->current_transaction()->NewIterator();
+  LevelDbTargetSequenceKey row_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix);
+       it->Next()) {
+    HARD_ASSERT(row_key.Decode(it->key()),
+                "Failed to decode target sequence key");
+    callback(row_key.sequence_number());
+  }
+}
+
 void LevelDbTargetCache::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
+  std::string position;
+  EnumerateOrphanedDocuments(callback, std::numeric_limits<size_t>::max(),
+                             &position);
+}
+
+void LevelDbTargetCache::EnumerateOrphanedDocuments(
+    const OrphanedDocumentCallback& callback,
+    size_t max_documents,
+    std::string* position) {
   std::string document_target_prefix = LevelDbDocumentTargetKey::KeyPrefix();
   auto it = db_->current_transaction()->NewIterator();
-  it->Seek(document_target_prefix);
+  it->Seek(position->empty() ? document_target_prefix : *position);
+  position->clear();
+  size_t examined = 0;
   ListenSequenceNumber next_to_report = 0;
   DocumentKey key_to_report;
   LevelDbDocumentTargetKey key;
@@ -333,12 +522,21 @@ void LevelDbTargetCache::EnumerateOrphanedDocuments(
   for (; it->Valid() && absl::StartsWith(it->key(), document_target_prefix);
        it->Next()) {
     HARD_ASSERT(key.Decode(it->key()), "Failed to decode DocumentTarget key");
+    // if next_to_report is non-zero and this is a new key, report it, the last
+    // one must be not be a member of any targets. Documents that are in a
+    // target may have no sentinel, so the new key may not be one.
+    if (next_to_report != 0 && key.document_key() != key_to_report) {
+      callback(key_to_report, next_to_report);
+      next_to_report = 0;
+    }
     if (key.IsSentinel()) {
-      // if next_to_report is non-zero, report it, this is a new key so the last
-      // one must be not be a member of any targets.
-      if (next_to_report != 0) {
-        callback(key_to_report, next_to_report);
+      // Sentinels sort before the target rows of their document, so stopping
+      // here never splits a document across slices.
+      if (examined == max_documents) {
+        *position = it->key();
+        break;
       }
+      ++examined;
       // set next_to_report to be this sequence number. It's the next one we
       // might report, if we don't find any targets for this document.
       next_to_report =
@@ -362,6 +560,23 @@ void LevelDbTargetCache::Save(const TargetData& target_data) {
   std::string key = LevelDbTargetKey::Key(target_id);
   db_->current_transaction()->Put(key,
                                   serializer_->EncodeTargetData(target_data));
+  SaveSequenceNumber(target_data);
+}
+
+void LevelDbTargetCache::SaveSequenceNumber(const TargetData& target_data) {
+  TargetId target_id = target_data.target_id();
+  ListenSequenceNumber sequence_number = target_data.sequence_number();
+  auto found = sequence_numbers_.find(target_id);
+  if (found != sequence_numbers_.end()) {
+    if (found->second == sequence_number) return;
+    db_->current_transaction()->Delete(
+        LevelDbTargetSequenceKey::Key(found->second, target_id));
+  }
+
+  std::string empty_buffer;
+  db_->current_transaction()->Put(
+      LevelDbTargetSequenceKey::Key(sequence_number, target_id), empty_buffer);
+  sequence_numbers_[target_id] = sequence_number;
 }
 
 bool LevelDbTargetCache::UpdateMetadata(const TargetData& target_data) {
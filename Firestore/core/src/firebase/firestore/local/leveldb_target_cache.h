@@ -17,10 +17,13 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_TARGET_CACHE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LEVELDB_TARGET_CACHE_H_
 
+#include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/local/target_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_interner.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
@@ -91,8 +94,13 @@ class LevelDbTargetCache : public TargetCache {
   void RemoveMatchingKeys(const model::DocumentKeySet& keys,
                           model::TargetId target_id) override;
 
-  /** Removes all the keys in the query results of the given target ID. */
-  void RemoveAllKeysForTarget(model::TargetId target_id);
+  /**
+   * Removes all the keys in the query results of the given target ID. The
+   * documents are left with sentinels of at least `sequence_number`, the last
+   * time the target was used.
+   */
+  void RemoveAllKeysForTarget(model::TargetId target_id,
+                              model::ListenSequenceNumber sequence_number);
 
   model::DocumentKeySet GetMatchingKeys(model::TargetId target_id) override;
 
@@ -118,16 +126,71 @@ class LevelDbTargetCache : public TargetCache {
 
   void SetLastRemoteSnapshotVersion(model::SnapshotVersion version) override;
 
+  std::vector<model::TargetId> GetStartupTargets() override;
+
+  void SetStartupTargets(
+      const std::vector<model::TargetId>& target_ids) override;
+
   // Non-interface methods
   void Start();
 
   void EnumerateOrphanedDocuments(const OrphanedDocumentCallback& callback);
 
+  /**
+   * Enumerates the sequence numbers of all targets, in ascending order, from
+   * the target sequences index without reading the targets themselves.
+   */
+  void EnumerateSequenceNumbers(const SequenceNumberCallback& callback);
+
+  /**
+   * Like `EnumerateOrphanedDocuments` above, but examines at most
+   * `max_documents` documents, starting at `position` (or at the beginning of
+   * the index if `position` is empty). On return, `position` holds the key at
+   * which to resume, or is empty if the whole index has been examined.
+   */
+  void EnumerateOrphanedDocuments(const OrphanedDocumentCallback& callback,
+                                  size_t max_documents,
+                                  std::string* position);
+
+  /**
+   * Like `RemoveTargets` above, but examines at most `max_targets` targets,
+   * starting at `position` (or at the first target if `position` is empty). On
+   * return, `position` holds the key at which to resume, or is empty if all
+   * targets have been examined.
+   *
+   * Targets are examined in order of their sequence numbers, so examining
+   * stops at the first target after `upper_bound`.
+   */
+  int RemoveTargets(
+      model::ListenSequenceNumber upper_bound,
+      const std::unordered_map<model::TargetId, TargetData>& live_targets,
+      size_t max_targets,
+      std::string* position);
+
  private:
   void Save(const TargetData& target_data);
+
+  /** Moves the target's row in the target sequences index, if needed. */
+  void SaveSequenceNumber(const TargetData& target_data);
   bool UpdateMetadata(const TargetData& target_data);
   void SaveMetadata();
 
+  /**
+   * Adds the given document keys to the chunks of the given target, or removes
+   * them from the chunks if `add` is false. Only the chunks that hold (or
+   * would hold) the keys are read and rewritten.
+   */
+  void UpdateChunks(const model::DocumentKeySet& keys,
+                    model::TargetId target_id,
+                    bool add);
+
+  /**
+   * Writes a sentinel row for the given document with `sequence_number`,
+   * unless it has one with a later sequence number already.
+   */
+  void EnsureSentinel(const model::DocumentKey& key,
+                      model::ListenSequenceNumber sequence_number);
+
   /**
    * Parses the given bytes as a `firestore_client_Target` protocol buffer and
    * then converts to the equivalent target data.
@@ -142,7 +205,20 @@ class LevelDbTargetCache : public TargetCache {
   /** A write-through cached copy of the metadata for the target cache. */
   nanopb::Message<firestore_client_TargetGlobal> metadata_;
 
+  /**
+   * A write-through cached copy of the target sequences index, by target ID,
+   * so that updating a target finds its old row without reading the target.
+   */
+  std::unordered_map<model::TargetId, model::ListenSequenceNumber>
+      sequence_numbers_;
+
   model::SnapshotVersion last_remote_snapshot_version_;
+
+  /**
+   * Shares the paths of keys returned from GetMatchingKeys, so documents that
+   * match several targets are only held in memory once.
+   */
+  model::DocumentKeyInterner key_interner_;
 };
 
 }  // namespace local
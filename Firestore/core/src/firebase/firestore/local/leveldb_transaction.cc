@@ -51,6 +51,7 @@ void LevelDbTransaction::Iterator::UpdateCurrent() {
   is_valid_ = mutation_is_valid || db_iter_->Valid();
 
   if (is_valid_) {
+    ++txn_->keys_read_;
     if (!mutation_is_valid) {
       is_mutation_ = false;
     } else if (!db_iter_->Valid()) {
@@ -165,17 +166,31 @@ void LevelDbTransaction::Put(std::string key, std::string value) {
   version_++;
 }
 
+std::string* LevelDbTransaction::PendingValue(std::string key) {
+  deletions_.erase(key);
+  std::string* value = &mutations_[std::move(key)];
+  value->clear();
+  version_++;
+  return value;
+}
+
 std::unique_ptr<LevelDbTransaction::Iterator>
 LevelDbTransaction::NewIterator() {
   return absl::make_unique<LevelDbTransaction::Iterator>(this);
 }
 
 Status LevelDbTransaction::Get(absl::string_view key, std::string* value) {
+  ++keys_read_;
+  return GetConcurrently(key, value);
+}
+
+Status LevelDbTransaction::GetConcurrently(absl::string_view key,
+                                           std::string* value) const {
   std::string key_string(key);
   if (deletions_.find(key_string) != deletions_.end()) {
     return Status::NotFound(key_string + " is not present in the transaction");
   } else {
-    Mutations::iterator iter{mutations_.find(key_string)};
+    Mutations::const_iterator iter{mutations_.find(key_string)};
     if (iter != mutations_.end()) {
       *value = iter->second;
       return Status::OK();
@@ -149,6 +149,18 @@ class LevelDbTransaction {
     return mutations_.size() + deletions_.size();
   }
 
+  /**
+   * Whether `Commit` waits until the changes have reached the disk, rather
+   * than returning once the operating system has them. Unsynced changes
+   * survive a crash of the process but not one of the device.
+   */
+  bool sync() const {
+    return write_options_.sync;
+  }
+  void set_sync(bool sync) {
+    write_options_.sync = sync;
+  }
+
   /**
    * Remove the database entry (if any) for "key".  It is not an error if "key"
    * did not exist in the database.
@@ -164,10 +176,17 @@ class LevelDbTransaction {
   /**
    * Schedules the row identified by `key` to be set to the given protocol
    * buffer message when this transaction commits.
+   *
+   * The message is encoded directly into the pending value, sized up front, so
+   * that storing it costs at most one allocation regardless of its size, and
+   * none if a value at least as large is already pending for the key.
    */
   template <typename T>
   void Put(std::string key, const nanopb::Message<T>& message) {
-    Put(std::move(key), MakeStdString(message));
+    std::string* value = PendingValue(std::move(key));
+    nanopb::StringWriter writer(value);
+    writer.Reserve(nanopb::EncodedSize(message.fields(), message.get()));
+    writer.Write(message.fields(), message.get());
   }
 
   /**
@@ -178,6 +197,14 @@ class LevelDbTransaction {
    */
   leveldb::Status Get(absl::string_view key, std::string* value);
 
+  /**
+   * Like `Get`, but may be called from several threads at once, as long as the
+   * transaction isn't changed in the meantime. Keys read this way aren't
+   * counted by `keys_read`.
+   */
+  leveldb::Status GetConcurrently(absl::string_view key,
+                                  std::string* value) const;
+
   /**
    * Returns a new Iterator over the pending changes in this transaction, merged
    * with the existing values already in leveldb.
@@ -192,13 +219,28 @@ class LevelDbTransaction {
 
   std::string ToString();
 
+  /**
+   * Returns the number of keys read by this transaction so far, either through
+   * `Get` or by positioning an iterator on an entry.
+   */
+  int64_t keys_read() const {
+    return keys_read_;
+  }
+
  private:
+  /**
+   * Schedules the row identified by `key` to be set and returns its value,
+   * cleared but keeping the storage of any value already pending for it.
+   */
+  std::string* PendingValue(std::string key);
+
   leveldb::DB* db_ = nullptr;
   Mutations mutations_;
   Deletions deletions_;
   leveldb::ReadOptions read_options_;
   leveldb::WriteOptions write_options_;
   int32_t version_ = 0;
+  int64_t keys_read_ = 0;
   std::string label_;
 };
 
@@ -16,21 +16,30 @@
 
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 
+#include <limits>
+#include <map>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/core/target.h"
+#include "Firestore/core/src/firebase/firestore/local/geohash.h"
+#include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
@@ -41,15 +50,114 @@ using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
+using model::FieldPath;
+using model::FieldValue;
 using model::MaybeDocument;
 using model::MaybeDocumentMap;
-using model::Mutation;
 using model::MutationBatch;
 using model::NoDocument;
 using model::OptionalMaybeDocumentMap;
 using model::ResourcePath;
 using model::SnapshotVersion;
 
+namespace {
+
+/**
+ * Merges a cursor over the remote documents of a collection with the overlays
+ * of the local mutations affecting it, yielding the local view of the
+ * documents that match the query.
+ */
+class LocalViewCursor : public DocumentCursor {
+ public:
+  LocalViewCursor(const Query& query,
+                  std::unique_ptr<DocumentCursor> remote_docs,
+                  MutationOverlayCache::CollectionOverlays overlays,
+                  RemoteDocumentCache* remote_document_cache)
+      : query_(query),
+        remote_docs_(std::move(remote_docs)),
+        overlays_(std::move(overlays)),
+        overlay_(overlays_.begin()),
+        remote_document_cache_(remote_document_cache) {
+    // Overlays of documents before the start of a key-ordered query can't
+    // produce results.
+    absl::optional<DocumentKey> start_key = query_.StartKey();
+    if (start_key) {
+      overlay_ = overlays_.lower_bound(*start_key);
+    }
+    Advance();
+  }
+
+  bool Valid() const override {
+    return current_.has_value();
+  }
+
+  const Document& document() const override {
+    return *current_;
+  }
+
+  void Next() override {
+    Advance();
+  }
+
+ private:
+  void Advance() {
+    current_ = absl::nullopt;
+    while (!current_ &&
+           (remote_docs_->Valid() || overlay_ != overlays_.end())) {
+      absl::optional<MaybeDocument> doc;
+      if (overlay_ != overlays_.end() &&
+          (!remote_docs_->Valid() ||
+           overlay_->first <= remote_docs_->document().key())) {
+        doc = overlay_->second.Apply(BaseDocument(overlay_->first,
+                                                  overlay_->second));
+        ++overlay_;
+      } else {
+        doc = remote_docs_->document();
+        remote_docs_->Next();
+      }
+
+      if (doc && doc->is_document()) {
+        Document document(*doc);
+        if (query_.Matches(document)) {
+          current_ = query_.has_projection() ? query_.Project(document)
+                                             : std::move(document);
+        }
+      }
+    }
+  }
+
+  /**
+   * Returns the remote document underlying the given overlay, consuming it
+   * from the remote cursor if present there. As in `AddMissingBaseDocuments`,
+   * documents the query doesn't match are looked up only if the overlay needs
+   * them.
+   */
+  absl::optional<MaybeDocument> BaseDocument(
+      const DocumentKey& key, const MutationOverlayCache::Overlay& overlay) {
+    if (remote_docs_->Valid() && remote_docs_->document().key() == key) {
+      MaybeDocument base_doc = remote_docs_->document();
+      remote_docs_->Next();
+      return base_doc;
+    }
+    if (overlay.needs_base_document()) {
+      absl::optional<MaybeDocument> base_doc = remote_document_cache_->Get(key);
+      if (base_doc && base_doc->is_document()) {
+        return base_doc;
+      }
+    }
+    return absl::nullopt;
+  }
+
+  Query query_;
+  std::unique_ptr<DocumentCursor> remote_docs_;
+  MutationOverlayCache::CollectionOverlays overlays_;
+  MutationOverlayCache::CollectionOverlays::const_iterator overlay_;
+  RemoteDocumentCache* remote_document_cache_ = nullptr;
+  absl::optional<Document> current_;
+};
+
+}  // namespace
+
 absl::optional<MaybeDocument> LocalDocumentsView::GetDocument(
     const DocumentKey& key) {
   std::vector<MutationBatch> batches =
@@ -70,7 +178,7 @@ absl::optional<MaybeDocument> LocalDocumentsView::GetDocument(
 OptionalMaybeDocumentMap LocalDocumentsView::ApplyLocalMutationsToDocuments(
     const OptionalMaybeDocumentMap& docs,
     const std::vector<MutationBatch>& batches) {
-  OptionalMaybeDocumentMap results;
+  OptionalMaybeDocumentMap::Transient results;
 
   for (const auto& kv : docs) {
     const DocumentKey& key = kv.first;
@@ -78,9 +186,9 @@ OptionalMaybeDocumentMap LocalDocumentsView::ApplyLocalMutationsToDocuments(
     for (const MutationBatch& batch : batches) {
       local_view = batch.ApplyToLocalDocument(local_view, key);
     }
-    results = results.insert(key, local_view);
+    results.insert(key, local_view);
   }
-  return results;
+  return std::move(results).freeze();
 }
 
 MaybeDocumentMap LocalDocumentsView::GetDocuments(const DocumentKeySet& keys) {
@@ -90,17 +198,18 @@ MaybeDocumentMap LocalDocumentsView::GetDocuments(const DocumentKeySet& keys) {
 
 MaybeDocumentMap LocalDocumentsView::GetLocalViewOfDocuments(
     const OptionalMaybeDocumentMap& base_docs) {
-  DocumentKeySet all_keys;
+  DocumentKeySet::Transient all_keys;
   for (const auto& kv : base_docs) {
-    all_keys = all_keys.insert(kv.first);
+    all_keys.insert(kv.first);
   }
   std::vector<MutationBatch> batches =
-      mutation_queue_->AllMutationBatchesAffectingDocumentKeys(all_keys);
+      mutation_queue_->AllMutationBatchesAffectingDocumentKeys(
+          std::move(all_keys).freeze());
 
   OptionalMaybeDocumentMap docs =
       ApplyLocalMutationsToDocuments(base_docs, batches);
 
-  MaybeDocumentMap results;
+  MaybeDocumentMap::Transient results;
   for (const auto& kv : docs) {
     const DocumentKey& key = kv.first;
     absl::optional<MaybeDocument> maybe_doc = kv.second;
@@ -110,10 +219,10 @@ MaybeDocumentMap LocalDocumentsView::GetLocalViewOfDocuments(
       maybe_doc = NoDocument(key, SnapshotVersion::None(),
                              /* has_committed_mutations= */ false);
     }
-    results = results.insert(key, *maybe_doc);
+    results.insert(key, *maybe_doc);
   }
 
-  return results;
+  return std::move(results).freeze();
 }
 
 DocumentMap LocalDocumentsView::GetDocumentsMatchingQuery(
@@ -144,6 +253,15 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
       query.path().empty(),
       "Currently we only support collection group queries at the root.");
 
+  // A cache that can find the documents of the collection group directly
+  // saves a query, and a read of the mutation queue, per parent.
+  absl::optional<DocumentMap> remote_docs =
+      remote_document_cache_->GetMatchingCollectionGroup(query,
+                                                         since_read_time);
+  if (remote_docs) {
+    return ApplyLocalMutationsToQueryResults(query, *std::move(remote_docs));
+  }
+
   const std::string& collection_id = *query.collection_group();
   std::vector<ResourcePath> parents =
       index_manager_->GetCollectionParents(collection_id);
@@ -164,41 +282,141 @@ model::DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionGroupQuery(
   return results;
 }
 
+absl::optional<DocumentMap>
+LocalDocumentsView::GetDocumentsMatchingQueryFromIndex(const Query& query) {
+  absl::optional<DocumentKeySet> keys =
+      index_manager_->GetDocumentsMatchingQuery(query);
+  if (!keys) {
+    return absl::nullopt;
+  }
+
+  return ApplyLocalMutationsToQueryResults(query, GetRemoteDocuments(*keys));
+}
+
+DocumentMap LocalDocumentsView::GetDocumentsInBoundingBox(
+    const ResourcePath& collection_path,
+    const FieldPath& field_path,
+    const GeoPoint& south_west,
+    const GeoPoint& north_east) {
+  Query query(collection_path);
+  absl::optional<DocumentKeySet> keys =
+      index_manager_->GetDocumentsInBoundingBox(collection_path, field_path,
+                                                south_west, north_east);
+  DocumentMap remote_docs =
+      keys ? GetRemoteDocuments(*keys)
+           : remote_document_cache_->GetMatching(query,
+                                                 SnapshotVersion::None());
+
+  DocumentMap results =
+      ApplyLocalMutationsToQueryResults(query, std::move(remote_docs));
+  DocumentMap unfiltered = results;
+  for (const auto& kv : unfiltered.underlying_map()) {
+    absl::optional<FieldValue> value = Document(kv.second).field(field_path);
+    if (!value || !value->is_geo_point() ||
+        !BoundingBoxContains(south_west, north_east,
+                             value->geo_point_value())) {
+      results = results.erase(kv.first);
+    }
+  }
+  return results;
+}
+
+std::unique_ptr<DocumentCursor>
+LocalDocumentsView::ScanDocumentsMatchingCollectionQuery(const Query& query) {
+  return absl::make_unique<LocalViewCursor>(
+      query,
+      remote_document_cache_->ScanMatching(query, SnapshotVersion::None()),
+      GetOverlays(query), remote_document_cache_);
+}
+
+size_t LocalDocumentsView::CountDocumentsMatchingQuery(const Query& query) {
+  if (query.IsDocumentQuery()) {
+    return GetDocumentsMatchingDocumentQuery(query.path()).size();
+  }
+
+  std::vector<Query> collection_queries;
+  if (query.IsCollectionGroupQuery()) {
+    const std::string& collection_id = *query.collection_group();
+    for (const ResourcePath& parent :
+         index_manager_->GetCollectionParents(collection_id)) {
+      collection_queries.push_back(
+          query.AsCollectionQueryAtPath(parent.Append(collection_id)));
+    }
+  } else {
+    collection_queries.push_back(query);
+  }
+
+  // Whichever end a limit applies to, it only caps the count.
+  size_t limit = query.has_limit_to_first() || query.has_limit_to_last()
+                     ? static_cast<size_t>(query.limit())
+                     : std::numeric_limits<size_t>::max();
+  size_t count = 0;
+  for (const Query& collection_query : collection_queries) {
+    std::unique_ptr<DocumentCursor> cursor =
+        ScanDocumentsMatchingCollectionQuery(collection_query);
+    for (; count < limit && cursor->Valid(); cursor->Next()) {
+      ++count;
+    }
+  }
+  return count;
+}
+
 DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     const Query& query, const SnapshotVersion& since_read_time) {
-  DocumentMap results =
+  if (since_read_time == SnapshotVersion::None() && query.IsKeyOrdered() &&
+      query.has_limit_to_first()) {
+    // The results are a prefix of the scan, so stop reading after them.
+    DocumentMap results;
+    std::unique_ptr<DocumentCursor> cursor =
+        ScanDocumentsMatchingCollectionQuery(query);
+    for (int32_t i = 0; i < query.limit() && cursor->Valid(); ++i) {
+      const Document& doc = cursor->document();
+      results = results.insert(doc.key(), doc);
+      cursor->Next();
+    }
+    return results;
+  }
+
+  DocumentMap remote_docs =
       remote_document_cache_->GetMatching(query, since_read_time);
-  // Get locally persisted mutation batches.
-  std::vector<MutationBatch> matching_batches =
-      mutation_queue_->AllMutationBatchesAffectingQuery(query);
+  return ApplyLocalMutationsToQueryResults(query, std::move(remote_docs));
+}
+
+DocumentMap LocalDocumentsView::GetRemoteDocuments(const DocumentKeySet& keys) {
+  DocumentMap remote_docs;
+  OptionalMaybeDocumentMap docs = remote_document_cache_->GetAll(keys);
+  for (const auto& kv : docs) {
+    const absl::optional<MaybeDocument>& maybe_doc = kv.second;
+    if (maybe_doc && maybe_doc->is_document()) {
+      remote_docs = remote_docs.insert(kv.first, Document(*maybe_doc));
+    }
+  }
+  return remote_docs;
+}
 
-  results = AddMissingBaseDocuments(matching_batches, std::move(results));
+DocumentMap LocalDocumentsView::ApplyLocalMutationsToQueryResults(
+    const Query& query, DocumentMap results) {
+  const MutationOverlayCache::CollectionOverlays& overlays = GetOverlays(query);
 
-  for (const MutationBatch& batch : matching_batches) {
-    for (const Mutation& mutation : batch.mutations()) {
-      // Only process documents belonging to the collection.
-      if (!query.path().IsImmediateParentOf(mutation.key().path())) {
-        continue;
-      }
+  results = AddMissingBaseDocuments(overlays, std::move(results));
 
-      const DocumentKey& key = mutation.key();
-      // base_doc may be unset for the documents that weren't yet written to
-      // the backend.
-      absl::optional<MaybeDocument> base_doc =
-          results.underlying_map().get(key);
+  for (const auto& kv : overlays) {
+    const DocumentKey& key = kv.first;
+    // base_doc may be unset for the documents that weren't yet written to the
+    // backend.
+    absl::optional<MaybeDocument> base_doc = results.underlying_map().get(key);
 
-      absl::optional<MaybeDocument> mutated_doc = mutation.ApplyToLocalView(
-          base_doc, base_doc, batch.local_write_time());
+    absl::optional<MaybeDocument> mutated_doc = kv.second.Apply(base_doc);
 
-      if (mutated_doc && mutated_doc->is_document()) {
-        results = results.insert(key, Document(*mutated_doc));
-      } else {
-        results = results.erase(key);
-      }
+    if (mutated_doc && mutated_doc->is_document()) {
+      results = results.insert(key, Document(*mutated_doc));
+    } else {
+      results = results.erase(key);
     }
   }
 
-  // Finally, filter out any documents that don't actually match the query. Note
+  // Finally, filter out any documents that don't actually match the query and
+  // drop the fields the query doesn't need. Note
   // that the extra reference here prevents DocumentMap's destructor from
   // deallocating the initial unfiltered results while we're iterating over
   // them.
@@ -208,23 +426,55 @@ DocumentMap LocalDocumentsView::GetDocumentsMatchingCollectionQuery(
     Document doc(kv.second);
     if (!query.Matches(doc)) {
       results = results.erase(key);
+    } else if (query.has_projection()) {
+      results = results.insert(key, query.Project(doc));
     }
   }
 
   return results;
 }
 
+const MutationOverlayCache::CollectionOverlays& LocalDocumentsView::GetOverlays(
+    const Query& query) {
+  uint64_t change_count = mutation_queue_->GetChangeCount();
+  if (query.IsCollectionGroupQuery()) {
+    const std::string& collection_id = *query.collection_group();
+    const MutationOverlayCache::CollectionOverlays* overlays =
+        overlay_cache_.FindGroup(collection_id, change_count);
+    if (overlays) {
+      return *overlays;
+    }
+    return overlay_cache_.RecordGroup(collection_id, change_count,
+                                      mutation_queue_->AllMutationBatches());
+  }
+
+  if (!mutation_queue_->MayHaveMutationsInCollection(query.path())) {
+    // The common case when there are no pending writes.
+    static const auto* no_overlays =
+        new MutationOverlayCache::CollectionOverlays();
+    return *no_overlays;
+  }
+
+  const MutationOverlayCache::CollectionOverlays* overlays =
+      overlay_cache_.Find(query.path(), change_count);
+  if (overlays) {
+    return *overlays;
+  }
+
+  std::vector<MutationBatch> matching_batches =
+      mutation_queue_->AllMutationBatchesAffectingQuery(query);
+  return overlay_cache_.Record(query.path(), change_count, matching_batches);
+}
+
 DocumentMap LocalDocumentsView::AddMissingBaseDocuments(
-    const std::vector<MutationBatch>& matching_batches,
+    const MutationOverlayCache::CollectionOverlays& overlays,
     DocumentMap existing_docs) {
   DocumentKeySet missing_doc_keys;
-  for (const MutationBatch& batch : matching_batches) {
-    for (const Mutation& mutation : batch.mutations()) {
-      const DocumentKey& key = mutation.key();
-      if (mutation.type() == Mutation::Type::Patch &&
-          !existing_docs.underlying_map().contains(key)) {
-        missing_doc_keys = missing_doc_keys.insert(key);
-      }
+  for (const auto& kv : overlays) {
+    const DocumentKey& key = kv.first;
+    if (kv.second.needs_base_document() &&
+        !existing_docs.underlying_map().contains(key)) {
+      missing_doc_keys = missing_doc_keys.insert(key);
     }
   }
 
@@ -17,12 +17,16 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_DOCUMENTS_VIEW_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_DOCUMENTS_VIEW_H_
 
+#include <memory>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/local/document_cursor.h"
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
+#include "Firestore/core/src/firebase/firestore/local/mutation_overlay_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -86,6 +90,44 @@ class LocalDocumentsView {
   virtual model::DocumentMap GetDocumentsMatchingQuery(
       const core::Query& query, const model::SnapshotVersion& since_read_time);
 
+  /**
+   * Performs a collection query against the local view of all documents,
+   * reading the candidate remote documents from a field index.
+   *
+   * @return The matching documents, or nullopt if no field index can serve the
+   *     query.
+   */
+  absl::optional<model::DocumentMap> GetDocumentsMatchingQueryFromIndex(
+      const core::Query& query);
+
+  /**
+   * Returns the local view of the documents in the given collection whose
+   * GeoPoint `field_path` lies within the bounding box with the given corners.
+   * Candidates are read from a spatial index if one is configured for the
+   * field, and the whole collection is scanned otherwise.
+   */
+  model::DocumentMap GetDocumentsInBoundingBox(
+      const model::ResourcePath& collection_path,
+      const model::FieldPath& field_path,
+      const GeoPoint& south_west,
+      const GeoPoint& north_east);
+
+  /**
+   * Returns a cursor over the local view of the documents matching a
+   * collection query, in key order. Unlike `GetDocumentsMatchingQuery`, remote
+   * documents are read and local mutations applied only as the cursor
+   * advances. The cursor must not outlive the current transaction.
+   */
+  std::unique_ptr<DocumentCursor> ScanDocumentsMatchingCollectionQuery(
+      const core::Query& query);
+
+  /**
+   * Counts the documents in the local view that match the given query, up to
+   * its limit. Collection queries are counted while scanning, without building
+   * the full results.
+   */
+  size_t CountDocumentsMatchingQuery(const core::Query& query);
+
  private:
   friend class CountingQueryEngine;  // For testing
 
@@ -113,6 +155,28 @@ class LocalDocumentsView {
   model::DocumentMap GetDocumentsMatchingCollectionQuery(
       const core::Query& query, const model::SnapshotVersion& since_read_time);
 
+  /**
+   * Reads the remote documents with the given keys, skipping the ones that
+   * are missing or deleted.
+   */
+  model::DocumentMap GetRemoteDocuments(const model::DocumentKeySet& keys);
+
+  /**
+   * Overlays the local mutations affecting `query` onto the given remote
+   * documents of the queried collection or collection group and removes the
+   * documents that don't match the query.
+   */
+  model::DocumentMap ApplyLocalMutationsToQueryResults(
+      const core::Query& query, model::DocumentMap results);
+
+  /**
+   * Returns the overlays of the documents in the queried collection or
+   * collection group, reading the mutation queue only if it changed since they
+   * were last recorded.
+   */
+  const MutationOverlayCache::CollectionOverlays& GetOverlays(
+      const core::Query& query);
+
   /**
    * It is possible that a `PatchMutation` can make a document match a query,
    * even if the version in the `RemoteDocumentCache` is not a match yet
@@ -123,7 +187,7 @@ class LocalDocumentsView {
    * lead to missing results for the query.
    */
   model::DocumentMap AddMissingBaseDocuments(
-      const std::vector<model::MutationBatch>& matching_batches,
+      const MutationOverlayCache::CollectionOverlays& overlays,
       model::DocumentMap existing_docs);
 
   RemoteDocumentCache* remote_document_cache() {
@@ -142,6 +206,8 @@ class LocalDocumentsView {
   RemoteDocumentCache* remote_document_cache_;
   MutationQueue* mutation_queue_;
   IndexManager* index_manager_;
+
+  MutationOverlayCache overlay_cache_;
 };
 
 }  // namespace local
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 
+#include <pb_encode.h>
+
 #include <cstdlib>
 #include <limits>
 #include <memory>
@@ -29,6 +31,8 @@
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
@@ -49,6 +53,8 @@ namespace {
 using core::Target;
 using model::Document;
 using model::DocumentState;
+using model::FieldMask;
+using model::FieldPath;
 using model::FieldValue;
 using model::MaybeDocument;
 using model::Mutation;
@@ -60,6 +66,7 @@ using model::UnknownDocument;
 using nanopb::ByteString;
 using nanopb::CheckedSize;
 using nanopb::MakeArray;
+using nanopb::MakeStringView;
 using nanopb::Message;
 using nanopb::Reader;
 using nanopb::SafeReadBoolean;
@@ -67,6 +74,9 @@ using nanopb::Writer;
 using util::Status;
 using util::StringFormat;
 
+// A field's tag and length, each encoded as a varint of at most 10 bytes.
+const size_t kMaxFieldHeaderSize = 20;
+
 }  // namespace
 
 Message<firestore_client_MaybeDocument> LocalSerializer::EncodeMaybeDocument(
@@ -77,9 +87,6 @@ Message<firestore_client_MaybeDocument> LocalSerializer::EncodeMaybeDocument(
     case MaybeDocument::Type::Document: {
       result->which_document_type = firestore_client_MaybeDocument_document_tag;
       Document doc(maybe_doc);
-      // TODO(b/142956770): other platforms check for whether the `Document`
-      // contains a memoized proto and use it if available instead of
-      // re-encoding.
       result->document = EncodeDocument(doc);
       result->has_committed_mutations = doc.has_committed_mutations();
       return result;
@@ -109,6 +116,30 @@ Message<firestore_client_MaybeDocument> LocalSerializer::EncodeMaybeDocument(
   UNREACHABLE();
 }
 
+absl::optional<std::string> LocalSerializer::EncodeReceivedDocument(
+    const MaybeDocument& maybe_doc) const {
+  if (!maybe_doc.is_document()) return absl::nullopt;
+
+  Document doc(maybe_doc);
+  const auto* encoded = absl::any_cast<ByteString>(&doc.proto());
+  if (!encoded) return absl::nullopt;
+
+  // A received document has no committed mutations, so the document is the
+  // only field of its MaybeDocument.
+  pb_byte_t header[kMaxFieldHeaderSize];
+  pb_ostream_t stream = pb_ostream_from_buffer(header, sizeof(header));
+  pb_encode_tag(&stream, PB_WT_STRING,
+                firestore_client_MaybeDocument_document_tag);
+  pb_encode_varint(&stream, encoded->size());
+
+  absl::string_view document = MakeStringView(*encoded);
+  std::string result;
+  result.reserve(stream.bytes_written + document.size());
+  result.append(reinterpret_cast<const char*>(header), stream.bytes_written);
+  result.append(document.data(), document.size());
+  return result;
+}
+
 MaybeDocument LocalSerializer::DecodeMaybeDocument(
     Reader* reader, const firestore_client_MaybeDocument& proto) const {
   if (!reader->status().ok()) return {};
@@ -138,6 +169,90 @@ MaybeDocument LocalSerializer::DecodeMaybeDocument(
   UNREACHABLE();
 }
 
+Message<google_firestore_v1_Value> LocalSerializer::EncodeFieldValue(
+    const FieldValue& value) const {
+  Message<google_firestore_v1_Value> result;
+  *result = rpc_serializer_.EncodeFieldValue(value);
+  return result;
+}
+
+FieldValue LocalSerializer::DecodeFieldValue(
+    Reader* reader, const google_firestore_v1_Value& proto) const {
+  return rpc_serializer_.DecodeFieldValue(reader, proto);
+}
+
+absl::optional<FieldValue> LocalSerializer::DecodeDocumentField(
+    Reader* reader,
+    const firestore_client_MaybeDocument& proto,
+    const FieldPath& field_path) const {
+  if (!reader->status().ok() || field_path.empty()) return absl::nullopt;
+  if (proto.which_document_type !=
+      firestore_client_MaybeDocument_document_tag) {
+    return absl::nullopt;
+  }
+
+  // Top-level fields and nested map fields use distinct (but identical)
+  // proto types, so find the top-level field first.
+  const google_firestore_v1_Value* value = nullptr;
+  const google_firestore_v1_Document& document = proto.document;
+  for (pb_size_t i = 0; i < document.fields_count; ++i) {
+    if (nanopb::MakeStringView(document.fields[i].key) ==
+        field_path.first_segment()) {
+      value = &document.fields[i].value;
+      break;
+    }
+  }
+
+  for (size_t segment = 1; value && segment < field_path.size(); ++segment) {
+    if (value->which_value_type != google_firestore_v1_Value_map_value_tag) {
+      return absl::nullopt;
+    }
+
+    const google_firestore_v1_MapValue& map_value = value->map_value;
+    value = nullptr;
+    for (pb_size_t i = 0; i < map_value.fields_count; ++i) {
+      if (nanopb::MakeStringView(map_value.fields[i].key) ==
+          field_path[segment]) {
+        value = &map_value.fields[i].value;
+        break;
+      }
+    }
+  }
+
+  if (!value) {
+    return absl::nullopt;
+  }
+  return rpc_serializer_.DecodeFieldValue(reader, *value);
+}
+
+Document LocalSerializer::DecodeDocumentFields(
+    Reader* reader,
+    const firestore_client_MaybeDocument& proto,
+    const FieldMask& mask) const {
+  HARD_ASSERT(
+      proto.which_document_type == firestore_client_MaybeDocument_document_tag,
+      "Expected a Document instead of MaybeDocument type %s",
+      proto.which_document_type);
+
+  ObjectValue fields = ObjectValue::Empty();
+  for (const FieldPath& field_path : mask) {
+    absl::optional<FieldValue> value =
+        DecodeDocumentField(reader, proto, field_path);
+    if (value) {
+      fields = fields.Set(field_path, *value);
+    }
+  }
+  SnapshotVersion version =
+      rpc_serializer_.DecodeVersion(reader, proto.document.update_time);
+
+  DocumentState state = SafeReadBoolean(proto.has_committed_mutations)
+                            ? DocumentState::kCommittedMutations
+                            : DocumentState::kSynced;
+  return Document(std::move(fields),
+                  rpc_serializer_.DecodeKey(reader, proto.document.name),
+                  version, state);
+}
+
 google_firestore_v1_Document LocalSerializer::EncodeDocument(
     const Document& doc) const {
   google_firestore_v1_Document result{};
@@ -239,7 +354,7 @@ Message<firestore_client_Target> LocalSerializer::EncodeTargetData(
       nanopb::CopyBytesArray(target_data.resume_token().get());
 
   const Target& target = target_data.target();
-  if (target.IsDocumentQuery()) {
+  if (target.IsDocumentQuery() || target.IsMultiDocumentTarget()) {
     result->which_target_type = firestore_client_Target_documents_tag;
     result->documents = rpc_serializer_.EncodeDocumentsTarget(target);
   } else {
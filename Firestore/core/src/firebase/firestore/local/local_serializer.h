@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_SERIALIZER_H_
 
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -25,6 +26,7 @@
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/remote/serializer.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -78,6 +80,17 @@ class LocalSerializer {
   nanopb::Message<firestore_client_MaybeDocument> EncodeMaybeDocument(
       const model::MaybeDocument& maybe_doc) const;
 
+  /**
+   * Encodes a document received from Watch for local storage by writing the
+   * encoded document it was received as, without encoding its fields again.
+   *
+   * @return The encoded MaybeDocument, or nullopt if `maybe_doc` doesn't carry
+   *     its encoding, in which case it has to be encoded with
+   *     `EncodeMaybeDocument`.
+   */
+  absl::optional<std::string> EncodeReceivedDocument(
+      const model::MaybeDocument& maybe_doc) const;
+
   /**
    * @brief Decodes nanopb proto representing a MaybeDocument proto to the
    * equivalent model.
@@ -86,6 +99,38 @@ class LocalSerializer {
       nanopb::Reader* reader,
       const firestore_client_MaybeDocument& proto) const;
 
+  /**
+   * Decodes the value of a single field of the Document in `proto`, without
+   * decoding any of the document's other fields.
+   *
+   * @return The field value, or nullopt if `proto` is not a Document or the
+   *     document has no value at `field_path`.
+   */
+  absl::optional<model::FieldValue> DecodeDocumentField(
+      nanopb::Reader* reader,
+      const firestore_client_MaybeDocument& proto,
+      const model::FieldPath& field_path) const;
+
+  /**
+   * Decodes the Document in `proto`, keeping only the fields covered by `mask`
+   * and without decoding any of the document's other fields.
+   */
+  model::Document DecodeDocumentFields(
+      nanopb::Reader* reader,
+      const firestore_client_MaybeDocument& proto,
+      const model::FieldMask& mask) const;
+
+  /**
+   * Encodes a single field value for local storage, as the remote document
+   * cache stores the large values of large documents.
+   */
+  nanopb::Message<google_firestore_v1_Value> EncodeFieldValue(
+      const model::FieldValue& value) const;
+
+  /** Decodes a field value encoded with `EncodeFieldValue`. */
+  model::FieldValue DecodeFieldValue(
+      nanopb::Reader* reader, const google_firestore_v1_Value& proto) const;
+
   /**
    * @brief Encodes a TargetData to the equivalent nanopb proto, representing a
    * ::firestore::proto::Target, for local storage.
@@ -16,23 +16,32 @@
 
 #include "Firestore/core/src/firebase/firestore/local/local_store.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
 #include "Firestore/core/src/firebase/firestore/local/local_view_changes.h"
 #include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
 #include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/query_engine.h"
+#include "Firestore/core/src/firebase/firestore/local/query_explanation.h"
 #include "Firestore/core/src/firebase/firestore/local/query_result.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_delegate.h"
+#include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/target_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch_result.h"
 #include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
 
 namespace firebase {
 namespace firestore {
@@ -45,10 +54,15 @@ using core::Query;
 using core::Target;
 using core::TargetIdGenerator;
 using model::BatchId;
+using model::Document;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
+using model::DocumentSet;
 using model::DocumentVersionMap;
+using model::FieldIndex;
+using model::FieldPath;
+using model::kBatchIdUnknown;
 using model::ListenSequenceNumber;
 using model::MaybeDocument;
 using model::MaybeDocumentMap;
@@ -59,6 +73,7 @@ using model::ObjectValue;
 using model::OptionalMaybeDocumentMap;
 using model::PatchMutation;
 using model::Precondition;
+using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetId;
 using nanopb::ByteString;
@@ -72,6 +87,20 @@ using remote::TargetChange;
  */
 const int64_t kResumeTokenMaxAgeSeconds = 5 * 60;  // 5 minutes
 
+/** The number of query results kept for queries that are run again. */
+const size_t kMaxCachedQueryResults = 16;
+
+/** The number of paginated queries whose base results are kept. */
+const size_t kMaxCachedPageResults = 4;
+
+/**
+ * How long after startup executed targets are recorded for the next session
+ * to prefetch, and how many at most. The first screens of an app typically
+ * listen to a handful of queries.
+ */
+constexpr std::chrono::seconds kStartupTargetWindow{5};
+const size_t kMaxStartupTargets = 10;
+
 }  // namespace
 
 LocalStore::LocalStore(Persistence* persistence,
@@ -98,12 +127,38 @@ void LocalStore::Start() {
   TargetId target_id = target_cache_->highest_target_id();
   target_id_generator_ =
       TargetIdGenerator::TargetCacheTargetIdGenerator(target_id);
+  PrefetchStartupTargets();
+  startup_deadline_ = std::chrono::steady_clock::now() + kStartupTargetWindow;
 }
 
 void LocalStore::StartMutationQueue() {
   persistence_->Run("Start MutationQueue", [&] { mutation_queue_->Start(); });
 }
 
+void LocalStore::PrefetchStartupTargets() {
+  persistence_->Run("Prefetch startup targets", [&] {
+    DocumentKeySet keys;
+    for (TargetId target_id : target_cache_->GetStartupTargets()) {
+      for (const DocumentKey& key : target_cache_->GetMatchingKeys(target_id)) {
+        keys = keys.insert(key);
+      }
+    }
+    remote_document_cache_->Prefetch(keys);
+  });
+}
+
+void LocalStore::RecordStartupTarget(TargetId target_id) {
+  if (std::chrono::steady_clock::now() > startup_deadline_ ||
+      startup_targets_.size() == kMaxStartupTargets ||
+      std::find(startup_targets_.begin(), startup_targets_.end(),
+                target_id) != startup_targets_.end()) {
+    return;
+  }
+
+  startup_targets_.push_back(target_id);
+  target_cache_->SetStartupTargets(startup_targets_);
+}
+
 MaybeDocumentMap LocalStore::HandleUserChange(const User& user) {
   // Swap out the mutation queue, grabbing the pending mutation batches before
   // and after.
@@ -112,6 +167,7 @@ MaybeDocumentMap LocalStore::HandleUserChange(const User& user) {
 
   // The old one has a reference to the mutation queue, so null it out first.
   local_documents_.reset();
+  ClearQueryResults();
   mutation_queue_ = persistence_->GetMutationQueueForUser(user);
 
   StartMutationQueue();
@@ -143,13 +199,26 @@ MaybeDocumentMap LocalStore::HandleUserChange(const User& user) {
 }
 
 LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
+  util::TraceSpan span("LocalStore::WriteLocally");
+  span.SetAttribute("mutations", static_cast<int64_t>(mutations.size()));
+
   Timestamp local_write_time = Timestamp::Now();
   DocumentKeySet keys;
   for (const Mutation& mutation : mutations) {
     keys = keys.insert(mutation.key());
   }
 
-  return persistence_->Run("Locally write mutations", [&] {
+  query_results_.clear();
+  LocalWriteResult result = persistence_->Run("Locally write mutations", [&] {
+    if (write_compaction_enabled_) {
+      absl::optional<MutationBatch> compacted = CompactIntoLastBatch(mutations);
+      if (compacted) {
+        mutation_queue_->ReplaceLastMutationBatch(*compacted);
+        return LocalWriteResult{compacted->batch_id(),
+                                local_documents_->GetDocuments(keys)};
+      }
+    }
+
     // Load and apply all existing mutations. This lets us compute the current
     // base state for all non-idempotent transforms before applying any
     // additional user-provided writes.
@@ -181,11 +250,32 @@ LocalWriteResult LocalStore::WriteLocally(std::vector<Mutation>&& mutations) {
         batch.ApplyToLocalDocumentSet(existing_documents);
     return LocalWriteResult{batch.batch_id(), std::move(changed_documents)};
   });
+
+  UpdatePageResults(result.changes());
+  span.SetAttribute("batch_id", result.batch_id());
+  return result;
+}
+
+absl::optional<MutationBatch> LocalStore::CompactIntoLastBatch(
+    const std::vector<Mutation>& mutations) {
+  BatchId last_batch_id = mutation_queue_->GetHighestUnacknowledgedBatchId();
+  if (last_batch_id == kBatchIdUnknown ||
+      last_batch_id <= highest_fetched_batch_id_) {
+    return absl::nullopt;
+  }
+
+  absl::optional<MutationBatch> last_batch =
+      mutation_queue_->LookupMutationBatch(last_batch_id);
+  if (!last_batch) {
+    return absl::nullopt;
+  }
+  return last_batch->CompactWith(mutations);
 }
 
 MaybeDocumentMap LocalStore::AcknowledgeBatch(
     const MutationBatchResult& batch_result) {
-  return persistence_->Run("Acknowledge batch", [&] {
+  query_results_.clear();
+  MaybeDocumentMap changes = persistence_->Run("Acknowledge batch", [&] {
     const MutationBatch& batch = batch_result.batch();
     mutation_queue_->AcknowledgeBatch(batch, batch_result.stream_token());
     ApplyBatchResult(batch_result);
@@ -193,6 +283,8 @@ MaybeDocumentMap LocalStore::AcknowledgeBatch(
 
     return local_documents_->GetDocuments(batch.keys());
   });
+  UpdatePageResults(changes);
+  return changes;
 }
 
 void LocalStore::ApplyBatchResult(const MutationBatchResult& batch_result) {
@@ -227,7 +319,8 @@ void LocalStore::ApplyBatchResult(const MutationBatchResult& batch_result) {
 }
 
 MaybeDocumentMap LocalStore::RejectBatch(BatchId batch_id) {
-  return persistence_->Run("Reject batch", [&] {
+  query_results_.clear();
+  MaybeDocumentMap changes = persistence_->Run("Reject batch", [&] {
     absl::optional<MutationBatch> to_reject =
         mutation_queue_->LookupMutationBatch(batch_id);
     HARD_ASSERT(to_reject.has_value(), "Attempt to reject nonexistent batch!");
@@ -237,6 +330,8 @@ MaybeDocumentMap LocalStore::RejectBatch(BatchId batch_id) {
 
     return local_documents_->GetDocuments(to_reject->keys());
   });
+  UpdatePageResults(changes);
+  return changes;
 }
 
 ByteString LocalStore::GetLastStreamToken() {
@@ -257,7 +352,8 @@ model::MaybeDocumentMap LocalStore::ApplyRemoteEvent(
   const SnapshotVersion& last_remote_version =
       target_cache_->GetLastRemoteSnapshotVersion();
 
-  return persistence_->Run("Apply remote event", [&] {
+  query_results_.clear();
+  MaybeDocumentMap changes = persistence_->Run("Apply remote event", [&] {
     // TODO(gsoltis): move the sequence number into the reference delegate.
     ListenSequenceNumber sequence_number =
         persistence_->current_sequence_number();
@@ -292,14 +388,37 @@ model::MaybeDocumentMap LocalStore::ApplyRemoteEvent(
                 .WithSequenceNumber(sequence_number);
         target_data_by_target_[target_id] = new_target_data;
 
-        // Update the target data if there are target changes (or if sufficient
-        // time has passed since the last update).
-        if (ShouldPersistTargetData(new_target_data, old_target_data, change)) {
+        // Update the target data if there are target changes, or if the
+        // target has just become current, so that its first synced resume
+        // token is durable. Otherwise buffer it, to be written out with other
+        // targets' updates.
+        bool became_current =
+            change.current() && current_targets_.insert(target_id).second;
+        if (became_current ||
+            ShouldPersistTargetData(new_target_data, old_target_data, change)) {
           target_cache_->UpdateTarget(new_target_data);
+          buffered_targets_.erase(target_id);
+        } else {
+          if (buffered_targets_.empty()) {
+            buffered_since_ = remote_event.snapshot_version();
+          }
+          buffered_targets_.insert(target_id);
         }
       }
     }
 
+    // Don't allow resume token changes to be buffered indefinitely. This allows
+    // us to be reasonably up-to-date after a crash, and writes the buffered
+    // targets together rather than as each one ages out.
+    if (!buffered_targets_.empty()) {
+      int64_t buffered_seconds =
+          remote_event.snapshot_version().timestamp().seconds() -
+          buffered_since_.timestamp().seconds();
+      if (buffered_seconds >= kResumeTokenMaxAgeSeconds) {
+        WriteBufferedTargetData();
+      }
+    }
+
     OptionalMaybeDocumentMap changed_docs;
     const DocumentKeySet& limbo_documents =
         remote_event.limbo_document_changes();
@@ -365,6 +484,8 @@ model::MaybeDocumentMap LocalStore::ApplyRemoteEvent(
 
     return local_documents_->GetLocalViewOfDocuments(changed_docs);
   });
+  UpdatePageResults(changes);
+  return changes;
 }
 
 bool LocalStore::ShouldPersistTargetData(const TargetData& new_target_data,
@@ -377,17 +498,6 @@ bool LocalStore::ShouldPersistTargetData(const TargetData& new_target_data,
   // Always persist target data if we don't already have a resume token.
   if (old_target_data.resume_token().empty()) return true;
 
-  // Don't allow resume token changes to be buffered indefinitely. This allows
-  // us to be reasonably up-to-date after a crash and avoids needing to loop
-  // over all active queries on shutdown. Especially in the browser we may not
-  // get time to do anything interesting while the current tab is closing.
-  int64_t new_seconds =
-      new_target_data.snapshot_version().timestamp().seconds();
-  int64_t old_seconds =
-      old_target_data.snapshot_version().timestamp().seconds();
-  int64_t time_delta = new_seconds - old_seconds;
-  if (time_delta >= kResumeTokenMaxAgeSeconds) return true;
-
   // Otherwise if the only thing that has changed about a target is its resume
   // token then it's not worth persisting. Note that the RemoteStore keeps an
   // in-memory view of the currently active targets which includes the current
@@ -399,6 +509,24 @@ bool LocalStore::ShouldPersistTargetData(const TargetData& new_target_data,
   return changes > 0;
 }
 
+void LocalStore::PersistBufferedTargetData() {
+  if (buffered_targets_.empty()) {
+    return;
+  }
+  persistence_->Run("Persist buffered target data",
+                    [&] { WriteBufferedTargetData(); });
+}
+
+void LocalStore::WriteBufferedTargetData() {
+  for (TargetId target_id : buffered_targets_) {
+    auto found = target_data_by_target_.find(target_id);
+    if (found != target_data_by_target_.end()) {
+      target_cache_->UpdateTarget(found->second);
+    }
+  }
+  buffered_targets_.clear();
+}
+
 absl::optional<TargetData> LocalStore::GetTargetData(
     const core::Target& target) {
   auto target_id = target_id_by_target_.find(target);
@@ -410,6 +538,14 @@ absl::optional<TargetData> LocalStore::GetTargetData(
 
 void LocalStore::NotifyLocalViewChanges(
     const std::vector<local::LocalViewChanges>& view_changes) {
+  // Removing references may garbage collect documents.
+  query_results_.clear();
+  for (const LocalViewChanges& view_change : view_changes) {
+    if (!view_change.removed_keys().empty()) {
+      page_results_.clear();
+      break;
+    }
+  }
   persistence_->Run("NotifyLocalViewChanges", [&] {
     for (const LocalViewChanges& view_change : view_changes) {
       int target_id = view_change.target_id();
@@ -444,7 +580,17 @@ void LocalStore::NotifyLocalViewChanges(
 absl::optional<MutationBatch> LocalStore::GetNextMutationBatch(
     BatchId batch_id) {
   return persistence_->Run("NextMutationBatchAfterBatchID", [&] {
-    return mutation_queue_->NextMutationBatchAfterBatchId(batch_id);
+    if (batch_id == kBatchIdUnknown) {
+      // The write pipeline is empty and is being filled from the start.
+      highest_fetched_batch_id_ = kBatchIdUnknown;
+    }
+    absl::optional<MutationBatch> batch =
+        mutation_queue_->NextMutationBatchAfterBatchId(batch_id);
+    if (batch) {
+      highest_fetched_batch_id_ =
+          std::max(highest_fetched_batch_id_, batch->batch_id());
+    }
+    return batch;
   });
 }
 
@@ -453,25 +599,167 @@ absl::optional<MaybeDocument> LocalStore::ReadDocument(const DocumentKey& key) {
                            [&] { return local_documents_->GetDocument(key); });
 }
 
+absl::optional<std::vector<MaybeDocument>>
+LocalStore::ReadCurrentRemoteDocuments(const std::vector<DocumentKey>& keys,
+                                       std::chrono::milliseconds max_staleness) {
+  using Result = absl::optional<std::vector<MaybeDocument>>;
+  return persistence_->Run("ReadCurrentRemoteDocuments", [&]() -> Result {
+    const SnapshotVersion& snapshot_version =
+        target_cache_->GetLastRemoteSnapshotVersion();
+    auto snapshot_age = Timestamp::Now().ToTimePoint() -
+                        snapshot_version.timestamp().ToTimePoint();
+    if (snapshot_version == SnapshotVersion::None() ||
+        snapshot_age > max_staleness) {
+      return absl::nullopt;
+    }
+
+    std::vector<MaybeDocument> documents;
+    for (const DocumentKey& key : keys) {
+      if (!local_view_references_.ContainsKey(key)) {
+        return absl::nullopt;
+      }
+      absl::optional<MaybeDocument> document =
+          remote_document_cache_->Get(key);
+      if (!document || !(document->is_document() ||
+                         document->is_no_document())) {
+        return absl::nullopt;
+      }
+      documents.push_back(std::move(*document));
+    }
+    return documents;
+  });
+}
+
+bool LocalStore::IsMutationQueueFull() {
+  if (max_pending_batches_ == 0 && max_pending_bytes_ == 0) {
+    return false;
+  }
+
+  return persistence_->Run("IsMutationQueueFull", [&] {
+    return (max_pending_batches_ > 0 &&
+            mutation_queue_->GetBatchCount() >= max_pending_batches_) ||
+           (max_pending_bytes_ > 0 &&
+            mutation_queue_->GetByteSize() >= max_pending_bytes_);
+  });
+}
+
 BatchId LocalStore::GetHighestUnacknowledgedBatchId() {
   return persistence_->Run("GetHighestUnacknowledgedBatchId", [&] {
     return mutation_queue_->GetHighestUnacknowledgedBatchId();
   });
 }
 
-TargetData LocalStore::AllocateTarget(Target target) {
-  TargetData target_data = persistence_->Run("Allocate target", [&] {
-    absl::optional<TargetData> cached = target_cache_->GetTarget(target);
-    // TODO(mcg): freshen last accessed date if cached exists?
-    if (!cached) {
-      cached = TargetData(std::move(target), target_id_generator_.NextId(),
-                          persistence_->current_sequence_number(),
-                          QueryPurpose::Listen);
-      target_cache_->AddTarget(*cached);
-    }
-    return *cached;
+void LocalStore::SavePrefetchedTarget(const Target& target,
+                                      const std::vector<Document>& documents,
+                                      const SnapshotVersion& read_time) {
+  persistence_->Run("Save prefetched target", [&] {
+    DocumentKeySet keys = SaveNewerDocuments(documents, read_time);
+    SaveTargetResults(target, keys, read_time);
   });
+}
+
+void LocalStore::SaveBundledDocuments(const std::vector<Document>& documents,
+                                      const SnapshotVersion& read_time) {
+  persistence_->Run("Save bundled documents",
+                    [&] { SaveNewerDocuments(documents, read_time); });
+}
+
+void LocalStore::SaveReadDocuments(const std::vector<Document>& documents,
+                                   const SnapshotVersion& read_time) {
+  persistence_->Run("Save read documents",
+                    [&] { SaveNewerDocuments(documents, read_time); });
+}
+
+void LocalStore::SaveBundledTarget(const Target& target,
+                                   const DocumentKeySet& keys,
+                                   const SnapshotVersion& read_time) {
+  persistence_->Run("Save bundled target",
+                    [&] { SaveTargetResults(target, keys, read_time); });
+}
+
+DocumentKeySet LocalStore::SaveNewerDocuments(
+    const std::vector<Document>& documents, const SnapshotVersion& read_time) {
+  ClearQueryResults();
+  DocumentKeySet keys;
+  for (const Document& doc : documents) {
+    keys = keys.insert(doc.key());
+  }
+
+  OptionalMaybeDocumentMap existing_docs = remote_document_cache_->GetAll(keys);
+  for (const Document& doc : documents) {
+    absl::optional<MaybeDocument> existing_doc;
+    auto found_existing = existing_docs.get(doc.key());
+    if (found_existing) {
+      existing_doc = *found_existing;
+    }
+
+    if (!existing_doc || doc.version() > existing_doc->version()) {
+      remote_document_cache_->Add(doc, read_time);
+    }
+  }
+  return keys;
+}
+
+void LocalStore::SaveTargetResults(const Target& target,
+                                   const DocumentKeySet& keys,
+                                   const SnapshotVersion& read_time) {
+  if (target_id_by_target_.find(target) != target_id_by_target_.end()) {
+    return;
+  }
+
+  TargetData target_data = GetOrAddTarget(target);
+  if (read_time <= target_data.last_limbo_free_snapshot_version()) {
+    return;
+  }
+
+  query_results_.clear();
+  TargetId target_id = target_data.target_id();
+  target_cache_->RemoveMatchingKeys(target_cache_->GetMatchingKeys(target_id),
+                                    target_id);
+  target_cache_->AddMatchingKeys(keys, target_id);
+  target_cache_->UpdateTarget(
+      target_data.WithLastLimboFreeSnapshotVersion(read_time)
+          .WithSequenceNumber(persistence_->current_sequence_number()));
+}
+
+TargetData LocalStore::AllocateTarget(Target target) {
+  TargetData target_data = persistence_->Run(
+      "Allocate target", [&] { return GetOrAddTarget(std::move(target)); });
+  TrackActiveTarget(target_data);
+  return target_data;
+}
+
+std::vector<TargetData> LocalStore::AllocateTargets(
+    std::vector<Target> targets) {
+  std::vector<TargetData> allocated =
+      persistence_->Run("Allocate targets", [&] {
+        std::vector<TargetData> result;
+        result.reserve(targets.size());
+        for (Target& target : targets) {
+          result.push_back(GetOrAddTarget(std::move(target)));
+        }
+        return result;
+      });
+
+  for (const TargetData& target_data : allocated) {
+    TrackActiveTarget(target_data);
+  }
+  return allocated;
+}
 
+TargetData LocalStore::GetOrAddTarget(Target target) {
+  absl::optional<TargetData> cached = target_cache_->GetTarget(target);
+  // TODO(mcg): freshen last accessed date if cached exists?
+  if (!cached) {
+    cached = TargetData(std::move(target), target_id_generator_.NextId(),
+                        persistence_->current_sequence_number(),
+                        QueryPurpose::Listen);
+    target_cache_->AddTarget(*cached);
+  }
+  return *cached;
+}
+
+void LocalStore::TrackActiveTarget(const TargetData& target_data) {
   // Sanity check to ensure that even when resuming a query it's not currently
   // active.
   TargetId target_id = target_data.target_id();
@@ -479,11 +767,10 @@ TargetData LocalStore::AllocateTarget(Target target) {
     target_data_by_target_[target_id] = target_data;
     target_id_by_target_[target_data.target()] = target_id;
   }
-
-  return target_data;
 }
 
 void LocalStore::ReleaseTarget(TargetId target_id) {
+  ClearQueryResults();
   persistence_->Run("Release target", [&] {
     auto found = target_data_by_target_.find(target_id);
     HARD_ASSERT(found != target_data_by_target_.end(),
@@ -505,12 +792,35 @@ void LocalStore::ReleaseTarget(TargetId target_id) {
     persistence_->reference_delegate()->RemoveTarget(target_data);
     target_data_by_target_.erase(target_id);
     target_id_by_target_.erase(target_data.target());
+    buffered_targets_.erase(target_id);
+    current_targets_.erase(target_id);
   });
 }
 
 QueryResult LocalStore::ExecuteQuery(const Query& query,
                                      bool use_previous_results) {
-  return persistence_->Run("ExecuteQuery", [&] {
+  util::TraceSpan span("LocalStore::ExecuteQuery");
+  auto start = std::chrono::steady_clock::now();
+
+  // Nothing that could change the results has happened since the query last
+  // ran.
+  auto cached = query_results_.find(query);
+  if (cached != query_results_.end()) {
+    QueryResult result(cached->second.documents(),
+                       cached->second.remote_keys());
+    auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    persistence_->metrics()->RecordQueryExecuted(result.documents().size(),
+                                                 latency);
+    util::Trace(util::TraceEvent::kExecuteQuery, result.documents().size(),
+                latency.count(), /* cached= */ 1);
+    span.SetAttribute("documents", result.documents().size());
+    span.SetAttribute("cached", 1);
+    return result;
+  }
+
+  int64_t scanned_before = persistence_->metrics()->documents_scanned();
+  QueryResult result = persistence_->Run("ExecuteQuery", [&] {
     absl::optional<TargetData> target_data = GetTargetData(query.ToTarget());
     SnapshotVersion last_limbo_free_snapshot_version;
     DocumentKeySet remote_keys;
@@ -519,14 +829,121 @@ QueryResult LocalStore::ExecuteQuery(const Query& query,
       last_limbo_free_snapshot_version =
           target_data->last_limbo_free_snapshot_version();
       remote_keys = target_cache_->GetMatchingKeys(target_data->target_id());
+      RecordStartupTarget(target_data->target_id());
     }
 
-    model::DocumentMap documents = query_engine_->GetDocumentsMatchingQuery(
-        query,
-        use_previous_results ? last_limbo_free_snapshot_version
-                             : SnapshotVersion::None(),
-        use_previous_results ? remote_keys : DocumentKeySet{});
-    return QueryResult(std::move(documents), std::move(remote_keys));
+    absl::optional<DocumentMap> page = ReadPage(query);
+    DocumentMap documents =
+        page ? *std::move(page)
+             : query_engine_->GetDocumentsMatchingQuery(
+                   query,
+                   use_previous_results ? last_limbo_free_snapshot_version
+                                        : SnapshotVersion::None(),
+                   use_previous_results ? remote_keys : DocumentKeySet{});
+    int64_t documents_scanned =
+        persistence_->metrics()->documents_scanned() - scanned_before;
+    return QueryResult(std::move(documents), std::move(remote_keys),
+                       documents_scanned);
+  });
+
+  if (query_results_.size() >= kMaxCachedQueryResults) {
+    query_results_.erase(query_results_.begin());
+  }
+  query_results_.emplace(query, result);
+
+  auto latency = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  persistence_->metrics()->RecordQueryExecuted(result.documents().size(),
+                                               latency);
+  util::Trace(util::TraceEvent::kExecuteQuery, result.documents().size(),
+              latency.count(), /* cached= */ 0);
+  span.SetAttribute("documents", result.documents().size());
+  span.SetAttribute("documents_scanned", result.documents_scanned());
+  return result;
+}
+
+size_t LocalStore::CountQuery(const Query& query) {
+  return persistence_->Run("CountQuery", [&] {
+    return local_documents_->CountDocumentsMatchingQuery(query);
+  });
+}
+
+void LocalStore::AddFieldIndex(const FieldIndex& index) {
+  persistence_->Run("AddFieldIndex", [&] {
+    persistence_->index_manager()->AddFieldIndex(index);
+  });
+}
+
+DocumentMap LocalStore::GetDocumentsInBoundingBox(
+    const ResourcePath& collection_path,
+    const FieldPath& field_path,
+    const GeoPoint& south_west,
+    const GeoPoint& north_east) {
+  return persistence_->Run("GetDocumentsInBoundingBox", [&] {
+    return local_documents_->GetDocumentsInBoundingBox(
+        collection_path, field_path, south_west, north_east);
+  });
+}
+
+int64_t LocalStore::CountMutationBatchesAffecting(const Query& query) {
+  if (query.IsDocumentQuery()) {
+    return static_cast<int64_t>(
+        mutation_queue_
+            ->AllMutationBatchesAffectingDocumentKey(DocumentKey{query.path()})
+            .size());
+  }
+  if (!query.IsCollectionGroupQuery()) {
+    return static_cast<int64_t>(
+        mutation_queue_->AllMutationBatchesAffectingQuery(query).size());
+  }
+
+  const std::string& collection_id = *query.collection_group();
+  int64_t count = 0;
+  for (const MutationBatch& batch : mutation_queue_->AllMutationBatches()) {
+    for (const Mutation& mutation : batch.mutations()) {
+      if (mutation.key().HasCollectionId(collection_id)) {
+        ++count;
+        break;
+      }
+    }
+  }
+  return count;
+}
+
+QueryExplanation LocalStore::ExplainQuery(const Query& query) {
+  using Clock = std::chrono::steady_clock;
+  auto since = [](Clock::time_point start) {
+    return std::chrono::duration_cast<QueryExplanation::Duration>(
+        Clock::now() - start);
+  };
+
+  return persistence_->Run("ExplainQuery", [&] {
+    QueryExplanation explanation;
+    explanation.engine = query_engine_->type();
+
+    auto start = Clock::now();
+    absl::optional<TargetData> target_data = GetTargetData(query.ToTarget());
+    SnapshotVersion last_limbo_free_snapshot_version;
+    DocumentKeySet remote_keys;
+    if (target_data) {
+      last_limbo_free_snapshot_version =
+          target_data->last_limbo_free_snapshot_version();
+      remote_keys = target_cache_->GetMatchingKeys(target_data->target_id());
+    }
+    explanation.target_lookup_time = since(start);
+
+    int64_t scanned_before = persistence_->metrics()->documents_scanned();
+    start = Clock::now();
+    DocumentMap documents = query_engine_->GetDocumentsMatchingQuery(
+        query, last_limbo_free_snapshot_version, remote_keys);
+    explanation.execution_time = since(start);
+
+    explanation.path = query_engine_->last_path();
+    explanation.documents_read =
+        persistence_->metrics()->documents_scanned() - scanned_before;
+    explanation.documents_matched = static_cast<int64_t>(documents.size());
+    explanation.mutation_batches_applied = CountMutationBatchesAffecting(query);
+    return explanation;
   });
 }
 
@@ -537,9 +954,100 @@ DocumentKeySet LocalStore::GetRemoteDocumentKeys(TargetId target_id) {
 }
 
 LruResults LocalStore::CollectGarbage(LruGarbageCollector* garbage_collector) {
-  return persistence_->Run("Collect garbage", [&] {
+  ClearQueryResults();
+  LruResults results = persistence_->Run("Collect garbage", [&] {
     return garbage_collector->Collect(target_data_by_target_);
   });
+  persistence_->metrics()->RecordGarbageCollection(results);
+  return results;
+}
+
+LruResults LocalStore::CollectGarbageSlice(
+    LruGarbageCollector* garbage_collector, int max_entries) {
+  ClearQueryResults();
+  LruResults results = persistence_->Run("Collect garbage slice", [&] {
+    return garbage_collector->CollectSlice(target_data_by_target_,
+                                           max_entries);
+  });
+  persistence_->metrics()->RecordGarbageCollection(results);
+  return results;
+}
+
+size_t LocalStore::ReleaseMemory() {
+  ClearQueryResults();
+  return persistence_->ReleaseMemory();
+}
+
+absl::optional<DocumentMap> LocalStore::ReadPage(const Query& query) {
+  if (!query.has_limit_to_first() || query.end_at() ||
+      query.has_projection() || query.IsDocumentQuery()) {
+    return absl::nullopt;
+  }
+
+  Query base_query(query.path(), query.collection_group(), query.filters(),
+                   query.explicit_order_bys(), Target::kNoLimit,
+                   core::LimitType::None, nullptr, nullptr);
+  auto found = page_results_.find(base_query);
+  if (found == page_results_.end()) {
+    // A lone first page is not worth keeping the whole base query for.
+    if (!query.start_at()) {
+      return absl::nullopt;
+    }
+
+    DocumentMap base_results = query_engine_->GetDocumentsMatchingQuery(
+        base_query, SnapshotVersion::None(), DocumentKeySet{});
+    DocumentSet sorted(base_query.Comparator());
+    for (const auto& kv : base_results.underlying_map()) {
+      sorted = sorted.insert(Document(kv.second));
+    }
+
+    if (page_results_.size() >= kMaxCachedPageResults) {
+      page_results_.erase(page_results_.begin());
+    }
+    found = page_results_.emplace(base_query, std::move(sorted)).first;
+  }
+
+  const DocumentSet& documents = found->second;
+  auto page_begin = documents.begin();
+  if (query.start_at()) {
+    const core::Bound& start_at = *query.start_at();
+    const core::OrderByList& order_bys = query.order_bys();
+    while (page_begin != documents.end() &&
+           !start_at.SortsBeforeDocument(order_bys, *page_begin)) {
+      ++page_begin;
+    }
+  }
+
+  DocumentMap page;
+  auto limit = static_cast<size_t>(query.limit());
+  for (auto it = page_begin; it != documents.end() && page.size() < limit;
+       ++it) {
+    page = page.insert(it->key(), *it);
+  }
+  return page;
+}
+
+void LocalStore::UpdatePageResults(const MaybeDocumentMap& changes) {
+  for (auto& entry : page_results_) {
+    const Query& base_query = entry.first;
+    DocumentSet documents = entry.second;
+    for (const auto& kv : changes) {
+      const MaybeDocument& maybe_doc = kv.second;
+      if (maybe_doc.is_document() &&
+          base_query.Matches(Document(maybe_doc))) {
+        // Replaces any earlier version of the document.
+        documents = documents.insert(Document(maybe_doc));
+      } else {
+        documents = documents.erase(kv.first);
+      }
+    }
+    entry.second = std::move(documents);
+  }
+}
+
+void LocalStore::ClearQueryResults() {
+  query_results_.clear();
+  page_results_.clear();
 }
 
 }  // namespace local
@@ -17,14 +17,23 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_STORE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LOCAL_STORE_H_
 
+#include <cstdint>
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/core/target_id_generator.h"
+#include "Firestore/core/src/firebase/firestore/local/query_explanation.h"
+#include "Firestore/core/src/firebase/firestore/local/query_result.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "absl/types/optional.h"
 
 namespace firebase {
@@ -34,10 +43,6 @@ namespace auth {
 class User;
 }  // namespace auth
 
-namespace core {
-class Query;
-}  // namespace core
-
 namespace remote {
 class RemoteEvent;
 class TargetChange;
@@ -52,7 +57,6 @@ class LruGarbageCollector;
 class MutationQueue;
 class Persistence;
 class QueryEngine;
-class QueryResult;
 class RemoteDocumentCache;
 class TargetCache;
 
@@ -106,7 +110,11 @@ class LocalStore {
 
   ~LocalStore();
 
-  /** Performs any initial startup actions required by the local store. */
+  /**
+   * Performs any initial startup actions required by the local store, and
+   * starts prefetching the documents of the targets executed early in the
+   * previous session, which the app is likely to execute again.
+   */
   void Start();
 
   /**
@@ -117,13 +125,55 @@ class LocalStore {
    */
   model::MaybeDocumentMap HandleUserChange(const auth::User& user);
 
-  /** Accepts locally generated Mutations and commits them to storage. */
+  /**
+   * Accepts locally generated Mutations and commits them to storage.
+   *
+   * With write compaction enabled, a write that only sets or patches the same
+   * documents as the last batch in the queue is merged into that batch if it
+   * hasn't been handed to the remote store yet. The result then has that
+   * batch's ID.
+   */
   LocalWriteResult WriteLocally(std::vector<model::Mutation>&& mutations);
 
+  /** Sets whether `WriteLocally` compacts writes; off by default. */
+  void set_write_compaction_enabled(bool value) {
+    write_compaction_enabled_ = value;
+  }
+
+  /**
+   * Sets the number and total size in bytes of the batches the mutation queue
+   * may hold before `IsMutationQueueFull` returns true. Zero means no limit;
+   * there are none by default.
+   */
+  void set_mutation_queue_limits(size_t max_batches, int64_t max_bytes) {
+    max_pending_batches_ = max_batches;
+    max_pending_bytes_ = max_bytes;
+  }
+
+  /**
+   * Returns true if the mutation queue holds as many batches or bytes as its
+   * limits allow, in which case callers should hold off writing until the
+   * backend acknowledges some of them.
+   */
+  bool IsMutationQueueFull();
+
   /**
    * Returns the current value of a document with a given key, or `nullopt` if
    * not found.
    */
+  /**
+   * Returns the documents with the given keys as last received from the
+   * backend (without any local mutations applied), or nullopt unless the cache
+   * can be trusted to be up to date for all of them: each document must be in
+   * the results of an active listen, and the last snapshot from the backend
+   * must be no older than `max_staleness`. The result may still be out of date
+   * (e.g. if the watch stream is lagging), so it must only be used where the
+   * backend verifies the versions read, like transactions do.
+   */
+  absl::optional<std::vector<model::MaybeDocument>> ReadCurrentRemoteDocuments(
+      const std::vector<model::DocumentKey>& keys,
+      std::chrono::milliseconds max_staleness);
+
   absl::optional<model::MaybeDocument> ReadDocument(
       const model::DocumentKey& key);
 
@@ -179,6 +229,45 @@ class LocalStore {
   model::MaybeDocumentMap ApplyRemoteEvent(
       const remote::RemoteEvent& remote_event);
 
+  /**
+   * Saves the results of a target read once from the backend, outside of a
+   * listen. The documents are added to the remote document cache, unless a
+   * newer version is already cached, and the target is recorded as matching
+   * exactly these documents as of `read_time`, so that a later listen to it,
+   * online or not, starts from these results.
+   *
+   * The target isn't allocated: like a released target, it remains subject to
+   * garbage collection. The metadata of an active target is left alone since
+   * its listen keeps it up to date.
+   */
+  void SavePrefetchedTarget(const core::Target& target,
+                            const std::vector<model::Document>& documents,
+                            const model::SnapshotVersion& read_time);
+
+  /**
+   * Saves a batch of documents loaded from a bundle, read by the backend at
+   * `read_time`. Like `SavePrefetchedTarget`, this doesn't replace newer
+   * versions of the documents.
+   */
+  void SaveBundledDocuments(const std::vector<model::Document>& documents,
+                            const model::SnapshotVersion& read_time);
+
+  /**
+   * Saves documents read once from the backend at `read_time`, outside of any
+   * target, in a single transaction. Newer cached versions are kept.
+   */
+  void SaveReadDocuments(const std::vector<model::Document>& documents,
+                         const model::SnapshotVersion& read_time);
+
+  /**
+   * Records that the given target, a query from a bundle, matched the
+   * documents with the given keys as of `read_time`. The documents must have
+   * been saved with `SaveBundledDocuments`.
+   */
+  void SaveBundledTarget(const core::Target& target,
+                         const model::DocumentKeySet& keys,
+                         const model::SnapshotVersion& read_time);
+
   /**
    * Returns the keys of the documents that are associated with the given
    * target_id in the remote table.
@@ -195,6 +284,14 @@ class LocalStore {
    */
   TargetData AllocateTarget(core::Target target);
 
+  /**
+   * Allocates all the given targets in a single transaction, as if by calling
+   * `AllocateTarget` for each one.
+   *
+   * @return the `TargetData` of each target, in the order of `targets`.
+   */
+  std::vector<TargetData> AllocateTargets(std::vector<core::Target> targets);
+
   /**
    * Unpin all the documents associated with a target.
    *
@@ -212,6 +309,39 @@ class LocalStore {
    */
   QueryResult ExecuteQuery(const core::Query& query, bool use_previous_results);
 
+  /**
+   * Counts the documents matching the given query in the local view, up to
+   * the query's limit, without building its results.
+   */
+  size_t CountQuery(const core::Query& query);
+
+  /**
+   * Adds a field index over the cached documents of a collection group and
+   * indexes the documents already cached. Adding an existing index does
+   * nothing.
+   */
+  void AddFieldIndex(const model::FieldIndex& index);
+
+  /**
+   * Returns the local view of the documents in the given collection whose
+   * GeoPoint `field_path` lies within the bounding box with the given corners,
+   * without consulting the backend. Only documents in the geohash cells
+   * covering the box are read if a field index starting with a Geohash
+   * segment on the field was added.
+   */
+  model::DocumentMap GetDocumentsInBoundingBox(
+      const model::ResourcePath& collection_path,
+      const model::FieldPath& field_path,
+      const GeoPoint& south_west,
+      const GeoPoint& north_east);
+
+  /**
+   * Runs the given query against the local store the way a listen would, and
+   * describes how it was executed rather than returning its results. Results
+   * cached in memory are bypassed, so that the query engine always runs.
+   */
+  QueryExplanation ExplainQuery(const core::Query& query);
+
   /**
    * Notify the local store of the changed views to locally pin / unpin
    * documents.
@@ -219,6 +349,13 @@ class LocalStore {
   void NotifyLocalViewChanges(
       const std::vector<LocalViewChanges>& view_changes);
 
+  /**
+   * Writes out the target metadata (resume tokens and sequence numbers) that
+   * `ApplyRemoteEvent` has buffered in memory. Called at shutdown so that a
+   * clean restart resumes every target from its latest token.
+   */
+  void PersistBufferedTargetData();
+
   /**
    * Gets the mutation batch after the passed in batch_id in the mutation queue
    * or `nullopt` if empty.
@@ -238,33 +375,121 @@ class LocalStore {
 
   LruResults CollectGarbage(LruGarbageCollector* garbage_collector);
 
+  /**
+   * Runs a single slice of garbage collection, examining at most `max_entries`
+   * targets or documents, in its own transaction. See
+   * `LruGarbageCollector::CollectSlice`.
+   */
+  LruResults CollectGarbageSlice(LruGarbageCollector* garbage_collector,
+                                 int max_entries);
+
+  /**
+   * Drops the cached query results and the caches of the persistence layer
+   * that can be rebuilt, in response to memory pressure. Returns an estimate
+   * of the number of bytes released by the persistence layer, which leaves out
+   * the query results.
+   */
+  size_t ReleaseMemory();
+
  private:
   friend class LocalStoreTest;  // for `GetTargetData()`
 
   void StartMutationQueue();
+  void PrefetchStartupTargets();
+
+  /**
+   * Records the given target as one the next session should prefetch, if it
+   * is executed soon enough after `Start`.
+   */
+  void RecordStartupTarget(model::TargetId target_id);
+
   void ApplyBatchResult(const model::MutationBatchResult& batch_result);
 
   /**
-   * Returns true if the new_target_data should be persisted during an update of
-   * an active target. TargetData should always be persisted when a target is
-   * being released and should not call this function.
+   * Returns true if the new_target_data should be persisted immediately during
+   * an update of an active target. TargetData should always be persisted when a
+   * target is being released and should not call this function.
    *
-   * While the target is active, TargetData updates can be omitted when nothing
+   * While the target is active, TargetData updates are buffered when nothing
    * about the target has changed except metadata like the resume token or
-   * snapshot version. Occasionally it's worth the extra write to prevent these
-   * values from getting too stale after a crash, but this doesn't have to be
-   * too frequent.
+   * snapshot version. Buffered updates are written out together, at most
+   * `kResumeTokenMaxAgeSeconds` after the oldest of them, so that they don't
+   * get too stale after a crash.
    */
   bool ShouldPersistTargetData(const TargetData& new_target_data,
                                const TargetData& old_target_data,
                                const remote::TargetChange& change) const;
 
+  /**
+   * Reads `query` from `page_results_` if it is a page of a paginated query:
+   * limited to its first documents, without an end bound or projection, and
+   * optionally starting at a bound (the end of the previous page). The base
+   * query's results are read once, when the first page with a start bound
+   * runs. Returns nullopt for other queries and for first pages whose base
+   * query wasn't read yet.
+   */
+  absl::optional<model::DocumentMap> ReadPage(const core::Query& query);
+
+  /**
+   * Replaces the documents in `page_results_` with their given local views.
+   * Must be called with the local views of all documents that changed.
+   */
+  void UpdatePageResults(const model::MaybeDocumentMap& changes);
+
+  /** Drops the results of all queries and pages. */
+  void ClearQueryResults();
+
   /**
    * Returns the TargetData as seen by the LocalStore, including updates that
    * may have not yet been persisted to the TargetCache.
    */
   absl::optional<TargetData> GetTargetData(const core::Target& query);
 
+  /**
+   * Returns the cached TargetData for the target, adding it to the target
+   * cache if it's new. Must be called in a transaction.
+   */
+  TargetData GetOrAddTarget(core::Target target);
+
+  /** Tracks the allocated target as active, unless it already is. */
+  void TrackActiveTarget(const TargetData& target_data);
+
+  /**
+   * Returns the number of pending mutation batches that affect the results of
+   * the given query. Must be called in a transaction.
+   */
+  int64_t CountMutationBatchesAffecting(const core::Query& query);
+
+  /**
+   * Adds the given documents to the remote document cache, unless a newer
+   * version is already cached. Returns the keys of all the given documents.
+   */
+  model::DocumentKeySet SaveNewerDocuments(
+      const std::vector<model::Document>& documents,
+      const model::SnapshotVersion& read_time);
+
+  /**
+   * Records that the given inactive target matches exactly `keys` as of
+   * `read_time`. Does nothing if the target is active.
+   */
+  void SaveTargetResults(const core::Target& target,
+                         const model::DocumentKeySet& keys,
+                         const model::SnapshotVersion& read_time);
+
+  /**
+   * Writes the buffered TargetData of active targets to the target cache. Must
+   * be called in a transaction.
+   */
+  void WriteBufferedTargetData();
+
+  /**
+   * Returns the last batch in the mutation queue with the given mutations
+   * compacted into it, or nullopt if it may already have been sent or the
+   * mutations can't be compacted into it.
+   */
+  absl::optional<model::MutationBatch> CompactIntoLastBatch(
+      const std::vector<model::Mutation>& mutations);
+
   /** Manages our in-memory or durable persistence. Owned by FirestoreClient. */
   Persistence* persistence_ = nullptr;
 
@@ -303,6 +528,52 @@ class LocalStore {
 
   /** Maps a target to its targetID. */
   std::unordered_map<core::Target, model::TargetId> target_id_by_target_;
+
+  /**
+   * Active targets whose entry in `target_data_by_target_` is newer than what's
+   * in the target cache.
+   */
+  std::unordered_set<model::TargetId> buffered_targets_;
+
+  /** The snapshot version of the oldest update in `buffered_targets_`. */
+  model::SnapshotVersion buffered_since_;
+
+  /** Active targets whose resume token has been persisted while current. */
+  std::unordered_set<model::TargetId> current_targets_;
+
+  /**
+   * The results of recently executed queries. Cleared by every operation that
+   * may change documents, mutations or the documents of targets, so the
+   * entries are always up to date and a query that runs again is answered
+   * without reading anything.
+   */
+  std::unordered_map<core::Query, QueryResult> query_results_;
+
+  /**
+   * The local results of the base queries of recently read pages (queries
+   * stripped of their limit and start bound), sorted by the base queries'
+   * ordering. Unlike `query_results_`, these are kept up to date as documents
+   * change, so that successive pages of an infinite scroll are sliced from
+   * them instead of each scanning the whole collection. Each `DocumentSet`
+   * indexes its documents by key, so updating one costs O(log n).
+   */
+  std::unordered_map<core::Query, model::DocumentSet> page_results_;
+
+  bool write_compaction_enabled_ = false;
+
+  size_t max_pending_batches_ = 0;
+  int64_t max_pending_bytes_ = 0;
+
+  /**
+   * The highest batch ID handed out by `GetNextMutationBatch` since the remote
+   * store's write pipeline was last empty. Batches up to it may be in flight,
+   * so they're never compacted.
+   */
+  model::BatchId highest_fetched_batch_id_ = model::kBatchIdUnknown;
+
+  /** The targets executed since `Start`, until `startup_deadline_`. */
+  std::vector<model::TargetId> startup_targets_;
+  std::chrono::steady_clock::time_point startup_deadline_;
 };
 
 }  // namespace local
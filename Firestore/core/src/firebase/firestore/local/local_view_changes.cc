@@ -32,7 +32,7 @@ LocalViewChanges LocalViewChanges::FromViewSnapshot(
   DocumentKeySet added_keys;
   DocumentKeySet removed_keys;
 
-  for (const DocumentViewChange& doc_change : snapshot.document_changes()) {
+  snapshot.ForEachDocumentChange([&](const DocumentViewChange& doc_change) {
     switch (doc_change.type()) {
       case DocumentViewChange::Type::Added:
         added_keys = added_keys.insert(doc_change.document().key());
@@ -46,7 +46,7 @@ LocalViewChanges LocalViewChanges::FromViewSnapshot(
         // Do nothing.
         break;
     }
-  }
+  });
 
   return LocalViewChanges(target_id, snapshot.from_cache(),
                           std::move(added_keys), std::move(removed_keys));
@@ -16,16 +16,23 @@
 
 #include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
 
+#include <algorithm>
 #include <chrono>  // NOLINT(build/c++11)
+#include <cmath>
+#include <limits>
 #include <queue>
+#include <random>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/api/settings.h"
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -85,16 +92,81 @@ class RollingSequenceNumberBuffer {
   const size_t max_elements_;
 };
 
+/**
+ * ReservoirSampler keeps a uniform random sample of a fixed number of sequence
+ * numbers from a series of unknown length.
+ *
+ * Uses "Algorithm L" (Li, 1994), which computes how many elements to skip
+ * between replacements, so most elements cost only a counter decrement.
+ */
+class ReservoirSampler {
+ public:
+  ReservoirSampler(size_t sample_size, std::mt19937* random)
+      : sample_size_(sample_size), random_(random) {
+    sample_.reserve(sample_size);
+    weight_ = std::exp(std::log(NextUniform()) / sample_size_);
+  }
+
+  void AddElement(ListenSequenceNumber sequence_number) {
+    if (sample_.size() < sample_size_) {
+      sample_.push_back(sequence_number);
+      if (sample_.size() == sample_size_) {
+        ComputeSkip();
+      }
+      return;
+    }
+
+    if (skip_ > 0) {
+      --skip_;
+      return;
+    }
+
+    std::uniform_int_distribution<size_t> index(0, sample_size_ - 1);
+    sample_[index(*random_)] = sequence_number;
+    weight_ *= std::exp(std::log(NextUniform()) / sample_size_);
+    ComputeSkip();
+  }
+
+  /** Returns the sample, sorted in ascending order. */
+  std::vector<ListenSequenceNumber> SortedSample() && {
+    std::sort(sample_.begin(), sample_.end());
+    return std::move(sample_);
+  }
+
+ private:
+  /** Returns a random number in the open interval (0, 1). */
+  double NextUniform() {
+    std::uniform_real_distribution<double> uniform(
+        std::numeric_limits<double>::min(), 1.0);
+    return uniform(*random_);
+  }
+
+  void ComputeSkip() {
+    double skip = std::floor(std::log(NextUniform()) / std::log1p(-weight_));
+    skip_ = skip < static_cast<double>(std::numeric_limits<size_t>::max())
+                ? static_cast<size_t>(skip)
+                : std::numeric_limits<size_t>::max();
+  }
+
+  const size_t sample_size_;
+  std::mt19937* random_;
+  std::vector<ListenSequenceNumber> sample_;
+  double weight_ = 0;
+  size_t skip_ = 0;
+};
+
 }  // namespace
 
 const ListenSequenceNumber kListenSequenceNumberInvalid = -1;
 
 LruParams LruParams::Default() {
-  return LruParams{100 * 1024 * 1024, 10, 1000};
+  return LruParams{100 * 1024 * 1024, 10, 1000, 0,
+                   LruEvictionPolicy::SequenceNumber};
 }
 
 LruParams LruParams::Disabled() {
-  return LruParams{api::Settings::CacheSizeUnlimited, 0, 0};
+  return LruParams{api::Settings::CacheSizeUnlimited, 0, 0, 0,
+                   LruEvictionPolicy::SequenceNumber};
 }
 
 LruParams LruParams::WithCacheSize(int64_t cache_size) {
@@ -108,34 +180,104 @@ LruGarbageCollector::LruGarbageCollector(LruDelegate* delegate,
     : delegate_(delegate), params_(std::move(params)) {
 }
 
-LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
+bool LruGarbageCollector::ShouldCollect(int64_t* current_size) {
   if (params_.min_bytes_threshold == Settings::CacheSizeUnlimited) {
     LOG_DEBUG("Garbage collection skipped; disabled");
-    return LruResults::DidNotRun();
+    return false;
   }
 
-  int64_t current_size = CalculateByteSize();
-  if (current_size < params_.min_bytes_threshold) {
+  *current_size = CalculateByteSize();
+  if (*current_size < params_.min_bytes_threshold) {
     // Not enough on disk to warrant collection. Wait another timeout cycle.
     LOG_DEBUG(
         "Garbage collection skipped; Cache size %s is lower than threshold %s",
-        current_size, params_.min_bytes_threshold);
-    return LruResults::DidNotRun();
+        *current_size, params_.min_bytes_threshold);
+    return false;
   }
 
-  LOG_DEBUG("Running garbage collection on cache of size: %s", current_size);
+  LOG_DEBUG("Running garbage collection on cache of size: %s", *current_size);
+  return true;
+}
+
+LruResults LruGarbageCollector::Collect(const LiveQueryMap& live_targets) {
+  int64_t current_size = 0;
+  if (!ShouldCollect(&current_size)) {
+    return LruResults::DidNotRun();
+  }
+  if (params_.eviction_policy == LruEvictionPolicy::SizeWeighted) {
+    return RunSizeWeightedCollection(live_targets, current_size);
+  }
   return RunGarbageCollection(live_targets);
 }
 
+LruResults LruGarbageCollector::CollectSlice(const LiveQueryMap& live_targets,
+                                             int max_entries) {
+  switch (phase_) {
+    case Phase::Idle: {
+      int64_t current_size = 0;
+      if (!ShouldCollect(&current_size)) {
+        return LruResults::DidNotRun();
+      }
+      if (params_.eviction_policy == LruEvictionPolicy::SizeWeighted) {
+        return RunSizeWeightedCollection(live_targets, current_size);
+      }
+
+      int sequence_numbers = SequenceNumbersToCollect();
+      upper_bound_ = SequenceNumberForQueryCount(sequence_numbers);
+      slice_results_ =
+          LruResults{/* did_run= */ true, sequence_numbers, 0, 0};
+      tombstones_removed_ = 0;
+      position_.clear();
+      phase_ = Phase::RemovingTargets;
+      return LruResults::DidNotRun();
+    }
+
+    case Phase::RemovingTargets:
+      slice_results_.targets_removed += delegate_->RemoveTargets(
+          upper_bound_, live_targets, max_entries, &position_);
+      if (position_.empty()) {
+        phase_ = Phase::RemovingDocuments;
+      }
+      return LruResults::DidNotRun();
+
+    case Phase::RemovingDocuments:
+      slice_results_.documents_removed += delegate_->RemoveOrphanedDocuments(
+          upper_bound_, max_entries, &position_);
+      if (position_.empty()) {
+        phase_ = Phase::RemovingTombstones;
+      }
+      return LruResults::DidNotRun();
+
+    case Phase::RemovingTombstones: {
+      // Tombstones only record that a document is known not to exist, which
+      // is worthless once nothing refers to the document, yet every one is
+      // decoded by collection scans. Drop them regardless of age.
+      int removed =
+          delegate_->RemoveOrphanedTombstones(max_entries, &position_);
+      tombstones_removed_ += removed;
+      slice_results_.documents_removed += removed;
+      if (!position_.empty()) {
+        return LruResults::DidNotRun();
+      }
+
+      LOG_DEBUG(
+          "LRU Garbage Collection: removed %s targets and %s documents "
+          "(including %s tombstones) in slices",
+          slice_results_.targets_removed, slice_results_.documents_removed,
+          tombstones_removed_);
+      phase_ = Phase::Idle;
+      return slice_results_;
+    }
+  }
+
+  UNREACHABLE();
+}
+
 LruResults LruGarbageCollector::RunGarbageCollection(
     const LiveQueryMap& live_targets) {
   Timestamp start = Timestamp::Now();
 
-  // Cap at the configured max
-  int sequence_numbers = QueryCountForPercentile(params_.percentile_to_collect);
-  if (sequence_numbers > params_.maximum_sequence_numbers_to_collect) {
-    sequence_numbers = params_.maximum_sequence_numbers_to_collect;
-  }
+  int sequence_numbers = SequenceNumbersToCollect();
   Timestamp counted_targets = Timestamp::Now();
 
   ListenSequenceNumber upper_bound =
@@ -169,6 +311,88 @@ LruResults LruGarbageCollector::RunGarbageCollection(
                     num_documents_removed};
 }
 
+LruResults LruGarbageCollector::RunSizeWeightedCollection(
+    const LiveQueryMap& live_targets, int64_t current_size) {
+  struct Candidate {
+    double score;
+    int64_t byte_size;
+    absl::optional<TargetData> target;
+    DocumentKey document_key;
+  };
+
+  Timestamp start = Timestamp::Now();
+  ListenSequenceNumber now = delegate_->current_sequence_number();
+  auto score = [now](int64_t byte_size, ListenSequenceNumber sequence_number) {
+    ListenSequenceNumber age = std::max<ListenSequenceNumber>(
+        now - sequence_number + 1, 1);
+    return static_cast<double>(byte_size) * static_cast<double>(age);
+  };
+
+  std::vector<Candidate> candidates;
+  delegate_->EnumerateTargets([&](const TargetData& target_data) {
+    if (live_targets.find(target_data.target_id()) != live_targets.end()) {
+      return;
+    }
+    int64_t byte_size = delegate_->CalculateByteSize(target_data);
+    candidates.push_back(
+        Candidate{score(byte_size, target_data.sequence_number()), byte_size,
+                  target_data, DocumentKey{}});
+  });
+  delegate_->EnumerateOrphanedDocumentSizes(
+      [&](const DocumentKey& key, ListenSequenceNumber sequence_number,
+          int64_t byte_size) {
+        candidates.push_back(Candidate{score(byte_size, sequence_number),
+                                       byte_size, absl::nullopt, key});
+      });
+
+  std::sort(candidates.begin(), candidates.end(),
+            [](const Candidate& lhs, const Candidate& rhs) {
+              return lhs.score > rhs.score;
+            });
+
+  int64_t bytes_to_free = current_size * params_.percentile_to_collect / 100;
+  int64_t bytes_freed = 0;
+  int num_targets_removed = 0;
+  int num_documents_removed = 0;
+  for (const Candidate& candidate : candidates) {
+    if (bytes_freed >= bytes_to_free ||
+        num_targets_removed + num_documents_removed >=
+            params_.maximum_sequence_numbers_to_collect) {
+      break;
+    }
+
+    if (candidate.target) {
+      delegate_->EvictTarget(*candidate.target);
+      num_targets_removed++;
+    } else if (delegate_->EvictOrphanedDocument(candidate.document_key)) {
+      num_documents_removed++;
+    } else {
+      continue;
+    }
+    bytes_freed += candidate.byte_size;
+  }
+
+  LOG_DEBUG(
+      "Size-weighted LRU Garbage Collection: removed %s targets and %s "
+      "documents (%s of %s candidates, about %s bytes) in %sms",
+      num_targets_removed, num_documents_removed,
+      num_targets_removed + num_documents_removed, candidates.size(),
+      bytes_freed, MillisecondsBetween(start, Timestamp::Now()));
+
+  return LruResults{/* did_run= */ true,
+                    num_targets_removed + num_documents_removed,
+                    num_targets_removed, num_documents_removed};
+}
+
+int LruGarbageCollector::SequenceNumbersToCollect() {
+  // Cap at the configured max
+  int sequence_numbers = QueryCountForPercentile(params_.percentile_to_collect);
+  if (sequence_numbers > params_.maximum_sequence_numbers_to_collect) {
+    sequence_numbers = params_.maximum_sequence_numbers_to_collect;
+  }
+  return sequence_numbers;
+}
+
 int LruGarbageCollector::QueryCountForPercentile(int percentile) {
   size_t total_count = delegate_->GetSequenceNumberCount();
   return static_cast<int>((percentile / 100.0f) * total_count);
@@ -180,11 +404,20 @@ ListenSequenceNumber LruGarbageCollector::SequenceNumberForQueryCount(
     return kListenSequenceNumberInvalid;
   }
 
+  if (params_.sequence_number_sample_size > 0) {
+    size_t total_count = delegate_->GetSequenceNumberCount();
+    if (total_count >
+        static_cast<size_t>(params_.sequence_number_sample_size)) {
+      return EstimateSequenceNumberForQueryCount(query_count, total_count);
+    }
+  }
+
   RollingSequenceNumberBuffer buffer(query_count);
 
-  delegate_->EnumerateTargets([&buffer](const TargetData& target_data) {
-    buffer.AddElement(target_data.sequence_number());
-  });
+  delegate_->EnumerateTargetSequenceNumbers(
+      [&buffer](ListenSequenceNumber sequence_number) {
+        buffer.AddElement(sequence_number);
+      });
 
   delegate_->EnumerateOrphanedDocuments(
       [&buffer](const DocumentKey& doc_key,
@@ -195,6 +428,34 @@ ListenSequenceNumber LruGarbageCollector::SequenceNumberForQueryCount(
   return buffer.max_value();
 }
 
+ListenSequenceNumber LruGarbageCollector::EstimateSequenceNumberForQueryCount(
+    int query_count, size_t total_count) {
+  auto sample_size = static_cast<size_t>(params_.sequence_number_sample_size);
+  ReservoirSampler sampler(sample_size, &random_);
+
+  delegate_->EnumerateTargetSequenceNumbers(
+      [&sampler](ListenSequenceNumber sequence_number) {
+        sampler.AddElement(sequence_number);
+      });
+
+  delegate_->EnumerateOrphanedDocuments(
+      [&sampler](const DocumentKey&, ListenSequenceNumber sequence_number) {
+        sampler.AddElement(sequence_number);
+      });
+
+  std::vector<ListenSequenceNumber> sample = std::move(sampler).SortedSample();
+  if (sample.empty()) {
+    return kListenSequenceNumberInvalid;
+  }
+
+  // Pick the element at the same relative rank within the sample. Round up so
+  // that a nonzero query count never maps to an empty prefix of the sample.
+  double fraction = static_cast<double>(query_count) / total_count;
+  auto rank = static_cast<size_t>(std::ceil(fraction * sample.size()));
+  rank = std::min(std::max<size_t>(rank, 1), sample.size());
+  return sample[rank - 1];
+}
+
 int LruGarbageCollector::RemoveTargets(ListenSequenceNumber sequence_number,
                                        const LiveQueryMap& live_queries) {
   return delegate_->RemoveTargets(sequence_number, live_queries);
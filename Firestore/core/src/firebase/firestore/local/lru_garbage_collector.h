@@ -17,6 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_LRU_GARBAGE_COLLECTOR_H_
 
+#include <functional>
+#include <random>
+#include <string>
 #include <unordered_map>
 
 #include "Firestore/core/src/firebase/firestore/local/reference_delegate.h"
@@ -34,6 +37,27 @@ class TargetData;
 ABSL_CONST_INIT extern const model::ListenSequenceNumber
     kListenSequenceNumberInvalid;
 
+/** Determines which targets and documents a collection removes. */
+enum class LruEvictionPolicy {
+  /**
+   * Removes the least recently used `percentile_to_collect` percent of targets
+   * and orphaned documents, regardless of their size.
+   */
+  SequenceNumber,
+
+  /**
+   * Removes targets and orphaned documents in order of their encoded size
+   * multiplied by their age in sequence numbers, until `percentile_to_collect`
+   * percent of the cache's bytes have been freed. Large, cold entries go first.
+   */
+  SizeWeighted,
+};
+
+using OrphanedDocumentSizeCallback =
+    std::function<void(const model::DocumentKey&,
+                       model::ListenSequenceNumber,
+                       int64_t byte_size)>;
+
 struct LruParams {
   static LruParams Default();
 
@@ -44,6 +68,15 @@ struct LruParams {
   int64_t min_bytes_threshold;
   int percentile_to_collect;
   int maximum_sequence_numbers_to_collect;
+
+  /**
+   * If nonzero, `SequenceNumberForQueryCount` estimates its result from a
+   * random sample of this many sequence numbers instead of computing it
+   * exactly.
+   */
+  int sequence_number_sample_size;
+
+  LruEvictionPolicy eviction_policy;
 };
 
 struct LruResults {
@@ -82,6 +115,13 @@ class LruDelegate : public ReferenceDelegate {
    */
   virtual void EnumerateTargets(const TargetCallback& callback) = 0;
 
+  /**
+   * Like `EnumerateTargets`, but only passes the sequence number of each
+   * target, which may not need the targets to be read in full.
+   */
+  virtual void EnumerateTargetSequenceNumbers(
+      const SequenceNumberCallback& callback) = 0;
+
   /**
    * Enumerates all of the outstanding mutations.
    */
@@ -103,6 +143,56 @@ class LruDelegate : public ReferenceDelegate {
    */
   virtual int RemoveTargets(model::ListenSequenceNumber sequence_number,
                             const LiveQueryMap& live_queries) = 0;
+
+  /**
+   * Like `RemoveOrphanedDocuments`, but examines at most `max_documents`
+   * documents, starting at the given `position` (or at the beginning if
+   * `position` is empty). On return, `position` holds the point at which to
+   * resume, or is empty if all documents have been examined.
+   */
+  virtual int RemoveOrphanedDocuments(
+      model::ListenSequenceNumber sequence_number,
+      int max_documents,
+      std::string* position) = 0;
+
+  /**
+   * Like `RemoveTargets`, but examines at most `max_targets` targets, starting
+   * at the given `position` (or at the beginning if `position` is empty). On
+   * return, `position` holds the point at which to resume, or is empty if all
+   * targets have been examined.
+   */
+  virtual int RemoveTargets(model::ListenSequenceNumber sequence_number,
+                            const LiveQueryMap& live_queries,
+                            int max_targets,
+                            std::string* position) = 0;
+
+  /**
+   * Removes the `NoDocument`s and `UnknownDocument`s that no target or pending
+   * mutation refers to, whatever their sequence number. Examines at most
+   * `max_documents` documents, resuming at `position` like the sliced
+   * `RemoveOrphanedDocuments`. Returns the number of documents removed.
+   */
+  virtual int RemoveOrphanedTombstones(int max_documents,
+                                       std::string* position) = 0;
+
+  /** Returns the encoded size of the given target, in bytes. */
+  virtual int64_t CalculateByteSize(const TargetData& target_data) = 0;
+
+  /**
+   * Like `EnumerateOrphanedDocuments`, but also passes the encoded size of each
+   * document, in bytes.
+   */
+  virtual void EnumerateOrphanedDocumentSizes(
+      const OrphanedDocumentSizeCallback& callback) = 0;
+
+  /** Removes the given target, which must not be live, from the cache. */
+  virtual void EvictTarget(const TargetData& target_data) = 0;
+
+  /**
+   * Removes the given orphaned document from the cache unless it is pinned.
+   * Returns true if the document was removed.
+   */
+  virtual bool EvictOrphanedDocument(const model::DocumentKey& key) = 0;
 };
 
 /**
@@ -127,6 +217,10 @@ class LruGarbageCollector {
 
   /**
    * Given a number of queries n, return the nth sequence number in the cache.
+   *
+   * If `LruParams::sequence_number_sample_size` is set and the cache holds more
+   * sequence numbers than that, the result is estimated from a uniform random
+   * sample: the sequence number at the same rank within the sample.
    */
   model::ListenSequenceNumber SequenceNumberForQueryCount(int query_count);
 
@@ -147,13 +241,74 @@ class LruGarbageCollector {
 
   local::LruResults Collect(const LiveQueryMap& live_targets);
 
+  /**
+   * Runs a bounded slice of garbage collection, examining at most
+   * `max_entries` targets or documents before returning.
+   *
+   * The first slice of a collection determines the sequence number upper bound
+   * and subsequent slices remove targets, then orphaned documents, and finally
+   * orphaned tombstones of any age, resuming where the previous slice left off.
+   * Each slice is expected to run in its own transaction.
+   *
+   * With `LruEvictionPolicy::SizeWeighted`, the whole collection runs in the
+   * first slice.
+   *
+   * Returns the accumulated results once the final slice has run, and
+   * `LruResults::DidNotRun()` for all other slices (as well as when collection
+   * is skipped altogether). Use `collection_in_progress()` to determine whether
+   * another slice is needed.
+   */
+  local::LruResults CollectSlice(const LiveQueryMap& live_targets,
+                                 int max_entries);
+
+  /**
+   * Returns true if a collection started by `CollectSlice` has not yet
+   * finished.
+   */
+  bool collection_in_progress() const {
+    return phase_ != Phase::Idle;
+  }
+
  private:
+  enum class Phase {
+    Idle,
+    RemovingTargets,
+    RemovingDocuments,
+    RemovingTombstones,
+  };
+
   LruResults RunGarbageCollection(const LiveQueryMap& live_targets);
 
+  model::ListenSequenceNumber EstimateSequenceNumberForQueryCount(
+      int query_count, size_t total_count);
+
+  /** Implements `LruEvictionPolicy::SizeWeighted`. */
+  LruResults RunSizeWeightedCollection(const LiveQueryMap& live_targets,
+                                       int64_t current_size);
+
+  /**
+   * Checks whether collection should run at all; returns false (and logs why)
+   * if it should not.
+   */
+  bool ShouldCollect(int64_t* current_size);
+
+  /** Returns the number of sequence numbers to collect, capped at the max. */
+  int SequenceNumbersToCollect();
+
   // Delegate owns the LruGarbageCollector; this is a back pointer.
   LruDelegate* delegate_;
 
   LruParams params_ = LruParams::Default();
+
+  // Only used for sampling; statistical quality is all that matters here.
+  std::mt19937 random_;
+
+  // State of an in-progress sliced collection.
+  Phase phase_ = Phase::Idle;
+  model::ListenSequenceNumber upper_bound_ = kListenSequenceNumberInvalid;
+  std::string position_;
+  LruResults slice_results_ = LruResults::DidNotRun();
+  int tombstones_removed_ = 0;
 };
 
 }  // namespace local
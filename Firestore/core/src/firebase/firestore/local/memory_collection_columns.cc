@@ -0,0 +1,291 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/memory_collection_columns.h"
+
+#include <cmath>
+#include <utility>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using core::FieldFilter;
+using core::Filter;
+using model::Document;
+using model::FieldPath;
+using model::FieldValue;
+using model::SnapshotVersion;
+
+namespace {
+
+using Operator = Filter::Operator;
+
+/**
+ * The largest magnitude up to which every integer has an exact double
+ * representation. Integers within this range compare the same way as their
+ * doubles.
+ */
+constexpr int64_t kMaxExactInteger = int64_t{1} << 53;
+
+bool IsExactDouble(int64_t value) {
+  return value >= -kMaxExactInteger && value <= kMaxExactInteger;
+}
+
+/** Returns true if `op` compares values (as opposed to array operators). */
+bool IsComparison(Operator op) {
+  switch (op) {
+    case Operator::LessThan:
+    case Operator::LessThanOrEqual:
+    case Operator::Equal:
+    case Operator::GreaterThanOrEqual:
+    case Operator::GreaterThan:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/**
+ * Invokes `narrow` with a predicate that applies `op` to the result of a
+ * three-way comparison, with the switch on `op` hoisted out of the loop.
+ */
+template <typename NarrowFn>
+void DispatchComparison(Operator op, NarrowFn narrow) {
+  switch (op) {
+    case Operator::LessThan:
+      narrow([](int cmp) { return cmp < 0; });
+      break;
+    case Operator::LessThanOrEqual:
+      narrow([](int cmp) { return cmp <= 0; });
+      break;
+    case Operator::Equal:
+      narrow([](int cmp) { return cmp == 0; });
+      break;
+    case Operator::GreaterThanOrEqual:
+      narrow([](int cmp) { return cmp >= 0; });
+      break;
+    case Operator::GreaterThan:
+      narrow([](int cmp) { return cmp > 0; });
+      break;
+    default:
+      break;
+  }
+}
+
+template <typename T>
+int ThreeWay(T lhs, T rhs) {
+  return static_cast<int>(lhs > rhs) - static_cast<int>(lhs < rhs);
+}
+
+}  // namespace
+
+void MemoryCollectionColumns::Add(Document document,
+                                  SnapshotVersion read_time) {
+  documents_.push_back(std::move(document));
+  read_times_.push_back(std::move(read_time));
+}
+
+size_t MemoryCollectionColumns::byte_size() const {
+  size_t result = documents_.capacity() * sizeof(Document) +
+                  read_times_.capacity() * sizeof(SnapshotVersion);
+  for (const auto& kv : columns_) {
+    const Column& column = kv.second;
+    result += column.cells.capacity() * sizeof(Cell) +
+              column.numbers.capacity() * sizeof(double) +
+              column.seconds.capacity() * sizeof(int64_t) +
+              column.nanos.capacity() * sizeof(int32_t);
+  }
+  return result;
+}
+
+const MemoryCollectionColumns::Column& MemoryCollectionColumns::GetColumn(
+    const FieldPath& field) {
+  auto found = columns_.find(field);
+  if (found != columns_.end()) {
+    return found->second;
+  }
+
+  Column column;
+  size_t count = documents_.size();
+  column.cells.resize(count, Cell::Missing);
+  column.numbers.resize(count);
+  column.seconds.resize(count);
+  column.nanos.resize(count);
+
+  for (size_t i = 0; i != count; ++i) {
+    absl::optional<FieldValue> value = documents_[i].field(field);
+    if (!value) continue;
+
+    switch (value->type()) {
+      case FieldValue::Type::Integer: {
+        int64_t integer = value->integer_value();
+        if (IsExactDouble(integer)) {
+          column.cells[i] = Cell::Number;
+          column.numbers[i] = static_cast<double>(integer);
+        } else {
+          column.cells[i] = Cell::Unknown;
+        }
+        break;
+      }
+
+      case FieldValue::Type::Double:
+        if (std::isnan(value->double_value())) {
+          column.cells[i] = Cell::Unknown;
+        } else {
+          column.cells[i] = Cell::Number;
+          column.numbers[i] = value->double_value();
+        }
+        break;
+
+      case FieldValue::Type::Timestamp: {
+        Timestamp timestamp = value->timestamp_value();
+        column.cells[i] = Cell::Timestamp;
+        column.seconds[i] = timestamp.seconds();
+        column.nanos[i] = timestamp.nanoseconds();
+        break;
+      }
+
+      default:
+        column.cells[i] = Cell::Other;
+        break;
+    }
+  }
+
+  return columns_.emplace(field, std::move(column)).first->second;
+}
+
+struct MemoryCollectionColumns::NarrowNumbers {
+  template <typename Matches>
+  void operator()(Matches matches) const {
+    for (size_t i = 0; i != count; ++i) {
+      bool keep = ((cells[i] == Cell::Number) &
+                   matches(ThreeWay(numbers[i], rhs))) |
+                  (cells[i] == Cell::Unknown);
+      out[i] &= static_cast<uint8_t>(keep);
+    }
+  }
+
+  const Cell* cells;
+  const double* numbers;
+  double rhs;
+  uint8_t* out;
+  size_t count;
+};
+
+struct MemoryCollectionColumns::NarrowTimestamps {
+  template <typename Matches>
+  void operator()(Matches matches) const {
+    for (size_t i = 0; i != count; ++i) {
+      int cmp = ThreeWay(seconds[i], rhs_seconds);
+      cmp = cmp != 0 ? cmp : ThreeWay(nanos[i], rhs_nanos);
+      bool keep = (cells[i] == Cell::Timestamp) & matches(cmp);
+      out[i] &= static_cast<uint8_t>(keep);
+    }
+  }
+
+  const Cell* cells;
+  const int64_t* seconds;
+  const int32_t* nanos;
+  int64_t rhs_seconds;
+  int32_t rhs_nanos;
+  uint8_t* out;
+  size_t count;
+};
+
+bool MemoryCollectionColumns::Narrow(const FieldFilter& filter,
+                                     std::vector<uint8_t>* candidates) {
+  HARD_ASSERT(candidates->size() == documents_.size(),
+              "Expected one candidate per document");
+
+  // Subclasses of FieldFilter (such as array-contains and key filters) have
+  // their own matching rules.
+  if (filter.type() != Filter::Type::kFieldFilter ||
+      !IsComparison(filter.op())) {
+    return false;
+  }
+
+  const FieldValue& rhs = filter.value();
+  Cell expected;
+  double rhs_number = 0;
+  Timestamp rhs_timestamp;
+  switch (rhs.type()) {
+    case FieldValue::Type::Integer:
+      if (!IsExactDouble(rhs.integer_value())) return false;
+      expected = Cell::Number;
+      rhs_number = static_cast<double>(rhs.integer_value());
+      break;
+    case FieldValue::Type::Double:
+      if (rhs.is_nan()) return false;
+      expected = Cell::Number;
+      rhs_number = rhs.double_value();
+      break;
+    case FieldValue::Type::Timestamp:
+      expected = Cell::Timestamp;
+      rhs_timestamp = rhs.timestamp_value();
+      break;
+    default:
+      return false;
+  }
+
+  const Column& column = GetColumn(filter.field());
+  const Cell* cells = column.cells.data();
+  uint8_t* out = candidates->data();
+  size_t count = column.cells.size();
+
+  // The loops below are written without data-dependent branches so that the
+  // compiler can vectorize them. Values that are not comparable with the
+  // filter value never match (see FieldFilter::Matches), except for Unknown
+  // values, which are left for the full query to decide.
+  if (expected == Cell::Number) {
+    const double* numbers = column.numbers.data();
+    DispatchComparison(filter.op(),
+                       NarrowNumbers{cells, numbers, rhs_number, out, count});
+  } else {
+    const int64_t* seconds = column.seconds.data();
+    const int32_t* nanos = column.nanos.data();
+    int64_t rhs_seconds = rhs_timestamp.seconds();
+    int32_t rhs_nanos = rhs_timestamp.nanoseconds();
+    DispatchComparison(filter.op(),
+                       NarrowTimestamps{cells, seconds, nanos, rhs_seconds,
+                                        rhs_nanos, out, count});
+  }
+  return true;
+}
+
+void MemoryCollectionColumns::NarrowToPresent(
+    const FieldPath& field, std::vector<uint8_t>* candidates) {
+  HARD_ASSERT(candidates->size() == documents_.size(),
+              "Expected one candidate per document");
+
+  const Column& column = GetColumn(field);
+  const Cell* cells = column.cells.data();
+  uint8_t* out = candidates->data();
+  for (size_t i = 0, count = column.cells.size(); i != count; ++i) {
+    out[i] &= static_cast<uint8_t>(cells[i] != Cell::Missing);
+  }
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
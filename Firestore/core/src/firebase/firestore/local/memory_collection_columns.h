@@ -0,0 +1,144 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_COLLECTION_COLUMNS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_COLLECTION_COLUMNS_H_
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+
+namespace firebase {
+namespace firestore {
+
+namespace core {
+class FieldFilter;
+}  // namespace core
+
+namespace local {
+
+/**
+ * A columnar snapshot of the documents in a single collection, used by
+ * MemoryRemoteDocumentCache to evaluate filters on collections that are
+ * queried repeatedly without intervening writes.
+ *
+ * The documents are stored in key order. For each field that a query filters
+ * or orders on, the snapshot lazily extracts the field's values into typed,
+ * contiguous vectors so that numeric and timestamp comparisons run as a tight
+ * loop over plain arrays instead of walking each document's ObjectValue.
+ *
+ * Narrowing only ever removes documents that cannot match; callers must still
+ * apply the full query to the remaining candidates.
+ *
+ * The snapshot is immutable once built and must be discarded when any
+ * document in the collection changes.
+ */
+class MemoryCollectionColumns {
+ public:
+  /** Appends a document. Documents must be added in key order. */
+  void Add(model::Document document, model::SnapshotVersion read_time);
+
+  size_t size() const {
+    return documents_.size();
+  }
+
+  const model::Document& document(size_t index) const {
+    return documents_[index];
+  }
+
+  const model::SnapshotVersion& read_time(size_t index) const {
+    return read_times_[index];
+  }
+
+  /**
+   * The memory taken up by the snapshot's vectors and columns, not counting
+   * the contents of the documents themselves.
+   */
+  size_t byte_size() const;
+
+  /**
+   * Clears the entries of `candidates` for documents that cannot match the
+   * given filter. `candidates` must have one entry per document.
+   *
+   * Only comparisons against numbers and timestamps are evaluated on columns;
+   * other filters leave `candidates` unchanged.
+   *
+   * @return true if the filter was evaluated.
+   */
+  bool Narrow(const core::FieldFilter& filter,
+              std::vector<uint8_t>* candidates);
+
+  /**
+   * Clears the entries of `candidates` for documents that do not contain the
+   * given field, as required by an order by on that field.
+   */
+  void NarrowToPresent(const model::FieldPath& field,
+                       std::vector<uint8_t>* candidates);
+
+ private:
+  /** What is known about a single value in a column. */
+  enum class Cell : uint8_t {
+    /** The document does not contain the field. */
+    Missing,
+
+    /** The value is a number, stored exactly in `numbers`. */
+    Number,
+
+    /** The value is a timestamp, stored in `seconds` and `nanos`. */
+    Timestamp,
+
+    /** The value is of a type that is not stored in the column. */
+    Other,
+
+    /**
+     * The value is a number that cannot be compared as a double (NaN, or an
+     * integer too large to be represented exactly). Never narrowed out.
+     */
+    Unknown,
+  };
+
+  struct Column {
+    std::vector<Cell> cells;
+    std::vector<double> numbers;
+    std::vector<int64_t> seconds;
+    std::vector<int32_t> nanos;
+  };
+
+  /**
+   * Loops that clear the candidates whose values don't satisfy a comparison,
+   * for numbers and timestamps respectively. Invoked with the predicate for
+   * the filter's operator.
+   */
+  struct NarrowNumbers;
+  struct NarrowTimestamps;
+
+  const Column& GetColumn(const model::FieldPath& field);
+
+  std::vector<model::Document> documents_;
+  std::vector<model::SnapshotVersion> read_times_;
+  std::map<model::FieldPath, Column> columns_;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_COLLECTION_COLUMNS_H_
@@ -19,16 +19,38 @@
 #include <algorithm>
 #include <set>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/geohash.h"
+#include "Firestore/core/src/firebase/firestore/local/index_scan.h"
+#include "Firestore/core/src/firebase/firestore/local/persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/strings/match.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+using core::Query;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::FieldIndex;
+using model::FieldPath;
+using model::MaybeDocument;
 using model::ResourcePath;
+using model::SnapshotVersion;
+
+using Segment = FieldIndex::Segment;
 
 bool MemoryCollectionParentIndex::Add(const ResourcePath& collection_path) {
   HARD_ASSERT(collection_path.size() % 2 == 1, "Expected a collection path.");
@@ -52,6 +74,10 @@ std::vector<ResourcePath> MemoryCollectionParentIndex::GetEntries(
   return result;
 }
 
+MemoryIndexManager::MemoryIndexManager(Persistence* persistence)
+    : persistence_(persistence) {
+}
+
 void MemoryIndexManager::AddToCollectionParentIndex(
     const ResourcePath& collection_path) {
   collection_parents_index_.Add(collection_path);
@@ -62,6 +88,214 @@ std::vector<ResourcePath> MemoryIndexManager::GetCollectionParents(
   return collection_parents_index_.GetEntries(collection_id);
 }
 
+void MemoryIndexManager::AddFieldIndex(const FieldIndex& index) {
+  HARD_ASSERT(!index.segments().empty(),
+              "Field indexes must have at least one segment");
+
+  std::vector<FieldIndex>& indexes = field_indexes_[index.collection_id()];
+  if (std::find(indexes.begin(), indexes.end(), index) != indexes.end()) {
+    return;
+  }
+  indexes.push_back(index);
+  if (!persistence_) return;
+
+  // Index the documents that are already cached in the collection group.
+  const std::string& collection_id = index.collection_id();
+  for (const ResourcePath& parent : GetCollectionParents(collection_id)) {
+    Query collection_query(parent.Append(collection_id));
+    DocumentMap documents = persistence_->remote_document_cache()->GetMatching(
+        collection_query, SnapshotVersion::None());
+    for (const auto& kv : documents.underlying_map()) {
+      WriteIndexEntries(index, Document(kv.second));
+    }
+  }
+}
+
+std::vector<FieldIndex> MemoryIndexManager::GetFieldIndexes(
+    const std::string& collection_id) {
+  auto found = field_indexes_.find(collection_id);
+  if (found == field_indexes_.end()) {
+    return {};
+  }
+  return found->second;
+}
+
+absl::optional<DocumentKeySet> MemoryIndexManager::GetDocumentsMatchingQuery(
+    const Query& query) {
+  if (query.IsDocumentQuery() || query.IsCollectionGroupQuery() ||
+      query.filters().empty()) {
+    return absl::nullopt;
+  }
+
+  const ResourcePath& collection_path = query.path();
+  auto found = field_indexes_.find(collection_path.last_segment());
+  if (found == field_indexes_.end()) {
+    return absl::nullopt;
+  }
+
+  const FieldIndex* best_index = nullptr;
+  absl::optional<IndexScan> best_scan =
+      PlanBestIndexScan(found->second, query, &best_index);
+  if (!best_scan) {
+    return absl::nullopt;
+  }
+
+  DocumentKeySet result;
+  const IndexEntries* entries = FindIndexEntries(*best_index, collection_path);
+  if (!entries) {
+    return result;
+  }
+
+  for (const std::vector<std::string>& prefix_values : best_scan->prefixes) {
+    std::vector<std::string> start_values = prefix_values;
+    if (best_scan->has_range) {
+      start_values.push_back(best_scan->range_lower);
+    }
+
+    size_t range_index = prefix_values.size();
+    for (auto it = entries->lower_bound(IndexEntry{start_values, ""});
+         it != entries->end(); ++it) {
+      const std::vector<std::string>& values = it->first;
+      if (!std::equal(prefix_values.begin(), prefix_values.end(),
+                      values.begin())) {
+        break;
+      }
+
+      if (best_scan->has_range &&
+          values[range_index] >= best_scan->range_upper) {
+        break;
+      }
+
+      result = result.insert(DocumentKey{collection_path.Append(it->second)});
+    }
+  }
+
+  return result;
+}
+
+absl::optional<DocumentKeySet> MemoryIndexManager::GetDocumentsInBoundingBox(
+    const ResourcePath& collection_path,
+    const FieldPath& field_path,
+    const GeoPoint& south_west,
+    const GeoPoint& north_east) {
+  auto found = field_indexes_.find(collection_path.last_segment());
+  if (found == field_indexes_.end()) {
+    return absl::nullopt;
+  }
+
+  const FieldIndex* spatial_index = nullptr;
+  for (const FieldIndex& index : found->second) {
+    const Segment& first = index.segments().front();
+    if (first.kind() == Segment::Kind::Geohash &&
+        first.field_path() == field_path) {
+      spatial_index = &index;
+      break;
+    }
+  }
+  if (!spatial_index) {
+    return absl::nullopt;
+  }
+
+  DocumentKeySet result;
+  const IndexEntries* entries =
+      FindIndexEntries(*spatial_index, collection_path);
+  if (!entries) {
+    return result;
+  }
+
+  // The geohashes in a cell all start with the cell's geohash, and sort just
+  // after it.
+  for (const std::string& cell :
+       GeohashCoveringCells(south_west, north_east, kMaxGeohashCells)) {
+    for (auto it = entries->lower_bound(IndexEntry{{cell}, ""});
+         it != entries->end() && absl::StartsWith(it->first.front(), cell);
+         ++it) {
+      result = result.insert(DocumentKey{collection_path.Append(it->second)});
+    }
+  }
+
+  return result;
+}
+
+bool MemoryIndexManager::HasFieldIndexes(
+    const ResourcePath& collection_path) const {
+  return field_indexes_.find(collection_path.last_segment()) !=
+         field_indexes_.end();
+}
+
+void MemoryIndexManager::AddIndexEntries(const MaybeDocument& document) {
+  if (!document.is_document()) return;
+
+  Document doc(document);
+  auto found = field_indexes_.find(doc.key().path().PopLast().last_segment());
+  if (found == field_indexes_.end()) return;
+
+  for (const FieldIndex& index : found->second) {
+    WriteIndexEntries(index, doc);
+  }
+}
+
+void MemoryIndexManager::RemoveIndexEntries(const MaybeDocument& document) {
+  if (!document.is_document()) return;
+
+  Document doc(document);
+  auto found = field_indexes_.find(doc.key().path().PopLast().last_segment());
+  if (found == field_indexes_.end()) return;
+
+  for (const FieldIndex& index : found->second) {
+    DeleteIndexEntries(index, doc);
+  }
+}
+
+const MemoryIndexManager::IndexEntries* MemoryIndexManager::FindIndexEntries(
+    const FieldIndex& index, const ResourcePath& collection_path) const {
+  auto by_index = index_entries_.find(index.CanonicalId());
+  if (by_index == index_entries_.end()) {
+    return nullptr;
+  }
+  auto by_collection = by_index->second.find(collection_path);
+  if (by_collection == by_index->second.end()) {
+    return nullptr;
+  }
+  return &by_collection->second;
+}
+
+void MemoryIndexManager::WriteIndexEntries(const FieldIndex& index,
+                                           const Document& document) {
+  std::vector<std::vector<std::string>> encoded =
+      EncodeIndexEntries(index, document);
+  if (encoded.empty()) return;
+
+  const ResourcePath& path = document.key().path();
+  IndexEntries& entries =
+      index_entries_[index.CanonicalId()][path.PopLast()];
+  for (std::vector<std::string>& values : encoded) {
+    entries.emplace(std::move(values), path.last_segment());
+  }
+}
+
+void MemoryIndexManager::DeleteIndexEntries(const FieldIndex& index,
+                                            const Document& document) {
+  std::vector<std::vector<std::string>> encoded =
+      EncodeIndexEntries(index, document);
+  if (encoded.empty()) return;
+
+  auto by_index = index_entries_.find(index.CanonicalId());
+  if (by_index == index_entries_.end()) return;
+
+  const ResourcePath& path = document.key().path();
+  auto by_collection = by_index->second.find(path.PopLast());
+  if (by_collection == by_index->second.end()) return;
+
+  IndexEntries& entries = by_collection->second;
+  for (std::vector<std::string>& values : encoded) {
+    entries.erase(IndexEntry{std::move(values), path.last_segment()});
+  }
+  if (entries.empty()) {
+    by_index->second.erase(by_collection);
+  }
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
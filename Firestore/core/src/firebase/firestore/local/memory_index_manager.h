@@ -17,17 +17,22 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_INDEX_MANAGER_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_INDEX_MANAGER_H_
 
+#include <map>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
+#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+class Persistence;
+
 /**
  * Internal implementation of the collection-parent index. Also used for
  * in-memory caching by LevelDbIndexManager and initial index population during
@@ -48,14 +53,91 @@ class MemoryCollectionParentIndex {
 /** An in-memory implementation of IndexManager. */
 class MemoryIndexManager : public IndexManager {
  public:
+  MemoryIndexManager() = default;
+
+  /**
+   * Creates an index manager that indexes the documents already cached in
+   * `persistence` when a field index is added.
+   */
+  explicit MemoryIndexManager(Persistence* persistence);
+
   void AddToCollectionParentIndex(
       const model::ResourcePath& collection_path) override;
 
   std::vector<model::ResourcePath> GetCollectionParents(
       const std::string& collection_id) override;
 
+  void AddFieldIndex(const model::FieldIndex& index) override;
+
+  std::vector<model::FieldIndex> GetFieldIndexes(
+      const std::string& collection_id) override;
+
+  /**
+   * Reads the candidate documents from the sorted entries of the best field
+   * index, seeking to the start of each scanned range instead of matching the
+   * query against every document in the collection.
+   */
+  absl::optional<model::DocumentKeySet> GetDocumentsMatchingQuery(
+      const core::Query& query) override;
+
+  absl::optional<model::DocumentKeySet> GetDocumentsInBoundingBox(
+      const model::ResourcePath& collection_path,
+      const model::FieldPath& field_path,
+      const GeoPoint& south_west,
+      const GeoPoint& north_east) override;
+
+  /**
+   * Returns true if any field index is configured for the collection group of
+   * the given collection, with the same purpose as
+   * LevelDbIndexManager::HasFieldIndexes.
+   */
+  bool HasFieldIndexes(const model::ResourcePath& collection_path) const;
+
+  /**
+   * Adds the field index entries for the given document. Does nothing unless
+   * the document is a Document in a collection with field indexes.
+   */
+  void AddIndexEntries(const model::MaybeDocument& document);
+
+  /**
+   * Removes the field index entries previously added for the given document
+   * by AddIndexEntries.
+   */
+  void RemoveIndexEntries(const model::MaybeDocument& document);
+
  private:
+  /**
+   * An index entry: the encoded values of the indexed fields, followed by the
+   * ID of the document. Entries sort in the same order as the rows of
+   * LevelDbIndexManager, so the same scans apply to both.
+   */
+  using IndexEntry = std::pair<std::vector<std::string>, std::string>;
+  using IndexEntries = std::set<IndexEntry>;
+
+  /**
+   * Returns the entries of the given index for documents directly in the
+   * given collection, or nullptr if there are none.
+   */
+  const IndexEntries* FindIndexEntries(
+      const model::FieldIndex& index,
+      const model::ResourcePath& collection_path) const;
+
+  void WriteIndexEntries(const model::FieldIndex& index,
+                         const model::Document& document);
+
+  void DeleteIndexEntries(const model::FieldIndex& index,
+                          const model::Document& document);
+
+  Persistence* persistence_ = nullptr;
+
   MemoryCollectionParentIndex collection_parents_index_;
+  std::unordered_map<std::string, std::vector<model::FieldIndex>>
+      field_indexes_;
+
+  /** The entries of each field index by canonical ID, then by collection. */
+  std::unordered_map<std::string,
+                     std::map<model::ResourcePath, IndexEntries>>
+      index_entries_;
 };
 
 }  // namespace local
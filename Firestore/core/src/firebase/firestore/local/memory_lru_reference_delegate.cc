@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_lru_reference_delegate.h"
 
+#include <string>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/listen_sequence.h"
@@ -89,6 +90,13 @@ void MemoryLruReferenceDelegate::EnumerateTargets(
   return persistence_->target_cache()->EnumerateTargets(callback);
 }
 
+void MemoryLruReferenceDelegate::EnumerateTargetSequenceNumbers(
+    const SequenceNumberCallback& callback) {
+  EnumerateTargets([&callback](const TargetData& target_data) {
+    callback(target_data.sequence_number());
+  });
+}
+
 void MemoryLruReferenceDelegate::EnumerateOrphanedDocuments(
     const OrphanedDocumentCallback& callback) {
   for (const auto& entry : sequence_numbers_) {
@@ -128,6 +136,72 @@ int MemoryLruReferenceDelegate::RemoveOrphanedDocuments(
   return static_cast<int>(removed.size());
 }
 
+int MemoryLruReferenceDelegate::RemoveTargets(
+    model::ListenSequenceNumber sequence_number,
+    const LiveQueryMap& live_queries,
+    int,
+    std::string* position) {
+  position->clear();
+  return RemoveTargets(sequence_number, live_queries);
+}
+
+int MemoryLruReferenceDelegate::RemoveOrphanedDocuments(
+    model::ListenSequenceNumber upper_bound, int, std::string* position) {
+  position->clear();
+  return RemoveOrphanedDocuments(upper_bound);
+}
+
+int MemoryLruReferenceDelegate::RemoveOrphanedTombstones(
+    int, std::string* position) {
+  position->clear();
+  std::vector<DocumentKey> tombstones;
+  EnumerateOrphanedDocuments(
+      [&](const DocumentKey& key, ListenSequenceNumber) {
+        absl::optional<model::MaybeDocument> doc =
+            persistence_->remote_document_cache()->Get(key);
+        if (doc && !doc->is_document()) {
+          tombstones.push_back(key);
+        }
+      });
+  for (const DocumentKey& key : tombstones) {
+    persistence_->remote_document_cache()->Remove(key);
+    sequence_numbers_.erase(key);
+  }
+  return static_cast<int>(tombstones.size());
+}
+
+int64_t MemoryLruReferenceDelegate::CalculateByteSize(
+    const TargetData& target_data) {
+  return sizer_->CalculateByteSize(target_data);
+}
+
+void MemoryLruReferenceDelegate::EnumerateOrphanedDocumentSizes(
+    const OrphanedDocumentSizeCallback& callback) {
+  EnumerateOrphanedDocuments(
+      [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
+        absl::optional<model::MaybeDocument> doc =
+            persistence_->remote_document_cache()->Get(key);
+        int64_t byte_size = doc ? sizer_->CalculateByteSize(*doc) : 0;
+        callback(key, sequence_number, byte_size);
+      });
+}
+
+void MemoryLruReferenceDelegate::EvictTarget(const TargetData& target_data) {
+  persistence_->target_cache()->RemoveTarget(target_data);
+}
+
+bool MemoryLruReferenceDelegate::EvictOrphanedDocument(const DocumentKey& key) {
+  auto it = sequence_numbers_.find(key);
+  ListenSequenceNumber sequence_number =
+      it != sequence_numbers_.end() ? it->second : current_sequence_number_;
+  if (IsPinnedAtSequenceNumber(sequence_number, key)) {
+    return false;
+  }
+  persistence_->remote_document_cache()->Remove(key);
+  sequence_numbers_.erase(key);
+  return true;
+}
+
 void MemoryLruReferenceDelegate::AddReference(const DocumentKey& key) {
   sequence_numbers_[key] = current_sequence_number_;
 }
@@ -172,16 +246,14 @@ bool MemoryLruReferenceDelegate::IsPinnedAtSequenceNumber(
 }
 
 int64_t MemoryLruReferenceDelegate::CalculateByteSize() {
-  // Note that this method is only used for testing because this delegate is
-  // only used for testing. The algorithm here (loop through everything,
-  // serialize it and count bytes) is inefficient and inexact, but won't run in
-  // production.
+  // The caches keep running totals, so this doesn't depend on how much is
+  // cached.
   int64_t count = 0;
-  count += persistence_->target_cache()->CalculateByteSize(*sizer_);
-  count += persistence_->remote_document_cache()->CalculateByteSize(*sizer_);
+  count += persistence_->target_cache()->byte_size();
+  count += persistence_->remote_document_cache()->byte_size();
   const auto& queues = persistence_->mutation_queues();
   for (const auto& entry : queues) {
-    count += entry.second->CalculateByteSize(*sizer_);
+    count += entry.second->GetByteSize();
   }
   return count;
 }
@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_LRU_REFERENCE_DELEGATE_H_
 
 #include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
 
@@ -69,6 +70,8 @@ class MemoryLruReferenceDelegate : public LruDelegate {
   size_t GetSequenceNumberCount() override;
 
   void EnumerateTargets(const TargetCallback& callback) override;
+  void EnumerateTargetSequenceNumbers(
+      const SequenceNumberCallback& callback) override;
   void EnumerateOrphanedDocuments(
       const OrphanedDocumentCallback& callback) override;
 
@@ -76,6 +79,30 @@ class MemoryLruReferenceDelegate : public LruDelegate {
   int RemoveTargets(model::ListenSequenceNumber sequence_number,
                     const LiveQueryMap& live_queries) override;
 
+  /**
+   * Removes all eligible documents in a single slice: the in-memory cache has
+   * no transactions to keep short, so `position` is always left empty.
+   */
+  int RemoveOrphanedDocuments(model::ListenSequenceNumber upper_bound,
+                              int max_documents,
+                              std::string* position) override;
+
+  /** Removes all eligible targets in a single slice; see above. */
+  int RemoveTargets(model::ListenSequenceNumber sequence_number,
+                    const LiveQueryMap& live_queries,
+                    int max_targets,
+                    std::string* position) override;
+
+  /** Removes all eligible tombstones in a single slice; see above. */
+  int RemoveOrphanedTombstones(int max_documents,
+                               std::string* position) override;
+
+  int64_t CalculateByteSize(const TargetData& target_data) override;
+  void EnumerateOrphanedDocumentSizes(
+      const OrphanedDocumentSizeCallback& callback) override;
+  void EvictTarget(const TargetData& target_data) override;
+  bool EvictOrphanedDocument(const model::DocumentKey& key) override;
+
  private:
   bool MutationQueuesContainKey(const model::DocumentKey& key) const;
 
@@ -92,7 +92,30 @@ MutationBatch MemoryMutationQueue::AddMutationBatch(
 
   MutationBatch batch(batch_id, local_write_time, std::move(base_mutations),
                       std::move(mutations));
+  Append(batch);
+  return batch;
+}
+
+void MemoryMutationQueue::AddBatches(std::vector<MutationBatch> batches,
+                                     ByteString last_stream_token) {
+  HARD_ASSERT(queue_.empty(), "Batches must be added to an empty queue");
+
+  for (const MutationBatch& batch : batches) {
+    HARD_ASSERT(queue_.empty() || batch.batch_id() == next_batch_id_,
+                "Mutation batch_ids must be consecutive");
+    next_batch_id_ = batch.batch_id() + 1;
+    Append(batch);
+  }
+  last_stream_token_ = std::move(last_stream_token);
+}
+
+void MemoryMutationQueue::Append(const MutationBatch& batch) {
+  BatchId batch_id = batch.batch_id();
   queue_.push_back(batch);
+  change_count_++;
+  if (const Sizer* sizer = persistence_->sizer()) {
+    byte_size_ += sizer->CalculateByteSize(batch);
+  }
 
   // Track references by document key and index collection parents.
   for (const Mutation& mutation : batch.mutations()) {
@@ -102,8 +125,6 @@ MutationBatch MemoryMutationQueue::AddMutationBatch(
     persistence_->index_manager()->AddToCollectionParentIndex(
         mutation.key().path().PopLast());
   }
-
-  return batch;
 }
 
 void MemoryMutationQueue::RemoveMutationBatch(const MutationBatch& batch) {
@@ -113,7 +134,11 @@ void MemoryMutationQueue::RemoveMutationBatch(const MutationBatch& batch) {
   HARD_ASSERT(head.batch_id() == batch.batch_id(),
               "Can only remove the first entry of the mutation queue");
 
-  queue_.erase(queue_.begin());
+  if (const Sizer* sizer = persistence_->sizer()) {
+    byte_size_ -= sizer->CalculateByteSize(head);
+  }
+  queue_.pop_front();
+  change_count_++;
 
   // Remove entries from the index too.
   for (const Mutation& mutation : batch.mutations()) {
@@ -125,6 +150,23 @@ void MemoryMutationQueue::RemoveMutationBatch(const MutationBatch& batch) {
   }
 }
 
+void MemoryMutationQueue::ReplaceLastMutationBatch(const MutationBatch& batch) {
+  HARD_ASSERT(!queue_.empty(), "Trying to replace batch in empty queue");
+  MutationBatch& last = queue_.back();
+  HARD_ASSERT(last.batch_id() == batch.batch_id(),
+              "Can only replace the last entry of the mutation queue");
+  HARD_ASSERT(last.keys() == batch.keys(),
+              "A replacement batch must affect the same documents");
+
+  if (const Sizer* sizer = persistence_->sizer()) {
+    byte_size_ -= sizer->CalculateByteSize(last);
+    byte_size_ += sizer->CalculateByteSize(batch);
+  }
+  // The index by document key is unchanged, since the documents are.
+  last = batch;
+  change_count_++;
+}
+
 std::vector<MutationBatch>
 MemoryMutationQueue::AllMutationBatchesAffectingDocumentKeys(
     const DocumentKeySet& document_keys) {
@@ -256,14 +298,6 @@ bool MemoryMutationQueue::ContainsKey(const model::DocumentKey& key) {
   return begin != range.end() && begin->key() == key;
 }
 
-int64_t MemoryMutationQueue::CalculateByteSize(const Sizer& sizer) {
-  int64_t count = 0;
-  for (const auto& batch : queue_) {
-    count += sizer.CalculateByteSize(batch);
-  }
-  return count;
-}
-
 ByteString MemoryMutationQueue::GetLastStreamToken() {
   return last_stream_token_;
 }
@@ -17,6 +17,9 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_MUTATION_QUEUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_MUTATION_QUEUE_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <deque>
 #include <set>
 #include <vector>
 
@@ -34,7 +37,6 @@ namespace firestore {
 namespace local {
 
 class MemoryPersistence;
-class Sizer;
 
 class MemoryMutationQueue : public MutationQueue {
  public:
@@ -54,8 +56,10 @@ class MemoryMutationQueue : public MutationQueue {
 
   void RemoveMutationBatch(const model::MutationBatch& batch) override;
 
+  void ReplaceLastMutationBatch(const model::MutationBatch& batch) override;
+
   std::vector<model::MutationBatch> AllMutationBatches() override {
-    return queue_;
+    return {queue_.begin(), queue_.end()};
   }
 
   std::vector<model::MutationBatch> AllMutationBatchesAffectingDocumentKeys(
@@ -75,11 +79,33 @@ class MemoryMutationQueue : public MutationQueue {
 
   model::BatchId GetHighestUnacknowledgedBatchId() override;
 
+  uint64_t GetChangeCount() override {
+    return change_count_;
+  }
+
+  size_t GetBatchCount() override {
+    return queue_.size();
+  }
+
+  /**
+   * Returns the total size in bytes of the queued batches, as estimated by the
+   * persistence's sizer, or zero if the persistence has no sizer.
+   */
+  int64_t GetByteSize() override {
+    return byte_size_;
+  }
+
   void PerformConsistencyCheck() override;
 
   bool ContainsKey(const model::DocumentKey& key);
 
-  int64_t CalculateByteSize(const Sizer& sizer);
+  /**
+   * Fills the empty queue with the given batches, which must have consecutive
+   * IDs, such as those read from a snapshot. New batches are numbered after
+   * the last of them.
+   */
+  void AddBatches(std::vector<model::MutationBatch> batches,
+                  nanopb::ByteString last_stream_token);
 
   nanopb::ByteString GetLastStreamToken() override;
   void SetLastStreamToken(nanopb::ByteString token) override;
@@ -88,6 +114,9 @@ class MemoryMutationQueue : public MutationQueue {
   using DocumentKeyReferenceSet =
       immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ByKey>;
 
+  /** Appends `batch` to the queue and indexes it by document key. */
+  void Append(const model::MutationBatch& batch);
+
   std::vector<model::MutationBatch> AllMutationBatchesWithIds(
       const std::set<model::BatchId>& batch_ids);
 
@@ -122,8 +151,11 @@ class MemoryMutationQueue : public MutationQueue {
    *
    * Once the held write acknowledgements become visible they are removed from
    * the head of the queue along with any tombstones that follow.
+   *
+   * Batch IDs are consecutive, so a batch is found by its offset from the
+   * first batch, and removing from the front is O(1).
    */
-  std::vector<model::MutationBatch> queue_;
+  std::deque<model::MutationBatch> queue_;
 
   /**
    * The next value to use when assigning sequential IDs to each mutation
@@ -131,6 +163,12 @@ class MemoryMutationQueue : public MutationQueue {
    */
   model::BatchId next_batch_id_ = 1;
 
+  /** Incremented whenever a batch is added or removed. */
+  uint64_t change_count_ = 0;
+
+  /** The running total returned by `GetByteSize()`. */
+  int64_t byte_size_ = 0;
+
   /**
    * The last received stream token from the server, used to acknowledge which
    * responses the client has processed. Stream tokens are opaque checkpoint
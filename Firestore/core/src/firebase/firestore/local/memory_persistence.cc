@@ -16,8 +16,18 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
+#include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/local/document_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/local/listen_sequence.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 #include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_eager_reference_delegate.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
@@ -28,14 +38,83 @@
 #include "Firestore/core/src/firebase/firestore/local/reference_delegate.h"
 #include "Firestore/core/src/firebase/firestore/local/sizer.h"
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/message.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
+namespace {
 
 using auth::User;
+using model::DocumentKey;
 using model::ListenSequenceNumber;
+using model::MaybeDocument;
+using model::MutationBatch;
+using model::SnapshotVersion;
+using model::TargetId;
+using nanopb::ByteString;
+using nanopb::MakeStdString;
+using nanopb::MakeStringView;
+using nanopb::Message;
+using nanopb::StringReader;
+using util::OrderedCode;
+using util::Path;
+using util::Status;
+using util::StatusOr;
+
+/**
+ * Snapshots are stored in DocumentSnapshot files, whose generation holds the
+ * version of the format of their records.
+ */
+constexpr int64_t kSnapshotFormatVersion = 1;
+
+/**
+ * The types of the records of a snapshot. Target documents belong to the
+ * target before them, and mutation batches to the mutation queue before them.
+ */
+enum class RecordType : uint64_t {
+  TargetGlobals = 1,
+  Target = 2,
+  TargetDocument = 3,
+  MutationQueue = 4,
+  MutationBatch = 5,
+  Document = 6,
+};
+
+Status CorruptSnapshot(absl::string_view what) {
+  return Status(Error::kDataLoss,
+                absl::StrCat("Memory cache snapshot is corrupt: ", what));
+}
+
+void WriteVersion(std::string* dest, const SnapshotVersion& version) {
+  OrderedCode::WriteSignedNumIncreasing(dest, version.timestamp().seconds());
+  OrderedCode::WriteSignedNumIncreasing(dest,
+                                        version.timestamp().nanoseconds());
+}
+
+bool ReadVersion(absl::string_view* src, SnapshotVersion* version) {
+  int64_t seconds = 0;
+  int64_t nanos = 0;
+  if (!OrderedCode::ReadSignedNumIncreasing(src, &seconds) ||
+      !OrderedCode::ReadSignedNumIncreasing(src, &nanos) || nanos < 0 ||
+      nanos >= 1000000000) {
+    return false;
+  }
+  *version = SnapshotVersion(Timestamp(seconds, static_cast<int32_t>(nanos)));
+  return true;
+}
+
+}  // namespace
 
 std::unique_ptr<MemoryPersistence>
 MemoryPersistence::WithEagerGarbageCollector() {
@@ -49,6 +128,7 @@ MemoryPersistence::WithEagerGarbageCollector() {
 std::unique_ptr<MemoryPersistence> MemoryPersistence::WithLruGarbageCollector(
     LruParams lru_params, std::unique_ptr<Sizer> sizer) {
   std::unique_ptr<MemoryPersistence> persistence(new MemoryPersistence());
+  persistence->sizer_ = sizer.get();
   auto delegate = absl::make_unique<MemoryLruReferenceDelegate>(
       persistence.get(), lru_params, std::move(sizer));
   persistence->set_reference_delegate(std::move(delegate));
@@ -56,7 +136,10 @@ std::unique_ptr<MemoryPersistence> MemoryPersistence::WithLruGarbageCollector(
 }
 
 MemoryPersistence::MemoryPersistence()
-    : target_cache_(this), remote_document_cache_(this), started_(true) {
+    : target_cache_(this),
+      remote_document_cache_(this),
+      index_manager_(this),
+      started_(true) {
 }
 
 MemoryPersistence::~MemoryPersistence() = default;
@@ -98,6 +181,10 @@ MemoryRemoteDocumentCache* MemoryPersistence::remote_document_cache() {
   return &remote_document_cache_;
 }
 
+size_t MemoryPersistence::ReleaseMemory() {
+  return remote_document_cache_.ReleaseMemory();
+}
+
 MemoryIndexManager* MemoryPersistence::index_manager() {
   return &index_manager_;
 }
@@ -106,6 +193,202 @@ ReferenceDelegate* MemoryPersistence::reference_delegate() {
   return reference_delegate_.get();
 }
 
+Status MemoryPersistence::SaveSnapshot(const Path& path,
+                                       const LocalSerializer& serializer) {
+  DocumentSnapshotWriter writer(path, kSnapshotFormatVersion);
+  uint64_t sequence = 0;
+  auto write = [&](RecordType type, absl::string_view payload) {
+    // The sequence number keeps the keys of the file in increasing order, so
+    // records are read back in the order they were written.
+    std::string key;
+    OrderedCode::WriteNumIncreasing(&key, sequence++);
+    OrderedCode::WriteNumIncreasing(&key, static_cast<uint64_t>(type));
+    writer.Add(key, payload);
+  };
+
+  std::string globals;
+  OrderedCode::WriteSignedNumIncreasing(&globals,
+                                        target_cache_.highest_target_id());
+  OrderedCode::WriteSignedNumIncreasing(
+      &globals, target_cache_.highest_listen_sequence_number());
+  WriteVersion(&globals, target_cache_.GetLastRemoteSnapshotVersion());
+  write(RecordType::TargetGlobals, globals);
+
+  target_cache_.EnumerateTargets([&](const TargetData& target_data) {
+    write(RecordType::Target,
+          MakeStdString(serializer.EncodeTargetData(target_data)));
+    for (const DocumentKey& key :
+         target_cache_.GetMatchingKeys(target_data.target_id())) {
+      write(RecordType::TargetDocument, key.path().CanonicalString());
+    }
+  });
+
+  for (const auto& entry : mutation_queues_) {
+    const User& user = entry.first;
+    MemoryMutationQueue* queue = entry.second.get();
+
+    std::string queue_record;
+    OrderedCode::WriteNumIncreasing(&queue_record, user.is_authenticated());
+    OrderedCode::WriteString(&queue_record, user.uid());
+    OrderedCode::WriteTrailingString(
+        &queue_record, MakeStringView(queue->GetLastStreamToken()));
+    write(RecordType::MutationQueue, queue_record);
+
+    for (const MutationBatch& batch : queue->AllMutationBatches()) {
+      write(RecordType::MutationBatch,
+            MakeStdString(serializer.EncodeMutationBatch(batch)));
+    }
+  }
+
+  std::string document_record;
+  remote_document_cache_.EnumerateEncoded(
+      serializer,
+      [&](absl::string_view encoded, const SnapshotVersion& read_time) {
+        document_record.clear();
+        WriteVersion(&document_record, read_time);
+        document_record.append(encoded.data(), encoded.size());
+        write(RecordType::Document, document_record);
+      });
+
+  return writer.Finish();
+}
+
+Status MemoryPersistence::LoadSnapshot(const Path& path,
+                                       const LocalSerializer& serializer) {
+  StatusOr<std::unique_ptr<DocumentSnapshot>> opened =
+      DocumentSnapshot::Open(path);
+  if (!opened.ok()) {
+    return opened.status();
+  }
+  std::unique_ptr<DocumentSnapshot> snapshot = std::move(opened).ValueOrDie();
+  if (snapshot->generation() != kSnapshotFormatVersion) {
+    return CorruptSnapshot("unsupported format version");
+  }
+
+  struct QueueRecord {
+    User user;
+    ByteString last_stream_token;
+    std::vector<MutationBatch> batches;
+  };
+
+  // Decode all records before changing any state, so that a corrupt file
+  // leaves the persistence empty.
+  TargetId highest_target_id = 0;
+  ListenSequenceNumber highest_sequence_number = 0;
+  SnapshotVersion last_remote_snapshot_version;
+  std::vector<std::pair<TargetData, model::DocumentKeySet>> targets;
+  std::vector<QueueRecord> queues;
+  std::vector<std::pair<MaybeDocument, SnapshotVersion>> documents;
+
+  for (size_t i = 0; i < snapshot->size(); ++i) {
+    absl::string_view key = snapshot->key(i);
+    absl::string_view payload = snapshot->value(i);
+    uint64_t sequence = 0;
+    uint64_t type = 0;
+    if (!OrderedCode::ReadNumIncreasing(&key, &sequence) ||
+        !OrderedCode::ReadNumIncreasing(&key, &type)) {
+      return CorruptSnapshot("invalid record key");
+    }
+
+    switch (static_cast<RecordType>(type)) {
+      case RecordType::TargetGlobals: {
+        int64_t target_id = 0;
+        if (!OrderedCode::ReadSignedNumIncreasing(&payload, &target_id) ||
+            !OrderedCode::ReadSignedNumIncreasing(&payload,
+                                                  &highest_sequence_number) ||
+            !ReadVersion(&payload, &last_remote_snapshot_version)) {
+          return CorruptSnapshot("invalid target globals");
+        }
+        highest_target_id = static_cast<TargetId>(target_id);
+        break;
+      }
+
+      case RecordType::Target: {
+        StringReader reader{payload};
+        auto message = Message<firestore_client_Target>::TryParse(&reader);
+        TargetData target_data = serializer.DecodeTargetData(&reader, *message);
+        if (!reader.ok()) return reader.status();
+        targets.emplace_back(std::move(target_data), model::DocumentKeySet{});
+        break;
+      }
+
+      case RecordType::TargetDocument: {
+        if (targets.empty()) {
+          return CorruptSnapshot("target document without target");
+        }
+        model::DocumentKeySet& keys = targets.back().second;
+        keys = keys.insert(DocumentKey::FromPathString(std::string(payload)));
+        break;
+      }
+
+      case RecordType::MutationQueue: {
+        uint64_t authenticated = 0;
+        std::string uid;
+        std::string token;
+        if (!OrderedCode::ReadNumIncreasing(&payload, &authenticated) ||
+            !OrderedCode::ReadString(&payload, &uid) ||
+            !OrderedCode::ReadTrailingString(&payload, &token)) {
+          return CorruptSnapshot("invalid mutation queue");
+        }
+        User user = authenticated ? User(std::move(uid)) : User();
+        queues.push_back({std::move(user), ByteString(token), {}});
+        break;
+      }
+
+      case RecordType::MutationBatch: {
+        if (queues.empty()) {
+          return CorruptSnapshot("mutation batch without mutation queue");
+        }
+        StringReader reader{payload};
+        auto message = Message<firestore_client_WriteBatch>::TryParse(&reader);
+        MutationBatch batch = serializer.DecodeMutationBatch(&reader, *message);
+        if (!reader.ok()) return reader.status();
+        queues.back().batches.push_back(std::move(batch));
+        break;
+      }
+
+      case RecordType::Document: {
+        SnapshotVersion read_time;
+        if (!ReadVersion(&payload, &read_time)) {
+          return CorruptSnapshot("invalid document read time");
+        }
+        StringReader reader{payload};
+        auto message =
+            Message<firestore_client_MaybeDocument>::TryParseWithArena(&reader);
+        MaybeDocument document =
+            serializer.DecodeMaybeDocument(&reader, *message);
+        if (!reader.ok()) return reader.status();
+        if (!documents.empty() &&
+            !(documents.back().first.key() < document.key())) {
+          return CorruptSnapshot("documents out of order");
+        }
+        documents.emplace_back(std::move(document), read_time);
+        break;
+      }
+
+      default:
+        return CorruptSnapshot("unknown record type");
+    }
+  }
+
+  Run("Load snapshot", [&] {
+    target_cache_.RestoreHighestIds(highest_target_id,
+                                    highest_sequence_number);
+    target_cache_.SetLastRemoteSnapshotVersion(last_remote_snapshot_version);
+    remote_document_cache_.AddSorted(documents);
+    for (const auto& target : targets) {
+      target_cache_.AddTarget(target.first);
+      target_cache_.AddMatchingKeys(target.second, target.first.target_id());
+    }
+    for (QueueRecord& queue : queues) {
+      GetMutationQueueForUser(queue.user)
+          ->AddBatches(std::move(queue.batches),
+                       std::move(queue.last_stream_token));
+    }
+  });
+  return Status::OK();
+}
+
 void MemoryPersistence::RunInternal(absl::string_view label,
                                     std::function<void()> block) {
   TransactionGuard guard(reference_delegate_.get(), label);
@@ -29,12 +29,15 @@
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_target_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
 struct LruParams;
+class LocalSerializer;
 class MemoryIndexManager;
 class MemoryMutationQueue;
 class MemoryRemoteDocumentCache;
@@ -67,6 +70,35 @@ class MemoryPersistence : public Persistence {
     return mutation_queues_;
   }
 
+  /**
+   * The sizer the caches use to keep a running total of their size in bytes,
+   * or nullptr if sizes aren't tracked (as with eager garbage collection).
+   */
+  const Sizer* sizer() const {
+    return sizer_;
+  }
+
+  /**
+   * Writes the documents, targets and mutation queues to a snapshot file at
+   * `path`, which replaces any previous snapshot once it's complete. The file
+   * is written in a single pass on the calling thread, so it's consistent as
+   * long as no transaction runs on another thread meanwhile.
+   */
+  util::Status SaveSnapshot(const util::Path& path,
+                            const LocalSerializer& serializer);
+
+  /**
+   * Fills the empty persistence from a snapshot file written by
+   * `SaveSnapshot`, so that a restarted process begins with the cache of the
+   * previous one. The file is memory-mapped, and the documents are read in key
+   * order and built into the document cache in a single pass.
+   *
+   * Returns an error and leaves the persistence empty if the file is missing
+   * or can't be read.
+   */
+  util::Status LoadSnapshot(const util::Path& path,
+                            const LocalSerializer& serializer);
+
   // MARK: Persistence overrides
 
   model::ListenSequenceNumber current_sequence_number() const override;
@@ -83,6 +115,8 @@ class MemoryPersistence : public Persistence {
 
   ReferenceDelegate* reference_delegate() override;
 
+  size_t ReleaseMemory() override;
+
  protected:
   void RunInternal(absl::string_view label,
                    std::function<void()> block) override;
@@ -115,6 +149,9 @@ class MemoryPersistence : public Persistence {
 
   std::unique_ptr<ReferenceDelegate> reference_delegate_;
 
+  // Owned by the reference delegate.
+  const Sizer* sizer_ = nullptr;
+
   bool started_ = false;
 };
 
@@ -16,19 +16,34 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_lru_reference_delegate.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/sizer.h"
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/message.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/memory/memory.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+using core::FieldFilter;
+using core::Filter;
+using core::OrderBy;
 using core::Query;
 using model::Document;
+using model::FieldPath;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
@@ -36,7 +51,29 @@ using model::ListenSequenceNumber;
 using model::MaybeDocument;
 using model::MaybeDocumentMap;
 using model::OptionalMaybeDocumentMap;
+using model::ResourcePath;
 using model::SnapshotVersion;
+using nanopb::MakeStdString;
+using nanopb::Message;
+using nanopb::StringReader;
+
+namespace {
+
+/**
+ * The number of filtered queries a collection must receive without
+ * intervening writes before a columnar snapshot of it is built. Building the
+ * snapshot costs about as much as a single scan, so this avoids paying for it
+ * on collections that are only queried once between writes.
+ */
+constexpr int kHotCollectionQueryCount = 2;
+
+/**
+ * The arena of compact storage is only compacted once removed documents take
+ * up this many bytes, and more than the documents still in the cache.
+ */
+constexpr size_t kMinArenaGarbageBytes = 1024 * 1024;
+
+}  // namespace
 
 MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
     MemoryPersistence* persistence) {
@@ -45,20 +82,101 @@ MemoryRemoteDocumentCache::MemoryRemoteDocumentCache(
 
 void MemoryRemoteDocumentCache::Add(const MaybeDocument& document,
                                     const model::SnapshotVersion& read_time) {
-  docs_ = docs_.insert(document.key(), std::make_pair(document, read_time));
+  RemoveFieldIndexEntries(document.key());
+  UntrackByteSize(document.key());
+  docs_ = docs_.insert(document.key(), MakeEntry(document, read_time));
+  MaybeCompactArena();
+  InvalidateColumns(document.key());
+  IndexCollectionGroup(document.key());
 
-  persistence_->index_manager()->AddToCollectionParentIndex(
-      document.key().path().PopLast());
+  MemoryIndexManager* index_manager = persistence_->index_manager();
+  index_manager->AddIndexEntries(document);
+  index_manager->AddToCollectionParentIndex(document.key().path().PopLast());
+}
+
+void MemoryRemoteDocumentCache::AddSorted(
+    const std::vector<std::pair<MaybeDocument, SnapshotVersion>>& documents) {
+  HARD_ASSERT(docs_.empty(), "Documents must be added to an empty cache");
+
+  std::vector<std::pair<DocumentKey, Entry>> entries;
+  entries.reserve(documents.size());
+  ResourcePath last_parent;
+  for (const auto& document : documents) {
+    const DocumentKey& key = document.first.key();
+    entries.emplace_back(key, MakeEntry(document.first, document.second));
+    IndexCollectionGroup(key);
+    persistence_->index_manager()->AddIndexEntries(document.first);
+
+    // Documents of the same collection are mostly adjacent, so only index the
+    // parent of a document when it differs from the previous one's.
+    ResourcePath parent = key.path().PopLast();
+    if (parent != last_parent) {
+      persistence_->index_manager()->AddToCollectionParentIndex(parent);
+      last_parent = std::move(parent);
+    }
+  }
+  docs_ = decltype(docs_)::FromSortedRange(entries.begin(), entries.end());
+}
+
+void MemoryRemoteDocumentCache::EnumerateEncoded(
+    const LocalSerializer& serializer,
+    const EncodedDocumentCallback& callback) const {
+  for (const auto& kv : docs_) {
+    const Entry& entry = kv.second;
+    if (serializer_) {
+      callback(absl::string_view{arena_}.substr(entry.offset, entry.size),
+               entry.read_time);
+    } else {
+      callback(MakeStdString(serializer.EncodeMaybeDocument(entry.document)),
+               entry.read_time);
+    }
+  }
+}
+
+MemoryRemoteDocumentCache::Entry MemoryRemoteDocumentCache::MakeEntry(
+    const MaybeDocument& document, const SnapshotVersion& read_time) {
+  Entry entry;
+  entry.is_document = document.is_document();
+  entry.read_time = read_time;
+  if (serializer_) {
+    absl::optional<std::string> encoded =
+        serializer_->EncodeReceivedDocument(document);
+    if (!encoded) {
+      encoded = MakeStdString(serializer_->EncodeMaybeDocument(document));
+    }
+    entry.offset = arena_.size();
+    entry.size = encoded->size();
+    arena_ += *encoded;
+    byte_size_ += static_cast<int64_t>(entry.size);
+  } else {
+    if (const Sizer* sizer = persistence_->sizer()) {
+      byte_size_ += sizer->CalculateByteSize(document);
+    }
+    // Documents received from Watch keep the bytes they were received as for
+    // persistent caches to write; don't hold on to those in memory.
+    entry.document = document;
+    if (document.is_document() && Document(document).proto().has_value()) {
+      Document doc(document);
+      entry.document = Document(doc.data(), doc.key(), doc.version(),
+                                doc.document_state());
+    }
+  }
+  return entry;
 }
 
 void MemoryRemoteDocumentCache::Remove(const DocumentKey& key) {
+  RemoveFieldIndexEntries(key);
+  UntrackByteSize(key);
   docs_ = docs_.erase(key);
+  MaybeCompactArena();
+  InvalidateColumns(key);
+  UnindexCollectionGroup(key);
 }
 
 absl::optional<MaybeDocument> MemoryRemoteDocumentCache::Get(
     const DocumentKey& key) {
   const auto& entry = docs_.get(key);
-  return entry ? entry->first : absl::optional<MaybeDocument>();
+  return entry ? ReadDocument(*entry) : absl::optional<MaybeDocument>();
 }
 
 OptionalMaybeDocumentMap MemoryRemoteDocumentCache::GetAll(
@@ -79,7 +197,16 @@ DocumentMap MemoryRemoteDocumentCache::GetMatching(
       !query.IsCollectionGroupQuery(),
       "CollectionGroup queries should be handled in LocalDocumentsView");
 
+  if (columnar_snapshots_enabled_ && !query.IsDocumentQuery() &&
+      !query.filters().empty()) {
+    MemoryCollectionColumns* columns = GetColumns(query.path());
+    if (columns) {
+      return GetMatchingFromColumns(query, since_read_time, columns);
+    }
+  }
+
   DocumentMap results;
+  int64_t documents_scanned = 0;
 
   // Documents are ordered by key, so we can use a prefix scan to narrow down
   // the documents we need to match the query against.
@@ -89,21 +216,50 @@ DocumentMap MemoryRemoteDocumentCache::GetMatching(
     if (!query.path().IsPrefixOf(key.path())) {
       break;
     }
-    const MaybeDocument& maybe_doc = it->second.first;
-    if (!maybe_doc.is_document()) {
+    const Entry& entry = it->second;
+    if (!entry.is_document || entry.read_time <= since_read_time) {
       continue;
     }
 
-    const SnapshotVersion& read_time = it->second.second;
-    if (read_time <= since_read_time) {
+    ++documents_scanned;
+    Document doc(ReadDocument(entry));
+    if (query.Matches(doc)) {
+      results = results.insert(key, std::move(doc));
+    }
+  }
+  persistence_->metrics()->RecordDocumentsScanned(documents_scanned);
+  return results;
+}
+
+absl::optional<DocumentMap>
+MemoryRemoteDocumentCache::GetMatchingCollectionGroup(
+    const Query& query, const SnapshotVersion& since_read_time) {
+  HARD_ASSERT(query.IsCollectionGroupQuery(),
+              "GetMatchingCollectionGroup needs a collection group query");
+
+  DocumentMap results;
+  auto group = collection_groups_.find(*query.collection_group());
+  if (group == collection_groups_.end()) {
+    return results;
+  }
+
+  int64_t documents_scanned = 0;
+  for (const DocumentKey& key : group->second) {
+    if (!query.path().IsPrefixOf(key.path())) {
+      continue;
+    }
+    const Entry& entry = docs_.find(key)->second;
+    if (!entry.is_document || entry.read_time <= since_read_time) {
       continue;
     }
 
-    Document doc(maybe_doc);
+    ++documents_scanned;
+    Document doc(ReadDocument(entry));
     if (query.Matches(doc)) {
       results = results.insert(key, std::move(doc));
     }
   }
+  persistence_->metrics()->RecordDocumentsScanned(documents_scanned);
   return results;
 }
 
@@ -115,21 +271,208 @@ std::vector<DocumentKey> MemoryRemoteDocumentCache::RemoveOrphanedDocuments(
   for (const auto& kv : docs_) {
     const DocumentKey& key = kv.first;
     if (!reference_delegate->IsPinnedAtSequenceNumber(upper_bound, key)) {
+      RemoveFieldIndexEntries(key);
+      UntrackByteSize(key);
       updated_docs = updated_docs.erase(key);
       removed.push_back(key);
+      InvalidateColumns(key);
+      UnindexCollectionGroup(key);
     }
   }
   docs_ = updated_docs;
+  MaybeCompactArena();
   return removed;
 }
 
-int64_t MemoryRemoteDocumentCache::CalculateByteSize(const Sizer& sizer) {
-  int64_t count = 0;
+void MemoryRemoteDocumentCache::UntrackByteSize(const DocumentKey& key) {
+  const Sizer* sizer = persistence_->sizer();
+  if (!sizer && !serializer_) return;
+
+  const auto& entry = docs_.get(key);
+  if (!entry) return;
+
+  if (serializer_) {
+    byte_size_ -= static_cast<int64_t>(entry->size);
+  } else {
+    byte_size_ -= sizer->CalculateByteSize(entry->document);
+  }
+}
+
+void MemoryRemoteDocumentCache::RemoveFieldIndexEntries(
+    const DocumentKey& key) {
+  MemoryIndexManager* index_manager = persistence_->index_manager();
+  if (!index_manager->HasFieldIndexes(key.path().PopLast())) return;
+
+  const auto& entry = docs_.get(key);
+  if (entry && entry->is_document) {
+    index_manager->RemoveIndexEntries(ReadDocument(*entry));
+  }
+}
+
+void MemoryRemoteDocumentCache::EnableCompactStorage(
+    LocalSerializer serializer) {
+  HARD_ASSERT(docs_.empty(),
+              "Compact storage must be enabled while the cache is empty");
+  serializer_ = absl::make_unique<LocalSerializer>(std::move(serializer));
+}
+
+MaybeDocument MemoryRemoteDocumentCache::ReadDocument(
+    const Entry& entry) const {
+  if (!serializer_) {
+    return entry.document;
+  }
+
+  StringReader reader{absl::string_view{arena_}.substr(entry.offset,
+                                                       entry.size)};
+  auto message =
+      Message<firestore_client_MaybeDocument>::TryParseWithArena(&reader);
+  MaybeDocument maybe_document =
+      serializer_->DecodeMaybeDocument(&reader, *message);
+  if (!reader.ok()) {
+    HARD_FAIL("MaybeDocument proto failed to parse: %s",
+              reader.status().ToString());
+  }
+  return maybe_document;
+}
+
+void MemoryRemoteDocumentCache::MaybeCompactArena() {
+  if (!serializer_) return;
+
+  size_t live_bytes = static_cast<size_t>(byte_size_);
+  size_t garbage_bytes = arena_.size() - live_bytes;
+  if (garbage_bytes < kMinArenaGarbageBytes || garbage_bytes < live_bytes) {
+    return;
+  }
+
+  CompactArena();
+}
+
+void MemoryRemoteDocumentCache::CompactArena() {
+  std::string arena;
+  arena.reserve(static_cast<size_t>(byte_size_));
+  std::vector<std::pair<DocumentKey, Entry>> entries;
+  entries.reserve(docs_.size());
   for (const auto& kv : docs_) {
-    const MaybeDocument& maybe_doc = kv.second.first;
-    count += sizer.CalculateByteSize(maybe_doc);
+    Entry entry = kv.second;
+    arena.append(arena_, entry.offset, entry.size);
+    entry.offset = arena.size() - entry.size;
+    entries.emplace_back(kv.first, std::move(entry));
+  }
+  docs_ = decltype(docs_)::FromSortedRange(entries.begin(), entries.end());
+  arena_ = std::move(arena);
+}
+
+size_t MemoryRemoteDocumentCache::ReleaseMemory() {
+  size_t released = 0;
+  for (const auto& kv : snapshots_) {
+    if (kv.second.columns) {
+      released += kv.second.columns->byte_size();
+    }
+  }
+  snapshots_.clear();
+
+  if (serializer_ && arena_.capacity() > static_cast<size_t>(byte_size_)) {
+    size_t capacity = arena_.capacity();
+    CompactArena();
+    if (arena_.capacity() < capacity) {
+      released += capacity - arena_.capacity();
+    }
+  }
+  return released;
+}
+
+void MemoryRemoteDocumentCache::set_columnar_snapshots_enabled(bool enabled) {
+  columnar_snapshots_enabled_ = enabled;
+  if (!enabled) {
+    snapshots_.clear();
+  }
+}
+
+MemoryCollectionColumns* MemoryRemoteDocumentCache::GetColumns(
+    const ResourcePath& collection) {
+  CollectionSnapshot& snapshot = snapshots_[collection.CanonicalString()];
+  if (snapshot.columns) {
+    return snapshot.columns.get();
+  }
+  if (++snapshot.queries < kHotCollectionQueryCount) {
+    return nullptr;
+  }
+
+  // Only documents directly in the collection can match a collection query, so
+  // the snapshot leaves out documents in subcollections.
+  auto columns = absl::make_unique<MemoryCollectionColumns>();
+  DocumentKey prefix{collection.Append("")};
+  for (auto it = docs_.lower_bound(prefix); it != docs_.end(); ++it) {
+    const DocumentKey& key = it->first;
+    if (!collection.IsPrefixOf(key.path())) {
+      break;
+    }
+    const Entry& entry = it->second;
+    if (!entry.is_document || key.path().size() != collection.size() + 1) {
+      continue;
+    }
+    columns->Add(Document(ReadDocument(entry)), entry.read_time);
+  }
+
+  snapshot.columns = std::move(columns);
+  return snapshot.columns.get();
+}
+
+void MemoryRemoteDocumentCache::IndexCollectionGroup(const DocumentKey& key) {
+  const ResourcePath& path = key.path();
+  DocumentKeySet& keys = collection_groups_[path[path.size() - 2]];
+  keys = keys.insert(key);
+}
+
+void MemoryRemoteDocumentCache::UnindexCollectionGroup(
+    const DocumentKey& key) {
+  const ResourcePath& path = key.path();
+  auto group = collection_groups_.find(path[path.size() - 2]);
+  if (group == collection_groups_.end()) return;
+
+  group->second = group->second.erase(key);
+  if (group->second.empty()) {
+    collection_groups_.erase(group);
+  }
+}
+
+void MemoryRemoteDocumentCache::InvalidateColumns(const DocumentKey& key) {
+  if (!snapshots_.empty()) {
+    snapshots_.erase(key.path().PopLast().CanonicalString());
   }
-  return count;
+}
+
+DocumentMap MemoryRemoteDocumentCache::GetMatchingFromColumns(
+    const Query& query,
+    const SnapshotVersion& since_read_time,
+    MemoryCollectionColumns* columns) {
+  std::vector<uint8_t> candidates(columns->size(), 1);
+  for (const Filter& filter : query.filters()) {
+    if (filter.IsAFieldFilter()) {
+      columns->Narrow(FieldFilter(filter), &candidates);
+    }
+  }
+  for (const OrderBy& order_by : query.explicit_order_bys()) {
+    if (order_by.field() != FieldPath::KeyFieldPath()) {
+      columns->NarrowToPresent(order_by.field(), &candidates);
+    }
+  }
+
+  DocumentMap results;
+  int64_t documents_scanned = 0;
+  for (size_t i = 0, count = columns->size(); i != count; ++i) {
+    if (columns->read_time(i) <= since_read_time) {
+      continue;
+    }
+
+    ++documents_scanned;
+    const Document& doc = columns->document(i);
+    if (candidates[i] && query.Matches(doc)) {
+      results = results.insert(doc.key(), doc);
+    }
+  }
+  persistence_->metrics()->RecordDocumentsScanned(documents_scanned);
+  return results;
 }
 
 }  // namespace local
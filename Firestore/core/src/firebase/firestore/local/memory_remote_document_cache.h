@@ -17,15 +17,24 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MEMORY_REMOTE_DOCUMENT_CACHE_H_
 
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_collection_columns.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/strings/string_view.h"
 
 namespace firebase {
 namespace firestore {
@@ -33,7 +42,6 @@ namespace local {
 
 class MemoryLruReferenceDelegate;
 class MemoryPersistence;
-class Sizer;
 
 class MemoryRemoteDocumentCache : public RemoteDocumentCache {
  public:
@@ -51,17 +59,165 @@ class MemoryRemoteDocumentCache : public RemoteDocumentCache {
       const core::Query& query,
       const model::SnapshotVersion& since_read_time) override;
 
+  /** Reads the documents of the collection group from `collection_groups_`. */
+  absl::optional<model::DocumentMap> GetMatchingCollectionGroup(
+      const core::Query& query,
+      const model::SnapshotVersion& since_read_time) override;
+
+  /**
+   * Fills the empty cache with the given documents and their read times,
+   * which must be sorted by key, building the underlying map in a single
+   * pass rather than inserting the documents one at a time.
+   */
+  void AddSorted(
+      const std::vector<std::pair<model::MaybeDocument, model::SnapshotVersion>>&
+          documents);
+
+  using EncodedDocumentCallback = std::function<void(
+      absl::string_view encoded, const model::SnapshotVersion& read_time)>;
+
+  /**
+   * Calls `callback` with each cached document, encoded as a MaybeDocument,
+   * and its read time, in key order. Documents are only encoded with
+   * `serializer` if storage isn't compact, since otherwise they already are.
+   */
+  void EnumerateEncoded(const LocalSerializer& serializer,
+                        const EncodedDocumentCallback& callback) const;
+
   std::vector<model::DocumentKey> RemoveOrphanedDocuments(
       MemoryLruReferenceDelegate* reference_delegate,
       model::ListenSequenceNumber upper_bound);
 
-  int64_t CalculateByteSize(const Sizer& sizer);
+  /**
+   * Returns the total size in bytes of the cached documents, as estimated by
+   * the persistence's sizer, or, with compact storage, the exact size of their
+   * encodings. Kept up to date as documents are added and removed, so this is
+   * O(1). Always zero if the persistence has no sizer and storage isn't
+   * compact.
+   */
+  int64_t byte_size() const {
+    return byte_size_;
+  }
+
+  /**
+   * Enables columnar snapshots of hot collections. When enabled, a collection
+   * that is queried repeatedly without intervening writes is copied into a
+   * MemoryCollectionColumns snapshot, and subsequent queries evaluate their
+   * numeric and timestamp filters over the snapshot's columns before matching
+   * the remaining documents. Disabled by default.
+   */
+  void set_columnar_snapshots_enabled(bool enabled);
+
+  /**
+   * Makes the cache keep documents encoded with the given serializer, appended
+   * to a single buffer, instead of keeping them decoded. Documents are decoded
+   * each time they are read, in exchange for taking a fraction of the memory,
+   * which suits caches that hold very many documents. Must be called while the
+   * cache is empty.
+   */
+  void EnableCompactStorage(LocalSerializer serializer);
+
+  /**
+   * Drops the columnar snapshots and, with compact storage, copies the live
+   * documents to an arena of their exact size. The documents themselves are
+   * the contents of the cache and are kept.
+   */
+  size_t ReleaseMemory() override;
 
  private:
+  struct Entry {
+    /** The document, unless storage is compact. */
+    model::MaybeDocument document;
+
+    /** The location of the encoded document in `arena_`, if compact. */
+    size_t offset = 0;
+    size_t size = 0;
+
+    bool is_document = false;
+    model::SnapshotVersion read_time;
+
+    friend bool operator==(const Entry& lhs, const Entry& rhs) {
+      return lhs.document == rhs.document && lhs.offset == rhs.offset &&
+             lhs.size == rhs.size && lhs.read_time == rhs.read_time;
+    }
+  };
+
+  struct CollectionSnapshot {
+    /** The number of filtered queries since the collection last changed. */
+    int queries = 0;
+
+    /** The snapshot, once the collection has become hot. */
+    std::unique_ptr<MemoryCollectionColumns> columns;
+  };
+
+  /**
+   * Returns the columnar snapshot of the given collection, building it if the
+   * collection has become hot, or nullptr if it has not.
+   */
+  MemoryCollectionColumns* GetColumns(const model::ResourcePath& collection);
+
+  /**
+   * Makes the entry that holds the given document, adding its size to
+   * `byte_size_` and, with compact storage, its encoding to `arena_`.
+   */
+  Entry MakeEntry(const model::MaybeDocument& document,
+                  const model::SnapshotVersion& read_time);
+
+  /**
+   * Subtracts the size of the document currently cached under the given key,
+   * if any, from `byte_size_`.
+   */
+  void UntrackByteSize(const model::DocumentKey& key);
+
+  /**
+   * Removes the field index entries of the document currently cached under
+   * the given key, if any, so that they don't outlive the document.
+   */
+  void RemoveFieldIndexEntries(const model::DocumentKey& key);
+
+  /** Returns the document in the given entry, decoding it if necessary. */
+  model::MaybeDocument ReadDocument(const Entry& entry) const;
+
+  /**
+   * Copies the encoded documents still in the cache to a new arena once
+   * enough space in the current one is taken up by removed documents.
+   */
+  void MaybeCompactArena();
+  void CompactArena();
+
+  /** Adds the given key to, or removes it from, `collection_groups_`. */
+  void IndexCollectionGroup(const model::DocumentKey& key);
+  void UnindexCollectionGroup(const model::DocumentKey& key);
+
+  /** Discards the snapshot of the collection containing the given key. */
+  void InvalidateColumns(const model::DocumentKey& key);
+
+  model::DocumentMap GetMatchingFromColumns(
+      const core::Query& query,
+      const model::SnapshotVersion& since_read_time,
+      MemoryCollectionColumns* columns);
+
   /** Underlying cache of documents and their read times. */
-  immutable::SortedMap<model::DocumentKey,
-                       std::pair<model::MaybeDocument, model::SnapshotVersion>>
-      docs_;
+  immutable::SortedMap<model::DocumentKey, Entry> docs_;
+
+  /** The keys in `docs_`, grouped by the ID of their collection. */
+  std::unordered_map<std::string, model::DocumentKeySet> collection_groups_;
+
+  /** Set if storage is compact. */
+  std::unique_ptr<LocalSerializer> serializer_;
+
+  /**
+   * The encodings of all documents added with compact storage, including
+   * those since replaced or removed.
+   */
+  std::string arena_;
+
+  int64_t byte_size_ = 0;
+
+  bool columnar_snapshots_enabled_ = false;
+
+  /** Snapshots keyed by the canonical string of the collection path. */
+  std::unordered_map<std::string, CollectionSnapshot> snapshots_;
 
   // This instance is owned by MemoryPersistence; avoid a retain cycle.
   MemoryPersistence* persistence_;
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/local/memory_target_cache.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
@@ -44,6 +45,10 @@ MemoryTargetCache::MemoryTargetCache(MemoryPersistence* persistence)
 }
 
 void MemoryTargetCache::AddTarget(const TargetData& target_data) {
+  if (const Sizer* sizer = persistence_->sizer()) {
+    UntrackByteSize(target_data.target());
+    byte_size_ += sizer->CalculateByteSize(target_data);
+  }
   targets_[target_data.target()] = target_data;
   if (target_data.target_id() > highest_target_id_) {
     highest_target_id_ = target_data.target_id();
@@ -59,6 +64,7 @@ void MemoryTargetCache::UpdateTarget(const TargetData& target_data) {
 }
 
 void MemoryTargetCache::RemoveTarget(const TargetData& target_data) {
+  UntrackByteSize(target_data.target());
   targets_.erase(target_data.target());
   references_.RemoveReferences(target_data.target_id());
 }
@@ -91,6 +97,7 @@ int MemoryTargetCache::RemoveTargets(
   }
 
   for (const Target* element : to_remove) {
+    UntrackByteSize(*element);
     targets_.erase(*element);
   }
   return static_cast<int>(to_remove.size());
@@ -120,12 +127,14 @@ bool MemoryTargetCache::Contains(const DocumentKey& key) {
   return references_.ContainsKey(key);
 }
 
-int64_t MemoryTargetCache::CalculateByteSize(const Sizer& sizer) {
-  int64_t count = 0;
-  for (const auto& kv : targets_) {
-    count += sizer.CalculateByteSize(kv.second);
+void MemoryTargetCache::UntrackByteSize(const Target& target) {
+  const Sizer* sizer = persistence_->sizer();
+  if (!sizer) return;
+
+  auto iter = targets_.find(target);
+  if (iter != targets_.end()) {
+    byte_size_ -= sizer->CalculateByteSize(iter->second);
   }
-  return count;
 }
 
 const SnapshotVersion& MemoryTargetCache::GetLastRemoteSnapshotVersion() const {
@@ -136,6 +145,14 @@ void MemoryTargetCache::SetLastRemoteSnapshotVersion(SnapshotVersion version) {
   last_remote_snapshot_version_ = std::move(version);
 }
 
+void MemoryTargetCache::RestoreHighestIds(
+    TargetId highest_target_id,
+    ListenSequenceNumber highest_listen_sequence_number) {
+  highest_target_id_ = std::max(highest_target_id_, highest_target_id);
+  highest_listen_sequence_number_ = std::max(highest_listen_sequence_number_,
+                                             highest_listen_sequence_number);
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -34,7 +34,6 @@ namespace firestore {
 namespace local {
 
 class MemoryPersistence;
-class Sizer;
 
 class MemoryTargetCache : public TargetCache {
  public:
@@ -67,7 +66,14 @@ class MemoryTargetCache : public TargetCache {
   bool Contains(const model::DocumentKey& key) override;
 
   // Other methods and accessors
-  int64_t CalculateByteSize(const Sizer& sizer);
+
+  /**
+   * Returns the total size in bytes of the cached targets, as estimated by the
+   * persistence's sizer, or zero if the persistence has no sizer.
+   */
+  int64_t byte_size() const {
+    return byte_size_;
+  }
 
   size_t size() const override {
     return targets_.size();
@@ -85,10 +91,21 @@ class MemoryTargetCache : public TargetCache {
 
   void SetLastRemoteSnapshotVersion(model::SnapshotVersion version) override;
 
+  /**
+   * Raises the highest target ID and sequence number to the given ones, such
+   * as those recorded in a snapshot, which may be those of removed targets.
+   */
+  void RestoreHighestIds(
+      model::TargetId highest_target_id,
+      model::ListenSequenceNumber highest_listen_sequence_number);
+
  private:
   // This instance is owned by MemoryPersistence.
   MemoryPersistence* persistence_;
 
+  /** Subtracts the size of the cached entry for `target`, if any. */
+  void UntrackByteSize(const core::Target& target);
+
   /** The highest sequence number encountered */
   model::ListenSequenceNumber highest_listen_sequence_number_;
   /** The highest numbered target ID encountered. */
@@ -99,6 +116,9 @@ class MemoryTargetCache : public TargetCache {
   /** Maps a target to the data about that query. */
   std::unordered_map<core::Target, TargetData> targets_;
 
+  /** The running total returned by `byte_size()`. */
+  int64_t byte_size_ = 0;
+
   /**
    * A ordered bidirectional mapping between documents and the remote target
    * IDs.
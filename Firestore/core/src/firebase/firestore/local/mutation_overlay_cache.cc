@@ -0,0 +1,168 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/mutation_overlay_cache.h"
+
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/model/transform_mutation.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::DocumentKey;
+using model::MaybeDocument;
+using model::Mutation;
+using model::MutationBatch;
+using model::PatchMutation;
+using model::Precondition;
+using model::ResourcePath;
+using model::TransformMutation;
+
+absl::optional<MaybeDocument> MutationOverlayCache::Overlay::Apply(
+    const absl::optional<MaybeDocument>& base_doc) const {
+  if (has_memoized_view_ && memoized_base_doc_ == base_doc) {
+    return memoized_view_;
+  }
+
+  absl::optional<MaybeDocument> doc = base_doc;
+  for (const Write& write : writes_) {
+    doc = write.mutation.ApplyToLocalView(doc, doc, write.local_write_time);
+  }
+
+  has_memoized_view_ = true;
+  memoized_base_doc_ = base_doc;
+  memoized_view_ = doc;
+  return doc;
+}
+
+bool MutationOverlayCache::Overlay::CombineWithLastWrite(
+    const Mutation& mutation) {
+  if (writes_.empty() ||
+      writes_.back().mutation.type() != Mutation::Type::Transform) {
+    return false;
+  }
+
+  if (mutation.type() == Mutation::Type::Patch) {
+    // An update that only transforms fields is written as an empty patch
+    // followed by a transform. After a transform, which has the same
+    // precondition, the empty patch doesn't change the local view, so it can
+    // be dropped to bring the transforms together.
+    PatchMutation patch(mutation);
+    return patch.mask().size() == 0 &&
+           patch.precondition() == Precondition::Exists(true);
+  }
+  if (mutation.type() != Mutation::Type::Transform) {
+    return false;
+  }
+
+  absl::optional<TransformMutation> combined =
+      TransformMutation(writes_.back().mutation)
+          .CombineForLocalView(TransformMutation(mutation));
+  if (!combined) {
+    return false;
+  }
+
+  // Increments and array unions don't depend on the local write time.
+  writes_.back().mutation = *std::move(combined);
+  return true;
+}
+
+const MutationOverlayCache::CollectionOverlays* MutationOverlayCache::Find(
+    const ResourcePath& collection_path, uint64_t change_count) {
+  Validate(change_count);
+  auto found = overlays_.find(collection_path);
+  return found != overlays_.end() ? &found->second : nullptr;
+}
+
+const MutationOverlayCache::CollectionOverlays& MutationOverlayCache::Record(
+    const ResourcePath& collection_path,
+    uint64_t change_count,
+    const std::vector<MutationBatch>& batches) {
+  Validate(change_count);
+  CollectionOverlays& overlays = overlays_[collection_path];
+  // Only record documents belonging to the collection.
+  RecordOverlays(
+      batches,
+      [&](const DocumentKey& key) {
+        return collection_path.IsImmediateParentOf(key.path());
+      },
+      &overlays);
+  return overlays;
+}
+
+const MutationOverlayCache::CollectionOverlays*
+MutationOverlayCache::FindGroup(const std::string& collection_id,
+                                uint64_t change_count) {
+  Validate(change_count);
+  auto found = group_overlays_.find(collection_id);
+  return found != group_overlays_.end() ? &found->second : nullptr;
+}
+
+const MutationOverlayCache::CollectionOverlays&
+MutationOverlayCache::RecordGroup(const std::string& collection_id,
+                                  uint64_t change_count,
+                                  const std::vector<MutationBatch>& batches) {
+  Validate(change_count);
+  CollectionOverlays& overlays = group_overlays_[collection_id];
+  RecordOverlays(
+      batches,
+      [&](const DocumentKey& key) {
+        return key.HasCollectionId(collection_id);
+      },
+      &overlays);
+  return overlays;
+}
+
+void MutationOverlayCache::Validate(uint64_t change_count) {
+  if (change_count != change_count_) {
+    overlays_.clear();
+    group_overlays_.clear();
+    change_count_ = change_count;
+  }
+}
+
+template <typename Predicate>
+void MutationOverlayCache::RecordOverlays(
+    const std::vector<MutationBatch>& batches,
+    const Predicate& belongs,
+    CollectionOverlays* overlays) {
+  overlays->clear();
+  for (const MutationBatch& batch : batches) {
+    for (const Mutation& mutation : batch.mutations()) {
+      if (!belongs(mutation.key())) {
+        continue;
+      }
+
+      Overlay& overlay = (*overlays)[mutation.key()];
+      if (mutation.type() == Mutation::Type::Patch) {
+        overlay.needs_base_document_ = true;
+      }
+      if (!overlay.CombineWithLastWrite(mutation)) {
+        overlay.writes_.push_back({mutation, batch.local_write_time()});
+      }
+    }
+  }
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MUTATION_OVERLAY_CACHE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MUTATION_OVERLAY_CACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Caches, per collection and per collection group, the pending mutations of
+ * each document in the collection, so that LocalDocumentsView doesn't have to
+ * read every mutation batch that affects the collection each time a query
+ * runs.
+ *
+ * The overlays of a collection are recorded from the mutation batches that
+ * affect it and stay valid until a batch is added to or removed from the
+ * mutation queue, as reported by `MutationQueue::GetChangeCount()`. Each
+ * overlay also remembers the local view it last computed, which is reused for
+ * as long as the document's remote state doesn't change.
+ */
+class MutationOverlayCache {
+ public:
+  /** The pending mutations of a single document. */
+  class Overlay {
+   public:
+    /**
+     * Returns true if the local view depends on the remote state of the
+     * document, i.e. if any of the mutations is a patch.
+     */
+    bool needs_base_document() const {
+      return needs_base_document_;
+    }
+
+    /**
+     * Returns the local view of the document after applying the mutations to
+     * `base_doc`, the document's remote state (if known).
+     */
+    absl::optional<model::MaybeDocument> Apply(
+        const absl::optional<model::MaybeDocument>& base_doc) const;
+
+   private:
+    friend class MutationOverlayCache;
+
+    struct Write {
+      model::Mutation mutation;
+      Timestamp local_write_time;
+    };
+
+    /**
+     * Folds the given mutation into the last write if that is a transform the
+     * mutation can be combined with, so that a run of increments to the same
+     * counter is applied as a single increment however many of them are
+     * pending. Returns false if the mutation must be added as a write of its
+     * own.
+     */
+    bool CombineWithLastWrite(const model::Mutation& mutation);
+
+    std::vector<Write> writes_;
+    bool needs_base_document_ = false;
+
+    mutable bool has_memoized_view_ = false;
+    mutable absl::optional<model::MaybeDocument> memoized_base_doc_;
+    mutable absl::optional<model::MaybeDocument> memoized_view_;
+  };
+
+  using CollectionOverlays = std::map<model::DocumentKey, Overlay>;
+
+  /**
+   * Returns the overlays of the documents in the given collection, or nullptr
+   * if they haven't been recorded since the mutation queue last changed.
+   *
+   * @param change_count The current `MutationQueue::GetChangeCount()`.
+   */
+  const CollectionOverlays* Find(const model::ResourcePath& collection_path,
+                                 uint64_t change_count);
+
+  /**
+   * Records the overlays of the documents in the given collection.
+   *
+   * @param change_count The current `MutationQueue::GetChangeCount()`.
+   * @param batches All mutation batches that affect the collection, in batch
+   *     order.
+   */
+  const CollectionOverlays& Record(
+      const model::ResourcePath& collection_path,
+      uint64_t change_count,
+      const std::vector<model::MutationBatch>& batches);
+
+  /**
+   * Returns the overlays of the documents in all collections with the given
+   * ID, or nullptr if they haven't been recorded since the mutation queue last
+   * changed.
+   *
+   * @param change_count The current `MutationQueue::GetChangeCount()`.
+   */
+  const CollectionOverlays* FindGroup(const std::string& collection_id,
+                                      uint64_t change_count);
+
+  /**
+   * Records the overlays of the documents in all collections with the given
+   * ID.
+   *
+   * @param change_count The current `MutationQueue::GetChangeCount()`.
+   * @param batches All mutation batches in the queue, in batch order.
+   */
+  const CollectionOverlays& RecordGroup(
+      const std::string& collection_id,
+      uint64_t change_count,
+      const std::vector<model::MutationBatch>& batches);
+
+ private:
+  /** Drops all overlays if the mutation queue changed since they were made. */
+  void Validate(uint64_t change_count);
+
+  /**
+   * Replaces `overlays` with the mutations in `batches` of the documents whose
+   * keys `belongs` accepts.
+   */
+  template <typename Predicate>
+  static void RecordOverlays(const std::vector<model::MutationBatch>& batches,
+                             const Predicate& belongs,
+                             CollectionOverlays* overlays);
+
+  std::map<model::ResourcePath, CollectionOverlays> overlays_;
+  std::map<std::string, CollectionOverlays> group_overlays_;
+  uint64_t change_count_ = 0;
+};
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MUTATION_OVERLAY_CACHE_H_
@@ -17,9 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MUTATION_QUEUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_MUTATION_QUEUE_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "absl/types/optional.h"
 
@@ -79,6 +82,13 @@ class MutationQueue {
    */
   virtual void RemoveMutationBatch(const model::MutationBatch& batch) = 0;
 
+  /**
+   * Replaces the last batch in the queue with the given batch, which has the
+   * same batch ID and affects the same documents. Used to compact a newer
+   * write into a batch that hasn't been sent yet.
+   */
+  virtual void ReplaceLastMutationBatch(const model::MutationBatch& batch) = 0;
+
   /** Gets all mutation batches in the mutation queue. */
   // TODO(mikelehen): PERF: Current consumer only needs mutated keys; if we can
   // provide that cheaply, we should replace this.
@@ -157,6 +167,33 @@ class MutationQueue {
    */
   virtual model::BatchId GetHighestUnacknowledgedBatchId() = 0;
 
+  /**
+   * Returns a counter that changes whenever a batch is added to or removed from
+   * this queue, so that state derived from the queue's batches can be reused
+   * until the queue changes. The counter is not persisted.
+   */
+  virtual uint64_t GetChangeCount() = 0;
+
+  /** Returns the number of batches in this queue. */
+  virtual size_t GetBatchCount() = 0;
+
+  /**
+   * Returns the total size in bytes of the batches in this queue, or zero if
+   * the implementation doesn't track it.
+   */
+  virtual int64_t GetByteSize() = 0;
+
+  /**
+   * Returns false if no batch in this queue mutates a document that is an
+   * immediate child of the given collection, so that callers can skip looking
+   * for such batches. Implementations that can't tell cheaply return true.
+   */
+  virtual bool MayHaveMutationsInCollection(
+      const model::ResourcePath& collection_path) {
+    (void)collection_path;
+    return true;
+  }
+
   /**
    * Performs a consistency check, examining the mutation queue for any leaks,
    * if possible.
@@ -20,6 +20,7 @@
 #include <functional>
 #include <utility>
 
+#include "Firestore/core/src/firebase/firestore/local/persistence_metrics.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "absl/strings/string_view.h"
 
@@ -112,6 +113,21 @@ class Persistence {
    */
   virtual ReferenceDelegate* reference_delegate() = 0;
 
+  /**
+   * Drops in-memory state that can be rebuilt from the persisted data, such as
+   * caches of decoded documents, in response to memory pressure. Returns an
+   * estimate of the number of bytes released.
+   */
+  virtual size_t ReleaseMemory() = 0;
+
+  /**
+   * Returns the counters describing the work done by this persistence layer.
+   * Components backed by this persistence record their activity here.
+   */
+  PersistenceMetrics* metrics() {
+    return &metrics_;
+  }
+
   /**
    * Accepts a function and runs it within a transaction. When called, a
    * transaction will be started before a block is run, and committed after the
@@ -153,6 +169,8 @@ class Persistence {
  private:
   virtual void RunInternal(absl::string_view label,
                            std::function<void()> block) = 0;
+
+  PersistenceMetrics metrics_;
 };
 
 }  // namespace local
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/persistence_metrics.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using Duration = LatencyHistogram::Duration;
+
+int BucketFor(int64_t micros) {
+  int bucket = 0;
+  while (micros > 0 && bucket < LatencyHistogram::kBucketCount - 1) {
+    micros >>= 1;
+    ++bucket;
+  }
+  return bucket;
+}
+
+std::string Describe(const LatencyHistogram::Snapshot& histogram) {
+  return absl::StrCat("count=", histogram.count,
+                      " p50=", histogram.Percentile(50).count(),
+                      "us p99=", histogram.Percentile(99).count(),
+                      "us max=", histogram.max.count(), "us");
+}
+
+}  // namespace
+
+Duration LatencyHistogram::Snapshot::Percentile(double percentile) const {
+  if (count == 0) {
+    return Duration{0};
+  }
+
+  double target = count * percentile / 100;
+  int64_t seen = 0;
+  for (int i = 0; i < kBucketCount - 1; ++i) {
+    seen += buckets[i];
+    if (seen >= target) {
+      // The exclusive upper bound of bucket `i`, but never more than the
+      // largest latency actually recorded.
+      return std::min(Duration{int64_t{1} << i}, max);
+    }
+  }
+  return max;
+}
+
+void LatencyHistogram::Record(Duration latency) {
+  int64_t micros = latency.count() < 0 ? 0 : latency.count();
+
+  count_.fetch_add(1, std::memory_order_relaxed);
+  total_micros_.fetch_add(micros, std::memory_order_relaxed);
+  buckets_[BucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+
+  int64_t max = max_micros_.load(std::memory_order_relaxed);
+  while (micros > max && !max_micros_.compare_exchange_weak(
+                             max, micros, std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const {
+  Snapshot result;
+  result.count = count_.load(std::memory_order_relaxed);
+  result.total = Duration{total_micros_.load(std::memory_order_relaxed)};
+  result.max = Duration{max_micros_.load(std::memory_order_relaxed)};
+  for (int i = 0; i < kBucketCount; ++i) {
+    result.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  return result;
+}
+
+void PersistenceMetrics::RecordQueryExecuted(int64_t documents_matched,
+                                             Duration latency) {
+  queries_executed_.fetch_add(1, std::memory_order_relaxed);
+  documents_matched_.fetch_add(documents_matched, std::memory_order_relaxed);
+  query_latency_.Record(latency);
+}
+
+void PersistenceMetrics::RecordGarbageCollection(const LruResults& results) {
+  if (!results.did_run) {
+    return;
+  }
+  targets_removed_.fetch_add(results.targets_removed,
+                             std::memory_order_relaxed);
+  documents_removed_.fetch_add(results.documents_removed,
+                               std::memory_order_relaxed);
+}
+
+PersistenceMetrics::Snapshot PersistenceMetrics::GetSnapshot() const {
+  Snapshot result;
+  result.keys_read = keys_read_.load(std::memory_order_relaxed);
+  result.bytes_decoded = bytes_decoded_.load(std::memory_order_relaxed);
+  result.queries_executed = queries_executed_.load(std::memory_order_relaxed);
+  result.documents_scanned =
+      documents_scanned_.load(std::memory_order_relaxed);
+  result.documents_matched =
+      documents_matched_.load(std::memory_order_relaxed);
+  result.targets_removed = targets_removed_.load(std::memory_order_relaxed);
+  result.documents_removed =
+      documents_removed_.load(std::memory_order_relaxed);
+  result.query_latency = query_latency_.GetSnapshot();
+  result.transaction_commit_latency =
+      transaction_commit_latency_.GetSnapshot();
+  return result;
+}
+
+std::string PersistenceMetrics::Snapshot::ToString() const {
+  return absl::StrCat(
+      "PersistenceMetrics(keys_read=", keys_read,
+      ", bytes_decoded=", bytes_decoded,
+      ", queries_executed=", queries_executed,
+      ", documents_scanned=", documents_scanned,
+      ", documents_matched=", documents_matched,
+      ", targets_removed=", targets_removed,
+      ", documents_removed=", documents_removed, ", query_latency=(",
+      Describe(query_latency), "), transaction_commit_latency=(",
+      Describe(transaction_commit_latency), "))");
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PERSISTENCE_METRICS_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PERSISTENCE_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+struct LruResults;
+
+/**
+ * A histogram of latencies, in buckets whose bounds grow exponentially.
+ *
+ * Recording is thread-safe and lock-free, so histograms can be updated from
+ * hot paths.
+ */
+class LatencyHistogram {
+ public:
+  using Duration = std::chrono::microseconds;
+
+  /**
+   * Bucket `i` holds latencies in [2^(i-1), 2^i) microseconds (bucket 0 holds
+   * latencies under 1 microsecond); the last bucket is unbounded.
+   */
+  static constexpr int kBucketCount = 25;
+
+  struct Snapshot {
+    /**
+     * Returns an upper bound for the given percentile (between 0 and 100) of
+     * the recorded latencies, based on the bucket it falls into.
+     */
+    Duration Percentile(double percentile) const;
+
+    int64_t count = 0;
+    Duration total{0};
+    Duration max{0};
+    std::array<int64_t, kBucketCount> buckets{};
+  };
+
+  void Record(Duration latency);
+
+  Snapshot GetSnapshot() const;
+
+ private:
+  std::atomic<int64_t> count_{0};
+  std::atomic<int64_t> total_micros_{0};
+  std::atomic<int64_t> max_micros_{0};
+  std::array<std::atomic<int64_t>, kBucketCount> buckets_{};
+};
+
+/**
+ * Counters and latency histograms describing the work done by the local
+ * persistence layer, meant to help tell apart slowness caused by disk access,
+ * decoding and query execution.
+ *
+ * All counters are cumulative since the persistence was created. Recording is
+ * thread-safe.
+ */
+class PersistenceMetrics {
+ public:
+  struct Snapshot {
+    std::string ToString() const;
+
+    /** The number of keys read from the underlying storage. */
+    int64_t keys_read = 0;
+
+    /** The number of bytes of remote documents decoded. */
+    int64_t bytes_decoded = 0;
+
+    /** The number of queries executed by the local store. */
+    int64_t queries_executed = 0;
+
+    /**
+     * The number of documents read from the remote document cache while
+     * executing queries.
+     */
+    int64_t documents_scanned = 0;
+
+    /** The number of documents that matched executed queries. */
+    int64_t documents_matched = 0;
+
+    /** The number of targets and documents removed by garbage collection. */
+    int64_t targets_removed = 0;
+    int64_t documents_removed = 0;
+
+    LatencyHistogram::Snapshot query_latency;
+    LatencyHistogram::Snapshot transaction_commit_latency;
+  };
+
+  void RecordKeysRead(int64_t count) {
+    keys_read_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  void RecordBytesDecoded(int64_t bytes) {
+    bytes_decoded_.fetch_add(bytes, std::memory_order_relaxed);
+  }
+
+  void RecordDocumentsScanned(int64_t count) {
+    documents_scanned_.fetch_add(count, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns the number of documents scanned so far, which is cheaper than
+   * taking a snapshot.
+   */
+  int64_t documents_scanned() const {
+    return documents_scanned_.load(std::memory_order_relaxed);
+  }
+
+  void RecordQueryExecuted(int64_t documents_matched,
+                           LatencyHistogram::Duration latency);
+
+  void RecordTransactionCommit(LatencyHistogram::Duration latency) {
+    transaction_commit_latency_.Record(latency);
+  }
+
+  void RecordGarbageCollection(const LruResults& results);
+
+  Snapshot GetSnapshot() const;
+
+ private:
+  std::atomic<int64_t> keys_read_{0};
+  std::atomic<int64_t> bytes_decoded_{0};
+  std::atomic<int64_t> queries_executed_{0};
+  std::atomic<int64_t> documents_scanned_{0};
+  std::atomic<int64_t> documents_matched_{0};
+  std::atomic<int64_t> targets_removed_{0};
+  std::atomic<int64_t> documents_removed_{0};
+  LatencyHistogram query_latency_;
+  LatencyHistogram transaction_commit_latency_;
+};
+
+using PersistenceMetricsCallback =
+    std::function<void(const PersistenceMetrics::Snapshot&)>;
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_PERSISTENCE_METRICS_H_
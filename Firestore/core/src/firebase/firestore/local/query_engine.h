@@ -36,7 +36,17 @@ class LocalDocumentsView;
  */
 class QueryEngine {
  public:
-  enum Type { Simple, IndexFree };
+  enum Type { Simple, IndexFree, CostBased };
+
+  /** The ways a query engine can find the documents matching a query. */
+  enum class Path {
+    /** Re-checked the documents that matched when the target last synced. */
+    PreviousResults,
+    /** Looked up the candidates found in a field index. */
+    IndexScan,
+    /** Read every document of the queried collection. */
+    FullScan,
+  };
 
   virtual ~QueryEngine() = default;
 
@@ -56,6 +66,17 @@ class QueryEngine {
 
   /** Returns the underlying algorithm used by the query engine. */
   virtual Type type() const = 0;
+
+  /**
+   * Returns how the last call to `GetDocumentsMatchingQuery()` found its
+   * results.
+   */
+  virtual Path last_path() const {
+    return last_path_;
+  }
+
+ protected:
+  Path last_path_ = Path::FullScan;
 };
 
 }  // namespace local
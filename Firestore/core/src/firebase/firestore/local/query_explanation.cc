@@ -0,0 +1,68 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/query_explanation.h"
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using util::StringFormat;
+
+namespace {
+
+const char* EngineName(QueryEngine::Type engine) {
+  switch (engine) {
+    case QueryEngine::Type::Simple:
+      return "simple";
+    case QueryEngine::Type::IndexFree:
+      return "index-free";
+    case QueryEngine::Type::CostBased:
+      return "cost-based";
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
+const char* PathName(QueryEngine::Path path) {
+  switch (path) {
+    case QueryEngine::Path::PreviousResults:
+      return "previous results";
+    case QueryEngine::Path::IndexScan:
+      return "index scan";
+    case QueryEngine::Path::FullScan:
+      return "full collection scan";
+  }
+  UNREACHABLE();
+}
+
+std::string QueryExplanation::ToString() const {
+  return StringFormat(
+      "QueryExplanation(engine=%s, path=%s, documents_read=%s, "
+      "documents_matched=%s, mutation_batches_applied=%s, "
+      "target_lookup_time=%sus, execution_time=%sus)",
+      EngineName(engine), PathName(path), documents_read, documents_matched,
+      mutation_batches_applied, target_lookup_time.count(),
+      execution_time.count());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
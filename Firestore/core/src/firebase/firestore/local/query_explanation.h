@@ -0,0 +1,77 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_EXPLANATION_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_EXPLANATION_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/local/query_engine.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+/**
+ * Describes how the local store executed a query, meant to help tell why a
+ * query is slow to run against the cache.
+ */
+struct QueryExplanation {
+  using Duration = std::chrono::microseconds;
+
+  std::string ToString() const;
+
+  /** The algorithm of the query engine that ran the query. */
+  QueryEngine::Type engine = QueryEngine::Type::Simple;
+
+  /** How the query engine found the matching documents. */
+  QueryEngine::Path path = QueryEngine::Path::FullScan;
+
+  /** The number of documents read from the remote document cache. */
+  int64_t documents_read = 0;
+
+  /** The number of documents that matched the query. */
+  int64_t documents_matched = 0;
+
+  /**
+   * The number of pending mutation batches that affect the query, whose
+   * mutations were applied on top of the cached documents.
+   */
+  int64_t mutation_batches_applied = 0;
+
+  /**
+   * The time spent looking up the query's target and the keys of the
+   * documents that matched it when it last synced.
+   */
+  Duration target_lookup_time{0};
+
+  /** The time spent by the query engine. */
+  Duration execution_time{0};
+};
+
+/** Returns a readable name of the given query engine path. */
+const char* PathName(QueryEngine::Path path);
+
+using QueryExplanationCallback = std::function<void(const QueryExplanation&)>;
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_EXPLANATION_H_
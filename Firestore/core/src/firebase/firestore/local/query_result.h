@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_RESULT_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_QUERY_RESULT_H_
 
+#include <cstdint>
 #include <utility>
 #include <vector>
 
@@ -33,8 +34,12 @@ class QueryResult {
   QueryResult() = default;
 
   /** Creates a new QueryResult with the given values. */
-  QueryResult(model::DocumentMap documents, model::DocumentKeySet remote_keys)
-      : documents_{std::move(documents)}, remote_keys_{std::move(remote_keys)} {
+  QueryResult(model::DocumentMap documents,
+              model::DocumentKeySet remote_keys,
+              int64_t documents_scanned = 0)
+      : documents_{std::move(documents)},
+        remote_keys_{std::move(remote_keys)},
+        documents_scanned_{documents_scanned} {
   }
 
   const model::DocumentMap& documents() const {
@@ -45,9 +50,18 @@ class QueryResult {
     return remote_keys_;
   }
 
+  /**
+   * The number of documents read from the remote document cache to produce
+   * this result, which is zero if it was served from memory.
+   */
+  int64_t documents_scanned() const {
+    return documents_scanned_;
+  }
+
  private:
   model::DocumentMap documents_;
   model::DocumentKeySet remote_keys_;
+  int64_t documents_scanned_ = 0;
 };
 
 }  // namespace local
@@ -16,6 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 #include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
@@ -23,14 +26,22 @@
 namespace firebase {
 namespace firestore {
 namespace local {
+namespace {
+
+// Erasing a reference from the primary set takes logarithmic time, so once an
+// Id holds more than about 1/16th of all references (the depth of a tree of
+// 64k entries), rebuilding the set in linear time is cheaper.
+const size_t kBulkEraseRatio = 16;
+
+}  // namespace
 
 using model::DocumentKey;
 using model::DocumentKeySet;
 
 void ReferenceSet::AddReference(const DocumentKey& key, int id) {
-  DocumentKeyReference reference{key, id};
-  by_key_ = by_key_.insert(reference);
-  by_id_ = by_id_.insert(reference);
+  by_key_ = by_key_.insert(DocumentKeyReference{key, id});
+  DocumentKeySet& keys = by_id_[id];
+  keys = keys.insert(key);
 }
 
 void ReferenceSet::AddReferences(const DocumentKeySet& keys, int id) {
@@ -51,40 +62,53 @@ void ReferenceSet::RemoveReferences(
 }
 
 DocumentKeySet ReferenceSet::RemoveReferences(int id) {
-  DocumentKeyReference start{DocumentKey::Empty(), id};
-  DocumentKeyReference end{DocumentKey::Empty(), id + 1};
-
-  DocumentKeySet removed{};
+  auto found = by_id_.find(id);
+  if (found == by_id_.end()) {
+    return DocumentKeySet{};
+  }
+  DocumentKeySet removed = std::move(found->second);
+  by_id_.erase(found);
+
+  if (removed.size() * kBulkEraseRatio < by_key_.size()) {
+    for (const DocumentKey& key : removed) {
+      by_key_ = by_key_.erase(DocumentKeyReference{key, id});
+    }
+    return removed;
+  }
 
-  auto initial = by_id_;
-  for (const auto& reference : initial.values_in(start, end)) {
-    RemoveReference(reference);
-    removed = removed.insert(reference.key());
+  std::vector<DocumentKeyReference> remaining;
+  remaining.reserve(by_key_.size() - removed.size());
+  for (const DocumentKeyReference& reference : by_key_) {
+    if (reference.ref_id() != id) {
+      remaining.push_back(reference);
+    }
   }
+  by_key_ = decltype(by_key_)::FromSortedRange(remaining.begin(),
+                                               remaining.end());
   return removed;
 }
 
 void ReferenceSet::RemoveAllReferences() {
-  auto initial = by_key_;
-  for (const DocumentKeyReference& reference : initial) {
-    RemoveReference(reference);
-  }
+  by_key_ = decltype(by_key_){};
+  by_id_.clear();
 }
 
 void ReferenceSet::RemoveReference(const DocumentKeyReference& reference) {
   by_key_ = by_key_.erase(reference);
-  by_id_ = by_id_.erase(reference);
+
+  auto found = by_id_.find(reference.ref_id());
+  if (found == by_id_.end()) {
+    return;
+  }
+  found->second = found->second.erase(reference.key());
+  if (found->second.empty()) {
+    by_id_.erase(found);
+  }
 }
 
 DocumentKeySet ReferenceSet::ReferencedKeys(int id) {
-  DocumentKeyReference start{DocumentKey::Empty(), id};
-  DocumentKeyReference end{DocumentKey::Empty(), id + 1};
-
-  DocumentKeySet keys;
-  for (const auto& reference : by_id_.values_in(start, end)) {
-    keys = keys.insert(reference.key());
-  }
-  return keys;
+  auto found = by_id_.find(id);
+  return found != by_id_.end() ? found->second : DocumentKeySet{};
 }
 
 bool ReferenceSet::ContainsKey(const DocumentKey& key) {
@@ -17,9 +17,11 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REFERENCE_SET_H_
 
+#include <unordered_map>
+
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 #include "Firestore/core/src/firebase/firestore/local/document_key_reference.h"
-#include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 
 namespace firebase {
 namespace firestore {
@@ -36,9 +38,11 @@ namespace local {
  * there's no references in that set (this can be efficiently checked thanks to
  * sorting by key).
  *
- * ReferenceSet also keeps a secondary set that contains references sorted by
- * Id. This one is used to efficiently implement removal of all references by
- * some TargetId.
+ * ReferenceSet also keeps a secondary index from each Id to the keys it
+ * references. This one is used to efficiently implement removal of all
+ * references by some TargetId: when a target releases a large share of all
+ * references at once, the primary set is rebuilt in a single pass instead of
+ * having each reference erased from it in turn.
  */
 class ReferenceSet {
  public:
@@ -84,7 +88,7 @@ class ReferenceSet {
 
   immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ByKey>
       by_key_;
-  immutable::SortedSet<DocumentKeyReference, DocumentKeyReference::ById> by_id_;
+  std::unordered_map<int, model::DocumentKeySet> by_id_;
 };
 
 }  // namespace local
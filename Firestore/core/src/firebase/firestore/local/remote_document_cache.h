@@ -17,7 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REMOTE_DOCUMENT_CACHE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_REMOTE_DOCUMENT_CACHE_H_
 
+#include <memory>
+
+#include "Firestore/core/src/firebase/firestore/local/document_cursor.h"
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
+#include "absl/memory/memory.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -91,6 +96,57 @@ class RemoteDocumentCache {
   virtual model::DocumentMap GetMatching(
       const core::Query& query,
       const model::SnapshotVersion& since_read_time) = 0;
+
+  /**
+   * Executes a query against the cached Document entries like `GetMatching`,
+   * but returns a cursor that yields the results in key order instead of
+   * building all of them up front. The cursor must not outlive the current
+   * transaction.
+   *
+   * The default implementation iterates over the result of `GetMatching`;
+   * caches that can read documents lazily override it so that consumers that
+   * stop early skip reading the rest.
+   */
+  virtual std::unique_ptr<DocumentCursor> ScanMatching(
+      const core::Query& query, const model::SnapshotVersion& since_read_time) {
+    return absl::make_unique<DocumentMapCursor>(
+        GetMatching(query, since_read_time));
+  }
+
+  /**
+   * Executes a collection group query against the cached Document entries, in
+   * the same way as `GetMatching` for other queries.
+   *
+   * Returns nullopt if the cache can't look up the documents of a collection
+   * group directly, in which case the caller queries each parent of the
+   * collection group instead. The default implementation always does.
+   */
+  virtual absl::optional<model::DocumentMap> GetMatchingCollectionGroup(
+      const core::Query& /* query */,
+      const model::SnapshotVersion& /* since_read_time */) {
+    return absl::nullopt;
+  }
+
+  /**
+   * Starts reading the given documents in the background, so that they are
+   * already decoded when they are next looked up. Only a hint: the default
+   * implementation, for caches that keep documents decoded anyway, does
+   * nothing.
+   */
+  virtual void Prefetch(const model::DocumentKeySet& /* keys */) {
+  }
+
+  /**
+   * Drops whatever the cache keeps in memory that it can rebuild from its
+   * contents, such as decoded copies of documents, and shrinks its buffers.
+   * Called in response to memory pressure.
+   *
+   * Returns an estimate of the number of bytes released. The default
+   * implementation keeps nothing of the kind and returns zero.
+   */
+  virtual size_t ReleaseMemory() {
+    return 0;
+  }
 };
 
 }  // namespace local
@@ -19,6 +19,7 @@
 
 #include <functional>
 #include <unordered_map>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
@@ -39,6 +40,8 @@ using OrphanedDocumentCallback =
 
 using TargetCallback = std::function<void(const TargetData&)>;
 
+using SequenceNumberCallback = std::function<void(model::ListenSequenceNumber)>;
+
 /**
  * Represents cached targets received from the remote backend. This contains
  * both a mapping between targets and the documents that matched them according
@@ -143,6 +146,23 @@ class TargetCache {
    * @param version The new snapshot version.
    */
   virtual void SetLastRemoteSnapshotVersion(model::SnapshotVersion version) = 0;
+
+  /**
+   * Returns the IDs of the targets that were executed early in the previous
+   * session, as recorded by `SetStartupTargets`. The default implementation
+   * doesn't outlive the session and always returns none.
+   */
+  virtual std::vector<model::TargetId> GetStartupTargets() {
+    return {};
+  }
+
+  /**
+   * Records the IDs of the targets executed early in the current session,
+   * replacing those of the previous one.
+   */
+  virtual void SetStartupTargets(
+      const std::vector<model::TargetId>& /* target_ids */) {
+  }
 };
 
 }  // namespace local
@@ -113,6 +113,12 @@ TargetData TargetData::WithLastLimboFreeSnapshotVersion(
                     std::move(last_limbo_free_snapshot_version), resume_token_);
 }
 
+TargetData TargetData::WithExpectedCount(int32_t expected_count) const {
+  TargetData result = *this;
+  result.expected_count_ = expected_count;
+  return result;
+}
+
 bool operator==(const TargetData& lhs, const TargetData& rhs) {
   return lhs.target() == rhs.target() && lhs.target_id() == rhs.target_id() &&
          lhs.sequence_number() == rhs.sequence_number() &&
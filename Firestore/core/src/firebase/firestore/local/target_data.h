@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_DATA_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_LOCAL_TARGET_DATA_H_
 
+#include <cstdint>
 #include <iosfwd>
 #include <memory>
 #include <string>
@@ -26,6 +27,7 @@
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -142,6 +144,15 @@ class TargetData {
     return resume_token_;
   }
 
+  /**
+   * The number of documents that last matched the target at the resume token,
+   * if known. This is only sent to the backend alongside the resume token and
+   * isn't persisted.
+   */
+  const absl::optional<int32_t>& expected_count() const {
+    return expected_count_;
+  }
+
   /** Creates a new target data instance with an updated sequence number. */
   TargetData WithSequenceNumber(
       model::ListenSequenceNumber sequence_number) const;
@@ -160,6 +171,12 @@ class TargetData {
   TargetData WithLastLimboFreeSnapshotVersion(
       model::SnapshotVersion last_limbo_free_snapshot_version) const;
 
+  /**
+   * Creates a new target data instance with the number of documents that last
+   * matched the target.
+   */
+  TargetData WithExpectedCount(int32_t expected_count) const;
+
   friend bool operator==(const TargetData& lhs, const TargetData& rhs);
 
   size_t Hash() const;
@@ -176,6 +193,7 @@ class TargetData {
   model::SnapshotVersion snapshot_version_;
   model::SnapshotVersion last_limbo_free_snapshot_version_;
   nanopb::ByteString resume_token_;
+  absl::optional<int32_t> expected_count_;
 };
 
 inline bool operator!=(const TargetData& lhs, const TargetData& rhs) {
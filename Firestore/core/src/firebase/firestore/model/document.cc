@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
 #include <ostream>
 #include <sstream>
 #include <utility>
@@ -100,6 +102,10 @@ class Document::Rep : public MaybeDocument::Rep {
   ObjectValue data_;
   DocumentState document_state_;
   absl::any proto_;
+
+  // The values memoized by Document::Memoize, by slot.
+  mutable std::mutex memoized_mutex_;
+  mutable std::map<int, std::shared_ptr<void>> memoized_;
 };
 
 Document::Document(ObjectValue data,
@@ -134,6 +140,24 @@ absl::optional<FieldValue> Document::field(const FieldPath& path) const {
   return data().Get(path);
 }
 
+std::shared_ptr<void> Document::Memoize(
+    int slot, const std::function<std::shared_ptr<void>()>& compute) const {
+  const Rep& rep = doc_rep();
+  {
+    std::lock_guard<std::mutex> lock(rep.memoized_mutex_);
+    auto found = rep.memoized_.find(slot);
+    if (found != rep.memoized_.end()) {
+      return found->second;
+    }
+  }
+
+  // Compute outside the lock, so that a slow conversion doesn't hold up reads
+  // of other slots. If two threads race, the first value stored wins.
+  std::shared_ptr<void> value = compute();
+  std::lock_guard<std::mutex> lock(rep.memoized_mutex_);
+  return rep.memoized_.emplace(slot, std::move(value)).first->second;
+}
+
 DocumentState Document::document_state() const {
   return doc_rep().document_state_;
 }
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_H_
 
+#include <functional>
 #include <iosfwd>
 #include <memory>
 #include <string>
@@ -116,6 +117,18 @@ class Document : public MaybeDocument {
 
   const absl::any& proto() const;
 
+  /**
+   * Returns the value memoized for this document in the given slot, calling
+   * `compute` to produce it the first time the slot is asked for.
+   *
+   * Memoized values are shared by all copies of this document, so the API
+   * layer uses them to convert the document's data for the user once, however
+   * many listeners the document is surfaced to or how often it's read. The
+   * slot distinguishes conversions with different options. Thread-safe.
+   */
+  std::shared_ptr<void> Memoize(
+      int slot, const std::function<std::shared_ptr<void>()>& compute) const;
+
   /** Compares against another Document. */
   friend bool operator==(const Document& lhs, const Document& rhs);
 
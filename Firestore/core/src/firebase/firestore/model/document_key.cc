@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 
+#include <atomic>
 #include <ostream>
 #include <utility>
 
@@ -37,17 +38,29 @@ void AssertValidPath(const ResourcePath& path) {
 
 }  // namespace
 
-DocumentKey::DocumentKey() : path_{std::make_shared<ResourcePath>()} {
+struct DocumentKey::Rep {
+  explicit Rep(ResourcePath path) : path{std::move(path)} {
+  }
+
+  const ResourcePath path;
+
+  // The hash of `path`, or zero if it hasn't been computed yet. Copies of a key
+  // can be hashed on different threads, which can only race to store the same
+  // value.
+  mutable std::atomic<size_t> hash{0};
+};
+
+DocumentKey::DocumentKey() : rep_{std::make_shared<Rep>(ResourcePath{})} {
 }
 
 DocumentKey::DocumentKey(const ResourcePath& path)
-    : path_{std::make_shared<ResourcePath>(path)} {
-  AssertValidPath(*path_);
+    : rep_{std::make_shared<Rep>(path)} {
+  AssertValidPath(rep_->path);
 }
 
 DocumentKey::DocumentKey(ResourcePath&& path)
-    : path_{std::make_shared<ResourcePath>(std::move(path))} {
-  AssertValidPath(*path_);
+    : rep_{std::make_shared<Rep>(std::move(path))} {
+  AssertValidPath(rep_->path);
 }
 
 DocumentKey DocumentKey::FromPathString(const std::string& path) {
@@ -68,11 +81,16 @@ bool DocumentKey::IsDocumentKey(const ResourcePath& path) {
 }
 
 util::ComparisonResult DocumentKey::CompareTo(const DocumentKey& other) const {
+  // Copies of a key (and keys interned by DocumentKeyInterner) share their
+  // path, so they can skip comparing it segment by segment.
+  if (rep_ == other.rep_) {
+    return util::ComparisonResult::Same;
+  }
   return path().CompareTo(other.path());
 }
 
 bool operator==(const DocumentKey& lhs, const DocumentKey& rhs) {
-  return lhs.path() == rhs.path();
+  return lhs.rep_ == rhs.rep_ || lhs.path() == rhs.path();
 }
 
 bool operator<(const DocumentKey& lhs, const DocumentKey& rhs) {
@@ -83,7 +101,16 @@ bool operator>(const DocumentKey& lhs, const DocumentKey& rhs) {
 }
 
 size_t DocumentKey::Hash() const {
-  return util::Hash(ToString());
+  if (!rep_) {
+    return Empty().Hash();
+  }
+
+  size_t hash = rep_->hash.load(std::memory_order_relaxed);
+  if (hash == 0) {
+    hash = rep_->path.Hash();
+    rep_->hash.store(hash, std::memory_order_relaxed);
+  }
+  return hash;
 }
 
 std::string DocumentKey::ToString() const {
@@ -95,7 +122,7 @@ std::ostream& operator<<(std::ostream& os, const DocumentKey& key) {
 }
 
 const ResourcePath& DocumentKey::path() const {
-  return path_ ? *path_ : Empty().path();
+  return rep_ ? rep_->path : Empty().path();
 }
 
 /** Returns true if the document is in the specified collection_id. */
@@ -105,7 +132,7 @@ bool DocumentKey::HasCollectionId(const std::string& collection_id) const {
 }
 
 size_t DocumentKeyHash::operator()(const DocumentKey& key) const {
-  return util::Hash(key.path());
+  return key.Hash();
 }
 
 }  // namespace model
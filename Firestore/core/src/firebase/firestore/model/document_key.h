@@ -22,6 +22,7 @@
 #include <iosfwd>
 #include <memory>
 #include <string>
+#include <utility>
 
 namespace firebase {
 namespace firestore {
@@ -67,6 +68,10 @@ class DocumentKey {
 
   friend bool operator==(const DocumentKey& lhs, const DocumentKey& rhs);
 
+  /**
+   * Returns the hash of the key's path. It's computed once and shared by all
+   * copies of the key.
+   */
   size_t Hash() const;
 
   std::string ToString() const;
@@ -80,9 +85,17 @@ class DocumentKey {
   bool HasCollectionId(const std::string& collection_id) const;
 
  private:
+  friend class DocumentKeyInterner;
+
+  /** The path of a key and its hash, shared by all copies of the key. */
+  struct Rep;
+
+  explicit DocumentKey(std::shared_ptr<const Rep> rep) : rep_{std::move(rep)} {
+  }
+
   // This is an optimization to make passing DocumentKey around cheaper (it's
   // copied often).
-  std::shared_ptr<const ResourcePath> path_;
+  std::shared_ptr<const Rep> rep_;
 };
 
 inline bool operator!=(const DocumentKey& lhs, const DocumentKey& rhs) {
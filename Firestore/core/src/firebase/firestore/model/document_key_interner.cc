@@ -0,0 +1,66 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/model/document_key_interner.h"
+
+#include <algorithm>
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+constexpr size_t DocumentKeyInterner::kMinPruneThreshold;
+
+DocumentKey DocumentKeyInterner::Intern(const DocumentKey& key) {
+  if (!key.rep_) {
+    return key;
+  }
+
+  size_t hash = key.Hash();
+
+  auto range = entries_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    DocumentKey candidate{it->second.lock()};
+    if (candidate.rep_ && candidate == key) {
+      return candidate;
+    }
+  }
+
+  entries_.emplace(hash, key.rep_);
+
+  // Prune once the table has doubled since the last pass, so that the cost of
+  // pruning is amortized over the insertions that made it necessary.
+  if (entries_.size() >= prune_threshold_) {
+    Prune();
+    prune_threshold_ = std::max(kMinPruneThreshold, 2 * entries_.size());
+  }
+  return key;
+}
+
+void DocumentKeyInterner::Prune() {
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    if (it->second.expired()) {
+      it = entries_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
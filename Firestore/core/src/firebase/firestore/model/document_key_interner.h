@@ -0,0 +1,79 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_KEY_INTERNER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_KEY_INTERNER_H_
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * Deduplicates DocumentKeys so that all equal keys passed through the same
+ * interner share a single path.
+ *
+ * Keys decoded from storage each get their own copy of their path, so a
+ * document that appears in many targets (or is read many times) is otherwise
+ * held in memory once per read. Interned keys also compare equal without
+ * looking at their segments, since DocumentKey checks for a shared path
+ * first.
+ *
+ * The interner only holds weak references: a path is freed as soon as the
+ * last key using it goes away, and its entry is pruned later.
+ *
+ * DocumentKeyInterner is not thread-safe.
+ */
+class DocumentKeyInterner {
+ public:
+  /**
+   * Returns a key equal to the given one, sharing its path with any live key
+   * previously returned for an equal key.
+   */
+  DocumentKey Intern(const DocumentKey& key);
+
+  /**
+   * Returns the number of entries in the table, which may include paths
+   * that have already been freed but not yet pruned.
+   */
+  size_t size() const {
+    return entries_.size();
+  }
+
+ private:
+  /** Removes entries for paths that have been freed. */
+  void Prune();
+
+  // Keyed by the hash of the path so that the table doesn't hold a strong
+  // reference to (or a copy of) any path.
+  std::unordered_multimap<size_t, std::weak_ptr<const DocumentKey::Rep>>
+      entries_;
+  size_t prune_threshold_ = kMinPruneThreshold;
+
+  static constexpr size_t kMinPruneThreshold = 64;
+};
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_KEY_INTERNER_H_
@@ -20,6 +20,17 @@ namespace firebase {
 namespace firestore {
 namespace model {
 
+DocumentMap DocumentMap::FromSortedDocuments(
+    const std::vector<Document>& documents) {
+  std::vector<MaybeDocumentMap::value_type> entries;
+  entries.reserve(documents.size());
+  for (const Document& document : documents) {
+    entries.emplace_back(document.key(), document);
+  }
+  return DocumentMap{
+      MaybeDocumentMap::FromSortedRange(entries.begin(), entries.end())};
+}
+
 ABSL_MUST_USE_RESULT DocumentMap
 DocumentMap::insert(const DocumentKey& key, const Document& value) const {
   return DocumentMap{map_.insert(key, value)};
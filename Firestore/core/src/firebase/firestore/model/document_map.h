@@ -18,6 +18,7 @@
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_MAP_H_
 
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
@@ -62,6 +63,13 @@ class DocumentMap {
 
   DocumentMap() = default;
 
+  /**
+   * Creates a DocumentMap from documents that are sorted by key and have no
+   * duplicate keys, in linear time. See SortedMap::FromSortedRange.
+   */
+  static DocumentMap FromSortedDocuments(
+      const std::vector<Document>& documents);
+
   ABSL_MUST_USE_RESULT DocumentMap insert(const DocumentKey& key,
                                           const Document& value) const;
 
@@ -21,7 +21,10 @@
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "Firestore/core/src/firebase/firestore/util/range.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
 #include "absl/algorithm/container.h"
 
@@ -39,21 +42,23 @@ inline absl::optional<Document> none() {
 }  // namespace
 
 DocumentComparator DocumentComparator::ByKey() {
-  return DocumentComparator([](const Document& lhs, const Document& rhs) {
-    return util::Compare(lhs.key(), rhs.key());
-  });
+  return DocumentComparator(
+      [](const Document& lhs, const Document& rhs) {
+        return util::Compare(lhs.key(), rhs.key());
+      },
+      nullptr, /* orders_by_key= */ true);
 }
 
 DocumentSet::DocumentSet(DocumentComparator&& comparator)
-    : index_{}, sorted_set_{std::move(comparator)} {
+    : index_{}, sorted_set_{SortedDocumentComparator{std::move(comparator)}} {
 }
 
 bool operator==(const DocumentSet& lhs, const DocumentSet& rhs) {
-  return absl::c_equal(lhs.sorted_set_, rhs.sorted_set_);
+  return absl::c_equal(lhs, rhs);
 }
 
 std::string DocumentSet::ToString() const {
-  return util::ToString(sorted_set_);
+  return util::ToString(util::make_range(begin(), end()));
 }
 
 std::ostream& operator<<(std::ostream& os, const DocumentSet& set) {
@@ -61,33 +66,55 @@ std::ostream& operator<<(std::ostream& os, const DocumentSet& set) {
 }
 
 size_t DocumentSet::Hash() const {
-  return util::Hash(sorted_set_);
+  return util::Hash(util::make_range(begin(), end()));
+}
+
+DocumentSet::SortedDocument DocumentSet::Probe(const DocumentKey& key) {
+  // Without a sort key, the probe is compared with the comparator, which only
+  // looks at its key.
+  return {Document(ObjectValue::Empty(), key, SnapshotVersion::None(),
+                   DocumentState::kSynced),
+          absl::nullopt};
+}
+
+const DocumentSet::SortedDocument* DocumentSet::Find(
+    const DocumentKey& key) const {
+  if (comparator().orders_by_key()) {
+    auto found = sorted_set_.find(Probe(key));
+    return found != sorted_set_.end() ? &*found : nullptr;
+  }
+
+  auto found = index_.find(key);
+  return found != index_.end() ? &found->second : nullptr;
 }
 
 bool DocumentSet::ContainsKey(const DocumentKey& key) const {
-  return index_.underlying_map().find(key) != index_.underlying_map().end();
+  return Find(key) != nullptr;
 }
 
 absl::optional<Document> DocumentSet::GetDocument(
     const DocumentKey& key) const {
-  auto found = index_.underlying_map().find(key);
-  return found != index_.underlying_map().end() ? Document(found->second)
-                                                : none();
+  const SortedDocument* found = Find(key);
+  return found ? found->first : none();
 }
 
 absl::optional<Document> DocumentSet::GetFirstDocument() const {
   auto result = sorted_set_.min();
-  return result != sorted_set_.end() ? *result : none();
+  return result != sorted_set_.end() ? result->first : none();
 }
 
 absl::optional<Document> DocumentSet::GetLastDocument() const {
   auto result = sorted_set_.max();
-  return result != sorted_set_.end() ? *result : none();
+  return result != sorted_set_.end() ? result->first : none();
 }
 
 size_t DocumentSet::IndexOf(const DocumentKey& key) const {
-  absl::optional<Document> doc = GetDocument(key);
-  return doc ? sorted_set_.find_index(*doc) : npos;
+  if (comparator().orders_by_key()) {
+    return sorted_set_.find_index(Probe(key));
+  }
+
+  const SortedDocument* found = Find(key);
+  return found ? sorted_set_.find_index(*found) : npos;
 }
 
 DocumentSet DocumentSet::insert(
@@ -97,24 +124,31 @@ DocumentSet DocumentSet::insert(
     return *this;
   }
 
-  // Remove any prior mapping of the document's key before adding, preventing
+  // Remove any prior entry for the document's key before adding, preventing
   // the sorted_set_ from accumulating values that aren't in the index.
   const DocumentKey& key = document->key();
-  DocumentSet removed = erase(key);
+  SortedDocument entry = ToSortedDocument(*document);
+
+  SetType set = sorted_set_;
+  if (const SortedDocument* existing = Find(key)) {
+    set = set.erase(*existing);
+  }
+  set = set.insert(entry);
 
-  DocumentMap index = removed.index_.insert(key, *document);
-  SetType set = removed.sorted_set_.insert(*document);
+  // Inserting into the index replaces any existing entry.
+  IndexType index =
+      comparator().orders_by_key() ? index_ : index_.insert(key, entry);
   return {std::move(index), std::move(set)};
 }
 
 DocumentSet DocumentSet::erase(const DocumentKey& key) const {
-  absl::optional<Document> doc = GetDocument(key);
-  if (!doc) {
+  const SortedDocument* existing = Find(key);
+  if (!existing) {
     return *this;
   }
 
-  DocumentMap index = index_.erase(key);
-  SetType set = sorted_set_.erase(*doc);
+  SetType set = sorted_set_.erase(*existing);
+  IndexType index = comparator().orders_by_key() ? index_ : index_.erase(key);
   return {std::move(index), std::move(set)};
 }
 
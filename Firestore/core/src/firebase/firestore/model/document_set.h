@@ -17,16 +17,20 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_SET_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_DOCUMENT_SET_H_
 
+#include <functional>
 #include <iosfwd>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_container.h"
+#include "Firestore/core/src/firebase/firestore/immutable/sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/immutable/sorted_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
-#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/src/firebase/firestore/util/iterator_adaptors.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -34,14 +38,55 @@ namespace model {
 
 class DocumentComparator : public util::FunctionComparator<Document> {
  public:
+  /**
+   * Returns a byte string for a document such that comparing the byte strings
+   * of two documents orders them exactly like the comparison function, or
+   * nullopt if the document's values can't be encoded that way.
+   */
+  using SortKeyFunction =
+      std::function<absl::optional<std::string>(const Document&)>;
+
   using FunctionComparator<Document>::FunctionComparator;
 
+  /**
+   * @param orders_by_key Whether the function orders documents by their keys
+   *     alone, ascending or descending.
+   */
+  DocumentComparator(ComparisonFunction&& function,
+                     SortKeyFunction&& sort_key_function,
+                     bool orders_by_key = false)
+      : FunctionComparator<Document>(std::move(function)),
+        sort_key_function_(std::move(sort_key_function)),
+        orders_by_key_(orders_by_key) {
+  }
+
   static DocumentComparator ByKey();
 
+  /**
+   * Returns true if documents are ordered by their keys alone, so that two
+   * documents with the same key always compare as the same regardless of
+   * their contents.
+   */
+  bool orders_by_key() const {
+    return orders_by_key_;
+  }
+
+  /**
+   * Returns the sort key of the given document, or nullopt if this comparator
+   * has no sort keys or can't encode the document.
+   */
+  absl::optional<std::string> SortKey(const Document& doc) const {
+    return sort_key_function_ ? sort_key_function_(doc) : absl::nullopt;
+  }
+
   // TODO(wilhuff): Remove this using statement
   // This exists to put these two overloads on equal footing. Once the overload
   // below is gone, this using statement can be removed as well.
   using FunctionComparator<Document>::Compare;
+
+ private:
+  SortKeyFunction sort_key_function_;
+  bool orders_by_key_ = false;
 };
 
 /**
@@ -52,15 +97,48 @@ class DocumentComparator : public util::FunctionComparator<Document> {
  */
 class DocumentSet : public immutable::SortedContainer {
  public:
+  /**
+   * A document in the sorted collection, along with its sort key if the
+   * comparator produced one when the document was added.
+   */
+  using SortedDocument = std::pair<Document, absl::optional<std::string>>;
+
+  /**
+   * Orders sorted documents by their sort keys where both have one, and with
+   * the document comparator otherwise.
+   */
+  class SortedDocumentComparator {
+   public:
+    explicit SortedDocumentComparator(DocumentComparator&& comparator)
+        : comparator_(std::move(comparator)) {
+    }
+
+    util::ComparisonResult Compare(const SortedDocument& lhs,
+                                   const SortedDocument& rhs) const {
+      if (lhs.second && rhs.second) {
+        return util::Compare(*lhs.second, *rhs.second);
+      }
+      return comparator_.Compare(lhs.first, rhs.first);
+    }
+
+    const DocumentComparator& comparator() const {
+      return comparator_;
+    }
+
+   private:
+    DocumentComparator comparator_;
+  };
+
   /**
    * The type of the main collection of documents in an DocumentSet.
    * @see sorted_set_.
    */
-  using SetType = immutable::SortedSet<Document, DocumentComparator>;
+  using SetType =
+      immutable::SortedSet<SortedDocument, SortedDocumentComparator>;
 
   // STL container types
   using value_type = Document;
-  using const_iterator = SetType::const_iterator;
+  using const_iterator = util::iterator_first<SetType::const_iterator>;
 
   /**
    * Creates a new, empty DocumentSet sorted by the given comparator, then by
@@ -69,26 +147,26 @@ class DocumentSet : public immutable::SortedContainer {
   explicit DocumentSet(DocumentComparator&& comparator);
 
   size_t size() const {
-    return index_.size();
+    return sorted_set_.size();
   }
 
   /** Returns true if the dictionary contains no elements. */
   bool empty() const {
-    return index_.empty();
+    return sorted_set_.empty();
   }
 
   /** Returns true if this set contains a document with the given key. */
   bool ContainsKey(const DocumentKey& key) const;
 
   const DocumentComparator& comparator() const {
-    return sorted_set_.comparator();
+    return sorted_set_.comparator().comparator();
   }
 
-  SetType::const_iterator begin() const {
-    return sorted_set_.begin();
+  const_iterator begin() const {
+    return const_iterator{sorted_set_.begin()};
   }
-  SetType::const_iterator end() const {
-    return sorted_set_.end();
+  const_iterator end() const {
+    return const_iterator{sorted_set_.end()};
   }
 
   /**
@@ -132,22 +210,49 @@ class DocumentSet : public immutable::SortedContainer {
   size_t Hash() const;
 
  private:
-  DocumentSet(DocumentMap&& index, SetType&& sorted_set)
+  using IndexType = immutable::SortedMap<DocumentKey, SortedDocument>;
+
+  DocumentSet(IndexType&& index, SetType&& sorted_set)
       : index_(std::move(index)), sorted_set_(std::move(sorted_set)) {
   }
 
+  SortedDocument ToSortedDocument(const Document& doc) const {
+    return {doc, comparator().SortKey(doc)};
+  }
+
+  /**
+   * Returns a document that sorts like any document with the given key. Only
+   * valid if the comparator orders by key.
+   */
+  static SortedDocument Probe(const DocumentKey& key);
+
+  /**
+   * Returns the entry in `sorted_set_` of the document with the given key, or
+   * nullptr if there is none. The entry belongs to this set.
+   */
+  const SortedDocument* Find(const DocumentKey& key) const;
+
   /**
-   * An index of the documents in the DocumentSet, indexed by document key.
-   * The index exists to guarantee the uniqueness of document keys in the set
-   * and to allow lookup and removal of documents by key.
+   * An index of the documents in the DocumentSet, indexed by document key,
+   * along with their sort keys. The index exists to guarantee the uniqueness
+   * of document keys in the set and to allow lookup and removal of documents
+   * by key.
+   *
+   * Empty if the comparator orders by key, since `sorted_set_` is then
+   * ordered by key as well and serves lookups by key itself. Each insertion
+   * and removal then only edits a single tree.
    */
-  DocumentMap index_;
+  IndexType index_;
 
   /**
    * The main collection of documents in the DocumentSet. The documents are
    * ordered by a comparator supplied from a query. The SetType collection
    * exists in addition to the index to allow ordered traversal of the
    * DocumentSet.
+   *
+   * Each document carries a sort key computed once when it's added, so that
+   * the comparisons made while inserting, erasing, and looking up documents
+   * compare bytes instead of walking the documents' values.
    */
   SetType sorted_set_;
 };
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
+
+#include <ostream>
+
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+namespace {
+
+const char* KindName(FieldIndex::Segment::Kind kind) {
+  switch (kind) {
+    case FieldIndex::Segment::Kind::Ordered:
+      return "asc";
+    case FieldIndex::Segment::Kind::Contains:
+      return "contains";
+    case FieldIndex::Segment::Kind::Geohash:
+      return "geohash";
+  }
+  return "unknown";
+}
+
+}  // namespace
+
+std::string FieldIndex::CanonicalId() const {
+  std::string result = collection_id_;
+  absl::StrAppend(&result, "|");
+  for (const Segment& segment : segments_) {
+    absl::StrAppend(&result, segment.field_path().CanonicalString(), ":",
+                    KindName(segment.kind()), ",");
+  }
+  return result;
+}
+
+std::string FieldIndex::ToString() const {
+  return absl::StrCat("FieldIndex(", CanonicalId(), ")");
+}
+
+std::ostream& operator<<(std::ostream& os, const FieldIndex& index) {
+  return os << index.ToString();
+}
+
+size_t FieldIndex::Hash() const {
+  size_t result = util::Hash(collection_id_);
+  for (const Segment& segment : segments_) {
+    result = util::Hash(result, segment.field_path(),
+                        static_cast<int>(segment.kind()));
+  }
+  return result;
+}
+
+bool operator==(const FieldIndex& lhs, const FieldIndex& rhs) {
+  return lhs.collection_id() == rhs.collection_id() &&
+         lhs.segments() == rhs.segments();
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
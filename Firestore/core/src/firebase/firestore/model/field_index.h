@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_INDEX_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_INDEX_H_
+
+#include <iosfwd>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+/**
+ * Describes a composite index over one or more fields of the documents in a
+ * collection group (i.e. all collections with the same collection ID).
+ *
+ * Each segment of the index names a field and how values of that field are
+ * indexed. Index entries are ordered by the values of the segments in the order
+ * in which they are declared, so a query can use the index if it constrains a
+ * prefix of the segments with equality filters, optionally followed by a single
+ * range filter.
+ */
+class FieldIndex {
+ public:
+  class Segment {
+   public:
+    enum class Kind {
+      /**
+       * The field value is indexed as a whole, in the order defined by
+       * FieldValue::CompareTo. Supports equality, `in` and range filters.
+       */
+      Ordered,
+
+      /**
+       * Each element of an array field is indexed separately. Supports
+       * `array-contains` and `array-contains-any` filters.
+       */
+      Contains,
+
+      /**
+       * GeoPoint field values are indexed by their geohash, so that documents
+       * within a bounding box can be found by scanning the cells covering it.
+       * Only usable as the first segment of an index, and not by queries.
+       */
+      Geohash,
+    };
+
+    Segment(FieldPath field_path, Kind kind)
+        : field_path_(std::move(field_path)), kind_(kind) {
+    }
+
+    const FieldPath& field_path() const {
+      return field_path_;
+    }
+
+    Kind kind() const {
+      return kind_;
+    }
+
+    friend bool operator==(const Segment& lhs, const Segment& rhs);
+
+   private:
+    FieldPath field_path_;
+    Kind kind_;
+  };
+
+  FieldIndex() = default;
+
+  FieldIndex(std::string collection_id, std::vector<Segment> segments)
+      : collection_id_(std::move(collection_id)),
+        segments_(std::move(segments)) {
+  }
+
+  /** The collection ID of the collection group this index applies to. */
+  const std::string& collection_id() const {
+    return collection_id_;
+  }
+
+  /** The indexed fields, in index order. */
+  const std::vector<Segment>& segments() const {
+    return segments_;
+  }
+
+  /**
+   * Returns a string that uniquely identifies this index among all indexes
+   * over the same collection group. Used to key the index entries.
+   */
+  std::string CanonicalId() const;
+
+  std::string ToString() const;
+
+  friend std::ostream& operator<<(std::ostream& os, const FieldIndex& index);
+
+  size_t Hash() const;
+
+ private:
+  std::string collection_id_;
+  std::vector<Segment> segments_;
+};
+
+inline bool operator==(const FieldIndex::Segment& lhs,
+                       const FieldIndex::Segment& rhs) {
+  return lhs.field_path_ == rhs.field_path_ && lhs.kind_ == rhs.kind_;
+}
+
+inline bool operator!=(const FieldIndex::Segment& lhs,
+                       const FieldIndex::Segment& rhs) {
+  return !(lhs == rhs);
+}
+
+bool operator==(const FieldIndex& lhs, const FieldIndex& rhs);
+
+inline bool operator!=(const FieldIndex& lhs, const FieldIndex& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_INDEX_H_
@@ -114,6 +114,20 @@ FieldPath FieldPath::FromServerFormat(const std::string& path) {
 }
 
 FieldPath FieldPath::FromServerFormatView(absl::string_view path) {
+  // Most paths have no backticks or escapes, and their segments can be split
+  // off whole rather than built up a character at a time.
+  if (path.find_first_of(absl::string_view("`\\\0", 3)) ==
+      absl::string_view::npos) {
+    SegmentsT segments = absl::StrSplit(path, '.');
+    for (const std::string& segment : segments) {
+      HARD_ASSERT(!segment.empty(),
+                  "Invalid field path (%s). Paths must not be empty, begin "
+                  "with '.', end with '.', or contain '..'",
+                  path);
+    }
+    return FieldPath{std::move(segments)};
+  }
+
   SegmentsT segments;
   std::string segment;
   segment.reserve(path.size());
@@ -19,9 +19,11 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <new>
 #include <set>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -59,37 +61,6 @@ const T& Cast(const BaseValue& rep) {
   return static_cast<const T&>(rep);
 }
 
-class NullValue : public FieldValue::BaseValue {
- public:
-  Type type() const override {
-    return Type::Null;
-  }
-
-  std::string ToString() const override {
-    return util::ToString(nullptr);
-  }
-
-  bool Equals(const BaseValue& other) const override {
-    if (type() != other.type()) return false;
-
-    // NullValue is the only instance of itself
-    return true;
-  }
-
-  ComparisonResult CompareTo(const BaseValue& other) const override {
-    ComparisonResult cmp = CompareTypes(other);
-    if (!util::Same(cmp)) return cmp;
-
-    // Null is only comparable with itself and is defined to be the same.
-    return ComparisonResult::Same;
-  }
-
-  size_t Hash() const override {
-    // std::hash is not defined for nullptr_t.
-    return util::Hash(static_cast<void*>(nullptr));
-  }
-};
-
 /**
  * A base class for implementing a "simple" field value type. Simple field
  * values:
@@ -139,76 +110,6 @@ class SimpleFieldValue : public FieldValue::BaseValue {
   ValueType value_;
 };
 
-class BooleanValue : public SimpleFieldValue<Type::Boolean, bool> {
- public:
-  using SimpleFieldValue::SimpleFieldValue;
-};
-
-template <Type type_enum, typename ValueType>
-class NumberValue : public SimpleFieldValue<type_enum, ValueType> {
- public:
-  using SimpleFieldValue<type_enum, ValueType>::SimpleFieldValue;
-
-  ComparisonResult CompareTo(const BaseValue& other) const override;
-};
-
-class IntegerValue : public NumberValue<Type::Integer, int64_t> {
- public:
-  using NumberValue<Type::Integer, int64_t>::NumberValue;
-};
-
-int64_t Integer(const BaseValue& rep) {
-  return Cast<IntegerValue>(rep).value();
-}
-
-class DoubleValue : public NumberValue<Type::Double, double> {
- public:
-  using NumberValue<Type::Double, double>::NumberValue;
-
-  bool Equals(const BaseValue& other) const override {
-    if (type() != other.type()) return false;
-
-    auto& other_value = Cast<DoubleValue>(other);
-    return util::DoubleBitwiseEquals(value(), other_value.value());
-  }
-
-  size_t Hash() const override {
-    return util::DoubleBitwiseHash(value());
-  }
-};
-
-double Double(const BaseValue& rep) {
-  return Cast<DoubleValue>(rep).value();
-}
-
-template <Type type_enum, typename ValueType>
-ComparisonResult NumberValue<type_enum, ValueType>::CompareTo(
-    const BaseValue& other) const {
-  ComparisonResult cmp = this->CompareTypes(other);
-  if (!util::Same(cmp)) return cmp;
-
-  Type this_type = this->type();
-  Type other_type = other.type();
-
-  if (this_type == other_type) {
-    if (this_type == Type::Integer) {
-      return Compare(Integer(*this), Integer(other));
-    } else {
-      return Compare(Double(*this), Double(other));
-    }
-
-  } else {
-    if (this_type == Type::Integer) {
-      // CompareMixedNumber only takes (double, int64_t) so reverse the argument
-      // order and then reverse the result.
-      return util::ReverseOrder(
-          util::CompareMixedNumber(Double(other), Integer(*this)));
-    } else {
-      return util::CompareMixedNumber(Double(*this), Integer(other));
-    }
-  }
-}
-
 // TODO(wilhuff): Use SimpleFieldValue as a base once we migrate to absl::Hash.
 //
 // This can't extend SimpleFieldValue because `util::Hash` is undefined for
@@ -512,9 +413,6 @@ class MapContents : public FieldValue::BaseValue {
 
 }  // namespace
 
-FieldValue::FieldValue() : FieldValue(std::make_shared<NullValue>()) {
-}
-
 bool FieldValue::Comparable(Type lhs, Type rhs) {
   switch (lhs) {
     case Type::Integer:
@@ -530,17 +428,17 @@ bool FieldValue::Comparable(Type lhs, Type rhs) {
 
 bool FieldValue::boolean_value() const {
   HARD_ASSERT(type() == Type::Boolean);
-  return Cast<BooleanValue>(*rep_).value();
+  return boolean_value_;
 }
 
 int64_t FieldValue::integer_value() const {
   HARD_ASSERT(type() == Type::Integer);
-  return Cast<IntegerValue>(*rep_).value();
+  return integer_value_;
 }
 
 double FieldValue::double_value() const {
   HARD_ASSERT(type() == Type::Double);
-  return Cast<DoubleValue>(*rep_).value();
+  return double_value_;
 }
 
 Timestamp FieldValue::timestamp_value() const {
@@ -632,21 +530,29 @@ ObjectValue ObjectValue::Delete(const FieldPath& field_path) const {
 }
 
 absl::optional<FieldValue> ObjectValue::Get(const FieldPath& field_path) const {
+  const FieldValue* value = Find(field_path);
+  if (value == nullptr) {
+    return absl::nullopt;
+  }
+  return *value;
+}
+
+const FieldValue* ObjectValue::Find(const FieldPath& field_path) const {
   const FieldValue* current = &this->fv_;
   for (const auto& path : field_path) {
     if (current->type() != Type::Object) {
-      return absl::nullopt;
+      return nullptr;
     }
 
     const FieldValue::Map& entries = current->object_value();
     const auto iter = entries.find(path);
     if (iter == entries.end()) {
-      return absl::nullopt;
+      return nullptr;
     } else {
       current = &iter->second;
     }
   }
-  return *current;
+  return current;
 }
 
 FieldMask ObjectValue::ToFieldMask() const {
@@ -677,25 +583,160 @@ FieldMask ObjectValue::ToFieldMask() const {
   return FieldMask(fields);
 }
 
+ObjectValue ObjectValue::Project(const FieldMask& mask) const {
+  ObjectValue result = ObjectValue::Empty();
+  for (const FieldPath& path : mask) {
+    if (path.empty()) {
+      return *this;
+    }
+    absl::optional<FieldValue> value = Get(path);
+    if (value) {
+      result = result.Set(path, *value);
+    }
+  }
+  return result;
+}
+
 ObjectValue ObjectValue::SetChild(const std::string& child_name,
                                   const FieldValue& value) const {
   return ObjectValue::FromMap(fv_.object_value().insert(child_name, value));
 }
 
+// ObjectValue::Builder
+
+struct ObjectValue::Builder::Change {
+  // Set if the field is deleted; any changes below it are discarded.
+  bool deleted = false;
+
+  // Replaces the original value of the field, if set.
+  absl::optional<FieldValue> value;
+
+  // Changes to the fields nested in this one, applied on top of `value`, or of
+  // the original value if `value` isn't set.
+  std::map<std::string, std::unique_ptr<Change>> children;
+
+  Change* GetOrAddChild(const std::string& name) {
+    std::unique_ptr<Change>& child = children[name];
+    if (!child) {
+      child = absl::make_unique<Change>();
+    }
+    return child.get();
+  }
+
+  /** Whether this change, or any nested in it, sets a value. */
+  bool SetsValue() const {
+    if (value) return true;
+    for (const auto& kv : children) {
+      if (kv.second->SetsValue()) return true;
+    }
+    return false;
+  }
+
+  /**
+   * Returns the value of the field after applying this change to its original
+   * value, or nullopt if the field ends up absent.
+   */
+  absl::optional<FieldValue> Apply(absl::optional<FieldValue> original) const {
+    if (deleted) return absl::nullopt;
+
+    absl::optional<FieldValue> current = value ? value : std::move(original);
+    if (children.empty()) return current;
+
+    if (!current || current->type() != FieldValue::Type::Object) {
+      // Deletes can't remove anything from a value that isn't an object, but
+      // setting a nested field replaces it with one.
+      if (!SetsValue()) return current;
+      current = FieldValue::EmptyObject();
+    }
+
+    FieldValue::Map::Transient entries{current->object_value()};
+    for (const auto& kv : children) {
+      absl::optional<FieldValue> child =
+          kv.second->Apply(entries.get(kv.first));
+      if (child) {
+        entries.insert(kv.first, *child);
+      } else {
+        entries.erase(kv.first);
+      }
+    }
+    return FieldValue::FromMap(std::move(entries).freeze());
+  }
+};
+
+ObjectValue::Builder::Builder(ObjectValue base)
+    : base_{std::move(base)}, root_{absl::make_unique<Change>()} {
+}
+
+ObjectValue::Builder::~Builder() = default;
+
+void ObjectValue::Builder::Set(const FieldPath& field_path,
+                               const FieldValue& value) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot set field for empty path on FieldValue");
+
+  Change* change = root_.get();
+  for (size_t i = 0; i + 1 < field_path.size(); ++i) {
+    change = change->GetOrAddChild(field_path[i]);
+    // A parent that was deleted or replaced with a primitive becomes an empty
+    // object to hold the field.
+    if (change->deleted ||
+        (change->value && change->value->type() != Type::Object)) {
+      change->deleted = false;
+      change->value = FieldValue::EmptyObject();
+      change->children.clear();
+    }
+  }
+
+  change = change->GetOrAddChild(field_path.last_segment());
+  change->deleted = false;
+  change->value = value;
+  change->children.clear();
+}
+
+void ObjectValue::Builder::Delete(const FieldPath& field_path) {
+  HARD_ASSERT(!field_path.empty(),
+              "Cannot delete field for empty path on FieldValue");
+
+  Change* change = root_.get();
+  for (size_t i = 0; i + 1 < field_path.size(); ++i) {
+    change = change->GetOrAddChild(field_path[i]);
+    // A parent that was deleted or replaced with a primitive can't contain
+    // the field.
+    if (change->deleted ||
+        (change->value && change->value->type() != Type::Object)) {
+      return;
+    }
+  }
+
+  change = change->GetOrAddChild(field_path.last_segment());
+  change->deleted = true;
+  change->value = absl::nullopt;
+  change->children.clear();
+}
+
+ObjectValue ObjectValue::Builder::Build() const {
+  absl::optional<FieldValue> result = root_->Apply(base_.AsFieldValue());
+  HARD_ASSERT(result.has_value(), "The root of an object can't be deleted");
+  return ObjectValue{std::move(result).value()};
+}
+
 FieldValue FieldValue::Null() {
   return FieldValue();
 }
 
 FieldValue FieldValue::True() {
-  return FieldValue(std::make_shared<BooleanValue>(true));
+  return FromBoolean(true);
 }
 
 FieldValue FieldValue::False() {
-  return FieldValue(std::make_shared<BooleanValue>(false));
+  return FromBoolean(false);
 }
 
 FieldValue FieldValue::FromBoolean(bool value) {
-  return value ? True() : False();
+  FieldValue result;
+  result.type_ = Type::Boolean;
+  result.boolean_value_ = value;
+  return result;
 }
 
 FieldValue FieldValue::Nan() {
@@ -707,7 +748,10 @@ FieldValue FieldValue::EmptyObject() {
 }
 
 FieldValue FieldValue::FromInteger(int64_t value) {
-  return FieldValue(std::make_shared<IntegerValue>(value));
+  FieldValue result;
+  result.type_ = Type::Integer;
+  result.integer_value_ = value;
+  return result;
 }
 
 // We use a canonical NaN bit pattern that's common for both Objective-C and
@@ -729,11 +773,14 @@ FieldValue FieldValue::FromDouble(double value) {
     value = canonical_nan;
   }
 
-  return FieldValue(std::make_shared<DoubleValue>(value));
+  FieldValue result;
+  result.type_ = Type::Double;
+  result.double_value_ = value;
+  return result;
 }
 
 FieldValue FieldValue::FromTimestamp(const Timestamp& value) {
-  return FieldValue(std::make_shared<TimestampValue>(value));
+  return FieldValue(absl::make_unique<TimestampValue>(value));
 }
 
 FieldValue FieldValue::FromServerTimestamp(const Timestamp& local_write_time) {
@@ -743,53 +790,144 @@ FieldValue FieldValue::FromServerTimestamp(const Timestamp& local_write_time) {
 FieldValue FieldValue::FromServerTimestamp(
     const Timestamp& local_write_time,
     absl::optional<FieldValue> previous_value) {
-  return FieldValue(std::make_shared<ServerTimestampValue>(
+  return FieldValue(absl::make_unique<ServerTimestampValue>(
       ServerTimestamp(local_write_time, std::move(previous_value))));
 }
 
 FieldValue FieldValue::FromString(const char* value) {
-  return FieldValue(std::make_shared<StringValue>(value));
+  return FieldValue(absl::make_unique<StringValue>(value));
 }
 
 FieldValue FieldValue::FromString(const std::string& value) {
-  return FieldValue(std::make_shared<StringValue>(value));
+  return FieldValue(absl::make_unique<StringValue>(value));
 }
 
 FieldValue FieldValue::FromString(std::string&& value) {
-  return FieldValue(std::make_shared<StringValue>(std::move(value)));
+  return FieldValue(absl::make_unique<StringValue>(std::move(value)));
 }
 
 FieldValue FieldValue::FromBlob(ByteString blob) {
-  return FieldValue(std::make_shared<BlobValue>(std::move(blob)));
+  return FieldValue(absl::make_unique<BlobValue>(std::move(blob)));
 }
 
 FieldValue FieldValue::FromReference(DatabaseId database_id, DocumentKey key) {
-  return FieldValue(std::make_shared<ReferenceValue>(
+  return FieldValue(absl::make_unique<ReferenceValue>(
       Reference(std::move(database_id), std::move(key))));
 }
 
 FieldValue FieldValue::FromGeoPoint(const GeoPoint& value) {
-  return FieldValue(std::make_shared<GeoPointValue>(value));
+  return FieldValue(absl::make_unique<GeoPointValue>(value));
 }
 
 FieldValue FieldValue::FromArray(const Array& value) {
-  return FieldValue(std::make_shared<ArrayContents>(value));
+  return FieldValue(absl::make_unique<ArrayContents>(value));
 }
 
 FieldValue FieldValue::FromArray(Array&& value) {
-  return FieldValue(std::make_shared<ArrayContents>(std::move(value)));
+  return FieldValue(absl::make_unique<ArrayContents>(std::move(value)));
 }
 
 FieldValue FieldValue::FromMap(const Map& value) {
-  return FieldValue(std::make_shared<MapContents>(value));
+  return FieldValue(absl::make_unique<MapContents>(value));
 }
 
 FieldValue FieldValue::FromMap(FieldValue::Map&& value) {
-  return FieldValue(std::make_shared<MapContents>(std::move(value)));
+  return FieldValue(absl::make_unique<MapContents>(std::move(value)));
 }
 
 bool operator==(const FieldValue& lhs, const FieldValue& rhs) {
-  return lhs.rep_->Equals(*rhs.rep_);
+  Type type = lhs.type();
+  if (type != rhs.type()) return false;
+
+  switch (type) {
+    case Type::Null:
+      return true;
+    case Type::Boolean:
+      return lhs.boolean_value() == rhs.boolean_value();
+    case Type::Integer:
+      return lhs.integer_value() == rhs.integer_value();
+    case Type::Double:
+      return util::DoubleBitwiseEquals(lhs.double_value(), rhs.double_value());
+    case Type::String:
+      return lhs.string_value() == rhs.string_value();
+    default:
+      // Copies share their representation, so they don't need to be walked.
+      return lhs.rep_ == rhs.rep_ || lhs.rep_->Equals(*rhs.rep_);
+  }
+}
+
+ComparisonResult FieldValue::CompareTo(const FieldValue& rhs) const {
+  Type this_type = type();
+  Type other_type = rhs.type();
+  if (!Comparable(this_type, other_type)) {
+    return Compare(this_type, other_type);
+  }
+
+  switch (this_type) {
+    case Type::Null:
+      // Null is only comparable with itself and is defined to be the same.
+      return ComparisonResult::Same;
+    case Type::Boolean:
+      return Compare(boolean_value(), rhs.boolean_value());
+    case Type::Integer:
+      if (other_type == Type::Integer) {
+        return Compare(integer_value(), rhs.integer_value());
+      }
+      // CompareMixedNumber only takes (double, int64_t) so reverse the
+      // argument order and then reverse the result.
+      return util::ReverseOrder(
+          util::CompareMixedNumber(rhs.double_value(), integer_value()));
+    case Type::Double:
+      if (other_type == Type::Double) {
+        return Compare(double_value(), rhs.double_value());
+      }
+      return util::CompareMixedNumber(double_value(), rhs.integer_value());
+    case Type::String:
+      return Compare(string_value(), rhs.string_value());
+    case Type::Timestamp:
+      if (other_type == Type::Timestamp) {
+        return Compare(Cast<TimestampValue>(*rep_).value(),
+                       Cast<TimestampValue>(*rhs.rep_).value());
+      }
+      return rep_->CompareTo(*rhs.rep_);
+    default:
+      return rep_->CompareTo(*rhs.rep_);
+  }
+}
+
+size_t FieldValue::Hash() const {
+  switch (type()) {
+    case Type::Null:
+      // std::hash is not defined for nullptr_t.
+      return util::Hash(static_cast<void*>(nullptr));
+    case Type::Boolean:
+      return util::Hash(boolean_value());
+    case Type::Integer:
+      return util::Hash(integer_value());
+    case Type::Double:
+      return util::DoubleBitwiseHash(double_value());
+    case Type::String:
+      return util::Hash(string_value());
+    default:
+      return rep_->Hash();
+  }
+}
+
+std::string FieldValue::ToString() const {
+  switch (type()) {
+    case Type::Null:
+      return util::ToString(nullptr);
+    case Type::Boolean:
+      return util::ToString(boolean_value());
+    case Type::Integer:
+      return util::ToString(integer_value());
+    case Type::Double:
+      return util::ToString(double_value());
+    case Type::String:
+      return util::ToString(string_value());
+    default:
+      return rep_->ToString();
+  }
 }
 
 std::ostream& operator<<(std::ostream& os, const FieldValue& value) {
@@ -17,8 +17,10 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_MODEL_FIELD_VALUE_H_
 
+#include <atomic>
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <iosfwd>
 #include <memory>
 #include <string>
@@ -50,6 +52,10 @@ class ObjectValue;
  * tagged-union class representing an immutable data value as stored in
  * Firestore. FieldValue represents all the different kinds of values
  * that can be stored in fields in a document.
+ *
+ * Nulls, booleans and numbers are stored inline, so they can be created and
+ * copied without allocating. All other values are held in a shared, immutable
+ * representation.
  */
 class FieldValue {
  public:
@@ -82,13 +88,47 @@ class FieldValue {
     // position instead, see the doc comment above.
   };
 
-  FieldValue();
+  FieldValue() : integer_value_{0} {
+  }
 
   FieldValue(ObjectValue object);  // NOLINT(runtime/explicit)
 
+  FieldValue(const FieldValue& other) : type_{other.type_} {
+    CopyValue(other);
+    if (IsShared(type_)) {
+      rep_->AddRef();
+    }
+  }
+
+  FieldValue(FieldValue&& other) noexcept : type_{other.type_} {
+    CopyValue(other);
+    other.type_ = Type::Null;
+    other.integer_value_ = 0;
+  }
+
+  ~FieldValue() {
+    Release();
+  }
+
+  FieldValue& operator=(const FieldValue& other) {
+    // Copy first: `other` may be owned by this value.
+    return *this = FieldValue{other};
+  }
+
+  FieldValue& operator=(FieldValue&& other) noexcept {
+    if (this != &other) {
+      FieldValue moved{std::move(other)};
+      Release();
+      type_ = moved.type_;
+      CopyValue(moved);
+      moved.type_ = Type::Null;
+    }
+    return *this;
+  }
+
   /** Returns the true type for this value. */
   Type type() const {
-    return rep_->type();
+    return type_;
   }
 
   bool is_boolean() const {
@@ -219,13 +259,9 @@ class FieldValue {
   static FieldValue FromMap(const Map& value);
   static FieldValue FromMap(Map&& value);
 
-  size_t Hash() const {
-    return rep_->Hash();
-  }
+  size_t Hash() const;
 
-  util::ComparisonResult CompareTo(const FieldValue& rhs) const {
-    return rep_->CompareTo(*rhs.rep_);
-  }
+  util::ComparisonResult CompareTo(const FieldValue& rhs) const;
 
   /**
    * Checks if the two values are equal, returning false if the value is
@@ -248,9 +284,7 @@ class FieldValue {
    */
   friend bool operator==(const FieldValue& lhs, const FieldValue& rhs);
 
-  std::string ToString() const {
-    return rep_->ToString();
-  }
+  std::string ToString() const;
 
   friend std::ostream& operator<<(std::ostream& os, const FieldValue& value);
 
@@ -269,20 +303,79 @@ class FieldValue {
 
     virtual size_t Hash() const = 0;
 
+    void AddRef() const {
+      ref_count_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /** Drops a reference, deleting this value once the last one is gone. */
+    void Release() const {
+      if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+      }
+    }
+
    protected:
     util::ComparisonResult CompareTypes(const BaseValue& other) const;
+
+   private:
+    // FieldValue holds its representation through a plain pointer with this
+    // count, instead of a shared_ptr, so that it fits in two words along with
+    // its type.
+    mutable std::atomic<int32_t> ref_count_{1};
   };
 
  private:
-  explicit FieldValue(std::shared_ptr<BaseValue> rep) : rep_(std::move(rep)) {
+  /**
+   * Returns true if values of the given type are held in rep_ rather than
+   * inline.
+   */
+  static bool IsShared(Type type) {
+    switch (type) {
+      case Type::Null:
+      case Type::Boolean:
+      case Type::Integer:
+      case Type::Double:
+        return false;
+      default:
+        return true;
+    }
+  }
+
+  /** Takes ownership of the given representation. */
+  explicit FieldValue(std::unique_ptr<BaseValue> rep)
+      : type_{rep->type()}, rep_{rep.release()} {
   }
 
-  std::shared_ptr<BaseValue> rep_;
+  /**
+   * Copies the contents of the union, whichever member is active, without
+   * touching ref counts.
+   */
+  void CopyValue(const FieldValue& other) noexcept {
+    static_assert(sizeof(integer_value_) >= sizeof(rep_),
+                  "union members must fit in integer_value_");
+    std::memcpy(&integer_value_, &other.integer_value_, sizeof(integer_value_));
+  }
+
+  void Release() noexcept {
+    if (IsShared(type_)) {
+      rep_->Release();
+    }
+  }
+
+  Type type_ = Type::Null;
+  union {
+    bool boolean_value_;
+    int64_t integer_value_;
+    double double_value_;
+    const BaseValue* rep_;
+  };
 };
 
 /** A structured object value stored in Firestore. */
 class ObjectValue : public util::Comparable<ObjectValue> {
  public:
+  class Builder;
+
   // Default constructible to make using this easy, though prefer
   // ObjectValue::Empty() to make intentions clear to readers.
   ObjectValue();
@@ -305,6 +398,13 @@ class ObjectValue : public util::Comparable<ObjectValue> {
    */
   absl::optional<FieldValue> Get(const FieldPath& field_path) const;
 
+  /**
+   * Like `Get`, but returns a pointer to the value within this object instead
+   * of a copy, or nullptr if there is no value at the path. The pointer stays
+   * valid for as long as this object, or any copy of it, is alive.
+   */
+  const FieldValue* Find(const FieldPath& field_path) const;
+
   /**
    * Returns a FieldValue with the field at the named path set to value.
    * Any absent parent of the field will also be created accordingly.
@@ -333,6 +433,12 @@ class ObjectValue : public util::Comparable<ObjectValue> {
    */
   FieldMask ToFieldMask() const;
 
+  /**
+   * Returns a copy of this ObjectValue that contains only the fields covered by
+   * the given mask. Fields of the mask that are not present are skipped.
+   */
+  ObjectValue Project(const FieldMask& mask) const;
+
   // TODO(rsgowman): Add Value() method?
   //
   // Java has a value() method which returns a (non-immutable) java.util.Map,
@@ -363,6 +469,36 @@ class ObjectValue : public util::Comparable<ObjectValue> {
   FieldValue fv_;
 };
 
+/**
+ * Applies a batch of `Set` and `Delete` changes to an ObjectValue. Chaining
+ * the `ObjectValue` methods copies every map from the root down to each
+ * changed field once per change; the builder records the changes and then
+ * rebuilds each affected map once, however many of the changes fall under it.
+ *
+ * Changes take effect in the order they are made, exactly as if the
+ * corresponding `ObjectValue` methods had been chained.
+ */
+class ObjectValue::Builder {
+ public:
+  explicit Builder(ObjectValue base);
+  ~Builder();
+
+  /** Sets the field at the given path, creating any absent parent. */
+  void Set(const FieldPath& field_path, const FieldValue& value);
+
+  /** Deletes the field at the given path, if there is one. */
+  void Delete(const FieldPath& field_path);
+
+  /** Returns the base object with all the changes applied. */
+  ObjectValue Build() const;
+
+ private:
+  struct Change;
+
+  ObjectValue base_;
+  std::unique_ptr<Change> root_;
+};
+
 class FieldValue::Reference {
  public:
   Reference(DatabaseId database_id, DocumentKey key)
@@ -431,6 +567,13 @@ inline bool operator>=(const FieldValue& lhs, const FieldValue& rhs) {
   return !(lhs < rhs);
 }
 
+/** Hashes FieldValues consistently with operator==. */
+struct FieldValueHash {
+  size_t operator()(const FieldValue& value) const {
+    return value.Hash();
+  }
+};
+
 // A bit pattern for our canonical NaN value. Exposed here for testing.
 ABSL_CONST_INIT extern const uint64_t kCanonicalNanBits;
 
@@ -56,6 +56,7 @@ class DocumentComparator;
 class DocumentKey;
 class DocumentMap;
 class DocumentSet;
+class FieldIndex;
 class FieldMask;
 class FieldPath;
 class FieldTransform;
@@ -69,6 +70,7 @@ class NoDocument;
 class ObjectValue;
 class PatchMutation;
 class Precondition;
+class ResourcePath;
 class SetMutation;
 class SnapshotVersion;
 class TransformMutation;
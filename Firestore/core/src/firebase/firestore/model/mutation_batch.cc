@@ -16,12 +16,19 @@
 
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 
+#include <algorithm>
+#include <memory>
 #include <ostream>
+#include <set>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch_result.h"
+#include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/to_string.h"
 
@@ -29,15 +36,71 @@ namespace firebase {
 namespace firestore {
 namespace model {
 
+namespace {
+
+/**
+ * Returns whether a write guarded by `earlier` can absorb a later write guarded
+ * by `later`, keeping only the earlier precondition. Once an earlier set or
+ * patch has applied, the document exists, so a later `exists` precondition
+ * holds. A later write without a precondition applies even when the earlier
+ * one fails, so it can only be absorbed by a write that can't fail either.
+ */
+bool CanKeepEarlierPrecondition(const Precondition& earlier,
+                                const Precondition& later) {
+  if (later.is_none()) return earlier.is_none();
+  if (later == Precondition::Exists(true)) {
+    return earlier.is_none() || earlier == later;
+  }
+  return false;
+}
+
+/**
+ * Returns a single mutation with the effect of `earlier` followed by `later`
+ * on the same document, or nullopt if there isn't one.
+ */
+absl::optional<Mutation> CompactMutations(const Mutation& earlier,
+                                          const Mutation& later) {
+  if ((earlier.type() != Mutation::Type::Set &&
+       earlier.type() != Mutation::Type::Patch) ||
+      !CanKeepEarlierPrecondition(earlier.precondition(),
+                                  later.precondition())) {
+    return absl::nullopt;
+  }
+
+  if (later.type() == Mutation::Type::Set) {
+    SetMutation set(later);
+    return SetMutation(set.key(), set.value(), earlier.precondition());
+  }
+  if (later.type() != Mutation::Type::Patch) return absl::nullopt;
+
+  PatchMutation patch(later);
+  if (earlier.type() == Mutation::Type::Set) {
+    SetMutation set(earlier);
+    return SetMutation(set.key(), patch.ApplyToObject(set.value()),
+                       set.precondition());
+  }
+
+  PatchMutation first(earlier);
+  std::set<FieldPath> fields(first.mask().begin(), first.mask().end());
+  fields.insert(patch.mask().begin(), patch.mask().end());
+  ObjectValue value =
+      patch.ApplyToObject(first.ApplyToObject(ObjectValue::Empty()));
+  return PatchMutation(first.key(), std::move(value),
+                       FieldMask(std::move(fields)), first.precondition());
+}
+
+}  // namespace
+
 MutationBatch::MutationBatch(int batch_id,
                              Timestamp local_write_time,
                              std::vector<Mutation> base_mutations,
                              std::vector<Mutation> mutations)
     : batch_id_(batch_id),
       local_write_time_(std::move(local_write_time)),
-      base_mutations_(std::move(base_mutations)),
-      mutations_(std::move(mutations)) {
-  HARD_ASSERT(!mutations_.empty(), "Cannot create an empty mutation batch");
+      rep_(std::make_shared<const Rep>(
+          Rep{std::move(base_mutations), std::move(mutations)})) {
+  HARD_ASSERT(!rep_->mutations.empty(),
+              "Cannot create an empty mutation batch");
 }
 
 absl::optional<MaybeDocument> MutationBatch::ApplyToRemoteDocument(
@@ -49,12 +112,12 @@ absl::optional<MaybeDocument> MutationBatch::ApplyToRemoteDocument(
               document_key.ToString(), maybe_doc->key().ToString());
 
   const auto& mutation_results = mutation_batch_result.mutation_results();
-  HARD_ASSERT(mutation_results.size() == mutations_.size(),
+  HARD_ASSERT(mutation_results.size() == mutations().size(),
               "Mismatch between mutations length (%s) and results length (%s)",
-              mutations_.size(), mutation_results.size());
+              mutations().size(), mutation_results.size());
 
-  for (size_t i = 0; i < mutations_.size(); i++) {
-    const Mutation& mutation = mutations_[i];
+  for (size_t i = 0; i < mutations().size(); i++) {
+    const Mutation& mutation = mutations()[i];
     const MutationResult& mutation_result = mutation_results[i];
     if (mutation.key() == document_key) {
       maybe_doc = mutation.ApplyToRemoteDocument(maybe_doc, mutation_result);
@@ -72,7 +135,7 @@ absl::optional<MaybeDocument> MutationBatch::ApplyToLocalDocument(
 
   // First, apply the base state. This allows us to apply non-idempotent
   // transform against a consistent set of values.
-  for (const Mutation& mutation : base_mutations_) {
+  for (const Mutation& mutation : base_mutations()) {
     if (mutation.key() == document_key) {
       maybe_doc =
           mutation.ApplyToLocalView(maybe_doc, maybe_doc, local_write_time_);
@@ -82,7 +145,7 @@ absl::optional<MaybeDocument> MutationBatch::ApplyToLocalDocument(
   absl::optional<MaybeDocument> base_doc = maybe_doc;
 
   // Second, apply all user-provided mutations.
-  for (const Mutation& mutation : mutations_) {
+  for (const Mutation& mutation : mutations()) {
     if (mutation.key() == document_key) {
       maybe_doc =
           mutation.ApplyToLocalView(maybe_doc, base_doc, local_write_time_);
@@ -98,7 +161,7 @@ MaybeDocumentMap MutationBatch::ApplyToLocalDocumentSet(
   // reduce the complexity to O(n).
 
   MaybeDocumentMap mutated_documents = document_set;
-  for (const Mutation& mutation : mutations_) {
+  for (const Mutation& mutation : mutations()) {
     const DocumentKey& key = mutation.key();
 
     absl::optional<MaybeDocument> previous_document =
@@ -114,12 +177,35 @@ MaybeDocumentMap MutationBatch::ApplyToLocalDocumentSet(
 
 DocumentKeySet MutationBatch::keys() const {
   DocumentKeySet set;
-  for (const Mutation& mutation : mutations_) {
+  for (const Mutation& mutation : mutations()) {
     set = set.insert(mutation.key());
   }
   return set;
 }
 
+absl::optional<MutationBatch> MutationBatch::CompactWith(
+    const std::vector<Mutation>& later) const {
+  if (!base_mutations().empty() || later.size() != mutations().size() ||
+      keys().size() != mutations().size()) {
+    return absl::nullopt;
+  }
+
+  std::vector<Mutation> compacted;
+  compacted.reserve(mutations().size());
+  for (const Mutation& mutation : mutations()) {
+    auto found = std::find_if(later.begin(), later.end(),
+                              [&](const Mutation& later_mutation) {
+                                return later_mutation.key() == mutation.key();
+                              });
+    if (found == later.end()) return absl::nullopt;
+
+    absl::optional<Mutation> combined = CompactMutations(mutation, *found);
+    if (!combined) return absl::nullopt;
+    compacted.push_back(*std::move(combined));
+  }
+  return MutationBatch(batch_id_, local_write_time_, {}, std::move(compacted));
+}
+
 bool operator==(const MutationBatch& lhs, const MutationBatch& rhs) {
   return lhs.batch_id() == rhs.batch_id() &&
          lhs.local_write_time() == rhs.local_write_time() &&
@@ -130,7 +216,7 @@ bool operator==(const MutationBatch& lhs, const MutationBatch& rhs) {
 std::string MutationBatch::ToString() const {
   return absl::StrCat("MutationBatch(id=", batch_id_,
                       ", local_write_time=", local_write_time_.ToString(),
-                      ", mutations=", util::ToString(mutations_), ")");
+                      ", mutations=", util::ToString(mutations()), ")");
 }
 
 std::ostream& operator<<(std::ostream& os, const MutationBatch& batch) {
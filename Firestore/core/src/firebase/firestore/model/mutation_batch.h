@@ -26,6 +26,7 @@
 #include "Firestore/core/src/firebase/firestore/model/model_fwd.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -72,7 +73,7 @@ class MutationBatch {
    * the backend.
    */
   const std::vector<Mutation>& base_mutations() const {
-    return base_mutations_;
+    return rep_->base_mutations;
   }
 
   /**
@@ -80,7 +81,7 @@ class MutationBatch {
    * mutations are applied both locally and remotely on the backend.
    */
   const std::vector<Mutation>& mutations() const {
-    return mutations_;
+    return rep_->mutations;
   }
 
   /**
@@ -126,6 +127,22 @@ class MutationBatch {
    */
   DocumentKeySet keys() const;
 
+  /**
+   * Returns a batch with the same ID and the same effect as this batch
+   * followed by a batch of the `later` mutations, or nullopt if they can't be
+   * combined.
+   *
+   * Only sets and patches combine, and only if both batches write each of the
+   * same documents once: a set or patch followed by patches becomes a single
+   * set or patch, and a set or patch followed by a set becomes the later set.
+   * The combined write keeps the earlier precondition, so writes only combine
+   * if that precondition is enough for the later one: a later write without a
+   * precondition (such as a merging set) doesn't combine with an earlier
+   * update, which fails if the document is missing.
+   */
+  absl::optional<MutationBatch> CompactWith(
+      const std::vector<Mutation>& later) const;
+
   friend bool operator==(const MutationBatch& lhs, const MutationBatch& rhs);
 
   std::string ToString() const;
@@ -133,10 +150,17 @@ class MutationBatch {
   friend std::ostream& operator<<(std::ostream& os, const MutationBatch& batch);
 
  private:
+  struct Rep {
+    std::vector<Mutation> base_mutations;
+    std::vector<Mutation> mutations;
+  };
+
   int batch_id_;
   Timestamp local_write_time_;
-  std::vector<Mutation> base_mutations_;
-  std::vector<Mutation> mutations_;
+
+  // Immutable and shared between copies, so that copying a batch out of a
+  // mutation queue doesn't copy its mutations.
+  std::shared_ptr<const Rep> rep_;
 };
 
 inline bool operator!=(const MutationBatch& lhs, const MutationBatch& rhs) {
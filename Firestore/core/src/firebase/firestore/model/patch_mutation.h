@@ -75,6 +75,11 @@ class PatchMutation : public Mutation {
     return patch_rep().mask();
   }
 
+  /** Returns the given object with the patch applied to it. */
+  ObjectValue ApplyToObject(ObjectValue object) const {
+    return patch_rep().PatchObject(std::move(object));
+  }
+
  private:
   class Rep : public Mutation::Rep {
    public:
@@ -110,12 +115,12 @@ class PatchMutation : public Mutation {
 
     std::string ToString() const override;
 
+    ObjectValue PatchObject(ObjectValue obj) const;
+
    private:
     ObjectValue PatchDocument(
         const absl::optional<MaybeDocument>& maybe_doc) const;
 
-    ObjectValue PatchObject(ObjectValue obj) const;
-
     ObjectValue value_;
     FieldMask mask_;
   };
@@ -16,9 +16,12 @@
 
 #include "Firestore/core/src/firebase/firestore/model/transform_mutation.h"
 
+#include <cstdint>
+#include <limits>
 #include <memory>
 #include <set>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
@@ -118,6 +121,71 @@ absl::optional<MaybeDocument> TransformMutation::Rep::ApplyToLocalView(
                   DocumentState::kLocalMutations);
 }
 
+namespace {
+
+/**
+ * Returns a single transform with the effect of applying `first` and then
+ * `second` to the same field, if there is one.
+ */
+absl::optional<TransformOperation> CombineTransforms(
+    const TransformOperation& first, const TransformOperation& second) {
+  using Type = TransformOperation::Type;
+
+  if (first.type() == Type::ArrayUnion && second.type() == Type::ArrayUnion) {
+    std::vector<FieldValue> elements = ArrayTransform(first).elements();
+    const std::vector<FieldValue>& more = ArrayTransform(second).elements();
+    elements.insert(elements.end(), more.begin(), more.end());
+    return ArrayTransform(Type::ArrayUnion, std::move(elements));
+  }
+
+  if (first.type() == Type::Increment && second.type() == Type::Increment) {
+    const FieldValue& a = NumericIncrementTransform(first).operand();
+    const FieldValue& b = NumericIncrementTransform(second).operand();
+    if (!a.is_integer() || !b.is_integer()) {
+      return absl::nullopt;
+    }
+
+    // Increments saturate, so only increments in the same direction can be
+    // added up front, and only if their sum doesn't saturate itself.
+    int64_t x = a.integer_value();
+    int64_t y = b.integer_value();
+    if ((x >= 0 && y >= 0 && x <= std::numeric_limits<int64_t>::max() - y) ||
+        (x < 0 && y < 0 && x >= std::numeric_limits<int64_t>::min() - y)) {
+      return NumericIncrementTransform(FieldValue::FromInteger(x + y));
+    }
+  }
+
+  return absl::nullopt;
+}
+
+}  // namespace
+
+absl::optional<TransformMutation> TransformMutation::CombineForLocalView(
+    const TransformMutation& next) const {
+  const std::vector<FieldTransform>& first = field_transforms();
+  const std::vector<FieldTransform>& second = next.field_transforms();
+  if (key() != next.key() || first.size() != second.size()) {
+    return absl::nullopt;
+  }
+
+  std::vector<FieldTransform> combined;
+  combined.reserve(first.size());
+  for (size_t i = 0; i < first.size(); ++i) {
+    if (first[i].path() != second[i].path()) {
+      return absl::nullopt;
+    }
+
+    absl::optional<TransformOperation> transform = CombineTransforms(
+        first[i].transformation(), second[i].transformation());
+    if (!transform) {
+      return absl::nullopt;
+    }
+    combined.emplace_back(first[i].path(), *transform);
+  }
+
+  return TransformMutation(key(), std::move(combined));
+}
+
 absl::optional<ObjectValue> TransformMutation::Rep::ExtractBaseValue(
     const absl::optional<MaybeDocument>& maybe_doc) const {
   absl::optional<ObjectValue> base_object;
@@ -209,12 +277,13 @@ ObjectValue TransformMutation::Rep::TransformObject(
   HARD_ASSERT(transform_results.size() == field_transforms_.size(),
               "Transform results size mismatch.");
 
+  ObjectValue::Builder builder{std::move(object_value)};
   for (size_t i = 0; i < field_transforms_.size(); i++) {
     const FieldTransform& field_transform = field_transforms_[i];
     const FieldPath& field_path = field_transform.path();
-    object_value = object_value.Set(field_path, transform_results[i]);
+    builder.Set(field_path, transform_results[i]);
   }
-  return object_value;
+  return builder.Build();
 }
 
 }  // namespace model
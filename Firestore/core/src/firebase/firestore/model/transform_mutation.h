@@ -57,6 +57,20 @@ class TransformMutation : public Mutation {
     return set_rep().field_transforms();
   }
 
+  /**
+   * Returns a single mutation whose local view is that of applying this
+   * mutation and then `next`, or nullopt if the two can't be combined. They
+   * can if they transform the same fields in the same order, each with either
+   * increments by integers of the same sign or array unions, which is what
+   * repeated writes to counters and sets look like.
+   *
+   * A field holding a double may round differently when incremented by the
+   * sum than when incremented twice; this only affects the local view until
+   * the backend's result replaces it.
+   */
+  absl::optional<TransformMutation> CombineForLocalView(
+      const TransformMutation& next) const;
+
  private:
   class Rep : public Mutation::Rep {
    public:
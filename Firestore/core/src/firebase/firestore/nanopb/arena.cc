@@ -0,0 +1,179 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "Firestore/core/src/firebase/firestore/nanopb/pb_system.h"
+#include "Firestore/core/src/firebase/firestore/util/thread_local.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+namespace {
+
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+// Blocks grow geometrically, but not without bound, so that a single large
+// proto doesn't end up with a block far larger than it needs.
+constexpr size_t kMaxBlockSize = 64 * 1024;
+
+/**
+ * Each allocation is preceded by a header recording its size, so that
+ * `Reallocate` knows how many bytes to copy.
+ */
+struct Header {
+  size_t size;
+};
+
+constexpr size_t kHeaderSize =
+    (sizeof(Header) + kAlignment - 1) / kAlignment * kAlignment;
+
+size_t RoundUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+Header* HeaderOf(void* ptr) {
+  return reinterpret_cast<Header*>(static_cast<char*>(ptr) - kHeaderSize);
+}
+
+util::ThreadLocal<Arena*> current_arena;
+
+}  // namespace
+
+Arena::Arena(size_t initial_block_size)
+    : initial_block_size_(std::max(initial_block_size, kAlignment)) {
+}
+
+void* Arena::Allocate(size_t size) {
+  size_t needed = kHeaderSize + RoundUp(size);
+  Block* block = BlockFor(needed);
+
+  char* result = block->data.get() + block->used + kHeaderSize;
+  block->used += needed;
+  allocated_bytes_ += needed;
+
+  HeaderOf(result)->size = size;
+  last_allocation_ = result;
+  return result;
+}
+
+void* Arena::Reallocate(void* ptr, size_t size) {
+  if (!ptr) {
+    return Allocate(size);
+  }
+
+  Header* header = HeaderOf(ptr);
+  size_t old_size = header->size;
+  if (size <= RoundUp(old_size)) {
+    header->size = size;
+    return ptr;
+  }
+
+  if (ptr == last_allocation_) {
+    Block& block = blocks_.back();
+    size_t grow_by = RoundUp(size) - RoundUp(old_size);
+    if (block.size - block.used >= grow_by) {
+      block.used += grow_by;
+      allocated_bytes_ += grow_by;
+      header->size = size;
+      return ptr;
+    }
+  }
+
+  void* result = Allocate(size);
+  std::memcpy(result, ptr, std::min(old_size, size));
+  return result;
+}
+
+bool Arena::Contains(const void* ptr) const {
+  const char* p = static_cast<const char*>(ptr);
+  for (const Block& block : blocks_) {
+    const char* begin = block.data.get();
+    if (p >= begin && p < begin + block.size) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Arena::Reset() {
+  blocks_.clear();
+  allocated_bytes_ = 0;
+  last_allocation_ = nullptr;
+}
+
+Arena::Block* Arena::BlockFor(size_t size) {
+  if (!blocks_.empty()) {
+    Block& last = blocks_.back();
+    if (last.size - last.used >= size) {
+      return &last;
+    }
+  }
+
+  size_t block_size = initial_block_size_;
+  if (!blocks_.empty()) {
+    block_size = std::min(blocks_.back().size * 2, kMaxBlockSize);
+  }
+  block_size = std::max(block_size, size);
+
+  Block block;
+  // `new char[]` returns memory aligned for any object of that size.
+  block.data.reset(new char[block_size]);
+  block.size = block_size;
+  blocks_.push_back(std::move(block));
+  return &blocks_.back();
+}
+
+ArenaScope::ArenaScope(Arena* arena) : previous_(current_arena.get()) {
+  current_arena.get() = arena;
+}
+
+ArenaScope::~ArenaScope() {
+  current_arena.get() = previous_;
+}
+
+Arena* ArenaScope::Current() {
+  return current_arena.get();
+}
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+using firebase::firestore::nanopb::Arena;
+using firebase::firestore::nanopb::ArenaScope;
+
+void* firestore_nanopb_realloc(void* ptr, size_t size) {
+  Arena* arena = ArenaScope::Current();
+  if (arena && (!ptr || arena->Contains(ptr))) {
+    return arena->Reallocate(ptr, size);
+  }
+  return std::realloc(ptr, size);
+}
+
+void firestore_nanopb_free(void* ptr) {
+  Arena* arena = ArenaScope::Current();
+  if (arena && arena->Contains(ptr)) {
+    // Arena memory is only freed all at once.
+    return;
+  }
+  std::free(ptr);
+}
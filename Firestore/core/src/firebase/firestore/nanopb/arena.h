@@ -0,0 +1,124 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+
+/**
+ * A bump allocator that backs the dynamically-allocated members of decoded
+ * Nanopb protos.
+ *
+ * Decoding a proto normally results in one `malloc` per repeated field, string
+ * and bytes array, each of which must later be freed individually by
+ * `pb_release`. An `Arena` instead carves all of these allocations out of a few
+ * large blocks and frees them all at once when it's destroyed.
+ *
+ * Memory handed out by an `Arena` is never freed individually: the arena only
+ * grows until it is destroyed or `Reset`.
+ *
+ * `Arena` is not thread-safe.
+ */
+class Arena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 4096;
+
+  explicit Arena(size_t initial_block_size = kDefaultBlockSize);
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  /**
+   * Allocates `size` bytes aligned suitably for any scalar type. Never returns
+   * null.
+   */
+  void* Allocate(size_t size);
+
+  /**
+   * Resizes an allocation previously returned by this arena, following the
+   * semantics of `realloc`: the contents are preserved up to the lesser of the
+   * old and new sizes, and `ptr` may be null.
+   *
+   * Growing the most recent allocation extends it in place when its block has
+   * room, which keeps appending to a repeated field cheap.
+   */
+  void* Reallocate(void* ptr, size_t size);
+
+  /** Returns true if `ptr` points into memory owned by this arena. */
+  bool Contains(const void* ptr) const;
+
+  /** Frees all memory allocated by this arena. */
+  void Reset();
+
+  /** The total number of bytes allocated by this arena. */
+  size_t allocated_bytes() const {
+    return allocated_bytes_;
+  }
+
+ private:
+  struct Block {
+    std::unique_ptr<char[]> data;
+    size_t size = 0;
+    size_t used = 0;
+  };
+
+  /** Returns a block with at least `size` free bytes. */
+  Block* BlockFor(size_t size);
+
+  size_t initial_block_size_ = 0;
+  size_t allocated_bytes_ = 0;
+  std::vector<Block> blocks_;
+
+  // The most recent allocation, which is the only one that can be extended in
+  // place.
+  char* last_allocation_ = nullptr;
+};
+
+/**
+ * While an `ArenaScope` is alive, Nanopb allocates the members of protos that
+ * are decoded on the current thread from the given arena.
+ *
+ * This only has an effect if the Nanopb runtime was built with the allocation
+ * hooks in `pb_system.h` (signalled by `FIRESTORE_NANOPB_ARENA`); otherwise
+ * Nanopb keeps allocating from the heap.
+ */
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena* arena);
+  ~ArenaScope();
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+  /** Returns the arena in effect on the current thread, if any. */
+  static Arena* Current();
+
+ private:
+  Arena* previous_ = nullptr;
+};
+
+}  // namespace nanopb
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_ARENA_H_
@@ -16,7 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 
+#include <atomic>
 #include <cctype>
+#include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <iomanip>
@@ -32,14 +34,57 @@ namespace firebase {
 namespace firestore {
 namespace nanopb {
 
+/**
+ * A byte array shared by copies of a `ByteString`, freed once the last of
+ * them lets go of it.
+ */
+class ByteString::Rep {
+ public:
+  explicit Rep(pb_bytes_array_t* bytes) : bytes_(bytes) {
+  }
+
+  ~Rep() {
+    std::free(bytes_);
+  }
+
+  Rep* Ref() {
+    ref_count_.fetch_add(1, std::memory_order_relaxed);
+    return this;
+  }
+
+  void Unref() {
+    if (ref_count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete this;
+    }
+  }
+
+  bool unique() const {
+    return ref_count_.load(std::memory_order_acquire) == 1;
+  }
+
+  pb_bytes_array_t* bytes() const {
+    return bytes_;
+  }
+
+  pb_bytes_array_t* release() {
+    pb_bytes_array_t* result = bytes_;
+    bytes_ = nullptr;
+    return result;
+  }
+
+ private:
+  std::atomic<int> ref_count_{1};
+  pb_bytes_array_t* bytes_ = nullptr;
+};
+
 ByteString::ByteString(const pb_bytes_array_t* bytes) {
   if (bytes != nullptr) {
-    bytes_ = MakeBytesArray(bytes->bytes, bytes->size);
+    Assign(bytes->bytes, bytes->size);
   }
 }
 
-ByteString::ByteString(const void* value, size_t size)
-    : bytes_(MakeBytesArray(value, size)) {
+ByteString::ByteString(const void* value, size_t size) {
+  Assign(value, size);
 }
 
 ByteString::ByteString(absl::string_view value)
@@ -51,52 +96,99 @@ ByteString::ByteString(std::initializer_list<uint8_t> value)
 }
 
 ByteString::ByteString(const ByteString& other)
-    : ByteString(other.data(), other.size()) {
+    : rep_(other.rep_ ? other.rep_->Ref() : nullptr) {
+  std::memcpy(inline_storage_, other.inline_storage_, kInlineStorageSize);
 }
 
-ByteString::ByteString(ByteString&& other) noexcept {
-  bytes_ = other.bytes_;
-  other.bytes_ = nullptr;
+ByteString::ByteString(ByteString&& other) noexcept : rep_(other.rep_) {
+  std::memcpy(inline_storage_, other.inline_storage_, kInlineStorageSize);
+  other.rep_ = nullptr;
+  other.inline_bytes()->size = 0;
 }
 
 ByteString::~ByteString() {
-  std::free(bytes_);
+  if (rep_) rep_->Unref();
 }
 
 ByteString& ByteString::operator=(const ByteString& other) {
-  if (bytes_ != other.bytes_) {
-    std::free(bytes_);
-    bytes_ = MakeBytesArray(other.data(), other.size());
-  }
+  ByteString copy{other};
+  swap(*this, copy);
   return *this;
 }
 
 ByteString& ByteString::operator=(ByteString&& other) noexcept {
-  if (bytes_ != other.bytes_) {
-    std::free(bytes_);
-    bytes_ = other.bytes_;
-    other.bytes_ = nullptr;
-  }
+  ByteString moved{std::move(other)};
+  swap(*this, moved);
   return *this;
 }
 
 /* static */ ByteString ByteString::Take(pb_bytes_array_t* bytes) {
-  return ByteString{bytes, 0};
+  // Adopt even short arrays: the caller may still be looking at them.
+  ByteString result;
+  if (bytes != nullptr) {
+    result.rep_ = new Rep(bytes);
+  }
+  return result;
 }
 
 const uint8_t* ByteString::data() const {
   static const uint8_t kEmpty[] = "";
-  return bytes_ ? bytes_->bytes : kEmpty;
+  const pb_bytes_array_t* bytes = get();
+  return bytes ? bytes->bytes : kEmpty;
+}
+
+const pb_bytes_array_t* ByteString::get() const {
+  if (rep_) return rep_->bytes();
+
+  const pb_bytes_array_t* bytes = inline_bytes();
+  return bytes->size > 0 ? bytes : nullptr;
 }
 
 pb_bytes_array_t* ByteString::release() {
-  pb_bytes_array_t* result = bytes_;
-  bytes_ = nullptr;
+  pb_bytes_array_t* result = nullptr;
+  if (rep_ && rep_->unique()) {
+    result = rep_->release();
+  } else {
+    result = MakeBytesArray(data(), size());
+  }
+
+  if (rep_) rep_->Unref();
+  rep_ = nullptr;
+  inline_bytes()->size = 0;
   return result;
 }
 
 void swap(ByteString& lhs, ByteString& rhs) noexcept {
-  std::swap(lhs.bytes_, rhs.bytes_);
+  using std::swap;
+  swap(lhs.rep_, rhs.rep_);
+  swap(lhs.inline_storage_, rhs.inline_storage_);
+}
+
+/* static */ size_t ByteString::InlineCapacity() {
+  // Leave room for the null terminator that `MakeBytesArray` also adds.
+  return kInlineStorageSize - offsetof(pb_bytes_array_t, bytes) - 1;
+}
+
+pb_bytes_array_t* ByteString::inline_bytes() {
+  return reinterpret_cast<pb_bytes_array_t*>(inline_storage_);
+}
+
+const pb_bytes_array_t* ByteString::inline_bytes() const {
+  return reinterpret_cast<const pb_bytes_array_t*>(inline_storage_);
+}
+
+void ByteString::Assign(const void* value, size_t size) {
+  if (size == 0) return;
+
+  if (size > InlineCapacity()) {
+    rep_ = new Rep(MakeBytesArray(value, size));
+    return;
+  }
+
+  pb_bytes_array_t* bytes = inline_bytes();
+  bytes->size = CheckedSize(size);
+  std::memcpy(bytes->bytes, value, size);
+  bytes->bytes[size] = '\0';
 }
 
 util::ComparisonResult ByteString::CompareTo(const ByteString& rhs) const {
@@ -35,8 +35,11 @@ namespace nanopb {
 
 /**
  * An immutable string-like object backed by a nanopb byte array. `ByteString`
- * owns its memory, has deep copy semantics, and creates a copy of any input
- * given to its constructors.
+ * owns its memory and creates a copy of any input given to its constructors.
+ *
+ * Since a `ByteString` can't be modified, copies share their bytes: longer
+ * byte arrays are reference counted, and short ones are stored inline, so that
+ * copying tokens and other short values around doesn't allocate.
  *
  * `ByteString` is similar in spirit to `com.google.protobuf.ByteString`. It
  * serves mostly the same purpose: it's a holder of a byte array that's
@@ -96,11 +99,12 @@ class ByteString : public util::Comparable<ByteString> {
   const uint8_t* data() const;
 
   size_t size() const {
-    return bytes_ ? bytes_->size : 0;
+    const pb_bytes_array_t* bytes = get();
+    return bytes ? bytes->size : 0;
   }
 
   bool empty() const {
-    return bytes_ == nullptr || bytes_->size == 0;
+    return size() == 0;
   }
 
   const uint8_t* begin() const {
@@ -120,13 +124,12 @@ class ByteString : public util::Comparable<ByteString> {
    * For actually reading the data in the buffer, prefer `data()` and `size()`
    * or `begin()` and `end()`, which handle this nullability for you.
    */
-  const pb_bytes_array_t* get() const {
-    return bytes_;
-  }
+  const pb_bytes_array_t* get() const;
 
   /**
    * Releases ownership of the backing byte array, and returns it to the caller.
-   * The backing byte array is set to null.
+   * The backing byte array is set to null. If the byte array is stored inline
+   * or shared with other copies, the caller gets a copy of it.
    *
    * This value may be null because nanopb (and protobuf generally) treat null
    * and empty byte arrays as equivalent. Assigning a null value to a nanopb
@@ -150,15 +153,24 @@ class ByteString : public util::Comparable<ByteString> {
   std::string ToHexString() const;
 
  private:
-  /**
-   * Private constructor directly assigns to bytes_. The extra integer tag
-   * helps disambiguate this constructor from the public constructor that takes
-   * `const pb_bytes_array_t*`.
-   */
-  explicit ByteString(pb_bytes_array_t* bytes, int) : bytes_{bytes} {
-  }
+  class Rep;
+
+  // Room for a pb_bytes_array_t header, its bytes, and a null terminator.
+  static constexpr size_t kInlineStorageSize = 24;
+
+  static size_t InlineCapacity();
+
+  pb_bytes_array_t* inline_bytes();
+  const pb_bytes_array_t* inline_bytes() const;
+
+  void Assign(const void* value, size_t size);
+
+  // The shared byte array, or null if the bytes are stored inline.
+  Rep* rep_ = nullptr;
 
-  pb_bytes_array_t* bytes_ = nullptr;
+  // Short byte arrays, laid out as a pb_bytes_array_t. A zero size, which
+  // value initialization gives, means the `ByteString` is empty.
+  alignas(pb_bytes_array_t) uint8_t inline_storage_[kInlineStorageSize] = {};
 };
 
 }  // namespace nanopb
@@ -0,0 +1,52 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_PB_SYSTEM_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_PB_SYSTEM_H_
+
+/*
+ * A replacement for the system headers included by Nanopb's `pb.h`, selected
+ * by defining `PB_SYSTEM_HEADER` when building Nanopb.
+ *
+ * Besides the headers Nanopb expects, this routes Nanopb's allocations through
+ * hooks that allocate from the current thread's `nanopb::Arena`, if any (see
+ * `arena.h`). This header is included from C, so must remain valid C.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void* firestore_nanopb_realloc(void* ptr, size_t size);
+void firestore_nanopb_free(void* ptr);
+
+#ifdef __cplusplus
+}  // extern "C"
+#endif
+
+#define pb_realloc(ptr, size) firestore_nanopb_realloc(ptr, size)
+#define pb_free(ptr) firestore_nanopb_free(ptr)
+
+/** Signals that Nanopb decodes into `nanopb::Arena`s. */
+#define FIRESTORE_NANOPB_ARENA 1
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_NANOPB_PB_SYSTEM_H_
@@ -26,6 +26,12 @@ namespace firebase {
 namespace firestore {
 namespace nanopb {
 
+size_t EncodedSize(const pb_field_t fields[], const void* src_struct) {
+  SizingWriter writer;
+  writer.Write(fields, src_struct);
+  return writer.size();
+}
+
 void Writer::Write(const pb_field_t fields[], const void* src_struct) {
   if (!pb_encode(&stream_, fields, src_struct)) {
     HARD_FAIL(PB_GET_ERROR(&stream_));
@@ -104,6 +110,12 @@ ByteString ByteStringWriter::Release() {
   return ByteString::Take(pending);
 }
 
+SizingWriter::SizingWriter() {
+  // A null callback makes Nanopb count bytes instead of writing them.
+  stream_.callback = nullptr;
+  stream_.max_size = SIZE_MAX;
+}
+
 namespace {
 
 bool AppendToString(pb_ostream_t* stream, const pb_byte_t* buf, size_t count) {
@@ -114,12 +126,19 @@ bool AppendToString(pb_ostream_t* stream, const pb_byte_t* buf, size_t count) {
 
 }  // namespace
 
-StringWriter::StringWriter() {
+StringWriter::StringWriter() : StringWriter(&buffer_) {
+}
+
+StringWriter::StringWriter(std::string* target) {
   stream_.callback = AppendToString;
-  stream_.state = &buffer_;
+  stream_.state = target;
   stream_.max_size = SIZE_MAX;
 }
 
+void StringWriter::Reserve(size_t capacity) {
+  static_cast<std::string*>(stream_.state)->reserve(capacity);
+}
+
 std::string StringWriter::Release() {
   return std::move(buffer_);
 }
@@ -31,6 +31,12 @@ namespace firebase {
 namespace firestore {
 namespace nanopb {
 
+/**
+ * Returns the number of bytes that encoding the given Nanopb proto takes, so
+ * that writers can reserve all of it up front instead of growing as they go.
+ */
+size_t EncodedSize(const pb_field_t* fields, const void* src_struct);
+
 /**
  * Docs TODO(rsgowman). But currently, this just wraps the underlying Nanopb
  * `pb_ostream_t`. All errors are considered fatal.
@@ -120,6 +126,21 @@ class ByteStringWriter : public Writer {
   size_t capacity_ = 0;
 };
 
+/**
+ * A `Writer` that only counts the bytes written, without storing them. This is
+ * Nanopb's sizing stream (`PB_OSTREAM_SIZING`): fields are still walked and
+ * varints computed, but nothing is allocated or copied.
+ */
+class SizingWriter : public Writer {
+ public:
+  SizingWriter();
+
+  /** Returns the number of bytes written so far. */
+  size_t size() const {
+    return stream_.bytes_written;
+  }
+};
+
 /**
  * A `Writer` that writes into a `std::string`.
  *
@@ -130,6 +151,19 @@ class StringWriter : public Writer {
  public:
   StringWriter();
 
+  /**
+   * Creates a `StringWriter` that appends to the given string rather than one
+   * of its own, so that callers can reuse the string's capacity across
+   * messages. `Release` must not be called on such a writer.
+   */
+  explicit StringWriter(std::string* target);
+
+  /**
+   * Reserves the given number of bytes of total capacity in the string being
+   * written.
+   */
+  void Reserve(size_t capacity);
+
   /**
    * Returns the string backing this `StringWriter`, taking ownership of its
    * contents.
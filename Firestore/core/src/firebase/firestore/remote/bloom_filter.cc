@@ -0,0 +1,111 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <array>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/md5.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+namespace {
+
+/** Reads 8 bytes of the digest starting at `offset` as a little-endian int. */
+uint64_t ReadUint64(const std::array<uint8_t, 16>& digest, size_t offset) {
+  uint64_t result = 0;
+  for (size_t i = 0; i != 8; ++i) {
+    result |= static_cast<uint64_t>(digest[offset + i]) << (i * 8);
+  }
+  return result;
+}
+
+}  // namespace
+
+BloomFilter::BloomFilter(std::vector<uint8_t> bitmap,
+                         int32_t padding,
+                         int32_t hash_count)
+    : bitmap_{std::move(bitmap)},
+      hash_count_{hash_count},
+      bit_count_{static_cast<int64_t>(bitmap_.size()) * 8 - padding} {
+}
+
+StatusOr<BloomFilter> BloomFilter::Create(std::vector<uint8_t> bitmap,
+                                          int32_t padding,
+                                          int32_t hash_count) {
+  if (padding < 0 || padding >= 8) {
+    return Status(Error::kInvalidArgument,
+                  StringFormat("Invalid padding: %s", padding));
+  }
+  if (hash_count < 0) {
+    return Status(Error::kInvalidArgument,
+                  StringFormat("Invalid hash count: %s", hash_count));
+  }
+  if (bitmap.empty() && padding != 0) {
+    return Status(Error::kInvalidArgument,
+                  StringFormat("Expected padding of 0 when bitmap length is "
+                               "0, but got %s",
+                               padding));
+  }
+  if (!bitmap.empty() && hash_count == 0) {
+    return Status(Error::kInvalidArgument,
+                  StringFormat("Invalid hash count: %s", hash_count));
+  }
+
+  return BloomFilter(std::move(bitmap), padding, hash_count);
+}
+
+bool BloomFilter::MightContain(absl::string_view value) const {
+  // An empty filter contains nothing.
+  if (bit_count_ == 0) return false;
+
+  std::array<uint8_t, 16> digest = util::CalculateMd5Digest(value);
+  uint64_t h1 = ReadUint64(digest, 0);
+  uint64_t h2 = ReadUint64(digest, 8);
+
+  // Unsigned arithmetic wraps, matching the backend's 64-bit hash combination.
+  auto bit_count = static_cast<uint64_t>(bit_count_);
+  for (int32_t i = 0; i != hash_count_; ++i) {
+    uint64_t combined = h1 + static_cast<uint64_t>(i) * h2;
+    if (!IsBitSet(combined % bit_count)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool BloomFilter::IsBitSet(uint64_t index) const {
+  uint8_t byte = bitmap_[index / 8];
+  return (byte & (0x01 << (index % 8))) != 0;
+}
+
+bool operator==(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return lhs.hash_count() == rhs.hash_count() &&
+         lhs.bit_count() == rhs.bit_count() && lhs.bitmap() == rhs.bitmap();
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
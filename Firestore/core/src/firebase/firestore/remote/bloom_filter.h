@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * A bloom filter sent by the backend along with an existence filter, holding
+ * the resource names of the documents in the target that haven't changed.
+ *
+ * Entries are hashed with MD5, and the two 64-bit halves of the digest, `h1`
+ * and `h2`, give the `i`th bit to test as `(h1 + i * h2) % bit_count`.
+ */
+class BloomFilter {
+ public:
+  /**
+   * Creates a bloom filter from its encoded bits, the number of unused bits
+   * at the end of the last byte of `bitmap`, and the number of hash functions.
+   * Returns an error if the parameters are inconsistent.
+   */
+  static util::StatusOr<BloomFilter> Create(std::vector<uint8_t> bitmap,
+                                            int32_t padding,
+                                            int32_t hash_count);
+
+  /**
+   * Returns whether the given value might be in the filter. A `false` result
+   * is definite; a `true` result may be a false positive.
+   */
+  bool MightContain(absl::string_view value) const;
+
+  /** The number of bits in the filter. */
+  int64_t bit_count() const {
+    return bit_count_;
+  }
+
+  int32_t hash_count() const {
+    return hash_count_;
+  }
+
+  const std::vector<uint8_t>& bitmap() const {
+    return bitmap_;
+  }
+
+ private:
+  BloomFilter(std::vector<uint8_t> bitmap, int32_t padding, int32_t hash_count);
+
+  bool IsBitSet(uint64_t index) const;
+
+  std::vector<uint8_t> bitmap_;
+  int32_t hash_count_ = 0;
+  int64_t bit_count_ = 0;
+};
+
+bool operator==(const BloomFilter& lhs, const BloomFilter& rhs);
+
+inline bool operator!=(const BloomFilter& lhs, const BloomFilter& rhs) {
+  return !(lhs == rhs);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_BLOOM_FILTER_H_
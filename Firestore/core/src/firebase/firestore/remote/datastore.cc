@@ -23,6 +23,7 @@
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
 #include "Firestore/core/src/firebase/firestore/auth/token.h"
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/target.h"
 #include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
@@ -35,7 +36,6 @@
 #include "Firestore/core/src/firebase/firestore/remote/grpc_unary_call.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/error_apple.h"
-#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
@@ -50,21 +50,19 @@ namespace {
 using auth::CredentialsProvider;
 using auth::Token;
 using core::DatabaseInfo;
+using core::Target;
 using model::DocumentKey;
+using model::DocumentKeyHash;
 using model::MaybeDocument;
 using model::Mutation;
 using util::AsyncQueue;
-using util::Executor;
 using util::LogIsDebugEnabled;
 using util::Status;
 using util::StatusOr;
 
 const auto kRpcNameCommit = "/google.firestore.v1.Firestore/Commit";
 const auto kRpcNameLookup = "/google.firestore.v1.Firestore/BatchGetDocuments";
-
-std::unique_ptr<Executor> CreateExecutor() {
-  return Executor::CreateSerial("com.google.firebase.firestore.rpc");
-}
+const auto kRpcNameRunQuery = "/google.firestore.v1.Firestore/RunQuery";
 
 std::string MakeString(grpc::string_ref grpc_str) {
   return {grpc_str.begin(), grpc_str.size()};
@@ -90,20 +88,24 @@ void LogGrpcCallFinished(absl::string_view rpc_name,
 
 Datastore::Datastore(const DatabaseInfo& database_info,
                      const std::shared_ptr<AsyncQueue>& worker_queue,
-                     std::shared_ptr<CredentialsProvider> credentials)
+                     std::shared_ptr<CredentialsProvider> credentials,
+                     std::shared_ptr<GrpcCompletionPoller> poller)
     : Datastore{database_info, worker_queue, credentials,
-                ConnectivityMonitor::Create(worker_queue)} {
+                ConnectivityMonitor::Create(worker_queue), std::move(poller)} {
 }
 
 Datastore::Datastore(const DatabaseInfo& database_info,
                      const std::shared_ptr<AsyncQueue>& worker_queue,
                      std::shared_ptr<CredentialsProvider> credentials,
-                     std::unique_ptr<ConnectivityMonitor> connectivity_monitor)
+                     std::unique_ptr<ConnectivityMonitor> connectivity_monitor,
+                     std::shared_ptr<GrpcCompletionPoller> poller)
     : worker_queue_{NOT_NULL(worker_queue)},
       credentials_{std::move(credentials)},
-      rpc_executor_{CreateExecutor()},
+      owns_poller_{!poller},
+      poller_{poller ? std::move(poller)
+                     : std::make_shared<GrpcCompletionPoller>()},
       connectivity_monitor_{std::move(connectivity_monitor)},
-      grpc_connection_{database_info, worker_queue, &grpc_queue_,
+      grpc_connection_{database_info, worker_queue, poller_->queue(),
                        connectivity_monitor_.get()},
       datastore_serializer_{database_info} {
   if (!database_info.ssl_enabled()) {
@@ -112,7 +114,7 @@ Datastore::Datastore(const DatabaseInfo& database_info,
 }
 
 void Datastore::Start() {
-  rpc_executor_->Execute([this] { PollGrpcQueue(); });
+  poller_->Start();
 }
 
 void Datastore::Shutdown() {
@@ -123,44 +125,33 @@ void Datastore::Shutdown() {
   // queue.
   grpc_connection_.Shutdown();
 
-  // `grpc::CompletionQueue::Next` will only return `false` once `Shutdown` has
-  // been called and all submitted tags have been extracted. Without this call,
-  // `rpc_executor_` will never finish.
-  grpc_queue_.Shutdown();
-  // Drain the executor to make sure it extracted all the operations from gRPC
-  // completion queue.
-  rpc_executor_->ExecuteBlocking([] {});
-}
-
-void Datastore::PollGrpcQueue() {
-  HARD_ASSERT(rpc_executor_->IsCurrentExecutor(),
-              "PollGrpcQueue should only be called on the "
-              "dedicated Datastore executor");
-
-  void* tag = nullptr;
-  bool ok = false;
-  while (grpc_queue_.Next(&tag, &ok)) {
-    auto completion = static_cast<GrpcCompletion*>(tag);
-    // While it's valid in principle, we never deliberately pass a null pointer
-    // to gRPC completion queue and expect it back. This assertion might be
-    // relaxed if necessary.
-    HARD_ASSERT(tag, "gRPC queue returned a null tag");
-    completion->Complete(ok);
+  // A shared poller keeps running for the other `Datastore`s; the completions
+  // of this `Datastore`'s calls have already been taken off its queue.
+  if (owns_poller_) {
+    poller_->Shutdown();
   }
 }
 
 std::shared_ptr<WatchStream> Datastore::CreateWatchStream(
     WatchStreamCallback* callback) {
-  return std::make_shared<WatchStream>(worker_queue_, credentials_,
-                                       datastore_serializer_.serializer(),
-                                       &grpc_connection_, callback);
+  auto stream = std::make_shared<WatchStream>(
+      worker_queue_, credentials_, datastore_serializer_.serializer(),
+      &grpc_connection_, callback);
+  if (stream_recorder_) {
+    stream->SetRecorder(stream_recorder_, RecordedStream::Watch);
+  }
+  return stream;
 }
 
 std::shared_ptr<WriteStream> Datastore::CreateWriteStream(
     WriteStreamCallback* callback) {
-  return std::make_shared<WriteStream>(worker_queue_, credentials_,
-                                       datastore_serializer_.serializer(),
-                                       &grpc_connection_, callback);
+  auto stream = std::make_shared<WriteStream>(
+      worker_queue_, credentials_, datastore_serializer_.serializer(),
+      &grpc_connection_, callback);
+  if (stream_recorder_) {
+    stream->SetRecorder(stream_recorder_, RecordedStream::Write);
+  }
+  return stream;
 }
 
 void Datastore::CommitMutations(const std::vector<Mutation>& mutations,
@@ -205,22 +196,39 @@ void Datastore::CommitMutationsWithCredentials(
 
 void Datastore::LookupDocuments(const std::vector<DocumentKey>& keys,
                                 LookupCallback&& callback) {
-  ResumeRpcWithCredentials(
-      // TODO(c++14): move into lambda.
-      [this, keys, callback](const StatusOr<Token>& maybe_credentials) mutable {
-        if (!maybe_credentials.ok()) {
-          callback(maybe_credentials.status());
-          return;
-        }
-        LookupDocumentsWithCredentials(maybe_credentials.ValueOrDie(), keys,
-                                       std::move(callback));
-      });
+  pending_lookups_.push_back(PendingLookup{keys, std::move(callback)});
+  if (pending_lookups_.size() > 1) {
+    // Will be sent along with the lookup that is waiting for credentials.
+    return;
+  }
+
+  ResumeRpcWithCredentials([this](const StatusOr<Token>& maybe_credentials) {
+    std::vector<PendingLookup> lookups = std::move(pending_lookups_);
+    pending_lookups_.clear();
+
+    if (!maybe_credentials.ok()) {
+      for (const PendingLookup& lookup : lookups) {
+        lookup.callback(maybe_credentials.status());
+      }
+      return;
+    }
+    LookupDocumentsWithCredentials(maybe_credentials.ValueOrDie(),
+                                   std::move(lookups));
+  });
 }
 
 void Datastore::LookupDocumentsWithCredentials(
-    const Token& token,
-    const std::vector<DocumentKey>& keys,
-    LookupCallback&& callback) {
+    const Token& token, std::vector<PendingLookup>&& lookups) {
+  std::vector<DocumentKey> keys;
+  std::unordered_set<DocumentKey, DocumentKeyHash> seen;
+  for (const PendingLookup& lookup : lookups) {
+    for (const DocumentKey& key : lookup.keys) {
+      if (seen.insert(key).second) {
+        keys.push_back(key);
+      }
+    }
+  }
+
   grpc::ByteBuffer message =
       MakeByteBuffer(datastore_serializer_.EncodeLookupRequest(keys));
 
@@ -231,12 +239,12 @@ void Datastore::LookupDocumentsWithCredentials(
   active_calls_.push_back(std::move(call_owning));
 
   // TODO(c++14): move into lambda.
-  call->Start([this, call, callback](
+  call->Start([this, call, lookups](
                   const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
     LogGrpcCallFinished("BatchGetDocuments", call, result.status());
     HandleCallStatus(result.status());
 
-    OnLookupDocumentsResponse(result, callback);
+    OnLookupDocumentsResponse(result, lookups);
 
     RemoveGrpcCall(call);
   });
@@ -244,14 +252,99 @@ void Datastore::LookupDocumentsWithCredentials(
 
 void Datastore::OnLookupDocumentsResponse(
     const StatusOr<std::vector<grpc::ByteBuffer>>& result,
-    const LookupCallback& callback) {
+    const std::vector<PendingLookup>& lookups) {
   if (!result.ok()) {
-    callback(result.status());
+    for (const PendingLookup& lookup : lookups) {
+      lookup.callback(result.status());
+    }
     return;
   }
 
   std::vector<grpc::ByteBuffer> responses = std::move(result).ValueOrDie();
-  callback(datastore_serializer_.MergeLookupResponses(responses));
+  StatusOr<std::vector<MaybeDocument>> merged =
+      datastore_serializer_.MergeLookupResponses(responses);
+  if (!merged.ok() || lookups.size() == 1) {
+    for (const PendingLookup& lookup : lookups) {
+      lookup.callback(merged);
+    }
+    return;
+  }
+
+  // Hand each caller the documents it asked for, keeping them sorted by key.
+  for (const PendingLookup& lookup : lookups) {
+    std::unordered_set<DocumentKey, DocumentKeyHash> requested(
+        lookup.keys.begin(), lookup.keys.end());
+    std::vector<MaybeDocument> docs;
+    for (const MaybeDocument& doc : merged.ValueOrDie()) {
+      if (requested.count(doc.key()) > 0) {
+        docs.push_back(doc);
+      }
+    }
+    lookup.callback(StatusOr<std::vector<MaybeDocument>>{std::move(docs)});
+  }
+}
+
+void Datastore::RunQuery(const Target& target, RunQueryCallback&& callback) {
+  StartRunQuery(
+      MakeByteBuffer(datastore_serializer_.EncodeRunQueryRequest(target)),
+      [this, callback](const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
+        if (result.ok()) {
+          callback(datastore_serializer_.MergeRunQueryResponses(
+              result.ValueOrDie()));
+        } else {
+          callback(result.status());
+        }
+      });
+}
+
+void Datastore::CountQuery(const Target& target,
+                           CountQueryCallback&& callback) {
+  StartRunQuery(
+      MakeByteBuffer(datastore_serializer_.EncodeCountQueryRequest(target)),
+      [this, callback](const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
+        if (result.ok()) {
+          callback(datastore_serializer_.CountRunQueryResponses(
+              result.ValueOrDie()));
+        } else {
+          callback(result.status());
+        }
+      });
+}
+
+void Datastore::StartRunQuery(grpc::ByteBuffer&& message,
+                              RunQueryResponsesCallback&& callback) {
+  ResumeRpcWithCredentials(
+      // TODO(c++14): move into lambda.
+      [this, message,
+       callback](const StatusOr<Token>& maybe_credentials) mutable {
+        if (!maybe_credentials.ok()) {
+          callback(maybe_credentials.status());
+          return;
+        }
+        RunQueryWithCredentials(maybe_credentials.ValueOrDie(),
+                                std::move(message), std::move(callback));
+      });
+}
+
+void Datastore::RunQueryWithCredentials(const Token& token,
+                                        grpc::ByteBuffer&& message,
+                                        RunQueryResponsesCallback&& callback) {
+  std::unique_ptr<GrpcStreamingReader> call_owning =
+      grpc_connection_.CreateStreamingReader(kRpcNameRunQuery, token,
+                                             std::move(message));
+  GrpcStreamingReader* call = call_owning.get();
+  active_calls_.push_back(std::move(call_owning));
+
+  // TODO(c++14): move into lambda.
+  call->Start([this, call, callback](
+                  const StatusOr<std::vector<grpc::ByteBuffer>>& result) {
+    LogGrpcCallFinished("RunQuery", call, result.status());
+    HandleCallStatus(result.status());
+
+    callback(result);
+
+    RemoveGrpcCall(call);
+  });
 }
 
 void Datastore::ResumeRpcWithCredentials(const OnCredentials& on_credentials) {
@@ -17,9 +17,12 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DATASTORE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_DATASTORE_H_
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
@@ -27,12 +30,13 @@
 #include "Firestore/core/src/firebase/firestore/core/core_fwd.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_call.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion_poller.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/firebase/firestore/remote/stream_recorder.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
-#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
 #include "absl/strings/string_view.h"
 #include "grpcpp/completion_queue.h"
@@ -62,16 +66,59 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   using LookupCallback = std::function<void(
       const util::StatusOr<std::vector<model::MaybeDocument>>&)>;
   using CommitCallback = std::function<void(const util::Status&)>;
+  using RunQueryCallback =
+      std::function<void(const util::StatusOr<RunQueryResult>&)>;
+  using CountQueryCallback =
+      std::function<void(const util::StatusOr<int64_t>&)>;
 
+  /**
+   * Creates a `Datastore` whose gRPC calls complete on the given `poller`,
+   * which may be shared with other `Datastore`s. If `poller` is null, the
+   * `Datastore` creates a poller of its own with a single thread.
+   */
   Datastore(const core::DatabaseInfo& database_info,
             const std::shared_ptr<util::AsyncQueue>& worker_queue,
-            std::shared_ptr<auth::CredentialsProvider> credentials);
+            std::shared_ptr<auth::CredentialsProvider> credentials,
+            std::shared_ptr<GrpcCompletionPoller> poller = nullptr);
 
   virtual ~Datastore() = default;
 
   /** Starts polling the gRPC completion queue. */
   void Start();
-  /** Cancels any pending gRPC calls and drains the gRPC completion queue. */
+
+  /**
+   * Starts connecting to the backend ahead of the first call, e.g. while the
+   * rest of the client is being set up.
+   */
+  void Connect() {
+    grpc_connection_.Connect();
+  }
+  /** See `GrpcConnection::SetKeepaliveTime`. */
+  void SetKeepaliveTime(std::chrono::milliseconds keepalive_time) {
+    grpc_connection_.SetKeepaliveTime(keepalive_time);
+  }
+
+  /**
+   * Compresses messages on the watch and write streams and on document
+   * lookups, except for messages smaller than `threshold_bytes`. Call before
+   * creating any streams or calls.
+   */
+  void EnableCompression(grpc_compression_algorithm algorithm,
+                         size_t threshold_bytes) {
+    grpc_connection_.EnableCompression(algorithm, threshold_bytes);
+  }
+  /**
+   * Records the responses of the watch and write streams created from now on
+   * with `recorder`, so that they can be replayed later.
+   */
+  void SetStreamRecorder(std::shared_ptr<StreamRecorder> recorder) {
+    stream_recorder_ = std::move(recorder);
+  }
+
+  /**
+   * Cancels any pending gRPC calls and, unless the gRPC completion poller is
+   * shared, drains the gRPC completion queue.
+   */
   void Shutdown();
 
   /**
@@ -87,10 +134,36 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   virtual std::shared_ptr<WriteStream> CreateWriteStream(
       WriteStreamCallback* callback);
 
-  void CommitMutations(const std::vector<model::Mutation>& mutations,
-                       CommitCallback&& callback);
-  void LookupDocuments(const std::vector<model::DocumentKey>& keys,
-                       LookupCallback&& callback);
+  virtual /*virtual for tests only*/ void CommitMutations(
+      const std::vector<model::Mutation>& mutations, CommitCallback&& callback);
+
+  /**
+   * Looks up the given documents on the backend.
+   *
+   * Lookups that are requested while an earlier one is still waiting for
+   * credentials (e.g. from several transactions retrying at the same time) are
+   * merged into a single BatchGetDocuments call. Each callback receives only
+   * the documents for its own keys.
+   */
+  virtual /*virtual for tests only*/ void LookupDocuments(
+      const std::vector<model::DocumentKey>& keys, LookupCallback&& callback);
+
+  /**
+   * Reads the documents matching the given target directly from the backend,
+   * without listening to it.
+   */
+  void RunQuery(const core::Target& target, RunQueryCallback&& callback);
+
+  /**
+   * Counts the documents matching the given target on the backend. Only the
+   * names of the documents are sent back, and nothing is cached.
+   */
+  void CountQuery(const core::Target& target, CountQueryCallback&& callback);
+
+  /** The database this `Datastore` sends requests to. */
+  const model::DatabaseId& database_id() const {
+    return datastore_serializer_.serializer().database_id();
+  }
 
   /** Returns true if the given error is a gRPC ABORTED error. */
   static bool IsAbortedError(const util::Status& status);
@@ -131,11 +204,12 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   Datastore(const core::DatabaseInfo& database_info,
             const std::shared_ptr<util::AsyncQueue>& worker_queue,
             std::shared_ptr<auth::CredentialsProvider> credentials,
-            std::unique_ptr<ConnectivityMonitor> connectivity_monitor);
+            std::unique_ptr<ConnectivityMonitor> connectivity_monitor,
+            std::shared_ptr<GrpcCompletionPoller> poller = nullptr);
 
   /** Test-only method */
   grpc::CompletionQueue* grpc_queue() {
-    return &grpc_queue_;
+    return poller_->queue();
   }
   /** Test-only method */
   GrpcCall* LastCall() {
@@ -148,20 +222,29 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   }
 
  private:
-  void PollGrpcQueue();
+  struct PendingLookup {
+    std::vector<model::DocumentKey> keys;
+    LookupCallback callback;
+  };
 
   void CommitMutationsWithCredentials(
       const auth::Token& token,
       const std::vector<model::Mutation>& mutations,
       CommitCallback&& callback);
 
-  void LookupDocumentsWithCredentials(
-      const auth::Token& token,
-      const std::vector<model::DocumentKey>& keys,
-      LookupCallback&& callback);
+  void LookupDocumentsWithCredentials(const auth::Token& token,
+                                      std::vector<PendingLookup>&& lookups);
   void OnLookupDocumentsResponse(
       const util::StatusOr<std::vector<grpc::ByteBuffer>>& result,
-      const LookupCallback& callback);
+      const std::vector<PendingLookup>& lookups);
+
+  using RunQueryResponsesCallback = std::function<void(
+      const util::StatusOr<std::vector<grpc::ByteBuffer>>&)>;
+  void StartRunQuery(grpc::ByteBuffer&& message,
+                     RunQueryResponsesCallback&& callback);
+  void RunQueryWithCredentials(const auth::Token& token,
+                               grpc::ByteBuffer&& message,
+                               RunQueryResponsesCallback&& callback);
 
   using OnCredentials = std::function<void(const util::StatusOr<auth::Token>&)>;
   void ResumeRpcWithCredentials(const OnCredentials& on_token);
@@ -180,16 +263,22 @@ class Datastore : public std::enable_shared_from_this<Datastore> {
   std::shared_ptr<util::AsyncQueue> worker_queue_;
   std::shared_ptr<auth::CredentialsProvider> credentials_;
 
-  // A separate executor dedicated to polling gRPC completion queue (which is
-  // shared for all spawned gRPC streams and calls).
-  std::unique_ptr<util::Executor> rpc_executor_;
-  grpc::CompletionQueue grpc_queue_;
+  // Only a `Datastore` that created its own poller may shut it down.
+  bool owns_poller_ = false;
+  // Polls the gRPC completion queue shared by all spawned gRPC streams and
+  // calls on dedicated threads. Must outlive `grpc_connection_`.
+  std::shared_ptr<GrpcCompletionPoller> poller_;
   // TODO(varconst): move `ConnectivityMonitor` to `FirestoreClient`.
   std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
   GrpcConnection grpc_connection_;
 
   std::vector<std::unique_ptr<GrpcCall>> active_calls_;
   DatastoreSerializer datastore_serializer_;
+
+  // Lookups waiting for credentials, to be sent in a single call.
+  std::vector<PendingLookup> pending_lookups_;
+
+  std::shared_ptr<StreamRecorder> stream_recorder_;
 };
 
 }  // namespace remote
@@ -52,19 +52,30 @@ ExponentialBackoff::ExponentialBackoff(const std::shared_ptr<AsyncQueue>& queue,
                                        double backoff_factor,
                                        Milliseconds initial_delay,
                                        Milliseconds max_delay)
+    : ExponentialBackoff(queue,
+                         timer_id,
+                         BackoffProfile{backoff_factor, initial_delay,
+                                        max_delay,
+                                        BackoffJitter::Proportional}) {
+}
+
+ExponentialBackoff::ExponentialBackoff(const std::shared_ptr<AsyncQueue>& queue,
+                                       TimerId timer_id,
+                                       const BackoffProfile& profile)
     : queue_{queue},
       timer_id_{timer_id},
-      backoff_factor_{backoff_factor},
-      initial_delay_{initial_delay},
-      max_delay_{max_delay},
+      backoff_factor_{profile.backoff_factor},
+      initial_delay_{profile.initial_delay},
+      max_delay_{profile.max_delay},
+      jitter_{profile.jitter},
       last_attempt_time_{chr::steady_clock::now()} {
   HARD_ASSERT(queue, "Queue can't be null");
 
-  HARD_ASSERT(backoff_factor >= 1.0, "Backoff factor must be at least 1");
+  HARD_ASSERT(backoff_factor_ >= 1.0, "Backoff factor must be at least 1");
 
-  HARD_ASSERT(initial_delay.count() >= 0, "Delays must be non-negative");
-  HARD_ASSERT(max_delay.count() >= 0, "Delays must be non-negative");
-  HARD_ASSERT(initial_delay <= max_delay,
+  HARD_ASSERT(initial_delay_.count() >= 0, "Delays must be non-negative");
+  HARD_ASSERT(max_delay_.count() >= 0, "Delays must be non-negative");
+  HARD_ASSERT(initial_delay_ <= max_delay_,
               "Initial delay can't be greater than max delay");
 }
 
@@ -77,12 +88,21 @@ ExponentialBackoff::ExponentialBackoff(const std::shared_ptr<AsyncQueue>& queue,
                          kDefaultBackoffMaxDelay) {
 }
 
+void ExponentialBackoff::DelayAtLeast(Milliseconds delay) {
+  min_delay_ = std::min(delay, max_delay_);
+}
+
 void ExponentialBackoff::BackoffAndRun(AsyncQueue::Operation&& operation) {
   Cancel();
 
   // First schedule the block using the current base (which may be 0 and should
   // be honored as such).
-  Milliseconds desired_delay_with_jitter = current_base_ + GetDelayWithJitter();
+  Milliseconds desired_delay_with_jitter = current_base_;
+  if (jitter_ == BackoffJitter::Proportional) {
+    desired_delay_with_jitter += GetDelayWithJitter();
+  }
+  desired_delay_with_jitter = std::max(desired_delay_with_jitter, min_delay_);
+  min_delay_ = Milliseconds::zero();
 
   Milliseconds delay_so_far = chr::duration_cast<Milliseconds>(
       chr::steady_clock::now() - last_attempt_time_);
@@ -109,8 +129,7 @@ void ExponentialBackoff::BackoffAndRun(AsyncQueue::Operation&& operation) {
 
   // Apply backoff factor to determine next delay, but ensure it is within
   // bounds.
-  current_base_ = ClampDelay(
-      chr::duration_cast<Milliseconds>(current_base_ * backoff_factor_));
+  current_base_ = ClampDelay(GetNextBase());
 }
 
 Milliseconds ExponentialBackoff::GetDelayWithJitter() {
@@ -120,6 +139,20 @@ Milliseconds ExponentialBackoff::GetDelayWithJitter() {
                                           current_base_);
 }
 
+Milliseconds ExponentialBackoff::GetNextBase() {
+  auto max_next_base =
+      chr::duration_cast<Milliseconds>(current_base_ * backoff_factor_);
+  if (jitter_ == BackoffJitter::Proportional ||
+      max_next_base <= initial_delay_) {
+    return max_next_base;
+  }
+
+  std::uniform_real_distribution<double> distribution;
+  double random_double = distribution(secure_random_);
+  return initial_delay_ + chr::duration_cast<Milliseconds>(
+                              random_double * (max_next_base - initial_delay_));
+}
+
 Milliseconds ExponentialBackoff::ClampDelay(Milliseconds delay) const {
   if (delay < initial_delay_) {
     return initial_delay_;
@@ -27,6 +27,32 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
+/** How `ExponentialBackoff` randomizes its delays. */
+enum class BackoffJitter {
+  /**
+   * Each delay is the base delay plus a +/- <=50% jitter, and the base delay
+   * is multiplied by the backoff factor after each attempt.
+   */
+  Proportional,
+
+  /**
+   * "Decorrelated" jitter: each delay is picked at random between the initial
+   * delay and the previous delay times the backoff factor. Delays of clients
+   * that started retrying at the same time drift apart much faster than with
+   * proportional jitter. Use with a backoff factor of about 3; smaller factors
+   * keep the delays close to the initial delay.
+   */
+  Decorrelated,
+};
+
+/** The parameters of an `ExponentialBackoff`. */
+struct BackoffProfile {
+  double backoff_factor;
+  util::AsyncQueue::Milliseconds initial_delay;
+  util::AsyncQueue::Milliseconds max_delay;
+  BackoffJitter jitter;
+};
+
 /**
  *
  * A helper for running delayed operations following an exponential backoff
@@ -61,6 +87,10 @@ class ExponentialBackoff {
                      util::AsyncQueue::Milliseconds initial_delay,
                      util::AsyncQueue::Milliseconds max_delay);
 
+  ExponentialBackoff(const std::shared_ptr<util::AsyncQueue>& queue,
+                     util::TimerId timer_id,
+                     const BackoffProfile& profile);
+
   /**
    * Instantiates the exponential backoff with the default values.
    */
@@ -86,6 +116,12 @@ class ExponentialBackoff {
     current_base_ = max_delay_;
   }
 
+  /**
+   * Makes the next `BackoffAndRun` wait for at least the given delay (capped
+   * at `max_delay`), e.g. because the backend asked to retry no sooner.
+   */
+  void DelayAtLeast(util::AsyncQueue::Milliseconds delay);
+
   /**
    * Waits for `current_base` seconds (which may be zero), increases the delay
    * and runs the specified operation. If there was a pending operation waiting
@@ -102,6 +138,8 @@ class ExponentialBackoff {
   using Milliseconds = util::AsyncQueue::Milliseconds;
   // Returns a random value in the range [-current_base_/2, current_base_/2].
   Milliseconds GetDelayWithJitter();
+  // Returns the base delay to use after `current_base_`.
+  Milliseconds GetNextBase();
   Milliseconds ClampDelay(Milliseconds delay) const;
 
   std::shared_ptr<util::AsyncQueue> queue_;
@@ -112,6 +150,8 @@ class ExponentialBackoff {
   Milliseconds current_base_{0};
   const Milliseconds initial_delay_;
   const Milliseconds max_delay_;
+  const BackoffJitter jitter_;
+  Milliseconds min_delay_{0};
   util::SecureRandom secure_random_;
   std::chrono::steady_clock::time_point last_attempt_time_;
 };
@@ -80,26 +80,61 @@ void GrpcCompletion::EnsureValidFuture() {
 }
 
 void GrpcCompletion::Complete(bool ok) {
-  // This mechanism allows `GrpcStream` to know when the completion is off the
-  // gRPC completion queue (and thus no longer requires the underlying gRPC
-  // objects to be valid).
-  off_queue_.set_value();
-
-  // The queued operation needs to also retain this completion. It's possible
-  // for Complete to fire, shutdown to start, and then have this queued
-  // operation run. If this weren't a retain that ordering would have the
-  // callback use after free.
-  auto shared_this = grpc_ownership_;
-  worker_queue_->Enqueue([shared_this, ok] {
-    if (shared_this->callback_) {
-      shared_this->callback_(ok, shared_this);
+  Complete({{this, ok}});
+}
+
+void GrpcCompletion::Complete(const std::vector<Result>& results) {
+  using Batch = std::vector<std::pair<std::shared_ptr<GrpcCompletion>, bool>>;
+
+  // Completions are grouped by worker queue, keeping their relative order. In
+  // practice, there are very few distinct queues, so a linear search is fine.
+  std::vector<std::pair<std::shared_ptr<AsyncQueue>, Batch>> batches;
+  for (const Result& result : results) {
+    GrpcCompletion* completion = result.first;
+
+    // This mechanism allows `GrpcStream` to know when the completion is off
+    // the gRPC completion queue (and thus no longer requires the underlying
+    // gRPC objects to be valid).
+    completion->off_queue_.set_value();
+
+    Batch* batch = nullptr;
+    for (auto& entry : batches) {
+      if (entry.first == completion->worker_queue_) {
+        batch = &entry.second;
+        break;
+      }
+    }
+    if (!batch) {
+      batches.emplace_back(completion->worker_queue_, Batch{});
+      batch = &batches.back().second;
     }
-  });
 
-  // Having called Complete, gRPC has released its ownership interest in this
-  // object. Once the queued operation completes the `GrpcCompletion` will be
-  // deleted.
-  grpc_ownership_.reset();
+    // The queued operation needs to also retain this completion. It's possible
+    // for Complete to fire, shutdown to start, and then have this queued
+    // operation run. If this weren't a retain that ordering would have the
+    // callback use after free.
+    //
+    // Having called Complete, gRPC has released its ownership interest in this
+    // object. Once the queued operation completes the `GrpcCompletion` will be
+    // deleted.
+    batch->emplace_back(std::move(completion->grpc_ownership_),
+                        result.second);
+  }
+
+  for (auto& entry : batches) {
+    auto batch = std::make_shared<Batch>(std::move(entry.second));
+    // Responses from the backend yield to operations requested by the user.
+    entry.first->Enqueue(
+        [batch] {
+          for (const auto& completed : *batch) {
+            const std::shared_ptr<GrpcCompletion>& completion = completed.first;
+            if (completion->callback_) {
+              completion->callback_(completed.second, completion);
+            }
+          }
+        },
+        AsyncQueue::Priority::RemoteEvent);
+  }
 }
 
 }  // namespace remote
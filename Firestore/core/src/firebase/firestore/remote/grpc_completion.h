@@ -22,6 +22,7 @@
 #include <future>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
@@ -74,6 +75,12 @@ class GrpcCompletion : public std::enable_shared_from_this<GrpcCompletion> {
   using Callback =
       std::function<void(bool, const std::shared_ptr<GrpcCompletion>&)>;
 
+  /**
+   * A completion taken off the gRPC completion queue, along with the `ok` value
+   * gRPC returned for it.
+   */
+  using Result = std::pair<GrpcCompletion*, bool>;
+
   static std::shared_ptr<GrpcCompletion> Create(
       Type type,
       const std::shared_ptr<util::AsyncQueue>& worker_queue,
@@ -91,6 +98,13 @@ class GrpcCompletion : public std::enable_shared_from_this<GrpcCompletion> {
    */
   void Complete(bool ok);
 
+  /**
+   * Like `Complete(bool)` for each of the given completions, but notifies all
+   * of the completions that share a worker queue with a single enqueued
+   * operation, in the order in which they are given.
+   */
+  static void Complete(const std::vector<Result>& results);
+
   void Cancel();
 
   /**
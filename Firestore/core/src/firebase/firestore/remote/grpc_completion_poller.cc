@@ -0,0 +1,122 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion_poller.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using util::Executor;
+
+constexpr size_t GrpcCompletionPoller::kMaxCompletionsPerHandoff;
+
+GrpcCompletionPoller::GrpcCompletionPoller(size_t thread_count) {
+  HARD_ASSERT(thread_count > 0, "gRPC completion poller needs a thread");
+  for (size_t i = 0; i != thread_count; ++i) {
+    std::string label =
+        absl::StrCat("com.google.firebase.firestore.rpc.", std::to_string(i));
+    executors_.push_back(Executor::CreateSerial(label.c_str()));
+  }
+}
+
+GrpcCompletionPoller::~GrpcCompletionPoller() {
+  Shutdown();
+}
+
+std::shared_ptr<GrpcCompletionPoller> GrpcCompletionPoller::GetShared(
+    size_t thread_count) {
+  static std::mutex mutex;
+  static std::weak_ptr<GrpcCompletionPoller> shared;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::shared_ptr<GrpcCompletionPoller> result = shared.lock();
+  if (!result) {
+    result = std::make_shared<GrpcCompletionPoller>(thread_count);
+    shared = result;
+  }
+  return result;
+}
+
+void GrpcCompletionPoller::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HARD_ASSERT(!shut_down_, "Starting a gRPC completion poller after shutdown");
+  if (started_) {
+    return;
+  }
+
+  started_ = true;
+  for (const auto& executor : executors_) {
+    executor->Execute([this] { Poll(); });
+  }
+}
+
+void GrpcCompletionPoller::Shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shut_down_) {
+      return;
+    }
+    shut_down_ = true;
+  }
+
+  // `grpc::CompletionQueue::Next` will only return `false` once `Shutdown` has
+  // been called and all submitted tags have been extracted. Without this call,
+  // the executors will never finish.
+  queue_.Shutdown();
+
+  // Drain the executors to make sure they extracted all the operations from
+  // the gRPC completion queue.
+  for (const auto& executor : executors_) {
+    executor->ExecuteBlocking([] {});
+  }
+}
+
+void GrpcCompletionPoller::Poll() {
+  std::vector<GrpcCompletion::Result> ready;
+
+  void* tag = nullptr;
+  bool ok = false;
+  while (queue_.Next(&tag, &ok)) {
+    // While it's valid in principle, we never deliberately pass a null pointer
+    // to gRPC completion queue and expect it back. This assertion might be
+    // relaxed if necessary.
+    HARD_ASSERT(tag, "gRPC queue returned a null tag");
+    ready.push_back({static_cast<GrpcCompletion*>(tag), ok});
+
+    // Pick up whatever else is ready without blocking.
+    while (ready.size() < kMaxCompletionsPerHandoff &&
+           queue_.AsyncNext(&tag, &ok, std::chrono::system_clock::now()) ==
+               grpc::CompletionQueue::GOT_EVENT) {
+      HARD_ASSERT(tag, "gRPC queue returned a null tag");
+      ready.push_back({static_cast<GrpcCompletion*>(tag), ok});
+    }
+
+    GrpcCompletion::Complete(ready);
+    ready.clear();
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_POLLER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_POLLER_H_
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "grpcpp/completion_queue.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * Owns a gRPC completion queue and a pool of threads that poll it, passing
+ * each completion that comes back to `GrpcCompletion::Complete`.
+ *
+ * By default, each `Datastore` has a poller of its own with a single thread.
+ * Processes that run many Firestore instances (e.g. one per tenant database)
+ * can instead have all instances share one poller with `GetShared`, so that
+ * the number of polling threads doesn't grow with the number of instances.
+ *
+ * Completions that are ready at the same time are handed off to their worker
+ * queues in batches, one `AsyncQueue::Enqueue` per batch and queue.
+ */
+class GrpcCompletionPoller {
+ public:
+  /** The maximum number of completions handed off by a single enqueue. */
+  static constexpr size_t kMaxCompletionsPerHandoff = 32;
+
+  explicit GrpcCompletionPoller(size_t thread_count = 1);
+
+  /** Shuts down the poller if `Shutdown` hasn't been called already. */
+  ~GrpcCompletionPoller();
+
+  /**
+   * Returns the poller shared by all Firestore instances in this process,
+   * creating it with the given number of threads if no instance currently
+   * uses it. The shared poller is shut down once the last instance releases
+   * it.
+   */
+  static std::shared_ptr<GrpcCompletionPoller> GetShared(size_t thread_count);
+
+  /** Starts polling. Has no effect if the poller is already running. */
+  void Start();
+
+  /**
+   * Shuts down the completion queue and blocks until the polling threads have
+   * extracted all remaining completions from it. All gRPC calls using the
+   * queue must have been finished before calling this.
+   */
+  void Shutdown();
+
+  grpc::CompletionQueue* queue() {
+    return &queue_;
+  }
+
+  size_t thread_count() const {
+    return executors_.size();
+  }
+
+  GrpcCompletionPoller(const GrpcCompletionPoller& other) = delete;
+  GrpcCompletionPoller& operator=(const GrpcCompletionPoller& other) = delete;
+
+ private:
+  void Poll();
+
+  grpc::CompletionQueue queue_;
+  std::vector<std::unique_ptr<util::Executor>> executors_;
+
+  std::mutex mutex_;
+  bool started_ = false;
+  bool shut_down_ = false;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_COMPLETION_POLLER_H_
@@ -17,6 +17,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 
 #include <algorithm>
+#include <functional>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <utility>
@@ -32,6 +33,7 @@
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "absl/memory/memory.h"
+#include "absl/strings/str_cat.h"
 #include "grpcpp/create_channel.h"
 
 namespace firebase {
@@ -63,6 +65,19 @@ std::shared_ptr<grpc::ChannelCredentials> CreateSslCredentials(
   return grpc::SslCredentials(options);
 }
 
+/**
+ * Returns the credentials for connecting to the production backend, which are
+ * created once and shared by all channels of all Firestore instances, since
+ * loading and parsing the root certificates is relatively expensive.
+ */
+std::shared_ptr<grpc::ChannelCredentials> DefaultSslCredentials() {
+  // Intentionally leaked, so that channels can still be created while static
+  // objects are destroyed.
+  static auto* credentials = new std::shared_ptr<grpc::ChannelCredentials>(
+      CreateSslCredentials(LoadGrpcRootCertificate()));
+  return *credentials;
+}
+
 struct HostConfig {
   util::Path certificate_path;
   std::string target_name;
@@ -120,6 +135,68 @@ HostConfigMap& Config() {
   return config_by_host_;
 }
 
+/**
+ * Caches gRPC channels for the whole process, so that connections to the same
+ * host with the same SSL settings share a channel (and thus a TCP connection
+ * and TLS session) instead of each opening their own. The channels are owned
+ * by the connections using them; the cache only holds weak references.
+ */
+class ChannelCache {
+  using ChannelByKey =
+      std::unordered_map<std::string, std::weak_ptr<grpc::Channel>>;
+  using Guard = std::lock_guard<std::mutex>;
+
+ public:
+  /**
+   * Returns the live channel cached under the given key or, if there's none,
+   * caches and returns a new one obtained from `create`.
+   */
+  std::shared_ptr<grpc::Channel> Get(
+      const std::string& key,
+      const std::function<std::shared_ptr<grpc::Channel>()>& create) {
+    Guard guard{mutex_};
+
+    // Don't let entries for channels nobody uses anymore accumulate.
+    for (auto iter = map_.begin(); iter != map_.end();) {
+      if (iter->second.expired()) {
+        iter = map_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+
+    std::shared_ptr<grpc::Channel> channel = map_[key].lock();
+    if (!channel ||
+        channel->GetState(/*try_to_connect=*/false) == GRPC_CHANNEL_SHUTDOWN) {
+      channel = create();
+      map_[key] = channel;
+    }
+    return channel;
+  }
+
+  /**
+   * Removes the given channel from the cache, so that the next call to `Get`
+   * with the same key creates a new channel. Has no effect if the given
+   * channel has already been replaced.
+   */
+  void Evict(const std::string& key, const grpc::Channel* channel) {
+    Guard guard{mutex_};
+    auto iter = map_.find(key);
+    if (iter != map_.end() && iter->second.lock().get() == channel) {
+      map_.erase(iter);
+    }
+  }
+
+ private:
+  ChannelByKey map_;
+  std::mutex mutex_;
+};
+
+ChannelCache& Channels() {
+  static ChannelCache channels;
+  return channels;
+}
+
 }  // namespace
 
 GrpcConnection::GrpcConnection(
@@ -174,17 +251,39 @@ std::unique_ptr<grpc::ClientContext> GrpcConnection::CreateContext(
   return context;
 }
 
+void GrpcConnection::Connect() {
+  EnsureActiveStub();
+  grpc_channel_->GetState(/*try_to_connect=*/true);
+}
+
 void GrpcConnection::EnsureActiveStub() {
   // TODO(varconst): find out in which cases a gRPC channel might shut down.
   // This might be overkill.
   if (!grpc_channel_ || grpc_channel_->GetState(/*try_to_connect=*/false) ==
                             GRPC_CHANNEL_SHUTDOWN) {
     LOG_DEBUG("Creating Firestore stub.");
-    grpc_channel_ = CreateChannel();
+    grpc_channel_ =
+        Channels().Get(ChannelKey(), [this] { return CreateChannel(); });
     grpc_stub_ = absl::make_unique<grpc::GenericStub>(grpc_channel_);
   }
 }
 
+std::string GrpcConnection::ChannelKey() const {
+  // Channels may only be shared between connections that would have created
+  // identical channels.
+  const std::string& host = database_info_->host();
+  std::string key = absl::StrCat(host, "|", keepalive_time_.count());
+  const HostConfig* host_config = Config().find(host);
+  if (!host_config) {
+    return key;
+  }
+  if (host_config->use_insecure_channel) {
+    return absl::StrCat(key, "|insecure");
+  }
+  return absl::StrCat(key, "|", host_config->certificate_path.ToUtf8String(),
+                      "|", host_config->target_name);
+}
+
 std::shared_ptr<grpc::Channel> GrpcConnection::CreateChannel() const {
   const std::string& host = database_info_->host();
 
@@ -192,13 +291,12 @@ std::shared_ptr<grpc::Channel> GrpcConnection::CreateChannel() const {
   // Ensure gRPC recovers from a dead connection. (Not typically necessary, as
   // the OS will usually notify gRPC when a connection dies. But not always.
   // This acts as a failsafe.)
-  args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS, 30 * 1000);
+  args.SetInt(GRPC_ARG_KEEPALIVE_TIME_MS,
+              static_cast<int>(keepalive_time_.count()));
 
   const HostConfig* host_config = Config().find(host);
   if (!host_config) {
-    std::string root_certificate = LoadGrpcRootCertificate();
-    return grpc::CreateCustomChannel(
-        host, CreateSslCredentials(root_certificate), args);
+    return grpc::CreateCustomChannel(host, DefaultSslCredentials(), args);
   }
 
   // For the case when `Settings.set_ssl_enabled(false)`.
@@ -228,10 +326,15 @@ std::unique_ptr<GrpcStream> GrpcConnection::CreateStream(
   EnsureActiveStub();
 
   auto context = CreateContext(token);
+  if (compression_ != GRPC_COMPRESS_NONE) {
+    context->set_compression_algorithm(compression_);
+  }
   auto call =
       grpc_stub_->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
-  return absl::make_unique<GrpcStream>(std::move(context), std::move(call),
-                                       worker_queue_, this, observer);
+  auto stream = absl::make_unique<GrpcStream>(
+      std::move(context), std::move(call), worker_queue_, this, observer);
+  stream->set_compression_threshold(compression_threshold_);
+  return stream;
 }
 
 std::unique_ptr<GrpcUnaryCall> GrpcConnection::CreateUnaryCall(
@@ -254,6 +357,12 @@ std::unique_ptr<GrpcStreamingReader> GrpcConnection::CreateStreamingReader(
   EnsureActiveStub();
 
   auto context = CreateContext(token);
+  // The request is the only message sent, so the threshold can be applied to
+  // the whole call.
+  if (compression_ != GRPC_COMPRESS_NONE &&
+      message.Length() >= compression_threshold_) {
+    context->set_compression_algorithm(compression_);
+  }
   auto call =
       grpc_stub_->PrepareCall(context.get(), MakeString(rpc_name), grpc_queue_);
   return absl::make_unique<GrpcStreamingReader>(
@@ -274,6 +383,11 @@ void GrpcConnection::RegisterConnectivityMonitor() {
         // connection before eventually failing. Note that gRPC Objective-C
         // client does the same thing:
         // https://github.com/grpc/grpc/blob/fe11db09575f2dfbe1f88cd44bd417acc168e354/src/objective-c/GRPCClient/private/GRPCHost.m#L309-L314
+        // Other connections may share the channel, so also make sure it won't
+        // be handed out again.
+        if (grpc_channel_) {
+          Channels().Evict(ChannelKey(), grpc_channel_.get());
+        }
         grpc_channel_.reset();
       });
 }
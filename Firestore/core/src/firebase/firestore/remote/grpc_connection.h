@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CONNECTION_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_CONNECTION_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -52,6 +53,10 @@ namespace remote {
 /**
  * Creates and owns gRPC objects (channel and stub) necessary to produce a
  * `GrpcStream`.
+ *
+ * gRPC channels are shared by all connections in the process that have the
+ * same host and SSL settings, so that Firestore instances talking to the same
+ * backend reuse TCP connections and TLS sessions.
  */
 class GrpcConnection {
  public:
@@ -62,6 +67,12 @@ class GrpcConnection {
 
   void Shutdown();
 
+  /**
+   * Creates the gRPC channel, if there is none yet, and starts connecting it,
+   * so that the first call doesn't have to wait for the channel to be set up.
+   */
+  void Connect();
+
   /**
    * Creates a stream to the given stream RPC endpoint. The resulting stream
    * needs to be `Start`ed before it can be used.
@@ -85,6 +96,25 @@ class GrpcConnection {
   void Register(GrpcCall* call);
   void Unregister(GrpcCall* call);
 
+  /**
+   * Compresses messages on streams and streaming reads with the given
+   * algorithm, except for messages smaller than `threshold_bytes`. Call before
+   * creating any streams or calls.
+   */
+  void EnableCompression(grpc_compression_algorithm algorithm,
+                         size_t threshold_bytes) {
+    compression_ = algorithm;
+    compression_threshold_ = threshold_bytes;
+  }
+
+  /**
+   * Sets how often gRPC pings the backend to detect dead connections. Call
+   * before creating any streams or calls.
+   */
+  void SetKeepaliveTime(std::chrono::milliseconds keepalive_time) {
+    keepalive_time_ = keepalive_time;
+  }
+
   /**
    * Don't use SSL, send all traffic unencrypted. Call before creating any
    * streams or calls.
@@ -99,9 +129,15 @@ class GrpcConnection {
                                  const util::Path& certificate_path,
                                  const std::string& target_name);
 
+  /** Test-only method */
+  const std::shared_ptr<grpc::Channel>& grpc_channel() const {
+    return grpc_channel_;
+  }
+
  private:
   std::unique_ptr<grpc::ClientContext> CreateContext(
       const auth::Token& credential) const;
+  std::string ChannelKey() const;
   std::shared_ptr<grpc::Channel> CreateChannel() const;
   void EnsureActiveStub();
 
@@ -116,6 +152,10 @@ class GrpcConnection {
 
   ConnectivityMonitor* connectivity_monitor_ = nullptr;
   std::vector<GrpcCall*> active_calls_;
+
+  grpc_compression_algorithm compression_ = GRPC_COMPRESS_NONE;
+  size_t compression_threshold_ = 0;
+  std::chrono::milliseconds keepalive_time_{std::chrono::seconds(30)};
 };
 
 }  // namespace remote
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/grpc_nanopb.h"
 
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 #include "Firestore/core/include/firebase/firestore/firestore_errors.h"
@@ -28,38 +30,76 @@ namespace firebase {
 namespace firestore {
 namespace remote {
 
-using nanopb::ByteString;
-using nanopb::ByteStringWriter;
 using util::Status;
 
-ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer) {
-  std::vector<grpc::Slice> slices;
-  grpc::Status status = buffer.Dump(&slices);
+ByteBufferInputStream::ByteBufferInputStream(const grpc::ByteBuffer& buffer) {
+  // Dumping the buffer only takes references to its slices.
+  grpc::Status status = buffer.Dump(&slices_);
   // Conversion may fail if compression is used and gRPC tries to decompress an
   // ill-formed buffer.
   if (!status.ok()) {
-    Status error{Error::kInternal,
-                 "Trying to convert an invalid grpc::ByteBuffer"};
-    error.CausedBy(ConvertStatus(status));
-    set_status(error);
-    return;
+    status_ = Status{Error::kInternal,
+                     "Trying to convert an invalid grpc::ByteBuffer"};
+    status_.CausedBy(ConvertStatus(status));
+    slices_.clear();
   }
 
-  ByteStringWriter writer;
-  writer.Reserve(buffer.Length());
-  for (const auto& slice : slices) {
-    writer.Append(slice.begin(), slice.size());
+  size_t size = 0;
+  for (const grpc::Slice& slice : slices_) {
+    size += slice.size();
   }
 
-  bytes_ = writer.Release();
-  stream_ = pb_istream_from_buffer(bytes_.data(), bytes_.size());
+  if (slices_.size() == 1) {
+    // A single slice can be read like any contiguous buffer, which avoids a
+    // callback for each small read Nanopb makes.
+    stream_ = pb_istream_from_buffer(slices_[0].begin(), size);
+  } else {
+    stream_.callback = ReadSlices;
+    stream_.state = this;
+    stream_.bytes_left = size;
+  }
+}
+
+bool ByteBufferInputStream::ReadSlices(pb_istream_t* stream,
+                                       pb_byte_t* buf,
+                                       size_t count) {
+  auto self = static_cast<ByteBufferInputStream*>(stream->state);
+  while (count > 0) {
+    if (self->slice_index_ == self->slices_.size()) {
+      PB_RETURN_ERROR(stream, "end-of-stream");
+    }
+
+    const grpc::Slice& slice = self->slices_[self->slice_index_];
+    size_t available = slice.size() - self->slice_offset_;
+    size_t length = std::min(count, available);
+    if (buf) {
+      std::memcpy(buf, slice.begin() + self->slice_offset_, length);
+      buf += length;
+    }
+    count -= length;
+
+    if (length == available) {
+      ++self->slice_index_;
+      self->slice_offset_ = 0;
+    } else {
+      self->slice_offset_ += length;
+    }
+  }
+  return true;
+}
+
+ByteBufferReader::ByteBufferReader(const grpc::ByteBuffer& buffer)
+    : input_{buffer} {
+  if (!input_.status().ok()) {
+    set_status(input_.status());
+  }
 }
 
 void ByteBufferReader::Read(const pb_field_t* fields, void* dest_struct) {
   if (!ok()) return;
 
-  if (!pb_decode(&stream_, fields, dest_struct)) {
-    Fail(PB_GET_ERROR(&stream_));
+  if (!pb_decode(input_.stream(), fields, dest_struct)) {
+    Fail(PB_GET_ERROR(input_.stream()));
   }
 }
 
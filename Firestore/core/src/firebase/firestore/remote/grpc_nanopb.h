@@ -26,27 +26,62 @@
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "grpcpp/support/byte_buffer.h"
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
+/**
+ * A Nanopb input stream that reads the slices of a `grpc::ByteBuffer` where
+ * they are, rather than from a contiguous copy of them, so that decoding large
+ * messages doesn't copy them first.
+ */
+class ByteBufferInputStream {
+ public:
+  explicit ByteBufferInputStream(const grpc::ByteBuffer& buffer);
+
+  ByteBufferInputStream(const ByteBufferInputStream&) = delete;
+  ByteBufferInputStream& operator=(const ByteBufferInputStream&) = delete;
+
+  /**
+   * The stream reading the buffer. Fails every read if the buffer couldn't be
+   * read, in which case `status()` describes why.
+   */
+  pb_istream_t* stream() {
+    return &stream_;
+  }
+
+  const util::Status& status() const {
+    return status_;
+  }
+
+ private:
+  static bool ReadSlices(pb_istream_t* stream, pb_byte_t* buf, size_t count);
+
+  std::vector<grpc::Slice> slices_;
+  // The position of the next byte to read.
+  size_t slice_index_ = 0;
+  size_t slice_offset_ = 0;
+
+  util::Status status_;
+  pb_istream_t stream_{};
+};
+
 /** A `Reader` that reads from the given `grpc::ByteBuffer`. */
 class ByteBufferReader : public nanopb::Reader {
  public:
   /**
-   * Copies the given `buffer` and associates the resulting stream with this
-   * `ByteBufferReader`.
+   * Associates the slices of the given `buffer` with this `ByteBufferReader`,
+   * without copying their contents.
    */
-  // TODO(varconst): avoid copying the buffer.
   explicit ByteBufferReader(const grpc::ByteBuffer& buffer);
 
   void Read(const pb_field_t* fields, void* dest_struct) override;
 
  private:
-  nanopb::ByteString bytes_;
-  pb_istream_t stream_{};
+  ByteBufferInputStream input_;
 };
 
 /** A `Writer` that writes into a `grpc::ByteBuffer`. */
@@ -29,6 +29,9 @@ namespace remote {
  * Finds the file containing gRPC root certificates (how it is stored differs by
  * platform) and returns its contents as a string. Will trigger assertion
  * failure if the file cannot be found or open.
+ *
+ * This is relatively expensive, so callers should load the certificates once
+ * and share the credentials created from them.
  */
 std::string LoadGrpcRootCertificate();
 
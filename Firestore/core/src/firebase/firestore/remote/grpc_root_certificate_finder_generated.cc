@@ -15,20 +15,60 @@
  */
 
 /**
- * This implementation presumes that `roots.pem` has been embedded into the
- * binary during the build and is accessible as a char array named
- * `grpc_root_certificates`.
+ * This implementation prefers the certificate bundle of the platform, where
+ * one can be found at a well-known path, and otherwise falls back to
+ * `roots.pem`, which has been embedded into the binary during the build and is
+ * accessible as a char array named `grpc_root_certificates`.
  */
 
 #include "Firestore/core/src/firebase/firestore/remote/grpc_root_certificate_finder.h"
 
+#include <string>
+#include <utility>
+
 #include "Firestore/core/src/firebase/firestore/remote/grpc_root_certificates_generated.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
 
 namespace firebase {
 namespace firestore {
 namespace remote {
 
+using util::Filesystem;
+using util::Path;
+using util::StatusOr;
+
+namespace {
+
+#if !__APPLE__ && !_WIN32
+// The locations of the system certificate bundle used by common Linux
+// distributions and BSDs. Apple platforms keep their trust store in the
+// keychain, so they always use the embedded roots.
+const char* const kSystemRootCertificatePaths[] = {
+    "/etc/ssl/certs/ca-certificates.crt",
+    "/etc/pki/tls/certs/ca-bundle.crt",
+    "/etc/ssl/ca-bundle.pem",
+    "/etc/pki/tls/cacert.pem",
+    "/etc/pki/ca-trust/extracted/pem/tls-ca-bundle.pem",
+    "/etc/ssl/cert.pem",
+};
+#endif  // !__APPLE__ && !_WIN32
+
+}  // namespace
+
 std::string LoadGrpcRootCertificate() {
+#if !__APPLE__ && !_WIN32
+  auto* fs = Filesystem::Default();
+  for (const char* path : kSystemRootCertificatePaths) {
+    StatusOr<std::string> certificates = fs->ReadFile(Path::FromUtf8(path));
+    if (certificates.ok() && !certificates.ValueOrDie().empty()) {
+      LOG_DEBUG("Using system root certificates from %s", path);
+      return std::move(certificates).ValueOrDie();
+    }
+  }
+#endif  // !__APPLE__ && !_WIN32
+
   return {reinterpret_cast<const char*>(grpc_root_certificates_generated_data),
           grpc_root_certificates_generated_size};
 }
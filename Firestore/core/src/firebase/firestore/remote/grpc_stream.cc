@@ -152,6 +152,7 @@ void GrpcStream::MaybeWrite(absl::optional<BufferedWrite> maybe_write) {
   }
 
   BufferedWrite write = std::move(maybe_write).value();
+  MaybeSkipCompression(write.message, &write.options);
   auto completion = NewCompletion(
       Type::Write,
       [this](const std::shared_ptr<GrpcCompletion>&) { OnWrite(); });
@@ -160,6 +161,13 @@ void GrpcStream::MaybeWrite(absl::optional<BufferedWrite> maybe_write) {
   call_->Write(*completion->message(), write.options, completion.get());
 }
 
+void GrpcStream::MaybeSkipCompression(const grpc::ByteBuffer& message,
+                                      grpc::WriteOptions* options) const {
+  if (message.Length() < compression_threshold_) {
+    options->set_no_compression();
+  }
+}
+
 void GrpcStream::FinishImmediately() {
   LOG_DEBUG("GrpcStream('%s'): finishing without notifying observers", this);
 
@@ -272,7 +280,8 @@ bool GrpcStream::TryLastWrite(grpc::ByteBuffer&& message) {
   BufferedWrite last_write = std::move(maybe_write).value();
   auto completion = NewCompletion(Type::Write, {});
   *completion->message() = last_write.message;
-  call_->WriteLast(*completion->message(), grpc::WriteOptions{},
+  MaybeSkipCompression(last_write.message, &last_write.options);
+  call_->WriteLast(*completion->message(), last_write.options,
                    completion.get());
 
   // Empirically, the write normally takes less than a millisecond to finish
@@ -318,6 +327,7 @@ void GrpcStream::OnOperationFailed() {
   }
 
   FinishGrpcCall([this](const std::shared_ptr<GrpcCompletion>& completion) {
+    retry_delay_ = GetRetryDelay(*completion->status());
     Status status = ConvertStatus(*completion->status());
     FinishAndNotify(status);
   });
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_STREAM_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_GRPC_STREAM_H_
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <functional>
 #include <map>
 #include <memory>
@@ -169,6 +170,15 @@ class GrpcStream : public GrpcCall {
     return observer_ == nullptr;
   }
 
+  /**
+   * Messages smaller than the given number of bytes are written uncompressed,
+   * even if compression is enabled on the stream's context. Compression isn't
+   * worth the CPU time for small messages.
+   */
+  void set_compression_threshold(size_t bytes) {
+    compression_threshold_ = bytes;
+  }
+
   /**
    * Returns the metadata received from the server.
    *
@@ -176,6 +186,14 @@ class GrpcStream : public GrpcCall {
    */
   Metadata GetResponseHeaders() const override;
 
+  /**
+   * Returns the delay after which the server asked to retry, if the stream
+   * failed with a status that included one.
+   */
+  const absl::optional<std::chrono::milliseconds>& retry_delay() const {
+    return retry_delay_;
+  }
+
   /** For tests only */
   grpc::ClientContext* context() override {
     return context_.get();
@@ -185,6 +203,8 @@ class GrpcStream : public GrpcCall {
   void Read();
   void MaybeWrite(absl::optional<internal::BufferedWrite> maybe_write);
   bool TryLastWrite(grpc::ByteBuffer&& message);
+  void MaybeSkipCompression(const grpc::ByteBuffer& message,
+                            grpc::WriteOptions* options) const;
 
   void Shutdown();
   void UnsetObserver() {
@@ -237,6 +257,10 @@ class GrpcStream : public GrpcCall {
 
   std::vector<std::shared_ptr<GrpcCompletion>> completions_;
 
+  size_t compression_threshold_ = 0;
+
+  absl::optional<std::chrono::milliseconds> retry_delay_;
+
   // gRPC asserts that a call is finished exactly once.
   bool is_grpc_call_finished_ = false;
 };
@@ -16,15 +16,36 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/grpc_util.h"
 
+#include <string>
+
+#include "Firestore/Protos/nanopb/google/protobuf/timestamp.nanopb.h"
+#include "Firestore/Protos/nanopb/google/rpc/status.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/message.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 
 namespace firebase {
 namespace firestore {
 namespace remote {
+namespace {
+
+namespace chr = std::chrono;
 
+using nanopb::MakeStringView;
+using nanopb::Message;
+using nanopb::StringReader;
 using util::Status;
 
+const char* const kRetryInfoTypeUrl =
+    "type.googleapis.com/google.rpc.RetryInfo";
+
+// The tag of `google.rpc.RetryInfo.retry_delay`.
+const uint32_t kRetryDelayTag = 1;
+
+}  // namespace
+
 Status ConvertStatus(const grpc::Status& from) {
   if (from.ok()) {
     return Status::OK();
@@ -43,6 +64,55 @@ Status ConvertStatus(const grpc::Status& from) {
   return {static_cast<Error>(error_code), from.error_message()};
 }
 
+absl::optional<chr::milliseconds> GetRetryDelay(const grpc::Status& status) {
+  const std::string& details = status.error_details();
+  if (details.empty()) {
+    return absl::nullopt;
+  }
+
+  StringReader reader{details};
+  auto proto = Message<google_rpc_Status>::TryParse(&reader);
+  if (!reader.ok()) {
+    return absl::nullopt;
+  }
+
+  for (pb_size_t i = 0; i < proto->details_count; ++i) {
+    const google_protobuf_Any& detail = proto->details[i];
+    if (MakeStringView(detail.type_url) != kRetryInfoTypeUrl ||
+        detail.value == nullptr) {
+      continue;
+    }
+
+    // There's no generated message for `google.rpc.RetryInfo`, so read its
+    // only field by hand.
+    pb_istream_t stream =
+        pb_istream_from_buffer(detail.value->bytes, detail.value->size);
+    pb_wire_type_t wire_type;
+    uint32_t tag = 0;
+    bool eof = false;
+    while (pb_decode_tag(&stream, &wire_type, &tag, &eof)) {
+      if (tag != kRetryDelayTag || wire_type != PB_WT_STRING) {
+        if (!pb_skip_field(&stream, wire_type)) {
+          break;
+        }
+        continue;
+      }
+
+      // `google.protobuf.Duration` has the same fields as
+      // `google.protobuf.Timestamp`.
+      google_protobuf_Timestamp delay{};
+      if (!pb_decode_delimited(&stream, google_protobuf_Timestamp_fields,
+                               &delay) ||
+          delay.seconds < 0 || delay.nanos < 0) {
+        break;
+      }
+      return chr::duration_cast<chr::milliseconds>(
+          chr::seconds(delay.seconds) + chr::nanoseconds(delay.nanos));
+    }
+  }
+  return absl::nullopt;
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
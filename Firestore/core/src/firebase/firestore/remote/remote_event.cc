@@ -16,10 +16,14 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 
+#include <algorithm>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 
 namespace firebase {
 namespace firestore {
@@ -29,14 +33,30 @@ using core::DocumentViewChange;
 using core::Target;
 using local::QueryPurpose;
 using local::TargetData;
+using model::DatabaseId;
 using model::DocumentKey;
 using model::DocumentKeySet;
 using model::MaybeDocument;
 using model::NoDocument;
+using model::ResourcePath;
 using model::SnapshotVersion;
 using model::TargetId;
 using nanopb::ByteString;
 
+namespace {
+
+/**
+ * Builds a DocumentKeySet from keys collected in no particular order. Sorting
+ * up front lets the set be built in linear time, without inserting the keys
+ * one at a time.
+ */
+DocumentKeySet ToDocumentKeySet(std::vector<DocumentKey> keys) {
+  std::sort(keys.begin(), keys.end());
+  return DocumentKeySet::FromSortedRange(keys.begin(), keys.end());
+}
+
+}  // namespace
+
 // TargetChange
 
 bool operator==(const TargetChange& lhs, const TargetChange& rhs) {
@@ -57,9 +77,9 @@ void TargetState::UpdateResumeToken(ByteString resume_token) {
 }
 
 TargetChange TargetState::ToTargetChange() const {
-  DocumentKeySet added_documents;
-  DocumentKeySet modified_documents;
-  DocumentKeySet removed_documents;
+  std::vector<DocumentKey> added_documents;
+  std::vector<DocumentKey> modified_documents;
+  std::vector<DocumentKey> removed_documents;
 
   for (const auto& entry : document_changes_) {
     const DocumentKey& document_key = entry.first;
@@ -67,22 +87,23 @@ TargetChange TargetState::ToTargetChange() const {
 
     switch (change_type) {
       case DocumentViewChange::Type::Added:
-        added_documents = added_documents.insert(document_key);
+        added_documents.push_back(document_key);
         break;
       case DocumentViewChange::Type::Modified:
-        modified_documents = modified_documents.insert(document_key);
+        modified_documents.push_back(document_key);
         break;
       case DocumentViewChange::Type::Removed:
-        removed_documents = removed_documents.insert(document_key);
+        removed_documents.push_back(document_key);
         break;
       default:
         HARD_FAIL("Encountered invalid change type: %s", change_type);
     }
   }
 
-  return TargetChange{resume_token(), current(), std::move(added_documents),
-                      std::move(modified_documents),
-                      std::move(removed_documents)};
+  return TargetChange{resume_token(), current(),
+                      ToDocumentKeySet(std::move(added_documents)),
+                      ToDocumentKeySet(std::move(modified_documents)),
+                      ToDocumentKeySet(std::move(removed_documents))};
 }
 
 void TargetState::ClearPendingChanges() {
@@ -237,10 +258,21 @@ void WatchChangeAggregator::HandleExistenceFilter(
     } else {
       int current_size = GetCurrentDocumentCountForTarget(target_id);
       if (current_size != expected_count) {
-        // Existence filter mismatch: We reset the mapping and raise a new
-        // snapshot with `isFromCache:true`.
-        ResetTarget(target_id);
-        pending_target_resets_.insert(target_id);
+        // Existence filter mismatch. If the backend told us which documents
+        // are unchanged, removing the others may be enough to reconcile the
+        // target without re-running the query.
+        const absl::optional<BloomFilter>& unchanged_names =
+            existence_filter.filter().unchanged_names();
+        if (unchanged_names) {
+          current_size -= FilterRemovedDocuments(*unchanged_names, target_id);
+        }
+
+        if (current_size != expected_count) {
+          // We reset the mapping and raise a new snapshot with
+          // `isFromCache:true`.
+          ResetTarget(target_id);
+          pending_target_resets_.insert(target_id);
+        }
       }
     }
   }
@@ -257,20 +289,29 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     absl::optional<TargetData> target_data =
         TargetDataForActiveTarget(target_id);
     if (target_data) {
-      if (target_state.current() && target_data->target().IsDocumentQuery()) {
+      const Target& target = target_data->target();
+      if (target_state.current() &&
+          (target.IsDocumentQuery() || target.IsMultiDocumentTarget())) {
         // Document queries for document that don't exist can produce an empty
         // result set. To update our local cache, we synthesize a document
         // delete if we have not previously received the document. This resolves
         // the limbo state of the document, removing it from
         // SyncEngine::limbo_document_refs_.
-        DocumentKey key{target_data->target().path()};
-        if (pending_document_updates_.find(key) ==
-                pending_document_updates_.end() &&
-            !TargetContainsDocument(target_id, key)) {
-          RemoveDocumentFromTarget(
-              target_id, key,
-              NoDocument(key, snapshot_version,
-                         /* has_committed_mutations= */ false));
+        std::vector<DocumentKey> keys;
+        if (target.IsMultiDocumentTarget()) {
+          keys = target.document_keys();
+        } else {
+          keys.emplace_back(target.path());
+        }
+        for (const DocumentKey& key : keys) {
+          if (pending_document_updates_.find(key) ==
+                  pending_document_updates_.end() &&
+              !TargetContainsDocument(target_id, key)) {
+            RemoveDocumentFromTarget(
+                target_id, key,
+                NoDocument(key, snapshot_version,
+                           /* has_committed_mutations= */ false));
+          }
         }
       }
 
@@ -281,7 +322,7 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     }
   }
 
-  DocumentKeySet resolved_limbo_documents;
+  std::vector<DocumentKey> resolved_limbo_documents;
 
   // We extract the set of limbo-only document updates as the GC logic
   // special-cases documents that do not appear in the target cache.
@@ -301,14 +342,14 @@ RemoteEvent WatchChangeAggregator::CreateRemoteEvent(
     }
 
     if (is_only_limbo_target) {
-      resolved_limbo_documents = resolved_limbo_documents.insert(entry.first);
+      resolved_limbo_documents.push_back(entry.first);
     }
   }
 
-  RemoteEvent remote_event{snapshot_version, std::move(target_changes),
-                           std::move(pending_target_resets_),
-                           std::move(pending_document_updates_),
-                           std::move(resolved_limbo_documents)};
+  RemoteEvent remote_event{
+      snapshot_version, std::move(target_changes),
+      std::move(pending_target_resets_), std::move(pending_document_updates_),
+      ToDocumentKeySet(std::move(resolved_limbo_documents))};
 
   // Re-initialize the current state to ensure that we do not modify the
   // generated `RemoteEvent`.
@@ -334,7 +375,7 @@ void WatchChangeAggregator::AddDocumentToTarget(TargetId target_id,
   target_state.AddDocumentChange(document.key(), change_type);
 
   pending_document_updates_[document.key()] = document;
-  pending_document_target_mappings_[document.key()].insert(target_id);
+  AddDocumentTargetMapping(document.key(), target_id);
 }
 
 void WatchChangeAggregator::RemoveDocumentFromTarget(
@@ -353,17 +394,46 @@ void WatchChangeAggregator::RemoveDocumentFromTarget(
     // snapshot, so we can just ignore the change.
     target_state.RemoveDocumentChange(key);
   }
-  pending_document_target_mappings_[key].insert(target_id);
+  AddDocumentTargetMapping(key, target_id);
 
   if (updated_document) {
     pending_document_updates_[key] = *updated_document;
   }
 }
 
+void WatchChangeAggregator::AddDocumentTargetMapping(const DocumentKey& key,
+                                                     TargetId target_id) {
+  absl::InlinedVector<TargetId, 2>& target_ids =
+      pending_document_target_mappings_[key];
+  if (std::find(target_ids.begin(), target_ids.end(), target_id) ==
+      target_ids.end()) {
+    target_ids.push_back(target_id);
+  }
+}
+
 void WatchChangeAggregator::RemoveTarget(TargetId target_id) {
   target_states_.erase(target_id);
 }
 
+int WatchChangeAggregator::FilterRemovedDocuments(
+    const BloomFilter& bloom_filter, TargetId target_id) {
+  const DatabaseId& database_id = target_metadata_provider_->GetDatabaseId();
+  ResourcePath documents{"projects", database_id.project_id(), "databases",
+                         database_id.database_id(), "documents"};
+
+  int removal_count = 0;
+  DocumentKeySet existing_keys =
+      target_metadata_provider_->GetRemoteKeysForTarget(target_id);
+  for (const DocumentKey& key : existing_keys) {
+    std::string name = documents.Append(key.path()).CanonicalString();
+    if (!bloom_filter.MightContain(name)) {
+      RemoveDocumentFromTarget(target_id, key, absl::nullopt);
+      ++removal_count;
+    }
+  }
+  return removal_count;
+}
+
 int WatchChangeAggregator::GetCurrentDocumentCountForTarget(
     TargetId target_id) {
   TargetState& target_state = EnsureTargetState(target_id);
@@ -17,13 +17,13 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_REMOTE_EVENT_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_REMOTE_EVENT_H_
 
-#include <set>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
@@ -31,6 +31,8 @@
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 
 namespace firebase {
 namespace firestore {
@@ -62,6 +64,12 @@ class TargetMetadataProvider {
    */
   virtual absl::optional<local::TargetData> GetTargetDataForTarget(
       model::TargetId target_id) const = 0;
+
+  /**
+   * Returns the database the targets belong to, which qualifies the document
+   * names in existence filter bloom filters.
+   */
+  virtual const model::DatabaseId& GetDatabaseId() const = 0;
 };
 
 /**
@@ -320,8 +328,9 @@ class WatchChangeAggregator {
 
   /**
    * Handles existence filters and synthesizes deletes for filter mismatches.
-   * Targets that are invalidated by filter mismatches are added to
-   * `pending_target_resets_`.
+   * If the filter carries a bloom filter of the unchanged documents, documents
+   * missing from it are removed from the target. Targets whose mismatch isn't
+   * resolved that way are added to `pending_target_resets_`.
    */
   void HandleExistenceFilter(
       const ExistenceFilterWatchChange& existence_filter);
@@ -370,6 +379,13 @@ class WatchChangeAggregator {
       const model::DocumentKey& key,
       const absl::optional<model::MaybeDocument>& updated_document);
 
+  /**
+   * Removes the documents in the target that the bloom filter shows are no
+   * longer in it, returning the number removed.
+   */
+  int FilterRemovedDocuments(const BloomFilter& bloom_filter,
+                             model::TargetId target_id);
+
   /**
    * Returns the current count of documents in the target. This includes both
    * the number of documents that the LocalStore considers to be part of the
@@ -411,16 +427,29 @@ class WatchChangeAggregator {
   bool TargetContainsDocument(model::TargetId target_id,
                               const model::DocumentKey& key);
 
-  /** The internal state of all tracked targets. */
-  std::unordered_map<model::TargetId, TargetState> target_states_;
+  /** Records that the document with `key` changed in `target_id`. */
+  void AddDocumentTargetMapping(const model::DocumentKey& key,
+                                model::TargetId target_id);
+
+  /**
+   * The internal state of all tracked targets.
+   *
+   * Inserting a target moves the states of the others, so references returned
+   * by `EnsureTargetState` are only valid until another target is added.
+   */
+  absl::flat_hash_map<model::TargetId, TargetState> target_states_;
 
   /** Keeps track of the documents to update since the last raised snapshot. */
   RemoteEvent::DocumentUpdateMap pending_document_updates_;
 
-  /** A mapping of document keys to their set of target IDs. */
-  std::unordered_map<model::DocumentKey,
-                     std::set<model::TargetId>,
-                     model::DocumentKeyHash>
+  /**
+   * A mapping of document keys to the distinct IDs of the targets they changed
+   * in. Nearly every document is in one or two targets, so the IDs are stored
+   * inline.
+   */
+  absl::flat_hash_map<model::DocumentKey,
+                      absl::InlinedVector<model::TargetId, 2>,
+                      model::DocumentKeyHash>
       pending_document_target_mappings_;
 
   /**
@@ -19,7 +19,9 @@
 #include <map>
 
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/target.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
@@ -39,8 +41,11 @@ namespace firestore {
 namespace remote {
 
 using core::DatabaseInfo;
+using core::Target;
 using local::TargetData;
+using model::Document;
 using model::DocumentKey;
+using model::FieldPath;
 using model::MaybeDocument;
 using model::Mutation;
 using model::MutationResult;
@@ -103,13 +108,18 @@ WatchStreamSerializer::EncodeUnwatchRequest(TargetId target_id) const {
 
 Message<google_firestore_v1_ListenResponse>
 WatchStreamSerializer::ParseResponse(Reader* reader) const {
-  return Message<google_firestore_v1_ListenResponse>::TryParse(reader);
+  // Responses are converted to `WatchChange`s right away and discarded, so
+  // decode them into an arena rather than allocating each member separately.
+  using ListenResponse = Message<google_firestore_v1_ListenResponse>;
+  return ListenResponse::TryParseWithArena(reader);
 }
 
 std::unique_ptr<WatchChange> WatchStreamSerializer::DecodeWatchChange(
     nanopb::Reader* reader,
-    const google_firestore_v1_ListenResponse& response) const {
-  return serializer_.DecodeWatchChange(reader, response);
+    const google_firestore_v1_ListenResponse& response,
+    pb_istream_t* encoded_response) const {
+  return serializer_.DecodeWatchChangeWithEncodedDocument(reader, response,
+                                                         encoded_response);
 }
 
 SnapshotVersion WatchStreamSerializer::DecodeSnapshotVersion(
@@ -268,6 +278,88 @@ DatastoreSerializer::MergeLookupResponses(
   return result;
 }
 
+Message<google_firestore_v1_RunQueryRequest>
+DatastoreSerializer::EncodeRunQueryRequest(const Target& target) const {
+  Message<google_firestore_v1_RunQueryRequest> result;
+
+  // The message takes ownership of the query target's allocations.
+  google_firestore_v1_Target_QueryTarget query_target =
+      serializer_.EncodeQueryTarget(target);
+  result->parent = query_target.parent;
+  result->which_query_type =
+      google_firestore_v1_RunQueryRequest_structured_query_tag;
+  result->query_type.structured_query = query_target.structured_query;
+
+  return result;
+}
+
+StatusOr<RunQueryResult> DatastoreSerializer::MergeRunQueryResponses(
+    const std::vector<grpc::ByteBuffer>& responses) const {
+  RunQueryResult result;
+
+  for (const auto& response : responses) {
+    result.byte_size += response.Length();
+
+    ByteBufferReader reader{response};
+    auto message =
+        Message<google_firestore_v1_RunQueryResponse>::TryParse(&reader);
+
+    // Responses that only report progress don't contain a document.
+    if (message->document.name != nullptr) {
+      result.documents.push_back(
+          serializer_.DecodeDocument(&reader, message->document));
+    }
+    SnapshotVersion read_time =
+        serializer_.DecodeVersion(&reader, message->read_time);
+    if (!reader.ok()) {
+      return reader.status();
+    }
+
+    if (read_time > result.read_time) {
+      result.read_time = read_time;
+    }
+  }
+
+  return StatusOr<RunQueryResult>{std::move(result)};
+}
+
+Message<google_firestore_v1_RunQueryRequest>
+DatastoreSerializer::EncodeCountQueryRequest(const Target& target) const {
+  Message<google_firestore_v1_RunQueryRequest> result =
+      EncodeRunQueryRequest(target);
+
+  google_firestore_v1_StructuredQuery_Projection& select =
+      result->query_type.structured_query.select;
+  select.fields_count = 1;
+  select.fields = MakeArray<google_firestore_v1_StructuredQuery_FieldReference>(
+      select.fields_count);
+  select.fields[0].field_path =
+      Serializer::EncodeFieldPath(FieldPath::KeyFieldPath());
+
+  return result;
+}
+
+StatusOr<int64_t> DatastoreSerializer::CountRunQueryResponses(
+    const std::vector<grpc::ByteBuffer>& responses) const {
+  int64_t count = 0;
+
+  for (const auto& response : responses) {
+    ByteBufferReader reader{response};
+    auto message =
+        Message<google_firestore_v1_RunQueryResponse>::TryParse(&reader);
+    if (!reader.ok()) {
+      return reader.status();
+    }
+
+    // Responses that only report progress don't contain a document.
+    if (message->document.name != nullptr) {
+      ++count;
+    }
+  }
+
+  return count;
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
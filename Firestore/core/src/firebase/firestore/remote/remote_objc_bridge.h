@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_REMOTE_OBJC_BRIDGE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_REMOTE_OBJC_BRIDGE_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <utility>
@@ -24,6 +25,8 @@
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/core/core_fwd.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
@@ -42,7 +45,6 @@ class TargetData;
 namespace model {
 class DocumentKey;
 class MaybeDocument;
-class SnapshotVersion;
 }  // namespace model
 
 namespace remote {
@@ -75,9 +77,15 @@ class WatchStreamSerializer {
 
   nanopb::Message<google_firestore_v1_ListenResponse> ParseResponse(
       nanopb::Reader* reader) const;
+  /**
+   * Decodes the watch change in `response`, keeping the encoded document of a
+   * document change, read by `encoded_response` from the bytes `response` was
+   * parsed from.
+   */
   std::unique_ptr<WatchChange> DecodeWatchChange(
       nanopb::Reader* reader,
-      const google_firestore_v1_ListenResponse& response) const;
+      const google_firestore_v1_ListenResponse& response,
+      pb_istream_t* encoded_response) const;
   model::SnapshotVersion DecodeSnapshotVersion(
       nanopb::Reader* reader,
       const google_firestore_v1_ListenResponse& response) const;
@@ -110,6 +118,15 @@ class WriteStreamSerializer {
   Serializer serializer_;
 };
 
+/** The documents returned by a RunQuery call. */
+struct RunQueryResult {
+  std::vector<model::Document> documents;
+  /** The time at which the backend read the documents. */
+  model::SnapshotVersion read_time;
+  /** The total size of the responses, in bytes. */
+  size_t byte_size = 0;
+};
+
 class DatastoreSerializer {
  public:
   explicit DatastoreSerializer(const core::DatabaseInfo& database_info);
@@ -127,6 +144,30 @@ class DatastoreSerializer {
   util::StatusOr<std::vector<model::MaybeDocument>> MergeLookupResponses(
       const std::vector<grpc::ByteBuffer>& responses) const;
 
+  nanopb::Message<google_firestore_v1_RunQueryRequest> EncodeRunQueryRequest(
+      const core::Target& target) const;
+
+  /**
+   * Merges the responses of a RunQuery call. The documents are in the order
+   * the backend returned them, which is the order of the query.
+   */
+  util::StatusOr<RunQueryResult> MergeRunQueryResponses(
+      const std::vector<grpc::ByteBuffer>& responses) const;
+
+  /**
+   * Encodes a RunQuery request for the given target that selects only the
+   * names of the matching documents, which is all a count needs.
+   */
+  nanopb::Message<google_firestore_v1_RunQueryRequest> EncodeCountQueryRequest(
+      const core::Target& target) const;
+
+  /**
+   * Counts the documents in the responses of a RunQuery call without
+   * converting them to `Document`s.
+   */
+  util::StatusOr<int64_t> CountRunQueryResponses(
+      const std::vector<grpc::ByteBuffer>& responses) const;
+
   const Serializer& serializer() const {
     return serializer_;
   }
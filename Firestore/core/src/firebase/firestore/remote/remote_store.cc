@@ -16,8 +16,12 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <iterator>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
 #include "Firestore/core/src/firebase/firestore/local/local_store.h"
@@ -40,8 +44,11 @@ using local::LocalStore;
 using local::QueryPurpose;
 using local::TargetData;
 using model::BatchId;
+using model::DatabaseId;
+using model::DocumentKey;
 using model::DocumentKeySet;
 using model::kBatchIdUnknown;
+using model::Mutation;
 using model::MutationBatch;
 using model::MutationBatchResult;
 using model::MutationResult;
@@ -53,26 +60,60 @@ using util::AsyncQueue;
 using util::Status;
 
 /**
- * The maximum number of pending writes to allow.
- * TODO(b/35853402): Negotiate this value with the backend.
+ * The maximum number of mutations to send in a single coalesced write request,
+ * matching the backend's limit on the number of writes per commit. Batches
+ * that are larger on their own are still sent, just not coalesced.
  */
-constexpr int kMaxPendingWrites = 10;
+constexpr size_t kMaxMutationsPerWriteRequest = 500;
+
+RemoteStore::WatchShard::WatchShard(RemoteStore* remote_store,
+                                    Datastore* datastore)
+    : remote_store_{remote_store} {
+  stream = datastore->CreateWatchStream(this);
+}
+
+void RemoteStore::WatchShard::OnWatchStreamOpen() {
+  remote_store_->OnWatchStreamOpen(*this);
+}
+
+void RemoteStore::WatchShard::OnWatchStreamChange(
+    const WatchChange& change, const SnapshotVersion& snapshot_version) {
+  remote_store_->OnWatchStreamChange(*this, change, snapshot_version);
+}
+
+void RemoteStore::WatchShard::OnWatchStreamClose(const Status& status) {
+  remote_store_->OnWatchStreamClose(*this, status);
+}
 
 RemoteStore::RemoteStore(
     LocalStore* local_store,
     std::shared_ptr<Datastore> datastore,
     const std::shared_ptr<AsyncQueue>& worker_queue,
-    std::function<void(model::OnlineState)> online_state_handler)
+    std::function<void(model::OnlineState)> online_state_handler,
+    int watch_stream_count)
     : local_store_{local_store},
       datastore_{std::move(datastore)},
+      worker_queue_{worker_queue},
       online_state_tracker_{worker_queue, std::move(online_state_handler)} {
   datastore_->Start();
 
   // Create streams (but note they're not started yet)
-  watch_stream_ = datastore_->CreateWatchStream(this);
+  for (int i = 0; i < std::max(1, watch_stream_count); ++i) {
+    watch_shards_.push_back(
+        absl::make_unique<WatchShard>(this, datastore_.get()));
+  }
   write_stream_ = datastore_->CreateWriteStream(this);
 }
 
+void RemoteStore::SetStreamIdleTimeouts(
+    AsyncQueue::Milliseconds initial_timeout,
+    AsyncQueue::Milliseconds max_timeout) {
+  for (const auto& shard : watch_shards_) {
+    shard->stream->SetIdleTimeouts(initial_timeout, max_timeout);
+  }
+  write_stream_->SetIdleTimeouts(initial_timeout, max_timeout);
+}
+
 void RemoteStore::Start() {
   // For now, all setup is handled by `EnableNetwork`. We might expand on this
   // in the future.
@@ -86,9 +127,14 @@ void RemoteStore::EnableNetwork() {
     // Load any saved stream token from persistent storage
     write_stream_->set_last_stream_token(local_store_->GetLastStreamToken());
 
-    if (ShouldStartWatchStream()) {
-      StartWatchStream();
-    } else {
+    bool watch_started = false;
+    for (const auto& shard : watch_shards_) {
+      if (ShouldStartWatchStream(*shard)) {
+        StartWatchStream(*shard);
+        watch_started = true;
+      }
+    }
+    if (!watch_started) {
       online_state_tracker_.UpdateState(OnlineState::Unknown);
     }
 
@@ -106,7 +152,9 @@ void RemoteStore::DisableNetwork() {
 }
 
 void RemoteStore::DisableNetworkInternal() {
-  watch_stream_->Stop();
+  for (const auto& shard : watch_shards_) {
+    shard->stream->Stop();
+  }
   write_stream_->Stop();
 
   if (!write_pipeline_.empty()) {
@@ -114,8 +162,12 @@ void RemoteStore::DisableNetworkInternal() {
               write_pipeline_.size());
     write_pipeline_.clear();
   }
+  write_requests_.Clear();
+  uncoalesced_writes_ = 0;
 
-  CleanUpWatchStreamState();
+  for (const auto& shard : watch_shards_) {
+    CleanUpWatchStreamState(*shard);
+  }
 }
 
 void RemoteStore::Shutdown() {
@@ -141,11 +193,15 @@ void RemoteStore::Listen(const TargetData& target_data) {
   // Mark this as something the client is currently listening for.
   listen_targets_[target_key] = target_data;
 
-  if (ShouldStartWatchStream()) {
+  WatchShard& shard = LeastLoadedWatchShard();
+  shard.target_ids.insert(target_key);
+  watch_shards_by_target_[target_key] = &shard;
+
+  if (ShouldStartWatchStream(shard)) {
     // The listen will be sent in `OnWatchStreamOpen`
-    StartWatchStream();
-  } else if (watch_stream_->IsOpen()) {
-    SendWatchRequest(target_data);
+    StartWatchStream(shard);
+  } else if (shard.stream->IsOpen()) {
+    SendWatchRequest(shard, target_data);
   }
 }
 
@@ -154,78 +210,122 @@ void RemoteStore::StopListening(TargetId target_id) {
   HARD_ASSERT(num_erased == 1,
               "StopListening: target not currently watched: %s", target_id);
 
+  WatchShard& shard = *watch_shards_by_target_.at(target_id);
+  watch_shards_by_target_.erase(target_id);
+  shard.target_ids.erase(target_id);
+
   // The watch stream might not be started if we're in a disconnected state
-  if (watch_stream_->IsOpen()) {
-    SendUnwatchRequest(target_id);
-  }
-  if (listen_targets_.empty()) {
-    if (watch_stream_->IsOpen()) {
-      watch_stream_->MarkIdle();
-    } else if (CanUseNetwork()) {
-      // Revert to `OnlineState::Unknown` if the watch stream is not open and we
-      // have no listeners, since without any listens to send we cannot confirm
-      // if the stream is healthy and upgrade to `OnlineState::Online`.
-      online_state_tracker_.UpdateState(OnlineState::Unknown);
+  if (shard.stream->IsOpen()) {
+    SendUnwatchRequest(shard, target_id);
+    if (shard.target_ids.empty()) {
+      shard.stream->MarkIdle();
+    }
+  }
+  if (listen_targets_.empty() && !IsAnyWatchStreamOpen() && CanUseNetwork()) {
+    // Revert to `OnlineState::Unknown` if no watch stream is open and we have
+    // no listeners, since without any listens to send we cannot confirm if the
+    // stream is healthy and upgrade to `OnlineState::Online`.
+    online_state_tracker_.UpdateState(OnlineState::Unknown);
+  }
+}
+
+RemoteStore::WatchShard& RemoteStore::LeastLoadedWatchShard() {
+  WatchShard* least_loaded = watch_shards_.front().get();
+  for (const auto& shard : watch_shards_) {
+    if (shard->target_ids.size() < least_loaded->target_ids.size()) {
+      least_loaded = shard.get();
     }
   }
+  return *least_loaded;
 }
 
-void RemoteStore::SendWatchRequest(const TargetData& target_data) {
+bool RemoteStore::IsAnyWatchStreamOpen() const {
+  return std::any_of(
+      watch_shards_.begin(), watch_shards_.end(),
+      [](const std::unique_ptr<WatchShard>& shard) {
+        return shard->stream->IsOpen();
+      });
+}
+
+void RemoteStore::SendWatchRequest(WatchShard& shard,
+                                   const TargetData& target_data) {
   // We need to increment the the expected number of pending responses we're due
   // from watch so we wait for the ack to process any messages from this target.
-  watch_change_aggregator_->RecordPendingTargetRequest(target_data.target_id());
-  watch_stream_->WatchQuery(target_data);
+  shard.aggregator->RecordPendingTargetRequest(target_data.target_id());
+
+  // When resuming, tell the backend how many documents we expect to match so
+  // that existence filters can carry the names of the unchanged ones.
+  if (!target_data.resume_token().empty()) {
+    auto expected_count = static_cast<int32_t>(
+        GetRemoteKeysForTarget(target_data.target_id()).size());
+    shard.stream->WatchQuery(target_data.WithExpectedCount(expected_count));
+  } else {
+    shard.stream->WatchQuery(target_data);
+  }
 }
 
-void RemoteStore::SendUnwatchRequest(TargetId target_id) {
+void RemoteStore::SendUnwatchRequest(WatchShard& shard, TargetId target_id) {
   // We need to increment the expected number of pending responses we're due
   // from watch so we wait for the removal on the server before we process any
   // messages from this target.
-  watch_change_aggregator_->RecordPendingTargetRequest(target_id);
-  watch_stream_->UnwatchTargetId(target_id);
+  shard.aggregator->RecordPendingTargetRequest(target_id);
+  shard.stream->UnwatchTargetId(target_id);
 }
 
-bool RemoteStore::ShouldStartWatchStream() const {
-  return CanUseNetwork() && !watch_stream_->IsStarted() &&
-         !listen_targets_.empty();
+bool RemoteStore::ShouldStartWatchStream(const WatchShard& shard) const {
+  return CanUseNetwork() && !shard.stream->IsStarted() &&
+         !shard.target_ids.empty();
 }
 
-void RemoteStore::StartWatchStream() {
-  HARD_ASSERT(ShouldStartWatchStream(),
+void RemoteStore::StartWatchStream(WatchShard& shard) {
+  HARD_ASSERT(ShouldStartWatchStream(shard),
               "StartWatchStream called when ShouldStartWatchStream is false.");
-  watch_change_aggregator_ = absl::make_unique<WatchChangeAggregator>(this);
-  watch_stream_->Start();
-
-  online_state_tracker_.HandleWatchStreamStart();
+  // The online state tracks the connection as a whole, so only the first stream
+  // to start begins a connection attempt.
+  bool other_stream_started = std::any_of(
+      watch_shards_.begin(), watch_shards_.end(),
+      [&](const std::unique_ptr<WatchShard>& other) {
+        return other.get() != &shard && other->stream->IsStarted();
+      });
+
+  shard.aggregator = absl::make_unique<WatchChangeAggregator>(this);
+  shard.stream->Start();
+
+  if (!other_stream_started) {
+    online_state_tracker_.HandleWatchStreamStart();
+  }
 }
 
-void RemoteStore::CleanUpWatchStreamState() {
-  watch_change_aggregator_.reset();
+void RemoteStore::CleanUpWatchStreamState(WatchShard& shard) {
+  shard.aggregator.reset();
 }
 
-void RemoteStore::OnWatchStreamOpen() {
+void RemoteStore::OnWatchStreamOpen(WatchShard& shard) {
   // Restore any existing watches.
-  for (const auto& kv : listen_targets_) {
-    SendWatchRequest(kv.second);
+  for (TargetId target_id : shard.target_ids) {
+    SendWatchRequest(shard, listen_targets_.at(target_id));
   }
 }
 
-void RemoteStore::OnWatchStreamClose(const Status& status) {
+void RemoteStore::OnWatchStreamClose(WatchShard& shard, const Status& status) {
   if (status.ok()) {
     // Graceful stop (due to Stop() or idle timeout). Make sure that's
     // desirable.
-    HARD_ASSERT(!ShouldStartWatchStream(),
+    HARD_ASSERT(!ShouldStartWatchStream(shard),
                 "Watch stream was stopped gracefully while still needed.");
   }
 
-  CleanUpWatchStreamState();
+  CleanUpWatchStreamState(shard);
 
   // If we still need the watch stream, retry the connection.
-  if (ShouldStartWatchStream()) {
-    online_state_tracker_.HandleWatchStreamFailure(status);
+  if (ShouldStartWatchStream(shard)) {
+    // While another stream is open, the connection is still working.
+    if (!IsAnyWatchStreamOpen()) {
+      online_state_tracker_.HandleWatchStreamFailure(status);
+    }
 
-    StartWatchStream();
-  } else {
+    StartWatchStream(shard);
+  } else if (!IsAnyWatchStreamOpen()) {
     // We don't need to restart the watch stream because there are no active
     // targets. The online state is set to unknown because there is no active
     // attempt at establishing a connection.
@@ -233,11 +333,13 @@ void RemoteStore::OnWatchStreamClose(const Status& status) {
   }
 }
 
-void RemoteStore::OnWatchStreamChange(const WatchChange& change,
+void RemoteStore::OnWatchStreamChange(WatchShard& shard,
+                                      const WatchChange& change,
                                       const SnapshotVersion& snapshot_version) {
   // Mark the connection as Online because we got a message from the server.
   online_state_tracker_.UpdateState(OnlineState::Online);
 
+  WatchChangeAggregator& aggregator = *shard.aggregator;
   if (change.type() == WatchChange::Type::TargetChange) {
     const WatchTargetChange& watch_target_change =
         static_cast<const WatchTargetChange&>(change);
@@ -245,35 +347,39 @@ void RemoteStore::OnWatchStreamChange(const WatchChange& change,
         !watch_target_change.cause().ok()) {
       // There was an error on a target, don't wait for a consistent snapshot to
       // raise events
-      return ProcessTargetError(watch_target_change);
+      return ProcessTargetError(shard, watch_target_change);
     } else {
-      watch_change_aggregator_->HandleTargetChange(watch_target_change);
+      aggregator.HandleTargetChange(watch_target_change);
     }
   } else if (change.type() == WatchChange::Type::Document) {
-    watch_change_aggregator_->HandleDocumentChange(
+    aggregator.HandleDocumentChange(
         static_cast<const DocumentWatchChange&>(change));
   } else {
     HARD_ASSERT(
         change.type() == WatchChange::Type::ExistenceFilter,
         "Expected WatchChange to be an instance of ExistenceFilterWatchChange");
-    watch_change_aggregator_->HandleExistenceFilter(
+    aggregator.HandleExistenceFilter(
         static_cast<const ExistenceFilterWatchChange&>(change));
   }
 
+  // A stream that is behind the snapshot version already raised by another
+  // keeps aggregating its changes until it catches up, so that remote events
+  // never go back in time.
   if (snapshot_version != SnapshotVersion::None() &&
       snapshot_version >= local_store_->GetLastRemoteSnapshotVersion()) {
     // We have received a target change with a global snapshot if the snapshot
     // version is not equal to `SnapshotVersion::None()`.
-    RaiseWatchSnapshot(snapshot_version);
+    RaiseWatchSnapshot(shard, snapshot_version);
   }
 }
 
-void RemoteStore::RaiseWatchSnapshot(const SnapshotVersion& snapshot_version) {
+void RemoteStore::RaiseWatchSnapshot(WatchShard& shard,
+                                     const SnapshotVersion& snapshot_version) {
   HARD_ASSERT(snapshot_version != SnapshotVersion::None(),
               "Can't raise event for unknown SnapshotVersion");
 
   RemoteEvent remote_event =
-      watch_change_aggregator_->CreateRemoteEvent(snapshot_version);
+      shard.aggregator->CreateRemoteEvent(snapshot_version);
 
   // Update in-memory resume tokens. `LocalStore` will update the persistent
   // view of these when applying the completed `RemoteEvent`.
@@ -316,7 +422,7 @@ void RemoteStore::RaiseWatchSnapshot(const SnapshotVersion& snapshot_version) {
 
     // Cause a hard reset by unwatching and rewatching immediately, but
     // deliberately don't send a resume token so that we get a full update.
-    SendUnwatchRequest(target_id);
+    SendUnwatchRequest(shard, target_id);
 
     // Mark the query we send as being on behalf of an existence filter
     // mismatch, but don't actually retain that in listen_targets_. This ensures
@@ -325,14 +431,15 @@ void RemoteStore::RaiseWatchSnapshot(const SnapshotVersion& snapshot_version) {
     TargetData request_target_data(target_data.target(), target_id,
                                    target_data.sequence_number(),
                                    QueryPurpose::ExistenceFilterMismatch);
-    SendWatchRequest(request_target_data);
+    SendWatchRequest(shard, request_target_data);
   }
 
   // Finally handle remote event
   sync_engine_->ApplyRemoteEvent(remote_event);
 }
 
-void RemoteStore::ProcessTargetError(const WatchTargetChange& change) {
+void RemoteStore::ProcessTargetError(WatchShard& shard,
+                                     const WatchTargetChange& change) {
   HARD_ASSERT(!change.cause().ok(), "Handling target error without a cause");
 
   // Ignore targets that have been removed already.
@@ -340,7 +447,9 @@ void RemoteStore::ProcessTargetError(const WatchTargetChange& change) {
     auto found = listen_targets_.find(target_id);
     if (found != listen_targets_.end()) {
       listen_targets_.erase(found);
-      watch_change_aggregator_->RemoveTarget(target_id);
+      watch_shards_by_target_.erase(target_id);
+      shard.target_ids.erase(target_id);
+      shard.aggregator->RemoveTarget(target_id);
       sync_engine_->HandleRejectedListen(target_id, change.cause());
     }
   }
@@ -365,13 +474,18 @@ void RemoteStore::FillWritePipeline() {
     last_batch_id_retrieved = batch->batch_id();
   }
 
+  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
+    SendWritePipeline();
+  }
+
   if (ShouldStartWriteStream()) {
     StartWriteStream();
   }
 }
 
 bool RemoteStore::CanAddToWritePipeline() const {
-  return CanUseNetwork() && write_pipeline_.size() < kMaxPendingWrites;
+  return CanUseNetwork() &&
+         write_pipeline_.size() < write_requests_.PipelineDepth();
 }
 
 void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
@@ -379,10 +493,39 @@ void RemoteStore::AddToWritePipeline(const MutationBatch& batch) {
               "AddToWritePipeline called when pipeline is full");
 
   write_pipeline_.push_back(batch);
+}
 
-  if (write_stream_->IsOpen() && write_stream_->handshake_complete()) {
-    write_stream_->WriteMutations(batch.mutations());
+void RemoteStore::SendWritePipeline() {
+  size_t next = write_requests_.sent_batch_count();
+  while (next < write_pipeline_.size()) {
+    std::vector<Mutation> mutations = write_pipeline_[next].mutations();
+    size_t end = next + 1;
+
+    if (write_coalescing_enabled_ && next >= uncoalesced_writes_) {
+      while (end < write_pipeline_.size()) {
+        const std::vector<Mutation>& more = write_pipeline_[end].mutations();
+        if (mutations.size() + more.size() > kMaxMutationsPerWriteRequest) {
+          break;
+        }
+        mutations.insert(mutations.end(), more.begin(), more.end());
+        ++end;
+      }
+    }
+
+    write_stream_->WriteMutations(mutations);
+    write_requests_.RecordRequest(end - next,
+                                  std::chrono::steady_clock::now());
+    next = end;
+  }
+}
+
+MutationBatch RemoteStore::PopWritePipeline() {
+  MutationBatch batch = write_pipeline_.front();
+  write_pipeline_.erase(write_pipeline_.begin());
+  if (uncoalesced_writes_ > 0) {
+    --uncoalesced_writes_;
   }
+  return batch;
 }
 
 bool RemoteStore::ShouldStartWriteStream() const {
@@ -405,25 +548,43 @@ void RemoteStore::OnWriteStreamHandshakeComplete() {
   local_store_->SetLastStreamToken(write_stream_->last_stream_token());
 
   // Send the write pipeline now that the stream is established.
-  for (const MutationBatch& write : write_pipeline_) {
-    write_stream_->WriteMutations(write.mutations());
-  }
+  write_requests_.Clear();
+  SendWritePipeline();
 }
 
 void RemoteStore::OnWriteStreamMutationResult(
     SnapshotVersion commit_version,
     std::vector<MutationResult> mutation_results) {
   // This is a response to a write containing mutations and should be correlated
-  // to the first write in our write pipeline.
+  // to the first write(s) in our write pipeline.
   HARD_ASSERT(!write_pipeline_.empty(), "Got result for empty write pipeline");
 
-  MutationBatch batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
+  size_t batch_count =
+      write_requests_.RecordResponse(std::chrono::steady_clock::now());
+  HARD_ASSERT(batch_count <= write_pipeline_.size(),
+              "Got result for %s writes but only %s are pending", batch_count,
+              write_pipeline_.size());
 
-  MutationBatchResult batch_result(std::move(batch), commit_version,
-                                   std::move(mutation_results),
-                                   write_stream_->last_stream_token());
-  sync_engine_->HandleSuccessfulWrite(batch_result);
+  // A coalesced request is acknowledged with the results of all its batches,
+  // in order.
+  auto next_result = mutation_results.begin();
+  for (size_t i = 0; i < batch_count; ++i) {
+    MutationBatch batch = PopWritePipeline();
+
+    auto result_count = static_cast<std::ptrdiff_t>(batch.mutations().size());
+    HARD_ASSERT(mutation_results.end() - next_result >= result_count,
+                "Got %s results for a write request with more mutations",
+                mutation_results.size());
+    std::vector<MutationResult> batch_results(
+        std::make_move_iterator(next_result),
+        std::make_move_iterator(next_result + result_count));
+    next_result += result_count;
+
+    MutationBatchResult batch_result(std::move(batch), commit_version,
+                                     std::move(batch_results),
+                                     write_stream_->last_stream_token());
+    sync_engine_->HandleSuccessfulWrite(batch_result);
+  }
 
   // It's possible that with the completion of this mutation another slot has
   // freed up.
@@ -454,6 +615,10 @@ void RemoteStore::OnWriteStreamClose(const Status& status) {
     }
   }
 
+  // Any writes that weren't acknowledged are resent once the stream is
+  // re-established.
+  write_requests_.Clear();
+
   // The write stream might have been started by refilling the write pipeline
   // for failed writes
   if (ShouldStartWriteStream()) {
@@ -491,15 +656,25 @@ void RemoteStore::HandleWriteError(const Status& status) {
     return;
   }
 
-  // If this was a permanent error, the request itself was the problem so it's
-  // not going to succeed if we resend it.
-  MutationBatch batch = write_pipeline_.front();
-  write_pipeline_.erase(write_pipeline_.begin());
-
   // In this case it's also unlikely that the server itself is melting
   // down--this was just a bad request so inhibit backoff on the next restart.
   write_stream_->InhibitBackoff();
 
+  // The backend rejects a coalesced request as a whole, so there is no telling
+  // which of its batches was the problem. Resend them one at a time to find
+  // out.
+  size_t batch_count = write_requests_.oldest_request_batch_count();
+  if (batch_count > 1) {
+    LOG_DEBUG("RemoteStore %s resending %s coalesced writes separately", this,
+              batch_count);
+    uncoalesced_writes_ = std::max(uncoalesced_writes_, batch_count);
+    return;
+  }
+
+  // If this was a permanent error, the request itself was the problem so it's
+  // not going to succeed if we resend it.
+  MutationBatch batch = PopWritePipeline();
+
   sync_engine_->HandleRejectedWrite(batch.batch_id(), status);
 
   // It's possible that with the completion of this mutation another slot has
@@ -513,8 +688,34 @@ bool RemoteStore::CanUseNetwork() const {
   return is_network_enabled_;
 }
 
-std::shared_ptr<Transaction> RemoteStore::CreateTransaction() {
-  return std::make_shared<Transaction>(datastore_.get());
+std::shared_ptr<Transaction> RemoteStore::CreateTransaction(
+    bool allow_local_reads) {
+  auto transaction = std::make_shared<Transaction>(datastore_.get());
+  if (allow_local_reads && max_transaction_read_staleness_.count() > 0) {
+    transaction->EnableLocalReads(local_store_, worker_queue_,
+                                  max_transaction_read_staleness_);
+  }
+  return transaction;
+}
+
+void RemoteStore::CommitMutations(const std::vector<Mutation>& mutations,
+                                  Datastore::CommitCallback&& callback) {
+  datastore_->CommitMutations(mutations, std::move(callback));
+}
+
+void RemoteStore::LookupDocuments(const std::vector<DocumentKey>& keys,
+                                  Datastore::LookupCallback&& callback) {
+  datastore_->LookupDocuments(keys, std::move(callback));
+}
+
+void RemoteStore::RunQuery(const core::Target& target,
+                           Datastore::RunQueryCallback&& callback) {
+  datastore_->RunQuery(target, std::move(callback));
+}
+
+void RemoteStore::CountQuery(const core::Target& target,
+                             Datastore::CountQueryCallback&& callback) {
+  datastore_->CountQuery(target, std::move(callback));
 }
 
 DocumentKeySet RemoteStore::GetRemoteKeysForTarget(TargetId target_id) const {
@@ -528,6 +729,10 @@ absl::optional<TargetData> RemoteStore::GetTargetDataForTarget(
                                         : absl::optional<TargetData>{};
 }
 
+const DatabaseId& RemoteStore::GetDatabaseId() const {
+  return datastore_->database_id();
+}
+
 void RemoteStore::HandleCredentialChange() {
   if (CanUseNetwork()) {
     // Tear down and re-create our network streams. This will ensure we get a
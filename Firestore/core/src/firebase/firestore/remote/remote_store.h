@@ -19,6 +19,7 @@
 
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/core/transaction.h"
@@ -31,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
+#include "Firestore/core/src/firebase/firestore/remote/write_request_tracker.h"
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
@@ -102,19 +104,54 @@ class RemoteStoreCallback {
       model::TargetId target_id) const = 0;
 };
 
-class RemoteStore : public TargetMetadataProvider,
-                    public WatchStreamCallback,
-                    public WriteStreamCallback {
+class RemoteStore : public TargetMetadataProvider, public WriteStreamCallback {
  public:
+  /**
+   * Creates a remote store that spreads its watch targets across
+   * `watch_stream_count` watch streams, so that a large initial load on one
+   * stream doesn't hold up the snapshots of the targets on the others.
+   */
   RemoteStore(local::LocalStore* local_store,
               std::shared_ptr<Datastore> datastore,
               const std::shared_ptr<util::AsyncQueue>& worker_queue,
-              std::function<void(model::OnlineState)> online_state_handler);
+              std::function<void(model::OnlineState)> online_state_handler,
+              int watch_stream_count = 1);
 
   void set_sync_engine(RemoteStoreCallback* sync_engine) {
     sync_engine_ = sync_engine;
   }
 
+  /**
+   * Whether consecutive small batches in the write pipeline are sent to the
+   * backend in a single write request. Each batch is still acknowledged (and
+   * reported to the sync engine) separately.
+   *
+   * Because the backend commits a write request atomically, a permanent error
+   * for a coalesced request does not identify the failing batch; the affected
+   * batches are then resent one per request so that only the offending batch
+   * is rejected.
+   */
+  void set_write_coalescing_enabled(bool value) {
+    write_coalescing_enabled_ = value;
+  }
+
+  /**
+   * Sets how long the watch and write streams stay open once idle; see
+   * `Stream::SetIdleTimeouts`.
+   */
+  void SetStreamIdleTimeouts(util::AsyncQueue::Milliseconds initial_timeout,
+                             util::AsyncQueue::Milliseconds max_timeout);
+
+  /**
+   * Sets how old the local cache may be for transactions to read from it
+   * instead of the backend. Zero, the default, makes transactions always read
+   * from the backend.
+   */
+  void set_max_transaction_read_staleness(
+      util::AsyncQueue::Milliseconds value) {
+    max_transaction_read_staleness_ = value;
+  }
+
   /**
    * Starts up the remote store, creating streams, restoring state from
    * `LocalStore`, etc.
@@ -181,21 +218,42 @@ class RemoteStore : public TargetMetadataProvider,
    */
   void AddToWritePipeline(const model::MutationBatch& batch);
 
-  /** Returns a new transaction backed by this remote store. */
+  /**
+   * Returns a new transaction backed by this remote store. If
+   * `allow_local_reads` is true and reads from the local cache are enabled,
+   * the transaction reads documents from the cache when it is up to date.
+   */
   // TODO(c++14): return a plain value when it becomes possible to move
   // `Transaction` into lambdas.
-  std::shared_ptr<core::Transaction> CreateTransaction();
+  std::shared_ptr<core::Transaction> CreateTransaction(bool allow_local_reads);
+
+  /**
+   * Sends the given mutations to the backend in a single commit, bypassing the
+   * write pipeline. Used by `BulkWriter`, whose writes are not stored locally.
+   */
+  void CommitMutations(const std::vector<model::Mutation>& mutations,
+                       Datastore::CommitCallback&& callback);
+
+  /** Looks up the given documents once, bypassing the watch stream. */
+  void LookupDocuments(const std::vector<model::DocumentKey>& keys,
+                       Datastore::LookupCallback&& callback);
+
+  /**
+   * Reads the documents matching the given target once, bypassing the watch
+   * stream.
+   */
+  void RunQuery(const core::Target& target,
+                Datastore::RunQueryCallback&& callback);
+
+  /** Counts the documents matching the given target on the backend. */
+  void CountQuery(const core::Target& target,
+                  Datastore::CountQueryCallback&& callback);
 
   model::DocumentKeySet GetRemoteKeysForTarget(
       model::TargetId target_id) const override;
   absl::optional<local::TargetData> GetTargetDataForTarget(
       model::TargetId target_id) const override;
-
-  void OnWatchStreamOpen() override;
-  void OnWatchStreamChange(
-      const WatchChange& change,
-      const model::SnapshotVersion& snapshot_version) override;
-  void OnWatchStreamClose(const util::Status& status) override;
+  const model::DatabaseId& GetDatabaseId() const override;
 
   void OnWriteStreamOpen() override;
   void OnWriteStreamHandshakeComplete() override;
@@ -205,19 +263,57 @@ class RemoteStore : public TargetMetadataProvider,
       std::vector<model::MutationResult> mutation_results) override;
 
  private:
+  /**
+   * A watch stream, and the state of the targets assigned to it. Each stream
+   * aggregates the changes to its own targets and raises them whenever it
+   * reaches a consistent snapshot.
+   */
+  class WatchShard : public WatchStreamCallback {
+   public:
+    WatchShard(RemoteStore* remote_store, Datastore* datastore);
+
+    void OnWatchStreamOpen() override;
+    void OnWatchStreamChange(
+        const WatchChange& change,
+        const model::SnapshotVersion& snapshot_version) override;
+    void OnWatchStreamClose(const util::Status& status) override;
+
+    std::shared_ptr<WatchStream> stream;
+    std::unique_ptr<WatchChangeAggregator> aggregator;
+
+    /** The targets in `listen_targets_` that this stream watches. */
+    std::unordered_set<model::TargetId> target_ids;
+
+   private:
+    RemoteStore* remote_store_ = nullptr;
+  };
+
   void DisableNetworkInternal();
 
-  void SendWatchRequest(const local::TargetData& target_data);
-  void SendUnwatchRequest(model::TargetId target_id);
+  void OnWatchStreamOpen(WatchShard& shard);
+  void OnWatchStreamChange(WatchShard& shard,
+                           const WatchChange& change,
+                           const model::SnapshotVersion& snapshot_version);
+  void OnWatchStreamClose(WatchShard& shard, const util::Status& status);
+
+  /** Returns the shard with the fewest targets, to watch a new target. */
+  WatchShard& LeastLoadedWatchShard();
+
+  bool IsAnyWatchStreamOpen() const;
+
+  void SendWatchRequest(WatchShard& shard,
+                        const local::TargetData& target_data);
+  void SendUnwatchRequest(WatchShard& shard, model::TargetId target_id);
 
   /**
    * Takes a batch of changes from the `Datastore`, repackages them as a
    * `RemoteEvent`, and passes that on to the `SyncEngine`.
    */
-  void RaiseWatchSnapshot(const model::SnapshotVersion& snapshot_version);
+  void RaiseWatchSnapshot(WatchShard& shard,
+                          const model::SnapshotVersion& snapshot_version);
 
   /** Process a target error and passes the error along to `SyncEngine`. */
-  void ProcessTargetError(const WatchTargetChange& change);
+  void ProcessTargetError(WatchShard& shard, const WatchTargetChange& change);
 
   /**
    * Returns true if we can add to the write pipeline (i.e. it is not full and
@@ -225,6 +321,15 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool CanAddToWritePipeline() const;
 
+  /**
+   * Sends the batches in the write pipeline that haven't been sent on the
+   * current stream yet, coalescing them into as few requests as allowed.
+   */
+  void SendWritePipeline();
+
+  /** Removes the first batch from the write pipeline and returns it. */
+  model::MutationBatch PopWritePipeline();
+
   void StartWriteStream();
 
   /**
@@ -236,15 +341,15 @@ class RemoteStore : public TargetMetadataProvider,
   void HandleHandshakeError(const util::Status& status);
   void HandleWriteError(const util::Status& status);
 
-  void StartWatchStream();
+  void StartWatchStream(WatchShard& shard);
 
   /**
-   * Returns true if the network is enabled, the watch stream has not yet been
-   * started and there are active watch targets.
+   * Returns true if the network is enabled, the shard's watch stream has not
+   * yet been started and there are active watch targets assigned to it.
    */
-  bool ShouldStartWatchStream() const;
+  bool ShouldStartWatchStream(const WatchShard& shard) const;
 
-  void CleanUpWatchStreamState();
+  void CleanUpWatchStreamState(WatchShard& shard);
 
   RemoteStoreCallback* sync_engine_ = nullptr;
 
@@ -257,6 +362,9 @@ class RemoteStore : public TargetMetadataProvider,
   /** The client-side proxy for interacting with the backend. */
   std::shared_ptr<Datastore> datastore_;
 
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  util::AsyncQueue::Milliseconds max_transaction_read_staleness_{0};
+
   /**
    * A mapping of watched targets that the client cares about tracking and the
    * user has explicitly called a 'listen' for this target.
@@ -276,14 +384,23 @@ class RemoteStore : public TargetMetadataProvider,
    */
   bool is_network_enabled_ = false;
 
-  std::shared_ptr<WatchStream> watch_stream_;
+  /**
+   * The watch streams. Since each stream raises its changes separately, remote
+   * events are only raised at snapshot versions no older than the last one:
+   * a stream that's behind the others holds on to its changes until it
+   * catches up.
+   */
+  std::vector<std::unique_ptr<WatchShard>> watch_shards_;
+
+  /** The shard watching each target in `listen_targets_`. */
+  std::unordered_map<model::TargetId, WatchShard*> watch_shards_by_target_;
+
   std::shared_ptr<WriteStream> write_stream_;
-  std::unique_ptr<WatchChangeAggregator> watch_change_aggregator_;
 
   /**
-   * A list of up to `kMaxPendingWrites` writes that we have fetched from the
-   * `LocalStore` via `FillWritePipeline` and have or will send to the write
-   * stream.
+   * A list of up to `write_requests_.PipelineDepth()` writes that we have
+   * fetched from the `LocalStore` via `FillWritePipeline` and have or will send
+   * to the write stream.
    *
    * Whenever `write_pipeline_` is not empty, the `RemoteStore` will attempt to
    * start or restart the write stream. When the stream is established, the
@@ -295,9 +412,21 @@ class RemoteStore : public TargetMetadataProvider,
    *
    * Write responses from the backend are linked to their originating request
    * purely based on order, and so we can just remove writes from the front of
-   * the `write_pipeline_` as we receive responses.
+   * the `write_pipeline_` as we receive responses. `write_requests_` records
+   * how many writes each response acknowledges.
    */
   std::vector<model::MutationBatch> write_pipeline_;
+
+  /** The write requests sent on the current write stream. */
+  WriteRequestTracker write_requests_;
+
+  bool write_coalescing_enabled_ = false;
+
+  /**
+   * The number of writes at the front of `write_pipeline_` that must be sent
+   * one per request because a coalesced request containing them was rejected.
+   */
+  size_t uncoalesced_writes_ = 0;
 };
 
 }  // namespace remote
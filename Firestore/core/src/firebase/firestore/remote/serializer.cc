@@ -26,6 +26,7 @@
 #include <set>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
 #include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
@@ -50,7 +51,10 @@
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
 #include "Firestore/core/src/firebase/firestore/timestamp_internal.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
 #include "Firestore/core/src/firebase/firestore/util/string_format.h"
 #include "absl/algorithm/container.h"
 
@@ -98,6 +102,7 @@ using model::TransformMutation;
 using model::TransformOperation;
 using model::VerifyMutation;
 using nanopb::ByteString;
+using nanopb::ByteStringWriter;
 using nanopb::CheckedSize;
 using nanopb::MakeArray;
 using nanopb::MakeStringView;
@@ -106,6 +111,7 @@ using nanopb::SafeReadBoolean;
 using nanopb::Writer;
 using remote::WatchChange;
 using util::Status;
+using util::StatusOr;
 using util::StringFormat;
 
 pb_bytes_array_t* Serializer::EncodeString(const std::string& str) {
@@ -158,6 +164,87 @@ Filter InvalidFilter() {
   return FieldFilter::Create({}, {}, {});
 }
 
+/**
+ * Finds the length-delimited fields with the given tag in the encoded message
+ * read by `stream`, and calls `read_field` with a stream over the contents of
+ * each. Returns false if the message is malformed or if `read_field` does.
+ */
+template <typename F>
+bool ReadEncodedFields(pb_istream_t* stream, uint32_t field_tag, F read_field) {
+  while (stream->bytes_left > 0) {
+    pb_wire_type_t wire_type{};
+    uint32_t tag = 0;
+    bool eof = false;
+    if (!pb_decode_tag(stream, &wire_type, &tag, &eof)) return false;
+
+    if (tag != field_tag || wire_type != PB_WT_STRING) {
+      if (!pb_skip_field(stream, wire_type)) return false;
+      continue;
+    }
+
+    pb_istream_t field{};
+    if (!pb_make_string_substream(stream, &field)) return false;
+    bool ok = read_field(&field);
+    if (!pb_close_string_substream(stream, &field) || !ok) return false;
+  }
+  return true;
+}
+
+/**
+ * Copies the encoded document of the document change in the encoded
+ * ListenResponse read by `stream`. Fails unless there's exactly one of each,
+ * since a decoder would merge several.
+ */
+bool ReadEncodedDocument(pb_istream_t* stream, ByteString* result) {
+  int documents = 0;
+  int changes = 0;
+  bool ok = ReadEncodedFields(
+      stream, google_firestore_v1_ListenResponse_document_change_tag,
+      [&](pb_istream_t* change) {
+        ++changes;
+        return ReadEncodedFields(
+            change, google_firestore_v1_DocumentChange_document_tag,
+            [&](pb_istream_t* document) {
+              ++documents;
+              ByteStringWriter writer;
+              size_t size = document->bytes_left;
+              writer.Reserve(size);
+              if (!pb_read(document, writer.pos(), size)) return false;
+              writer.SetSize(size);
+              *result = writer.Release();
+              return true;
+            });
+      });
+  return ok && changes == 1 && documents == 1;
+}
+
+/**
+ * Builds a map from decoded `fields` in their wire order. The fields are
+ * sorted once and the map is built in bulk, rather than inserting them one
+ * at a time. As with inserting, the last of several fields with the same key
+ * wins.
+ */
+FieldValue::Map MakeFieldMap(std::vector<FieldValue::Map::value_type> fields) {
+  std::stable_sort(fields.begin(), fields.end(),
+                   [](const FieldValue::Map::value_type& lhs,
+                      const FieldValue::Map::value_type& rhs) {
+                     return lhs.first < rhs.first;
+                   });
+
+  // Keep the last field of each run of equal keys.
+  auto last = fields.begin();
+  for (auto it = fields.begin(); it != fields.end(); ++it) {
+    auto next = std::next(it);
+    if (next == fields.end() || next->first != it->first) {
+      if (last != it) *last = std::move(*it);
+      ++last;
+    }
+  }
+  fields.erase(last, fields.end());
+
+  return FieldValue::Map::FromSortedRange(fields.begin(), fields.end());
+}
+
 }  // namespace
 
 Serializer::Serializer(DatabaseId database_id)
@@ -318,27 +405,26 @@ ObjectValue Serializer::DecodeFields(
     Reader* reader,
     size_t count,
     const google_firestore_v1_Document_FieldsEntry* fields) const {
-  FieldValue::Map result;
+  std::vector<FieldValue::Map::value_type> entries;
+  entries.reserve(count);
   for (size_t i = 0; i < count; i++) {
-    FieldValue::Map::value_type kv = DecodeFieldsEntry(reader, fields[i]);
-    result = result.insert(std::move(kv.first), std::move(kv.second));
+    entries.push_back(DecodeFieldsEntry(reader, fields[i]));
   }
 
-  return ObjectValue::FromMap(result);
+  return ObjectValue::FromMap(MakeFieldMap(std::move(entries)));
 }
 
 FieldValue::Map Serializer::DecodeMapValue(
     Reader* reader, const google_firestore_v1_MapValue& map_value) const {
-  FieldValue::Map result;
-
+  std::vector<FieldValue::Map::value_type> entries;
+  entries.reserve(map_value.fields_count);
   for (size_t i = 0; i < map_value.fields_count; i++) {
     std::string key = DecodeString(map_value.fields[i].key);
     FieldValue value = DecodeFieldValue(reader, map_value.fields[i].value);
-
-    result = result.insert(key, value);
+    entries.emplace_back(std::move(key), std::move(value));
   }
 
-  return result;
+  return MakeFieldMap(std::move(entries));
 }
 
 FieldValue Serializer::DecodeFieldValue(
@@ -571,6 +657,20 @@ NoDocument Serializer::DecodeMissingDocument(
                     /*has_committed_mutations=*/false);
 }
 
+Document Serializer::DecodeDocument(
+    Reader* reader, const google_firestore_v1_Document& proto) const {
+  DocumentKey key = DecodeKey(reader, proto.name);
+  ObjectValue value = DecodeFields(reader, proto.fields_count, proto.fields);
+  SnapshotVersion version = DecodeVersion(reader, proto.update_time);
+
+  if (version == SnapshotVersion::None()) {
+    reader->Fail("Got a document with no snapshot version");
+  }
+
+  return Document(std::move(value), std::move(key), version,
+                  DocumentState::kSynced);
+}
+
 google_firestore_v1_Write Serializer::EncodeMutation(
     const Mutation& mutation) const {
   HARD_ASSERT(mutation.is_valid(), "Invalid mutation encountered.");
@@ -871,7 +971,7 @@ google_firestore_v1_Target Serializer::EncodeTarget(
   google_firestore_v1_Target result{};
   const Target& target = target_data.target();
 
-  if (target.IsDocumentQuery()) {
+  if (target.IsDocumentQuery() || target.IsMultiDocumentTarget()) {
     result.which_target_type = google_firestore_v1_Target_documents_tag;
     result.target_type.documents = EncodeDocumentsTarget(target);
   } else {
@@ -884,6 +984,11 @@ google_firestore_v1_Target Serializer::EncodeTarget(
     result.which_resume_type = google_firestore_v1_Target_resume_token_tag;
     result.resume_type.resume_token =
         nanopb::CopyBytesArray(target_data.resume_token().get());
+
+    if (target_data.expected_count().has_value()) {
+      result.has_expected_count = true;
+      result.expected_count.value = *target_data.expected_count();
+    }
   }
 
   return result;
@@ -893,6 +998,16 @@ google_firestore_v1_Target_DocumentsTarget Serializer::EncodeDocumentsTarget(
     const core::Target& target) const {
   google_firestore_v1_Target_DocumentsTarget result{};
 
+  if (target.IsMultiDocumentTarget()) {
+    const std::vector<DocumentKey>& keys = target.document_keys();
+    result.documents_count = CheckedSize(keys.size());
+    result.documents = MakeArray<pb_bytes_array_t*>(result.documents_count);
+    for (pb_size_t i = 0; i < result.documents_count; ++i) {
+      result.documents[i] = EncodeQueryPath(keys[i].path());
+    }
+    return result;
+  }
+
   result.documents_count = 1;
   result.documents = MakeArray<pb_bytes_array_t*>(result.documents_count);
   result.documents[0] = EncodeQueryPath(target.path());
@@ -903,13 +1018,29 @@ google_firestore_v1_Target_DocumentsTarget Serializer::EncodeDocumentsTarget(
 Target Serializer::DecodeDocumentsTarget(
     nanopb::Reader* reader,
     const google_firestore_v1_Target_DocumentsTarget& proto) const {
-  if (proto.documents_count != 1) {
-    reader->Fail(
-        StringFormat("DocumentsTarget contained other than 1 document %s",
-                     proto.documents_count));
+  if (proto.documents_count == 0) {
+    reader->Fail("DocumentsTarget contained no documents");
     return {};
   }
 
+  if (proto.documents_count > 1) {
+    std::vector<DocumentKey> keys;
+    keys.reserve(proto.documents_count);
+    for (pb_size_t i = 0; i < proto.documents_count; ++i) {
+      ResourcePath path =
+          DecodeQueryPath(reader, DecodeString(proto.documents[i]));
+      if (!reader->status().ok()) return {};
+      if (!DocumentKey::IsDocumentKey(path)) {
+        reader->Fail(StringFormat("Invalid document path in DocumentsTarget %s",
+                                  path.CanonicalString()));
+        return {};
+      }
+      keys.emplace_back(std::move(path));
+    }
+    std::sort(keys.begin(), keys.end());
+    return Target::ForDocuments(std::move(keys));
+  }
+
   ResourcePath path = DecodeQueryPath(reader, DecodeString(proto.documents[0]));
   return Query(std::move(path)).ToTarget();
 }
@@ -1549,7 +1680,7 @@ std::unique_ptr<WatchChange> Serializer::DecodeWatchChange(
       return DecodeTargetChange(reader, watch_change.target_change);
 
     case google_firestore_v1_ListenResponse_document_change_tag:
-      return DecodeDocumentChange(reader, watch_change.document_change);
+      return DecodeDocumentChange(reader, watch_change.document_change, {});
 
     case google_firestore_v1_ListenResponse_document_delete_tag:
       return DecodeDocumentDelete(reader, watch_change.document_delete);
@@ -1563,6 +1694,23 @@ std::unique_ptr<WatchChange> Serializer::DecodeWatchChange(
   UNREACHABLE();
 }
 
+std::unique_ptr<WatchChange> Serializer::DecodeWatchChangeWithEncodedDocument(
+    nanopb::Reader* reader,
+    const google_firestore_v1_ListenResponse& watch_change,
+    pb_istream_t* encoded_response) const {
+  if (watch_change.which_response_type !=
+      google_firestore_v1_ListenResponse_document_change_tag) {
+    return DecodeWatchChange(reader, watch_change);
+  }
+
+  ByteString encoded_document;
+  if (!ReadEncodedDocument(encoded_response, &encoded_document)) {
+    encoded_document = {};
+  }
+  return DecodeDocumentChange(reader, watch_change.document_change,
+                              std::move(encoded_document));
+}
+
 SnapshotVersion Serializer::DecodeVersionFromListenResponse(
     nanopb::Reader* reader,
     const google_firestore_v1_ListenResponse& listen_response) const {
@@ -1619,7 +1767,8 @@ WatchTargetChangeState Serializer::DecodeTargetChangeState(
 
 std::unique_ptr<WatchChange> Serializer::DecodeDocumentChange(
     nanopb::Reader* reader,
-    const google_firestore_v1_DocumentChange& change) const {
+    const google_firestore_v1_DocumentChange& change,
+    ByteString encoded_document) const {
   ObjectValue value = DecodeFields(reader, change.document.fields_count,
                                    change.document.fields);
   DocumentKey key = DecodeKey(reader, change.document.name);
@@ -1628,13 +1777,13 @@ std::unique_ptr<WatchChange> Serializer::DecodeDocumentChange(
               "Got a document change with no snapshot version");
   SnapshotVersion version = DecodeVersion(reader, change.document.update_time);
 
-  // TODO(b/142956770): other platforms memoize `change.document` inside the
-  // `Document`. This currently cannot be implemented efficiently because it
-  // would require a reference-counted ownership model for the proto (copying it
-  // would defeat the purpose). Note, however, that even without this
-  // optimization C++ implementation is on par with the preceding Objective-C
-  // implementation.
-  Document document(std::move(value), key, version, DocumentState::kSynced);
+  // Keep the bytes the document was received as, so that the local store can
+  // write them as they are instead of encoding the decoded fields again.
+  Document document =
+      encoded_document.empty()
+          ? Document(std::move(value), key, version, DocumentState::kSynced)
+          : Document(std::move(value), key, version, DocumentState::kSynced,
+                     std::move(encoded_document));
 
   std::vector<TargetId> updated_target_ids(
       change.target_ids, change.target_ids + change.target_ids_count);
@@ -1683,9 +1832,32 @@ std::unique_ptr<WatchChange> Serializer::DecodeDocumentRemove(
 std::unique_ptr<WatchChange> Serializer::DecodeExistenceFilterWatchChange(
     nanopb::Reader* reader,
     const google_firestore_v1_ExistenceFilter& filter) const {
-  ExistenceFilter existence_filter{filter.count};
-  return absl::make_unique<ExistenceFilterWatchChange>(existence_filter,
-                                                       filter.target_id);
+  absl::optional<BloomFilter> unchanged_names;
+  if (filter.has_unchanged_names) {
+    const google_firestore_v1_BloomFilter& bloom_filter =
+        filter.unchanged_names;
+    std::vector<uint8_t> bitmap;
+    if (bloom_filter.bits.bitmap) {
+      const pb_bytes_array_t* bytes = bloom_filter.bits.bitmap;
+      bitmap.assign(bytes->bytes, bytes->bytes + bytes->size);
+    }
+
+    StatusOr<BloomFilter> created =
+        BloomFilter::Create(std::move(bitmap), bloom_filter.bits.padding,
+                            bloom_filter.hash_count);
+    if (created.ok()) {
+      unchanged_names = std::move(created).ValueOrDie();
+    } else {
+      // The filter is only an optimization: without it a mismatched target
+      // is reset, as it was before the backend sent bloom filters.
+      LOG_WARN("Ignoring invalid bloom filter in existence filter: %s",
+               created.status().ToString());
+    }
+  }
+
+  ExistenceFilter existence_filter{filter.count, std::move(unchanged_names)};
+  return absl::make_unique<ExistenceFilterWatchChange>(
+      std::move(existence_filter), filter.target_id);
 }
 
 }  // namespace remote
@@ -82,6 +82,10 @@ class Serializer {
    */
   explicit Serializer(model::DatabaseId database_id);
 
+  const model::DatabaseId& database_id() const {
+    return database_id_;
+  }
+
   /**
    * Encodes the string to nanopb bytes.
    *
@@ -158,6 +162,12 @@ class Serializer {
       nanopb::Reader* reader,
       const google_firestore_v1_BatchGetDocumentsResponse& response) const;
 
+  /**
+   * Decodes a document returned by a query, such as in a RunQuery response.
+   */
+  model::Document DecodeDocument(
+      nanopb::Reader* reader, const google_firestore_v1_Document& proto) const;
+
   google_firestore_v1_Write EncodeMutation(
       const model::Mutation& mutation) const;
   model::Mutation DecodeMutation(
@@ -232,6 +242,19 @@ class Serializer {
       nanopb::Reader* reader,
       const google_firestore_v1_ListenResponse& watch_change) const;
 
+  /**
+   * Decodes a watch change like `DecodeWatchChange`, and keeps the encoded
+   * document of a document change with the decoded document, so that the
+   * document can be stored locally without being encoded again.
+   *
+   * @param encoded_response A stream over the bytes `watch_change` was parsed
+   *     from, which is read to find the encoded document.
+   */
+  std::unique_ptr<remote::WatchChange> DecodeWatchChangeWithEncodedDocument(
+      nanopb::Reader* reader,
+      const google_firestore_v1_ListenResponse& watch_change,
+      pb_istream_t* encoded_response) const;
+
   model::SnapshotVersion DecodeVersionFromListenResponse(
       nanopb::Reader* reader,
       const google_firestore_v1_ListenResponse& listen_response) const;
@@ -349,7 +372,8 @@ class Serializer {
 
   std::unique_ptr<remote::WatchChange> DecodeDocumentChange(
       nanopb::Reader* reader,
-      const google_firestore_v1_DocumentChange& change) const;
+      const google_firestore_v1_DocumentChange& change,
+      nanopb::ByteString encoded_document) const;
   std::unique_ptr<remote::WatchChange> DecodeDocumentDelete(
       nanopb::Reader* reader,
       const google_firestore_v1_DocumentDelete& change) const;
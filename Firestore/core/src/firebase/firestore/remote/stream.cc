@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/remote/stream.h"
 
+#include <algorithm>
 #include <chrono>  // NOLINT(build/c++11)
 #include <utility>
 
@@ -42,13 +43,6 @@ using util::TimerId;
 
 namespace {
 
-/**
- * Initial backoff time after an error.
- * Set to 1s according to https://cloud.google.com/apis/design/errors.
- */
-const double kBackoffFactor = 1.5;
-const AsyncQueue::Milliseconds kBackoffInitialDelay{std::chrono::seconds(1)};
-const AsyncQueue::Milliseconds kBackoffMaxDelay{std::chrono::seconds(60)};
 /** The time a stream stays open after it is marked idle. */
 const AsyncQueue::Milliseconds kIdleTimeout{std::chrono::seconds(60)};
 
@@ -58,13 +52,16 @@ Stream::Stream(const std::shared_ptr<AsyncQueue>& worker_queue,
                std::shared_ptr<CredentialsProvider> credentials_provider,
                GrpcConnection* grpc_connection,
                TimerId backoff_timer_id,
+               const BackoffProfile& backoff_profile,
                TimerId idle_timer_id)
-    : backoff_{worker_queue, backoff_timer_id, kBackoffFactor,
-               kBackoffInitialDelay, kBackoffMaxDelay},
+    : backoff_{worker_queue, backoff_timer_id, backoff_profile},
       credentials_provider_{std::move(credentials_provider)},
       worker_queue_{worker_queue},
       grpc_connection_{grpc_connection},
-      idle_timer_id_{idle_timer_id} {
+      idle_timer_id_{idle_timer_id},
+      initial_idle_timeout_{kIdleTimeout},
+      max_idle_timeout_{kIdleTimeout},
+      idle_timeout_{kIdleTimeout} {
 }
 
 // Check state
@@ -185,10 +182,22 @@ void Stream::MarkIdle() {
 
   if (IsOpen() && !idleness_timer_) {
     idleness_timer_ = worker_queue_->EnqueueAfterDelay(
-        kIdleTimeout, idle_timer_id_, [this] { Stop(); });
+        idle_timeout_, idle_timer_id_, [this] {
+          idle_timeout_ = initial_idle_timeout_;
+          Stop();
+        });
   }
 }
 
+void Stream::SetIdleTimeouts(AsyncQueue::Milliseconds initial_timeout,
+                             AsyncQueue::Milliseconds max_timeout) {
+  HARD_ASSERT(initial_timeout <= max_timeout,
+              "Initial idle timeout can't be greater than max idle timeout");
+  initial_idle_timeout_ = initial_timeout;
+  max_idle_timeout_ = max_timeout;
+  idle_timeout_ = initial_timeout;
+}
+
 void Stream::CancelIdleCheck() {
   EnsureOnQueue();
   idleness_timer_.Cancel();
@@ -196,6 +205,12 @@ void Stream::CancelIdleCheck() {
 
 // Read/write
 
+void Stream::SetRecorder(std::shared_ptr<StreamRecorder> recorder,
+                         RecordedStream recorded_stream) {
+  recorder_ = std::move(recorder);
+  recorded_stream_ = recorded_stream;
+}
+
 void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
   EnsureOnQueue();
 
@@ -207,16 +222,46 @@ void Stream::OnStreamRead(const grpc::ByteBuffer& message) {
                   grpc_stream_->GetResponseHeaders()));
   }
 
+  if (recorder_) {
+    recorder_->Record(recorded_stream_, message);
+  }
+
   Status read_status = NotifyStreamResponse(message);
   if (!read_status.ok()) {
-    grpc_stream_->FinishImmediately();
-    // Don't expect gRPC to produce status -- since the error happened on the
-    // client, we have all the information we need.
-    OnStreamFinish(read_status);
-    return;
+    OnStreamResponseError(read_status);
   }
 }
 
+void Stream::OnStreamResponseError(const Status& status) {
+  grpc_stream_->FinishImmediately();
+  // Don't expect gRPC to produce status -- since the error happened on the
+  // client, we have all the information we need.
+  OnStreamFinish(status);
+}
+
+Stream::AsyncResponseHandler Stream::MakeAsyncResponseHandler() {
+  EnsureOnQueue();
+
+  std::weak_ptr<Stream> weak_this{shared_from_this()};
+  int initial_close_count = close_count_;
+  std::shared_ptr<AsyncQueue> worker_queue = worker_queue_;
+  return [weak_this, initial_close_count,
+          worker_queue](std::function<Status()> notify) {
+    worker_queue->EnqueueRelaxed([weak_this, initial_close_count, notify] {
+      auto strong_this = weak_this.lock();
+      // The response is stale if the stream has been closed since then.
+      if (!strong_this || strong_this->close_count_ != initial_close_count) {
+        return;
+      }
+
+      Status status = notify();
+      if (!status.ok()) {
+        strong_this->OnStreamResponseError(status);
+      }
+    });
+  };
+}
+
 // Stopping
 
 void Stream::Stop() {
@@ -280,12 +325,23 @@ void Stream::Close(const Status& status) {
 }
 
 void Stream::HandleErrorStatus(const Status& status) {
-  if (status.code() == Error::kResourceExhausted) {
+  absl::optional<AsyncQueue::Milliseconds> retry_delay;
+  if (grpc_stream_) {
+    retry_delay = grpc_stream_->retry_delay();
+  }
+
+  if (retry_delay) {
+    LOG_DEBUG("%s Backend asked to retry in %s ms", GetDebugDescription(),
+              retry_delay->count());
+    backoff_.DelayAtLeast(*retry_delay);
+  } else if (status.code() == Error::kResourceExhausted) {
     LOG_DEBUG(
         "%s Using maximum backoff delay to prevent overloading the backend.",
         GetDebugDescription());
     backoff_.ResetToMax();
-  } else if (status.code() == Error::kUnauthenticated) {
+  }
+
+  if (status.code() == Error::kUnauthenticated) {
     // "unauthenticated" error means the token was rejected. Try force
     // refreshing it in case it just expired.
     credentials_provider_->InvalidateToken();
@@ -310,6 +366,10 @@ void Stream::Write(grpc::ByteBuffer&& message) {
 
   HARD_ASSERT(IsOpen(), "Cannot write when the stream is not open.");
 
+  if (idleness_timer_) {
+    // The stream is reused while idle: keep it open longer next time.
+    idle_timeout_ = std::min(idle_timeout_ * 2, max_idle_timeout_);
+  }
   CancelIdleCheck();
   grpc_stream_->Write(std::move(message));
 }
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -27,6 +28,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/grpc_connection.h"
 #include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_objc_bridge.h"
+#include "Firestore/core/src/firebase/firestore/remote/stream_recorder.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
 #include "absl/strings/string_view.h"
@@ -122,6 +124,7 @@ class Stream : public GrpcStreamObserver,
          std::shared_ptr<auth::CredentialsProvider> credentials_provider,
          GrpcConnection* grpc_connection,
          util::TimerId backoff_timer_id,
+         const BackoffProfile& backoff_profile,
          util::TimerId idle_timer_id);
 
   /**
@@ -169,16 +172,26 @@ class Stream : public GrpcStreamObserver,
 
   /**
    * Marks this stream as idle. If no further actions are performed on the
-   * stream for one minute, the stream will automatically close itself and
-   * notify the stream's `OnClose` handler with Status::OK. The stream will then
-   * be in a non-started state, requiring the caller to start the stream again
-   * before further use.
+   * stream for the idle timeout (one minute by default), the stream will
+   * automatically close itself and notify the stream's `OnClose` handler with
+   * Status::OK. The stream will then be in a non-started state, requiring the
+   * caller to start the stream again before further use.
    *
    * Only streams that are in state 'Open' can be marked idle, as all other
    * states imply pending network operations.
    */
   void MarkIdle();
 
+  /**
+   * Sets how long the stream stays open once marked idle. Every time an idle
+   * stream is used again before it closes, the timeout doubles, up to
+   * `max_timeout`, so that streams that keep getting reused aren't torn down
+   * and reopened. Once the stream closes for being idle, the timeout starts
+   * over from `initial_timeout`.
+   */
+  void SetIdleTimeouts(util::AsyncQueue::Milliseconds initial_timeout,
+                       util::AsyncQueue::Milliseconds max_timeout);
+
   /**
    * Marks the stream as active again, preventing auto-closing of the stream.
    * Can be called from any state -- if the stream is not in state `Open`, this
@@ -186,17 +199,40 @@ class Stream : public GrpcStreamObserver,
    */
   void CancelIdleCheck();
 
+  /**
+   * Records every response this stream receives from now on with `recorder`,
+   * as responses of `recorded_stream`.
+   */
+  void SetRecorder(std::shared_ptr<StreamRecorder> recorder,
+                   RecordedStream recorded_stream);
+
   // `GrpcStreamObserver` interface -- do not use.
   void OnStreamStart() override;
   void OnStreamRead(const grpc::ByteBuffer& message) override;
   void OnStreamFinish(const util::Status& status) override;
 
  protected:
+  /**
+   * Delivers the result of processing a response off the worker queue. Can be
+   * called from any thread: the given function is run on the worker queue and,
+   * if it fails, the stream is closed just as if `NotifyStreamResponse` had
+   * failed. The function is dropped if the stream has been closed or
+   * destroyed in the meantime.
+   */
+  using AsyncResponseHandler =
+      std::function<void(std::function<util::Status()>)>;
+
   // `Stream` expects all its methods to be called on the worker queue.
   void EnsureOnQueue() const;
   void Write(grpc::ByteBuffer&& message);
   std::string GetDebugDescription() const;
 
+  /**
+   * Creates an `AsyncResponseHandler` that is valid until the stream is next
+   * closed.
+   */
+  AsyncResponseHandler MakeAsyncResponseHandler();
+
   ExponentialBackoff backoff_;
 
  private:
@@ -214,6 +250,7 @@ class Stream : public GrpcStreamObserver,
 
   void Close(const util::Status& status);
   void HandleErrorStatus(const util::Status& status);
+  void OnStreamResponseError(const util::Status& status);
 
   void RequestCredentials();
   void ResumeStartWithCredentials(
@@ -232,6 +269,12 @@ class Stream : public GrpcStreamObserver,
 
   util::TimerId idle_timer_id_{};
   util::DelayedOperation idleness_timer_;
+  util::AsyncQueue::Milliseconds initial_idle_timeout_;
+  util::AsyncQueue::Milliseconds max_idle_timeout_;
+  util::AsyncQueue::Milliseconds idle_timeout_;
+
+  std::shared_ptr<StreamRecorder> recorder_;
+  RecordedStream recorded_stream_ = RecordedStream::Watch;
 
   // Used to prevent auth if the stream happens to be restarted before token is
   // received.
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/stream_recorder.h"
+
+#include <utility>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/string_format.h"
+#include "grpcpp/support/slice.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using util::Filesystem;
+using util::Path;
+using util::Status;
+using util::StatusOr;
+using util::StringFormat;
+
+constexpr uint32_t kMagic = 0x46535352;  // "FSSR"
+constexpr uint32_t kFormatVersion = 1;
+
+constexpr size_t kHeaderSize = 8;
+constexpr size_t kRecordHeaderSize = 13;
+
+uint64_t ReadUint(absl::string_view bytes, size_t offset, size_t size) {
+  uint64_t value = 0;
+  for (size_t i = size; i > 0; --i) {
+    value = (value << 8) | static_cast<uint8_t>(bytes[offset + i - 1]);
+  }
+  return value;
+}
+
+}  // namespace
+
+StatusOr<std::unique_ptr<StreamRecorder>> StreamRecorder::Create(
+    const Path& path) {
+  std::ofstream file(path.native_value(),
+                     std::ios::binary | std::ios::out | std::ios::trunc);
+  if (!file) {
+    return Status{Error::kInternal,
+                  StringFormat("Failed to create stream recording at %s",
+                               path.ToUtf8String())};
+  }
+
+  std::unique_ptr<StreamRecorder> recorder(
+      new StreamRecorder(path, std::move(file)));
+  recorder->WriteUint32(kMagic);
+  recorder->WriteUint32(kFormatVersion);
+  recorder->file_.flush();
+  return {std::move(recorder)};
+}
+
+StreamRecorder::StreamRecorder(Path path, std::ofstream file)
+    : path_(std::move(path)),
+      start_(std::chrono::steady_clock::now()),
+      file_(std::move(file)) {
+}
+
+void StreamRecorder::Record(RecordedStream stream,
+                            const grpc::ByteBuffer& message) {
+  if (failed_) return;
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start_);
+
+  char stream_byte = static_cast<char>(stream);
+  WriteBytes(absl::string_view{&stream_byte, 1});
+  WriteUint64(static_cast<uint64_t>(elapsed.count()));
+  WriteUint32(static_cast<uint32_t>(message.Length()));
+
+  std::vector<grpc::Slice> slices;
+  message.Dump(&slices);
+  for (const grpc::Slice& slice : slices) {
+    WriteBytes(absl::string_view{reinterpret_cast<const char*>(slice.begin()),
+                                 slice.size()});
+  }
+  file_.flush();
+
+  if (!file_) {
+    LOG_WARN("Stopped recording streams: failed to write to %s",
+             path_.ToUtf8String());
+    failed_ = true;
+  }
+}
+
+void StreamRecorder::WriteUint32(uint32_t value) {
+  char bytes[4];
+  for (char& byte : bytes) {
+    byte = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  WriteBytes(absl::string_view{bytes, sizeof(bytes)});
+}
+
+void StreamRecorder::WriteUint64(uint64_t value) {
+  char bytes[8];
+  for (char& byte : bytes) {
+    byte = static_cast<char>(value & 0xff);
+    value >>= 8;
+  }
+  WriteBytes(absl::string_view{bytes, sizeof(bytes)});
+}
+
+void StreamRecorder::WriteBytes(absl::string_view bytes) {
+  file_.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
+
+StatusOr<std::vector<RecordedFrame>> ReadStreamRecording(const Path& path) {
+  StatusOr<std::string> maybe_contents = Filesystem::Default()->ReadFile(path);
+  if (!maybe_contents.ok()) {
+    return maybe_contents.status();
+  }
+  absl::string_view contents = maybe_contents.ValueOrDie();
+
+  if (contents.size() < kHeaderSize || ReadUint(contents, 0, 4) != kMagic) {
+    return Status{Error::kDataLoss,
+                  StringFormat("%s is not a stream recording",
+                               path.ToUtf8String())};
+  }
+  uint64_t version = ReadUint(contents, 4, 4);
+  if (version != kFormatVersion) {
+    return Status{Error::kDataLoss,
+                  StringFormat("Unsupported stream recording version %s",
+                               version)};
+  }
+
+  std::vector<RecordedFrame> frames;
+  size_t offset = kHeaderSize;
+  // A recording cut short by a crash ends with a partial record, which is
+  // dropped.
+  while (contents.size() - offset >= kRecordHeaderSize) {
+    auto stream = static_cast<RecordedStream>(contents[offset]);
+    if (stream != RecordedStream::Watch && stream != RecordedStream::Write) {
+      return Status{Error::kDataLoss,
+                    StringFormat("Invalid stream in recording at offset %s",
+                                 offset)};
+    }
+    uint64_t time = ReadUint(contents, offset + 1, 8);
+    uint64_t size = ReadUint(contents, offset + 9, 4);
+    if (contents.size() - offset - kRecordHeaderSize < size) {
+      break;
+    }
+
+    RecordedFrame frame;
+    frame.stream = stream;
+    frame.time = std::chrono::microseconds(time);
+    frame.message = std::string{
+        contents.substr(offset + kRecordHeaderSize, static_cast<size_t>(size))};
+    frames.push_back(std::move(frame));
+    offset += kRecordHeaderSize + static_cast<size_t>(size);
+  }
+  return frames;
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_RECORDER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_RECORDER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "absl/strings/string_view.h"
+#include "grpcpp/support/byte_buffer.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/** The stream a recorded response was received on. */
+enum class RecordedStream : uint8_t {
+  Watch = 1,
+  Write = 2,
+};
+
+/** A response as it was received from the backend. */
+struct RecordedFrame {
+  RecordedStream stream = RecordedStream::Watch;
+
+  /** When the response arrived, relative to the start of the recording. */
+  std::chrono::microseconds time{0};
+
+  /** The serialized `ListenResponse` or `WriteResponse`. */
+  std::string message;
+};
+
+/**
+ * Appends the responses of the watch and write streams to a file, along with
+ * the time each of them arrived, so that traffic that causes a performance
+ * problem can be replayed later without the backend.
+ *
+ * Responses are recorded before they are decoded, so the file holds exactly
+ * what went over the wire. Each response is flushed as it's recorded, so that
+ * the recording survives a crash. The streams that share a recorder must
+ * record on the same queue.
+ *
+ * The file is a header followed by one record per response:
+ *
+ *   header: magic (u32), format version (u32)
+ *   record: stream (u8), time in microseconds (u64), message size (u32),
+ *           message bytes
+ */
+class StreamRecorder {
+ public:
+  /**
+   * Creates a recorder that writes to the file at `path`, replacing any
+   * previous recording there.
+   */
+  static util::StatusOr<std::unique_ptr<StreamRecorder>> Create(
+      const util::Path& path);
+
+  StreamRecorder(const StreamRecorder&) = delete;
+  StreamRecorder& operator=(const StreamRecorder&) = delete;
+
+  /**
+   * Records a response received on the given stream. Stops recording, with a
+   * warning, if the file can't be written.
+   */
+  void Record(RecordedStream stream, const grpc::ByteBuffer& message);
+
+ private:
+  StreamRecorder(util::Path path, std::ofstream file);
+
+  void WriteUint32(uint32_t value);
+  void WriteUint64(uint64_t value);
+  void WriteBytes(absl::string_view bytes);
+
+  util::Path path_;
+  std::chrono::steady_clock::time_point start_;
+  std::ofstream file_;
+  bool failed_ = false;
+};
+
+/** Reads back all the responses in a file written by `StreamRecorder`. */
+util::StatusOr<std::vector<RecordedFrame>> ReadStreamRecording(
+    const util::Path& path);
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_STREAM_RECORDER_H_
@@ -14,10 +14,12 @@
  * limitations under the License.
  */
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
 
+#include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
@@ -25,6 +27,7 @@
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
 
 namespace firebase {
 namespace firestore {
@@ -33,13 +36,37 @@ namespace remote {
 using auth::CredentialsProvider;
 using auth::Token;
 using local::TargetData;
+using model::SnapshotVersion;
 using model::TargetId;
 using nanopb::Message;
+using remote::ByteBufferInputStream;
 using remote::ByteBufferReader;
 using util::AsyncQueue;
+using util::Executor;
 using util::Status;
 using util::TimerId;
 
+namespace {
+
+using ListenResponse = Message<google_firestore_v1_ListenResponse>;
+
+/**
+ * The number of responses that may be waiting to be decoded before
+ * `NotifyStreamResponse` blocks on the decoder.
+ */
+constexpr int kMaxDecoderBacklog = 32;
+
+/**
+ * Every client reconnects its watch stream once the backend recovers from an
+ * outage, so the delays are decorrelated to keep them from reconnecting in
+ * lockstep.
+ */
+const BackoffProfile kBackoffProfile{3.0, std::chrono::seconds(1),
+                                     std::chrono::seconds(60),
+                                     BackoffJitter::Decorrelated};
+
+}  // namespace
+
 WatchStream::WatchStream(
     const std::shared_ptr<AsyncQueue>& async_queue,
     std::shared_ptr<CredentialsProvider> credentials_provider,
@@ -47,15 +74,21 @@ WatchStream::WatchStream(
     GrpcConnection* grpc_connection,
     WatchStreamCallback* callback)
     : Stream{async_queue, std::move(credentials_provider), grpc_connection,
-             TimerId::ListenStreamConnectionBackoff, TimerId::ListenStreamIdle},
-      watch_serializer_{std::move(serializer)},
-      callback_{NOT_NULL(callback)} {
+             TimerId::ListenStreamConnectionBackoff, kBackoffProfile,
+             TimerId::ListenStreamIdle},
+      watch_serializer_{
+          std::make_shared<WatchStreamSerializer>(std::move(serializer))},
+      callback_{NOT_NULL(callback)},
+      decoder_{Executor::CreateSerial("com.google.firebase.firestore.watch")},
+      decoder_backlog_{std::make_shared<std::atomic<int>>(0)} {
 }
 
 void WatchStream::WatchQuery(const TargetData& query) {
   EnsureOnQueue();
+  util::TraceSpan span("WatchStream::WatchQuery");
+  span.SetAttribute("target_id", query.target_id());
 
-  auto request = watch_serializer_.EncodeWatchRequest(query);
+  auto request = watch_serializer_->EncodeWatchRequest(query);
   LOG_DEBUG("%s watch: %s", GetDebugDescription(), request.ToString());
   Write(MakeByteBuffer(request));
 }
@@ -63,7 +96,7 @@ void WatchStream::WatchQuery(const TargetData& query) {
 void WatchStream::UnwatchTargetId(TargetId target_id) {
   EnsureOnQueue();
 
-  auto request = watch_serializer_.EncodeUnwatchRequest(target_id);
+  auto request = watch_serializer_->EncodeUnwatchRequest(target_id);
 
   LOG_DEBUG("%s unwatch: %s", GetDebugDescription(), request.ToString());
   Write(MakeByteBuffer(request));
@@ -84,10 +117,53 @@ void WatchStream::NotifyStreamOpen() {
 }
 
 Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
-  ByteBufferReader reader{message};
-  auto response = watch_serializer_.ParseResponse(&reader);
-  if (!reader.ok()) {
-    return reader.status();
+  // Back-pressure: if the decoder falls too far behind, wait for it to catch
+  // up rather than letting undecoded responses pile up in memory.
+  if (*decoder_backlog_ >= kMaxDecoderBacklog) {
+    decoder_->ExecuteBlocking([] {});
+  }
+  ++*decoder_backlog_;
+
+  AsyncResponseHandler handler = MakeAsyncResponseHandler();
+  std::shared_ptr<const WatchStreamSerializer> serializer = watch_serializer_;
+  std::shared_ptr<std::atomic<int>> backlog = decoder_backlog_;
+  decoder_->Execute([this, handler, serializer, backlog, message] {
+    util::TraceSpan span("WatchStream::DecodeResponse");
+    ByteBufferReader reader{message};
+    auto response =
+        std::make_shared<ListenResponse>(serializer->ParseResponse(&reader));
+
+    std::shared_ptr<WatchChange> watch_change;
+    SnapshotVersion version;
+    if (reader.ok()) {
+      ByteBufferInputStream encoded_response{message};
+      watch_change = serializer->DecodeWatchChange(&reader, **response,
+                                                   encoded_response.stream());
+      version = serializer->DecodeSnapshotVersion(&reader, **response);
+    }
+    Status status = reader.status();
+    --*backlog;
+
+    // `this` is only accessed if the stream is still alive and hasn't been
+    // closed since the response was received.
+    util::SpanId decode_span = span.id();
+    handler([this, status, response, watch_change, version, decode_span] {
+      util::TraceSpan apply_span("WatchStream::ApplyResponse", decode_span);
+      return ApplyResponse(status, *response, watch_change.get(), version);
+    });
+  });
+
+  return Status::OK();
+}
+
+Status WatchStream::ApplyResponse(const Status& status,
+                                  const ListenResponse& response,
+                                  const WatchChange* watch_change,
+                                  const SnapshotVersion& version) {
+  EnsureOnQueue();
+
+  if (!status.ok()) {
+    return status;
   }
 
   LOG_DEBUG("%s response: %s", GetDebugDescription(), response.ToString());
@@ -95,12 +171,6 @@ Status WatchStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
   // A successful response means the stream is healthy.
   backoff_.Reset();
 
-  auto watch_change = watch_serializer_.DecodeWatchChange(&reader, *response);
-  auto version = watch_serializer_.DecodeSnapshotVersion(&reader, *response);
-  if (!reader.ok()) {
-    return reader.status();
-  }
-
   callback_->OnWatchStreamChange(*watch_change, version);
 
   return Status::OK();
@@ -17,6 +17,7 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WATCH_STREAM_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WATCH_STREAM_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 
@@ -26,6 +27,7 @@
 #include "Firestore/core/src/firebase/firestore/remote/stream.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
 #include "Firestore/core/src/firebase/firestore/util/status_fwd.h"
 #include "absl/strings/string_view.h"
 #include "grpcpp/support/byte_buffer.h"
@@ -114,12 +116,26 @@ class WatchStream : public Stream {
   util::Status NotifyStreamResponse(const grpc::ByteBuffer& message) override;
   void NotifyStreamClose(const util::Status& status) override;
 
+  /** Notifies the callback of a response decoded by the decoder. */
+  util::Status ApplyResponse(
+      const util::Status& status,
+      const nanopb::Message<google_firestore_v1_ListenResponse>& response,
+      const WatchChange* watch_change,
+      const model::SnapshotVersion& version);
+
   std::string GetDebugName() const override {
     return "WatchStream";
   }
 
-  WatchStreamSerializer watch_serializer_;
+  // Shared with the decoder, which may outlive the stream.
+  std::shared_ptr<const WatchStreamSerializer> watch_serializer_;
   WatchStreamCallback* callback_;
+
+  // Responses are decoded on this serial executor, so that decoding a frame
+  // can overlap with applying the previous ones on the worker queue.
+  std::unique_ptr<util::Executor> decoder_;
+  // The number of responses handed to the decoder but not yet decoded.
+  std::shared_ptr<std::atomic<int>> decoder_backlog_;
 };
 
 }  // namespace remote
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/remote/write_request_tracker.h"
+
+#include <algorithm>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+namespace {
+
+using Milliseconds = std::chrono::milliseconds;
+
+/** How much round-trip time each slot of the write pipeline accounts for. */
+constexpr Milliseconds kRoundTripPerPipelineSlot{25};
+
+/**
+ * The weight of a new sample in the smoothed round-trip time, as in TCP's
+ * SRTT (RFC 6298).
+ */
+constexpr int kRoundTripSmoothingDivisor = 8;
+
+}  // namespace
+
+constexpr size_t WriteRequestTracker::kMinPipelineDepth;
+constexpr size_t WriteRequestTracker::kMaxPipelineDepth;
+
+void WriteRequestTracker::RecordRequest(size_t batch_count,
+                                        Clock::time_point sent_time) {
+  HARD_ASSERT(batch_count > 0, "Write request must contain at least one batch");
+  requests_.push_back(Request{batch_count, sent_time});
+  sent_batch_count_ += batch_count;
+}
+
+size_t WriteRequestTracker::RecordResponse(Clock::time_point received_time) {
+  HARD_ASSERT(!requests_.empty(), "Got write response without a request");
+
+  Request request = requests_.front();
+  requests_.pop_front();
+  sent_batch_count_ -= request.batch_count;
+
+  Clock::duration sample =
+      std::max(received_time - request.sent_time, Clock::duration::zero());
+  if (has_round_trip_time_) {
+    smoothed_round_trip_time_ +=
+        (sample - smoothed_round_trip_time_) / kRoundTripSmoothingDivisor;
+  } else {
+    smoothed_round_trip_time_ = sample;
+    has_round_trip_time_ = true;
+  }
+
+  return request.batch_count;
+}
+
+void WriteRequestTracker::Clear() {
+  requests_.clear();
+  sent_batch_count_ = 0;
+}
+
+size_t WriteRequestTracker::oldest_request_batch_count() const {
+  return requests_.empty() ? 0 : requests_.front().batch_count;
+}
+
+size_t WriteRequestTracker::PipelineDepth() const {
+  auto slots = static_cast<size_t>(smoothed_round_trip_time_ /
+                                   kRoundTripPerPipelineSlot);
+  return std::min(std::max(slots, kMinPipelineDepth), kMaxPipelineDepth);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_REQUEST_TRACKER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_REQUEST_TRACKER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <deque>
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+/**
+ * Tracks the write requests that `RemoteStore` has sent on the write stream
+ * but that have not been acknowledged yet.
+ *
+ * A single request may carry several consecutive mutation batches from the
+ * write pipeline (see `RemoteStore::set_write_coalescing_enabled`). Responses
+ * arrive in the order the requests were sent, so the tracker only needs to
+ * remember how many batches each request covered in order to split a response
+ * back into per-batch acknowledgements.
+ *
+ * The tracker also keeps a smoothed estimate of the round-trip time of write
+ * requests, which determines how many batches the write pipeline may hold.
+ */
+class WriteRequestTracker {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * The smallest number of batches the write pipeline may hold, regardless of
+   * the measured round-trip time.
+   */
+  static constexpr size_t kMinPipelineDepth = 10;
+
+  /** The largest number of batches the write pipeline may hold. */
+  static constexpr size_t kMaxPipelineDepth = 100;
+
+  /** Records that a request covering `batch_count` batches was sent. */
+  void RecordRequest(size_t batch_count, Clock::time_point sent_time);
+
+  /**
+   * Records the response to the oldest outstanding request and updates the
+   * round-trip time estimate.
+   *
+   * @return The number of batches covered by the acknowledged request.
+   */
+  size_t RecordResponse(Clock::time_point received_time);
+
+  /**
+   * Forgets all outstanding requests, e.g. because the stream was closed and
+   * the requests will be sent again. The round-trip time estimate is kept.
+   */
+  void Clear();
+
+  /** The number of requests awaiting a response. */
+  size_t outstanding_requests() const {
+    return requests_.size();
+  }
+
+  /** The total number of batches covered by the outstanding requests. */
+  size_t sent_batch_count() const {
+    return sent_batch_count_;
+  }
+
+  /**
+   * The number of batches covered by the oldest outstanding request, or 0 if
+   * there are none.
+   */
+  size_t oldest_request_batch_count() const;
+
+  /**
+   * The smoothed round-trip time of write requests, or zero if no response
+   * has been received yet.
+   */
+  Clock::duration smoothed_round_trip_time() const {
+    return smoothed_round_trip_time_;
+  }
+
+  /**
+   * Returns how many batches the write pipeline may hold: one for every
+   * `kRoundTripPerPipelineSlot` of the smoothed round-trip time, clamped to
+   * [kMinPipelineDepth, kMaxPipelineDepth]. Slow connections thus keep more
+   * writes in flight so that acknowledgements keep up with new writes.
+   */
+  size_t PipelineDepth() const;
+
+ private:
+  struct Request {
+    size_t batch_count;
+    Clock::time_point sent_time;
+  };
+
+  std::deque<Request> requests_;
+  size_t sent_batch_count_ = 0;
+
+  bool has_round_trip_time_ = false;
+  Clock::duration smoothed_round_trip_time_{};
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_REMOTE_WRITE_REQUEST_TRACKER_H_
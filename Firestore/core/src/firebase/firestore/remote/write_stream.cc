@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
@@ -25,6 +26,7 @@
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
 #include "Firestore/core/src/firebase/firestore/util/log.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
 
 namespace firebase {
 namespace firestore {
@@ -40,6 +42,18 @@ using util::AsyncQueue;
 using util::Status;
 using util::TimerId;
 
+namespace {
+
+/**
+ * Like the watch stream, the write stream of every client with pending writes
+ * reconnects once the backend recovers from an outage.
+ */
+const BackoffProfile kBackoffProfile{3.0, std::chrono::seconds(1),
+                                     std::chrono::seconds(60),
+                                     BackoffJitter::Decorrelated};
+
+}  // namespace
+
 WriteStream::WriteStream(
     const std::shared_ptr<AsyncQueue>& async_queue,
     std::shared_ptr<CredentialsProvider> credentials_provider,
@@ -47,7 +61,8 @@ WriteStream::WriteStream(
     GrpcConnection* grpc_connection,
     WriteStreamCallback* callback)
     : Stream{async_queue, std::move(credentials_provider), grpc_connection,
-             TimerId::WriteStreamConnectionBackoff, TimerId::WriteStreamIdle},
+             TimerId::WriteStreamConnectionBackoff, kBackoffProfile,
+             TimerId::WriteStreamIdle},
       write_serializer_{std::move(serializer)},
       callback_{NOT_NULL(callback)} {
 }
@@ -80,6 +95,9 @@ void WriteStream::WriteMutations(const std::vector<Mutation>& mutations) {
   HARD_ASSERT(handshake_complete(),
               "Handshake must be complete before writing mutations");
 
+  util::TraceSpan span("WriteStream::WriteMutations");
+  span.SetAttribute("mutations", static_cast<int64_t>(mutations.size()));
+
   auto request = write_serializer_.EncodeWriteMutationsRequest(
       mutations, last_stream_token());
   LOG_DEBUG("%s write request: %s", GetDebugDescription(), request.ToString());
@@ -117,6 +135,7 @@ void WriteStream::NotifyStreamClose(const Status& status) {
 }
 
 Status WriteStream::NotifyStreamResponse(const grpc::ByteBuffer& message) {
+  util::TraceSpan span("WriteStream::OnResponse");
   ByteBufferReader reader{message};
   Message<google_firestore_v1_WriteResponse> response =
       write_serializer_.ParseResponse(&reader);
@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 
+#include <iterator>
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
@@ -26,6 +27,39 @@ namespace firebase {
 namespace firestore {
 namespace util {
 
+namespace {
+
+AsyncQueue::Priority PriorityOf(TimerId timer_id) {
+  switch (timer_id) {
+    case TimerId::GarbageCollectionDelay:
+    case TimerId::PersistenceMetricsReport:
+    case TimerId::DocumentSnapshotCompaction:
+    case TimerId::BackgroundMigration:
+      return AsyncQueue::Priority::Background;
+    default:
+      return AsyncQueue::Priority::Interactive;
+  }
+}
+
+// Lets the system favor the queue's thread over other work in the app while
+// the user is waiting on one of its operations, and disfavor it while it only
+// has maintenance to do.
+Executor::QualityOfService QosOf(AsyncQueue::Priority priority) {
+  switch (priority) {
+    case AsyncQueue::Priority::Interactive:
+      return Executor::QualityOfService::UserInitiated;
+    case AsyncQueue::Priority::RemoteEvent:
+      return Executor::QualityOfService::Default;
+    case AsyncQueue::Priority::Background:
+      return Executor::QualityOfService::Utility;
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
+constexpr size_t AsyncQueue::kPriorityCount;
+
 std::shared_ptr<AsyncQueue> AsyncQueue::Create(
     std::unique_ptr<Executor> executor) {
   // Use new because make_shared cannot access a private constructor.
@@ -71,9 +105,9 @@ void AsyncQueue::ExecuteBlocking(const Operation& operation) {
   is_operation_in_progress_ = false;
 }
 
-void AsyncQueue::Enqueue(const Operation& operation) {
+void AsyncQueue::Enqueue(const Operation& operation, Priority priority) {
   VerifySequentialOrder();
-  EnqueueRelaxed(operation);
+  EnqueueRelaxed(operation, priority);
 }
 
 void AsyncQueue::EnqueueAndInitiateShutdown(const Operation& operation) {
@@ -81,14 +115,28 @@ void AsyncQueue::EnqueueAndInitiateShutdown(const Operation& operation) {
   VerifySequentialOrder();
 
   is_shutting_down_ = true;
-  executor_->Execute(Wrap(operation));
+  {
+    // Nothing can join the lower-priority lanes from now on. Move what waits
+    // there ahead of the shutdown, so that it doesn't run against torn-down
+    // state.
+    std::lock_guard<std::mutex> lock{lanes_mutex_};
+    std::deque<Operation>& interactive = lanes_[0];
+    for (size_t i = 1; i != kPriorityCount; ++i) {
+      std::deque<Operation>& lane = lanes_[i];
+      interactive.insert(interactive.end(),
+                         std::make_move_iterator(lane.begin()),
+                         std::make_move_iterator(lane.end()));
+      lane.clear();
+    }
+  }
+  ExecuteInLane(operation, Priority::Interactive);
 }
 
 void AsyncQueue::EnqueueEvenAfterShutdown(const Operation& operation) {
   // Still guarding the lock to ensure sequential scheduling.
   std::lock_guard<std::mutex> lock{shut_down_mutex_};
   VerifySequentialOrder();
-  executor_->Execute(Wrap(operation));
+  ExecuteInLane(operation, Priority::Interactive);
 }
 
 bool AsyncQueue::is_shutting_down() const {
@@ -96,12 +144,13 @@ bool AsyncQueue::is_shutting_down() const {
   return is_shutting_down_;
 }
 
-void AsyncQueue::EnqueueRelaxed(const Operation& operation) {
+void AsyncQueue::EnqueueRelaxed(const Operation& operation,
+                                Priority priority) {
   std::lock_guard<std::mutex> lock{shut_down_mutex_};
   if (is_shutting_down_) {
     return;
   }
-  executor_->Execute(Wrap(operation));
+  ExecuteInLane(operation, priority);
 }
 
 DelayedOperation AsyncQueue::EnqueueAfterDelay(Milliseconds delay,
@@ -119,7 +168,24 @@ DelayedOperation AsyncQueue::EnqueueAfterDelay(Milliseconds delay,
     delay = Milliseconds(0);
   }
 
-  Executor::TaggedOperation tagged{static_cast<int>(timer_id), Wrap(operation)};
+  Operation wrapped = Wrap(operation);
+  Priority priority = PriorityOf(timer_id);
+  if (priority != Priority::Interactive) {
+    // Yield to the more urgent operations that are already waiting.
+    auto shared_this = shared_from_this();
+    wrapped = [shared_this, wrapped, priority] {
+      shared_this->RunLanesAbove(priority);
+      wrapped();
+    };
+  }
+
+  Executor::TaggedOperation tagged{static_cast<int>(timer_id),
+                                   std::move(wrapped)};
+  if (priority == Priority::Background) {
+    // Timers fire without anyone waiting on them, unlike operations put in the
+    // background lane, such as loading a bundle.
+    tagged.qos = Executor::QualityOfService::Background;
+  }
   return executor_->Schedule(delay, std::move(tagged));
 }
 
@@ -132,6 +198,64 @@ AsyncQueue::Operation AsyncQueue::Wrap(const Operation& operation) {
   return [shared_this, operation] { shared_this->ExecuteBlocking(operation); };
 }
 
+void AsyncQueue::ExecuteInLane(const Operation& operation, Priority priority) {
+  {
+    std::lock_guard<std::mutex> lock{lanes_mutex_};
+    lanes_[static_cast<size_t>(priority)].push_back(operation);
+  }
+
+  // There is one run per enqueued operation, but it picks whichever waiting
+  // operation has the highest priority. A run may find the lanes empty if
+  // `RunLanesAbove` has already run its operation.
+  auto shared_this = shared_from_this();
+  executor_->ExecuteWithQos(QosOf(priority), [shared_this] {
+    shared_this->RunNextInLanes();
+  });
+}
+
+void AsyncQueue::RunNextInLanes() {
+  absl::optional<Operation> operation = PopFromLanes(kPriorityCount);
+  if (operation) {
+    ExecuteBlocking(operation.value());
+  }
+}
+
+void AsyncQueue::RunLanesAbove(Priority priority) {
+  size_t lane_count = static_cast<size_t>(priority);
+
+  // Only run the operations that are already waiting, so that a steady stream
+  // of new ones cannot hold this one back forever.
+  size_t waiting = 0;
+  {
+    std::lock_guard<std::mutex> lock{lanes_mutex_};
+    for (size_t i = 0; i != lane_count; ++i) {
+      waiting += lanes_[i].size();
+    }
+  }
+
+  for (; waiting != 0; --waiting) {
+    absl::optional<Operation> operation = PopFromLanes(lane_count);
+    if (!operation) {
+      break;
+    }
+    ExecuteBlocking(operation.value());
+  }
+}
+
+absl::optional<AsyncQueue::Operation> AsyncQueue::PopFromLanes(
+    size_t lane_count) {
+  std::lock_guard<std::mutex> lock{lanes_mutex_};
+  for (size_t i = 0; i != lane_count; ++i) {
+    std::deque<Operation>& lane = lanes_[i];
+    if (!lane.empty()) {
+      Operation result = std::move(lane.front());
+      lane.pop_front();
+      return result;
+    }
+  }
+  return {};
+}
+
 void AsyncQueue::VerifySequentialOrder() const {
   // This is the inverse of `VerifyIsCurrentQueue`.
   HARD_ASSERT(!is_operation_in_progress_ || !executor_->IsCurrentExecutor(),
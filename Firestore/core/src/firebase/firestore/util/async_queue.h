@@ -17,14 +17,17 @@
 #ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
 #define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_ASYNC_QUEUE_H_
 
+#include <array>
 #include <atomic>
 #include <chrono>  // NOLINT(build/c++11)
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "absl/types/optional.h"
 
 namespace firebase {
 namespace firestore {
@@ -62,17 +65,71 @@ enum class TimerId {
    */
   GarbageCollectionDelay,
 
+  /**
+   * A timer used to periodically report persistence metrics to a listener
+   * registered with `FirestoreClient`.
+   */
+  PersistenceMetricsReport,
+
+  /**
+   * A timer used to periodically rebuild the snapshot of the remote document
+   * cache, if it is enabled.
+   */
+  DocumentSnapshotCompaction,
+
+  /**
+   * A timer used to advance the schema migrations that backfill indexes in the
+   * background after the persistence layer has started.
+   */
+  BackgroundMigration,
+
+  /**
+   * A timer used to write the transactions that LevelDB group commit holds
+   * on to, shortly after the first of them commits.
+   */
+  GroupCommitFlush,
+
+  /**
+   * A timer used to periodically write the memory cache to disk, if it is
+   * enabled.
+   */
+  MemoryCacheSnapshot,
+
   /**
    * A timer used to retry transactions. Since there can be multiple concurrent
    * transactions, multiple of these may be in the queue at a given time.
    */
-  RetryTransaction
+  RetryTransaction,
+
+  /**
+   * Timers used by `BulkWriter` to retry failed writes with backoff and to
+   * resume writing once its rate limit allows. Since there can be multiple
+   * bulk writers, multiple of these may be in the queue at a given time.
+   */
+  BulkWriterRetry,
+  BulkWriterRateLimit,
+
+  /**
+   * A timer used by `EventManager` to stop listening to a query once it has
+   * had no listeners for the linger period. Since several queries can linger
+   * at once, multiple of these may be in the queue at a given time.
+   */
+  ListenLinger
 };
 
 // A serial queue that executes given operations asynchronously, one at a time.
 // Operations may be scheduled to be executed as soon as possible or in the
 // future. Operations scheduled for the same time are FIFO-ordered.
 //
+// Operations enqueued for immediate execution belong to a `Priority` lane.
+// Among the operations waiting to run, those of a higher priority run first;
+// within a lane, operations are FIFO-ordered. Delayed operations tagged with
+// a background `TimerId` (e.g. garbage collection) let all operations of
+// higher priority that are waiting when they become due run first. A running
+// operation is never interrupted. On platforms that support it, the lanes also
+// set the executor's quality of service, so that the system runs the queue
+// sooner while interactive operations are waiting.
+//
 // `AsyncQueue` wraps a platform-specific executor, adding checks that enforce
 // sequential ordering of operations: an enqueued operation, while being run,
 // normally cannot enqueue other operations for immediate execution (but see
@@ -89,6 +146,19 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   using Operation = Executor::Operation;
   using Milliseconds = Executor::Milliseconds;
 
+  // The priority lanes of operations enqueued for immediate execution, from
+  // highest to lowest.
+  enum class Priority {
+    // Operations requested by the user, such as reads, writes and listens,
+    // and everything else not put in another lane. This is the default.
+    Interactive,
+    // Handling of responses and events from the backend, such as remote events
+    // on the watch stream.
+    RemoteEvent,
+    // Maintenance work, such as garbage collection.
+    Background,
+  };
+
   static std::shared_ptr<AsyncQueue> Create(std::unique_ptr<Executor> executor);
 
   // Asserts for the caller that it is being invoked as part of an operation on
@@ -98,7 +168,7 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   // Enqueue methods
 
   // Puts the `operation` on the queue to be executed as soon as possible, while
-  // maintaining FIFO order.
+  // maintaining FIFO order among operations of the same `priority`.
   //
   // Precondition: `Enqueue` calls cannot be nested; that is, `Enqueue` may not
   // be called by a previously enqueued operation when it is run (as a special
@@ -107,11 +177,15 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   //
   // After the shutdown process has initiated (`is_shutting_down()` is true),
   // calling `Enqueue` is a no-op.
-  void Enqueue(const Operation& operation);
+  void Enqueue(const Operation& operation,
+               Priority priority = Priority::Interactive);
 
   // Like `Enqueue`, but also starts the shutdown process. Once the shutdown
   // process has started, calling any Enqueue* methods becomes a no-op
   //
+  // The operations still waiting in lower-priority lanes were enqueued before
+  // the shutdown started, so they run before `operation` does.
+  //
   // The exception is `EnqueueEvenAfterShutdown`, operations requsted via
   // this will still be scheduled.
   void EnqueueAndInitiateShutdown(const Operation& operation);
@@ -121,7 +195,8 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   void EnqueueEvenAfterShutdown(const Operation& operation);
 
   // Like `Enqueue`, but without applying any prerequisite checks.
-  void EnqueueRelaxed(const Operation& operation);
+  void EnqueueRelaxed(const Operation& operation,
+                      Priority priority = Priority::Interactive);
 
   // Whether the queue has initiated its shutdown process.
   bool is_shutting_down() const;
@@ -190,6 +265,18 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
 
   Operation Wrap(const Operation& operation);
 
+  // Puts the `operation` in its lane and schedules a run of the operation with
+  // the highest priority on the executor.
+  void ExecuteInLane(const Operation& operation, Priority priority);
+  // Runs the waiting operation with the highest priority, if any.
+  void RunNextInLanes();
+  // Runs the operations waiting in lanes of a higher priority than the given
+  // one.
+  void RunLanesAbove(Priority priority);
+  // Removes and returns the first operation in the highest-priority nonempty
+  // lane among the `lane_count` highest-priority lanes.
+  absl::optional<Operation> PopFromLanes(size_t lane_count);
+
   // Asserts that the current invocation happens asynchronously on the queue.
   void VerifyIsCurrentExecutor() const;
   void VerifySequentialOrder() const;
@@ -201,6 +288,10 @@ class AsyncQueue : public std::enable_shared_from_this<AsyncQueue> {
   mutable std::mutex shut_down_mutex_;
 
   std::vector<TimerId> timer_ids_to_skip_;
+
+  static constexpr size_t kPriorityCount = 3;
+  std::array<std::deque<Operation>, kPriorityCount> lanes_;
+  std::mutex lanes_mutex_;
 };
 
 }  // namespace util
@@ -78,6 +78,20 @@ class Executor {
   using Operation = std::function<void()>;
   using Milliseconds = std::chrono::milliseconds;
 
+  // How urgently the system should run an executor's operations relative to
+  // other work in the process, from least to most urgent. Implementations that
+  // can't prioritize work ignore it.
+  enum class QualityOfService {
+    // Maintenance the user isn't aware of, such as garbage collection.
+    Background,
+    // Long-running work the user isn't waiting on, such as loading bundles.
+    Utility,
+    // Whatever the platform picks when nothing is specified.
+    Default,
+    // Work the user is waiting on, such as reads backing the UI.
+    UserInitiated,
+  };
+
   // Operations scheduled for future execution have an opaque tag. The value of
   // the tag is ignored by the executor but can be used to find operations with
   // a given tag after they are scheduled.
@@ -89,27 +103,41 @@ class Executor {
     }
     Tag tag = 0;
     Operation operation;
+    // The quality of service to run the operation at once it's due.
+    QualityOfService qos = QualityOfService::Default;
   };
 
   // Creates a new serial Executor of the platform-appropriate type, and gives
-  // it the given label, if the implementation supports it.
+  // it the given label and quality of service, if the implementation supports
+  // them.
   //
   // Note that this method has multiple definitions, depending on the platform.
-  static std::unique_ptr<Executor> CreateSerial(const char* label);
+  static std::unique_ptr<Executor> CreateSerial(
+      const char* label, QualityOfService qos = QualityOfService::Default);
 
   // Creates a new concurrent Executor of the platform-appropriate type, with
-  // at least the given number of threads, and gives it the given label, if the
-  // implementation supports it.
+  // at least the given number of threads, and gives it the given label and
+  // quality of service, if the implementation supports them.
   //
   // Note that this method has multiple definitions, depending on the platform.
-  static std::unique_ptr<Executor> CreateConcurrent(const char* label,
-                                                    int threads);
+  static std::unique_ptr<Executor> CreateConcurrent(
+      const char* label,
+      int threads,
+      QualityOfService qos = QualityOfService::Default);
 
   virtual ~Executor() = default;
 
   // Schedules the `operation` to be asynchronously executed as soon as
   // possible, in FIFO order.
   virtual void Execute(Operation&& operation) = 0;
+  // Like `Execute`, but runs the `operation` at the given quality of service
+  // rather than the executor's own. On a serial executor, a more urgent
+  // operation also raises the operations queued ahead of it until it has run.
+  // The default implementation ignores `qos`.
+  virtual void ExecuteWithQos(QualityOfService qos, Operation&& operation) {
+    (void)qos;
+    Execute(std::move(operation));
+  }
   // Like `Execute`, but blocks until the `operation` finishes, consequently
   // draining immediate operations from the executor.
   virtual void ExecuteBlocking(Operation&& operation) = 0;
@@ -70,6 +70,7 @@ class ExecutorLibdispatch : public Executor {
   std::string Name() const override;
 
   void Execute(Operation&& operation) override;
+  void ExecuteWithQos(QualityOfService qos, Operation&& operation) override;
   void ExecuteBlocking(Operation&& operation) override;
   DelayedOperation Schedule(Milliseconds delay,
                             TaggedOperation&& operation) override;
@@ -43,6 +43,42 @@ absl::string_view GetCurrentQueueLabel() {
       dispatch_queue_get_label(DISPATCH_CURRENT_QUEUE_LABEL));
 }
 
+qos_class_t ToQosClass(const Executor::QualityOfService qos) {
+  switch (qos) {
+    case Executor::QualityOfService::Background:
+      return QOS_CLASS_BACKGROUND;
+    case Executor::QualityOfService::Utility:
+      return QOS_CLASS_UTILITY;
+    case Executor::QualityOfService::Default:
+      return QOS_CLASS_DEFAULT;
+    case Executor::QualityOfService::UserInitiated:
+      return QOS_CLASS_USER_INITIATED;
+  }
+  UNREACHABLE();
+}
+
+dispatch_queue_attr_t QueueAttributes(const dispatch_queue_attr_t attributes,
+                                      const Executor::QualityOfService qos) {
+  // Leave default queues unspecified so that they keep inheriting the quality
+  // of service of whoever submits work to them.
+  if (qos == Executor::QualityOfService::Default) {
+    return attributes;
+  }
+  return dispatch_queue_attr_make_with_qos_class(attributes, ToQosClass(qos),
+                                                 0);
+}
+
+// Wraps `work` in a block that runs at the given quality of service, even if
+// the queue it's submitted to or the submitting thread has a different one.
+dispatch_block_t BlockWithQos(const Executor::QualityOfService qos,
+                              std::function<void()>&& work) {
+  const auto wrap = std::make_shared<std::function<void()>>(std::move(work));
+  return dispatch_block_create_with_qos_class(DISPATCH_BLOCK_ENFORCE_QOS_CLASS,
+                                              ToQosClass(qos), 0, ^{
+                                                (*wrap)();
+                                              });
+}
+
 }  // namespace
 
 namespace internal {
@@ -245,6 +281,17 @@ std::string ExecutorLibdispatch::Name() const {
 void ExecutorLibdispatch::Execute(Operation&& operation) {
   DispatchAsync(dispatch_queue(), std::move(operation));
 }
+void ExecutorLibdispatch::ExecuteWithQos(const QualityOfService qos,
+                                         Operation&& operation) {
+  if (qos == QualityOfService::Default) {
+    Execute(std::move(operation));
+    return;
+  }
+  // On a serial queue, libdispatch raises the queue's threads to the block's
+  // quality of service until the block has run, so the operations queued
+  // ahead of it don't keep it waiting at a lower priority.
+  dispatch_async(dispatch_queue(), BlockWithQos(qos, std::move(operation)));
+}
 void ExecutorLibdispatch::ExecuteBlocking(Operation&& operation) {
   DispatchSync(dispatch_queue(), std::move(operation));
 }
@@ -260,6 +307,7 @@ DelayedOperation ExecutorLibdispatch::Schedule(const Milliseconds delay,
   // guaranteed to outlive the executor, and it's possible for work to be
   // invoked by libdispatch after the executor is destroyed. Executor only
   // stores an observer pointer to the operation.
+  const QualityOfService qos = operation.qos;
   TimeSlot* time_slot = nullptr;
   TimeSlotId time_slot_id = 0;
   RunSynchronized(this, [this, delay, &operation, &time_slot, &time_slot_id] {
@@ -268,8 +316,14 @@ DelayedOperation ExecutorLibdispatch::Schedule(const Milliseconds delay,
     schedule_[time_slot_id] = time_slot;
   });
 
-  dispatch_after_f(delay_ns, dispatch_queue(), time_slot,
-                   TimeSlot::InvokedByLibdispatch);
+  if (qos == QualityOfService::Default) {
+    dispatch_after_f(delay_ns, dispatch_queue(), time_slot,
+                     TimeSlot::InvokedByLibdispatch);
+  } else {
+    dispatch_after(delay_ns, dispatch_queue(), BlockWithQos(qos, [time_slot] {
+                     TimeSlot::InvokedByLibdispatch(time_slot);
+                   }));
+  }
 
   return DelayedOperation{[this, time_slot_id] {
     // `time_slot` might have been destroyed by the time cancellation function
@@ -337,19 +391,22 @@ ExecutorLibdispatch::TimeSlotId ExecutorLibdispatch::NextId() {
 
 // MARK: - Executor
 
-std::unique_ptr<Executor> Executor::CreateSerial(const char* label) {
-  dispatch_queue_t queue = dispatch_queue_create(label, DISPATCH_QUEUE_SERIAL);
+std::unique_ptr<Executor> Executor::CreateSerial(const char* label,
+                                                 QualityOfService qos) {
+  dispatch_queue_t queue = dispatch_queue_create(
+      label, QueueAttributes(DISPATCH_QUEUE_SERIAL, qos));
   return absl::make_unique<ExecutorLibdispatch>(queue);
 }
 
 std::unique_ptr<Executor> Executor::CreateConcurrent(const char* label,
-                                                     int threads) {
+                                                     int threads,
+                                                     QualityOfService qos) {
   HARD_ASSERT(threads > 1);
 
   // Concurrent queues auto-create enough threads to avoid deadlock so there's
   // no need to honor the threads argument.
-  dispatch_queue_t queue =
-      dispatch_queue_create(label, DISPATCH_QUEUE_CONCURRENT);
+  dispatch_queue_t queue = dispatch_queue_create(
+      label, QueueAttributes(DISPATCH_QUEUE_CONCURRENT, qos));
   return absl::make_unique<ExecutorLibdispatch>(queue);
 }
 
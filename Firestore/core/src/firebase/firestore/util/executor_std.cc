@@ -20,6 +20,7 @@
 #include <memory>
 #include <sstream>
 
+#include "Firestore/core/src/firebase/firestore/util/serial_executor_std.h"
 #include "absl/memory/memory.h"
 
 namespace firebase {
@@ -41,7 +42,8 @@ std::string ThreadIdToString(const std::thread::id thread_id) {
 // MARK: - ExecutorStd
 
 ExecutorStd::ExecutorStd(int threads)
-    : shutting_down_(std::make_shared<std::atomic<bool>>()) {
+    : immediate_(threads > 0 ? threads : 1),
+      shutting_down_(std::make_shared<std::atomic<bool>>()) {
   HARD_ASSERT(threads > 0);
 
   // Somewhat counter-intuitively, constructor of `std::atomic` assigns the
@@ -49,21 +51,23 @@ ExecutorStd::ExecutorStd(int threads)
   // before the worker thread is started.
   // See [this thread](https://stackoverflow.com/questions/25609858) for context
   // on the constructor.
-  current_id_ = 0;
+  next_queue_ = 0;
+  pending_ = 0;
+  sleeping_ = 0;
   *shutting_down_ = false;
   for (int i = 0; i < threads; ++i) {
-    worker_thread_pool_.emplace_back(&ExecutorStd::PollingThread, this);
+    worker_thread_pool_.emplace_back(&ExecutorStd::PollingThread, this,
+                                     static_cast<size_t>(i));
   }
 }
 
 ExecutorStd::~ExecutorStd() {
-  *shutting_down_ = true;
-
-  // Make sure the worker threads are not blocked, so that the call to `join`
-  // doesn't hang. It's not deterministic which thread will pick up an entry,
-  // so add an entry for each thread before attempting to join.
-  for (size_t i = 0; i < worker_thread_pool_.size(); ++i) {
-    UnblockQueue();
+  {
+    // Setting the flag under the lock makes sure that no worker checks it and
+    // then goes to sleep after the notification.
+    std::lock_guard<std::mutex> lock{sleep_mutex_};
+    *shutting_down_ = true;
+    wake_up_.notify_all();
   }
 
   for (std::thread& thread : worker_thread_pool_) {
@@ -79,7 +83,21 @@ ExecutorStd::~ExecutorStd() {
 }
 
 void ExecutorStd::Execute(Operation&& operation) {
-  PushOnSchedule(std::move(operation), Immediate());
+  WorkerQueue& queue = immediate_[next_queue_++ % immediate_.size()];
+  {
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    queue.operations.push_back(std::move(operation));
+  }
+
+  // The count must go up before checking `sleeping_` (and `Sleep` increments
+  // `sleeping_` before checking the count), so that either a sleeping worker
+  // sees the new operation or this thread sees the worker going to sleep. In
+  // the common case, the workers are busy and no lock is taken.
+  ++pending_;
+  if (sleeping_ > 0) {
+    std::lock_guard<std::mutex> lock{sleep_mutex_};
+    wake_up_.notify_one();
+  }
 }
 
 DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
@@ -91,52 +109,95 @@ DelayedOperation ExecutorStd::Schedule(const Milliseconds delay,
 
   namespace chr = std::chrono;
   const auto now = chr::time_point_cast<Milliseconds>(chr::steady_clock::now());
-  const auto id =
-      PushOnSchedule(std::move(tagged.operation), now + delay, tagged.tag);
+  const Id id = schedule_.Push(Entry{std::move(tagged.operation), tagged.tag},
+                               now + delay, tagged.tag);
+
+  // A sleeping worker may be waiting until a later operation is due.
+  WakeUpForSchedule();
 
   return DelayedOperation{[this, id] { TryCancel(id); }};
 }
 
 void ExecutorStd::TryCancel(const Id operation_id) {
-  schedule_.RemoveIf(
-      [operation_id](const Entry& e) { return e.id == operation_id; });
+  schedule_.Remove(operation_id);
 }
 
-ExecutorStd::Id ExecutorStd::PushOnSchedule(Operation&& operation,
-                                            const TimePoint when,
-                                            const Tag tag) {
-  // Note: operations scheduled for immediate execution don't actually need an
-  // id. This could be tweaked to reuse the same id for all such operations.
-  const auto id = NextId();
-  schedule_.Push(Entry{std::move(operation), id, tag}, when);
-  return id;
-}
-
-void ExecutorStd::PollingThread() {
+void ExecutorStd::PollingThread(const size_t worker) {
   // Keep a local shared_ptr here to ensure that the atomic pointed to by
   // shutting_down_ remains valid even after the destruction of the executor.
   std::shared_ptr<std::atomic<bool>> local_shutting_down = shutting_down_;
   while (!*local_shutting_down) {
-    Entry entry = schedule_.PopBlocking();
-    if (entry.tagged.operation) {
-      entry.tagged.operation();
+    absl::optional<Operation> operation = TakeImmediate(worker);
+    if (operation) {
+      if (*operation) {
+        (*operation)();
+      }
+      continue;
+    }
+
+    absl::optional<Entry> entry = schedule_.PopIfDue();
+    if (entry) {
+      if (entry->tagged.operation) {
+        entry->tagged.operation();
+      }
+      continue;
+    }
+
+    Sleep();
+  }
+}
+
+absl::optional<Executor::Operation> ExecutorStd::TakeImmediate(
+    const size_t worker) {
+  const size_t count = immediate_.size();
+  for (size_t offset = 0; offset != count; ++offset) {
+    WorkerQueue& queue = immediate_[(worker + offset) % count];
+    std::lock_guard<std::mutex> lock{queue.mutex};
+    if (queue.operations.empty()) {
+      continue;
+    }
+
+    Operation operation;
+    if (offset == 0) {
+      operation = std::move(queue.operations.front());
+      queue.operations.pop_front();
+    } else {
+      // Steal from the other end, away from the owner.
+      operation = std::move(queue.operations.back());
+      queue.operations.pop_back();
     }
+    --pending_;
+    return operation;
   }
+  return {};
 }
 
-void ExecutorStd::UnblockQueue() {
-  // Put a no-op for immediate execution on the queue to ensure that
-  // `schedule_.PopBlocking` returns, and worker thread can notice that shutdown
-  // is in progress.
-  schedule_.Push(Entry{[] {}, /*id=*/0}, Immediate());
+void ExecutorStd::Sleep() {
+  std::unique_lock<std::mutex> lock{sleep_mutex_};
+  ++sleeping_;
+
+  const uint64_t generation = schedule_generation_;
+  auto has_work = [this, generation] {
+    return pending_ > 0 || schedule_generation_ != generation ||
+           *shutting_down_;
+  };
+  absl::optional<TimePoint> next_due = schedule_.NextDue();
+  if (next_due) {
+    // Workaround for Visual Studio 2015, see `Schedule::PopBlocking`.
+    const auto until = std::chrono::time_point_cast<
+        std::chrono::steady_clock::duration>(next_due.value());
+    wake_up_.wait_until(lock, until, has_work);
+  } else {
+    wake_up_.wait(lock, has_work);
+  }
+
+  --sleeping_;
 }
 
-ExecutorStd::Id ExecutorStd::NextId() {
-  // The wrap around after ~4 billion operations is explicitly ignored. Even if
-  // an instance of `ExecutorStd` runs long enough to get `current_id_` to
-  // overflow, it's extremely unlikely that any object still holds a reference
-  // that is old enough to cause a conflict.
-  return current_id_++;
+void ExecutorStd::WakeUpForSchedule() {
+  std::lock_guard<std::mutex> lock{sleep_mutex_};
+  ++schedule_generation_;
+  wake_up_.notify_one();
 }
 
 bool ExecutorStd::IsCurrentExecutor() const {
@@ -171,8 +232,7 @@ void ExecutorStd::ExecuteBlocking(Operation&& operation) {
 }
 
 bool ExecutorStd::IsScheduled(const Tag tag) const {
-  return schedule_.Contains(
-      [&tag](const Entry& e) { return e.tagged.tag == tag; });
+  return schedule_.ContainsTag(tag);
 }
 
 absl::optional<Executor::TaggedOperation> ExecutorStd::PopFromSchedule() {
@@ -190,11 +250,16 @@ absl::optional<Executor::TaggedOperation> ExecutorStd::PopFromSchedule() {
 // definition in executor_libdispatch.mm.
 #if !__APPLE__
 
-std::unique_ptr<Executor> Executor::CreateSerial(const char*) {
-  return absl::make_unique<ExecutorStd>(/*threads=*/1);
+// Threads started by the standard library can't be prioritized portably, so
+// the quality of service is ignored.
+std::unique_ptr<Executor> Executor::CreateSerial(const char*,
+                                                 QualityOfService) {
+  return absl::make_unique<SerialExecutorStd>();
 }
 
-std::unique_ptr<Executor> Executor::CreateConcurrent(const char*, int threads) {
+std::unique_ptr<Executor> Executor::CreateConcurrent(const char*,
+                                                     int threads,
+                                                     QualityOfService) {
   return absl::make_unique<ExecutorStd>(threads);
 }
 
@@ -20,11 +20,13 @@
 #include <algorithm>
 #include <atomic>
 #include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
 #include <deque>
 #include <memory>
 #include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <thread>  // NOLINT(build/c++11)
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -46,27 +48,42 @@ namespace async {
 // becomes available. It correctly handles entries being asynchronously added or
 // removed from the schedule.
 //
+// Entries are kept in a binary heap that is indexed by the handles returned
+// from `Push`, so pushing, popping and removing an entry by handle all take
+// logarithmic time. Entries may also be given a tag, and `ContainsTag` takes
+// constant time.
+//
 // The details of time management are completely concealed within the class.
 // Once an entry is scheduled, there is no way to reschedule or even retrieve
 // the time.
 template <typename T>
 class Schedule {
   // Internal invariants:
-  // - entries are always in sorted order, leftmost entry is always the most
-  //   due;
+  // - `heap_` is a binary min-heap, so `heap_.front()` is always the most due
+  //   entry;
+  // - `slots_[node.slot].position` is the position of `node` in `heap_` for
+  //   every node of the heap;
+  // - `tag_counts_` counts the entries with each tag other than `kNoTag`;
   // - each operation modifying the queue notifies the condition variable `cv_`.
  public:
   using Duration = std::chrono::milliseconds;
   using Clock = std::chrono::steady_clock;
   // Entries are scheduled using absolute time.
   using TimePoint = std::chrono::time_point<Clock, Duration>;
+  using Tag = Executor::Tag;
+  // Identifies a scheduled entry. A handle is not reused until its slot has
+  // been reused 2^32 times, so a handle to a removed entry can be safely
+  // passed to `Remove`.
+  using Handle = uint64_t;
+
+  static constexpr Tag kNoTag = -1;
 
   // Schedules an entry for the specified time due. `due` may be in the past.
-  void Push(const T& value, const TimePoint due) {
-    InsertPreservingOrder(Entry{value, due});
+  Handle Push(const T& value, const TimePoint due, const Tag tag = kNoTag) {
+    return Insert(T(value), due, tag);
   }
-  void Push(T&& value, const TimePoint due) {
-    InsertPreservingOrder(Entry{std::move(value), due});
+  Handle Push(T&& value, const TimePoint due, const Tag tag = kNoTag) {
+    return Insert(std::move(value), due, tag);
   }
 
   // If the queue contains at least one entry for which the scheduled time is
@@ -77,7 +94,7 @@ class Schedule {
     std::lock_guard<std::mutex> lock{mutex_};
 
     if (HasDueLocked()) {
-      return ExtractLocked(scheduled_.begin());
+      return ExtractLocked(0);
     }
     return {};
   }
@@ -90,7 +107,7 @@ class Schedule {
     std::unique_lock<std::mutex> lock{mutex_};
 
     while (true) {
-      cv_.wait(lock, [this] { return !scheduled_.empty(); });
+      cv_.wait(lock, [this] { return !heap_.empty(); });
 
       // To minimize busy waiting, sleep until either the nearest entry in the
       // future either changes, or else becomes due.
@@ -99,9 +116,9 @@ class Schedule {
       // that's at least as fine-grained as the clock on which `wait_until` is
       // parametrized.
       const auto until =
-          std::chrono::time_point_cast<Clock::duration>(scheduled_.front().due);
+          std::chrono::time_point_cast<Clock::duration>(heap_.front().due);
       cv_.wait_until(lock, until, [this, until] {
-        return scheduled_.empty() || scheduled_.front().due != until;
+        return heap_.empty() || heap_.front().due != until;
       });
       // There are 3 possibilities why `wait_until` has returned:
       // - `wait_until` has timed out, in which case the current time is at
@@ -115,24 +132,57 @@ class Schedule {
       //   to #2.
 
       if (HasDueLocked()) {
-        return ExtractLocked(scheduled_.begin());
+        return ExtractLocked(0);
       }
     }
   }
 
   bool empty() const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return scheduled_.empty();
+    return heap_.empty();
   }
 
   size_t size() const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return scheduled_.size();
+    return heap_.size();
   }
 
-  // Removes the first entry satisfying predicate from the queue and returns it.
-  // If no such entry exists, returns an empty `optional`. Predicate is applied
-  // to entries in order according to their scheduled time.
+  // Returns the time for which the most due entry is scheduled. If the queue is
+  // empty, returns an empty `optional`.
+  absl::optional<TimePoint> NextDue() const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (heap_.empty()) {
+      return {};
+    }
+    return heap_.front().due;
+  }
+
+  // Removes the entry with the given handle from the queue and returns it. If
+  // the entry has already been removed, returns an empty `optional`.
+  //
+  // Note that this function doesn't take into account whether the removed entry
+  // is past its due time.
+  absl::optional<T> Remove(const Handle handle) {
+    std::lock_guard<std::mutex> lock{mutex_};
+
+    const auto slot = static_cast<uint32_t>(handle);
+    const auto generation = static_cast<uint32_t>(handle >> 32);
+    if (slot >= slots_.size() || slots_[slot].generation != generation ||
+        !slots_[slot].value) {
+      return {};
+    }
+    return ExtractLocked(slots_[slot].position);
+  }
+
+  // Checks whether the queue contains an entry with the given tag.
+  bool ContainsTag(const Tag tag) const {
+    std::lock_guard<std::mutex> lock{mutex_};
+    return tag_counts_.find(tag) != tag_counts_.end();
+  }
+
+  // Removes the most due entry satisfying predicate from the queue and returns
+  // it. If no such entry exists, returns an empty `optional`. Takes linear
+  // time; prefer `Remove` where a handle is available.
   //
   // Note that this function doesn't take into account whether the removed entry
   // is past its due time.
@@ -140,12 +190,16 @@ class Schedule {
   absl::optional<T> RemoveIf(const Pred pred) {
     std::lock_guard<std::mutex> lock{mutex_};
 
-    for (auto iter = scheduled_.begin(), end = scheduled_.end(); iter != end;
-         ++iter) {
-      if (pred(iter->value)) {
-        return ExtractLocked(iter);
+    absl::optional<size_t> found;
+    for (size_t i = 0; i != heap_.size(); ++i) {
+      if ((!found || heap_[i] < heap_[*found]) &&
+          pred(*slots_[heap_[i].slot].value)) {
+        found = i;
       }
     }
+    if (found) {
+      return ExtractLocked(*found);
+    }
     return {};
   }
 
@@ -153,62 +207,167 @@ class Schedule {
   template <typename Pred>
   bool Contains(const Pred pred) const {
     std::lock_guard<std::mutex> lock{mutex_};
-    return std::any_of(scheduled_.begin(), scheduled_.end(),
-                       [&pred](const Entry& s) { return pred(s.value); });
+    return std::any_of(heap_.begin(), heap_.end(), [&](const Node& node) {
+      return pred(*slots_[node.slot].value);
+    });
   }
 
  private:
-  struct Entry {
-    bool operator<(const Entry& rhs) const {
-      return due < rhs.due;
+  // A heap node is kept small, so that sifting it is cheap; the value stays in
+  // its slot.
+  struct Node {
+    Node(const TimePoint due, const uint64_t sequence, const uint32_t slot)
+        : due{due}, sequence{sequence}, slot{slot} {
+    }
+
+    bool operator<(const Node& rhs) const {
+      return due < rhs.due || (due == rhs.due && sequence < rhs.sequence);
     }
 
-    T value;
     TimePoint due;
+    // Breaks ties between entries due at the same time in FIFO order.
+    uint64_t sequence;
+    uint32_t slot;
   };
-  // All removals are on the front, but most insertions are expected to be on
-  // the back.
-  using Container = std::deque<Entry>;
-  using Iterator = typename Container::iterator;
 
-  void InsertPreservingOrder(Entry&& new_entry) {
+  struct Slot {
+    absl::optional<T> value;
+    Tag tag = kNoTag;
+    size_t position = 0;
+    // Incremented whenever the slot is freed, to invalidate old handles.
+    uint32_t generation = 0;
+  };
+
+  Handle Insert(T&& value, const TimePoint due, const Tag tag) {
     std::lock_guard<std::mutex> lock{mutex_};
 
-    const auto insertion_point =
-        std::upper_bound(scheduled_.begin(), scheduled_.end(), new_entry);
-    scheduled_.insert(insertion_point, std::move(new_entry));
+    uint32_t slot_index;
+    if (free_slots_.empty()) {
+      slot_index = static_cast<uint32_t>(slots_.size());
+      slots_.emplace_back();
+    } else {
+      slot_index = free_slots_.back();
+      free_slots_.pop_back();
+    }
+    Slot& slot = slots_[slot_index];
+    slot.value = std::move(value);
+    slot.tag = tag;
+    if (tag != kNoTag) {
+      ++tag_counts_[tag];
+    }
+
+    heap_.emplace_back(due, next_sequence_++, slot_index);
+    slot.position = heap_.size() - 1;
+    SiftUp(heap_.size() - 1);
 
     cv_.notify_one();
+    return (static_cast<Handle>(slot.generation) << 32) | slot_index;
   }
 
   // This function expects the mutex to be already locked.
   bool HasDueLocked() const {
     namespace chr = std::chrono;
     const auto now = chr::time_point_cast<Duration>(Clock::now());
-    return !scheduled_.empty() && now >= scheduled_.front().due;
+    return !heap_.empty() && now >= heap_.front().due;
   }
 
   // This function expects the mutex to be already locked.
-  T ExtractLocked(const Iterator where) {
-    HARD_ASSERT(!scheduled_.empty(),
-                "Trying to pop an entry from an empty queue.");
+  T ExtractLocked(const size_t position) {
+    HARD_ASSERT(!heap_.empty(), "Trying to pop an entry from an empty queue.");
+
+    const uint32_t slot_index = heap_[position].slot;
+    Slot& slot = slots_[slot_index];
+    T result = std::move(*slot.value);
+    slot.value.reset();
+    if (slot.tag != kNoTag) {
+      auto count = tag_counts_.find(slot.tag);
+      if (--count->second == 0) {
+        tag_counts_.erase(count);
+      }
+    }
+    ++slot.generation;
+    free_slots_.push_back(slot_index);
+
+    // Fill the hole with the last node, which may belong either above or below
+    // it.
+    const size_t last = heap_.size() - 1;
+    if (position != last) {
+      Place(position, heap_[last]);
+      heap_.pop_back();
+      SiftDown(SiftUp(position));
+    } else {
+      heap_.pop_back();
+    }
 
-    T result = std::move(where->value);
-    scheduled_.erase(where);
     cv_.notify_one();
-
     return result;
   }
 
+  void Place(const size_t position, const Node& node) {
+    heap_[position] = node;
+    slots_[node.slot].position = position;
+  }
+
+  // Moves the node at `position` up until its parent is due before it, and
+  // returns its new position.
+  size_t SiftUp(size_t position) {
+    const Node node = heap_[position];
+    while (position > 0) {
+      const size_t parent = (position - 1) / 2;
+      if (!(node < heap_[parent])) {
+        break;
+      }
+      Place(position, heap_[parent]);
+      position = parent;
+    }
+    Place(position, node);
+    return position;
+  }
+
+  // Moves the node at `position` down until its children are due after it.
+  void SiftDown(size_t position) {
+    const Node node = heap_[position];
+    const size_t size = heap_.size();
+    while (true) {
+      size_t child = 2 * position + 1;
+      if (child >= size) {
+        break;
+      }
+      if (child + 1 < size && heap_[child + 1] < heap_[child]) {
+        ++child;
+      }
+      if (!(heap_[child] < node)) {
+        break;
+      }
+      Place(position, heap_[child]);
+      position = child;
+    }
+    Place(position, node);
+  }
+
   mutable std::mutex mutex_;
   std::condition_variable cv_;
-  Container scheduled_;
+  std::vector<Node> heap_;
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> free_slots_;
+  std::unordered_map<Tag, int> tag_counts_;
+  uint64_t next_sequence_ = 0;
 };
 
+template <typename T>
+constexpr typename Schedule<T>::Tag Schedule<T>::kNoTag;
+
 }  // namespace async
 
-// A serial queue that executes provided operations on a dedicated background
-// thread, using C++11 standard library functionality.
+// An executor that runs operations on a pool of worker threads, using C++11
+// standard library functionality. With a single thread, it's a serial queue.
+//
+// Each worker has its own queue of operations for immediate execution, and
+// `Execute` spreads operations across the queues. A worker runs the operations
+// on its own queue in FIFO order, and once it runs out, steals from the back of
+// the other workers' queues. So workers don't contend on a single lock, and
+// idle workers only wait on a condition variable when there is no work at all.
+// Delayed operations are kept in a shared `Schedule`.
 class ExecutorStd : public Executor {
  public:
   explicit ExecutorStd(int threads);
@@ -228,36 +387,33 @@ class ExecutorStd : public Executor {
   absl::optional<TaggedOperation> PopFromSchedule() override;
 
   using TimePoint = async::Schedule<Operation>::TimePoint;
-  // To allow canceling operations, each scheduled operation is assigned
-  // a monotonically increasing identifier.
-  using Id = unsigned int;
+  // To allow canceling operations, each scheduled operation is identified by
+  // the handle of its entry in the schedule.
+  using Id = uint64_t;
 
   // If the operation hasn't yet been run, it will be removed from the queue.
   // Otherwise, this function is a no-op.
   void TryCancel(Id operation_id);
 
-  Id PushOnSchedule(Operation&& operation, TimePoint when, Tag tag = -1);
+  void PollingThread(size_t worker);
 
-  void PollingThread();
-  void UnblockQueue();
-  Id NextId();
+  // Removes an operation for immediate execution from the queue of `worker`,
+  // or else from the queue of another worker, and returns it. Returns an empty
+  // `optional` if all queues are empty.
+  absl::optional<Operation> TakeImmediate(size_t worker);
 
-  // As a convention, assign the epoch time to all operations scheduled for
-  // immediate execution. Note that it means that an immediate operation is
-  // always scheduled before any delayed operation, even in the corner case when
-  // the immediate operation was scheduled after a delayed operation was due
-  // (but hasn't yet run).
-  static TimePoint Immediate() {
-    return TimePoint{};
-  }
+  // Blocks until there may be an operation to run.
+  void Sleep();
+  // Wakes up a sleeping worker, if there is one, so that it notices a newly
+  // scheduled delayed operation.
+  void WakeUpForSchedule();
 
   struct Entry {
     Entry() {
     }
-    Entry(Operation&& operation,
-          const ExecutorStd::Id id,
-          const ExecutorStd::Tag tag = kNoTag)
-        : tagged{tag, std::move(operation)}, id{id} {
+    explicit Entry(Operation&& operation,
+                   const ExecutorStd::Tag tag = kNoTag)
+        : tagged{tag, std::move(operation)} {
     }
 
     bool IsImmediate() const {
@@ -266,17 +422,36 @@ class ExecutorStd : public Executor {
 
     static constexpr Tag kNoTag = -1;
     TaggedOperation tagged;
-    Id id = 0;
   };
-  // Operations scheduled for immediate execution are also put on the schedule
-  // (with due time set to `Immediate`).
+
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Operation> operations;
+  };
+
+  // One queue of operations for immediate execution per worker thread.
+  // Immediate operations always run before any delayed operation that's due.
+  std::vector<WorkerQueue> immediate_;
+  // The queue that `Execute` pushes to next, modulo the number of queues.
+  std::atomic<size_t> next_queue_{0};
+  // The number of operations on all queues in `immediate_`. May briefly be
+  // negative while an operation is taken before its push has been counted.
+  std::atomic<int64_t> pending_{0};
+
+  // Delayed operations only.
   async::Schedule<Entry> schedule_;
 
+  // Used to put idle workers to sleep.
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_up_;
+  std::atomic<int> sleeping_{0};
+  // Incremented when a delayed operation is scheduled, so that sleeping
+  // workers reevaluate how long to sleep for.
+  uint64_t schedule_generation_ = 0;
+
   std::vector<std::thread> worker_thread_pool_;
   // Used to stop the worker thread.
   std::shared_ptr<std::atomic<bool>> shutting_down_;
-
-  std::atomic<Id> current_id_{0};
 };
 
 }  // namespace util
@@ -31,27 +31,22 @@ namespace firebase {
 namespace firestore {
 namespace util {
 
-// This is a pretty terrible hash implementation for lack of a better one being
-// readily available. It exists as a portability crutch between our existing
-// Objective-C code where overriding `-isEqual:` also requires `-hash` and C++
-// where `operator==()` can be defined without defining a hash code.
-//
-// It's based on the recommendation in Effective Java, Item 9, wherein you
-// implement composite hashes like so:
-//
-//     size_t result = first_;
-//     result = 31 * result + second_;
-//     result = 31 * result + third_;
-//     // ...
-//     return result;
-//
-// This is the basis of this implementation because that's what the existing
-// Objective-C code mostly does by hand. Using this implementation gets the
-// same result by calling
+// A hash for types whose equality is defined in C++, so that they can be
+// used in unordered containers and so that Objective-C wrappers overriding
+// `-isEqual:` can also implement `-hash`. Composite hashes are written as
 //
 //     return util::Hash(first_, second_, /* ..., */ third_);
 //
-// TODO(wilhuff): Replace this with whatever Abseil releases.
+// The hashes of the values are combined in the style of boost::hash_combine.
+// Unlike the `31 * result + value` recipe from Effective Java, it doesn't make
+// composites of small integers (whose std::hash is often the identity) collide
+// whenever they add up to the same total, yet it costs no more than a few
+// shifts and adds. Multiply-based mixers such as
+// wyhash's spread bits better but measured slower in unordered containers,
+// which is where these hashes end up (see hashing_benchmark.cc).
+//
+// Hashes are only stable within a single process: they must never be
+// persisted or sent over the wire.
 
 namespace impl {
 
@@ -93,9 +88,12 @@ using std_hash_type =
 
 /**
  * Combines a hash_value with whatever accumulated state there is so far.
+ *
+ * This is the mixing step of boost::hash_combine: the shifts carry the high
+ * and low bits of the state into each other before the value is folded in.
  */
 constexpr size_t Combine(size_t state, size_t hash_value) {
-  return 31 * state + hash_value;
+  return state ^ (hash_value + 0x9e3779b9 + (state << 6) + (state >> 2));
 }
 
 /**
@@ -216,9 +214,14 @@ size_t HashInternal(size_t state, const T& value, const Ts&... rest) {
 
 }  // namespace impl
 
-template <typename... Ts>
-size_t Hash(const Ts&... values) {
-  return impl::HashInternal(0u, values...);
+/**
+ * Returns the hash of the given values. The hash of a single value is that
+ * value's own hash, such as the result of its `Hash()` member or `-hash`
+ * method.
+ */
+template <typename T, typename... Ts>
+size_t Hash(const T& value, const Ts&... rest) {
+  return impl::HashInternal(impl::InvokeHash(value), rest...);
 }
 
 }  // namespace util
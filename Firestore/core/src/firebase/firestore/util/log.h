@@ -37,6 +37,19 @@ enum LogLevel {
   kLogLevelError,
 };
 
+// The lowest level that is compiled in. Messages below it are removed at
+// compile time, along with the evaluation of their arguments, regardless of
+// the level set with `LogSetLevel`. Defaults to `kLogLevelDebug`, which keeps
+// all messages.
+#ifndef FIRESTORE_MIN_LOG_LEVEL
+#define FIRESTORE_MIN_LOG_LEVEL 0
+#endif
+
+// Tests whether messages at the given level are compiled in.
+constexpr bool LogIsCompiledIn(LogLevel level) {
+  return level >= FIRESTORE_MIN_LOG_LEVEL;
+}
+
 // Log a message if kLogLevelDebug is enabled. Arguments are not evaluated if
 // logging is disabled.
 //
@@ -46,7 +59,8 @@ enum LogLevel {
 #define LOG_DEBUG(...)                                         \
   do {                                                         \
     namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelDebug)) {         \
+    if (_util::LogIsCompiledIn(_util::kLogLevelDebug) &&       \
+        _util::LogIsLoggable(_util::kLogLevelDebug)) {         \
       std::string _message = _util::StringFormat(__VA_ARGS__); \
       _util::LogMessage(_util::kLogLevelDebug, _message);      \
     }                                                          \
@@ -61,7 +75,8 @@ enum LogLevel {
 #define LOG_WARN(...)                                          \
   do {                                                         \
     namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelWarning)) {       \
+    if (_util::LogIsCompiledIn(_util::kLogLevelWarning) &&     \
+        _util::LogIsLoggable(_util::kLogLevelWarning)) {       \
       std::string _message = _util::StringFormat(__VA_ARGS__); \
       _util::LogMessage(_util::kLogLevelWarning, _message);    \
     }                                                          \
@@ -76,7 +91,8 @@ enum LogLevel {
 #define LOG_ERROR(...)                                         \
   do {                                                         \
     namespace _util = firebase::firestore::util;               \
-    if (_util::LogIsLoggable(_util::kLogLevelError)) {         \
+    if (_util::LogIsCompiledIn(_util::kLogLevelError) &&       \
+        _util::LogIsLoggable(_util::kLogLevelError)) {         \
       std::string _message = _util::StringFormat(__VA_ARGS__); \
       _util::LogMessage(_util::kLogLevelError, _message);      \
     }                                                          \
@@ -87,7 +103,7 @@ bool LogIsLoggable(LogLevel level);
 
 // Is debug logging enabled?
 inline bool LogIsDebugEnabled() {
-  return LogIsLoggable(kLogLevelDebug);
+  return LogIsCompiledIn(kLogLevelDebug) && LogIsLoggable(kLogLevelDebug);
 }
 
 // All messages at or above the specified log level value are displayed.
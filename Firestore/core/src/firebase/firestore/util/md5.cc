@@ -0,0 +1,135 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/md5.h"
+
+#include <cstring>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+// Per-round shift amounts.
+const uint32_t kShifts[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20, 5, 9,  14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21,
+};
+
+// The integer parts of abs(sin(i + 1)) * 2^32.
+const uint32_t kSines[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391,
+};
+
+uint32_t RotateLeft(uint32_t value, uint32_t shift) {
+  return (value << shift) | (value >> (32 - shift));
+}
+
+/** Folds one 64-byte block into the running state. */
+void ProcessBlock(const uint8_t* block, uint32_t state[4]) {
+  uint32_t words[16];
+  for (int i = 0; i != 16; ++i) {
+    words[i] = static_cast<uint32_t>(block[i * 4]) |
+               static_cast<uint32_t>(block[i * 4 + 1]) << 8 |
+               static_cast<uint32_t>(block[i * 4 + 2]) << 16 |
+               static_cast<uint32_t>(block[i * 4 + 3]) << 24;
+  }
+
+  uint32_t a = state[0];
+  uint32_t b = state[1];
+  uint32_t c = state[2];
+  uint32_t d = state[3];
+
+  for (int i = 0; i != 64; ++i) {
+    uint32_t f;
+    int g;
+    if (i < 16) {
+      f = (b & c) | (~b & d);
+      g = i;
+    } else if (i < 32) {
+      f = (d & b) | (~d & c);
+      g = (5 * i + 1) % 16;
+    } else if (i < 48) {
+      f = b ^ c ^ d;
+      g = (3 * i + 5) % 16;
+    } else {
+      f = c ^ (b | ~d);
+      g = (7 * i) % 16;
+    }
+
+    uint32_t rotated = RotateLeft(a + f + kSines[i] + words[g], kShifts[i]);
+    a = d;
+    d = c;
+    c = b;
+    b = b + rotated;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+}
+
+}  // namespace
+
+std::array<uint8_t, 16> CalculateMd5Digest(absl::string_view data) {
+  uint32_t state[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+
+  const auto* bytes = reinterpret_cast<const uint8_t*>(data.data());
+  size_t size = data.size();
+  size_t offset = 0;
+  for (; size - offset >= 64; offset += 64) {
+    ProcessBlock(bytes + offset, state);
+  }
+
+  // Pad the remainder with a single 1 bit, zeros, and the message length in
+  // bits, spilling into a second block if the length doesn't fit.
+  uint8_t tail[128] = {};
+  size_t remaining = size - offset;
+  std::memcpy(tail, bytes + offset, remaining);
+  tail[remaining] = 0x80;
+  size_t tail_size = remaining < 56 ? 64 : 128;
+
+  uint64_t bit_length = static_cast<uint64_t>(size) * 8;
+  for (int i = 0; i != 8; ++i) {
+    tail[tail_size - 8 + i] = static_cast<uint8_t>(bit_length >> (i * 8));
+  }
+  for (size_t i = 0; i != tail_size; i += 64) {
+    ProcessBlock(tail + i, state);
+  }
+
+  std::array<uint8_t, 16> digest;
+  for (int i = 0; i != 16; ++i) {
+    digest[i] = static_cast<uint8_t>(state[i / 4] >> ((i % 4) * 8));
+  }
+  return digest;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/parallel_for.h"
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace internal {
+namespace {
+
+using Body = std::function<void(size_t begin, size_t end, int worker)>;
+
+// Enough chunks that the other workers can take over from a worker that falls
+// behind, and few enough that claiming a chunk is cheap next to processing it.
+constexpr size_t kChunksPerWorker = 8;
+
+/** The part of the range that a worker hasn't processed or lost yet. */
+struct Share {
+  std::mutex mutex;
+  size_t begin = 0;
+  size_t end = 0;
+};
+
+/**
+ * The state shared by the workers of one ParallelForChunks call. Owned jointly
+ * by the caller and the scheduled tasks, so that tasks starting after the call
+ * has returned can still find out that there's nothing left to do.
+ */
+class ParallelForState {
+ public:
+  ParallelForState(int workers, size_t count, size_t chunk_size,
+                   const Body* body)
+      : shares_(workers),
+        chunk_size_(chunk_size),
+        body_(body),
+        remaining_(count) {
+    size_t n = shares_.size();
+    for (size_t i = 0; i != n; ++i) {
+      shares_[i].begin = count * i / n;
+      shares_[i].end = count * (i + 1) / n;
+    }
+  }
+
+  /** Processes chunks until there are none left to claim. */
+  void Run(int worker) {
+    size_t begin = 0;
+    size_t end = 0;
+    while (Claim(worker, &begin, &end)) {
+      (*body_)(begin, end, worker);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      remaining_ -= end - begin;
+      if (remaining_ == 0) {
+        done_.notify_all();
+      }
+    }
+  }
+
+  /** Blocks until every chunk has been processed. */
+  void Await() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return remaining_ == 0; });
+  }
+
+ private:
+  bool Claim(int worker, size_t* begin, size_t* end) {
+    size_t n = shares_.size();
+    Share& own = shares_[worker];
+    {
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (own.begin != own.end) {
+        *begin = own.begin;
+        *end = std::min(own.begin + chunk_size_, own.end);
+        own.begin = *end;
+        return true;
+      }
+    }
+
+    // Steal from the back, away from where the owner is working.
+    for (size_t offset = 1; offset != n; ++offset) {
+      Share& victim = shares_[(worker + offset) % n];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (victim.begin != victim.end) {
+        *end = victim.end;
+        *begin = victim.end - std::min(chunk_size_, victim.end - victim.begin);
+        victim.end = *begin;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<Share> shares_;
+  size_t chunk_size_ = 0;
+
+  // Only valid while chunks remain, which the caller waits for.
+  const Body* body_ = nullptr;
+
+  size_t remaining_ = 0;
+  std::mutex mutex_;
+  std::condition_variable done_;
+};
+
+}  // namespace
+
+void ParallelForChunks(Executor* executor,
+                       int workers,
+                       size_t count,
+                       const Body& body) {
+  if (count == 0) {
+    return;
+  }
+  if (workers < 1) {
+    workers = 1;
+  }
+  if (static_cast<size_t>(workers) > count) {
+    workers = static_cast<int>(count);
+  }
+  if (workers == 1) {
+    body(0, count, 0);
+    return;
+  }
+
+  size_t chunk_size =
+      std::max<size_t>(1, count / (workers * kChunksPerWorker));
+  auto state =
+      std::make_shared<ParallelForState>(workers, count, chunk_size, &body);
+  for (int worker = 1; worker < workers; ++worker) {
+    executor->Execute([state, worker] { state->Run(worker); });
+  }
+
+  state->Run(0);
+  state->Await();
+}
+
+}  // namespace internal
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
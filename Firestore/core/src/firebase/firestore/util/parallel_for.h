@@ -0,0 +1,112 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_PARALLEL_FOR_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_PARALLEL_FOR_H_
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class Executor;
+
+namespace internal {
+
+/**
+ * Splits [0, count) into chunks and calls `body(begin, end, worker)` once per
+ * chunk, on the calling thread and on up to `workers - 1` tasks scheduled on
+ * `executor`. `worker` is in [0, workers), and no two calls with the same
+ * `worker` run at the same time.
+ *
+ * Each worker starts with an equal share of the range and takes chunks from
+ * the front of it. Once its share is exhausted, it steals chunks from the back
+ * of the other workers' shares, so uneven chunks don't leave workers idle.
+ *
+ * Blocks until every chunk has been processed. Tasks that start late find no
+ * work left and return without calling `body`, so the caller doesn't wait for
+ * them.
+ */
+void ParallelForChunks(
+    Executor* executor,
+    int workers,
+    size_t count,
+    const std::function<void(size_t begin, size_t end, int worker)>& body);
+
+}  // namespace internal
+
+/**
+ * Calls `body(i)` for every `i` in [0, count), in parallel on `executor` and
+ * the calling thread, and blocks until all calls have finished. Uses at most
+ * `workers` threads; `executor` must be able to run `workers - 1` tasks
+ * concurrently for them all to be used.
+ */
+template <typename Body>
+void ParallelFor(Executor* executor, int workers, size_t count, Body&& body) {
+  internal::ParallelForChunks(executor, workers, count,
+                              [&body](size_t begin, size_t end, int) {
+                                for (size_t i = begin; i != end; ++i) {
+                                  body(i);
+                                }
+                              });
+}
+
+/**
+ * Like `ParallelFor`, but `body(i, &results)` may append any number of values
+ * to `results`. Each worker appends to its own vector, so producing results
+ * takes no locks, and the vectors are concatenated once all calls have
+ * finished.
+ *
+ * The results are grouped by worker, so they are in no particular order.
+ */
+template <typename T, typename Body>
+std::vector<T> ParallelCollect(Executor* executor,
+                               int workers,
+                               size_t count,
+                               Body&& body) {
+  std::vector<std::vector<T>> buffers(workers > 1 ? workers : 1);
+  internal::ParallelForChunks(
+      executor, workers, count,
+      [&body, &buffers](size_t begin, size_t end, int worker) {
+        std::vector<T>* results = &buffers[worker];
+        for (size_t i = begin; i != end; ++i) {
+          body(i, results);
+        }
+      });
+
+  size_t size = 0;
+  for (const std::vector<T>& buffer : buffers) {
+    size += buffer.size();
+  }
+  std::vector<T> result = std::move(buffers[0]);
+  result.reserve(size);
+  for (size_t i = 1; i < buffers.size(); ++i) {
+    result.insert(result.end(), std::make_move_iterator(buffers[i].begin()),
+                  std::make_move_iterator(buffers[i].end()));
+  }
+  return result;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_PARALLEL_FOR_H_
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/util/rate_limiter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+RateLimiter::RateLimiter(int64_t initial_capacity,
+                         double multiplier,
+                         Milliseconds multiplier_period,
+                         int64_t maximum_capacity,
+                         Clock::time_point start_time)
+    : initial_capacity_{initial_capacity},
+      multiplier_{multiplier},
+      multiplier_period_{multiplier_period},
+      maximum_capacity_{maximum_capacity},
+      start_time_{start_time},
+      available_tokens_{initial_capacity},
+      last_refill_time_{start_time} {
+  HARD_ASSERT(initial_capacity > 0, "Rate limiter capacity must be positive");
+  HARD_ASSERT(multiplier_period.count() > 0,
+              "Rate limiter multiplier period must be positive");
+}
+
+bool RateLimiter::TryMakeRequest(int64_t num_operations,
+                                 Clock::time_point request_time) {
+  RefillTokens(request_time);
+  if (num_operations > available_tokens_) {
+    return false;
+  }
+  available_tokens_ -= num_operations;
+  return true;
+}
+
+RateLimiter::Milliseconds RateLimiter::GetNextRequestDelay(
+    int64_t num_operations, Clock::time_point request_time) {
+  RefillTokens(request_time);
+
+  int64_t capacity = CapacityAt(request_time);
+  int64_t needed = std::min(num_operations, capacity) - available_tokens_;
+  if (needed <= 0) {
+    return Milliseconds{0};
+  }
+
+  // Round up so that the bucket is sure to hold enough tokens by then.
+  return Milliseconds{(needed * 1000 + capacity - 1) / capacity};
+}
+
+int64_t RateLimiter::CapacityAt(Clock::time_point time) const {
+  int64_t periods =
+      std::max<int64_t>((time - start_time_) / multiplier_period_, 0);
+  double capacity = std::floor(std::pow(multiplier_, periods) *
+                               static_cast<double>(initial_capacity_));
+  if (capacity >= static_cast<double>(maximum_capacity_)) {
+    return maximum_capacity_;
+  }
+  return static_cast<int64_t>(capacity);
+}
+
+void RateLimiter::RefillTokens(Clock::time_point request_time) {
+  if (request_time <= last_refill_time_) {
+    return;
+  }
+
+  int64_t capacity = CapacityAt(request_time);
+  auto elapsed = std::chrono::duration_cast<Milliseconds>(request_time -
+                                                          last_refill_time_);
+  int64_t tokens_to_add = elapsed.count() * capacity / 1000;
+
+  // Only advance the refill time when whole tokens were added, so that
+  // frequent requests don't lose the fractional tokens in between.
+  if (tokens_to_add > 0) {
+    available_tokens_ = std::min(capacity, available_tokens_ + tokens_to_add);
+    last_refill_time_ = request_time;
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_RATE_LIMITER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_RATE_LIMITER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A token bucket that limits the rate of operations, with a capacity that
+ * grows over time.
+ *
+ * The bucket starts out holding `initial_capacity` tokens and refills at a
+ * rate of `capacity` tokens per second. Every `multiplier_period` after
+ * `start_time`, the capacity is multiplied by `multiplier`, up to
+ * `maximum_capacity`. With the default parameters of `BulkWriter` this
+ * implements the "500/50/5" ramp-up rule recommended for Firestore: start at
+ * 500 operations per second and increase by 50% every 5 minutes.
+ *
+ * Times are passed in explicitly so that the limiter can be tested without
+ * waiting.
+ */
+class RateLimiter {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Milliseconds = std::chrono::milliseconds;
+
+  RateLimiter(int64_t initial_capacity,
+              double multiplier,
+              Milliseconds multiplier_period,
+              int64_t maximum_capacity,
+              Clock::time_point start_time);
+
+  /**
+   * Consumes `num_operations` tokens and returns true if the bucket holds
+   * enough of them at `request_time`. Otherwise, leaves the bucket unchanged
+   * and returns false.
+   */
+  bool TryMakeRequest(int64_t num_operations, Clock::time_point request_time);
+
+  /**
+   * Returns how long to wait after `request_time` until a request for
+   * `num_operations` would succeed. Returns zero if it would succeed now.
+   *
+   * A request for more operations than the current capacity is treated as a
+   * request for the full capacity, so that it is delayed rather than starved.
+   */
+  Milliseconds GetNextRequestDelay(int64_t num_operations,
+                                   Clock::time_point request_time);
+
+  /** The refill rate, in tokens per second, at `time`. */
+  int64_t CapacityAt(Clock::time_point time) const;
+
+ private:
+  void RefillTokens(Clock::time_point request_time);
+
+  const int64_t initial_capacity_;
+  const double multiplier_;
+  const Milliseconds multiplier_period_;
+  const int64_t maximum_capacity_;
+  const Clock::time_point start_time_;
+
+  int64_t available_tokens_;
+  Clock::time_point last_refill_time_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_RATE_LIMITER_H_
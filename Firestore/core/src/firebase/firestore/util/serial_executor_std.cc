@@ -0,0 +1,185 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/serial_executor_std.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <future>  // NOLINT(build/c++11)
+#include <sstream>
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+// The only guarantee is that different `thread_id`s will produce different
+// values.
+std::string ThreadIdToString(const std::thread::id thread_id) {
+  std::ostringstream stream;
+  stream << thread_id;
+  return stream.str();
+}
+
+}  // namespace
+
+SerialExecutorStd::SerialExecutorStd()
+    : shutting_down_(std::make_shared<std::atomic<bool>>()) {
+  // See the comment in `ExecutorStd` constructor on why the atomics are
+  // assigned before the worker thread is started.
+  sleeping_ = false;
+  *shutting_down_ = false;
+  worker_thread_ = std::thread{&SerialExecutorStd::PollingThread, this};
+}
+
+SerialExecutorStd::~SerialExecutorStd() {
+  *shutting_down_ = true;
+  WakeUp();
+
+  // If the current thread is running this destructor, we can't join the
+  // thread. Instead detach it and rely on PollingThread to notice that
+  // *shutting_down_ is now true.
+  if (std::this_thread::get_id() == worker_thread_.get_id()) {
+    worker_thread_.detach();
+  } else {
+    worker_thread_.join();
+  }
+}
+
+void SerialExecutorStd::Execute(Operation&& operation) {
+  immediate_.Push(std::move(operation));
+
+  // The push must come before checking `sleeping_` (and `Sleep` sets
+  // `sleeping_` before checking for operations), so that either the worker
+  // thread sees the new operation or this thread sees it going to sleep. In
+  // the common case, the worker thread is busy and no lock is taken.
+  if (sleeping_) {
+    WakeUp();
+  }
+}
+
+DelayedOperation SerialExecutorStd::Schedule(const Milliseconds delay,
+                                             TaggedOperation&& tagged) {
+  HARD_ASSERT(delay.count() >= 0, "Schedule: delay cannot be negative");
+
+  namespace chr = std::chrono;
+  const auto now = chr::time_point_cast<Milliseconds>(chr::steady_clock::now());
+  const Id id = schedule_.Push(Entry{std::move(tagged.operation), tagged.tag},
+                              now + delay, tagged.tag);
+
+  // The worker thread may be sleeping until a later operation is due.
+  WakeUp();
+
+  return DelayedOperation{[this, id] { TryCancel(id); }};
+}
+
+void SerialExecutorStd::TryCancel(const Id operation_id) {
+  schedule_.Remove(operation_id);
+}
+
+void SerialExecutorStd::PollingThread() {
+  // Keep a local shared_ptr here to ensure that the atomic pointed to by
+  // shutting_down_ remains valid even after the destruction of the executor.
+  std::shared_ptr<std::atomic<bool>> local_shutting_down = shutting_down_;
+  while (!*local_shutting_down) {
+    absl::optional<Operation> operation = immediate_.Pop();
+    if (operation) {
+      if (*operation) {
+        (*operation)();
+      }
+      continue;
+    }
+
+    absl::optional<Entry> entry = schedule_.PopIfDue();
+    if (entry) {
+      if (entry->tagged.operation) {
+        entry->tagged.operation();
+      }
+      continue;
+    }
+
+    Sleep();
+  }
+}
+
+void SerialExecutorStd::Sleep() {
+  std::unique_lock<std::mutex> lock{sleep_mutex_};
+  sleeping_ = true;
+
+  auto has_work = [this] { return woken_up_ || !immediate_.empty(); };
+  absl::optional<TimePoint> next_due = schedule_.NextDue();
+  if (next_due) {
+    // Workaround for Visual Studio 2015, see `Schedule::PopBlocking`.
+    const auto until = std::chrono::time_point_cast<
+        std::chrono::steady_clock::duration>(next_due.value());
+    wake_up_.wait_until(lock, until, has_work);
+  } else {
+    wake_up_.wait(lock, has_work);
+  }
+
+  woken_up_ = false;
+  sleeping_ = false;
+}
+
+void SerialExecutorStd::WakeUp() {
+  std::lock_guard<std::mutex> lock{sleep_mutex_};
+  woken_up_ = true;
+  wake_up_.notify_one();
+}
+
+bool SerialExecutorStd::IsCurrentExecutor() const {
+  return std::this_thread::get_id() == worker_thread_.get_id();
+}
+
+std::string SerialExecutorStd::CurrentExecutorName() const {
+  if (IsCurrentExecutor()) {
+    return Name();
+  } else {
+    return ThreadIdToString(std::this_thread::get_id());
+  }
+}
+
+std::string SerialExecutorStd::Name() const {
+  return ThreadIdToString(worker_thread_.get_id());
+}
+
+void SerialExecutorStd::ExecuteBlocking(Operation&& operation) {
+  std::promise<void> signal_finished;
+  Execute([&] {
+    operation();
+    signal_finished.set_value();
+  });
+  signal_finished.get_future().wait();
+}
+
+bool SerialExecutorStd::IsScheduled(const Tag tag) const {
+  return schedule_.ContainsTag(tag);
+}
+
+absl::optional<Executor::TaggedOperation> SerialExecutorStd::PopFromSchedule() {
+  auto removed =
+      schedule_.RemoveIf([](const Entry& e) { return !e.IsImmediate(); });
+  if (!removed.has_value()) {
+    return {};
+  }
+  return {std::move(removed.value().tagged)};
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,160 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SERIAL_EXECUTOR_STD_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SERIAL_EXECUTOR_STD_H_
+
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "absl/types/optional.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace async {
+
+// A lock-free FIFO queue that any number of threads may push to, but only
+// a single thread may pop from (D. Vyukov's non-intrusive MPSC queue).
+//
+// `Push` is wait-free: it's a single atomic exchange. A push only becomes
+// visible to `Pop` once the pushing thread has linked it in; until then, `Pop`
+// may report the queue as empty even though the push has started.
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head_{new Node{}} {
+    tail_ = head_.load();
+  }
+
+  ~MpscQueue() {
+    while (Pop()) {
+    }
+    delete tail_;
+  }
+
+  // May be called from any thread.
+  void Push(T&& value) {
+    auto node = new Node{};
+    node->value = std::move(value);
+    Node* prev = head_.exchange(node);
+    prev->next.store(node);
+  }
+
+  // Removes the least recently pushed entry and returns it. If the queue is
+  // empty, returns an empty `optional`. Must only be called from the consumer
+  // thread.
+  absl::optional<T> Pop() {
+    Node* tail = tail_;
+    Node* next = tail->next.load();
+    if (!next) {
+      return {};
+    }
+
+    // `next` becomes the new stub node; its value is moved out.
+    T result = std::move(next->value);
+    tail_ = next;
+    delete tail;
+    return result;
+  }
+
+  // Must only be called from the consumer thread.
+  bool empty() const {
+    return tail_->next.load() == nullptr;
+  }
+
+  MpscQueue(const MpscQueue& other) = delete;
+  MpscQueue& operator=(const MpscQueue& other) = delete;
+
+ private:
+  struct Node {
+    std::atomic<Node*> next{nullptr};
+    T value;
+  };
+
+  // Producers push at the head, the consumer pops at the tail. The tail is
+  // always a stub node whose value has already been consumed.
+  std::atomic<Node*> head_;
+  Node* tail_ = nullptr;
+};
+
+}  // namespace async
+
+// A serial queue that executes provided operations on a dedicated background
+// thread, like `ExecutorStd` with a single thread.
+//
+// Operations for immediate execution, which are the vast majority, are put on
+// a lock-free queue, so threads enqueueing them don't contend with each other
+// or with the worker thread. Only delayed operations go through the
+// mutex-guarded `Schedule`, and the worker thread only takes a lock to go to
+// sleep when there is nothing to run.
+class SerialExecutorStd : public Executor {
+ public:
+  SerialExecutorStd();
+  ~SerialExecutorStd();
+
+  void Execute(Operation&& operation) override;
+  void ExecuteBlocking(Operation&& operation) override;
+
+  DelayedOperation Schedule(Milliseconds delay,
+                            TaggedOperation&& tagged) override;
+
+  bool IsCurrentExecutor() const override;
+  std::string CurrentExecutorName() const override;
+  std::string Name() const override;
+
+  bool IsScheduled(Tag tag) const override;
+  absl::optional<TaggedOperation> PopFromSchedule() override;
+
+ private:
+  using Id = ExecutorStd::Id;
+  using Entry = ExecutorStd::Entry;
+  using TimePoint = async::Schedule<Entry>::TimePoint;
+
+  void TryCancel(Id operation_id);
+  void PollingThread();
+  void Sleep();
+  void WakeUp();
+
+  // Operations scheduled for immediate execution. Always run before any due
+  // delayed operation, like in `ExecutorStd`.
+  async::MpscQueue<Operation> immediate_;
+  async::Schedule<Entry> schedule_;
+
+  // Used to put the worker thread to sleep when there is nothing to run.
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_up_;
+  std::atomic<bool> sleeping_{false};
+  bool woken_up_ = false;
+
+  std::thread worker_thread_;
+  // Used to stop the worker thread.
+  std::shared_ptr<std::atomic<bool>> shutting_down_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_SERIAL_EXECUTOR_STD_H_
@@ -32,6 +32,12 @@ std::string MakeString(CFStringRef str) {
     return {};
   }
 
+  // Strings stored as ASCII, such as most dictionary keys, expose their bytes
+  // directly, which are then also their UTF-8 encoding.
+  if (const char* ascii = CFStringGetCStringPtr(str, kCFStringEncodingASCII)) {
+    return std::string(ascii, static_cast<size_t>(num_chars));
+  }
+
   // In the first pass figure the size required. The size does not include the
   // null terminator.
   CFRange range{0, num_chars};
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_THREAD_LOCAL_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_THREAD_LOCAL_H_
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <cstdlib>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * A value of type T of which each thread has its own copy, value-initialized
+ * the first time the thread reads it.
+ *
+ * This stands in for C++11 `thread_local`, which needs iOS 9 or later while
+ * the SDK still supports iOS 8. Instances are meant to have static storage
+ * duration: the copies of threads that exit are destroyed, but the underlying
+ * key is never released.
+ *
+ * This is header-only and has no dependencies, so that Nanopb's allocation
+ * hooks can use it.
+ */
+template <typename T>
+class ThreadLocal {
+ public:
+  ThreadLocal() {
+#if defined(_WIN32)
+    index_ = FlsAlloc(&Destroy);
+    if (index_ == FLS_OUT_OF_INDEXES) std::abort();
+#else
+    if (pthread_key_create(&key_, &Destroy) != 0) std::abort();
+#endif
+  }
+
+  ThreadLocal(const ThreadLocal&) = delete;
+  ThreadLocal& operator=(const ThreadLocal&) = delete;
+
+  /** Returns the calling thread's copy of the value. */
+  T& get() {
+    T* value = static_cast<T*>(GetSpecific());
+    if (!value) {
+      value = new T();
+      SetSpecific(value);
+    }
+    return *value;
+  }
+
+ private:
+#if defined(_WIN32)
+  static void NTAPI Destroy(void* value) {
+    delete static_cast<T*>(value);
+  }
+
+  void* GetSpecific() const {
+    return FlsGetValue(index_);
+  }
+
+  void SetSpecific(void* value) {
+    FlsSetValue(index_, value);
+  }
+
+  DWORD index_;
+#else
+  static void Destroy(void* value) {
+    delete static_cast<T*>(value);
+  }
+
+  void* GetSpecific() const {
+    return pthread_getspecific(key_);
+  }
+
+  void SetSpecific(void* value) {
+    pthread_setspecific(key_, value);
+  }
+
+  pthread_key_t key_;
+#endif
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_THREAD_LOCAL_H_
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <mutex>   // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace internal {
+
+std::atomic<bool> g_trace_enabled{false};
+
+}  // namespace internal
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/** The number of most recent events kept in the buffer. */
+const size_t kTraceCapacity = 1024;
+
+struct TraceBuffer {
+  std::mutex mutex;
+  Clock::time_point start;
+  std::vector<TraceRecord> records;
+
+  /** The total number of events recorded since the trace was enabled. */
+  uint64_t count = 0;
+};
+
+TraceBuffer& GetTraceBuffer() {
+  // Intentionally leaked, so that events can still be recorded while static
+  // objects are destroyed.
+  static auto* buffer = new TraceBuffer();
+  return *buffer;
+}
+
+struct EventDescription {
+  const char* name;
+  const char* arg_names[3];
+};
+
+EventDescription Describe(TraceEvent event) {
+  switch (event) {
+    case TraceEvent::kListen:
+      return {"Listen", {"target_id", nullptr, nullptr}};
+    case TraceEvent::kStopListening:
+      return {"StopListening", {"target_id", nullptr, nullptr}};
+    case TraceEvent::kRemoteEvent:
+      return {"RemoteEvent", {"target_changes", "document_updates", nullptr}};
+    case TraceEvent::kExecuteQuery:
+      return {"ExecuteQuery", {"documents", "micros", "cached"}};
+  }
+  UNREACHABLE();
+}
+
+}  // namespace
+
+namespace internal {
+
+void TraceRecordEvent(TraceEvent event, int64_t arg0, int64_t arg1,
+                      int64_t arg2) {
+  Clock::time_point now = Clock::now();
+
+  TraceBuffer& buffer = GetTraceBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.records.empty()) {
+    // Disabled while this event was being recorded.
+    return;
+  }
+
+  TraceRecord& record = buffer.records[buffer.count % kTraceCapacity];
+  record.time_micros =
+      std::chrono::duration_cast<std::chrono::microseconds>(now - buffer.start)
+          .count();
+  record.event = event;
+  record.args[0] = arg0;
+  record.args[1] = arg1;
+  record.args[2] = arg2;
+  ++buffer.count;
+}
+
+}  // namespace internal
+
+void TraceSetEnabled(bool enabled) {
+  TraceBuffer& buffer = GetTraceBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (enabled) {
+    buffer.start = Clock::now();
+    buffer.records.assign(kTraceCapacity, TraceRecord{});
+  } else {
+    buffer.records.clear();
+    buffer.records.shrink_to_fit();
+  }
+  buffer.count = 0;
+  internal::g_trace_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::vector<TraceRecord> TraceSnapshot() {
+  TraceBuffer& buffer = GetTraceBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+
+  std::vector<TraceRecord> result;
+  if (buffer.count <= kTraceCapacity) {
+    result.assign(buffer.records.begin(),
+                  buffer.records.begin() + static_cast<size_t>(buffer.count));
+  } else {
+    auto oldest = buffer.records.begin() +
+                  static_cast<size_t>(buffer.count % kTraceCapacity);
+    result.assign(oldest, buffer.records.end());
+    result.insert(result.end(), buffer.records.begin(), oldest);
+  }
+  return result;
+}
+
+std::string TraceDump() {
+  std::string result;
+  for (const TraceRecord& record : TraceSnapshot()) {
+    EventDescription description = Describe(record.event);
+    absl::StrAppend(&result, "+", record.time_micros, "us ", description.name);
+    for (size_t i = 0; i < 3; ++i) {
+      if (description.arg_names[i]) {
+        absl::StrAppend(&result, " ", description.arg_names[i], "=",
+                        record.args[i]);
+      }
+    }
+    result += '\n';
+  }
+  return result;
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
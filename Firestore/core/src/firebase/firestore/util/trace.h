@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/**
+ * The events that can be recorded in the trace. Each event records up to three
+ * integer arguments, whose meaning is given next to the event.
+ */
+enum class TraceEvent : uint8_t {
+  /** A query started listening: target id. */
+  kListen,
+  /** The last query of a target stopped listening: target id. */
+  kStopListening,
+  /** A remote event was applied: target changes, document updates. */
+  kRemoteEvent,
+  /** A query ran against the local store: documents, microseconds, cached. */
+  kExecuteQuery,
+};
+
+/** A recorded event, with its arguments left as raw integers. */
+struct TraceRecord {
+  /** Microseconds since the trace was enabled. */
+  int64_t time_micros = 0;
+  TraceEvent event = TraceEvent::kListen;
+  int64_t args[3] = {};
+};
+
+namespace internal {
+
+extern std::atomic<bool> g_trace_enabled;
+
+void TraceRecordEvent(TraceEvent event, int64_t arg0, int64_t arg1,
+                      int64_t arg2);
+
+}  // namespace internal
+
+/**
+ * Enables or disables the trace. Enabling the trace discards any events
+ * recorded before.
+ *
+ * Unlike debug logging, the trace doesn't format anything when events are
+ * recorded: it only keeps the most recent events in a fixed-size ring buffer,
+ * to be decoded with `TraceDump` after something went wrong. This makes it
+ * cheap enough to keep enabled in production.
+ */
+void TraceSetEnabled(bool enabled);
+
+inline bool TraceIsEnabled() {
+  return internal::g_trace_enabled.load(std::memory_order_relaxed);
+}
+
+/** Records an event if the trace is enabled. */
+inline void Trace(TraceEvent event,
+                  int64_t arg0 = 0,
+                  int64_t arg1 = 0,
+                  int64_t arg2 = 0) {
+  if (TraceIsEnabled()) {
+    internal::TraceRecordEvent(event, arg0, arg1, arg2);
+  }
+}
+
+/** Returns the recorded events that are still in the buffer, oldest first. */
+std::vector<TraceRecord> TraceSnapshot();
+
+/**
+ * Decodes the recorded events that are still in the buffer into text, one
+ * event per line, oldest first.
+ */
+std::string TraceDump();
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACE_H_
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
+
+#include <mutex>  // NOLINT(build/c++11)
+
+#include "Firestore/core/src/firebase/firestore/util/thread_local.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace internal {
+
+std::atomic<bool> g_tracer_installed{false};
+
+}  // namespace internal
+
+namespace {
+
+struct TracerHolder {
+  std::mutex mutex;
+  std::shared_ptr<Tracer> tracer;
+};
+
+TracerHolder& GetTracerHolder() {
+  // Intentionally leaked, so that spans can still end while static objects
+  // are destroyed.
+  static auto* holder = new TracerHolder();
+  return *holder;
+}
+
+std::shared_ptr<Tracer> GetTracer() {
+  TracerHolder& holder = GetTracerHolder();
+  std::lock_guard<std::mutex> lock(holder.mutex);
+  return holder.tracer;
+}
+
+std::atomic<SpanId> next_span_id{1};
+
+ThreadLocal<SpanId> current_span_id;
+
+}  // namespace
+
+void SetTracer(std::shared_ptr<Tracer> tracer) {
+  TracerHolder& holder = GetTracerHolder();
+  std::lock_guard<std::mutex> lock(holder.mutex);
+  internal::g_tracer_installed.store(tracer != nullptr,
+                                     std::memory_order_relaxed);
+  holder.tracer = std::move(tracer);
+}
+
+TraceSpan::TraceSpan(const char* name) : TraceSpan(name, Current()) {
+}
+
+TraceSpan::TraceSpan(const char* name, SpanId parent_id) {
+  if (!TracerIsInstalled()) {
+    return;
+  }
+
+  tracer_ = GetTracer();
+  if (!tracer_) {
+    // Removed since the check above.
+    return;
+  }
+
+  id_ = next_span_id.fetch_add(1, std::memory_order_relaxed);
+  SpanId& current = current_span_id.get();
+  previous_ = current;
+  current = id_;
+  tracer_->BeginSpan(id_, parent_id, name);
+}
+
+TraceSpan::~TraceSpan() {
+  if (!tracer_) {
+    return;
+  }
+
+  current_span_id.get() = previous_;
+  tracer_->EndSpan(id_, attributes_);
+}
+
+SpanId TraceSpan::Current() {
+  return current_span_id.get();
+}
+
+void TraceSpan::SetAttribute(const char* key, int64_t value) {
+  if (tracer_) {
+    attributes_.emplace_back(key, std::to_string(value));
+  }
+}
+
+void TraceSpan::SetAttribute(const char* key, std::string value) {
+  if (tracer_) {
+    attributes_.emplace_back(key, std::move(value));
+  }
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACER_H_
+#define FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+/** Identifies a span. Zero means no span. */
+using SpanId = uint64_t;
+
+/** Describes a span, such as the target or batch it concerns. */
+using SpanAttributes = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * Receives the spans that cover the stages of listens and writes, for example
+ * to export them to a tracing service.
+ *
+ * Spans begin and end on any of Firestore's threads, so implementations must
+ * be thread-safe, and should return quickly.
+ */
+class Tracer {
+ public:
+  virtual ~Tracer() = default;
+
+  /**
+   * Called when a span begins. `parent_id` is the span it's part of, which
+   * may already have ended if the work continued asynchronously, or zero.
+   */
+  virtual void BeginSpan(SpanId id, SpanId parent_id, const char* name) = 0;
+
+  /** Called when a span ends, with the attributes set on it. */
+  virtual void EndSpan(SpanId id, const SpanAttributes& attributes) = 0;
+};
+
+namespace internal {
+
+extern std::atomic<bool> g_tracer_installed;
+
+}  // namespace internal
+
+/**
+ * Installs the tracer that receives all spans from now on, or removes it if
+ * `tracer` is null. Spans that already began end on the tracer they began on.
+ */
+void SetTracer(std::shared_ptr<Tracer> tracer);
+
+inline bool TracerIsInstalled() {
+  return internal::g_tracer_installed.load(std::memory_order_relaxed);
+}
+
+/**
+ * A span that lasts for the lifetime of this object, and is the current span
+ * of its thread in the meantime. Does nothing unless a tracer is installed
+ * when it's created.
+ *
+ * To connect work that continues on another thread, capture `id()` (or
+ * `Current()`) and pass it as the parent of a span created there.
+ */
+class TraceSpan {
+ public:
+  /** Begins a span that is part of the current span of this thread. */
+  explicit TraceSpan(const char* name);
+
+  /** Begins a span that is part of the given one. */
+  TraceSpan(const char* name, SpanId parent_id);
+
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  /** The innermost span that is open on this thread, or zero. */
+  static SpanId Current();
+
+  /** Whether the span is being reported to a tracer. */
+  bool active() const {
+    return tracer_ != nullptr;
+  }
+
+  SpanId id() const {
+    return id_;
+  }
+
+  void SetAttribute(const char* key, int64_t value);
+  void SetAttribute(const char* key, std::string value);
+
+ private:
+  std::shared_ptr<Tracer> tracer_;
+  SpanId id_ = 0;
+  SpanId previous_ = 0;
+  SpanAttributes attributes_;
+};
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_SRC_FIREBASE_FIRESTORE_UTIL_TRACER_H_
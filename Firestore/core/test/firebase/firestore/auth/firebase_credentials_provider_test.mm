@@ -34,6 +34,7 @@
 @property(nonatomic, nullable, strong, readonly) NSString* token;
 @property(nonatomic, nullable, strong, readonly) NSString* uid;
 @property(nonatomic, readonly) BOOL forceRefreshTriggered;
+@property(nonatomic, readonly) int tokenRequests;
 - (instancetype)initWithToken:(nullable NSString*)token
                           uid:(nullable NSString*)uid NS_DESIGNATED_INITIALIZER;
 - (instancetype)init NS_UNAVAILABLE;
@@ -61,6 +62,7 @@
 - (void)getTokenForcingRefresh:(BOOL)forceRefresh
                   withCallback:(nonnull FIRTokenCallback)callback {
   _forceRefreshTriggered = forceRefresh;
+  _tokenRequests++;
   callback(self.token, nil);
 }
 
@@ -153,6 +155,27 @@ TEST(FirebaseCredentialsProviderTest, InvalidateToken) {
   });
 }
 
+TEST(FirebaseCredentialsProviderTest, CachesToken) {
+  FIRApp* app = testutil::AppForUnitTesting();
+  FSTAuthFake* auth = [[FSTAuthFake alloc] initWithToken:@"token for fake uid"
+                                                     uid:@"fake uid"];
+  FirebaseCredentialsProvider credentials_provider(app, auth);
+  for (int i = 0; i < 2; ++i) {
+    credentials_provider.GetToken([](util::StatusOr<Token> result) {
+      EXPECT_TRUE(result.ok());
+      EXPECT_EQ("token for fake uid", result.ValueOrDie().token());
+    });
+  }
+  EXPECT_EQ(1, auth.tokenRequests);
+
+  credentials_provider.InvalidateToken();
+  credentials_provider.GetToken([](util::StatusOr<Token> result) {
+    EXPECT_TRUE(result.ok());
+  });
+  EXPECT_TRUE(auth.forceRefreshTriggered);
+  EXPECT_EQ(2, auth.tokenRequests);
+}
+
 }  // namespace auth
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/core/bulk_writer.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/src/firebase/firestore/model/delete_mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/testutil/async_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using model::Mutation;
+using testutil::Expectation;
+using util::AsyncQueue;
+using util::Executor;
+using util::Status;
+using util::StatusCallback;
+using util::TimerId;
+
+using testing::ElementsAre;
+
+using Keys = std::vector<std::string>;
+
+class BulkWriterTest : public testing::Test, public testutil::AsyncTest {
+ public:
+  BulkWriterTest()
+      : worker_queue{testutil::AsyncQueueForTesting()},
+        user_executor{testutil::ExecutorForTesting("user")} {
+    worker_queue->SkipDelaysForTimerId(TimerId::BulkWriterRetry);
+    writer = std::make_shared<BulkWriter>(
+        worker_queue, user_executor,
+        [this](const std::vector<Mutation>& mutations,
+               StatusCallback callback) {
+          Keys keys;
+          for (const Mutation& mutation : mutations) {
+            keys.push_back(mutation.key().ToString());
+          }
+          commits.push_back(keys);
+          callback(commit_status(keys));
+        });
+  }
+
+  /** Writes the document and records the outcome in `results`. */
+  void Write(const std::string& path) {
+    writer->Write({testutil::DeleteMutation(path)},
+                  [this, path](Status status) { results[path] = status; });
+  }
+
+  void FlushAndWait() {
+    Expectation flushed;
+    writer->Flush([&](Status) { flushed.Fulfill(); });
+    Await(flushed);
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue;
+  std::shared_ptr<Executor> user_executor;
+  std::shared_ptr<BulkWriter> writer;
+
+  /** Decides the outcome of each commit. Accessed on the worker queue. */
+  std::function<Status(const Keys&)> commit_status = [](const Keys&) {
+    return Status::OK();
+  };
+
+  /** The keys of the documents in each commit, in order. */
+  std::vector<Keys> commits;
+
+  /** The outcome of each write. Accessed on the user executor. */
+  std::map<std::string, Status> results;
+};
+
+TEST_F(BulkWriterTest, BatchesWritesUntilFlushed) {
+  for (int i = 0; i < 45; ++i) {
+    Write("docs/" + std::to_string(i));
+  }
+  FlushAndWait();
+
+  ASSERT_EQ(commits.size(), 3u);
+  EXPECT_EQ(commits[0].size(), BulkWriter::kMaxBatchSize);
+  EXPECT_EQ(commits[1].size(), BulkWriter::kMaxBatchSize);
+  EXPECT_EQ(commits[2].size(), 5u);
+
+  EXPECT_EQ(results.size(), 45u);
+  for (const auto& result : results) {
+    EXPECT_TRUE(result.second.ok());
+  }
+}
+
+TEST_F(BulkWriterTest, SerializesWritesToTheSameDocument) {
+  Write("docs/a");
+  Write("docs/a");
+  Write("docs/b");
+  FlushAndWait();
+
+  EXPECT_THAT(commits, ElementsAre(Keys{"docs/a"}, Keys{"docs/a", "docs/b"}));
+}
+
+TEST_F(BulkWriterTest, RetriesTransientErrors) {
+  int attempts = 0;
+  commit_status = [&](const Keys&) {
+    return ++attempts == 1 ? Status(Error::kUnavailable, "try again")
+                           : Status::OK();
+  };
+
+  Write("docs/a");
+  FlushAndWait();
+
+  EXPECT_EQ(commits.size(), 2u);
+  EXPECT_TRUE(results["docs/a"].ok());
+}
+
+TEST_F(BulkWriterTest, FailsAfterMaxAttempts) {
+  commit_status = [](const Keys&) {
+    return Status(Error::kUnavailable, "try again");
+  };
+
+  Write("docs/a");
+  FlushAndWait();
+
+  EXPECT_EQ(commits.size(), static_cast<size_t>(BulkWriter::kMaxAttempts));
+  EXPECT_EQ(results["docs/a"].code(), Error::kUnavailable);
+}
+
+TEST_F(BulkWriterTest, IsolatesPermanentErrors) {
+  commit_status = [](const Keys& keys) {
+    for (const std::string& key : keys) {
+      if (key == "docs/bad") {
+        return Status(Error::kInvalidArgument, "bad document");
+      }
+    }
+    return Status::OK();
+  };
+
+  Write("docs/a");
+  Write("docs/bad");
+  Write("docs/c");
+  FlushAndWait();
+
+  EXPECT_THAT(commits,
+              ElementsAre(Keys{"docs/a", "docs/bad", "docs/c"}, Keys{"docs/a"},
+                          Keys{"docs/bad"}, Keys{"docs/c"}));
+  EXPECT_TRUE(results["docs/a"].ok());
+  EXPECT_EQ(results["docs/bad"].code(), Error::kInvalidArgument);
+  EXPECT_TRUE(results["docs/c"].ok());
+}
+
+TEST_F(BulkWriterTest, FlushWaitsForEarlierWritesOnly) {
+  Expectation flushed;
+  writer->Flush([&](Status status) {
+    EXPECT_TRUE(status.ok());
+    flushed.Fulfill();
+  });
+  Await(flushed);
+  EXPECT_TRUE(commits.empty());
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
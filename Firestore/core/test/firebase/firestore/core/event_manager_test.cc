@@ -16,6 +16,7 @@
 
 #include "Firestore/core/src/firebase/firestore/core/event_manager.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <memory>
 #include <utility>
 #include <vector>
@@ -26,7 +27,9 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
 #include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/test/firebase/firestore/testutil/async_testing.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -42,15 +45,24 @@ using model::OnlineState;
 using testing::_;
 using testing::ElementsAre;
 using testing::StrictMock;
+using testutil::Doc;
 using testutil::Query;
 using util::StatusOr;
 using util::StatusOrCallback;
+using util::TimerId;
 
 ViewSnapshotListener NoopViewSnapshotHandler() {
   return EventListener<ViewSnapshot>::Create(
       [](const StatusOr<ViewSnapshot>&) {});
 }
 
+ViewSnapshotListener Accumulating(std::vector<ViewSnapshot>* values) {
+  return EventListener<ViewSnapshot>::Create(
+      [values](const StatusOr<ViewSnapshot>& maybe_snapshot) {
+        values->push_back(maybe_snapshot.ValueOrDie());
+      });
+}
+
 std::shared_ptr<QueryListener> NoopQueryListener(core::Query query) {
   return QueryListener::Create(std::move(query),
                                ListenOptions::DefaultOptions(),
@@ -61,7 +73,12 @@ class MockEventSource : public core::QueryEventSource {
  public:
   MOCK_METHOD1(SetCallback, void(core::SyncEngineCallback*));
   MOCK_METHOD1(Listen, model::TargetId(core::Query));
+  MOCK_METHOD1(ListenAll,
+               std::vector<model::TargetId>(const std::vector<core::Query>&));
   MOCK_METHOD1(StopListening, void(const core::Query&));
+  MOCK_METHOD1(DropDocuments, bool(const core::Query&));
+  MOCK_METHOD1(RestoreDocuments,
+               absl::optional<ViewSnapshot>(const core::Query&));
 };
 
 TEST(EventManagerTest, HandlesManyListnersPerQuery) {
@@ -84,6 +101,27 @@ TEST(EventManagerTest, HandlesManyListnersPerQuery) {
   event_manager.RemoveQueryListener(listener1);
 }
 
+TEST(EventManagerTest, ListensToNewQueriesOfABatchTogether) {
+  core::Query query1 = Query("foo/bar");
+  core::Query query2 = Query("bar/baz");
+  core::Query query3 = Query("baz/qux");
+  auto listener1 = NoopQueryListener(query1);
+
+  StrictMock<MockEventSource> mock_event_source;
+  EXPECT_CALL(mock_event_source, SetCallback(_));
+  EventManager event_manager(&mock_event_source);
+
+  EXPECT_CALL(mock_event_source, Listen(query1));
+  event_manager.AddQueryListener(listener1);
+
+  // Only queries without listeners are listened to, each of them once.
+  EXPECT_CALL(mock_event_source, ListenAll(ElementsAre(query2, query3)))
+      .WillOnce(testing::Return(std::vector<model::TargetId>{2, 3}));
+  event_manager.AddQueryListeners(
+      {NoopQueryListener(query1), NoopQueryListener(query2),
+       NoopQueryListener(query2), NoopQueryListener(query3)});
+}
+
 TEST(EventManagerTest, HandlesUnlistenOnUnknownListenerGracefully) {
   core::Query query = Query("foo/bar");
   auto listener = NoopQueryListener(query);
@@ -95,6 +133,37 @@ TEST(EventManagerTest, HandlesUnlistenOnUnknownListenerGracefully) {
   event_manager.RemoveQueryListener(listener);
 }
 
+TEST(EventManagerTest, KeepsListeningForTheLingerPeriod) {
+  core::Query query = Query("foo/bar");
+  auto listener1 = NoopQueryListener(query);
+  auto listener2 = NoopQueryListener(query);
+  auto worker_queue = testutil::AsyncQueueForTesting();
+
+  StrictMock<MockEventSource> mock_event_source;
+  EXPECT_CALL(mock_event_source, SetCallback(_));
+  EventManager event_manager(&mock_event_source);
+  event_manager.SetListenLinger(worker_queue, std::chrono::seconds(5));
+
+  EXPECT_CALL(mock_event_source, Listen(query));
+  worker_queue->EnqueueBlocking([&] {
+    event_manager.AddQueryListener(listener1);
+    event_manager.RemoveQueryListener(listener1);
+  });
+  EXPECT_TRUE(worker_queue->IsScheduled(TimerId::ListenLinger));
+
+  // Listening again while the query lingers reuses its listen.
+  worker_queue->EnqueueBlocking([&] {
+    event_manager.AddQueryListener(listener2);
+  });
+  EXPECT_FALSE(worker_queue->IsScheduled(TimerId::ListenLinger));
+
+  worker_queue->EnqueueBlocking([&] {
+    event_manager.RemoveQueryListener(listener2);
+  });
+  EXPECT_CALL(mock_event_source, StopListening(query));
+  worker_queue->RunScheduledOperationsUntil(TimerId::ListenLinger);
+}
+
 ViewSnapshot make_empty_view_snapshot(const core::Query& query) {
   DocumentSet empty_docs{query.Comparator()};
   // sync_state_changed has to be `true` to prevent an assertion about a
@@ -142,6 +211,100 @@ TEST(EventManagerTest, NotifiesListenersInTheRightOrder) {
   ASSERT_THAT(event_order, ElementsAre("listener1", "listener3", "listener2"));
 }
 
+TEST(EventManagerTest, SharesFilteredSnapshotsBetweenListeners) {
+  core::Query query = Query("foo");
+  model::Document doc1 = Doc("foo/a", 1);
+  model::Document doc2 = Doc("foo/b", 1);
+  std::vector<ViewSnapshot> accum1;
+  std::vector<ViewSnapshot> accum2;
+  std::vector<ViewSnapshot> full_accum;
+
+  auto listener1 = QueryListener::Create(query, Accumulating(&accum1));
+  auto listener2 = QueryListener::Create(query, Accumulating(&accum2));
+  auto full_listener = QueryListener::Create(
+      query, ListenOptions::FromIncludeMetadataChanges(true),
+      Accumulating(&full_accum));
+
+  MockEventSource mock_event_source;
+  EventManager event_manager(&mock_event_source);
+  event_manager.AddQueryListener(listener1);
+  event_manager.AddQueryListener(listener2);
+  event_manager.AddQueryListener(full_listener);
+
+  DocumentSet empty_docs{query.Comparator()};
+  DocumentSet docs1 = empty_docs.insert(doc1);
+  DocumentSet docs2 = docs1.insert(doc2);
+  DocumentViewChange added1{doc1, DocumentViewChange::Type::Added};
+  DocumentViewChange metadata1{doc1, DocumentViewChange::Type::Metadata};
+  DocumentViewChange added2{doc2, DocumentViewChange::Type::Added};
+
+  ViewSnapshot snapshot1{query,
+                         empty_docs,
+                         empty_docs,
+                         {added1},
+                         DocumentKeySet{},
+                         /*from_cache=*/false,
+                         /*sync_state_changed=*/true,
+                         /*excludes_metadata_changes=*/false};
+  ViewSnapshot snapshot2{query,
+                         docs2,
+                         docs1,
+                         {metadata1, added2},
+                         DocumentKeySet{},
+                         /*from_cache=*/false,
+                         /*sync_state_changed=*/false,
+                         /*excludes_metadata_changes=*/false};
+  event_manager.OnViewSnapshots({snapshot1});
+  event_manager.OnViewSnapshots({snapshot2});
+
+  ASSERT_EQ(accum1.size(), 2);
+  ASSERT_EQ(accum2.size(), 2);
+  ASSERT_EQ(full_accum.size(), 2);
+
+  EXPECT_THAT(accum1[1].document_changes(), ElementsAre(added2));
+  EXPECT_THAT(full_accum[1].document_changes(), ElementsAre(metadata1, added2));
+
+  // Both filtering listeners received the same list of changes.
+  EXPECT_EQ(&accum1[1].document_changes(), &accum2[1].document_changes());
+}
+
+TEST(EventManagerTest, DropsDocumentsWhileAllListenersOnlyReadChanges) {
+  core::Query query = Query("foo/bar");
+  ListenOptions changes_only(/*include_query_metadata_changes=*/false,
+                             /*include_document_metadata_changes=*/false,
+                             /*wait_for_sync_when_online=*/false,
+                             /*conflate_snapshots=*/false,
+                             /*changes_only=*/true);
+  std::vector<ViewSnapshot> events;
+  auto changes_listener =
+      QueryListener::Create(query, changes_only, NoopViewSnapshotHandler());
+  auto full_listener = QueryListener::Create(
+      query, ListenOptions::DefaultOptions(), Accumulating(&events));
+
+  StrictMock<MockEventSource> mock_event_source;
+  EXPECT_CALL(mock_event_source, SetCallback(_));
+  EventManager event_manager(&mock_event_source);
+
+  EXPECT_CALL(mock_event_source, Listen(query));
+  event_manager.AddQueryListener(changes_listener);
+
+  // The documents are dropped once the listener raised its first snapshot.
+  ViewSnapshot snapshot = make_empty_view_snapshot(query);
+  EXPECT_CALL(mock_event_source, DropDocuments(query))
+      .WillOnce(testing::Return(true));
+  event_manager.OnViewSnapshots({snapshot});
+
+  // A listener that needs the documents restores them.
+  EXPECT_CALL(mock_event_source, RestoreDocuments(query))
+      .WillOnce(testing::Return(snapshot));
+  event_manager.AddQueryListener(full_listener);
+  EXPECT_EQ(events.size(), 1);
+
+  EXPECT_CALL(mock_event_source, DropDocuments(query))
+      .WillOnce(testing::Return(true));
+  event_manager.RemoveQueryListener(full_listener);
+}
+
 TEST(EventManagerTest, WillForwardOnlineStateChanges) {
   core::Query query = Query("foo/bar");
 
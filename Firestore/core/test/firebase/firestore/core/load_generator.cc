@@ -0,0 +1,465 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Drives several `FirestoreClient`s against an in-process fake backend with a
+// mix of listens, writes, transactions and network toggles, and reports the
+// throughput and latency of each kind of operation.
+//
+// Usage:
+//   firebase_firestore_core_load_generator [--clients=4] [--documents=100]
+//       [--duration_s=10] [--latency_ms=0] [--persistence=memory|leveldb]
+//       [--listens=20] [--writes=60] [--transactions=15] [--toggles=5]
+//
+// The last four flags are the relative weights of the kinds of operations.
+// Each client runs one operation at a time, on a thread of its own.
+
+#include <algorithm>
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdio>
+#include <cstdlib>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/api/settings.h"
+#include "Firestore/core/src/firebase/firestore/auth/empty_credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/event_listener.h"
+#include "Firestore/core/src/firebase/firestore/core/firestore_client.h"
+#include "Firestore/core/src/firebase/firestore/core/listen_options.h"
+#include "Firestore/core/src/firebase/firestore/core/query_listener.h"
+#include "Firestore/core/src/firebase/firestore/core/transaction.h"
+#include "Firestore/core/src/firebase/firestore/core/user_data.h"
+#include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/log.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/test/firebase/firestore/remote/fake_backend.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using auth::EmptyCredentialsProvider;
+using local::LevelDbPersistence;
+using model::DatabaseId;
+using model::Document;
+using model::DocumentKey;
+using model::MaybeDocument;
+using model::Mutation;
+using remote::FakeBackend;
+using testutil::Map;
+using util::AsyncQueue;
+using util::Executor;
+using util::Status;
+using util::StatusOr;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* kCollection = "load";
+
+enum class Operation { Listen, Write, Transaction, Toggle };
+constexpr int kOperationCount = 4;
+
+const char* OperationName(Operation operation) {
+  switch (operation) {
+    case Operation::Listen:
+      return "listen";
+    case Operation::Write:
+      return "write";
+    case Operation::Transaction:
+      return "transaction";
+    case Operation::Toggle:
+      return "offline toggle";
+  }
+  return "";
+}
+
+struct Options {
+  int clients = 4;
+  int documents = 100;
+  int duration_s = 10;
+  int latency_ms = 0;
+  bool persistence = false;
+  int weights[kOperationCount] = {20, 60, 15, 5};
+};
+
+bool ParseInt(absl::string_view arg, absl::string_view name, int* value) {
+  std::string prefix = absl::StrCat("--", name, "=");
+  if (!absl::StartsWith(arg, prefix)) return false;
+  if (!absl::SimpleAtoi(arg.substr(prefix.size()), value) || *value < 0) {
+    std::fprintf(stderr, "Invalid value for --%s\n", std::string{name}.c_str());
+    std::exit(2);
+  }
+  return true;
+}
+
+Options ParseOptions(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    absl::string_view arg = argv[i];
+    if (ParseInt(arg, "clients", &options.clients) ||
+        ParseInt(arg, "documents", &options.documents) ||
+        ParseInt(arg, "duration_s", &options.duration_s) ||
+        ParseInt(arg, "latency_ms", &options.latency_ms) ||
+        ParseInt(arg, "listens", &options.weights[0]) ||
+        ParseInt(arg, "writes", &options.weights[1]) ||
+        ParseInt(arg, "transactions", &options.weights[2]) ||
+        ParseInt(arg, "toggles", &options.weights[3])) {
+      continue;
+    }
+    if (arg == "--persistence=memory" || arg == "--persistence=leveldb") {
+      options.persistence = arg == "--persistence=leveldb";
+      continue;
+    }
+    std::fprintf(stderr, "Unknown flag %s\n", argv[i]);
+    std::exit(2);
+  }
+  if (options.clients == 0 || options.documents == 0) {
+    std::fprintf(stderr, "--clients and --documents must be positive\n");
+    std::exit(2);
+  }
+  return options;
+}
+
+/** The latencies of the completed operations of one kind. */
+class OperationStats {
+ public:
+  void Add(Clock::duration latency, const Status& status) {
+    if (status.ok()) {
+      latencies_.push_back(latency);
+    } else {
+      ++errors_;
+    }
+  }
+
+  void Merge(const OperationStats& other) {
+    latencies_.insert(latencies_.end(), other.latencies_.begin(),
+                      other.latencies_.end());
+    errors_ += other.errors_;
+  }
+
+  size_t count() const {
+    return latencies_.size();
+  }
+  size_t errors() const {
+    return errors_;
+  }
+
+  /** Returns the `percentile` latency in milliseconds. Sorts the latencies. */
+  double Percentile(double percentile) {
+    if (latencies_.empty()) return 0;
+    std::sort(latencies_.begin(), latencies_.end());
+    double rank = percentile / 100 * static_cast<double>(latencies_.size() - 1);
+    auto index = static_cast<size_t>(rank);
+    return std::chrono::duration<double, std::milli>(latencies_[index]).count();
+  }
+
+ private:
+  std::vector<Clock::duration> latencies_;
+  size_t errors_ = 0;
+};
+
+using ClientStats = std::vector<OperationStats>;
+
+std::string DocumentPath(int document) {
+  return absl::StrCat(kCollection, "/doc", document);
+}
+
+/**
+ * Runs operations on one client until the deadline, one at a time, and
+ * records their latencies.
+ */
+class ClientDriver {
+ public:
+  ClientDriver(std::shared_ptr<FirestoreClient> client,
+               int index,
+               const Options& options)
+      : client_{std::move(client)},
+        index_{index},
+        options_{options},
+        random_{static_cast<std::mt19937::result_type>(index)},
+        stats_(kOperationCount) {
+  }
+
+  void Run(Clock::time_point deadline) {
+    std::discrete_distribution<int> operations(std::begin(options_.weights),
+                                               std::end(options_.weights));
+    while (Clock::now() < deadline) {
+      auto operation = static_cast<Operation>(operations(random_));
+      Clock::time_point start = Clock::now();
+      Status status = RunOperation(operation);
+      stats_[static_cast<size_t>(operation)].Add(Clock::now() - start, status);
+    }
+  }
+
+  const ClientStats& stats() const {
+    return stats_;
+  }
+
+ private:
+  Status RunOperation(Operation operation) {
+    switch (operation) {
+      case Operation::Listen:
+        return Listen();
+      case Operation::Write:
+        return Write();
+      case Operation::Transaction:
+        return RunTransaction();
+      case Operation::Toggle:
+        return ToggleNetwork();
+    }
+    return Status::OK();
+  }
+
+  int RandomDocument() {
+    return std::uniform_int_distribution<int>(0, options_.documents - 1)(
+        random_);
+  }
+
+  /** Listens to the collection until the backend has sent its result. */
+  Status Listen() {
+    auto result = std::make_shared<std::promise<Status>>();
+    auto done = std::make_shared<bool>(false);
+    // Runs on the worker queue.
+    auto listener = EventListener<ViewSnapshot>::Create(
+        [result, done](StatusOr<ViewSnapshot> snapshot) {
+          if (*done) return;
+          if (!snapshot.ok()) {
+            *done = true;
+            result->set_value(snapshot.status());
+          } else if (!snapshot.ValueOrDie().from_cache()) {
+            *done = true;
+            result->set_value(Status::OK());
+          }
+        });
+
+    std::future<Status> listened = result->get_future();
+    auto query_listener =
+        client_->ListenToQuery(testutil::Query(kCollection),
+                               ListenOptions::DefaultOptions(),
+                               ViewSnapshotSharedListener{std::move(listener)});
+    Status status = listened.get();
+    client_->RemoveListener(query_listener);
+    return status;
+  }
+
+  Status Write() {
+    std::vector<Mutation> mutations;
+    mutations.push_back(testutil::SetMutation(
+        DocumentPath(RandomDocument()),
+        Map("client", index_, "count", ++writes_)));
+
+    std::promise<Status> result;
+    client_->WriteMutations(std::move(mutations),
+                            [&result](Status status) {
+                              result.set_value(std::move(status));
+                            });
+    return result.get_future().get();
+  }
+
+  /** Increments a counter in a document, retrying on contention. */
+  Status RunTransaction() {
+    DocumentKey key = testutil::Key(DocumentPath(RandomDocument()));
+
+    auto update = [key](std::shared_ptr<Transaction> transaction,
+                        TransactionResultCallback callback) {
+      transaction->Lookup(
+          {key},
+          [transaction, key, callback](
+              const StatusOr<std::vector<MaybeDocument>>& documents) {
+            if (!documents.ok()) {
+              callback(documents.status());
+              return;
+            }
+
+            int64_t count = 0;
+            const MaybeDocument& document = documents.ValueOrDie().front();
+            if (document.is_document()) {
+              auto value = Document(document).field(testutil::Field("count"));
+              if (value && value->is_integer()) count = value->integer_value();
+            }
+            transaction->Set(
+                key, ParsedSetData{testutil::WrapObject("count", count + 1),
+                                   {}});
+            callback(Status::OK());
+          });
+    };
+
+    std::promise<Status> result;
+    client_->Transaction(5, std::move(update), [&result](Status status) {
+      result.set_value(std::move(status));
+    });
+    return result.get_future().get();
+  }
+
+  /** Takes the client offline and back online. */
+  Status ToggleNetwork() {
+    std::promise<Status> disabled;
+    client_->DisableNetwork(
+        [&disabled](Status status) { disabled.set_value(std::move(status)); });
+    Status status = disabled.get_future().get();
+    if (!status.ok()) return status;
+
+    std::promise<Status> enabled;
+    client_->EnableNetwork(
+        [&enabled](Status status) { enabled.set_value(std::move(status)); });
+    return enabled.get_future().get();
+  }
+
+  std::shared_ptr<FirestoreClient> client_;
+  int index_ = 0;
+  const Options& options_;
+  std::mt19937 random_;
+  int64_t writes_ = 0;
+  ClientStats stats_;
+};
+
+DatabaseInfo ClientDatabaseInfo(int index) {
+  return DatabaseInfo{DatabaseId{"load-generator", DatabaseId::kDefault},
+                      absl::StrCat("load-generator-", index), "localhost",
+                      false};
+}
+
+void ClearPersistence(const Options& options) {
+  if (!options.persistence) return;
+  for (int i = 0; i < options.clients; ++i) {
+    Status cleared =
+        LevelDbPersistence::ClearPersistence(ClientDatabaseInfo(i));
+    if (!cleared.ok()) {
+      std::fprintf(stderr, "Failed to clear persistence: %s\n",
+                   cleared.ToString().c_str());
+      std::exit(1);
+    }
+  }
+}
+
+void PrintReport(const Options& options,
+                 std::vector<ClientStats> client_stats,
+                 Clock::duration elapsed) {
+  double seconds = std::chrono::duration<double>(elapsed).count();
+  std::printf("%d clients, %s persistence, %d ms latency, %.1f s\n",
+              options.clients, options.persistence ? "leveldb" : "memory",
+              options.latency_ms, seconds);
+  std::printf("%-16s %8s %8s %10s %9s %9s %9s %9s\n", "operation", "count",
+              "errors", "ops/s", "p50 ms", "p90 ms", "p99 ms", "max ms");
+
+  OperationStats total;
+  for (int i = 0; i < kOperationCount; ++i) {
+    OperationStats stats;
+    for (const ClientStats& client : client_stats) {
+      stats.Merge(client[static_cast<size_t>(i)]);
+    }
+    total.Merge(stats);
+    if (stats.count() == 0 && stats.errors() == 0) continue;
+
+    std::printf("%-16s %8zu %8zu %10.1f %9.2f %9.2f %9.2f %9.2f\n",
+                OperationName(static_cast<Operation>(i)), stats.count(),
+                stats.errors(), static_cast<double>(stats.count()) / seconds,
+                stats.Percentile(50), stats.Percentile(90),
+                stats.Percentile(99), stats.Percentile(100));
+  }
+  std::printf("%-16s %8zu %8zu %10.1f %9.2f %9.2f %9.2f %9.2f\n", "total",
+              total.count(), total.errors(),
+              static_cast<double>(total.count()) / seconds,
+              total.Percentile(50), total.Percentile(90), total.Percentile(99),
+              total.Percentile(100));
+}
+
+int Run(int argc, char** argv) {
+  Options options = ParseOptions(argc, argv);
+  util::LogSetLevel(util::kLogLevelWarning);
+  ClearPersistence(options);
+
+  auto backend = std::make_shared<FakeBackend>(
+      std::chrono::milliseconds(options.latency_ms));
+  api::Settings settings;
+  settings.set_persistence_enabled(options.persistence);
+
+  std::vector<std::shared_ptr<FirestoreClient>> clients;
+  for (int i = 0; i < options.clients; ++i) {
+    clients.push_back(FirestoreClient::Create(
+        ClientDatabaseInfo(i), settings,
+        std::make_shared<EmptyCredentialsProvider>(),
+        Executor::CreateSerial("com.google.firebase.firestore.load.user"),
+        AsyncQueue::Create(
+            Executor::CreateSerial("com.google.firebase.firestore.load")),
+        [backend](const DatabaseInfo& database_info,
+                  const std::shared_ptr<AsyncQueue>& worker_queue,
+                  std::shared_ptr<auth::CredentialsProvider> credentials) {
+          return backend->CreateDatastore(database_info, worker_queue,
+                                          std::move(credentials));
+        }));
+  }
+
+  std::vector<std::unique_ptr<ClientDriver>> drivers;
+  for (int i = 0; i < options.clients; ++i) {
+    drivers.push_back(absl::make_unique<ClientDriver>(clients[i], i, options));
+  }
+
+  Clock::time_point start = Clock::now();
+  Clock::time_point deadline = start + std::chrono::seconds(options.duration_s);
+  std::vector<std::thread> threads;
+  for (auto& driver : drivers) {
+    ClientDriver* raw_driver = driver.get();
+    threads.emplace_back([raw_driver, deadline] { raw_driver->Run(deadline); });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  Clock::duration elapsed = Clock::now() - start;
+
+  for (const auto& client : clients) {
+    client->Terminate();
+  }
+
+  std::vector<ClientStats> client_stats;
+  for (const auto& driver : drivers) {
+    client_stats.push_back(driver->stats());
+  }
+  PrintReport(options, std::move(client_stats), elapsed);
+
+  drivers.clear();
+  clients.clear();
+  ClearPersistence(options);
+  return 0;
+}
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
+
+int main(int argc, char** argv) {
+  return firebase::firestore::core::Run(argc, argv);
+}
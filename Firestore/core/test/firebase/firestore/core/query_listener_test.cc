@@ -26,6 +26,7 @@
 #include "Firestore/core/src/firebase/firestore/core/view.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
@@ -209,6 +210,117 @@ TEST_F(QueryListenerTest, MutingAsyncListenerPreventsAllSubsequentEvents) {
   ASSERT_THAT(accum, ElementsAre(view_snapshot1));
 }
 
+TEST_F(QueryListenerTest, ConflatesSnapshotsWaitingForTheExecutor) {
+  std::vector<ViewSnapshot> accum;
+
+  Query query = testutil::Query("rooms");
+  Document doc1 = Doc("rooms/Eros", 1, Map("name", "Eros"));
+  Document doc2 = Doc("rooms/Hades", 2, Map("name", "Hades"));
+  Document doc3 = Doc("rooms/Other", 3, Map("name", "Other"));
+  Document doc2prime =
+      Doc("rooms/Hades", 4, Map("name", "Hades", "owner", "Jonny"));
+
+  auto listener = AsyncEventListener<ViewSnapshot>::Create(
+      _executor, Accumulating(&accum));
+  listener->ConflateEvents(ViewSnapshot::Merge);
+
+  View view(query, DocumentKeySet{});
+  ViewSnapshot snap1 = ApplyChanges(&view, {doc1, doc2}, absl::nullopt).value();
+  ViewSnapshot snap2 =
+      ApplyChanges(&view, {doc2prime, doc3}, absl::nullopt).value();
+  ViewSnapshot snap3 =
+      ApplyChanges(&view, {testutil::DeletedDoc("rooms/Other", 5)},
+                   absl::nullopt)
+          .value();
+
+  // Hold the executor so that all snapshots are raised before any is
+  // delivered.
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  _executor->Execute([released] { released.wait(); });
+
+  listener->OnEvent(snap1);
+  listener->OnEvent(snap2);
+  listener->OnEvent(snap3);
+  release.set_value();
+
+  Expectation drained;
+  _executor->Execute(drained.AsCallback());
+  Await(drained);
+
+  // Changes to the same document are merged, and doc3 was both added and
+  // removed before the listener saw it.
+  DocumentViewChange change1{doc1, DocumentViewChange::Type::Added};
+  DocumentViewChange change2{doc2prime, DocumentViewChange::Type::Added};
+
+  ASSERT_EQ(accum.size(), 1);
+  const ViewSnapshot& merged = accum[0];
+  ASSERT_EQ(merged.documents(), snap3.documents());
+  ASSERT_EQ(merged.old_documents(), snap1.old_documents());
+  ASSERT_THAT(merged.document_changes(), ElementsAre(change1, change2));
+}
+
+TEST_F(QueryListenerTest, DoesNotConflateSnapshotsAcrossErrors) {
+  std::vector<ViewSnapshot> accum;
+  std::vector<Status> errors;
+
+  Query query = testutil::Query("rooms");
+  Document doc1 = Doc("rooms/Eros", 1, Map("name", "Eros"));
+  Document doc2 = Doc("rooms/Hades", 2, Map("name", "Hades"));
+
+  auto listener = AsyncEventListener<ViewSnapshot>::Create(
+      _executor, EventListener<ViewSnapshot>::Create(
+                     [&](const StatusOr<ViewSnapshot>& maybe_snapshot) {
+                       if (maybe_snapshot.ok()) {
+                         accum.push_back(maybe_snapshot.ValueOrDie());
+                       } else {
+                         errors.push_back(maybe_snapshot.status());
+                       }
+                     }));
+  listener->ConflateEvents(ViewSnapshot::Merge);
+
+  View view(query, DocumentKeySet{});
+  ViewSnapshot snap1 = ApplyChanges(&view, {doc1}, absl::nullopt).value();
+  ViewSnapshot snap2 = ApplyChanges(&view, {doc2}, absl::nullopt).value();
+  Status error{Error::kUnknown, "Some error"};
+
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  _executor->Execute([released] { released.wait(); });
+
+  listener->OnEvent(snap1);
+  listener->OnEvent(error);
+  listener->OnEvent(snap2);
+  release.set_value();
+
+  Expectation drained;
+  _executor->Execute(drained.AsCallback());
+  Await(drained);
+
+  ASSERT_THAT(accum, ElementsAre(snap1, snap2));
+  ASSERT_THAT(errors, ElementsAre(error));
+}
+
+TEST_F(QueryListenerTest, RaisesEventsInlineWithoutAnExecutor) {
+  std::vector<ViewSnapshot> accum;
+
+  Query query = testutil::Query("rooms");
+  Document doc1 = Doc("rooms/Eros", 1, Map("name", "Eros"));
+
+  auto listener =
+      AsyncEventListener<ViewSnapshot>::Create(nullptr, Accumulating(&accum));
+
+  View view(query, DocumentKeySet{});
+  ViewSnapshot snap1 = ApplyChanges(&view, {doc1}, absl::nullopt).value();
+
+  listener->OnEvent(snap1);
+  ASSERT_THAT(accum, ElementsAre(snap1));
+
+  listener->Mute();
+  listener->OnEvent(snap1);
+  ASSERT_THAT(accum, ElementsAre(snap1));
+}
+
 TEST_F(QueryListenerTest, DoesNotRaiseEventsForMetadataChangesUnlessSpecified) {
   std::vector<ViewSnapshot> filtered_accum;
   std::vector<ViewSnapshot> full_accum;
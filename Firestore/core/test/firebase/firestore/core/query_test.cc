@@ -22,6 +22,7 @@
 #include "Firestore/core/src/firebase/firestore/core/field_filter.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
@@ -36,6 +37,7 @@ namespace core {
 using firebase::firestore::util::ComparisonResult;
 using model::Document;
 using model::DocumentComparator;
+using model::FieldMask;
 using model::FieldPath;
 using model::FieldValue;
 using model::ResourcePath;
@@ -259,6 +261,53 @@ TEST(QueryTest, InFiltersWithObjectValues) {
   EXPECT_THAT(query, Matches(doc));
 }
 
+TEST(QueryTest, InFiltersWithManyValues) {
+  auto query = testutil::Query("collection")
+                   .AddingFilter(Filter("zip", "in",
+                                        Array("a", 1, 2.5, NAN, Map("b", 2))));
+
+  EXPECT_THAT(query, Matches(Doc("collection/1", 0, Map("zip", "a"))));
+  EXPECT_THAT(query, Matches(Doc("collection/1", 0, Map("zip", 1))));
+  EXPECT_THAT(query, Matches(Doc("collection/1", 0, Map("zip", 2.5))));
+  EXPECT_THAT(query, Matches(Doc("collection/1", 0, Map("zip", NAN))));
+  EXPECT_THAT(query, Matches(Doc("collection/1", 0, Map("zip", Map("b", 2)))));
+
+  // Values that compare the same but are of different types don't match.
+  EXPECT_THAT(query, Not(Matches(Doc("collection/1", 0, Map("zip", 1.0)))));
+  EXPECT_THAT(query, Not(Matches(Doc("collection/1", 0, Map("zip", "b")))));
+}
+
+TEST(QueryTest, MatchesSeveralFiltersOnOneMap) {
+  auto query = testutil::Query("collection")
+                   .AddingFilter(Filter("x", ">=", 0))
+                   .AddingFilter(Filter("a.b.d", "in", Array(2, 3)))
+                   .AddingFilter(Filter("a.e", "array_contains", 4))
+                   .AddingFilter(Filter("a.b.c", "==", 1));
+
+  EXPECT_THAT(query, Matches(Doc("collection/1", 0,
+                                 Map("a", Map("b", Map("c", 1, "d", 3), "e",
+                                              Array(4, 5)),
+                                     "x", 1))));
+
+  // Missing a field of the map.
+  EXPECT_THAT(query,
+              Not(Matches(Doc("collection/1", 0,
+                              Map("a", Map("b", Map("c", 1), "e", Array(4)),
+                                  "x", 1)))));
+
+  // The map is not a map.
+  EXPECT_THAT(query, Not(Matches(Doc("collection/1", 0,
+                                     Map("a", Map("b", 1, "e", Array(4)), "x",
+                                         1)))));
+
+  // A field outside the map doesn't match.
+  EXPECT_THAT(query, Not(Matches(Doc("collection/1", 0,
+                                     Map("a",
+                                         Map("b", Map("c", 1, "d", 2), "e",
+                                             Array(4)),
+                                         "x", -1)))));
+}
+
 TEST(QueryTest, ArrayContainsAnyFilters) {
   auto query =
       testutil::Query("collection")
@@ -711,6 +760,71 @@ TEST(QueryTest, CanonicalIDs) {
                                      "desc|lb:b:OAK1000|ub:a:SFO2000"));
 }
 
+TEST(QueryTest, CanonicalIDsIncludeProjection) {
+  auto projection = testutil::Query("coll").WithProjection(
+      FieldMask{Field("b"), Field("a.c")});
+  EXPECT_THAT(projection, HasCanonicalId("coll|f:|ob:__name__asc|p:a.c,b,"));
+
+  auto limit = projection.WithLimitToLast(1);
+  EXPECT_THAT(limit,
+              HasCanonicalId("coll|f:|ob:__name__desc|l:1|lt:l|p:a.c,b,"));
+}
+
+TEST(QueryTest, ProjectionIsLocalOnly) {
+  auto base_query = testutil::Query("coll");
+  auto projection = base_query.WithProjection(FieldMask{Field("a")});
+
+  EXPECT_NE(projection, base_query);
+  EXPECT_NE(projection, base_query.WithProjection(FieldMask{Field("b")}));
+  EXPECT_EQ(projection, base_query.WithProjection(FieldMask{Field("a")}));
+  EXPECT_EQ(projection.ToTarget(), base_query.ToTarget());
+
+  // Builders keep the projection.
+  auto filtered = projection.AddingFilter(Filter("b", "==", 1));
+  ASSERT_TRUE(filtered.has_projection());
+  EXPECT_EQ(*filtered.projection(), FieldMask{Field("a")});
+}
+
+TEST(QueryTest, HashIsConsistentAcrossCopies) {
+  auto query = testutil::Query("coll").AddingFilter(Filter("a", ">", 1));
+  size_t hash = query.Hash();
+
+  // Copies share the memoized Target and hash.
+  auto copy = query;
+  EXPECT_EQ(copy, query);
+  EXPECT_EQ(copy.Hash(), hash);
+  EXPECT_EQ(copy.ToTarget().Hash(), query.ToTarget().Hash());
+
+  // An equal query built separately hashes the same.
+  auto rebuilt = testutil::Query("coll").AddingFilter(Filter("a", ">", 1));
+  EXPECT_EQ(rebuilt, query);
+  EXPECT_EQ(rebuilt.Hash(), hash);
+
+  // The projection and limit type are hashed along with the Target.
+  auto projection = query.WithProjection(FieldMask{Field("a")});
+  EXPECT_NE(projection.Hash(), hash);
+  EXPECT_EQ(projection.ToTarget().Hash(), query.ToTarget().Hash());
+}
+
+TEST(QueryTest, ProjectsDocumentsToReadFields) {
+  auto query = testutil::Query("coll")
+                   .AddingFilter(Filter("a", ">", 1))
+                   .AddingOrderBy(OrderBy("a"))
+                   .AddingOrderBy(OrderBy("__name__"))
+                   .WithProjection(FieldMask{Field("b.c")});
+  EXPECT_EQ(query.ReadMask(), (FieldMask{Field("a"), Field("b.c")}));
+
+  Document doc = Doc("coll/1", 1000,
+                     Map("a", 2, "b", Map("c", 3, "d", 4), "e", Map("f", 5)));
+  Document projected = query.Project(doc);
+  EXPECT_EQ(projected, Doc("coll/1", 1000, Map("a", 2, "b", Map("c", 3))));
+  EXPECT_TRUE(query.Matches(projected));
+
+  auto unprojected = testutil::Query("coll");
+  EXPECT_FALSE(unprojected.has_projection());
+  EXPECT_EQ(unprojected.Project(doc), doc);
+}
+
 TEST(QueryTest, MatchesAllDocuments) {
   auto base_query = testutil::Query("coll");
   EXPECT_TRUE(base_query.MatchesAllDocuments());
@@ -734,6 +848,28 @@ TEST(QueryTest, MatchesAllDocuments) {
   EXPECT_FALSE(query.MatchesAllDocuments());
 }
 
+TEST(QueryTest, KeyOrderedQueriesExposeBoundKeys) {
+  auto base_query = testutil::Query("coll");
+  EXPECT_TRUE(base_query.IsKeyOrdered());
+  EXPECT_EQ(base_query.StartKey(), absl::nullopt);
+  EXPECT_EQ(base_query.EndKey(), absl::nullopt);
+
+  auto query = base_query.AddingOrderBy(OrderBy("__name__"))
+                   .StartingAt(Bound({Ref("project", "coll/b")}, true))
+                   .EndingAt(Bound({Ref("project", "coll/d")}, false));
+  EXPECT_TRUE(query.IsKeyOrdered());
+  EXPECT_EQ(query.StartKey(), testutil::Key("coll/b"));
+  EXPECT_EQ(query.EndKey(), testutil::Key("coll/d"));
+
+  query = base_query.AddingOrderBy(OrderBy("__name__", "desc"));
+  EXPECT_FALSE(query.IsKeyOrdered());
+
+  query = base_query.AddingOrderBy(OrderBy("foo"))
+              .StartingAt(Bound({Value("SFO")}, true));
+  EXPECT_FALSE(query.IsKeyOrdered());
+  EXPECT_EQ(query.StartKey(), absl::nullopt);
+}
+
 }  // namespace core
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 Google
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/target_cost.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+
+using testutil::Array;
+using testutil::Doc;
+using testutil::Map;
+
+namespace {
+
+TargetCost Cost(model::TargetId target_id,
+                int64_t bytes_retained,
+                int64_t documents_scanned,
+                int64_t micros) {
+  TargetCost cost;
+  cost.target_id = target_id;
+  cost.bytes_retained = bytes_retained;
+  cost.documents_scanned = documents_scanned;
+  cost.query_time = TargetCost::Duration(micros);
+  return cost;
+}
+
+std::vector<model::TargetId> TargetIds(const std::vector<TargetCost>& costs) {
+  std::vector<model::TargetId> result;
+  for (const TargetCost& cost : costs) {
+    result.push_back(cost.target_id);
+  }
+  return result;
+}
+
+}  // namespace
+
+TEST(TargetCostTest, TotalTimeAddsUpTheParts) {
+  TargetCost cost;
+  cost.query_time = TargetCost::Duration(1);
+  cost.view_time = TargetCost::Duration(20);
+  cost.snapshot_time = TargetCost::Duration(300);
+  EXPECT_EQ(TargetCost::Duration(321), cost.total_time());
+}
+
+TEST(TargetCostTest, RanksByTheGivenMeasure) {
+  std::vector<TargetCost> costs = {Cost(1, 300, 10, 2), Cost(2, 100, 30, 1),
+                                   Cost(3, 200, 20, 3)};
+
+  EXPECT_EQ(
+      (std::vector<model::TargetId>{1, 3, 2}),
+      TargetIds(TopTargetCosts(costs, 3, TargetCostOrder::BytesRetained)));
+  EXPECT_EQ(
+      (std::vector<model::TargetId>{2, 3, 1}),
+      TargetIds(TopTargetCosts(costs, 3, TargetCostOrder::DocumentsScanned)));
+  EXPECT_EQ((std::vector<model::TargetId>{3, 1, 2}),
+            TargetIds(TopTargetCosts(costs, 3, TargetCostOrder::TotalTime)));
+}
+
+TEST(TargetCostTest, KeepsOnlyTheMostExpensive) {
+  std::vector<TargetCost> costs = {Cost(1, 300, 0, 0), Cost(2, 100, 0, 0),
+                                   Cost(3, 200, 0, 0)};
+
+  EXPECT_EQ(
+      (std::vector<model::TargetId>{1, 3}),
+      TargetIds(TopTargetCosts(costs, 2, TargetCostOrder::BytesRetained)));
+  EXPECT_EQ(3u,
+            TopTargetCosts(costs, 10, TargetCostOrder::BytesRetained).size());
+  EXPECT_TRUE(TopTargetCosts(costs, 0, TargetCostOrder::BytesRetained).empty());
+}
+
+TEST(TargetCostTest, EstimatesGrowWithTheData) {
+  int64_t empty = EstimateByteSize(Doc("coll/doc", 1, Map()));
+  int64_t small = EstimateByteSize(Doc("coll/doc", 1, Map("a", "b")));
+  int64_t large = EstimateByteSize(
+      Doc("coll/doc", 1,
+          Map("a", std::string(1000, 'x'), "b", Map("c", Array(1, 2, 3)))));
+  int64_t long_key = EstimateByteSize(Doc("coll/a-much-longer-id", 1, Map()));
+
+  EXPECT_GT(empty, 0);
+  EXPECT_GT(small, empty);
+  EXPECT_GT(large, small + 1000);
+  EXPECT_GT(long_key, empty);
+}
+
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/core/view.h"
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace core {
+namespace {
+
+using model::Document;
+using model::DocumentKeySet;
+using model::MaybeDocumentMap;
+
+using testutil::Doc;
+using testutil::Map;
+
+Document BenchmarkDoc(int index, int64_t version) {
+  return Doc(absl::StrCat("coll/doc", index), version,
+             Map("index", index, "even", index % 2 == 0));
+}
+
+MaybeDocumentMap BenchmarkDocs(int count, int64_t version) {
+  MaybeDocumentMap docs;
+  for (int i = 0; i < count; ++i) {
+    Document doc = BenchmarkDoc(i, version);
+    docs = docs.insert(doc.key(), doc);
+  }
+  return docs;
+}
+
+core::Query BenchmarkQuery() {
+  return testutil::Query("coll")
+      .AddingFilter(testutil::Filter("even", "==", true))
+      .AddingOrderBy(testutil::OrderBy("index", "desc"));
+}
+
+/** Computes the changes for the initial results of a query. */
+void BM_ComputeInitialDocumentChanges(benchmark::State& state) {
+  auto size = static_cast<int>(state.range(0));
+  View view{BenchmarkQuery(), DocumentKeySet{}};
+  MaybeDocumentMap docs = BenchmarkDocs(size, 1);
+
+  for (auto _ : state) {
+    ViewDocumentChanges changes = view.ComputeDocumentChanges(docs);
+    benchmark::DoNotOptimize(changes);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ComputeInitialDocumentChanges)->Range(10, 10000);
+
+/** Computes the changes when every document in a populated view changes. */
+void BM_ComputeUpdatedDocumentChanges(benchmark::State& state) {
+  auto size = static_cast<int>(state.range(0));
+  View view{BenchmarkQuery(), DocumentKeySet{}};
+  view.ApplyChanges(view.ComputeDocumentChanges(BenchmarkDocs(size, 1)));
+  MaybeDocumentMap updates = BenchmarkDocs(size, 2);
+
+  for (auto _ : state) {
+    ViewDocumentChanges changes = view.ComputeDocumentChanges(updates);
+    benchmark::DoNotOptimize(changes);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ComputeUpdatedDocumentChanges)->Range(10, 10000);
+
+}  // namespace
+}  // namespace core
+}  // namespace firestore
+}  // namespace firebase
@@ -126,6 +126,49 @@ TEST(ViewSnapshotTest, ViewSnapshotConstructor) {
   ASSERT_EQ(snapshot.sync_state_changed(), sync_state_changed);
 }
 
+TEST(ViewSnapshotTest, FromChangeSetSortsChangesByTypeAndQueryOrder) {
+  Query query = testutil::Query("a");
+  DocumentSet old_documents = DocumentSet{DocumentComparator::ByKey()};
+  DocumentSet documents = old_documents;
+
+  Document doc1 = Doc("a/1", 1, Map());
+  Document doc2 = Doc("a/2", 1, Map());
+  Document doc3 = Doc("a/3", 1, Map());
+  Document doc4 = Doc("a/4", 1, Map());
+  documents = documents.insert(doc1).insert(doc3).insert(doc4);
+
+  DocumentViewChangeSet changes;
+  changes.AddChange(DocumentViewChange{doc4, Type::Metadata});
+  changes.AddChange(DocumentViewChange{doc3, Type::Added});
+  changes.AddChange(DocumentViewChange{doc2, Type::Removed});
+  changes.AddChange(DocumentViewChange{doc1, Type::Added});
+
+  ViewSnapshot snapshot = ViewSnapshot::FromChangeSet(
+      query, documents, old_documents, changes, DocumentKeySet{},
+      /*from_cache=*/false, /*sync_state_changed=*/false,
+      /*excludes_metadata_changes=*/false);
+  ASSERT_EQ(snapshot.document_change_count(), 4);
+
+  std::vector<DocumentViewChange> expected{
+      DocumentViewChange{doc2, Type::Removed},
+      DocumentViewChange{doc1, Type::Added},
+      DocumentViewChange{doc3, Type::Added},
+      DocumentViewChange{doc4, Type::Metadata}};
+  ASSERT_EQ(snapshot.document_changes(), expected);
+
+  ViewSnapshot filtered = snapshot.ExcludingMetadataChanges();
+  ASSERT_EQ(filtered.document_change_count(), 3);
+  expected.pop_back();
+  ASSERT_EQ(filtered.document_changes(), expected);
+
+  size_t visited = 0;
+  filtered.ForEachDocumentChange([&](const DocumentViewChange& change) {
+    ASSERT_NE(change.type(), Type::Metadata);
+    ++visited;
+  });
+  ASSERT_EQ(visited, 3);
+}
+
 }  // namespace core
 }  // namespace firestore
 }  // namespace firebase
@@ -23,7 +23,9 @@
 #include "Firestore/core/src/firebase/firestore/core/view.h"
 #include "Firestore/core/src/firebase/firestore/core/view_snapshot.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_mask.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
@@ -38,8 +40,10 @@ namespace core {
 
 using model::Document;
 using model::DocumentKeySet;
+using model::DocumentMap;
 using model::DocumentSet;
 using model::DocumentState;
+using model::FieldMask;
 using model::FieldValue;
 using model::ResourcePath;
 
@@ -156,6 +160,78 @@ TEST(ViewTest, ReturnsNilIfThereAreNoChanges) {
   ASSERT_FALSE(snapshot.has_value());
 }
 
+TEST(ViewTest, IgnoresChangesOutsideProjection) {
+  Query query = QueryForMessages()
+                    .AddingOrderBy(OrderBy("sort"))
+                    .WithProjection(FieldMask{Field("text")});
+  View view(query, DocumentKeySet{});
+
+  Document doc1 =
+      Doc("rooms/eros/messages/1", 0, Map("text", "msg1", "sort", 1, "x", 1));
+  Document projected_doc1 =
+      Doc("rooms/eros/messages/1", 0, Map("text", "msg1", "sort", 1));
+
+  ViewSnapshot snapshot = ApplyChanges(&view, {doc1}, absl::nullopt).value();
+  ASSERT_THAT(snapshot.documents(), ElementsAre(projected_doc1));
+
+  // Only a field outside the projection changed.
+  Document new_doc1 =
+      Doc("rooms/eros/messages/1", 1, Map("text", "msg1", "sort", 1, "x", 2));
+  absl::optional<ViewSnapshot> no_change =
+      ApplyChanges(&view, {new_doc1}, absl::nullopt);
+  ASSERT_FALSE(no_change.has_value());
+
+  // Fields read by the ordering stay visible.
+  Document newer_doc1 =
+      Doc("rooms/eros/messages/1", 2, Map("text", "msg1", "sort", 2, "x", 2));
+  snapshot = ApplyChanges(&view, {newer_doc1}, absl::nullopt).value();
+  ASSERT_THAT(snapshot.documents(),
+              ElementsAre(Doc("rooms/eros/messages/1", 2,
+                              Map("text", "msg1", "sort", 2))));
+}
+
+TEST(ViewTest, DropsDocumentContentsAndComparesByVersion) {
+  Query query = QueryForMessages().AddingOrderBy(OrderBy("sort"));
+  View view(query, DocumentKeySet{});
+
+  Document doc1 = Doc("rooms/eros/messages/1", 1, Map("text", "a", "sort", 1));
+  Document doc2 = Doc("rooms/eros/messages/2", 1, Map("text", "b", "sort", 2));
+  ApplyChanges(&view, {doc1, doc2}, AckTarget({doc1, doc2}));
+
+  view.DropDocuments();
+  ASSERT_FALSE(view.retains_documents());
+  ASSERT_THAT(view.documents(),
+              ElementsAre(Doc("rooms/eros/messages/1", 1, Map("sort", 1)),
+                          Doc("rooms/eros/messages/2", 1, Map("sort", 2))));
+
+  // The same version of a document has the same contents.
+  ASSERT_FALSE(ApplyChanges(&view, {doc1}, absl::nullopt).has_value());
+
+  // Changes still carry the full documents.
+  Document new_doc1 =
+      Doc("rooms/eros/messages/1", 2, Map("text", "c", "sort", 1));
+  ViewSnapshot snapshot =
+      ApplyChanges(&view, {new_doc1}, absl::nullopt).value();
+  ASSERT_TRUE((snapshot.document_changes() ==
+               std::vector<DocumentViewChange>{DocumentViewChange{
+                   new_doc1, DocumentViewChange::Type::Modified}}));
+
+  // Documents with pending writes are kept whole.
+  Document doc3 = Doc("rooms/eros/messages/3", 1, Map("text", "d", "sort", 3),
+                      DocumentState::kLocalMutations);
+  ApplyChanges(&view, {doc3}, absl::nullopt);
+  ASSERT_EQ(view.documents().GetDocument(doc3.key()), doc3);
+
+  DocumentMap local_documents;
+  for (const Document& doc : {new_doc1, doc2, doc3}) {
+    local_documents = local_documents.insert(doc.key(), doc);
+  }
+  snapshot = view.RestoreDocuments(local_documents);
+  ASSERT_TRUE(view.retains_documents());
+  ASSERT_THAT(view.documents(), ElementsAre(new_doc1, doc2, doc3));
+  ASSERT_THAT(snapshot.documents(), ElementsAre(new_doc1, doc2, doc3));
+}
+
 TEST(ViewTest, DoesNotReturnNilForFirstChanges) {
   Query query = QueryForMessages();
   View view(query, DocumentKeySet{});
@@ -536,6 +612,156 @@ TEST(ViewTest, HandlesApplyingIrrelevantDocs) {
   view.ApplyChanges(changes);
 }
 
+TEST(ViewTest, KeepsOverflowDocsAfterRefill) {
+  Query query =
+      QueryForMessages().AddingOrderBy(OrderBy("order")).WithLimitToFirst(2);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map("order", 1));
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map("order", 2));
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map("order", 3));
+  Document doc4 = Doc("rooms/eros/messages/3", 0, Map("order", 4));
+  View view(query, DocumentKeySet{});
+
+  // The initial results are not known to be complete past the limit.
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc1, doc2, doc3, doc4}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc1, doc2}));
+  ASSERT_TRUE(changes.overflow_document_set().empty());
+  view.ApplyChanges(changes);
+
+  // Remove one of the docs and refill from the local cache.
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/0")}));
+  ASSERT_TRUE(changes.needs_refill());
+  changes =
+      view.ComputeDocumentChanges(DocUpdates({doc2, doc3, doc4}), changes);
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc2, doc3}));
+  ASSERT_THAT(changes.overflow_document_set(), ContainsDocs({doc4}));
+  ASSERT_FALSE(changes.needs_refill());
+  view.ApplyChanges(changes);
+
+  // Removing another doc now pulls in the overflow doc without a refill.
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/1")}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc3, doc4}));
+  ASSERT_TRUE(changes.overflow_document_set().empty());
+  ASSERT_FALSE(changes.needs_refill());
+  ASSERT_THAT(
+      changes.change_set().GetChanges(),
+      ElementsAre(DocumentViewChange{doc2, DocumentViewChange::Type::Removed},
+                  DocumentViewChange{doc4, DocumentViewChange::Type::Added}));
+  view.ApplyChanges(changes);
+
+  // With the overflow used up, the next removal needs a refill again.
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/2")}));
+  ASSERT_TRUE(changes.needs_refill());
+}
+
+TEST(ViewTest, KeepsDocsPushedOutOfLimitAsOverflow) {
+  Query query =
+      QueryForMessages().AddingOrderBy(OrderBy("order")).WithLimitToFirst(2);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map("order", 1));
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map("order", 3));
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map("order", 2));
+  View view(query, DocumentKeySet{});
+
+  view.ApplyChanges(view.ComputeDocumentChanges(DocUpdates({doc1, doc2})));
+
+  // Add a doc that pushes doc2 out of the limit.
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc3}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc1, doc3}));
+  ASSERT_THAT(changes.overflow_document_set(), ContainsDocs({doc2}));
+  view.ApplyChanges(changes);
+
+  // Moving a doc past the overflow doc brings the overflow doc back.
+  doc1 = Doc("rooms/eros/messages/0", 1, Map("order", 10));
+  changes = view.ComputeDocumentChanges(DocUpdates({doc1}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc3, doc2}));
+  ASSERT_TRUE(changes.overflow_document_set().empty());
+  ASSERT_FALSE(changes.needs_refill());
+  ASSERT_THAT(
+      changes.change_set().GetChanges(),
+      ElementsAre(DocumentViewChange{doc1, DocumentViewChange::Type::Removed},
+                  DocumentViewChange{doc2, DocumentViewChange::Type::Added}));
+}
+
+TEST(ViewTest, KeepsOverflowDocsForLimitToLast) {
+  Query query =
+      QueryForMessages().AddingOrderBy(OrderBy("order")).WithLimitToLast(2);
+  Document doc1 = Doc("rooms/eros/messages/0", 0, Map("order", 1));
+  Document doc2 = Doc("rooms/eros/messages/1", 0, Map("order", 2));
+  Document doc3 = Doc("rooms/eros/messages/2", 0, Map("order", 3));
+  Document doc4 = Doc("rooms/eros/messages/3", 0, Map("order", 4));
+  View view(query, DocumentKeySet{});
+
+  view.ApplyChanges(view.ComputeDocumentChanges(DocUpdates({doc2, doc3})));
+
+  // Add a doc that pushes doc2 out of the limit.
+  ViewDocumentChanges changes =
+      view.ComputeDocumentChanges(DocUpdates({doc4}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc3, doc4}));
+  ASSERT_THAT(changes.overflow_document_set(), ContainsDocs({doc2}));
+  view.ApplyChanges(changes);
+
+  // A new doc past the overflow doc is dropped, since the local cache may
+  // contain docs in between.
+  changes = view.ComputeDocumentChanges(DocUpdates({doc1}));
+  ASSERT_THAT(changes.overflow_document_set(), ContainsDocs({doc2}));
+  ASSERT_EQ(0, changes.change_set().GetChanges().size());
+  view.ApplyChanges(changes);
+
+  changes = view.ComputeDocumentChanges(
+      DocUpdates({DeletedDoc("rooms/eros/messages/3")}));
+  ASSERT_THAT(changes.document_set(), ContainsDocs({doc2, doc3}));
+  ASSERT_FALSE(changes.needs_refill());
+}
+
+TEST(ViewTest, ComputesLocalSnapshotLikeANewView) {
+  Query query = QueryForMessages()
+                    .AddingFilter(Filter("sort", "<=", 2))
+                    .AddingOrderBy(OrderBy("sort"))
+                    .WithLimitToFirst(2);
+  Document doc1 = Doc("rooms/eros/messages/1", 0, Map("sort", 1),
+                      DocumentState::kLocalMutations);
+  Document doc2 = Doc("rooms/eros/messages/2", 0, Map("sort", 2));
+  Document doc3 = Doc("rooms/eros/messages/3", 0, Map("sort", 0));
+  Document doc4 = Doc("rooms/eros/messages/4", 0, Map("sort", 3));
+
+  DocumentMap documents;
+  for (const Document& doc : {doc1, doc2, doc3, doc4}) {
+    documents = documents.insert(doc.key(), doc);
+  }
+
+  View view(query, DocumentKeySet{});
+  ViewSnapshot expected =
+      ApplyChanges(&view, {doc1, doc2, doc3, doc4}, absl::nullopt).value();
+  ViewSnapshot snapshot = View::ComputeLocalSnapshot(query, documents);
+
+  ASSERT_EQ(snapshot.query(), query);
+  ASSERT_THAT(snapshot.documents(), ElementsAre(doc3, doc1));
+  ASSERT_EQ(snapshot.documents(), expected.documents());
+  ASSERT_EQ(snapshot.mutated_keys(), expected.mutated_keys());
+  ASSERT_TRUE(snapshot.from_cache());
+  ASSERT_TRUE(snapshot.has_pending_writes());
+}
+
+TEST(ViewTest, ComputesSnapshotOfServerDocuments) {
+  Query query = QueryForMessages();
+  Document doc1 = Doc("rooms/eros/messages/1", 1, Map());
+  Document doc2 = Doc("rooms/eros/messages/2", 1, Map());
+  DocumentMap documents;
+  documents = documents.insert(doc2.key(), doc2);
+  documents = documents.insert(doc1.key(), doc1);
+
+  ViewSnapshot snapshot =
+      View::ComputeLocalSnapshot(query, documents, /*from_cache=*/false);
+
+  ASSERT_THAT(snapshot.documents(), ElementsAre(doc1, doc2));
+  ASSERT_FALSE(snapshot.from_cache());
+  ASSERT_FALSE(snapshot.has_pending_writes());
+}
+
 TEST(ViewTest, ComputesMutatedKeys) {
   Query query = QueryForMessages();
   Document doc1 = Doc("rooms/eros/messages/0", 0, Map());
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "Firestore/core/test/firebase/firestore/immutable/testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace immutable {
+namespace impl {
+
+using IntMap = BTreeSortedMap<int, int>;
+using Node = IntMap::node_type;
+using SizeType = SortedMapBase::size_type;
+
+namespace {
+
+/**
+ * Verifies the structural invariants of the subtree rooted at the given node
+ * and returns its height.
+ */
+int CheckNode(const Node& node, bool is_root) {
+  if (!is_root) {
+    EXPECT_GE(node.entry_count(), Node::kMinEntries);
+  }
+  EXPECT_LE(node.entry_count(), Node::kMaxEntries);
+  EXPECT_GT(node.entry_count(), 0u);
+
+  for (SizeType i = 1; i < node.entry_count(); ++i) {
+    EXPECT_LT(node.entry(i - 1).first, node.entry(i).first);
+  }
+
+  if (node.leaf()) {
+    EXPECT_EQ(node.entry_count(), node.size());
+    return 1;
+  }
+
+  SizeType size = node.entry_count();
+  int height = -1;
+  for (SizeType i = 0; i <= node.entry_count(); ++i) {
+    const Node& child = node.child(i);
+    if (i > 0) {
+      EXPECT_LT(node.entry(i - 1).first, child.entry(0).first);
+    }
+    if (i < node.entry_count()) {
+      EXPECT_LT(child.entry(child.entry_count() - 1).first,
+                node.entry(i).first);
+    }
+
+    int child_height = CheckNode(child, false);
+    if (height == -1) {
+      height = child_height;
+    }
+    EXPECT_EQ(height, child_height) << "All leaves must be at the same depth";
+    size += child.size();
+  }
+  EXPECT_EQ(size, node.size());
+  return height + 1;
+}
+
+int CheckInvariants(const IntMap& map) {
+  if (map.empty()) {
+    EXPECT_EQ(nullptr, map.root());
+    return 0;
+  }
+  return CheckNode(*map.root(), true);
+}
+
+}  // namespace
+
+TEST(BTreeSortedMap, EmptySize) {
+  IntMap map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(0u, map.size());
+  EXPECT_EQ(nullptr, map.root());
+  EXPECT_EQ(map.begin(), map.end());
+  EXPECT_EQ(map.end(), map.max());
+}
+
+TEST(BTreeSortedMap, SplitsRoot) {
+  IntMap map = ToMap<IntMap>(Sequence(Node::kMaxEntries));
+  ASSERT_TRUE(map.root()->leaf());
+
+  map = map.insert(Node::kMaxEntries, 0);
+  EXPECT_FALSE(map.root()->leaf());
+  EXPECT_EQ(1u, map.root()->entry_count());
+  EXPECT_EQ(2, CheckInvariants(map));
+}
+
+TEST(BTreeSortedMap, CollapsesRoot) {
+  IntMap map = ToMap<IntMap>(Sequence(Node::kMaxEntries + 1));
+  ASSERT_FALSE(map.root()->leaf());
+
+  map = map.erase(0);
+  EXPECT_TRUE(map.root()->leaf());
+  EXPECT_EQ(1, CheckInvariants(map));
+}
+
+TEST(BTreeSortedMap, InsertIsImmutable) {
+  IntMap original = ToMap<IntMap>(Sequence(500));
+  IntMap modified = original.insert(1000, 1000).erase(250);
+
+  EXPECT_EQ(500u, original.size());
+  EXPECT_TRUE(Found(original, 250, 250));
+  EXPECT_TRUE(NotFound(original, 1000));
+  EXPECT_SEQ_EQ(Pairs(Sequence(500)), original);
+  CheckInvariants(original);
+  CheckInvariants(modified);
+}
+
+TEST(BTreeSortedMap, MaintainsInvariantsWhileShrinking) {
+  std::vector<int> values = Shuffled(Sequence(3000));
+  IntMap map = ToMap<IntMap>(values);
+  EXPECT_EQ(3, CheckInvariants(map));
+
+  std::vector<int> to_remove = Shuffled(values);
+  for (size_t i = 0; i < to_remove.size(); ++i) {
+    map = map.erase(to_remove[i]);
+    if (i % 97 == 0) {
+      CheckInvariants(map);
+    }
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(BTreeSortedMap, FromSortedRange) {
+  for (int n : {0, 1, 32, 33, 34, 66, 67, 1088, 1089, 5000}) {
+    std::vector<std::pair<int, int>> pairs = Pairs(Sequence(n));
+    IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end(), {});
+
+    EXPECT_EQ(static_cast<SizeType>(n), map.size());
+    EXPECT_SEQ_EQ(pairs, map);
+    CheckInvariants(map);
+
+    // Trees built in bulk must remain valid under further mutation.
+    std::vector<int> to_remove = Shuffled(Sequence(n));
+    for (int i : to_remove) {
+      map = map.erase(i);
+    }
+    EXPECT_TRUE(map.empty());
+  }
+}
+
+TEST(BTreeSortedMap, FindIndexMatchesPosition) {
+  IntMap map = ToMap<IntMap>(Shuffled(Sequence(0, 4000, 2)));
+  for (int i = 0; i < 4000; ++i) {
+    SizeType expected =
+        i % 2 == 0 ? static_cast<SizeType>(i / 2) : IntMap::npos;
+    ASSERT_EQ(expected, map.find_index(i)) << "key " << i;
+  }
+}
+
+TEST(BTreeSortedMap, LowerBound) {
+  IntMap map = ToMap<IntMap>(Sequence(0, 2000, 10));
+  for (int key = -5; key < 2000; key += 3) {
+    auto found = map.lower_bound(key);
+    int expected = ((std::max(key, 0) + 9) / 10) * 10;
+    if (expected >= 2000) {
+      ASSERT_EQ(map.end(), found);
+    } else {
+      ASSERT_EQ(expected, found->first) << "key " << key;
+    }
+  }
+  EXPECT_EQ(1990, map.max()->first);
+}
+
+TEST(BTreeSortedMap, MatchesStdMap) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> keys(0, 1999);
+  std::uniform_int_distribution<int> ops(0, 2);
+
+  IntMap map;
+  std::map<int, int> expected;
+  for (int i = 0; i < 20000; ++i) {
+    int key = keys(rng);
+    if (ops(rng) == 0) {
+      map = map.erase(key);
+      expected.erase(key);
+    } else {
+      map = map.insert(key, i);
+      expected[key] = i;
+    }
+    ASSERT_EQ(expected.size(), map.size());
+  }
+
+  CheckInvariants(map);
+  EXPECT_EQ((std::vector<std::pair<int, int>>{expected.begin(),
+                                               expected.end()}),
+            Collect(map));
+}
+
+}  // namespace impl
+}  // namespace immutable
+}  // namespace firestore
+}  // namespace firebase
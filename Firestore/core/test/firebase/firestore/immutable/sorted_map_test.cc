@@ -30,6 +30,7 @@
 #include <utility>
 
 #include "Firestore/core/src/firebase/firestore/immutable/array_sorted_map.h"
+#include "Firestore/core/src/firebase/firestore/immutable/btree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/immutable/tree_sorted_map.h"
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 
@@ -53,6 +54,18 @@ struct TestPolicy<impl::ArraySortedMap<int, int>> {
   static const SizeType kLargeSize = SortedMapBase::kFixedSize;
 };
 
+template <>
+struct TestPolicy<SortedMap<int, int>> {
+  // Large enough to pass through all three representations.
+  static const SizeType kLargeSize = 2 * SortedMapBase::kMaxTreeSize;
+};
+
+template <>
+struct TestPolicy<impl::BTreeSortedMap<int, int>> {
+  // Large enough for the tree to have at least three levels.
+  static const SizeType kLargeSize = 2000;
+};
+
 template <typename IntMap>
 class SortedMapTest : public ::testing::Test {
  public:
@@ -68,7 +81,8 @@ class SortedMapTest : public ::testing::Test {
 // NOLINTNEXTLINE: must be a typedef for the gtest macros
 typedef ::testing::Types<SortedMap<int, int>,
                          impl::ArraySortedMap<int, int>,
-                         impl::TreeSortedMap<int, int>>
+                         impl::TreeSortedMap<int, int>,
+                         impl::BTreeSortedMap<int, int>>
     TestedTypes;
 TYPED_TEST_SUITE(SortedMapTest, TestedTypes);
 
@@ -225,6 +239,22 @@ TYPED_TEST(SortedMapTest, InsertionAndRemovalOfMaxItems) {
   ASSERT_EQ(0u, map.size()) << "Check we removed all of the items";
 }
 
+TYPED_TEST(SortedMapTest, FromSortedRange) {
+  int n = this->large_number();
+  for (int size : {0, 1, n / 2, n}) {
+    std::vector<std::pair<int, int>> pairs = Pairs(Sequence(size));
+    TypeParam map = TypeParam::FromSortedRange(pairs.begin(), pairs.end(), {});
+    ASSERT_EQ(static_cast<SizeType>(size), map.size());
+    ASSERT_SEQ_EQ(pairs, map);
+
+    for (int i : Shuffled(Sequence(size))) {
+      ASSERT_TRUE(Found(map, i, i));
+      map = map.erase(i);
+    }
+    ASSERT_TRUE(map.empty());
+  }
+}
+
 TYPED_TEST(SortedMapTest, EraseDoesNotInvalidateIterators) {
   std::vector<int> keys = Sequence(1, 4);
   TypeParam original = ToMap<TypeParam>(keys);
@@ -472,6 +502,64 @@ TYPED_TEST(SortedMapTest, KeysIn) {
   ASSERT_SEQ_EQ(Seq(8, 14), map.keys_in(7, 13));   // in between to in between
 }
 
+TEST(SortedMapTransientTest, MatchesPersistentEdits) {
+  using IntMap = SortedMap<int, int>;
+  for (int size : {0, 5, 100, 2 * static_cast<int>(IntMap::kMaxTreeSize)}) {
+    std::vector<int> keys = Shuffled(Sequence(size));
+    IntMap expected;
+    IntMap::Transient transient;
+    for (int key : keys) {
+      expected = expected.insert(key, key);
+      transient.insert(key, key);
+      ASSERT_EQ(expected.size(), transient.size());
+    }
+    for (int key : Sequence(0, size, 3)) {
+      expected = expected.erase(key);
+      transient.erase(key);
+      ASSERT_FALSE(transient.contains(key));
+    }
+
+    IntMap actual = std::move(transient).freeze();
+    ASSERT_EQ(Collect(expected), Collect(actual));
+    for (int key : keys) {
+      ASSERT_EQ(expected.get(key), actual.get(key));
+    }
+  }
+}
+
+TEST(SortedMapTransientTest, LeavesOriginalUnchanged) {
+  using IntMap = SortedMap<int, int>;
+  IntMap original = ToMap<IntMap>(Sequence(0, 200, 2));
+
+  IntMap::Transient transient{original};
+  for (int i : Sequence(200)) {
+    if (i % 2 == 0) {
+      transient.erase(i);
+    } else {
+      transient.insert(i, i);
+    }
+  }
+  IntMap edited = std::move(transient).freeze();
+
+  ASSERT_SEQ_EQ(Pairs(Sequence(0, 200, 2)), original);
+  ASSERT_SEQ_EQ(Pairs(Sequence(1, 200, 2)), edited);
+}
+
+TEST(SortedMapTransientTest, ErasingEverythingYieldsAnEmptyMap) {
+  using IntMap = SortedMap<int, int>;
+  IntMap::Transient transient{ToMap<IntMap>(Sequence(100))};
+  for (int i : Shuffled(Sequence(100))) {
+    transient.erase(i);
+  }
+  EXPECT_TRUE(transient.empty());
+
+  IntMap map = std::move(transient).freeze();
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.begin(), map.end());
+  map = map.insert(1, 1);
+  EXPECT_TRUE(Found(map, 1, 1));
+}
+
 }  // namespace immutable
 }  // namespace firestore
 }  // namespace firebase
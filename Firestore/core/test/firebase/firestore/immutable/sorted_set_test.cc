@@ -77,6 +77,36 @@ TEST(SortedSetTest, Size) {
   }
 }
 
+TEST(SortedSetTest, FromSortedRange) {
+  for (int size : {0, 10, kLargeNumber, 10 * kLargeNumber}) {
+    std::vector<int> values = Sequence(size);
+    SortedSet<int> set =
+        SortedSet<int>::FromSortedRange(values.begin(), values.end());
+    ASSERT_EQ(static_cast<SizeType>(size), set.size());
+    ASSERT_SEQ_EQ(values, set);
+    ASSERT_EQ(ToSet(values), set);
+  }
+}
+
+TEST(SortedSetTest, Transient) {
+  SortedSet<int> original = ToSet(Sequence(0, kLargeNumber, 2));
+
+  SortedSet<int>::Transient transient{original};
+  for (int i : Shuffled(Sequence(kLargeNumber))) {
+    if (i % 2 == 0) {
+      transient.erase(i);
+    } else {
+      transient.insert(i);
+    }
+  }
+  EXPECT_FALSE(transient.contains(0));
+  EXPECT_TRUE(transient.contains(1));
+  SortedSet<int> edited = std::move(transient).freeze();
+
+  ASSERT_SEQ_EQ(Sequence(0, kLargeNumber, 2), original);
+  ASSERT_SEQ_EQ(Sequence(1, kLargeNumber, 2), edited);
+}
+
 TEST(SortedSetSet, Find) {
   SortedSet<int> set = SortedSet<int>{}.insert(1).insert(2).insert(4);
 
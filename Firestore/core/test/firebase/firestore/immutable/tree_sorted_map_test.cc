@@ -29,6 +29,31 @@ namespace impl {
 
 using IntMap = TreeSortedMap<int, int>;
 
+namespace {
+
+/**
+ * Verifies that the subtree rooted at the given node is a valid left-leaning
+ * red-black tree and returns its black height.
+ */
+int CheckNode(const IntMap::node_type& node) {
+  if (node.empty()) {
+    return 1;
+  }
+
+  EXPECT_FALSE(node.right().red()) << "Red nodes must lean left";
+  if (node.red()) {
+    EXPECT_FALSE(node.left().red()) << "Red nodes must not be adjacent";
+  }
+  EXPECT_EQ(node.left().size() + 1 + node.right().size(), node.size());
+
+  int left_height = CheckNode(node.left());
+  int right_height = CheckNode(node.right());
+  EXPECT_EQ(left_height, right_height);
+  return left_height + (node.red() ? 0 : 1);
+}
+
+}  // namespace
+
 TEST(TreeSortedMap, EmptySize) {
   IntMap map;
   EXPECT_TRUE(map.empty());
@@ -223,6 +248,77 @@ TEST(TreeSortedMap, InsertIsImmutable) {
   EXPECT_TRUE(original.root().right().empty());
 }
 
+TEST(TreeSortedMap, FromSortedRangeIsBalanced) {
+  for (int n = 0; n < 300; ++n) {
+    std::vector<std::pair<int, int>> pairs = Pairs(Sequence(n));
+    IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end(), {});
+
+    ASSERT_EQ(static_cast<size_t>(n), map.size());
+    ASSERT_SEQ_EQ(pairs, map);
+    EXPECT_FALSE(map.root().red());
+    CheckNode(map.root());
+  }
+}
+
+TEST(TreeSortedMap, FromSortedRangeSupportsMutation) {
+  std::vector<std::pair<int, int>> pairs = Pairs(Sequence(0, 200, 2));
+  IntMap map = IntMap::FromSortedRange(pairs.begin(), pairs.end(), {});
+
+  for (int i : Shuffled(Sequence(1, 200, 2))) {
+    map = map.insert(i, i);
+  }
+  CheckNode(map.root());
+  ASSERT_SEQ_EQ(Pairs(Sequence(200)), map);
+
+  for (int i : Shuffled(Sequence(200))) {
+    map = map.erase(i);
+    CheckNode(map.root());
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(TreeSortedMap, InPlaceEditsKeepTreeBalanced) {
+  IntMap map;
+  for (int i : Shuffled(Sequence(200))) {
+    map.insert_in_place(i, i);
+    CheckNode(map.root());
+    EXPECT_FALSE(map.root().red());
+  }
+  ASSERT_SEQ_EQ(Pairs(Sequence(200)), map);
+
+  for (int i : Shuffled(Sequence(200))) {
+    map.erase_in_place(i);
+    CheckNode(map.root());
+  }
+  EXPECT_TRUE(map.empty());
+}
+
+TEST(TreeSortedMap, InPlaceEditsDoNotAffectCopies) {
+  std::vector<std::pair<int, int>> pairs = Pairs(Sequence(0, 100, 2));
+  IntMap original = IntMap::FromSortedRange(pairs.begin(), pairs.end(), {});
+
+  IntMap edited = original;
+  for (int i : Shuffled(Sequence(100))) {
+    if (i % 2 == 0) {
+      edited.erase_in_place(i);
+    } else {
+      edited.insert_in_place(i, i);
+    }
+  }
+  CheckNode(edited.root());
+  ASSERT_SEQ_EQ(Pairs(Sequence(1, 100, 2)), edited);
+  ASSERT_SEQ_EQ(pairs, original);
+  CheckNode(original.root());
+}
+
+TEST(TreeSortedMap, EraseInPlaceAcceptsKeysFromTheMap) {
+  IntMap map = IntMap::Create(Pairs(Sequence(50)), {});
+  while (!map.empty()) {
+    map.erase_in_place(map.root().key());
+    CheckNode(map.root());
+  }
+}
+
 TEST(TreeSortedMap, InitializerIsSorted) {
   IntMap map = IntMap::Create(
       std::vector<IntMap::value_type>{{3, 0}, {2, 0}, {1, 0}}, {});
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/bundle_loader.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/order_by.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/index_free_query_engine.h"
+#include "Firestore/core/src/firebase/firestore/local/local_store.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/query_result.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using auth::User;
+using core::Query;
+using model::DatabaseId;
+using model::Document;
+using model::DocumentKeySet;
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Key;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Version;
+using util::StatusOr;
+
+class BundleLoaderTest : public testing::Test {
+ protected:
+  BundleLoaderTest()
+      : persistence_(MemoryPersistenceWithLruGcForTesting()),
+        local_store_(persistence_.get(), &query_engine_,
+                     User::Unauthenticated()),
+        builder_(database_id_, Version(10)) {
+    local_store_.Start();
+  }
+
+  /** Feeds the bundle to a loader a few bytes at a time. */
+  StatusOr<std::vector<NamedQuery>> Load(const std::string& bundle) {
+    BundleLoader loader(&local_store_, database_id_);
+    for (size_t i = 0; i < bundle.size(); i += 7) {
+      if (!loader.AddChunk(absl::string_view(bundle).substr(i, 7)).ok()) {
+        break;
+      }
+    }
+    return loader.Finish();
+  }
+
+  QueryResult Execute(const Query& query) {
+    return local_store_.ExecuteQuery(query, /* use_previous_results= */ true);
+  }
+
+  DatabaseId database_id_{"p", "d"};
+  std::unique_ptr<MemoryPersistence> persistence_;
+  IndexFreeQueryEngine query_engine_;
+  LocalStore local_store_;
+  BundleBuilder builder_;
+};
+
+TEST_F(BundleLoaderTest, LoadsDocumentsAndNamedQueries) {
+  Query query = testutil::Query("coll").AddingFilter(Filter("a", "==", 1));
+  builder_.AddNamedQuery("ones", query, Version(10));
+  Document matching = Doc("coll/1", 5, Map("a", 1));
+  builder_.AddDocument(matching);
+  builder_.AddDocument(Doc("coll/2", 5, Map("a", 2)));
+  builder_.AddDocument(Doc("other/1", 5, Map("a", 1)));
+
+  StatusOr<std::vector<NamedQuery>> named_queries = Load(builder_.bundle());
+  ASSERT_TRUE(named_queries.ok());
+  ASSERT_EQ(named_queries.ValueOrDie().size(), 1);
+  const NamedQuery& named_query = named_queries.ValueOrDie()[0];
+  EXPECT_EQ(named_query.name, "ones");
+  EXPECT_EQ(named_query.query.ToTarget(), query.ToTarget());
+  EXPECT_EQ(named_query.read_time, Version(10));
+
+  QueryResult result = Execute(query);
+  EXPECT_EQ(result.remote_keys(), DocumentKeySet{matching.key()});
+  ASSERT_EQ(result.documents().size(), 1);
+  EXPECT_EQ(Document(result.documents().underlying_map().begin()->second),
+            matching);
+
+  EXPECT_EQ(local_store_.ReadDocument(Key("other/1"))->version(), Version(5));
+}
+
+TEST_F(BundleLoaderTest, KeepsOnlyTheFirstResultsOfLimitQueries) {
+  Query query =
+      testutil::Query("coll").AddingOrderBy(OrderBy("a")).WithLimitToFirst(2);
+  builder_.AddNamedQuery("top", query, Version(10));
+  builder_.AddDocument(Doc("coll/3", 5, Map("a", 3)));
+  builder_.AddDocument(Doc("coll/1", 5, Map("a", 1)));
+  builder_.AddDocument(Doc("coll/2", 5, Map("a", 2)));
+
+  ASSERT_TRUE(Load(builder_.bundle()).ok());
+
+  EXPECT_EQ(Execute(query).remote_keys(),
+            (DocumentKeySet{Key("coll/1"), Key("coll/2")}));
+}
+
+TEST_F(BundleLoaderTest, DoesNotReplaceNewerDocuments) {
+  builder_.AddDocument(Doc("coll/1", 5, Map("a", 1)));
+  std::string old_bundle = builder_.bundle();
+
+  BundleBuilder newer(database_id_, Version(20));
+  newer.AddDocument(Doc("coll/1", 15, Map("a", 2)));
+  ASSERT_TRUE(Load(newer.bundle()).ok());
+  ASSERT_TRUE(Load(old_bundle).ok());
+
+  EXPECT_EQ(local_store_.ReadDocument(Key("coll/1"))->version(), Version(15));
+}
+
+TEST_F(BundleLoaderTest, RejectsIncompleteBundles) {
+  builder_.AddDocument(Doc("coll/1", 5, Map("a", 1)));
+  const std::string& bundle = builder_.bundle();
+
+  EXPECT_FALSE(Load(bundle.substr(0, bundle.size() - 1)).ok());
+  EXPECT_FALSE(Load("").ok());
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/cost_based_query_engine.h"
+
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/local_documents_view.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+using auth::User;
+using model::Document;
+using model::DocumentKeySet;
+using model::DocumentMap;
+using model::SnapshotVersion;
+using testutil::Doc;
+using testutil::Field;
+using testutil::Filter;
+using testutil::Map;
+using testutil::Query;
+using testutil::Resource;
+using testutil::Version;
+
+const Document kDocA = Doc("coll/a", 1, Map("matches", true, "order", 1));
+const Document kDocB = Doc("coll/b", 1, Map("matches", false, "order", 2));
+const Document kDocC = Doc("coll/c", 1, Map("matches", true, "order", 3));
+
+const SnapshotVersion kLastLimboFreeSnapshot = Version(10);
+
+/** Records whether the last query re-used previous results. */
+class RecordingLocalDocumentsView : public LocalDocumentsView {
+ public:
+  using LocalDocumentsView::LocalDocumentsView;
+
+  DocumentMap GetDocumentsMatchingQuery(
+      const core::Query& query,
+      const SnapshotVersion& since_read_time) override {
+    used_previous_results = since_read_time != SnapshotVersion::None();
+    return LocalDocumentsView::GetDocumentsMatchingQuery(query,
+                                                         since_read_time);
+  }
+
+  bool used_previous_results = false;
+};
+
+}  // namespace
+
+class CostBasedQueryEngineTest : public ::testing::Test {
+ public:
+  CostBasedQueryEngineTest()
+      : persistence_(MemoryPersistence::WithEagerGarbageCollector()),
+        index_manager_(absl::make_unique<MemoryIndexManager>()),
+        local_documents_view_(
+            persistence_->remote_document_cache(),
+            persistence_->GetMutationQueueForUser(User::Unauthenticated()),
+            index_manager_.get()) {
+    query_engine_.SetLocalDocumentsView(&local_documents_view_);
+  }
+
+  void AddDocuments(const std::vector<Document>& docs) {
+    persistence_->Run("AddDocuments", [&] {
+      for (const Document& doc : docs) {
+        persistence_->remote_document_cache()->Add(doc, doc.version());
+      }
+    });
+  }
+
+  DocumentMap RunQuery(const core::Query& query,
+                       const SnapshotVersion& last_limbo_free_snapshot_version,
+                       const std::vector<Document>& previous_results) {
+    DocumentKeySet remote_keys;
+    for (const Document& doc : previous_results) {
+      remote_keys = remote_keys.insert(doc.key());
+    }
+    return persistence_->Run("RunQuery", [&] {
+      return query_engine_.GetDocumentsMatchingQuery(
+          query, last_limbo_free_snapshot_version, remote_keys);
+    });
+  }
+
+  bool UsedPreviousResults() const {
+    return local_documents_view_.used_previous_results;
+  }
+
+ protected:
+  std::unique_ptr<Persistence> persistence_;
+  std::unique_ptr<MemoryIndexManager> index_manager_;
+  RecordingLocalDocumentsView local_documents_view_;
+  CostBasedQueryEngine query_engine_;
+};
+
+TEST_F(CostBasedQueryEngineTest, CollectsStatisticsDuringFullScans) {
+  AddDocuments({kDocA, kDocB, kDocC});
+  EXPECT_EQ(query_engine_.GetStatistics(Resource("coll")), nullptr);
+
+  core::Query query = Query("coll").AddingFilter(Filter("matches", "==", true));
+  DocumentMap results = RunQuery(query, SnapshotVersion::None(), {});
+  EXPECT_EQ(results.size(), 2);
+  EXPECT_FALSE(UsedPreviousResults());
+
+  const CollectionStatistics* statistics =
+      query_engine_.GetStatistics(Resource("coll"));
+  ASSERT_NE(statistics, nullptr);
+  EXPECT_EQ(statistics->document_count(), 3);
+  EXPECT_EQ(statistics->DistinctValues(Field("matches")), 2);
+  EXPECT_EQ(statistics->DistinctValues(Field("order")), 3);
+  EXPECT_EQ(statistics->DistinctValues(Field("missing")), 0);
+}
+
+TEST_F(CostBasedQueryEngineTest, ReusesPreviousResultsOfSmallTargets) {
+  AddDocuments({kDocA, kDocB, kDocC});
+
+  core::Query query = Query("coll").AddingFilter(Filter("matches", "==", true));
+  DocumentMap results = RunQuery(query, kLastLimboFreeSnapshot, {kDocA});
+  EXPECT_TRUE(UsedPreviousResults());
+  EXPECT_EQ(query_engine_.last_path(), QueryEngine::Path::PreviousResults);
+  EXPECT_TRUE(results.underlying_map().contains(kDocA.key()));
+}
+
+TEST_F(CostBasedQueryEngineTest, ScansSmallCollections) {
+  AddDocuments({kDocA, kDocB, kDocC});
+
+  // Learn the collection size first.
+  RunQuery(Query("coll"), SnapshotVersion::None(), {});
+
+  core::Query query = Query("coll").AddingFilter(Filter("order", ">", 1));
+  DocumentMap results =
+      RunQuery(query, kLastLimboFreeSnapshot, {kDocA, kDocB, kDocC});
+  EXPECT_FALSE(UsedPreviousResults());
+  EXPECT_EQ(query_engine_.last_path(), QueryEngine::Path::FullScan);
+  EXPECT_EQ(results.size(), 2);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
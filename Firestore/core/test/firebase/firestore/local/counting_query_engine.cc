@@ -93,6 +93,11 @@ void WrappedMutationQueue::RemoveMutationBatch(
   subject_->RemoveMutationBatch(batch);
 }
 
+void WrappedMutationQueue::ReplaceLastMutationBatch(
+    const model::MutationBatch& batch) {
+  subject_->ReplaceLastMutationBatch(batch);
+}
+
 std::vector<model::MutationBatch> WrappedMutationQueue::AllMutationBatches() {
   auto result = subject_->AllMutationBatches();
   query_engine_->mutations_read_by_key_ += result.size();
@@ -138,6 +143,18 @@ model::BatchId WrappedMutationQueue::GetHighestUnacknowledgedBatchId() {
   return subject_->GetHighestUnacknowledgedBatchId();
 }
 
+uint64_t WrappedMutationQueue::GetChangeCount() {
+  return subject_->GetChangeCount();
+}
+
+size_t WrappedMutationQueue::GetBatchCount() {
+  return subject_->GetBatchCount();
+}
+
+int64_t WrappedMutationQueue::GetByteSize() {
+  return subject_->GetByteSize();
+}
+
 void WrappedMutationQueue::PerformConsistencyCheck() {
   subject_->PerformConsistencyCheck();
 }
@@ -62,6 +62,10 @@ class CountingQueryEngine : public QueryEngine {
     return query_engine_->type();
   }
 
+  Path last_path() const override {
+    return query_engine_->last_path();
+  }
+
   /**
    * Returns the number of documents returned by the RemoteDocumentCache's
    * `GetMatching()` API (since the last call to `ResetCounts()`)
@@ -135,6 +139,8 @@ class WrappedMutationQueue : public MutationQueue {
 
   void RemoveMutationBatch(const model::MutationBatch& batch) override;
 
+  void ReplaceLastMutationBatch(const model::MutationBatch& batch) override;
+
   std::vector<model::MutationBatch> AllMutationBatches() override;
 
   std::vector<model::MutationBatch> AllMutationBatchesAffectingDocumentKeys(
@@ -154,6 +160,12 @@ class WrappedMutationQueue : public MutationQueue {
 
   model::BatchId GetHighestUnacknowledgedBatchId() override;
 
+  uint64_t GetChangeCount() override;
+
+  size_t GetBatchCount() override;
+
+  int64_t GetByteSize() override;
+
   void PerformConsistencyCheck() override;
 
   nanopb::ByteString GetLastStreamToken() override;
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/document_snapshot.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/filesystem_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/status_testing.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using testutil::TestTempDir;
+using util::Filesystem;
+using util::Path;
+
+std::unique_ptr<DocumentSnapshot> OpenOrDie(const Path& path) {
+  auto opened = DocumentSnapshot::Open(path);
+  EXPECT_OK(opened.status());
+  return std::move(opened).ValueOrDie();
+}
+
+TEST(DocumentSnapshotTest, RoundTripsEntries) {
+  TestTempDir dir;
+  Path path = dir.Child("snapshot");
+
+  DocumentSnapshotWriter writer(path, 42);
+  writer.Add("a", "1");
+  writer.Add("b", "");
+  writer.Add(std::string("c\0d", 3), std::string("x\0y", 3));
+  EXPECT_OK(writer.Finish());
+
+  auto snapshot = OpenOrDie(path);
+  EXPECT_EQ(42, snapshot->generation());
+  ASSERT_EQ(3u, snapshot->size());
+  EXPECT_EQ("a", snapshot->key(0));
+  EXPECT_EQ("1", snapshot->value(0));
+  EXPECT_EQ("b", snapshot->key(1));
+  EXPECT_EQ("", snapshot->value(1));
+  EXPECT_EQ(std::string("c\0d", 3), snapshot->key(2));
+  EXPECT_EQ(std::string("x\0y", 3), snapshot->value(2));
+}
+
+TEST(DocumentSnapshotTest, OpensEmptySnapshot) {
+  TestTempDir dir;
+  Path path = dir.Child("snapshot");
+
+  DocumentSnapshotWriter writer(path, 1);
+  EXPECT_OK(writer.Finish());
+
+  auto snapshot = OpenOrDie(path);
+  EXPECT_EQ(0u, snapshot->size());
+  EXPECT_EQ(0u, snapshot->LowerBound("a"));
+}
+
+TEST(DocumentSnapshotTest, FindsLowerBound) {
+  TestTempDir dir;
+  Path path = dir.Child("snapshot");
+
+  DocumentSnapshotWriter writer(path, 1);
+  writer.Add("b", "");
+  writer.Add("d", "");
+  writer.Add("f", "");
+  EXPECT_OK(writer.Finish());
+
+  auto snapshot = OpenOrDie(path);
+  EXPECT_EQ(0u, snapshot->LowerBound(""));
+  EXPECT_EQ(0u, snapshot->LowerBound("b"));
+  EXPECT_EQ(1u, snapshot->LowerBound("c"));
+  EXPECT_EQ(1u, snapshot->LowerBound("d"));
+  EXPECT_EQ(2u, snapshot->LowerBound("e"));
+  EXPECT_EQ(3u, snapshot->LowerBound("g"));
+}
+
+TEST(DocumentSnapshotTest, ReplacesPreviousSnapshot) {
+  TestTempDir dir;
+  Path path = dir.Child("snapshot");
+
+  DocumentSnapshotWriter first(path, 1);
+  first.Add("a", "old");
+  EXPECT_OK(first.Finish());
+  auto old_snapshot = OpenOrDie(path);
+
+  DocumentSnapshotWriter second(path, 2);
+  second.Add("a", "new");
+  EXPECT_OK(second.Finish());
+  auto new_snapshot = OpenOrDie(path);
+
+  EXPECT_EQ(2, new_snapshot->generation());
+  EXPECT_EQ("new", new_snapshot->value(0));
+
+  // Previously opened snapshots are unaffected.
+  EXPECT_EQ("old", old_snapshot->value(0));
+}
+
+TEST(DocumentSnapshotTest, RejectsMissingFile) {
+  TestTempDir dir;
+  EXPECT_FALSE(DocumentSnapshot::Open(dir.Child("missing")).ok());
+}
+
+TEST(DocumentSnapshotTest, RejectsTruncatedFile) {
+  TestTempDir dir;
+  Path path = dir.Child("snapshot");
+
+  DocumentSnapshotWriter writer(path, 1);
+  writer.Add("a", "1");
+  writer.Add("b", "2");
+  EXPECT_OK(writer.Finish());
+
+  std::string contents = Filesystem::Default()->ReadFile(path).ValueOrDie();
+  for (size_t size : {size_t{0}, size_t{10}, contents.size() - 1}) {
+    std::ofstream file{path.native_value(), std::ios::binary};
+    file.write(contents.data(), static_cast<std::streamsize>(size));
+    file.close();
+
+    EXPECT_FALSE(DocumentSnapshot::Open(path).ok()) << "size " << size;
+  }
+}
+
+TEST(DocumentSnapshotTest, RejectsCorruptOffsets) {
+  TestTempDir dir;
+  Path path = dir.Child("snapshot");
+
+  DocumentSnapshotWriter writer(path, 1);
+  writer.Add("a", "1");
+  EXPECT_OK(writer.Finish());
+
+  std::string contents = Filesystem::Default()->ReadFile(path).ValueOrDie();
+
+  // The offsets table immediately precedes the 20 byte footer.
+  contents[contents.size() - 28] = 1;
+  std::ofstream file{path.native_value(), std::ios::binary};
+  file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+  file.close();
+
+  EXPECT_FALSE(DocumentSnapshot::Open(path).ok());
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/geohash.h"
+
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+namespace {
+
+/** Returns true if any of `cells` contains `point`. */
+bool Covers(const std::vector<std::string>& cells, const GeoPoint& point) {
+  std::string geohash = GeohashEncode(point);
+  for (const std::string& cell : cells) {
+    if (absl::StartsWith(geohash, cell)) return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST(GeohashTest, EncodesPoints) {
+  EXPECT_EQ(GeohashEncode(GeoPoint(57.64911, 10.40744), 11), "u4pruydqqvj");
+  EXPECT_EQ(GeohashEncode(GeoPoint(37.7749, -122.4194), 5), "9q8yy");
+  EXPECT_EQ(GeohashEncode(GeoPoint(-90, -180), 3), "000");
+  EXPECT_EQ(GeohashEncode(GeoPoint(90, 180), 3), "zzz");
+  EXPECT_EQ(GeohashEncode(GeoPoint(0, 0)).size(), kGeohashPrecision);
+}
+
+TEST(GeohashTest, NestsCellsByPrefix) {
+  GeoPoint point(37.7749, -122.4194);
+  std::string geohash = GeohashEncode(point);
+  for (size_t precision = 1; precision < kGeohashPrecision; ++precision) {
+    EXPECT_EQ(GeohashEncode(point, precision), geohash.substr(0, precision));
+  }
+}
+
+TEST(GeohashTest, CoversBoundingBoxes) {
+  GeoPoint south_west(37.70, -122.52);
+  GeoPoint north_east(37.82, -122.35);
+  std::vector<std::string> cells =
+      GeohashCoveringCells(south_west, north_east, 16);
+  ASSERT_FALSE(cells.empty());
+  EXPECT_LE(cells.size(), 16u);
+
+  for (double latitude : {37.70, 37.75, 37.82}) {
+    for (double longitude : {-122.52, -122.4, -122.35}) {
+      EXPECT_TRUE(Covers(cells, GeoPoint(latitude, longitude)));
+    }
+  }
+  EXPECT_FALSE(Covers(cells, GeoPoint(40.71, -74.0)));
+}
+
+TEST(GeohashTest, CoversBoxesAcrossTheAntimeridian) {
+  GeoPoint south_west(-20, 170);
+  GeoPoint north_east(-10, -170);
+  std::vector<std::string> cells =
+      GeohashCoveringCells(south_west, north_east, 16);
+  EXPECT_LE(cells.size(), 16u);
+
+  EXPECT_TRUE(Covers(cells, GeoPoint(-15, 175)));
+  EXPECT_TRUE(Covers(cells, GeoPoint(-15, -175)));
+  EXPECT_FALSE(Covers(cells, GeoPoint(-15, 0)));
+
+  EXPECT_TRUE(BoundingBoxContains(south_west, north_east, GeoPoint(-15, 175)));
+  EXPECT_TRUE(
+      BoundingBoxContains(south_west, north_east, GeoPoint(-15, -175)));
+  EXPECT_FALSE(BoundingBoxContains(south_west, north_east, GeoPoint(-15, 0)));
+}
+
+TEST(GeohashTest, CoversTheWorldWithFewCells) {
+  std::vector<std::string> cells =
+      GeohashCoveringCells(GeoPoint(-90, -180), GeoPoint(90, 180), 1);
+  EXPECT_EQ(cells, std::vector<std::string>{""});
+
+  EXPECT_TRUE(
+      GeohashCoveringCells(GeoPoint(10, 0), GeoPoint(-10, 0), 16).empty());
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/hot_document_cache.h"
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::Document;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+
+TEST(HotDocumentCacheTest, ReturnsCachedDocuments) {
+  HotDocumentCache cache(10);
+  Document doc = Doc("a/1", 1, Map("a", 1));
+
+  EXPECT_EQ(cache.Get(doc.key()), absl::nullopt);
+  cache.Put(doc);
+  EXPECT_EQ(cache.Get(doc.key()), doc);
+  EXPECT_EQ(cache.Get(Key("a/2")), absl::nullopt);
+
+  EXPECT_EQ(1, cache.hits());
+  EXPECT_EQ(2, cache.misses());
+}
+
+TEST(HotDocumentCacheTest, ReplacesAndInvalidates) {
+  HotDocumentCache cache(10);
+  cache.Put(Doc("a/1", 1, Map("a", 1)));
+
+  Document updated = Doc("a/1", 2, Map("a", 2));
+  cache.Put(updated);
+  EXPECT_EQ(cache.Get(updated.key()), updated);
+  EXPECT_EQ(1u, cache.size());
+
+  cache.Invalidate(updated.key());
+  EXPECT_EQ(cache.Get(updated.key()), absl::nullopt);
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(HotDocumentCacheTest, EvictsLeastRecentlyUsed) {
+  // A single shard makes eviction order predictable.
+  HotDocumentCache cache(2, /* shard_count= */ 1);
+  Document a = Doc("a/1", 1, Map());
+  Document b = Doc("a/2", 1, Map());
+  Document c = Doc("a/3", 1, Map());
+
+  cache.Put(a);
+  cache.Put(b);
+  EXPECT_EQ(cache.Get(a.key()), a);  // Makes `b` the least recently used.
+  cache.Put(c);
+
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(cache.Get(a.key()), a);
+  EXPECT_EQ(cache.Get(b.key()), absl::nullopt);
+  EXPECT_EQ(cache.Get(c.key()), c);
+}
+
+TEST(HotDocumentCacheTest, StaysWithinCapacity) {
+  HotDocumentCache cache(16, /* shard_count= */ 4);
+  for (int i = 0; i < 100; i++) {
+    cache.Put(Doc("a/" + std::to_string(i), 1, Map()));
+  }
+  EXPECT_LE(cache.size(), 16u);
+}
+
+TEST(HotDocumentCacheTest, TracksByteSize) {
+  HotDocumentCache cache(2, /* shard_count= */ 1);
+  cache.Put(Doc("a/1", 1, Map()), 10);
+  cache.Put(Doc("a/2", 1, Map()), 20);
+  EXPECT_EQ(30u, cache.byte_size());
+
+  cache.Put(Doc("a/1", 2, Map()), 15);
+  EXPECT_EQ(35u, cache.byte_size());
+
+  cache.Put(Doc("a/3", 1, Map()), 5);  // Evicts a/2.
+  EXPECT_EQ(20u, cache.byte_size());
+
+  cache.Invalidate(Key("a/1"));
+  EXPECT_EQ(5u, cache.byte_size());
+
+  EXPECT_EQ(5u, cache.Clear());
+  EXPECT_EQ(0u, cache.byte_size());
+  EXPECT_EQ(0u, cache.size());
+}
+
+TEST(HotDocumentCacheTest, ZeroCapacityDisablesCaching) {
+  HotDocumentCache cache(0);
+  Document doc = Doc("a/1", 1, Map());
+  cache.Put(doc);
+  EXPECT_EQ(cache.Get(doc.key()), absl::nullopt);
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(1, cache.misses());
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
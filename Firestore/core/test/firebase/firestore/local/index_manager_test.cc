@@ -23,14 +23,18 @@
 
 #include "Firestore/core/src/firebase/firestore/local/index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
 #include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
 namespace firestore {
 namespace local {
 
+using model::FieldIndex;
 using model::ResourcePath;
+using testutil::Field;
 
 void IndexManagerTest::AssertParents(const std::string& collection_id,
                                      std::vector<std::string> expected) {
@@ -71,6 +75,28 @@ TEST_P(IndexManagerTest, AddAndReadCollectionParentIndexEntries) {
   });
 }
 
+TEST_P(IndexManagerTest, AddAndReadFieldIndexes) {
+  IndexManager* index_manager = persistence->index_manager();
+  persistence->Run("AddAndReadFieldIndexes", [&]() {
+    FieldIndex by_a(
+        "coll",
+        {FieldIndex::Segment(Field("a"), FieldIndex::Segment::Kind::Ordered)});
+    FieldIndex by_a_and_b(
+        "coll",
+        {FieldIndex::Segment(Field("a"), FieldIndex::Segment::Kind::Ordered),
+         FieldIndex::Segment(Field("b"), FieldIndex::Segment::Kind::Contains)});
+
+    index_manager->AddFieldIndex(by_a);
+    index_manager->AddFieldIndex(by_a_and_b);
+    index_manager->AddFieldIndex(by_a);
+
+    EXPECT_EQ(index_manager->GetFieldIndexes("coll"),
+              (std::vector<FieldIndex>{by_a, by_a_and_b}));
+    EXPECT_EQ(index_manager->GetFieldIndexes("other"),
+              std::vector<FieldIndex>{});
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/index_value_writer.h"
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using model::FieldValue;
+using testutil::Array;
+using testutil::BlobValue;
+using testutil::Map;
+using testutil::Ref;
+using testutil::Value;
+
+namespace {
+
+/**
+ * Values in ascending order. Values in the same inner vector compare equal.
+ */
+std::vector<std::vector<FieldValue>> OrderedValueGroups() {
+  double nan = std::numeric_limits<double>::quiet_NaN();
+  double infinity = std::numeric_limits<double>::infinity();
+
+  return {
+      {Value(nullptr)},
+      {Value(false)},
+      {Value(true)},
+      {Value(nan)},
+      {Value(-infinity)},
+      {Value(std::numeric_limits<int64_t>::min())},
+      {Value(-1.5)},
+      {Value(-1), Value(-1.0)},
+      {Value(-0.0), Value(0.0), Value(0)},
+      {Value(std::numeric_limits<double>::min())},
+      {Value(1), Value(1.0)},
+      {Value(1.5)},
+      {Value(infinity)},
+      {Value(Timestamp(-1, 0))},
+      {Value(Timestamp(0, 0))},
+      {Value(Timestamp(0, 1))},
+      {Value(Timestamp(1, 0))},
+      {Value("")},
+      {Value("a")},
+      {Value(std::string("a\0", 2))},
+      {Value("ab")},
+      {Value("b")},
+      {BlobValue()},
+      {BlobValue(0)},
+      {BlobValue(0, 1)},
+      {BlobValue(255)},
+      {Ref("p", "coll/a")},
+      {Ref("p", "coll/a/sub/a")},
+      {Ref("p", "coll/b")},
+      {Value(GeoPoint(-90, 0))},
+      {Value(GeoPoint(0, -180))},
+      {Value(GeoPoint(0, 0))},
+      {Value(GeoPoint(90, 180))},
+      {Array()},
+      {Array(nullptr)},
+      {Array(1, 2)},
+      {Array(1, 2, 3)},
+      {Array(1, 3)},
+      {Array("a")},
+      {Value(Map())},
+      {Value(Map("a", 1))},
+      {Value(Map("a", 1, "b", 2))},
+      {Value(Map("a", 2))},
+      {Value(Map("b", 1))},
+  };
+}
+
+}  // namespace
+
+TEST(IndexValueWriterTest, PreservesValueOrder) {
+  std::vector<std::vector<FieldValue>> groups = OrderedValueGroups();
+  for (size_t i = 0; i < groups.size(); ++i) {
+    for (const FieldValue& left : groups[i]) {
+      for (size_t j = 0; j < groups.size(); ++j) {
+        for (const FieldValue& right : groups[j]) {
+          std::string encoded_left = EncodeIndexValue(left);
+          std::string encoded_right = EncodeIndexValue(right);
+          if (i < j) {
+            EXPECT_LT(encoded_left, encoded_right) << left << " < " << right;
+          } else if (i == j) {
+            EXPECT_EQ(encoded_left, encoded_right) << left << " == " << right;
+          } else {
+            EXPECT_GT(encoded_left, encoded_right) << left << " > " << right;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(IndexValueWriterTest, TypeBoundsEncloseTypeOrderGroup) {
+  for (const std::vector<FieldValue>& group : OrderedValueGroups()) {
+    for (const FieldValue& value : group) {
+      std::string encoded = EncodeIndexValue(value);
+      for (const std::vector<FieldValue>& other_group : OrderedValueGroups()) {
+        for (const FieldValue& other : other_group) {
+          bool comparable = FieldValue::Comparable(value.type(), other.type());
+          std::string lower = IndexValueTypeLowerBound(other);
+          std::string upper = IndexValueTypeUpperBound(other);
+          EXPECT_EQ(comparable, lower <= encoded && encoded < upper)
+              << value << " within bounds of " << other;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -16,9 +16,20 @@
 
 #include "Firestore/core/test/firebase/firestore/local/index_manager_test.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
 #include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
@@ -26,18 +37,207 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using model::DocumentKeySet;
+using model::FieldIndex;
+using testutil::Array;
+using testutil::Doc;
+using testutil::Field;
+using testutil::Filter;
+using testutil::Key;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Value;
+using testutil::Version;
+
+using Kind = FieldIndex::Segment::Kind;
+
 namespace {
 
 std::unique_ptr<Persistence> PersistenceFactory() {
   return LevelDbPersistenceForTesting();
 }
 
+FieldIndex MakeFieldIndex(
+    const std::string& collection_id,
+    std::vector<std::pair<std::string, Kind>> fields) {
+  std::vector<FieldIndex::Segment> segments;
+  for (const auto& field : fields) {
+    segments.emplace_back(Field(field.first), field.second);
+  }
+  return FieldIndex(collection_id, std::move(segments));
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(LevelDbIndexManagerTest,
                          IndexManagerTest,
                          ::testing::Values(PersistenceFactory));
 
+class LevelDbFieldIndexTest : public ::testing::Test {
+ public:
+  LevelDbFieldIndexTest() : persistence_(LevelDbPersistenceForTesting()) {
+  }
+
+  ~LevelDbFieldIndexTest() override {
+    persistence_->Shutdown();
+  }
+
+ protected:
+  void AddDocument(const model::Document& document) {
+    persistence_->Run("AddDocument", [&] {
+      persistence_->remote_document_cache()->Add(document, Version(1));
+    });
+  }
+
+  void RemoveDocument(const std::string& path) {
+    persistence_->Run("RemoveDocument", [&] {
+      persistence_->remote_document_cache()->Remove(Key(path));
+    });
+  }
+
+  void AddFieldIndex(const FieldIndex& index) {
+    persistence_->Run("AddFieldIndex", [&] {
+      persistence_->index_manager()->AddFieldIndex(index);
+    });
+  }
+
+  absl::optional<DocumentKeySet> Matching(const core::Query& query) {
+    return persistence_->Run("Matching", [&] {
+      return persistence_->index_manager()->GetDocumentsMatchingQuery(query);
+    });
+  }
+
+  void AssertMatching(const core::Query& query,
+                      std::vector<std::string> expected_paths) {
+    DocumentKeySet expected;
+    for (const std::string& path : expected_paths) {
+      expected = expected.insert(Key(path));
+    }
+
+    absl::optional<DocumentKeySet> actual = Matching(query);
+    ASSERT_TRUE(actual.has_value()) << query.ToString();
+    EXPECT_EQ(*actual, expected) << query.ToString();
+  }
+
+  std::unique_ptr<LevelDbPersistence> persistence_;
+};
+
+TEST_F(LevelDbFieldIndexTest, BackfillsExistingDocuments) {
+  AddDocument(Doc("coll/a", 1, Map("a", 1)));
+  AddDocument(Doc("coll/b", 1, Map("a", 2)));
+  AddDocument(Doc("parent/p/coll/c", 1, Map("a", 1)));
+
+  AddFieldIndex(MakeFieldIndex("coll", {{"a", Kind::Ordered}}));
+
+  AssertMatching(testutil::Query("coll").AddingFilter(Filter("a", "==", 1)),
+                 {"coll/a"});
+  AssertMatching(
+      testutil::Query("parent/p/coll").AddingFilter(Filter("a", "==", 1)),
+      {"parent/p/coll/c"});
+}
+
+TEST_F(LevelDbFieldIndexTest, MaintainsEntriesOnWrite) {
+  AddFieldIndex(MakeFieldIndex("coll", {{"a", Kind::Ordered}}));
+  core::Query query =
+      testutil::Query("coll").AddingFilter(Filter("a", "==", 1));
+
+  AddDocument(Doc("coll/a", 1, Map("a", 1)));
+  AddDocument(Doc("coll/b", 1, Map("b", 1)));
+  AssertMatching(query, {"coll/a"});
+
+  AddDocument(Doc("coll/a", 2, Map("a", 2)));
+  AddDocument(Doc("coll/b", 2, Map("a", 1)));
+  AssertMatching(query, {"coll/b"});
+
+  RemoveDocument("coll/b");
+  AssertMatching(query, {});
+}
+
+TEST_F(LevelDbFieldIndexTest, ServesRangeAndInFilters) {
+  AddFieldIndex(MakeFieldIndex("coll", {{"a", Kind::Ordered}}));
+  AddDocument(Doc("coll/a", 1, Map("a", 1)));
+  AddDocument(Doc("coll/b", 1, Map("a", 2.5)));
+  AddDocument(Doc("coll/c", 1, Map("a", 3)));
+  AddDocument(Doc("coll/d", 1, Map("a", "3")));
+
+  core::Query query = testutil::Query("coll");
+  AssertMatching(query.AddingFilter(Filter("a", ">", 1)),
+                 {"coll/a", "coll/b", "coll/c"});
+  AssertMatching(query.AddingFilter(Filter("a", "<", 3)),
+                 {"coll/a", "coll/b", "coll/c"});
+  AssertMatching(query.AddingFilter(Filter("a", ">=", 2))
+                     .AddingFilter(Filter("a", "<=", 2.5)),
+                 {"coll/b"});
+  AssertMatching(query.AddingFilter(Filter("a", "in", Array(1, "3"))),
+                 {"coll/a", "coll/d"});
+}
+
+TEST_F(LevelDbFieldIndexTest, ServesCompositeQueries) {
+  AddFieldIndex(MakeFieldIndex(
+      "coll", {{"tags", Kind::Contains}, {"a", Kind::Ordered}}));
+  AddDocument(Doc("coll/a", 1, Map("tags", Array("x", "y"), "a", 1)));
+  AddDocument(Doc("coll/b", 1, Map("tags", Array("y"), "a", 2)));
+  AddDocument(Doc("coll/c", 1, Map("tags", Array("x"))));
+
+  core::Query query = testutil::Query("coll");
+  AssertMatching(query.AddingFilter(Filter("tags", "array-contains", "y"))
+                     .AddingFilter(Filter("a", ">=", 2)),
+                 {"coll/b"});
+  AssertMatching(query.AddingFilter(Filter("tags", "array-contains", "x"))
+                     .AddingOrderBy(OrderBy("a")),
+                 {"coll/a"});
+}
+
+TEST_F(LevelDbFieldIndexTest, DoesNotServeUnindexedQueries) {
+  AddFieldIndex(
+      MakeFieldIndex("coll", {{"a", Kind::Ordered}, {"b", Kind::Ordered}}));
+
+  core::Query query = testutil::Query("coll");
+  EXPECT_FALSE(Matching(query));
+  EXPECT_FALSE(Matching(query.AddingFilter(Filter("b", "==", 1))));
+  EXPECT_FALSE(Matching(query.AddingFilter(Filter("a", "==", 1))));
+  EXPECT_FALSE(Matching(
+      testutil::Query("other").AddingFilter(Filter("a", "==", 1))));
+  EXPECT_TRUE(Matching(query.AddingFilter(Filter("a", "==", 1))
+                           .AddingFilter(Filter("b", "==", 1))));
+}
+
+TEST_F(LevelDbFieldIndexTest, ServesBoundingBoxes) {
+  AddFieldIndex(MakeFieldIndex("coll", {{"location", Kind::Geohash}}));
+  AddDocument(Doc("coll/sf", 1, Map("location", GeoPoint(37.77, -122.42))));
+  AddDocument(
+      Doc("coll/oakland", 1, Map("location", GeoPoint(37.80, -122.27))));
+  AddDocument(Doc("coll/nyc", 1, Map("location", GeoPoint(40.71, -74.01))));
+  AddDocument(Doc("coll/none", 1, Map("location", "sf")));
+
+  auto in_box = [&](const GeoPoint& south_west, const GeoPoint& north_east) {
+    return persistence_->Run("InBox", [&] {
+      return persistence_->index_manager()->GetDocumentsInBoundingBox(
+          testutil::Resource("coll"), Field("location"), south_west,
+          north_east);
+    });
+  };
+
+  absl::optional<DocumentKeySet> bay_area =
+      in_box(GeoPoint(37.6, -122.6), GeoPoint(37.9, -122.2));
+  ASSERT_TRUE(bay_area.has_value());
+  EXPECT_TRUE(bay_area->contains(Key("coll/sf")));
+  EXPECT_TRUE(bay_area->contains(Key("coll/oakland")));
+  EXPECT_FALSE(bay_area->contains(Key("coll/nyc")));
+  EXPECT_FALSE(bay_area->contains(Key("coll/none")));
+
+  EXPECT_EQ(in_box(GeoPoint(-10, 10), GeoPoint(10, 20)), DocumentKeySet{});
+  EXPECT_FALSE(persistence_->Run("OtherField", [&] {
+    return persistence_->index_manager()->GetDocumentsInBoundingBox(
+        testutil::Resource("coll"), Field("other"), GeoPoint(-90, -180),
+        GeoPoint(90, 180));
+  }));
+
+  // Spatial indexes never serve regular queries.
+  EXPECT_FALSE(Matching(testutil::Query("coll").AddingFilter(
+      Filter("location", "==", Value(GeoPoint(37.77, -122.42))))));
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
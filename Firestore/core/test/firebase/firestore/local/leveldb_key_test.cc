@@ -15,6 +15,10 @@
  */
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
+
+#include <string>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
 #include "Firestore/core/src/firebase/firestore/util/string_util.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
@@ -23,6 +27,7 @@
 
 using firebase::firestore::model::BatchId;
 using firebase::firestore::model::DocumentKey;
+using firebase::firestore::model::FieldIndex;
 using firebase::firestore::model::SnapshotVersion;
 using firebase::firestore::model::TargetId;
 
@@ -50,6 +55,11 @@ std::string TargetDocKey(TargetId target_id, absl::string_view key) {
   return LevelDbTargetDocumentKey::Key(target_id, testutil::Key(key));
 }
 
+std::string ChunkKey(TargetId target_id, absl::string_view bound) {
+  return LevelDbTargetDocumentChunkKey::Key(target_id,
+                                            testutil::Resource(bound));
+}
+
 std::string DocTargetKey(absl::string_view key, TargetId target_id) {
   return LevelDbDocumentTargetKey::Key(testutil::Key(key), target_id);
 }
@@ -68,6 +78,24 @@ std::string RemoteDocumentReadTimeKey(absl::string_view collection_path,
       document_id);
 }
 
+FieldIndex MakeFieldIndex(absl::string_view collection_id,
+                          absl::string_view ordered_field,
+                          absl::string_view contains_field) {
+  return FieldIndex(
+      std::string(collection_id),
+      {FieldIndex::Segment(testutil::Field(ordered_field),
+                           FieldIndex::Segment::Kind::Ordered),
+       FieldIndex::Segment(testutil::Field(contains_field),
+                           FieldIndex::Segment::Kind::Contains)});
+}
+
+std::string IndexEntryKey(absl::string_view collection_path,
+                          const std::vector<std::string>& values,
+                          absl::string_view document_id) {
+  return LevelDbIndexEntryKey::Key(
+      "coll|a:asc,", testutil::Resource(collection_path), values, document_id);
+}
+
 }  // namespace
 
 /**
@@ -267,6 +295,36 @@ TEST(LevelDbQueryKeyTest, Description) {
                                LevelDbQueryTargetKey::Key("foo", 42));
 }
 
+TEST(TargetSequenceKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetSequenceKey key;
+
+  auto encoded = LevelDbTargetSequenceKey::Key(1000, 42);
+  bool ok = key.Decode(encoded);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(1000, key.sequence_number());
+  ASSERT_EQ(42, key.target_id());
+}
+
+TEST(TargetSequenceKeyTest, Ordering) {
+  ASSERT_LT(LevelDbTargetSequenceKey::Key(2, 100),
+            LevelDbTargetSequenceKey::Key(10, 1));
+  ASSERT_LT(LevelDbTargetSequenceKey::Key(10, 1),
+            LevelDbTargetSequenceKey::Key(10, 2));
+}
+
+TEST(TargetSequenceKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[target_sequence: sequence_number=1000 target_id=42]",
+      LevelDbTargetSequenceKey::Key(1000, 42));
+}
+
+TEST(StartupTargetsKeyTest, EncodeDecodeTargetIds) {
+  std::vector<TargetId> target_ids = {2, 42, 1000};
+  std::string encoded = LevelDbStartupTargetsKey::EncodeTargetIds(target_ids);
+  ASSERT_EQ(target_ids, LevelDbStartupTargetsKey::DecodeTargetIds(encoded));
+  ASSERT_TRUE(LevelDbStartupTargetsKey::DecodeTargetIds("").empty());
+}
+
 TEST(TargetDocumentKeyTest, EncodeDecodeCycle) {
   LevelDbTargetDocumentKey key;
 
@@ -296,6 +354,52 @@ TEST(TargetDocumentKeyTest, Description) {
   ASSERT_EQ("[target_document: target_id=42 path=foo/bar]", DescribeKey(key));
 }
 
+TEST(TargetDocumentChunkKeyTest, EncodeDecodeCycle) {
+  LevelDbTargetDocumentChunkKey key;
+
+  auto encoded = ChunkKey(42, "foo/bar");
+  bool ok = key.Decode(encoded);
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(42, key.target_id());
+  ASSERT_EQ(testutil::Resource("foo/bar"), key.bound());
+
+  ok = key.Decode(ChunkKey(42, ""));
+  ASSERT_TRUE(ok);
+  ASSERT_EQ(model::ResourcePath{}, key.bound());
+}
+
+TEST(TargetDocumentChunkKeyTest, Ordering) {
+  // Different target_id:
+  ASSERT_LT(ChunkKey(1, "foo/bar"), ChunkKey(2, "foo/bar"));
+  ASSERT_LT(ChunkKey(2, ""), ChunkKey(10, "foo/bar"));
+
+  // Different bounds sort from the greatest down:
+  ASSERT_GT(ChunkKey(1, "foo/bar"), ChunkKey(1, "foo/baz"));
+  ASSERT_GT(ChunkKey(1, "foo/bar"), ChunkKey(1, "foo/bar2"));
+  ASSERT_GT(ChunkKey(1, "foo/bar"), ChunkKey(1, "foo/bar/suffix/key"));
+  ASSERT_GT(ChunkKey(1, "foo/bar/suffix/key"), ChunkKey(1, "foo/bar2"));
+  ASSERT_GT(ChunkKey(1, ""), ChunkKey(1, "foo/bar"));
+}
+
+TEST(TargetDocumentChunkKeyTest, Description) {
+  ASSERT_EQ("[target_document_chunk: target_id=42 bound=foo/bar]",
+            DescribeKey(ChunkKey(42, "foo/bar")));
+}
+
+TEST(TargetDocumentChunkKeyTest, EncodesDocumentKeys) {
+  std::vector<DocumentKey> keys{
+      testutil::Key("foo/bar"), testutil::Key("foo/bar/baz/1"),
+      testutil::Key("foo/bar/baz/2"), testutil::Key("foo/bar2"),
+      testutil::Key("qux/1")};
+
+  std::string encoded =
+      LevelDbTargetDocumentChunkKey::EncodeDocumentKeys(keys.begin(),
+                                                        keys.end());
+  std::vector<DocumentKey> decoded;
+  LevelDbTargetDocumentChunkKey::DecodeDocumentKeys(encoded, &decoded);
+  ASSERT_EQ(keys, decoded);
+}
+
 TEST(DocumentTargetKeyTest, EncodeDecodeCycle) {
   LevelDbDocumentTargetKey key;
 
@@ -364,6 +468,64 @@ TEST(RemoteDocumentKeyTest, EncodeDecodeCycle) {
   }
 }
 
+TEST(RemoteDocumentKeyTest, CountSegmentsAfterPrefix) {
+  auto count = [](const std::string& key, const std::string& prefix) {
+    return LevelDbRemoteDocumentKey::CountSegmentsAfterPrefix(
+        RemoteDocKey(key), RemoteDocKeyPrefix(prefix));
+  };
+
+  EXPECT_EQ(count("foo/bar", "foo"), 1u);
+  EXPECT_EQ(count("foo/bar/baz/quux", "foo"), 3u);
+  EXPECT_EQ(count("foo/bar/baz/quux", "foo/bar/baz"), 1u);
+  EXPECT_EQ(count("foo/bar", ""), 2u);
+  EXPECT_EQ(count("foo/bar", "foo/bar"), 0u);
+
+  // Path segments must match in full.
+  EXPECT_EQ(count("foo2/bar", "foo"), absl::nullopt);
+  EXPECT_EQ(count("fo/bar", "foo"), absl::nullopt);
+  EXPECT_EQ(count("bar/baz", "foo"), absl::nullopt);
+
+  // Keys from other tables and truncated keys are rejected.
+  std::string prefix = RemoteDocKeyPrefix("foo");
+  EXPECT_EQ(LevelDbRemoteDocumentKey::CountSegmentsAfterPrefix(
+                DocMutationKey("user1", "foo/bar", 1), prefix),
+            absl::nullopt);
+  std::string key = RemoteDocKey("foo/bar");
+  for (size_t size = prefix.size(); size < key.size(); ++size) {
+    EXPECT_EQ(LevelDbRemoteDocumentKey::CountSegmentsAfterPrefix(
+                  key.substr(0, size), prefix),
+              absl::nullopt);
+  }
+}
+
+TEST(RemoteDocumentKeyTest, ChildKeyPrefix) {
+  std::string prefix = RemoteDocKeyPrefix("rooms");
+  std::string key = RemoteDocKey("rooms/abc/messages/xyz");
+
+  absl::optional<absl::string_view> child =
+      LevelDbRemoteDocumentKey::ChildKeyPrefix(key, prefix);
+  ASSERT_TRUE(child);
+  EXPECT_EQ(*child, RemoteDocKeyPrefix("rooms/abc"));
+  EXPECT_EQ(LevelDbRemoteDocumentKey::ChildKeyPrefix(RemoteDocKey("rooms/abc"),
+                                                     prefix),
+            child);
+
+  // The successor of the child prefix sorts after the child's whole subtree
+  // and before its siblings.
+  std::string successor = util::PrefixSuccessor(*child);
+  EXPECT_LT(RemoteDocKey("rooms/abc/messages/xyz/reactions/1"), successor);
+  EXPECT_LT(RemoteDocKey("rooms/abc/zzz/1"), successor);
+  EXPECT_GT(RemoteDocKey("rooms/abc0"), successor);
+  EXPECT_GT(RemoteDocKey("rooms/abd"), successor);
+  EXPECT_GT(RemoteDocKey(std::string("rooms/abc\0", 10)), successor);
+
+  EXPECT_EQ(LevelDbRemoteDocumentKey::ChildKeyPrefix(RemoteDocKey("other/abc"),
+                                                     prefix),
+            absl::nullopt);
+  EXPECT_EQ(LevelDbRemoteDocumentKey::ChildKeyPrefix(prefix, prefix),
+            absl::nullopt);
+}
+
 TEST(RemoteDocumentKeyTest, Description) {
   AssertExpectedKeyDescription(
       "[remote_document: path=foo/bar/baz/quux]",
@@ -423,6 +585,79 @@ TEST(RemoteDocumentReadTimeKeyTest, Description) {
       RemoteDocumentReadTimeKey("coll", 1000001, "doc"));
 }
 
+TEST(IndexConfigurationKeyTest, Prefixing) {
+  auto table_key = LevelDbIndexConfigurationKey::KeyPrefix();
+  auto coll_key = LevelDbIndexConfigurationKey::KeyPrefix("coll");
+  auto index_key =
+      LevelDbIndexConfigurationKey::Key(MakeFieldIndex("coll", "a", "b"));
+
+  ASSERT_TRUE(absl::StartsWith(coll_key, table_key));
+  ASSERT_TRUE(absl::StartsWith(index_key, coll_key));
+  ASSERT_FALSE(absl::StartsWith(index_key,
+                                LevelDbIndexConfigurationKey::KeyPrefix("co")));
+}
+
+TEST(IndexConfigurationKeyTest, EncodeDecodeCycle) {
+  LevelDbIndexConfigurationKey key;
+
+  std::vector<FieldIndex> indexes{MakeFieldIndex("coll", "a", "b"),
+                                  MakeFieldIndex("coll", "a.b", "c"),
+                                  MakeFieldIndex("other", "`a|b`", "c")};
+  for (const FieldIndex& index : indexes) {
+    auto encoded = LevelDbIndexConfigurationKey::Key(index);
+    bool ok = key.Decode(encoded);
+    ASSERT_TRUE(ok);
+    ASSERT_EQ(index, key.index());
+  }
+}
+
+TEST(IndexConfigurationKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[index_configuration: collection_id=coll field_path=a kind=0 "
+      "field_path=b kind=1]",
+      LevelDbIndexConfigurationKey::Key(MakeFieldIndex("coll", "a", "b")));
+}
+
+TEST(IndexEntryKeyTest, Ordering) {
+  // Index values order before document IDs:
+  ASSERT_LT(IndexEntryKey("coll", {"a"}, "2"),
+            IndexEntryKey("coll", {"b"}, "1"));
+  ASSERT_LT(IndexEntryKey("coll", {"a"}, "1"),
+            IndexEntryKey("coll", {"a"}, "2"));
+  ASSERT_LT(IndexEntryKey("coll", {"a", "b"}, "1"),
+            IndexEntryKey("coll", {"a", "c"}, "1"));
+
+  // Entries of a collection order before those of its subcollections:
+  ASSERT_LT(IndexEntryKey("coll", {"b"}, "1"),
+            IndexEntryKey("coll/doc/coll", {"a"}, "1"));
+}
+
+TEST(IndexEntryKeyTest, EncodeDecodeCycle) {
+  LevelDbIndexEntryKey key;
+
+  std::vector<std::string> collection_paths{"coll", "coll/doc/coll"};
+  std::vector<std::vector<std::string>> values{
+      {"a"}, {"a", ""}, {std::string("\0\1", 2)}};
+  for (const auto& collection_path : collection_paths) {
+    for (const auto& value : values) {
+      auto encoded = IndexEntryKey(collection_path, value, "doc");
+      bool ok = key.Decode(encoded);
+      ASSERT_TRUE(ok);
+      ASSERT_EQ("coll|a:asc,", key.index_id());
+      ASSERT_EQ(testutil::Resource(collection_path), key.collection_path());
+      ASSERT_EQ(value, key.values());
+      ASSERT_EQ("doc", key.document_id());
+    }
+  }
+}
+
+TEST(IndexEntryKeyTest, Description) {
+  AssertExpectedKeyDescription(
+      "[index_entry: index_id=coll|a:asc, path=coll index_value=6162 "
+      "document_id=doc]",
+      IndexEntryKey("coll", {"ab"}, "doc"));
+}
+
 #undef AssertExpectedKeyDescription
 
 }  // namespace local
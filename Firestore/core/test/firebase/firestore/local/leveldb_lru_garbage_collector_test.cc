@@ -15,14 +15,21 @@
  */
 
 #include <string>
+#include <utility>
+#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_target_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/test/firebase/firestore/local/lru_garbage_collector_test.h"
 #include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "gtest/gtest.h"
 
 namespace firebase {
@@ -31,6 +38,12 @@ namespace local {
 namespace {
 
 using model::DocumentKey;
+using model::DocumentKeySet;
+using model::ListenSequenceNumber;
+using testutil::Key;
+
+using OrphanedDocuments =
+    std::vector<std::pair<DocumentKey, ListenSequenceNumber>>;
 
 class TestHelper : public LruGarbageCollectorTestHelper {
  public:
@@ -61,6 +74,48 @@ INSTANTIATE_TEST_SUITE_P(LevelDbLruGarbageCollectorTest,
                          LruGarbageCollectorTest,
                          ::testing::Values(Factory));
 
+TEST(LevelDbLruGarbageCollectorTest, WritesSentinelsWhenDocumentsLeaveTargets) {
+  auto persistence = LevelDbPersistenceForTesting();
+  LevelDbTargetCache* target_cache = persistence->target_cache();
+  DocumentKey removed = Key("docs/0");
+  DocumentKey kept = Key("docs/1");
+  auto orphaned_documents = [&] {
+    OrphanedDocuments result;
+    target_cache->EnumerateOrphanedDocuments(
+        [&](const DocumentKey& key, ListenSequenceNumber sequence_number) {
+          result.emplace_back(key, sequence_number);
+        });
+    return result;
+  };
+
+  TargetData target_data = persistence->Run("add", [&] {
+    TargetData result(testutil::Query("docs").ToTarget(), 1,
+                      persistence->current_sequence_number(),
+                      QueryPurpose::Listen);
+    target_cache->AddTarget(result);
+    target_cache->AddMatchingKeys(DocumentKeySet{removed, kept}, 1);
+    return result;
+  });
+
+  // Documents get a sentinel once they leave a target...
+  ListenSequenceNumber removed_at = persistence->Run("remove", [&] {
+    target_cache->RemoveMatchingKeys(DocumentKeySet{removed}, 1);
+    return persistence->current_sequence_number();
+  });
+  persistence->Run("check removed", [&] {
+    EXPECT_EQ(orphaned_documents(), (OrphanedDocuments{{removed, removed_at}}));
+  });
+
+  // ... including when the whole target goes away.
+  persistence->Run("remove target",
+                   [&] { target_cache->RemoveTarget(target_data); });
+  persistence->Run("check removed target", [&] {
+    EXPECT_EQ(orphaned_documents(),
+              (OrphanedDocuments{{removed, removed_at},
+                                 {kept, target_data.sequence_number()}}));
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
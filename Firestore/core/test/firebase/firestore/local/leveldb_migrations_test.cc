@@ -17,9 +17,11 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
+#include "Firestore/Protos/nanopb/firestore/local/target.nanopb.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_migrations.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_target_cache.h"
@@ -458,6 +460,179 @@ TEST_F(LevelDbMigrationsTest, CreateCollectionParentsIndex) {
   }
 }
 
+TEST_F(LevelDbMigrationsTest, BackfillsCollectionParentsInChunks) {
+  std::string empty_buffer;
+  {
+    LevelDbTransaction transaction(db_.get(), "Write Remote Documents");
+    for (const char* path :
+         {"a/1/cg/1", "b/1/cg/2", "c/1", "c/2", "d/1/cg/3"}) {
+      transaction.Put(LevelDbRemoteDocumentKey::Key(Key(path)), empty_buffer);
+    }
+    transaction.Put(
+        LevelDbDocumentMutationKey::Key("dummy-uid", Key("e/1/cg/4"),
+                                        /*dummy batch_id=*/123),
+        empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::StartMigrations(db_.get());
+  ASSERT_EQ(LevelDbMigrations::ReadSchemaVersion(db_.get()), 7);
+
+  std::vector<model::ResourcePath> all_parents{
+      model::ResourcePath{"a", "1"}, model::ResourcePath{"b", "1"},
+      model::ResourcePath{"d", "1"}, model::ResourcePath{"e", "1"}};
+
+  // Each step indexes two rows, and parents the index is still missing are
+  // found by scanning. The collection group documents backfill follows in
+  // three more steps.
+  int steps = 0;
+  bool more = true;
+  while (more) {
+    LevelDbTransaction transaction(db_.get(), "Backfill step");
+    more = LevelDbMigrations::ContinueBackfill(&transaction, 2);
+    transaction.Commit();
+    ++steps;
+
+    LevelDbTransaction verify(db_.get(), "Verify");
+    std::vector<model::ResourcePath> parents;
+    auto it = verify.NewIterator();
+    std::string index_prefix = LevelDbCollectionParentKey::KeyPrefix("cg");
+    LevelDbCollectionParentKey row_key;
+    for (it->Seek(index_prefix);
+         it->Valid() && absl::StartsWith(it->key(), index_prefix) &&
+         row_key.Decode(it->key());
+         it->Next()) {
+      parents.push_back(row_key.parent());
+    }
+    EXPECT_EQ(LevelDbMigrations::AddUnindexedCollectionParents(&verify, "cg",
+                                                               &parents),
+              steps < 3);
+    EXPECT_THAT(parents, testing::UnorderedElementsAreArray(all_parents));
+  }
+  EXPECT_EQ(steps, 6);
+}
+
+TEST_F(LevelDbMigrationsTest, BackfillsCollectionGroupDocuments) {
+  std::string empty_buffer;
+  {
+    LevelDbTransaction transaction(db_.get(), "Write Remote Documents");
+    for (const char* path : {"a/1/cg/1", "b/1/cg/2", "c/1", "d/1/cg/3"}) {
+      transaction.Put(LevelDbRemoteDocumentKey::Key(Key(path)), empty_buffer);
+    }
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::StartMigrations(db_.get());
+  {
+    LevelDbTransaction transaction(db_.get(), "Verify pending");
+    ASSERT_TRUE(
+        LevelDbMigrations::IsCollectionGroupDocumentsBackfillPending(
+            &transaction));
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get());
+
+  LevelDbTransaction transaction(db_.get(), "Verify");
+  EXPECT_FALSE(LevelDbMigrations::IsCollectionGroupDocumentsBackfillPending(
+      &transaction));
+
+  std::vector<DocumentKey> keys;
+  auto it = transaction.NewIterator();
+  std::string index_prefix = LevelDbCollectionGroupDocumentKey::KeyPrefix("cg");
+  LevelDbCollectionGroupDocumentKey row_key;
+  for (it->Seek(index_prefix);
+       it->Valid() && absl::StartsWith(it->key(), index_prefix) &&
+       row_key.Decode(it->key());
+       it->Next()) {
+    EXPECT_EQ(LevelDbCollectionGroupDocumentKey::DecodeReadTime(it->value()),
+              absl::nullopt);
+    keys.push_back(row_key.document_key());
+  }
+  EXPECT_EQ(keys, (std::vector<DocumentKey>{Key("a/1/cg/1"), Key("b/1/cg/2"),
+                                            Key("d/1/cg/3")}));
+}
+
+TEST_F(LevelDbMigrationsTest, MovesTargetDocumentsIntoChunks) {
+  std::vector<DocumentKey> target1_keys;
+  for (int i = 0; i < 300; ++i) {
+    target1_keys.push_back(Key("docs/" + std::to_string(1000 + i)));
+  }
+  std::vector<DocumentKey> target2_keys{Key("docs/1000")};
+
+  LevelDbMigrations::RunMigrations(db_.get(), 7);
+  {
+    std::string empty_buffer;
+    LevelDbTransaction transaction(db_.get(), "Write target documents");
+    for (const DocumentKey& key : target1_keys) {
+      transaction.Put(LevelDbTargetDocumentKey::Key(1, key), empty_buffer);
+    }
+    transaction.Put(LevelDbTargetDocumentKey::Key(2, target2_keys[0]),
+                    empty_buffer);
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 8);
+  ASSERT_EQ(LevelDbMigrations::ReadSchemaVersion(db_.get()), 8);
+
+  // Migration 8 is done, so running the migrations again must leave the
+  // chunks alone.
+  LevelDbMigrations::RunMigrations(db_.get(), 8);
+
+  LevelDbTransaction transaction(db_.get(), "Verify");
+  auto it = transaction.NewIterator();
+  std::string old_prefix = LevelDbTargetDocumentKey::KeyPrefix();
+  it->Seek(old_prefix);
+  ASSERT_FALSE(it->Valid() && absl::StartsWith(it->key(), old_prefix));
+
+  for (TargetId target_id : {1, 2}) {
+    // Chunks are stored from the greatest bound down.
+    std::string chunk_prefix =
+        LevelDbTargetDocumentChunkKey::KeyPrefix(target_id);
+    std::vector<std::string> chunks;
+    for (it->Seek(chunk_prefix);
+         it->Valid() && absl::StartsWith(it->key(), chunk_prefix);
+         it->Next()) {
+      chunks.push_back(it->value());
+    }
+    std::vector<DocumentKey> keys;
+    for (auto chunk = chunks.rbegin(); chunk != chunks.rend(); ++chunk) {
+      LevelDbTargetDocumentChunkKey::DecodeDocumentKeys(*chunk, &keys);
+    }
+
+    EXPECT_EQ(keys, target_id == 1 ? target1_keys : target2_keys);
+    EXPECT_EQ(chunks.size(), target_id == 1 ? 2u : 1u);
+  }
+}
+
+TEST_F(LevelDbMigrationsTest, IndexesTargetSequenceNumbers) {
+  LevelDbMigrations::RunMigrations(db_.get(), 8);
+  {
+    LevelDbTransaction transaction(db_.get(), "Write targets");
+    for (TargetId target_id : {1, 2, 3}) {
+      Message<firestore_client_Target> target;
+      target->target_id = target_id;
+      target->last_listen_sequence_number = 100 - target_id;
+      transaction.Put(LevelDbTargetKey::Key(target_id), target);
+    }
+    transaction.Commit();
+  }
+
+  LevelDbMigrations::RunMigrations(db_.get(), 9);
+
+  LevelDbTransaction transaction(db_.get(), "Verify");
+  auto it = transaction.NewIterator();
+  std::string prefix = LevelDbTargetSequenceKey::KeyPrefix();
+  std::vector<std::pair<ListenSequenceNumber, TargetId>> rows;
+  LevelDbTargetSequenceKey row_key;
+  for (it->Seek(prefix); it->Valid() && absl::StartsWith(it->key(), prefix) &&
+                         row_key.Decode(it->key());
+       it->Next()) {
+    rows.emplace_back(row_key.sequence_number(), row_key.target_id());
+  }
+  EXPECT_EQ(rows, (std::vector<std::pair<ListenSequenceNumber, TargetId>>{
+                      {97, 3}, {98, 2}, {99, 1}}));
+}
+
 TEST_F(LevelDbMigrationsTest, CanDowngrade) {
   // First, run all of the migrations
   LevelDbMigrations::RunMigrations(db_.get());
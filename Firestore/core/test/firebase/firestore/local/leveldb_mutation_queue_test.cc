@@ -19,11 +19,16 @@
 
 #include "Firestore/Protos/nanopb/firestore/local/mutation.nanopb.h"
 #include "Firestore/Protos/nanopb/google/protobuf/empty.nanopb.h"
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
 #include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_mutation_queue.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
@@ -32,6 +37,7 @@
 #include "Firestore/core/test/firebase/firestore/local/mutation_queue_test.h"
 #include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
 #include "Firestore/core/test/firebase/firestore/testutil/status_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/strings/string_view.h"
 #include "gtest/gtest.h"
 #include "leveldb/db.h"
@@ -47,10 +53,13 @@ using leveldb::Slice;
 using leveldb::Status;
 using leveldb::WriteOptions;
 using model::BatchId;
+using model::MutationBatch;
 using nanopb::ByteString;
 using nanopb::Message;
 using nanopb::StringReader;
 using nanopb::StringWriter;
+using testutil::Map;
+using testutil::Resource;
 using util::OrderedCode;
 
 // A dummy mutation value, useful for testing code that's known to examine only
@@ -181,6 +190,99 @@ TEST_F(LevelDbMutationQueueTest, EmptyProtoCanBeUpgraded) {
             ByteString(default_message->last_stream_token));
 }
 
+TEST_F(LevelDbMutationQueueTest, TracksCollectionsWithPendingMutations) {
+  auto may_have_mutations = [&](absl::string_view path) {
+    return mutation_queue_->MayHaveMutationsInCollection(Resource(path));
+  };
+
+  persistence_->Run("TracksCollectionsWithPendingMutations", [&] {
+    EXPECT_FALSE(may_have_mutations("foo"));
+
+    MutationBatch batch1 = mutation_queue_->AddMutationBatch(
+        Timestamp::Now(), {},
+        {testutil::SetMutation("foo/bar", Map("a", 1)),
+         testutil::PatchMutation("foo/bar", Map("b", 1), {})});
+    MutationBatch batch2 = mutation_queue_->AddMutationBatch(
+        Timestamp::Now(), {},
+        {testutil::SetMutation("foo/baz/sub/doc", Map("a", 1))});
+
+    EXPECT_TRUE(may_have_mutations("foo"));
+    EXPECT_TRUE(may_have_mutations("foo/baz/sub"));
+    EXPECT_FALSE(may_have_mutations("food"));
+
+    // Restarting rebuilds the counts from the document-mutation index.
+    mutation_queue_->Start();
+    EXPECT_TRUE(may_have_mutations("foo"));
+
+    mutation_queue_->RemoveMutationBatch(batch1);
+    EXPECT_FALSE(may_have_mutations("foo"));
+    EXPECT_TRUE(may_have_mutations("foo/baz/sub"));
+    core::Query query = testutil::Query("foo");
+    EXPECT_TRUE(
+        mutation_queue_->AllMutationBatchesAffectingQuery(query).empty());
+
+    mutation_queue_->RemoveMutationBatch(batch2);
+    EXPECT_FALSE(may_have_mutations("foo/baz/sub"));
+  });
+}
+
+TEST_F(LevelDbMutationQueueTest, TracksStoredBatchSizes) {
+  persistence_->Run("TracksStoredBatchSizes", [&] {
+    EXPECT_EQ(mutation_queue_->GetByteSize(), 0);
+
+    MutationBatch batch1 = mutation_queue_->AddMutationBatch(
+        Timestamp::Now(), {}, {testutil::SetMutation("foo/bar", Map("a", 1))});
+    int64_t one_batch = mutation_queue_->GetByteSize();
+    EXPECT_GT(one_batch, 0);
+
+    MutationBatch batch2 = mutation_queue_->AddMutationBatch(
+        Timestamp::Now(), {}, {testutil::SetMutation("foo/baz", Map("a", 1))});
+    int64_t two_batches = mutation_queue_->GetByteSize();
+    EXPECT_GT(two_batches, one_batch);
+
+    // Restarting reloads the totals from the stored batches.
+    mutation_queue_->Start();
+    EXPECT_EQ(mutation_queue_->GetBatchCount(), 2u);
+    EXPECT_EQ(mutation_queue_->GetByteSize(), two_batches);
+
+    MutationBatch bigger(
+        batch2.batch_id(), batch2.local_write_time(), {},
+        {testutil::SetMutation("foo/baz", Map("a", "a much longer value"))});
+    mutation_queue_->ReplaceLastMutationBatch(bigger);
+    EXPECT_GT(mutation_queue_->GetByteSize(), two_batches);
+
+    mutation_queue_->RemoveMutationBatch(batch1);
+    mutation_queue_->RemoveMutationBatch(bigger);
+    EXPECT_EQ(mutation_queue_->GetBatchCount(), 0u);
+    EXPECT_EQ(mutation_queue_->GetByteSize(), 0);
+  });
+}
+
+TEST(LevelDbMutationQueueDurabilityTest, GroupCommitDoesNotHoldSyncedWrites) {
+  LevelDbOptions options;
+  options.sync_mutation_queue_writes = true;
+  auto persistence = LevelDbPersistenceForTesting(options);
+
+  int flushes_scheduled = 0;
+  persistence->EnableGroupCommit([&] { ++flushes_scheduled; });
+
+  MutationQueue* queue = persistence->GetMutationQueueForUser(User("user"));
+  BatchId batch_id = persistence->Run("add", [&] {
+    queue->Start();
+    return queue
+        ->AddMutationBatch(
+            Timestamp::Now(), {},
+            {testutil::SetMutation("foo/bar", testutil::Map("a", 1))})
+        .batch_id();
+  });
+
+  EXPECT_EQ(flushes_scheduled, 0);
+  std::string key = LevelDbMutationKey::Key("user", batch_id);
+  std::string value;
+  Status status = persistence->ptr()->Get(leveldb::ReadOptions(), key, &value);
+  EXPECT_TRUE(status.ok());
+}
+
 void LevelDbMutationQueueTest::SetDummyValueForKey(const std::string& key) {
   db_->Put(WriteOptions(), key, kDummy);
 }
@@ -16,6 +16,10 @@
 
 #include "Firestore/core/src/firebase/firestore/local/leveldb_opener.h"
 
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <thread>  // NOLINT(build/c++11)
+
 #include "Firestore/core/src/firebase/firestore/core/database_info.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
@@ -72,6 +76,18 @@ void RunPersistence(LevelDbOpener* opener) {
   persistence->Shutdown();
 }
 
+/**
+ * Waits up to five seconds for the given condition to hold, e.g. for data
+ * deleted in the background to be gone.
+ */
+bool Eventually(const std::function<bool()>& condition) {
+  for (int i = 0; i < 500; ++i) {
+    if (condition()) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return false;
+}
+
 }  // namespace
 
 TEST(LevelDbOpenerTest, CanFindAppDataDir) {
@@ -214,6 +230,64 @@ TEST(LevelDbOpenerTest, WorksWithoutLegacyData) {
   ASSERT_THAT(other_fs.IsDirectory(data_dir), IsOk());
 }
 
+TEST(LevelDbOpenerTest, OpensWithTuningOptions) {
+  TestTempDir root_dir;
+  OtherFilesystem other_fs(root_dir.path());
+  DatabaseInfo db_info = FakeDatabaseInfo();
+
+  LevelDbOptions options;
+  options.block_cache_size_bytes = 1024 * 1024;
+  options.bloom_filter_bits_per_key = 16;
+  options.write_buffer_size_bytes = 256 * 1024;
+  options.shared_block_cache = true;
+  options.max_open_files = 64;
+
+  LevelDbOpener opener(db_info, &other_fs);
+  auto created = opener.Create(LruParams::Disabled(), options);
+  ASSERT_OK(created.status());
+  std::move(created).ValueOrDie()->Shutdown();
+
+  // Tables written with different options remain readable.
+  LevelDbOpener reopener(db_info, &other_fs);
+  RunPersistence(&reopener);
+}
+
+TEST(LevelDbOpenerTest, ClearsDataDirInBackground) {
+  TestTempDir root_dir;
+  Filesystem* fs = Filesystem::Default();
+  DatabaseInfo db_info = FakeDatabaseInfo();
+
+  LevelDbOpener opener(db_info, root_dir.path());
+  RunPersistence(&opener);
+  Path data_dir = opener.LevelDbDataDir().ValueOrDie();
+  ASSERT_THAT(fs->IsDirectory(data_dir), IsOk());
+
+  ASSERT_OK(opener.ClearDataDir());
+  EXPECT_THAT(fs->IsDirectory(data_dir), IsNotFound());
+
+  Path trash_dir = Path::JoinUtf8(root_dir.path(), "key/project/trash");
+  EXPECT_TRUE(Eventually([&] { return util::IsEmptyDir(trash_dir); }));
+
+  // Clearing again is a no-op.
+  EXPECT_OK(opener.ClearDataDir());
+}
+
+TEST(LevelDbOpenerTest, SweepsTrashLeftOverByPreviousRuns) {
+  TestTempDir root_dir;
+  Filesystem* fs = Filesystem::Default();
+  DatabaseInfo db_info = FakeDatabaseInfo();
+
+  Path trash_dir = Path::JoinUtf8(root_dir.path(), "key/project/trash");
+  Path leftover = Path::JoinUtf8(trash_dir, "leftover");
+  ASSERT_OK(fs->RecursivelyCreateDir(leftover));
+  testutil::Touch(Path::JoinUtf8(leftover, "000001.ldb"));
+
+  LevelDbOpener opener(db_info, root_dir.path());
+  RunPersistence(&opener);
+  EXPECT_TRUE(Eventually(
+      [&] { return fs->IsDirectory(trash_dir).code() == Error::kNotFound; }));
+}
+
 class MockFilesystem : public Filesystem {
  public:
   MOCK_METHOD1(AppDataDir, StatusOr<Path>(absl::string_view));
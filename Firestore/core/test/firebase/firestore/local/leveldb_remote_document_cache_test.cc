@@ -17,14 +17,26 @@
 #include <initializer_list>
 #include <memory>
 #include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/hot_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_key.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/leveldb_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
 #include "Firestore/core/test/firebase/firestore/local/remote_document_cache_test.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/memory/memory.h"
+#include "gmock/gmock.h"
 #include "leveldb/db.h"
 
 namespace firebase {
@@ -33,12 +45,37 @@ namespace local {
 namespace {
 
 using leveldb::WriteOptions;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentMap;
+using model::SnapshotVersion;
+using testing::ElementsAreArray;
+using testutil::Doc;
+using testutil::Map;
+using testutil::Version;
+using util::Filesystem;
 using util::OrderedCode;
+using util::Path;
 
 // A dummy document value, useful for testing code that's known to examine only
 // document keys.
 const char* kDummy = "1";
 
+/** Returns the IDs of the chunks stored for the given document. */
+std::vector<std::string> ChunkIds(LevelDbPersistence* db,
+                                  const DocumentKey& key) {
+  std::vector<std::string> result;
+  auto it = db->current_transaction()->NewIterator();
+  LevelDbRemoteDocumentChunkKey chunk_key;
+  for (it->Seek(LevelDbRemoteDocumentChunkKey::KeyPrefix(key));
+       it->Valid() && chunk_key.Decode(it->key()) &&
+       chunk_key.document_key() == key;
+       it->Next()) {
+    result.push_back(chunk_key.chunk_id());
+  }
+  return result;
+}
+
 /**
  * Writes a dummy row that looks like a remote document key but is different
  * enough that it shouldn't be picked up in scans of the table.
@@ -79,12 +116,356 @@ std::unique_ptr<Persistence> PersistenceFactory() {
   return persistence;
 }
 
+class LevelDbDocumentSnapshotTest : public testing::Test {
+ protected:
+  LevelDbDocumentSnapshotTest() : dir_(LevelDbDir()) {
+    Open(/* snapshot_enabled= */ true);
+  }
+
+  void Open(bool snapshot_enabled) {
+    if (persistence_) {
+      persistence_->Shutdown();
+    }
+    persistence_ = LevelDbPersistenceForTesting(dir_);
+    persistence_->ConfigureDocumentSnapshot(snapshot_enabled);
+    cache_ = persistence_->remote_document_cache();
+  }
+
+  /** Runs both steps of a compaction: building and installing the file. */
+  void Compact() {
+    persistence_->CompactDocumentSnapshot();
+    cache_->AwaitSnapshotBuild();
+    persistence_->CompactDocumentSnapshot();
+  }
+
+  void Add(const Document& doc) {
+    persistence_->Run("Add", [&] { cache_->Add(doc, Version(1)); });
+  }
+
+  void Remove(absl::string_view path) {
+    persistence_->Run("Remove", [&] { cache_->Remove(testutil::Key(path)); });
+  }
+
+  std::vector<Document> GetMatching(const core::Query& query) {
+    return persistence_->Run("GetMatching", [&] {
+      DocumentMap results = cache_->GetMatching(query, SnapshotVersion::None());
+      std::vector<Document> docs;
+      for (const auto& kv : results.underlying_map()) {
+        docs.push_back(Document(kv.second));
+      }
+      return docs;
+    });
+  }
+
+  bool SnapshotFileExists() {
+    return Filesystem::Default()
+        ->FileSize(dir_.AppendUtf8("remote_documents.snapshot"))
+        .ok();
+  }
+
+  Path dir_;
+  std::unique_ptr<LevelDbPersistence> persistence_;
+  LevelDbRemoteDocumentCache* cache_ = nullptr;
+};
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(LevelDbRemoteDocumentCacheTest,
                          RemoteDocumentCacheTest,
                          testing::Values(PersistenceFactory));
 
+TEST_F(LevelDbDocumentSnapshotTest, ReadsDocumentsFromSnapshot) {
+  Document b1 = Doc("b/1", 1, Map("a", 1));
+  Document b2 = Doc("b/2", 1, Map("a", 2));
+  Add(Doc("a/1", 1, Map("a", 1)));
+  Add(b1);
+  Add(b2);
+  Add(Doc("b/1/c/1", 1, Map("a", 1)));
+  Add(Doc("c/1", 1, Map("a", 1)));
+
+  Compact();
+  EXPECT_TRUE(SnapshotFileExists());
+
+  EXPECT_THAT(GetMatching(testutil::Query("b")), ElementsAreArray({b1, b2}));
+  core::Query filtered =
+      testutil::Query("b").AddingFilter(testutil::Filter("a", "==", 2));
+  EXPECT_THAT(GetMatching(filtered), ElementsAreArray({b2}));
+}
+
+TEST_F(LevelDbDocumentSnapshotTest, ReadsChangesSinceSnapshotFromLevelDb) {
+  Add(Doc("b/1", 1, Map("a", 1)));
+  Add(Doc("b/2", 1, Map("a", 1)));
+  Compact();
+
+  Document updated = Doc("b/1", 2, Map("a", 2));
+  Document added = Doc("b/3", 2, Map("a", 3));
+  Add(updated);
+  Add(added);
+  Remove("b/2");
+
+  EXPECT_THAT(GetMatching(testutil::Query("b")),
+              ElementsAreArray({updated, added}));
+  core::Query filtered =
+      testutil::Query("b").AddingFilter(testutil::Filter("a", "==", 1));
+  EXPECT_TRUE(GetMatching(filtered).empty());
+}
+
+TEST_F(LevelDbDocumentSnapshotTest, ReadsChangesMadeDuringBuild) {
+  Document b1 = Doc("b/1", 1, Map("a", 1));
+  Add(b1);
+  Add(Doc("b/2", 1, Map("a", 1)));
+
+  persistence_->CompactDocumentSnapshot();
+  Document updated = Doc("b/2", 2, Map("a", 2));
+  Add(updated);
+  cache_->AwaitSnapshotBuild();
+  persistence_->CompactDocumentSnapshot();
+
+  EXPECT_THAT(GetMatching(testutil::Query("b")),
+              ElementsAreArray({b1, updated}));
+
+  Compact();
+  EXPECT_THAT(GetMatching(testutil::Query("b")),
+              ElementsAreArray({b1, updated}));
+}
+
+TEST_F(LevelDbDocumentSnapshotTest, ReopensSnapshot) {
+  Add(Doc("b/1", 1, Map("a", 1)));
+  Compact();
+
+  Document updated = Doc("b/1", 2, Map("a", 2));
+  Add(updated);
+
+  Open(/* snapshot_enabled= */ true);
+  EXPECT_THAT(GetMatching(testutil::Query("b")), ElementsAreArray({updated}));
+}
+
+TEST_F(LevelDbDocumentSnapshotTest, DisablingRemovesSnapshot) {
+  Add(Doc("b/1", 1, Map("a", 1)));
+  Compact();
+  EXPECT_TRUE(SnapshotFileExists());
+
+  Open(/* snapshot_enabled= */ false);
+  EXPECT_FALSE(SnapshotFileExists());
+
+  // Changes made while disabled aren't recorded, so re-enabling must not use
+  // an old snapshot.
+  Document updated = Doc("b/1", 2, Map("a", 2));
+  Add(updated);
+
+  Open(/* snapshot_enabled= */ true);
+  EXPECT_THAT(GetMatching(testutil::Query("b")), ElementsAreArray({updated}));
+
+  Compact();
+  EXPECT_THAT(GetMatching(testutil::Query("b")), ElementsAreArray({updated}));
+}
+
+TEST(LevelDbRemoteDocumentCacheTest, ServesRepeatedReadsFromMemory) {
+  auto persistence = LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  const HotDocumentCache& hot = cache->hot_documents();
+  Document doc = Doc("a/1", 1, Map("a", 1));
+
+  persistence->Run("test", [&] {
+    cache->Add(doc, Version(1));
+
+    EXPECT_EQ(cache->Get(doc.key()), doc);
+    EXPECT_EQ(0, hot.hits());
+    EXPECT_EQ(cache->Get(doc.key()), doc);
+    EXPECT_EQ(cache->GetAll({doc.key()}).size(), 1u);
+    EXPECT_EQ(2, hot.hits());
+
+    // Writes invalidate the cached document.
+    Document updated = Doc("a/1", 2, Map("a", 2));
+    cache->Add(updated, Version(2));
+    EXPECT_EQ(cache->Get(doc.key()), updated);
+    EXPECT_EQ(2, hot.hits());
+
+    cache->Remove(doc.key());
+    EXPECT_EQ(cache->Get(doc.key()), absl::nullopt);
+    EXPECT_EQ(2, hot.hits());
+  });
+}
+
+TEST(LevelDbRemoteDocumentCacheTest, PrefetchesDocumentsIntoMemory) {
+  auto persistence = LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  const HotDocumentCache& hot = cache->hot_documents();
+  Document doc1 = Doc("a/1", 1, Map("a", 1));
+  Document doc2 = Doc("a/2", 1, Map("a", 2));
+
+  persistence->Run("add", [&] {
+    cache->Add(doc1, Version(1));
+    cache->Add(doc2, Version(1));
+  });
+  persistence->Run("prefetch",
+                   [&] { cache->Prefetch({doc1.key(), doc2.key()}); });
+
+  // Documents written while the prefetch is in progress are left out.
+  Document updated = Doc("a/2", 2, Map("a", 3));
+  persistence->Run("update", [&] { cache->Add(updated, Version(2)); });
+  cache->AwaitPrefetch();
+
+  persistence->Run("get", [&] {
+    EXPECT_EQ(cache->Get(doc1.key()), doc1);
+    EXPECT_EQ(1, hot.hits());
+    EXPECT_EQ(cache->Get(updated.key()), updated);
+    EXPECT_EQ(1, hot.hits());
+  });
+}
+
+TEST(LevelDbRemoteDocumentCacheTest, ReadOnlyTransactionsReadFromSnapshot) {
+  auto persistence = LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  Document doc = Doc("a/1", 1, Map("a", 1));
+  Document updated = Doc("a/1", 2, Map("a", 2));
+  core::Query query = testutil::Query("a");
+
+  persistence->Run("add", [&] { cache->Add(doc, Version(1)); });
+
+  int64_t version = persistence->RunReadOnly("read", [&] {
+    EXPECT_TRUE(persistence->in_read_only_transaction());
+
+    // Commit a write from another thread while the snapshot is held.
+    std::thread writer([&] {
+      EXPECT_FALSE(persistence->in_read_only_transaction());
+      persistence->Run("update", [&] { cache->Add(updated, Version(2)); });
+    });
+    writer.join();
+
+    EXPECT_EQ(cache->Get(doc.key()), doc);
+    DocumentMap matching = cache->GetMatching(query, SnapshotVersion::None());
+    ASSERT_EQ(matching.size(), 1u);
+    EXPECT_EQ(Document(matching.underlying_map().begin()->second), doc);
+  });
+
+  EXPECT_FALSE(persistence->in_read_only_transaction());
+  EXPECT_NE(version, persistence->write_version());
+  persistence->Run("get", [&] { EXPECT_EQ(cache->Get(doc.key()), updated); });
+}
+
+TEST(LevelDbRemoteDocumentCacheTest, GroupCommitHoldsWritesUntilFlushed) {
+  auto persistence = LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  Document doc1 = Doc("a/1", 1, Map("a", 1));
+  Document doc2 = Doc("a/2", 1, Map("a", 2));
+
+  int flushes_scheduled = 0;
+  persistence->EnableGroupCommit([&] { ++flushes_scheduled; });
+
+  persistence->Run("add 1", [&] { cache->Add(doc1, Version(1)); });
+  persistence->Run("add 2", [&] { cache->Add(doc2, Version(1)); });
+  EXPECT_EQ(flushes_scheduled, 1);
+
+  // Transactions read through the pending writes...
+  persistence->Run("get", [&] { EXPECT_EQ(cache->Get(doc1.key()), doc1); });
+
+  // ... but LevelDB doesn't have them yet.
+  int64_t version = persistence->RunReadOnly(
+      "read", [&] { EXPECT_EQ(cache->Get(doc1.key()), absl::nullopt); });
+  EXPECT_NE(version, persistence->write_version());
+
+  persistence->FlushPendingCommits();
+  version = persistence->RunReadOnly("read", [&] {
+    EXPECT_EQ(cache->Get(doc1.key()), doc1);
+    EXPECT_EQ(cache->Get(doc2.key()), doc2);
+  });
+  EXPECT_EQ(version, persistence->write_version());
+
+  persistence->Run("add 1 again", [&] { cache->Add(doc1, Version(2)); });
+  EXPECT_EQ(flushes_scheduled, 2);
+}
+
+TEST(LevelDbRemoteDocumentCacheTest, StoresLargeValuesInChunks) {
+  auto persistence = LevelDbPersistenceForTesting();
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+  std::string large(300 * 1024, 'x');
+  Document doc = Doc("a/1", 1, Map("large", large, "small", 1));
+  Document updated = Doc("a/1", 2, Map("large", large, "small", 2));
+  Document small = Doc("a/1", 3, Map("small", 3));
+
+  persistence->Run("test", [&] {
+    cache->Add(doc, Version(1));
+    std::vector<std::string> chunk_ids = ChunkIds(persistence.get(), doc.key());
+    EXPECT_EQ(chunk_ids.size(), 1u);
+    EXPECT_EQ(cache->Get(doc.key()), doc);
+
+    // Filters on moved values still match.
+    core::Query query = testutil::Query("a").AddingFilter(
+        testutil::Filter("large", "==", large.c_str()));
+    DocumentMap matching = cache->GetMatching(query, SnapshotVersion::None());
+    ASSERT_EQ(matching.size(), 1u);
+    EXPECT_EQ(Document(matching.underlying_map().begin()->second), doc);
+
+    // An update that leaves the large value as is keeps its chunk.
+    cache->Add(updated, Version(2));
+    EXPECT_EQ(ChunkIds(persistence.get(), doc.key()), chunk_ids);
+    EXPECT_EQ(cache->Get(doc.key()), updated);
+
+    cache->Add(small, Version(3));
+    EXPECT_TRUE(ChunkIds(persistence.get(), doc.key()).empty());
+    EXPECT_EQ(cache->Get(doc.key()), small);
+
+    cache->Add(doc, Version(4));
+    cache->Remove(doc.key());
+    EXPECT_TRUE(ChunkIds(persistence.get(), doc.key()).empty());
+  });
+}
+
+TEST(LevelDbRemoteDocumentCacheTest, CompressesDocumentsWithDictionary) {
+  Path dir = LevelDbDir();
+  LevelDbOptions options;
+  options.compress_documents = true;
+  auto persistence =
+      LevelDbPersistenceForTesting(dir, LruParams::Default(), options);
+  LevelDbRemoteDocumentCache* cache = persistence->remote_document_cache();
+
+  std::vector<Document> docs;
+  for (int i = 0; i < 20; ++i) {
+    docs.push_back(Doc("a/" + std::to_string(i), 1,
+                       Map("description", "a document like all the others",
+                           "count", i)));
+  }
+
+  persistence->Run("add", [&] {
+    for (const Document& doc : docs) {
+      cache->Add(doc, Version(1));
+    }
+
+    LevelDbTransaction* transaction = persistence->current_transaction();
+    std::string dictionary;
+    EXPECT_TRUE(
+        transaction
+            ->Get(LevelDbCompressionDictionaryKey::Key(testutil::Resource("a")),
+                  &dictionary)
+            .ok());
+
+    // Documents written once the dictionary exists are compressed with it.
+    std::string row;
+    ASSERT_TRUE(
+        transaction->Get(LevelDbRemoteDocumentKey::Key(docs.back().key()), &row)
+            .ok());
+    EXPECT_EQ(row[0], '\0');
+    EXPECT_EQ(cache->Get(docs.back().key()), docs.back());
+  });
+  persistence->Shutdown();
+
+  // Compressed documents stay readable once compression is turned off.
+  persistence = LevelDbPersistenceForTesting(dir);
+  cache = persistence->remote_document_cache();
+  persistence->Run("read", [&] {
+    for (const Document& doc : docs) {
+      EXPECT_EQ(cache->Get(doc.key()), doc);
+    }
+
+    core::Query query =
+        testutil::Query("a").AddingFilter(testutil::Filter("count", "==", 3));
+    DocumentMap matching = cache->GetMatching(query, SnapshotVersion::None());
+    ASSERT_EQ(matching.size(), 1u);
+    EXPECT_EQ(Document(matching.underlying_map().begin()->second), docs[3]);
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -20,6 +20,7 @@
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
 #include "Firestore/core/src/firebase/firestore/util/path.h"
 #include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
@@ -34,6 +35,7 @@ namespace {
 
 using core::Query;
 using model::DocumentKey;
+using model::DocumentKeySet;
 using model::ListenSequenceNumber;
 using model::SnapshotVersion;
 using model::TargetId;
@@ -117,18 +119,62 @@ TEST_F(LevelDbTargetCacheTest, RemoveMatchingKeysForTargetID) {
     ASSERT_TRUE(cache->Contains(key2));
     ASSERT_TRUE(cache->Contains(key3));
 
-    cache->RemoveAllKeysForTarget(1);
+    cache->RemoveAllKeysForTarget(1, persistence_->current_sequence_number());
     ASSERT_FALSE(cache_->Contains(key1));
     ASSERT_FALSE(cache_->Contains(key2));
     ASSERT_TRUE(cache_->Contains(key3));
 
-    cache->RemoveAllKeysForTarget(2);
+    cache->RemoveAllKeysForTarget(2, persistence_->current_sequence_number());
     ASSERT_FALSE(cache_->Contains(key1));
     ASSERT_FALSE(cache_->Contains(key2));
     ASSERT_FALSE(cache_->Contains(key3));
   });
 }
 
+TEST_F(LevelDbTargetCacheTest, KeepsManyMatchingKeysInChunks) {
+  persistence_->Run("test_keeps_many_matching_keys_in_chunks", [&]() {
+    LevelDbTargetCache* cache = leveldb_cache();
+
+    // Enough keys to split chunks several times, added out of order.
+    DocumentKeySet evens;
+    DocumentKeySet odds;
+    for (int i = 0; i < 2000; ++i) {
+      DocumentKey key = testutil::Key("foo/" + std::to_string(10000 + i));
+      if (i % 2 == 0) {
+        evens = evens.insert(key);
+      } else {
+        odds = odds.insert(key);
+      }
+    }
+    cache->AddMatchingKeys(odds, 1);
+    cache->AddMatchingKeys(evens, 1);
+    cache->AddMatchingKeys(evens, 2);
+
+    DocumentKeySet all = evens;
+    for (const DocumentKey& key : odds) {
+      all = all.insert(key);
+    }
+    ASSERT_EQ(cache->GetMatchingKeys(1), all);
+    ASSERT_EQ(cache->GetMatchingKeys(2), evens);
+
+    cache->RemoveMatchingKeys(evens, 1);
+    ASSERT_EQ(cache->GetMatchingKeys(1), odds);
+    ASSERT_EQ(cache->GetMatchingKeys(2), evens);
+
+    cache->RemoveMatchingKeys(odds, 1);
+    ASSERT_EQ(cache->GetMatchingKeys(1), DocumentKeySet{});
+
+    DocumentKey first = testutil::Key("foo/10000");
+    cache->AddMatchingKeys(DocumentKeySet{first}, 1);
+    ASSERT_EQ(cache->GetMatchingKeys(1), DocumentKeySet{first});
+
+    cache->RemoveAllKeysForTarget(2, persistence_->current_sequence_number());
+    ASSERT_EQ(cache->GetMatchingKeys(2), DocumentKeySet{});
+    ASSERT_TRUE(cache->Contains(first));
+    ASSERT_FALSE(cache->Contains(testutil::Key("foo/10002")));
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
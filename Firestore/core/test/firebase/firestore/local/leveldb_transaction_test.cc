@@ -218,6 +218,35 @@ TEST_F(LevelDbTransactionTest, ProtobufSupport) {
             parsed->last_listen_sequence_number);
 }
 
+TEST_F(LevelDbTransactionTest, ProtobufReplacesPendingValue) {
+  LevelDbTransaction transaction(db_.get(), "ProtobufReplacesPendingValue");
+
+  transaction.Put("the_key", std::string(1024, 'x'));
+  transaction.Delete("other_key");
+
+  Message<firestore_client_Target> target;
+  target->target_id = 3;
+  transaction.Put("the_key", target);
+  transaction.Put("other_key", target);
+
+  std::string the_value;
+  ASSERT_TRUE(transaction.Get("the_key", &the_value).ok());
+  std::string other_value;
+  ASSERT_TRUE(transaction.Get("other_key", &other_value).ok());
+  ASSERT_EQ(the_value, other_value);
+
+  ByteString bytes{the_value};
+  StringReader reader{bytes};
+  auto parsed = Message<firestore_client_Target>::TryParse(&reader);
+  ASSERT_TRUE(reader.ok());
+  ASSERT_EQ(3, parsed->target_id);
+
+  transaction.Commit();
+  std::string committed;
+  ASSERT_TRUE(db_->Get(ReadOptions(), "other_key", &committed).ok());
+  ASSERT_EQ(the_value, committed);
+}
+
 TEST_F(LevelDbTransactionTest, CanIterateAndDelete) {
   LevelDbTransaction transaction(db_.get(), "CanIterateAndDelete");
 
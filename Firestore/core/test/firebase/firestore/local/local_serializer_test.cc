@@ -40,6 +40,7 @@
 #include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
 #include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
 #include "Firestore/core/src/firebase/firestore/util/status.h"
 #include "Firestore/core/test/firebase/firestore/nanopb/nanopb_testing.h"
 #include "Firestore/core/test/firebase/firestore/testutil/status_testing.h"
@@ -283,6 +284,68 @@ TEST_F(LocalSerializerTest, EncodesDocumentAsMaybeDocument) {
   ExpectRoundTrip(doc, maybe_doc_proto, doc.type());
 }
 
+TEST_F(LocalSerializerTest, WritesReceivedDocumentsAsReceived) {
+  v1::Document doc_proto;
+  doc_proto.set_name("projects/p/databases/d/documents/some/path");
+  v1::Value value_proto;
+  value_proto.set_string_value("bar");
+  doc_proto.mutable_fields()->insert({"foo", value_proto});
+  doc_proto.mutable_update_time()->set_nanos(42000);
+  // Not part of the local format, but kept as it was received.
+  doc_proto.mutable_create_time()->set_nanos(1000);
+
+  v1::ListenResponse response_proto;
+  *response_proto.mutable_document_change()->mutable_document() = doc_proto;
+  response_proto.mutable_document_change()->add_target_ids(1);
+  ByteString response_bytes = ProtobufSerialize(response_proto);
+
+  StringReader response_reader(response_bytes);
+  auto response =
+      Message<google_firestore_v1_ListenResponse>::TryParse(&response_reader);
+  pb_istream_t encoded_response =
+      pb_istream_from_buffer(response_bytes.data(), response_bytes.size());
+  auto watch_change = remote_serializer.DecodeWatchChangeWithEncodedDocument(
+      &response_reader, *response, &encoded_response);
+  ASSERT_OK(response_reader.status());
+  const MaybeDocument& received =
+      *static_cast<remote::DocumentWatchChange&>(*watch_change).new_document();
+
+  absl::optional<std::string> encoded =
+      serializer.EncodeReceivedDocument(received);
+  ASSERT_TRUE(encoded);
+
+  ::firestore::client::MaybeDocument maybe_doc_proto;
+  *maybe_doc_proto.mutable_document() = doc_proto;
+  EXPECT_EQ(ByteString(*encoded), ProtobufSerialize(maybe_doc_proto));
+
+  StringReader reader(*encoded);
+  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+  MaybeDocument decoded = serializer.DecodeMaybeDocument(&reader, *message);
+  EXPECT_OK(reader.status());
+  EXPECT_EQ(decoded, Doc("some/path", /*version=*/42, Map("foo", "bar")));
+
+  // Documents that weren't received from Watch have to be encoded.
+  EXPECT_FALSE(serializer.EncodeReceivedDocument(
+      Doc("some/path", /*version=*/42, Map("foo", "bar"))));
+}
+
+TEST_F(LocalSerializerTest, DecodesProjectedDocument) {
+  Document doc = Doc("some/path", /*version=*/42,
+                     Map("a", 1, "b", Map("c", "x", "d", "y"), "e", true),
+                     DocumentState::kCommittedMutations);
+  ByteString bytes = EncodeMaybeDocument(&serializer, doc);
+
+  StringReader reader(bytes);
+  auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+  Document projected = serializer.DecodeDocumentFields(
+      &reader, *message, FieldMask{Field("a"), Field("b.d"), Field("f")});
+  EXPECT_OK(reader.status());
+
+  EXPECT_EQ(projected, Doc("some/path", /*version=*/42,
+                           Map("a", 1, "b", Map("d", "y")),
+                           DocumentState::kCommittedMutations));
+}
+
 TEST_F(LocalSerializerTest, EncodesNoDocumentAsMaybeDocument) {
   NoDocument no_doc = DeletedDoc("some/path", /*version=*/42);
 
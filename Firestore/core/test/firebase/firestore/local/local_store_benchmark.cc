@@ -0,0 +1,252 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/index_free_query_engine.h"
+#include "Firestore/core/src/firebase/firestore/local/leveldb_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/local_store.h"
+#include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
+#include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/query_result.h"
+#include "Firestore/core/src/firebase/firestore/local/reference_delegate.h"
+#include "Firestore/core/src/firebase/firestore/local/target_data.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
+#include "Firestore/core/test/firebase/firestore/remote/fake_target_metadata_provider.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using auth::User;
+using model::Document;
+using model::Mutation;
+using model::TargetId;
+using remote::DocumentWatchChange;
+using remote::FakeTargetMetadataProvider;
+using remote::RemoteEvent;
+using remote::WatchChangeAggregator;
+
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Map;
+using testutil::Query;
+
+constexpr const char* kCollection = "coll";
+
+// The first benchmark argument.
+enum PersistenceType {
+  kMemoryPersistence = 0,
+  kLevelDbPersistence = 1,
+};
+
+/**
+ * LRU parameters that make each garbage collection remove everything that
+ * isn't referenced, regardless of the size of the cache.
+ */
+LruParams CollectEverything() {
+  return LruParams{/* min_bytes_threshold= */ 0,
+                   /* percentile_to_collect= */ 100,
+                   /* maximum_sequence_numbers_to_collect= */ 1000,
+                   /* sequence_number_sample_size= */ 0,
+                   /* eviction_policy= */ LruEvictionPolicy::SequenceNumber};
+}
+
+std::unique_ptr<Persistence> MakePersistence(benchmark::State& state) {
+  switch (state.range(0)) {
+    case kMemoryPersistence:
+      state.SetLabel("Memory");
+      return MemoryPersistenceWithLruGcForTesting(CollectEverything());
+    case kLevelDbPersistence:
+      state.SetLabel("LevelDb");
+      return LevelDbPersistenceForTesting(CollectEverything());
+  }
+  HARD_FAIL("Unknown persistence type %s", state.range(0));
+}
+
+/** Runs over both persistence types with collections of various sizes. */
+void PersistenceAndSize(benchmark::internal::Benchmark* benchmark) {
+  for (int type : {kMemoryPersistence, kLevelDbPersistence}) {
+    for (int size : {10, 100, 1000}) {
+      benchmark->Args({type, size});
+    }
+  }
+}
+
+Document BenchmarkDoc(int index, int64_t version) {
+  return Doc(absl::StrCat(kCollection, "/doc", index), version,
+             Map("index", index, "even", index % 2 == 0, "value",
+                 "The quick brown fox jumps over the lazy dog"));
+}
+
+/** A `LocalStore` and its dependencies, set up for a single benchmark run. */
+class LocalStoreBenchmark {
+ public:
+  explicit LocalStoreBenchmark(benchmark::State& state)
+      : persistence_(MakePersistence(state)),
+        local_store_(persistence_.get(), &query_engine_,
+                     User::Unauthenticated()) {
+    local_store_.Start();
+  }
+
+  LocalStore* local_store() {
+    return &local_store_;
+  }
+
+  LruGarbageCollector* garbage_collector() {
+    return static_cast<LruDelegate*>(persistence_->reference_delegate())
+        ->garbage_collector();
+  }
+
+  /** Allocates a target for the whole benchmark collection. */
+  TargetId AllocateTarget() {
+    return local_store_.AllocateTarget(Query(kCollection).ToTarget())
+        .target_id();
+  }
+
+  /**
+   * Creates a remote event that adds (or updates) `count` documents in the
+   * benchmark collection at the given version.
+   */
+  RemoteEvent AddedRemoteEvent(TargetId target_id, int count, int64_t version) {
+    auto metadata_provider =
+        FakeTargetMetadataProvider::CreateEmptyResultProvider(
+            model::ResourcePath{kCollection}, {target_id});
+    WatchChangeAggregator aggregator{&metadata_provider};
+    for (int i = 0; i < count; ++i) {
+      Document doc = BenchmarkDoc(i, version);
+      DocumentWatchChange change{{target_id}, {}, doc.key(), doc};
+      aggregator.HandleDocumentChange(change);
+    }
+    return aggregator.CreateRemoteEvent(testutil::Version(version));
+  }
+
+  /** Adds `count` documents to the remote document cache. */
+  TargetId AddDocuments(int count, int64_t version = 1) {
+    TargetId target_id = AllocateTarget();
+    local_store_.ApplyRemoteEvent(AddedRemoteEvent(target_id, count, version));
+    return target_id;
+  }
+
+ private:
+  std::unique_ptr<Persistence> persistence_;
+  IndexFreeQueryEngine query_engine_;
+  LocalStore local_store_;
+};
+
+void BM_ExecuteQuery(benchmark::State& state) {
+  LocalStoreBenchmark bench{state};
+  auto size = static_cast<int>(state.range(1));
+  bench.AddDocuments(size);
+
+  core::Query query =
+      Query(kCollection).AddingFilter(Filter("even", "==", true));
+  for (auto _ : state) {
+    QueryResult result = bench.local_store()->ExecuteQuery(
+        query, /* use_previous_results= */ false);
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ExecuteQuery)->Apply(PersistenceAndSize);
+
+void BM_ApplyRemoteEvent(benchmark::State& state) {
+  LocalStoreBenchmark bench{state};
+  auto size = static_cast<int>(state.range(1));
+  TargetId target_id = bench.AllocateTarget();
+
+  int64_t version = 0;
+  for (auto _ : state) {
+    // Each event updates every document to a newer version.
+    state.PauseTiming();
+    RemoteEvent event = bench.AddedRemoteEvent(target_id, size, ++version);
+    state.ResumeTiming();
+
+    bench.local_store()->ApplyRemoteEvent(event);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ApplyRemoteEvent)->Apply(PersistenceAndSize);
+
+void BM_WriteLocally(benchmark::State& state) {
+  LocalStoreBenchmark bench{state};
+  auto size = static_cast<int>(state.range(1));
+  bench.AddDocuments(size);
+
+  for (auto _ : state) {
+    // A batch that overwrites every document in the collection.
+    state.PauseTiming();
+    std::vector<Mutation> mutations;
+    for (int i = 0; i < size; ++i) {
+      mutations.push_back(
+          testutil::SetMutation(absl::StrCat(kCollection, "/doc", i),
+                                Map("index", i, "written", true)));
+    }
+    state.ResumeTiming();
+
+    LocalWriteResult result =
+        bench.local_store()->WriteLocally(std::move(mutations));
+
+    // Keep the mutation queue from growing across iterations.
+    state.PauseTiming();
+    bench.local_store()->RejectBatch(result.batch_id());
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_WriteLocally)->Apply(PersistenceAndSize);
+
+void BM_CollectGarbage(benchmark::State& state) {
+  LocalStoreBenchmark bench{state};
+  auto size = static_cast<int>(state.range(1));
+
+  for (auto _ : state) {
+    // Fill the cache with documents that are only referenced by a target that
+    // is no longer listened to, so that collection removes all of them.
+    state.PauseTiming();
+    TargetId target_id = bench.AddDocuments(size);
+    bench.local_store()->ReleaseTarget(target_id);
+    state.ResumeTiming();
+
+    LruResults results =
+        bench.local_store()->CollectGarbage(bench.garbage_collector());
+    benchmark::DoNotOptimize(results);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_CollectGarbage)->Apply(PersistenceAndSize);
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
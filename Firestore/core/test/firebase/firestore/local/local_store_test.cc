@@ -16,6 +16,7 @@
 
 #include "Firestore/core/test/firebase/firestore/local/local_store_test.h"
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <string>
 #include <utility>
 #include <vector>
@@ -28,10 +29,12 @@
 #include "Firestore/core/src/firebase/firestore/local/local_write_result.h"
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/query_result.h"
+#include "Firestore/core/src/firebase/firestore/local/target_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/delete_mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/document_map.h"
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch_result.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
@@ -59,6 +62,7 @@ using model::DocumentKey;
 using model::DocumentKeySet;
 using model::DocumentMap;
 using model::DocumentState;
+using model::FieldIndex;
 using model::FieldValue;
 using model::ListenSequenceNumber;
 using model::MaybeDocument;
@@ -1012,6 +1016,156 @@ TEST_P(LocalStoreTest, CanExecuteMixedCollectionQueries) {
           Doc("foo/bonk", 0, Map("a", "b"), DocumentState::kLocalMutations)));
 }
 
+TEST_P(LocalStoreTest, CanExecuteKeyOrderedLimitQueries) {
+  core::Query query = Query("foo");
+  AllocateQuery(query);
+
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/a", 10, Map("matches", true)), {2}, {}));
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/c", 10, Map("matches", false)), {2}, {}));
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/d", 10, Map("matches", true)), {2}, {}));
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/e", 10, Map("matches", true)), {2}, {}));
+
+  // Local mutations add, remove and newly match documents ahead of the limit.
+  local_store_.WriteLocally(
+      {testutil::DeleteMutation("foo/a"),
+       testutil::SetMutation("foo/b", Map("matches", true)),
+       testutil::PatchMutation("foo/c", Map("matches", true), {})});
+
+  core::Query limit_query =
+      query.AddingFilter(testutil::Filter("matches", "==", true))
+          .WithLimitToFirst(3);
+  QueryResult query_result = ExecuteQuery(limit_query);
+  ASSERT_EQ(
+      DocMapToArray(query_result.documents()),
+      Vector(
+          Doc("foo/b", 0, Map("matches", true), DocumentState::kLocalMutations),
+          Doc("foo/c", 10, Map("matches", true),
+              DocumentState::kLocalMutations),
+          Doc("foo/d", 10, Map("matches", true))));
+}
+
+TEST_P(LocalStoreTest, CountsDocumentsMatchingQueries) {
+  core::Query query = Query("foo");
+  AllocateQuery(query);
+
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/a", 10, Map("matches", true)), {2}, {}));
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/c", 10, Map("matches", false)), {2}, {}));
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/d", 10, Map("matches", true)), {2}, {}));
+
+  local_store_.WriteLocally(
+      {testutil::DeleteMutation("foo/a"),
+       testutil::SetMutation("foo/b", Map("matches", true)),
+       testutil::PatchMutation("foo/c", Map("matches", true), {})});
+
+  core::Query matching =
+      query.AddingFilter(testutil::Filter("matches", "==", true));
+  EXPECT_EQ(local_store_.CountQuery(matching), 3);
+  EXPECT_EQ(local_store_.CountQuery(matching.WithLimitToFirst(2)), 2);
+  EXPECT_EQ(local_store_.CountQuery(Query("foo/b")), 1);
+  EXPECT_EQ(local_store_.CountQuery(Query("foo/a")), 0);
+}
+
+TEST_P(LocalStoreTest, ReadsSuccessivePagesFromTheBaseQuery) {
+  core::Query query = Query("foo").AddingOrderBy(testutil::OrderBy("n"));
+  AllocateQuery(query);
+  for (int n = 1; n <= 5; ++n) {
+    std::string path = std::string("foo/") + static_cast<char>('a' + n - 1);
+    ApplyRemoteEvent(UpdateRemoteEvent(Doc(path, 10, Map("n", n)), {2}, {}));
+  }
+
+  auto page_after = [&](double n) {
+    return query.StartingAt(core::Bound({Value(n)}, /* is_before= */ false))
+        .WithLimitToFirst(2);
+  };
+
+  // A first page on its own runs like any other query...
+  ExecuteQuery(query.WithLimitToFirst(2));
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 5);
+
+  // ...while the second page reads the base query once...
+  ExecuteQuery(page_after(2));
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 5);
+  FSTAssertQueryReturned("foo/c", "foo/d");
+
+  // ...and later pages are sliced from its results.
+  ExecuteQuery(page_after(4));
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 0);
+  FSTAssertQueryReturned("foo/e");
+
+  // The results follow local and remote changes without being read again.
+  WriteMutation(testutil::SetMutation("foo/f", Map("n", 4.5)));
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/e", 11, Map("n", 0)), {2}, {}));
+  ExecuteQuery(page_after(4));
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 0);
+  FSTAssertQueryReturned("foo/f");
+  ExecuteQuery(page_after(-1));
+  FSTAssertQueryReturned("foo/a", "foo/e");
+
+  // Deleted documents leave the results.
+  WriteMutation(testutil::DeleteMutation("foo/e"));
+  ExecuteQuery(page_after(-1));
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 0);
+  FSTAssertQueryReturned("foo/a", "foo/b");
+}
+
+TEST_P(LocalStoreTest, ReadsDocumentsInBoundingBoxes) {
+  local_store_.AddFieldIndex(FieldIndex(
+      "foo",
+      {{testutil::Field("location"), FieldIndex::Segment::Kind::Geohash}}));
+  AllocateQuery(Query("foo"));
+
+  ApplyRemoteEvent(UpdateRemoteEvent(
+      Doc("foo/a", 10, Map("location", GeoPoint(37.77, -122.42))), {2}, {}));
+  ApplyRemoteEvent(UpdateRemoteEvent(
+      Doc("foo/b", 10, Map("location", GeoPoint(37.80, -122.27))), {2}, {}));
+  ApplyRemoteEvent(UpdateRemoteEvent(
+      Doc("foo/c", 10, Map("location", GeoPoint(40.71, -74.01))), {2}, {}));
+
+  local_store_.WriteLocally(
+      {testutil::PatchMutation("foo/b", Map("location", GeoPoint(0, 0)), {}),
+       testutil::SetMutation("foo/d",
+                             Map("location", GeoPoint(37.75, -122.45)))});
+
+  DocumentMap results = local_store_.GetDocumentsInBoundingBox(
+      testutil::Resource("foo"), testutil::Field("location"),
+      GeoPoint(37.6, -122.6), GeoPoint(37.9, -122.2));
+  std::vector<DocumentKey> keys;
+  for (const auto& kv : results.underlying_map()) {
+    keys.push_back(kv.first);
+  }
+  EXPECT_EQ(keys, (std::vector<DocumentKey>{Key("foo/a"), Key("foo/d")}));
+}
+
+TEST_P(LocalStoreTest, ExplainsQueries) {
+  core::Query query =
+      Query("foo").AddingFilter(testutil::Filter("matches", "==", true));
+  AllocateQuery(query);
+
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/a", 10, Map("matches", true)), {2}, {}));
+  ApplyRemoteEvent(
+      UpdateRemoteEvent(Doc("foo/c", 10, Map("matches", false)), {2}, {}));
+  local_store_.WriteLocally(
+      {testutil::PatchMutation("foo/c", Map("matches", true), {})});
+
+  QueryExplanation explanation = local_store_.ExplainQuery(query);
+  EXPECT_EQ(explanation.engine, query_engine_.type());
+  EXPECT_EQ(explanation.path, QueryEngine::Path::FullScan);
+  EXPECT_EQ(explanation.documents_matched, 2);
+  EXPECT_EQ(explanation.mutation_batches_applied, 1);
+
+  explanation = local_store_.ExplainQuery(Query("foo/c"));
+  EXPECT_EQ(explanation.documents_matched, 1);
+  EXPECT_EQ(explanation.mutation_batches_applied, 1);
+}
+
 TEST_P(LocalStoreTest, ReadsAllDocumentsForInitialCollectionQueries) {
   core::Query query = Query("foo");
   local_store_.AllocateTarget(query.ToTarget());
@@ -1028,6 +1182,45 @@ TEST_P(LocalStoreTest, ReadsAllDocumentsForInitialCollectionQueries) {
   FSTAssertMutationsRead(/* by_key= */ 0, /* by_query= */ 1);
 }
 
+TEST_P(LocalStoreTest, ReusesOverlaysUntilMutationQueueChanges) {
+  core::Query query = Query("foo");
+  local_store_.AllocateTarget(query.ToTarget());
+
+  WriteMutation(testutil::SetMutation("foo/bar", Map("a", 1)));
+  ExecuteQuery(query);
+
+  QueryResult query_result = ExecuteQuery(query);
+  FSTAssertMutationsRead(/* by_key= */ 0, /* by_query= */ 0);
+  ASSERT_EQ(DocMapToArray(query_result.documents()),
+            Vector(Doc("foo/bar", 0, Map("a", 1),
+                       DocumentState::kLocalMutations)));
+
+  WriteMutation(testutil::PatchMutation("foo/bar", Map("b", 2)));
+  query_result = ExecuteQuery(query);
+  FSTAssertMutationsRead(/* by_key= */ 0, /* by_query= */ 2);
+  ASSERT_EQ(DocMapToArray(query_result.documents()),
+            Vector(Doc("foo/bar", 0, Map("a", 1, "b", 2),
+                       DocumentState::kLocalMutations)));
+}
+
+TEST_P(LocalStoreTest, ReusesResultsUntilDocumentsChange) {
+  core::Query query = Query("foo");
+  local_store_.AllocateTarget(query.ToTarget());
+
+  ApplyRemoteEvent(UpdateRemoteEvent(Doc("foo/bar", 10, Map()), {2}, {}));
+  ExecuteQuery(query);
+  FSTAssertQueryReturned("foo/bar");
+
+  ExecuteQuery(query);
+  FSTAssertRemoteDocumentsRead(/* by_key= */ 0, /* by_query= */ 0);
+  FSTAssertMutationsRead(/* by_key= */ 0, /* by_query= */ 0);
+  FSTAssertQueryReturned("foo/bar");
+
+  WriteMutation(testutil::SetMutation("foo/baz", Map()));
+  ExecuteQuery(query);
+  FSTAssertQueryReturned("foo/bar", "foo/baz");
+}
+
 TEST_P(LocalStoreTest, PersistsResumeTokens) {
   // This test only works in the absence of the FSTEagerGarbageCollector.
   if (IsGcEager()) return;
@@ -1062,6 +1255,39 @@ TEST_P(LocalStoreTest, PersistsResumeTokens) {
   ASSERT_GT(new_sequence_number, initial_sequence_number);
 }
 
+TEST_P(LocalStoreTest, BuffersResumeTokenOnlyUpdates) {
+  core::Query query = Query("foo/bar");
+  TargetId target_id = AllocateQuery(query);
+
+  auto persisted_resume_token = [&] {
+    return persistence_->Run("Get persisted target", [&] {
+      return persistence_->target_cache()
+          ->GetTarget(query.ToTarget())
+          ->resume_token();
+    });
+  };
+
+  // The first resume token is persisted right away.
+  ApplyRemoteEvent(NoChangeEvent(target_id, 1000));
+  ASSERT_EQ(persisted_resume_token(), testutil::ResumeToken(1000));
+
+  // Later updates that only change the resume token are buffered...
+  ApplyRemoteEvent(NoChangeEvent(target_id, 2000));
+  ASSERT_EQ(persisted_resume_token(), testutil::ResumeToken(1000));
+
+  // ... until they are explicitly written out...
+  local_store_.PersistBufferedTargetData();
+  ASSERT_EQ(persisted_resume_token(), testutil::ResumeToken(2000));
+
+  // ... or the oldest buffered update is five minutes old.
+  ApplyRemoteEvent(NoChangeEvent(target_id, 3000));
+  ASSERT_EQ(persisted_resume_token(), testutil::ResumeToken(2000));
+  int64_t five_minutes_later = 3000 + 5 * 60 * 1000000;
+  ApplyRemoteEvent(NoChangeEvent(target_id, five_minutes_later));
+  ASSERT_EQ(persisted_resume_token(),
+            testutil::ResumeToken(five_minutes_later));
+}
+
 TEST_P(LocalStoreTest, RemoteDocumentKeysForTarget) {
   core::Query query = Query("foo");
   AllocateQuery(query);
@@ -1481,6 +1707,100 @@ TEST_P(LocalStoreTest, GetHighestUnacknowledgeBatchId) {
   ASSERT_EQ(-1, local_store_.GetHighestUnacknowledgedBatchId());
 }
 
+TEST_P(LocalStoreTest, ReportsAFullMutationQueue) {
+  EXPECT_FALSE(local_store_.IsMutationQueueFull());
+
+  local_store_.set_mutation_queue_limits(2, 0);
+  WriteMutation(testutil::SetMutation("foo/bar", Map("abc", 123)));
+  EXPECT_FALSE(local_store_.IsMutationQueueFull());
+
+  WriteMutation(testutil::SetMutation("foo/baz", Map("abc", 123)));
+  EXPECT_TRUE(local_store_.IsMutationQueueFull());
+
+  AcknowledgeMutationWithVersion(1);
+  EXPECT_FALSE(local_store_.IsMutationQueueFull());
+
+  local_store_.set_mutation_queue_limits(0, 0);
+  WriteMutation(testutil::SetMutation("foo/qux", Map("abc", 123)));
+  EXPECT_FALSE(local_store_.IsMutationQueueFull());
+}
+
+TEST_P(LocalStoreTest, CompactsWritesIntoTheLastBatch) {
+  local_store_.set_write_compaction_enabled(true);
+
+  WriteMutation(testutil::SetMutation("foo/bar", Map("a", 1)));
+  WriteMutation(testutil::PatchMutation("foo/bar", Map("b", 2), {}));
+  EXPECT_EQ(1, local_store_.GetHighestUnacknowledgedBatchId());
+  FSTAssertChanged(
+      Doc("foo/bar", 0, Map("a", 1, "b", 2), DocumentState::kLocalMutations));
+  FSTAssertContains(
+      Doc("foo/bar", 0, Map("a", 1, "b", 2), DocumentState::kLocalMutations));
+
+  WriteMutation(testutil::SetMutation("foo/bar", Map("c", 3)));
+  EXPECT_EQ(1, local_store_.GetHighestUnacknowledgedBatchId());
+  FSTAssertContains(
+      Doc("foo/bar", 0, Map("c", 3), DocumentState::kLocalMutations));
+
+  // Writes to other documents get their own batch.
+  WriteMutation(testutil::SetMutation("foo/baz", Map("a", 1)));
+  EXPECT_EQ(2, local_store_.GetHighestUnacknowledgedBatchId());
+}
+
+TEST_P(LocalStoreTest, DoesNotCompactWritesIntoFetchedBatches) {
+  local_store_.set_write_compaction_enabled(true);
+
+  WriteMutation(testutil::SetMutation("foo/bar", Map("a", 1)));
+  ASSERT_TRUE(local_store_.GetNextMutationBatch(model::kBatchIdUnknown));
+
+  // The first batch may already be on its way to the backend.
+  WriteMutation(testutil::PatchMutation("foo/bar", Map("b", 2), {}));
+  EXPECT_EQ(2, local_store_.GetHighestUnacknowledgedBatchId());
+  FSTAssertContains(
+      Doc("foo/bar", 0, Map("a", 1, "b", 2), DocumentState::kLocalMutations));
+}
+
+TEST_P(LocalStoreTest, DoesNotCompactWritesWithWeakerPreconditions) {
+  local_store_.set_write_compaction_enabled(true);
+
+  // The update fails while foo/bar is missing, but the merge applies anyway.
+  WriteMutation(testutil::PatchMutation("foo/bar", Map("a", 1), {}));
+  WriteMutation(testutil::PatchMutation("foo/bar", Map("b", 2),
+                                        {testutil::Field("b")}));
+  EXPECT_EQ(2, local_store_.GetHighestUnacknowledgedBatchId());
+  FSTAssertContains(
+      Doc("foo/bar", 0, Map("b", 2), DocumentState::kLocalMutations));
+}
+
+TEST_P(LocalStoreTest, ReadsCurrentRemoteDocumentsInActiveViews) {
+  using std::chrono::minutes;
+
+  // A snapshot received ten minutes ago.
+  Timestamp now = Timestamp::Now();
+  int64_t version = (now.seconds() - 10 * 60) * 1000000;
+  Document doc = Doc("foo/bar", version, Map("it", "base"));
+
+  TargetId target_id = AllocateQuery(Query("foo"));
+  ApplyRemoteEvent(AddedRemoteEvent(doc, {target_id}));
+
+  // Not in the results of an active listen yet.
+  EXPECT_FALSE(
+      local_store_.ReadCurrentRemoteDocuments({Key("foo/bar")}, minutes(60)));
+
+  NotifyLocalViewChanges(TestViewChanges(target_id, /* from_cache= */ false,
+                                         {"foo/bar"}, {}));
+  auto documents =
+      local_store_.ReadCurrentRemoteDocuments({Key("foo/bar")}, minutes(60));
+  ASSERT_TRUE(documents);
+  EXPECT_EQ(*documents, std::vector<MaybeDocument>{doc});
+
+  // Too old.
+  EXPECT_FALSE(
+      local_store_.ReadCurrentRemoteDocuments({Key("foo/bar")}, minutes(1)));
+  // Not in any view.
+  EXPECT_FALSE(local_store_.ReadCurrentRemoteDocuments(
+      {Key("foo/bar"), Key("foo/baz")}, minutes(60)));
+}
+
 TEST_P(LocalStoreTest, OnlyPersistsUpdatesForDocumentsWhenVersionChanges) {
   core::Query query = Query("foo");
   AllocateQuery(query);
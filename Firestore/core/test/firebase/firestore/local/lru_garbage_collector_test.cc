@@ -16,6 +16,7 @@
 
 #include "Firestore/core/test/firebase/firestore/local/lru_garbage_collector_test.h"
 
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
@@ -35,9 +36,11 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/precondition.h"
 #include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/model/unknown_document.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/strings/str_cat.h"
 #include "gtest/gtest.h"
@@ -54,10 +57,12 @@ using model::DocumentKeySet;
 using model::DocumentState;
 using model::ListenSequenceNumber;
 using model::Mutation;
+using model::NoDocument;
 using model::ObjectValue;
 using model::Precondition;
 using model::SetMutation;
 using model::TargetId;
+using model::UnknownDocument;
 
 using testutil::Key;
 using testutil::Query;
@@ -269,6 +274,27 @@ TEST_P(LruGarbageCollectorTest, SequenceNumberForFiftyQueries) {
   ASSERT_EQ(initial_sequence_number_ + 10, SequenceNumberForQueryCount(10));
 }
 
+TEST_P(LruGarbageCollectorTest, SequenceNumberEstimatedFromSample) {
+  LruParams params = LruParams::Default();
+  params.sequence_number_sample_size = 100;
+  NewTestResources(params);
+  for (int i = 0; i < 50; i++) {
+    AddNextQuery();
+  }
+
+  // The cache is smaller than the sample, so the result is exact.
+  ASSERT_EQ(initial_sequence_number_ + 10, SequenceNumberForQueryCount(10));
+
+  for (int i = 50; i < 1000; i++) {
+    AddNextQuery();
+  }
+
+  // The estimate should be close to the median, with a standard deviation of
+  // roughly 50 sequence numbers for a sample of 100.
+  ListenSequenceNumber estimate = SequenceNumberForQueryCount(500);
+  ASSERT_NEAR(initial_sequence_number_ + 500, estimate, 200);
+}
+
 TEST_P(LruGarbageCollectorTest,
        SequenceNumberForMultipleQueriesInATransaction) {
   // 50 queries, 9 with one transaction, incrementing from there. Should get
@@ -741,6 +767,151 @@ TEST_P(LruGarbageCollectorTest, GCRan) {
   ASSERT_EQ(100, results.documents_removed);
 }
 
+TEST_P(LruGarbageCollectorTest, SizeWeightedPolicyPrefersLargeDocuments) {
+  LruParams params = LruParams::Default();
+  params.min_bytes_threshold = 100;
+  params.percentile_to_collect = 1;
+  params.eviction_policy = LruEvictionPolicy::SizeWeighted;
+  NewTestResources(params);
+
+  // The small documents are older, so collecting by sequence number alone
+  // would remove them first.
+  std::vector<DocumentKey> small_docs;
+  for (int i = 0; i < 10; i++) {
+    persistence_->Run("Add a small document", [&] {
+      Document doc = CacheADocumentInTransaction();
+      MarkDocumentEligibleForGcInTransaction(doc.key());
+      small_docs.push_back(doc.key());
+    });
+  }
+  DocumentKey large_doc = persistence_->Run("Add a large document", [&] {
+    Document doc = NextTestDocumentWithValue(
+        WrapObject("data", std::string(100 * 1024, 'x')));
+    document_cache_->Add(doc, doc.version());
+    MarkDocumentEligibleForGcInTransaction(doc.key());
+    return doc.key();
+  });
+
+  // Freeing 1% of the cache only takes the large document.
+  LruResults results =
+      persistence_->Run("GC", [&] { return gc_->Collect({}); });
+  ASSERT_TRUE(results.did_run);
+  ASSERT_EQ(0, results.targets_removed);
+  ASSERT_EQ(1, results.documents_removed);
+
+  persistence_->Run("verify", [&] {
+    ASSERT_EQ(absl::nullopt, document_cache_->Get(large_doc));
+    for (const DocumentKey& key : small_docs) {
+      ASSERT_NE(absl::nullopt, document_cache_->Get(key));
+    }
+  });
+}
+
+TEST_P(LruGarbageCollectorTest, GCRanInSlices) {
+  LruParams params = LruParams::Default();
+  // Set a low threshold so we will definitely run.
+  params.min_bytes_threshold = 100;
+  NewTestResources(params);
+
+  // Add 100 targets and 10 documents to each.
+  for (int i = 0; i < 100; i++) {
+    persistence_->Run("Add a target and some documents", [&] {
+      TargetData target_data = AddNextQueryInTransaction();
+      for (int j = 0; j < 10; j++) {
+        Document doc = CacheADocumentInTransaction();
+        AddDocument(doc.key(), target_data.target_id());
+      }
+    });
+  }
+
+  // Each slice runs in its own transaction. Only the last one reports results.
+  int slices = 0;
+  LruResults results = LruResults::DidNotRun();
+  do {
+    ASSERT_FALSE(results.did_run);
+    results = persistence_->Run("GC slice", [&] {
+      return gc_->CollectSlice({}, /* max_entries= */ 7);
+    });
+    slices++;
+  } while (gc_->collection_in_progress());
+
+  // The results should match a collection run in one go.
+  ASSERT_TRUE(results.did_run);
+  ASSERT_EQ(10, results.targets_removed);
+  ASSERT_EQ(100, results.documents_removed);
+  ASSERT_GE(slices, 3);
+
+  // A subsequent collection starts over.
+  persistence_->Run("GC slice", [&] { gc_->CollectSlice({}, 7); });
+  ASSERT_TRUE(gc_->collection_in_progress());
+}
+
+TEST_P(LruGarbageCollectorTest, GCInSlicesRemovesOrphanedTombstones) {
+  LruParams params = LruParams::Default();
+  // Set a low threshold so we will definitely run, and collect no sequence
+  // numbers, so that only tombstones are removed.
+  params.min_bytes_threshold = 100;
+  params.percentile_to_collect = 0;
+  NewTestResources(params);
+
+  std::vector<DocumentKey> orphaned_tombstones;
+  std::vector<DocumentKey> expected_retained;
+  persistence_->Run("Add documents and tombstones", [&] {
+    for (int i = 0; i < 10; i++) {
+      NoDocument deleted(NextTestDocKey(), Version(2),
+                         /* has_committed_mutations= */ false);
+      document_cache_->Add(deleted, deleted.version());
+      MarkDocumentEligibleForGcInTransaction(deleted.key());
+      orphaned_tombstones.push_back(deleted.key());
+    }
+    UnknownDocument unknown(NextTestDocKey(), Version(2));
+    document_cache_->Add(unknown, unknown.version());
+    MarkDocumentEligibleForGcInTransaction(unknown.key());
+    orphaned_tombstones.push_back(unknown.key());
+
+    // Orphaned documents that exist are left to the LRU policy.
+    Document doc = NextTestDocumentWithValue(big_object_value_);
+    document_cache_->Add(doc, doc.version());
+    MarkDocumentEligibleForGcInTransaction(doc.key());
+    expected_retained.push_back(doc.key());
+
+    // Tombstones in a target are still needed.
+    TargetData target_data = AddNextQueryInTransaction();
+    NoDocument in_target(NextTestDocKey(), Version(2), false);
+    document_cache_->Add(in_target, in_target.version());
+    AddDocument(in_target.key(), target_data.target_id());
+    expected_retained.push_back(in_target.key());
+
+    // As are tombstones with pending mutations.
+    NoDocument mutated(NextTestDocKey(), Version(2), false);
+    document_cache_->Add(mutated, mutated.version());
+    MarkDocumentEligibleForGcInTransaction(mutated.key());
+    mutation_queue_->AddMutationBatch(Timestamp::Now(), {},
+                                      {MutationForDocument(mutated.key())});
+    expected_retained.push_back(mutated.key());
+  });
+
+  LruResults results = LruResults::DidNotRun();
+  do {
+    results = persistence_->Run("GC slice", [&] {
+      return gc_->CollectSlice({}, /* max_entries= */ 4);
+    });
+  } while (gc_->collection_in_progress());
+
+  ASSERT_TRUE(results.did_run);
+  ASSERT_EQ(0, results.targets_removed);
+  ASSERT_EQ(orphaned_tombstones.size(), results.documents_removed);
+  persistence_->Run("verify", [&] {
+    for (const DocumentKey& key : orphaned_tombstones) {
+      ASSERT_EQ(absl::nullopt, document_cache_->Get(key));
+    }
+    for (const DocumentKey& key : expected_retained) {
+      ASSERT_NE(absl::nullopt, document_cache_->Get(key))
+          << "Missing document " << key.ToString().c_str();
+    }
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
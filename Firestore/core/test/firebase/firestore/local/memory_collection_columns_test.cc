@@ -0,0 +1,208 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/memory_collection_columns.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using core::FieldFilter;
+using model::Document;
+using testutil::Doc;
+using testutil::Field;
+using testutil::Filter;
+using testutil::Map;
+using testutil::Value;
+using testutil::Version;
+
+class MemoryCollectionColumnsTest : public testing::Test {
+ protected:
+  void AddDocs(const std::vector<Document>& docs) {
+    for (const Document& doc : docs) {
+      columns_.Add(doc, Version(1));
+    }
+  }
+
+  /** Returns the indexes of the documents left after applying `filter`. */
+  std::vector<size_t> Narrow(const FieldFilter& filter) {
+    std::vector<uint8_t> candidates(columns_.size(), 1);
+    EXPECT_TRUE(columns_.Narrow(filter, &candidates));
+    return Survivors(candidates);
+  }
+
+  std::vector<size_t> Survivors(const std::vector<uint8_t>& candidates) {
+    std::vector<size_t> result;
+    for (size_t i = 0; i < candidates.size(); ++i) {
+      if (candidates[i]) result.push_back(i);
+    }
+    return result;
+  }
+
+  /**
+   * Verifies that narrowing by `filter` never removes a document that
+   * matches it.
+   */
+  void ExpectNarrowingIsSafe(const FieldFilter& filter) {
+    std::vector<uint8_t> candidates(columns_.size(), 1);
+    columns_.Narrow(filter, &candidates);
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      if (filter.Matches(columns_.document(i))) {
+        EXPECT_TRUE(candidates[i])
+            << filter.ToString() << " removed " << columns_.document(i);
+      }
+    }
+  }
+
+  MemoryCollectionColumns columns_;
+};
+
+TEST_F(MemoryCollectionColumnsTest, NarrowsNumericComparisons) {
+  AddDocs({
+      Doc("coll/a", 1, Map("n", 1)),
+      Doc("coll/b", 1, Map("n", 2.5)),
+      Doc("coll/c", 1, Map("n", 3)),
+      Doc("coll/d", 1, Map("n", "3")),
+      Doc("coll/e", 1, Map("other", 3)),
+      Doc("coll/f", 1, Map("n", -0.0)),
+  });
+
+  using Indexes = std::vector<size_t>;
+  EXPECT_EQ(Narrow(Filter("n", "<", 3)), (Indexes{0, 1, 5}));
+  EXPECT_EQ(Narrow(Filter("n", "<=", 2.5)), (Indexes{0, 1, 5}));
+  EXPECT_EQ(Narrow(Filter("n", "==", 3.0)), (Indexes{2}));
+  EXPECT_EQ(Narrow(Filter("n", "==", 0)), (Indexes{5}));
+  EXPECT_EQ(Narrow(Filter("n", ">=", 2.5)), (Indexes{1, 2}));
+  EXPECT_EQ(Narrow(Filter("n", ">", 1)), (Indexes{1, 2}));
+}
+
+TEST_F(MemoryCollectionColumnsTest, KeepsNumbersThatAreNotExactDoubles) {
+  int64_t big = (int64_t{1} << 53) + 1;
+  AddDocs({
+      Doc("coll/a", 1, Map("n", std::numeric_limits<double>::quiet_NaN())),
+      Doc("coll/b", 1, Map("n", big)),
+      Doc("coll/c", 1, Map("n", 1)),
+  });
+
+  EXPECT_EQ(Narrow(Filter("n", ">", 1)), (std::vector<size_t>{0, 1}));
+
+  // Filter values that cannot be compared as doubles are not evaluated.
+  std::vector<uint8_t> candidates(columns_.size(), 1);
+  EXPECT_FALSE(columns_.Narrow(Filter("n", "<", Value(big)), &candidates));
+  EXPECT_FALSE(columns_.Narrow(
+      Filter("n", "==", std::numeric_limits<double>::quiet_NaN()),
+      &candidates));
+  EXPECT_EQ(Survivors(candidates), (std::vector<size_t>{0, 1, 2}));
+}
+
+TEST_F(MemoryCollectionColumnsTest, NarrowsTimestampComparisons) {
+  AddDocs({
+      Doc("coll/a", 1, Map("t", Timestamp(100, 5))),
+      Doc("coll/b", 1, Map("t", Timestamp(100, 10))),
+      Doc("coll/c", 1, Map("t", Timestamp(101, 0))),
+      Doc("coll/d", 1, Map("t", 100)),
+  });
+
+  using Indexes = std::vector<size_t>;
+  EXPECT_EQ(Narrow(Filter("t", "<", Value(Timestamp(100, 10)))),
+            (Indexes{0}));
+  EXPECT_EQ(Narrow(Filter("t", "==", Value(Timestamp(100, 10)))),
+            (Indexes{1}));
+  EXPECT_EQ(Narrow(Filter("t", ">=", Value(Timestamp(100, 6)))),
+            (Indexes{1, 2}));
+}
+
+TEST_F(MemoryCollectionColumnsTest, NarrowsEveryFieldIndependently) {
+  AddDocs({
+      Doc("coll/a", 1, Map("x", 1, "y", 5)),
+      Doc("coll/b", 1, Map("x", 2, "y", 4)),
+      Doc("coll/c", 1, Map("x", 3, "y", 3)),
+  });
+
+  std::vector<uint8_t> candidates(columns_.size(), 1);
+  columns_.Narrow(Filter("x", ">=", 2), &candidates);
+  columns_.Narrow(Filter("y", ">=", 4), &candidates);
+  EXPECT_EQ(Survivors(candidates), (std::vector<size_t>{1}));
+}
+
+TEST_F(MemoryCollectionColumnsTest, LeavesOtherFiltersToTheQuery) {
+  AddDocs({
+      Doc("coll/a", 1, Map("s", "foo", "arr", testutil::Array(1, 2))),
+  });
+
+  std::vector<uint8_t> candidates(columns_.size(), 1);
+  EXPECT_FALSE(columns_.Narrow(Filter("s", "==", "foo"), &candidates));
+  EXPECT_FALSE(
+      columns_.Narrow(Filter("arr", "array-contains", 1), &candidates));
+  EXPECT_FALSE(columns_.Narrow(Filter("arr", "in", testutil::Array(1, 2)),
+                               &candidates));
+  EXPECT_EQ(Survivors(candidates), (std::vector<size_t>{0}));
+}
+
+TEST_F(MemoryCollectionColumnsTest, NarrowsToDocumentsContainingField) {
+  AddDocs({
+      Doc("coll/a", 1, Map("x", 1)),
+      Doc("coll/b", 1, Map("y", 1)),
+      Doc("coll/c", 1, Map("x", Map("nested", 1))),
+  });
+
+  std::vector<uint8_t> candidates(columns_.size(), 1);
+  columns_.NarrowToPresent(Field("x"), &candidates);
+  EXPECT_EQ(Survivors(candidates), (std::vector<size_t>{0, 2}));
+
+  candidates.assign(columns_.size(), 1);
+  columns_.NarrowToPresent(Field("x.nested"), &candidates);
+  EXPECT_EQ(Survivors(candidates), (std::vector<size_t>{2}));
+}
+
+TEST_F(MemoryCollectionColumnsTest, NeverRemovesMatchingDocuments) {
+  AddDocs({
+      Doc("coll/a", 1, Map("v", 1)),
+      Doc("coll/b", 1, Map("v", -1.5)),
+      Doc("coll/c", 1, Map("v", std::numeric_limits<double>::quiet_NaN())),
+      Doc("coll/d", 1, Map("v", std::numeric_limits<int64_t>::max())),
+      Doc("coll/e", 1, Map("v", -std::numeric_limits<double>::infinity())),
+      Doc("coll/f", 1, Map("v", Timestamp(0, 1))),
+      Doc("coll/g", 1, Map("v", "1")),
+      Doc("coll/h", 1, Map("v", nullptr)),
+      Doc("coll/i", 1, Map()),
+  });
+
+  for (const char* op : {"<", "<=", "==", ">=", ">"}) {
+    ExpectNarrowingIsSafe(Filter("v", op, 1));
+    ExpectNarrowingIsSafe(Filter("v", op, -1.5));
+    ExpectNarrowingIsSafe(Filter("v", op, Value(Timestamp(0, 1))));
+    ExpectNarrowingIsSafe(
+        Filter("v", op, Value(std::numeric_limits<int64_t>::min())));
+  }
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
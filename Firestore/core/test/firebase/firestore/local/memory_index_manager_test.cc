@@ -16,10 +16,21 @@
 
 #include "Firestore/core/test/firebase/firestore/local/index_manager_test.h"
 
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_index_manager.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_delegate.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key_set.h"
+#include "Firestore/core/src/firebase/firestore/model/field_index.h"
 #include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
@@ -27,6 +38,18 @@ namespace firebase {
 namespace firestore {
 namespace local {
 
+using model::DocumentKeySet;
+using model::FieldIndex;
+using testutil::Doc;
+using testutil::Field;
+using testutil::Filter;
+using testutil::Key;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Version;
+
+using Kind = FieldIndex::Segment::Kind;
+
 namespace {
 
 std::unique_ptr<Persistence> PersistenceFactory() {
@@ -39,6 +62,78 @@ INSTANTIATE_TEST_SUITE_P(MemoryIndexManagerTest,
                          IndexManagerTest,
                          ::testing::Values(PersistenceFactory));
 
+class MemoryFieldIndexTest : public ::testing::Test {
+ public:
+  MemoryFieldIndexTest()
+      : persistence_(MemoryPersistenceWithEagerGcForTesting()) {
+  }
+
+ protected:
+  void AddDocument(const model::Document& document) {
+    persistence_->remote_document_cache()->Add(document, Version(1));
+  }
+
+  void AddFieldIndex(const std::string& collection_id,
+                     const std::string& field) {
+    persistence_->index_manager()->AddFieldIndex(FieldIndex(
+        collection_id, {FieldIndex::Segment(Field(field), Kind::Ordered)}));
+  }
+
+  void AssertMatching(const core::Query& query,
+                      std::vector<std::string> expected_paths) {
+    DocumentKeySet expected;
+    for (const std::string& path : expected_paths) {
+      expected = expected.insert(Key(path));
+    }
+
+    absl::optional<DocumentKeySet> actual =
+        persistence_->index_manager()->GetDocumentsMatchingQuery(query);
+    ASSERT_TRUE(actual.has_value()) << query.ToString();
+    EXPECT_EQ(*actual, expected) << query.ToString();
+  }
+
+  std::unique_ptr<MemoryPersistence> persistence_;
+};
+
+TEST_F(MemoryFieldIndexTest, ServesPrefixRanges) {
+  AddDocument(Doc("contacts/1", 1, Map("name", "ada")));
+  AddDocument(Doc("contacts/2", 1, Map("name", "adam")));
+  AddFieldIndex("contacts", "name");
+  AddDocument(Doc("contacts/3", 1, Map("name", "alan")));
+  AddDocument(Doc("contacts/4", 1, Map("name", "Adele")));
+  AddDocument(Doc("contacts/5", 1, Map("name", 1)));
+  AddDocument(Doc("other/6", 1, Map("name", "ada")));
+
+  // U+F8FF sorts after the characters that names are made of.
+  core::Query query = testutil::Query("contacts");
+  AssertMatching(query.AddingFilter(Filter("name", ">=", "ad"))
+                     .AddingFilter(Filter("name", "<", "ad\xef\xa3\xbf")),
+                 {"contacts/1", "contacts/2"});
+  // Bounds are inclusive, so strict bounds are left to the query.
+  AssertMatching(query.AddingFilter(Filter("name", ">", "adam"))
+                     .AddingOrderBy(OrderBy("name")),
+                 {"contacts/2", "contacts/3"});
+  EXPECT_FALSE(persistence_->index_manager()->GetDocumentsMatchingQuery(
+      query.AddingFilter(Filter("age", ">", 1))));
+}
+
+TEST_F(MemoryFieldIndexTest, MaintainsEntriesOnWrite) {
+  AddFieldIndex("contacts", "name");
+  core::Query query =
+      testutil::Query("contacts").AddingFilter(Filter("name", "==", "ada"));
+
+  AddDocument(Doc("contacts/1", 1, Map("name", "ada")));
+  AddDocument(Doc("contacts/2", 1, Map("email", "ada")));
+  AssertMatching(query, {"contacts/1"});
+
+  AddDocument(Doc("contacts/1", 2, Map("name", "bob")));
+  AddDocument(Doc("contacts/2", 2, Map("name", "ada")));
+  AssertMatching(query, {"contacts/2"});
+
+  persistence_->remote_document_cache()->Remove(Key("contacts/2"));
+  AssertMatching(query, {});
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
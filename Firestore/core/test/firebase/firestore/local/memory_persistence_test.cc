@@ -0,0 +1,153 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_mutation_queue.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_target_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/target_data.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/no_document.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/filesystem_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/status_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using auth::User;
+using model::DatabaseId;
+using model::DocumentKeySet;
+using model::MutationBatch;
+using nanopb::ByteString;
+using remote::Serializer;
+using testutil::DeletedDoc;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+using testutil::Query;
+using testutil::TestTempDir;
+using testutil::Version;
+using util::Path;
+
+class MemoryPersistenceSnapshotTest : public ::testing::Test {
+ public:
+  MemoryPersistenceSnapshotTest()
+      : serializer_(Serializer(DatabaseId("p", "d"))),
+        path_(dir_.Child("memory_cache.snapshot")) {
+  }
+
+ protected:
+  LocalSerializer serializer_;
+  TestTempDir dir_;
+  Path path_;
+};
+
+TEST_F(MemoryPersistenceSnapshotTest, RoundTripsCache) {
+  auto persistence = MemoryPersistence::WithEagerGarbageCollector();
+  User user("alice");
+  TargetData target_data(Query("rooms").ToTarget(), 2, 7,
+                         QueryPurpose::Listen);
+
+  persistence->Run("Fill cache", [&] {
+    persistence->remote_document_cache()->Add(
+        Doc("rooms/a", 1, Map("name", "a")), Version(1));
+    persistence->remote_document_cache()->Add(
+        Doc("rooms/b/messages/c", 2, Map("text", "hi")), Version(2));
+    persistence->remote_document_cache()->Add(DeletedDoc("rooms/d", 3),
+                                              Version(3));
+
+    persistence->target_cache()->AddTarget(target_data);
+    persistence->target_cache()->AddMatchingKeys(
+        DocumentKeySet{Key("rooms/a"), Key("rooms/d")}, 2);
+    persistence->target_cache()->SetLastRemoteSnapshotVersion(Version(3));
+
+    MemoryMutationQueue* queue = persistence->GetMutationQueueForUser(user);
+    queue->Start();
+    queue->AddMutationBatch(Timestamp(1, 0), {},
+                            {testutil::SetMutation("rooms/e", Map())});
+    queue->SetLastStreamToken(ByteString("token"));
+  });
+  ASSERT_OK(persistence->SaveSnapshot(path_, serializer_));
+
+  auto loaded = MemoryPersistence::WithEagerGarbageCollector();
+  ASSERT_OK(loaded->LoadSnapshot(path_, serializer_));
+
+  loaded->Run("Verify cache", [&] {
+    MemoryRemoteDocumentCache* documents = loaded->remote_document_cache();
+    EXPECT_EQ(Doc("rooms/a", 1, Map("name", "a")),
+              documents->Get(Key("rooms/a")));
+    EXPECT_EQ(Doc("rooms/b/messages/c", 2, Map("text", "hi")),
+              documents->Get(Key("rooms/b/messages/c")));
+    EXPECT_EQ(DeletedDoc("rooms/d", 3), documents->Get(Key("rooms/d")));
+
+    MemoryTargetCache* targets = loaded->target_cache();
+    EXPECT_EQ(2, targets->highest_target_id());
+    EXPECT_EQ(Version(3), targets->GetLastRemoteSnapshotVersion());
+    EXPECT_EQ(target_data, targets->GetTarget(Query("rooms").ToTarget()));
+    EXPECT_EQ((DocumentKeySet{Key("rooms/a"), Key("rooms/d")}),
+              targets->GetMatchingKeys(2));
+
+    MemoryMutationQueue* queue = loaded->GetMutationQueueForUser(user);
+    std::vector<MutationBatch> batches = queue->AllMutationBatches();
+    ASSERT_EQ(1u, batches.size());
+    EXPECT_EQ(std::vector<model::Mutation>{testutil::SetMutation("rooms/e",
+                                                                 Map())},
+              batches[0].mutations());
+    EXPECT_EQ(ByteString("token"), queue->GetLastStreamToken());
+  });
+}
+
+TEST_F(MemoryPersistenceSnapshotTest, LoadFailsWithoutSnapshot) {
+  auto persistence = MemoryPersistence::WithEagerGarbageCollector();
+  EXPECT_EQ(Error::kNotFound,
+            persistence->LoadSnapshot(path_, serializer_).code());
+}
+
+TEST_F(MemoryPersistenceSnapshotTest, LoadRejectsCorruptSnapshot) {
+  {
+    std::ofstream out(path_.native_value(), std::ios::binary);
+    out << "not a snapshot";
+  }
+
+  auto persistence = MemoryPersistence::WithEagerGarbageCollector();
+  EXPECT_FALSE(persistence->LoadSnapshot(path_, serializer_).ok());
+  persistence->Run("Verify empty", [&] {
+    EXPECT_EQ(0, persistence->target_cache()->highest_target_id());
+  });
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
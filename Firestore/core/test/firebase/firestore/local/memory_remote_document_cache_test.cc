@@ -15,13 +15,23 @@
  */
 
 #include <memory>
+#include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/proto_sizer.h"
 #include "Firestore/core/src/firebase/firestore/local/reference_delegate.h"
 #include "Firestore/core/src/firebase/firestore/local/remote_document_cache.h"
+#include "Firestore/core/src/firebase/firestore/local/sizer.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
 #include "Firestore/core/test/firebase/firestore/local/persistence_testing.h"
 #include "Firestore/core/test/firebase/firestore/local/remote_document_cache_test.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
 
@@ -30,16 +40,159 @@ namespace firestore {
 namespace local {
 namespace {
 
+using model::DatabaseId;
+using model::DocumentKey;
+using model::DocumentMap;
+using model::SnapshotVersion;
+using testutil::Doc;
+using testutil::Filter;
+using testutil::Key;
+using testutil::Map;
+using testutil::OrderBy;
+using testutil::Query;
+using testutil::Version;
+
 std::unique_ptr<Persistence> PersistenceFactory() {
   return MemoryPersistenceWithEagerGcForTesting();
 }
 
+std::unique_ptr<Persistence> CompactPersistenceFactory() {
+  return MemoryPersistenceWithCompactStorageForTesting();
+}
+
+std::vector<DocumentKey> Keys(const DocumentMap& docs) {
+  std::vector<DocumentKey> result;
+  for (const auto& kv : docs.underlying_map()) {
+    result.push_back(kv.first);
+  }
+  return result;
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(MemoryRemoteDocumentCacheTest,
                          RemoteDocumentCacheTest,
                          testing::Values(PersistenceFactory));
 
+INSTANTIATE_TEST_SUITE_P(CompactMemoryRemoteDocumentCacheTest,
+                         RemoteDocumentCacheTest,
+                         testing::Values(CompactPersistenceFactory));
+
+TEST(MemoryRemoteDocumentCacheSizeTest, TracksByteSizeAsDocumentsChange) {
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithLruGcForTesting();
+  MemoryRemoteDocumentCache* cache = persistence->remote_document_cache();
+  const Sizer* sizer = persistence->sizer();
+  ASSERT_NE(sizer, nullptr);
+
+  auto small = Doc("coll/a", 1, Map("n", 1));
+  auto large = Doc("coll/a", 2, Map("n", 1, "s", "a somewhat longer value"));
+  auto other = Doc("coll/b", 1, Map("n", 2));
+
+  persistence->Run("test", [&] {
+    ASSERT_EQ(0, cache->byte_size());
+
+    cache->Add(small, Version(1));
+    cache->Add(other, Version(1));
+    ASSERT_EQ(sizer->CalculateByteSize(small) + sizer->CalculateByteSize(other),
+              cache->byte_size());
+
+    // Replacing a document only counts the new version.
+    cache->Add(large, Version(2));
+    ASSERT_EQ(sizer->CalculateByteSize(large) + sizer->CalculateByteSize(other),
+              cache->byte_size());
+
+    cache->Remove(large.key());
+    cache->Remove(other.key());
+    ASSERT_EQ(0, cache->byte_size());
+  });
+}
+
+TEST(MemoryRemoteDocumentCacheSizeTest, CountsEncodedBytesWithCompactStorage) {
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithCompactStorageForTesting();
+  MemoryRemoteDocumentCache* cache = persistence->remote_document_cache();
+  // The same database as the persistence's serializer.
+  ProtoSizer sizer{LocalSerializer(remote::Serializer(DatabaseId("p", "d")))};
+
+  auto small = Doc("coll/a", 1, Map("n", 1));
+  auto large = Doc("coll/a", 2, Map("n", 1, "s", "a somewhat longer value"));
+
+  persistence->Run("test", [&] {
+    cache->Add(small, Version(1));
+    ASSERT_EQ(sizer.CalculateByteSize(small), cache->byte_size());
+
+    cache->Add(large, Version(2));
+    ASSERT_EQ(sizer.CalculateByteSize(large), cache->byte_size());
+    EXPECT_EQ(cache->Get(large.key()), large);
+
+    cache->Remove(large.key());
+    ASSERT_EQ(0, cache->byte_size());
+    EXPECT_EQ(cache->Get(large.key()), absl::nullopt);
+  });
+}
+
+TEST(MemoryRemoteDocumentCacheColumnsTest, MatchesHotCollectionsFromColumns) {
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  MemoryRemoteDocumentCache* cache = persistence->remote_document_cache();
+  cache->set_columnar_snapshots_enabled(true);
+
+  persistence->Run("MatchesHotCollectionsFromColumns", [&] {
+    cache->Add(Doc("coll/a", 1, Map("n", 1)), Version(1));
+    cache->Add(Doc("coll/b", 1, Map("n", 2)), Version(1));
+    cache->Add(Doc("coll/c", 1, Map("n", 3, "m", 1)), Version(2));
+    cache->Add(Doc("coll/c/sub/d", 1, Map("n", 4)), Version(1));
+
+    core::Query query = Query("coll").AddingFilter(Filter("n", ">", 1));
+
+    // The first query scans the cache, later ones read the snapshot.
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(Keys(cache->GetMatching(query, SnapshotVersion::None())),
+                (std::vector<DocumentKey>{Key("coll/b"), Key("coll/c")}));
+    }
+    EXPECT_EQ(Keys(cache->GetMatching(query, Version(1))),
+              (std::vector<DocumentKey>{Key("coll/c")}));
+    EXPECT_EQ(
+        Keys(cache->GetMatching(
+            query.AddingOrderBy(OrderBy("n")).AddingOrderBy(OrderBy("m")),
+            SnapshotVersion::None())),
+        (std::vector<DocumentKey>{Key("coll/c")}));
+
+    // Writes discard the snapshot.
+    cache->Add(Doc("coll/a", 2, Map("n", 5)), Version(3));
+    cache->Remove(Key("coll/b"));
+    for (int i = 0; i < 3; ++i) {
+      EXPECT_EQ(Keys(cache->GetMatching(query, SnapshotVersion::None())),
+                (std::vector<DocumentKey>{Key("coll/a"), Key("coll/c")}));
+    }
+  });
+}
+
+TEST(MemoryRemoteDocumentCacheColumnsTest, ReleaseMemoryDropsColumns) {
+  std::unique_ptr<MemoryPersistence> persistence =
+      MemoryPersistenceWithEagerGcForTesting();
+  MemoryRemoteDocumentCache* cache = persistence->remote_document_cache();
+  cache->set_columnar_snapshots_enabled(true);
+
+  persistence->Run("ReleaseMemoryDropsColumns", [&] {
+    cache->Add(Doc("coll/a", 1, Map("n", 1)), Version(1));
+    cache->Add(Doc("coll/b", 1, Map("n", 2)), Version(1));
+
+    core::Query query = Query("coll").AddingFilter(Filter("n", ">", 1));
+    for (int i = 0; i < 3; ++i) {
+      cache->GetMatching(query, SnapshotVersion::None());
+    }
+
+    EXPECT_GT(cache->ReleaseMemory(), 0u);
+    EXPECT_EQ(0u, cache->ReleaseMemory());
+
+    // The documents themselves are kept.
+    EXPECT_EQ(Keys(cache->GetMatching(query, SnapshotVersion::None())),
+              (std::vector<DocumentKey>{Key("coll/b")}));
+  });
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
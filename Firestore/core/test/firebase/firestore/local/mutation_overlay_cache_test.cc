@@ -0,0 +1,137 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/local/mutation_overlay_cache.h"
+
+#include <vector>
+
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
+#include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/transform_mutation.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+namespace {
+
+using model::DocumentState;
+using model::MaybeDocument;
+using model::Mutation;
+using model::MutationBatch;
+using testutil::Doc;
+using testutil::Key;
+using testutil::Map;
+using testutil::Resource;
+using testutil::Value;
+
+MutationBatch Batch(model::BatchId batch_id, std::vector<Mutation> mutations) {
+  return MutationBatch(batch_id, Timestamp(1, 0), {}, std::move(mutations));
+}
+
+TEST(MutationOverlayCacheTest, RecordsMutationsOfImmediateChildren) {
+  MutationOverlayCache cache;
+  std::vector<MutationBatch> batches = {
+      Batch(1, {testutil::SetMutation("coll/a", Map("v", 1)),
+                testutil::SetMutation("coll/a/sub/b", Map("v", 1))}),
+      Batch(2, {testutil::PatchMutation("coll/c", Map("v", 2))}),
+  };
+
+  const MutationOverlayCache::CollectionOverlays& overlays =
+      cache.Record(Resource("coll"), 0, batches);
+
+  ASSERT_EQ(overlays.size(), 2);
+  EXPECT_FALSE(overlays.at(Key("coll/a")).needs_base_document());
+  EXPECT_TRUE(overlays.at(Key("coll/c")).needs_base_document());
+  EXPECT_EQ(cache.Find(Resource("coll"), 0), &overlays);
+  EXPECT_EQ(cache.Find(Resource("other"), 0), nullptr);
+}
+
+TEST(MutationOverlayCacheTest, ForgetsOverlaysWhenQueueChanges) {
+  MutationOverlayCache cache;
+  std::vector<MutationBatch> batches = {
+      Batch(1, {testutil::SetMutation("coll/a", Map("v", 1))}),
+  };
+  cache.Record(Resource("coll"), 1, batches);
+  ASSERT_NE(cache.Find(Resource("coll"), 1), nullptr);
+
+  EXPECT_EQ(cache.Find(Resource("coll"), 2), nullptr);
+
+  // The old change count doesn't bring the overlays back.
+  EXPECT_EQ(cache.Find(Resource("coll"), 1), nullptr);
+}
+
+TEST(MutationOverlayCacheTest, AppliesMutationsInBatchOrder) {
+  MutationOverlayCache cache;
+  std::vector<MutationBatch> batches = {
+      Batch(1, {testutil::PatchMutation("coll/a", Map("v", 1))}),
+      Batch(2, {testutil::PatchMutation("coll/a", Map("w", 2))}),
+  };
+  const MutationOverlayCache::CollectionOverlays& overlays =
+      cache.Record(Resource("coll"), 0, batches);
+  const MutationOverlayCache::Overlay& overlay = overlays.at(Key("coll/a"));
+
+  absl::optional<MaybeDocument> base_doc =
+      Doc("coll/a", 1, Map("u", 0, "v", 0));
+  absl::optional<MaybeDocument> expected =
+      Doc("coll/a", 1, Map("u", 0, "v", 1, "w", 2),
+          DocumentState::kLocalMutations);
+  EXPECT_EQ(overlay.Apply(base_doc), expected);
+  EXPECT_EQ(overlay.Apply(base_doc), expected);
+
+  // A changed remote document yields a new local view.
+  absl::optional<MaybeDocument> new_base_doc = Doc("coll/a", 2, Map("u", 3));
+  EXPECT_EQ(overlay.Apply(new_base_doc),
+            Doc("coll/a", 2, Map("u", 3, "v", 1, "w", 2),
+                DocumentState::kLocalMutations));
+
+  // Patches don't apply to documents that don't exist.
+  EXPECT_EQ(overlay.Apply(absl::nullopt), absl::nullopt);
+}
+
+TEST(MutationOverlayCacheTest, CombinesRunsOfIncrements) {
+  MutationOverlayCache cache;
+  std::vector<MutationBatch> batches;
+  for (model::BatchId batch_id = 1; batch_id <= 50; ++batch_id) {
+    // An update that only increments a field is an empty patch followed by a
+    // transform.
+    batches.push_back(
+        Batch(batch_id, {testutil::PatchMutation("coll/a"),
+                         testutil::TransformMutation(
+                             "coll/a", {testutil::Increment("n", Value(1))})}));
+  }
+  batches.push_back(Batch(
+      51, {testutil::TransformMutation(
+              "coll/a", {testutil::Increment("n", Value(0.5))})}));
+
+  const MutationOverlayCache::CollectionOverlays& overlays =
+      cache.Record(Resource("coll"), 0, batches);
+  const MutationOverlayCache::Overlay& overlay = overlays.at(Key("coll/a"));
+
+  EXPECT_EQ(overlay.Apply(Doc("coll/a", 1, Map("n", 10))),
+            Doc("coll/a", 1, Map("n", 60.5), DocumentState::kLocalMutations));
+  EXPECT_EQ(overlay.Apply(absl::nullopt), absl::nullopt);
+}
+
+}  // namespace
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
@@ -114,6 +114,30 @@ TEST_P(MutationQueueTest, CountBatches) {
   });
 }
 
+TEST_P(MutationQueueTest, TracksBatchCountAndByteSize) {
+  persistence_->Run("TracksBatchCountAndByteSize", [&] {
+    EXPECT_EQ(mutation_queue_->GetBatchCount(), 0u);
+    int64_t initial_size = mutation_queue_->GetByteSize();
+
+    MutationBatch batch1 = AddMutationBatch("foo/bar");
+    MutationBatch batch2 = AddMutationBatch("foo/baz");
+    EXPECT_EQ(mutation_queue_->GetBatchCount(), 2u);
+    EXPECT_GE(mutation_queue_->GetByteSize(), initial_size);
+
+    // Replacing a batch doesn't add one.
+    MutationBatch replacement(
+        batch2.batch_id(), batch2.local_write_time(), {},
+        {testutil::SetMutation("foo/baz", Map("a", "a much longer value"))});
+    mutation_queue_->ReplaceLastMutationBatch(replacement);
+    EXPECT_EQ(mutation_queue_->GetBatchCount(), 2u);
+
+    mutation_queue_->RemoveMutationBatch(batch1);
+    mutation_queue_->RemoveMutationBatch(replacement);
+    EXPECT_EQ(mutation_queue_->GetBatchCount(), 0u);
+    EXPECT_EQ(mutation_queue_->GetByteSize(), initial_size);
+  });
+}
+
 TEST_P(MutationQueueTest, AcknowledgeBatchId) {
   persistence_->Run("AcknowledgeBatchId", [&] {
     ASSERT_EQ(GetBatchCount(), 0);
@@ -153,6 +177,24 @@ TEST_P(MutationQueueTest, AcknowledgeThenRemove) {
   });
 }
 
+TEST_P(MutationQueueTest, ChangeCountTracksAddsAndRemoves) {
+  persistence_->Run("ChangeCountTracksAddsAndRemoves", [&] {
+    uint64_t initial = mutation_queue_->GetChangeCount();
+
+    MutationBatch batch1 = AddMutationBatch();
+    uint64_t after_add = mutation_queue_->GetChangeCount();
+    EXPECT_NE(after_add, initial);
+
+    // Reads and acknowledgements don't change the set of batches.
+    mutation_queue_->AllMutationBatchesAffectingQuery(Query("foo"));
+    mutation_queue_->AcknowledgeBatch(batch1, {});
+    EXPECT_EQ(mutation_queue_->GetChangeCount(), after_add);
+
+    mutation_queue_->RemoveMutationBatch(batch1);
+    EXPECT_NE(mutation_queue_->GetChangeCount(), after_add);
+  });
+}
+
 TEST_P(MutationQueueTest, LookupMutationBatch) {
   persistence_->Run("LookupMutationBatch", [&] {
     // Searching on an empty queue should not find a non-existent batch.
@@ -182,6 +224,26 @@ TEST_P(MutationQueueTest, LookupMutationBatch) {
   });
 }
 
+TEST_P(MutationQueueTest, ReplaceLastMutationBatch) {
+  persistence_->Run("ReplaceLastMutationBatch", [&] {
+    AddMutationBatch("foo/bar");
+    MutationBatch last = AddMutationBatch("foo/baz");
+    uint64_t before = mutation_queue_->GetChangeCount();
+
+    SetMutation replacement = testutil::SetMutation("foo/baz", Map("a", 2));
+    MutationBatch compacted(last.batch_id(), last.local_write_time(), {},
+                            {replacement});
+    mutation_queue_->ReplaceLastMutationBatch(compacted);
+
+    absl::optional<MutationBatch> found =
+        mutation_queue_->LookupMutationBatch(last.batch_id());
+    ASSERT_NE(found, absl::nullopt);
+    EXPECT_EQ(*found, compacted);
+    EXPECT_NE(mutation_queue_->GetChangeCount(), before);
+    EXPECT_EQ(mutation_queue_->AllMutationBatches().size(), 2u);
+  });
+}
+
 TEST_P(MutationQueueTest, NextMutationBatchAfterBatchId) {
   persistence_->Run("NextMutationBatchAfterBatchId", [&] {
     std::vector<MutationBatch> batches = CreateBatches(10);
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/local/persistence_metrics.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/local/lru_garbage_collector.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace local {
+
+using std::chrono::microseconds;
+
+TEST(LatencyHistogramTest, EmptyHistogram) {
+  LatencyHistogram histogram;
+  LatencyHistogram::Snapshot snapshot = histogram.GetSnapshot();
+
+  EXPECT_EQ(snapshot.count, 0);
+  EXPECT_EQ(snapshot.total, microseconds(0));
+  EXPECT_EQ(snapshot.max, microseconds(0));
+  EXPECT_EQ(snapshot.Percentile(50), microseconds(0));
+}
+
+TEST(LatencyHistogramTest, RecordsCountTotalAndMax) {
+  LatencyHistogram histogram;
+  histogram.Record(microseconds(3));
+  histogram.Record(microseconds(100));
+  histogram.Record(microseconds(7));
+
+  LatencyHistogram::Snapshot snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 3);
+  EXPECT_EQ(snapshot.total, microseconds(110));
+  EXPECT_EQ(snapshot.max, microseconds(100));
+}
+
+TEST(LatencyHistogramTest, PercentilesAreBucketUpperBounds) {
+  LatencyHistogram histogram;
+  for (int i = 0; i < 90; ++i) {
+    histogram.Record(microseconds(5));
+  }
+  for (int i = 0; i < 10; ++i) {
+    histogram.Record(microseconds(1000));
+  }
+
+  LatencyHistogram::Snapshot snapshot = histogram.GetSnapshot();
+  // 5us falls into the [4, 8) bucket.
+  EXPECT_EQ(snapshot.Percentile(50), microseconds(8));
+  EXPECT_EQ(snapshot.Percentile(90), microseconds(8));
+  // The upper bound of the [512, 1024) bucket is capped by the maximum.
+  EXPECT_EQ(snapshot.Percentile(99), microseconds(1000));
+  EXPECT_EQ(snapshot.Percentile(100), microseconds(1000));
+}
+
+TEST(LatencyHistogramTest, HandlesOutOfRangeLatencies) {
+  LatencyHistogram histogram;
+  histogram.Record(microseconds(-5));
+  histogram.Record(std::chrono::hours(24));
+
+  LatencyHistogram::Snapshot snapshot = histogram.GetSnapshot();
+  EXPECT_EQ(snapshot.count, 2);
+  EXPECT_EQ(snapshot.buckets[0], 1);
+  EXPECT_EQ(snapshot.buckets[LatencyHistogram::kBucketCount - 1], 1);
+  EXPECT_EQ(snapshot.Percentile(100), std::chrono::hours(24));
+}
+
+TEST(PersistenceMetricsTest, AccumulatesCounters) {
+  PersistenceMetrics metrics;
+  metrics.RecordKeysRead(5);
+  metrics.RecordKeysRead(2);
+  metrics.RecordBytesDecoded(1024);
+  metrics.RecordDocumentsScanned(10);
+  metrics.RecordQueryExecuted(3, microseconds(50));
+  metrics.RecordQueryExecuted(1, microseconds(20));
+  metrics.RecordTransactionCommit(microseconds(400));
+
+  PersistenceMetrics::Snapshot snapshot = metrics.GetSnapshot();
+  EXPECT_EQ(snapshot.keys_read, 7);
+  EXPECT_EQ(snapshot.bytes_decoded, 1024);
+  EXPECT_EQ(snapshot.documents_scanned, 10);
+  EXPECT_EQ(snapshot.queries_executed, 2);
+  EXPECT_EQ(snapshot.documents_matched, 4);
+  EXPECT_EQ(snapshot.query_latency.count, 2);
+  EXPECT_EQ(snapshot.query_latency.max, microseconds(50));
+  EXPECT_EQ(snapshot.transaction_commit_latency.count, 1);
+}
+
+TEST(PersistenceMetricsTest, RecordsGarbageCollectionThatRan) {
+  PersistenceMetrics metrics;
+  metrics.RecordGarbageCollection(LruResults{/* did_run= */ true, 10, 2, 7});
+  metrics.RecordGarbageCollection(LruResults::DidNotRun());
+
+  PersistenceMetrics::Snapshot snapshot = metrics.GetSnapshot();
+  EXPECT_EQ(snapshot.targets_removed, 2);
+  EXPECT_EQ(snapshot.documents_removed, 7);
+}
+
+TEST(PersistenceMetricsTest, RecordsConcurrently) {
+  PersistenceMetrics metrics;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 1000; ++j) {
+        metrics.RecordKeysRead(1);
+        metrics.RecordTransactionCommit(microseconds(j));
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  PersistenceMetrics::Snapshot snapshot = metrics.GetSnapshot();
+  EXPECT_EQ(snapshot.keys_read, 4000);
+  EXPECT_EQ(snapshot.transaction_commit_latency.count, 4000);
+  EXPECT_EQ(snapshot.transaction_commit_latency.max, microseconds(999));
+}
+
+TEST(PersistenceMetricsTest, ToStringDescribesCounters) {
+  PersistenceMetrics metrics;
+  metrics.RecordKeysRead(42);
+
+  std::string description = metrics.GetSnapshot().ToString();
+  EXPECT_NE(description.find("keys_read=42"), std::string::npos);
+}
+
+}  // namespace local
+}  // namespace firestore
+}  // namespace firebase
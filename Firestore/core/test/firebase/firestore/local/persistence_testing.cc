@@ -64,9 +64,9 @@ Path LevelDbDir() {
 }
 
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
-    Path dir, LruParams lru_params) {
-  auto created =
-      LevelDbPersistence::Create(dir, MakeLocalSerializer(), lru_params);
+    Path dir, LruParams lru_params, const LevelDbOptions& options) {
+  auto created = LevelDbPersistence::Create(dir, MakeLocalSerializer(),
+                                            lru_params, options);
   if (!created.ok()) {
     util::ThrowIllegalState("Failed to open leveldb in dir %s: %s",
                             dir.ToUtf8String(), created.status().ToString());
@@ -75,12 +75,20 @@ std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
 }
 
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(Path dir) {
-  return LevelDbPersistenceForTesting(std::move(dir), LruParams::Default());
+  return LevelDbPersistenceForTesting(std::move(dir), LruParams::Default(),
+                                      LevelDbOptions());
 }
 
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
     LruParams lru_params) {
-  return LevelDbPersistenceForTesting(LevelDbDir(), lru_params);
+  return LevelDbPersistenceForTesting(LevelDbDir(), lru_params,
+                                      LevelDbOptions());
+}
+
+std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
+    const LevelDbOptions& options) {
+  return LevelDbPersistenceForTesting(LevelDbDir(), LruParams::Default(),
+                                      options);
 }
 
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting() {
@@ -102,6 +110,14 @@ std::unique_ptr<MemoryPersistence> MemoryPersistenceWithLruGcForTesting(
                                                     std::move(sizer));
 }
 
+std::unique_ptr<MemoryPersistence>
+MemoryPersistenceWithCompactStorageForTesting() {
+  auto persistence = MemoryPersistence::WithEagerGarbageCollector();
+  persistence->remote_document_cache()->EnableCompactStorage(
+      MakeLocalSerializer());
+  return persistence;
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -30,6 +30,7 @@ class Path;
 namespace local {
 
 class LevelDbPersistence;
+struct LevelDbOptions;
 struct LruParams;
 class MemoryPersistence;
 
@@ -67,6 +68,23 @@ std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
 std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
     LruParams lru_params);
 
+/**
+ * Creates and starts a new LevelDbPersistence instance for testing, destroying
+ * any previous contents if they existed.
+ *
+ * Opens the database with the provided options.
+ */
+std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
+    const LevelDbOptions& options);
+
+/**
+ * Creates and starts a new LevelDbPersistence instance for testing in the
+ * given directory, with the provided LRU params and options. Does not delete
+ * any data present in the directory.
+ */
+std::unique_ptr<LevelDbPersistence> LevelDbPersistenceForTesting(
+    util::Path dir, LruParams lru_params, const LevelDbOptions& options);
+
 /** Creates and starts a new MemoryPersistence instance for testing. */
 std::unique_ptr<MemoryPersistence> MemoryPersistenceWithEagerGcForTesting();
 
@@ -75,6 +93,13 @@ std::unique_ptr<MemoryPersistence> MemoryPersistenceWithLruGcForTesting();
 std::unique_ptr<MemoryPersistence> MemoryPersistenceWithLruGcForTesting(
     LruParams lru_params);
 
+/**
+ * Creates and starts a new MemoryPersistence instance for testing whose
+ * remote document cache uses compact storage.
+ */
+std::unique_ptr<MemoryPersistence>
+MemoryPersistenceWithCompactStorageForTesting();
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/local/reference_set.h"
 
+#include <string>
+
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 
@@ -26,6 +28,7 @@ namespace firestore {
 namespace local {
 
 using model::DocumentKey;
+using model::DocumentKeySet;
 
 TEST(ReferenceSetTest, AddOrRemoveReferences) {
   DocumentKey key = testutil::Key("foo/bar");
@@ -79,6 +82,44 @@ TEST(ReferenceSetTest, RemoteAllReferencesForTargetId) {
   EXPECT_FALSE(reference_set.ContainsKey(key3));
 }
 
+TEST(ReferenceSetTest, ReferencedKeys) {
+  DocumentKey key1 = testutil::Key("foo/bar");
+  DocumentKey key2 = testutil::Key("foo/baz");
+  ReferenceSet reference_set{};
+
+  reference_set.AddReferences(DocumentKeySet{key1, key2}, 1);
+  reference_set.AddReference(key2, 2);
+  EXPECT_EQ(reference_set.ReferencedKeys(1), (DocumentKeySet{key1, key2}));
+  EXPECT_EQ(reference_set.ReferencedKeys(2), DocumentKeySet{key2});
+  EXPECT_EQ(reference_set.ReferencedKeys(3), DocumentKeySet{});
+
+  reference_set.RemoveReference(key2, 2);
+  EXPECT_EQ(reference_set.ReferencedKeys(2), DocumentKeySet{});
+  EXPECT_EQ(reference_set.size(), 2);
+}
+
+TEST(ReferenceSetTest, RemovesLargeTargetsAtOnce) {
+  ReferenceSet reference_set{};
+  DocumentKeySet large;
+  for (int i = 0; i < 1000; ++i) {
+    large = large.insert(testutil::Key("coll/doc" + std::to_string(i)));
+  }
+  reference_set.AddReferences(large, 1);
+  reference_set.AddReference(testutil::Key("coll/doc1"), 2);
+  reference_set.AddReference(testutil::Key("other/doc"), 2);
+
+  EXPECT_EQ(reference_set.RemoveReferences(1), large);
+  EXPECT_EQ(reference_set.size(), 2);
+  EXPECT_TRUE(reference_set.ContainsKey(testutil::Key("coll/doc1")));
+  EXPECT_FALSE(reference_set.ContainsKey(testutil::Key("coll/doc2")));
+  EXPECT_TRUE(reference_set.ContainsKey(testutil::Key("other/doc")));
+  EXPECT_EQ(reference_set.RemoveReferences(1), DocumentKeySet{});
+
+  reference_set.RemoveAllReferences();
+  EXPECT_TRUE(reference_set.empty());
+  EXPECT_EQ(reference_set.ReferencedKeys(2), DocumentKeySet{});
+}
+
 }  // namespace local
 }  // namespace firestore
 }  // namespace firebase
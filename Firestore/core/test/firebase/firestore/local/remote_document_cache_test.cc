@@ -17,8 +17,11 @@
 #include "Firestore/core/test/firebase/firestore/local/remote_document_cache_test.h"
 
 #include <memory>
+#include <string>
 #include <vector>
 
+#include "Firestore/core/src/firebase/firestore/core/bound.h"
+#include "Firestore/core/src/firebase/firestore/core/field_filter.h"
 #include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/local/memory_remote_document_cache.h"
 #include "Firestore/core/src/firebase/firestore/local/persistence.h"
@@ -29,6 +32,7 @@
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/util/string_apple.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -147,6 +151,32 @@ TEST_P(RemoteDocumentCacheTest,
       });
 }
 
+TEST_P(RemoteDocumentCacheTest, SetAndReadManyDocumentsWithGaps) {
+  persistence_->Run("test_set_and_read_many_documents_with_gaps", [=] {
+    std::vector<Document> written;
+    DocumentKeySet keys;
+    for (int i = 0; i < 20; ++i) {
+      std::string path = absl::StrCat("coll/doc", i);
+      keys = keys.insert(testutil::Key(path));
+      // Leave gaps both between requested documents (subcollections) and in
+      // the requested keys (missing documents).
+      SetTestDocument(absl::StrCat(path, "/sub/doc"));
+      if (i % 3 != 0) {
+        written.push_back(SetTestDocument(path));
+      }
+    }
+
+    OptionalMaybeDocumentMap read = cache_->GetAll(keys);
+    EXPECT_EQ(read.size(), keys.size());
+    EXPECT_THAT(read, HasAtLeastDocs(written));
+    for (int i = 0; i < 20; i += 3) {
+      auto found = read.find(testutil::Key(absl::StrCat("coll/doc", i)));
+      ASSERT_TRUE(found != read.end());
+      EXPECT_EQ(absl::nullopt, found->second);
+    }
+  });
+}
+
 TEST_P(RemoteDocumentCacheTest, SetAndReadADocumentAtDeepPath) {
   SetAndReadTestDocument(kLongDocPath);
 }
@@ -208,6 +238,80 @@ TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQuery) {
   });
 }
 
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQuerySkipsSubcollections) {
+  persistence_->Run("test_documents_matching_query_skips_subcollections", [&] {
+    SetTestDocument("rooms/a");
+    SetTestDocument("rooms/a/messages/1");
+    SetTestDocument("rooms/a/messages/2");
+    SetTestDocument("rooms/a/messages/2/reactions/1");
+    SetTestDocument("rooms/a/users/1");
+    SetTestDocument("rooms/a0/messages/1");
+    SetTestDocument("rooms/ab");
+    SetTestDocument("rooms/b/messages/1");
+    SetTestDocument("rooms/c");
+    SetTestDocument("roomsx/a");
+
+    core::Query query = Query("rooms");
+    DocumentMap results = cache_->GetMatching(query, SnapshotVersion::None());
+    std::vector<Document> docs = {
+        Doc("rooms/a", kVersion, kDocData),
+        Doc("rooms/ab", kVersion, kDocData),
+        Doc("rooms/c", kVersion, kDocData),
+    };
+    EXPECT_THAT(results.underlying_map(), HasExactlyDocs(docs));
+  });
+}
+
+TEST_P(RemoteDocumentCacheTest, ScanMatchingYieldsDocumentsInKeyOrder) {
+  persistence_->Run("test_scan_matching_yields_documents_in_key_order", [&] {
+    SetTestDocument("rooms/c");
+    SetTestDocument("rooms/a");
+    SetTestDocument("rooms/a/messages/1");
+    SetTestDocument("rooms/b");
+    SetTestDocument("roomsx/a");
+
+    std::unique_ptr<DocumentCursor> cursor =
+        cache_->ScanMatching(Query("rooms"), SnapshotVersion::None());
+    std::vector<DocumentKey> keys;
+    for (; cursor->Valid(); cursor->Next()) {
+      keys.push_back(cursor->document().key());
+    }
+    EXPECT_EQ(keys,
+              (std::vector<DocumentKey>{testutil::Key("rooms/a"),
+                                        testutil::Key("rooms/b"),
+                                        testutil::Key("rooms/c")}));
+  });
+}
+
+TEST_P(RemoteDocumentCacheTest, ScanMatchingHonorsKeyBounds) {
+  persistence_->Run("test_scan_matching_honors_key_bounds", [&] {
+    SetTestDocument("rooms/a");
+    SetTestDocument("rooms/b");
+    SetTestDocument("rooms/b/messages/1");
+    SetTestDocument("rooms/c");
+    SetTestDocument("rooms/d");
+    SetTestDocument("rooms/e");
+
+    core::Query query =
+        Query("rooms")
+            .StartingAt(core::Bound({testutil::Ref("project", "rooms/b")},
+                                    /* is_before= */ false))
+            .EndingAt(core::Bound({testutil::Ref("project", "rooms/d")},
+                                  /* is_before= */ false));
+    std::unique_ptr<DocumentCursor> cursor =
+        cache_->ScanMatching(query, SnapshotVersion::None());
+    std::vector<DocumentKey> keys;
+    for (; cursor->Valid(); cursor->Next()) {
+      if (query.Matches(cursor->document())) {
+        keys.push_back(cursor->document().key());
+      }
+    }
+    EXPECT_EQ(keys,
+              (std::vector<DocumentKey>{testutil::Key("rooms/c"),
+                                        testutil::Key("rooms/d")}));
+  });
+}
+
 TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQuerySinceReadTime) {
   persistence_->Run("test_documents_matching_query_since_read_time", [&] {
     SetTestDocument("b/old", /* updateTime= */ 1, /* readTime= */ 11);
@@ -238,6 +342,28 @@ TEST_P(RemoteDocumentCacheTest, DocumentsMatchingUsesReadTimeNotUpdateTime) {
       });
 }
 
+TEST_P(RemoteDocumentCacheTest, DocumentsMatchingQueryWithFilters) {
+  persistence_->Run("test_documents_matching_query_with_filters", [&] {
+    Document match1 = Doc("b/1", kVersion, Map("a", Map("b", 1), "c", "x"));
+    Document match2 = Doc("b/2", kVersion, Map("a", Map("b", 1), "c", "x"));
+    cache_->Add(match1, Version(kVersion));
+    cache_->Add(match2, Version(kVersion));
+    cache_->Add(Doc("b/3", kVersion, Map("a", Map("b", 2), "c", "x")),
+                Version(kVersion));
+    cache_->Add(Doc("b/4", kVersion, Map("a", 1, "c", "x")), Version(kVersion));
+    cache_->Add(Doc("b/5", kVersion, Map("a", Map("b", 1), "c", "y")),
+                Version(kVersion));
+    cache_->Add(Doc("b/6", kVersion, Map("c", "x")), Version(kVersion));
+
+    core::Query query = Query("b")
+                            .AddingFilter(testutil::Filter("a.b", "==", 1))
+                            .AddingFilter(testutil::Filter("c", "==", "x"));
+    DocumentMap results = cache_->GetMatching(query, SnapshotVersion::None());
+    std::vector<Document> docs = {match1, match2};
+    EXPECT_THAT(results.underlying_map(), HasExactlyDocs(docs));
+  });
+}
+
 // MARK: - Helpers
 
 Document RemoteDocumentCacheTest::SetTestDocument(const absl::string_view path,
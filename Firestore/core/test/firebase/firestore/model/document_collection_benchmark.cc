@@ -0,0 +1,136 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unordered_set>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/document_map.h"
+#include "Firestore/core/src/firebase/firestore/model/document_set.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+std::vector<Document> Docs(int64_t count) {
+  std::vector<Document> docs;
+  for (int64_t i = 0; i < count; ++i) {
+    docs.push_back(testutil::Doc(absl::StrCat("coll/doc", i), 1));
+  }
+  return docs;
+}
+
+void BM_IterateDocumentMap(benchmark::State& state) {
+  DocumentMap map;
+  for (const Document& doc : Docs(state.range(0))) {
+    map = map.insert(doc.key(), doc);
+  }
+
+  for (auto _ : state) {
+    for (const auto& entry : map.underlying_map()) {
+      benchmark::DoNotOptimize(&entry);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IterateDocumentMap)->Range(100, 10000);
+
+void BM_IterateDocumentKeySet(benchmark::State& state) {
+  DocumentKeySet keys;
+  for (const Document& doc : Docs(state.range(0))) {
+    keys = keys.insert(doc.key());
+  }
+
+  for (auto _ : state) {
+    for (const DocumentKey& key : keys) {
+      benchmark::DoNotOptimize(&key);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IterateDocumentKeySet)->Range(100, 10000);
+
+void BM_IterateDocumentSet(benchmark::State& state) {
+  DocumentSet set{DocumentComparator::ByKey()};
+  for (const Document& doc : Docs(state.range(0))) {
+    set = set.insert(doc);
+  }
+
+  for (auto _ : state) {
+    for (const Document& doc : set) {
+      benchmark::DoNotOptimize(&doc);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_IterateDocumentSet)->Range(100, 10000);
+
+/** Each lookup creates iterators for its result and for `end()`. */
+void BM_FindInDocumentKeySet(benchmark::State& state) {
+  std::vector<Document> docs = Docs(state.range(0));
+  DocumentKeySet keys;
+  for (const Document& doc : docs) {
+    keys = keys.insert(doc.key());
+  }
+
+  for (auto _ : state) {
+    for (const Document& doc : docs) {
+      benchmark::DoNotOptimize(keys.find(doc.key()) != keys.end());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindInDocumentKeySet)->Range(100, 10000);
+
+/** Copies of a key share its hash, so only the first lookup computes it. */
+void BM_FindInUnorderedDocumentKeySet(benchmark::State& state) {
+  std::vector<Document> docs = Docs(state.range(0));
+  std::unordered_set<DocumentKey, DocumentKeyHash> keys;
+  for (const Document& doc : docs) {
+    keys.insert(doc.key());
+  }
+
+  for (auto _ : state) {
+    for (const Document& doc : docs) {
+      benchmark::DoNotOptimize(keys.find(doc.key()) != keys.end());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FindInUnorderedDocumentKeySet)->Range(100, 10000);
+
+/** Hashes keys that have never been hashed before, as after decoding. */
+void BM_HashNewDocumentKey(benchmark::State& state) {
+  std::vector<Document> docs = Docs(state.range(0));
+  for (auto _ : state) {
+    for (const Document& doc : docs) {
+      DocumentKey fresh{doc.key().path()};
+      benchmark::DoNotOptimize(fresh.Hash());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HashNewDocumentKey)->Range(100, 10000);
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/model/document_key_interner.h"
+
+#include <string>
+
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/resource_path.h"
+#include "Firestore/core/src/firebase/firestore/util/comparison.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+
+using testutil::Key;
+
+TEST(DocumentKeyInternerTest, SharesPathsOfEqualKeys) {
+  DocumentKeyInterner interner;
+
+  DocumentKey first = interner.Intern(Key("rooms/eros"));
+  DocumentKey second = interner.Intern(Key("rooms/eros"));
+  DocumentKey other = interner.Intern(Key("rooms/other"));
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(&first.path(), &second.path());
+  EXPECT_NE(first, other);
+  EXPECT_NE(&first.path(), &other.path());
+  EXPECT_EQ(util::ComparisonResult::Same, first.CompareTo(second));
+  EXPECT_EQ(util::ComparisonResult::Ascending, first.CompareTo(other));
+}
+
+TEST(DocumentKeyInternerTest, ReturnsTheKeyWhenNotYetInterned) {
+  DocumentKeyInterner interner;
+
+  DocumentKey key = Key("rooms/eros");
+  DocumentKey interned = interner.Intern(key);
+  EXPECT_EQ(&key.path(), &interned.path());
+}
+
+TEST(DocumentKeyInternerTest, DoesNotKeepPathsAlive) {
+  DocumentKeyInterner interner;
+  interner.Intern(Key("rooms/eros"));
+
+  // The first key is gone, so the next one becomes the shared instance.
+  DocumentKey key = Key("rooms/eros");
+  DocumentKey interned = interner.Intern(key);
+  EXPECT_EQ(&key.path(), &interned.path());
+}
+
+TEST(DocumentKeyInternerTest, PrunesFreedPaths) {
+  DocumentKeyInterner interner;
+  DocumentKey kept = interner.Intern(Key("rooms/kept"));
+  for (int i = 0; i < 1000; ++i) {
+    interner.Intern(Key("rooms/" + std::to_string(i)));
+  }
+
+  // Only a bounded number of freed entries may remain after pruning.
+  EXPECT_LT(interner.size(), 200u);
+  EXPECT_EQ(&kept.path(), &interner.Intern(Key("rooms/kept")).path());
+}
+
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
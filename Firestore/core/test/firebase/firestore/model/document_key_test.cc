@@ -161,6 +161,18 @@ TEST(DocumentKey, Comparator) {
   EXPECT_EQ(comparator.Compare(abcd, xyzw), util::ComparisonResult::Ascending);
 }
 
+TEST(DocumentKey, Hash) {
+  DocumentKey key = Key("a/b/c/d");
+  DocumentKey copied = key;
+  EXPECT_EQ(key.Hash(), key.path().Hash());
+  EXPECT_EQ(copied.Hash(), key.Hash());
+  EXPECT_EQ(DocumentKeyHash{}(key), key.Hash());
+
+  // Equal keys that don't share a path hash alike.
+  EXPECT_EQ(Key("a/b/c/d").Hash(), key.Hash());
+  EXPECT_NE(Key("a/b/c/e").Hash(), key.Hash());
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -16,9 +16,15 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document_set.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <vector>
 
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/util/delayed_constructor.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
 #include "gmock/gmock.h"
@@ -34,7 +40,10 @@ using testing::Eq;
 using testutil::Doc;
 using testutil::DocComparator;
 using testutil::DocSet;
+using testutil::Array;
 using testutil::Map;
+using testutil::OrderBy;
+using testutil::Value;
 
 class DocumentSetTest : public testing::Test {
  public:
@@ -106,6 +115,33 @@ TEST_F(DocumentSetTest, Updates) {
   ASSERT_THAT(set, ElementsAre(doc3_, doc1_, doc2_prime));
 }
 
+TEST_F(DocumentSetTest, LooksUpByKeyWhenOrderedByKey) {
+  core::Query query = testutil::Query("docs");
+  for (DocumentComparator comparator :
+       {DocumentComparator::ByKey(), query.Comparator(),
+        query.AddingOrderBy(OrderBy(FieldPath::kDocumentKeyPath, "desc"))
+            .Comparator()}) {
+    ASSERT_TRUE(comparator.orders_by_key());
+    DocumentSet set = DocSet(comparator, {doc1_, doc2_, doc3_});
+
+    Document doc2_prime = Doc("docs/2", 0, Map("sort", 9));
+    set = set.insert(doc2_prime);
+    EXPECT_EQ(set.size(), 3);
+    EXPECT_EQ(set.GetDocument(doc2_prime.key()), doc2_prime);
+
+    set = set.erase(doc1_.key());
+    EXPECT_EQ(set.size(), 2);
+    EXPECT_FALSE(set.ContainsKey(doc1_.key()));
+    EXPECT_EQ(set.IndexOf(doc1_.key()), DocumentSet::npos);
+
+    size_t index = 0;
+    for (const Document& doc : set) {
+      EXPECT_EQ(set.IndexOf(doc.key()), index++);
+    }
+  }
+  EXPECT_FALSE(comp_.orders_by_key());
+}
+
 TEST_F(DocumentSetTest, AddsDocsWithEqualComparisonValues) {
   Document doc4 = Doc("docs/4", 0, Map("sort", 2));
 
@@ -132,6 +168,65 @@ TEST_F(DocumentSetTest, Equality) {
   EXPECT_NE(set1, sorted_set1);
 }
 
+TEST_F(DocumentSetTest, SortsLikeTheComparatorWithAndWithoutSortKeys) {
+  // A mix of values the comparator can encode as sort keys and values it
+  // can't, like integers that doubles can't represent exactly and arrays.
+  std::vector<FieldValue> values = {
+      Value(nullptr),
+      Value(false),
+      Value(true),
+      Value(std::nan("")),
+      Value(-1.5),
+      Value(-0.0),
+      Value(0),
+      Value(1),
+      Value(1.0),
+      Value(std::numeric_limits<int64_t>::max()),
+      Value(9007199254740993LL),
+      Value(9007199254740992.0),
+      FieldValue::FromTimestamp(Timestamp(1, 2)),
+      FieldValue::FromTimestamp(Timestamp(-1, 5)),
+      Value(""),
+      Value("a"),
+      Value("a\xff"),
+      Value("b"),
+      Array(1, 2),
+  };
+
+  std::vector<Document> docs;
+  for (size_t i = 0; i < values.size(); ++i) {
+    docs.push_back(Doc("docs/" + std::to_string(values.size() - i), 0,
+                       Map("sort", values[i])));
+  }
+  docs.push_back(Doc("docs/1/sub/a", 0, Map("sort", 1)));
+
+  for (const char* direction : {"asc", "desc"}) {
+    DocumentComparator comparator =
+        testutil::Query("docs")
+            .AddingOrderBy(OrderBy("sort", direction))
+            .Comparator();
+    EXPECT_TRUE(comparator.SortKey(docs[0]));
+    EXPECT_FALSE(comparator.SortKey(docs[9]));
+
+    std::vector<Document> expected = docs;
+    std::sort(expected.begin(), expected.end(),
+              [&](const Document& lhs, const Document& rhs) {
+                return util::Ascending(comparator.Compare(lhs, rhs));
+              });
+
+    DocumentSet set = DocSet(comparator, docs);
+    EXPECT_THAT(set, testing::ElementsAreArray(expected));
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(set.IndexOf(expected[i].key()), i);
+    }
+
+    for (const Document& doc : docs) {
+      set = set.erase(doc.key());
+    }
+    EXPECT_TRUE(set.empty());
+  }
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace firestore
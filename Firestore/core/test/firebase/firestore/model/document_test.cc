@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 
+#include <memory>
+
 #include "Firestore/core/src/firebase/firestore/model/field_path.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/unknown_document.h"
@@ -81,6 +83,26 @@ TEST(DocumentTest, Equality) {
   EXPECT_NE(doc, UnknownDocument(Key("same/path"), Version(1)));
 }
 
+TEST(DocumentTest, MemoizesValuesAcrossCopies) {
+  Document doc = Doc("some/path", 1, Map("a", 1));
+  Document copy = doc;
+
+  int computed = 0;
+  auto compute = [&] {
+    ++computed;
+    return std::make_shared<int>(computed);
+  };
+
+  std::shared_ptr<void> first = doc.Memoize(0, compute);
+  EXPECT_EQ(copy.Memoize(0, compute), first);
+  EXPECT_EQ(computed, 1);
+
+  // Other slots and other versions of the document are memoized separately.
+  EXPECT_NE(doc.Memoize(1, compute), first);
+  EXPECT_NE(Doc("some/path", 1, Map("a", 1)).Memoize(0, compute), first);
+  EXPECT_EQ(computed, 3);
+}
+
 }  // namespace model
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/field_path.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace model {
+namespace {
+
+// The valid field paths from the FieldPath fuzzing corpus, in
+// Firestore/Example/FuzzTests/FuzzingResources/FieldPath/Corpus.
+const std::vector<std::string>& CorpusPaths() {
+  static const auto* paths = new std::vector<std::string>{
+      "a",
+      "nested.field.name",
+      "__name__",
+      "another_field_with_underscore.and_then_subfield",
+      "23423423",
+      "_starts.with_underscore",
+      "rooms/foo",
+      "restaurants/name_of_restaurant.somereview",
+      "this.is.a.field",
+      "[ \"a\", \"b\", \"c\"]",
+      "[ \"a\", \"b.c\", \"d\"]",
+      "[ \"field1\", \"__name__\"]",
+      "[ \"a\", \"__name__\", \"b\"]",
+      "_",
+      "__",
+  };
+  return *paths;
+}
+
+void BM_FieldPathFromServerFormat(benchmark::State& state) {
+  const std::vector<std::string>& paths = CorpusPaths();
+  for (auto _ : state) {
+    for (const std::string& path : paths) {
+      benchmark::DoNotOptimize(FieldPath::FromServerFormat(path));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_FieldPathFromServerFormat);
+
+void BM_FieldPathFromEscapedServerFormat(benchmark::State& state) {
+  std::vector<std::string> paths;
+  for (const std::string& path : CorpusPaths()) {
+    paths.push_back(FieldPath::FromServerFormat(path).CanonicalString());
+  }
+
+  for (auto _ : state) {
+    for (const std::string& path : paths) {
+      benchmark::DoNotOptimize(FieldPath::FromServerFormat(path));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * paths.size());
+}
+BENCHMARK(BM_FieldPathFromEscapedServerFormat);
+
+}  // namespace
+}  // namespace model
+}  // namespace firestore
+}  // namespace firebase
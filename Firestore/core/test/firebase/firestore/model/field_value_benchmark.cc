@@ -17,6 +17,8 @@
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 
 #include <limits>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
@@ -113,6 +115,25 @@ BENCHMARK(BM_FieldValueStringFill)
     ->Arg(1 << 9)
     ->Arg(1 << 10);
 
+void BM_FieldValueNumericObject(benchmark::State& state) {
+  // Models a document with `state.range(0)` numeric fields.
+  auto fields = static_cast<int>(state.range(0));
+  std::vector<std::string> names;
+  for (int i = 0; i < fields; ++i) {
+    names.push_back("field" + std::to_string(i));
+  }
+
+  for (auto _ : state) {
+    FieldValue::Map map;
+    for (int i = 0; i < fields; ++i) {
+      map = map.insert(names[i], FieldValue::FromInteger(i));
+    }
+    FieldValue object = FieldValue::FromMap(std::move(map));
+    benchmark::DoNotOptimize(object);
+  }
+}
+BENCHMARK(BM_FieldValueNumericObject)->Arg(10)->Arg(50);
+
 using UserType = absl::variant<int64_t, double, std::string, Timestamp>;
 struct FromValueVisitor {
   FieldValue operator()(int64_t value) {
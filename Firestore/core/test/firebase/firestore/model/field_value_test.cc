@@ -23,6 +23,7 @@
 #include <chrono>  // NOLINT(build/c++11)
 #include <climits>
 #include <cmath>
+#include <utility>
 #include <vector>
 
 #include "Firestore/core/src/firebase/firestore/model/field_mask.h"
@@ -122,6 +123,18 @@ TEST_F(FieldValueTest, ExtractsFields) {
   EXPECT_EQ(nullopt, value.Get(Field("bar.a")));
 }
 
+TEST_F(FieldValueTest, FindsFieldsInPlace) {
+  ObjectValue value = WrapObject("foo", Map("a", 1, "b", "string"));
+
+  const FieldValue* found = value.Find(Field("foo.b"));
+  ASSERT_NE(found, nullptr);
+  EXPECT_EQ(Value("string"), *found);
+  EXPECT_EQ(found, value.Find(Field("foo.b")));
+
+  EXPECT_EQ(nullptr, value.Find(Field("foo.a.b")));
+  EXPECT_EQ(nullptr, value.Find(Field("bar")));
+}
+
 TEST_F(FieldValueTest, ExtractsFieldMask) {
   ObjectValue value =
       WrapObject("a", "b", "map",
@@ -210,6 +223,18 @@ TEST_F(FieldValueTest, DeletesHandleMissingKeys) {
   EXPECT_EQ(WrapObject("a", Map("b", 1, "c", 2)), mod);
 }
 
+TEST_F(FieldValueTest, ProjectsFields) {
+  ObjectValue value =
+      WrapObject("a", Map("b", 1, "c", Map("d", 2)), "e", 3, "f", Map());
+
+  EXPECT_EQ(WrapObject("a", Map("c", Map("d", 2)), "e", 3),
+            value.Project(FieldMask{Field("a.c"), Field("e")}));
+  EXPECT_EQ(WrapObject("f", Map()), value.Project(FieldMask{Field("f")}));
+  EXPECT_EQ(ObjectValue::Empty(),
+            value.Project(FieldMask{Field("g"), Field("e.h"), Field("a.c.x")}));
+  EXPECT_EQ(ObjectValue::Empty(), value.Project(FieldMask{}));
+}
+
 TEST_F(FieldValueTest, DeletesNestedKeys) {
   FieldValue::Map orig = Map("a", Map("b", 1, "c", Map("d", 2, "e", 3)));
   ObjectValue old = WrapObject(orig);
@@ -237,6 +262,58 @@ TEST_F(FieldValueTest, DeletesNestedKeys) {
   EXPECT_EQ(ObjectValue::Empty(), mod);
 }
 
+TEST_F(FieldValueTest, BuilderAppliesNestedChangesTogether) {
+  ObjectValue old = WrapObject("a", 1, "stats", Map("x", 1, "y", 2, "z", 3));
+
+  ObjectValue::Builder builder{old};
+  builder.Set(Field("stats.x"), Value(10));
+  builder.Set(Field("stats.w"), Value(0));
+  builder.Delete(Field("stats.y"));
+  builder.Set(Field("b.c"), Value("new"));
+  builder.Delete(Field("missing.field"));
+  ObjectValue mod = builder.Build();
+
+  EXPECT_EQ(WrapObject("a", 1, "stats", Map("x", 1, "y", 2, "z", 3)), old);
+  EXPECT_EQ(WrapObject("a", 1, "b", Map("c", "new"), "stats",
+                       Map("w", 0, "x", 10, "z", 3)),
+            mod);
+}
+
+TEST_F(FieldValueTest, BuilderAppliesChangesInOrder) {
+  ObjectValue old = WrapObject("a", 1, "b", Map("c", 2));
+
+  // Each sequence of changes must give the same result as chaining them.
+  using Change = std::pair<const char*, absl::optional<FieldValue>>;
+  std::vector<std::vector<Change>> sequences = {
+      {{"a.x", Value(1)}},
+      {{"a.x", nullopt}},
+      {{"a", nullopt}, {"a.x", Value(1)}},
+      {{"a", nullopt}, {"a.x", absl::nullopt}},
+      {{"b.c", Value(3)}, {"b", Value(4)}},
+      {{"b", Value(4)}, {"b.c", Value(3)}},
+      {{"b", Value(4)}, {"b.c", nullopt}},
+      {{"b", WrapObject("d", 5)}, {"b.c", Value(3)}},
+      {{"b.c.d", nullopt}, {"b.e", Value(6)}},
+      {{"b.c", nullopt}, {"b.c.d", Value(7)}},
+      {{"b.c.d", Value(7)}, {"b.c", nullopt}},
+  };
+
+  for (const std::vector<Change>& changes : sequences) {
+    ObjectValue expected = old;
+    ObjectValue::Builder builder{old};
+    for (const Change& change : changes) {
+      if (change.second) {
+        expected = expected.Set(Field(change.first), *change.second);
+        builder.Set(Field(change.first), *change.second);
+      } else {
+        expected = expected.Delete(Field(change.first));
+        builder.Delete(Field(change.first));
+      }
+    }
+    EXPECT_EQ(expected, builder.Build());
+  }
+}
+
 #if defined(_WIN32)
 #define timegm _mkgmtime
 
@@ -710,6 +787,39 @@ TEST_F(FieldValueTest, Copy) {
   EXPECT_EQ(FieldValue::Null(), clone);
 }
 
+TEST_F(FieldValueTest, Move) {
+  FieldValue string_value = FieldValue::FromString("value");
+  FieldValue moved = std::move(string_value);
+  EXPECT_EQ(FieldValue::FromString("value"), moved);
+  EXPECT_EQ(FieldValue::Null(), string_value);  // NOLINT: use after move
+
+  FieldValue integer_value = FieldValue::FromInteger(42);
+  moved = std::move(integer_value);
+  EXPECT_EQ(FieldValue::FromInteger(42), moved);
+
+  moved = std::move(moved);
+  EXPECT_EQ(FieldValue::FromInteger(42), moved);
+}
+
+TEST_F(FieldValueTest, CopiesOutliveTheOriginal) {
+  FieldValue copy;
+  {
+    FieldValue array_value = FieldValue::FromArray(
+        {FieldValue::FromString("a"), FieldValue::FromInteger(1)});
+    copy = array_value;
+  }
+  EXPECT_EQ(FieldValue::FromArray(
+                {FieldValue::FromString("a"), FieldValue::FromInteger(1)}),
+            copy);
+
+  // Assigning a value owned by the target itself must not free it early.
+  copy = FieldValue{copy.array_value()[0]};
+  EXPECT_EQ(FieldValue::FromString("a"), copy);
+  FieldValue nested = FieldValue::FromArray({FieldValue::FromString("b")});
+  nested = nested.array_value()[0];
+  EXPECT_EQ(FieldValue::FromString("b"), nested);
+}
+
 TEST_F(FieldValueTest, CompareMixedType) {
   const FieldValue null_value = FieldValue::Null();
   const FieldValue true_value = FieldValue::True();
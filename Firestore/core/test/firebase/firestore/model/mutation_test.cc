@@ -22,6 +22,7 @@
 #include "Firestore/core/src/firebase/firestore/model/document.h"
 #include "Firestore/core/src/firebase/firestore/model/field_value.h"
 #include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation_batch.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/patch_mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/set_mutation.h"
@@ -41,6 +42,7 @@ using testutil::DeletedDoc;
 using testutil::DeleteMutation;
 using testutil::Doc;
 using testutil::Field;
+using testutil::Key;
 using testutil::Map;
 using testutil::MutationResult;
 using testutil::PatchMutation;
@@ -309,6 +311,47 @@ TEST(MutationTest, AppliesIncrementWithoutUnderflow) {
   TransformBaseDoc(base_data, transforms, expected);
 }
 
+TEST(MutationTest, CombinesIncrementsAndArrayUnionsForLocalView) {
+  auto first = TransformMutation(
+      "collection/key", {{"count", Increment(2)}, {"tags", ArrayUnion(1, 2)}});
+  auto second = TransformMutation(
+      "collection/key", {{"count", Increment(3)}, {"tags", ArrayUnion(2, 3)}});
+
+  absl::optional<model::TransformMutation> combined =
+      first.CombineForLocalView(second);
+  ASSERT_TRUE(combined.has_value());
+
+  absl::optional<MaybeDocument> base_doc =
+      Doc("collection/key", 0, Map("count", 1, "tags", Array(3)));
+  absl::optional<MaybeDocument> first_doc =
+      first.ApplyToLocalView(base_doc, base_doc, now);
+  absl::optional<MaybeDocument> expected_doc =
+      second.ApplyToLocalView(first_doc, first_doc, now);
+  EXPECT_EQ(combined->ApplyToLocalView(base_doc, base_doc, now), expected_doc);
+  EXPECT_EQ(expected_doc, Doc("collection/key", 0,
+                              Map("count", 6, "tags", Array(3, 1, 2)),
+                              DocumentState::kLocalMutations));
+}
+
+TEST(MutationTest, DoesNotCombineTransformsThatDependOnOrder) {
+  auto increment =
+      TransformMutation("collection/key", {{"count", Increment(1)}});
+
+  EXPECT_FALSE(increment.CombineForLocalView(
+      TransformMutation("collection/key", {{"count", Increment(-1)}})));
+  EXPECT_FALSE(increment.CombineForLocalView(
+      TransformMutation("collection/key", {{"count", Increment(1.5)}})));
+  EXPECT_FALSE(increment.CombineForLocalView(
+      TransformMutation("collection/key", {{"count", ArrayUnion(1)}})));
+  EXPECT_FALSE(increment.CombineForLocalView(
+      TransformMutation("collection/key", {{"other", Increment(1)}})));
+  EXPECT_FALSE(increment.CombineForLocalView(
+      TransformMutation("collection/other", {{"count", Increment(1)}})));
+  EXPECT_FALSE(
+      TransformMutation("collection/key", {{"count", Increment(LONG_MAX)}})
+          .CombineForLocalView(increment));
+}
+
 TEST(MutationTest, AppliesLocalArrayUnionTransformToMissingField) {
   auto base_data = Map();
   TransformPairs transforms = {{"missing", ArrayUnion(1, 2)}};
@@ -503,6 +546,84 @@ TEST(MutationTest, Transitions) {
   // TODO(rsgowman)
 }
 
+MutationBatch Batch(std::vector<Mutation> mutations) {
+  return MutationBatch(1, now, {}, std::move(mutations));
+}
+
+TEST(MutationTest, CompactsSetFollowedBySet) {
+  MutationBatch batch = Batch({SetMutation("foo/a", Map("a", 1))});
+
+  auto compacted = batch.CompactWith({SetMutation("foo/a", Map("b", 2))});
+
+  ASSERT_TRUE(compacted);
+  EXPECT_EQ(*compacted, Batch({SetMutation("foo/a", Map("b", 2))}));
+}
+
+TEST(MutationTest, CompactsSetFollowedByPatch) {
+  MutationBatch batch = Batch({SetMutation("foo/a", Map("a", 1))});
+
+  auto compacted = batch.CompactWith({PatchMutation("foo/a", Map("b", 2))});
+
+  ASSERT_TRUE(compacted);
+  EXPECT_EQ(*compacted, Batch({SetMutation("foo/a", Map("a", 1, "b", 2))}));
+}
+
+TEST(MutationTest, CompactsPatchFollowedByPatch) {
+  MutationBatch batch = Batch({PatchMutation("foo/a", Map("a", 1))});
+
+  auto compacted = batch.CompactWith({PatchMutation("foo/a", Map("b", 2))});
+
+  ASSERT_TRUE(compacted);
+  Mutation expected =
+      model::PatchMutation(Key("foo/a"), WrapObject("a", 1, "b", 2),
+                           FieldMask{Field("a"), Field("b")},
+                           Precondition::Exists(true));
+  EXPECT_EQ(*compacted, Batch({expected}));
+}
+
+TEST(MutationTest, CompactsMergeFollowedByUpdate) {
+  MutationBatch batch =
+      Batch({PatchMutation("foo/a", Map("a", 1), {Field("a")})});
+
+  auto compacted = batch.CompactWith({PatchMutation("foo/a", Map("b", 2))});
+
+  // The merge creates the document, so the update can't fail after it.
+  ASSERT_TRUE(compacted);
+  Mutation expected =
+      model::PatchMutation(Key("foo/a"), WrapObject("a", 1, "b", 2),
+                           FieldMask{Field("a"), Field("b")},
+                           Precondition::None());
+  EXPECT_EQ(*compacted, Batch({expected}));
+}
+
+TEST(MutationTest, DoesNotCompactUpdateFollowedByWriteWithoutPrecondition) {
+  MutationBatch batch = Batch({PatchMutation("foo/a", Map("a", 1))});
+
+  // The update fails if the document is missing, while these apply anyway.
+  EXPECT_FALSE(
+      batch.CompactWith({PatchMutation("foo/a", Map("b", 2), {Field("b")})}));
+  EXPECT_FALSE(batch.CompactWith({SetMutation("foo/a", Map("b", 2))}));
+}
+
+TEST(MutationTest, DoesNotCompactMismatchedKeys) {
+  MutationBatch batch = Batch({SetMutation("foo/a", Map("a", 1)),
+                               SetMutation("foo/b", Map("b", 1))});
+
+  EXPECT_FALSE(batch.CompactWith({SetMutation("foo/a", Map("a", 2))}));
+  EXPECT_FALSE(batch.CompactWith({SetMutation("foo/a", Map("a", 2)),
+                                  SetMutation("foo/c", Map("c", 2))}));
+  EXPECT_FALSE(batch.CompactWith({SetMutation("foo/a", Map("a", 2)),
+                                  SetMutation("foo/a", Map("a", 3))}));
+}
+
+TEST(MutationTest, DoesNotCompactOtherMutations) {
+  MutationBatch batch = Batch({SetMutation("foo/a", Map("a", 1))});
+
+  EXPECT_FALSE(batch.CompactWith({DeleteMutation("foo/a")}));
+  EXPECT_FALSE(Batch({DeleteMutation("foo/a")})
+                   .CompactWith({SetMutation("foo/a", Map("a", 1))}));
+}
+
 }  // namespace
 }  // namespace model
 }  // namespace firestore
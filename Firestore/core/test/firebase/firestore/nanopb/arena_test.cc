@@ -0,0 +1,130 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/nanopb/arena.h"
+
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace nanopb {
+namespace {
+
+bool IsAligned(const void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t) == 0;
+}
+
+TEST(ArenaTest, AllocatesAlignedMemory) {
+  Arena arena;
+  void* first = arena.Allocate(1);
+  void* second = arena.Allocate(3);
+  void* third = arena.Allocate(sizeof(double));
+
+  EXPECT_TRUE(IsAligned(first));
+  EXPECT_TRUE(IsAligned(second));
+  EXPECT_TRUE(IsAligned(third));
+  EXPECT_NE(first, second);
+  EXPECT_NE(second, third);
+}
+
+TEST(ArenaTest, ContainsOnlyItsOwnAllocations) {
+  Arena arena;
+  int on_stack = 0;
+  void* allocated = arena.Allocate(16);
+
+  EXPECT_TRUE(arena.Contains(allocated));
+  EXPECT_FALSE(arena.Contains(&on_stack));
+  EXPECT_FALSE(arena.Contains(nullptr));
+}
+
+TEST(ArenaTest, AllocationsLargerThanABlock) {
+  Arena arena{64};
+  auto* small = static_cast<char*>(arena.Allocate(8));
+  auto* large = static_cast<char*>(arena.Allocate(1024));
+  std::memset(large, 'a', 1024);
+  std::memset(small, 'b', 8);
+
+  EXPECT_TRUE(arena.Contains(large + 1023));
+  EXPECT_EQ(large[1023], 'a');
+  EXPECT_GE(arena.allocated_bytes(), 1024u + 8u);
+}
+
+TEST(ArenaTest, ReallocateNullAllocates) {
+  Arena arena;
+  void* ptr = arena.Reallocate(nullptr, 10);
+  EXPECT_NE(ptr, nullptr);
+  EXPECT_TRUE(arena.Contains(ptr));
+}
+
+TEST(ArenaTest, ReallocateExtendsLastAllocationInPlace) {
+  Arena arena;
+  auto* ptr = static_cast<int*>(arena.Allocate(sizeof(int)));
+  for (int i = 1; i <= 100; ++i) {
+    ptr = static_cast<int*>(arena.Reallocate(ptr, sizeof(int) * i));
+    ptr[i - 1] = i;
+  }
+
+  // Growing one element at a time, the way Nanopb grows repeated fields,
+  // shouldn't copy the array each time.
+  EXPECT_LT(arena.allocated_bytes(), sizeof(int) * 100 * 2);
+  for (int i = 1; i <= 100; ++i) {
+    EXPECT_EQ(ptr[i - 1], i);
+  }
+}
+
+TEST(ArenaTest, ReallocateCopiesEarlierAllocations) {
+  Arena arena;
+  auto* first = static_cast<char*>(arena.Allocate(4));
+  std::memcpy(first, "abc", 4);
+  arena.Allocate(4);
+
+  auto* grown = static_cast<char*>(arena.Reallocate(first, 64));
+  EXPECT_NE(grown, first);
+  EXPECT_STREQ(grown, "abc");
+}
+
+TEST(ArenaTest, Reset) {
+  Arena arena;
+  void* ptr = arena.Allocate(16);
+  arena.Reset();
+
+  EXPECT_FALSE(arena.Contains(ptr));
+  EXPECT_EQ(arena.allocated_bytes(), 0u);
+}
+
+TEST(ArenaScopeTest, Nests) {
+  Arena outer;
+  Arena inner;
+  EXPECT_EQ(ArenaScope::Current(), nullptr);
+  {
+    ArenaScope outer_scope{&outer};
+    EXPECT_EQ(ArenaScope::Current(), &outer);
+    {
+      ArenaScope inner_scope{&inner};
+      EXPECT_EQ(ArenaScope::Current(), &inner);
+    }
+    EXPECT_EQ(ArenaScope::Current(), &outer);
+  }
+  EXPECT_EQ(ArenaScope::Current(), nullptr);
+}
+
+}  //  namespace
+}  //  namespace nanopb
+}  //  namespace firestore
+}  //  namespace firebase
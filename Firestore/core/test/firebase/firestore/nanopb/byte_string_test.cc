@@ -18,6 +18,8 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <string>
+#include <utility>
 
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
 #include "gmock/gmock.h"
@@ -148,6 +150,46 @@ TEST(ByteStringTest, Release) {
   std::free(released);
 }
 
+TEST(ByteStringTest, ReleasesSharedBytesAsACopy) {
+  std::string long_value(100, 'a');
+  ByteString value{long_value};
+  ByteString copy = value;
+
+  freed_ptr<pb_bytes_array_t> released{value.release()};
+  EXPECT_EQ(value.get(), nullptr);
+  EXPECT_NE(released.get(), copy.get());
+  EXPECT_EQ(MakeString(released.get()), long_value);
+  EXPECT_EQ(copy.ToString(), long_value);
+}
+
+TEST(ByteStringTest, CopiesShareLongValues) {
+  ByteString original{std::string(100, 'a')};
+  ByteString copy = original;
+  EXPECT_EQ(copy.data(), original.data());
+
+  ByteString assigned;
+  assigned = copy;
+  EXPECT_EQ(assigned.data(), original.data());
+
+  ByteString moved = std::move(copy);
+  EXPECT_EQ(moved.data(), original.data());
+  EXPECT_TRUE(copy.empty());  // NOLINT(bugprone-use-after-move)
+
+  original = ByteString{};
+  EXPECT_EQ(moved, ByteString{std::string(100, 'a')});
+}
+
+TEST(ByteStringTest, CopiesShortValuesInline) {
+  ByteString original{"token"};
+  ByteString copy = original;
+  EXPECT_NE(copy.data(), original.data());
+  EXPECT_EQ(copy, original);
+
+  // Short values are null-terminated, like those copied into byte arrays.
+  EXPECT_EQ(copy.data()[copy.size()], '\0');
+  EXPECT_EQ(MakeString(copy.get()), "token");
+}
+
 TEST(ByteStringTest, Comparison) {
   ByteString abc{"abc"};
   ByteString def{"def"};
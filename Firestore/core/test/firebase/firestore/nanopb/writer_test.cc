@@ -16,6 +16,8 @@
 
 #include "Firestore/core/src/firebase/firestore/nanopb/writer.h"
 
+#include <string>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
@@ -67,6 +69,15 @@ TEST(BasicStringWriterTest, Releases) {
   EXPECT_EQ(second.get(), nullptr);
 }
 
+TEST(StringWriterTest, ReservesInTheTargetString) {
+  std::string target = "foo";
+  StringWriter writer(&target);
+
+  writer.Reserve(100);
+  EXPECT_GE(target.capacity(), 100);
+  EXPECT_EQ(target, "foo");
+}
+
 }  //  namespace nanopb
 }  //  namespace firestore
 }  //  namespace firebase
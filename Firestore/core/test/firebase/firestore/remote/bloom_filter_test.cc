@@ -0,0 +1,90 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
+
+#include <string>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using util::StatusOr;
+
+const char* kDocuments =
+    "projects/test-project/databases/(default)/documents/";
+
+std::string Name(const char* path) {
+  return std::string(kDocuments) + path;
+}
+
+/**
+ * A 61-bit filter with 3 hashes containing "coll/a" and "coll/b", as the
+ * backend would encode it.
+ */
+BloomFilter TwoDocumentFilter() {
+  std::vector<uint8_t> bitmap{0x20, 0x40, 0x00, 0x00, 0x60, 0x02, 0x00, 0x10};
+  return BloomFilter::Create(bitmap, 3, 3).ValueOrDie();
+}
+
+}  // namespace
+
+TEST(BloomFilterTest, ContainsAddedDocuments) {
+  BloomFilter filter = TwoDocumentFilter();
+  EXPECT_EQ(filter.bit_count(), 61);
+  EXPECT_EQ(filter.hash_count(), 3);
+
+  EXPECT_TRUE(filter.MightContain(Name("coll/a")));
+  EXPECT_TRUE(filter.MightContain(Name("coll/b")));
+  EXPECT_FALSE(filter.MightContain(Name("coll/c")));
+  EXPECT_FALSE(filter.MightContain(Name("coll/d")));
+}
+
+TEST(BloomFilterTest, EmptyFilterContainsNothing) {
+  StatusOr<BloomFilter> filter = BloomFilter::Create({}, 0, 0);
+  ASSERT_TRUE(filter.ok());
+  EXPECT_EQ(filter.ValueOrDie().bit_count(), 0);
+  EXPECT_FALSE(filter.ValueOrDie().MightContain(""));
+  EXPECT_FALSE(filter.ValueOrDie().MightContain(Name("coll/a")));
+}
+
+TEST(BloomFilterTest, RejectsInvalidParameters) {
+  EXPECT_FALSE(BloomFilter::Create({1}, -1, 1).ok());
+  EXPECT_FALSE(BloomFilter::Create({1}, 8, 1).ok());
+  EXPECT_FALSE(BloomFilter::Create({1}, 0, -1).ok());
+  EXPECT_FALSE(BloomFilter::Create({1}, 0, 0).ok());
+  EXPECT_FALSE(BloomFilter::Create({}, 1, 0).ok());
+}
+
+TEST(BloomFilterTest, Equality) {
+  std::vector<uint8_t> bitmap{0x20, 0x40, 0x00, 0x00, 0x60, 0x02, 0x00, 0x10};
+  EXPECT_EQ(TwoDocumentFilter(), TwoDocumentFilter());
+  EXPECT_NE(TwoDocumentFilter(),
+            BloomFilter::Create({0x20}, 3, 3).ValueOrDie());
+  EXPECT_NE(TwoDocumentFilter(),
+            BloomFilter::Create(bitmap, 2, 3).ValueOrDie());
+  EXPECT_NE(TwoDocumentFilter(),
+            BloomFilter::Create(bitmap, 3, 2).ValueOrDie());
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -20,6 +20,7 @@
 
 #include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
 #include "Firestore/Protos/nanopb/google/firestore/v1/firestore.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
 #include "Firestore/core/src/firebase/firestore/model/mutation.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/message.h"
 #include "Firestore/core/src/firebase/firestore/nanopb/nanopb_util.h"
@@ -91,6 +92,20 @@ grpc::ByteBuffer MakeFakeDocument(const std::string& doc_name) {
   return MakeByteBuffer(response);
 }
 
+grpc::ByteBuffer MakeFakeQueryResponse(const std::string& doc_name) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  Message<google_firestore_v1_RunQueryResponse> response;
+
+  google_firestore_v1_Document& doc = response->document;
+  doc.name = serializer.EncodeString(
+      absl::StrCat("projects/p/databases/d/documents/", doc_name));
+  doc.has_update_time = true;
+  doc.update_time.nanos = 42000;
+  response->read_time.seconds = 1;
+
+  return MakeByteBuffer(response);
+}
+
 class FakeDatastore : public Datastore {
  public:
   using Datastore::Datastore;
@@ -261,6 +276,89 @@ TEST_F(DatastoreTest, LookupDocumentsTwoSuccessfulReads) {
   EXPECT_TRUE(resulting_status.ok());
 }
 
+TEST_F(DatastoreTest, LookupDocumentsCoalescesConcurrentLookups) {
+  credentials->DelayGetToken();
+
+  std::vector<MaybeDocument> docs1;
+  std::vector<MaybeDocument> docs2;
+  worker_queue->EnqueueBlocking([&] {
+    datastore->LookupDocuments(
+        {testutil::Key("foo/1")},
+        [&](const StatusOr<std::vector<MaybeDocument>>& maybe_documents) {
+          docs1 = maybe_documents.ValueOrDie();
+        });
+    datastore->LookupDocuments(
+        {testutil::Key("foo/1"), testutil::Key("foo/2")},
+        [&](const StatusOr<std::vector<MaybeDocument>>& maybe_documents) {
+          docs2 = maybe_documents.ValueOrDie();
+        });
+  });
+  credentials->InvokeGetToken();
+  worker_queue->EnqueueBlocking([] {});
+
+  // Both lookups are answered by a single call.
+  ForceFinishAnyTypeOrder(
+      {{Type::Write, CompletionResult::Ok},
+       {Type::Read, MakeFakeDocument("foo/1")},
+       {Type::Read, MakeFakeDocument("foo/2")},
+       /*Read after last*/ {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  ASSERT_EQ(docs1.size(), 1);
+  EXPECT_EQ(docs1[0].key().ToString(), "foo/1");
+  ASSERT_EQ(docs2.size(), 2);
+  EXPECT_EQ(docs2[0].key().ToString(), "foo/1");
+  EXPECT_EQ(docs2[1].key().ToString(), "foo/2");
+}
+
+TEST_F(DatastoreTest, RunQueryReadsDocumentsInQueryOrder) {
+  StatusOr<RunQueryResult> result;
+  worker_queue->EnqueueBlocking([&] {
+    datastore->RunQuery(testutil::Query("foo").ToTarget(),
+                        [&](const StatusOr<RunQueryResult>& query_result) {
+                          result = query_result;
+                        });
+  });
+  // Make sure Auth has a chance to run.
+  worker_queue->EnqueueBlocking([] {});
+
+  ForceFinishAnyTypeOrder(
+      {{Type::Write, CompletionResult::Ok},
+       {Type::Read, MakeFakeQueryResponse("foo/2")},
+       {Type::Read, MakeFakeQueryResponse("foo/1")},
+       /*Read after last*/ {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  ASSERT_TRUE(result.ok());
+  const RunQueryResult& query_result = result.ValueOrDie();
+  ASSERT_EQ(query_result.documents.size(), 2);
+  EXPECT_EQ(query_result.documents[0].key().ToString(), "foo/2");
+  EXPECT_EQ(query_result.documents[1].key().ToString(), "foo/1");
+  EXPECT_EQ(query_result.read_time, testutil::Version(1000000));
+  EXPECT_GT(query_result.byte_size, 0);
+}
+
+TEST_F(DatastoreTest, CountQueryCountsReturnedDocuments) {
+  StatusOr<int64_t> result;
+  worker_queue->EnqueueBlocking([&] {
+    datastore->CountQuery(
+        testutil::Query("foo").ToTarget(),
+        [&](const StatusOr<int64_t>& count) { result = count; });
+  });
+  // Make sure Auth has a chance to run.
+  worker_queue->EnqueueBlocking([] {});
+
+  ForceFinishAnyTypeOrder(
+      {{Type::Write, CompletionResult::Ok},
+       {Type::Read, MakeFakeQueryResponse("foo/1")},
+       {Type::Read, MakeFakeQueryResponse("foo/2")},
+       /*Read after last*/ {Type::Read, CompletionResult::Error}});
+  ForceFinish({{Type::Finish, grpc::Status::OK}});
+
+  ASSERT_TRUE(result.ok());
+  EXPECT_EQ(result.ValueOrDie(), 2);
+}
+
 // gRPC errors
 
 TEST_F(DatastoreTest, CommitMutationsError) {
@@ -88,6 +88,36 @@ TEST_F(ExponentialBackoffTest, SequentialCallsToBackoffAndRun) {
   Await(finished);
 }
 
+TEST_F(ExponentialBackoffTest, DecorrelatedJitter) {
+  ExponentialBackoff decorrelated{
+      queue, timer_id,
+      BackoffProfile{3.0, chr::seconds{5}, chr::seconds{30},
+                     BackoffJitter::Decorrelated}};
+
+  Expectation finished;
+  queue->EnqueueBlocking([&] {
+    decorrelated.BackoffAndRun([] {});
+    decorrelated.BackoffAndRun([] {});
+    decorrelated.BackoffAndRun(finished.AsCallback());
+  });
+
+  queue->RunScheduledOperationsUntil(timer_id);
+  Await(finished);
+}
+
+TEST_F(ExponentialBackoffTest, DelayAtLeast) {
+  Expectation finished;
+  queue->EnqueueBlocking([&] {
+    // Without the requested delay, the first attempt would run immediately.
+    backoff.DelayAtLeast(chr::seconds{10});
+    backoff.BackoffAndRun(finished.AsCallback());
+    EXPECT_TRUE(queue->IsScheduled(timer_id));
+  });
+
+  queue->RunScheduledOperationsUntil(timer_id);
+  Await(finished);
+}
+
 }  // namespace remote
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,523 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/remote/fake_backend.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "Firestore/core/include/firebase/firestore/firestore_errors.h"
+#include "Firestore/core/include/firebase/firestore/timestamp.h"
+#include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/local/target_data.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/no_document.h"
+#include "Firestore/core/src/firebase/firestore/model/precondition.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_stream.h"
+#include "Firestore/core/src/firebase/firestore/remote/write_stream.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/util/create_noop_connectivity_monitor.h"
+#include "absl/memory/memory.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using auth::CredentialsProvider;
+using core::LimitType;
+using core::Query;
+using core::Target;
+using local::TargetData;
+using model::Document;
+using model::DocumentKey;
+using model::DocumentState;
+using model::MaybeDocument;
+using model::Mutation;
+using model::MutationResult;
+using model::NoDocument;
+using model::Precondition;
+using model::SnapshotVersion;
+using model::TargetId;
+using nanopb::ByteString;
+using util::AsyncQueue;
+using util::CreateNoOpConnectivityMonitor;
+using util::Executor;
+using util::Status;
+
+SnapshotVersion ToSnapshotVersion(int64_t version) {
+  return SnapshotVersion{Timestamp{version, 0}};
+}
+
+bool Matches(const Target& target, const MaybeDocument& maybe_doc) {
+  if (!maybe_doc.is_document()) return false;
+
+  const DocumentKey& key = maybe_doc.key();
+  if (target.IsMultiDocumentTarget()) {
+    return std::binary_search(target.document_keys().begin(),
+                              target.document_keys().end(), key);
+  }
+  if (target.IsDocumentQuery()) {
+    return key.path() == target.path();
+  }
+  Query query{target.path(), target.collection_group(), target.filters(),
+              {},            Target::kNoLimit,            LimitType::None,
+              nullptr,       nullptr};
+  return query.Matches(Document(maybe_doc));
+}
+
+/**
+ * Checks a precondition the way the backend does, where an update time of
+ * zero (which a transaction sends for a document it read as missing) means
+ * the document must not exist.
+ */
+bool PreconditionHolds(const Precondition& precondition,
+                       const absl::optional<MaybeDocument>& maybe_doc) {
+  if (precondition.type() == Precondition::Type::UpdateTime &&
+      precondition.update_time() == SnapshotVersion::None()) {
+    return !maybe_doc || !maybe_doc->is_document();
+  }
+  return precondition.IsValidFor(maybe_doc);
+}
+
+class FakeWatchStream : public WatchStream {
+ public:
+  FakeWatchStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                  std::shared_ptr<CredentialsProvider> credentials_provider,
+                  Serializer serializer,
+                  GrpcConnection* grpc_connection,
+                  WatchStreamCallback* callback,
+                  std::shared_ptr<FakeBackend> backend)
+      : WatchStream{worker_queue, std::move(credentials_provider),
+                    std::move(serializer), grpc_connection, callback},
+        worker_queue_{worker_queue},
+        callback_{callback},
+        backend_{std::move(backend)} {
+  }
+
+  void Start() override {
+    HARD_ASSERT(!open_, "Trying to start already started watch stream");
+    open_ = true;
+
+    std::weak_ptr<Stream> weak_this = shared_from_this();
+    int generation = ++generation_;
+    watch_id_ = backend_->AddWatch(
+        worker_queue_, [weak_this, generation](
+                           FakeBackend::WatchChanges changes,
+                           const SnapshotVersion& snapshot_version) {
+          auto shared_this = weak_this.lock();
+          if (!shared_this) return;
+          static_cast<FakeWatchStream*>(shared_this.get())
+              ->OnChanges(generation, changes, snapshot_version);
+        });
+    callback_->OnWatchStreamOpen();
+  }
+
+  void Stop() override {
+    if (open_) {
+      backend_->RemoveWatch(watch_id_);
+    }
+    WatchStream::Stop();
+    open_ = false;
+  }
+
+  bool IsStarted() const override {
+    return open_;
+  }
+  bool IsOpen() const override {
+    return open_;
+  }
+
+  void WatchQuery(const TargetData& query) override {
+    backend_->Watch(watch_id_, query.target_id(), query.target(),
+                    !query.resume_token().empty());
+  }
+
+  void UnwatchTargetId(TargetId target_id) override {
+    backend_->Unwatch(watch_id_, target_id);
+  }
+
+ private:
+  void OnChanges(int generation,
+                 const FakeBackend::WatchChanges& changes,
+                 const SnapshotVersion& snapshot_version) {
+    // Drop changes meant for a previous incarnation of the stream.
+    if (!open_ || generation != generation_) return;
+
+    // As on the wire, only the global change at the end carries a version.
+    for (size_t i = 0; i < changes.size(); ++i) {
+      bool last = i + 1 == changes.size();
+      callback_->OnWatchStreamChange(
+          *changes[i], last ? snapshot_version : SnapshotVersion::None());
+    }
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  WatchStreamCallback* callback_ = nullptr;
+  std::shared_ptr<FakeBackend> backend_;
+  bool open_ = false;
+  int generation_ = 0;
+  FakeBackend::WatchId watch_id_ = 0;
+};
+
+class FakeWriteStream : public WriteStream {
+ public:
+  FakeWriteStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                  std::shared_ptr<CredentialsProvider> credentials_provider,
+                  Serializer serializer,
+                  GrpcConnection* grpc_connection,
+                  WriteStreamCallback* callback,
+                  std::shared_ptr<FakeBackend> backend)
+      : WriteStream{worker_queue, std::move(credentials_provider),
+                    std::move(serializer), grpc_connection, callback},
+        worker_queue_{worker_queue},
+        callback_{callback},
+        backend_{std::move(backend)} {
+  }
+
+  void Start() override {
+    HARD_ASSERT(!open_, "Trying to start already started write stream");
+    open_ = true;
+    ++generation_;
+    callback_->OnWriteStreamOpen();
+  }
+
+  void Stop() override {
+    WriteStream::Stop();
+    open_ = false;
+    SetHandshakeComplete(false);
+  }
+
+  bool IsStarted() const override {
+    return open_;
+  }
+  bool IsOpen() const override {
+    return open_;
+  }
+
+  void WriteHandshake() override {
+    SetHandshakeComplete();
+    callback_->OnWriteStreamHandshakeComplete();
+  }
+
+  void WriteMutations(const std::vector<Mutation>& mutations) override {
+    std::weak_ptr<Stream> weak_this = shared_from_this();
+    int generation = generation_;
+    size_t count = mutations.size();
+    backend_->Commit(
+        mutations, worker_queue_,
+        [weak_this, generation, count](const Status& status,
+                                       const SnapshotVersion& version) {
+          auto shared_this = weak_this.lock();
+          if (!shared_this) return;
+          static_cast<FakeWriteStream*>(shared_this.get())
+              ->OnCommit(generation, count, status, version);
+        });
+  }
+
+ private:
+  void OnCommit(int generation,
+                size_t count,
+                const Status& status,
+                const SnapshotVersion& version) {
+    if (!open_ || generation != generation_) return;
+
+    if (!status.ok()) {
+      // The backend fails the whole stream when a write is rejected.
+      open_ = false;
+      SetHandshakeComplete(false);
+      callback_->OnWriteStreamClose(status);
+      return;
+    }
+    std::vector<MutationResult> results(count,
+                                        MutationResult{version, absl::nullopt});
+    callback_->OnWriteStreamMutationResult(version, std::move(results));
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  WriteStreamCallback* callback_ = nullptr;
+  std::shared_ptr<FakeBackend> backend_;
+  bool open_ = false;
+  int generation_ = 0;
+};
+
+class FakeDatastore : public Datastore {
+ public:
+  FakeDatastore(const core::DatabaseInfo& database_info,
+                const std::shared_ptr<AsyncQueue>& worker_queue,
+                std::shared_ptr<CredentialsProvider> credentials,
+                std::shared_ptr<FakeBackend> backend)
+      : Datastore{database_info, worker_queue, credentials,
+                  CreateNoOpConnectivityMonitor()},
+        worker_queue_{worker_queue},
+        credentials_{std::move(credentials)},
+        backend_{std::move(backend)} {
+  }
+
+  std::shared_ptr<WatchStream> CreateWatchStream(
+      WatchStreamCallback* callback) override {
+    return std::make_shared<FakeWatchStream>(
+        worker_queue_, credentials_, Serializer{database_id()},
+        grpc_connection(), callback, backend_);
+  }
+
+  std::shared_ptr<WriteStream> CreateWriteStream(
+      WriteStreamCallback* callback) override {
+    return std::make_shared<FakeWriteStream>(
+        worker_queue_, credentials_, Serializer{database_id()},
+        grpc_connection(), callback, backend_);
+  }
+
+  void CommitMutations(const std::vector<Mutation>& mutations,
+                       CommitCallback&& callback) override {
+    backend_->Commit(mutations, worker_queue_,
+                     [callback](const Status& status, const SnapshotVersion&) {
+                       callback(status);
+                     });
+  }
+
+  void LookupDocuments(const std::vector<DocumentKey>& keys,
+                       LookupCallback&& callback) override {
+    backend_->Lookup(keys, worker_queue_, std::move(callback));
+  }
+
+ private:
+  std::shared_ptr<AsyncQueue> worker_queue_;
+  std::shared_ptr<CredentialsProvider> credentials_;
+  std::shared_ptr<FakeBackend> backend_;
+};
+
+}  // namespace
+
+FakeBackend::FakeBackend(std::chrono::milliseconds latency)
+    : latency_{latency},
+      executor_{Executor::CreateSerial("com.google.firebase.firestore.fake")} {
+}
+
+std::shared_ptr<Datastore> FakeBackend::CreateDatastore(
+    const core::DatabaseInfo& database_info,
+    const std::shared_ptr<AsyncQueue>& worker_queue,
+    std::shared_ptr<CredentialsProvider> credentials) {
+  return std::make_shared<FakeDatastore>(database_info, worker_queue,
+                                         std::move(credentials),
+                                         shared_from_this());
+}
+
+size_t FakeBackend::document_count() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return static_cast<size_t>(
+      std::count_if(documents_.begin(), documents_.end(),
+                    [](const std::pair<const DocumentKey, MaybeDocument>& doc) {
+                      return doc.second.is_document();
+                    }));
+}
+
+SnapshotVersion FakeBackend::version() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return ToSnapshotVersion(version_);
+}
+
+FakeBackend::WatchId FakeBackend::AddWatch(
+    std::shared_ptr<AsyncQueue> worker_queue, WatchDelivery delivery) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  WatchId watch_id = ++next_watch_id_;
+  watches_[watch_id] = WatchState{std::move(worker_queue), std::move(delivery),
+                                  {}};
+  return watch_id;
+}
+
+void FakeBackend::RemoveWatch(WatchId watch_id) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  watches_.erase(watch_id);
+}
+
+void FakeBackend::Watch(WatchId watch_id,
+                        TargetId target_id,
+                        const Target& target,
+                        bool resuming) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto found = watches_.find(watch_id);
+  if (found == watches_.end()) return;
+  WatchState& watch = found->second;
+  watch.targets[target_id] = target;
+
+  auto changes = std::make_shared<WatchChanges>();
+  changes->push_back(absl::make_unique<WatchTargetChange>(
+      WatchTargetChangeState::Added, std::vector<TargetId>{target_id}));
+  if (resuming) {
+    // Changes since the resume token aren't kept, so send the whole result
+    // again.
+    changes->push_back(absl::make_unique<WatchTargetChange>(
+        WatchTargetChangeState::Reset, std::vector<TargetId>{target_id}));
+  }
+  for (const auto& entry : documents_) {
+    if (Matches(target, entry.second)) {
+      changes->push_back(absl::make_unique<DocumentWatchChange>(
+          std::vector<TargetId>{target_id}, std::vector<TargetId>{},
+          entry.first, entry.second));
+    }
+  }
+  changes->push_back(absl::make_unique<WatchTargetChange>(
+      WatchTargetChangeState::Current, std::vector<TargetId>{target_id},
+      ByteString{std::to_string(version_)}));
+  changes->push_back(absl::make_unique<WatchTargetChange>(
+      WatchTargetChangeState::NoChange, std::vector<TargetId>{}));
+
+  SnapshotVersion version = ToSnapshotVersion(version_);
+  WatchDelivery delivery = watch.delivery;
+  Deliver(watch.worker_queue, [delivery, changes, version] {
+    delivery(std::move(*changes), version);
+  });
+}
+
+void FakeBackend::Unwatch(WatchId watch_id, TargetId target_id) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  auto found = watches_.find(watch_id);
+  if (found == watches_.end()) return;
+  found->second.targets.erase(target_id);
+}
+
+void FakeBackend::Commit(const std::vector<Mutation>& mutations,
+                         const std::shared_ptr<AsyncQueue>& worker_queue,
+                         CommitCallback callback) {
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  // Mutations of the same document see each other's results.
+  std::map<DocumentKey, absl::optional<MaybeDocument>> staged;
+  auto current = [&](const DocumentKey& key) -> absl::optional<MaybeDocument> {
+    auto found = staged.find(key);
+    if (found != staged.end()) return found->second;
+    auto existing = documents_.find(key);
+    if (existing != documents_.end()) return existing->second;
+    return absl::nullopt;
+  };
+
+  SnapshotVersion version = ToSnapshotVersion(version_ + 1);
+  for (const Mutation& mutation : mutations) {
+    absl::optional<MaybeDocument> maybe_doc = current(mutation.key());
+    if (!PreconditionHolds(mutation.precondition(), maybe_doc)) {
+      Status error{Error::kFailedPrecondition,
+                   "A precondition of the commit was not met"};
+      Deliver(worker_queue, [callback, error] {
+        callback(error, SnapshotVersion::None());
+      });
+      return;
+    }
+
+    MaybeDocument result = mutation.ApplyToRemoteDocument(
+        maybe_doc, MutationResult{version, absl::nullopt});
+    if (result.is_document()) {
+      staged[mutation.key()] = Document{Document(result).data(), result.key(),
+                                        version, DocumentState::kSynced};
+    } else {
+      staged[mutation.key()] = NoDocument{result.key(), version, false};
+    }
+  }
+
+  ++version_;
+  std::vector<MaybeDocument> before;
+  std::vector<MaybeDocument> after;
+  for (auto& entry : staged) {
+    auto existing = documents_.find(entry.first);
+    before.push_back(existing != documents_.end()
+                         ? existing->second
+                         : NoDocument{entry.first, SnapshotVersion::None(),
+                                      false});
+    after.push_back(*entry.second);
+    documents_[entry.first] = *entry.second;
+  }
+
+  Deliver(worker_queue, [callback, version] {
+    callback(Status::OK(), version);
+  });
+  NotifyWatchesLocked(before, after);
+}
+
+void FakeBackend::Lookup(const std::vector<DocumentKey>& keys,
+                         const std::shared_ptr<AsyncQueue>& worker_queue,
+                         Datastore::LookupCallback callback) {
+  std::lock_guard<std::mutex> lock{mutex_};
+
+  SnapshotVersion read_time = ToSnapshotVersion(version_);
+  std::vector<MaybeDocument> result;
+  for (const DocumentKey& key : keys) {
+    auto found = documents_.find(key);
+    if (found != documents_.end() && found->second.is_document()) {
+      result.push_back(found->second);
+    } else {
+      result.push_back(NoDocument{key, read_time, false});
+    }
+  }
+
+  Deliver(worker_queue, [callback, result] { callback(result); });
+}
+
+void FakeBackend::Deliver(const std::shared_ptr<AsyncQueue>& worker_queue,
+                          AsyncQueue::Operation operation) {
+  // Operations go through the backend's own executor, so that one client's
+  // request never enqueues onto its worker queue from the worker queue, and
+  // so that responses keep their order whatever the latency.
+  auto enqueue = [worker_queue, operation] {
+    worker_queue->Enqueue(operation);
+  };
+  if (latency_.count() == 0) {
+    executor_->Execute(std::move(enqueue));
+  } else {
+    executor_->Schedule(latency_, Executor::TaggedOperation{
+                                      0, std::move(enqueue)});
+  }
+}
+
+void FakeBackend::NotifyWatchesLocked(const std::vector<MaybeDocument>& before,
+                                      const std::vector<MaybeDocument>& after) {
+  SnapshotVersion version = ToSnapshotVersion(version_);
+  for (const auto& entry : watches_) {
+    const WatchState& watch = entry.second;
+
+    auto changes = std::make_shared<WatchChanges>();
+    for (size_t i = 0; i < after.size(); ++i) {
+      std::vector<TargetId> updated;
+      std::vector<TargetId> removed;
+      for (const auto& target : watch.targets) {
+        if (Matches(target.second, after[i])) {
+          updated.push_back(target.first);
+        } else if (Matches(target.second, before[i])) {
+          removed.push_back(target.first);
+        }
+      }
+      if (updated.empty() && removed.empty()) continue;
+
+      changes->push_back(absl::make_unique<DocumentWatchChange>(
+          std::move(updated), std::move(removed), after[i].key(), after[i]));
+    }
+    if (changes->empty()) continue;
+
+    changes->push_back(absl::make_unique<WatchTargetChange>(
+        WatchTargetChangeState::NoChange, std::vector<TargetId>{}));
+    WatchDelivery delivery = watch.delivery;
+    Deliver(watch.worker_queue, [delivery, changes, version] {
+      delivery(std::move(*changes), version);
+    });
+  }
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
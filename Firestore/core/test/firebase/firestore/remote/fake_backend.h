@@ -0,0 +1,161 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_FAKE_BACKEND_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_FAKE_BACKEND_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <unordered_map>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/core/target.h"
+#include "Firestore/core/src/firebase/firestore/model/document_key.h"
+#include "Firestore/core/src/firebase/firestore/model/maybe_document.h"
+#include "Firestore/core/src/firebase/firestore/model/mutation.h"
+#include "Firestore/core/src/firebase/firestore/model/snapshot_version.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+class WatchChange;
+
+/**
+ * An in-process stand-in for the Firestore backend, shared by any number of
+ * clients. Each client talks to it through a `Datastore` created by
+ * `CreateDatastore`, which can be passed to `FirestoreClient::Create` as its
+ * `DatastoreFactory`.
+ *
+ * The backend keeps the documents of a single database in memory. It commits
+ * writes from the write stream and from transactions, checking their
+ * preconditions, and sends the changes to every watch target they affect,
+ * whichever client is listening. Targets are matched on their path and
+ * filters; limits and bounds are left for the clients to apply. Field
+ * transforms are not supported.
+ *
+ * Responses are delivered on the worker queue of the receiving client after
+ * the configured latency, in the order the backend produced them.
+ */
+class FakeBackend : public std::enable_shared_from_this<FakeBackend> {
+ public:
+  explicit FakeBackend(
+      std::chrono::milliseconds latency = std::chrono::milliseconds(0));
+
+  /**
+   * Creates a `Datastore` connected to this backend. The signature matches
+   * `core::DatastoreFactory`.
+   */
+  std::shared_ptr<Datastore> CreateDatastore(
+      const core::DatabaseInfo& database_info,
+      const std::shared_ptr<util::AsyncQueue>& worker_queue,
+      std::shared_ptr<auth::CredentialsProvider> credentials);
+
+  /** The number of documents that currently exist. */
+  size_t document_count() const;
+
+  /** The version of the last commit. */
+  model::SnapshotVersion version() const;
+
+  // The interface for the streams and datastores of the clients follows.
+
+  using WatchId = int;
+  using WatchChanges = std::vector<std::unique_ptr<WatchChange>>;
+
+  /**
+   * Receives the changes for the targets of one watch stream. Called on the
+   * worker queue of the stream, with the version the changes are current at.
+   */
+  using WatchDelivery =
+      std::function<void(WatchChanges, const model::SnapshotVersion&)>;
+
+  /** Registers an open watch stream, whose changes go to `delivery`. */
+  WatchId AddWatch(std::shared_ptr<util::AsyncQueue> worker_queue,
+                   WatchDelivery delivery);
+  void RemoveWatch(WatchId watch_id);
+
+  /**
+   * Starts sending the changes to the documents matching `target` to the
+   * given watch, starting with the current results. If `resuming`, the target
+   * is reset first, as when its resume token has expired.
+   */
+  void Watch(WatchId watch_id,
+             model::TargetId target_id,
+             const core::Target& target,
+             bool resuming);
+  void Unwatch(WatchId watch_id, model::TargetId target_id);
+
+  /**
+   * Commits `mutations` atomically. On success, `callback` receives the
+   * commit version and changes are sent to the affected watch targets. If a
+   * precondition fails, nothing is committed and `callback` receives a
+   * `kFailedPrecondition` error.
+   */
+  using CommitCallback =
+      std::function<void(const util::Status&, const model::SnapshotVersion&)>;
+  void Commit(const std::vector<model::Mutation>& mutations,
+              const std::shared_ptr<util::AsyncQueue>& worker_queue,
+              CommitCallback callback);
+
+  /** Reads the current versions of `keys`. */
+  void Lookup(const std::vector<model::DocumentKey>& keys,
+              const std::shared_ptr<util::AsyncQueue>& worker_queue,
+              Datastore::LookupCallback callback);
+
+ private:
+  struct WatchState {
+    std::shared_ptr<util::AsyncQueue> worker_queue;
+    WatchDelivery delivery;
+    std::unordered_map<model::TargetId, core::Target> targets;
+  };
+
+  /** Runs `operation` on `worker_queue` once the latency has passed. */
+  void Deliver(const std::shared_ptr<util::AsyncQueue>& worker_queue,
+               util::AsyncQueue::Operation operation);
+
+  /**
+   * Sends the changes to `before` (the previous state of the documents of
+   * `after`) to every watch target they affect. Must be called with the mutex
+   * held.
+   */
+  void NotifyWatchesLocked(const std::vector<model::MaybeDocument>& before,
+                           const std::vector<model::MaybeDocument>& after);
+
+  std::chrono::milliseconds latency_;
+  std::unique_ptr<util::Executor> executor_;
+
+  mutable std::mutex mutex_;
+  int64_t version_ = 0;
+  std::map<model::DocumentKey, model::MaybeDocument> documents_;
+  WatchId next_watch_id_ = 0;
+  std::unordered_map<WatchId, WatchState> watches_;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_FAKE_BACKEND_H_
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion_poller.h"
+
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/test/firebase/firestore/testutil/async_testing.h"
+#include "absl/memory/memory.h"
+#include "grpcpp/alarm.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using testutil::AsyncQueueForTesting;
+using testutil::Expectation;
+using util::AsyncQueue;
+using Type = GrpcCompletion::Type;
+
+class GrpcCompletionPollerTest : public testing::Test,
+                                 public testutil::AsyncTest {
+ public:
+  GrpcCompletionPollerTest()
+      : worker_queue{AsyncQueueForTesting()},
+        other_queue{AsyncQueueForTesting()} {
+  }
+
+  /**
+   * Creates a completion that appends `index` to `record` on the given queue
+   * and fulfills `all_completed` once `expected_count` completions ran.
+   */
+  std::shared_ptr<GrpcCompletion> CreateCompletion(
+      const std::shared_ptr<AsyncQueue>& queue,
+      int index,
+      std::vector<int>* record) {
+    return GrpcCompletion::Create(
+        Type::Read, queue,
+        [=](bool ok, const std::shared_ptr<GrpcCompletion>&) {
+          queue->VerifyIsCurrentQueue();
+          EXPECT_TRUE(ok);
+          record->push_back(index);
+          if (++completed_count == expected_count) {
+            all_completed.Fulfill();
+          }
+        });
+  }
+
+  std::shared_ptr<AsyncQueue> worker_queue;
+  std::shared_ptr<AsyncQueue> other_queue;
+
+  std::atomic<int> completed_count{0};
+  int expected_count = 0;
+  Expectation all_completed;
+};
+
+TEST_F(GrpcCompletionPollerTest, DeliversCompletionsToWorkerQueue) {
+  GrpcCompletionPoller poller(2);
+  poller.Start();
+
+  std::vector<int> completed;
+  expected_count = 3;
+  std::vector<std::unique_ptr<grpc::Alarm>> alarms;
+  for (int i = 0; i != expected_count; ++i) {
+    auto completion = CreateCompletion(worker_queue, i, &completed);
+    alarms.push_back(absl::make_unique<grpc::Alarm>());
+    alarms.back()->Set(poller.queue(), std::chrono::system_clock::now(),
+                       completion.get());
+  }
+
+  Await(all_completed);
+  worker_queue->EnqueueBlocking([&] { EXPECT_EQ(completed.size(), 3u); });
+  poller.Shutdown();
+}
+
+TEST_F(GrpcCompletionPollerTest, GroupsCompletionsByWorkerQueueInOrder) {
+  std::vector<int> on_worker_queue;
+  std::vector<int> on_other_queue;
+  expected_count = 4;
+  auto first = CreateCompletion(worker_queue, 0, &on_worker_queue);
+  auto second = CreateCompletion(other_queue, 1, &on_other_queue);
+  auto third = CreateCompletion(worker_queue, 2, &on_worker_queue);
+  auto fourth = CreateCompletion(other_queue, 3, &on_other_queue);
+
+  GrpcCompletion::Complete({{first.get(), true},
+                            {second.get(), true},
+                            {third.get(), true},
+                            {fourth.get(), true}});
+
+  Await(all_completed);
+  worker_queue->EnqueueBlocking(
+      [&] { EXPECT_EQ(on_worker_queue, (std::vector<int>{0, 2})); });
+  other_queue->EnqueueBlocking(
+      [&] { EXPECT_EQ(on_other_queue, (std::vector<int>{1, 3})); });
+}
+
+TEST_F(GrpcCompletionPollerTest, CanShutDownMoreThanOnce) {
+  GrpcCompletionPoller poller;
+  poller.Start();
+  poller.Start();
+  poller.Shutdown();
+  poller.Shutdown();
+}
+
+TEST_F(GrpcCompletionPollerTest, SharesPollerWhileInUse) {
+  auto shared = GrpcCompletionPoller::GetShared(2);
+  EXPECT_EQ(shared->thread_count(), 2u);
+  EXPECT_EQ(GrpcCompletionPoller::GetShared(4), shared);
+
+  // Once released, the next caller gets a new poller.
+  shared.reset();
+  EXPECT_EQ(GrpcCompletionPoller::GetShared(4)->thread_count(), 4u);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -186,6 +186,57 @@ TEST_F(GrpcConnectionTest, ConnectivityChangeWithSeveralActiveCalls) {
   EXPECT_EQ(changes_count, 3);
 }
 
+TEST_F(GrpcConnectionTest, SharesChannelBetweenConnectionsToSameHost) {
+  auto other_monitor = absl::make_unique<FakeConnectivityMonitor>(worker_queue);
+  GrpcStreamTester other_tester{worker_queue, other_monitor.get()};
+
+  std::unique_ptr<GrpcUnaryCall> foo = tester.CreateUnaryCall();
+  std::unique_ptr<GrpcUnaryCall> bar = other_tester.CreateUnaryCall();
+
+  ASSERT_NE(tester.grpc_connection()->grpc_channel(), nullptr);
+  EXPECT_EQ(tester.grpc_connection()->grpc_channel(),
+            other_tester.grpc_connection()->grpc_channel());
+}
+
+TEST_F(GrpcConnectionTest, ConnectCreatesTheChannelAheadOfCalls) {
+  tester.grpc_connection()->Connect();
+  auto channel = tester.grpc_connection()->grpc_channel();
+  ASSERT_NE(channel, nullptr);
+
+  std::unique_ptr<GrpcUnaryCall> foo = tester.CreateUnaryCall();
+  EXPECT_EQ(tester.grpc_connection()->grpc_channel(), channel);
+}
+
+TEST_F(GrpcConnectionTest, ConnectivityChangeStopsChannelSharing) {
+  auto other_monitor = absl::make_unique<FakeConnectivityMonitor>(worker_queue);
+  GrpcStreamTester other_tester{worker_queue, other_monitor.get()};
+
+  std::unique_ptr<GrpcUnaryCall> foo = tester.CreateUnaryCall();
+  std::unique_ptr<GrpcUnaryCall> bar = other_tester.CreateUnaryCall();
+  auto old_channel = other_tester.grpc_connection()->grpc_channel();
+  ASSERT_EQ(tester.grpc_connection()->grpc_channel(), old_channel);
+
+  // The other connection still uses the old channel, but it must not be handed
+  // out anymore.
+  SetNetworkStatus(NetworkStatus::Unavailable);
+  std::unique_ptr<GrpcUnaryCall> baz = tester.CreateUnaryCall();
+  EXPECT_NE(tester.grpc_connection()->grpc_channel(), old_channel);
+}
+
+TEST_F(GrpcConnectionTest, CompressesStreamsAndLargeStreamingReads) {
+  tester.grpc_connection()->EnableCompression(GRPC_COMPRESS_GZIP, 1);
+
+  ConnectivityObserver observer;
+  std::unique_ptr<GrpcStream> stream = tester.CreateStream(&observer);
+  EXPECT_EQ(stream->context()->compression_algorithm(), GRPC_COMPRESS_GZIP);
+
+  // The request of a streaming read is empty, so below the threshold.
+  std::unique_ptr<GrpcStreamingReader> streaming_call =
+      tester.CreateStreamingReader();
+  EXPECT_EQ(streaming_call->context()->compression_algorithm(),
+            GRPC_COMPRESS_NONE);
+}
+
 TEST_F(GrpcConnectionTest, ShutdownFastFinishesActiveCalls) {
   class NoFinishObserver : public GrpcStreamObserver {
    public:
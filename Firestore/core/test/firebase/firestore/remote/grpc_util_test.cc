@@ -0,0 +1,83 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_util.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <string>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+namespace chr = std::chrono;
+
+std::string Varint(uint64_t value) {
+  std::string result;
+  while (value >= 0x80) {
+    result.push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  result.push_back(static_cast<char>(value));
+  return result;
+}
+
+std::string VarintField(uint32_t tag, uint64_t value) {
+  return Varint(tag << 3) + Varint(value);
+}
+
+std::string BytesField(uint32_t tag, const std::string& value) {
+  return Varint((tag << 3) | 2) + Varint(value.size()) + value;
+}
+
+// Encodes a `google.rpc.Status` with a single detail.
+std::string StatusDetails(const std::string& type_url,
+                          const std::string& value) {
+  std::string any = BytesField(1, type_url) + BytesField(2, value);
+  return VarintField(1, grpc::RESOURCE_EXHAUSTED) + BytesField(3, any);
+}
+
+std::string RetryInfo(int64_t seconds, int32_t nanos) {
+  std::string duration = VarintField(1, seconds) + VarintField(2, nanos);
+  return BytesField(1, duration);
+}
+
+const char* const kRetryInfoTypeUrl =
+    "type.googleapis.com/google.rpc.RetryInfo";
+
+}  // namespace
+
+TEST(GrpcUtilTest, ReadsTheRetryDelay) {
+  grpc::Status status{grpc::RESOURCE_EXHAUSTED, "",
+                      StatusDetails(kRetryInfoTypeUrl, RetryInfo(2, 5000000))};
+  EXPECT_EQ(GetRetryDelay(status), chr::milliseconds(2005));
+}
+
+TEST(GrpcUtilTest, IgnoresOtherDetails) {
+  EXPECT_FALSE(GetRetryDelay(grpc::Status{grpc::RESOURCE_EXHAUSTED, ""}));
+  EXPECT_FALSE(GetRetryDelay(grpc::Status{
+      grpc::RESOURCE_EXHAUSTED, "",
+      StatusDetails("type.googleapis.com/google.rpc.DebugInfo",
+                    RetryInfo(2, 0))}));
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
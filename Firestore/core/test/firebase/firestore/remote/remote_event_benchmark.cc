@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
+#include "Firestore/core/test/firebase/firestore/remote/fake_target_metadata_provider.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using model::Document;
+using model::TargetId;
+
+using testutil::Doc;
+using testutil::Map;
+using testutil::Resource;
+using testutil::Version;
+
+/**
+ * Returns changes adding `count` documents to target 1, with every fourth
+ * document also added to target 2.
+ */
+std::vector<DocumentWatchChange> BenchmarkChanges(int count) {
+  std::vector<DocumentWatchChange> changes;
+  changes.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    Document doc = Doc(absl::StrCat("coll/doc", i), 1, Map("index", i));
+    std::vector<TargetId> target_ids{1};
+    if (i % 4 == 0) {
+      target_ids.push_back(2);
+    }
+    changes.emplace_back(std::move(target_ids), std::vector<TargetId>{},
+                         doc.key(), doc);
+  }
+  return changes;
+}
+
+/** Aggregates the document changes of a large initial query result. */
+void BM_AggregateDocumentChanges(benchmark::State& state) {
+  auto size = static_cast<int>(state.range(0));
+  FakeTargetMetadataProvider metadata_provider =
+      FakeTargetMetadataProvider::CreateEmptyResultProvider(Resource("coll"),
+                                                            {1, 2});
+  std::vector<DocumentWatchChange> changes = BenchmarkChanges(size);
+
+  for (auto _ : state) {
+    WatchChangeAggregator aggregator{&metadata_provider};
+    for (const DocumentWatchChange& change : changes) {
+      aggregator.HandleDocumentChange(change);
+    }
+    RemoteEvent event = aggregator.CreateRemoteEvent(Version(2));
+    benchmark::DoNotOptimize(event);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_AggregateDocumentChanges)->Range(1000, 100000);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -23,6 +23,7 @@
 #include "Firestore/core/src/firebase/firestore/model/document_key.h"
 #include "Firestore/core/src/firebase/firestore/model/no_document.h"
 #include "Firestore/core/src/firebase/firestore/model/types.h"
+#include "Firestore/core/src/firebase/firestore/remote/bloom_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/existence_filter.h"
 #include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
 #include "Firestore/core/src/firebase/firestore/remote/watch_change.h"
@@ -74,6 +75,15 @@ std::unique_ptr<DocumentWatchChange> MakeDocChange(
       std::move(updated), std::move(removed), std::move(key), doc);
 }
 
+/**
+ * Returns a bloom filter of unchanged document names, as the backend would
+ * encode it for a target that still contains "coll/a" and "coll/b".
+ */
+BloomFilter UnchangedNames() {
+  std::vector<uint8_t> bitmap{0x20, 0x40, 0x00, 0x00, 0x60, 0x02, 0x00, 0x10};
+  return BloomFilter::Create(bitmap, 3, 3).ValueOrDie();
+}
+
 std::unique_ptr<WatchTargetChange> MakeTargetChange(
     WatchTargetChangeState state, std::vector<TargetId> target_ids) {
   return absl::make_unique<WatchTargetChange>(state, std::move(target_ids));
@@ -598,6 +608,56 @@ TEST_F(RemoteEventTest, ExistenceFilterMismatchRemovesCurrentChanges) {
   ASSERT_TRUE(event.target_changes().at(1) == target_change1);
 }
 
+TEST_F(RemoteEventTest, ExistenceFilterBloomFilterRemovesDocuments) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+
+  WatchChangeAggregator aggregator =
+      CreateAggregator(target_map, no_outstanding_responses_,
+                       DocumentKeySet{Key("coll/a"), Key("coll/b"),
+                                      Key("coll/c")},
+                       {});
+
+  // The filter contains "coll/a" and "coll/b", which accounts for the
+  // mismatch without resetting the target.
+  ExistenceFilterWatchChange existence_filter{
+      ExistenceFilter{2, UnchangedNames()}, 1};
+  aggregator.HandleExistenceFilter(existence_filter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  ASSERT_EQ(event.target_mismatches().size(), 0);
+  ASSERT_EQ(event.document_updates().size(), 0);
+
+  ASSERT_EQ(event.target_changes().size(), 1);
+  TargetChange target_change{resume_token1_, false, DocumentKeySet{},
+                             DocumentKeySet{},
+                             DocumentKeySet{Key("coll/c")}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change);
+}
+
+TEST_F(RemoteEventTest, ExistenceFilterBloomFilterFallsBackToReset) {
+  std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
+
+  WatchChangeAggregator aggregator =
+      CreateAggregator(target_map, no_outstanding_responses_,
+                       DocumentKeySet{Key("coll/a"), Key("coll/b"),
+                                      Key("coll/c")},
+                       {});
+
+  // Removing "coll/c" still leaves more documents than the backend counted.
+  ExistenceFilterWatchChange existence_filter{
+      ExistenceFilter{1, UnchangedNames()}, 1};
+  aggregator.HandleExistenceFilter(existence_filter);
+
+  RemoteEvent event = aggregator.CreateRemoteEvent(testutil::Version(3));
+
+  ASSERT_EQ(event.target_mismatches().size(), 1);
+  TargetChange target_change{
+      ByteString(), false, DocumentKeySet{}, DocumentKeySet{},
+      DocumentKeySet{Key("coll/a"), Key("coll/b"), Key("coll/c")}};
+  ASSERT_TRUE(event.target_changes().at(1) == target_change);
+}
+
 TEST_F(RemoteEventTest, DocumentUpdate) {
   std::unordered_map<TargetId, TargetData> target_map = ActiveQueries({1});
 
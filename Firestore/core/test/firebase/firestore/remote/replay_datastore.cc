@@ -0,0 +1,165 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/test/firebase/firestore/remote/replay_datastore.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "Firestore/core/src/firebase/firestore/remote/grpc_completion.h"
+#include "Firestore/core/src/firebase/firestore/remote/grpc_stream.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/hard_assert.h"
+#include "Firestore/core/test/firebase/firestore/util/create_noop_connectivity_monitor.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using auth::CredentialsProvider;
+using auth::Token;
+using util::AsyncQueue;
+using util::CreateNoOpConnectivityMonitor;
+using util::GrpcStreamTester;
+using util::MakeByteBuffer;
+
+class ReplayWatchStream : public WatchStream {
+ public:
+  ReplayWatchStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                    std::shared_ptr<CredentialsProvider> credentials_provider,
+                    Serializer serializer,
+                    GrpcStreamTester* tester,
+                    grpc::ClientContext** context,
+                    WatchStreamCallback* callback)
+      : WatchStream{worker_queue, std::move(credentials_provider),
+                    std::move(serializer), tester->grpc_connection(),
+                    callback},
+        tester_{tester},
+        context_{context} {
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection*,
+                                               const Token&) override {
+    auto result = tester_->CreateStream(this);
+    *context_ = result->context();
+    return result;
+  }
+
+  GrpcStreamTester* tester_ = nullptr;
+  grpc::ClientContext** context_ = nullptr;
+};
+
+class ReplayWriteStream : public WriteStream {
+ public:
+  ReplayWriteStream(const std::shared_ptr<AsyncQueue>& worker_queue,
+                    std::shared_ptr<CredentialsProvider> credentials_provider,
+                    Serializer serializer,
+                    GrpcStreamTester* tester,
+                    grpc::ClientContext** context,
+                    WriteStreamCallback* callback)
+      : WriteStream{worker_queue, std::move(credentials_provider),
+                    std::move(serializer), tester->grpc_connection(),
+                    callback},
+        tester_{tester},
+        context_{context} {
+  }
+
+ private:
+  std::unique_ptr<GrpcStream> CreateGrpcStream(GrpcConnection*,
+                                               const Token&) override {
+    auto result = tester_->CreateStream(this);
+    *context_ = result->context();
+    return result;
+  }
+
+  GrpcStreamTester* tester_ = nullptr;
+  grpc::ClientContext** context_ = nullptr;
+};
+
+}  // namespace
+
+ReplayDatastore::ReplayDatastore(
+    const core::DatabaseInfo& database_info,
+    const std::shared_ptr<AsyncQueue>& worker_queue,
+    std::shared_ptr<CredentialsProvider> credentials)
+    : Datastore{database_info, worker_queue, credentials,
+                CreateNoOpConnectivityMonitor()},
+      worker_queue_{worker_queue},
+      credentials_{std::move(credentials)},
+      connectivity_monitor_{CreateNoOpConnectivityMonitor()},
+      tester_{worker_queue, connectivity_monitor_.get()} {
+}
+
+std::shared_ptr<WatchStream> ReplayDatastore::CreateWatchStream(
+    WatchStreamCallback* callback) {
+  return std::make_shared<ReplayWatchStream>(
+      worker_queue_, credentials_, Serializer{database_id()}, &tester_,
+      &watch_context_, callback);
+}
+
+std::shared_ptr<WriteStream> ReplayDatastore::CreateWriteStream(
+    WriteStreamCallback* callback) {
+  return std::make_shared<ReplayWriteStream>(
+      worker_queue_, credentials_, Serializer{database_id()}, &tester_,
+      &write_context_, callback);
+}
+
+void ReplayDatastore::Replay(const std::vector<RecordedFrame>& frames,
+                             RecordedStream stream,
+                             ReplaySpeed speed) {
+  std::vector<const RecordedFrame*> replayed;
+  for (const RecordedFrame& frame : frames) {
+    if (frame.stream == stream) {
+      replayed.push_back(&frame);
+    }
+  }
+  if (replayed.empty()) return;
+
+  // Let the stream finish starting, which creates its gRPC stream.
+  worker_queue_->EnqueueBlocking([] {});
+  grpc::ClientContext* context =
+      stream == RecordedStream::Watch ? watch_context_ : write_context_;
+  HARD_ASSERT(context, "The stream must be started before it's replayed");
+
+  size_t next = 0;
+  auto start = std::chrono::steady_clock::now();
+  std::chrono::microseconds first_time = replayed.front()->time;
+  tester_.ForceFinish(context, [&](GrpcCompletion* completion) {
+    if (completion->type() != GrpcCompletion::Type::Read) {
+      completion->Complete(true);
+      return false;
+    }
+
+    const RecordedFrame& frame = *replayed[next++];
+    if (speed == ReplaySpeed::Recorded) {
+      std::this_thread::sleep_until(start + (frame.time - first_time));
+    }
+    *completion->message() = MakeByteBuffer(frame.message);
+    completion->Complete(true);
+    return next == replayed.size();
+  });
+}
+
+void ReplayDatastore::FinishReplay() {
+  tester_.KeepPollingGrpcQueue();
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
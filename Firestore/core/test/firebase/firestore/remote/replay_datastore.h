@@ -0,0 +1,102 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_REPLAY_DATASTORE_H_
+#define FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_REPLAY_DATASTORE_H_
+
+#include <memory>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/auth/credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/remote/connectivity_monitor.h"
+#include "Firestore/core/src/firebase/firestore/remote/datastore.h"
+#include "Firestore/core/src/firebase/firestore/remote/stream_recorder.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/test/firebase/firestore/util/grpc_stream_tester.h"
+#include "grpcpp/client_context.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+enum class ReplaySpeed {
+  /** Feeds responses with the same delays between them as when recorded. */
+  Recorded,
+
+  /**
+   * Feeds each response as soon as the stream reads the previous one, to
+   * measure the throughput of everything that processes responses.
+   */
+  Maximum,
+};
+
+/**
+ * A `Datastore` whose watch and write streams receive responses recorded by
+ * `StreamRecorder` instead of responses from the backend. The streams are the
+ * real `WatchStream` and `WriteStream`, running on a fake gRPC connection
+ * provided by `GrpcStreamTester`, so replayed responses go through the same
+ * decoding and `RemoteStore` processing as live ones.
+ *
+ * Requests the streams send are acknowledged and dropped, so the code that
+ * drives the streams (e.g. `RemoteStore::Listen`) must use the same target IDs
+ * as the recorded client.
+ */
+class ReplayDatastore : public Datastore {
+ public:
+  ReplayDatastore(const core::DatabaseInfo& database_info,
+                  const std::shared_ptr<util::AsyncQueue>& worker_queue,
+                  std::shared_ptr<auth::CredentialsProvider> credentials);
+
+  std::shared_ptr<WatchStream> CreateWatchStream(
+      WatchStreamCallback* callback) override;
+  std::shared_ptr<WriteStream> CreateWriteStream(
+      WriteStreamCallback* callback) override;
+
+  /**
+   * Feeds the frames of `frames` that were recorded on `stream` to the stream
+   * of that kind, and blocks until it has read all of them. The stream must
+   * have been started, and the other kind of stream must not be started in
+   * the meantime.
+   *
+   * The stream decodes watch responses off the worker queue, so the last ones
+   * may still be in progress when this returns.
+   */
+  void Replay(const std::vector<RecordedFrame>& frames,
+              RecordedStream stream,
+              ReplaySpeed speed);
+
+  /**
+   * Completes all further operations of the streams, so that they can be
+   * stopped. Must be called on the worker queue, just before the streams are
+   * stopped (e.g. by `RemoteStore::Shutdown`).
+   */
+  void FinishReplay();
+
+ private:
+  std::shared_ptr<util::AsyncQueue> worker_queue_;
+  std::shared_ptr<auth::CredentialsProvider> credentials_;
+  std::unique_ptr<ConnectivityMonitor> connectivity_monitor_;
+  util::GrpcStreamTester tester_;
+  grpc::ClientContext* watch_context_ = nullptr;
+  grpc::ClientContext* write_context_ = nullptr;
+};
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
+
+#endif  // FIRESTORE_CORE_TEST_FIREBASE_FIRESTORE_REMOTE_REPLAY_DATASTORE_H_
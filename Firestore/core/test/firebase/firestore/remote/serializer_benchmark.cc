@@ -0,0 +1,260 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/Protos/nanopb/firestore/local/maybe_document.nanopb.h"
+#include "Firestore/Protos/nanopb/google/firestore/v1/document.nanopb.h"
+#include "Firestore/core/src/firebase/firestore/local/local_serializer.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/model/document.h"
+#include "Firestore/core/src/firebase/firestore/model/field_value.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/byte_string.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/message.h"
+#include "Firestore/core/src/firebase/firestore/nanopb/reader.h"
+#include "Firestore/core/src/firebase/firestore/remote/serializer.h"
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/src/firebase/firestore/util/statusor.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace {
+
+// Counts every allocation made through the global operator new, so that the
+// benchmarks can report allocations per document.
+std::atomic<int64_t> allocation_count{0};
+
+}  // namespace
+
+void* operator new(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  void* result = std::malloc(size == 0 ? 1 : size);
+  if (!result) throw std::bad_alloc();
+  return result;
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using local::LocalSerializer;
+using model::DatabaseId;
+using model::Document;
+using model::FieldValue;
+using model::MaybeDocument;
+using nanopb::ByteString;
+using nanopb::MakeByteString;
+using nanopb::Message;
+using nanopb::StringReader;
+using util::DirectoryIterator;
+using util::Filesystem;
+using util::Path;
+using util::StatusOr;
+
+#ifndef FIRESTORE_SERIALIZER_CORPUS_DIR
+#define FIRESTORE_SERIALIZER_CORPUS_DIR ""
+#endif
+
+/**
+ * Reports the throughput of a benchmark that processed `bytes_per_iteration`
+ * bytes in `documents_per_iteration` documents per iteration, and the number
+ * of allocations per document since `allocations_before`.
+ */
+void ReportThroughput(benchmark::State& state,
+                      int64_t allocations_before,
+                      int64_t bytes_per_iteration,
+                      int64_t documents_per_iteration) {
+  int64_t allocations = allocation_count.load() - allocations_before;
+  int64_t documents = state.iterations() * documents_per_iteration;
+
+  state.SetBytesProcessed(state.iterations() * bytes_per_iteration);
+  state.SetItemsProcessed(documents);
+  state.counters["allocs_per_doc"] =
+      documents == 0 ? 0 : static_cast<double>(allocations) / documents;
+}
+
+/**
+ * Reads the binary `Value` protos of the serializer fuzzing corpus, skipping
+ * any that don't decode.
+ */
+std::vector<std::string> LoadCorpus(const Serializer& serializer) {
+  std::vector<std::string> result;
+
+  Path dir = Path::FromUtf8(FIRESTORE_SERIALIZER_CORPUS_DIR);
+  auto iter = DirectoryIterator::Create(dir);
+  for (; iter->Valid(); iter->Next()) {
+    StatusOr<std::string> contents =
+        Filesystem::Default()->ReadFile(iter->file());
+    if (!contents.ok()) continue;
+
+    StringReader reader{contents.ValueOrDie()};
+    auto message = Message<google_firestore_v1_Value>::TryParse(&reader);
+    serializer.DecodeFieldValue(&reader, *message);
+    if (reader.ok()) {
+      result.push_back(std::move(contents).ValueOrDie());
+    }
+  }
+  return result;
+}
+
+void BM_DecodeCorpus(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  std::vector<std::string> corpus = LoadCorpus(serializer);
+  if (corpus.empty()) {
+    state.SkipWithError("The serializer fuzzing corpus is missing");
+    return;
+  }
+
+  int64_t bytes = 0;
+  for (const std::string& proto : corpus) {
+    bytes += static_cast<int64_t>(proto.size());
+  }
+
+  int64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    for (const std::string& proto : corpus) {
+      StringReader reader{proto};
+      auto message = Message<google_firestore_v1_Value>::TryParse(&reader);
+      benchmark::DoNotOptimize(serializer.DecodeFieldValue(&reader, *message));
+    }
+  }
+  ReportThroughput(state, allocations_before, bytes,
+                   static_cast<int64_t>(corpus.size()));
+}
+BENCHMARK(BM_DecodeCorpus);
+
+void BM_EncodeCorpus(benchmark::State& state) {
+  Serializer serializer{DatabaseId{"p", "d"}};
+  std::vector<std::string> corpus = LoadCorpus(serializer);
+  if (corpus.empty()) {
+    state.SkipWithError("The serializer fuzzing corpus is missing");
+    return;
+  }
+
+  std::vector<FieldValue> values;
+  int64_t bytes = 0;
+  for (const std::string& proto : corpus) {
+    StringReader reader{proto};
+    auto message = Message<google_firestore_v1_Value>::TryParse(&reader);
+    values.push_back(serializer.DecodeFieldValue(&reader, *message));
+    bytes += static_cast<int64_t>(proto.size());
+  }
+
+  int64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    for (const FieldValue& value : values) {
+      Message<google_firestore_v1_Value> message;
+      *message = serializer.EncodeFieldValue(value);
+      benchmark::DoNotOptimize(MakeByteString(message));
+    }
+  }
+  ReportThroughput(state, allocations_before, bytes,
+                   static_cast<int64_t>(values.size()));
+}
+BENCHMARK(BM_EncodeCorpus);
+
+/** A document whose data is `depth` maps, each nested in the previous one. */
+Document DeepMapDocument(int64_t depth) {
+  FieldValue value = FieldValue::FromString("leaf");
+  for (int64_t i = 0; i < depth; ++i) {
+    value = FieldValue::FromMap({{"depth", FieldValue::FromInteger(i)},
+                                 {"nested", value}});
+  }
+  return testutil::Doc("coll/deep", 1, value);
+}
+
+/** A document with a single array of `size` doubles. */
+Document BigArrayDocument(int64_t size) {
+  std::vector<FieldValue> array;
+  array.reserve(static_cast<size_t>(size));
+  for (int64_t i = 0; i < size; ++i) {
+    array.push_back(FieldValue::FromDouble(static_cast<double>(i) / 3));
+  }
+  return testutil::Doc("coll/array", 1,
+                       FieldValue::Map{}.insert(
+                           "array", FieldValue::FromArray(std::move(array))));
+}
+
+/** A document with `count` fields holding short strings. */
+Document SmallStringsDocument(int64_t count) {
+  FieldValue::Map map;
+  for (int64_t i = 0; i < count; ++i) {
+    map = map.insert(absl::StrCat("field", i),
+                     FieldValue::FromString(absl::StrCat("value", i)));
+  }
+  return testutil::Doc("coll/strings", 1, map);
+}
+
+using DocumentGenerator = Document (*)(int64_t);
+
+void EncodeDocument(benchmark::State& state, DocumentGenerator generate) {
+  LocalSerializer serializer{Serializer{DatabaseId{"p", "d"}}};
+  Document doc = generate(state.range(0));
+  auto bytes = static_cast<int64_t>(
+      MakeByteString(serializer.EncodeMaybeDocument(doc)).size());
+
+  int64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        MakeByteString(serializer.EncodeMaybeDocument(doc)));
+  }
+  ReportThroughput(state, allocations_before, bytes, 1);
+}
+
+void DecodeDocument(benchmark::State& state, DocumentGenerator generate) {
+  LocalSerializer serializer{Serializer{DatabaseId{"p", "d"}}};
+  ByteString encoded =
+      MakeByteString(serializer.EncodeMaybeDocument(generate(state.range(0))));
+
+  int64_t allocations_before = allocation_count.load();
+  for (auto _ : state) {
+    StringReader reader{encoded};
+    auto message = Message<firestore_client_MaybeDocument>::TryParse(&reader);
+    MaybeDocument doc = serializer.DecodeMaybeDocument(&reader, *message);
+    benchmark::DoNotOptimize(doc);
+  }
+  ReportThroughput(state, allocations_before,
+                   static_cast<int64_t>(encoded.size()), 1);
+}
+
+BENCHMARK_CAPTURE(EncodeDocument, DeepMap, DeepMapDocument)->Range(8, 64);
+BENCHMARK_CAPTURE(DecodeDocument, DeepMap, DeepMapDocument)->Range(8, 64);
+BENCHMARK_CAPTURE(EncodeDocument, BigArray, BigArrayDocument)
+    ->Range(64, 16384);
+BENCHMARK_CAPTURE(DecodeDocument, BigArray, BigArrayDocument)
+    ->Range(64, 16384);
+BENCHMARK_CAPTURE(EncodeDocument, SmallStrings, SmallStringsDocument)
+    ->Range(64, 4096);
+BENCHMARK_CAPTURE(DecodeDocument, SmallStrings, SmallStringsDocument)
+    ->Range(64, 4096);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -41,6 +41,7 @@
 #include "Firestore/core/src/firebase/firestore/core/bound.h"
 #include "Firestore/core/src/firebase/firestore/core/field_filter.h"
 #include "Firestore/core/src/firebase/firestore/core/query.h"
+#include "Firestore/core/src/firebase/firestore/core/target.h"
 #include "Firestore/core/src/firebase/firestore/local/target_data.h"
 #include "Firestore/core/src/firebase/firestore/model/delete_mutation.h"
 #include "Firestore/core/src/firebase/firestore/model/document.h"
@@ -62,6 +63,7 @@
 #include "Firestore/core/test/firebase/firestore/nanopb/nanopb_testing.h"
 #include "Firestore/core/test/firebase/firestore/testutil/status_testing.h"
 #include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/optional.h"
 #include "google/protobuf/stubs/common.h"
@@ -840,6 +842,21 @@ TEST_F(SerializerTest, EncodesNestedObjects) {
   ExpectRoundTrip(model, proto, FieldValue::Type::Object);
 }
 
+TEST_F(SerializerTest, EncodesLargeObjects) {
+  // Enough fields that the decoded map can't use the array representation.
+  FieldValue::Map map;
+  v1::Value proto;
+  google::protobuf::Map<std::string, v1::Value>* fields =
+      proto.mutable_map_value()->mutable_fields();
+  for (int64_t i = 0; i < 100; ++i) {
+    std::string key = absl::StrCat("field", i);
+    map = map.insert(key, FieldValue::FromInteger(i));
+    (*fields)[key] = ValueProto(i);
+  }
+
+  ExpectRoundTrip(FieldValue::FromMap(map), proto, FieldValue::Type::Object);
+}
+
 TEST_F(SerializerTest, EncodesFieldValuesWithRepeatedEntries) {
   // Technically, serialized Value protos can contain multiple values. (The last
   // one "wins".) However, well-behaved proto emitters (such as libprotobuf)
@@ -1199,6 +1216,19 @@ TEST_F(SerializerTest, EncodesFirstLevelKeyQueries) {
   ExpectRoundTrip(model, proto);
 }
 
+TEST_F(SerializerTest, EncodesMultiDocumentTargets) {
+  TargetData model(core::Target::ForDocuments({Key("docs/1"), Key("docs/2")}),
+                   1, 0, QueryPurpose::Listen);
+
+  v1::Target proto;
+  proto.mutable_documents()->add_documents(ResourceName("docs/1"));
+  proto.mutable_documents()->add_documents(ResourceName("docs/2"));
+  proto.set_target_id(1);
+
+  SCOPED_TRACE("EncodesMultiDocumentTargets");
+  ExpectRoundTrip(model, proto);
+}
+
 TEST_F(SerializerTest, EncodesFirstLevelAncestorQueries) {
   TargetData model = CreateTargetData("messages");
 
@@ -1505,6 +1535,36 @@ TEST_F(SerializerTest, EncodesResumeTokens) {
   ExpectRoundTrip(model, proto);
 }
 
+TEST_F(SerializerTest, EncodesExpectedCountWithResumeTokens) {
+  core::Query q = Query("docs");
+  TargetData model =
+      TargetData(q.ToTarget(), 1, 0, QueryPurpose::Listen,
+                 SnapshotVersion::None(), SnapshotVersion::None(),
+                 Bytes({1, 2, 3}))
+          .WithExpectedCount(42);
+
+  v1::Target proto;
+  proto.mutable_query()->set_parent(ResourceName(""));
+  proto.set_target_id(1);
+
+  v1::StructuredQuery::CollectionSelector from;
+  from.set_collection_id("docs");
+  *proto.mutable_query()->mutable_structured_query()->add_from() =
+      std::move(from);
+
+  v1::StructuredQuery::Order order;
+  order.mutable_field()->set_field_path(FieldPath::kDocumentKeyPath);
+  order.set_direction(v1::StructuredQuery::ASCENDING);
+  *proto.mutable_query()->mutable_structured_query()->add_order_by() =
+      std::move(order);
+
+  proto.set_resume_token("\001\002\003");
+  proto.mutable_expected_count()->set_value(42);
+
+  SCOPED_TRACE("EncodesExpectedCountWithResumeTokens");
+  ExpectRoundTrip(model, proto);
+}
+
 TEST_F(SerializerTest, EncodesListenRequestLabels) {
   core::Query q = Query("docs");
 
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/remote/stream_recorder.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/filesystem.h"
+#include "Firestore/core/src/firebase/firestore/util/path.h"
+#include "Firestore/core/test/firebase/firestore/testutil/filesystem_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/status_testing.h"
+#include "Firestore/core/test/firebase/firestore/util/grpc_stream_tester.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+using testutil::TestTempDir;
+using util::Filesystem;
+using util::MakeByteBuffer;
+using util::Path;
+
+std::vector<RecordedFrame> ReadOrDie(const Path& path) {
+  auto frames = ReadStreamRecording(path);
+  EXPECT_OK(frames.status());
+  return std::move(frames).ValueOrDie();
+}
+
+TEST(StreamRecorderTest, RoundTripsFrames) {
+  TestTempDir dir;
+  Path path = dir.Child("recording");
+
+  {
+    auto recorder = StreamRecorder::Create(path);
+    ASSERT_OK(recorder.status());
+    recorder.ValueOrDie()->Record(RecordedStream::Watch,
+                                  MakeByteBuffer("listen"));
+    recorder.ValueOrDie()->Record(RecordedStream::Write,
+                                  MakeByteBuffer(std::string("a\0b", 3)));
+    recorder.ValueOrDie()->Record(RecordedStream::Watch, MakeByteBuffer(""));
+  }
+
+  std::vector<RecordedFrame> frames = ReadOrDie(path);
+  ASSERT_EQ(3u, frames.size());
+  EXPECT_EQ(RecordedStream::Watch, frames[0].stream);
+  EXPECT_EQ("listen", frames[0].message);
+  EXPECT_EQ(RecordedStream::Write, frames[1].stream);
+  EXPECT_EQ(std::string("a\0b", 3), frames[1].message);
+  EXPECT_EQ(RecordedStream::Watch, frames[2].stream);
+  EXPECT_EQ("", frames[2].message);
+  EXPECT_LE(frames[0].time, frames[1].time);
+  EXPECT_LE(frames[1].time, frames[2].time);
+}
+
+TEST(StreamRecorderTest, DropsPartialLastFrame) {
+  TestTempDir dir;
+  Path path = dir.Child("recording");
+
+  {
+    auto recorder = StreamRecorder::Create(path);
+    ASSERT_OK(recorder.status());
+    recorder.ValueOrDie()->Record(RecordedStream::Watch, MakeByteBuffer("a"));
+    recorder.ValueOrDie()->Record(RecordedStream::Watch,
+                                  MakeByteBuffer("truncated"));
+  }
+  std::string contents = Filesystem::Default()->ReadFile(path).ValueOrDie();
+  {
+    std::ofstream out(path.native_value(), std::ios::binary | std::ios::trunc);
+    out << contents.substr(0, contents.size() - 4);
+  }
+
+  std::vector<RecordedFrame> frames = ReadOrDie(path);
+  ASSERT_EQ(1u, frames.size());
+  EXPECT_EQ("a", frames[0].message);
+}
+
+TEST(StreamRecorderTest, RejectsOtherFiles) {
+  TestTempDir dir;
+  Path path = dir.Child("recording");
+  {
+    std::ofstream out(path.native_value(), std::ios::binary);
+    out << "not a recording";
+  }
+
+  EXPECT_EQ(Error::kDataLoss, ReadStreamRecording(path).status().code());
+}
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -0,0 +1,197 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Firestore/Protos/cpp/google/firestore/v1/firestore.pb.h"
+#include "Firestore/core/src/firebase/firestore/auth/empty_credentials_provider.h"
+#include "Firestore/core/src/firebase/firestore/auth/user.h"
+#include "Firestore/core/src/firebase/firestore/core/database_info.h"
+#include "Firestore/core/src/firebase/firestore/local/index_free_query_engine.h"
+#include "Firestore/core/src/firebase/firestore/local/local_store.h"
+#include "Firestore/core/src/firebase/firestore/local/memory_persistence.h"
+#include "Firestore/core/src/firebase/firestore/local/target_data.h"
+#include "Firestore/core/src/firebase/firestore/model/database_id.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_event.h"
+#include "Firestore/core/src/firebase/firestore/remote/remote_store.h"
+#include "Firestore/core/src/firebase/firestore/remote/stream_recorder.h"
+#include "Firestore/core/src/firebase/firestore/util/async_queue.h"
+#include "Firestore/core/src/firebase/firestore/util/status.h"
+#include "Firestore/core/test/firebase/firestore/remote/replay_datastore.h"
+#include "Firestore/core/test/firebase/firestore/testutil/async_testing.h"
+#include "Firestore/core/test/firebase/firestore/testutil/testutil.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+namespace {
+
+namespace v1 = google::firestore::v1;
+using auth::EmptyCredentialsProvider;
+using auth::User;
+using core::DatabaseInfo;
+using local::IndexFreeQueryEngine;
+using local::LocalStore;
+using local::MemoryPersistence;
+using local::TargetData;
+using model::BatchId;
+using model::DatabaseId;
+using model::DocumentKeySet;
+using model::MutationBatchResult;
+using model::OnlineState;
+using model::TargetId;
+using util::Status;
+
+RecordedFrame WatchFrame(const v1::ListenResponse& response) {
+  RecordedFrame frame;
+  frame.stream = RecordedStream::Watch;
+  frame.message = response.SerializeAsString();
+  return frame;
+}
+
+/**
+ * Returns the responses of an initial query result of `count` documents for
+ * `target_id`, one document per response.
+ */
+std::vector<RecordedFrame> InitialResultFrames(TargetId target_id, int count) {
+  std::vector<RecordedFrame> frames;
+
+  v1::ListenResponse added;
+  added.mutable_target_change()->set_target_change_type(
+      v1::TargetChange_TargetChangeType_ADD);
+  added.mutable_target_change()->add_target_ids(target_id);
+  frames.push_back(WatchFrame(added));
+
+  for (int i = 0; i < count; ++i) {
+    v1::ListenResponse response;
+    v1::DocumentChange* change = response.mutable_document_change();
+    change->mutable_document()->set_name(
+        absl::StrCat("projects/p/databases/d/documents/coll/doc", i));
+    change->mutable_document()->mutable_update_time()->set_seconds(1);
+    (*change->mutable_document()->mutable_fields())["index"].set_integer_value(
+        i);
+    change->add_target_ids(target_id);
+    frames.push_back(WatchFrame(response));
+  }
+
+  v1::ListenResponse current;
+  current.mutable_target_change()->set_target_change_type(
+      v1::TargetChange_TargetChangeType_CURRENT);
+  current.mutable_target_change()->add_target_ids(target_id);
+  current.mutable_target_change()->set_resume_token("resume");
+  frames.push_back(WatchFrame(current));
+
+  v1::ListenResponse global;
+  global.mutable_target_change()->mutable_read_time()->set_seconds(2);
+  frames.push_back(WatchFrame(global));
+
+  return frames;
+}
+
+/**
+ * Applies remote events to the local store, as the sync engine would, and
+ * signals once a remote event has been applied.
+ */
+class ApplyingSyncEngine : public RemoteStoreCallback {
+ public:
+  explicit ApplyingSyncEngine(LocalStore* local_store)
+      : local_store_{local_store} {
+  }
+
+  std::future<void> NextRemoteEvent() {
+    applied_ = std::promise<void>{};
+    return applied_.get_future();
+  }
+
+  void ApplyRemoteEvent(const RemoteEvent& remote_event) override {
+    local_store_->ApplyRemoteEvent(remote_event);
+    applied_.set_value();
+  }
+
+  void HandleRejectedListen(TargetId, Status) override {
+  }
+  void HandleSuccessfulWrite(const MutationBatchResult&) override {
+  }
+  void HandleRejectedWrite(BatchId, Status) override {
+  }
+  void HandleOnlineStateChange(OnlineState) override {
+  }
+  DocumentKeySet GetRemoteKeys(TargetId) const override {
+    return {};
+  }
+
+ private:
+  LocalStore* local_store_ = nullptr;
+  std::promise<void> applied_;
+};
+
+/**
+ * Replays the initial result of a large query through the watch stream, the
+ * remote store and the local store, as fast as they can take it.
+ */
+void BM_ReplayInitialQueryResult(benchmark::State& state) {
+  auto count = static_cast<int>(state.range(0));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto worker_queue = testutil::AsyncQueueForTesting();
+    auto persistence = MemoryPersistence::WithEagerGarbageCollector();
+    IndexFreeQueryEngine query_engine;
+    LocalStore local_store{persistence.get(), &query_engine,
+                           User::Unauthenticated()};
+    auto datastore = std::make_shared<ReplayDatastore>(
+        DatabaseInfo{DatabaseId{"p", "d"}, "", "", false}, worker_queue,
+        std::make_shared<EmptyCredentialsProvider>());
+    RemoteStore remote_store{&local_store, datastore, worker_queue,
+                             [](OnlineState) {}};
+    ApplyingSyncEngine sync_engine{&local_store};
+    remote_store.set_sync_engine(&sync_engine);
+
+    std::vector<RecordedFrame> frames;
+    worker_queue->EnqueueBlocking([&] {
+      local_store.Start();
+      remote_store.Start();
+      TargetData target_data =
+          local_store.AllocateTarget(testutil::Query("coll").ToTarget());
+      frames = InitialResultFrames(target_data.target_id(), count);
+      remote_store.Listen(target_data);
+    });
+    std::future<void> applied = sync_engine.NextRemoteEvent();
+    state.ResumeTiming();
+
+    datastore->Replay(frames, RecordedStream::Watch, ReplaySpeed::Maximum);
+    applied.wait();
+
+    state.PauseTiming();
+    worker_queue->EnqueueBlocking([&] {
+      datastore->FinishReplay();
+      remote_store.Shutdown();
+    });
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ReplayInitialQueryResult)->Range(1000, 10000);
+
+}  // namespace
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <chrono>  // NOLINT(build/c++11)
 #include <initializer_list>
 #include <memory>
 #include <string>
@@ -62,6 +63,9 @@ using Type = GrpcCompletion::Type;
 
 const auto kIdleTimerId = TimerId::ListenStreamIdle;
 const auto kBackoffTimerId = TimerId::ListenStreamConnectionBackoff;
+const BackoffProfile kBackoffProfile{1.5, std::chrono::seconds(1),
+                                     std::chrono::seconds(60),
+                                     BackoffJitter::Proportional};
 
 class TestStream : public Stream {
  public:
@@ -69,10 +73,14 @@ class TestStream : public Stream {
              GrpcStreamTester* tester,
              std::shared_ptr<CredentialsProvider> credentials_provider)
       : Stream{worker_queue, credentials_provider,
-               /*GrpcConnection=*/nullptr, kBackoffTimerId, kIdleTimerId},
+               /*GrpcConnection=*/nullptr, kBackoffTimerId, kBackoffProfile,
+               kIdleTimerId},
         tester_{tester} {
   }
 
+  using Stream::AsyncResponseHandler;
+  using Stream::MakeAsyncResponseHandler;
+
   void WriteEmptyBuffer() {
     Write({});
   }
@@ -317,6 +325,67 @@ TEST_F(StreamTest, ObserverReceivesStreamCloseOnError) {
   });
 }
 
+TEST_F(StreamTest, AsyncResponseRunsOnWorkerQueue) {
+  StartStream();
+
+  TestStream::AsyncResponseHandler handler;
+  worker_queue->EnqueueBlocking(
+      [&] { handler = firestore_stream->MakeAsyncResponseHandler(); });
+
+  bool notified = false;
+  handler([&] {
+    worker_queue->VerifyIsCurrentQueue();
+    notified = true;
+    return util::Status::OK();
+  });
+
+  worker_queue->EnqueueBlocking([&] {
+    EXPECT_TRUE(notified);
+    EXPECT_TRUE(firestore_stream->IsOpen());
+  });
+}
+
+TEST_F(StreamTest, AsyncResponseIsDroppedAfterClose) {
+  StartStream();
+
+  TestStream::AsyncResponseHandler handler;
+  worker_queue->EnqueueBlocking([&] {
+    handler = firestore_stream->MakeAsyncResponseHandler();
+    KeepPollingGrpcQueue();
+    firestore_stream->Stop();
+  });
+  StartStream();
+
+  bool notified = false;
+  handler([&] {
+    notified = true;
+    return util::Status::OK();
+  });
+
+  worker_queue->EnqueueBlocking([&] { EXPECT_FALSE(notified); });
+}
+
+TEST_F(StreamTest, AsyncResponseErrorClosesStream) {
+  StartStream();
+
+  TestStream::AsyncResponseHandler handler;
+  worker_queue->EnqueueBlocking(
+      [&] { handler = firestore_stream->MakeAsyncResponseHandler(); });
+
+  handler([&] {
+    // The stream will issue a finish operation and block until it's
+    // completed, so asynchronously polling gRPC queue is necessary.
+    KeepPollingGrpcQueue();
+    return util::Status{Error::kInternal, ""};
+  });
+
+  worker_queue->EnqueueBlocking([&] {
+    EXPECT_FALSE(firestore_stream->IsStarted());
+    EXPECT_EQ(observed_states(),
+              States({"NotifyStreamOpen", "NotifyStreamClose(Internal)"}));
+  });
+}
+
 // Write
 
 TEST_F(StreamTest, SeveralWrites) {
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/remote/write_request_tracker.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace chr = std::chrono;
+
+namespace firebase {
+namespace firestore {
+namespace remote {
+
+using Clock = WriteRequestTracker::Clock;
+
+TEST(WriteRequestTrackerTest, AcknowledgesRequestsInOrder) {
+  WriteRequestTracker tracker;
+  Clock::time_point now = Clock::now();
+
+  tracker.RecordRequest(3, now);
+  tracker.RecordRequest(1, now);
+  EXPECT_EQ(tracker.outstanding_requests(), 2u);
+  EXPECT_EQ(tracker.sent_batch_count(), 4u);
+  EXPECT_EQ(tracker.oldest_request_batch_count(), 3u);
+
+  EXPECT_EQ(tracker.RecordResponse(now), 3u);
+  EXPECT_EQ(tracker.sent_batch_count(), 1u);
+  EXPECT_EQ(tracker.oldest_request_batch_count(), 1u);
+
+  EXPECT_EQ(tracker.RecordResponse(now), 1u);
+  EXPECT_EQ(tracker.outstanding_requests(), 0u);
+  EXPECT_EQ(tracker.oldest_request_batch_count(), 0u);
+}
+
+TEST(WriteRequestTrackerTest, ClearKeepsRoundTripTime) {
+  WriteRequestTracker tracker;
+  Clock::time_point now = Clock::now();
+
+  tracker.RecordRequest(1, now);
+  tracker.RecordResponse(now + chr::milliseconds(400));
+  tracker.RecordRequest(2, now);
+  tracker.Clear();
+
+  EXPECT_EQ(tracker.outstanding_requests(), 0u);
+  EXPECT_EQ(tracker.sent_batch_count(), 0u);
+  EXPECT_EQ(tracker.smoothed_round_trip_time(), chr::milliseconds(400));
+}
+
+TEST(WriteRequestTrackerTest, SmoothsRoundTripTime) {
+  WriteRequestTracker tracker;
+  Clock::time_point now = Clock::now();
+
+  tracker.RecordRequest(1, now);
+  tracker.RecordResponse(now + chr::milliseconds(800));
+  EXPECT_EQ(tracker.smoothed_round_trip_time(), chr::milliseconds(800));
+
+  // Each new sample moves the estimate an eighth of the way.
+  tracker.RecordRequest(1, now);
+  tracker.RecordResponse(now);
+  EXPECT_EQ(tracker.smoothed_round_trip_time(), chr::milliseconds(700));
+}
+
+TEST(WriteRequestTrackerTest, PipelineDepthFollowsRoundTripTime) {
+  WriteRequestTracker tracker;
+  Clock::time_point now = Clock::now();
+  EXPECT_EQ(tracker.PipelineDepth(), WriteRequestTracker::kMinPipelineDepth);
+
+  tracker.RecordRequest(1, now);
+  tracker.RecordResponse(now + chr::milliseconds(1000));
+  EXPECT_EQ(tracker.PipelineDepth(), 40u);
+
+  WriteRequestTracker fast;
+  fast.RecordRequest(1, now);
+  fast.RecordResponse(now + chr::milliseconds(20));
+  EXPECT_EQ(fast.PipelineDepth(), WriteRequestTracker::kMinPipelineDepth);
+
+  WriteRequestTracker slow;
+  slow.RecordRequest(1, now);
+  slow.RecordResponse(now + chr::seconds(30));
+  EXPECT_EQ(slow.PipelineDepth(), WriteRequestTracker::kMaxPipelineDepth);
+}
+
+}  // namespace remote
+}  // namespace firestore
+}  // namespace firebase
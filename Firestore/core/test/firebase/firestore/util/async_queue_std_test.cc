@@ -17,6 +17,7 @@
 #include "Firestore/core/test/firebase/firestore/util/async_queue_test.h"
 
 #include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/src/firebase/firestore/util/serial_executor_std.h"
 
 #include "absl/memory/memory.h"
 #include "gtest/gtest.h"
@@ -31,11 +32,20 @@ std::unique_ptr<Executor> ExecutorFactory() {
   return absl::make_unique<ExecutorStd>(/*threads=*/1);
 }
 
+std::unique_ptr<Executor> SerialExecutorFactory() {
+  return absl::make_unique<SerialExecutorStd>();
+}
+
 }  // namespace
 
 INSTANTIATE_TEST_SUITE_P(AsyncQueueStd,
                          AsyncQueueTest,
                          ::testing::Values(ExecutorFactory));
+
+INSTANTIATE_TEST_SUITE_P(AsyncQueueSerialStd,
+                         AsyncQueueTest,
+                         ::testing::Values(SerialExecutorFactory));
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -67,6 +67,37 @@ TEST_P(AsyncQueueTest, EnqueueRelaxedWorksFromWithinEnqueue) {
   Await(ran);
 }
 
+TEST_P(AsyncQueueTest, RunsWaitingOperationsInOrderOfPriority) {
+  using Priority = AsyncQueue::Priority;
+
+  std::promise<void> unblock;
+  Expectation blocked;
+  Expectation ran;
+  std::string steps;
+
+  queue->Enqueue([&] {
+    blocked.Fulfill();
+    unblock.get_future().wait();
+  });
+  Await(blocked);
+
+  queue->Enqueue([&steps] { steps += '5'; }, Priority::Background);
+  queue->Enqueue([&steps] { steps += '3'; }, Priority::RemoteEvent);
+  queue->Enqueue([&steps] { steps += '1'; }, Priority::Interactive);
+  queue->Enqueue([&steps] { steps += '4'; }, Priority::RemoteEvent);
+  queue->Enqueue(
+      [&] {
+        steps += '6';
+        ran.Fulfill();
+      },
+      Priority::Background);
+  queue->Enqueue([&steps] { steps += '2'; });
+  unblock.set_value();
+
+  Await(ran);
+  EXPECT_EQ(steps, "123456");
+}
+
 TEST_P(AsyncQueueTest, EnqueueBlocking) {
   bool finished = false;
   queue->EnqueueBlocking([&] { finished = true; });
@@ -211,6 +242,32 @@ TEST_P(AsyncQueueTest, CanScheduleOprationsWithRespectsToShutdownState) {
   EXPECT_EQ(steps, "124");
 }
 
+TEST_P(AsyncQueueTest, RunsWaitingOperationsOfAllPrioritiesBeforeShutdown) {
+  using Priority = AsyncQueue::Priority;
+
+  std::promise<void> unblock;
+  Expectation blocked;
+  Expectation ran;
+  std::string steps;
+
+  queue->Enqueue([&] {
+    blocked.Fulfill();
+    unblock.get_future().wait();
+  });
+  Await(blocked);
+
+  queue->Enqueue([&steps] { steps += '3'; }, Priority::Background);
+  queue->Enqueue([&steps] { steps += '2'; }, Priority::RemoteEvent);
+  queue->Enqueue([&steps] { steps += '1'; });
+  queue->EnqueueAndInitiateShutdown([&steps] { steps += '4'; });
+  queue->Enqueue([&steps] { steps += 'X'; }, Priority::Background);
+  queue->EnqueueEvenAfterShutdown(ran.AsCallback());
+  unblock.set_value();
+
+  Await(ran);
+  EXPECT_EQ(steps, "1234");
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
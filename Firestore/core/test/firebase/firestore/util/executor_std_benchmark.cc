@@ -0,0 +1,97 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <future>  // NOLINT(build/c++11)
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/src/firebase/firestore/util/serial_executor_std.h"
+#include "benchmark/benchmark.h"
+
+using firebase::firestore::util::Executor;
+using firebase::firestore::util::ExecutorStd;
+using firebase::firestore::util::SerialExecutorStd;
+
+namespace {
+
+const int kOperationsPerProducer = 1000;
+
+/**
+ * Has `state.range(0)` threads enqueue operations on the given executor at the
+ * same time, the way user threads enqueue listens, writes and credential
+ * changes on the worker queue, and waits until all of them have run.
+ */
+void ExecuteFromManyThreads(benchmark::State& state, Executor* executor) {
+  const int producers = static_cast<int>(state.range(0));
+
+  for (auto _ : state) {
+    std::atomic<int> remaining{producers * kOperationsPerProducer};
+    std::promise<void> all_run;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p != producers; ++p) {
+      threads.emplace_back([&] {
+        for (int i = 0; i != kOperationsPerProducer; ++i) {
+          executor->Execute([&] {
+            if (--remaining == 0) {
+              all_run.set_value();
+            }
+          });
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    all_run.get_future().wait();
+  }
+
+  state.SetItemsProcessed(state.iterations() * producers *
+                          kOperationsPerProducer);
+}
+
+void BM_ExecutorStd_Execute(benchmark::State& state) {
+  ExecutorStd executor{/*threads=*/1};
+  ExecuteFromManyThreads(state, &executor);
+}
+BENCHMARK(BM_ExecutorStd_Execute)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+void BM_ExecutorStd_ExecuteConcurrent(benchmark::State& state) {
+  ExecutorStd executor{/*threads=*/8};
+  ExecuteFromManyThreads(state, &executor);
+}
+BENCHMARK(BM_ExecutorStd_ExecuteConcurrent)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+void BM_SerialExecutorStd_Execute(benchmark::State& state) {
+  SerialExecutorStd executor;
+  ExecuteFromManyThreads(state, &executor);
+}
+BENCHMARK(BM_SerialExecutorStd_Execute)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime();
+
+}  // namespace
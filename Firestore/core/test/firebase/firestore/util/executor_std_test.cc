@@ -109,6 +109,62 @@ TEST_F(ScheduleTest, RemoveIf) {
   EXPECT_TRUE(schedule.empty());
 }
 
+TEST_F(ScheduleTest, RemoveByHandle) {
+  ScheduleT::Handle first = schedule.Push(1, start_time);
+  ScheduleT::Handle second = schedule.Push(2, Now() + chr::minutes(1));
+  schedule.Push(3, start_time);
+
+  EXPECT_EQ(schedule.Remove(second).value(), 2);
+  EXPECT_EQ(schedule.Remove(first).value(), 1);
+  // Already removed.
+  EXPECT_FALSE(schedule.Remove(first).has_value());
+
+  // The slot of a removed entry is reused without reviving its old handle.
+  ScheduleT::Handle fourth = schedule.Push(4, start_time);
+  EXPECT_FALSE(schedule.Remove(first).has_value());
+  EXPECT_EQ(schedule.Remove(fourth).value(), 4);
+
+  EXPECT_EQ(schedule.PopIfDue().value(), 3);
+  EXPECT_TRUE(schedule.empty());
+}
+
+TEST_F(ScheduleTest, ContainsTag) {
+  EXPECT_FALSE(schedule.ContainsTag(1));
+
+  ScheduleT::Handle first = schedule.Push(1, start_time, /*tag=*/1);
+  schedule.Push(2, start_time, /*tag=*/1);
+  schedule.Push(3, start_time);
+  EXPECT_TRUE(schedule.ContainsTag(1));
+  EXPECT_FALSE(schedule.ContainsTag(2));
+
+  schedule.Remove(first);
+  EXPECT_TRUE(schedule.ContainsTag(1));
+  EXPECT_EQ(schedule.PopIfDue().value(), 2);
+  EXPECT_FALSE(schedule.ContainsTag(1));
+}
+
+TEST_F(ScheduleTest, OrderingAfterRemovals) {
+  std::vector<ScheduleT::Handle> handles;
+  for (int i = 0; i < 100; ++i) {
+    // Interleave due times so that removals happen all over the heap.
+    handles.push_back(
+        schedule.Push(i, start_time + chr::milliseconds((i * 37) % 100)));
+  }
+  for (int i = 0; i < 100; i += 3) {
+    schedule.Remove(handles[i]);
+  }
+
+  std::this_thread::sleep_for(chr::milliseconds(100));
+  std::vector<int> values;
+  while (!schedule.empty()) {
+    values.push_back(schedule.PopIfDue().value());
+  }
+  for (size_t i = 1; i < values.size(); ++i) {
+    EXPECT_LT((values[i - 1] * 37) % 100, (values[i] * 37) % 100);
+  }
+  EXPECT_EQ(values.size(), 66u);
+}
+
 TEST_F(ScheduleTest, Ordering) {
   schedule.Push(11, start_time + chr::milliseconds(5));
   schedule.Push(1, start_time);
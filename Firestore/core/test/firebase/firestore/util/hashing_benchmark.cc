@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/hashing.h"
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+/** Hashes a composite of small integers, like a version and a target ID. */
+struct IntPair {
+  int64_t first;
+  int64_t second;
+
+  size_t Hash() const {
+    return util::Hash(first, second);
+  }
+
+  friend bool operator==(const IntPair& lhs, const IntPair& rhs) {
+    return lhs.first == rhs.first && lhs.second == rhs.second;
+  }
+};
+
+struct IntPairHash {
+  size_t operator()(const IntPair& pair) const {
+    return pair.Hash();
+  }
+};
+
+/** Document paths of the form `coll/doc<i>/sub/doc<j>`, as segments. */
+std::vector<std::vector<std::string>> Paths(int64_t count) {
+  std::vector<std::vector<std::string>> paths;
+  for (int64_t i = 0; i < count; ++i) {
+    paths.push_back({"coll", absl::StrCat("doc", i / 10), "sub",
+                     absl::StrCat("doc", i % 10)});
+  }
+  return paths;
+}
+
+void BM_HashIntPair(benchmark::State& state) {
+  IntPair pair{12345, 67};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(pair.Hash());
+    pair.second++;
+  }
+}
+BENCHMARK(BM_HashIntPair);
+
+void BM_HashPath(benchmark::State& state) {
+  std::vector<std::vector<std::string>> paths = Paths(state.range(0));
+  for (auto _ : state) {
+    for (const std::vector<std::string>& path : paths) {
+      benchmark::DoNotOptimize(Hash(path));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_HashPath)->Range(100, 10000);
+
+/**
+ * Looks up grid points of small integers in an unordered set, which is where
+ * weak combining of hashes shows up as long bucket chains.
+ */
+void BM_FindIntPairInUnorderedSet(benchmark::State& state) {
+  int64_t side = state.range(0);
+  std::unordered_set<IntPair, IntPairHash> set;
+  for (int64_t i = 0; i < side; ++i) {
+    for (int64_t j = 0; j < side; ++j) {
+      set.insert(IntPair{i, j});
+    }
+  }
+
+  for (auto _ : state) {
+    for (int64_t i = 0; i < side; ++i) {
+      for (int64_t j = 0; j < side; ++j) {
+        benchmark::DoNotOptimize(set.find(IntPair{i, j}) != set.end());
+      }
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * side * side);
+}
+BENCHMARK(BM_FindIntPairInUnorderedSet)->Range(16, 256);
+
+}  // namespace
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -18,6 +18,8 @@
 
 #include <map>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 #include "absl/strings/string_view.h"
 #include "gtest/gtest.h"
@@ -60,14 +62,11 @@ TEST(HashingTest, String) {
 }
 
 TEST(HashingTest, StringView) {
-  // For StringView we expect the range-based hasher to kick in. This is
-  // basically terrible, but no worse than Java's `String.hashCode()`. Another
+  // For StringView we expect the range-based hasher to kick in. Another
   // possibility would be just to create a temporary std::string and std::hash
-  // that, but that requires an explicit specialization. Since we're only
-  // defining this for compatibility with Objective-C and not really sensitive
-  // to performance or hash quality here, this is good enough.
-  size_t expected = std::hash<unsigned char>{}('a');
-  expected = 31u * expected + std::hash<size_t>{}(1);
+  // that, but that requires an explicit specialization.
+  size_t expected = impl::Combine(0, std::hash<unsigned char>{}('a'));
+  expected = impl::Combine(expected, std::hash<size_t>{}(1));
   ASSERT_EQ(expected, Hash(absl::string_view{"a"}));
 }
 
@@ -79,10 +78,10 @@ TEST(HashingTest, SizeT) {
 TEST(HashingTest, Array) {
   int values[] = {0, 1, 2};
 
-  size_t expected = std::hash<int>{}(0);
-  expected = 31u * expected + std::hash<int>{}(1);
-  expected = 31u * expected + std::hash<int>{}(2);
-  expected = 31u * expected + std::hash<size_t>{}(3);  // length of array
+  size_t expected = impl::Combine(0, std::hash<int>{}(0));
+  expected = impl::Combine(expected, std::hash<int>{}(1));
+  expected = impl::Combine(expected, std::hash<int>{}(2));
+  expected = impl::Combine(expected, std::hash<size_t>{}(3));  // length
   ASSERT_EQ(expected, Hash(values));
 }
 
@@ -93,8 +92,8 @@ TEST(HashingTest, HasHashMember) {
 TEST(HashingTest, RangeOfStdHashable) {
   std::vector<int> values{42};
 
-  size_t expected = std::hash<int>{}(42);
-  expected = 31u * expected + std::hash<size_t>{}(1);  // length of array
+  size_t expected = impl::Combine(0, std::hash<int>{}(42));
+  expected = impl::Combine(expected, std::hash<size_t>{}(1));  // length
   ASSERT_EQ(expected, Hash(values));
 
   std::vector<int> values_leading_zero{0, 42};
@@ -110,8 +109,8 @@ TEST(HashingTest, RangeOfHashMember) {
 
   // We trust the underlying Hash() member to do its thing, so unlike the other
   // examples, the 42u here is not run through std::hash<size_t>{}().
-  size_t expected = 42u;
-  expected = 31u * expected + std::hash<size_t>{}(1);  // length of array
+  size_t expected = impl::Combine(0, 42u);
+  expected = impl::Combine(expected, std::hash<size_t>{}(1));  // length
   ASSERT_EQ(expected, Hash(values));
 }
 
@@ -144,20 +143,35 @@ TEST(HashingTest, Composite) {
   EXPECT_EQ(std::hash<int>{}(1), Hash(1));
 
   size_t expected = std::hash<int>{}(1);
-  expected = 31 * expected + std::hash<int>{}(0);
+  expected = impl::Combine(expected, std::hash<int>{}(0));
   EXPECT_EQ(expected, Hash(1, 0));
 
   expected = std::hash<int>{}(1);
-  expected = 31 * expected + std::hash<int>{}(0);
-  expected = 31 * expected + std::hash<int>{}(0);
+  expected = impl::Combine(expected, std::hash<int>{}(0));
+  expected = impl::Combine(expected, std::hash<int>{}(0));
   EXPECT_EQ(expected, Hash(1, 0, 0));
 
   expected = Hash(1);
-  expected = 31u * expected + Hash(2);
-  expected = 31u * expected + Hash(3);
+  expected = impl::Combine(expected, Hash(2));
+  expected = impl::Combine(expected, Hash(3));
   EXPECT_EQ(expected, Hash(1, 2, 3));
 }
 
+TEST(HashingTest, CompositesOfSmallValuesDontCollide) {
+  // With `31 * result + value`, (1, 0) and (0, 31) hashed alike, as did any
+  // pairs of small integers that added up to the same total.
+  EXPECT_NE(Hash(1, 0), Hash(0, 31));
+  EXPECT_NE(Hash(0, 1), Hash(1, 0));
+
+  std::unordered_set<size_t> hashes;
+  for (int i = 0; i < 32; ++i) {
+    for (int j = 0; j < 32; ++j) {
+      hashes.insert(Hash(i, j));
+    }
+  }
+  EXPECT_EQ(hashes.size(), 32u * 32u);
+}
+
 }  // namespace util
 }  // namespace firestore
 }  // namespace firebase
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/md5.h"
+
+#include <array>
+#include <string>
+
+#include "absl/strings/escaping.h"
+#include "absl/strings/string_view.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+std::string HexDigest(absl::string_view data) {
+  std::array<uint8_t, 16> digest = CalculateMd5Digest(data);
+  return absl::BytesToHexString(absl::string_view(
+      reinterpret_cast<const char*>(digest.data()), digest.size()));
+}
+
+}  // namespace
+
+TEST(Md5Test, MatchesReferenceDigests) {
+  // The test suite from RFC 1321.
+  EXPECT_EQ(HexDigest(""), "d41d8cd98f00b204e9800998ecf8427e");
+  EXPECT_EQ(HexDigest("a"), "0cc175b9c0f1b6a831c399e269772661");
+  EXPECT_EQ(HexDigest("abc"), "900150983cd24fb0d6963f7d28e17f72");
+  EXPECT_EQ(HexDigest("message digest"), "f96b697d7cb7938d525a2f31aaf161d0");
+  EXPECT_EQ(HexDigest("abcdefghijklmnopqrstuvwxyz"),
+            "c3fcd3d76192e4007dfb496cca67e13b");
+  EXPECT_EQ(HexDigest("12345678901234567890123456789012345678901234567890123456"
+                      "789012345678901234567890"),
+            "57edf4a22be3c955ac49da2e2107b67a");
+}
+
+TEST(Md5Test, PadsAcrossBlockBoundaries) {
+  // Lengths around 56 bytes need a second padding block for the length.
+  EXPECT_EQ(HexDigest(std::string(55, 'x')),
+            "04364420e25c512fd958a70738aa8f72");
+  EXPECT_EQ(HexDigest(std::string(56, 'x')),
+            "668a72d5ba17f08e62dabcafad6db14b");
+  EXPECT_EQ(HexDigest(std::string(64, 'x')),
+            "c1bb4f81d892b2d57947682aeb252456");
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
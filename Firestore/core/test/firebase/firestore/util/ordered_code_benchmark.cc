@@ -14,6 +14,12 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
 #include "benchmark/benchmark.h"
@@ -21,6 +27,46 @@
 using firebase::firestore::util::OrderedCode;
 using firebase::firestore::util::SecureRandom;
 
+namespace {
+
+/**
+ * Returns the segments of document paths shaped like typical Firestore keys:
+ * `depth` pairs of a collection ID and a document ID of `id_length` random
+ * alphanumeric characters (20 for auto-generated IDs).
+ */
+std::vector<std::vector<std::string>> MakeDocumentPaths(int64_t depth,
+                                                        int64_t id_length) {
+  static const char* const kCollections[] = {"users", "rooms", "messages",
+                                              "posts", "comments"};
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+
+  SecureRandom rnd;
+  const int kPaths = 1024;
+  std::vector<std::vector<std::string>> paths(kPaths);
+  for (std::vector<std::string>& path : paths) {
+    for (int64_t i = 0; i < depth; ++i) {
+      path.emplace_back(kCollections[rnd.Uniform(5)]);
+      std::string id;
+      std::generate_n(std::back_inserter(id), id_length, [&] {
+        return kAlphabet[rnd.Uniform(sizeof(kAlphabet) - 1)];
+      });
+      path.push_back(std::move(id));
+    }
+  }
+  return paths;
+}
+
+/** Encodes a path the way LevelDbRemoteDocumentKey encodes its segments. */
+void WriteDocumentKey(std::string* dest, const std::vector<std::string>& path) {
+  for (const std::string& segment : path) {
+    OrderedCode::WriteSignedNumIncreasing(dest, 5);  // Component label
+    OrderedCode::WriteString(dest, segment);
+  }
+}
+
+}  // namespace
+
 static void BM_SkipToNextSpecialByte(benchmark::State& state) {
   // Use enough distinct values to confuse the branch predictor
   SecureRandom rnd;
@@ -61,3 +107,58 @@ BENCHMARK(BM_SkipToNextSpecialByte)
     ->Arg(1 << 9)
     ->Arg(1 << 10)
     ->Arg(1 << 15);
+
+static void BM_WriteDocumentKey(benchmark::State& state) {
+  std::vector<std::vector<std::string>> paths =
+      MakeDocumentPaths(state.range(0), state.range(1));
+
+  size_t index = 0;
+  int64_t total_bytes = 0;
+  std::string dest;
+  for (auto _ : state) {
+    dest.clear();
+    WriteDocumentKey(&dest, paths[index++ % paths.size()]);
+    benchmark::DoNotOptimize(dest.data());
+    total_bytes += static_cast<int64_t>(dest.size());
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_WriteDocumentKey)
+    ->Args({1, 20})
+    ->Args({2, 20})
+    ->Args({4, 20})
+    ->Args({2, 64});
+
+static void BM_ReadDocumentKey(benchmark::State& state) {
+  std::vector<std::vector<std::string>> paths =
+      MakeDocumentPaths(state.range(0), state.range(1));
+  std::vector<std::string> keys;
+  for (const std::vector<std::string>& path : paths) {
+    keys.emplace_back();
+    WriteDocumentKey(&keys.back(), path);
+  }
+
+  size_t index = 0;
+  int64_t total_bytes = 0;
+  std::string segment;
+  for (auto _ : state) {
+    absl::string_view key = keys[index++ % keys.size()];
+    total_bytes += static_cast<int64_t>(key.size());
+    int64_t label = 0;
+    while (!key.empty()) {
+      segment.clear();
+      if (!OrderedCode::ReadSignedNumIncreasing(&key, &label) ||
+          !OrderedCode::ReadString(&key, &segment)) {
+        state.SkipWithError("Failed to decode key");
+        break;
+      }
+      benchmark::DoNotOptimize(segment.data());
+    }
+  }
+  state.SetBytesProcessed(total_bytes);
+}
+BENCHMARK(BM_ReadDocumentKey)
+    ->Args({1, 20})
+    ->Args({2, 20})
+    ->Args({4, 20})
+    ->Args({2, 64});
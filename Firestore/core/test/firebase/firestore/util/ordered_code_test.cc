@@ -16,7 +16,9 @@
 
 #include "Firestore/core/src/firebase/firestore/util/ordered_code.h"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <limits>
 
 #include "Firestore/core/src/firebase/firestore/util/secure_random.h"
@@ -289,6 +291,26 @@ TEST(OrderedCode, ExhaustiveFindSpecial) {
   EXPECT_EQ(count, 256 * 256 * 256 * 2);
 }
 
+TEST(OrderedCode, FindSpecialAtEveryAlignment) {
+  // Special bytes may fall anywhere within or across the 16-byte blocks
+  // scanned by the vectorized search, which need not be aligned.
+  char buf[64];
+  for (size_t start = 0; start < 16; start++) {
+    for (size_t special_pos = start; special_pos < sizeof(buf);
+         special_pos++) {
+      for (char special_byte : {'\0', '\xff'}) {
+        std::fill(std::begin(buf), std::end(buf), 'a');
+        buf[special_pos] = special_byte;
+        EXPECT_EQ(&buf[special_pos], OrderedCode::TEST_SkipToNextSpecialByte(
+                                         &buf[start], std::end(buf)));
+        // The search must not look past the limit.
+        EXPECT_EQ(&buf[special_pos], OrderedCode::TEST_SkipToNextSpecialByte(
+                                         &buf[start], &buf[special_pos]));
+      }
+    }
+  }
+}
+
 TEST(OrderedCodeUint64, EncodeDecode) {
   TestNumbers<uint64_t>(1);
 }
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+namespace {
+
+std::unique_ptr<Executor> CreateExecutor() {
+  return Executor::CreateConcurrent("ParallelForTest", 4);
+}
+
+}  // namespace
+
+TEST(ParallelForTest, VisitsEveryIndexOnce) {
+  auto executor = CreateExecutor();
+  for (size_t count : {0, 1, 3, 100, 10000}) {
+    std::vector<std::atomic<int>> visits(count);
+    ParallelFor(executor.get(), 4, count, [&](size_t i) { ++visits[i]; });
+    for (size_t i = 0; i != count; ++i) {
+      EXPECT_EQ(visits[i].load(), 1) << "index " << i << " of " << count;
+    }
+  }
+}
+
+TEST(ParallelForTest, RunsInlineWithOneWorker) {
+  std::vector<size_t> visited;
+  ParallelFor(nullptr, 1, 5, [&](size_t i) { visited.push_back(i); });
+  EXPECT_EQ(visited, (std::vector<size_t>{0, 1, 2, 3, 4}));
+}
+
+TEST(ParallelForTest, CollectsResultsOfAllWorkers) {
+  auto executor = CreateExecutor();
+  std::vector<size_t> result = ParallelCollect<size_t>(
+      executor.get(), 4, 1000, [](size_t i, std::vector<size_t>* results) {
+        // Drop some indices and duplicate others.
+        if (i % 3 == 0) {
+          return;
+        }
+        results->push_back(i);
+        if (i % 5 == 0) {
+          results->push_back(i);
+        }
+      });
+
+  std::vector<size_t> expected;
+  for (size_t i = 0; i != 1000; ++i) {
+    if (i % 3 != 0) {
+      expected.push_back(i);
+      if (i % 5 == 0) {
+        expected.push_back(i);
+      }
+    }
+  }
+  std::sort(result.begin(), result.end());
+  EXPECT_EQ(result, expected);
+}
+
+TEST(ParallelForTest, FinishesWhenOneWorkerIsSlow) {
+  auto executor = CreateExecutor();
+  std::atomic<int> sum{0};
+  ParallelFor(executor.get(), 4, 400, [&](size_t i) {
+    if (i == 0) {
+      // The other workers steal the rest of this worker's share.
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    sum += static_cast<int>(i);
+  });
+  EXPECT_EQ(sum.load(), 399 * 400 / 2);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
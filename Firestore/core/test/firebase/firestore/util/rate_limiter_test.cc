@@ -0,0 +1,82 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Firestore/core/src/firebase/firestore/util/rate_limiter.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace chr = std::chrono;
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class RateLimiterTest : public testing::Test {
+ public:
+  RateLimiterTest()
+      : start{RateLimiter::Clock::now()},
+        limiter{500, 1.5, chr::minutes(5), 10000, start} {
+  }
+
+  RateLimiter::Clock::time_point start;
+  RateLimiter limiter;
+};
+
+TEST_F(RateLimiterTest, AcceptsAndRejectsRequests) {
+  EXPECT_TRUE(limiter.TryMakeRequest(100, start));
+  EXPECT_TRUE(limiter.TryMakeRequest(400, start));
+  EXPECT_FALSE(limiter.TryMakeRequest(1, start));
+
+  // At 500 tokens per second, 10 tokens are added every 20ms.
+  EXPECT_FALSE(limiter.TryMakeRequest(11, start + chr::milliseconds(20)));
+  EXPECT_TRUE(limiter.TryMakeRequest(10, start + chr::milliseconds(20)));
+}
+
+TEST_F(RateLimiterTest, DoesNotRefillPastCapacity) {
+  EXPECT_TRUE(limiter.TryMakeRequest(500, start));
+  EXPECT_FALSE(limiter.TryMakeRequest(501, start + chr::seconds(10)));
+  EXPECT_TRUE(limiter.TryMakeRequest(500, start + chr::seconds(10)));
+}
+
+TEST_F(RateLimiterTest, CalculatesNextRequestDelay) {
+  EXPECT_EQ(limiter.GetNextRequestDelay(500, start), chr::milliseconds(0));
+
+  EXPECT_TRUE(limiter.TryMakeRequest(500, start));
+  EXPECT_EQ(limiter.GetNextRequestDelay(1, start), chr::milliseconds(2));
+  EXPECT_EQ(limiter.GetNextRequestDelay(100, start), chr::milliseconds(200));
+
+  // Requests larger than the capacity wait for a full bucket.
+  EXPECT_EQ(limiter.GetNextRequestDelay(1000, start), chr::milliseconds(1000));
+}
+
+TEST_F(RateLimiterTest, IncreasesCapacityOverTime) {
+  EXPECT_EQ(limiter.CapacityAt(start), 500);
+  EXPECT_EQ(limiter.CapacityAt(start + chr::minutes(4)), 500);
+  EXPECT_EQ(limiter.CapacityAt(start + chr::minutes(5)), 750);
+  EXPECT_EQ(limiter.CapacityAt(start + chr::minutes(10)), 1125);
+  EXPECT_EQ(limiter.CapacityAt(start + chr::minutes(90)), 10000);
+
+  EXPECT_TRUE(limiter.TryMakeRequest(500, start));
+  EXPECT_FALSE(limiter.TryMakeRequest(751, start + chr::minutes(5)));
+  EXPECT_TRUE(limiter.TryMakeRequest(750, start + chr::minutes(5)));
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
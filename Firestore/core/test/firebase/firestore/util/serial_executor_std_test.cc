@@ -0,0 +1,169 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/serial_executor_std.h"
+
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "Firestore/core/src/firebase/firestore/util/executor_std.h"
+#include "Firestore/core/test/firebase/firestore/testutil/async_testing.h"
+#include "Firestore/core/test/firebase/firestore/util/executor_test.h"
+#include "absl/memory/memory.h"
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+using async::MpscQueue;
+
+// MpscQueue tests
+
+TEST(MpscQueueTest, PopsInFifoOrder) {
+  MpscQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.Pop().has_value());
+
+  queue.Push(1);
+  queue.Push(2);
+  queue.Push(3);
+  EXPECT_FALSE(queue.empty());
+
+  EXPECT_EQ(queue.Pop().value(), 1);
+  EXPECT_EQ(queue.Pop().value(), 2);
+  EXPECT_EQ(queue.Pop().value(), 3);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.Pop().has_value());
+}
+
+TEST(MpscQueueTest, DestroysRemainingEntries) {
+  auto value = std::make_shared<int>(42);
+  {
+    MpscQueue<std::shared_ptr<int>> queue;
+    queue.Push(std::shared_ptr<int>{value});
+    queue.Push(std::shared_ptr<int>{value});
+    EXPECT_EQ(value.use_count(), 3);
+  }
+  EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(MpscQueueTest, KeepsOrderOfEachProducer) {
+  const int kProducers = 4;
+  const int kValuesPerProducer = 10000;
+
+  MpscQueue<int> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p != kProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i != kValuesPerProducer; ++i) {
+        queue.Push(p * kValuesPerProducer + i);
+      }
+    });
+  }
+
+  std::vector<int> last_seen(kProducers, -1);
+  int popped = 0;
+  while (popped != kProducers * kValuesPerProducer) {
+    absl::optional<int> value = queue.Pop();
+    if (!value) {
+      std::this_thread::yield();
+      continue;
+    }
+    int producer = value.value() / kValuesPerProducer;
+    int index = value.value() % kValuesPerProducer;
+    EXPECT_EQ(index, last_seen[producer] + 1);
+    last_seen[producer] = index;
+    ++popped;
+  }
+
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_TRUE(queue.empty());
+}
+
+// SerialExecutorStd tests
+
+namespace {
+
+inline std::unique_ptr<Executor> ExecutorFactory(int threads) {
+  // `SerialExecutorStd` has a single consumer by design; the concurrent
+  // executor tests are covered by `ExecutorStd`.
+  if (threads != 1) {
+    return absl::make_unique<ExecutorStd>(threads);
+  }
+  return absl::make_unique<SerialExecutorStd>();
+}
+
+}  // namespace
+
+INSTANTIATE_TEST_SUITE_P(ExecutorTestSerialStd,
+                         ExecutorTest,
+                         ::testing::Values(ExecutorFactory));
+
+class SerialExecutorStdTest : public ::testing::Test,
+                              public testutil::AsyncTest {};
+
+TEST_F(SerialExecutorStdTest, RunsOperationsFromManyThreadsInOrder) {
+  const int kProducers = 4;
+  const int kOperationsPerProducer = 1000;
+
+  SerialExecutorStd executor;
+  std::vector<int> last_seen(kProducers, -1);
+  testutil::Expectation done;
+
+  std::vector<std::thread> producers;
+  for (int p = 0; p != kProducers; ++p) {
+    producers.emplace_back([&, p] {
+      for (int i = 0; i != kOperationsPerProducer; ++i) {
+        executor.Execute([&, p, i] {
+          EXPECT_EQ(i, last_seen[p] + 1);
+          last_seen[p] = i;
+        });
+      }
+    });
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+
+  executor.Execute([&] { done.Fulfill(); });
+  Await(done);
+}
+
+TEST_F(SerialExecutorStdTest, RunsImmediateOperationsBeforeDelayedOnes) {
+  SerialExecutorStd executor;
+  std::vector<int> steps;
+  testutil::Expectation done;
+
+  executor.ExecuteBlocking([&] {
+    executor.Schedule(Executor::Milliseconds(0),
+                      {1, [&] {
+                         steps.push_back(2);
+                         done.Fulfill();
+                       }});
+    executor.Execute([&] { steps.push_back(1); });
+  });
+
+  Await(done);
+  executor.ExecuteBlocking([&] { EXPECT_EQ(steps, (std::vector<int>{1, 2})); });
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
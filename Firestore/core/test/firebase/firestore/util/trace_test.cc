@@ -0,0 +1,92 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/trace.h"
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+class TraceTest : public testing::Test {
+ protected:
+  void TearDown() override {
+    TraceSetEnabled(false);
+  }
+};
+
+TEST_F(TraceTest, RecordsNothingWhileDisabled) {
+  TraceSetEnabled(false);
+  Trace(TraceEvent::kListen, 2);
+
+  EXPECT_FALSE(TraceIsEnabled());
+  EXPECT_TRUE(TraceSnapshot().empty());
+  EXPECT_EQ(TraceDump(), "");
+}
+
+TEST_F(TraceTest, RecordsRawArguments) {
+  TraceSetEnabled(true);
+  Trace(TraceEvent::kListen, 2);
+  Trace(TraceEvent::kRemoteEvent, 1, 30);
+
+  std::vector<TraceRecord> records = TraceSnapshot();
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].event, TraceEvent::kListen);
+  EXPECT_EQ(records[0].args[0], 2);
+  EXPECT_EQ(records[1].event, TraceEvent::kRemoteEvent);
+  EXPECT_EQ(records[1].args[0], 1);
+  EXPECT_EQ(records[1].args[1], 30);
+  EXPECT_LE(records[0].time_micros, records[1].time_micros);
+}
+
+TEST_F(TraceTest, KeepsTheMostRecentEvents) {
+  TraceSetEnabled(true);
+  for (int i = 0; i < 5000; ++i) {
+    Trace(TraceEvent::kListen, i);
+  }
+
+  std::vector<TraceRecord> records = TraceSnapshot();
+  ASSERT_FALSE(records.empty());
+  EXPECT_LT(records.size(), 5000u);
+  EXPECT_EQ(records.back().args[0], 4999);
+  for (size_t i = 1; i < records.size(); ++i) {
+    EXPECT_EQ(records[i].args[0], records[i - 1].args[0] + 1);
+  }
+}
+
+TEST_F(TraceTest, EnablingDiscardsPreviousEvents) {
+  TraceSetEnabled(true);
+  Trace(TraceEvent::kListen, 2);
+  TraceSetEnabled(true);
+
+  EXPECT_TRUE(TraceSnapshot().empty());
+}
+
+TEST_F(TraceTest, DumpDecodesEvents) {
+  TraceSetEnabled(true);
+  Trace(TraceEvent::kStopListening, 4);
+  Trace(TraceEvent::kExecuteQuery, 10, 250, 1);
+
+  std::string dump = TraceDump();
+  EXPECT_NE(dump.find("StopListening target_id=4\n"), std::string::npos);
+  EXPECT_NE(dump.find("ExecuteQuery documents=10 micros=250 cached=1\n"),
+            std::string::npos);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
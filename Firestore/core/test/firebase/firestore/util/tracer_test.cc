@@ -0,0 +1,159 @@
+/*
+ * Copyright 2020 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Firestore/core/src/firebase/firestore/util/tracer.h"
+
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace firebase {
+namespace firestore {
+namespace util {
+
+namespace {
+
+struct RecordedSpan {
+  SpanId id = 0;
+  SpanId parent_id = 0;
+  std::string name;
+  bool ended = false;
+  SpanAttributes attributes;
+};
+
+class RecordingTracer : public Tracer {
+ public:
+  void BeginSpan(SpanId id, SpanId parent_id, const char* name) override {
+    RecordedSpan span;
+    span.id = id;
+    span.parent_id = parent_id;
+    span.name = name;
+    spans.push_back(span);
+  }
+
+  void EndSpan(SpanId id, const SpanAttributes& attributes) override {
+    for (RecordedSpan& span : spans) {
+      if (span.id == id) {
+        span.ended = true;
+        span.attributes = attributes;
+      }
+    }
+  }
+
+  std::vector<RecordedSpan> spans;
+};
+
+}  // namespace
+
+class TracerTest : public testing::Test {
+ protected:
+  void SetUp() override {
+    SetTracer(tracer_);
+  }
+
+  void TearDown() override {
+    SetTracer(nullptr);
+  }
+
+  std::shared_ptr<RecordingTracer> tracer_ =
+      std::make_shared<RecordingTracer>();
+};
+
+TEST_F(TracerTest, DoesNothingWithoutATracer) {
+  SetTracer(nullptr);
+  {
+    TraceSpan span("Ignored");
+    span.SetAttribute("key", 1);
+
+    EXPECT_FALSE(TracerIsInstalled());
+    EXPECT_FALSE(span.active());
+    EXPECT_EQ(span.id(), 0u);
+    EXPECT_EQ(TraceSpan::Current(), 0u);
+  }
+  EXPECT_TRUE(tracer_->spans.empty());
+}
+
+TEST_F(TracerTest, ReportsSpansWithAttributes) {
+  {
+    TraceSpan span("Listen");
+    span.SetAttribute("target_id", 2);
+    span.SetAttribute("query", "coll");
+
+    ASSERT_EQ(tracer_->spans.size(), 1u);
+    EXPECT_FALSE(tracer_->spans[0].ended);
+  }
+
+  ASSERT_EQ(tracer_->spans.size(), 1u);
+  const RecordedSpan& span = tracer_->spans[0];
+  EXPECT_EQ(span.name, "Listen");
+  EXPECT_EQ(span.parent_id, 0u);
+  EXPECT_TRUE(span.ended);
+  EXPECT_EQ(span.attributes,
+            (SpanAttributes{{"target_id", "2"}, {"query", "coll"}}));
+}
+
+TEST_F(TracerTest, NestsSpansOnTheSameThread) {
+  {
+    TraceSpan outer("Outer");
+    EXPECT_EQ(TraceSpan::Current(), outer.id());
+    {
+      TraceSpan inner("Inner");
+      EXPECT_EQ(TraceSpan::Current(), inner.id());
+    }
+    EXPECT_EQ(TraceSpan::Current(), outer.id());
+  }
+  EXPECT_EQ(TraceSpan::Current(), 0u);
+
+  ASSERT_EQ(tracer_->spans.size(), 2u);
+  EXPECT_EQ(tracer_->spans[1].parent_id, tracer_->spans[0].id);
+  EXPECT_NE(tracer_->spans[1].id, tracer_->spans[0].id);
+}
+
+TEST_F(TracerTest, ConnectsSpansAcrossThreads) {
+  SpanId parent_id = 0;
+  {
+    TraceSpan parent("Parent");
+    parent_id = parent.id();
+  }
+
+  std::thread thread([parent_id] {
+    EXPECT_EQ(TraceSpan::Current(), 0u);
+    TraceSpan child("Child", parent_id);
+  });
+  thread.join();
+
+  ASSERT_EQ(tracer_->spans.size(), 2u);
+  EXPECT_EQ(tracer_->spans[1].name, "Child");
+  EXPECT_EQ(tracer_->spans[1].parent_id, parent_id);
+  EXPECT_TRUE(tracer_->spans[1].ended);
+}
+
+TEST_F(TracerTest, SpansEndOnTheTracerTheyBeganOn) {
+  {
+    TraceSpan span("Span");
+    SetTracer(nullptr);
+  }
+
+  ASSERT_EQ(tracer_->spans.size(), 1u);
+  EXPECT_TRUE(tracer_->spans[0].ended);
+}
+
+}  // namespace util
+}  // namespace firestore
+}  // namespace firebase
@@ -37,6 +37,7 @@
     _mappingID = mappingID;
     _target = target;
     _qosTier = GDTCOREventQosDefault;
+    _GDTFileRange = NSMakeRange(NSNotFound, 0);
   }
   GDTCORLogDebug("Event %@ created. mappingID: %@ target:%ld", self, mappingID, (long)target);
   return self;
@@ -49,6 +50,7 @@
   copy.clockSnapshot = _clockSnapshot;
   copy.customPrioritizationParams = _customPrioritizationParams;
   copy->_GDTFilePath = _GDTFilePath;
+  copy->_GDTFileRange = _GDTFileRange;
   GDTCORLogDebug("Copying event %@ to event %@", self, copy);
   return copy;
 }
@@ -59,8 +61,9 @@
   NSUInteger timeHash = [_clockSnapshot hash];
   NSInteger dataObjectHash = [_dataObject hash];
   NSUInteger fileURL = [_GDTFilePath hash];
+  NSUInteger fileOffset = _GDTFileRange.location == NSNotFound ? 0 : _GDTFileRange.location;
 
-  return mappingIDHash ^ _target ^ _qosTier ^ timeHash ^ dataObjectHash ^ fileURL;
+  return mappingIDHash ^ _target ^ _qosTier ^ timeHash ^ dataObjectHash ^ fileURL ^ fileOffset;
 }
 
 - (BOOL)isEqual:(id)object {
@@ -103,10 +106,76 @@
     return NO;
   }
   _GDTFilePath = filePath;
+  _GDTFileRange = NSMakeRange(NSNotFound, 0);
   _dataObject = nil;
   return YES;
 }
 
+- (BOOL)appendToSegment:(NSString *)segmentPath
+             fileHandle:(NSFileHandle *)fileHandle
+                  error:(NSError **)error {
+  NSData *dataTransportBytes = [_dataObject transportBytes];
+  if (dataTransportBytes == nil) {
+    _GDTFilePath = nil;
+    _dataObject = nil;
+    return NO;
+  }
+  unsigned long long offset;
+  @try {
+    offset = [fileHandle seekToEndOfFile];
+    [fileHandle writeData:dataTransportBytes];
+  } @catch (NSException *exception) {
+    GDTCORLogError(GDTCORMCEFileWriteError, @"An event could not be appended to segment %@: %@",
+                   segmentPath, exception);
+    if (error) {
+      NSDictionary *userInfo = @{NSLocalizedFailureReasonErrorKey : exception.reason ?: @""};
+      *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                   code:NSFileWriteUnknownError
+                               userInfo:userInfo];
+    }
+    return NO;
+  }
+  _GDTFilePath = segmentPath;
+  _GDTFileRange = NSMakeRange((NSUInteger)offset, dataTransportBytes.length);
+  _dataObject = nil;
+  return YES;
+}
+
+#pragma mark - Reading stored bytes
+
+- (nullable NSData *)storedBytesWithError:(NSError **)error {
+  if (!_GDTFilePath) {
+    return nil;
+  }
+  NSURL *fileURL = self.fileURL;
+  if (_GDTFileRange.location == NSNotFound) {
+    return [NSData dataWithContentsOfURL:fileURL options:0 error:error];
+  }
+  NSFileHandle *fileHandle = [NSFileHandle fileHandleForReadingFromURL:fileURL error:error];
+  if (!fileHandle) {
+    return nil;
+  }
+  NSData *bytes;
+  @try {
+    [fileHandle seekToFileOffset:_GDTFileRange.location];
+    bytes = [fileHandle readDataOfLength:_GDTFileRange.length];
+  } @catch (NSException *exception) {
+    bytes = nil;
+  }
+  [fileHandle closeFile];
+  if (bytes.length != _GDTFileRange.length) {
+    GDTCORLogError(GDTCORMCEFileReadError, @"An event could not be read from segment %@",
+                   fileURL);
+    if (error) {
+      *error = [NSError errorWithDomain:NSCocoaErrorDomain
+                                   code:NSFileReadCorruptFileError
+                               userInfo:nil];
+    }
+    return nil;
+  }
+  return bytes;
+}
+
 #pragma mark - NSSecureCoding and NSCoding Protocols
 
 /** NSCoding key for mappingID property. */
@@ -127,6 +196,12 @@ static NSString *fileURLKey = @"_fileURL";
 /** NSCoding key for GDTFilePath property. */
 static NSString *kGDTFilePathKey = @"_GDTFilePath";
 
+/** NSCoding key for the location of the GDTFileRange property. */
+static NSString *kGDTFileRangeLocationKey = @"_GDTFileRangeLocation";
+
+/** NSCoding key for the length of the GDTFileRange property. */
+static NSString *kGDTFileRangeLengthKey = @"_GDTFileRangeLength";
+
 /** NSCoding key for customPrioritizationParams property. */
 static NSString *customPrioritizationParams = @"_customPrioritizationParams";
 
@@ -173,6 +248,11 @@ static NSString *kStoredEventCustomPrioritizationParamsKey =
     } else {
       _GDTFilePath = [aDecoder decodeObjectOfClass:[NSString class] forKey:kGDTFilePathKey];
     }
+    if ([aDecoder containsValueForKey:kGDTFileRangeLocationKey]) {
+      _GDTFileRange =
+          NSMakeRange((NSUInteger)[aDecoder decodeInt64ForKey:kGDTFileRangeLocationKey],
+                      (NSUInteger)[aDecoder decodeInt64ForKey:kGDTFileRangeLengthKey]);
+    }
     _customPrioritizationParams = [aDecoder decodeObjectOfClass:[NSDictionary class]
                                                          forKey:customPrioritizationParams];
   }
@@ -209,6 +289,10 @@ static NSString *kStoredEventCustomPrioritizationParamsKey =
   [aCoder encodeInteger:_qosTier forKey:qosTierKey];
   [aCoder encodeObject:_clockSnapshot forKey:clockSnapshotKey];
   [aCoder encodeObject:_GDTFilePath forKey:kGDTFilePathKey];
+  if (_GDTFileRange.location != NSNotFound) {
+    [aCoder encodeInt64:(int64_t)_GDTFileRange.location forKey:kGDTFileRangeLocationKey];
+    [aCoder encodeInt64:(int64_t)_GDTFileRange.length forKey:kGDTFileRangeLengthKey];
+  }
   [aCoder encodeObject:_customPrioritizationParams forKey:customPrioritizationParams];
 }
 
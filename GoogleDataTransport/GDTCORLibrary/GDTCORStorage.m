@@ -27,6 +27,9 @@
 #import "GDTCORLibrary/Private/GDTCORRegistrar_Private.h"
 #import "GDTCORLibrary/Private/GDTCORUploadCoordinator.h"
 
+/** The size after which a new segment is started for new events. */
+static const unsigned long long kGDTCORSegmentMaxSize = 64 * 1024;
+
 @implementation GDTCORStorage
 
 + (NSString *)archivePath {
@@ -53,6 +56,7 @@
     _storageQueue = dispatch_queue_create("com.google.GDTCORStorage", DISPATCH_QUEUE_SERIAL);
     _targetToEventSet = [[NSMutableDictionary alloc] init];
     _storedEvents = [[NSMutableOrderedSet alloc] init];
+    _segmentEventCounts = [[NSMutableDictionary alloc] init];
     _uploadCoordinator = [GDTCORUploadCoordinator sharedInstance];
   }
   return self;
@@ -100,6 +104,10 @@
     NSError *error = nil;
     NSURL *eventFile = [self saveEventBytesToDisk:event eventHash:event.hash error:&error];
     GDTCORLogDebug("Event saved to disk: %@", eventFile);
+    if (hadOriginalCompletion) {
+      // The caller is waiting to hear the event is on disk, so don't leave it in the page cache.
+      [self.currentSegmentHandle synchronizeFile];
+    }
     completion(eventFile != nil, error);
 
     // Add event to tracking collections.
@@ -146,7 +154,9 @@
     for (GDTCOREvent *event in eventsToRemove) {
       // Remove from disk, first and foremost.
       NSError *error;
-      if (event.fileURL) {
+      if (event.GDTFilePath && event.GDTFileRange.location != NSNotFound) {
+        [self removeEventFromSegment:event.GDTFilePath];
+      } else if (event.fileURL) {
         NSURL *fileURL = event.fileURL;
         [[NSFileManager defaultManager] removeItemAtURL:fileURL error:&error];
         GDTCORAssert(error == nil, @"There was an error removing an event file: %@", error);
@@ -157,6 +167,7 @@
       [self.storedEvents removeObject:event];
       [self.targetToEventSet[@(event.target)] removeObject:event];
     }
+    self.storedEventCount = self.storedEvents.count;
   });
 }
 
@@ -174,7 +185,98 @@
   }
 }
 
-/** Saves the event's dataObject to a file using NSData mechanisms.
+/** Returns a handle to the segment new events should be appended to, starting a new segment if
+ * there isn't one or the current one is full.
+ *
+ * @return The handle, or nil if a segment couldn't be created.
+ */
+- (nullable NSFileHandle *)segmentHandleForWriting {
+  if (self.currentSegmentHandle) {
+    unsigned long long size = 0;
+    @try {
+      size = [self.currentSegmentHandle seekToEndOfFile];
+    } @catch (NSException *exception) {
+      size = kGDTCORSegmentMaxSize;
+    }
+    if (size < kGDTCORSegmentMaxSize) {
+      return self.currentSegmentHandle;
+    }
+    [self closeCurrentSegment];
+  }
+  NSString *segmentPath = [NSString
+      stringWithFormat:@"segment-%@", [[NSProcessInfo processInfo] globallyUniqueString]];
+  NSURL *segmentURL = [GDTCORRootDirectory() URLByAppendingPathComponent:segmentPath];
+  if (![[NSFileManager defaultManager] createFileAtPath:segmentURL.path
+                                               contents:nil
+                                             attributes:nil]) {
+    GDTCORLogError(GDTCORMCEFileWriteError, @"A segment file could not be created: %@",
+                   segmentURL);
+    return nil;
+  }
+  NSError *error;
+  NSFileHandle *handle = [NSFileHandle fileHandleForWritingToURL:segmentURL error:&error];
+  if (!handle) {
+    GDTCORLogError(GDTCORMCEFileWriteError, @"A segment file could not be opened: %@", error);
+    return nil;
+  }
+  self.currentSegmentPath = segmentPath;
+  self.currentSegmentHandle = handle;
+  GDTCORLogDebug("Started segment %@", segmentPath);
+  return handle;
+}
+
+/** Closes the current segment. New events go to a new segment afterwards. */
+- (void)closeCurrentSegment {
+  NSString *segmentPath = self.currentSegmentPath;
+  [self.currentSegmentHandle closeFile];
+  self.currentSegmentHandle = nil;
+  self.currentSegmentPath = nil;
+  if (segmentPath && self.segmentEventCounts[segmentPath] == nil) {
+    [self deleteSegment:segmentPath];
+  }
+}
+
+/** Notes that an event stored in the given segment was removed, and deletes the segment if it was
+ * the last one in it.
+ *
+ * @param segmentPath The GDTCORRootDirectory-relative path of the segment.
+ */
+- (void)removeEventFromSegment:(NSString *)segmentPath {
+  NSUInteger count = [self.segmentEventCounts[segmentPath] unsignedIntegerValue];
+  if (count > 1) {
+    self.segmentEventCounts[segmentPath] = @(count - 1);
+    return;
+  }
+  [self.segmentEventCounts removeObjectForKey:segmentPath];
+  if ([segmentPath isEqualToString:self.currentSegmentPath]) {
+    [self closeCurrentSegment];
+  } else {
+    [self deleteSegment:segmentPath];
+  }
+}
+
+/** Deletes a segment file from disk. */
+- (void)deleteSegment:(NSString *)segmentPath {
+  NSURL *segmentURL = [GDTCORRootDirectory() URLByAppendingPathComponent:segmentPath];
+  NSError *error;
+  [[NSFileManager defaultManager] removeItemAtURL:segmentURL error:&error];
+  GDTCORAssert(error == nil, @"There was an error removing a segment file: %@", error);
+  GDTCORLogDebug("Removed segment from disk: %@", segmentURL);
+}
+
+/** Rebuilds the count of events in each segment from the stored events. */
+- (void)recountSegmentEvents {
+  [self.segmentEventCounts removeAllObjects];
+  for (GDTCOREvent *event in self.storedEvents) {
+    if (event.GDTFilePath && event.GDTFileRange.location != NSNotFound) {
+      NSUInteger count = [self.segmentEventCounts[event.GDTFilePath] unsignedIntegerValue];
+      self.segmentEventCounts[event.GDTFilePath] = @(count + 1);
+    }
+  }
+}
+
+/** Saves the event's dataObject to disk by appending it to the current segment. If no segment can
+ * be opened, the event is written to a file of its own using NSData mechanisms.
  *
  * @note This method should only be called from a method within a block on _storageQueue to maintain
  * thread safety.
@@ -186,9 +288,18 @@
 - (NSURL *)saveEventBytesToDisk:(GDTCOREvent *)event
                       eventHash:(NSUInteger)eventHash
                           error:(NSError **)error {
-  NSString *eventFileName = [NSString stringWithFormat:@"event-%lu", (unsigned long)eventHash];
   NSError *writingError;
-  [event writeToGDTPath:eventFileName error:&writingError];
+  NSFileHandle *segmentHandle = [self segmentHandleForWriting];
+  if (segmentHandle) {
+    NSString *segmentPath = self.currentSegmentPath;
+    if ([event appendToSegment:segmentPath fileHandle:segmentHandle error:&writingError]) {
+      NSUInteger count = [self.segmentEventCounts[segmentPath] unsignedIntegerValue];
+      self.segmentEventCounts[segmentPath] = @(count + 1);
+    }
+  } else {
+    NSString *eventFileName = [NSString stringWithFormat:@"event-%lu", (unsigned long)eventHash];
+    [event writeToGDTPath:eventFileName error:&writingError];
+  }
   if (writingError) {
     GDTCORLogDebug(@"There was an error saving an event to disk: %@", writingError);
   }
@@ -204,6 +315,7 @@
  */
 - (void)addEventToTrackingCollections:(GDTCOREvent *)event {
   [_storedEvents addObject:event];
+  self.storedEventCount = _storedEvents.count;
   NSNumber *target = @(event.target);
   NSMutableSet<GDTCOREvent *> *events = self.targetToEventSet[target];
   events = events ? events : [[NSMutableSet alloc] init];
@@ -290,6 +402,8 @@ static NSString *const kGDTCORStorageUploadCoordinatorKey = @"GDTCORStorageUploa
     sharedInstance->_uploadCoordinator =
         [aDecoder decodeObjectOfClass:[GDTCORUploadCoordinator class]
                                forKey:kGDTCORStorageUploadCoordinatorKey];
+    [sharedInstance recountSegmentEvents];
+    sharedInstance.storedEventCount = sharedInstance->_storedEvents.count;
   });
   return sharedInstance;
 }
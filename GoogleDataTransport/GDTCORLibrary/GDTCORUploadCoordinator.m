@@ -21,9 +21,19 @@
 #import <GoogleDataTransport/GDTCORConsoleLogger.h>
 #import <GoogleDataTransport/GDTCORReachability.h>
 
+#import "GDTCORLibrary/Private/GDTCOREvent_Private.h"
 #import "GDTCORLibrary/Private/GDTCORRegistrar_Private.h"
 #import "GDTCORLibrary/Private/GDTCORStorage.h"
 
+/** The largest exponent of the spacing between uploads on mobile data, for 8 timer intervals. */
+static const NSUInteger kGDTCORMaxMobileDataBackoffExponent = 3;
+
+/** The number of stored events at which uploads stop being spaced out on mobile data. */
+static const NSUInteger kGDTCORBacklogThreshold = 500;
+
+/** The most packages a target uploads back to back on Wi-Fi between timer fires. */
+static const NSUInteger kGDTCORMaxDrainCount = 5;
+
 @implementation GDTCORUploadCoordinator
 
 + (instancetype)sharedInstance {
@@ -45,6 +55,7 @@
     _timerInterval = 30 * NSEC_PER_SEC;
     _timerLeeway = 5 * NSEC_PER_SEC;
     _targetToInFlightPackages = [[NSMutableDictionary alloc] init];
+    _targetToDrainCount = [[NSMutableDictionary alloc] init];
   }
   return self;
 }
@@ -53,8 +64,18 @@
   dispatch_async(_coordinationQueue, ^{
     GDTCORLogDebug("Forcing an upload of target %ld", (long)target);
     GDTCORUploadConditions conditions = [self uploadConditions];
-    conditions |= GDTCORUploadConditionHighPriority;
-    [self uploadTargets:@[ @(target) ] conditions:conditions];
+    [self uploadTargets:@[ @(target) ]
+             conditions:conditions | GDTCORUploadConditionHighPriority];
+
+    // The radio is awake for this upload anyway, so let the other targets upload now too, and push
+    // the next timer fire back rather than waking up again shortly after.
+    if (![self shouldDeferUploadWithConditions:conditions]) {
+      NSMutableArray<NSNumber *> *otherTargets =
+          [self.registrar.targetToUploader.allKeys mutableCopy];
+      [otherTargets removeObject:@(target)];
+      [self uploadTargets:otherTargets conditions:conditions];
+      [self rescheduleTimer];
+    }
   });
 }
 
@@ -84,6 +105,12 @@
       if (![[GDTCORApplication sharedApplication] isRunningInBackground]) {
         GDTCORUploadConditions conditions = [self uploadConditions];
         GDTCORLogDebug("%@", @"Upload timer fired");
+        [self->_targetToDrainCount removeAllObjects];
+        if ([self shouldDeferUploadWithConditions:conditions]) {
+          GDTCORLogDebug("Deferring uploads on mobile data, %ld timer fires to go",
+                         (long)self->_mobileDataSkipsRemaining);
+          return;
+        }
         [self uploadTargets:[self.registrar.targetToUploader allKeys] conditions:conditions];
       }
     });
@@ -92,6 +119,83 @@
   });
 }
 
+/** Restarts the timer so that its next fire is a full interval from now. */
+- (void)rescheduleTimer {
+  if (_timer) {
+    dispatch_source_set_timer(_timer, dispatch_time(DISPATCH_TIME_NOW, (int64_t)_timerInterval),
+                              _timerInterval, _timerLeeway);
+  }
+}
+
+/** Decides whether a regular upload should be skipped to space out uploads on mobile data. Each
+ * upload on mobile data doubles the spacing, up to a limit. Wi-Fi, or a large backlog of stored
+ * events, resets it.
+ *
+ * @note This method should only be called on the coordination queue.
+ *
+ * @param conditions The current upload conditions.
+ * @return YES if the upload should be skipped, NO otherwise.
+ */
+- (BOOL)shouldDeferUploadWithConditions:(GDTCORUploadConditions)conditions {
+  BOOL onMobileData =
+      (conditions & GDTCORUploadConditionMobileData) == GDTCORUploadConditionMobileData;
+  if (!onMobileData || self.storage.storedEventCount >= kGDTCORBacklogThreshold) {
+    _mobileDataBackoffExponent = 0;
+    _mobileDataSkipsRemaining = 0;
+    return NO;
+  }
+  if (_mobileDataSkipsRemaining > 0) {
+    _mobileDataSkipsRemaining--;
+    return YES;
+  }
+  _mobileDataSkipsRemaining = (1 << _mobileDataBackoffExponent) - 1;
+  _mobileDataBackoffExponent = MIN(_mobileDataBackoffExponent + 1,
+                                   kGDTCORMaxMobileDataBackoffExponent);
+  return NO;
+}
+
+/** Returns the number of bytes of event data in the package.
+ *
+ * @param package The package.
+ * @return The number of bytes the package's events take on disk.
+ */
+- (uint64_t)byteCountOfPackage:(GDTCORUploadPackage *)package {
+  uint64_t bytes = 0;
+  for (GDTCOREvent *event in package.events) {
+    if (event.GDTFileRange.location != NSNotFound) {
+      bytes += event.GDTFileRange.length;
+    } else if (event.fileURL) {
+      NSDictionary *attributes =
+          [[NSFileManager defaultManager] attributesOfItemAtPath:event.fileURL.path error:nil];
+      bytes += [attributes fileSize];
+    }
+  }
+  return bytes;
+}
+
+/** Updates the upload counters with a package that finished uploading or expired.
+ *
+ * @note This method should only be called on the coordination queue.
+ *
+ * @param package The package.
+ * @param successful YES if the package was uploaded, NO otherwise.
+ */
+- (void)recordDeliveryOfPackage:(GDTCORUploadPackage *)package successful:(BOOL)successful {
+  if (!successful) {
+    _eventsFailedToUpload += package.events.count;
+    return;
+  }
+  int64_t now = [GDTCORClock snapshot].timeMillis;
+  for (GDTCOREvent *event in package.events) {
+    int64_t createdAt = event.clockSnapshot.timeMillis;
+    if (event.clockSnapshot && createdAt <= now) {
+      _totalTimeToUploadMillis += (uint64_t)(now - createdAt);
+    }
+  }
+  _eventsUploaded += package.events.count;
+  _bytesUploaded += [self byteCountOfPackage:package];
+}
+
 /** Stops the currently running timer. */
 - (void)stopTimer {
   if (_timer) {
@@ -244,6 +348,19 @@ static NSString *const ktargetToInFlightPackagesKey =
     if (successful && package.events) {
       [self.storage removeEvents:package.events];
     }
+    [self recordDeliveryOfPackage:package successful:successful];
+
+    // On Wi-Fi, keep going while there's a backlog instead of waiting for the next timer fire.
+    GDTCORUploadConditions conditions = [self uploadConditions];
+    NSUInteger drainCount = [self->_targetToDrainCount[targetNumber] unsignedIntegerValue];
+    if (successful && package.events.count > 0 &&
+        (conditions & GDTCORUploadConditionWifiData) == GDTCORUploadConditionWifiData &&
+        self.storage.storedEventCount > package.events.count &&
+        drainCount < kGDTCORMaxDrainCount) {
+      self->_targetToDrainCount[targetNumber] = @(drainCount + 1);
+      GDTCORLogDebug("Target %@ has a backlog, uploading another package", targetNumber);
+      [self uploadTargets:@[ targetNumber ] conditions:conditions];
+    }
   });
 }
 
@@ -259,6 +376,7 @@ static NSString *const ktargetToInFlightPackagesKey =
     if (targetToInFlightPackages) {
       [targetToInFlightPackages removeObjectForKey:targetNumber];
     }
+    [self recordDeliveryOfPackage:package successful:NO];
     if (registrar) {
       id<GDTCORPrioritizer> prioritizer = registrar.targetToPrioritizer[targetNumber];
       id<GDTCORUploader> uploader = registrar.targetToUploader[targetNumber];
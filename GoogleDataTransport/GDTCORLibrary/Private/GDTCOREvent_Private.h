@@ -34,6 +34,23 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (BOOL)writeToGDTPath:(NSString *)filePath error:(NSError **)error;
 
+/** Appends [dataObject transportBytes] to the end of a segment file shared by several events,
+ * populates fileURL with the segment's filename and records where in the segment the bytes are,
+ * then nils the dataObject property. This method should not be called twice on the same event.
+ *
+ * @param segmentPath The GDTCORRootDirectory-relative path of the segment.
+ * @param fileHandle A handle to the segment, open for writing and positioned at its end.
+ * @param error If populated, the error encountered during writing to disk.
+ * @return YES if writing dataObject to disk was successful, NO otherwise.
+ */
+- (BOOL)appendToSegment:(NSString *)segmentPath
+             fileHandle:(NSFileHandle *)fileHandle
+                  error:(NSError **)error;
+
+/** The range of the event's bytes within the file at fileURL. The location is NSNotFound if the
+ * event has the whole file to itself. */
+@property(nonatomic, readonly) NSRange GDTFileRange;
+
 @end
 
 NS_ASSUME_NONNULL_END
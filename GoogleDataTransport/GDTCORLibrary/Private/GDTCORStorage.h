@@ -46,6 +46,9 @@ NS_ASSUME_NONNULL_BEGIN
  */
 - (void)removeEvents:(NSSet<GDTCOREvent *> *)events;
 
+/** The number of events currently stored. Safe to read from any thread. */
+@property(atomic, readonly) NSUInteger storedEventCount;
+
 @end
 
 NS_ASSUME_NONNULL_END
@@ -29,9 +29,22 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic)
     NSMutableDictionary<NSNumber *, NSMutableSet<GDTCOREvent *> *> *targetToEventSet;
 
+/** The number of stored events, kept in sync with storedEvents. */
+@property(atomic, readwrite) NSUInteger storedEventCount;
+
 /** All the events that have been stored. */
 @property(readonly, nonatomic) NSMutableOrderedSet<GDTCOREvent *> *storedEvents;
 
+/** The GDTCORRootDirectory-relative path of the segment new events are appended to. */
+@property(nullable, nonatomic) NSString *currentSegmentPath;
+
+/** A handle to the current segment, open for writing. */
+@property(nullable, nonatomic) NSFileHandle *currentSegmentHandle;
+
+/** A map of segment paths to the number of stored events in them. A segment is deleted when the
+ * last of its events is removed. */
+@property(nonatomic) NSMutableDictionary<NSString *, NSNumber *> *segmentEventCounts;
+
 /** The upload coordinator instance used by this storage instance. */
 @property(nonatomic) GDTCORUploadCoordinator *uploadCoordinator;
 
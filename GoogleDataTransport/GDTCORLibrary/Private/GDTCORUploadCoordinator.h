@@ -53,6 +53,30 @@ NS_ASSUME_NONNULL_BEGIN
 @property(nonatomic, readonly)
     NSMutableDictionary<NSNumber *, GDTCORUploadPackage *> *targetToInFlightPackages;
 
+/** The number of timer fires to skip before the next upload on mobile data. */
+@property(nonatomic, readonly) NSUInteger mobileDataSkipsRemaining;
+
+/** The exponent of the current spacing between uploads on mobile data, which is
+ * 2^mobileDataBackoffExponent timer intervals. */
+@property(nonatomic, readonly) NSUInteger mobileDataBackoffExponent;
+
+/** The number of packages uploaded back to back for each target since the last timer fire. */
+@property(nonatomic, readonly) NSMutableDictionary<NSNumber *, NSNumber *> *targetToDrainCount;
+
+/** The number of events that were successfully uploaded. */
+@property(nonatomic, readonly) uint64_t eventsUploaded;
+
+/** The number of bytes of event data that were successfully uploaded. */
+@property(nonatomic, readonly) uint64_t bytesUploaded;
+
+/** The number of events in packages that failed to upload or expired. These events stay in
+ * storage and are retried later. */
+@property(nonatomic, readonly) uint64_t eventsFailedToUpload;
+
+/** The total time, in milliseconds, between the creation of each uploaded event and its upload.
+ * Divide by eventsUploaded for the average time to upload. */
+@property(nonatomic, readonly) uint64_t totalTimeToUploadMillis;
+
 /** The storage object the coordinator will use. Generally used for testing. */
 @property(nonatomic) GDTCORStorage *storage;
 
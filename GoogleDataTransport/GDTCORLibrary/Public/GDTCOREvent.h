@@ -61,7 +61,9 @@ typedef NS_ENUM(NSInteger, GDTCOREventQoS) {
 /** The clock snapshot at the time of the event. */
 @property(nonatomic) GDTCORClock *clockSnapshot;
 
-/** The resulting file URL when [dataObject -transportBytes] has been saved to disk.*/
+/** The resulting file URL when [dataObject -transportBytes] has been saved to disk. The file may
+ * be a segment holding the bytes of several events, so use -storedBytesWithError: to read the
+ * bytes of this event. */
 @property(nullable, readonly, nonatomic) NSURL *fileURL;
 
 /** A dictionary provided to aid prioritizers by allowing the passing of arbitrary data. It will be
@@ -83,6 +85,13 @@ typedef NS_ENUM(NSInteger, GDTCOREventQoS) {
 - (nullable instancetype)initWithMappingID:(NSString *)mappingID
                                     target:(NSInteger)target NS_DESIGNATED_INITIALIZER;
 
+/** Reads the bytes of [dataObject -transportBytes] that were saved to disk.
+ *
+ * @param error If populated, the error encountered while reading from disk.
+ * @return The saved bytes, or nil if they couldn't be read.
+ */
+- (nullable NSData *)storedBytesWithError:(NSError **)error;
+
 @end
 
 NS_ASSUME_NONNULL_END
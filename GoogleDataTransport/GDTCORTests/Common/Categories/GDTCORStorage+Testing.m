@@ -24,6 +24,11 @@
   dispatch_sync(self.storageQueue, ^{
     [self.targetToEventSet removeAllObjects];
     [self.storedEvents removeAllObjects];
+    self.storedEventCount = 0;
+    [self.segmentEventCounts removeAllObjects];
+    [self.currentSegmentHandle closeFile];
+    self.currentSegmentHandle = nil;
+    self.currentSegmentPath = nil;
     NSError *error;
     [[NSFileManager defaultManager] removeItemAtPath:[GDTCORStorage archivePath] error:&error];
   });
@@ -55,7 +55,7 @@
 
   // In real usage, you'd create an instance of whatever request proto your server needs.
   for (GDTCOREvent *event in package.events) {
-    NSData *fileData = [NSData dataWithContentsOfURL:event.fileURL];
+    NSData *fileData = [event storedBytesWithError:nil];
     GDTCORFatalAssert(fileData, @"An event file shouldn't be empty");
     [uploadData appendData:fileData];
   }
@@ -199,6 +199,45 @@ static NSInteger target = kGDTCORTargetCCT;
   });
 }
 
+/** Tests that events share a segment, which is deleted once all its events are removed. */
+- (void)testEventsShareASegment {
+  GDTCORStorage *storage = [GDTCORStorage sharedInstance];
+  __block GDTCOREvent *storedEvent1, *storedEvent2;
+
+  // events are autoreleased, and the pool needs to drain.
+  @autoreleasepool {
+    for (NSString *string in @[ @"testString1", @"testString2" ]) {
+      GDTCOREvent *event = [[GDTCOREvent alloc] initWithMappingID:@"404" target:target];
+      event.dataObject = [[GDTCORDataObjectTesterSimple alloc] initWithString:string];
+      XCTestExpectation *writtenExpectation = [self expectationWithDescription:@"event written"];
+      [storage storeEvent:event
+               onComplete:^(BOOL wasWritten, NSError *error) {
+                 XCTAssertTrue(wasWritten);
+                 [writtenExpectation fulfill];
+               }];
+      [self waitForExpectations:@[ writtenExpectation ] timeout:10.0];
+    }
+  }
+  dispatch_sync(storage.storageQueue, ^{
+    storedEvent1 = storage.storedEvents[0];
+    storedEvent2 = storage.storedEvents[1];
+  });
+  XCTAssertEqualObjects(storedEvent1.fileURL, storedEvent2.fileURL);
+  NSData *expectedBytes = [@"testString2" dataUsingEncoding:NSUTF8StringEncoding];
+  XCTAssertEqualObjects([storedEvent2 storedBytesWithError:nil], expectedBytes);
+
+  [storage removeEvents:[NSSet setWithObject:storedEvent1]];
+  dispatch_sync(storage.storageQueue, ^{
+    XCTAssertTrue([[NSFileManager defaultManager] fileExistsAtPath:storedEvent2.fileURL.path]);
+  });
+  XCTAssertEqualObjects([storedEvent2 storedBytesWithError:nil], expectedBytes);
+
+  [storage removeEvents:[NSSet setWithObject:storedEvent2]];
+  dispatch_sync(storage.storageQueue, ^{
+    XCTAssertFalse([[NSFileManager defaultManager] fileExistsAtPath:storedEvent2.fileURL.path]);
+  });
+}
+
 /** Tests storing a few different events. */
 - (void)testStoreMultipleEvents {
   __block GDTCOREvent *storedEvent1, *storedEvent2, *storedEvent3;
@@ -88,6 +88,28 @@
   [self waitForExpectations:@[ expectation ] timeout:1.0];
 }
 
+/** Tests that delivered and failed packages are counted. */
+- (void)testUploadCounters {
+  GDTCORUploadCoordinator *coordinator = [GDTCORUploadCoordinator sharedInstance];
+  __block uint64_t eventsUploaded, eventsFailed;
+  dispatch_sync(coordinator.coordinationQueue, ^{
+    eventsUploaded = coordinator.eventsUploaded;
+    eventsFailed = coordinator.eventsFailedToUpload;
+  });
+
+  GDTCORUploadPackage *package = [[GDTCORUploadPackage alloc] initWithTarget:kGDTCORTargetTest];
+  package.events = [GDTCOREventGenerator generate3Events];
+  [coordinator packageDelivered:package successful:YES];
+  [coordinator packageDelivered:package successful:NO];
+  [coordinator packageExpired:package];
+
+  dispatch_sync(coordinator.coordinationQueue, ^{
+    XCTAssertEqual(coordinator.eventsUploaded - eventsUploaded, 3);
+    XCTAssertEqual(coordinator.eventsFailedToUpload - eventsFailed, 6);
+    XCTAssertGreaterThan(coordinator.bytesUploaded, 0);
+  });
+}
+
 /** Tests the timer is running at the desired frequency. */
 - (void)testTimerIsRunningAtDesiredFrequency {
   __block int numberOfTimesCalled = 0;
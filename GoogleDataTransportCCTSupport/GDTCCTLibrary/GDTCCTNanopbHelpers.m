@@ -150,7 +150,7 @@ gdt_cct_LogEvent GDTCCTConstructLogEvent(GDTCOREvent *event) {
   NSError *error;
   NSData *extensionBytes;
   if (event.fileURL) {
-    extensionBytes = [NSData dataWithContentsOfURL:event.fileURL options:0 error:&error];
+    extensionBytes = [event storedBytesWithError:&error];
   } else {
     GDTCORLogError(GDTCORMCEFileReadError, @"%@", @"An event's fileURL property was nil.");
     return logEvent;